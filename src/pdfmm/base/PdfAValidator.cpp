@@ -0,0 +1,398 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfAValidator.h"
+
+#include <pdfmm/private/XMPUtils.h>
+
+#include "PdfArray.h"
+#include "PdfContentsReader.h"
+#include "PdfDictionary.h"
+#include "PdfDocument.h"
+#include "PdfExecutor.h"
+#include "PdfObjectWalker.h"
+#include "PdfPage.h"
+#include "PdfPageCollection.h"
+#include "PdfXObjectForm.h"
+
+using namespace std;
+using namespace mm;
+
+static void checkMetadata(const PdfDocument& doc, PdfALevel& level, vector<PdfAViolation>& violations);
+static void checkOutputIntents(const PdfDocument& doc, vector<PdfAViolation>& violations);
+static void checkObject(const PdfObject& obj, const PdfName* key, bool isPdfA1, vector<PdfAViolation>& violations);
+static void checkContents(const PdfCanvas& canvas, const PdfReference& ref, vector<PdfAViolation>& violations);
+static void checkResource(const PdfCanvas& canvas, const PdfContent& content, const string_view& type,
+    unsigned operandIndex, const PdfReference& ref, vector<PdfAViolation>& violations);
+static PdfReference getOwnerReference(const PdfObject& obj);
+static bool isPdfA1(PdfALevel level);
+
+PdfAValidator::PdfAValidator(PdfALevel level)
+    : m_level(level) { }
+
+PdfAValidationResult PdfAValidator::Validate(PdfDocument& doc, unsigned threadCount)
+{
+    PdfAValidationResult ret;
+    ret.Level = m_level;
+    auto& violations = ret.Violations;
+    auto& trailer = doc.GetTrailer().GetObject();
+    if (doc.GetEncrypt() != nullptr)
+    {
+        auto encrypt = trailer.GetDictionary().GetKey("Encrypt");
+        violations.push_back({ PdfAViolationType::Encrypted,
+            encrypt != nullptr && encrypt->IsReference() ? encrypt->GetReference() : PdfReference(),
+            "The document is encrypted" });
+    }
+
+    checkMetadata(doc, ret.Level, violations);
+    checkOutputIntents(doc, violations);
+
+    // Walk the object graph once, collecting the
+    // XObject forms, whose contents are read later
+    bool pdfA1 = isPdfA1(ret.Level);
+    vector<const PdfObject*> forms;
+    PdfObjectWalker walker(&doc.GetObjects());
+    (void)walker.Walk(trailer, [&](const PdfObject& obj, const PdfName* key)
+    {
+        checkObject(obj, key, pdfA1, violations);
+        const PdfDictionary* dict;
+        if (obj.IsIndirect() && obj.TryGetDictionary(dict) && obj.HasStream()
+            && dict->FindKeyAs<PdfName>("Subtype") == "Form")
+        {
+            forms.push_back(&obj);
+        }
+
+        return PdfWalkAction::Continue;
+    });
+
+    // NOTE: Access the pages through the const collection,
+    // which is safe to read concurrently from frozen documents
+    const auto& collection = const_cast<const PdfPageCollection&>(doc.GetPages());
+    vector<const PdfCanvas*> canvases;
+    vector<unique_ptr<PdfXObjectForm>> formElements;
+    for (unsigned i = 0; i < collection.GetCount(); i++)
+        canvases.push_back(&collection.GetPage(i));
+
+    for (auto obj : forms)
+    {
+        unique_ptr<PdfXObjectForm> form;
+        if (!PdfXObject::TryCreateFromObject(const_cast<PdfObject&>(*obj), form))
+            continue;
+
+        canvases.push_back(form.get());
+        formElements.push_back(std::move(form));
+    }
+
+    auto executor = doc.GetExecutor();
+    if (threadCount == 0)
+        threadCount = executor->GetConcurrency();
+
+    threadCount = std::min(threadCount, (unsigned)canvases.size());
+    if (threadCount <= 1 || !doc.TryFreeze())
+        threadCount = 1;
+
+    vector<vector<PdfAViolation>> contentsViolations(canvases.size());
+    executor->ParallelFor(canvases.size(), 1, threadCount, [&]()
+    {
+        return [&](size_t i)
+        {
+            auto& canvas = *canvases[i];
+            checkContents(canvas, canvas.GetElement().GetObject().GetIndirectReference(), contentsViolations[i]);
+        };
+    });
+
+    for (auto& canvasViolations : contentsViolations)
+    {
+        for (auto& violation : canvasViolations)
+            violations.push_back(std::move(violation));
+    }
+
+    return ret;
+}
+
+void checkMetadata(const PdfDocument& doc, PdfALevel& level, vector<PdfAViolation>& violations)
+{
+    auto& catalog = doc.GetCatalog();
+    auto catalogRef = catalog.GetObject().GetIndirectReference();
+    PdfXMPMetadata metadata;
+    auto xmp = catalog.GetMetadataStreamValue();
+    if (xmp.size() == 0 || !TryReadXMPMetadata(xmp, metadata))
+    {
+        violations.push_back({ PdfAViolationType::MissingMetadata, catalogRef,
+            xmp.size() == 0 ? "The catalog has no XMP metadata" : "The XMP metadata is not valid" });
+        if (level == PdfALevel::Unknown)
+            violations.push_back({ PdfAViolationType::MissingIdentification, catalogRef, "The PDF/A level is not declared" });
+
+        return;
+    }
+
+    if (metadata.PdfaLevel == PdfALevel::Unknown)
+        violations.push_back({ PdfAViolationType::MissingIdentification, catalogRef, "The XMP metadata doesn't declare the PDF/A level" });
+    else if (level == PdfALevel::Unknown)
+        level = metadata.PdfaLevel;
+
+    auto info = doc.GetTrailer().GetDictionary().FindKey("Info");
+    const PdfDictionary* infoDict;
+    if (info == nullptr || !info->TryGetDictionary(infoDict))
+        return;
+
+    auto infoRef = info->GetIndirectReference();
+    auto checkString = [&](const string_view& key, const nullable<PdfString>& xmpValue)
+    {
+        auto obj = infoDict->FindKey(key);
+        const PdfString* value;
+        if (obj == nullptr || !obj->TryGetString(value))
+            return;
+
+        if (!xmpValue.has_value() || xmpValue->GetString() != value->GetString())
+        {
+            violations.push_back({ PdfAViolationType::InconsistentMetadata, infoRef,
+                utls::Format("The Info entry /{} doesn't match the XMP metadata", key) });
+        }
+    };
+
+    auto checkDate = [&](const string_view& key, const nullable<PdfDate>& xmpValue)
+    {
+        auto obj = infoDict->FindKey(key);
+        const PdfString* value;
+        PdfDate date;
+        if (obj == nullptr || !obj->TryGetString(value) || !PdfDate::TryParse(value->GetString(), date))
+            return;
+
+        if (!xmpValue.has_value() || xmpValue->GetSecondsFromEpoch() != date.GetSecondsFromEpoch())
+        {
+            violations.push_back({ PdfAViolationType::InconsistentMetadata, infoRef,
+                utls::Format("The Info entry /{} doesn't match the XMP metadata", key) });
+        }
+    };
+
+    checkString("Title", metadata.Title);
+    checkString("Author", metadata.Author);
+    checkString("Subject", metadata.Subject);
+    checkString("Creator", metadata.Creator);
+    checkString("Producer", metadata.Producer);
+    checkDate("CreationDate", metadata.CreationDate);
+    checkDate("ModDate", metadata.ModDate);
+}
+
+void checkOutputIntents(const PdfDocument& doc, vector<PdfAViolation>& violations)
+{
+    auto& catalog = doc.GetCatalog();
+    auto intents = catalog.GetDictionary().FindKey("OutputIntents");
+    const PdfArray* arr;
+    if (intents != nullptr && intents->TryGetArray(arr))
+    {
+        for (unsigned i = 0; i < arr->GetSize(); i++)
+        {
+            const PdfDictionary* intent;
+            if (arr->FindAt(i).TryGetDictionary(intent)
+                && intent->FindKeyAs<PdfName>("S") == "GTS_PDFA1"
+                && intent->FindKey("DestOutputProfile") != nullptr)
+            {
+                return;
+            }
+        }
+    }
+
+    violations.push_back({ PdfAViolationType::MissingOutputIntent, catalog.GetObject().GetIndirectReference(),
+        "There's no PDF/A output intent with a destination profile" });
+}
+
+void checkObject(const PdfObject& obj, const PdfName* key, bool isPdfA1, vector<PdfAViolation>& violations)
+{
+    const PdfDictionary* dict;
+    if (!obj.TryGetDictionary(dict))
+        return;
+
+    auto type = dict->FindKeyAs<PdfName>("Type");
+    auto subtype = dict->FindKeyAs<PdfName>("Subtype");
+    if (type == "Font" && (subtype == "Type1" || subtype == "MMType1" || subtype == "TrueType"
+        || subtype == "CIDFontType0" || subtype == "CIDFontType2"))
+    {
+        // Type0 fonts are checked by their descendant
+        // font, and Type3 fonts are defined by the contents
+        auto descriptor = dict->FindKey("FontDescriptor");
+        const PdfDictionary* descriptorDict;
+        if (descriptor == nullptr || !descriptor->TryGetDictionary(descriptorDict)
+            || (!descriptorDict->HasKey("FontFile") && !descriptorDict->HasKey("FontFile2")
+                && !descriptorDict->HasKey("FontFile3")))
+        {
+            violations.push_back({ PdfAViolationType::FontNotEmbedded, getOwnerReference(obj),
+                utls::Format("The font {} is not embedded", dict->FindKeyAs<PdfName>("BaseFont").GetString()) });
+        }
+    }
+
+    auto action = dict->FindKeyAs<PdfName>("S");
+    if (action == "JavaScript" || action == "Launch" || action == "Sound" || action == "Movie"
+        || action == "ResetForm" || action == "ImportData")
+    {
+        violations.push_back({ PdfAViolationType::ForbiddenAction, getOwnerReference(obj),
+            utls::Format("The {} actions are not allowed", action.GetString()) });
+    }
+
+    if (obj.IsIndirect() && obj.HasStream())
+    {
+        if (dict->HasKey("F"))
+        {
+            violations.push_back({ PdfAViolationType::ExternalStream, obj.GetIndirectReference(),
+                "The data of the stream is in an external file" });
+        }
+
+        if (isPdfA1)
+        {
+            auto filter = dict->FindKey("Filter");
+            const PdfName* name;
+            const PdfArray* filters;
+            bool lzw = false;
+            if (filter == nullptr)
+            {
+                // No filters
+            }
+            else if (filter->TryGetName(name))
+            {
+                lzw = *name == "LZWDecode";
+            }
+            else if (filter->TryGetArray(filters))
+            {
+                for (unsigned i = 0; i < filters->GetSize(); i++)
+                {
+                    if (filters->FindAt(i).TryGetName(name) && *name == "LZWDecode")
+                        lzw = true;
+                }
+            }
+
+            if (lzw)
+            {
+                violations.push_back({ PdfAViolationType::ForbiddenFilter, obj.GetIndirectReference(),
+                    "The LZWDecode filter is not allowed in PDF/A-1" });
+            }
+        }
+    }
+
+    if (!isPdfA1)
+        return;
+
+    // The transparency of the groups, of the graphics states and of the images
+    if (key != nullptr && *key == "Group" && action == "Transparency")
+    {
+        violations.push_back({ PdfAViolationType::Transparency, getOwnerReference(obj),
+            "Transparency groups are not allowed in PDF/A-1" });
+    }
+
+    auto smask = dict->FindKey("SMask");
+    const PdfName* smaskName;
+    if (smask != nullptr && !(smask->TryGetName(smaskName) && *smaskName == "None"))
+    {
+        violations.push_back({ PdfAViolationType::Transparency, getOwnerReference(obj),
+            "Soft masks are not allowed in PDF/A-1" });
+    }
+
+    for (auto alphaKey : { "CA"sv, "ca"sv })
+    {
+        auto alpha = dict->FindKey(alphaKey);
+        double value;
+        if (alpha != nullptr && alpha->TryGetReal(value) && value != 1)
+        {
+            violations.push_back({ PdfAViolationType::Transparency, getOwnerReference(obj),
+                utls::Format("The constant alpha /{} {} is not allowed in PDF/A-1", alphaKey, value) });
+        }
+    }
+
+    auto blendMode = dict->FindKey("BM");
+    const PdfName* blendModeName;
+    if (blendMode != nullptr && !(blendMode->TryGetName(blendModeName)
+        && (*blendModeName == "Normal" || *blendModeName == "Compatible")))
+    {
+        violations.push_back({ PdfAViolationType::Transparency, getOwnerReference(obj),
+            "Blend modes other than Normal are not allowed in PDF/A-1" });
+    }
+}
+
+void checkContents(const PdfCanvas& canvas, const PdfReference& ref, vector<PdfAViolation>& violations)
+{
+    // The forms are checked on their own
+    PdfContentReaderArgs args;
+    args.Flags = PdfContentReaderFlags::DontFollowXObjectForms;
+    PdfContentsReader reader(canvas, args);
+    PdfContent content;
+    while (reader.TryReadNext(content))
+    {
+        switch (content.Type)
+        {
+            case PdfContentType::UnexpectedKeyword:
+            {
+                violations.push_back({ PdfAViolationType::UndefinedOperator, ref,
+                    utls::Format("The operator {} is not defined", content.Keyword) });
+                break;
+            }
+            case PdfContentType::Operator:
+            {
+                switch (content.Operator)
+                {
+                    case PdfOperator::Tf:
+                        checkResource(canvas, content, "Font", 1, ref, violations);
+                        break;
+                    case PdfOperator::gs:
+                        checkResource(canvas, content, "ExtGState", 0, ref, violations);
+                        break;
+                    case PdfOperator::sh:
+                        checkResource(canvas, content, "Shading", 0, ref, violations);
+                        break;
+                    case PdfOperator::Do:
+                        checkResource(canvas, content, "XObject", 0, ref, violations);
+                        break;
+                    default:
+                        // Nothing to check
+                        break;
+                }
+                break;
+            }
+            default:
+            {
+                // Nothing to check
+                break;
+            }
+        }
+    }
+}
+
+void checkResource(const PdfCanvas& canvas, const PdfContent& content, const string_view& type,
+    unsigned operandIndex, const PdfReference& ref, vector<PdfAViolation>& violations)
+{
+    const PdfName* name;
+    if (content.Stack.GetSize() <= operandIndex
+        || !content.Stack[operandIndex].TryGetName(name)
+        || canvas.GetFromResources(type, name->GetString()) != nullptr)
+    {
+        return;
+    }
+
+    violations.push_back({ PdfAViolationType::MissingResource, ref,
+        utls::Format("The resource /{} of type {} is not in the resources", name->GetString(), type) });
+}
+
+// Get the reference of the indirect object containing the given one
+PdfReference getOwnerReference(const PdfObject& obj)
+{
+    auto current = &obj;
+    while (!current->IsIndirect())
+    {
+        auto parent = current->GetParent();
+        if (parent == nullptr || parent->GetOwner() == nullptr)
+            return { };
+
+        current = parent->GetOwner();
+    }
+
+    return current->GetIndirectReference();
+}
+
+bool isPdfA1(PdfALevel level)
+{
+    return level == PdfALevel::L1A || level == PdfALevel::L1B;
+}
@@ -0,0 +1,87 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_A_VALIDATOR_H
+#define PDF_A_VALIDATOR_H
+
+#include "PdfDeclarations.h"
+
+#include "PdfReference.h"
+
+namespace mm {
+
+class PdfDocument;
+
+enum class PdfAViolationType
+{
+    Encrypted,              ///< The document is encrypted
+    MissingMetadata,        ///< The catalog has no valid XMP metadata
+    MissingIdentification,  ///< The XMP metadata doesn't declare the PDF/A level
+    InconsistentMetadata,   ///< An entry of the Info dictionary doesn't match the XMP metadata
+    MissingOutputIntent,    ///< There's no PDF/A output intent with a destination profile
+    FontNotEmbedded,        ///< A font program is not embedded
+    Transparency,           ///< Transparency is used in a PDF/A-1 document
+    ExternalStream,         ///< The data of a stream is in an external file
+    ForbiddenFilter,        ///< A stream uses LZWDecode in a PDF/A-1 document
+    ForbiddenAction,        ///< A JavaScript, Launch, Sound, Movie, ResetForm or ImportData action
+    UndefinedOperator,      ///< A content stream uses an operator not defined by the PDF specification
+    MissingResource,        ///< A content stream uses a resource not in its resources
+};
+
+/** A violation of the PDF/A requirements found by PdfAValidator
+ */
+struct PDFMM_API PdfAViolation
+{
+    PdfAViolationType Type;
+    PdfReference Reference;     ///< The object violating the requirement, or the page or the form for the contents
+    std::string Description;
+};
+
+struct PDFMM_API PdfAValidationResult
+{
+    PdfALevel Level = PdfALevel::Unknown;   ///< The level the document was validated against
+    std::vector<PdfAViolation> Violations;
+
+    inline bool IsValid() const { return Violations.size() == 0; }
+};
+
+/**
+ * Check the conformance of a document to PDF/A, as a preflight
+ *
+ * The object graph is walked once, from the trailer, checking the
+ * fonts, the transparency, the streams and the actions, then the
+ * content streams of the pages and of the XObject forms found are read
+ * concurrently, on the executor of the document, checking the operators
+ * and the resources they use. The encryption, the output intent and the
+ * consistency of the XMP metadata with the Info dictionary are checked
+ * as well. It's not a full validation: the requirements checked are the
+ * most common causes of non conformance
+ */
+class PDFMM_API PdfAValidator final
+{
+public:
+    /** Create a validator
+     *  \param level the level to check the document against, or
+     *      PdfALevel::Unknown to use the level declared by its XMP metadata
+     */
+    PdfAValidator(PdfALevel level = PdfALevel::Unknown);
+
+    /** Check the conformance of a document
+     *  \param threadCount the maximum count of threads reading the contents,
+     *      or 0 to use the concurrency of the executor of the document
+     *  \remarks To read it concurrently the document is frozen first.
+     *      Documents that can't be frozen are read on the calling thread
+     */
+    PdfAValidationResult Validate(PdfDocument& doc, unsigned threadCount = 0);
+
+private:
+    PdfALevel m_level;
+};
+
+};
+
+#endif // PDF_A_VALIDATOR_H
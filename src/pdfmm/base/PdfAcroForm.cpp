@@ -9,18 +9,29 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 
 #include "PdfAcroForm.h"
+
+#include <unordered_set>
+
 #include "PdfArray.h"
+#include "PdfCheckBox.h"
+#include "PdfChoiceField.h"
 #include "PdfDictionary.h"
 #include "PdfDocument.h"
 #include "PdfFont.h"
+#include "PdfPainter.h"
 #include "PdfStringStream.h"
+#include "PdfTextBox.h"
+#include "PdfXObjectForm.h"
 
 using namespace std;
 using namespace mm;
 
+static void pushFields(PdfIndirectObjectList& objects, PdfArray& arr, vector<PdfObject*>& stack);
+static void drawButtonAppearance(PdfXObjectForm& form, PdfFieldType type, PdfButtonStyle style, bool on);
+
 // The AcroForm dict does NOT have a /Type key!
 PdfAcroForm::PdfAcroForm(PdfDocument& doc, PdfAcroFormDefaulAppearance defaultAppearance)
-    : PdfDictionaryElement(doc)
+    : PdfDictionaryElement(doc), m_FieldIndexModificationCount(0), m_FieldIndexValid(false)
 {
     // Initialize with an empty fields array
     this->GetObject().GetDictionary().AddKey("Fields", PdfArray());
@@ -28,10 +39,12 @@ PdfAcroForm::PdfAcroForm(PdfDocument& doc, PdfAcroFormDefaulAppearance defaultAp
 }
 
 PdfAcroForm::PdfAcroForm(PdfObject& obj)
-    : PdfDictionaryElement(obj)
+    : PdfDictionaryElement(obj), m_FieldIndexModificationCount(0), m_FieldIndexValid(false)
 {
 }
 
+PdfAcroForm::~PdfAcroForm() { }
+
 PdfArray& PdfAcroForm::GetOrCreateFieldsArray()
 {
     auto fields = GetObject().GetDictionary().FindKey("Fields");
@@ -80,3 +93,265 @@ bool PdfAcroForm::GetNeedAppearances() const
 {
     return this->GetObject().GetDictionary().FindKeyAs<bool>("NeedAppearances", false);
 }
+
+PdfField* PdfAcroForm::GetField(const string_view& fullName)
+{
+    if (!m_FieldIndexValid)
+        buildFieldIndex();
+
+    auto found = m_FieldIndex.find((string)fullName);
+    if (m_FieldIndexModificationCount == GetDocument().GetObjects().GetModificationCount())
+        return found == m_FieldIndex.end() ? nullptr : found->second;
+
+    // The document has been modified since the index was built: a found
+    // field is returned if it's still valid, otherwise the index is built again
+    if (found != m_FieldIndex.end() && isFieldValid(*found->second, fullName))
+        return found->second;
+
+    buildFieldIndex();
+    found = m_FieldIndex.find((string)fullName);
+    return found == m_FieldIndex.end() ? nullptr : found->second;
+}
+
+void PdfAcroForm::FillFields(const vector<pair<string, PdfString>>& values)
+{
+    // Build the index once at the beginning, so the
+    // fields found are not invalidated by setting them
+    if (!m_FieldIndexValid || m_FieldIndexModificationCount != GetDocument().GetObjects().GetModificationCount())
+        buildFieldIndex();
+
+    vector<PdfField*> fields;
+    fields.reserve(values.size());
+    for (auto& pair : values)
+    {
+        auto found = m_FieldIndex.find(pair.first);
+        if (found == m_FieldIndex.end())
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Field " + pair.first + " not found");
+
+        fields.push_back(found->second);
+    }
+
+    for (unsigned i = 0; i < values.size(); i++)
+    {
+        auto& field = *fields[i];
+        auto& value = values[i].second;
+        switch (field.GetType())
+        {
+            case PdfFieldType::TextBox:
+            {
+                static_cast<PdfTextBox&>(field).SetText(value);
+                break;
+            }
+            case PdfFieldType::CheckBox:
+            {
+                auto& str = value.GetString();
+                static_cast<PdfCheckBox&>(field).SetChecked(str.length() != 0 && str != "Off");
+                break;
+            }
+            case PdfFieldType::ComboBox:
+            case PdfFieldType::ListBox:
+            {
+                auto& choice = static_cast<PdChoiceField&>(field);
+                unsigned count = (unsigned)choice.GetItemCount();
+                unsigned index = 0;
+                for (; index < count; index++)
+                {
+                    if (choice.GetItem(index) == value)
+                        break;
+                }
+
+                if (index == count)
+                    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Item " + value.GetString() + " not found in field " + values[i].first);
+
+                choice.SetSelectedIndex((int)index);
+                break;
+            }
+            default:
+            {
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Field " + values[i].first + " can't be filled with a value");
+            }
+        }
+    }
+
+    SetNeedAppearances(true);
+}
+
+void PdfAcroForm::buildFieldIndex()
+{
+    // Keep the existing fields, so the ones still in the
+    // form are not created again and stay valid
+    unordered_map<const PdfObject*, unique_ptr<PdfField>> existing;
+    for (auto& field : m_Fields)
+    {
+        auto obj = &field->GetObject();
+        existing[obj] = std::move(field);
+    }
+
+    m_Fields.clear();
+    m_FieldIndex.clear();
+    m_FieldIndexModificationCount = GetDocument().GetObjects().GetModificationCount();
+    m_FieldIndexValid = true;
+
+    auto fieldsObj = GetDictionary().FindKey("Fields");
+    if (fieldsObj == nullptr || !fieldsObj->IsArray())
+        return;
+
+    auto& objects = GetDocument().GetObjects();
+    unordered_set<const PdfObject*> visited;
+    vector<PdfObject*> stack;
+    pushFields(objects, fieldsObj->GetArray(), stack);
+
+    while (stack.size() != 0)
+    {
+        auto obj = stack.back();
+        stack.pop_back();
+        if (!obj->IsDictionary() || !visited.insert(obj).second)
+            continue;
+
+        auto& dict = obj->GetDictionary();
+        auto kids = dict.FindKey("Kids");
+        if (kids != nullptr && kids->IsArray())
+            pushFields(objects, kids->GetArray(), stack);
+
+        // Widgets without a partial name are part of their parent field
+        if (!dict.HasKey("T"))
+            continue;
+
+        unique_ptr<PdfField> field;
+        auto found = existing.find(obj);
+        if (found != existing.end() && found->second->GetType() == PdfField::GetFieldType(*obj))
+            field = std::move(found->second);
+        else if (!PdfField::TryCreateFromObject(*obj, field))
+            continue;
+
+        // The first field with a full name wins
+        auto inserted = m_FieldIndex.insert({ field->GetFullName(), field.get() });
+        if (inserted.second)
+            m_Fields.push_back(std::move(field));
+    }
+}
+
+bool PdfAcroForm::isFieldValid(const PdfField& field, const string_view& fullName) const
+{
+    // Direct fields can't be checked, since
+    // they may have been removed with their parent
+    auto& obj = field.GetObject();
+    if (!obj.IsIndirect()
+        || GetDocument().GetObjects().GetObject(obj.GetIndirectReference()) != &obj)
+    {
+        return false;
+    }
+
+    return field.GetType() == PdfField::GetFieldType(obj) && field.GetFullName() == fullName;
+}
+
+void PdfAcroForm::getButtonAppearances(PdfFieldType type, double width, double height,
+    PdfButtonStyle style, PdfReference& on, PdfReference& off)
+{
+    auto& objects = GetDocument().GetObjects();
+    auto key = ButtonAppearanceKey(type, width, height, style);
+    auto found = m_buttonAppearances.find(key);
+
+    // The shared XObjects may have been removed from the document
+    if (found != m_buttonAppearances.end()
+        && objects.GetObject(found->second.On) != nullptr
+        && objects.GetObject(found->second.Off) != nullptr)
+    {
+        on = found->second.On;
+        off = found->second.Off;
+        return;
+    }
+
+    PdfRect rect(0, 0, width, height);
+    PdfXObjectForm onForm(GetDocument(), rect);
+    drawButtonAppearance(onForm, type, style, true);
+    PdfXObjectForm offForm(GetDocument(), rect);
+    drawButtonAppearance(offForm, type, style, false);
+
+    on = onForm.GetObject().GetIndirectReference();
+    off = offForm.GetObject().GetIndirectReference();
+    m_buttonAppearances[key] = { on, off };
+}
+
+void pushFields(PdfIndirectObjectList& objects, PdfArray& arr, vector<PdfObject*>& stack)
+{
+    // Push in reverse order, so the fields are visited in document order.
+    // Missing objects are skipped
+    for (unsigned i = arr.GetSize(); i > 0; i--)
+    {
+        auto& item = arr[i - 1];
+        PdfReference ref;
+        if (!item.TryGetReference(ref))
+        {
+            stack.push_back(&item);
+            continue;
+        }
+
+        auto obj = objects.GetObject(ref);
+        if (obj != nullptr)
+            stack.push_back(obj);
+    }
+}
+
+void drawButtonAppearance(PdfXObjectForm& form, PdfFieldType type, PdfButtonStyle style, bool on)
+{
+    auto rect = form.GetRect();
+    double width = rect.GetWidth();
+    double height = rect.GetHeight();
+    double size = std::min(width, height);
+    double x = width / 2;
+    double y = height / 2;
+
+    PdfPainter painter;
+    painter.SetCanvas(&form);
+    painter.GetGraphicsState().SetLineWidth(1);
+    if (type == PdfFieldType::RadioButton)
+        painter.Circle(x, y, size / 2 - 0.5);
+    else
+        painter.Rectangle(0.5, 0.5, width - 1, height - 1);
+
+    painter.Stroke();
+    if (on)
+    {
+        // The mark fits a square centered in the button
+        double radius = size * 0.3;
+        switch (style)
+        {
+            case PdfButtonStyle::Check:
+                painter.GetGraphicsState().SetLineWidth(size * 0.1);
+                painter.MoveTo(x - radius, y);
+                painter.LineTo(x - radius * 0.3, y - radius * 0.7);
+                painter.LineTo(x + radius, y + radius * 0.8);
+                painter.Stroke();
+                break;
+            case PdfButtonStyle::Cross:
+                painter.GetGraphicsState().SetLineWidth(size * 0.1);
+                painter.MoveTo(x - radius, y - radius);
+                painter.LineTo(x + radius, y + radius);
+                painter.MoveTo(x - radius, y + radius);
+                painter.LineTo(x + radius, y - radius);
+                painter.Stroke();
+                break;
+            case PdfButtonStyle::Circle:
+                painter.Circle(x, y, radius);
+                painter.Fill();
+                break;
+            case PdfButtonStyle::Diamond:
+                painter.MoveTo(x, y - radius);
+                painter.LineTo(x + radius, y);
+                painter.LineTo(x, y + radius);
+                painter.LineTo(x - radius, y);
+                painter.ClosePath();
+                painter.Fill();
+                break;
+            case PdfButtonStyle::Square:
+                painter.Rectangle(x - radius, y - radius, radius * 2, radius * 2);
+                painter.Fill();
+                break;
+            default:
+                PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
+        }
+    }
+
+    painter.FinishDrawing();
+}
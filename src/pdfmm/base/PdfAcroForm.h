@@ -11,11 +11,17 @@
 
 #include "PdfDeclarations.h"
 
+#include <map>
+#include <unordered_map>
+
+#include "PdfButton.h"
 #include "PdfElement.h"
+#include "PdfString.h"
 
 namespace mm {
 
 class PdfDocument;
+class PdfField;
 
 enum  class PdfAcroFormDefaulAppearance
 {
@@ -25,6 +31,8 @@ enum  class PdfAcroFormDefaulAppearance
 
 class PDFMM_API PdfAcroForm final : public PdfDictionaryElement
 {
+    friend class PdfButton;
+
 public:
 
     /** Create a new PdfAcroForm dictionary object
@@ -39,8 +47,35 @@ public:
      */
     PdfAcroForm(PdfObject& obj);
 
+    ~PdfAcroForm();
+
     PdfArray& GetOrCreateFieldsArray();
 
+    /** Get a field by its fully qualified name
+     *
+     *  The fields are indexed by full name on the first lookup,
+     *  and the index is built again only when a lookup misses or
+     *  finds a stale field after the document has been modified.
+     *  The returned field is owned by this form and stays valid
+     *  until the index is built again
+     *
+     *  \param fullName the full name of the field, e.g. "parent.child"
+     *  \returns the field, or nullptr if not found
+     */
+    PdfField* GetField(const std::string_view& fullName);
+
+    /** Set the values of many fields in one pass
+     *
+     *  Text boxes are set with the given text, choice fields
+     *  select the item with the given value and check boxes
+     *  are checked unless the value is empty or "Off". Instead
+     *  of updating the appearance of every field, NeedAppearances
+     *  is set once at the end, so the viewer regenerates them
+     *
+     *  \param values pairs of full field names and values
+     */
+    void FillFields(const std::vector<std::pair<std::string, PdfString>>& values);
+
     /** Set the value of the NeedAppearances key in the interactive forms
      *  dictionary.
      *
@@ -65,6 +100,32 @@ private:
      *  \param defaultAppearance specifies if a default appearance should be added
      */
     void Init(PdfAcroFormDefaulAppearance defaultAppearance);
+
+    void buildFieldIndex();
+
+    bool isFieldValid(const PdfField& field, const std::string_view& fullName) const;
+
+    /** Get the on and off appearances of the buttons with the
+     *  given type, size and style, creating them the first time
+     */
+    void getButtonAppearances(PdfFieldType type, double width, double height,
+        PdfButtonStyle style, PdfReference& on, PdfReference& off);
+
+private:
+    struct ButtonAppearances
+    {
+        PdfReference On;
+        PdfReference Off;
+    };
+
+    using ButtonAppearanceKey = std::tuple<PdfFieldType, double, double, PdfButtonStyle>;
+
+private:
+    std::vector<std::unique_ptr<PdfField>> m_Fields;
+    std::unordered_map<std::string, PdfField*> m_FieldIndex;
+    uint64_t m_FieldIndexModificationCount;
+    bool m_FieldIndexValid;
+    std::map<ButtonAppearanceKey, ButtonAppearances> m_buttonAppearances;
 };
 
 };
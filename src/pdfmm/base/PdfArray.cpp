@@ -9,26 +9,41 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfArray.h"
 #include "PdfOutputDevice.h"
+#include "PdfInputDevice.h"
+#include "PdfTokenizer.h"
+#include "PdfVariant.h"
 
 using namespace std;
 using namespace mm;
 
+// The source of an array whose reading is deferred
+struct PdfArray::LazySource
+{
+    InputStreamDevice* Device;
+    size_t Offset;
+    PdfStatefulEncrypt Encrypt;
+};
+
 PdfArray::PdfArray() { }
 
 PdfArray::PdfArray(const PdfArray& rhs)
-    : m_Objects(rhs.m_Objects)
 {
+    rhs.delayedLoad();
+    m_Objects = rhs.m_Objects;
     setChildrenParent();
 }
 
 PdfArray::PdfArray(PdfArray&& rhs) noexcept
-    : m_Objects(std::move(rhs.m_Objects))
+    : m_Objects(std::move(rhs.m_Objects)), m_lazySource(std::move(rhs.m_lazySource))
 {
     setChildrenParent();
 }
 
+PdfArray::~PdfArray() { }
+
 void PdfArray::RemoveAt(unsigned idx)
 {
+    delayedLoad();
     // TODO: Set dirty only if really removed
     if (idx >= m_Objects.size())
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Index is out of bounds");
@@ -49,7 +64,9 @@ PdfObject& PdfArray::FindAt(unsigned idx)
 
 PdfArray& PdfArray::operator=(const PdfArray& rhs)
 {
+    rhs.delayedLoad();
     m_Objects = rhs.m_Objects;
+    m_lazySource = nullptr;
     setChildrenParent();
     return *this;
 }
@@ -57,17 +74,20 @@ PdfArray& PdfArray::operator=(const PdfArray& rhs)
 PdfArray& PdfArray::operator=(PdfArray&& rhs) noexcept
 {
     m_Objects = std::move(rhs.m_Objects);
+    m_lazySource = std::move(rhs.m_lazySource);
     setChildrenParent();
     return *this;
 }
 
 unsigned PdfArray::GetSize() const
 {
+    delayedLoad();
     return (unsigned)m_Objects.size();
 }
 
 bool PdfArray::IsEmpty() const
 {
+    delayedLoad();
     return m_Objects.empty();
 }
 
@@ -109,6 +129,7 @@ PdfObject& PdfArray::AddIndirectSafe(const PdfObject& obj)
 
 PdfObject& PdfArray::SetAt(unsigned idx, const PdfObject& obj)
 {
+    delayedLoad();
     if (idx >= m_Objects.size())
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Index is out of bounds");
 
@@ -120,6 +141,7 @@ PdfObject& PdfArray::SetAt(unsigned idx, const PdfObject& obj)
 
 PdfObject& PdfArray::SetAt(unsigned idx, PdfObject&& obj)
 {
+    delayedLoad();
     if (idx >= m_Objects.size())
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Index is out of bounds");
 
@@ -131,6 +153,7 @@ PdfObject& PdfArray::SetAt(unsigned idx, PdfObject&& obj)
 
 void PdfArray::SetAtIndirect(unsigned idx, const PdfObject* obj)
 {
+    delayedLoad();
     if (idx >= m_Objects.size())
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Index is out of bounds");
 
@@ -144,6 +167,7 @@ void PdfArray::SetAtIndirect(unsigned idx, const PdfObject* obj)
 
 PdfObject& PdfArray::SetAtIndirectSafe(unsigned idx, const PdfObject& obj)
 {
+    delayedLoad();
     if (idx >= m_Objects.size())
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Index is out of bounds");
 
@@ -169,9 +193,10 @@ PdfArrayConstIndirectIterable PdfArray::GetIndirectIterator() const
 
 void PdfArray::Clear()
 {
-    if (m_Objects.size() == 0)
+    if (m_lazySource == nullptr && m_Objects.size() == 0)
         return;
 
+    m_lazySource = nullptr;
     m_Objects.clear();
     SetDirty();
 }
@@ -179,6 +204,7 @@ void PdfArray::Clear()
 void PdfArray::Write(OutputStreamDevice& device, PdfWriteFlags writeMode,
     const PdfStatefulEncrypt& encrypt, charbuff& buffer) const
 {
+    delayedLoad();
     auto it = m_Objects.begin();
 
     int count = 1;
@@ -188,14 +214,23 @@ void PdfArray::Write(OutputStreamDevice& device, PdfWriteFlags writeMode,
     else
         device.Write('[');
 
+    // In minimal mode the literals following a delimiter are not spaced
+    bool minimal = (writeMode & (PdfWriteFlags::Clean | PdfWriteFlags::Minimal)) == PdfWriteFlags::Minimal;
+    bool delimited = true;
     while (it != m_Objects.end())
     {
-        it->GetVariant().Write(device, writeMode, encrypt, buffer);
+        auto& variant = it->GetVariant();
+        if (minimal && delimited && IsLiteralDataType(variant.GetDataType()))
+            variant.Write(device, writeMode | PdfWriteFlags::NoInlineLiteral, encrypt, buffer);
+        else
+            variant.Write(device, writeMode, encrypt, buffer);
+
         if ((writeMode & PdfWriteFlags::Clean) == PdfWriteFlags::Clean)
         {
             device.Write((count % 10 == 0) ? '\n' : ' ');
         }
 
+        delimited = IsDelimitedDataType(variant.GetDataType());
         it++;
         count++;
     }
@@ -205,6 +240,7 @@ void PdfArray::Write(OutputStreamDevice& device, PdfWriteFlags writeMode,
 
 void PdfArray::ResetDirtyInternal()
 {
+    // NOTE: The children of a lazy array are not read yet, so they are clean
     // Propagate state to all subclasses
     for (auto& obj : m_Objects)
         obj.ResetDirty();
@@ -217,20 +253,80 @@ void PdfArray::setChildrenParent()
         obj.SetParent(*this);
 }
 
+void PdfArray::setLazySource(InputStreamDevice& device, size_t offset, const PdfStatefulEncrypt& encrypt)
+{
+    m_Objects.clear();
+    m_lazySource.reset(new LazySource{ &device, offset, encrypt });
+}
+
+size_t PdfArray::getLazySourceMemoryUsage() const
+{
+    return m_lazySource == nullptr ? 0 : sizeof(LazySource);
+}
+
+void PdfArray::load()
+{
+    // Read the array again from the recorded offset, restoring the
+    // device position as the device may be in use by the parser
+    auto& device = *m_lazySource->Device;
+    size_t prevPosition = device.GetPosition();
+    PdfTokenizer tokenizer;
+    PdfVariant variant;
+    device.Seek(m_lazySource->Offset);
+    tokenizer.ReadNextVariant(device, variant, m_lazySource->Encrypt);
+    device.Seek(prevPosition);
+
+    // NOTE: Don't set dirty, the array is just being read
+    m_Objects = std::move(variant.GetArray().m_Objects);
+    m_lazySource = nullptr;
+    setChildrenParent();
+}
+
 PdfObject& PdfArray::add(PdfObject&& obj)
 {
     return *insertAt(m_Objects.end(), std::move(obj));
 }
 
+PdfObject& PdfArray::adoptBack()
+{
+    auto& ret = m_Objects.back();
+    ret.SetParent(*this);
+    SetDirty();
+    return ret;
+}
+
+void PdfArray::prepareAdd(size_t count)
+{
+    size_t size = m_Objects.size() + count;
+    if (size > m_Objects.capacity())
+        reserveObjects(std::max(size, m_Objects.capacity() * 2));
+}
+
+void PdfArray::reserveObjects(size_t size)
+{
+    if (size <= m_Objects.capacity())
+        return;
+
+    // NOTE: Moved objects are detached from their parent
+    m_Objects.reserve(size);
+    setChildrenParent();
+}
+
 PdfArray::iterator PdfArray::insertAt(const iterator& pos, PdfObject&& obj)
 {
-    auto ret = m_Objects.emplace(pos, std::move(obj));
+    delayedLoad();
+    // NOTE: Reserve first, since the position is invalidated
+    // if the objects are moved
+    size_t index = pos - m_Objects.begin();
+    prepareAdd(1);
+    auto ret = m_Objects.emplace(m_Objects.begin() + index, std::move(obj));
     ret->SetParent(*this);
     return ret;
 }
 
 PdfObject& PdfArray::getAt(unsigned idx) const
 {
+    delayedLoad();
     if (idx >= (unsigned)m_Objects.size())
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Index is out of bounds");
 
@@ -239,6 +335,7 @@ PdfObject& PdfArray::getAt(unsigned idx) const
 
 PdfObject& PdfArray::findAt(unsigned idx) const
 {
+    delayedLoad();
     if (idx >= (unsigned)m_Objects.size())
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Index is out of bounds");
 
@@ -251,6 +348,7 @@ PdfObject& PdfArray::findAt(unsigned idx) const
 
 size_t PdfArray::size() const
 {
+    delayedLoad();
     return m_Objects.size();
 }
 
@@ -270,6 +368,7 @@ PdfArray::iterator PdfArray::insert(const iterator& pos, PdfObject&& obj)
 
 void PdfArray::erase(const iterator& pos)
 {
+    delayedLoad();
     // TODO: Set dirty only if really removed
     m_Objects.erase(pos);
     SetDirty();
@@ -277,6 +376,7 @@ void PdfArray::erase(const iterator& pos)
 
 void PdfArray::erase(const iterator& first, const iterator& last)
 {
+    delayedLoad();
     // TODO: Set dirty only if really removed
     m_Objects.erase(first, last);
     SetDirty();
@@ -284,7 +384,9 @@ void PdfArray::erase(const iterator& first, const iterator& last)
 
 void PdfArray::Resize(unsigned count, const PdfObject& val)
 {
+    delayedLoad();
     size_t currentSize = m_Objects.size();
+    reserveObjects(count);
     m_Objects.resize(count, val);
     for (size_t i = currentSize; i < count; i++)
     {
@@ -298,7 +400,39 @@ void PdfArray::Resize(unsigned count, const PdfObject& val)
 
 void PdfArray::Reserve(unsigned n)
 {
-    m_Objects.reserve(n);
+    delayedLoad();
+    reserveObjects(n);
+}
+
+void PdfArray::AddNumbers(const cspan<int64_t>& numbers)
+{
+    delayedLoad();
+    auto document = GetObjectDocument();
+    prepareAdd(numbers.size());
+    for (int64_t number : numbers)
+    {
+        // NOTE: Numbers have no variant data owned by the document
+        auto& obj = m_Objects.emplace_back(number);
+        obj.m_Parent = this;
+        obj.m_Document = document;
+    }
+
+    SetDirty();
+}
+
+void PdfArray::AddReals(const cspan<double>& numbers)
+{
+    delayedLoad();
+    auto document = GetObjectDocument();
+    prepareAdd(numbers.size());
+    for (double number : numbers)
+    {
+        auto& obj = m_Objects.emplace_back(number);
+        obj.m_Parent = this;
+        obj.m_Document = document;
+    }
+
+    SetDirty();
 }
 
 PdfObject& PdfArray::operator[](size_type idx)
@@ -313,79 +447,97 @@ const PdfObject& PdfArray::operator[](size_type idx) const
 
 PdfArray::iterator PdfArray::begin()
 {
+    delayedLoad();
     return m_Objects.begin();
 }
 
 PdfArray::const_iterator PdfArray::begin() const
 {
+    delayedLoad();
     return m_Objects.begin();
 }
 
 PdfArray::iterator PdfArray::end()
 {
+    delayedLoad();
     return m_Objects.end();
 }
 
 PdfArray::const_iterator PdfArray::end() const
 {
+    delayedLoad();
     return m_Objects.end();
 }
 
 PdfArray::reverse_iterator PdfArray::rbegin()
 {
+    delayedLoad();
     return m_Objects.rbegin();
 }
 
 PdfArray::const_reverse_iterator PdfArray::rbegin() const
 {
+    delayedLoad();
     return m_Objects.rbegin();
 }
 
 PdfArray::reverse_iterator PdfArray::rend()
 {
+    delayedLoad();
     return m_Objects.rend();
 }
 
 PdfArray::const_reverse_iterator PdfArray::rend() const
 {
+    delayedLoad();
     return m_Objects.rend();
 }
 
 void PdfArray::resize(size_t size)
 {
+    delayedLoad();
 #ifndef NDEBUG
     if (size > numeric_limits<unsigned>::max())
         throw length_error("Too big size");
 #endif
+    size_t currentSize = m_Objects.size();
+    reserveObjects(size);
     m_Objects.resize(size);
+    for (size_t i = currentSize; i < size; i++)
+        m_Objects[i].SetParent(*this);
 }
 
 void PdfArray::reserve(size_t size)
 {
+    delayedLoad();
 #ifndef NDEBUG
     if (size > numeric_limits<unsigned>::max())
         throw length_error("Too big size");
 #endif
-    m_Objects.reserve(size);
+    reserveObjects(size);
 }
 
 PdfObject& PdfArray::front()
 {
+    delayedLoad();
     return m_Objects.front();
 }
 
 const PdfObject& PdfArray::front() const
 {
+    delayedLoad();
     return m_Objects.front();
 }
 
 PdfObject& PdfArray::back()
 {
+    delayedLoad();
     return m_Objects.back();
 }
 
 const PdfObject& PdfArray::back() const
 {
+    delayedLoad();
     return m_Objects.back();
 }
 
@@ -394,6 +546,9 @@ bool PdfArray::operator==(const PdfArray& rhs) const
     if (this == &rhs)
         return true;
 
+    delayedLoad();
+    rhs.delayedLoad();
+
     // We don't check owner
     return m_Objects == rhs.m_Objects;
 }
@@ -403,6 +558,9 @@ bool PdfArray::operator!=(const PdfArray& rhs) const
     if (this == &rhs)
         return false;
 
+    delayedLoad();
+    rhs.delayedLoad();
+
     // We don't check owner
     return m_Objects != rhs.m_Objects;
 }
@@ -14,6 +14,7 @@
 
 namespace mm {
 
+class InputStreamDevice;
 class PdfArray;
 using PdfArrayList = std::vector<PdfObject>;
 
@@ -79,6 +80,7 @@ using PdfArrayConstIndirectIterable = PdfArrayIndirectIterableBase<const PdfObje
 class PDFMM_API PdfArray final : public PdfDataContainer
 {
     friend class PdfObject;
+    friend class PdfTokenizer;
 public:
     using size_type = size_t;
     using value_type = PdfObject;
@@ -100,6 +102,8 @@ public:
     PdfArray(const PdfArray& rhs);
     PdfArray(PdfArray&& rhs) noexcept;
 
+    ~PdfArray();
+
     /** assignment operator
      *
      *  \param rhs the array to assign
@@ -167,6 +171,16 @@ public:
 
     void Reserve(unsigned n);
 
+    /** Append integer numbers, constructing the objects in place
+     *  after a single reservation of the capacity
+     */
+    void AddNumbers(const cspan<int64_t>& numbers);
+
+    /** Append real numbers, constructing the objects in place
+     *  after a single reservation of the capacity
+     */
+    void AddReals(const cspan<double>& numbers);
+
 public:
     /**
      *  \returns the size of the array
@@ -236,6 +250,12 @@ public:
 
     void reserve(size_t size);
 
+    /** Construct an object in place at the end of the array
+     *  \returns the constructed object
+     */
+    template<typename... TArgs>
+    PdfObject& emplace_back(TArgs&&... args);
+
     iterator insert(const iterator& pos, const PdfObject& obj);
     iterator insert(const iterator& pos, PdfObject&& obj);
 
@@ -278,20 +298,60 @@ protected:
     void setChildrenParent() override;
 
 private:
+    struct LazySource;
+
+    /** Defer the reading of the array, which will be read again
+     *  from the given device offset when it's accessed the first time.
+     *  The device must outlive the array
+     */
+    void setLazySource(InputStreamDevice& device, size_t offset, const PdfStatefulEncrypt& encrypt);
+
+    /** Read the array if its reading was deferred
+     */
+    inline void delayedLoad() const
+    {
+        if (m_lazySource != nullptr)
+            const_cast<PdfArray&>(*this).load();
+    }
+
+    void load();
+
+    /** \returns the memory of the state kept to read
+     *      the array, or 0 if it's already read
+     */
+    size_t getLazySourceMemoryUsage() const;
+
     PdfObject& add(PdfObject&& obj);
+    // Adopt the object just constructed at the end of the array
+    PdfObject& adoptBack();
+    // Ensure the capacity for more objects, growing it geometrically
+    void prepareAdd(size_t count);
+    // Reserve the capacity, setting again the parent of the moved objects
+    void reserveObjects(size_t size);
     iterator insertAt(const iterator& pos, PdfObject&& obj);
     PdfObject& getAt(unsigned idx) const;
     PdfObject& findAt(unsigned idx) const;
 
 private:
     PdfArrayList m_Objects;
+    std::unique_ptr<LazySource> m_lazySource;
 };
 
+template<typename... TArgs>
+PdfObject& PdfArray::emplace_back(TArgs&&... args)
+{
+    delayedLoad();
+    prepareAdd(1);
+    m_Objects.emplace_back(std::forward<TArgs>(args)...);
+    return adoptBack();
+}
+
 template<typename InputIterator>
 void PdfArray::insert(const PdfArray::iterator& pos,
     const InputIterator& first,
     const InputIterator& last)
 {
+    delayedLoad();
     auto document = GetObjectDocument();
     iterator it1 = first;
     iterator it2 = pos;
@@ -10,6 +10,9 @@
 
 #include "PdfButton.h"
 
+#include "PdfAcroForm.h"
+#include "PdfDocument.h"
+
 using namespace std;
 using namespace mm;
 
@@ -58,3 +61,27 @@ nullable<PdfString> PdfButton::GetCaption() const
 
     return { };
 }
+
+void PdfButton::createAppearances(PdfButtonStyle style, const PdfName& onState)
+{
+    auto widget = GetWidgetAnnotation();
+    if (widget == nullptr)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The button has no widget");
+
+    auto rect = widget->GetRect();
+    PdfReference on;
+    PdfReference off;
+    GetDocument().GetOrCreateAcroForm().getButtonAppearances(GetType(),
+        rect.GetWidth(), rect.GetHeight(), style, on, off);
+
+    PdfDictionary normal;
+    normal.AddKey(onState, on);
+    normal.AddKey("Off", off);
+    PdfDictionary appearance;
+    appearance.AddKey("N", normal);
+
+    auto& dict = widget->GetDictionary();
+    dict.AddKey("AP", appearance);
+    if (!dict.HasKey("AS"))
+        dict.AddKey("AS", PdfName("Off"));
+}
@@ -13,6 +13,18 @@
 
 namespace mm
 {
+    /** The look of the on state of the generated appearances
+     *  of check boxes and radio buttons
+     */
+    enum class PdfButtonStyle
+    {
+        Check,
+        Circle,
+        Cross,
+        Diamond,
+        Square,
+    };
+
     class PDFMM_API PdfButton : public PdfField
     {
         friend class PdfField;
@@ -57,6 +69,13 @@ namespace mm
          *  \returns the caption of this button
          */
         nullable<PdfString> GetCaption() const;
+
+    protected:
+        /** Set the normal appearances of the widget, with
+         *  the given on state and the /Off state. Widgets of the
+         *  same type, size and style share the same XObjects
+         */
+        void createAppearances(PdfButtonStyle style, const PdfName& onState);
     };
 }
 
@@ -7,29 +7,51 @@ using namespace std;
 using namespace mm;
 
 PdfCIDToGIDMap::PdfCIDToGIDMap(CIDToGIDMap&& map, PdfGlyphAccess access)
-    : m_cidToGidMap(std::move(map)), m_access(access) { }
+    : PdfCIDToGIDMap(vector<pair<unsigned, unsigned>>(map.begin(), map.end()), access) { }
+
+PdfCIDToGIDMap::PdfCIDToGIDMap(vector<pair<unsigned, unsigned>>&& entries, PdfGlyphAccess access)
+    : m_entries(std::move(entries)), m_access(access)
+{
+    // The entries are sorted and unique, so the CIDs are dense
+    // if the last one is the count of the entries minus one
+    m_isDense = m_entries.size() == 0 || m_entries.back().first == m_entries.size() - 1;
+}
 
 PdfCIDToGIDMap PdfCIDToGIDMap::Create(const PdfObject& cidToGidMapObj, PdfGlyphAccess access)
 {
-    CIDToGIDMap map;
     // Table 115 — Entries in a CIDFont dictionary
     // "The glyph index for a particular CID value c shall be
     // a 2 - byte value stored in bytes 2 × c and 2 × c + 1,
     // where the first byte shall be the high - order byte"
     auto buffer = cidToGidMapObj.MustGetStream().GetFilteredCopy();
-    for (unsigned i = 0, count = (unsigned)buffer.size() / 2; i < count; i++)
+    unsigned count = (unsigned)buffer.size() / 2;
+    vector<pair<unsigned, unsigned>> entries(count);
+    for (unsigned i = 0; i < count; i++)
     {
-        unsigned gid = (unsigned)buffer[i * 2 + 0] << 8 | (unsigned)buffer[i * 2 + 1];
-        map[i] = gid;
+        unsigned gid = (unsigned)(uint8_t)buffer[i * 2 + 0] << 8 | (unsigned)(uint8_t)buffer[i * 2 + 1];
+        entries[i] = { i, gid };
     }
 
-    return PdfCIDToGIDMap(std::move(map), access);
+    return PdfCIDToGIDMap(std::move(entries), access);
 }
 
 bool PdfCIDToGIDMap::TryMapCIDToGID(unsigned cid, unsigned& gid) const
 {
-    auto found = m_cidToGidMap.find(cid);
-    if (found == m_cidToGidMap.end())
+    if (m_isDense)
+    {
+        if (cid >= m_entries.size())
+        {
+            gid = 0;
+            return false;
+        }
+
+        gid = m_entries[cid].second;
+        return true;
+    }
+
+    auto found = std::lower_bound(m_entries.begin(), m_entries.end(), cid,
+        [](const pair<unsigned, unsigned>& entry, unsigned cid) { return entry.first < cid; });
+    if (found == m_entries.end() || found->first != cid)
     {
         gid = 0;
         return false;
@@ -43,25 +65,13 @@ void PdfCIDToGIDMap::ExportTo(PdfObject& descendantFont)
 {
     auto cidToGidMap = descendantFont.MustGetDocument().GetObjects().CreateDictionaryObject();
     descendantFont.GetDictionary().AddKeyIndirect("CIDToGIDMap", cidToGidMap);
-    auto& stream = cidToGidMap->GetOrCreateStream();
-    stream.BeginAppend();
-    unsigned previousCid = 0;
-    array<char, 2> entry;
-    for (auto& pair : m_cidToGidMap)
-    {
-        entry = { };
-        unsigned cid = previousCid;
-        for (; cid < pair.first; cid++)
-        {
-            // Write zeroes for missing mappings
-            stream.AppendBuffer(entry.data(), 2);
-        }
 
-        utls::WriteUInt16BE(entry.data(), (uint16_t)pair.second);
-        stream.AppendBuffer(entry.data(), 2);
-        previousCid = cid;
-    }
-    stream.EndAppend();
+    // Write the table at once, with zeroes for the missing mappings
+    charbuff buffer(m_entries.size() == 0 ? 0 : (m_entries.back().first + 1) * 2);
+    for (auto& pair : m_entries)
+        utls::WriteUInt16BE(buffer.data() + pair.first * 2, (uint16_t)pair.second);
+
+    cidToGidMap->GetOrCreateStream().Set(buffer);
 }
 
 bool PdfCIDToGIDMap::HasGlyphAccess(PdfGlyphAccess access) const
@@ -71,15 +81,15 @@ bool PdfCIDToGIDMap::HasGlyphAccess(PdfGlyphAccess access) const
 
 unsigned PdfCIDToGIDMap::GetSize() const
 {
-    return (unsigned)m_cidToGidMap.size();
+    return (unsigned)m_entries.size();
 }
 
 PdfCIDToGIDMap::iterator PdfCIDToGIDMap::begin() const
 {
-    return m_cidToGidMap.begin();
+    return m_entries.begin();
 }
 
 PdfCIDToGIDMap::iterator PdfCIDToGIDMap::end() const
 {
-    return m_cidToGidMap.end();
+    return m_entries.end();
 }
@@ -19,7 +19,7 @@ namespace mm
     class PdfCIDToGIDMap final
     {
     public:
-        using iterator = CIDToGIDMap::const_iterator;
+        using iterator = std::vector<std::pair<unsigned, unsigned>>::const_iterator;
 
     public:
         PdfCIDToGIDMap(CIDToGIDMap&& map, PdfGlyphAccess access);
@@ -42,7 +42,13 @@ namespace mm
         iterator end() const;
 
     private:
-        CIDToGIDMap m_cidToGidMap;
+        PdfCIDToGIDMap(std::vector<std::pair<unsigned, unsigned>>&& entries, PdfGlyphAccess access);
+
+    private:
+        // The mappings sorted by CID. When the CIDs are all
+        // the ones from 0 to the size, they are indexed directly
+        std::vector<std::pair<unsigned, unsigned>> m_entries;
+        bool m_isDense;
         PdfGlyphAccess m_access;
     };
 
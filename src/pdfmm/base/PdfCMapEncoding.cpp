@@ -9,6 +9,8 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfCMapEncoding.h"
 
+#include <deque>
+#include <mutex>
 #include <utfcpp/utf8.h>
 
 #include "PdfDictionary.h"
@@ -21,12 +23,34 @@
 using namespace std;
 using namespace mm;
 
+// The maximum count of the parsed CMaps in the cache
+static constexpr size_t MaxCachedCMaps = 256;
+
 struct CodeLimits
 {
     unsigned char MinCodeSize = numeric_limits<unsigned char>::max();
     unsigned char MaxCodeSize = 0;
 };
 
+namespace
+{
+    // A parsed CMap. The map is null if it's an identity
+    struct ParsedCMap
+    {
+        shared_ptr<PdfCharCodeMap> Map;
+        PdfEncodingLimits Limits;
+    };
+
+    // A cache of the parsed CMaps, keyed by the CMap content.
+    // The oldest entries are evicted first
+    struct CMapCache
+    {
+        mutex Mutex;
+        unordered_map<string, shared_ptr<const ParsedCMap>> Entries;
+        deque<const string*> Keys;
+    };
+}
+
 static void readNextVariantSequence(PdfPostScriptTokenizer& tokenizer, InputStreamDevice& device,
     PdfVariant& variant, const string_view& endSequenceKeyword, bool& endOfSequence);
 static uint32_t getCodeFromVariant(const PdfVariant& var, CodeLimits& limits);
@@ -38,7 +62,9 @@ static void handleRangeMapping(PdfCharCodeMap& map,
     unsigned char codeSize, unsigned rangeSize);
 static vector<char32_t> handleUtf8String(const string& str);
 static void pushMapping(PdfCharCodeMap& map, const PdfCharCode& codeUnit, const std::vector<char32_t>& codePoints);
-static PdfCharCodeMap parseCMapObject(const PdfObjectStream& stream, CodeLimits& limits);
+static PdfCharCodeMap parseCMapObject(const bufferview& buffer, CodeLimits& limits);
+static shared_ptr<const ParsedCMap> parseCMap(const bufferview& buffer);
+static CMapCache& getCMapCache();
 
 PdfCMapEncoding::PdfCMapEncoding(PdfCharCodeMap&& map)
     : PdfCMapEncoding(std::move(map), map.GetLimits()) { }
@@ -46,10 +72,68 @@ PdfCMapEncoding::PdfCMapEncoding(PdfCharCodeMap&& map)
 PdfCMapEncoding::PdfCMapEncoding(PdfCharCodeMap&& map, const PdfEncodingLimits& limits)
     : PdfEncodingMapBase(std::move(map), PdfEncodingMapType::CMap), m_Limits(limits) { }
 
+PdfCMapEncoding::PdfCMapEncoding(const shared_ptr<PdfCharCodeMap>& map, const PdfEncodingLimits& limits)
+    : PdfEncodingMapBase(map, PdfEncodingMapType::CMap), m_Limits(limits) { }
+
 unique_ptr<PdfEncodingMap> PdfCMapEncoding::CreateFromObject(const PdfObject& cmapObj)
+{
+    charbuff buffer;
+    cmapObj.MustGetStream().ExtractTo(buffer);
+
+    auto& cache = getCMapCache();
+    shared_ptr<const ParsedCMap> parsed;
+    {
+        lock_guard<mutex> lock(cache.Mutex);
+        auto found = cache.Entries.find(buffer);
+        if (found != cache.Entries.end())
+            parsed = found->second;
+    }
+
+    if (parsed == nullptr)
+    {
+        parsed = parseCMap(buffer);
+        // NOTE: The map is shared by many encodings, also in different
+        // threads, so its lazily built reverse lookup is built now
+        if (parsed->Map != nullptr)
+            parsed->Map->reviseCPMap();
+
+        lock_guard<mutex> lock(cache.Mutex);
+        auto inserted = cache.Entries.try_emplace(std::move(buffer), parsed);
+        if (inserted.second)
+        {
+            cache.Keys.push_back(&inserted.first->first);
+            if (cache.Keys.size() > MaxCachedCMaps)
+            {
+                cache.Entries.erase(cache.Entries.find(*cache.Keys.front()));
+                cache.Keys.pop_front();
+            }
+        }
+    }
+
+    if (parsed->Map == nullptr)
+    {
+        return unique_ptr<PdfIdentityEncoding>(new PdfIdentityEncoding(
+            PdfEncodingMapType::CMap, parsed->Limits, PdfIdentityOrientation::Unkwnown));
+    }
+
+    return unique_ptr<PdfCMapEncoding>(new PdfCMapEncoding(parsed->Map, parsed->Limits));
+}
+
+const PdfEncodingLimits& PdfCMapEncoding::GetLimits() const
+{
+    return m_Limits;
+}
+
+bool PdfCMapEncoding::HasLigaturesSupport() const
+{
+    // CMap encodings may have ligatures
+    return true;
+}
+
+shared_ptr<const ParsedCMap> parseCMap(const bufferview& buffer)
 {
     CodeLimits codeLimits;
-    auto map = parseCMapObject(cmapObj.MustGetStream(), codeLimits);
+    auto map = parseCMapObject(buffer, codeLimits);
     auto mapLimits = map.GetLimits();
     // NOTE: In some cases the encoding is degenerate and has no code
     // entries at all, but the CMap may still encode the code size
@@ -59,6 +143,8 @@ unique_ptr<PdfEncodingMap> PdfCMapEncoding::CreateFromObject(const PdfObject& cm
     if (codeLimits.MaxCodeSize > mapLimits.MaxCodeSize)
         mapLimits.MaxCodeSize = codeLimits.MaxCodeSize;
 
+    auto ret = std::make_shared<ParsedCMap>();
+    ret->Limits = mapLimits;
     if (map.GetSize() != 0
         && mapLimits.MinCodeSize == mapLimits.MaxCodeSize)
     {
@@ -83,33 +169,23 @@ unique_ptr<PdfEncodingMap> PdfCMapEncoding::CreateFromObject(const PdfObject& cm
         } while (it != end);
 
         if (identity)
-        {
-            return unique_ptr<PdfIdentityEncoding>(new PdfIdentityEncoding(
-                PdfEncodingMapType::CMap, mapLimits, PdfIdentityOrientation::Unkwnown));
-        }
+            return ret;
     }
 
-    return unique_ptr<PdfCMapEncoding>(new PdfCMapEncoding(std::move(map), mapLimits));
-}
-
-const PdfEncodingLimits& PdfCMapEncoding::GetLimits() const
-{
-    return m_Limits;
+    ret->Map = std::make_shared<PdfCharCodeMap>(std::move(map));
+    return ret;
 }
 
-bool PdfCMapEncoding::HasLigaturesSupport() const
+CMapCache& getCMapCache()
 {
-    // CMap encodings may have ligatures
-    return true;
+    static CMapCache s_cache;
+    return s_cache;
 }
 
-PdfCharCodeMap parseCMapObject(const PdfObjectStream& stream, CodeLimits& limits)
+PdfCharCodeMap parseCMapObject(const bufferview& buffer, CodeLimits& limits)
 {
     PdfCharCodeMap ret;
-    charbuff streamBuffer;
-    stream.ExtractTo(streamBuffer);
-
-    SpanStreamDevice device(streamBuffer);
+    SpanStreamDevice device(buffer);
     PdfPostScriptTokenizer tokenizer;
     deque<unique_ptr<PdfVariant>> tokens;
     PdfString str;
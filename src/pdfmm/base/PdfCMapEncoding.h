@@ -27,11 +27,16 @@ namespace mm
 
     public:
         /** Construct an encoding map from an object
+         *
+         * The parsed CMaps are cached by their content, and the
+         * encodings of identical CMaps share the same immutable map,
+         * also across documents
          */
         static std::unique_ptr<PdfEncodingMap> CreateFromObject(const PdfObject& cmapObj);
 
     private:
         PdfCMapEncoding(PdfCharCodeMap&& map, const PdfEncodingLimits& limits);
+        PdfCMapEncoding(const std::shared_ptr<PdfCharCodeMap>& map, const PdfEncodingLimits& limits);
 
     public:
         bool HasLigaturesSupport() const override;
@@ -8,7 +8,7 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfCanvasInputDevice.h"
 #include "PdfCanvas.h"
-#include "PdfStreamDevice.h"
+#include "PdfObjectInputStream.h"
 
 using namespace std;
 using namespace mm;
@@ -79,6 +79,19 @@ bool PdfCanvasInputDevice::peek(char& ch) const
     }
 }
 
+bool PdfCanvasInputDevice::tryPeek(bufferview& view) const
+{
+    // NOTE: The newline separator inserted on a device switch and
+    // the switch itself are handled by peek() and readChar()
+    if (m_eof || m_deviceSwitchOccurred)
+    {
+        view = { };
+        return false;
+    }
+
+    return m_currDevice->TryPeek(view);
+}
+
 size_t PdfCanvasInputDevice::readBuffer(char* buffer, size_t size, bool& eof)
 {
     PDFMM_ASSERT(size != 0);
@@ -122,6 +135,8 @@ size_t PdfCanvasInputDevice::readBuffer(char* buffer, size_t size, bool& eof)
         read = device->Read(buffer + count, size, eof);
         size -= read;
         count += read;
+        if (size == 0)
+            return count;
     }
 }
 
@@ -205,11 +220,14 @@ bool PdfCanvasInputDevice::tryPopNextDevice()
         if (contents == nullptr)
             continue;
 
-        contents->ExtractTo(m_buffer);
-        if (m_buffer.size() == 0)
+        // Decode the stream while reading it, not to hold the whole
+        // decoded content. Skip streams decoding to no data
+        auto device = std::make_unique<PdfObjectInputStream>(*contents);
+        char ch;
+        if (!device->Peek(ch))
             continue;
 
-        m_currDevice = std::make_unique<SpanStreamDevice>(m_buffer);
+        m_currDevice = std::move(device);
         return true;
     }
 
@@ -38,10 +38,10 @@ protected:
     size_t readBuffer(char* buffer, size_t size, bool& eof) override;
     bool readChar(char& ch) override;
     bool peek(char& ch) const override;
+    bool tryPeek(bufferview& view) const override;
 private:
     bool m_eof;
     std::list<const PdfObject*> m_contents;
-    charbuff m_buffer;
     std::unique_ptr<InputStreamDevice> m_currDevice;
     bool m_deviceSwitchOccurred;
 };
@@ -7,25 +7,24 @@
 
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfCharCodeMap.h"
-#include <random>
 #include <algorithm>
 #include <utfcpp/utf8.h>
 
 using namespace std;
 using namespace mm;
 
+// The maximum code looked up directly, so the table takes at most 512KB
+static constexpr unsigned MaxDirectCode = 0xFFFF;
+
 PdfCharCodeMap::PdfCharCodeMap()
-    : m_MapDirty(false), m_codePointMapHead(nullptr), m_depth(0) { }
+    : m_directFirstCode(0), m_MapDirty(false), m_codePointMapRootCount(0) { }
 
 PdfCharCodeMap::PdfCharCodeMap(PdfCharCodeMap&& map) noexcept
 {
     move(map);
 }
 
-PdfCharCodeMap::~PdfCharCodeMap()
-{
-    deleteNode(m_codePointMapHead);
-}
+PdfCharCodeMap::~PdfCharCodeMap() { }
 
 PdfCharCodeMap& PdfCharCodeMap::operator=(PdfCharCodeMap&& map) noexcept
 {
@@ -45,11 +44,15 @@ const PdfEncodingLimits& PdfCharCodeMap::GetLimits() const
 
 void PdfCharCodeMap::move(PdfCharCodeMap& map) noexcept
 {
+    // NOTE: Moving the map keeps the addresses of its
+    // values, which are referenced by the direct lookup
     m_CodeUnitMap = std::move(map.m_CodeUnitMap);
+    m_directCodes = std::move(map.m_directCodes);
+    utls::move(map.m_directFirstCode, m_directFirstCode);
     utls::move(map.m_Limits, m_Limits);
     utls::move(map.m_MapDirty, m_MapDirty);
-    utls::move(map.m_codePointMapHead, m_codePointMapHead);
-    utls::move(map.m_depth, m_depth);
+    m_codePointMap = std::move(map.m_codePointMap);
+    utls::move(map.m_codePointMapRootCount, m_codePointMapRootCount);
 }
 
 void PdfCharCodeMap::PushMapping(const PdfCharCode& codeUnit, const codepointview& codePoints)
@@ -69,21 +72,21 @@ void PdfCharCodeMap::PushMapping(const PdfCharCode& codeUnit, codepoint codePoin
 
 bool PdfCharCodeMap::TryGetCodePoints(const PdfCharCode& codeUnit, vector<codepoint>& codePoints) const
 {
-    auto found = m_CodeUnitMap.find(codeUnit);
-    if (found == m_CodeUnitMap.end())
+    auto found = findCodePoints(codeUnit);
+    if (found == nullptr)
     {
         codePoints.clear();
         return false;
     }
 
-    codePoints = found->second;
+    codePoints.assign(found->begin(), found->end());
     return true;
 }
 
 bool PdfCharCodeMap::TryGetNextCharCode(string_view::iterator& it, const string_view::iterator& end, PdfCharCode& code) const
 {
     const_cast<PdfCharCodeMap&>(*this).reviseCPMap();
-    return tryFindNextCharacterId(m_codePointMapHead, it, end, code);
+    return tryFindNextCharacterId(0, m_codePointMapRootCount, it, end, code);
 }
 
 bool PdfCharCodeMap::TryGetCharCode(const codepointview& codePoints, PdfCharCode& codeUnit) const
@@ -91,14 +94,16 @@ bool PdfCharCodeMap::TryGetCharCode(const codepointview& codePoints, PdfCharCode
     const_cast<PdfCharCodeMap&>(*this).reviseCPMap();
     auto it = codePoints.begin();
     auto end = codePoints.end();
-    const CPMapNode* node = m_codePointMapHead;
+    const CPMapNode* node = nullptr;
+    unsigned index = 0;
+    unsigned count = m_codePointMapRootCount;
     if (it == end)
         goto NotFound;
 
     while (true)
     {
         // All the sequence must match
-        node = findNode(node, *it);
+        node = findNode(index, count, *it);
         if (node == nullptr)
             goto NotFound;
 
@@ -106,7 +111,8 @@ bool PdfCharCodeMap::TryGetCharCode(const codepointview& codePoints, PdfCharCode
         if (it == end)
             break;
 
-        node = node->Ligatures;
+        index = node->LigaturesIndex;
+        count = node->LigaturesCount;
     }
 
     if (node->CodeUnit.CodeSpaceSize == 0)
@@ -128,8 +134,8 @@ NotFound:
 bool PdfCharCodeMap::TryGetCharCode(codepoint codePoint, PdfCharCode& code) const
 {
     const_cast<PdfCharCodeMap&>(*this).reviseCPMap();
-    auto node = findNode(m_codePointMapHead, codePoint);
-    if (node == nullptr)
+    auto node = findNode(0, m_codePointMapRootCount, codePoint);
+    if (node == nullptr || node->CodeUnit.CodeSpaceSize == 0)
     {
         code = { };
         return false;
@@ -144,7 +150,9 @@ void PdfCharCodeMap::pushMapping(const PdfCharCode& codeUnit, vector<codepoint>&
     if (codeUnit.CodeSpaceSize == 0)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Code unit must be valid");
 
-    m_CodeUnitMap[codeUnit] = std::move(codePoints);
+    auto& mapped = m_CodeUnitMap[codeUnit];
+    mapped = std::move(codePoints);
+    pushDirectMapping(codeUnit, mapped);
 
     // Update limits
     if (codeUnit.CodeSpaceSize < m_Limits.MinCodeSize)
@@ -159,13 +167,53 @@ void PdfCharCodeMap::pushMapping(const PdfCharCode& codeUnit, vector<codepoint>&
     m_MapDirty = true;
 }
 
-bool PdfCharCodeMap::tryFindNextCharacterId(const CPMapNode* node, string_view::iterator& it,
-    const string_view::iterator& end, PdfCharCode& codeUnit)
+void PdfCharCodeMap::pushDirectMapping(const PdfCharCode& codeUnit, const vector<codepoint>& codePoints)
+{
+    unsigned code = codeUnit.Code;
+    if (code > MaxDirectCode)
+        return;
+
+    if (m_directCodes.size() == 0)
+    {
+        m_directFirstCode = code;
+        m_directCodes.resize(1);
+    }
+    else if (code < m_directFirstCode)
+    {
+        m_directCodes.insert(m_directCodes.begin(), m_directFirstCode - code, nullptr);
+        m_directFirstCode = code;
+    }
+    else if (code - m_directFirstCode >= m_directCodes.size())
+    {
+        m_directCodes.resize(code - m_directFirstCode + 1);
+    }
+
+    m_directCodes[code - m_directFirstCode] = &codePoints;
+}
+
+const vector<codepoint>* PdfCharCodeMap::findCodePoints(const PdfCharCode& codeUnit) const
+{
+    if (codeUnit.Code <= MaxDirectCode)
+    {
+        // NOTE: Lower codes wrap around to large indices
+        unsigned index = codeUnit.Code - m_directFirstCode;
+        return index < m_directCodes.size() ? m_directCodes[index] : nullptr;
+    }
+
+    auto found = m_CodeUnitMap.find(codeUnit);
+    if (found == m_CodeUnitMap.end())
+        return nullptr;
+
+    return &found->second;
+}
+
+bool PdfCharCodeMap::tryFindNextCharacterId(unsigned index, unsigned count, string_view::iterator& it,
+    const string_view::iterator& end, PdfCharCode& codeUnit) const
 {
     PDFMM_INVARIANT(it != end);
     string_view::iterator curr;
     codepoint codePoint = (codepoint)utf8::next(it, end);
-    node = findNode(node, codePoint);
+    auto node = findNode(index, count, codePoint);
     if (node == nullptr)
         goto NotFound;
 
@@ -174,7 +222,8 @@ bool PdfCharCodeMap::tryFindNextCharacterId(const CPMapNode* node, string_view::
         // Try to find ligatures, save a temporary iterator
         // in case the search in unsuccessful
         curr = it;
-        if (tryFindNextCharacterId(node->Ligatures, curr, end, codeUnit))
+        if (node->LigaturesCount != 0
+            && tryFindNextCharacterId(node->LigaturesIndex, node->LigaturesCount, curr, end, codeUnit))
         {
             it = curr;
             return true;
@@ -197,17 +246,17 @@ NotFound:
     return false;
 }
 
-const PdfCharCodeMap::CPMapNode* PdfCharCodeMap::findNode(const CPMapNode* node, codepoint codePoint)
+const PdfCharCodeMap::CPMapNode* PdfCharCodeMap::findNode(unsigned index, unsigned count, codepoint codePoint) const
 {
-    if (node == nullptr)
+    auto begin = m_codePointMap.data() + index;
+    auto end = begin + count;
+    auto found = std::lower_bound(begin, end, codePoint, [](const CPMapNode& node, codepoint codePoint) {
+        return node.CodePoint < codePoint;
+    });
+    if (found == end || found->CodePoint != codePoint)
         return nullptr;
 
-    if (node->CodePoint == codePoint)
-        return node;
-    else if (node->CodePoint > codePoint)
-        return findNode(node->Left, codePoint);
-    else
-        return findNode(node->Right, codePoint);
+    return found;
 }
 
 void PdfCharCodeMap::reviseCPMap()
@@ -215,64 +264,72 @@ void PdfCharCodeMap::reviseCPMap()
     if (!m_MapDirty)
         return;
 
-    if (m_codePointMapHead != nullptr)
+    // Sort the code point sequences, so the ones with
+    // the same prefix are contiguous
+    struct Mapping
     {
-        deleteNode(m_codePointMapHead);
-        m_codePointMapHead = nullptr;
-    }
-
-    // Randomize items in the map in a separate list
-    // so BST creation will be more balanced
-    // https://en.wikipedia.org/wiki/Random_binary_tree
-    // TODO: Create a perfectly balanced BST
-    vector<pair<PdfCharCode, vector<codepoint>>> pairs;
-    pairs.reserve(m_CodeUnitMap.size());
-    std::copy(m_CodeUnitMap.begin(), m_CodeUnitMap.end(), std::back_inserter(pairs));
-    std::mt19937 e(random_device{}());
-    std::shuffle(pairs.begin(), pairs.end(), e);
-
-    for (auto& pair : pairs)
+        const vector<codepoint>* CodePoints;
+        PdfCharCode CodeUnit;
+    };
+    vector<Mapping> mappings;
+    mappings.reserve(m_CodeUnitMap.size());
+    for (auto& pair : m_CodeUnitMap)
+        mappings.push_back({ &pair.second, pair.first });
+
+    std::stable_sort(mappings.begin(), mappings.end(), [](const Mapping& lhs, const Mapping& rhs) {
+        return *lhs.CodePoints < *rhs.CodePoints;
+    });
+
+    // Add the nodes of a level for the mappings in the given range, with
+    // the given common prefix length, and then the levels of their ligatures
+    m_codePointMap.clear();
+    m_codePointMap.reserve(mappings.size());
+    std::function<unsigned(size_t, size_t, size_t)> addLevel = [&](size_t first, size_t last, size_t depth)
     {
-        CPMapNode** curr = &m_codePointMapHead;      // Node root being searched
-        CPMapNode* found;                     // Last found node
-        auto it = pair.second.begin();
-        auto end = pair.second.end();
-        PDFMM_INVARIANT(it != end);
-        while (true)
+        // Returns the count of the nodes of the level
+        unsigned levelIndex = (unsigned)m_codePointMap.size();
+        vector<size_t> groups;
+        for (size_t i = first; i < last; i++)
         {
-            found = findOrAddNode(*curr, *it);
-            it++;
-            if (it == end)
-                break;
+            codepoint codePoint = (*mappings[i].CodePoints)[depth];
+            if (groups.size() == 0 || m_codePointMap.back().CodePoint != codePoint)
+            {
+                groups.push_back(i);
+                m_codePointMap.push_back({ codePoint, { }, 0, 0 });
+            }
+
+            // NOTE: The first code unit is kept, when
+            // the same sequence is mapped by many
+            auto& node = m_codePointMap.back();
+            if (mappings[i].CodePoints->size() == depth + 1 && node.CodeUnit.CodeSpaceSize == 0)
+                node.CodeUnit = mappings[i].CodeUnit;
+        }
+        groups.push_back(last);
 
-            // We add subsequent codepoints to ligatures
-            curr = &found->Ligatures;
+        for (size_t i = 0; i < groups.size() - 1; i++)
+        {
+            // The mappings ending at this level are sorted first
+            size_t ligaturesFirst = groups[i];
+            while (ligaturesFirst < groups[i + 1] && mappings[ligaturesFirst].CodePoints->size() == depth + 1)
+                ligaturesFirst++;
+
+            if (ligaturesFirst == groups[i + 1])
+                continue;
+
+            unsigned ligaturesIndex = (unsigned)m_codePointMap.size();
+            unsigned ligaturesCount = addLevel(ligaturesFirst, groups[i + 1], depth + 1);
+            auto& node = m_codePointMap[levelIndex + i];
+            node.LigaturesIndex = ligaturesIndex;
+            node.LigaturesCount = ligaturesCount;
         }
 
-        // Finally set the char code on the last found/added node
-        found->CodeUnit = pair.first;
-    }
+        return (unsigned)(groups.size() - 1);
+    };
 
+    m_codePointMapRootCount = mappings.size() == 0 ? 0 : addLevel(0, mappings.size(), 0);
     m_MapDirty = false;
 }
 
-PdfCharCodeMap::CPMapNode* PdfCharCodeMap::findOrAddNode(CPMapNode*& node, codepoint codePoint)
-{
-    if (node == nullptr)
-    {
-        node = new CPMapNode{ };
-        node->CodePoint = codePoint;
-        return node;
-    }
-
-    if (node->CodePoint == codePoint)
-        return node;
-    else if (node->CodePoint > codePoint)
-        return findOrAddNode(node->Left, codePoint);
-    else
-        return findOrAddNode(node->Right, codePoint);
-}
-
 PdfCharCodeMap::iterator PdfCharCodeMap::begin() const
 {
     return m_CodeUnitMap.begin();
@@ -282,14 +339,3 @@ PdfCharCodeMap::iterator PdfCharCodeMap::end() const
 {
     return m_CodeUnitMap.end();
 }
-
-void PdfCharCodeMap::deleteNode(CPMapNode* node)
-{
-    if (node == nullptr)
-        return;
-
-    deleteNode(node->Ligatures);
-    deleteNode(node->Left);
-    deleteNode(node->Right);
-    delete node;
-}
@@ -32,6 +32,8 @@ namespace mm
      */
     class PDFMM_API PdfCharCodeMap final
     {
+        friend class PdfCMapEncoding;
+
     public:
         PdfCharCodeMap();
 
@@ -77,15 +79,18 @@ namespace mm
     private:
         void move(PdfCharCodeMap& map) noexcept;
         void pushMapping(const PdfCharCode& codeUnit, std::vector<codepoint>&& codePoints);
+        void pushDirectMapping(const PdfCharCode& codeUnit, const std::vector<codepoint>& codePoints);
+        const std::vector<codepoint>* findCodePoints(const PdfCharCode& codeUnit) const;
 
-        // Map code point(s) -> code units
+        // Map code point(s) -> code units. The nodes are stored in a
+        // flat array, where the nodes of the same level are contiguous
+        // and sorted by code point, the root level being the first
         struct CPMapNode
         {
             codepoint CodePoint;
             PdfCharCode CodeUnit;
-            CPMapNode* Ligatures;
-            CPMapNode* Left;
-            CPMapNode* Right;
+            unsigned LigaturesIndex;
+            unsigned LigaturesCount;
         };
 
     private:
@@ -94,11 +99,9 @@ namespace mm
 
     private:
         void reviseCPMap();
-        static bool tryFindNextCharacterId(const CPMapNode* node, std::string_view::iterator &it,
-            const std::string_view::iterator& end, PdfCharCode& cid);
-        static const CPMapNode* findNode(const CPMapNode* node, codepoint codePoint);
-        static void deleteNode(CPMapNode* node);
-        static CPMapNode* findOrAddNode(CPMapNode*& node, codepoint codePoint);
+        bool tryFindNextCharacterId(unsigned index, unsigned count, std::string_view::iterator &it,
+            const std::string_view::iterator& end, PdfCharCode& cid) const;
+        const CPMapNode* findNode(unsigned index, unsigned count, codepoint codePoint) const;
 
     public:
         // Map code units -> code point(s)
@@ -113,9 +116,14 @@ namespace mm
     private:
         PdfEncodingLimits m_Limits;
         CodeUnitMap m_CodeUnitMap;
+        // Direct lookup of the code points of the codes up to 0xFFFF,
+        // starting from the first one, pointing to the values of the
+        // code unit map. The other codes are searched in the map
+        std::vector<const std::vector<codepoint>*> m_directCodes;
+        unsigned m_directFirstCode;
         bool m_MapDirty;
-        CPMapNode* m_codePointMapHead;           // Head of a BST to lookup code points
-        int m_depth;
+        std::vector<CPMapNode> m_codePointMap;
+        unsigned m_codePointMapRootCount;
     };
 }
 
@@ -50,6 +50,11 @@ void PdfCheckBox::SetAppearanceUnchecked(const PdfXObject& xobj)
     this->AddAppearanceStream("Off", xobj.GetObject().GetIndirectReference());
 }
 
+void PdfCheckBox::CreateAppearances(PdfButtonStyle style)
+{
+    createAppearances(style, "Yes");
+}
+
 void PdfCheckBox::SetChecked(bool isChecked)
 {
     GetObject().GetDictionary().AddKey("V", (isChecked ? PdfName("Yes") : PdfName("Off")));
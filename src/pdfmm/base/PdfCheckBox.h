@@ -40,6 +40,16 @@ namespace mm
          */
         void SetAppearanceUnchecked(const PdfXObject& xobj);
 
+        /** Generate the checked and unchecked appearance streams
+         *
+         *  The appearances are shared by all the check boxes of the
+         *  document with the same size and style, so many identical
+         *  check boxes reference a single pair of XObjects
+         *
+         *  \param style the look of the checked state
+         */
+        void CreateAppearances(PdfButtonStyle style = PdfButtonStyle::Check);
+
         /** Sets the state of this checkbox
          *
          *  \param isChecked if true the checkbox will be checked
@@ -21,9 +21,19 @@
 #include "PdfInputDevice.h"
 #include "PdfStreamDevice.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define PDFMM_COLOR_CONVERSION_SSE2
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 using namespace mm;
 
+static unsigned getColorComponentCount(PdfColorSpace colorSpace);
+static void convertColors(PdfColorSpace colorSpace, const float* src,
+    PdfColorSpace targetColorSpace, float* dst, size_t count, bool padded);
+static float toSRGB(float linear);
+
 /** A PdfNamedColor holds
  *  a PdfColor object and a name.
  */
@@ -615,6 +625,92 @@ PdfColor PdfColor::ConvertToCMYK() const
     }
 }
 
+PdfCompactColor PdfColor::ToCompact() const
+{
+    PdfCompactColor ret{ m_ColorSpace, { } };
+    switch (m_ColorSpace)
+    {
+        case PdfColorSpace::DeviceGray:
+        {
+            ret.Components[0] = (float)m_Color.gray;
+            break;
+        }
+        case PdfColorSpace::DeviceRGB:
+        case PdfColorSpace::Lab:
+        {
+            for (unsigned i = 0; i < 3; i++)
+                ret.Components[i] = (float)m_Color.rgb[i];
+            break;
+        }
+        case PdfColorSpace::DeviceCMYK:
+        {
+            for (unsigned i = 0; i < 4; i++)
+                ret.Components[i] = (float)m_Color.cmyk[i];
+            break;
+        }
+        default:
+        {
+            PDFMM_RAISE_ERROR(PdfErrorCode::CannotConvertColor);
+        }
+    }
+
+    return ret;
+}
+
+PdfColor PdfColor::FromCompact(const PdfCompactColor& color)
+{
+    auto& components = color.Components;
+    switch (color.ColorSpace)
+    {
+        case PdfColorSpace::DeviceGray:
+            return PdfColor(components[0]);
+        case PdfColorSpace::DeviceRGB:
+            return PdfColor(components[0], components[1], components[2]);
+        case PdfColorSpace::DeviceCMYK:
+            return PdfColor(components[0], components[1], components[2], components[3]);
+        case PdfColorSpace::Lab:
+            return CreateCieLab(components[0], components[1], components[2]);
+        default:
+            PDFMM_RAISE_ERROR(PdfErrorCode::CannotConvertColor);
+    }
+}
+
+void PdfColor::ConvertColors(PdfColorSpace colorSpace, const cspan<float>& components,
+    PdfColorSpace targetColorSpace, const mspan<float>& converted)
+{
+    unsigned componentCount = getColorComponentCount(colorSpace);
+    unsigned targetComponentCount = getColorComponentCount(targetColorSpace);
+    if (componentCount == 0 || targetComponentCount == 0 || targetColorSpace == PdfColorSpace::Lab)
+        PDFMM_RAISE_ERROR(PdfErrorCode::CannotConvertColor);
+
+    size_t count = components.size() / componentCount;
+    if (components.size() % componentCount != 0 || converted.size() < count * targetComponentCount)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Invalid number of color components");
+
+    convertColors(colorSpace, components.data(), targetColorSpace, converted.data(), count, false);
+}
+
+void PdfColor::ConvertColors(const mspan<PdfCompactColor>& colors, PdfColorSpace targetColorSpace)
+{
+    if (getColorComponentCount(targetColorSpace) == 0 || targetColorSpace == PdfColorSpace::Lab)
+        PDFMM_RAISE_ERROR(PdfErrorCode::CannotConvertColor);
+
+    for (auto& color : colors)
+    {
+        if (color.ColorSpace == targetColorSpace)
+            continue;
+
+        if (getColorComponentCount(color.ColorSpace) == 0)
+            PDFMM_RAISE_ERROR(PdfErrorCode::CannotConvertColor);
+
+        // The compact colors always have room for whole vectors
+        float converted[4] = { };
+        convertColors(color.ColorSpace, color.Components, targetColorSpace, converted, 1, true);
+        std::copy(std::begin(converted), std::end(converted), color.Components);
+        color.ColorSpace = targetColorSpace;
+    }
+}
+
 PdfArray PdfColor::ToArray() const
 {
     PdfArray array;
@@ -1338,3 +1434,237 @@ double PdfColor::GetCieB() const
 
     return m_Color.lab[2];
 }
+
+unsigned getColorComponentCount(PdfColorSpace colorSpace)
+{
+    switch (colorSpace)
+    {
+        case PdfColorSpace::DeviceGray:
+            return 1;
+        case PdfColorSpace::DeviceRGB:
+        case PdfColorSpace::Lab:
+            return 3;
+        case PdfColorSpace::DeviceCMYK:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+// The colors are converted through RGB. CIE-Lab colors are relative
+// to D50 and are converted to sRGB, with the Bradford adaptation
+constexpr float LabWhitePoint[3] = { 0.9642f, 1.0f, 0.8249f };
+constexpr float LabToSRGB[3][3] = {
+    {  3.1338561f, -1.6168667f, -0.4906146f },
+    { -0.9787684f,  1.9161415f,  0.0334540f },
+    {  0.0719453f, -0.2289914f,  1.4052427f },
+};
+constexpr float LabEpsilon = 6.0f / 29.0f;
+
+void convertColors(PdfColorSpace colorSpace, const float* src,
+    PdfColorSpace targetColorSpace, float* dst, size_t count, bool padded)
+{
+    unsigned componentCount = getColorComponentCount(colorSpace);
+    unsigned targetComponentCount = getColorComponentCount(targetColorSpace);
+    if (colorSpace == targetColorSpace)
+    {
+        std::copy(src, src + count * componentCount, dst);
+        return;
+    }
+
+#ifdef PDFMM_COLOR_CONVERSION_SSE2
+    // Every color is handled in a vector. The whole vectors can be
+    // loaded and stored but for the last color, as the components
+    // past the ones of the color belong to the next one
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 grayWeights = _mm_setr_ps(0.299f, 0.587f, 0.114f, 0.0f);
+    for (size_t i = 0; i < count; i++, src += componentCount, dst += targetComponentCount)
+    {
+        bool whole = padded || i + 1 < count;
+        __m128 color;
+        if (componentCount == 1)
+            color = _mm_set1_ps(*src);
+        else if (whole || componentCount == 4)
+            color = _mm_loadu_ps(src);
+        else
+            color = _mm_setr_ps(src[0], src[1], src[2], 0.0f);
+
+        __m128 rgb;
+        switch (colorSpace)
+        {
+            case PdfColorSpace::DeviceCMYK:
+            {
+                __m128 black = _mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 3, 3, 3));
+                rgb = _mm_mul_ps(_mm_sub_ps(one, color), _mm_sub_ps(one, black));
+                break;
+            }
+            case PdfColorSpace::Lab:
+            {
+                // (fy, a / 500, -b / 200), then (fx, fy, fz)
+                __m128 scaled = _mm_add_ps(
+                    _mm_mul_ps(color, _mm_setr_ps(1.0f / 116.0f, 1.0f / 500.0f, -1.0f / 200.0f, 0.0f)),
+                    _mm_setr_ps(16.0f / 116.0f, 0.0f, 0.0f, 0.0f));
+                __m128 fy = _mm_shuffle_ps(scaled, scaled, _MM_SHUFFLE(0, 0, 0, 0));
+                __m128 offsets = _mm_shuffle_ps(scaled, scaled, _MM_SHUFFLE(3, 2, 3, 1));
+                __m128 f = _mm_add_ps(fy, offsets);
+                __m128 cube = _mm_mul_ps(_mm_mul_ps(f, f), f);
+                __m128 linear = _mm_mul_ps(_mm_sub_ps(f, _mm_set1_ps(4.0f / 29.0f)),
+                    _mm_set1_ps(3.0f * LabEpsilon * LabEpsilon));
+                __m128 mask = _mm_cmpgt_ps(f, _mm_set1_ps(LabEpsilon));
+                __m128 xyz = _mm_mul_ps(_mm_or_ps(_mm_and_ps(mask, cube), _mm_andnot_ps(mask, linear)),
+                    _mm_setr_ps(LabWhitePoint[0], LabWhitePoint[1], LabWhitePoint[2], 0.0f));
+
+                __m128 x = _mm_shuffle_ps(xyz, xyz, _MM_SHUFFLE(0, 0, 0, 0));
+                __m128 y = _mm_shuffle_ps(xyz, xyz, _MM_SHUFFLE(1, 1, 1, 1));
+                __m128 z = _mm_shuffle_ps(xyz, xyz, _MM_SHUFFLE(2, 2, 2, 2));
+                rgb = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(x, _mm_setr_ps(LabToSRGB[0][0], LabToSRGB[1][0], LabToSRGB[2][0], 0.0f)),
+                    _mm_mul_ps(y, _mm_setr_ps(LabToSRGB[0][1], LabToSRGB[1][1], LabToSRGB[2][1], 0.0f))),
+                    _mm_mul_ps(z, _mm_setr_ps(LabToSRGB[0][2], LabToSRGB[1][2], LabToSRGB[2][2], 0.0f)));
+                rgb = _mm_min_ps(_mm_max_ps(rgb, zero), one);
+
+                alignas(16) float components[4];
+                _mm_store_ps(components, rgb);
+                rgb = _mm_setr_ps(toSRGB(components[0]), toSRGB(components[1]), toSRGB(components[2]), 0.0f);
+                break;
+            }
+            default:
+            {
+                rgb = color;
+                break;
+            }
+        }
+
+        switch (targetColorSpace)
+        {
+            case PdfColorSpace::DeviceGray:
+            {
+                __m128 products = _mm_mul_ps(rgb, grayWeights);
+                products = _mm_add_ps(products, _mm_movehl_ps(products, products));
+                products = _mm_add_ss(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(1, 1, 1, 1)));
+                _mm_store_ss(dst, products);
+                break;
+            }
+            case PdfColorSpace::DeviceRGB:
+            {
+                if (whole)
+                {
+                    _mm_storeu_ps(dst, rgb);
+                }
+                else
+                {
+                    alignas(16) float components[4];
+                    _mm_store_ps(components, rgb);
+                    std::copy(components, components + 3, dst);
+                }
+                break;
+            }
+            default:
+            {
+                // Black is the complement of the maximum component, the
+                // other components are relative to the maximum
+                __m128 max = _mm_max_ps(rgb, _mm_shuffle_ps(rgb, rgb, _MM_SHUFFLE(0, 0, 2, 1)));
+                max = _mm_max_ps(max, _mm_shuffle_ps(rgb, rgb, _MM_SHUFFLE(1, 1, 0, 2)));
+                max = _mm_shuffle_ps(max, max, _MM_SHUFFLE(0, 0, 0, 0));
+                __m128 cmy = _mm_div_ps(_mm_sub_ps(max, rgb), max);
+                cmy = _mm_and_ps(cmy, _mm_cmpgt_ps(max, zero));
+                alignas(16) float components[4];
+                _mm_store_ps(components, cmy);
+                components[3] = 1.0f - _mm_cvtss_f32(max);
+                _mm_storeu_ps(dst, _mm_load_ps(components));
+                break;
+            }
+        }
+    }
+#else // PDFMM_COLOR_CONVERSION_SSE2
+    (void)padded;
+    for (size_t i = 0; i < count; i++, src += componentCount, dst += targetComponentCount)
+    {
+        float rgb[3];
+        switch (colorSpace)
+        {
+            case PdfColorSpace::DeviceGray:
+            {
+                std::fill(rgb, rgb + 3, *src);
+                break;
+            }
+            case PdfColorSpace::DeviceCMYK:
+            {
+                for (unsigned c = 0; c < 3; c++)
+                    rgb[c] = (1.0f - src[c]) * (1.0f - src[3]);
+                break;
+            }
+            case PdfColorSpace::Lab:
+            {
+                float fy = (src[0] + 16.0f) / 116.0f;
+                float f[3] = { fy + src[1] / 500.0f, fy, fy - src[2] / 200.0f };
+                float xyz[3];
+                for (unsigned c = 0; c < 3; c++)
+                {
+                    xyz[c] = LabWhitePoint[c] * (f[c] > LabEpsilon ? f[c] * f[c] * f[c]
+                        : 3.0f * LabEpsilon * LabEpsilon * (f[c] - 4.0f / 29.0f));
+                }
+                for (unsigned c = 0; c < 3; c++)
+                {
+                    float linear = LabToSRGB[c][0] * xyz[0] + LabToSRGB[c][1] * xyz[1] + LabToSRGB[c][2] * xyz[2];
+                    rgb[c] = toSRGB(std::clamp(linear, 0.0f, 1.0f));
+                }
+                break;
+            }
+            default:
+            {
+                std::copy(src, src + 3, rgb);
+                break;
+            }
+        }
+
+        switch (targetColorSpace)
+        {
+            case PdfColorSpace::DeviceGray:
+            {
+                *dst = 0.299f * rgb[0] + 0.587f * rgb[1] + 0.114f * rgb[2];
+                break;
+            }
+            case PdfColorSpace::DeviceRGB:
+            {
+                std::copy(rgb, rgb + 3, dst);
+                break;
+            }
+            default:
+            {
+                float max = std::max({ rgb[0], rgb[1], rgb[2] });
+                for (unsigned c = 0; c < 3; c++)
+                    dst[c] = max > 0.0f ? (max - rgb[c]) / max : 0.0f;
+                dst[3] = 1.0f - max;
+                break;
+            }
+        }
+    }
+#endif // PDFMM_COLOR_CONVERSION_SSE2
+}
+
+// The sRGB transfer function, interpolated in a table
+float toSRGB(float linear)
+{
+    constexpr unsigned TableSize = 4096;
+    static const auto table = []() {
+        vector<float> ret(TableSize + 1);
+        for (unsigned i = 0; i <= TableSize; i++)
+        {
+            double value = (double)i / TableSize;
+            ret[i] = (float)(value <= 0.0031308 ? value * 12.92
+                : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055);
+        }
+        return ret;
+    }();
+
+    // NOTE: The linear segment is too steep for the table
+    if (linear <= 0.0031308f)
+        return linear * 12.92f;
+
+    float position = linear * TableSize;
+    unsigned index = std::min((unsigned)position, TableSize - 1);
+    float fraction = position - index;
+    return table[index] + (table[index + 1] - table[index]) * fraction;
+}
@@ -18,6 +18,20 @@ namespace mm {
 class PdfObject;
 class PdfDocument;
 
+/** A compact color, without the separation name and the alternate
+ *  color space of PdfColor, to be used in hot loops
+ *
+ *  The components are the ones of PdfColor, in single precision:
+ *  gray, RGB and CMYK in the range 0.0 to 1.0, CIE-Lab L in the
+ *  range 0.0 to 100.0 and A and B in the range -128.0 to 127.0.
+ *  The unused components are ignored
+ */
+struct PdfCompactColor
+{
+    PdfColorSpace ColorSpace;
+    float Components[4];
+};
+
 /** A color object can represent either a grayscale
  *  value, a RGB color, a CMYK color, a separation color or
  *  a CieLab color.
@@ -318,6 +332,37 @@ public:
      */
     PdfColor ConvertToCMYK() const;
 
+    /** Get the compact representation of a gray, RGB, CMYK or CIE-Lab color
+     */
+    PdfCompactColor ToCompact() const;
+
+    /** Create a color object from its compact representation
+     */
+    static PdfColor FromCompact(const PdfCompactColor& color);
+
+    /** Convert colors stored as consecutive components in bulk
+     *
+     *  The conversions are the same of ConvertToGrayScale, ConvertToRGB and
+     *  ConvertToCMYK, with the same limits. CIE-Lab colors, relative to the
+     *  D50 white point, can be converted too, through sRGB
+     *
+     *  \param colorSpace the color space of the colors, DeviceGray,
+     *      DeviceRGB, DeviceCMYK or Lab
+     *  \param components the components of the colors
+     *  \param targetColorSpace DeviceGray, DeviceRGB or DeviceCMYK
+     *  \param converted receives the components of the converted
+     *      colors, it must be large enough for all the colors
+     */
+    static void ConvertColors(PdfColorSpace colorSpace, const cspan<float>& components,
+        PdfColorSpace targetColorSpace, const mspan<float>& converted);
+
+    /** Convert compact colors in place, in bulk
+     *
+     *  \param targetColorSpace DeviceGray, DeviceRGB or DeviceCMYK
+     *  \see ConvertColors
+     */
+    static void ConvertColors(const mspan<PdfCompactColor>& colors, PdfColorSpace targetColorSpace);
+
     /** Creates a PdfArray which represents a color from a color.
      *  \returns a PdfArray object
      */
@@ -0,0 +1,433 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfContentsOptimizer.h"
+
+#include "PdfPage.h"
+#include "PdfContentsReader.h"
+#include "PdfCanvasInputDevice.h"
+#include "PdfOperatorUtils.h"
+#include "PdfTokenizer.h"
+
+using namespace std;
+using namespace mm;
+
+static void writeReal(double value, string& str);
+
+PdfContentsOptimizer::PdfContentsOptimizer()
+    : m_buffer(nullptr), m_inTextObject(false), m_pathOpen(false) { }
+
+void PdfContentsOptimizer::Optimize(PdfPage& page)
+{
+    charbuff buffer;
+    Optimize(std::make_shared<PdfCanvasInputDevice>(page), buffer);
+
+    // Replace the contents, that may be an array of
+    // streams, with a single stream
+    auto& contents = page.GetOrCreateContents();
+    contents.Reset();
+    contents.GetStreamForAppending(PdfStreamAppendFlags::NoSaveRestorePrior).Set(buffer);
+}
+
+void PdfContentsOptimizer::Optimize(const shared_ptr<InputStreamDevice>& device, charbuff& buffer)
+{
+    buffer.clear();
+    m_buffer = &buffer;
+    invalidateState();
+    m_blocks.clear();
+    m_inTextObject = false;
+    m_pathOpen = false;
+
+    // NOTE: The reader is constructed on the device alone,
+    // so the XObject forms are reported as plain Do operators
+    PdfContentsReader reader(device);
+    PdfContent content;
+    while (reader.TryReadNext(content))
+    {
+        switch (content.Type)
+        {
+            case PdfContentType::Operator:
+            {
+                handleOperator(content);
+                break;
+            }
+            case PdfContentType::ImageDictionary:
+            {
+                markPainting();
+                m_operands.clear();
+                for (auto& pair : content.InlineImageDictionary)
+                {
+                    appendToken(m_operands, pair.first.GetEscapedName().insert(0, "/"));
+                    writeVariant(pair.second.GetVariant(), m_operands);
+                }
+
+                appendToken(m_operands, "ID");
+                m_operands.push_back(' ');
+                appendToken(*m_buffer, "BI");
+                m_buffer->append(m_operands);
+                break;
+            }
+            case PdfContentType::ImageData:
+            {
+                // The data includes the whitespace before EI, if any
+                m_buffer->append(content.InlineImageData);
+                if ((content.Warnings & PdfContentWarnings::MissingEndImage) == PdfContentWarnings::None)
+                    m_buffer->append("EI\n");
+                break;
+            }
+            case PdfContentType::UnexpectedKeyword:
+            {
+                // Custom operators or invalid content are kept
+                // as they are, and they make the state unknown
+                invalidateState();
+                markPainting();
+                writeOperands(content, m_operands);
+                writeOperator(content.Keyword, m_operands);
+                break;
+            }
+            default:
+            {
+                // Other contents are not reported when
+                // XObject forms are not followed
+                break;
+            }
+        }
+    }
+
+    m_buffer = nullptr;
+}
+
+void PdfContentsOptimizer::handleOperator(const PdfContent& content)
+{
+    writeOperands(content, m_operands);
+    auto op = GetPdfOperatorName(content.Operator);
+    if (content.Warnings != PdfContentWarnings::None)
+    {
+        // Operators with wrong operand count are kept as they
+        // are, just following the save/restore structure
+        invalidateState();
+        markPainting();
+        switch (content.Operator)
+        {
+            case PdfOperator::q:
+                m_blocks.push_back({ m_buffer->size(), m_state, true, m_inTextObject });
+                break;
+            case PdfOperator::Q:
+                if (m_blocks.size() != 0)
+                    m_blocks.pop_back();
+                markPainting();
+                break;
+            case PdfOperator::BT:
+                m_inTextObject = true;
+                break;
+            case PdfOperator::ET:
+                m_inTextObject = false;
+                break;
+            default:
+                break;
+        }
+
+        writeOperator(op, m_operands);
+        return;
+    }
+
+    switch (content.Operator)
+    {
+        case PdfOperator::w:
+        case PdfOperator::J:
+        case PdfOperator::j:
+        case PdfOperator::M:
+        case PdfOperator::d:
+        case PdfOperator::ri:
+        case PdfOperator::i:
+        {
+            // The state slots follow the order of the operators
+            using enum_type = std::underlying_type_t<PdfOperator>;
+            auto slot = (StateSlot)((enum_type)StateSlot::LineWidth
+                + (enum_type)content.Operator - (enum_type)PdfOperator::w);
+            if (!trySetState(slot, m_operands))
+                return;
+
+            break;
+        }
+        case PdfOperator::Tc:
+        case PdfOperator::Tw:
+        case PdfOperator::Tz:
+        case PdfOperator::TL:
+        case PdfOperator::Tf:
+        case PdfOperator::Tr:
+        case PdfOperator::Ts:
+        {
+            using enum_type = std::underlying_type_t<PdfOperator>;
+            auto slot = (StateSlot)((enum_type)StateSlot::CharSpacing
+                + (enum_type)content.Operator - (enum_type)PdfOperator::Tc);
+            if (!trySetState(slot, m_operands))
+                return;
+
+            break;
+        }
+        case PdfOperator::g:
+        case PdfOperator::rg:
+        case PdfOperator::k:
+        {
+            // The operator is part of the value, since
+            // it selects the color space as well
+            if (!trySetState(StateSlot::FillColor, (string)op + m_operands))
+                return;
+
+            break;
+        }
+        case PdfOperator::G:
+        case PdfOperator::RG:
+        case PdfOperator::K:
+        {
+            if (!trySetState(StateSlot::StrokeColor, (string)op + m_operands))
+                return;
+
+            break;
+        }
+        case PdfOperator::cs:
+        case PdfOperator::sc:
+        case PdfOperator::scn:
+        {
+            m_state[(size_t)StateSlot::FillColor] = { };
+            break;
+        }
+        case PdfOperator::CS:
+        case PdfOperator::SC:
+        case PdfOperator::SCN:
+        {
+            m_state[(size_t)StateSlot::StrokeColor] = { };
+            break;
+        }
+        case PdfOperator::gs:
+        {
+            // The graphics state parameter dictionary
+            // can set most of the parameters
+            invalidateState();
+            break;
+        }
+        case PdfOperator::q:
+        {
+            m_blocks.push_back({ m_buffer->size(), m_state, false, m_inTextObject });
+            break;
+        }
+        case PdfOperator::Q:
+        {
+            if (m_blocks.size() == 0)
+            {
+                // Unbalanced Q, keep it
+                invalidateState();
+                break;
+            }
+
+            auto block = std::move(m_blocks.back());
+            m_blocks.pop_back();
+            m_state = std::move(block.SavedState);
+            if (!block.Paints && block.InTextObject == m_inTextObject && !m_pathOpen)
+            {
+                // The block just changes the state, that is restored
+                m_buffer->resize(block.Offset);
+                return;
+            }
+
+            markPainting();
+            break;
+        }
+        case PdfOperator::cm:
+        {
+            if (m_operands == "1 0 0 1 0 0")
+                return;
+
+            break;
+        }
+        case PdfOperator::BT:
+        {
+            m_inTextObject = true;
+            break;
+        }
+        case PdfOperator::ET:
+        {
+            m_inTextObject = false;
+            break;
+        }
+        case PdfOperator::m:
+        case PdfOperator::l:
+        case PdfOperator::c:
+        case PdfOperator::v:
+        case PdfOperator::y:
+        case PdfOperator::h:
+        case PdfOperator::re:
+        {
+            m_pathOpen = true;
+            break;
+        }
+        case PdfOperator::n:
+        {
+            m_pathOpen = false;
+            break;
+        }
+        case PdfOperator::W:
+        case PdfOperator::W_Star:
+        case PdfOperator::Td:
+        case PdfOperator::TD:
+        case PdfOperator::Tm:
+        case PdfOperator::T_Star:
+        {
+            // Don't paint
+            break;
+        }
+        case PdfOperator::S:
+        case PdfOperator::s:
+        case PdfOperator::f:
+        case PdfOperator::F:
+        case PdfOperator::f_Star:
+        case PdfOperator::B:
+        case PdfOperator::B_Star:
+        case PdfOperator::b:
+        case PdfOperator::b_Star:
+        {
+            m_pathOpen = false;
+            markPainting();
+            break;
+        }
+        case PdfOperator::DoubleQuote:
+        {
+            // " sets the word and character spacing
+            m_state[(size_t)StateSlot::WordSpacing] = { };
+            m_state[(size_t)StateSlot::CharSpacing] = { };
+            markPainting();
+            break;
+        }
+        default:
+        {
+            // Text showing, XObjects, shadings, marked content,
+            // and the other operators are kept
+            markPainting();
+            break;
+        }
+    }
+
+    writeOperator(op, m_operands);
+}
+
+bool PdfContentsOptimizer::trySetState(StateSlot slot, const string& operands)
+{
+    auto& value = m_state[(size_t)slot];
+    if (value.has_value() && *value == operands)
+        return false;
+
+    value = operands;
+    return true;
+}
+
+void PdfContentsOptimizer::invalidateState()
+{
+    for (auto& value : m_state)
+        value = { };
+}
+
+void PdfContentsOptimizer::markPainting()
+{
+    if (m_blocks.size() != 0)
+        m_blocks.back().Paints = true;
+}
+
+void PdfContentsOptimizer::writeOperator(const string_view& op, const string& operands)
+{
+    m_buffer->append(operands);
+    appendToken(*m_buffer, op);
+    m_buffer->push_back('\n');
+}
+
+void PdfContentsOptimizer::writeOperands(const PdfContent& content, string& operands)
+{
+    operands.clear();
+    // Iterate the operands from the bottom of the stack
+    for (auto it = content.Stack.rbegin(); it != content.Stack.rend(); it++)
+        writeVariant(*it, operands);
+}
+
+void PdfContentsOptimizer::writeVariant(const PdfVariant& variant, string& str)
+{
+    // Numbers are written also in arrays and dictionaries,
+    // as in TJ or d operands and marked content properties
+    switch (variant.GetDataType())
+    {
+        case PdfDataType::Number:
+        {
+            m_token.clear();
+            utls::AppendNumberTo(m_token, variant.GetNumber());
+            break;
+        }
+        case PdfDataType::Real:
+        {
+            writeReal(variant.GetReal(), m_token);
+            break;
+        }
+        case PdfDataType::Array:
+        {
+            appendToken(str, "[");
+            for (auto& obj : variant.GetArray())
+                writeVariant(obj.GetVariant(), str);
+
+            appendToken(str, "]");
+            return;
+        }
+        case PdfDataType::Dictionary:
+        {
+            appendToken(str, "<<");
+            for (auto& pair : variant.GetDictionary())
+            {
+                appendToken(str, pair.first.GetEscapedName().insert(0, "/"));
+                writeVariant(pair.second.GetVariant(), str);
+            }
+
+            appendToken(str, ">>");
+            return;
+        }
+        default:
+        {
+            variant.ToString(m_token);
+            break;
+        }
+    }
+
+    appendToken(str, m_token);
+}
+
+void PdfContentsOptimizer::appendToken(string& str, const string_view& token)
+{
+    // Separate the tokens only when they would merge
+    if (str.size() != 0 && token.size() != 0
+        && PdfTokenizer::IsRegular(str.back()) && PdfTokenizer::IsRegular(token.front()))
+    {
+        str.push_back(' ');
+    }
+
+    str.append(token);
+}
+
+void writeReal(double value, string& str)
+{
+    utls::FormatTo(str, value, 6);
+    if (str == "-0")
+    {
+        str = "0";
+    }
+    else if (str.size() > 1 && str[0] == '0' && str[1] == '.')
+    {
+        // 0.5 -> .5
+        str.erase(0, 1);
+    }
+    else if (str.size() > 2 && str[0] == '-' && str[1] == '0' && str[2] == '.')
+    {
+        // -0.5 -> -.5
+        str.erase(1, 1);
+    }
+}
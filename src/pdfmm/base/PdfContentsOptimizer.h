@@ -0,0 +1,115 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_CONTENTS_OPTIMIZER_H
+#define PDF_CONTENTS_OPTIMIZER_H
+
+#include "PdfDeclarations.h"
+
+#include <array>
+
+namespace mm {
+
+class PdfPage;
+class PdfVariant;
+class InputStreamDevice;
+struct PdfContent;
+
+/**
+ * Rewrites content streams into smaller, semantically equivalent
+ * ones. The optimizer:
+ * - drops the graphics and text state operators, including the
+ *   device colors, that set the value already in effect;
+ * - drops the identity cm. Other cm are kept even if repeated,
+ *   since each one concatenates to the current matrix;
+ * - drops the q/Q blocks that don't paint anything;
+ * - writes numbers with at most 6 decimal digits and the least
+ *   whitespace, one operator per line.
+ *
+ * Unknown operators, operators ill formed and gs invalidate the
+ * tracked state, so the following state operators are kept
+ */
+class PDFMM_API PdfContentsOptimizer final
+{
+public:
+    PdfContentsOptimizer();
+
+    /** Optimize the contents of the page, replacing them with a single stream
+     */
+    void Optimize(PdfPage& page);
+
+    /** Optimize a content stream
+     * \param device the content stream source
+     * \param buffer the buffer receiving the optimized content stream
+     */
+    void Optimize(const std::shared_ptr<InputStreamDevice>& device, charbuff& buffer);
+
+private:
+    // The tracked state parameters
+    enum class StateSlot
+    {
+        LineWidth = 0,
+        LineCap,
+        LineJoin,
+        MiterLimit,
+        DashPattern,
+        RenderingIntent,
+        Flatness,
+        CharSpacing,
+        WordSpacing,
+        HorizontalScaling,
+        Leading,
+        Font,
+        TextRendering,
+        TextRise,
+        FillColor,
+        StrokeColor,
+        Count
+    };
+
+    // Operands of the operators setting the state parameters,
+    // as written. Not set if the value is unknown
+    using State = std::array<nullable<std::string>, (size_t)StateSlot::Count>;
+
+    struct Block
+    {
+        size_t Offset;      // Offset of the q operator in the output
+        State SavedState;
+        bool Paints;
+        bool InTextObject;
+    };
+
+    void handleOperator(const PdfContent& content);
+
+    // Returns false if the operator doesn't change the state
+    bool trySetState(StateSlot slot, const std::string& operands);
+
+    void invalidateState();
+
+    void markPainting();
+
+    void writeOperator(const std::string_view& op, const std::string& operands);
+
+    void writeOperands(const PdfContent& content, std::string& operands);
+
+    void writeVariant(const PdfVariant& variant, std::string& str);
+
+    static void appendToken(std::string& str, const std::string_view& token);
+
+private:
+    charbuff* m_buffer;
+    State m_state;
+    std::vector<Block> m_blocks;
+    bool m_inTextObject;
+    bool m_pathOpen;
+    std::string m_operands;
+    std::string m_token;
+};
+
+};
+
+#endif // PDF_CONTENTS_OPTIMIZER_H
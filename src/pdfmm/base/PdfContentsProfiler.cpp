@@ -0,0 +1,261 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include <pdfmm/private/PdfTracePrivate.h>
+#include "PdfContentsProfiler.h"
+
+#include <unordered_set>
+
+#include "PdfDocument.h"
+#include "PdfPage.h"
+#include "PdfPageCollection.h"
+#include "PdfContentsReader.h"
+#include "PdfStreamDevice.h"
+#include "PdfXObjectForm.h"
+
+using namespace std;
+using namespace mm;
+
+static constexpr size_t OperatorCount = (size_t)PdfOperator::EX + 1;
+
+static const PdfObject* getXObject(const PdfCanvas& canvas, const PdfVariantStack& stack, PdfXObjectType& type);
+
+PdfContentsProfiler::PdfContentsProfiler() { }
+
+PdfContentsProfile PdfContentsProfiler::Profile(const PdfCanvas& canvas)
+{
+    PdfContentsProfile ret;
+    profile(canvas, dynamic_cast<const PdfXObjectForm*>(&canvas) != nullptr, ret, nullptr);
+    return ret;
+}
+
+PdfDocumentContentsProfile PdfContentsProfiler::Profile(const PdfDocument& doc)
+{
+    PdfDocumentContentsProfile ret;
+    auto& pages = doc.GetPages();
+    vector<PdfReference> forms;
+    vector<PdfReference> drawn;
+    unordered_set<PdfReference> visited;
+    auto addForms = [&]()
+    {
+        for (auto& ref : drawn)
+        {
+            if (visited.insert(ref).second)
+                forms.push_back(ref);
+        }
+
+        drawn.clear();
+    };
+
+    ret.Pages.resize(pages.GetCount());
+    for (unsigned i = 0; i < pages.GetCount(); i++)
+    {
+        profile(pages.GetPage(i), false, ret.Pages[i], &drawn);
+        addForms();
+    }
+
+    // Profile the forms drawn by the pages and by the
+    // other forms. The list grows while they are profiled
+    for (size_t i = 0; i < forms.size(); i++)
+    {
+        unique_ptr<PdfXObjectForm> form;
+        auto obj = doc.GetObjects().GetObject(forms[i]);
+        if (obj == nullptr || !PdfXObject::TryCreateFromObject(*obj, form))
+            continue;
+
+        ret.Forms.emplace_back();
+        profile(*form, true, ret.Forms.back(), &drawn);
+        addForms();
+    }
+
+    return ret;
+}
+
+void PdfContentsProfiler::profile(const PdfCanvas& canvas, bool isForm, PdfContentsProfile& profile,
+    vector<PdfReference>* forms)
+{
+    auto& element = canvas.GetElement();
+    PDFMM_TRACE_SCOPE(trace, ContentsProfile, &element.GetDocument());
+    auto start = chrono::steady_clock::now();
+    profile.Reference = element.GetObject().GetIndirectReference();
+    profile.IsForm = isForm;
+    profile.OperatorCounts.assign(OperatorCount, 0);
+
+    // Decode every stream once, measuring it, and read them together,
+    // since the operators may span the streams
+    m_buffer.clear();
+    auto contents = canvas.GetContentsObject();
+    if (contents != nullptr)
+    {
+        auto addStream = [&](const PdfObject& obj)
+        {
+            auto stream = obj.GetStream();
+            if (stream == nullptr)
+                return;
+
+            stream->ExtractTo(m_streamBuffer);
+            profile.StreamLengths.push_back(m_streamBuffer.size());
+            m_buffer.append(m_streamBuffer);
+            m_buffer.push_back('\n');
+        };
+
+        if (contents->IsArray())
+        {
+            auto& arr = contents->GetArray();
+            for (unsigned i = 0; i < arr.GetSize(); i++)
+                addStream(arr.FindAt(i));
+        }
+        else
+        {
+            addStream(*contents);
+        }
+    }
+
+    PdfContentsReader reader(std::make_shared<SpanStreamDevice>(m_buffer));
+    PdfContent content;
+    unsigned depth = 0;
+    unsigned operatorCount = 0;
+    while (reader.TryReadNext(content))
+    {
+        if (content.Warnings != PdfContentWarnings::None)
+            profile.WarningCount++;
+
+        switch (content.Type)
+        {
+            case PdfContentType::Operator:
+            {
+                operatorCount++;
+                profile.OperatorCounts[(size_t)content.Operator]++;
+                switch (content.Operator)
+                {
+                    case PdfOperator::q:
+                    {
+                        depth++;
+                        profile.MaxNestingDepth = std::max(profile.MaxNestingDepth, depth);
+                        break;
+                    }
+                    case PdfOperator::Q:
+                    {
+                        if (depth != 0)
+                            depth--;
+                        break;
+                    }
+                    case PdfOperator::l:
+                    case PdfOperator::c:
+                    case PdfOperator::v:
+                    case PdfOperator::y:
+                    case PdfOperator::h:
+                    {
+                        profile.PathSegmentCount++;
+                        break;
+                    }
+                    case PdfOperator::re:
+                    {
+                        profile.PathSegmentCount += 4;
+                        break;
+                    }
+                    case PdfOperator::Tj:
+                    case PdfOperator::TJ:
+                    case PdfOperator::Quote:
+                    case PdfOperator::DoubleQuote:
+                    {
+                        profile.TextShowCount++;
+                        break;
+                    }
+                    case PdfOperator::Do:
+                    {
+                        PdfXObjectType type;
+                        auto xobj = getXObject(canvas, content.Stack, type);
+                        if (xobj == nullptr)
+                            break;
+
+                        if (type == PdfXObjectType::Image)
+                        {
+                            profile.ImageCount++;
+                        }
+                        else if (type == PdfXObjectType::Form)
+                        {
+                            profile.FormCount++;
+                            if (forms != nullptr && xobj->IsIndirect())
+                                forms->push_back(xobj->GetIndirectReference());
+                        }
+                        break;
+                    }
+                    default:
+                    {
+                        // Just count the other operators
+                        break;
+                    }
+                }
+                break;
+            }
+            case PdfContentType::ImageDictionary:
+            {
+                operatorCount++;
+                profile.ImageCount++;
+                profile.InlineImageCount++;
+                break;
+            }
+            case PdfContentType::UnexpectedKeyword:
+            {
+                operatorCount++;
+                profile.OperatorCounts[(size_t)PdfOperator::Unknown]++;
+                break;
+            }
+            default:
+            {
+                // The XObject forms are not followed
+                break;
+            }
+        }
+    }
+
+    profile.Duration = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+    PDFMM_TRACE_SET(trace, Reference, profile.Reference);
+    PDFMM_TRACE_SET(trace, InputLength, profile.GetContentsLength());
+    PDFMM_TRACE_SET(trace, OutputLength, operatorCount);
+    PDFMM_TRACE_SET(trace, Name, isForm ? "form"sv : "page"sv);
+}
+
+unsigned PdfContentsProfile::GetOperatorCount(PdfOperator op) const
+{
+    if ((size_t)op >= OperatorCounts.size())
+        return 0;
+
+    return OperatorCounts[(size_t)op];
+}
+
+size_t PdfContentsProfile::GetContentsLength() const
+{
+    size_t ret = 0;
+    for (size_t length : StreamLengths)
+        ret += length;
+
+    return ret;
+}
+
+// Get the XObject drawn by a Do operator, and its type
+const PdfObject* getXObject(const PdfCanvas& canvas, const PdfVariantStack& stack, PdfXObjectType& type)
+{
+    const PdfName* name;
+    const PdfObject* xobj;
+    const PdfObject* subtypeObj;
+    const PdfName* subtype;
+    if (stack.GetSize() != 1
+        || !stack[0].TryGetName(name)
+        || (xobj = canvas.GetFromResources("XObject", *name)) == nullptr
+        || !xobj->IsDictionary()
+        || (subtypeObj = xobj->GetDictionary().FindKey("Subtype")) == nullptr
+        || !subtypeObj->TryGetName(subtype))
+    {
+        return nullptr;
+    }
+
+    type = PdfXObject::FromString(subtype->GetString());
+    return xobj;
+}
@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_CONTENTS_PROFILER_H
+#define PDF_CONTENTS_PROFILER_H
+
+#include "PdfDeclarations.h"
+
+#include <chrono>
+
+#include "PdfReference.h"
+
+namespace mm {
+
+class PdfCanvas;
+class PdfDocument;
+
+/** The operators and the resources used by the contents of a page or
+ * of a XObject form, as measured by PdfContentsProfiler
+ */
+struct PDFMM_API PdfContentsProfile
+{
+    PdfReference Reference;                 ///< The page or the XObject form
+    bool IsForm = false;
+    std::vector<size_t> StreamLengths;      ///< The decoded length of every content stream
+    std::vector<unsigned> OperatorCounts;   ///< The count of every operator, indexed by PdfOperator. Unknown counts the unexpected keywords
+    unsigned PathSegmentCount = 0;          ///< The segments of the paths. A re operator counts 4 segments
+    unsigned TextShowCount = 0;             ///< The Tj, TJ, ' and " operators
+    unsigned ImageCount = 0;                ///< The image XObjects and the inline images drawn
+    unsigned InlineImageCount = 0;
+    unsigned FormCount = 0;                 ///< The XObject forms drawn
+    unsigned MaxNestingDepth = 0;           ///< The maximum depth of the q/Q blocks
+    unsigned WarningCount = 0;              ///< The contents read with warnings, like operators with wrong operands
+    std::chrono::nanoseconds Duration { };  ///< The time spent decoding and reading the contents
+
+    /** \returns the count of the given operator
+     */
+    unsigned GetOperatorCount(PdfOperator op) const;
+
+    /** \returns the decoded length of all the content streams
+     */
+    size_t GetContentsLength() const;
+};
+
+/** The profiles of the contents of a document
+ */
+struct PDFMM_API PdfDocumentContentsProfile
+{
+    std::vector<PdfContentsProfile> Pages;
+    std::vector<PdfContentsProfile> Forms;  ///< Every XObject form drawn, once, in the order it's first drawn
+};
+
+/**
+ * Measure the operators and the resources used by content streams,
+ * to find out the contents that are slow to render.
+ *
+ * The XObject forms are not followed, but they are profiled on their
+ * own. When tracing is supported, a PdfTraceEventType::ContentsProfile
+ * event is delivered for every page and form profiled, so the
+ * pathological contents can be flagged by a sink during ingestion
+ */
+class PDFMM_API PdfContentsProfiler final
+{
+public:
+    PdfContentsProfiler();
+
+    /** Profile the contents of a page or of a XObject form
+     */
+    PdfContentsProfile Profile(const PdfCanvas& canvas);
+
+    /** Profile the contents of all the pages of a document,
+     *  and of the XObject forms they draw
+     */
+    PdfDocumentContentsProfile Profile(const PdfDocument& doc);
+
+private:
+    void profile(const PdfCanvas& canvas, bool isForm, PdfContentsProfile& profile,
+        std::vector<PdfReference>* forms);
+
+private:
+    charbuff m_buffer;
+    charbuff m_streamBuffer;
+};
+
+};
+
+#endif // PDF_CONTENTS_PROFILER_H
@@ -10,6 +10,108 @@
 using namespace std;
 using namespace mm;
 
+// The parameters of an inline image determining the length of its data
+struct InlineImageParams
+{
+    int64_t Length = -1;
+    int64_t Width = -1;
+    int64_t Height = -1;
+    int64_t BitsPerComponent = -1;
+    int ComponentCount = -1;
+    bool ImageMask = false;
+    bool HasFilter = false;
+};
+
+// The size of the chunks the inline image data is read in, when its
+// length is known but the device data can't be viewed in memory
+static constexpr size_t InlineImgChunkSize = 4096;
+
+// A device reading the data that was read past the end of an
+// inline image, before the data of the device it was read from
+class PdfPushbackInputDevice final : public InputStreamDevice
+{
+public:
+    PdfPushbackInputDevice(const shared_ptr<InputStreamDevice>& device)
+        : m_device(device), m_position(0) { }
+
+    /** Push back data to be read before the remaining one
+     */
+    void PushBack(const bufferview& data)
+    {
+        m_data.erase(m_data.begin(), m_data.begin() + m_position);
+        m_data.insert(m_data.begin(), data.begin(), data.end());
+        m_position = 0;
+    }
+
+    size_t GetLength() const override
+    {
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NotImplemented, "Unsupported");
+    }
+
+    size_t GetPosition() const override
+    {
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NotImplemented, "Unsupported");
+    }
+
+    bool Eof() const override
+    {
+        return m_position == m_data.size() && m_device->Eof();
+    }
+
+protected:
+    size_t readBuffer(char* buffer, size_t size, bool& eof) override
+    {
+        size_t count = std::min(size, m_data.size() - m_position);
+        std::memcpy(buffer, m_data.data() + m_position, count);
+        m_position += count;
+        if (count < size)
+            count += m_device->Read(buffer + count, size - count, eof);
+
+        eof = Eof();
+        return count;
+    }
+
+    bool readChar(char& ch) override
+    {
+        if (m_position == m_data.size())
+            return m_device->Read(ch);
+
+        ch = m_data[m_position];
+        m_position++;
+        return true;
+    }
+
+    bool peek(char& ch) const override
+    {
+        if (m_position == m_data.size())
+            return m_device->Peek(ch);
+
+        ch = m_data[m_position];
+        return true;
+    }
+
+    bool tryPeek(bufferview& view) const override
+    {
+        if (m_position == m_data.size())
+            return m_device->TryPeek(view);
+
+        view = bufferview(m_data.data() + m_position, m_data.size() - m_position);
+        return true;
+    }
+
+private:
+    shared_ptr<InputStreamDevice> m_device;
+    charbuff m_data;
+    size_t m_position;
+};
+
+static void pushBackInlineImgData(shared_ptr<InputStreamDevice>& device, const bufferview& data);
+static nullable<size_t> getInlineImgLength(const PdfDictionary& dict);
+static nullable<size_t> getInlineImgLength(const vector<PdfRawOperand>& operands);
+static nullable<size_t> getInlineImgLength(const InlineImageParams& params);
+static int getColorSpaceComponentCount(const string_view& name);
+static const char* findEndImage(const char* begin, const char* end);
+
 PdfContentsReader::PdfContentsReader(const PdfCanvas& canvas,
         nullable<const PdfContentReaderArgs&> args) :
     PdfContentsReader(std::make_shared<PdfCanvasInputDevice>(canvas),
@@ -30,25 +132,44 @@ PdfContentsReader::PdfContentsReader(const shared_ptr<InputStreamDevice>& device
     if (device == nullptr)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Device must be non null");
 
-    m_inputs.push_back({ nullptr, device, canvas });
+    m_inputs.push_back({ nullptr, device, canvas, nullptr });
+
+    // Replay the compiled contents of the canvas, if any
+    if (canvas != nullptr && m_args.Cache != nullptr && m_args.InlineImageHandler == nullptr)
+    {
+        auto& ref = PdfContentsCache::getReference(*canvas);
+        if (ref.IsIndirect())
+            m_inputs.back().CachedForm = m_args.Cache->find(ref);
+    }
 }
 
 bool PdfContentsReader::TryReadNext(PdfContent& content)
 {
     beforeReadReset(content);
+    bool hasTrailingOperands;
 
     while (true)
     {
         if (m_inputs.size() == 0)
             goto Eof;
 
+        if (m_inputs.back().CachedForm != nullptr)
+        {
+            if (!tryReadCachedContent(content))
+                goto PopDevice;
+
+            goto HandleContent;
+        }
+
         if (m_readingInlineImgData)
         {
             if (m_args.InlineImageHandler == nullptr)
             {
-                if (!tryReadInlineImgData(content.InlineImageData))
+                bufferview data;
+                if (!tryReadInlineImgData(data))
                     goto PopDevice;
 
+                content.InlineImageData = data;
                 content.Type = PdfContentType::ImageData;
                 m_readingInlineImgData = false;
                 afterReadClear(content);
@@ -86,6 +207,8 @@ bool PdfContentsReader::TryReadNext(PdfContent& content)
 
     PopDevice:
         PDFMM_INVARIANT(m_inputs.size() != 0);
+        hasTrailingOperands = content.Stack.GetSize() != 0
+            || (m_inputs.back().CachedForm != nullptr && m_inputs.back().CachedForm->HasTrailingOperands);
         m_inputs.pop_back();
         if (m_inputs.size() == 0)
             goto Eof;
@@ -93,7 +216,7 @@ bool PdfContentsReader::TryReadNext(PdfContent& content)
         // Unless the device stack is empty, popping a devices
         // means that we finished processing an XObject form
         content.Type = PdfContentType::EndXObjectForm;
-        if (content.Stack.GetSize() != 0)
+        if (hasTrailingOperands)
             content.Warnings |= PdfContentWarnings::SpuriousStackContent;
 
         goto HandleContent;
@@ -105,6 +228,166 @@ bool PdfContentsReader::TryReadNext(PdfContent& content)
     }
 }
 
+bool PdfContentsReader::TryReadNextRaw(PdfRawContent& content)
+{
+    content.Warnings = PdfContentWarnings::None;
+    content.Operator = PdfOperator::Unknown;
+    content.Keyword = { };
+    content.InlineImageData = { };
+    m_rawOperands.clear();
+    m_rawBuffer.clear();
+
+    bool success;
+    if (m_inputs.size() == 0)
+    {
+        success = false;
+    }
+    else if (m_readingInlineImgData)
+    {
+        m_readingInlineImgData = false;
+        success = tryReadInlineImgData(content.InlineImageData);
+        content.Type = PdfContentType::ImageData;
+    }
+    else
+    {
+        success = false;
+        unsigned depth = 0;
+        unsigned operandCount = 0;
+        PdfRawOperand operand;
+        while (tryReadNextRawOperand(content, operand))
+        {
+            if (m_temp.PsType == PdfPostScriptTokenType::Variant)
+            {
+                // Count the operands at the top level only
+                switch (operand.Type)
+                {
+                    case PdfRawOperandType::ArrayBegin:
+                    case PdfRawOperandType::DictionaryBegin:
+                        if (depth == 0)
+                            operandCount++;
+                        depth++;
+                        break;
+                    case PdfRawOperandType::ArrayEnd:
+                    case PdfRawOperandType::DictionaryEnd:
+                        if (depth != 0)
+                            depth--;
+                        break;
+                    default:
+                        if (depth == 0)
+                            operandCount++;
+                        break;
+                }
+
+                m_rawOperands.push_back(operand);
+                continue;
+            }
+
+            success = true;
+            if (m_temp.PsType != PdfPostScriptTokenType::Keyword
+                || !TryGetPdfOperator(content.Keyword, content.Operator))
+            {
+                content.Type = PdfContentType::UnexpectedKeyword;
+                break;
+            }
+
+            content.Type = PdfContentType::Operator;
+            int expectedCount = mm::GetOperandCount(content.Operator);
+            if (expectedCount != -1 && operandCount != (unsigned)expectedCount)
+            {
+                if (operandCount < (unsigned)expectedCount)
+                    content.Warnings |= PdfContentWarnings::InvalidOperator;
+                else // operandCount > expectedCount
+                    content.Warnings |= PdfContentWarnings::SpuriousStackContent;
+            }
+
+            if (content.Operator == PdfOperator::BI)
+            {
+                success = tryReadRawInlineImgDict(content);
+                content.Type = PdfContentType::ImageDictionary;
+                m_readingInlineImgData = true;
+            }
+
+            break;
+        }
+    }
+
+    if (!success)
+    {
+        m_inputs.clear();
+        m_rawOperands.clear();
+        content.Type = PdfContentType::Unknown;
+        content.Operator = PdfOperator::Unknown;
+        content.Keyword = { };
+        content.Operands = { };
+        return false;
+    }
+
+    content.Operands = cspan<PdfRawOperand>(m_rawOperands.data(), m_rawOperands.size());
+    if (content.Warnings != PdfContentWarnings::None)
+        handleWarnings();
+
+    return true;
+}
+
+// Returns false in case of EOF
+bool PdfContentsReader::tryReadNextRawOperand(PdfRawContent& content, PdfRawOperand& operand)
+{
+    const char* prevData = m_rawBuffer.data();
+    if (!m_tokenizer.TryReadNextRaw(*m_inputs.back().Device, m_temp.PsType, content.Keyword, operand, m_rawBuffer))
+        return false;
+
+    if (m_rawBuffer.data() != prevData)
+    {
+        // The decoded data buffer grew, make the
+        // views of the previous operands point to it
+        for (auto& prevOperand : m_rawOperands)
+        {
+            if (prevOperand.Data.size() != 0)
+                prevOperand.Data = string_view(m_rawBuffer.data() + (prevOperand.Data.data() - prevData), prevOperand.Data.size());
+        }
+    }
+
+    return true;
+}
+
+// Returns false in case of EOF
+bool PdfContentsReader::tryReadRawInlineImgDict(PdfRawContent& content)
+{
+    PdfRawOperand operand;
+    while (true)
+    {
+        if (!tryReadNextRawOperand(content, operand))
+            return false;
+
+        switch (m_temp.PsType)
+        {
+            case PdfPostScriptTokenType::Keyword:
+            {
+                // Try to find end of dictionary
+                if (content.Keyword == "ID")
+                {
+                    content.Keyword = "BI";
+                    m_inlineImgLength = getInlineImgLength(m_rawOperands);
+                    return true;
+                }
+
+                content.Warnings |= PdfContentWarnings::InvalidImageDictionaryContent;
+                continue;
+            }
+            case PdfPostScriptTokenType::Variant:
+            {
+                m_rawOperands.push_back(operand);
+                continue;
+            }
+            default:
+            {
+                content.Warnings |= PdfContentWarnings::InvalidImageDictionaryContent;
+                continue;
+            }
+        }
+    }
+}
+
 // Returns false in case of EOF
 bool PdfContentsReader::tryReadNextContent(PdfContent& content)
 {
@@ -282,7 +565,10 @@ bool PdfContentsReader::tryReadInlineImgDict(PdfContent& content)
             {
                 // Try to find end of dictionary
                 if (m_temp.Keyword == "ID")
+                {
+                    m_inlineImgLength = getInlineImgLength(content.InlineImageDictionary);
                     return true;
+                }
 
                 content.Warnings |= PdfContentWarnings::InvalidImageDictionaryContent;
                 continue;
@@ -328,8 +614,12 @@ void PdfContentsReader::tryFollowXObject(PdfContent& content)
 
     content.XObject.reset(xobj.release());
     content.Type = PdfContentType::DoXObject;
+    followXObject(content, *xobjraw);
+}
 
-    if (isCalledRecursively(xobjraw))
+void PdfContentsReader::followXObject(PdfContent& content, const PdfObject& xobjraw)
+{
+    if (isCalledRecursively(&xobjraw))
     {
         content.Warnings |= PdfContentWarnings::RecursiveXObject;
         return;
@@ -338,21 +628,138 @@ void PdfContentsReader::tryFollowXObject(PdfContent& content)
     if (content.XObject->GetType() == PdfXObjectType::Form
         && (m_args.Flags & PdfContentReaderFlags::DontFollowXObjectForms) == PdfContentReaderFlags::None)
     {
-        m_inputs.push_back({
-            content.XObject,
-            std::make_shared<PdfCanvasInputDevice>(static_cast<const PdfXObjectForm&>(*content.XObject)),
-            dynamic_cast<const PdfCanvas*>(content.XObject.get()) });
+        auto& form = static_cast<const PdfXObjectForm&>(*content.XObject);
+        if (m_args.Cache != nullptr && m_args.InlineImageHandler == nullptr && xobjraw.IsIndirect())
+        {
+            m_inputs.push_back({
+                content.XObject,
+                nullptr,
+                dynamic_cast<const PdfCanvas*>(content.XObject.get()),
+                getCachedForm(xobjraw, form) });
+        }
+        else
+        {
+            m_inputs.push_back({
+                content.XObject,
+                std::make_shared<PdfCanvasInputDevice>(form),
+                dynamic_cast<const PdfCanvas*>(content.XObject.get()),
+                nullptr });
+        }
     }
 }
 
+// Returns false at the end of the cached form
+bool PdfContentsReader::tryReadCachedContent(PdfContent& content)
+{
+    auto& input = m_inputs.back();
+    if (input.CachedIndex == input.CachedForm->Entries.size())
+        return false;
+
+    auto& entry = input.CachedForm->Entries[input.CachedIndex];
+    input.CachedIndex++;
+    content.Type = entry.Type;
+    content.Warnings |= entry.Warnings;
+    content.Operator = entry.Operator;
+    content.Keyword = entry.Keyword;
+    content.Stack = entry.Stack;
+    switch (entry.Type)
+    {
+        case PdfContentType::ImageDictionary:
+            content.InlineImageDictionary = entry.InlineImageDictionary;
+            break;
+        case PdfContentType::ImageData:
+            content.InlineImageData = entry.InlineImageData;
+            break;
+        case PdfContentType::Operator:
+        {
+            if (entry.Operator != PdfOperator::Do)
+                break;
+
+            // Nested forms are followed while replaying, eventually
+            // from the cache as well. The XObject was resolved when
+            // compiling the contents
+            if (entry.XObject == nullptr)
+            {
+                content.Warnings |= PdfContentWarnings::InvalidXObject;
+                break;
+            }
+
+            (void)content.Stack[0].TryGetName(content.Name);
+            content.XObject = entry.XObject;
+            content.Type = PdfContentType::DoXObject;
+            followXObject(content, *entry.XObjectObject);
+            break;
+        }
+        default:
+            break;
+    }
+
+    return true;
+}
+
+PdfContentsCache::FormPtr PdfContentsReader::getCachedForm(const PdfObject& xobj, const PdfXObjectForm& form)
+{
+    auto ref = xobj.GetIndirectReference();
+    auto cached = m_args.Cache->find(ref);
+    if (cached != nullptr)
+        return cached;
+
+    // NOTE: Another reader may have cached the form in the meantime
+    return m_args.Cache->insert(ref, PdfContentsCache::compile(form));
+}
+
 // Returns false in case of EOF
-bool PdfContentsReader::tryReadInlineImgData(charbuff& data)
+bool PdfContentsReader::tryReadInlineImgData(bufferview& data)
 {
+    auto& device = *m_inputs.back().Device;
+    auto length = m_inlineImgLength;
+    m_inlineImgLength = nullptr;
+
     // Consume one whitespace between ID and data
     char ch;
-    if (!m_inputs.back().Device->Read(ch))
+    if (!device.Read(ch))
         return false;
 
+    // NOTE: The end of the data is found by searching for "EI"
+    // followed by a whitespace, that is still wrong since the
+    // Pdf specification is broken with this regard. The dictionary
+    // should have a /Length key with the length of the data, and
+    // it's a requirement in Pdf 2.0 specification (ISO 32000-2).
+    // When the length is known, either from /Length or from the
+    // size of unfiltered images, the search starts after the data
+    bufferview view;
+    if (device.TryGetView(view))
+    {
+        // Fast path, the data is viewed directly in the device
+        const char* begin = view.data() + device.GetPosition();
+        const char* end = view.data() + view.size();
+        const char* endImage = nullptr;
+        if (length.has_value() && *length <= (size_t)(end - begin))
+        {
+            // Check that the end image operator follows,
+            // or fall back searching from the beginning
+            const char* it = begin + *length;
+            while (it != end && PdfTokenizer::IsWhitespace(*it))
+                it++;
+
+            if (findEndImage(it, std::min(it + 3, end)) == it)
+                endImage = it;
+        }
+
+        if (endImage == nullptr)
+            endImage = findEndImage(begin, end);
+
+        if (endImage == nullptr)
+        {
+            device.Seek(view.size());
+            return false;
+        }
+
+        data = bufferview(begin, endImage - begin);
+        device.Seek((size_t)(endImage + 3 - view.data()));
+        return true;
+    }
+
     // Read "EI"
     enum class ReadEIStatus
     {
@@ -361,16 +768,76 @@ bool PdfContentsReader::tryReadInlineImgData(charbuff& data)
         ReadWhiteSpace
     };
 
-    // NOTE: This is a better version of the previous approach
-    // and still is wrong since the Pdf specification is broken
-    // with this regard. The dictionary should have a /Length
-    // key with the length of the data, and it's a requirement
-    // in Pdf 2.0 specification (ISO 32000-2). To handle better
-    // the situation the only approach would be to use more
-    // comprehensive heuristic, similarly to what pdf.js does
     ReadEIStatus status = ReadEIStatus::ReadE;
-    unsigned readCount = 0;
-    while (m_inputs.back().Device->Read(ch))
+    size_t readCount = 0;
+    auto readChar = [&]() -> bool
+    {
+        if (!device.Read(ch))
+            return false;
+
+        if (m_buffer->size() == readCount)
+            m_buffer->resize(m_buffer->size() * 2);
+
+        m_buffer->data()[readCount] = ch;
+        readCount++;
+        return true;
+    };
+
+    if (length.has_value() && *length != 0)
+    {
+        // Read the data in bounded chunks, so the buffer grows only
+        // with the data actually available in the device
+        bool eof = false;
+        while (readCount < *length && !eof)
+        {
+            size_t chunkSize = std::min(*length - readCount, InlineImgChunkSize);
+            if (m_buffer->size() < readCount + chunkSize)
+                m_buffer->resize(std::max(readCount + chunkSize, m_buffer->size() * 2));
+
+            size_t read = device.Read(m_buffer->data() + readCount, chunkSize, eof);
+            if (read == 0)
+                break;
+
+            readCount += read;
+        }
+
+        // The device can't be rewound: check that the end image operator
+        // follows the data, reading it, or fall back searching from the
+        // beginning of the data read so far
+        if (readCount == *length)
+        {
+            bool hasChar;
+            while ((hasChar = readChar()) && PdfTokenizer::IsWhitespace(ch));
+
+            size_t endImage = readCount - 1;
+            if (hasChar && ch == 'E' && readChar() && ch == 'I' && readChar()
+                && PdfTokenizer::IsWhitespace(ch))
+            {
+                data = bufferview(m_buffer->data(), endImage);
+                return true;
+            }
+        }
+
+        auto endImage = findEndImage(m_buffer->data(), m_buffer->data() + readCount);
+        if (endImage != nullptr)
+        {
+            // The data after the end image operator was read in
+            // excess, and it is read again by the next operations
+            size_t dataLength = (size_t)(endImage - m_buffer->data());
+            pushBackInlineImgData(m_inputs.back().Device, bufferview(endImage + 3, readCount - dataLength - 3));
+            data = bufferview(m_buffer->data(), dataLength);
+            return true;
+        }
+
+        // Continue searching "EI", tolerating its first
+        // characters read as data
+        if (readCount >= 2 && m_buffer->data()[readCount - 2] == 'E' && m_buffer->data()[readCount - 1] == 'I')
+            status = ReadEIStatus::ReadWhiteSpace;
+        else if (readCount >= 1 && m_buffer->data()[readCount - 1] == 'E')
+            status = ReadEIStatus::ReadI;
+    }
+
+    while (device.Read(ch))
     {
         switch (status)
         {
@@ -385,7 +852,7 @@ bool PdfContentsReader::tryReadInlineImgData(charbuff& data)
             {
                 if (ch == 'I')
                     status = ReadEIStatus::ReadWhiteSpace;
-                else
+                else if (ch != 'E')
                     status = ReadEIStatus::ReadE;
 
                 break;
@@ -397,6 +864,8 @@ bool PdfContentsReader::tryReadInlineImgData(charbuff& data)
                     data = bufferview(m_buffer->data(), readCount - 2);
                     return true;
                 }
+                else if (ch == 'E')
+                    status = ReadEIStatus::ReadI;
                 else
                     status = ReadEIStatus::ReadE;
 
@@ -434,3 +903,322 @@ bool PdfContentsReader::isCalledRecursively(const PdfObject* xobj)
 
     return false;
 }
+
+PdfContentsCache::PdfContentsCache() { }
+
+void PdfContentsCache::Compile(const PdfCanvas& canvas)
+{
+    auto& ref = getReference(canvas);
+    if (!ref.IsIndirect())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The canvas must be an indirect object");
+
+    auto form = compile(canvas);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_forms[ref] = form;
+}
+
+void PdfContentsCache::Remove(const PdfCanvas& canvas)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_forms.erase(getReference(canvas));
+}
+
+PdfContentsCache::FormPtr PdfContentsCache::compile(const PdfCanvas& canvas)
+{
+    // Tokenize the contents without following the XObjects, which
+    // are resolved with the resources of the canvas and followed
+    // while replaying. Warnings are recorded and handled while replaying
+    auto compiled = std::make_shared<Form>();
+    auto resources = canvas.GetResources();
+    PdfContentsReader reader(std::make_shared<PdfCanvasInputDevice>(canvas));
+    PdfContent content;
+    const PdfName* name;
+    while (reader.TryReadNext(content))
+    {
+        compiled->Entries.push_back({
+            content.Type,
+            content.Warnings,
+            content.Operator,
+            (string)content.Keyword,
+            content.Stack,
+            content.Type == PdfContentType::ImageDictionary ? content.InlineImageDictionary : PdfDictionary(),
+            content.Type == PdfContentType::ImageData ? content.InlineImageData : charbuff(),
+            nullptr,
+            nullptr
+        });
+
+        const PdfObject* xobjraw;
+        unique_ptr<PdfXObject> xobj;
+        if (content.Type == PdfContentType::Operator
+            && content.Operator == PdfOperator::Do
+            && content.Stack.GetSize() == 1
+            && content.Stack[0].TryGetName(name)
+            && resources != nullptr
+            && (xobjraw = resources->GetResource("XObject", *name)) != nullptr
+            && PdfXObject::TryCreateFromObject(const_cast<PdfObject&>(*xobjraw), xobj))
+        {
+            auto& entry = compiled->Entries.back();
+            entry.XObject.reset(xobj.release());
+            entry.XObjectObject = xobjraw;
+        }
+    }
+
+    compiled->HasTrailingOperands = content.Stack.GetSize() != 0;
+    return compiled;
+}
+
+const PdfReference& PdfContentsCache::getReference(const PdfCanvas& canvas)
+{
+    return canvas.GetElement().GetObject().GetIndirectReference();
+}
+
+void PdfContentsCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_forms.clear();
+}
+
+unsigned PdfContentsCache::GetSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (unsigned)m_forms.size();
+}
+
+PdfContentsCache::FormPtr PdfContentsCache::find(const PdfReference& ref) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_forms.find(ref);
+    if (found == m_forms.end())
+        return nullptr;
+
+    return found->second;
+}
+
+PdfContentsCache::FormPtr PdfContentsCache::insert(const PdfReference& ref, const FormPtr& form)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_forms.emplace(ref, form).first->second;
+}
+
+nullable<size_t> getInlineImgLength(const PdfDictionary& dict)
+{
+    InlineImageParams params;
+    for (auto& pair : dict)
+    {
+        auto& key = pair.first.GetString();
+        auto& value = pair.second;
+        if (key == "L" || key == "Length")
+        {
+            (void)value.TryGetNumber(params.Length);
+        }
+        else if (key == "W" || key == "Width")
+        {
+            (void)value.TryGetNumber(params.Width);
+        }
+        else if (key == "H" || key == "Height")
+        {
+            (void)value.TryGetNumber(params.Height);
+        }
+        else if (key == "BPC" || key == "BitsPerComponent")
+        {
+            (void)value.TryGetNumber(params.BitsPerComponent);
+        }
+        else if (key == "IM" || key == "ImageMask")
+        {
+            (void)value.TryGetBool(params.ImageMask);
+        }
+        else if (key == "F" || key == "Filter")
+        {
+            const PdfArray* arr;
+            params.HasFilter = !value.TryGetArray(arr) || arr->GetSize() != 0;
+        }
+        else if (key == "CS" || key == "ColorSpace")
+        {
+            const PdfName* name;
+            const PdfArray* arr;
+            if (value.TryGetName(name))
+            {
+                params.ComponentCount = getColorSpaceComponentCount(name->GetString());
+            }
+            else if (value.TryGetArray(arr) && arr->GetSize() != 0 && (*arr)[0].TryGetName(name))
+            {
+                // Only indexed color spaces have a known component count
+                auto& family = name->GetString();
+                if (family == "I" || family == "Indexed")
+                    params.ComponentCount = 1;
+            }
+        }
+    }
+
+    return getInlineImgLength(params);
+}
+
+nullable<size_t> getInlineImgLength(const vector<PdfRawOperand>& operands)
+{
+    InlineImageParams params;
+    for (size_t i = 0; i + 1 < operands.size(); i++)
+    {
+        auto& key = operands[i].Data;
+        auto& value = operands[i + 1];
+        if (operands[i].Type != PdfRawOperandType::Name)
+            continue;
+
+        i++;
+        if (value.Type == PdfRawOperandType::ArrayBegin || value.Type == PdfRawOperandType::DictionaryBegin)
+        {
+            if ((key == "CS" || key == "ColorSpace") && i + 1 < operands.size()
+                && operands[i + 1].Type == PdfRawOperandType::Name
+                && (operands[i + 1].Data == "I" || operands[i + 1].Data == "Indexed"))
+            {
+                params.ComponentCount = 1;
+            }
+            else if (key == "F" || key == "Filter")
+            {
+                params.HasFilter = i + 1 >= operands.size() || operands[i + 1].Type != PdfRawOperandType::ArrayEnd;
+            }
+
+            // Skip the nested operands
+            unsigned depth = 1;
+            while (depth != 0 && i + 1 < operands.size())
+            {
+                i++;
+                switch (operands[i].Type)
+                {
+                    case PdfRawOperandType::ArrayBegin:
+                    case PdfRawOperandType::DictionaryBegin:
+                        depth++;
+                        break;
+                    case PdfRawOperandType::ArrayEnd:
+                    case PdfRawOperandType::DictionaryEnd:
+                        depth--;
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            continue;
+        }
+
+        if (key == "F" || key == "Filter")
+        {
+            params.HasFilter = true;
+        }
+        else if (key == "IM" || key == "ImageMask")
+        {
+            params.ImageMask = value.Type == PdfRawOperandType::Bool && value.Number != 0;
+        }
+        else if (key == "CS" || key == "ColorSpace")
+        {
+            if (value.Type == PdfRawOperandType::Name)
+                params.ComponentCount = getColorSpaceComponentCount(value.Data);
+        }
+        else if (value.Type == PdfRawOperandType::Number && value.Number == std::floor(value.Number))
+        {
+            if (key == "L" || key == "Length")
+                params.Length = (int64_t)value.Number;
+            else if (key == "W" || key == "Width")
+                params.Width = (int64_t)value.Number;
+            else if (key == "H" || key == "Height")
+                params.Height = (int64_t)value.Number;
+            else if (key == "BPC" || key == "BitsPerComponent")
+                params.BitsPerComponent = (int64_t)value.Number;
+        }
+    }
+
+    return getInlineImgLength(params);
+}
+
+nullable<size_t> getInlineImgLength(const InlineImageParams& params)
+{
+    if (params.Length >= 0)
+        return (size_t)params.Length;
+
+    // The length of filtered data can't be determined
+    if (params.HasFilter)
+        return { };
+
+    int64_t bitsPerPixel;
+    if (params.ImageMask)
+    {
+        bitsPerPixel = 1;
+    }
+    else
+    {
+        switch (params.BitsPerComponent)
+        {
+            case 1:
+            case 2:
+            case 4:
+            case 8:
+            case 16:
+                break;
+            default:
+                return { };
+        }
+
+        if (params.ComponentCount < 1)
+            return { };
+
+        bitsPerPixel = params.BitsPerComponent * params.ComponentCount;
+    }
+
+    // Inline images are meant to be small, so reject sizes
+    // that may overflow. Rows are padded to a byte boundary
+    constexpr int64_t MaxSize = 1 << 24;
+    if (params.Width <= 0 || params.Height <= 0
+        || params.Width > MaxSize || params.Height > MaxSize)
+    {
+        return { };
+    }
+
+    return (size_t)(((params.Width * bitsPerPixel + 7) / 8) * params.Height);
+}
+
+int getColorSpaceComponentCount(const string_view& name)
+{
+    // NOTE: Other names are color spaces in the resources
+    if (name == "G" || name == "DeviceGray")
+        return 1;
+    else if (name == "RGB" || name == "DeviceRGB")
+        return 3;
+    else if (name == "CMYK" || name == "DeviceCMYK")
+        return 4;
+    else
+        return -1;
+}
+
+// Find the "EI" operator followed by a whitespace
+const char* findEndImage(const char* begin, const char* end)
+{
+    const char* it = begin;
+    while (end - it >= 3)
+    {
+        it = (const char*)std::memchr(it, 'E', end - it - 2);
+        if (it == nullptr)
+            return nullptr;
+
+        if (it[1] == 'I' && PdfTokenizer::IsWhitespace(it[2]))
+            return it;
+
+        it++;
+    }
+
+    return nullptr;
+}
+
+void pushBackInlineImgData(shared_ptr<InputStreamDevice>& device, const bufferview& data)
+{
+    if (data.size() == 0)
+        return;
+
+    auto pushback = dynamic_cast<PdfPushbackInputDevice*>(device.get());
+    if (pushback == nullptr)
+    {
+        auto newDevice = std::make_shared<PdfPushbackInputDevice>(device);
+        pushback = newDevice.get();
+        device = newDevice;
+    }
+
+    pushback->PushBack(data);
+}
@@ -15,6 +15,9 @@
 #include "PdfVariantStack.h"
 #include "PdfPostScriptTokenizer.h"
 
+#include <mutex>
+#include <unordered_map>
+
 namespace mm {
 
 /** Type of the content read from a content stream
@@ -56,6 +59,21 @@ struct PdfContent
     std::shared_ptr<const PdfXObject> XObject;
 };
 
+/** Content as read from content streams by PdfContentsReader::TryReadNextRaw
+ *
+ * The operands and their data view memory owned by the
+ * reader, which is valid until the next read
+ */
+struct PdfRawContent
+{
+    PdfContentType Type = PdfContentType::Unknown;
+    PdfContentWarnings Warnings = PdfContentWarnings::None;
+    cspan<PdfRawOperand> Operands;
+    PdfOperator Operator = PdfOperator::Unknown;
+    std::string_view Keyword;
+    bufferview InlineImageData;
+};
+
 enum class PdfContentReaderFlags
 {
     None = 0,
@@ -69,10 +87,92 @@ enum class PdfContentReaderFlags
  */
 using PdfInlineImageHandler = std::function<bool(const PdfDictionary& imageDict, InputStreamDevice& device)>;
 
+/** A cache of the tokenized contents of XObject forms, keyed by
+ * their reference, so that forms drawn many times, like headers,
+ * footers or watermarks, are decoded and tokenized only once and
+ * then replayed. The contents of pages can be compiled in the cache
+ * as well, so that several passes on the same page, e.g. text
+ * extraction and then bounds computation, decode and tokenize the
+ * page only once. The XObjects drawn by the cached contents are
+ * resolved once as well. The cache is bound to a single document,
+ * and it can be shared by the readers of all its pages
+ * \remarks It's internally synchronized
+ */
+class PDFMM_API PdfContentsCache final
+{
+    friend class PdfContentsReader;
+
+public:
+    PdfContentsCache();
+
+    /** Compile the contents of the given canvas, e.g. a page, in the
+     * cache. The readers of the canvas using this cache will replay the
+     * compiled contents, instead of reading the content streams
+     * \remarks The contents must be removed with Remove() if the
+     * canvas is modified
+     */
+    void Compile(const PdfCanvas& canvas);
+
+    /** Remove the cached contents of the given canvas, if any
+     */
+    void Remove(const PdfCanvas& canvas);
+
+    /** Remove all the cached forms and compiled contents
+     */
+    void Clear();
+
+    /** \returns the count of the cached forms and compiled contents
+     */
+    unsigned GetSize() const;
+
+private:
+    PdfContentsCache(const PdfContentsCache&) = delete;
+    PdfContentsCache& operator=(const PdfContentsCache&) = delete;
+
+    struct Entry
+    {
+        PdfContentType Type;
+        PdfContentWarnings Warnings;
+        PdfOperator Operator;
+        std::string Keyword;
+        PdfVariantStack Stack;
+        PdfDictionary InlineImageDictionary;
+        charbuff InlineImageData;
+        // The XObject drawn by a Do operator, resolved when compiling
+        std::shared_ptr<const PdfXObject> XObject;
+        const PdfObject* XObjectObject;
+    };
+
+    struct Form
+    {
+        std::vector<Entry> Entries;
+        bool HasTrailingOperands = false;
+    };
+
+    using FormPtr = std::shared_ptr<const Form>;
+
+    static FormPtr compile(const PdfCanvas& canvas);
+
+    static const PdfReference& getReference(const PdfCanvas& canvas);
+
+    FormPtr find(const PdfReference& ref) const;
+
+    FormPtr insert(const PdfReference& ref, const FormPtr& form);
+
+private:
+    mutable std::mutex m_mutex;
+    std::unordered_map<PdfReference, FormPtr> m_forms;
+};
+
 struct PdfContentReaderArgs
 {
     PdfContentReaderFlags Flags = PdfContentReaderFlags::None;
     PdfInlineImageHandler InlineImageHandler;
+
+    /** Cache for the contents of the followed XObject forms. It's
+     *  not used when an inline image handler is set
+     */
+    std::shared_ptr<PdfContentsCache> Cache;
 };
 
 /** Reader class to read content streams
@@ -91,6 +191,19 @@ private:
 public:
     bool TryReadNext(PdfContent& data);
 
+    /** Read the next content without creating PdfVariant operands
+     *
+     * Numbers are parsed in the operands, and strings and names are
+     * views of decoded data owned by the reader, so walking a content
+     * stream performs no heap allocations per operator. XObject forms
+     * are not followed. Inline images are read as an ImageDictionary
+     * content, with the keys and the values as operands, followed by
+     * an ImageData content
+     *  \remarks Don't mix with TryReadNext() on the same reader. The
+     * inline image handler is not used
+     */
+    bool TryReadNextRaw(PdfRawContent& content);
+
 private:
     void beforeReadReset(PdfContent& content);
 
@@ -102,10 +215,20 @@ private:
 
     bool tryReadInlineImgDict(PdfContent& content);
 
-    bool tryReadInlineImgData(charbuff& data);
+    bool tryReadInlineImgData(bufferview& data);
+
+    bool tryReadNextRawOperand(PdfRawContent& content, PdfRawOperand& operand);
+
+    bool tryReadRawInlineImgDict(PdfRawContent& content);
 
     void tryFollowXObject(PdfContent& content);
 
+    void followXObject(PdfContent& content, const PdfObject& xobjraw);
+
+    bool tryReadCachedContent(PdfContent& content);
+
+    PdfContentsCache::FormPtr getCachedForm(const PdfObject& xobj, const PdfXObjectForm& form);
+
     void handleWarnings();
 
     bool isCalledRecursively(const PdfObject* xobj);
@@ -124,6 +247,8 @@ private:
         std::shared_ptr<const PdfXObject> Form;
         std::shared_ptr<InputStreamDevice> Device;
         const PdfCanvas* Canvas;
+        PdfContentsCache::FormPtr CachedForm;   // Replayed instead of the device, if not null
+        size_t CachedIndex = 0;
     };
 
 private:
@@ -132,9 +257,14 @@ private:
     std::shared_ptr<charbuff> m_buffer;
     PdfPostScriptTokenizer m_tokenizer;
     bool m_readingInlineImgData;  // A state of reading inline image data
+    nullable<size_t> m_inlineImgLength; // Length of the inline image data, if it can be determined
 
     // Temp storage
     Storage m_temp;
+
+    // Reused storage of TryReadNextRaw()
+    std::vector<PdfRawOperand> m_rawOperands;
+    charbuff m_rawBuffer;
 };
 
 };
@@ -10,6 +10,7 @@
 
 #include "PdfDeclarations.h"
 #include "PdfStatefulEncrypt.h"
+#include "PdfMemoryResource.h"
 
 namespace mm {
 
@@ -22,6 +23,8 @@ class OutputStreamDevice;
  */
 class PDFMM_API PdfDataProvider
 {
+    PDFMM_DECLARE_MEMORY_RESOURCE_ALLOCATION
+
 protected:
     /** Create a new PdfDataProvider.
      *  Can only be called by subclasses
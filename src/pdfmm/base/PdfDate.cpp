@@ -25,38 +25,24 @@ using namespace mm;
 // a W3C date has a maximum of 26 bytes incuding the terminating \0
 #define W3C_DATE_BUFFER_SIZE 26
 
-#define PEEK_DATE_CHAR(str, zoneShift)\
-if (*str == '\0')\
-{\
-    goto End;\
-}\
-else if (tryReadShiftChar(str, zoneShift))\
-{\
-    goto ParseShift;\
-}
-
-#define PEEK_DATE_CHAR_W3C(str, separator)\
-if (*str == '\0')\
-{\
-    goto End;\
-}\
-else if (*str != separator)\
-{\
-    return false;\
-}\
-else\
-{\
-    str++;\
-}
-
-static bool parseFixLenNumber(const char*& in, unsigned maxLength, int min, int max, int& ret);
+static bool parseFixLenNumber(const char*& in, const char* end, unsigned maxLength, int min, int max, int& ret);
 static int getLocalOffesetFromUTCMinutes();
-static bool tryReadShiftChar(const char*& in, int& zoneShift);
-static bool tryParse(const string_view & dateStr, chrono::seconds & secondsFromEpoch, nullable<chrono::minutes>&minutesFromUtc);
-static bool tryParseW3C(const string_view & dateStr, chrono::seconds & secondsFromEpoch, nullable<chrono::minutes>&minutesFromUtc);
-static void inferTimeComponents(int y, int m, int d, int h, int M, int s,
-    bool hasZoneShift, int zoneShift, int zoneHour, int zoneMin,
-    chrono::seconds & secondsFromEpoch, nullable<chrono::minutes>&minutesFromUtc);
+static bool tryReadShiftChar(const char*& in, const char* end, int& zoneShift);
+static bool tryParse(string_view dateStr, PdfDateComponents& components);
+static bool tryParseW3C(string_view dateStr, PdfDateComponents& components);
+static void setComponents(PdfDateComponents& components, const int values[6],
+    bool hasZoneShift, int zoneShift, int zoneHour, int zoneMin);
+static void inferTimeComponents(const PdfDateComponents& components,
+    chrono::seconds& secondsFromEpoch, nullable<chrono::minutes>& minutesFromUtc);
+static char* writeDigits(char* cursor, unsigned value, unsigned count);
+
+// The lengths and the ranges of the fields of a date, from the year to the seconds
+static constexpr unsigned FieldLengths[6] = { 4, 2, 2, 2, 2, 2 };
+static constexpr int FieldMins[6] = { 0, 1, 1, 0, 0, 0 };
+static constexpr int FieldMaxs[6] = { 9999, 12, 31, 23, 59, 59 };
+
+// The separators preceding the fields of a W3C date
+static constexpr char W3CSeparators[6] = { '\0', '-', '-', 'T', ':', ':' };
 
 PdfDate::PdfDate()
 {
@@ -75,7 +61,8 @@ PdfDate::PdfDate(const chrono::seconds& secondsFromEpoch, const nullable<chrono:
 
 PdfDate PdfDate::Parse(const string_view& dateStr)
 {
-    PdfDate date;
+    // NOTE: Don't use the default constructor, that reads the clock
+    PdfDate date(chrono::seconds(), { });
     if (!TryParse(dateStr, date))
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Date is invalid");
 
@@ -84,21 +71,25 @@ PdfDate PdfDate::Parse(const string_view& dateStr)
 
 bool PdfDate::TryParse(const string_view& dateStr, PdfDate& date)
 {
-    chrono::seconds secondsFromEpoch;
-    nullable<chrono::minutes> minutesFromUtc;
-    if (!tryParse(dateStr, secondsFromEpoch, minutesFromUtc))
+    PdfDateComponents components;
+    if (!tryParse(dateStr, components))
     {
-        date = { };
+        date = PdfDate(chrono::seconds(), { });
         return false;
     }
 
-    date = PdfDate(secondsFromEpoch, minutesFromUtc);
+    inferTimeComponents(components, date.m_SecondsFromEpoch, date.m_MinutesFromUtc);
     return true;
 }
 
+bool PdfDate::TryParse(const string_view& dateStr, PdfDateComponents& components)
+{
+    return tryParse(dateStr, components);
+}
+
 PdfDate PdfDate::ParseW3C(const string_view& dateStr)
 {
-    PdfDate date;
+    PdfDate date(chrono::seconds(), { });
     if (!TryParseW3C(dateStr, date))
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Date is invalid");
 
@@ -107,48 +98,30 @@ PdfDate PdfDate::ParseW3C(const string_view& dateStr)
 
 bool PdfDate::TryParseW3C(const string_view& dateStr, PdfDate& date)
 {
-    chrono::seconds secondsFromEpoch;
-    nullable<chrono::minutes> minutesFromUtc;
-    if (!tryParseW3C(dateStr, secondsFromEpoch, minutesFromUtc))
+    PdfDateComponents components;
+    if (!tryParseW3C(dateStr, components))
     {
-        date = { };
+        date = PdfDate(chrono::seconds(), { });
         return false;
     }
 
-    date = PdfDate(secondsFromEpoch, minutesFromUtc);
+    inferTimeComponents(components, date.m_SecondsFromEpoch, date.m_MinutesFromUtc);
     return true;
 }
 
-PdfString PdfDate::createStringRepresentation(bool w3cstring) const
+bool PdfDate::TryParseW3C(const string_view& dateStr, PdfDateComponents& components)
+{
+    return tryParseW3C(dateStr, components);
+}
+
+size_t PdfDate::writeStringRepresentation(char* buffer, bool w3cstring) const
 {
-    string offset;
     chrono::hh_mm_ss<chrono::seconds> time;
     chrono::year_month_day ymd;
     if (m_MinutesFromUtc.has_value())
     {
-        auto minutesFromUtc = *m_MinutesFromUtc;
-        int minutesFromUtci = (int)minutesFromUtc.count();
-        unsigned offseth = std::abs(minutesFromUtci) / 60;
-        unsigned offsetm = std::abs(minutesFromUtci) % 60;
-        if (minutesFromUtci == 0)
-        {
-            offset = "Z";
-        }
-        else
-        {
-            bool plus = minutesFromUtci > 0 ? true : false;
-            if (w3cstring)
-            {
-                utls::FormatTo(offset, "{}{:02}:{:02}", plus ? '+' : '-', offseth, offsetm);
-            }
-            else
-            {
-                utls::FormatTo(offset, "{}{:02}'{:02}'", plus ? '+' : '-', offseth, offsetm);
-            }
-        }
-
         // Assume sys time
-        auto secondsFromEpoch = (chrono::sys_seconds)(m_SecondsFromEpoch + minutesFromUtc);
+        auto secondsFromEpoch = (chrono::sys_seconds)(m_SecondsFromEpoch + *m_MinutesFromUtc);
         auto dp = chrono::floor<chrono::days>(secondsFromEpoch);
         ymd = chrono::year_month_day(dp);
         time = chrono::hh_mm_ss<chrono::seconds>(chrono::floor<chrono::seconds>(secondsFromEpoch - dp));
@@ -162,36 +135,69 @@ PdfString PdfDate::createStringRepresentation(bool w3cstring) const
         time = chrono::hh_mm_ss<chrono::seconds>(chrono::floor<chrono::seconds>(secondsFromEpoch - dp));
     }
 
-    short y = (short)(int)ymd.year();
-    unsigned char m = (unsigned char)(unsigned)ymd.month();
-    unsigned char d = (unsigned char)(unsigned)ymd.day();
-    unsigned char h = (unsigned char)time.hours().count();
-    unsigned char M = (unsigned char)time.minutes().count();
-    unsigned char s = (unsigned char)time.seconds().count();
+    // The years not representable with 4 digits are clamped
+    int y = std::clamp((int)ymd.year(), 0, 9999);
 
-    string date;
-    if (w3cstring)
+    // e.g. "D:19981223195207-08'00'" or "1998-12-23T19:52:07-08:00"
+    char* cursor = buffer;
+    if (!w3cstring)
     {
-        // e.g. "1998-12-23T19:52:07-08:00"
-        utls::FormatTo(date, "{:04}-{:02}-{:02}T{:02}:{:02}:{:02}{}", y, m, d, h, M, s, offset);
+        *cursor++ = 'D';
+        *cursor++ = ':';
     }
-    else
+
+    cursor = writeDigits(cursor, (unsigned)y, 4);
+    if (w3cstring)
+        *cursor++ = '-';
+    cursor = writeDigits(cursor, (unsigned)ymd.month(), 2);
+    if (w3cstring)
+        *cursor++ = '-';
+    cursor = writeDigits(cursor, (unsigned)ymd.day(), 2);
+    if (w3cstring)
+        *cursor++ = 'T';
+    cursor = writeDigits(cursor, (unsigned)time.hours().count(), 2);
+    if (w3cstring)
+        *cursor++ = ':';
+    cursor = writeDigits(cursor, (unsigned)time.minutes().count(), 2);
+    if (w3cstring)
+        *cursor++ = ':';
+    cursor = writeDigits(cursor, (unsigned)time.seconds().count(), 2);
+
+    if (m_MinutesFromUtc.has_value())
     {
-        // e.g. "D:19981223195207−08'00'"
-        utls::FormatTo(date, "D:{:04}{:02}{:02}{:02}{:02}{:02}{}", y, m, d, h, M, s, offset);
+        int minutesFromUtc = (int)m_MinutesFromUtc->count();
+        if (minutesFromUtc == 0)
+        {
+            *cursor++ = 'Z';
+        }
+        else
+        {
+            unsigned offseth = (unsigned)std::abs(minutesFromUtc) / 60;
+            unsigned offsetm = (unsigned)std::abs(minutesFromUtc) % 60;
+            *cursor++ = minutesFromUtc > 0 ? '+' : '-';
+            cursor = writeDigits(cursor, offseth, 2);
+            *cursor++ = w3cstring ? ':' : '\'';
+            cursor = writeDigits(cursor, offsetm, 2);
+            if (!w3cstring)
+                *cursor++ = '\'';
+        }
     }
 
-    return PdfString(date);
+    return (size_t)(cursor - buffer);
 }
 
 PdfString PdfDate::ToString() const
 {
-    return createStringRepresentation(false);
+    char buffer[PDF_DATE_BUFFER_SIZE];
+    size_t length = writeStringRepresentation(buffer, false);
+    return PdfString(string_view(buffer, length));
 }
 
 PdfString PdfDate::ToStringW3C() const
 {
-    return createStringRepresentation(true);
+    char buffer[W3C_DATE_BUFFER_SIZE];
+    size_t length = writeStringRepresentation(buffer, true);
+    return PdfString(string_view(buffer, length));
 }
 
 bool PdfDate::operator==(const PdfDate& rhs) const
@@ -204,79 +210,62 @@ bool PdfDate::operator!=(const PdfDate& rhs) const
     return m_MinutesFromUtc != rhs.m_MinutesFromUtc || m_SecondsFromEpoch != rhs.m_SecondsFromEpoch;
 }
 
-bool tryParse(const string_view& dateStr, chrono::seconds& secondsFromEpoch, nullable<chrono::minutes>& minutesFromUtc)
+bool tryParse(string_view dateStr, PdfDateComponents& components)
 {
-    int y = 0;
-    int m = 0;
-    int d = 0;
-    int h = 0;
-    int M = 0;
-    int s = 0;
-
+    int values[6] = { 0, 1, 1, 0, 0, 0 };
     bool hasZoneShift = false;
     int zoneShift = 0;
     int zoneHour = 0;
     int zoneMin = 0;
 
-    const char* cursor = dateStr.data();
-    if (cursor == nullptr)
+    // The date ends at the first terminator, if any
+    dateStr = dateStr.substr(0, dateStr.find('\0'));
+    if (dateStr.empty())
         return false;
 
+    const char* cursor = dateStr.data();
+    const char* end = cursor + dateStr.size();
     if (*cursor == 'D')
     {
         cursor++;
-        if (*cursor++ != ':')
+        if (cursor == end || *cursor++ != ':')
             return false;
     }
 
-    PEEK_DATE_CHAR(cursor, zoneShift);
-
-    if (!parseFixLenNumber(cursor, 4, 0, 9999, y))
-        return false;
-
-    PEEK_DATE_CHAR(cursor, zoneShift);
-
-    if (!parseFixLenNumber(cursor, 2, 1, 12, m))
-        return false;
-
-    PEEK_DATE_CHAR(cursor, zoneShift);
-
-    if (!parseFixLenNumber(cursor, 2, 1, 31, d))
-        return false;
-
-    PEEK_DATE_CHAR(cursor, zoneShift);
-
-    if (!parseFixLenNumber(cursor, 2, 0, 23, h))
-        return false;
-
-    PEEK_DATE_CHAR(cursor, zoneShift);
+    for (unsigned i = 0; i < 6; i++)
+    {
+        if (cursor == end)
+            goto End;
 
-    if (!parseFixLenNumber(cursor, 2, 0, 59, M))
-        return false;
+        if (tryReadShiftChar(cursor, end, zoneShift))
+            goto ParseShift;
 
-    PEEK_DATE_CHAR(cursor, zoneShift);
+        if (!parseFixLenNumber(cursor, end, FieldLengths[i], FieldMins[i], FieldMaxs[i], values[i]))
+            return false;
+    }
 
-    if (!parseFixLenNumber(cursor, 2, 0, 59, s))
-        return false;
+    if (cursor == end)
+        goto End;
 
-    PEEK_DATE_CHAR(cursor, zoneShift);
+    // Other characters are like a shift of 0
+    (void)tryReadShiftChar(cursor, end, zoneShift);
 
 ParseShift:
     hasZoneShift = true;
-    if (*cursor != '\0')
+    if (cursor != end)
     {
-        if (!parseFixLenNumber(cursor, 2, 0, 59, zoneHour))
+        if (!parseFixLenNumber(cursor, end, 2, 0, 59, zoneHour))
             goto End;
 
-        if (*cursor == '\'')
+        if (cursor != end && *cursor == '\'')
         {
             cursor++;
-            if (*cursor != '\0')
+            if (cursor != end)
             {
-                if (!parseFixLenNumber(cursor, 2, 0, 59, zoneMin))
+                if (!parseFixLenNumber(cursor, end, 2, 0, 59, zoneMin))
                     return false;
 
-                if (*cursor == '\'')
+                if (cursor != end && *cursor == '\'')
                     cursor++;
             }
         }
@@ -284,83 +273,67 @@ ParseShift:
         if (zoneShift == 0 && (zoneHour != 0 || zoneMin != 0))
             return false;
 
-        if (*cursor != '\0')
+        if (cursor != end)
             return false;
     }
 
 End:
-    inferTimeComponents(y, m, d, h, M, s,
-        hasZoneShift, zoneShift, zoneHour, zoneMin,
-        secondsFromEpoch, minutesFromUtc);
-
+    setComponents(components, values, hasZoneShift, zoneShift, zoneHour, zoneMin);
     return true;
 }
 
-bool tryParseW3C(const string_view& dateStr, chrono::seconds& secondsFromEpoch, nullable<chrono::minutes>& minutesFromUtc)
+bool tryParseW3C(string_view dateStr, PdfDateComponents& components)
 {
-    int y = 0;
-    int m = 0;
-    int d = 0;
-    int h = 0;
-    int M = 0;
-    int s = 0;
-
+    int values[6] = { 0, 1, 1, 0, 0, 0 };
     bool hasZoneShift = false;
     int zoneShift = 0;
     int zoneHour = 0;
     int zoneMin = 0;
 
-    const char* cursor = dateStr.data();
-    if (cursor == nullptr || *cursor == '\0')
-        return false;
-
-    if (!parseFixLenNumber(cursor, 4, 0, 9999, y))
-        return false;
-
-    PEEK_DATE_CHAR_W3C(cursor, '-');
-
-    if (!parseFixLenNumber(cursor, 2, 1, 12, m))
-        return false;
-
-    PEEK_DATE_CHAR_W3C(cursor, '-');
-
-    if (!parseFixLenNumber(cursor, 2, 1, 31, d))
-        return false;
-
-    PEEK_DATE_CHAR_W3C(cursor, 'T');
-
-    if (!parseFixLenNumber(cursor, 2, 0, 23, h))
+    // The date ends at the first terminator, if any
+    dateStr = dateStr.substr(0, dateStr.find('\0'));
+    if (dateStr.empty())
         return false;
 
-    PEEK_DATE_CHAR_W3C(cursor, ':');
+    const char* cursor = dateStr.data();
+    const char* end = cursor + dateStr.size();
+    for (unsigned i = 0; i < 6; i++)
+    {
+        if (i != 0)
+        {
+            // The time zone may follow the minutes
+            if (i == 5 && tryReadShiftChar(cursor, end, zoneShift))
+                goto ParseShift;
 
-    if (!parseFixLenNumber(cursor, 2, 0, 59, M))
-        return false;
+            if (cursor == end)
+                goto End;
 
-    if (tryReadShiftChar(cursor, zoneShift))
-        goto ParseShift;
+            if (*cursor != W3CSeparators[i])
+                return false;
 
-    PEEK_DATE_CHAR_W3C(cursor, ':');
+            cursor++;
+        }
 
-    if (!parseFixLenNumber(cursor, 2, 0, 59, s))
-        return false;
+        if (!parseFixLenNumber(cursor, end, FieldLengths[i], FieldMins[i], FieldMaxs[i], values[i]))
+            return false;
+    }
 
-    if (!tryReadShiftChar(cursor, zoneShift))
+    if (!tryReadShiftChar(cursor, end, zoneShift))
         goto End;
 
 ParseShift:
     hasZoneShift = true;
-    if (*cursor != '\0')
+    if (cursor != end)
     {
-        if (!parseFixLenNumber(cursor, 2, 0, 59, zoneHour))
+        if (!parseFixLenNumber(cursor, end, 2, 0, 59, zoneHour))
             goto End;
 
-        if (*cursor == ':')
+        if (cursor != end && *cursor == ':')
         {
             cursor++;
-            if (*cursor != '\0')
+            if (cursor != end)
             {
-                if (!parseFixLenNumber(cursor, 2, 0, 59, zoneMin))
+                if (!parseFixLenNumber(cursor, end, 2, 0, 59, zoneMin))
                     return false;
             }
         }
@@ -368,26 +341,39 @@ ParseShift:
         if (zoneShift == 0 && (zoneHour != 0 || zoneMin != 0))
             return false;
 
-        if (*cursor != '\0')
+        if (cursor != end)
             return false;
     }
 
 End:
-    inferTimeComponents(y, m, d, h, M, s,
-        hasZoneShift, zoneShift, zoneHour, zoneMin,
-        secondsFromEpoch, minutesFromUtc);
-
+    setComponents(components, values, hasZoneShift, zoneShift, zoneHour, zoneMin);
     return true;
 }
 
-void inferTimeComponents(int y, int m, int d, int h, int M, int s,
-    bool hasZoneShift, int zoneShift, int zoneHour, int zoneMin,
-    chrono::seconds& secondsFromEpoch, nullable<chrono::minutes>& minutesFromUtc)
+void setComponents(PdfDateComponents& components, const int values[6],
+    bool hasZoneShift, int zoneShift, int zoneHour, int zoneMin)
 {
-    secondsFromEpoch = (chrono::local_days(chrono::year(y) / m / d) + chrono::hours(h) + chrono::minutes(M) + chrono::seconds(s)).time_since_epoch();
+    components.Year = values[0];
+    components.Month = (unsigned)values[1];
+    components.Day = (unsigned)values[2];
+    components.Hour = (unsigned)values[3];
+    components.Minute = (unsigned)values[4];
+    components.Second = (unsigned)values[5];
     if (hasZoneShift)
+        components.MinutesFromUtc = zoneShift * (zoneHour * 60 + zoneMin);
+    else
+        components.MinutesFromUtc = nullptr;
+}
+
+void inferTimeComponents(const PdfDateComponents& components,
+    chrono::seconds& secondsFromEpoch, nullable<chrono::minutes>& minutesFromUtc)
+{
+    secondsFromEpoch = (chrono::local_days(chrono::year(components.Year) / components.Month / components.Day)
+        + chrono::hours(components.Hour) + chrono::minutes(components.Minute)
+        + chrono::seconds(components.Second)).time_since_epoch();
+    if (components.MinutesFromUtc.has_value())
     {
-        minutesFromUtc = zoneShift * (chrono::hours(zoneHour) + chrono::minutes(zoneMin));
+        minutesFromUtc = chrono::minutes(*components.MinutesFromUtc);
         secondsFromEpoch -= *minutesFromUtc;
     }
     else
@@ -408,8 +394,11 @@ int getLocalOffesetFromUTCMinutes()
     return (int)(timegm(locg) - mktime(&locl)) / 60;
 }
 
-bool tryReadShiftChar(const char*& in, int& zoneShift)
+bool tryReadShiftChar(const char*& in, const char* end, int& zoneShift)
 {
+    if (in == end)
+        return false;
+
     switch (*in)
     {
         case '+':
@@ -429,12 +418,12 @@ bool tryReadShiftChar(const char*& in, int& zoneShift)
     return true;
 }
 
-bool parseFixLenNumber(const char*& in, unsigned maxLength, int min, int max, int& ret)
+bool parseFixLenNumber(const char*& in, const char* end, unsigned maxLength, int min, int max, int& ret)
 {
     ret = 0;
     for (unsigned i = 0; i < maxLength; i++)
     {
-        if (in == nullptr || !isdigit(*in))
+        if (in == end || *in < '0' || *in > '9')
             return i != 0;
 
         ret = ret * 10 + (*in - '0');
@@ -445,3 +434,14 @@ bool parseFixLenNumber(const char*& in, unsigned maxLength, int min, int max, in
 
     return true;
 }
+
+char* writeDigits(char* cursor, unsigned value, unsigned count)
+{
+    for (unsigned i = count; i > 0; i--)
+    {
+        cursor[i - 1] = (char)('0' + value % 10);
+        value /= 10;
+    }
+
+    return cursor + count;
+}
@@ -16,6 +16,21 @@
 
 namespace mm {
 
+/** The components of a date, as written in a date string.
+ *  The missing components have their default values
+ */
+struct PDFMM_API PdfDateComponents
+{
+    int Year = 0;
+    unsigned Month = 1;
+    unsigned Day = 1;
+    unsigned Hour = 0;
+    unsigned Minute = 0;
+    unsigned Second = 0;
+    /** The offset from UTC, missing if the date has no time zone */
+    nullable<int> MinutesFromUtc;
+};
+
 /** This class is a date datatype as specified in the PDF
  *  reference. You can easily convert from Unix time_t to
  *  the PDF time representation and back. Dates like these
@@ -54,6 +69,11 @@ public:
     static PdfDate Parse(const std::string_view& dateStr);
     static bool TryParse(const std::string_view& dateStr, PdfDate& date);
 
+    /** Parse the components of a date in PDF format, without
+     *  converting them to a time and without allocating
+     */
+    static bool TryParse(const std::string_view& dateStr, PdfDateComponents& components);
+
     /** Create a PdfDate with a specified date and time
      *  \param dateStr the date and time of this object
      *         in W3C format. It has to be a string of
@@ -62,6 +82,11 @@ public:
     static PdfDate ParseW3C(const std::string_view& dateStr);
     static bool TryParseW3C(const std::string_view& dateStr, PdfDate& date);
 
+    /** Parse the components of a date in W3C format, without
+     *  converting them to a time and without allocating
+     */
+    static bool TryParseW3C(const std::string_view& dateStr, PdfDateComponents& components);
+
     /** \returns the date and time of this PdfDate in
      *  seconds since epoch.
      */
@@ -82,10 +107,11 @@ public:
     bool operator!=(const PdfDate& rhs) const;
 
 private:
-    /** Creates the internal string representation from
-     *  a time_t value and writes it to m_szDate.
+    /** Write the string representation of the
+     *  date to a buffer large enough for it
+     *  \returns the length of the string written
      */
-    PdfString createStringRepresentation(bool w3cstring) const;
+    size_t writeStringRepresentation(char* buffer, bool w3cstring) const;
 
 private:
     std::chrono::seconds m_SecondsFromEpoch;
@@ -11,6 +11,7 @@
 #include <utfcpp/utf8.h>
 #include <pdfmm/private/charconv_compat.h>
 #include <pdfmm/private/utfcpp_extensions.h>
+#include <pdfmm/private/PdfEncodingPrivate.h>
 
 #include "PdfInputDevice.h"
 #include "PdfOutputDevice.h"
@@ -25,9 +26,10 @@
 using namespace std;
 using namespace mm;
 
-static const locale s_cachedLocale("C");
-
 static void removeTrailingZeroes(string& str);
+static size_t removeTrailingZeroes(const char* str, size_t len);
+template <typename T>
+static void formatTo(string& str, T value, unsigned short precision);
 
 struct VersionIdentity
 {
@@ -86,6 +88,34 @@ string_view mm::GetPdfVersionName(PdfVersion version)
     }
 }
 
+bool mm::IsLiteralDataType(PdfDataType type)
+{
+    switch (type)
+    {
+        case PdfDataType::Bool:
+        case PdfDataType::Number:
+        case PdfDataType::Real:
+        case PdfDataType::Reference:
+        case PdfDataType::Null:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool mm::IsDelimitedDataType(PdfDataType type)
+{
+    switch (type)
+    {
+        case PdfDataType::String:
+        case PdfDataType::Array:
+        case PdfDataType::Dictionary:
+            return true;
+        default:
+            return false;
+    }
+}
+
 vector<string> mm::ToPdfKeywordsList(const string_view& str)
 {
     vector<string> ret;
@@ -136,6 +166,7 @@ string mm::ToPdfKeywordsString(const cspan<string>& keywords)
 
 const locale& utls::GetInvariantLocale()
 {
+    static const locale s_cachedLocale("C");
     return s_cachedLocale;
 }
 
@@ -392,8 +423,7 @@ void utls::WriteUtf16BETo(u16string& str, char32_t codePoint)
 
 void utls::ReadUtf16BEString(const bufferview& buffer, string& utf8str)
 {
-    utf8::u16bechariterable iterable(buffer.data(), buffer.size());
-    utf8::utf16to8(iterable.begin(), iterable.end(), std::back_inserter(utf8str));
+    mm::ConvertUTF16BEToUTF8(string_view(buffer.data(), buffer.size()), utf8str);
 }
 
 void utls::ReadUtf16LEString(const bufferview& buffer, string& utf8str)
@@ -404,14 +434,19 @@ void utls::ReadUtf16LEString(const bufferview& buffer, string& utf8str)
 
 void utls::FormatTo(string& str, float value, unsigned short precision)
 {
-    utls::FormatTo(str, "{:.{}f}", value, precision);
-    removeTrailingZeroes(str);
+    formatTo(str, value, precision);
 }
 
 void utls::FormatTo(string& str, double value, unsigned short precision)
 {
-    utls::FormatTo(str, "{:.{}f}", value, precision);
-    removeTrailingZeroes(str);
+    formatTo(str, value, precision);
+}
+
+void utls::AppendNumberTo(string& str, int64_t value)
+{
+    char buffer[20];
+    auto result = std::to_chars(buffer, buffer + std::size(buffer), value);
+    str.append(buffer, result.ptr - buffer);
 }
 
 string utls::ToLower(const string_view& str)
@@ -429,6 +464,16 @@ string utls::Trim(const string_view& str, char ch)
     return ret;
 }
 
+size_t utls::GetHeapSize(const string& str)
+{
+    auto data = (const char*)str.data();
+    auto obj = (const char*)&str;
+    if (data >= obj && data < obj + sizeof(string))
+        return 0;
+
+    return str.capacity() + 1;
+}
+
 void utls::ByteSwap(u16string& str)
 {
     for (unsigned i = 0; i < str.length(); i++)
@@ -596,24 +641,41 @@ void utls::ReadInt16BE(const char* buf, int16_t& value)
     value = AS_BIG_ENDIAN(value);
 }
 
+template <typename T>
+void formatTo(string& str, T value, unsigned short precision)
+{
+    // Enough for the usual numbers, otherwise fallback
+    // to the formatting library with a dynamic buffer
+    char buffer[64];
+    auto result = std::to_chars(buffer, buffer + std::size(buffer), value, chars_format::fixed, precision);
+    if (result.ec != std::errc())
+    {
+        utls::FormatTo(str, "{:.{}f}", value, precision);
+        removeTrailingZeroes(str);
+        return;
+    }
+
+    str.assign(buffer, removeTrailingZeroes(buffer, result.ptr - buffer));
+}
+
 void removeTrailingZeroes(string& str)
 {
-    // Remove trailing zeroes
-    const char* cursor = str.data();
-    size_t len = str.size();
-    while (cursor[len - 1] == '0')
+    str.resize(removeTrailingZeroes(str.data(), str.size()));
+}
+
+size_t removeTrailingZeroes(const char* str, size_t len)
+{
+    // Numbers formatted with no decimal digits have no
+    // zeroes to remove. Otherwise there's always at least
+    // one digit before the decimal point
+    if (std::memchr(str, '.', len) == nullptr)
+        return len;
+
+    while (str[len - 1] == '0')
         len--;
 
-    if (cursor[len - 1] == '.')
+    if (str[len - 1] == '.')
         len--;
 
-    if (len == 0)
-    {
-        str.resize(1);
-        str[0] = '0';
-    }
-    else
-    {
-        str.resize(len);
-    }
+    return len;
 }
@@ -123,6 +123,7 @@ enum class PdfWriteFlags
     None = 0,
     Clean = 1,             ///< Create a PDF that is readable in a text editor, i.e. insert spaces and linebreaks between tokens
     NoInlineLiteral = 2,   ///< Don't write spaces before literal types (numerical, references, null)
+    Minimal = 8,           ///< Don't write any byte not required by the syntax, e.g. the spaces after delimiters and the end of lines after "obj". Ignored if PdfWriteFlags::Clean is set
 
     // NOTE: The following flags are actually never set but
     // they are kept for documenting some PDF peculiarities
@@ -159,6 +160,7 @@ enum class PdfTextExtractFlags
     IgnoreCase = 1,
     KeepWhiteTokens = 2,
     TokenizeWords = 4,
+    ReadingOrder = 8,       ///< Arrange the entries in lines and columns by their position, instead of the content order
 };
 
 enum class PdfXObjectType
@@ -190,6 +192,19 @@ enum class PdfFilterType
     Crypt
 };
 
+/**
+ * Compression level of the Flate filter, from Fastest to Best.
+ * Intermediate levels can be obtained by casting the level number
+ */
+enum class PdfCompressionLevel : int8_t
+{
+    Default = -1,              ///< Use the level of the document, or the default level of the deflate backend
+    None = 0,                  ///< Store the data without compressing it
+    Fastest = 1,
+    Best = 9,
+    Archival = 12,             ///< The slowest and best level of libdeflate. Without libdeflate it's the same as Best
+};
+
 /**
  * Enum for the font descriptor flags
  *
@@ -315,6 +330,10 @@ enum class PdfColorSpace
     DeviceN
 };
 
+/**
+ * Enum for the layouts of 8 bit per component pixels,
+ * named after the order of the components in memory
+ */
 enum class PdfPixelFormat
 {
     Unknown = 0,
@@ -322,6 +341,8 @@ enum class PdfPixelFormat
     BGRA,
     Gray,
     CMYK,
+    RGB24,
+    BGR24,
 };
 
 /**
@@ -409,9 +430,22 @@ enum class PdfHorizontalAlignment
 enum class PdfSaveOptions
 {
     None,
+    ConcurrentWrite = 1,    ///< Serialize the objects on multiple threads when the document is not encrypted nor saved incrementally. The output is the same
+    CompressObjects = 2,    ///< Pack the objects with no stream in compressed object streams. It requires an XRef stream, which is used when saving a full document
+    DeduplicateObjects = 4, ///< Write only once the identical objects, e.g. the same fonts or images of merged documents, and point the references to the written one. It's not supported by incremental updates and streamed documents
     // NOTE: Make room for some more options to come later
     NoModifyDateUpdate = 8,
     Clean = 16,
+    Linearize = 32,         ///< Write a linearized (Fast Web View) file, with the objects of the first page at the beginning. It requires a seekable device and it's not supported by incremental updates and streamed documents
+    Minimal = 64,           ///< Write the objects with no byte not required by the syntax, see PdfWriteFlags::Minimal. The output is not PDF/A compliant
+};
+
+enum class PdfLoadOptions
+{
+    None = 0,
+    FirstPageOnly = 1,      ///< When the file is linearized, load only the objects of the first-page section and defer the rest until needed
+    CollectParserStats = 2, ///< Collect the parser timings and counters, see PdfMemDocument::GetParserStats()
+    RebuildBrokenXRef = 4,  ///< Rebuild the xref entries by scanning the file when they are broken, see PdfParser::SetRebuildBrokenXRef()
 };
 
 /**
@@ -627,6 +661,7 @@ enum class PdfBlendMode
 };
 
 ENABLE_BITMASK_OPERATORS(mm::PdfSaveOptions);
+ENABLE_BITMASK_OPERATORS(mm::PdfLoadOptions);
 ENABLE_BITMASK_OPERATORS(mm::PdfWriteFlags);
 ENABLE_BITMASK_OPERATORS(mm::PdfInfoInitial);
 ENABLE_BITMASK_OPERATORS(mm::PdfFontStyle);
@@ -14,6 +14,26 @@
 using namespace std;
 using namespace mm;
 
+// The capacity of the first chunk of entries, every
+// next chunk doubles the total capacity
+static constexpr size_t FirstChunkCapacity = 4;
+
+// Above this count of keys the entries are indexed by a tree
+static constexpr size_t TreeIndexThreshold = 12;
+
+static_assert(alignof(PdfDictionaryMap::value_type) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+    "The entries must be aligned in the chunks");
+static_assert(sizeof(PdfDictionaryMap::value_type) >= sizeof(void*),
+    "The removed entries must fit the link to the next one");
+
+struct PdfDictionaryMap::Chunk final
+{
+    Chunk* Next;
+    value_type* Entries;
+    size_t Capacity;
+    size_t Used;
+};
+
 PdfDictionary::PdfDictionary() { }
 
 PdfDictionary::PdfDictionary(const PdfDictionary& rhs)
@@ -53,8 +73,8 @@ bool PdfDictionary::operator==(const PdfDictionary& rhs) const
 
 bool PdfDictionary::operator!=(const PdfDictionary& rhs) const
 {
-    if (this != &rhs)
-        return true;
+    if (this == &rhs)
+        return false;
 
     // We don't check owner
     return m_Map != rhs.m_Map;
@@ -112,7 +132,7 @@ pair<PdfDictionaryMap::iterator, bool> PdfDictionary::AddKey(const PdfName& key,
     // NOTE: Empty PdfNames are legal according to the PDF specification.
     // Don't check for it
 
-    pair<PdfDictionaryMap::iterator, bool> inserted = m_Map.try_emplace(key, std::move(obj));
+    auto inserted = m_Map.try_emplace(key, std::move(obj));
     if (!inserted.second)
     {
         if (noDirtySet)
@@ -183,11 +203,9 @@ bool PdfDictionary::HasKey(const string_view& key) const
 
 bool PdfDictionary::RemoveKey(const string_view& key)
 {
-    PdfDictionaryMap::iterator found = m_Map.find(key);
-    if (found == m_Map.end())
+    if (m_Map.erase(key) == 0)
         return false;
 
-    m_Map.erase(found);
     SetDirty();
     return true;
 }
@@ -368,3 +386,361 @@ size_t PdfDictionary::size() const
 {
     return m_Map.size();
 }
+
+PdfDictionaryMap::PdfDictionaryMap()
+    : m_chunks(nullptr), m_freeEntries(nullptr), m_size(0) { }
+
+PdfDictionaryMap::PdfDictionaryMap(const PdfDictionaryMap& rhs)
+    : PdfDictionaryMap()
+{
+    try
+    {
+        // NOTE: The keys are copied in order, so they are all appended
+        for (auto& pair : rhs)
+        {
+            if (m_size == TreeIndexThreshold)
+                buildTreeIndex();
+
+            auto entry = constructEntry(pair.first, pair.second);
+            if (m_treeIndex == nullptr)
+            {
+                getFlatIndex()[m_size] = entry;
+            }
+            else
+            {
+                try
+                {
+                    m_treeIndex->emplace_hint(m_treeIndex->end(), entry->first.GetRawData(), entry);
+                }
+                catch (...)
+                {
+                    entry->~value_type();
+                    freeEntry(entry);
+                    throw;
+                }
+            }
+
+            m_size++;
+        }
+    }
+    catch (...)
+    {
+        destroyEntries();
+        throw;
+    }
+}
+
+PdfDictionaryMap::PdfDictionaryMap(PdfDictionaryMap&& rhs) noexcept :
+    m_chunks(rhs.m_chunks),
+    m_freeEntries(rhs.m_freeEntries),
+    m_treeIndex(std::move(rhs.m_treeIndex)),
+    m_size(rhs.m_size)
+{
+    rhs.m_chunks = nullptr;
+    rhs.m_freeEntries = nullptr;
+    rhs.m_size = 0;
+}
+
+PdfDictionaryMap::~PdfDictionaryMap()
+{
+    destroyEntries();
+}
+
+PdfDictionaryMap& PdfDictionaryMap::operator=(const PdfDictionaryMap& rhs)
+{
+    if (this != &rhs)
+        *this = PdfDictionaryMap(rhs);
+
+    return *this;
+}
+
+PdfDictionaryMap& PdfDictionaryMap::operator=(PdfDictionaryMap&& rhs) noexcept
+{
+    if (this == &rhs)
+        return *this;
+
+    destroyEntries();
+    m_chunks = rhs.m_chunks;
+    m_freeEntries = rhs.m_freeEntries;
+    m_treeIndex = std::move(rhs.m_treeIndex);
+    m_size = rhs.m_size;
+    rhs.m_chunks = nullptr;
+    rhs.m_freeEntries = nullptr;
+    rhs.m_size = 0;
+    return *this;
+}
+
+bool PdfDictionaryMap::operator==(const PdfDictionaryMap& rhs) const
+{
+    if (m_size != rhs.m_size)
+        return false;
+
+    return std::equal(begin(), end(), rhs.begin(), [](const value_type& lhs, const value_type& rhs) {
+        return lhs.first == rhs.first && lhs.second == rhs.second;
+    });
+}
+
+bool PdfDictionaryMap::operator!=(const PdfDictionaryMap& rhs) const
+{
+    return !(*this == rhs);
+}
+
+pair<PdfDictionaryMap::iterator, bool> PdfDictionaryMap::try_emplace(const PdfName& key, PdfObject&& obj)
+{
+    string_view keyView = key.GetRawData();
+    if (m_treeIndex == nullptr)
+    {
+        // Keys are often added already sorted, e.g. when reading
+        // files written by this library, so the end is tried first
+        size_t index;
+        if (m_size == 0 || getFlatIndex()[m_size - 1]->first.GetRawData() < keyView)
+        {
+            index = m_size;
+        }
+        else
+        {
+            auto it = lowerBound(keyView);
+            if ((*it)->first.GetRawData() == keyView)
+                return { iterator(it), false };
+
+            index = (size_t)(it - getFlatIndex());
+        }
+
+        if (m_size < TreeIndexThreshold)
+        {
+            // NOTE: The flat index may be allocated with the entry
+            auto entry = constructEntry(key, std::move(obj));
+            auto flatIndex = getFlatIndex();
+            std::copy_backward(flatIndex + index, flatIndex + m_size, flatIndex + m_size + 1);
+            flatIndex[index] = entry;
+            m_size++;
+            return { iterator(flatIndex + index), true };
+        }
+
+        buildTreeIndex();
+    }
+
+    auto found = m_treeIndex->lower_bound(keyView);
+    if (found != m_treeIndex->end() && found->first == keyView)
+        return { iterator(TreeIndex::const_iterator(found)), false };
+
+    auto entry = constructEntry(key, std::move(obj));
+    TreeIndex::iterator inserted;
+    try
+    {
+        inserted = m_treeIndex->emplace_hint(found, entry->first.GetRawData(), entry);
+    }
+    catch (...)
+    {
+        entry->~value_type();
+        freeEntry(entry);
+        throw;
+    }
+
+    m_size++;
+    return { iterator(TreeIndex::const_iterator(inserted)), true };
+}
+
+PdfDictionaryMap::iterator PdfDictionaryMap::find(const string_view& key)
+{
+    if (m_treeIndex != nullptr)
+        return iterator(TreeIndex::const_iterator(m_treeIndex->find(key)));
+
+    auto it = lowerBound(key);
+    if (it == getFlatIndex() + m_size || (*it)->first.GetRawData() != key)
+        return end();
+
+    return iterator(it);
+}
+
+PdfDictionaryMap::const_iterator PdfDictionaryMap::find(const string_view& key) const
+{
+    return const_cast<PdfDictionaryMap&>(*this).find(key);
+}
+
+size_t PdfDictionaryMap::erase(const string_view& key)
+{
+    value_type* entry;
+    if (m_treeIndex == nullptr)
+    {
+        auto flatIndex = getFlatIndex();
+        auto it = const_cast<value_type**>(lowerBound(key));
+        if (it == flatIndex + m_size || (*it)->first.GetRawData() != key)
+            return 0;
+
+        entry = *it;
+        std::copy(it + 1, flatIndex + m_size, it);
+    }
+    else
+    {
+        auto found = m_treeIndex->find(key);
+        if (found == m_treeIndex->end())
+            return 0;
+
+        // NOTE: The tree key is a view of the entry key
+        entry = found->second;
+        m_treeIndex->erase(found);
+    }
+
+    entry->~value_type();
+    freeEntry(entry);
+    m_size--;
+    return 1;
+}
+
+void PdfDictionaryMap::clear()
+{
+    destroyEntries();
+    m_chunks = nullptr;
+    m_freeEntries = nullptr;
+    m_treeIndex.reset();
+    m_size = 0;
+}
+
+PdfDictionaryMap::iterator PdfDictionaryMap::begin()
+{
+    if (m_treeIndex == nullptr)
+        return iterator(getFlatIndex());
+    else
+        return iterator(TreeIndex::const_iterator(m_treeIndex->begin()));
+}
+
+PdfDictionaryMap::iterator PdfDictionaryMap::end()
+{
+    if (m_treeIndex == nullptr)
+        return iterator(getFlatIndex() + m_size);
+    else
+        return iterator(TreeIndex::const_iterator(m_treeIndex->end()));
+}
+
+PdfDictionaryMap::const_iterator PdfDictionaryMap::begin() const
+{
+    return const_cast<PdfDictionaryMap&>(*this).begin();
+}
+
+PdfDictionaryMap::const_iterator PdfDictionaryMap::end() const
+{
+    return const_cast<PdfDictionaryMap&>(*this).end();
+}
+
+PdfDictionaryMap::value_type** PdfDictionaryMap::getFlatIndex() const
+{
+    if (m_chunks == nullptr)
+        return nullptr;
+
+    // The flat index follows the header of the first chunk
+    return reinterpret_cast<value_type**>(reinterpret_cast<char*>(m_chunks) + sizeof(Chunk));
+}
+
+PdfDictionaryMap::value_type* const* PdfDictionaryMap::lowerBound(const string_view& key) const
+{
+    auto flatIndex = getFlatIndex();
+    return std::lower_bound(flatIndex, flatIndex + m_size, key,
+        [](const value_type* entry, const string_view& key) {
+            return entry->first.GetRawData() < key;
+        });
+}
+
+template <typename TObject>
+PdfDictionaryMap::value_type* PdfDictionaryMap::constructEntry(const PdfName& key, TObject&& obj)
+{
+    // Reuse the entries of the removed keys first
+    if (m_freeEntries != nullptr)
+    {
+        auto entry = m_freeEntries;
+        m_freeEntries = *std::launder(reinterpret_cast<value_type**>(entry));
+        try
+        {
+            return new(entry) value_type(key, std::forward<TObject>(obj));
+        }
+        catch (...)
+        {
+            freeEntry(entry);
+            throw;
+        }
+    }
+
+    Chunk* chunk = m_chunks == nullptr || m_chunks->Next == nullptr ? m_chunks : m_chunks->Next;
+    if (chunk == nullptr || chunk->Used == chunk->Capacity)
+    {
+        size_t offset;
+        size_t capacity;
+        if (chunk == nullptr)
+        {
+            offset = sizeof(Chunk) + TreeIndexThreshold * sizeof(value_type*);
+            capacity = FirstChunkCapacity;
+        }
+        else
+        {
+            offset = sizeof(Chunk);
+            capacity = chunk == m_chunks ? chunk->Capacity : chunk->Capacity * 2;
+        }
+
+        offset = (offset + alignof(value_type) - 1) / alignof(value_type) * alignof(value_type);
+        char* buffer = new char[offset + capacity * sizeof(value_type)];
+        chunk = new(buffer) Chunk{ nullptr, reinterpret_cast<value_type*>(buffer + offset), capacity, 0 };
+        if (m_chunks == nullptr)
+        {
+            m_chunks = chunk;
+        }
+        else
+        {
+            chunk->Next = m_chunks->Next;
+            m_chunks->Next = chunk;
+        }
+    }
+
+    auto entry = new(chunk->Entries + chunk->Used) value_type(key, std::forward<TObject>(obj));
+    chunk->Used++;
+    return entry;
+}
+
+void PdfDictionaryMap::freeEntry(value_type* entry)
+{
+    new(entry) value_type*(m_freeEntries);
+    m_freeEntries = entry;
+}
+
+void PdfDictionaryMap::buildTreeIndex()
+{
+    auto treeIndex = std::make_unique<TreeIndex>();
+    auto flatIndex = getFlatIndex();
+    for (size_t i = 0; i < m_size; i++)
+        treeIndex->emplace_hint(treeIndex->end(), flatIndex[i]->first.GetRawData(), flatIndex[i]);
+
+    m_treeIndex = std::move(treeIndex);
+}
+
+void PdfDictionaryMap::destroyEntries()
+{
+    for (auto& pair : *this)
+        pair.~value_type();
+
+    Chunk* chunk = m_chunks;
+    while (chunk != nullptr)
+    {
+        Chunk* next = chunk->Next;
+        delete[] reinterpret_cast<char*>(chunk);
+        chunk = next;
+    }
+}
+
+size_t PdfDictionaryMap::getMemoryUsage() const
+{
+    size_t usage = 0;
+    for (Chunk* chunk = m_chunks; chunk != nullptr; chunk = chunk->Next)
+    {
+        usage += (size_t)(reinterpret_cast<char*>(chunk->Entries) - reinterpret_cast<char*>(chunk))
+            + chunk->Capacity * sizeof(value_type);
+    }
+
+    if (m_treeIndex != nullptr)
+    {
+        // NOTE: The nodes of the tree hold also the
+        // links of the tree, that are about 4 pointers
+        usage += sizeof(TreeIndex) + m_treeIndex->size()
+            * (sizeof(TreeIndex::value_type) + 4 * sizeof(void*));
+    }
+
+    return usage;
+}
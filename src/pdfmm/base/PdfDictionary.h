@@ -18,27 +18,153 @@ namespace mm {
 
 class PdfDictionary;
 
-// Compartor to enable heterogeneous lookup in
-// PdfDictionary with both PdfName and string_view
-// See https://stackoverflow.com/a/31924435/213871
-struct PdfDictionaryComparator final
+/** The storage of the keys and values of a dictionary, iterated
+ * sorted by key like a std::map
+ *
+ * Most dictionaries have few keys, so the entries are constructed in
+ * chunks of growing capacity and searched in a flat index of pointers
+ * sorted by key, that is allocated together with the first chunk.
+ * Above a threshold of keys the entries are indexed by a tree instead.
+ * The entries keep their address when other keys are added or removed,
+ * as the objects of the document hold references to the values of
+ * dictionaries, e.g. the resources of a page
+ */
+class PDFMM_API PdfDictionaryMap final
 {
-    using is_transparent = std::true_type;
-    bool operator()(const PdfName& lhs, const PdfName& rhs) const
-    {
-        return lhs < rhs;
-    }
-    bool operator()(const PdfName& lhs, const std::string_view& rhs) const
-    {
-        return lhs.GetRawData() < rhs;
-    }
-    bool operator()(const std::string_view& lhs, const PdfName& rhs) const
+    friend class PdfObject;
+
+public:
+    using value_type = std::pair<const PdfName, PdfObject>;
+
+private:
+    using TreeIndex = std::map<std::string_view, value_type*, std::less<>>;
+
+public:
+    template <typename TValue>
+    class Iterator final
     {
-        return lhs < rhs.GetRawData();
-    }
-};
+        friend class PdfDictionaryMap;
+        template <typename> friend class Iterator;
+    public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::remove_const_t<TValue>;
+        using pointer = TValue*;
+        using reference = TValue&;
+        using iterator_category = std::bidirectional_iterator_tag;
+    public:
+        Iterator() : m_flatIt(nullptr), m_isTree(false) { }
+        template <typename TOtherValue>
+        Iterator(const Iterator<TOtherValue>& it)
+            : m_flatIt(it.m_flatIt), m_treeIt(it.m_treeIt), m_isTree(it.m_isTree) { }
+    private:
+        Iterator(PdfDictionaryMap::value_type* const* it)
+            : m_flatIt(it), m_isTree(false) { }
+        Iterator(const TreeIndex::const_iterator& it)
+            : m_flatIt(nullptr), m_treeIt(it), m_isTree(true) { }
+    public:
+        reference operator*() const { return *get(); }
+        pointer operator->() const { return get(); }
+        bool operator==(const Iterator& rhs) const
+        {
+            return m_isTree ? m_treeIt == rhs.m_treeIt : m_flatIt == rhs.m_flatIt;
+        }
+        bool operator!=(const Iterator& rhs) const { return !(*this == rhs); }
+        Iterator& operator++()
+        {
+            if (m_isTree)
+                m_treeIt++;
+            else
+                m_flatIt++;
+
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator ret = *this;
+            ++(*this);
+            return ret;
+        }
+        Iterator& operator--()
+        {
+            if (m_isTree)
+                m_treeIt--;
+            else
+                m_flatIt--;
+
+            return *this;
+        }
+        Iterator operator--(int)
+        {
+            Iterator ret = *this;
+            --(*this);
+            return ret;
+        }
+    private:
+        pointer get() const { return m_isTree ? m_treeIt->second : *m_flatIt; }
+    private:
+        PdfDictionaryMap::value_type* const* m_flatIt;
+        TreeIndex::const_iterator m_treeIt;
+        bool m_isTree;
+    };
+
+    using iterator = Iterator<value_type>;
+    using const_iterator = Iterator<const value_type>;
+
+public:
+    PdfDictionaryMap();
+    PdfDictionaryMap(const PdfDictionaryMap& rhs);
+    PdfDictionaryMap(PdfDictionaryMap&& rhs) noexcept;
+    ~PdfDictionaryMap();
+
+    PdfDictionaryMap& operator=(const PdfDictionaryMap& rhs);
+    PdfDictionaryMap& operator=(PdfDictionaryMap&& rhs) noexcept;
+
+    bool operator==(const PdfDictionaryMap& rhs) const;
+    bool operator!=(const PdfDictionaryMap& rhs) const;
+
+    /** Insert a key with the given value, if the key is missing
+     *  \returns the entry of the key and true if it was inserted.
+     *      The value is moved only if the key is inserted
+     */
+    std::pair<iterator, bool> try_emplace(const PdfName& key, PdfObject&& obj);
+
+    iterator find(const std::string_view& key);
+    const_iterator find(const std::string_view& key) const;
+
+    /** Remove the given key
+     *  \returns the count of the removed entries, 0 or 1
+     */
+    size_t erase(const std::string_view& key);
 
-using PdfDictionaryMap = std::map<PdfName, PdfObject, PdfDictionaryComparator>;
+    void clear();
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+private:
+    struct Chunk;
+    value_type** getFlatIndex() const;
+    value_type* const* lowerBound(const std::string_view& key) const;
+    template <typename TObject>
+    value_type* constructEntry(const PdfName& key, TObject&& obj);
+    void freeEntry(value_type* entry);
+    void buildTreeIndex();
+    void destroyEntries();
+    size_t getMemoryUsage() const;
+
+private:
+    // The first chunk, that holds also the flat index, followed
+    // by the other chunks from the last allocated one
+    Chunk* m_chunks;
+    // The removed entries, linked through their storage
+    value_type* m_freeEntries;
+    std::unique_ptr<TreeIndex> m_treeIndex;
+    size_t m_size;
+};
 
 /**
  * Helper class to iterate through indirect objects
@@ -28,12 +28,20 @@ using namespace mm;
 // specification and attempt to implement it better
 // https://github.com/adobe-type-tools/agl-specification
 // https://github.com/adobe-type-tools/agl-aglfn/
-static struct
+namespace
 {
-    char32_t u;
-    const char* name;
-} nameToUnicodeTab[] = {
+    struct CodePointName
+    {
+        char32_t u;
+        const char* name;
+    };
+}
+
+// NOTE: The table is sorted by name, so the names are searched in it
+// with a binary search. The order is checked at compile time below
+static constexpr CodePointName nameToUnicodeTab[] = {
   {0x0021, "!"},
+  {0x0022, "\""},
   {0x0023, "#"},
   {0x0024, "$"},
   {0x0025, "%"},
@@ -358,13 +366,213 @@ static struct
   {0x017b, "Zdotaccent"},
   {0x0396, "Zeta"},
   {0x005a, "Zsmall"},
-  {0x0022, "\""},
   {0x005c, "\\"},
   {0x005d, "]"},
   {0x005e, "^"},
   {0x005f, "_"},
   {0x0060, "`"},
   {0x0061, "a"},
+  {0x2701, "a1"},
+  {0x2721, "a10"},
+  {0x275E, "a100"},
+  {0x2761, "a101"},
+  {0x2762, "a102"},
+  {0x2763, "a103"},
+  {0x2764, "a104"},
+  {0x2710, "a105"},
+  {0x2765, "a106"},
+  {0x2766, "a107"},
+  {0x2767, "a108"},
+  {0x2660, "a109"},
+  {0x261B, "a11"},
+  {0x2665, "a110"},
+  {0x2666, "a111"},
+  {0x2663, "a112"},
+  {0x2709, "a117"},
+  {0x2708, "a118"},
+  {0x2707, "a119"},
+  {0x261E, "a12"},
+  {0x2460, "a120"},
+  {0x2461, "a121"},
+  {0x2462, "a122"},
+  {0x2463, "a123"},
+  {0x2464, "a124"},
+  {0x2465, "a125"},
+  {0x2466, "a126"},
+  {0x2467, "a127"},
+  {0x2468, "a128"},
+  {0x2469, "a129"},
+  {0x270C, "a13"},
+  {0x2776, "a130"},
+  {0x2777, "a131"},
+  {0x2778, "a132"},
+  {0x2779, "a133"},
+  {0x277A, "a134"},
+  {0x277B, "a135"},
+  {0x277C, "a136"},
+  {0x277D, "a137"},
+  {0x277E, "a138"},
+  {0x277F, "a139"},
+  {0x270D, "a14"},
+  {0x2780, "a140"},
+  {0x2781, "a141"},
+  {0x2782, "a142"},
+  {0x2783, "a143"},
+  {0x2784, "a144"},
+  {0x2785, "a145"},
+  {0x2786, "a146"},
+  {0x2787, "a147"},
+  {0x2788, "a148"},
+  {0x2789, "a149"},
+  {0x270E, "a15"},
+  {0x278A, "a150"},
+  {0x278B, "a151"},
+  {0x278C, "a152"},
+  {0x278D, "a153"},
+  {0x278E, "a154"},
+  {0x278F, "a155"},
+  {0x2790, "a156"},
+  {0x2791, "a157"},
+  {0x2792, "a158"},
+  {0x2793, "a159"},
+  {0x270F, "a16"},
+  {0x2794, "a160"},
+  {0x2192, "a161"},
+  {0x27A3, "a162"},
+  {0x2194, "a163"},
+  {0x2195, "a164"},
+  {0x2799, "a165"},
+  {0x279B, "a166"},
+  {0x279C, "a167"},
+  {0x279D, "a168"},
+  {0x279E, "a169"},
+  {0x2711, "a17"},
+  {0x279F, "a170"},
+  {0x27A0, "a171"},
+  {0x27A1, "a172"},
+  {0x27A2, "a173"},
+  {0x27A4, "a174"},
+  {0x27A5, "a175"},
+  {0x27A6, "a176"},
+  {0x27A7, "a177"},
+  {0x27A8, "a178"},
+  {0x27A9, "a179"},
+  {0x2712, "a18"},
+  {0x27AB, "a180"},
+  {0x27AD, "a181"},
+  {0x27AF, "a182"},
+  {0x27B2, "a183"},
+  {0x27B3, "a184"},
+  {0x27B5, "a185"},
+  {0x27B8, "a186"},
+  {0x27BA, "a187"},
+  {0x27BB, "a188"},
+  {0x27BC, "a189"},
+  {0x2713, "a19"},
+  {0x27BD, "a190"},
+  {0x27BE, "a191"},
+  {0x279A, "a192"},
+  {0x27AA, "a193"},
+  {0x27B6, "a194"},
+  {0x27B9, "a195"},
+  {0x2798, "a196"},
+  {0x27B4, "a197"},
+  {0x27B7, "a198"},
+  {0x27AC, "a199"},
+  {0x2702, "a2"},
+  {0x2714, "a20"},
+  {0x27AE, "a200"},
+  {0x27B1, "a201"},
+  {0x2703, "a202"},
+  {0x2750, "a203"},
+  {0x2752, "a204"},
+  {0x276E, "a205"},
+  {0x2770, "a206"},
+  {0x2715, "a21"},
+  {0x2716, "a22"},
+  {0x2717, "a23"},
+  {0x2718, "a24"},
+  {0x2719, "a25"},
+  {0x271A, "a26"},
+  {0x271B, "a27"},
+  {0x271C, "a28"},
+  {0x2722, "a29"},
+  {0x2704, "a3"},
+  {0x2723, "a30"},
+  {0x2724, "a31"},
+  {0x2725, "a32"},
+  {0x2726, "a33"},
+  {0x2727, "a34"},
+  {0x2605, "a35"},
+  {0x2729, "a36"},
+  {0x272A, "a37"},
+  {0x272B, "a38"},
+  {0x272C, "a39"},
+  {0x260E, "a4"},
+  {0x272D, "a40"},
+  {0x272E, "a41"},
+  {0x272F, "a42"},
+  {0x2730, "a43"},
+  {0x2731, "a44"},
+  {0x2732, "a45"},
+  {0x2733, "a46"},
+  {0x2734, "a47"},
+  {0x2735, "a48"},
+  {0x2736, "a49"},
+  {0x2706, "a5"},
+  {0x2737, "a50"},
+  {0x2738, "a51"},
+  {0x2739, "a52"},
+  {0x273A, "a53"},
+  {0x273B, "a54"},
+  {0x273C, "a55"},
+  {0x273D, "a56"},
+  {0x273E, "a57"},
+  {0x273F, "a58"},
+  {0x2740, "a59"},
+  {0x271D, "a6"},
+  {0x2741, "a60"},
+  {0x2742, "a61"},
+  {0x2743, "a62"},
+  {0x2744, "a63"},
+  {0x2745, "a64"},
+  {0x2746, "a65"},
+  {0x2747, "a66"},
+  {0x2748, "a67"},
+  {0x2749, "a68"},
+  {0x274A, "a69"},
+  {0x271E, "a7"},
+  {0x274B, "a70"},
+  {0x25CF, "a71"},
+  {0x274D, "a72"},
+  {0x25A0, "a73"},
+  {0x274F, "a74"},
+  {0x2751, "a75"},
+  {0x25B2, "a76"},
+  {0x25BC, "a77"},
+  {0x25C6, "a78"},
+  {0x2756, "a79"},
+  {0x271F, "a8"},
+  {0x25D7, "a81"},
+  {0x2758, "a82"},
+  {0x2759, "a83"},
+  {0x275A, "a84"},
+  {0x276F, "a85"},
+  {0x2771, "a86"},
+  {0x2772, "a87"},
+  {0x2773, "a88"},
+  {0x2768, "a89"},
+  {0x2720, "a9"},
+  {0x2769, "a90"},
+  {0x276C, "a91"},
+  {0x276D, "a92"},
+  {0x276A, "a93"},
+  {0x276B, "a94"},
+  {0x2774, "a95"},
+  {0x2775, "a96"},
+  {0x275B, "a97"},
+  {0x275C, "a98"},
+  {0x275D, "a99"},
   {0x00e1, "aacute"},
   {0x0103, "abreve"},
   {0x00e2, "acircumflex"},
@@ -779,15 +987,16 @@ static struct
   {0x0021, "exclamsmall"},
   {0x2203, "existential"},
   {0x0066, "f"},
-  {0xfb00, "ff"},
-  {0xfb03, "ffi"},
-  {0xfb04, "ffl"},
-  {0xfb01, "fi"},
   {0xfb00, "f_f"},
   {0xfb03, "f_f_i"},
   {0xfb04, "f_f_l"},
   {0xfb01, "f_i"},
+  {0xfb02, "f_l"},
   {0x2640, "female"},
+  {0xfb00, "ff"},
+  {0xfb03, "ffi"},
+  {0xfb04, "ffl"},
+  {0xfb01, "fi"},
   {0x2012, "figuredash"},
   {0x25a0, "filledbox"},
   {0x25ac, "filledrect"},
@@ -797,7 +1006,6 @@ static struct
   {0x0035, "fiveoldstyle"},
   {0x2075, "fivesuperior"},
   {0xfb02, "fl"},
-  {0xfb02, "f_l"},
   {0x0192, "florin"},
   {0x0034, "four"},
   {0x2084, "fourinferior"},
@@ -1121,215 +1329,11 @@ static struct
   {0x007c, "|"},
   {0x007d, "}"},
   {0x007e, "~"},
-  // https://github.com/adobe-type-tools/agl-aglfn/blob/master/zapfdingbats.txt
-  {0x275E, "a100"},
-  {0x2761, "a101"},
-  {0x2762, "a102"},
-  {0x2763, "a103"},
-  {0x2764, "a104"},
-  {0x2710, "a105"},
-  {0x2765, "a106"},
-  {0x2766, "a107"},
-  {0x2767, "a108"},
-  {0x2660, "a109"},
-  {0x2721, "a10"},
-  {0x2665, "a110"},
-  {0x2666, "a111"},
-  {0x2663, "a112"},
-  {0x2709, "a117"},
-  {0x2708, "a118"},
-  {0x2707, "a119"},
-  {0x261B, "a11"},
-  {0x2460, "a120"},
-  {0x2461, "a121"},
-  {0x2462, "a122"},
-  {0x2463, "a123"},
-  {0x2464, "a124"},
-  {0x2465, "a125"},
-  {0x2466, "a126"},
-  {0x2467, "a127"},
-  {0x2468, "a128"},
-  {0x2469, "a129"},
-  {0x261E, "a12"},
-  {0x2776, "a130"},
-  {0x2777, "a131"},
-  {0x2778, "a132"},
-  {0x2779, "a133"},
-  {0x277A, "a134"},
-  {0x277B, "a135"},
-  {0x277C, "a136"},
-  {0x277D, "a137"},
-  {0x277E, "a138"},
-  {0x277F, "a139"},
-  {0x270C, "a13"},
-  {0x2780, "a140"},
-  {0x2781, "a141"},
-  {0x2782, "a142"},
-  {0x2783, "a143"},
-  {0x2784, "a144"},
-  {0x2785, "a145"},
-  {0x2786, "a146"},
-  {0x2787, "a147"},
-  {0x2788, "a148"},
-  {0x2789, "a149"},
-  {0x270D, "a14"},
-  {0x278A, "a150"},
-  {0x278B, "a151"},
-  {0x278C, "a152"},
-  {0x278D, "a153"},
-  {0x278E, "a154"},
-  {0x278F, "a155"},
-  {0x2790, "a156"},
-  {0x2791, "a157"},
-  {0x2792, "a158"},
-  {0x2793, "a159"},
-  {0x270E, "a15"},
-  {0x2794, "a160"},
-  {0x2192, "a161"},
-  {0x27A3, "a162"},
-  {0x2194, "a163"},
-  {0x2195, "a164"},
-  {0x2799, "a165"},
-  {0x279B, "a166"},
-  {0x279C, "a167"},
-  {0x279D, "a168"},
-  {0x279E, "a169"},
-  {0x270F, "a16"},
-  {0x279F, "a170"},
-  {0x27A0, "a171"},
-  {0x27A1, "a172"},
-  {0x27A2, "a173"},
-  {0x27A4, "a174"},
-  {0x27A5, "a175"},
-  {0x27A6, "a176"},
-  {0x27A7, "a177"},
-  {0x27A8, "a178"},
-  {0x27A9, "a179"},
-  {0x2711, "a17"},
-  {0x27AB, "a180"},
-  {0x27AD, "a181"},
-  {0x27AF, "a182"},
-  {0x27B2, "a183"},
-  {0x27B3, "a184"},
-  {0x27B5, "a185"},
-  {0x27B8, "a186"},
-  {0x27BA, "a187"},
-  {0x27BB, "a188"},
-  {0x27BC, "a189"},
-  {0x2712, "a18"},
-  {0x27BD, "a190"},
-  {0x27BE, "a191"},
-  {0x279A, "a192"},
-  {0x27AA, "a193"},
-  {0x27B6, "a194"},
-  {0x27B9, "a195"},
-  {0x2798, "a196"},
-  {0x27B4, "a197"},
-  {0x27B7, "a198"},
-  {0x27AC, "a199"},
-  {0x2713, "a19"},
-  {0x2701, "a1"},
-  {0x27AE, "a200"},
-  {0x27B1, "a201"},
-  {0x2703, "a202"},
-  {0x2750, "a203"},
-  {0x2752, "a204"},
-  {0x276E, "a205"},
-  {0x2770, "a206"},
-  {0x2714, "a20"},
-  {0x2715, "a21"},
-  {0x2716, "a22"},
-  {0x2717, "a23"},
-  {0x2718, "a24"},
-  {0x2719, "a25"},
-  {0x271A, "a26"},
-  {0x271B, "a27"},
-  {0x271C, "a28"},
-  {0x2722, "a29"},
-  {0x2702, "a2"},
-  {0x2723, "a30"},
-  {0x2724, "a31"},
-  {0x2725, "a32"},
-  {0x2726, "a33"},
-  {0x2727, "a34"},
-  {0x2605, "a35"},
-  {0x2729, "a36"},
-  {0x272A, "a37"},
-  {0x272B, "a38"},
-  {0x272C, "a39"},
-  {0x2704, "a3"},
-  {0x272D, "a40"},
-  {0x272E, "a41"},
-  {0x272F, "a42"},
-  {0x2730, "a43"},
-  {0x2731, "a44"},
-  {0x2732, "a45"},
-  {0x2733, "a46"},
-  {0x2734, "a47"},
-  {0x2735, "a48"},
-  {0x2736, "a49"},
-  {0x260E, "a4"},
-  {0x2737, "a50"},
-  {0x2738, "a51"},
-  {0x2739, "a52"},
-  {0x273A, "a53"},
-  {0x273B, "a54"},
-  {0x273C, "a55"},
-  {0x273D, "a56"},
-  {0x273E, "a57"},
-  {0x273F, "a58"},
-  {0x2740, "a59"},
-  {0x2706, "a5"},
-  {0x2741, "a60"},
-  {0x2742, "a61"},
-  {0x2743, "a62"},
-  {0x2744, "a63"},
-  {0x2745, "a64"},
-  {0x2746, "a65"},
-  {0x2747, "a66"},
-  {0x2748, "a67"},
-  {0x2749, "a68"},
-  {0x274A, "a69"},
-  {0x271D, "a6"},
-  {0x274B, "a70"},
-  {0x25CF, "a71"},
-  {0x274D, "a72"},
-  {0x25A0, "a73"},
-  {0x274F, "a74"},
-  {0x2751, "a75"},
-  {0x25B2, "a76"},
-  {0x25BC, "a77"},
-  {0x25C6, "a78"},
-  {0x2756, "a79"},
-  {0x271E, "a7"},
-  {0x25D7, "a81"},
-  {0x2758, "a82"},
-  {0x2759, "a83"},
-  {0x275A, "a84"},
-  {0x276F, "a85"},
-  {0x2771, "a86"},
-  {0x2772, "a87"},
-  {0x2773, "a88"},
-  {0x2768, "a89"},
-  {0x271F, "a8"},
-  {0x2769, "a90"},
-  {0x276C, "a91"},
-  {0x276D, "a92"},
-  {0x276A, "a93"},
-  {0x276B, "a94"},
-  {0x2774, "a95"},
-  {0x2775, "a96"},
-  {0x275B, "a97"},
-  {0x275C, "a98"},
-  {0x275D, "a99"},
-  {0x2720, "a9"},
-  { 0, nullptr }
 };
 
-static struct {
-    char32_t u;
-    const char* name;
-} UnicodeToNameTab[] = {
+// NOTE: The table is sorted by code point, so the code points are
+// searched in it with a binary search
+static constexpr CodePointName UnicodeToNameTab[] = {
     {0x0000, ".notdef"},
     {0x0020, "space"},
     {0x0021, "exclam"},
@@ -2382,9 +2386,35 @@ static struct {
     {0xFB2B, "afii57695"},
     {0xFB35, "afii57723"},
     {0xFB4B, "afii57700"},
-    {0xFFFF, nullptr}
 };
 
+static constexpr bool isSortedByName(const CodePointName* table, size_t size)
+{
+    for (size_t i = 1; i < size; i++)
+    {
+        if (string_view(table[i - 1].name) >= string_view(table[i].name))
+            return false;
+    }
+
+    return true;
+}
+
+static constexpr bool isSortedByCodePoint(const CodePointName* table, size_t size)
+{
+    for (size_t i = 1; i < size; i++)
+    {
+        if (table[i - 1].u >= table[i].u)
+            return false;
+    }
+
+    return true;
+}
+
+static_assert(isSortedByName(nameToUnicodeTab, std::size(nameToUnicodeTab)),
+    "The glyph names must be sorted");
+static_assert(isSortedByCodePoint(UnicodeToNameTab, std::size(UnicodeToNameTab)),
+    "The canonical code points must be sorted");
+
 PdfDifferenceList::PdfDifferenceList() { }
 
 void PdfDifferenceList::AddDifference(unsigned char code, char32_t codePoint)
@@ -2651,11 +2681,12 @@ char32_t PdfDifferenceEncoding::NameToCodePoint(const PdfName& name)
 
 char32_t PdfDifferenceEncoding::NameToCodePoint(const string_view& name)
 {
-    for (unsigned i = 0; nameToUnicodeTab[i].name != nullptr; i++)
-    {
-        if (nameToUnicodeTab[i].name == name)
-            return nameToUnicodeTab[i].u;
-    }
+    auto found = std::lower_bound(std::begin(nameToUnicodeTab), std::end(nameToUnicodeTab), name,
+        [](const CodePointName& entry, const string_view& name) {
+            return string_view(entry.name) < name;
+        });
+    if (found != std::end(nameToUnicodeTab) && found->name == name)
+        return found->u;
 
     // if we get here, then we might be looking up an undefined codepoint
     // so try looking for our special format..
@@ -2675,17 +2706,20 @@ char32_t PdfDifferenceEncoding::NameToCodePoint(const string_view& name)
 
 PdfName PdfDifferenceEncoding::CodePointToName(char32_t inCodePoint)
 {
-    for (unsigned i = 0; UnicodeToNameTab[i].name; i++)
-    {
-        if (UnicodeToNameTab[i].u == inCodePoint)
-            return PdfName(UnicodeToNameTab[i].name);
-    }
+    auto found = std::lower_bound(std::begin(UnicodeToNameTab), std::end(UnicodeToNameTab), inCodePoint,
+        [](const CodePointName& entry, char32_t codePoint) {
+            return entry.u < codePoint;
+        });
+    if (found != std::end(UnicodeToNameTab) && found->u == inCodePoint)
+        return PdfName(found->name);
 
-    // if we can't find in the canonical list, look in the complete list
-    for (unsigned i = 0; nameToUnicodeTab[i].name; i++)
+    // if we can't find in the canonical list, look in the complete list.
+    // NOTE: No code point missing in the canonical list has more than
+    // one name, so the order of the complete list doesn't matter
+    for (auto& entry : nameToUnicodeTab)
     {
-        if (nameToUnicodeTab[i].u == inCodePoint)
-            return PdfName(nameToUnicodeTab[i].name);
+        if (entry.u == inCodePoint)
+            return PdfName(entry.name);
     }
 
     // if we get here, then we are looking up an undefined codepoint
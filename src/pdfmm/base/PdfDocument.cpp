@@ -8,16 +8,19 @@
 
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include <pdfmm/private/XMPUtils.h>
+#include <pdfmm/private/PdfFiltersPrivate.h>
 #include "PdfDocument.h"
 
 #include <algorithm>
 #include <deque>
+#include <unordered_set>
 
 #include "PdfArray.h"
 #include "PdfDictionary.h"
 #include "PdfImmediateWriter.h"
 #include "PdfObject.h"
 #include "PdfObjectStream.h"
+#include "PdfObjectWalker.h"
 #include "PdfIndirectObjectList.h"
 #include "PdfAcroForm.h"
 #include "PdfDestination.h"
@@ -27,41 +30,46 @@
 #include "PdfInfo.h"
 #include "PdfNameTree.h"
 #include "PdfOutlines.h"
+#include "PdfImage.h"
 #include "PdfPage.h"
+#include "PdfPainter.h"
 #include "PdfPageCollection.h"
 #include "PdfXObject.h"
+#include "PdfContentsReader.h"
+#include "PdfExecutor.h"
 
 using namespace std;
 using namespace mm;
 
-PdfDocument::PdfDocument(bool empty) :
+static void preloadFonts(PdfFontManager& fontManager, const PdfCanvas& canvas);
+static vector<unsigned> getPageIndices(const PdfPageCollection& collection, const cspan<unsigned>& pages);
+#ifdef PDFMM_HAVE_TIFF_LIB
+static double getTiffScale(TIFF* tiff, ttag_t resolutionTag);
+#endif // PDFMM_HAVE_TIFF_LIB
+static void pruneFields(PdfIndirectObjectList& objects, PdfArray& fields, unordered_set<PdfReference>& visited);
+
+PdfDocument::PdfDocument(bool empty, pmr::memory_resource* resource) :
+    m_TraceSink(nullptr),
+    m_MemoryResource(resource),
     m_Objects(*this),
     m_Metadata(*this),
-    m_FontManager(*this)
+    m_FontManager(*this),
+    m_ImageManager(*this),
+    m_CompressionLevel(PdfCompressionLevel::Default)
 {
     if (!empty)
-    {
-        m_TrailerObj.reset(new PdfObject()); // The trailer is NO part of the vector of objects
-        m_TrailerObj->SetDocument(this);
-        auto catalog = m_Objects.CreateDictionaryObject("Catalog");
-        m_Trailer.reset(new PdfTrailer(*m_TrailerObj));
-
-        m_Catalog.reset(new PdfCatalog(*catalog));
-        m_TrailerObj->GetDictionary().AddKeyIndirect("Root", catalog);
-
-        auto info = m_Objects.CreateDictionaryObject();
-        m_Info.reset(new PdfInfo(*info,
-            PdfInfoInitial::WriteProducer | PdfInfoInitial::WriteCreationTime));
-        m_TrailerObj->GetDictionary().AddKeyIndirect("Info", info);
-
-        Init();
-    }
+        InitEmpty();
 }
 
 PdfDocument::PdfDocument(const PdfDocument& doc) :
+    m_TraceSink(doc.m_TraceSink),
+    m_MemoryResource(doc.m_MemoryResource),
+    m_Executor(doc.m_Executor),
     m_Objects(*this, doc.m_Objects),
     m_Metadata(*this),
-    m_FontManager(*this)
+    m_FontManager(*this),
+    m_ImageManager(*this),
+    m_CompressionLevel(doc.m_CompressionLevel)
 {
     SetTrailer(std::make_unique<PdfObject>(doc.GetTrailer().GetObject()));
     Init();
@@ -74,11 +82,42 @@ PdfDocument::~PdfDocument()
 
 void PdfDocument::Clear() 
 {
+    // NOTE: Drop the wrappers of the objects first, so a document
+    // loaded again doesn't keep the ones of the previous document
+    m_Metadata.Invalidate();
+    m_Outlines = nullptr;
+    m_AcroForm = nullptr;
+    m_NameTree = nullptr;
+    m_Pages = nullptr;
+    m_Info = nullptr;
+    m_Catalog = nullptr;
+    m_Trailer = nullptr;
+    m_TrailerObj = nullptr;
     m_FontManager.Clear();
+    m_ImageManager.Clear();
     m_Objects.Clear();
     m_Objects.SetCanReuseObjectNumbers(true);
 }
 
+void PdfDocument::InitEmpty()
+{
+    PdfMemoryResourceScope scope(m_MemoryResource);
+    m_TrailerObj.reset(new PdfObject()); // The trailer is NO part of the vector of objects
+    m_TrailerObj->SetDocument(this);
+    auto catalog = m_Objects.CreateDictionaryObject("Catalog");
+    m_Trailer.reset(new PdfTrailer(*m_TrailerObj));
+
+    m_Catalog.reset(new PdfCatalog(*catalog));
+    m_TrailerObj->GetDictionary().AddKeyIndirect("Root", catalog);
+
+    auto info = m_Objects.CreateDictionaryObject();
+    m_Info.reset(new PdfInfo(*info,
+        PdfInfoInitial::WriteProducer | PdfInfoInitial::WriteCreationTime));
+    m_TrailerObj->GetDictionary().AddKeyIndirect("Info", info);
+
+    Init();
+}
+
 void PdfDocument::Init()
 {
     auto pagesRootObj = m_Catalog->GetDictionary().FindKey("Pages");
@@ -393,47 +432,188 @@ PdfRect PdfDocument::FillXObjectFromPage(PdfXObject& xobj, const PdfPage& page,
 
 void PdfDocument::FixObjectReferences(PdfObject& obj, int difference)
 {
-    if (obj.IsDictionary())
+    // The references are not followed, only the direct values are walked
+    PdfMutableObjectWalker walker;
+    walker.Walk(obj, [difference](PdfObject& value, const PdfName*)
     {
-        for (auto& pair : obj.GetDictionary())
+        if (value.IsReference())
         {
-            if (pair.second.IsReference())
-            {
-                pair.second = PdfObject(PdfReference(pair.second.GetReference().ObjectNumber() + difference,
-                    pair.second.GetReference().GenerationNumber()));
-            }
-            else if (pair.second.IsDictionary() ||
-                pair.second.IsArray())
-            {
-                FixObjectReferences(pair.second, difference);
-            }
+            value = PdfObject(PdfReference(value.GetReference().ObjectNumber() + difference,
+                value.GetReference().GenerationNumber()));
         }
+
+        return PdfWalkAction::Continue;
+    });
+}
+
+void PdfDocument::CollectGarbage()
+{
+    m_Objects.CollectGarbage();
+}
+
+vector<vector<PdfTextEntry>> PdfDocument::ExtractText(const cspan<unsigned>& pages,
+    const PdfTextExtractParams& params, unsigned threadCount)
+{
+    // NOTE: Access the pages through the const collection,
+    // which is safe to read concurrently from frozen documents
+    const auto& collection = const_cast<const PdfPageCollection&>(*m_Pages);
+    auto indices = getPageIndices(collection, pages);
+
+    // Share the XObject forms between all the pages
+    auto actualParams = params;
+    if (actualParams.ContentsCache == nullptr)
+        actualParams.ContentsCache = std::make_shared<PdfContentsCache>();
+
+    vector<vector<PdfTextEntry>> ret(indices.size());
+    auto executor = GetExecutor();
+    if (threadCount == 0)
+        threadCount = executor->GetConcurrency();
+
+    threadCount = std::min(threadCount, (unsigned)indices.size());
+    if (threadCount > 1 && TryFreeze())
+    {
+        // Load the fonts of the pages upfront, so the
+        // threads find them already in the cache
+        for (unsigned index : indices)
+            preloadFonts(m_FontManager, collection.GetPage(index));
     }
-    else if (obj.IsArray())
+    else
     {
-        for (auto& child : obj.GetArray())
+        threadCount = 1;
+    }
+
+    executor->ParallelFor(indices.size(), 1, threadCount, [&]()
+    {
+        return [&](size_t i)
         {
-            if (child.IsReference())
-            {
-                child = PdfObject(PdfReference(child.GetReference().ObjectNumber() + difference,
-                    child.GetReference().GenerationNumber()));
-            }
-            else if (child.IsDictionary() || child.IsArray())
+            collection.GetPage(indices[i]).ExtractTextTo(ret[i], actualParams);
+        };
+    });
+
+    return ret;
+}
+
+void PdfDocument::PaintPages(const cspan<unsigned>& pages,
+    const function<void(PdfPage& page, unsigned index)>& paint, unsigned threadCount)
+{
+    auto indices = getPageIndices(*m_Pages, pages);
+
+    // Retrieve the pages upfront, so the page
+    // cache is not filled concurrently
+    vector<PdfPage*> canvases(indices.size());
+    for (unsigned i = 0; i < indices.size(); i++)
+        canvases[i] = &m_Pages->GetPage(indices[i]);
+
+    auto executor = GetExecutor();
+    if (threadCount == 0)
+        threadCount = executor->GetConcurrency();
+
+    threadCount = std::min(threadCount, (unsigned)indices.size());
+    if (threadCount > 1 && m_Objects.tryBeginConcurrentWrites())
+    {
+        for (auto page : canvases)
+            page->EnsureOwnResources();
+    }
+    else
+    {
+        threadCount = 1;
+    }
+
+    try
+    {
+        executor->ParallelFor(indices.size(), 1, threadCount, [&]()
+        {
+            return [&](size_t i)
             {
-                FixObjectReferences(child, difference);
-            }
-        }
+                paint(*canvases[i], indices[i]);
+            };
+        });
     }
-    else if (obj.IsReference())
+    catch (...)
     {
-        obj = PdfObject(PdfReference(obj.GetReference().ObjectNumber() + difference,
-            obj.GetReference().GenerationNumber()));
+        m_Objects.endConcurrentWrites();
+        throw;
     }
+
+    m_Objects.endConcurrentWrites();
 }
 
-void PdfDocument::CollectGarbage()
+#ifdef PDFMM_HAVE_TIFF_LIB
+
+unsigned PdfDocument::AppendTiffPages(const string_view& filename)
 {
-    m_Objects.CollectGarbage();
+    TIFF* tiff = (TIFF*)PdfImage::openTiff(filename);
+    unsigned count = 0;
+    try
+    {
+        do
+        {
+            PdfImage image(*this);
+            image.LoadFromTiffHandle(tiff);
+            double scaleX = getTiffScale(tiff, TIFFTAG_XRESOLUTION);
+            double scaleY = getTiffScale(tiff, TIFFTAG_YRESOLUTION);
+            auto page = m_Pages->CreatePage(PdfRect(0, 0,
+                image.GetWidth() * scaleX, image.GetHeight() * scaleY));
+
+            PdfPainter painter;
+            painter.SetCanvas(page);
+            painter.DrawImage(image, 0, 0, scaleX, scaleY);
+            painter.FinishDrawing();
+            count++;
+        } while (TIFFReadDirectory(tiff));
+    }
+    catch (...)
+    {
+        TIFFClose(tiff);
+        throw;
+    }
+
+    TIFFClose(tiff);
+    return count;
+}
+
+#endif // PDFMM_HAVE_TIFF_LIB
+
+void PdfDocument::FlattenAnnotations(const cspan<unsigned>& pages)
+{
+    unsigned count = 0;
+    if (pages.size() == 0)
+    {
+        for (unsigned i = 0; i < m_Pages->GetCount(); i++)
+            count += m_Pages->GetPage(i).FlattenAnnotations();
+    }
+    else
+    {
+        for (unsigned index : pages)
+        {
+            if (index >= m_Pages->GetCount())
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Page index {} is out of range", index);
+        }
+
+        for (unsigned index : pages)
+            count += m_Pages->GetPage(index).FlattenAnnotations();
+    }
+
+    if (count == 0 || m_AcroForm == nullptr)
+        return;
+
+    // The objects of the flattened widgets were removed, so
+    // the fields are pruned in a single walk of the field tree
+    auto fields = m_AcroForm->GetDictionary().FindKey("Fields");
+    if (fields != nullptr && fields->IsArray())
+    {
+        unordered_set<PdfReference> visited;
+        pruneFields(m_Objects, fields->GetArray(), visited);
+        if (fields->GetArray().GetSize() != 0)
+            return;
+    }
+
+    // No field is left, remove the form
+    auto acroFormRef = m_AcroForm->GetObject().GetIndirectReference();
+    m_Catalog->GetDictionary().RemoveKey("AcroForm");
+    m_AcroForm = nullptr;
+    if (acroFormRef.IsIndirect())
+        m_Objects.RemoveObject(acroFormRef);
 }
 
 PdfOutlines& PdfDocument::GetOrCreateOutlines()
@@ -564,3 +744,121 @@ bool PdfDocument::IsHighPrintAllowed() const
 {
     return GetEncrypt() == nullptr ? true : GetEncrypt()->IsHighPrintAllowed();
 }
+
+shared_ptr<PdfExecutor> PdfDocument::GetExecutor() const
+{
+    if (m_Executor != nullptr)
+        return m_Executor;
+
+    return PdfExecutor::GetDefault();
+}
+
+bool PdfDocument::TryFreeze()
+{
+    return false;
+}
+
+void preloadFonts(PdfFontManager& fontManager, const PdfCanvas& canvas)
+{
+    auto resources = canvas.GetResources();
+    if (resources == nullptr)
+        return;
+
+    for (auto& pair : resources->GetResourceIterator("Font"))
+    {
+        if (pair.second->IsIndirect())
+            (void)fontManager.GetLoadedFont(*pair.second);
+    }
+}
+
+#ifdef PDFMM_HAVE_TIFF_LIB
+
+// Get the scale from pixels to points
+double getTiffScale(TIFF* tiff, ttag_t resolutionTag)
+{
+    float resolution = 0;
+    uint16 unit = RESUNIT_INCH;
+    TIFFGetField(tiff, resolutionTag, &resolution);
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_RESOLUTIONUNIT, &unit);
+    if (resolution <= 0 || unit == RESUNIT_NONE)
+        return 1;
+
+    if (unit == RESUNIT_CENTIMETER)
+        resolution *= 2.54f;
+
+    return 72.0 / resolution;
+}
+
+#endif // PDFMM_HAVE_TIFF_LIB
+
+// Remove the fields whose widgets were all removed from the document
+void pruneFields(PdfIndirectObjectList& objects, PdfArray& fields, unordered_set<PdfReference>& visited)
+{
+    PdfArray kept;
+    bool changed = false;
+    for (unsigned i = 0; i < fields.GetSize(); i++)
+    {
+        auto& item = fields[i];
+        PdfObject* field = &item;
+        if (item.IsReference())
+        {
+            field = objects.GetObject(item.GetReference());
+            if (field == nullptr)
+            {
+                // A removed widget
+                changed = true;
+                continue;
+            }
+
+            if (!visited.insert(item.GetReference()).second)
+            {
+                kept.Add(item);
+                continue;
+            }
+        }
+
+        PdfDictionary* dict;
+        PdfObject* kids;
+        if (field->TryGetDictionary(dict) && (kids = dict->FindKey("Kids")) != nullptr
+            && kids->IsArray() && kids->GetArray().GetSize() != 0)
+        {
+            pruneFields(objects, kids->GetArray(), visited);
+            if (kids->GetArray().GetSize() == 0)
+            {
+                changed = true;
+                if (item.IsReference())
+                    objects.RemoveObject(item.GetReference());
+
+                continue;
+            }
+        }
+
+        kept.Add(item);
+    }
+
+    if (changed)
+        fields = kept;
+}
+
+vector<unsigned> getPageIndices(const PdfPageCollection& collection, const cspan<unsigned>& pages)
+{
+    vector<unsigned> indices;
+    if (pages.size() == 0)
+    {
+        indices.resize(collection.GetCount());
+        for (unsigned i = 0; i < indices.size(); i++)
+            indices[i] = i;
+    }
+    else
+    {
+        for (unsigned index : pages)
+        {
+            if (index >= collection.GetCount())
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Page index {} is out of range", index);
+        }
+
+        indices.assign(pages.begin(), pages.end());
+    }
+
+    return indices;
+}
@@ -16,8 +16,10 @@
 #include "PdfIndirectObjectList.h"
 #include "PdfAcroForm.h"
 #include "PdfFontManager.h"
+#include "PdfImageManager.h"
 #include "PdfMetadata.h"
 #include "PdfPageCollection.h"
+#include "PdfPage.h"
 #include "PdfNameTree.h"
 
 namespace mm {
@@ -32,6 +34,8 @@ class PdfPage;
 class PdfRect;
 class PdfXObject;
 class PdfEncrypt;
+class PdfTraceSink;
+class PdfExecutor;
 
 /** PdfDocument is the core interface for working with PDF documents.
  *
@@ -51,6 +55,8 @@ class PdfEncrypt;
 class PDFMM_API PdfDocument
 {
     friend class PdfMetadata;
+    friend class PdfRedactor;
+    friend class PdfAValidator;
 
 public:
     /** Close down/destruct the PdfDocument
@@ -151,6 +157,74 @@ public:
 
     void CollectGarbage();
 
+    /** Extract the text of many pages of the document at once,
+     *  processing the pages concurrently
+     *
+     *  \param pages the indices of the pages to extract. All the
+     *      pages are extracted if empty
+     *  \param params the extraction parameters, used for all the pages.
+     *      If no contents cache is set, one is created for the call
+     *  \param threadCount the count of the threads to use, or 0 to
+     *      use the concurrency of the executor of the document
+     *  \returns the text entries of every page, in the order of pages
+     *  \remarks To read it concurrently the document is frozen first,
+     *      so the objects and the fonts are loaded only once and shared
+     *      by all threads. Documents that can't be frozen are
+     *      processed on the calling thread
+     *  \see PdfMemDocument::Freeze
+     */
+    std::vector<std::vector<PdfTextEntry>> ExtractText(const cspan<unsigned>& pages = { },
+        const PdfTextExtractParams& params = { }, unsigned threadCount = 0);
+
+    /** Paint many pages of the document at once, processing
+     *  the pages concurrently
+     *
+     *  \param pages the indices of the pages to paint. All the
+     *      pages are painted if empty
+     *  \param paint the function painting a page, e.g. with a
+     *      PdfPainter. It's called concurrently for distinct pages
+     *      with the page and its index
+     *  \param threadCount the count of the threads to use, or 0 to
+     *      use the concurrency of the executor of the document
+     *  \remarks While painting, the creation of the objects, their lookups
+     *      and the tracking of their modifications are synchronized, and
+     *      every page gets a resources dictionary of its own, so the function
+     *      can modify the page, add resources and create new objects, like
+     *      content streams and graphics states. Encoding text with a font
+     *      is synchronized as well, but the fonts, the images and the other
+     *      objects shared by the pages must be created upfront. The objects
+     *      are loaded first, and documents writing the objects immediately
+     *      are painted on the calling thread
+     */
+    void PaintPages(const cspan<unsigned>& pages,
+        const std::function<void(PdfPage& page, unsigned index)>& paint, unsigned threadCount = 0);
+
+#ifdef PDFMM_HAVE_TIFF_LIB
+    /** Append a page for every image of a multi-page TIFF file
+     *
+     *  The pages are sized after the resolution of the images, 72 DPI
+     *  if missing. The strips are decoded and compressed one at time,
+     *  so at most the data of one strip is held decoded. Images in a
+     *  single strip compressed with CCITT Group 4 or with
+     *  self-contained JPEG data are embedded without decoding them
+     *  \param filename the TIFF file
+     *  \returns the count of the pages appended
+     */
+    unsigned AppendTiffPages(const std::string_view& filename);
+#endif // PDFMM_HAVE_TIFF_LIB
+
+    /** Flatten the annotations of many pages of the document at once
+     *
+     *  \param pages the indices of the pages to flatten. All the
+     *      pages are flattened if empty
+     *  \remarks The form fields with all the widgets flattened are
+     *      removed from the /AcroForm in a single pass, and the /AcroForm
+     *      itself is removed when no field is left, invalidating the
+     *      PdfAcroForm returned by GetAcroForm()
+     *  \see PdfPage::FlattenAnnotations
+     */
+    void FlattenAnnotations(const cspan<unsigned>& pages = { });
+
     /** Checks if printing this document is allowed.
      *  Every PDF-consuming application has to adhere to this value!
      *
@@ -304,11 +378,55 @@ public:
 
     PdfFontManager& GetFontManager() { return m_FontManager; }
 
+    /** Get the manager of the images and the ICC profiles shared in the document
+     */
+    PdfImageManager& GetImageManager() { return m_ImageManager; }
+
+    /** Set the level used by the Flate filter when changing the
+     *  content of the streams of this document
+     *
+     *  Streams can override it with PdfObjectStream::SetCompressionLevel
+     */
+    void SetCompressionLevel(PdfCompressionLevel level) { m_CompressionLevel = level; }
+
+    inline PdfCompressionLevel GetCompressionLevel() const { return m_CompressionLevel; }
+
+    /** Set the sink receiving the events traced for this document,
+     *  in place of the global one set with PdfTrace::SetGlobalSink
+     *
+     *  \param sink the sink, or nullptr to use the global one. It's
+     *  not owned and it must be kept alive until it's replaced
+     */
+    void SetTraceSink(PdfTraceSink* sink) { m_TraceSink = sink; }
+
+    inline PdfTraceSink* GetTraceSink() const { return m_TraceSink; }
+
+    /** Set the executor running the parallel operations on this
+     *  document, in place of the global one set with PdfExecutor::SetDefault
+     *
+     *  \param executor the executor, or nullptr to use the global one
+     */
+    void SetExecutor(const std::shared_ptr<PdfExecutor>& executor) { m_Executor = executor; }
+
+    /** \returns the executor set with SetExecutor, if any, or the global one
+     */
+    std::shared_ptr<PdfExecutor> GetExecutor() const;
+
+    /** \returns the memory resource the objects of this document are
+     *  allocated from, or nullptr if they use the global heap
+     *  \see PdfMemoryResource
+     */
+    inline std::pmr::memory_resource* GetMemoryResource() const { return m_MemoryResource; }
+
 protected:
     /** Construct a new (empty) PdfDocument
      *  \param empty if true NO default objects (such as catalog) are created.
+     *  \param resource the memory resource the objects are allocated
+     *      from, or nullptr to use the global heap. It must outlive all
+     *      the objects and values allocated from it, also the ones
+     *      removed or moved out of the document
      */
-    PdfDocument(bool empty = false);
+    PdfDocument(bool empty = false, std::pmr::memory_resource* resource = nullptr);
 
     PdfDocument(const PdfDocument& doc);
 
@@ -324,6 +442,10 @@ protected:
      */
     void Init();
 
+    /** Create the trailer, the catalog and the info of a new document
+     */
+    void InitEmpty();
+
     /** Recursively changes every PdfReference in the PdfObject and in any child
      *  that is either an PdfArray or a direct object.
      *  The reference is changed so that difference is added to the object number
@@ -348,15 +470,26 @@ protected:
  */
     virtual void SetPdfVersion(PdfVersion version) = 0;
 
+    /** Prepare the document for concurrent read access
+     *  \returns false if the document doesn't support it
+     */
+    virtual bool TryFreeze();
+
 private:
     PdfDocument& operator=(const PdfDocument&) = delete;
 
     PdfInfo& GetInfo() { return *m_Info; }
 
 private:
+    // NOTE: Initialized first, since the objects may be loaded
+    // while constructing the other members
+    PdfTraceSink* m_TraceSink;
+    std::pmr::memory_resource* m_MemoryResource;
+    std::shared_ptr<PdfExecutor> m_Executor;
     PdfIndirectObjectList m_Objects;
     PdfMetadata m_Metadata;
     PdfFontManager m_FontManager;
+    PdfImageManager m_ImageManager;
     std::unique_ptr<PdfObject> m_TrailerObj;
     std::unique_ptr<PdfTrailer> m_Trailer;
     std::unique_ptr<PdfCatalog> m_Catalog;
@@ -365,6 +498,7 @@ private:
     std::unique_ptr<PdfAcroForm> m_AcroForm;
     std::unique_ptr<PdfOutlines> m_Outlines;
     std::unique_ptr<PdfNameTree> m_NameTree;
+    PdfCompressionLevel m_CompressionLevel;
 };
 
 };
@@ -0,0 +1,447 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfDocumentDiff.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "PdfArray.h"
+#include "PdfDictionary.h"
+#include "PdfDocumentHasher.h"
+#include "PdfInputDevice.h"
+#include "PdfMemDocument.h"
+#include "PdfObjectStream.h"
+#include "PdfObjectWalker.h"
+#include "PdfPage.h"
+#include "PdfPageCollection.h"
+#include "PdfParserObject.h"
+
+using namespace std;
+using namespace mm;
+
+static constexpr size_t DataChunkSize = 64 * 1024;
+
+// The attributes the pages inherit from the page tree
+static constexpr string_view InheritableKeys[] = {
+    "CropBox",
+    "MediaBox",
+    "Resources",
+    "Rotate",
+};
+
+static bool tryGetPermanentIdentifier(const PdfDocument& doc, PdfString& identifier);
+static bool isPrefixOf(InputStreamDevice& prefix, InputStreamDevice& device);
+static bool isPageTreeNode(const PdfDictionary& dict);
+static void mark(vector<bool>& marked, uint32_t objNum);
+static bool isMarked(const vector<bool>& marked, uint32_t objNum);
+
+PdfDocumentDiff::PdfDocumentDiff(PdfDocument& oldDoc, PdfDocument& newDoc) :
+    m_oldDoc(&oldDoc),
+    m_newDoc(&newDoc),
+    m_alignment(PdfDiffAlignment::Structure) { }
+
+void PdfDocumentDiff::Compute()
+{
+    PdfString oldIdentifier;
+    PdfString newIdentifier;
+    if (tryGetPermanentIdentifier(*m_oldDoc, oldIdentifier)
+        && tryGetPermanentIdentifier(*m_newDoc, newIdentifier)
+        && oldIdentifier.GetRawData() == newIdentifier.GetRawData())
+    {
+        Compute(PdfDiffAlignment::Reference);
+    }
+    else
+    {
+        Compute(PdfDiffAlignment::Structure);
+    }
+}
+
+void PdfDocumentDiff::Compute(PdfDiffAlignment alignment)
+{
+    m_alignment = alignment;
+    m_objects.clear();
+    m_pages.clear();
+    switch (alignment)
+    {
+        case PdfDiffAlignment::Reference:
+            compareByReference();
+            break;
+        case PdfDiffAlignment::Structure:
+            compareStructure();
+            break;
+        default:
+            PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
+    }
+}
+
+bool PdfDocumentDiff::IsEmpty() const
+{
+    return m_objects.size() == 0 && m_pages.size() == 0;
+}
+
+void PdfDocumentDiff::compareByReference()
+{
+    // The object lists are sorted by reference, so they are merged
+    bool sharedSource = hasSharedSource();
+    auto& oldObjects = m_oldDoc->GetObjects();
+    auto& newObjects = m_newDoc->GetObjects();
+
+    // The changed objects and the pages of the new
+    // document are marked by their object number
+    vector<bool> changedRefs(newObjects.GetObjectCount());
+    bool hasChanges = false;
+    auto oldIt = oldObjects.begin();
+    auto newIt = newObjects.begin();
+    while (oldIt != oldObjects.end() || newIt != newObjects.end())
+    {
+        if (newIt == newObjects.end()
+            || (oldIt != oldObjects.end() && (*oldIt)->GetIndirectReference() < (*newIt)->GetIndirectReference()))
+        {
+            m_objects.push_back({ PdfDiffChange::Removed, (*oldIt)->GetIndirectReference(), PdfReference() });
+            oldIt++;
+        }
+        else if (oldIt == oldObjects.end()
+            || (*newIt)->GetIndirectReference() < (*oldIt)->GetIndirectReference())
+        {
+            auto& ref = (*newIt)->GetIndirectReference();
+            m_objects.push_back({ PdfDiffChange::Added, PdfReference(), ref });
+            mark(changedRefs, ref.ObjectNumber());
+            hasChanges = true;
+            newIt++;
+        }
+        else
+        {
+            if (isObjectChanged(**oldIt, **newIt, sharedSource))
+            {
+                auto& ref = (*newIt)->GetIndirectReference();
+                m_objects.push_back({ PdfDiffChange::Changed, ref, ref });
+                mark(changedRefs, ref.ObjectNumber());
+                hasChanges = true;
+            }
+
+            oldIt++;
+            newIt++;
+        }
+    }
+
+    // Align the pages by the reference of the page objects
+    auto& oldPages = m_oldDoc->GetPages();
+    unordered_map<PdfReference, unsigned> oldPageIndices;
+    for (unsigned i = 0; i < oldPages.GetCount(); i++)
+        oldPageIndices[oldPages.GetPage(i).GetObject().GetIndirectReference()] = i;
+
+    auto& newPages = m_newDoc->GetPages();
+    vector<bool> newPageRefs(newObjects.GetObjectCount());
+    for (unsigned i = 0; i < newPages.GetCount(); i++)
+        mark(newPageRefs, newPages.GetPage(i).GetObject().GetIndirectReference().ObjectNumber());
+
+    vector<bool> unchangedRefs(newObjects.GetObjectCount());
+    for (unsigned i = 0; i < newPages.GetCount(); i++)
+    {
+        auto& ref = newPages.GetPage(i).GetObject().GetIndirectReference();
+        auto found = oldPageIndices.find(ref);
+        if (found == oldPageIndices.end())
+        {
+            m_pages.push_back({ PdfDiffChange::Added, nullptr, i });
+            continue;
+        }
+
+        if (hasChanges && isPageChanged(i, newPageRefs, changedRefs, unchangedRefs))
+            m_pages.push_back({ PdfDiffChange::Changed, found->second, i });
+
+        oldPageIndices.erase(found);
+    }
+
+    vector<unsigned> removedPages;
+    for (auto& pair : oldPageIndices)
+        removedPages.push_back(pair.second);
+
+    std::sort(removedPages.begin(), removedPages.end());
+    for (unsigned index : removedPages)
+        m_pages.push_back({ PdfDiffChange::Removed, index, nullptr });
+}
+
+void PdfDocumentDiff::compareStructure()
+{
+    // NOTE: The identical documents are skipped at the cost of the
+    // fingerprints, that are computed anyway to align the pages
+    PdfDocumentHasher oldHasher(*m_oldDoc);
+    PdfDocumentHasher newHasher(*m_newDoc);
+    if (oldHasher.ComputeCatalogHash() != newHasher.ComputeCatalogHash())
+    {
+        m_objects.push_back({ PdfDiffChange::Changed,
+            m_oldDoc->GetCatalog().GetObject().GetIndirectReference(),
+            m_newDoc->GetCatalog().GetObject().GetIndirectReference() });
+    }
+
+    auto oldHashes = oldHasher.ComputePageHashes();
+    auto newHashes = newHasher.ComputePageHashes();
+
+    // Skip the identical pages at the start and at the end, then
+    // align the remaining pages by their position
+    unsigned start = 0;
+    while (start < oldHashes.size() && start < newHashes.size()
+        && oldHashes[start] == newHashes[start])
+    {
+        start++;
+    }
+
+    unsigned oldEnd = (unsigned)oldHashes.size();
+    unsigned newEnd = (unsigned)newHashes.size();
+    while (oldEnd > start && newEnd > start
+        && oldHashes[oldEnd - 1] == newHashes[newEnd - 1])
+    {
+        oldEnd--;
+        newEnd--;
+    }
+
+    auto& oldPages = m_oldDoc->GetPages();
+    auto& newPages = m_newDoc->GetPages();
+    unsigned oldIndex = start;
+    unsigned newIndex = start;
+    vector<PdfObjectDiff> removedObjects;
+    vector<PdfPageDiff> removedPages;
+    while (oldIndex < oldEnd || newIndex < newEnd)
+    {
+        if (oldIndex < oldEnd && newIndex < newEnd)
+        {
+            if (oldHashes[oldIndex] != newHashes[newIndex])
+            {
+                m_objects.push_back({ PdfDiffChange::Changed,
+                    oldPages.GetPage(oldIndex).GetObject().GetIndirectReference(),
+                    newPages.GetPage(newIndex).GetObject().GetIndirectReference() });
+                m_pages.push_back({ PdfDiffChange::Changed, oldIndex, newIndex });
+            }
+
+            oldIndex++;
+            newIndex++;
+        }
+        else if (newIndex < newEnd)
+        {
+            m_objects.push_back({ PdfDiffChange::Added, PdfReference(),
+                newPages.GetPage(newIndex).GetObject().GetIndirectReference() });
+            m_pages.push_back({ PdfDiffChange::Added, nullptr, newIndex });
+            newIndex++;
+        }
+        else
+        {
+            removedObjects.push_back({ PdfDiffChange::Removed,
+                oldPages.GetPage(oldIndex).GetObject().GetIndirectReference(), PdfReference() });
+            removedPages.push_back({ PdfDiffChange::Removed, oldIndex, nullptr });
+            oldIndex++;
+        }
+    }
+
+    m_objects.insert(m_objects.end(), removedObjects.begin(), removedObjects.end());
+    m_pages.insert(m_pages.end(), removedPages.begin(), removedPages.end());
+}
+
+bool PdfDocumentDiff::isObjectChanged(const PdfObject& oldObj, const PdfObject& newObj, bool sharedSource)
+{
+    if (sharedSource && !oldObj.IsDirty() && !newObj.IsDirty())
+    {
+        // The objects at the same offset of the shared
+        // source are the same, without parsing them
+        auto oldParserObj = dynamic_cast<const PdfParserObject*>(&oldObj);
+        auto newParserObj = dynamic_cast<const PdfParserObject*>(&newObj);
+        if (oldParserObj != nullptr && newParserObj != nullptr
+            && oldParserObj->GetOffset() >= 0
+            && oldParserObj->GetOffset() == newParserObj->GetOffset())
+        {
+            return false;
+        }
+    }
+
+    if (oldObj.GetVariant() != newObj.GetVariant())
+        return true;
+
+    bufferview oldView;
+    bufferview newView;
+    bool oldHasView = !oldObj.IsDelayedLoadStreamDone() && tryGetRawStreamView(oldObj, oldView);
+    bool newHasView = !newObj.IsDelayedLoadStreamDone() && tryGetRawStreamView(newObj, newView);
+    charbuff oldData;
+    charbuff newData;
+    if (!oldHasView)
+    {
+        auto stream = oldObj.GetStream();
+        if (stream != nullptr)
+        {
+            oldData = stream->GetFilteredCopy();
+            oldView = oldData;
+        }
+    }
+
+    if (!newHasView)
+    {
+        auto stream = newObj.GetStream();
+        if (stream != nullptr)
+        {
+            newData = stream->GetFilteredCopy();
+            newView = newData;
+        }
+    }
+
+    // NOTE: An object with an empty stream and
+    // one without a stream are not told apart
+    return oldView.size() != newView.size()
+        || std::memcmp(oldView.data(), newView.data(), oldView.size()) != 0;
+}
+
+bool PdfDocumentDiff::isPageChanged(unsigned pageIndex, const vector<bool>& pageRefs,
+    const vector<bool>& changedRefs, vector<bool>& unchangedRefs)
+{
+    // Walk the objects reachable from the page, without walking other
+    // pages and the page tree, until a changed object is found
+    auto& page = m_newDoc->GetPages().GetPage(pageIndex);
+    auto& pageObj = page.GetObject();
+    vector<uint32_t> visited;
+    bool changed = false;
+    PdfObjectWalker walker(&m_newDoc->GetObjects());
+    PdfObjectWalker::Visitor visitor = [&](const PdfObject& obj, const PdfName* key)
+    {
+        if (obj.IsIndirect())
+        {
+            // The page tree nodes are changed by the pages added or
+            // removed, the values inherited from them are walked apart
+            if (&obj != &pageObj && obj.IsDictionary() && isPageTreeNode(obj.GetDictionary()))
+                return PdfWalkAction::SkipChildren;
+
+            uint32_t objNum = obj.GetIndirectReference().ObjectNumber();
+            if (isMarked(changedRefs, objNum))
+            {
+                changed = true;
+                return PdfWalkAction::Stop;
+            }
+
+            visited.push_back(objNum);
+        }
+        else if (key != nullptr && key->GetRawData() == "Parent")
+        {
+            auto dict = dynamic_cast<const PdfDictionary*>(obj.GetParent());
+            if (dict != nullptr && isPageTreeNode(*dict))
+                return PdfWalkAction::SkipChildren;
+        }
+        else if (obj.IsReference())
+        {
+            uint32_t objNum = obj.GetReference().ObjectNumber();
+            if (isMarked(unchangedRefs, objNum)
+                || (objNum != pageObj.GetIndirectReference().ObjectNumber() && isMarked(pageRefs, objNum)))
+            {
+                return PdfWalkAction::SkipChildren;
+            }
+        }
+
+        return PdfWalkAction::Continue;
+    };
+
+    if (!walker.Walk(pageObj, visitor))
+        return true;
+
+    auto& dict = pageObj.GetDictionary();
+    for (auto& key : InheritableKeys)
+    {
+        PdfName name(key);
+        if (dict.HasKey(name))
+            continue;
+
+        auto inherited = page.GetInheritedKey(name);
+        if (inherited != nullptr && !walker.Walk(*inherited, visitor))
+            return true;
+    }
+
+    // The whole graph reachable from the visited objects is unchanged
+    PDFMM_ASSERT(!changed);
+    for (uint32_t objNum : visited)
+        mark(unchangedRefs, objNum);
+
+    return false;
+}
+
+bool PdfDocumentDiff::hasSharedSource() const
+{
+    auto oldDoc = dynamic_cast<PdfMemDocument*>(m_oldDoc);
+    auto newDoc = dynamic_cast<PdfMemDocument*>(m_newDoc);
+    if (oldDoc == nullptr || newDoc == nullptr
+        || oldDoc->m_device == nullptr || newDoc->m_device == nullptr)
+    {
+        return false;
+    }
+
+    if (oldDoc->m_device == newDoc->m_device)
+        return true;
+
+    return isPrefixOf(*oldDoc->m_device, *newDoc->m_device);
+}
+
+bool PdfDocumentDiff::tryGetRawStreamView(const PdfObject& obj, bufferview& view)
+{
+    return obj.TryGetRawStreamView(view);
+}
+
+bool tryGetPermanentIdentifier(const PdfDocument& doc, PdfString& identifier)
+{
+    auto idObj = doc.GetTrailer().GetObject().GetDictionary().FindKey("ID");
+    const PdfArray* arr;
+    return idObj != nullptr && idObj->TryGetArray(arr) && arr->GetSize() != 0
+        && (*arr)[0].TryGetString(identifier);
+}
+
+bool isPrefixOf(InputStreamDevice& prefix, InputStreamDevice& device)
+{
+    size_t length = prefix.GetLength();
+    if (length > device.GetLength())
+        return false;
+
+    bufferview prefixView;
+    bufferview deviceView;
+    if (prefix.TryGetView(prefixView) && device.TryGetView(deviceView))
+        return std::memcmp(prefixView.data(), deviceView.data(), length) == 0;
+
+    unique_ptr<char[]> prefixChunk(new char[DataChunkSize]);
+    unique_ptr<char[]> deviceChunk(new char[DataChunkSize]);
+    prefix.Seek(0);
+    device.Seek(0);
+    for (size_t offset = 0; offset < length; offset += DataChunkSize)
+    {
+        size_t size = std::min(DataChunkSize, length - offset);
+        bool eof;
+        if (prefix.Read(prefixChunk.get(), size, eof) != size
+            || device.Read(deviceChunk.get(), size, eof) != size
+            || std::memcmp(prefixChunk.get(), deviceChunk.get(), size) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool isPageTreeNode(const PdfDictionary& dict)
+{
+    auto type = dict.FindKey(PdfName::KeyType);
+    if (type == nullptr || !type->IsName())
+        return false;
+
+    auto& name = type->GetName().GetRawData();
+    return name == "Page" || name == "Pages";
+}
+
+void mark(vector<bool>& marked, uint32_t objNum)
+{
+    if (objNum >= marked.size())
+        marked.resize((size_t)objNum + 1);
+
+    marked[objNum] = true;
+}
+
+bool isMarked(const vector<bool>& marked, uint32_t objNum)
+{
+    return objNum < marked.size() && marked[objNum];
+}
@@ -0,0 +1,119 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_DOCUMENT_DIFF_H
+#define PDF_DOCUMENT_DIFF_H
+
+#include "PdfDeclarations.h"
+#include "PdfReference.h"
+
+namespace mm {
+
+class PdfDocument;
+class PdfObject;
+
+enum class PdfDiffChange
+{
+    Added,
+    Removed,
+    Changed,
+};
+
+enum class PdfDiffAlignment
+{
+    Reference,      ///< The objects are aligned by reference, as in revisions of the same document
+    Structure,      ///< The catalogs and the pages are aligned and compared by their content fingerprints
+};
+
+/** An object that differs between the documents. The
+ *  reference of the side missing the object is PdfReference()
+ */
+struct PDFMM_API PdfObjectDiff
+{
+    PdfDiffChange Change;
+    PdfReference OldReference;
+    PdfReference NewReference;
+};
+
+/** A page that differs between the documents. The
+ *  index of the side missing the page is null
+ */
+struct PDFMM_API PdfPageDiff
+{
+    PdfDiffChange Change;
+    nullable<unsigned> OldIndex;
+    nullable<unsigned> NewIndex;
+};
+
+/** Compare two documents, or two revisions of the same document,
+ *  reporting the objects and the pages that were changed, added or removed
+ *
+ * Revisions of a document, recognized by the same permanent identifier,
+ * the first element of the trailer /ID, are aligned by reference. When
+ * the new revision is an incremental update of the file of the old one,
+ * the objects not rewritten by the update are at the same offset of the
+ * shared source and they are skipped without being parsed. A page of
+ * both revisions is changed when an object reachable from it is
+ * changed, and the objects proven unchanged are not walked again
+ *
+ * Unrelated documents are aligned structurally, by the content
+ * fingerprints of PdfDocumentHasher: the catalogs are compared and
+ * the pages are aligned skipping the identical pages at the start and
+ * at the end, so a page inserted or removed doesn't shift the others.
+ * The objects reported are the catalogs and the page objects
+ * \remarks The documents must not be modified while they are compared
+ * \see PdfDocumentHasher
+ */
+class PDFMM_API PdfDocumentDiff final
+{
+public:
+    PdfDocumentDiff(PdfDocument& oldDoc, PdfDocument& newDoc);
+
+public:
+    /** Compare the documents, choosing the alignment by the /ID of the trailers
+     */
+    void Compute();
+
+    void Compute(PdfDiffAlignment alignment);
+
+    /** \returns true if no difference was found
+     */
+    bool IsEmpty() const;
+
+public:
+    inline PdfDiffAlignment GetAlignment() const { return m_alignment; }
+
+    /** \returns the objects that differ, in order of the reference
+     *  when aligned by reference, otherwise the catalog first
+     */
+    inline const std::vector<PdfObjectDiff>& GetObjects() const { return m_objects; }
+
+    /** \returns the pages that differ, in order of the new index,
+     *  with the removed pages after the others
+     */
+    inline const std::vector<PdfPageDiff>& GetPages() const { return m_pages; }
+
+private:
+    void compareByReference();
+    void compareStructure();
+    bool isObjectChanged(const PdfObject& oldObj, const PdfObject& newObj, bool sharedSource);
+    bool isPageChanged(unsigned pageIndex, const std::vector<bool>& pageRefs,
+        const std::vector<bool>& changedRefs, std::vector<bool>& unchangedRefs);
+    bool hasSharedSource() const;
+    static bool tryGetRawStreamView(const PdfObject& obj, bufferview& view);
+
+private:
+    PdfDocument* m_oldDoc;
+    PdfDocument* m_newDoc;
+    PdfDiffAlignment m_alignment;
+    std::vector<PdfObjectDiff> m_objects;
+    std::vector<PdfPageDiff> m_pages;
+};
+
+};
+
+#endif // PDF_DOCUMENT_DIFF_H
@@ -0,0 +1,674 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfDocumentHasher.h"
+
+#include <cstring>
+#include <unordered_map>
+
+#include "PdfArray.h"
+#include "PdfDictionary.h"
+#include "PdfDocument.h"
+#include "PdfExecutor.h"
+#include "PdfInputDevice.h"
+#include "PdfObjectStream.h"
+#include "PdfObjectWalker.h"
+#include "PdfOutputStream.h"
+#include "PdfPage.h"
+#include "PdfPageCollection.h"
+
+using namespace std;
+using namespace mm;
+
+static constexpr size_t DataChunkSize = 64 * 1024;
+
+// The keys holding producer information and timestamps
+static constexpr string_view IgnoredKeys[] = {
+    "CreationDate",
+    "Metadata",
+    "ModDate",
+    "Producer",
+};
+
+// The attributes the pages inherit from the page tree
+static constexpr string_view InheritableKeys[] = {
+    "CropBox",
+    "MediaBox",
+    "Resources",
+    "Rotate",
+};
+
+namespace
+{
+    // Streaming 64 bit XXH64, see https://github.com/Cyan4973/xxHash
+    class XXHash64 final
+    {
+    public:
+        XXHash64();
+
+        void Update(const char* data, size_t size);
+
+        uint64_t Digest() const;
+
+    private:
+        void processStripe(const char* data);
+
+    private:
+        uint64_t m_acc[4];
+        char m_buffer[32];
+        size_t m_bufferSize;
+        uint64_t m_totalSize;
+    };
+
+    class HashOutputStream final : public OutputStream
+    {
+    public:
+        HashOutputStream(XXHash64& hash)
+            : m_hash(&hash) { }
+
+    protected:
+        void writeBuffer(const char* buffer, size_t size) override
+        {
+            m_hash->Update(buffer, size);
+        }
+
+    private:
+        XXHash64* m_hash;
+    };
+
+    struct HashedPage
+    {
+        const PdfObject* Object;
+        vector<pair<PdfName, const PdfObject*>> InheritedValues;
+    };
+
+    // The pages and the stream data collected when loading, that is
+    // then read concurrently by the walks that compute the hashes
+    struct HashContext
+    {
+        HashContext(bool(*tryGetRawStreamView)(const PdfObject& obj, bufferview& view))
+            : TryGetRawStreamView(tryGetRawStreamView) { }
+
+        bool(*TryGetRawStreamView)(const PdfObject& obj, bufferview& view);
+        vector<HashedPage> Pages;
+        unordered_map<PdfReference, unsigned> PageIndices;
+        unordered_map<const PdfObject*, bufferview> RawStreams;
+    };
+
+    // Walk in canonical order the graph reachable from an object. The
+    // walk with no hash reads the objects and the streams from the
+    // source, so the walks computing the hash, that visit the same
+    // values, only read memory and can run concurrently
+    class GraphWalker final
+    {
+    public:
+        GraphWalker(const PdfIndirectObjectList& objects, HashContext& context, XXHash64* hash);
+
+        void WalkPage(unsigned pageIndex);
+
+        void WalkCatalog(const PdfObject& catalog);
+
+    private:
+        PdfWalkAction visit(const PdfObject& obj, const PdfName* key);
+        PdfWalkAction visitReference(const PdfReference& ref);
+        void walkStream(const PdfObject& obj);
+        void writeTag(char tag);
+        void writeNumber(uint64_t number);
+        void writeData(const bufferview& data);
+
+    private:
+        const PdfIndirectObjectList* m_objects;
+        HashContext* m_context;
+        XXHash64* m_hash;
+        unsigned m_pageIndex;
+        PdfObjectWalker m_walker;
+        PdfObjectWalker::Visitor m_visitor;
+        vector<unsigned> m_visitIds;
+        unsigned m_visitCount;
+    };
+}
+
+static void loadPages(PdfDocument& doc, HashContext& context);
+static uint64_t readUInt64LE(const char* data);
+static uint32_t readUInt32LE(const char* data);
+static uint64_t rotl(uint64_t value, int bits);
+static uint64_t xxhRound(uint64_t acc, uint64_t input);
+static uint64_t xxhMergeRound(uint64_t acc, uint64_t value);
+static bool isIgnoredKey(const PdfName& key);
+static bool isSkippedKey(const PdfName& key, const PdfObject& value);
+static bool isPageTreeNode(const PdfDictionary& dict);
+
+PdfDocumentHasher::PdfDocumentHasher(PdfDocument& doc)
+    : m_doc(&doc) { }
+
+uint64_t PdfDocumentHasher::ComputeDocumentHash()
+{
+    auto& catalog = m_doc->GetCatalog().GetObject();
+    HashContext context(tryGetRawStreamView);
+    loadPages(*m_doc, context);
+    {
+        GraphWalker loader(m_doc->GetObjects(), context, nullptr);
+        loader.WalkCatalog(catalog);
+        for (unsigned i = 0; i < context.Pages.size(); i++)
+            loader.WalkPage(i);
+    }
+
+    XXHash64 catalogHash;
+    GraphWalker walker(m_doc->GetObjects(), context, &catalogHash);
+    walker.WalkCatalog(catalog);
+
+    vector<uint64_t> pageHashes(context.Pages.size());
+    m_doc->GetExecutor()->ParallelFor(pageHashes.size(), 1, 0, [&]()
+    {
+        return [&](size_t i)
+        {
+            XXHash64 hash;
+            GraphWalker pageWalker(m_doc->GetObjects(), context, &hash);
+            pageWalker.WalkPage((unsigned)i);
+            pageHashes[i] = hash.Digest();
+        };
+    });
+
+    char buffer[8];
+    XXHash64 hash;
+    auto writeNumber = [&](uint64_t number)
+    {
+        for (unsigned i = 0; i < 8; i++)
+            buffer[i] = (char)(number >> (i * 8));
+        hash.Update(buffer, 8);
+    };
+
+    writeNumber(catalogHash.Digest());
+    writeNumber(pageHashes.size());
+    for (auto pageHash : pageHashes)
+        writeNumber(pageHash);
+
+    return hash.Digest();
+}
+
+uint64_t PdfDocumentHasher::ComputeCatalogHash()
+{
+    auto& catalog = m_doc->GetCatalog().GetObject();
+    HashContext context(tryGetRawStreamView);
+    loadPages(*m_doc, context);
+    {
+        GraphWalker loader(m_doc->GetObjects(), context, nullptr);
+        loader.WalkCatalog(catalog);
+    }
+
+    XXHash64 hash;
+    GraphWalker walker(m_doc->GetObjects(), context, &hash);
+    walker.WalkCatalog(catalog);
+    return hash.Digest();
+}
+
+uint64_t PdfDocumentHasher::ComputePageHash(unsigned pageIndex)
+{
+    if (pageIndex >= m_doc->GetPages().GetCount())
+        PDFMM_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
+
+    // NOTE: The other pages are needed only to be hashed as their index
+    HashContext context(tryGetRawStreamView);
+    loadPages(*m_doc, context);
+    {
+        GraphWalker loader(m_doc->GetObjects(), context, nullptr);
+        loader.WalkPage(pageIndex);
+    }
+
+    XXHash64 hash;
+    GraphWalker walker(m_doc->GetObjects(), context, &hash);
+    walker.WalkPage(pageIndex);
+    return hash.Digest();
+}
+
+vector<uint64_t> PdfDocumentHasher::ComputePageHashes()
+{
+    HashContext context(tryGetRawStreamView);
+    loadPages(*m_doc, context);
+    {
+        GraphWalker loader(m_doc->GetObjects(), context, nullptr);
+        for (unsigned i = 0; i < context.Pages.size(); i++)
+            loader.WalkPage(i);
+    }
+
+    vector<uint64_t> ret(context.Pages.size());
+    m_doc->GetExecutor()->ParallelFor(ret.size(), 1, 0, [&]()
+    {
+        return [&](size_t i)
+        {
+            XXHash64 hash;
+            GraphWalker walker(m_doc->GetObjects(), context, &hash);
+            walker.WalkPage((unsigned)i);
+            ret[i] = hash.Digest();
+        };
+    });
+
+    return ret;
+}
+
+uint64_t PdfDocumentHasher::ComputeDataHash(InputStreamDevice& device)
+{
+    bufferview view;
+    if (device.TryGetView(view))
+        return ComputeDataHash(view);
+
+    XXHash64 hash;
+    unique_ptr<char[]> chunk(new char[DataChunkSize]);
+    device.Seek(0);
+    bool eof;
+    do
+    {
+        size_t read = device.Read(chunk.get(), DataChunkSize, eof);
+        hash.Update(chunk.get(), read);
+    } while (!eof);
+
+    return hash.Digest();
+}
+
+uint64_t PdfDocumentHasher::ComputeDataHash(const bufferview& data)
+{
+    XXHash64 hash;
+    hash.Update(data.data(), data.size());
+    return hash.Digest();
+}
+
+bool PdfDocumentHasher::tryGetRawStreamView(const PdfObject& obj, bufferview& view)
+{
+    return obj.TryGetRawStreamView(view);
+}
+
+GraphWalker::GraphWalker(const PdfIndirectObjectList& objects, HashContext& context, XXHash64* hash) :
+    m_objects(&objects),
+    m_context(&context),
+    m_hash(hash),
+    m_pageIndex(numeric_limits<unsigned>::max()),
+    m_walker(&objects),
+    m_visitor([this](const PdfObject& obj, const PdfName* key) { return visit(obj, key); }),
+    m_visitCount(0) { }
+
+void GraphWalker::WalkPage(unsigned pageIndex)
+{
+    m_pageIndex = pageIndex;
+    m_walker.Reset();
+    m_visitCount = 0;
+    auto& page = m_context->Pages[pageIndex];
+    m_walker.Walk(*page.Object, m_visitor);
+
+    for (auto& inherited : page.InheritedValues)
+    {
+        writeData(inherited.first.GetRawData());
+        m_walker.Walk(*inherited.second, m_visitor);
+    }
+}
+
+void GraphWalker::WalkCatalog(const PdfObject& catalog)
+{
+    m_pageIndex = numeric_limits<unsigned>::max();
+    m_walker.Reset();
+    m_visitCount = 0;
+    m_walker.Walk(catalog, m_visitor);
+}
+
+PdfWalkAction GraphWalker::visit(const PdfObject& obj, const PdfName* key)
+{
+    if (obj.IsIndirect())
+    {
+        // The objects are numbered in the order they are visited. The
+        // key of an object reached by a reference was already written
+        uint32_t objNum = obj.GetIndirectReference().ObjectNumber();
+        if (objNum >= m_visitIds.size())
+            m_visitIds.resize((size_t)objNum + 1);
+
+        m_visitIds[objNum] = m_visitCount++;
+        writeTag('O');
+        walkStream(obj);
+    }
+    else if (key != nullptr)
+    {
+        if (isSkippedKey(*key, obj))
+            return PdfWalkAction::SkipChildren;
+
+        writeData(key->GetRawData());
+    }
+
+    switch (obj.GetDataType())
+    {
+        case PdfDataType::Bool:
+            writeTag(obj.GetBool() ? 't' : 'f');
+            break;
+        case PdfDataType::Number:
+            writeTag('i');
+            writeNumber((uint64_t)obj.GetNumber());
+            break;
+        case PdfDataType::Real:
+        {
+            double real = obj.GetRealStrict();
+            uint64_t bits;
+            std::memcpy(&bits, &real, sizeof(bits));
+            writeTag('r');
+            writeNumber(bits);
+            break;
+        }
+        case PdfDataType::String:
+            writeTag('s');
+            writeData(obj.GetString().GetRawData());
+            break;
+        case PdfDataType::Name:
+            writeTag('/');
+            writeData(obj.GetName().GetRawData());
+            break;
+        case PdfDataType::Reference:
+            return visitReference(obj.GetReference());
+        case PdfDataType::Array:
+            writeTag('[');
+            writeNumber(obj.GetArray().GetSize());
+            break;
+        case PdfDataType::Dictionary:
+        {
+            unsigned count = 0;
+            for (auto& pair : obj.GetDictionary())
+            {
+                if (!isSkippedKey(pair.first, pair.second))
+                    count++;
+            }
+
+            writeTag('<');
+            writeNumber(count);
+            break;
+        }
+        case PdfDataType::Null:
+        default:
+            writeTag('n');
+            break;
+    }
+
+    return PdfWalkAction::Continue;
+}
+
+PdfWalkAction GraphWalker::visitReference(const PdfReference& ref)
+{
+    // Missing objects are null, see ISO 32000-1:2008 7.3.10 "Indirect Objects"
+    auto obj = m_objects->GetObject(ref);
+    if (obj == nullptr)
+    {
+        writeTag('n');
+        return PdfWalkAction::SkipChildren;
+    }
+
+    auto foundPage = m_context->PageIndices.find(ref);
+    if (foundPage != m_context->PageIndices.end() && foundPage->second != m_pageIndex)
+    {
+        writeTag('P');
+        writeNumber(foundPage->second);
+        return PdfWalkAction::SkipChildren;
+    }
+
+    if (obj->IsDictionary() && isPageTreeNode(obj->GetDictionary())
+        && foundPage == m_context->PageIndices.end())
+    {
+        // The shape of the page tree is not hashed
+        writeTag('T');
+        return PdfWalkAction::SkipChildren;
+    }
+
+    if (m_walker.IsVisited(ref.ObjectNumber()))
+    {
+        writeTag('R');
+        writeNumber(m_visitIds[ref.ObjectNumber()]);
+        return PdfWalkAction::SkipChildren;
+    }
+
+    return PdfWalkAction::Continue;
+}
+
+void GraphWalker::walkStream(const PdfObject& obj)
+{
+    if (m_hash == nullptr)
+    {
+        // Read the stream data straight from the source if
+        // possible, otherwise load the stream as it is stored
+        bufferview view;
+        if (!obj.IsDelayedLoadStreamDone() && m_context->TryGetRawStreamView(obj, view))
+            m_context->RawStreams[&obj] = view;
+        else
+            (void)obj.HasStream();
+
+        return;
+    }
+
+    auto found = m_context->RawStreams.find(&obj);
+    if (found != m_context->RawStreams.end())
+    {
+        writeTag('S');
+        writeData(found->second);
+        return;
+    }
+
+    auto stream = obj.GetStream();
+    if (stream == nullptr)
+        return;
+
+    writeTag('S');
+    writeNumber(stream->GetLength());
+    HashOutputStream output(*m_hash);
+    stream->CopyTo(output);
+}
+
+void GraphWalker::writeTag(char tag)
+{
+    if (m_hash != nullptr)
+        m_hash->Update(&tag, 1);
+}
+
+void GraphWalker::writeNumber(uint64_t number)
+{
+    if (m_hash == nullptr)
+        return;
+
+    char buffer[8];
+    for (unsigned i = 0; i < 8; i++)
+        buffer[i] = (char)(number >> (i * 8));
+
+    m_hash->Update(buffer, 8);
+}
+
+void GraphWalker::writeData(const bufferview& data)
+{
+    if (m_hash == nullptr)
+        return;
+
+    writeNumber(data.size());
+    m_hash->Update(data.data(), data.size());
+}
+
+constexpr uint64_t XXHPrime1 = 11400714785074694791ULL;
+constexpr uint64_t XXHPrime2 = 14029467366897019727ULL;
+constexpr uint64_t XXHPrime3 = 1609587929392839161ULL;
+constexpr uint64_t XXHPrime4 = 9650029242287828579ULL;
+constexpr uint64_t XXHPrime5 = 2870177450012600261ULL;
+
+XXHash64::XXHash64() :
+    m_acc{ XXHPrime1 + XXHPrime2, XXHPrime2, 0, 0 - XXHPrime1 },
+    m_buffer{ },
+    m_bufferSize(0),
+    m_totalSize(0) { }
+
+void XXHash64::Update(const char* data, size_t size)
+{
+    m_totalSize += size;
+    if (m_bufferSize + size < 32)
+    {
+        std::memcpy(m_buffer + m_bufferSize, data, size);
+        m_bufferSize += size;
+        return;
+    }
+
+    if (m_bufferSize != 0)
+    {
+        size_t fill = 32 - m_bufferSize;
+        std::memcpy(m_buffer + m_bufferSize, data, fill);
+        processStripe(m_buffer);
+        data += fill;
+        size -= fill;
+        m_bufferSize = 0;
+    }
+
+    for (; size >= 32; data += 32, size -= 32)
+        processStripe(data);
+
+    std::memcpy(m_buffer, data, size);
+    m_bufferSize = size;
+}
+
+uint64_t XXHash64::Digest() const
+{
+    uint64_t ret;
+    if (m_totalSize >= 32)
+    {
+        ret = rotl(m_acc[0], 1) + rotl(m_acc[1], 7) + rotl(m_acc[2], 12) + rotl(m_acc[3], 18);
+        for (unsigned i = 0; i < 4; i++)
+            ret = xxhMergeRound(ret, m_acc[i]);
+    }
+    else
+    {
+        ret = XXHPrime5;
+    }
+
+    ret += m_totalSize;
+    const char* data = m_buffer;
+    size_t size = m_bufferSize;
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        ret ^= xxhRound(0, readUInt64LE(data));
+        ret = rotl(ret, 27) * XXHPrime1 + XXHPrime4;
+    }
+
+    if (size >= 4)
+    {
+        ret ^= (uint64_t)readUInt32LE(data) * XXHPrime1;
+        ret = rotl(ret, 23) * XXHPrime2 + XXHPrime3;
+        data += 4;
+        size -= 4;
+    }
+
+    for (; size > 0; data++, size--)
+    {
+        ret ^= (uint64_t)(unsigned char)*data * XXHPrime5;
+        ret = rotl(ret, 11) * XXHPrime1;
+    }
+
+    ret ^= ret >> 33;
+    ret *= XXHPrime2;
+    ret ^= ret >> 29;
+    ret *= XXHPrime3;
+    ret ^= ret >> 32;
+    return ret;
+}
+
+void XXHash64::processStripe(const char* data)
+{
+    for (unsigned i = 0; i < 4; i++)
+        m_acc[i] = xxhRound(m_acc[i], readUInt64LE(data + i * 8));
+}
+
+void loadPages(PdfDocument& doc, HashContext& context)
+{
+    auto& pages = doc.GetPages();
+    unsigned count = pages.GetCount();
+    context.Pages.reserve(count);
+    for (unsigned i = 0; i < count; i++)
+    {
+        auto& page = pages.GetPage(i);
+        HashedPage hashed = { &page.GetObject(), { } };
+        auto& dict = page.GetObject().GetDictionary();
+        for (auto& key : InheritableKeys)
+        {
+            PdfName name(key);
+            if (dict.HasKey(name))
+                continue;
+
+            auto inherited = page.GetInheritedKey(name);
+            if (inherited != nullptr)
+                hashed.InheritedValues.push_back({ name, inherited });
+        }
+
+        context.PageIndices[page.GetObject().GetIndirectReference()] = i;
+        context.Pages.push_back(std::move(hashed));
+    }
+}
+
+uint64_t readUInt64LE(const char* data)
+{
+    uint64_t ret = 0;
+    for (unsigned i = 0; i < 8; i++)
+        ret |= (uint64_t)(unsigned char)data[i] << (i * 8);
+
+    return ret;
+}
+
+uint32_t readUInt32LE(const char* data)
+{
+    uint32_t ret = 0;
+    for (unsigned i = 0; i < 4; i++)
+        ret |= (uint32_t)(unsigned char)data[i] << (i * 8);
+
+    return ret;
+}
+
+uint64_t rotl(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t xxhRound(uint64_t acc, uint64_t input)
+{
+    acc += input * XXHPrime2;
+    acc = rotl(acc, 31);
+    return acc * XXHPrime1;
+}
+
+uint64_t xxhMergeRound(uint64_t acc, uint64_t value)
+{
+    acc ^= xxhRound(0, value);
+    return acc * XXHPrime1 + XXHPrime4;
+}
+
+bool isIgnoredKey(const PdfName& key)
+{
+    auto raw = key.GetRawData();
+    for (auto& ignored : IgnoredKeys)
+    {
+        if (raw == ignored)
+            return true;
+    }
+
+    return false;
+}
+
+bool isSkippedKey(const PdfName& key, const PdfObject& value)
+{
+    if (isIgnoredKey(key))
+        return true;
+
+    // The page tree nodes are not walked up through their /Parent
+    if (key.GetRawData() != "Parent")
+        return false;
+
+    auto dict = dynamic_cast<const PdfDictionary*>(value.GetParent());
+    return dict != nullptr && isPageTreeNode(*dict);
+}
+
+bool isPageTreeNode(const PdfDictionary& dict)
+{
+    auto type = dict.FindKey(PdfName::KeyType);
+    if (type == nullptr || !type->IsName())
+        return false;
+
+    auto& name = type->GetName().GetRawData();
+    return name == "Page" || name == "Pages";
+}
@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_DOCUMENT_HASHER_H
+#define PDF_DOCUMENT_HASHER_H
+
+#include "PdfDeclarations.h"
+
+namespace mm {
+
+class PdfDocument;
+class PdfObject;
+class InputStreamDevice;
+
+/** Compute fingerprints of documents, for example to find duplicates
+ *
+ * The content fingerprints hash the canonical object graph reachable
+ * from the catalog: the references are resolved structurally, so
+ * they don't depend on the object numbering, and the /Producer,
+ * /CreationDate, /ModDate and /Metadata keys are ignored, as is the
+ * trailer with the /ID and the /Info dictionary. The shape of the
+ * page tree is ignored too, the pages are hashed in order. Streams
+ * are hashed as they are stored, without decoding them, so the
+ * same content compressed differently has different fingerprints
+ *
+ * The hash is 64 bit XXH64, which is fast but not cryptographic
+ * \remarks The document must not be modified while it's hashed
+ */
+class PDFMM_API PdfDocumentHasher final
+{
+public:
+    PdfDocumentHasher(PdfDocument& doc);
+
+public:
+    /** Compute the content fingerprint of the whole document,
+     *  hashing the pages concurrently
+     *  \see ComputePageHashes
+     */
+    uint64_t ComputeDocumentHash();
+
+    /** Compute the content fingerprint of the catalog, without the pages
+     *
+     *  The objects reachable from the catalog are hashed, with the
+     *  pages hashed as their index and the page tree nodes skipped
+     */
+    uint64_t ComputeCatalogHash();
+
+    /** Compute the content fingerprint of a single page
+     *
+     *  The page dictionary, its inherited attributes and the objects
+     *  reachable from them are hashed. Other pages referenced by the
+     *  page, as by the destinations of links, are hashed as their index
+     */
+    uint64_t ComputePageHash(unsigned pageIndex);
+
+    /** Compute the content fingerprints of all the pages
+     *
+     *  The objects are read from the source serially, then the
+     *  pages are hashed concurrently by the executor of the document.
+     *  The streams are hashed straight from the source, when it's
+     *  contiguous in memory, otherwise they are loaded as they are
+     */
+    std::vector<uint64_t> ComputePageHashes();
+
+public:
+    /** Compute a byte level fingerprint of the data of a device
+     *
+     *  It's much cheaper than the content fingerprint,
+     *  but it changes with any rewrite of the file
+     */
+    static uint64_t ComputeDataHash(InputStreamDevice& device);
+
+    static uint64_t ComputeDataHash(const bufferview& data);
+
+private:
+    /** Get the stream data of an object not loaded yet, as
+     *  PdfObject::TryGetRawStreamView(), reading the source
+     */
+    static bool tryGetRawStreamView(const PdfObject& obj, bufferview& view);
+
+private:
+    PdfDocument* m_doc;
+};
+
+};
+
+#endif // PDF_DOCUMENT_HASHER_H
@@ -0,0 +1,198 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfDocumentInfoProbe.h"
+
+#include "PdfIndirectObjectList.h"
+#include "PdfObjectStreamParser.h"
+#include "PdfParser.h"
+#include "PdfParserObject.h"
+#include "PdfStreamDevice.h"
+
+using namespace std;
+using namespace mm;
+
+PdfDocumentInfoProbe::PdfDocumentInfoProbe()
+{
+    reset();
+}
+
+void PdfDocumentInfoProbe::Load(const string_view& filename)
+{
+    if (filename.length() == 0)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    FileStreamDevice device(filename);
+    LoadFromDevice(device);
+}
+
+void PdfDocumentInfoProbe::LoadFromBuffer(const bufferview& buffer)
+{
+    if (buffer.size() == 0)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    SpanStreamDevice device(buffer);
+    LoadFromDevice(device);
+}
+
+void PdfDocumentInfoProbe::LoadFromDevice(InputStreamDevice& device)
+{
+    reset();
+
+    unique_ptr<PdfObject> trailer;
+    {
+        // Read only the xref sections and the trailers. The
+        // objects list stays empty, it's just required by the parser
+        PdfIndirectObjectList objects;
+        PdfParser parser(objects);
+        if (!parser.IsPdfFile(device))
+            PDFMM_RAISE_ERROR(PdfErrorCode::NoPdfFile);
+
+        parser.ReadDocumentStructure(device);
+        m_PdfVersion = parser.GetPdfVersion();
+        m_entries = std::move(parser.m_entries);
+        trailer.reset(new PdfObject(parser.GetTrailer()));
+    }
+
+    auto encryptObj = trailer->GetDictionary().GetKey("Encrypt");
+    m_IsEncrypted = encryptObj != nullptr && !encryptObj->IsNull();
+
+    try
+    {
+        auto catalogObj = trailer->GetDictionary().GetKey("Root");
+        if (catalogObj == nullptr)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "The trailer has no /Root key");
+
+        auto catalog = resolve(device, *catalogObj);
+        auto versionObj = catalog->GetDictionary().GetKey("Version");
+        if (versionObj != nullptr && versionObj->IsName())
+        {
+            auto version = mm::GetPdfVersion(versionObj->GetName().GetString());
+            if (version != PdfVersion::Unknown)
+                m_PdfVersion = version;
+        }
+
+        auto pagesObj = catalog->GetDictionary().GetKey("Pages");
+        if (pagesObj != nullptr)
+        {
+            auto pages = resolve(device, *pagesObj);
+            auto countObj = pages->GetDictionary().GetKey("Count");
+            int64_t count;
+            if (countObj != nullptr && resolve(device, *countObj)->TryGetNumber(count) && count > 0)
+                m_PageCount = (unsigned)count;
+        }
+    }
+    catch (PdfError& e)
+    {
+        // The objects of encrypted files may be in
+        // object streams that can't be decoded here
+        if (!m_IsEncrypted)
+        {
+            PDFMM_PUSH_FRAME_INFO(e, "Unable to read the page tree root");
+            throw e;
+        }
+
+        mm::LogMessage(PdfLogSeverity::Warning, "Unable to read the page count of the encrypted file");
+    }
+
+    auto infoObj = trailer->GetDictionary().GetKey("Info");
+    if (infoObj != nullptr && !m_IsEncrypted)
+    {
+        auto info = resolve(device, *infoObj);
+        PdfDictionary* dict;
+        if (info->TryGetDictionary(dict))
+        {
+            for (auto& pair : *dict)
+                m_Info.AddKey(pair.first, *resolve(device, pair.second));
+
+            m_HasInfo = true;
+        }
+    }
+
+    // Release the xref entries, they are not needed anymore
+    m_entries.Clear();
+}
+
+void PdfDocumentInfoProbe::reset()
+{
+    m_entries.Clear();
+    m_PdfVersion = PdfVersion::Unknown;
+    m_PageCount = 0;
+    m_IsEncrypted = false;
+    m_HasInfo = false;
+    m_Info.Clear();
+}
+
+unique_ptr<PdfObject> PdfDocumentInfoProbe::readObject(InputStreamDevice& device, const PdfReference& ref)
+{
+    if (ref.ObjectNumber() >= m_entries.GetSize())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Object {} is not in the xref entries", ref.ToString());
+
+    auto& entry = m_entries[ref.ObjectNumber()];
+    if (!entry.Parsed)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Object {} is not in the xref entries", ref.ToString());
+
+    switch (entry.Type)
+    {
+        case XRefEntryType::InUse:
+        {
+            // The object is not bound to a document, so
+            // the references it contains are not resolved
+            unique_ptr<PdfParserObject> obj(new PdfParserObject(nullptr, ref, device, (ssize_t)entry.Offset));
+            // NOTE: Access the variant to read the object now
+            (void)obj->GetDataType();
+            return obj;
+        }
+        case XRefEntryType::Compressed:
+        {
+            return readCompressedObject(device, ref.ObjectNumber(), (uint32_t)entry.ObjectNumber);
+        }
+        default:
+        {
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Object {} is free", ref.ToString());
+        }
+    }
+}
+
+unique_ptr<PdfObject> PdfDocumentInfoProbe::readCompressedObject(InputStreamDevice& device, uint32_t objNum, uint32_t streamNum)
+{
+    if (streamNum >= m_entries.GetSize())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Object stream {} 0 R is not in the xref entries", streamNum);
+
+    auto& entry = m_entries[streamNum];
+    if (!entry.Parsed || entry.Type != XRefEntryType::InUse)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Object stream {} 0 R is not in the xref entries", streamNum);
+
+    PdfParserObject stream(nullptr, PdfReference(streamNum, 0), device, (ssize_t)entry.Offset);
+    auto& dict = stream.GetDictionary();
+
+    // Resolve an indirect stream length, as the
+    // stream object is not bound to a document
+    auto lengthObj = dict.GetKey(PdfName::KeyLength);
+    if (lengthObj != nullptr && lengthObj->IsReference())
+        dict.AddKey(PdfName::KeyLength, *readObject(device, lengthObj->GetReference()));
+
+    stream.ParseStream();
+
+    PdfIndirectObjectList objects;
+    PdfObjectStreamParser parser(stream, objects, std::make_shared<charbuff>(PdfTokenizer::BufferSize));
+    PdfObjectStreamParser::ObjectList read;
+    parser.Read({ (int64_t)objNum }, read);
+    if (read.size() == 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Object {} 0 R not found in object stream {} 0 R", objNum, streamNum);
+
+    return std::move(read.front());
+}
+
+unique_ptr<PdfObject> PdfDocumentInfoProbe::resolve(InputStreamDevice& device, const PdfObject& obj)
+{
+    if (obj.IsReference())
+        return readObject(device, obj.GetReference());
+    else
+        return unique_ptr<PdfObject>(new PdfObject(obj));
+}
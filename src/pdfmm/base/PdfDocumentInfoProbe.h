@@ -0,0 +1,100 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_DOCUMENT_INFO_PROBE_H
+#define PDF_DOCUMENT_INFO_PROBE_H
+
+#include "PdfDeclarations.h"
+#include "PdfDictionary.h"
+#include "PdfXRefEntry.h"
+
+namespace mm {
+
+class InputStreamDevice;
+class PdfObject;
+class PdfReference;
+
+/**
+ * Read the basic information of a PDF file, that is the
+ * version, the page count, the encryption flag and the /Info
+ * dictionary, without loading the document.
+ *
+ * Only the xref sections, the trailers, the catalog, the
+ * page tree root and the /Info dictionary are read, and no object
+ * is created for the other xref entries. Object streams are decoded
+ * only if they contain one of the required objects
+ */
+class PDFMM_API PdfDocumentInfoProbe final
+{
+public:
+    PdfDocumentInfoProbe();
+
+    /** Read the information from a PDF file
+     *
+     *  \param filename filename of the file to read
+     */
+    void Load(const std::string_view& filename);
+
+    /** Read the information from a PDF file in memory
+     *
+     *  \param buffer the buffer containing the PDF file
+     */
+    void LoadFromBuffer(const bufferview& buffer);
+
+    /** Read the information from a PDF file from an input device
+     *
+     *  \param device the input device to read from
+     */
+    void LoadFromDevice(InputStreamDevice& device);
+
+public:
+    /** \returns the version of the file, as stated by the
+     *      header or by the /Version key of the catalog
+     */
+    inline PdfVersion GetPdfVersion() const { return m_PdfVersion; }
+
+    /** \returns the page count stated by the page tree root
+     */
+    inline unsigned GetPageCount() const { return m_PageCount; }
+
+    /** \returns true if the file is encrypted
+     */
+    inline bool IsEncrypted() const { return m_IsEncrypted; }
+
+    /** \returns the /Info dictionary of the file, or nullptr if it
+     *      has none. The strings of encrypted files are not decrypted,
+     *      so the dictionary is never available for them
+     */
+    inline const PdfDictionary* GetInfo() const { return m_HasInfo ? &m_Info : nullptr; }
+
+private:
+    void reset();
+
+    /** Read the indirect object with the given reference. Object
+     *  references in the read object are not resolved
+     */
+    std::unique_ptr<PdfObject> readObject(InputStreamDevice& device, const PdfReference& ref);
+
+    std::unique_ptr<PdfObject> readCompressedObject(InputStreamDevice& device, uint32_t objNum, uint32_t streamNum);
+
+    /** Resolve the object if it's a reference, otherwise
+     *  copy it in a new object
+     */
+    std::unique_ptr<PdfObject> resolve(InputStreamDevice& device, const PdfObject& obj);
+
+private:
+    PdfXRefEntries m_entries;
+    PdfVersion m_PdfVersion;
+    unsigned m_PageCount;
+    bool m_IsEncrypted;
+    bool m_HasInfo;
+    PdfDictionary m_Info;
+};
+
+};
+
+#endif // PDF_DOCUMENT_INFO_PROBE_H
@@ -0,0 +1,300 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfDocumentSplitter.h"
+
+#include <unordered_map>
+
+#include "PdfArray.h"
+#include "PdfMemDocument.h"
+#include "PdfPage.h"
+#include "PdfPageCollection.h"
+#include "PdfStreamDevice.h"
+#include "PdfWriter.h"
+#include "PdfXRef.h"
+
+using namespace std;
+using namespace mm;
+
+static constexpr uint32_t CatalogNumber = 1;
+static constexpr uint32_t PagesNumber = 2;
+
+namespace
+{
+    // Writes a trailer with only the catalog of the written pages
+    class SplitterXRef final : public PdfXRef
+    {
+    public:
+        SplitterXRef(PdfWriter& writer)
+            : PdfXRef(writer) { }
+
+    protected:
+        void EndWriteImpl(OutputStreamDevice& device, charbuff& buffer) override
+        {
+            PdfObject trailer;
+            auto& dict = trailer.GetDictionary();
+            dict.AddKey(PdfName::KeySize, static_cast<int64_t>(GetSize()));
+            dict.AddKey("Root", PdfReference(CatalogNumber, 0));
+            device.Write("trailer\n");
+            trailer.Write(device, GetWriter().GetWriteFlags(), nullptr, buffer);
+        }
+    };
+}
+
+static void renumberReferences(PdfObject& obj, const unordered_map<PdfReference, PdfReference>& references);
+
+PdfDocumentSplitter::PdfDocumentSplitter(PdfMemDocument& doc)
+    : m_doc(&doc)
+{
+    m_closures.resize(doc.GetPages().GetCount());
+    collectStops();
+}
+
+PdfDocumentSplitter::~PdfDocumentSplitter() { }
+
+void PdfDocumentSplitter::WritePages(const string_view& filename, unsigned pageIndex, unsigned pageCount,
+    PdfSaveOptions options)
+{
+    FileStreamDevice device(filename, FileMode::Create);
+    WritePages(device, pageIndex, pageCount, options);
+    device.Close();
+}
+
+void PdfDocumentSplitter::WritePages(OutputStreamDevice& device, unsigned pageIndex, unsigned pageCount,
+    PdfSaveOptions options)
+{
+    if (pageCount == 0 || pageIndex + pageCount > m_closures.size())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Invalid page range");
+
+    // Number the objects of all the pages. The objects shared by
+    // more pages in the range are written only once
+    unordered_map<PdfReference, PdfReference> references;
+    vector<const PdfObject*> objects;
+    vector<const PageClosure*> closures;
+    uint32_t number = PagesNumber + 1;
+    for (unsigned i = pageIndex; i < pageIndex + pageCount; i++)
+    {
+        auto& closure = getClosure(i);
+        closures.push_back(&closure);
+        for (auto obj : closure.Objects)
+        {
+            if (references.insert({ obj->GetIndirectReference(), PdfReference(number, 0) }).second)
+            {
+                objects.push_back(obj);
+                number++;
+            }
+        }
+    }
+
+    PdfWriter writer(m_doc->GetObjects(), m_doc->GetTrailer().GetObject());
+    writer.SetSaveOptions(options);
+    auto writeFlags = writer.GetWriteFlags();
+    SplitterXRef xref(writer);
+
+    utls::FormatTo(m_buffer, "%PDF-{}\n%\xe2\xe3\xcf\xd3\n", mm::GetPdfVersionName(m_doc->GetMetadata().GetPdfVersion()));
+    device.Write(m_buffer);
+
+    PdfObject catalog;
+    catalog.GetDictionary().AddKey(PdfName::KeyType, PdfName("Catalog"));
+    catalog.GetDictionary().AddKey("Pages", PdfReference(PagesNumber, 0));
+    xref.AddInUseObject(PdfReference(CatalogNumber, 0), device.GetPosition());
+    catalog.write(device, writeFlags, PdfReference(CatalogNumber, 0), nullptr, nullptr, m_buffer);
+
+    PdfObject pages;
+    PdfArray kids;
+    for (auto closure : closures)
+        kids.Add(references[closure->Objects[0]->GetIndirectReference()]);
+    pages.GetDictionary().AddKey(PdfName::KeyType, PdfName("Pages"));
+    pages.GetDictionary().AddKey("Kids", kids);
+    pages.GetDictionary().AddKey("Count", static_cast<int64_t>(pageCount));
+    xref.AddInUseObject(PdfReference(PagesNumber, 0), device.GetPosition());
+    pages.write(device, writeFlags, PdfReference(PagesNumber, 0), nullptr, nullptr, m_buffer);
+
+    // Write a copy of the data of the objects with the references
+    // replaced, while the streams are written from the source objects
+    unordered_map<const PdfObject*, const PageClosure*> pageClosures;
+    for (auto closure : closures)
+        pageClosures[closure->Objects[0]] = closure;
+
+    for (auto obj : objects)
+    {
+        PdfObject renumbered(obj->GetVariant());
+        auto found = pageClosures.find(obj);
+        if (found != pageClosures.end())
+        {
+            auto& dict = renumbered.GetDictionary();
+            for (auto& pair : found->second->Inherited)
+                dict.AddKey(pair.first, pair.second);
+        }
+
+        renumberReferences(renumbered, references);
+        if (found != pageClosures.end())
+            renumbered.GetDictionary().AddKey("Parent", PdfReference(PagesNumber, 0));
+
+        auto& reference = references[obj->GetIndirectReference()];
+        xref.AddInUseObject(reference, device.GetPosition());
+        obj->write(device, writeFlags, reference, &renumbered.m_Variant, nullptr, m_buffer);
+    }
+
+    xref.Write(device, m_buffer);
+    device.Flush();
+}
+
+unsigned PdfDocumentSplitter::GetPageCount() const
+{
+    return (unsigned)m_closures.size();
+}
+
+const PdfDocumentSplitter::PageClosure& PdfDocumentSplitter::getClosure(unsigned pageIndex)
+{
+    auto& closure = m_closures[pageIndex];
+    if (closure != nullptr)
+        return *closure;
+
+    const PdfName inheritableAttributes[] = {
+        PdfName("Resources"),
+        PdfName("MediaBox"),
+        PdfName("CropBox"),
+        PdfName("Rotate"),
+    };
+
+    closure.reset(new PageClosure());
+    auto& page = m_doc->GetPages().GetPage(pageIndex);
+    auto& pageObj = page.GetObject();
+    for (auto& name : inheritableAttributes)
+    {
+        if (pageObj.GetDictionary().HasKey(name))
+            continue;
+
+        auto attribute = page.GetInheritedKey(name);
+        if (attribute != nullptr)
+            closure->Inherited.AddKey(name, *attribute);
+    }
+
+    // Collect the objects reachable from the page and from the inherited
+    // attributes. The page tree nodes and the parent fields are not part
+    // of the page, and the references to other pages are not followed
+    auto& objects = closure->Objects;
+    unordered_set<PdfReference> visited;
+    visited.insert(pageObj.GetIndirectReference());
+    objects.push_back(&pageObj);
+    vector<const PdfObject*> stack;
+    auto collect = [&](const PdfObject& root) {
+        stack.push_back(&root);
+        while (stack.size() != 0)
+        {
+            auto child = stack.back();
+            stack.pop_back();
+            switch (child->GetDataType())
+            {
+                case PdfDataType::Reference:
+                {
+                    auto ref = child->GetReference();
+                    if (!visited.insert(ref).second || m_stops.find(ref) != m_stops.end())
+                        break;
+
+                    auto obj = m_doc->GetObjects().GetObject(ref);
+                    if (obj != nullptr)
+                        objects.push_back(obj);
+
+                    break;
+                }
+                case PdfDataType::Array:
+                {
+                    for (auto& item : child->GetArray())
+                        stack.push_back(&item);
+                    break;
+                }
+                case PdfDataType::Dictionary:
+                {
+                    for (auto& pair : child->GetDictionary())
+                    {
+                        if (pair.first != "Parent")
+                            stack.push_back(&pair.second);
+                    }
+                    break;
+                }
+                default:
+                {
+                    // Nothing to do
+                    break;
+                }
+            }
+        }
+    };
+
+    PdfObject inherited(closure->Inherited);
+    collect(inherited);
+    for (size_t i = 0; i < objects.size(); i++)
+        collect(*objects[i]);
+
+    return *closure;
+}
+
+void PdfDocumentSplitter::collectStops()
+{
+    auto& catalog = m_doc->GetCatalog().GetObject();
+    m_stops.insert(catalog.GetIndirectReference());
+    auto& pages = m_doc->GetPages();
+    m_stops.insert(pages.GetObject().GetIndirectReference());
+    for (unsigned i = 0; i < pages.GetCount(); i++)
+    {
+        // Also the intermediate page tree nodes are stops
+        const PdfObject* node = &pages.GetPage(i).GetObject();
+        PdfReference ref;
+        while (node != nullptr && m_stops.insert(node->GetIndirectReference()).second)
+        {
+            auto parent = node->GetDictionary().GetKey("Parent");
+            if (parent == nullptr || !parent->TryGetReference(ref))
+                break;
+
+            node = m_doc->GetObjects().GetObject(ref);
+        }
+    }
+}
+
+void renumberReferences(PdfObject& obj, const unordered_map<PdfReference, PdfReference>& references)
+{
+    // References to objects that are not written are replaced with null
+    vector<PdfObject*> stack;
+    stack.push_back(&obj);
+    while (stack.size() != 0)
+    {
+        auto child = stack.back();
+        stack.pop_back();
+        switch (child->GetDataType())
+        {
+            case PdfDataType::Reference:
+            {
+                auto found = references.find(child->GetReference());
+                if (found == references.end())
+                    *child = PdfObject(PdfVariant::NullValue);
+                else
+                    child->SetReference(found->second);
+                break;
+            }
+            case PdfDataType::Array:
+            {
+                for (auto& item : child->GetArray())
+                    stack.push_back(&item);
+                break;
+            }
+            case PdfDataType::Dictionary:
+            {
+                for (auto& pair : child->GetDictionary())
+                    stack.push_back(&pair.second);
+                break;
+            }
+            default:
+            {
+                // Nothing to do
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,97 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_DOCUMENT_SPLITTER_H
+#define PDF_DOCUMENT_SPLITTER_H
+
+#include "PdfDeclarations.h"
+
+#include <unordered_set>
+
+#include "PdfDictionary.h"
+#include "PdfReference.h"
+
+namespace mm {
+
+class PdfMemDocument;
+class PdfObject;
+class OutputStreamDevice;
+
+/**
+ * Write ranges of pages of a document as new documents, without
+ * copying the document in memory.
+ *
+ * The objects used by each page are collected only once, the first
+ * time the page is written, and the objects shared by more pages,
+ * e.g. fonts, are written by reference from the source document.
+ * The streams not loaded yet are copied as they are from the source
+ * file. The outlines, the AcroForm and the other document-level
+ * objects are not written, and the references to objects not
+ * in the written pages are replaced with null.
+ *
+ * The document must not be modified while the splitter is in use
+ */
+class PDFMM_API PdfDocumentSplitter final
+{
+public:
+    /** Create a splitter for the pages of the given document
+     */
+    PdfDocumentSplitter(PdfMemDocument& doc);
+
+    ~PdfDocumentSplitter();
+
+    /** Write the given range of pages as a new document
+     *
+     *  \param device the device to write to
+     *  \param pageIndex the index of the first page to write
+     *  \param pageCount the number of pages to write
+     *  \param options the save options, only the ones about the
+     *      formatting of the objects are supported
+     */
+    void WritePages(OutputStreamDevice& device, unsigned pageIndex, unsigned pageCount = 1,
+        PdfSaveOptions options = PdfSaveOptions::None);
+
+    /** Write the given range of pages as a new document
+     *
+     *  \param filename filename of the document to write
+     *  \see WritePages
+     */
+    void WritePages(const std::string_view& filename, unsigned pageIndex, unsigned pageCount = 1,
+        PdfSaveOptions options = PdfSaveOptions::None);
+
+    /** \returns the page count of the document
+     */
+    unsigned GetPageCount() const;
+
+private:
+    PdfDocumentSplitter(const PdfDocumentSplitter&) = delete;
+    PdfDocumentSplitter& operator=(const PdfDocumentSplitter&) = delete;
+
+private:
+    struct PageClosure
+    {
+        // The inherited attributes not present in the page dictionary
+        PdfDictionary Inherited;
+        // The page object first, then all the objects reachable from it
+        std::vector<const PdfObject*> Objects;
+    };
+
+    const PageClosure& getClosure(unsigned pageIndex);
+
+    void collectStops();
+
+private:
+    PdfMemDocument* m_doc;
+    std::vector<std::unique_ptr<PageClosure>> m_closures;
+    // The catalog, the page tree nodes and the pages, where collecting stops
+    std::unordered_set<PdfReference> m_stops;
+    charbuff m_buffer;
+};
+
+};
+
+#endif // PDF_DOCUMENT_SPLITTER_H
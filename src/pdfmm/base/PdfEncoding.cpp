@@ -8,6 +8,7 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfEncoding.h"
 
+#include <array>
 #include <atomic>
 #include <utfcpp/utf8.h>
 
@@ -15,11 +16,27 @@
 
 #include "PdfDocument.h"
 #include "PdfDictionary.h"
+#include "PdfCMapEncoding.h"
 #include "PdfEncodingMapFactory.h"
 
 using namespace std;
 using namespace mm;
 
+// Markers of the one byte table entries that have no
+// code point or that need the encoding map lookup
+constexpr char32_t NoCodePoint = U'\xFFFFFFFF';
+constexpr char32_t MultipleCodePoints = U'\xFFFFFFFE';
+
+struct PdfEncoding::OneByteTable
+{
+    // The code point of every char code
+    array<char32_t, 256> CodePoints;
+    // The char code of every ASCII code point, or -1 if
+    // missing. Only valid if HasAsciiCodes is true
+    array<short, 128> AsciiCodes;
+    bool HasAsciiCodes;
+};
+
 static PdfCharCode fetchFallbackCharCode(string_view::iterator& it, const string_view::iterator& end, const PdfEncodingLimits& limits);
 
 PdfEncoding::PdfEncoding()
@@ -39,6 +56,8 @@ PdfEncoding::PdfEncoding(size_t id, const PdfEncodingMapConstPtr& encoding, cons
 {
     if (encoding == nullptr)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Main encoding must be not null");
+
+    initOneByteTable();
 }
 
 PdfEncoding::PdfEncoding(const PdfObject& fontObj, const PdfEncodingMapConstPtr& encoding, const PdfEncodingMapConstPtr& toUnicode)
@@ -100,6 +119,9 @@ bool PdfEncoding::TryConvertToEncoded(const string_view& str, charbuff& encoded)
         if (!GetToUnicodeMapSafe(toUnicode))
             return false;
 
+        if (m_OneByteTable != nullptr && m_OneByteTable->HasAsciiCodes)
+            return tryConvertUtf8ToOneByte(str, encoded);
+
         auto it = str.begin();
         auto end = str.end();
         while (it != end)
@@ -162,7 +184,11 @@ bool PdfEncoding::tryGetCharCode(PdfFont& font, unsigned gid, const unicodeview&
 {
     if (font.IsSubsettingEnabled())
     {
-        codeUnit = font.AddSubsetGIDSafe(gid, codePoints).Unit;
+        PdfCID cid;
+        if (!font.TryAddSubsetGIDSafe(gid, codePoints, cid))
+            return false;
+
+        codeUnit = cid.Unit;
         return true;
     }
     else
@@ -188,6 +214,9 @@ bool PdfEncoding::tryConvertEncodedToUtf8(const string_view& encoded, string& st
     if (encoded.empty())
         return true;
 
+    if (m_OneByteTable != nullptr)
+        return tryConvertOneByteToUtf8(encoded, str);
+
     auto& map = GetToUnicodeMapSafe();
     auto& limits = map.GetLimits();
     bool success = true;
@@ -217,6 +246,81 @@ bool PdfEncoding::tryConvertEncodedToUtf8(const string_view& encoded, string& st
     return success;
 }
 
+bool PdfEncoding::tryConvertOneByteToUtf8(const string_view& encoded, string& str) const
+{
+    auto& codePointTable = m_OneByteTable->CodePoints;
+    bool success = true;
+    vector<char32_t> codePoints;
+    str.reserve(encoded.size());
+    for (size_t i = 0; i < encoded.size(); i++)
+    {
+        unsigned char code = (unsigned char)encoded[i];
+        char32_t codePoint = codePointTable[code];
+        if (codePoint < 0x80)
+        {
+            // Most char codes of Western-language text map to ASCII
+            if (codePoint != U'\0')
+                str.push_back((char)codePoint);
+
+            continue;
+        }
+
+        if (codePoint == NoCodePoint)
+        {
+            // Same fallback as fetchFallbackCharCode() with one byte codes
+            success = false;
+            codePoint = code;
+        }
+        else if (codePoint == MultipleCodePoints)
+        {
+            (void)GetToUnicodeMapSafe().TryGetCodePoints(PdfCharCode(code, 1), codePoints);
+            for (size_t j = 0; j < codePoints.size(); j++)
+            {
+                if (codePoints[j] != U'\0' && utf8::internal::is_code_point_valid(codePoints[j]))
+                    utf8::unchecked::append((uint32_t)codePoints[j], std::back_inserter(str));
+            }
+
+            continue;
+        }
+
+        if (codePoint != U'\0' && utf8::internal::is_code_point_valid(codePoint))
+            utf8::unchecked::append((uint32_t)codePoint, std::back_inserter(str));
+    }
+
+    return success;
+}
+
+bool PdfEncoding::tryConvertUtf8ToOneByte(const string_view& str, charbuff& encoded) const
+{
+    auto& toUnicode = GetToUnicodeMapSafe();
+    auto& asciiCodes = m_OneByteTable->AsciiCodes;
+    encoded.reserve(str.size());
+    auto it = str.begin();
+    auto end = str.end();
+    PdfCharCode code;
+    while (it != end)
+    {
+        unsigned char ch = (unsigned char)*it;
+        if (ch < 0x80)
+        {
+            short asciiCode = asciiCodes[ch];
+            if (asciiCode < 0)
+                return false;
+
+            encoded.push_back((char)asciiCode);
+            it++;
+            continue;
+        }
+
+        if (!toUnicode.TryGetNextCharCode(it, end, code))
+            return false;
+
+        code.AppendTo(encoded);
+    }
+
+    return true;
+}
+
 vector<PdfCID> PdfEncoding::ConvertToCIDs(const PdfString& encodedStr) const
 {
     // Just ignore failures
@@ -291,6 +395,55 @@ bool PdfEncoding::tryConvertEncodedToCIDs(const string_view& encoded, vector<Pdf
     return success;
 }
 
+// Build the tables only for the maps that can't change
+// later, that are the simple encodings and the parsed
+// CMaps, and only when all the char codes are one byte
+void PdfEncoding::initOneByteTable()
+{
+    const PdfEncodingMap* toUnicode;
+    if (!GetToUnicodeMapSafe(toUnicode))
+        return;
+
+    if (toUnicode->GetType() != PdfEncodingMapType::Simple
+        && dynamic_cast<const PdfCMapEncoding*>(toUnicode) == nullptr)
+    {
+        return;
+    }
+
+    auto& limits = toUnicode->GetLimits();
+    if (limits.MinCodeSize != 1 || limits.MaxCodeSize != 1)
+        return;
+
+    auto table = std::make_shared<OneByteTable>();
+    vector<char32_t> codePoints;
+    for (unsigned i = 0; i < 256; i++)
+    {
+        if (!toUnicode->TryGetCodePoints(PdfCharCode(i, 1), codePoints))
+            table->CodePoints[i] = NoCodePoint;
+        else if (codePoints.size() != 1 || codePoints[0] >= MultipleCodePoints)
+            table->CodePoints[i] = MultipleCodePoints;
+        else
+            table->CodePoints[i] = codePoints[0];
+    }
+
+    // The reverse lookup of ligatures needs the following
+    // code points, so there's no table for those maps
+    table->HasAsciiCodes = !toUnicode->HasLigaturesSupport();
+    if (table->HasAsciiCodes)
+    {
+        PdfCharCode code;
+        for (unsigned i = 0; i < 128; i++)
+        {
+            if (toUnicode->TryGetCharCode((char32_t)i, code))
+                table->AsciiCodes[i] = (short)code.Code;
+            else
+                table->AsciiCodes[i] = -1;
+        }
+    }
+
+    m_OneByteTable = std::move(table);
+}
+
 const PdfCharCode& PdfEncoding::GetFirstChar() const
 {
     auto& limits = GetLimits();
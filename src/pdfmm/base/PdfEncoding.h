@@ -180,8 +180,13 @@ namespace mm
         static size_t GetNextId();
 
     private:
+        struct OneByteTable;
+
+        void initOneByteTable();
         bool tryExportObjectTo(PdfDictionary& dictionary, bool wantCidMapping) const;
         bool tryConvertEncodedToUtf8(const std::string_view& encoded, std::string& str) const;
+        bool tryConvertOneByteToUtf8(const std::string_view& encoded, std::string& str) const;
+        bool tryConvertUtf8ToOneByte(const std::string_view& str, charbuff& encoded) const;
         bool tryConvertEncodedToCIDs(const std::string_view& encoded, std::vector<PdfCID>& cids) const;
         void writeCIDMapping(PdfObject& cmapObj, const PdfFont& font, const std::string_view& baseFont) const;
         void writeToUnicodeCMap(PdfObject& cmapObj) const;
@@ -192,6 +197,8 @@ namespace mm
         PdfEncodingMapConstPtr m_Encoding;
         PdfEncodingMapConstPtr m_ToUnicode;
         PdfEncodingLimits m_Limits;
+        // Precomputed lookups of one byte encodings, or null
+        std::shared_ptr<const OneByteTable> m_OneByteTable;
     };
 }
 
@@ -18,6 +18,32 @@
 using namespace std;
 using namespace mm;
 
+// Write the ToUnicode entries coalescing the codes mapped to
+// consecutive code points in bfrange entries, in blocks of
+// at most 100 entries as required by the CMap specification
+class ToUnicodeWriter
+{
+public:
+    ToUnicodeWriter();
+public:
+    void Add(const PdfCharCode& code, const unicodeview& codePoints);
+    void WriteTo(PdfObjectStream& stream);
+private:
+    void flushPending();
+    static void appendBlocks(PdfObjectStream& stream, const vector<string>& entries, const string_view& type);
+private:
+    vector<string> m_chars;
+    vector<string> m_ranges;
+    PdfCharCode m_firstCode;
+    PdfCharCode m_lastCode;
+    vector<char32_t> m_codePoints;    // Code points of the first code of the pending entry
+    bool m_pending;
+    string m_temp;
+    u16string m_u16tmp;
+};
+
+static void writeUTF16CodeTo(string& str, const unicodeview& codePoints, u16string& u16tmp);
+
 PdfEncodingMap::PdfEncodingMap(PdfEncodingMapType type)
     : m_Type(type) { }
 
@@ -246,29 +272,9 @@ bool PdfEncodingMap::tryGetNextCodePoints(string_view::iterator& it, const strin
 
 void PdfEncodingMap::AppendUTF16CodeTo(PdfObjectStream& stream, const unicodeview& codePoints, u16string& u16tmp)
 {
-    char hexbuf[2];
-    stream.Append("<");
-    bool first = true;
-    for (unsigned i = 0; i < codePoints.size(); i++)
-    {
-        if (first)
-            first = false;
-        else
-            stream.Append(" "); // Separate each character in the ligatures
-
-        char32_t cp = codePoints[i];
-        utls::WriteUtf16BETo(u16tmp, cp);
-
-        auto data = (const char*)u16tmp.data();
-        size_t size = u16tmp.size() * sizeof(char16_t);
-        for (unsigned l = 0; l < size; l++)
-        {
-            // Append hex codes of the converted utf16 string
-            utls::WriteCharHexTo(hexbuf, data[l]);
-            stream.AppendBuffer(hexbuf, std::size(hexbuf));
-        }
-    }
-    stream.Append(">");
+    string str;
+    writeUTF16CodeTo(str, codePoints, u16tmp);
+    stream.Append(str);
 }
 
 void PdfEncodingMap::AppendCodeSpaceRange(PdfObjectStream& stream) const
@@ -349,20 +355,11 @@ void PdfEncodingMapBase::AppendCodeSpaceRange(PdfObjectStream& stream) const
 
 void PdfEncodingMapBase::AppendToUnicodeEntries(PdfObjectStream& stream) const
 {
-    // Very easy, just do a list of bfchar
-    // Use PdfEncodingMap::AppendUTF16CodeTo
-    u16string u16temp;
-    string temp = std::to_string(m_charMap->GetSize());
-    stream.Append(temp).Append(" beginbfchar\n");
+    ToUnicodeWriter writer;
     for (auto& pair : *m_charMap)
-    {
-        pair.first.WriteHexTo(temp);
-        stream.Append(temp);
-        stream.Append(" ");
-        PdfEncodingMap::AppendUTF16CodeTo(stream, pair.second, u16temp);
-        stream.Append("\n");
-    }
-    stream.Append("endbfchar");
+        writer.Add(pair.first, pair.second);
+
+    writer.WriteTo(stream);
 }
 
 PdfEncodingMapBase::PdfEncodingMapBase(const shared_ptr<PdfCharCodeMap>& map, PdfEncodingMapType type)
@@ -408,23 +405,16 @@ void PdfEncodingMapOneByte::AppendToUnicodeEntries(PdfObjectStream& stream) cons
     vector<char32_t> codePoints;
     unsigned code = limits.FirstChar.Code;
     unsigned lastCode = limits.LastChar.Code;
-    string codeStr;
-    stream.Append("1 beginbfrange\n");
-    limits.FirstChar.WriteHexTo(codeStr);
-    stream.Append(codeStr).Append(" ");
-    limits.LastChar.WriteHexTo(codeStr);
-    stream.Append(codeStr).Append(" [\n");
-    u16string u16tmp;
-    for (; code < lastCode; code++)
+    ToUnicodeWriter writer;
+    for (; code <= lastCode; code++)
     {
         if (!TryGetCodePoints(PdfCharCode(code), codePoints))
             PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "Unable to find character code");
 
-        AppendUTF16CodeTo(stream, codePoints, u16tmp);
-        stream.Append("\n");
+        writer.Add(PdfCharCode(code), codePoints);
     }
-    stream.Append("]\n");
-    stream.Append("endbfrange");
+
+    writer.WriteTo(stream);
 }
 
 void PdfEncodingMapOneByte::AppendCIDMappingEntries(PdfObjectStream& stream, const PdfFont& font) const
@@ -518,31 +508,44 @@ PdfBuiltInEncoding::PdfBuiltInEncoding(const PdfName& name)
 {
 }
 
-void PdfBuiltInEncoding::InitEncodingTable()
+void PdfBuiltInEncoding::initEncodingTable() const
 {
-    if (!m_EncodingTable.empty())
-        return;
-
-    const char32_t* cpUnicodeTable = this->GetToUnicodeTable();
-    for (size_t i = 0; i < 256; i++)
+    std::call_once(m_EncodingTableInit, [this]()
     {
-        // fill the table with data
-        m_EncodingTable[cpUnicodeTable[i]] =
-            static_cast<unsigned char>(i);
-    }
+        const char32_t* cpUnicodeTable = this->GetToUnicodeTable();
+        vector<pair<char32_t, unsigned char>> entries;
+        entries.reserve(256);
+        for (unsigned i = 0; i < 256; i++)
+            entries.push_back({ cpUnicodeTable[i], (unsigned char)i });
+
+        // NOTE: The stable sort keeps the codes of a code point in
+        // ascending order, then only the last one is kept
+        std::stable_sort(entries.begin(), entries.end(),
+            [](const pair<char32_t, unsigned char>& lhs, const pair<char32_t, unsigned char>& rhs) {
+                return lhs.first < rhs.first;
+            });
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (i + 1 == entries.size() || entries[i + 1].first != entries[i].first)
+                m_EncodingTable.push_back(entries[i]);
+        }
+    });
 }
 
 bool PdfBuiltInEncoding::tryGetCharCode(char32_t codePoint, PdfCharCode& codeUnit) const
 {
-    const_cast<PdfBuiltInEncoding*>(this)->InitEncodingTable();
-    auto found = m_EncodingTable.find(codePoint);
-    if (found == m_EncodingTable.end())
+    initEncodingTable();
+    auto found = std::lower_bound(m_EncodingTable.begin(), m_EncodingTable.end(), codePoint,
+        [](const pair<char32_t, unsigned char>& entry, char32_t codePoint) {
+            return entry.first < codePoint;
+        });
+    if (found == m_EncodingTable.end() || found->first != codePoint)
     {
         codeUnit = { };
         return false;
     }
 
-    codeUnit = { (unsigned char)found->second, 1 };
+    codeUnit = { found->second, 1 };
     return true;
 }
 
@@ -555,3 +558,111 @@ bool PdfBuiltInEncoding::tryGetCodePoints(const PdfCharCode& codeUnit, vector<ch
     codePoints.push_back(cpUnicodeTable[codeUnit.Code]);
     return true;
 }
+
+ToUnicodeWriter::ToUnicodeWriter()
+    : m_pending(false) { }
+
+void ToUnicodeWriter::Add(const PdfCharCode& code, const unicodeview& codePoints)
+{
+    if (m_pending && codePoints.size() == 1 && m_codePoints.size() == 1
+        && code.CodeSpaceSize == m_lastCode.CodeSpaceSize
+        && code.Code == m_lastCode.Code + 1
+        && (code.Code & 0xFF) != 0)
+    {
+        // Only the last byte of the source and of the destination can
+        // vary in a bfrange, so the code points must be in the BMP,
+        // where they are a single UTF-16 code unit, and the codes and the
+        // code points must not cross the boundary of their last byte
+        char32_t codePoint = m_codePoints[0] + (code.Code - m_firstCode.Code);
+        if (codePoints[0] == codePoint && codePoint <= 0xFFFF && (codePoint & 0xFF) != 0
+            && (codePoint < 0xD800 || codePoint > 0xDFFF))
+        {
+            m_lastCode = code;
+            return;
+        }
+    }
+
+    flushPending();
+    m_firstCode = code;
+    m_lastCode = code;
+    m_codePoints.assign(codePoints.begin(), codePoints.end());
+    m_pending = true;
+}
+
+void ToUnicodeWriter::WriteTo(PdfObjectStream& stream)
+{
+    flushPending();
+    appendBlocks(stream, m_chars, "bfchar");
+    if (m_chars.size() != 0 && m_ranges.size() != 0)
+        stream.Append("\n");
+
+    appendBlocks(stream, m_ranges, "bfrange");
+}
+
+void ToUnicodeWriter::flushPending()
+{
+    if (!m_pending)
+        return;
+
+    string entry;
+    m_firstCode.WriteHexTo(m_temp);
+    entry.append(m_temp).append(" ");
+    if (m_lastCode.Code != m_firstCode.Code)
+    {
+        m_lastCode.WriteHexTo(m_temp);
+        entry.append(m_temp).append(" ");
+        writeUTF16CodeTo(entry, m_codePoints, m_u16tmp);
+        m_ranges.push_back(std::move(entry));
+    }
+    else
+    {
+        writeUTF16CodeTo(entry, m_codePoints, m_u16tmp);
+        m_chars.push_back(std::move(entry));
+    }
+
+    m_pending = false;
+}
+
+void ToUnicodeWriter::appendBlocks(PdfObjectStream& stream, const vector<string>& entries, const string_view& type)
+{
+    constexpr size_t MaxBlockSize = 100;
+    for (size_t i = 0; i < entries.size(); i += MaxBlockSize)
+    {
+        if (i != 0)
+            stream.Append("\n");
+
+        size_t blockSize = std::min(MaxBlockSize, entries.size() - i);
+        stream.Append(std::to_string(blockSize)).Append(" begin").Append(type).Append("\n");
+        for (size_t j = i; j < i + blockSize; j++)
+            stream.Append(entries[j]).Append("\n");
+
+        stream.Append("end").Append(type);
+    }
+}
+
+void writeUTF16CodeTo(string& str, const unicodeview& codePoints, u16string& u16tmp)
+{
+    char hexbuf[2];
+    str.push_back('<');
+    bool first = true;
+    for (unsigned i = 0; i < codePoints.size(); i++)
+    {
+        if (first)
+            first = false;
+        else
+            str.push_back(' '); // Separate each character in the ligatures
+
+        char32_t cp = codePoints[i];
+        utls::WriteUtf16BETo(u16tmp, cp);
+
+        auto data = (const char*)u16tmp.data();
+        size_t size = u16tmp.size() * sizeof(char16_t);
+        for (unsigned l = 0; l < size; l++)
+        {
+            // Append hex codes of the converted utf16 string
+            utls::WriteCharHexTo(hexbuf, data[l]);
+            str.append(hexbuf, std::size(hexbuf));
+        }
+    }
+    str.push_back('>');
+}
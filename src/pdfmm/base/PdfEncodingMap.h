@@ -10,6 +10,9 @@
 #define PDF_ENCODING_MAP_H
 
 #include "PdfDeclarations.h"
+
+#include <mutex>
+
 #include "PdfObject.h"
 #include "PdfName.h"
 #include "PdfCharCodeMap.h"
@@ -209,7 +212,7 @@ public:
 
     const PdfEncodingLimits& GetLimits() const override;
 
-private:
+protected:
     PdfEncodingMapBase(const std::shared_ptr<PdfCharCodeMap>& map, PdfEncodingMapType type);
 
 private:
@@ -269,13 +272,16 @@ protected:
 
 private:
     /** Initialize the internal table of mappings from Unicode code points
-     *  to encoded byte values.
+     *  to encoded byte values, once also when called concurrently
      */
-    void InitEncodingTable();
+    void initEncodingTable() const;
 
 private:
     PdfName m_Name;         // The name of the encoding
-    std::unordered_map<char32_t, char> m_EncodingTable; // The helper table for conversions into this encoding
+    mutable std::once_flag m_EncodingTableInit;
+    // The helper table for conversions into this encoding,
+    // sorted by code point. The last code of a code point wins
+    mutable std::vector<std::pair<char32_t, unsigned char>> m_EncodingTable;
 };
 
 /** Dummy encoding map that will just throw exception
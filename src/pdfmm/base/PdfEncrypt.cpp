@@ -50,6 +50,9 @@ PdfEncryptAlgorithm::AESV2;
 #define AES_IV_LENGTH 16
 #define AES_BLOCK_SIZE 16
 
+// The maximum count of the cached object keys, about 64 bytes each
+static constexpr size_t MaxObjectKeyCount = 65536;
+
 namespace mm
 {
 
@@ -76,30 +79,54 @@ private:
     EVP_CIPHER_CTX *aes;
 };
 
-// A class that holds the RC4 Crypto object
-// Either CCCrpytor or EVP_CIPHER_CTX
-class RC4CryptoEngine
+// The cipher contexts of the thread, one for every cipher and direction.
+// A context is initialized with its cipher only the first time, then
+// every use sets just the key and the initial vector, so the cipher
+// is not fetched and set up again for every string and stream
+class CipherContexts final
 {
 public:
-
-    RC4CryptoEngine()
+    ~CipherContexts()
     {
-        rc4 = EVP_CIPHER_CTX_new();
+        for (auto& context : m_contexts)
+            EVP_CIPHER_CTX_free(context.Context);
     }
 
-    EVP_CIPHER_CTX* getEngine()
+    EVP_CIPHER_CTX* Get(const EVP_CIPHER* cipher, bool encrypt)
     {
-        return rc4;
+        for (auto& context : m_contexts)
+        {
+            if (context.Cipher == cipher && context.Encrypt == encrypt)
+                return context.Context;
+        }
+
+        EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+        if (ctx == nullptr)
+            PDFMM_RAISE_ERROR(PdfErrorCode::OutOfMemory);
+
+        if (EVP_CipherInit_ex(ctx, cipher, nullptr, nullptr, nullptr, encrypt ? 1 : 0) != 1)
+        {
+            EVP_CIPHER_CTX_free(ctx);
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing cipher context");
+        }
+
+        m_contexts.push_back({ cipher, encrypt, ctx });
+        return ctx;
     }
 
-    ~RC4CryptoEngine()
+private:
+    struct Context
     {
-        EVP_CIPHER_CTX_free(rc4);
-    }
+        const EVP_CIPHER* Cipher;
+        bool Encrypt;
+        EVP_CIPHER_CTX* Context;
+    };
 
 private:
-    EVP_CIPHER_CTX* rc4;
+    vector<Context> m_contexts;
 };
+
+static thread_local CipherContexts s_cipherContexts;
     
 /** A class that can encrypt/decrpyt streamed data block wise
  *  This is used in the input and output stream encryption implementation.
@@ -109,7 +136,7 @@ class PdfRC4Stream
 {
 public:
     PdfRC4Stream(unsigned char rc4key[256], unsigned char rc4last[256],
-        unsigned char* key, unsigned keylen) :
+        const unsigned char* key, unsigned keylen) :
         m_a(0), m_b(0)
     {
         size_t i;
@@ -188,7 +215,7 @@ class PdfRC4OutputStream : public OutputStream
 {
 public:
     PdfRC4OutputStream(OutputStream& outputStream, unsigned char rc4key[256],
-        unsigned char rc4last[256], unsigned char* key, unsigned keylen) :
+        unsigned char rc4last[256], const unsigned char* key, unsigned keylen) :
         m_OutputStream(&outputStream), m_stream(rc4key, rc4last, key, keylen)
     {
     }
@@ -214,7 +241,7 @@ class PdfRC4InputStream : public InputStream
 {
 public:
     PdfRC4InputStream(InputStream& inputStream, size_t inputLen, unsigned char rc4key[256], unsigned char rc4last[256],
-        unsigned char* key, unsigned keylen) :
+        const unsigned char* key, unsigned keylen) :
         m_InputStream(&inputStream),
         m_inputLen(inputLen),
         m_stream(rc4key, rc4last, key, keylen) { }
@@ -243,7 +270,7 @@ private:
 class PdfAESInputStream : public InputStream
 {
 public:
-    PdfAESInputStream(InputStream& inputStream, size_t inputLen, unsigned char* key, unsigned keylen) :
+    PdfAESInputStream(InputStream& inputStream, size_t inputLen, const unsigned char* key, unsigned keylen) :
         m_InputStream(&inputStream),
         m_inputLen(inputLen),
         m_inputEof(false),
@@ -362,6 +389,116 @@ private:
     size_t m_drainLeft;
 };
 
+/** An OutputStream that encrypts all data written
+ *  using the AES encryption algorithm. The initialization
+ *  vector is written before the data, which is encrypted
+ *  in blocks of bounded size. The last block is padded
+ *  when the stream is flushed
+ */
+class PdfAESOutputStream : public OutputStream
+{
+    static constexpr size_t BufferSize = 16384;
+
+public:
+    PdfAESOutputStream(OutputStream& outputStream, const unsigned char* key, unsigned keylen,
+        const unsigned char iv[AES_IV_LENGTH]) :
+        m_OutputStream(&outputStream),
+        m_init(true),
+        m_finished(false)
+    {
+        const EVP_CIPHER* cipher;
+        switch (keylen)
+        {
+            case (unsigned)PdfKeyLength::L128 / 8:
+            {
+                cipher = EVP_aes_128_cbc();
+                break;
+            }
+#ifdef PDFMM_HAVE_LIBIDN
+            case (unsigned)PdfKeyLength::L256 / 8:
+            {
+                cipher = EVP_aes_256_cbc();
+                break;
+            }
+#endif
+            default:
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Invalid AES key length");
+        }
+
+        m_ctx = EVP_CIPHER_CTX_new();
+        if (m_ctx == nullptr)
+            PDFMM_RAISE_ERROR(PdfErrorCode::OutOfMemory);
+
+        if (EVP_EncryptInit_ex(m_ctx, cipher, nullptr, key, iv) != 1)
+        {
+            EVP_CIPHER_CTX_free(m_ctx);
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing AES encryption engine");
+        }
+
+        std::memcpy(m_iv, iv, AES_IV_LENGTH);
+    }
+
+    ~PdfAESOutputStream()
+    {
+        EVP_CIPHER_CTX_free(m_ctx);
+    }
+
+protected:
+    void writeBuffer(const char* buffer, size_t size) override
+    {
+        if (m_finished)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "The AES encrypted stream is already finished");
+
+        writeInitialVector();
+        while (size != 0)
+        {
+            size_t chunkSize = std::min(size, BufferSize);
+            int outlen;
+            if (EVP_EncryptUpdate(m_ctx, m_buffer, &outlen, (const unsigned char*)buffer, (int)chunkSize) != 1)
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error AES-encrypting data");
+
+            m_OutputStream->Write((const char*)m_buffer, (size_t)outlen);
+            buffer += chunkSize;
+            size -= chunkSize;
+        }
+    }
+
+    void flush() override
+    {
+        // NOTE: The stream may be flushed more than once,
+        // for example also by the filter writing to it
+        if (m_finished)
+            return;
+
+        writeInitialVector();
+        int outlen;
+        if (EVP_EncryptFinal_ex(m_ctx, m_buffer, &outlen) != 1)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error AES-encrypting data");
+
+        m_OutputStream->Write((const char*)m_buffer, (size_t)outlen);
+        m_finished = true;
+    }
+
+private:
+    void writeInitialVector()
+    {
+        if (!m_init)
+            return;
+
+        m_OutputStream->Write((const char*)m_iv, AES_IV_LENGTH);
+        m_init = false;
+    }
+
+private:
+    EVP_CIPHER_CTX* m_ctx;
+    OutputStream* m_OutputStream;
+    bool m_init;
+    bool m_finished;
+    unsigned char m_iv[AES_IV_LENGTH];
+    // Room for the encrypted data of a chunk plus a block
+    unsigned char m_buffer[BufferSize + AES_BLOCK_SIZE];
+};
+
 }
 
 PdfEncrypt::~PdfEncrypt() { }
@@ -748,6 +885,7 @@ void PdfEncryptMD5Base::ComputeEncryptionKey(const string_view& documentId,
     }
 
     std::memcpy(m_encryptionKey, digest, m_keyLength);
+    clearObjKeys();
 
     // Setup user key
     if (revision == 3 || revision == 4)
@@ -796,6 +934,19 @@ void PdfEncryptMD5Base::ComputeEncryptionKey(const string_view& documentId,
 
 void PdfEncryptMD5Base::CreateObjKey(unsigned char objkey[16], unsigned& pnKeyLen, const PdfReference& objref) const
 {
+    // The strings and the stream of an object share its key,
+    // and the objects are usually visited more times
+    {
+        lock_guard<mutex> lock(m_objKeysMutex);
+        auto found = m_objKeys.find(objref);
+        if (found != m_objKeys.end())
+        {
+            std::memcpy(objkey, found->second.Key, sizeof(found->second.Key));
+            pnKeyLen = found->second.Length;
+            return;
+        }
+    }
+
     const unsigned n = static_cast<unsigned>(objref.ObjectNumber());
     const unsigned g = static_cast<unsigned>(objref.GenerationNumber());
 
@@ -822,18 +973,22 @@ void PdfEncryptMD5Base::CreateObjKey(unsigned char objkey[16], unsigned& pnKeyLe
 
     GetMD5Binary(nkey, nkeylen, objkey);
     pnKeyLen = (m_keyLength <= 11) ? m_keyLength + 5 : 16;
-}
 
-PdfEncryptRC4Base::PdfEncryptRC4Base()
-{
-    m_rc4 = new RC4CryptoEngine();
+    lock_guard<mutex> lock(m_objKeysMutex);
+    if (m_objKeys.size() >= MaxObjectKeyCount)
+        m_objKeys.clear();
+
+    auto& cached = m_objKeys[objref];
+    std::memcpy(cached.Key, objkey, sizeof(cached.Key));
+    cached.Length = pnKeyLen;
 }
 
-PdfEncryptRC4Base::~PdfEncryptRC4Base()
+void PdfEncryptMD5Base::clearObjKeys()
 {
-    delete m_rc4;
+    lock_guard<mutex> lock(m_objKeysMutex);
+    m_objKeys.clear();
 }
-    
+
 /**
  * RC4 is the standard encryption algorithm used in PDF format
  */
@@ -842,17 +997,13 @@ void PdfEncryptRC4Base::RC4(const unsigned char* key, unsigned keylen,
     const unsigned char* textin, size_t textlen,
     unsigned char* textout, size_t textoutlen) const
 {
-    EVP_CIPHER_CTX* rc4 = m_rc4->getEngine();
-
     if (textlen != textoutlen)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing RC4 encryption engine");
 
-    // Don't set the key because we will modify the parameters
-    int status = EVP_EncryptInit_ex(rc4, EVP_rc4(), nullptr, nullptr, nullptr);
-    if (status != 1)
-        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing RC4 encryption engine");
-
-    status = EVP_CIPHER_CTX_set_key_length(rc4, keylen);
+    // The context has the cipher already, but not the key
+    // because we will modify the parameters
+    EVP_CIPHER_CTX* rc4 = s_cipherContexts.Get(EVP_rc4(), true);
+    int status = EVP_CIPHER_CTX_set_key_length(rc4, keylen);
     if (status != 1)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing RC4 encryption engine");
 
@@ -1027,7 +1178,7 @@ void PdfEncryptRC4::Decrypt(const char* inStr, size_t inLen, const PdfReference&
     Encrypt(inStr, inLen, objref, outStr, outLen);
 }
 
-unique_ptr<InputStream> PdfEncryptRC4::CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref)
+unique_ptr<InputStream> PdfEncryptRC4::CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const
 {
     (void)inputLen;
     unsigned char objkey[MD5_DIGEST_LENGTH];
@@ -1101,7 +1252,7 @@ PdfEncryptRC4::PdfEncryptRC4(const string_view& userPassword, const string_view&
     m_pValue = PERMS_DEFAULT | protection;
 }
 
-unique_ptr<OutputStream> PdfEncryptRC4::CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref)
+unique_ptr<OutputStream> PdfEncryptRC4::CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const
 {
     unsigned char objkey[MD5_DIGEST_LENGTH];
     unsigned keylen;
@@ -1126,18 +1277,17 @@ void PdfEncryptAESBase::BaseDecrypt(const unsigned char* key, unsigned keyLen, c
     if ((textlen % 16) != 0)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error AES-decryption data length not a multiple of 16");
 
-    EVP_CIPHER_CTX* aes = m_aes->getEngine();
-
-    int rc;
+    EVP_CIPHER_CTX* aes;
     if (keyLen == (int)PdfKeyLength::L128 / 8)
-        rc = EVP_DecryptInit_ex(aes, EVP_aes_128_cbc(), nullptr, key, iv);
+        aes = s_cipherContexts.Get(EVP_aes_128_cbc(), false);
 #ifdef PDFMM_HAVE_LIBIDN
     else if (keyLen == (int)PdfKeyLength::L256 / 8)
-        rc = EVP_DecryptInit_ex(aes, EVP_aes_256_cbc(), nullptr, key, iv);
+        aes = s_cipherContexts.Get(EVP_aes_256_cbc(), false);
 #endif
     else
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Invalid AES key length");
 
+    int rc = EVP_DecryptInit_ex(aes, nullptr, nullptr, key, iv);
     if (rc != 1)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing AES decryption engine");
 
@@ -1158,18 +1308,17 @@ void PdfEncryptAESBase::BaseEncrypt(const unsigned char* key, unsigned keyLen, c
     unsigned char* textout, size_t textoutlen) const
 {
     (void)textoutlen;
-    EVP_CIPHER_CTX* aes = m_aes->getEngine();
-
-    int rc;
+    EVP_CIPHER_CTX* aes;
     if (keyLen == (int)PdfKeyLength::L128 / 8)
-        rc = EVP_EncryptInit_ex(aes, EVP_aes_128_cbc(), nullptr, key, iv);
+        aes = s_cipherContexts.Get(EVP_aes_128_cbc(), true);
 #ifdef PDFMM_HAVE_LIBIDN
     else if (keyLen == (int)PdfKeyLength::L256 / 8)
-        rc = EVP_EncryptInit_ex(aes, EVP_aes_256_cbc(), nullptr, key, iv);
+        aes = s_cipherContexts.Get(EVP_aes_256_cbc(), true);
 #endif
     else
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Invalid AES key length");
 
+    int rc = EVP_EncryptInit_ex(aes, nullptr, nullptr, key, iv);
     if (rc != 1)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing AES encryption engine");
 
@@ -1318,7 +1467,7 @@ size_t PdfEncryptAESV2::CalculateStreamLength(size_t length) const
     return realLength;
 }
     
-unique_ptr<InputStream> PdfEncryptAESV2::CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref)
+unique_ptr<InputStream> PdfEncryptAESV2::CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const
 {
     unsigned char objkey[MD5_DIGEST_LENGTH];
     unsigned keylen;
@@ -1326,16 +1475,14 @@ unique_ptr<InputStream> PdfEncryptAESV2::CreateEncryptionInputStream(InputStream
     return unique_ptr<InputStream>(new PdfAESInputStream(inputStream, inputLen, objkey, keylen));
 }
     
-unique_ptr<OutputStream> PdfEncryptAESV2::CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref)
+unique_ptr<OutputStream> PdfEncryptAESV2::CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const
 {
-    (void)outputStream;
-    (void)objref;
-    /*unsigned char objkey[MD5_DIGEST_LENGTH];
-     int keylen;
-
-     this->CreateObjKey( objkey, &keylen );*/
-
-    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "CreateEncryptionOutputStream does not yet support AESV2");
+    unsigned char objkey[MD5_DIGEST_LENGTH];
+    unsigned keylen;
+    this->CreateObjKey(objkey, keylen, objref);
+    unsigned char iv[AES_IV_LENGTH];
+    this->GenerateInitialVector(iv);
+    return unique_ptr<OutputStream>(new PdfAESOutputStream(outputStream, objkey, keylen, iv));
 }
     
 #ifdef PDFMM_HAVE_LIBIDN
@@ -1763,17 +1910,18 @@ size_t PdfEncryptAESV3::CalculateStreamLength(size_t length) const
     return realLength;
 }
 
-unique_ptr<InputStream> PdfEncryptAESV3::CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref)
+unique_ptr<InputStream> PdfEncryptAESV3::CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const
 {
     (void)objref;
     return unique_ptr<InputStream>(new PdfAESInputStream(inputStream, inputLen, m_encryptionKey, 32));
 }
 
-unique_ptr<OutputStream> PdfEncryptAESV3::CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref)
+unique_ptr<OutputStream> PdfEncryptAESV3::CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const
 {
-    (void)outputStream;
     (void)objref;
-    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "CreateEncryptionOutputStream does not yet support AESV3");
+    unsigned char iv[AES_IV_LENGTH];
+    this->GenerateInitialVector(iv);
+    return unique_ptr<OutputStream>(new PdfAESOutputStream(outputStream, m_encryptionKey, m_keyLength, iv));
 }
     
 #endif // PDFMM_HAVE_LIBIDN
@@ -1785,9 +1933,13 @@ int PdfEncrypt::GetKeyLength() const
 
 void PdfEncrypt::EncryptTo(charbuff& out, const bufferview& view, const PdfReference& objref) const
 {
-    size_t outputLen = this->CalculateStreamLength(view.size());
-    out.resize(outputLen);
-    this->Encrypt(view.data(), view.size(), objref, out.data(), outputLen);
+    out.resize(this->CalculateStreamLength(view.size()));
+    EncryptTo(out.data(), view, objref);
+}
+
+void PdfEncrypt::EncryptTo(char* out, const bufferview& view, const PdfReference& objref) const
+{
+    this->Encrypt(view.data(), view.size(), objref, out, this->CalculateStreamLength(view.size()));
 }
 
 void PdfEncrypt::DecryptTo(charbuff& out, const bufferview& view, const PdfReference& objref) const
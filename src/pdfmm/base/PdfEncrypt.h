@@ -10,6 +10,10 @@
 #define PDF_ENCRYPT_H
 
 #include "PdfDeclarations.h"
+
+#include <mutex>
+#include <unordered_map>
+
 #include "PdfString.h"
 #include "PdfReference.h"
 
@@ -21,7 +25,6 @@ class InputStream;
 class PdfObject;
 class OutputStream;
 class AESCryptoEngine;
-class RC4CryptoEngine;
 
 /* Class representing PDF encryption methods. (For internal use only)
  * Based on code from Ulrich Telle: http://wxcode.sourceforge.net/components/wxpdfdoc/
@@ -196,26 +199,25 @@ public:
     /** Create an InputStream that decrypts all data read from
      *  it using the current settings of the PdfEncrypt object.
      *
-     *  Warning: Currently only RC4 based encryption is supported using output streams!
-     *
      *  \param inputStream the created InputStream reads all decrypted
      *         data to this input stream.
      *
      *  \returns an InputStream that decrypts all data.
      */
-    virtual std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) = 0;
+    virtual std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const = 0;
 
     /** Create an OutputStream that encrypts all data written to
      *  it using the current settings of the PdfEncrypt object.
-     *
-     *  Warning: Currently only RC4 based encryption is supported using output streams!
+     *  The data is encrypted as it's written, and the stream must be
+     *  flushed at the end of the data to write the final AES block.
+     *  The encrypted length is CalculateStreamLength() of the data length
      *
      *  \param outputStream the created OutputStream writes all encrypted
      *         data to this output stream.
      *
      *  \returns a OutputStream that encrypts all data.
      */
-    virtual std::unique_ptr<OutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) = 0;
+    virtual std::unique_ptr<OutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const = 0;
 
     /**
      * Tries to authenticate a user using either the user or owner password
@@ -348,6 +350,11 @@ public:
      */
     void EncryptTo(charbuff& out, const bufferview& view, const PdfReference& objref) const;
 
+    /** Encrypt a character span into a buffer
+     *  \param out the buffer, of CalculateStreamLength(view.size()) characters
+     */
+    void EncryptTo(char* out, const bufferview& view, const PdfReference& objref) const;
+
     /** Decrypt a character span
      */
     void DecryptTo(charbuff& out, const bufferview& view, const PdfReference& objref) const;
@@ -486,7 +493,7 @@ protected:
         const unsigned char* textin, size_t textlen,
         unsigned char* textout, size_t textoutlen) const;
 
-    AESCryptoEngine* m_aes;                // AES encryptor
+    AESCryptoEngine* m_aes;                // AES encryptor for the key computations
 };
 
 /** A pure virtual class that is used to encrypt a PDF file (RC4-40..128)
@@ -498,18 +505,13 @@ protected:
  */
 class PdfEncryptRC4Base
 {
-public:
-    ~PdfEncryptRC4Base();
-
 protected:
-    PdfEncryptRC4Base();
+    PdfEncryptRC4Base() { }
 
-    // AES encryption
+    // RC4 encryption, with a cipher context of the thread
     void RC4(const unsigned char* key, unsigned keylen,
         const unsigned char* textin, size_t textlen,
         unsigned char* textout, size_t textoutlen) const;
-
-    RC4CryptoEngine* m_rc4;                // AES encryptor
 };
 
 class PdfEncryptMD5Base : public PdfEncrypt, public PdfEncryptRC4Base
@@ -565,8 +567,23 @@ protected:
      */
     void CreateObjKey(unsigned char objkey[16], unsigned& pnKeyLen, const PdfReference& objref) const;
 
-    unsigned char m_rc4key[16];         // last RC4 key
-    unsigned char m_rc4last[256];       // last RC4 state table
+    // NOTE: The RC4 streams update the cached key schedule
+    mutable unsigned char m_rc4key[16];         // last RC4 key
+    mutable unsigned char m_rc4last[256];       // last RC4 state table
+
+private:
+    void clearObjKeys();
+
+private:
+    struct ObjectKey
+    {
+        unsigned char Key[16];
+        unsigned Length;
+    };
+
+    // Object keys by reference, they're invalidated when the encryption key changes
+    mutable std::mutex m_objKeysMutex;
+    mutable std::unordered_map<PdfReference, ObjectKey> m_objKeys;
 
 };
 
@@ -584,8 +601,8 @@ public:
     PdfEncryptAESV2(const std::string_view& userPassword, const std::string_view& ownerPassword,
         PdfPermissions protection = PdfPermissions::Default);
 
-    std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) override;
-    std::unique_ptr<OutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) override;
+    std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const override;
+    std::unique_ptr<OutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const override;
 
     void Encrypt(const char* inStr, size_t inLen, const PdfReference& objref,
         char* outStr, size_t outLen) const override;
@@ -618,8 +635,8 @@ public:
     PdfEncryptAESV3(const std::string_view& userPassword, const std::string_view& ownerPassword,
         PdfPermissions protection = PdfPermissions::Default);
 
-    std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) override;
-    std::unique_ptr<OutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) override;
+    std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const override;
+    std::unique_ptr<OutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const override;
 
     // Encrypt a character string
     void Encrypt(const char* inStr, size_t inLen, const PdfReference& objref,
@@ -662,9 +679,9 @@ public:
     void Decrypt(const char* inStr, size_t inLen, const PdfReference& objref,
         char* outStr, size_t& outLen) const override;
 
-    std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) override;
+    std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const override;
 
-    std::unique_ptr<OutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) override;
+    std::unique_ptr<OutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const override;
 
     size_t CalculateStreamOffset() const override;
 
@@ -13,14 +13,18 @@
 #include <pdfmm/private/FileSystem.h>
 #include <pdfmm/private/outstringstream.h>
 
+#include <atomic>
+
 using namespace std;
 using namespace cmn;
 using namespace mm;
 
+// NOTE: Atomic since it's checked before formatting
+// the messages, possibly from concurrent loads
 #ifdef DEBUG
-PdfLogSeverity s_MaxLogSeverity = PdfLogSeverity::Debug;
+static atomic<PdfLogSeverity> s_MaxLogSeverity(PdfLogSeverity::Debug);
 #else
-PdfLogSeverity s_MaxLogSeverity = PdfLogSeverity::Information;
+static atomic<PdfLogSeverity> s_MaxLogSeverity(PdfLogSeverity::Information);
 #endif // DEBUG
 
 // Retrieve the basepath of the source directory
@@ -69,6 +73,9 @@ bool PdfError::operator!=(PdfErrorCode code)
 
 void PdfError::PrintErrorMsg() const
 {
+    if (!mm::IsLogMessageEnabled(PdfLogSeverity::Error))
+        return;
+
     const char* msg = PdfError::ErrorMessage(m_error);
     const char* name = PdfError::ErrorName(m_error);
 
@@ -258,6 +265,9 @@ const char* PdfError::ErrorName(PdfErrorCode code)
         case PdfErrorCode::CannotEncryptedForUpdate:
             msg = "PdfErrorCode::CannotEncryptedForUpdate";
             break;
+        case PdfErrorCode::MemoryBudgetExceeded:
+            msg = "PdfErrorCode::MemoryBudgetExceeded";
+            break;
         case PdfErrorCode::Unknown:
             msg = "PdfErrorCode::Unknown";
             break;
@@ -398,6 +408,9 @@ const char* PdfError::ErrorMessage(PdfErrorCode code)
         case PdfErrorCode::XmpMetadata:
             msg = "Error while reading or writing XMP metadata";
             break;
+        case PdfErrorCode::MemoryBudgetExceeded:
+            msg = "The process memory budget was exceeded.";
+            break;
         case PdfErrorCode::Unknown:
             msg = "Error code unknown.";
             break;
@@ -410,17 +423,17 @@ const char* PdfError::ErrorMessage(PdfErrorCode code)
 
 void PdfError::SetMaxLoggingSeverity(PdfLogSeverity logSeverity)
 {
-    s_MaxLogSeverity = logSeverity;
+    s_MaxLogSeverity.store(logSeverity, memory_order_relaxed);
 }
 
 PdfLogSeverity PdfError::GetMaxLoggingSeverity()
 {
-    return s_MaxLogSeverity;
+    return s_MaxLogSeverity.load(memory_order_relaxed);
 }
 
 bool PdfError::IsLoggingSeverityEnabled(PdfLogSeverity logSeverity)
 {
-    return logSeverity <= s_MaxLogSeverity;
+    return logSeverity <= s_MaxLogSeverity.load(memory_order_relaxed);
 }
 
 void PdfError::AddToCallstack(string filepath, unsigned line, string information)
@@ -430,7 +443,7 @@ void PdfError::AddToCallstack(string filepath, unsigned line, string information
 
 void mm::LogMessage(PdfLogSeverity logSeverity, const string_view& msg)
 {
-    if (logSeverity > s_MaxLogSeverity)
+    if (!mm::IsLogMessageEnabled(logSeverity))
         return;
 
     if (s_LogMessageCallback == nullptr)
@@ -92,6 +92,7 @@ enum class PdfErrorCode
     CannotEncryptedForUpdate, ///< Cannot load encrypted documents for update.
 
     XmpMetadata,              ///< Error while creating or reading XMP metadata
+    MemoryBudgetExceeded,     ///< The process memory budget set with PdfMemoryGovernor was exceeded
 };
 
 /**
@@ -0,0 +1,241 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfExecutor.h"
+
+#include <atomic>
+
+using namespace std;
+using namespace mm;
+
+namespace
+{
+    // The state of a ParallelFor, shared with the submitted tasks
+    // since they may run after ParallelFor returned
+    struct ParallelState
+    {
+        ParallelState(size_t count, size_t batchSize, const PdfExecutor::WorkerFactory& createWorker);
+
+        size_t Count;
+        size_t BatchSize;
+        // NOTE: Valid only until Closed is set
+        const PdfExecutor::WorkerFactory* CreateWorker;
+        atomic<size_t> NextIndex;
+        atomic<bool> Failed;
+        mutex Mutex;
+        condition_variable Cond;
+        unsigned ActiveCount;
+        bool Closed;
+        exception_ptr Error;
+    };
+}
+
+static void processIndices(ParallelState& state);
+static shared_ptr<PdfExecutor> getBuiltinPool();
+
+static mutex s_defaultMutex;
+static shared_ptr<PdfExecutor> s_default;
+
+PdfExecutor::~PdfExecutor() { }
+
+void PdfExecutor::ParallelFor(size_t count, size_t batchSize, unsigned maxConcurrency,
+    const WorkerFactory& createWorker)
+{
+    if (batchSize == 0)
+        batchSize = 1;
+
+    unsigned concurrency = GetConcurrency();
+    if (maxConcurrency == 0 || maxConcurrency > concurrency)
+        maxConcurrency = concurrency;
+
+    unsigned taskCount = (unsigned)std::min<size_t>(maxConcurrency, (count + batchSize - 1) / batchSize);
+    if (taskCount < 2)
+    {
+        auto worker = createWorker();
+        for (size_t i = 0; i < count; i++)
+            worker(i);
+
+        return;
+    }
+
+    auto state = std::make_shared<ParallelState>(count, batchSize, createWorker);
+    for (unsigned i = 1; i < taskCount; i++)
+    {
+        Submit([state]()
+        {
+            {
+                unique_lock<mutex> lock(state->Mutex);
+                if (state->Closed)
+                    return;
+
+                state->ActiveCount++;
+            }
+
+            processIndices(*state);
+
+            unique_lock<mutex> lock(state->Mutex);
+            state->ActiveCount--;
+            if (state->ActiveCount == 0)
+                state->Cond.notify_all();
+        });
+    }
+
+    processIndices(*state);
+
+    // All the indices were claimed: wait only for the tasks that are
+    // still processing them, the ones starting later just return
+    unique_lock<mutex> lock(state->Mutex);
+    state->Closed = true;
+    state->Cond.wait(lock, [&state]() { return state->ActiveCount == 0; });
+    if (state->Error != nullptr)
+        std::rethrow_exception(state->Error);
+}
+
+future<void> PdfExecutor::RunAsync(function<void()> func)
+{
+    if (GetConcurrency() < 2)
+        return std::async(std::launch::async, std::move(func));
+
+    auto promise = std::make_shared<std::promise<void>>();
+    auto ret = promise->get_future();
+    Submit([promise, func = std::move(func)]()
+    {
+        try
+        {
+            func();
+            promise->set_value();
+        }
+        catch (...)
+        {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return ret;
+}
+
+void PdfExecutor::SetDefault(const shared_ptr<PdfExecutor>& executor)
+{
+    unique_lock<mutex> lock(s_defaultMutex);
+    s_default = executor;
+}
+
+shared_ptr<PdfExecutor> PdfExecutor::GetDefault()
+{
+    {
+        unique_lock<mutex> lock(s_defaultMutex);
+        if (s_default != nullptr)
+            return s_default;
+    }
+
+    return getBuiltinPool();
+}
+
+PdfThreadPool::PdfThreadPool(unsigned concurrency) :
+    m_concurrency(concurrency == 0 ? std::thread::hardware_concurrency() : concurrency),
+    m_stopped(false)
+{
+    // NOTE: hardware_concurrency() may return 0 when unknown
+    if (m_concurrency == 0)
+        m_concurrency = 1;
+
+    m_threads.reserve(m_concurrency - 1);
+    for (unsigned i = 1; i < m_concurrency; i++)
+        m_threads.emplace_back(&PdfThreadPool::run, this);
+}
+
+PdfThreadPool::~PdfThreadPool()
+{
+    {
+        unique_lock<mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+
+    m_cond.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+unsigned PdfThreadPool::GetConcurrency() const
+{
+    return m_concurrency;
+}
+
+void PdfThreadPool::Submit(Task task)
+{
+    if (m_threads.size() == 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "The thread pool has no threads to run the task");
+
+    {
+        unique_lock<mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+
+    m_cond.notify_one();
+}
+
+void PdfThreadPool::run()
+{
+    while (true)
+    {
+        Task task;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]() { return m_stopped || m_tasks.size() != 0; });
+            if (m_stopped)
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+ParallelState::ParallelState(size_t count, size_t batchSize, const PdfExecutor::WorkerFactory& createWorker) :
+    Count(count),
+    BatchSize(batchSize),
+    CreateWorker(&createWorker),
+    NextIndex(0),
+    Failed(false),
+    ActiveCount(0),
+    Closed(false) { }
+
+void processIndices(ParallelState& state)
+{
+    try
+    {
+        auto worker = (*state.CreateWorker)();
+        while (!state.Failed)
+        {
+            size_t start = state.NextIndex.fetch_add(state.BatchSize);
+            if (start >= state.Count)
+                break;
+
+            size_t end = std::min(start + state.BatchSize, state.Count);
+            for (size_t i = start; i < end; i++)
+                worker(i);
+        }
+    }
+    catch (...)
+    {
+        unique_lock<mutex> lock(state.Mutex);
+        if (state.Error == nullptr)
+            state.Error = std::current_exception();
+
+        state.Failed = true;
+    }
+}
+
+shared_ptr<PdfExecutor> getBuiltinPool()
+{
+    // NOTE: Created on the first use, so applications
+    // setting their own executor never start the threads
+    static shared_ptr<PdfExecutor> s_pool = std::make_shared<PdfThreadPool>();
+    return s_pool;
+}
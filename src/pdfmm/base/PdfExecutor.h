@@ -0,0 +1,133 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_EXECUTOR_H
+#define PDF_EXECUTOR_H
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <future>
+
+#include "PdfDeclarations.h"
+
+namespace mm {
+
+/** An interface running the tasks of the parallel operations of the library
+ *
+ * The library splits the work of parsing, decrypting, writing,
+ * subsetting fonts and extracting text in tasks submitted to an
+ * executor. The executor can be set globally, with SetDefault, or
+ * for a single document, with PdfDocument::SetExecutor, so the
+ * library can share the threads of the host application
+ * (for example an adapter to a TBB arena or an asio pool)
+ *
+ * The thread starting a parallel operation always takes part to
+ * the work and it never waits for a task that didn't start, so
+ * parallel operations can't deadlock even if the executor runs
+ * the tasks late, or when they are nested
+ */
+class PDFMM_API PdfExecutor
+{
+public:
+    using Task = std::function<void()>;
+    using Worker = std::function<void(size_t)>;
+    using WorkerFactory = std::function<Worker()>;
+
+public:
+    virtual ~PdfExecutor();
+
+    /** \returns the count of tasks that can run at the same time,
+     * the thread starting a parallel operation included
+     */
+    virtual unsigned GetConcurrency() const = 0;
+
+    /** Schedule a task to be run on another thread
+     *
+     * The task doesn't throw. Submit must not block waiting
+     * for the task, nor run it in the calling thread
+     */
+    virtual void Submit(Task task) = 0;
+
+public:
+    /** Process the [0, count) indices concurrently, handing them out
+     * in batches. The factory is called once per task to create the
+     * function processing a single index, so each task can hold private
+     * state. The first exception thrown is rethrown here
+     *
+     * \param maxConcurrency the maximum count of tasks processing the
+     * indices, the calling thread included, or 0 to use GetConcurrency().
+     * It's capped to GetConcurrency() anyway
+     */
+    void ParallelFor(size_t count, size_t batchSize, unsigned maxConcurrency,
+        const WorkerFactory& createWorker);
+
+    /** Run a function without blocking the calling thread
+     *
+     * The function is submitted as a task or, if the executor
+     * has no concurrency, it's run on a thread of its own
+     * \returns a future that is ready when the function returned.
+     *      It rethrows the exception thrown by the function, if any
+     */
+    std::future<void> RunAsync(std::function<void()> func);
+
+public:
+    /** Set the executor used by the documents without one of their own
+     *
+     * \param executor the executor, or nullptr to restore the built-in pool
+     */
+    static void SetDefault(const std::shared_ptr<PdfExecutor>& executor);
+
+    /** \returns the executor set with SetDefault, or the built-in
+     * thread pool, created on the first use
+     */
+    static std::shared_ptr<PdfExecutor> GetDefault();
+};
+
+/** The built-in executor, a pool of threads sharing a queue of tasks
+ *
+ * Tasks are coarse: a parallel operation submits at most one task per
+ * thread and the tasks then claim the work in batches on their own
+ */
+class PDFMM_API PdfThreadPool final : public PdfExecutor
+{
+public:
+    /** Create a pool of the given concurrency
+     *
+     * \param concurrency the count of tasks that can run at the same time,
+     * or 0 to use the count of hardware threads. The pool starts
+     * one thread less, since the calling thread always takes part to the work
+     */
+    PdfThreadPool(unsigned concurrency = 0);
+
+    ~PdfThreadPool();
+
+public:
+    unsigned GetConcurrency() const override;
+
+    void Submit(Task task) override;
+
+private:
+    PdfThreadPool(const PdfThreadPool&) = delete;
+    PdfThreadPool& operator=(const PdfThreadPool&) = delete;
+
+    void run();
+
+private:
+    unsigned m_concurrency;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Task> m_tasks;
+    bool m_stopped;
+    std::vector<std::thread> m_threads;
+};
+
+};
+
+#endif // PDF_EXECUTOR_H
@@ -56,11 +56,11 @@ void PdfFileObjectStream::BeginAppendImpl(const PdfFilterList& filters)
         if (m_CurrEncrypt != nullptr)
         {
             m_EncryptStream = m_CurrEncrypt->CreateEncryptionOutputStream(*m_Device, GetParent().GetIndirectReference());
-            m_Stream = PdfFilterFactory::CreateEncodeStream(filters, *m_EncryptStream);
+            m_Stream = PdfFilterFactory::CreateEncodeStream(filters, *m_EncryptStream, GetEffectiveCompressionLevel());
         }
         else
         {
-            m_Stream = PdfFilterFactory::CreateEncodeStream(filters, *m_Device);
+            m_Stream = PdfFilterFactory::CreateEncodeStream(filters, *m_Device, GetEffectiveCompressionLevel());
         }
     }
     else
@@ -92,9 +92,8 @@ void PdfFileObjectStream::EndAppendImpl()
         m_EncryptStream = nullptr;
     }
 
+    // NOTE: The written data is already encrypted
     m_Length = m_Device->GetLength() - m_initialLength;
-    if (m_CurrEncrypt != nullptr)
-        m_Length = m_CurrEncrypt->CalculateStreamLength(m_Length);
 
     m_LengthObj->SetNumber(static_cast<int64_t>(m_Length));
 }
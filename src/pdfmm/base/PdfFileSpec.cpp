@@ -10,6 +10,9 @@
 
 #include <pdfmm/private/outstringstream.h>
 
+#include <openssl/md5.h>
+#include <openssl/evp.h>
+
 #include "PdfDictionary.h"
 #include "PdfDocument.h"
 #include "PdfObject.h"
@@ -20,6 +23,48 @@ using namespace std;
 using namespace cmn;
 using namespace mm;
 
+namespace
+{
+    // Count and MD5-hash the data while it's read
+    class EmbeddingInputStream final : public InputStream
+    {
+    public:
+        EmbeddingInputStream(InputStream& stream)
+            : m_stream(&stream), m_ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free), m_size(0)
+        {
+            if (m_ctx == nullptr || EVP_DigestInit_ex(m_ctx.get(), EVP_md5(), nullptr) != 1)
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing MD5 hashing engine");
+        }
+
+        PdfString GetCheckSum()
+        {
+            char digest[MD5_DIGEST_LENGTH];
+            if (EVP_DigestFinal_ex(m_ctx.get(), reinterpret_cast<unsigned char*>(digest), nullptr) != 1)
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error MD5-hashing data");
+
+            return PdfString::FromRaw({ digest, MD5_DIGEST_LENGTH });
+        }
+
+        size_t GetSize() const { return m_size; }
+
+    protected:
+        size_t readBuffer(char* buffer, size_t size, bool& eof) override
+        {
+            size_t read = m_stream->Read(buffer, size, eof);
+            if (EVP_DigestUpdate(m_ctx.get(), buffer, read) != 1)
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error MD5-hashing data");
+
+            m_size += read;
+            return read;
+        }
+
+    private:
+        InputStream* m_stream;
+        unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> m_ctx;
+        size_t m_size;
+    };
+}
+
 PdfFileSpec::PdfFileSpec(PdfDocument& doc, const string_view& filename, bool embed, bool striPath)
     : PdfDictionaryElement(doc, "Filespec")
 {
@@ -32,6 +77,13 @@ PdfFileSpec::PdfFileSpec(PdfDocument& doc, const string_view& filename, const ch
     Init(filename, data, size, striPath);
 }
 
+PdfFileSpec::PdfFileSpec(PdfDocument& doc, const string_view& filename, InputStream& stream,
+        bool compress, bool striPath)
+    : PdfDictionaryElement(doc, "Filespec")
+{
+    Init(filename, stream, compress, striPath);
+}
+
 PdfFileSpec::PdfFileSpec(PdfObject& obj)
     : PdfDictionaryElement(obj)
 {
@@ -39,23 +91,24 @@ PdfFileSpec::PdfFileSpec(PdfObject& obj)
 
 void PdfFileSpec::Init(const string_view& filename, bool embed, bool striPath)
 {
-    this->GetObject().GetDictionary().AddKey("F", this->CreateFileSpecification(MaybeStripPath(filename, striPath)));
-    this->GetObject().GetDictionary().AddKey("UF", PdfString(MaybeStripPath(filename, true)));
-
     if (embed)
     {
-        PdfDictionary ef;
-
-        auto embeddedStream = this->GetDocument().GetObjects().CreateDictionaryObject("EmbeddedFile");
-        this->EmbeddFile(*embeddedStream, filename);
-
-        ef.AddKey("F", embeddedStream->GetIndirectReference());
-
-        this->GetObject().GetDictionary().AddKey("EF", ef);
+        FileStreamDevice input(filename);
+        Init(filename, input, true, striPath);
+        return;
     }
+
+    this->GetObject().GetDictionary().AddKey("F", this->CreateFileSpecification(MaybeStripPath(filename, striPath)));
+    this->GetObject().GetDictionary().AddKey("UF", PdfString(MaybeStripPath(filename, true)));
 }
 
 void PdfFileSpec::Init(const string_view& filename, const char* data, size_t size, bool striPath)
+{
+    SpanStreamDevice input(data, size);
+    Init(filename, input, true, striPath);
+}
+
+void PdfFileSpec::Init(const string_view& filename, InputStream& stream, bool compress, bool striPath)
 {
     this->GetObject().GetDictionary().AddKey("F", this->CreateFileSpecification(MaybeStripPath(filename, striPath)));
     this->GetObject().GetDictionary().AddKey("UF", PdfString(MaybeStripPath(filename, true)));
@@ -63,7 +116,7 @@ void PdfFileSpec::Init(const string_view& filename, const char* data, size_t siz
     PdfDictionary ef;
 
     auto embeddedStream = this->GetDocument().GetObjects().CreateDictionaryObject("EmbeddedFile");
-    this->EmbeddFileFromMem(*embeddedStream, data, size);
+    this->EmbeddStream(*embeddedStream, stream, compress);
 
     ef.AddKey("F", embeddedStream->GetIndirectReference());
 
@@ -107,16 +160,19 @@ PdfString PdfFileSpec::CreateFileSpecification(const string_view& filename) cons
     return PdfString(str.str());
 }
 
-void PdfFileSpec::EmbeddFile(PdfObject& obj, const string_view& filename) const
+void PdfFileSpec::EmbeddStream(PdfObject& obj, InputStream& stream, bool compress) const
 {
-    size_t size = utls::FileSize(filename);
-
-    FileStreamDevice input(filename);
-    obj.GetOrCreateStream().Set(input);
+    // The data is compressed while it's read, and it's never held whole
+    EmbeddingInputStream input(stream);
+    if (compress)
+        obj.GetOrCreateStream().Set(input);
+    else
+        obj.GetOrCreateStream().Set(input, { });
 
     // Add additional information about the embedded file to the stream
     PdfDictionary params;
-    params.AddKey("Size", static_cast<int64_t>(size));
+    params.AddKey("Size", static_cast<int64_t>(input.GetSize()));
+    params.AddKey("CheckSum", input.GetCheckSum());
     // TODO: CreationDate and ModDate
     obj.GetDictionary().AddKey("Params", params);
 }
@@ -144,17 +200,6 @@ string PdfFileSpec::MaybeStripPath(const string_view& filename, bool stripPath)
     return (string)lastFrom;
 }
 
-void PdfFileSpec::EmbeddFileFromMem(PdfObject& obj, const char* data, size_t size) const
-{
-    SpanStreamDevice memstream(reinterpret_cast<const char*>(data), size);
-    obj.GetOrCreateStream().Set(memstream);
-
-    // Add additional information about the embedded file to the stream
-    PdfDictionary params;
-    params.AddKey("Size", static_cast<int64_t>(size));
-    obj.GetDictionary().AddKey("Params", params);
-}
-
 const PdfString& PdfFileSpec::GetFilename(bool canUnicode) const
 {
     if (canUnicode && this->GetObject().GetDictionary().HasKey("UF"))
@@ -165,3 +210,35 @@ const PdfString& PdfFileSpec::GetFilename(bool canUnicode) const
 
     PDFMM_RAISE_ERROR(PdfErrorCode::InvalidDataType);
 }
+
+bool PdfFileSpec::HasEmbeddedFile() const
+{
+    return findEmbeddedFile() != nullptr;
+}
+
+void PdfFileSpec::ExtractEmbeddedFile(OutputStream& stream) const
+{
+    auto embeddedFile = findEmbeddedFile();
+    if (embeddedFile == nullptr)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The file is not embedded");
+
+    // NOTE: The data is decoded in chunks, not extracted to a buffer
+    embeddedFile->MustGetStream().ExtractTo(stream);
+}
+
+const PdfObject* PdfFileSpec::findEmbeddedFile() const
+{
+    auto ef = this->GetObject().GetDictionary().FindKey("EF");
+    if (ef == nullptr || !ef->IsDictionary())
+        return nullptr;
+
+    // Prefer the file of the unicode name, like GetFilename()
+    auto embeddedFile = ef->GetDictionary().FindKey("UF");
+    if (embeddedFile == nullptr || embeddedFile->GetStream() == nullptr)
+        embeddedFile = ef->GetDictionary().FindKey("F");
+
+    if (embeddedFile == nullptr || embeddedFile->GetStream() == nullptr)
+        return nullptr;
+
+    return embeddedFile;
+}
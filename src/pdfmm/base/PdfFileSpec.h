@@ -16,6 +16,8 @@
 namespace mm {
 
 class PdfDocument;
+class InputStream;
+class OutputStream;
 
 /**
  *  A file specification is used in the PDF file to referr to another file.
@@ -29,6 +31,18 @@ public:
 
     PdfFileSpec(PdfDocument& doc, const std::string_view& filename, const char* data, size_t size, bool striPath = false);
 
+    /** Create a file specification embedding the data read from a stream
+     *
+     * The data is read and compressed in chunks, and its size and MD5
+     * checksum are added to the /Params of the embedded file. The memory
+     * used by the embedded stream depends on the stream factory of the
+     * document, e.g. PdfSpillStreamFactory bounds it
+     *  \param stream the stream to read the data of the file from
+     *  \param compress whether to compress the data, or to store it unfiltered
+     */
+    PdfFileSpec(PdfDocument& doc, const std::string_view& filename, InputStream& stream,
+        bool compress = true, bool striPath = false);
+
     PdfFileSpec(PdfObject& obj);
 
     /** Gets file name for the FileSpec
@@ -39,6 +53,15 @@ public:
      */
     const PdfString& GetFilename(bool canUnicode) const;
 
+    /** \returns true if the file is embedded in the document
+     */
+    bool HasEmbeddedFile() const;
+
+    /** Decode the embedded file and write it to a stream, in chunks
+     *  \param stream the stream to write the data of the file to
+     */
+    void ExtractEmbeddedFile(OutputStream& stream) const;
+
 private:
 
     /** Initialize a filespecification from a filename
@@ -56,17 +79,28 @@ private:
      */
     void Init(const std::string_view& filename, const char* data, size_t size, bool striPath);
 
+    /** Initialize a filespecification from a stream
+     *  \param filename filename
+     *  \param stream stream to read the data of the file from
+     *  \param compress whether to compress the data
+     *  \param striPath whether to strip path from the file name string
+     */
+    void Init(const std::string_view& filename, InputStream& stream, bool compress, bool striPath);
+
     /** Create a file specification string from a filename
      *  \param filename filename
      *  \returns a file specification string
      */
     PdfString CreateFileSpecification(const std::string_view& filename) const;
 
-    /** Embedd a file into a stream object
-     *  \param obj write the file to this object stream
-     *  \param filename the file to embedd
+    /** Embedd the data read from a stream into a stream object
+     *  \param obj write the data to this object stream
+     *  \param stream the stream to read the data from
+     *  \param compress whether to compress the data
      */
-    void EmbeddFile(PdfObject& obj, const std::string_view& filename) const;
+    void EmbeddStream(PdfObject& obj, InputStream& stream, bool compress) const;
+
+    const PdfObject* findEmbeddedFile() const;
 
     /** Strips path from a file, according to \a striPath
      *  \param filename a file name string
@@ -75,11 +109,6 @@ private:
      *     or \a filename without a path part, if \a striPath is true
      */
     std::string MaybeStripPath(const std::string_view& filename, bool stripPath) const;
-
-    /* Petr P. Petrov 17 September 2009*/
-    /** Embeds the file from memory
-      */
-    void EmbeddFileFromMem(PdfObject& obj, const char* data, size_t size) const;
 };
 
 };
@@ -48,9 +48,9 @@ static const char* s_shortFilters[] = {
 class PdfFilteredEncodeStream : public OutputStream
 {
 private:
-    void init(OutputStream& outputStream, PdfFilterType filterType)
+    void init(OutputStream& outputStream, PdfFilterType filterType, PdfCompressionLevel level)
     {
-        m_filter = PdfFilterFactory::Create(filterType);
+        m_filter = PdfFilterFactory::Create(filterType, level);
         if (m_filter == nullptr)
             PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedFilter);
 
@@ -58,15 +58,15 @@ private:
     }
 
 public:
-    PdfFilteredEncodeStream(OutputStream& outputStream, PdfFilterType filterType)
+    PdfFilteredEncodeStream(OutputStream& outputStream, PdfFilterType filterType, PdfCompressionLevel level)
     {
-        init(outputStream, filterType);
+        init(outputStream, filterType, level);
     }
 
-    PdfFilteredEncodeStream(unique_ptr<OutputStream> outputStream, PdfFilterType filterType)
+    PdfFilteredEncodeStream(unique_ptr<OutputStream> outputStream, PdfFilterType filterType, PdfCompressionLevel level)
         : m_OutputStream(std::move(outputStream))
     {
-        init(*outputStream, filterType);
+        init(*m_OutputStream, filterType, level);
     }
 protected:
     void writeBuffer(const char* buffer, size_t len) override
@@ -83,35 +83,127 @@ private:
     unique_ptr<PdfFilter> m_filter;
 };
 
-class PdfFilteredDecodeStream : public OutputStream
+// Decodes with a chain of filters, where every filter writes to a
+// stage that feeds the next filter, and the last filter writes to
+// the output stream. The small writes of a filter are gathered in a
+// slice of a block buffer shared by all the stages, so the filters
+// receive whole blocks and no buffer grows while decoding
+class PdfFilterChainDecodeStream final : public OutputStream
 {
-private:
-    void init(OutputStream& outputStream, const PdfFilterType filterType,
-        const PdfDictionary* decodeParms)
+    static constexpr size_t BlockSize = 16384;
+
+    class Stage final : public OutputStream
     {
-        m_filter = PdfFilterFactory::Create(filterType);
-        if (m_filter == nullptr)
-            PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedFilter);
+    public:
+        Stage()
+            : m_Next(nullptr), m_Block(nullptr), m_Length(0), m_FilterFailed(false) { }
 
-        m_filter->BeginDecode(outputStream, decodeParms);
-    }
+        void Init(PdfFilter& next, char* block)
+        {
+            m_Next = &next;
+            m_Block = block;
+        }
+
+    protected:
+        void writeBuffer(const char* buffer, size_t len) override
+        {
+            if (m_Length + len > BlockSize)
+                writeBlock();
+
+            if (len >= BlockSize)
+            {
+                decodeBlock(buffer, len);
+            }
+            else
+            {
+                std::memcpy(m_Block + m_Length, buffer, len);
+                m_Length += len;
+            }
+        }
+
+        void flush() override
+        {
+            // The previous filter ended, so write the remaining
+            // data and end also the next filter
+            if (m_FilterFailed)
+                return;
+
+            writeBlock();
+            try
+            {
+                m_Next->EndDecode();
+            }
+            catch (PdfError& e)
+            {
+                PDFMM_PUSH_FRAME_INFO(e, "PdfFilter::EndDecode() failed in filter of type {}",
+                    PdfFilterFactory::FilterTypeToName(m_Next->GetType()));
+                m_FilterFailed = true;
+                throw;
+            }
+        }
+
+    private:
+        void writeBlock()
+        {
+            if (m_Length == 0)
+                return;
+
+            size_t length = m_Length;
+            m_Length = 0;
+            decodeBlock(m_Block, length);
+        }
+
+        void decodeBlock(const char* buffer, size_t len)
+        {
+            try
+            {
+                m_Next->DecodeBlock({ buffer, len });
+            }
+            catch (PdfError& e)
+            {
+                PDFMM_PUSH_FRAME(e);
+                m_FilterFailed = true;
+                throw;
+            }
+        }
+
+    private:
+        PdfFilter* m_Next;
+        char* m_Block;
+        size_t m_Length;
+        bool m_FilterFailed;
+    };
 
 public:
-    PdfFilteredDecodeStream(OutputStream& outputStream, const PdfFilterType filterType,
-        const PdfDictionary* decodeParms)
-        : m_FilterFailed(false)
+    PdfFilterChainDecodeStream(OutputStream& outputStream, const PdfFilterList& filters,
+        const PdfObject* decodeParms)
+        : m_Stages(filters.size() - 1), m_FilterFailed(false)
     {
-        init(outputStream, filterType, decodeParms);
-    }
+        m_Blocks->resize(BlockSize * (filters.size() - 1));
+        m_Filters.reserve(filters.size());
+        for (auto filterType : filters)
+        {
+            auto filter = PdfFilterFactory::Create(filterType);
+            if (filter == nullptr)
+                PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedFilter);
 
-    PdfFilteredDecodeStream(unique_ptr<OutputStream> outputStream, const PdfFilterType filterType,
-        const PdfDictionary* decodeParms)
-        : m_OutputStream(std::move(outputStream)), m_FilterFailed(false)
-    {
-        if (outputStream == nullptr)
-            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Output stream must be not null");
+            m_Filters.push_back(std::move(filter));
+        }
 
-        init(*outputStream, filterType, decodeParms);
+        // Begin from the last filter, so every filter writes
+        // to a stage whose next filter already began
+        for (size_t i = filters.size(); i-- > 0; )
+        {
+            if (i + 1 == filters.size())
+            {
+                m_Filters[i]->BeginDecode(outputStream, getDecodeParms(decodeParms, i));
+            }
+            else
+            {
+                m_Stages[i].Init(*m_Filters[i + 1], m_Blocks->data() + i * BlockSize);
+                m_Filters[i]->BeginDecode(m_Stages[i], getDecodeParms(decodeParms, i));
+            }
+        }
     }
 
 protected:
@@ -119,7 +211,7 @@ protected:
     {
         try
         {
-            m_filter->DecodeBlock({ buffer, len });
+            m_Filters[0]->DecodeBlock({ buffer, len });
         }
         catch (PdfError& e)
         {
@@ -128,25 +220,50 @@ protected:
             throw;
         }
     }
+
     void flush() override
     {
+        // Ending the first filter flushes its stage, that
+        // ends the next filter and so on down the chain
         try
         {
             if (!m_FilterFailed)
-                m_filter->EndDecode();
+                m_Filters[0]->EndDecode();
         }
         catch (PdfError& e)
         {
             PDFMM_PUSH_FRAME_INFO(e, "PdfFilter::EndDecode() failed in filter of type {}",
-                PdfFilterFactory::FilterTypeToName(m_filter->GetType()));
+                PdfFilterFactory::FilterTypeToName(m_Filters[0]->GetType()));
             m_FilterFailed = true;
             throw;
         }
     }
 
 private:
-    shared_ptr<OutputStream> m_OutputStream;
-    unique_ptr<PdfFilter> m_filter;
+    static const PdfDictionary* getDecodeParms(const PdfObject* decodeParms, size_t index)
+    {
+        // A single dictionary is given to all the filters, while
+        // an array has a dictionary or null for every filter
+        if (decodeParms == nullptr)
+            return nullptr;
+
+        if (decodeParms->IsDictionary())
+            return &decodeParms->GetDictionary();
+
+        if (decodeParms->IsArray() && index < decodeParms->GetArray().size())
+        {
+            auto& obj = decodeParms->GetArray().FindAt((unsigned)index);
+            if (obj.IsDictionary())
+                return &obj.GetDictionary();
+        }
+
+        return nullptr;
+    }
+
+private:
+    vector<unique_ptr<PdfFilter>> m_Filters;
+    vector<Stage> m_Stages;
+    PdfScratchBuffer m_Blocks;
     bool m_FilterFailed;
 };
 
@@ -173,6 +290,9 @@ void PdfFilter::EncodeTo(charbuff& outBuffer, const bufferview& inBuffer) const
     if (!this->CanEncode())
         PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedFilter);
 
+    if (const_cast<PdfFilter*>(this)->EncodeToImpl(outBuffer, inBuffer))
+        return;
+
     BufferStreamDevice stream(outBuffer);
     const_cast<PdfFilter*>(this)->BeginEncode(stream);
     const_cast<PdfFilter*>(this)->EncodeBlock(inBuffer);
@@ -185,17 +305,35 @@ void PdfFilter::DecodeTo(charbuff& outBuffer, const bufferview& inBuffer,
     if (!this->CanDecode())
         PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedFilter);
 
+    if (const_cast<PdfFilter*>(this)->DecodeToImpl(outBuffer, inBuffer, decodeParms))
+        return;
+
     BufferStreamDevice stream(outBuffer);
     const_cast<PdfFilter*>(this)->BeginDecode(stream, decodeParms);
     const_cast<PdfFilter*>(this)->DecodeBlock(inBuffer);
     const_cast<PdfFilter*>(this)->EndDecode();
 }
 
+bool PdfFilter::EncodeToImpl(charbuff& outBuffer, const bufferview& inBuffer)
+{
+    (void)outBuffer;
+    (void)inBuffer;
+    return false;
+}
+
+bool PdfFilter::DecodeToImpl(charbuff& outBuffer, const bufferview& inBuffer, const PdfDictionary* decodeParms)
+{
+    (void)outBuffer;
+    (void)inBuffer;
+    (void)decodeParms;
+    return false;
+}
+
 //
 // PdfFilterFactory code
 //
 
-unique_ptr<PdfFilter> PdfFilterFactory::Create(PdfFilterType filterType)
+unique_ptr<PdfFilter> PdfFilterFactory::Create(PdfFilterType filterType, PdfCompressionLevel level)
 {
     PdfFilter* filter = nullptr;
     switch (filterType)
@@ -216,7 +354,7 @@ unique_ptr<PdfFilter> PdfFilterFactory::Create(PdfFilterType filterType)
             break;
 
         case PdfFilterType::FlateDecode:
-            filter = new PdfFlateFilter();
+            filter = new PdfFlateFilter(level);
             break;
 
         case PdfFilterType::RunLengthDecode:
@@ -232,12 +370,8 @@ unique_ptr<PdfFilter> PdfFilterFactory::Create(PdfFilterType filterType)
 #endif // PDFMM_HAVE_JPEG_LIB
 
         case PdfFilterType::CCITTFaxDecode:
-#ifdef PDFMM_HAVE_TIFF_LIB
             filter = new PdfCCITTFilter();
             break;
-#else
-            break;
-#endif // PDFMM_HAVE_TIFF_LIB
 
 
         case PdfFilterType::JBIG2Decode:
@@ -250,18 +384,19 @@ unique_ptr<PdfFilter> PdfFilterFactory::Create(PdfFilterType filterType)
     return unique_ptr<PdfFilter>(filter);
 }
 
-unique_ptr<OutputStream> PdfFilterFactory::CreateEncodeStream(const PdfFilterList& filters, OutputStream& stream)
+unique_ptr<OutputStream> PdfFilterFactory::CreateEncodeStream(const PdfFilterList& filters, OutputStream& stream,
+    PdfCompressionLevel level)
 {
     PdfFilterList::const_iterator it = filters.begin();
 
     PDFMM_RAISE_LOGIC_IF(!filters.size(), "Cannot create an EncodeStream from an empty list of filters");
 
-    unique_ptr<OutputStream> filter(new PdfFilteredEncodeStream(stream, *it));
+    unique_ptr<OutputStream> filter(new PdfFilteredEncodeStream(stream, *it, level));
     it++;
 
     while (it != filters.end())
     {
-        filter.reset(new PdfFilteredEncodeStream(std::move(filter), *it));
+        filter.reset(new PdfFilteredEncodeStream(std::move(filter), *it, level));
         it++;
     }
 
@@ -282,29 +417,14 @@ unique_ptr<OutputStream> PdfFilterFactory::CreateDecodeStream(const PdfFilterLis
 unique_ptr<OutputStream> PdfFilterFactory::createDecodeStream(const PdfFilterList& filters, OutputStream& stream,
     const PdfDictionary* dictionary)
 {
-    PdfFilterList::const_reverse_iterator it = filters.rbegin();
-
     PDFMM_RAISE_LOGIC_IF(filters.size() == 0, "Cannot create an DecodeStream from an empty list of filters");
 
     // TODO: Add also support for DP? (used in inline images)
-    const PdfObject* decodeParams;
-    if (dictionary != nullptr
-        && (decodeParams = dictionary->FindKey("DecodeParms")) != nullptr
-        && decodeParams->IsDictionary())
-    {
-        dictionary = &decodeParams->GetDictionary();
-    }
-
-    unique_ptr<OutputStream> filterStream(new PdfFilteredDecodeStream(stream, *it, dictionary));
-    it++;
-
-    while (it != filters.rend())
-    {
-        filterStream.reset(new PdfFilteredDecodeStream(std::move(filterStream), *it, dictionary));
-        it++;
-    }
+    const PdfObject* decodeParms = nullptr;
+    if (dictionary != nullptr)
+        decodeParms = dictionary->FindKey("DecodeParms");
 
-    return filterStream;
+    return unique_ptr<OutputStream>(new PdfFilterChainDecodeStream(stream, filters, decodeParms));
 }
 
 PdfFilterType PdfFilterFactory::FilterNameToType(const PdfName& name, bool supportShortNames)
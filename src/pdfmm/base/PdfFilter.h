@@ -270,6 +270,27 @@ protected:
      */
     virtual void EndDecodeImpl() { }
 
+    /** Real implementation of a one-shot EncodeTo(). NEVER call this method directly.
+     *
+     *  By default this function does nothing and EncodeTo() encodes the data
+     *  progressively. Filters having a faster path for whole buffers can
+     *  override it, appending the encoded data to the output buffer.
+     *
+     *  \returns true if the data was encoded, false to encode it progressively
+     */
+    virtual bool EncodeToImpl(charbuff& outBuffer, const bufferview& inBuffer);
+
+    /** Real implementation of a one-shot DecodeTo(). NEVER call this method directly.
+     *
+     *  By default this function does nothing and DecodeTo() decodes the data
+     *  progressively. Filters having a faster path for whole buffers can
+     *  override it, appending the decoded data to the output buffer.
+     *  The output buffer must be left untouched when returning false.
+     *
+     *  \returns true if the data was decoded, false to decode it progressively
+     */
+    virtual bool DecodeToImpl(charbuff& outBuffer, const bufferview& inBuffer, const PdfDictionary* decodeParms);
+
     inline OutputStream* GetStream() const { return m_OutputStream; }
 
 private:
@@ -290,11 +311,13 @@ public:
      *  with it.
      *
      *  \param filterType return value of GetType() for filter to be created
+     *  \param level the compression level, used by the Flate filter
      *
      *  \returns a new PdfFilter allocated using new, or nullptr if no
      *           filter is available for this type.
      */
-    static std::unique_ptr<PdfFilter> Create(PdfFilterType filterType);
+    static std::unique_ptr<PdfFilter> Create(PdfFilterType filterType,
+        PdfCompressionLevel level = PdfCompressionLevel::Default);
 
     /** Create an OutputStream that applies a list of filters
      *  on all data written to it.
@@ -302,11 +325,13 @@ public:
      *  \param filters a list of filters
      *  \param stream write all data to this OutputStream after it has been
      *         encoded
+     *  \param level the compression level, used by the Flate filter
      *  \returns a new OutputStream that has to be deleted by the caller.
      *
      *  \see PdfFilterFactory::CreateFilterList
      */
-    static std::unique_ptr<OutputStream> CreateEncodeStream(const PdfFilterList& filters, OutputStream& stream);
+    static std::unique_ptr<OutputStream> CreateEncodeStream(const PdfFilterList& filters, OutputStream& stream,
+        PdfCompressionLevel level = PdfCompressionLevel::Default);
 
     /** Create an OutputStream that applies a list of filters
      *  on all data written to it.
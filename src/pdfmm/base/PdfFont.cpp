@@ -9,6 +9,8 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfFont.h"
 
+#include <deque>
+#include <mutex>
 #include <regex>
 #include <utfcpp/utf8.h>
 
@@ -19,13 +21,16 @@
 #include "PdfArray.h"
 #include "PdfEncoding.h"
 #include "PdfEncodingFactory.h"
+#include "PdfFilter.h"
 #include "PdfInputStream.h"
+#include "PdfMemoryGovernor.h"
 #include "PdfObjectStream.h"
 #include "PdfWriter.h"
 #include "PdfCharCodeMap.h"
 #include "PdfEncodingShim.h"
 #include "PdfFontMetrics.h"
 #include "PdfPage.h"
+#include "PdfStreamDevice.h"
 #include "PdfFontMetricsStandard14.h"
 #include "PdfFontManager.h"
 #include "PdfFontMetricsFreetype.h"
@@ -36,6 +41,86 @@ using namespace std;
 using namespace cmn;
 using namespace mm;
 
+// The maximum number of subsets kept by the shared cache
+static constexpr size_t MaxSharedSubsets = 256;
+
+namespace
+{
+    // The used glyphs are the GIDs with their CIDs, as
+    // the CIDs determine the order of the glyphs in the subset
+    using SharedSubsetKey = tuple<size_t, size_t, PdfFontType, PdfFilterType,
+        PdfCompressionLevel, vector<pair<unsigned, unsigned>>>;
+}
+
+class PdfFont::SharedSubsets final
+{
+public:
+    static SharedSubsets& GetInstance()
+    {
+        static SharedSubsets s_subsets;
+        return s_subsets;
+    }
+
+    bool IsEnabled()
+    {
+        lock_guard<mutex> lock(Mutex);
+        return Enabled;
+    }
+
+    // Evict the oldest subset, returning the size released to
+    // PdfMemoryGovernor. The mutex must be held
+    size_t EvictOldest()
+    {
+        auto found = Subsets.find(*Keys.front());
+        size_t released = found->second.Reserved;
+        PdfMemoryGovernor::Release(released);
+        Subsets.erase(found);
+        Keys.pop_front();
+        return released;
+    }
+
+    void Clear()
+    {
+        while (Keys.size() != 0)
+            (void)EvictOldest();
+    }
+
+private:
+    SharedSubsets()
+    {
+        m_callback = PdfMemoryGovernor::AddPressureCallback([this](size_t size) {
+            lock_guard<mutex> lock(Mutex);
+            size_t released = 0;
+            while (released < size && Keys.size() != 0)
+                released += EvictOldest();
+
+            return released;
+        });
+    }
+
+    ~SharedSubsets()
+    {
+        PdfMemoryGovernor::RemovePressureCallback(m_callback);
+        Clear();
+    }
+
+public:
+    struct SharedSubset
+    {
+        shared_ptr<const PreparedFontFile> File;
+        size_t Reserved;
+    };
+
+    mutex Mutex;
+    bool Enabled = false;
+    map<SharedSubsetKey, SharedSubset> Subsets;
+    // The keys in insertion order, for the eviction
+    deque<const SharedSubsetKey*> Keys;
+
+private:
+    unsigned m_callback;
+};
+
 static double getCharWidth(double widthGlyph, const PdfTextState& state, bool ignoreCharSpacing);
 static string_view toString(PdfFontStretch stretch);
 
@@ -241,11 +326,134 @@ void PdfFont::EmbedFont()
         return;
 
     if (m_SubsettingEnabled)
+    {
+        // Try to reuse the subset of another document
+        if (SharedSubsets::GetInstance().IsEnabled())
+            PrepareEmbed();
+
         embedFontSubset();
+    }
     else
+    {
         embedFont();
+    }
 
     m_IsEmbedded = true;
+    m_preparedFontFile.reset();
+}
+
+void PdfFont::PrepareEmbed()
+{
+    if (m_IsEmbedded || !m_EmbeddingEnabled || m_preparedFontFile != nullptr
+        || PdfObjectStream::DefaultFilter == PdfFilterType::None)
+    {
+        return;
+    }
+
+    auto& shared = SharedSubsets::GetInstance();
+    SharedSubsetKey key;
+    bool useShared = false;
+    if (m_SubsettingEnabled)
+    {
+        useShared = shared.IsEnabled();
+        if (useShared)
+        {
+            auto fontData = m_Metrics->GetOrLoadFontFileData();
+            vector<pair<unsigned, unsigned>> glyphs;
+            glyphs.reserve(m_SubsetGIDs.size());
+            for (auto& pair : m_SubsetGIDs)
+                glyphs.push_back({ pair.first, pair.second.Id });
+
+            key = SharedSubsetKey(std::hash<string_view>()(string_view(fontData.data(), fontData.size())),
+                fontData.size(), GetType(), PdfObjectStream::DefaultFilter,
+                GetDocument().GetCompressionLevel(), std::move(glyphs));
+
+            lock_guard<mutex> lock(shared.Mutex);
+            auto found = shared.Subsets.find(key);
+            if (found != shared.Subsets.end())
+            {
+                m_preparedFontFile = found->second.File;
+                return;
+            }
+        }
+    }
+
+    auto filter = PdfFilterFactory::Create(PdfObjectStream::DefaultFilter, GetDocument().GetCompressionLevel());
+    if (filter == nullptr || !filter->CanEncode())
+        return;
+
+    shared_ptr<PreparedFontFile> prepared(new PreparedFontFile());
+    bufferview data;
+    if (m_SubsettingEnabled)
+    {
+        if (!tryBuildFontSubset(prepared->Subset))
+            return;
+
+        data = prepared->Subset;
+    }
+    else
+    {
+        data = m_Metrics->GetOrLoadFontFileData();
+    }
+
+    if (data.empty())
+        return;
+
+    filter->EncodeTo(prepared->Encoded, data);
+    m_preparedFontFile = prepared;
+    if (!useShared)
+        return;
+
+    // NOTE: Reserve before locking, since the pressure
+    // may evict subsets too. Subsets not fitting the
+    // budget are not shared
+    size_t reserved;
+    if (!PdfMemoryGovernor::TryReserve(prepared->Subset.size() + prepared->Encoded.size(), reserved))
+        return;
+
+    lock_guard<mutex> lock(shared.Mutex);
+    if (!shared.Enabled)
+    {
+        PdfMemoryGovernor::Release(reserved);
+        return;
+    }
+
+    auto inserted = shared.Subsets.emplace(std::move(key), SharedSubsets::SharedSubset{ std::move(prepared), reserved });
+    if (!inserted.second)
+    {
+        PdfMemoryGovernor::Release(reserved);
+        return;
+    }
+
+    shared.Keys.push_back(&inserted.first->first);
+    if (shared.Keys.size() > MaxSharedSubsets)
+        (void)shared.EvictOldest();
+}
+
+void PdfFont::SetSharedSubsetCacheEnabled(bool enabled)
+{
+    auto& shared = SharedSubsets::GetInstance();
+    lock_guard<mutex> lock(shared.Mutex);
+    shared.Enabled = enabled;
+    if (!enabled)
+        shared.Clear();
+}
+
+bool PdfFont::tryBuildFontSubset(charbuff& output) const
+{
+    (void)output;
+    return false;
+}
+
+bufferview PdfFont::GetFontSubset(charbuff& buffer) const
+{
+    if (m_preparedFontFile != nullptr)
+        return m_preparedFontFile->Subset;
+
+    if (!tryBuildFontSubset(buffer))
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NotImplemented, "Subsetting not implemented for this font type");
+
+    return buffer;
 }
 
 void PdfFont::embedFont()
@@ -322,7 +530,67 @@ bool PdfFont::TryGetStringWidth(const PdfString& encodedStr, const PdfTextState&
     if (!m_Encoding->TryConvertToCIDs(encodedStr, cids))
         success = false;
 
-    width = getStringWidth(cids, state);
+    // NOTE: Missing glyphs are measured with
+    // the default width, and don't fail here
+    (void)TryGetStringAdvances(cids, state, { }, width);
+    return success;
+}
+
+bool PdfFont::TryGetStringAdvances(const cspan<char32_t>& codePoints, const PdfTextState& state,
+    const mspan<double>& advances, double& width) const
+{
+    if (advances.size() != 0 && advances.size() < codePoints.size())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The advances are fewer than the code points");
+
+    bool success = true;
+    width = 0;
+    for (size_t i = 0; i < codePoints.size(); i++)
+    {
+        unsigned gid;
+        double glyphWidth;
+        if (!TryGetGID(codePoints[i], PdfGlyphAccess::Width, gid)
+            || !m_Metrics->TryGetGlyphWidth(gid, glyphWidth))
+        {
+            glyphWidth = m_Metrics->GetDefaultWidth();
+            success = false;
+        }
+
+        double advance = getCharWidth(glyphWidth, state, false);
+        if (advances.size() != 0)
+            advances[i] = advance;
+
+        width += advance;
+    }
+
+    return success;
+}
+
+bool PdfFont::TryGetStringAdvances(const cspan<PdfCID>& cids, const PdfTextState& state,
+    const mspan<double>& advances, double& width) const
+{
+    if (advances.size() != 0 && advances.size() < cids.size())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The advances are fewer than the CIDs");
+
+    bool success = true;
+    width = 0;
+    for (size_t i = 0; i < cids.size(); i++)
+    {
+        unsigned gid;
+        double glyphWidth;
+        if (!TryMapCIDToGID(cids[i].Id, PdfGlyphAccess::Width, gid)
+            || !m_Metrics->TryGetGlyphWidth(gid, glyphWidth))
+        {
+            glyphWidth = m_Metrics->GetDefaultWidth();
+            success = false;
+        }
+
+        double advance = getCharWidth(glyphWidth, state, false);
+        if (advances.size() != 0)
+            advances[i] = advance;
+
+        width += advance;
+    }
+
     return success;
 }
 
@@ -386,10 +654,13 @@ void PdfFont::GetBoundingBox(PdfArray& arr) const
     arr.Clear();
     vector<double> bbox;
     m_Metrics->GetBoundingBox(bbox);
-    arr.Add(PdfObject(static_cast<int64_t>(std::round(bbox[0] / matrix[0]))));
-    arr.Add(PdfObject(static_cast<int64_t>(std::round(bbox[1] / matrix[3]))));
-    arr.Add(PdfObject(static_cast<int64_t>(std::round(bbox[2] / matrix[0]))));
-    arr.Add(PdfObject(static_cast<int64_t>(std::round(bbox[3] / matrix[3]))));
+    int64_t scaled[4] = {
+        static_cast<int64_t>(std::round(bbox[0] / matrix[0])),
+        static_cast<int64_t>(std::round(bbox[1] / matrix[3])),
+        static_cast<int64_t>(std::round(bbox[2] / matrix[0])),
+        static_cast<int64_t>(std::round(bbox[3] / matrix[3]))
+    };
+    arr.AddNumbers(scaled);
 }
 
 void PdfFont::FillDescriptor(PdfDictionary& dict) const
@@ -525,7 +796,19 @@ PdfObject* PdfFont::embedFontFileData(PdfObject& descriptor, const PdfName& font
 {
     auto contents = GetDocument().GetObjects().CreateDictionaryObject();
     descriptor.GetDictionary().AddKeyIndirect(fontFileName, contents);
-    contents->GetOrCreateStream().Set(data);
+    if (m_preparedFontFile == nullptr)
+    {
+        contents->GetOrCreateStream().Set(data);
+    }
+    else
+    {
+        // The data was already encoded by PrepareEmbed()
+        contents->GetDictionary().AddKey(PdfName::KeyFilter,
+            PdfName(PdfFilterFactory::FilterTypeToName(PdfObjectStream::DefaultFilter)));
+        SpanStreamDevice input(m_preparedFontFile->Encoded);
+        contents->GetOrCreateStream().SetRawData(input);
+    }
+
     return contents;
 }
 
@@ -534,15 +817,6 @@ void PdfFont::initImported()
     // By default do nothing
 }
 
-double PdfFont::getStringWidth(const vector<PdfCID>& cids, const PdfTextState& state) const
-{
-    double width = 0;
-    for (auto& cid : cids)
-        width += getCharWidth(GetCIDWidthRaw(cid.Id), state, false);
-
-    return width;
-}
-
 double PdfFont::GetLineSpacing(const PdfTextState& state) const
 {
     return m_Metrics->GetLineSpacing() * state.FontSize;
@@ -584,13 +858,8 @@ double PdfFont::GetDescent(const PdfTextState& state) const
 
 PdfCID PdfFont::AddSubsetGIDSafe(unsigned gid, const unicodeview& codePoints)
 {
-    PDFMM_ASSERT(m_SubsettingEnabled && !m_IsEmbedded);
-    auto found = m_SubsetGIDs.find(gid);
-    if (found != m_SubsetGIDs.end())
-        return found->second;
-
     PdfCID ret;
-    if (!tryAddSubsetGID(gid, codePoints, ret))
+    if (!TryAddSubsetGIDSafe(gid, codePoints, ret))
     {
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile,
             "The encoding doesn't support these characters or the gid is already present");
@@ -599,6 +868,20 @@ PdfCID PdfFont::AddSubsetGIDSafe(unsigned gid, const unicodeview& codePoints)
     return ret;
 }
 
+bool PdfFont::TryAddSubsetGIDSafe(unsigned gid, const unicodeview& codePoints, PdfCID& cid)
+{
+    PDFMM_ASSERT(m_SubsettingEnabled && !m_IsEmbedded);
+    lock_guard<mutex> lock(m_subsetMutex);
+    auto found = findSubsetCID(gid);
+    if (found != nullptr)
+    {
+        cid = *found;
+        return true;
+    }
+
+    return tryAddSubsetGID(gid, codePoints, cid);
+}
+
 PdfCharCode PdfFont::AddCharCodeSafe(unsigned gid, const unicodeview& codePoints)
 {
     // NOTE: This method is supported only when doing fully embedding
@@ -608,6 +891,7 @@ PdfCharCode PdfFont::AddCharCodeSafe(unsigned gid, const unicodeview& codePoints
         && !IsObjectLoaded()
         && m_Metrics->HasUnicodeMapping());
 
+    lock_guard<mutex> lock(m_subsetMutex);
     PdfCharCode code;
     if (m_DynamicToUnicodeMap->TryGetCharCode(codePoints, code))
         return code;
@@ -668,7 +952,6 @@ bool PdfFont::tryConvertToGIDs(const std::string_view& utf8Str, PdfGlyphAccess a
     {
         auto it = utf8Str.begin();
         auto end = utf8Str.end();
-        vector<unsigned> gids;
         while (it != end)
         {
             char32_t cp = utf8::next(it, end);
@@ -700,11 +983,15 @@ bool PdfFont::tryAddSubsetGID(unsigned gid, const unicodeview& codePoints, PdfCI
     {
         // We start numberings CIDs from 1 since CID 0
         // is reserved for fallbacks
-        auto inserted = m_SubsetGIDs.try_emplace(gid, PdfCID((unsigned)m_SubsetGIDs.size() + 1));
-        cid = inserted.first->second;
-        if (!inserted.second)
+        auto found = findSubsetCID(gid);
+        if (found != nullptr)
+        {
+            cid = *found;
             return false;
+        }
 
+        cid = PdfCID((unsigned)m_SubsetGIDs.size() + 1);
+        insertSubsetCID(gid, cid);
         m_DynamicCIDMap->PushMapping(cid.Unit, cid.Id);
         m_DynamicToUnicodeMap->PushMapping(cid.Unit, codePoints);
         return true;
@@ -720,12 +1007,40 @@ bool PdfFont::tryAddSubsetGID(unsigned gid, const unicodeview& codePoints, PdfCI
 
         // We start numberings CIDs from 1 since CID 0
         // is reserved for fallbacks
-        auto inserted = m_SubsetGIDs.try_emplace(gid, PdfCID((unsigned)m_SubsetGIDs.size() + 1, codeUnit));
-        cid = inserted.first->second;
-        return inserted.second;
+        auto found = findSubsetCID(gid);
+        if (found != nullptr)
+        {
+            cid = *found;
+            return false;
+        }
+
+        cid = PdfCID((unsigned)m_SubsetGIDs.size() + 1, codeUnit);
+        insertSubsetCID(gid, cid);
+        return true;
     }
 }
 
+const PdfCID* PdfFont::findSubsetCID(unsigned gid) const
+{
+    if (gid >= m_subsetCIDs.size() || m_subsetCIDs[gid].Id == 0)
+        return nullptr;
+
+    return &m_subsetCIDs[gid];
+}
+
+void PdfFont::insertSubsetCID(unsigned gid, const PdfCID& cid)
+{
+    if (gid >= m_subsetCIDs.size())
+    {
+        // Grow geometrically, but not beyond the glyph count
+        m_subsetCIDs.resize(std::max((size_t)gid + 1,
+            std::min((size_t)m_Metrics->GetGlyphCount(), m_subsetCIDs.size() * 2)));
+    }
+
+    m_subsetCIDs[gid] = cid;
+    m_SubsetGIDs.try_emplace(gid, cid);
+}
+
 void PdfFont::AddSubsetGIDs(const PdfString& encodedStr)
 {
     if (IsObjectLoaded())
@@ -746,12 +1061,13 @@ void PdfFont::AddSubsetGIDs(const PdfString& encodedStr)
     vector<PdfCID> cids;
     unsigned gid;
     (void)GetEncoding().TryConvertToCIDs(encodedStr, cids);
+    lock_guard<mutex> lock(m_subsetMutex);
     for (auto& cid : cids)
     {
-        if (TryMapCIDToGID(cid.Id, PdfGlyphAccess::FontProgram, gid))
+        if (TryMapCIDToGID(cid.Id, PdfGlyphAccess::FontProgram, gid)
+            && findSubsetCID(gid) == nullptr)
         {
-            (void)m_SubsetGIDs.try_emplace(gid,
-                PdfCID((unsigned)m_SubsetGIDs.size() + 1, cid.Unit));
+            insertSubsetCID(gid, PdfCID((unsigned)m_SubsetGIDs.size() + 1, cid.Unit));
         }
     }
 }
@@ -11,6 +11,7 @@
 
 #include "PdfDeclarations.h"
 
+#include <mutex>
 #include <ostream>
 
 #include "PdfTextState.h"
@@ -46,6 +47,7 @@ struct PdfFontCreateParams
  */
 class PDFMM_API PdfFont : public PdfDictionaryElement
 {
+    class SharedSubsets;
     friend class PdfFontFactory;
     friend class PdfFontObject;
     friend class PdfEncoding;
@@ -180,6 +182,31 @@ public:
      */
     bool TryGetStringWidth(const PdfString& encodedStr, const PdfTextState& state, double& width) const;
 
+    /** Retrieve the advances of a run of code points in PDF units when
+     *  drawn with the current font, without allocating
+     *  \param codePoints the code points of the run. No glyph substitution
+     *      is performed, so every code point gets exactly one advance
+     *  \param advances receives the advance of every code point. It must be
+     *      as large as the run, or empty when only the total width is needed
+     *  \param width the total width of the run
+     *  \returns false if some glyphs could not be found, which are measured
+     *      with the default width
+     */
+    bool TryGetStringAdvances(const cspan<char32_t>& codePoints, const PdfTextState& state,
+        const mspan<double>& advances, double& width) const;
+
+    /** Retrieve the advances of a run of CIDs in PDF units when
+     *  drawn with the current font, without allocating
+     *  \param cids the CIDs of the run, as converted by PdfEncoding::TryConvertToCIDs
+     *  \param advances receives the advance of every CID. It must be
+     *      as large as the run, or empty when only the total width is needed
+     *  \param width the total width of the run
+     *  \returns false if some glyphs could not be found, which are measured
+     *      with the default width
+     */
+    bool TryGetStringAdvances(const cspan<PdfCID>& cids, const PdfTextState& state,
+        const mspan<double>& advances, double& width) const;
+
     /**
      *  \remarks Doesn't throw if characater glyph could not be found
      */
@@ -358,6 +385,19 @@ protected:
 
     virtual void embedFontSubset();
 
+    /** Build the font program of the subset of the used glyphs
+     * \remarks It must not modify the font or the document, as
+     *      it's called concurrently for the fonts of a document
+     * \returns false if the font can't build the subset without
+     *      embedding it, that is the default
+     */
+    virtual bool tryBuildFontSubset(charbuff& output) const;
+
+    /** Get the subset built by PrepareEmbed(), if any,
+     * otherwise build it in the given buffer
+     */
+    bufferview GetFontSubset(charbuff& buffer) const;
+
 private:
     PdfFont(const PdfFont& rhs) = delete;
 
@@ -366,6 +406,18 @@ private:
      */
     void EmbedFont();
 
+    /** Build the subset of the font, if subsetting, and encode the font
+     * program with the default stream filter, so EmbedFont() has just
+     * to create the objects. It doesn't modify the document, so
+     * different fonts can be prepared concurrently
+     */
+    void PrepareEmbed();
+
+    /** Enable or disable the cache of the encoded subsets shared
+     * by the fonts of all the documents. See PdfFontManager::SetSharedSubsetCacheEnabled()
+     */
+    static void SetSharedSubsetCacheEnabled(bool enabled);
+
     /**
      * Perform inititialization tasks for fonts imported or created
      * from scratch
@@ -379,9 +431,16 @@ private:
      * \param codePoints code points mapped by this gid. May be a single
      *      code point or a ligature
      * \return A mapped CID. Return existing CID if already present
+     * \remarks It's internally synchronized, so text can be
+     *      encoded with the font concurrently
      */
     PdfCID AddSubsetGIDSafe(unsigned gid, const unicodeview& codePoints);
 
+    /** Like AddSubsetGIDSafe, but return false instead of throwing
+     * if the code points can't be mapped by the font encoding
+     */
+    bool TryAddSubsetGIDSafe(unsigned gid, const unicodeview& codePoints, PdfCID& cid);
+
     /** Add dynamic charcode from code points.
      *
      * \return A mapped code. Return existing code if already present
@@ -397,11 +456,11 @@ private:
 private:
     bool tryConvertToGIDs(const std::string_view& utf8Str, PdfGlyphAccess access, std::vector<unsigned>& gids) const;
     bool tryAddSubsetGID(unsigned gid, const unicodeview& codePoints, PdfCID& cid);
+    const PdfCID* findSubsetCID(unsigned gid) const;
+    void insertSubsetCID(unsigned gid, const PdfCID& cid);
 
     void initBase(const PdfEncoding& encoding);
 
-    double getStringWidth(const std::vector<PdfCID>& cids, const PdfTextState& state) const;
-
     PdfObject* embedFontFileData(PdfObject& descriptor, const PdfName& fontFileName, const bufferview& data);
 
     static std::unique_ptr<PdfFont> createFontForType(PdfDocument& doc, const PdfFontMetricsConstPtr& metrics,
@@ -414,8 +473,22 @@ private:
     bool m_IsEmbedded;
     bool m_SubsettingEnabled;
     UsedGIDsMap m_SubsetGIDs;
+    // The CIDs of the subset indexed by GID, with
+    // Id 0 for the unused GIDs, for fast lookups
+    std::vector<PdfCID> m_subsetCIDs;
+    // Guards the used glyphs and the dynamic maps, which
+    // are filled while encoding text from any thread
+    std::mutex m_subsetMutex;
     PdfCIDToGIDMapConstPtr m_cidToGidMap;
 
+    struct PreparedFontFile
+    {
+        charbuff Subset;
+        charbuff Encoded;
+    };
+    // NOTE: Shared with the process-wide subset cache, if enabled
+    std::shared_ptr<const PreparedFontFile> m_preparedFontFile;
+
 protected:
     PdfFontMetricsConstPtr m_Metrics;
     std::unique_ptr<PdfEncoding> m_Encoding;
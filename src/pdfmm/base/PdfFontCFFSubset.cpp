@@ -0,0 +1,912 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+// Ref: Adobe Technical Note #5176, "The Compact Font Format Specification"
+// and Adobe Technical Note #5177, "The Type 2 Charstring Format"
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfFontCFFSubset.h"
+
+#include <pdfmm/private/FreetypePrivate.h>
+#include FT_TRUETYPE_TAGS_H
+
+using namespace std;
+using namespace mm;
+
+// The operators of the DICT data. The two bytes escaped
+// operators are identified by 1200 + the second byte
+static constexpr unsigned OpCharset = 15;
+static constexpr unsigned OpEncoding = 16;
+static constexpr unsigned OpCharStrings = 17;
+static constexpr unsigned OpPrivate = 18;
+static constexpr unsigned OpSubrs = 19;
+static constexpr unsigned OpCharstringType = 1206;
+static constexpr unsigned OpSyntheticBase = 1220;
+static constexpr unsigned OpROS = 1230;
+static constexpr unsigned OpCIDCount = 1234;
+static constexpr unsigned OpFDArray = 1236;
+static constexpr unsigned OpFDSelect = 1237;
+
+// The SIDs of the strings of the font follow the standard strings
+static constexpr unsigned StandardStringCount = 391;
+// The maximum nesting of subroutine calls, see #5177 Appendix B
+static constexpr unsigned MaxSubrNesting = 10;
+// The charstring of the subroutines not called by the subset
+static const char ReturnCharString[] = { 11 };
+
+namespace
+{
+    struct DictEntry
+    {
+        unsigned Op;
+        bufferview Operands;
+        // The integer operands, real operands are stored as 0
+        vector<int> Values;
+    };
+
+    using DictEntries = vector<DictEntry>;
+
+    // The Private DICT and the local subroutines of a name-keyed
+    // font, or of a Font DICT of the FDArray of a CID-keyed font
+    struct SubFont
+    {
+        DictEntries FontDict;
+        DictEntries Private;
+        vector<bufferview> Subrs;
+        vector<bool> UsedSubrs;
+    };
+
+    class CFFSubsetter final
+    {
+    public:
+        CFFSubsetter(const bufferview& data);
+
+    public:
+        void BuildFont(charbuff& output, const CIDToGIDMap& cidToGidMap);
+
+    private:
+        void readSubFont(SubFont& font, const DictEntries& dict);
+        void readFDSelect(size_t offset);
+        void scanCharString(const bufferview& charString, SubFont& font, unsigned depth);
+        vector<bufferview> getSubsetSubrs(const vector<bufferview>& subrs, const vector<bool>& used) const;
+
+    private:
+        bufferview m_data;
+        bool m_isCIDKeyed;
+        bufferview m_name;
+        DictEntries m_topDict;
+        vector<bufferview> m_strings;
+        vector<bufferview> m_globalSubrs;
+        vector<bool> m_usedGlobalSubrs;
+        vector<bufferview> m_charStrings;
+        vector<SubFont> m_subFonts;
+        vector<unsigned> m_fdSelect;
+
+        // The state of the charstrings scanning
+        vector<int> m_stack;
+        unsigned m_stemCount;
+        bool m_endChar;
+        bool m_keepAllSubrs;
+    };
+}
+
+static bufferview getCFFData(const bufferview& fontData);
+static bufferview getView(const bufferview& data, size_t offset, size_t size);
+static unsigned readCard16(const bufferview& data, size_t offset);
+static void readIndex(const bufferview& data, size_t& offset, vector<bufferview>& items);
+static void readDict(const bufferview& data, DictEntries& entries);
+static const DictEntry* findEntry(const DictEntries& entries, unsigned op);
+static size_t getOffsetValue(const DictEntry* entry, unsigned index, unsigned count);
+static int getSubrBias(size_t count);
+static size_t getIndexSize(const vector<bufferview>& items);
+static unsigned getOffSize(size_t offset);
+static void writeIndex(charbuff& output, const vector<bufferview>& items);
+static void writeCard16(charbuff& output, unsigned value);
+static void writeInt(charbuff& output, int32_t value);
+static void writeOp(charbuff& output, unsigned op);
+static void writeEntry(charbuff& output, const DictEntry& entry);
+static bufferview getView(const charbuff& buffer);
+
+void PdfFontCFFSubset::BuildFont(charbuff& output, const PdfFontMetrics& metrics,
+    const CIDToGIDMap& cidToGidMap)
+{
+    if (metrics.GetFontFileType() != PdfFontFileType::Type1CCF)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "The font to be subsetted is not a CFF font");
+
+    BuildFont(output, metrics.GetOrLoadFontFileData(), cidToGidMap);
+}
+
+void PdfFontCFFSubset::BuildFont(charbuff& output, const bufferview& fontData,
+    const CIDToGIDMap& cidToGidMap)
+{
+    CFFSubsetter subsetter(getCFFData(fontData));
+    subsetter.BuildFont(output, cidToGidMap);
+}
+
+CFFSubsetter::CFFSubsetter(const bufferview& data) :
+    m_data(data),
+    m_isCIDKeyed(false),
+    m_stemCount(0),
+    m_endChar(false),
+    m_keepAllSubrs(false)
+{
+    auto header = getView(data, 0, 4);
+    if (header[0] != 1)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedFontFormat, "Unsupported CFF font version");
+
+    vector<bufferview> items;
+    size_t offset = (unsigned char)header[2];
+    readIndex(data, offset, items);
+    if (items.size() == 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "The CFF font has no name");
+
+    // NOTE: Only the first font of a FontSet is read
+    m_name = items[0];
+    readIndex(data, offset, items);
+    if (items.size() == 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "The CFF font has no Top DICT");
+
+    readDict(items[0], m_topDict);
+    readIndex(data, offset, m_strings);
+    readIndex(data, offset, m_globalSubrs);
+    m_usedGlobalSubrs.resize(m_globalSubrs.size());
+
+    auto charstringType = findEntry(m_topDict, OpCharstringType);
+    if (charstringType != nullptr && (charstringType->Values.size() != 1 || charstringType->Values[0] != 2))
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedFontFormat, "Unsupported CFF charstring type");
+
+    if (findEntry(m_topDict, OpSyntheticBase) != nullptr)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedFontFormat, "Synthetic CFF fonts are not supported");
+
+    offset = getOffsetValue(findEntry(m_topDict, OpCharStrings), 0, 1);
+    readIndex(data, offset, m_charStrings);
+
+    m_isCIDKeyed = findEntry(m_topDict, OpROS) != nullptr;
+    if (m_isCIDKeyed)
+    {
+        offset = getOffsetValue(findEntry(m_topDict, OpFDArray), 0, 1);
+        readIndex(data, offset, items);
+        if (items.size() == 0)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "The CFF font has no Font DICT");
+
+        m_subFonts.resize(items.size());
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            readDict(items[i], m_subFonts[i].FontDict);
+            readSubFont(m_subFonts[i], m_subFonts[i].FontDict);
+        }
+
+        readFDSelect(getOffsetValue(findEntry(m_topDict, OpFDSelect), 0, 1));
+    }
+    else
+    {
+        // The Private DICT of name-keyed fonts is in the Top DICT
+        m_subFonts.resize(1);
+        readSubFont(m_subFonts[0], m_topDict);
+        m_fdSelect.resize(m_charStrings.size());
+    }
+}
+
+void CFFSubsetter::BuildFont(charbuff& output, const CIDToGIDMap& cidToGidMap)
+{
+    // The glyphs of the subset, starting with .notdef
+    vector<unsigned> gids = { 0 };
+    vector<unsigned> cids = { 0 };
+    for (auto& pair : cidToGidMap)
+    {
+        // NOTE: CID 0 is always the .notdef glyph
+        if (pair.first == 0)
+            continue;
+
+        if (pair.first > 0xFFFF)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "CID out of range");
+
+        if (pair.second >= m_charStrings.size())
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "GID out of range");
+
+        cids.push_back(pair.first);
+        gids.push_back(pair.second);
+    }
+
+    // Determine the used Font DICTS, in order of first use,
+    // and the subroutines called by the glyphs
+    constexpr unsigned NoFont = numeric_limits<unsigned>::max();
+    vector<unsigned> fontIndices(m_subFonts.size(), NoFont);
+    vector<unsigned> usedFonts;
+    vector<unsigned> glyphFonts;
+    vector<bufferview> charStrings;
+    for (unsigned gid : gids)
+    {
+        unsigned fd = m_fdSelect[gid];
+        if (fontIndices[fd] == NoFont)
+        {
+            fontIndices[fd] = (unsigned)usedFonts.size();
+            usedFonts.push_back(fd);
+        }
+
+        glyphFonts.push_back(fontIndices[fd]);
+        charStrings.push_back(m_charStrings[gid]);
+
+        m_stack.clear();
+        m_stemCount = 0;
+        m_endChar = false;
+        scanCharString(m_charStrings[gid], m_subFonts[fd], 0);
+    }
+
+    // Name-keyed fonts are converted to CID-keyed with an "Adobe-Identity-0"
+    // ROS, so they need the strings of the registry and of the ordering
+    vector<bufferview> strings = m_strings;
+    unsigned registrySid = 0;
+    unsigned orderingSid = 0;
+    if (!m_isCIDKeyed)
+    {
+        registrySid = StandardStringCount + (unsigned)strings.size();
+        strings.push_back(bufferview("Adobe", 5));
+        orderingSid = StandardStringCount + (unsigned)strings.size();
+        strings.push_back(bufferview("Identity", 8));
+    }
+
+    auto globalSubrs = getSubsetSubrs(m_globalSubrs, m_usedGlobalSubrs);
+
+    // Format 2 charset, with the ranges of consecutive CIDs
+    charbuff charset;
+    charset.push_back(2);
+    for (size_t i = 1; i < cids.size(); )
+    {
+        size_t next = i + 1;
+        while (next < cids.size() && cids[next] == cids[next - 1] + 1)
+            next++;
+
+        writeCard16(charset, cids[i]);
+        writeCard16(charset, (unsigned)(next - i - 1));
+        i = next;
+    }
+
+    // Format 3 FDSelect, with the ranges of glyphs with the same Font DICT
+    vector<unsigned> fdRanges;
+    for (unsigned i = 0; i < glyphFonts.size(); i++)
+    {
+        if (i == 0 || glyphFonts[i] != glyphFonts[i - 1])
+            fdRanges.push_back(i);
+    }
+
+    charbuff fdSelect;
+    fdSelect.push_back(3);
+    writeCard16(fdSelect, (unsigned)fdRanges.size());
+    for (unsigned first : fdRanges)
+    {
+        writeCard16(fdSelect, first);
+        fdSelect.push_back((char)glyphFonts[first]);
+    }
+    writeCard16(fdSelect, (unsigned)glyphFonts.size());
+
+    // The Private DICTs, each followed by its local subroutines
+    vector<charbuff> privates(usedFonts.size());
+    vector<vector<bufferview>> localSubrs(usedFonts.size());
+    for (size_t i = 0; i < usedFonts.size(); i++)
+    {
+        auto& font = m_subFonts[usedFonts[i]];
+        for (auto& entry : font.Private)
+        {
+            if (entry.Op != OpSubrs)
+                writeEntry(privates[i], entry);
+        }
+
+        if (font.Subrs.size() != 0)
+        {
+            // NOTE: The offset is relative to the Private DICT and it
+            // includes the operand and the operator being written
+            localSubrs[i] = getSubsetSubrs(font.Subrs, font.UsedSubrs);
+            writeInt(privates[i], (int32_t)privates[i].size() + 6);
+            writeOp(privates[i], OpSubrs);
+        }
+    }
+
+    // NOTE: The offsets in the DICTs are always written with 5 bytes,
+    // so the DICTs can be laid out before knowing the offsets
+    vector<charbuff> fontDicts(usedFonts.size());
+    auto buildFontDicts = [&](const vector<size_t>& privateOffsets)
+    {
+        for (size_t i = 0; i < usedFonts.size(); i++)
+        {
+            auto& dict = fontDicts[i];
+            dict.clear();
+            for (auto& entry : m_subFonts[usedFonts[i]].FontDict)
+            {
+                if (entry.Op != OpPrivate)
+                    writeEntry(dict, entry);
+            }
+
+            writeInt(dict, (int32_t)privates[i].size());
+            writeInt(dict, (int32_t)privateOffsets[i]);
+            writeOp(dict, OpPrivate);
+        }
+    };
+
+    charbuff topDict;
+    auto buildTopDict = [&](size_t charsetOffset, size_t fdSelectOffset, size_t charStringsOffset, size_t fdArrayOffset)
+    {
+        topDict.clear();
+
+        // The ROS must be the first entry of the Top DICT
+        if (m_isCIDKeyed)
+        {
+            writeEntry(topDict, *findEntry(m_topDict, OpROS));
+        }
+        else
+        {
+            writeInt(topDict, (int32_t)registrySid);
+            writeInt(topDict, (int32_t)orderingSid);
+            writeInt(topDict, 0);
+            writeOp(topDict, OpROS);
+        }
+
+        for (auto& entry : m_topDict)
+        {
+            switch (entry.Op)
+            {
+                case OpROS:
+                case OpCharset:
+                case OpEncoding:
+                case OpCharStrings:
+                case OpPrivate:
+                case OpCIDCount:
+                case OpFDArray:
+                case OpFDSelect:
+                    break;
+                default:
+                    writeEntry(topDict, entry);
+                    break;
+            }
+        }
+
+        writeInt(topDict, (int32_t)cids.back() + 1);
+        writeOp(topDict, OpCIDCount);
+        writeInt(topDict, (int32_t)charsetOffset);
+        writeOp(topDict, OpCharset);
+        writeInt(topDict, (int32_t)fdSelectOffset);
+        writeOp(topDict, OpFDSelect);
+        writeInt(topDict, (int32_t)charStringsOffset);
+        writeOp(topDict, OpCharStrings);
+        writeInt(topDict, (int32_t)fdArrayOffset);
+        writeOp(topDict, OpFDArray);
+    };
+
+    auto getFontDictsView = [&]()
+    {
+        vector<bufferview> ret;
+        for (auto& dict : fontDicts)
+            ret.push_back(getView(dict));
+
+        return ret;
+    };
+
+    // Lay out the font
+    vector<size_t> privateOffsets(usedFonts.size());
+    buildTopDict(0, 0, 0, 0);
+    buildFontDicts(privateOffsets);
+    size_t offset = 4 + getIndexSize({ m_name }) + getIndexSize({ getView(topDict) })
+        + getIndexSize(strings) + getIndexSize(globalSubrs);
+    size_t charsetOffset = offset;
+    offset += charset.size();
+    size_t fdSelectOffset = offset;
+    offset += fdSelect.size();
+    size_t charStringsOffset = offset;
+    offset += getIndexSize(charStrings);
+    size_t fdArrayOffset = offset;
+    offset += getIndexSize(getFontDictsView());
+    for (size_t i = 0; i < usedFonts.size(); i++)
+    {
+        privateOffsets[i] = offset;
+        offset += privates[i].size();
+        if (localSubrs[i].size() != 0)
+            offset += getIndexSize(localSubrs[i]);
+    }
+
+    if (offset > (size_t)numeric_limits<int32_t>::max())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The CFF subset is too big");
+
+    buildTopDict(charsetOffset, fdSelectOffset, charStringsOffset, fdArrayOffset);
+    buildFontDicts(privateOffsets);
+
+    output.clear();
+    output.reserve(offset);
+    // Header: major and minor version, header size and size of the offsets
+    output.append({ 1, 0, 4, 4 });
+    writeIndex(output, { m_name });
+    writeIndex(output, { getView(topDict) });
+    writeIndex(output, strings);
+    writeIndex(output, globalSubrs);
+    output.append(charset);
+    output.append(fdSelect);
+    writeIndex(output, charStrings);
+    writeIndex(output, getFontDictsView());
+    for (size_t i = 0; i < usedFonts.size(); i++)
+    {
+        output.append(privates[i]);
+        if (localSubrs[i].size() != 0)
+            writeIndex(output, localSubrs[i]);
+    }
+
+    PDFMM_ASSERT(output.size() == offset);
+}
+
+void CFFSubsetter::readSubFont(SubFont& font, const DictEntries& dict)
+{
+    size_t size = getOffsetValue(findEntry(dict, OpPrivate), 0, 2);
+    size_t offset = getOffsetValue(findEntry(dict, OpPrivate), 1, 2);
+    readDict(getView(m_data, offset, size), font.Private);
+
+    auto subrs = findEntry(font.Private, OpSubrs);
+    if (subrs == nullptr)
+        return;
+
+    // NOTE: The offset of the subroutines is relative to the Private DICT
+    offset += getOffsetValue(subrs, 0, 1);
+    readIndex(m_data, offset, font.Subrs);
+    font.UsedSubrs.resize(font.Subrs.size());
+}
+
+void CFFSubsetter::readFDSelect(size_t offset)
+{
+    size_t glyphCount = m_charStrings.size();
+    m_fdSelect.resize(glyphCount);
+    unsigned format = (unsigned char)getView(m_data, offset, 1)[0];
+    switch (format)
+    {
+        case 0:
+        {
+            auto fds = getView(m_data, offset + 1, glyphCount);
+            for (size_t i = 0; i < glyphCount; i++)
+                m_fdSelect[i] = (unsigned char)fds[i];
+
+            break;
+        }
+        case 3:
+        {
+            unsigned rangeCount = readCard16(m_data, offset + 1);
+            offset += 3;
+            unsigned first = readCard16(m_data, offset);
+            for (unsigned i = 0; i < rangeCount; i++)
+            {
+                unsigned fd = (unsigned char)getView(m_data, offset + 2, 1)[0];
+                unsigned next = readCard16(m_data, offset + 3);
+                if (next < first || next > glyphCount)
+                    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "Invalid CFF FDSelect range");
+
+                for (unsigned gid = first; gid < next; gid++)
+                    m_fdSelect[gid] = fd;
+
+                first = next;
+                offset += 3;
+            }
+            break;
+        }
+        default:
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "Invalid CFF FDSelect format");
+    }
+
+    for (unsigned fd : m_fdSelect)
+    {
+        if (fd >= m_subFonts.size())
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "Invalid CFF Font DICT index");
+    }
+}
+
+void CFFSubsetter::scanCharString(const bufferview& charString, SubFont& font, unsigned depth)
+{
+    if (depth > MaxSubrNesting)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "Too nested CFF subroutines");
+
+    size_t i = 0;
+    while (i < charString.size())
+    {
+        unsigned b0 = (unsigned char)charString[i];
+        if (b0 == 28 || b0 >= 32)
+        {
+            // The operands are kept to follow the subroutines indices
+            int value;
+            if (b0 == 28)
+            {
+                value = (int16_t)readCard16(charString, i + 1);
+                i += 3;
+            }
+            else if (b0 <= 246)
+            {
+                value = (int)b0 - 139;
+                i += 1;
+            }
+            else if (b0 <= 254)
+            {
+                int b1 = (unsigned char)getView(charString, i + 1, 1)[0];
+                if (b0 <= 250)
+                    value = ((int)b0 - 247) * 256 + b1 + 108;
+                else
+                    value = -((int)b0 - 251) * 256 - b1 - 108;
+                i += 2;
+            }
+            else
+            {
+                // 16.16 fixed number, keep the integer part
+                uint32_t fixed = (uint32_t)readCard16(charString, i + 1) << 16 | readCard16(charString, i + 3);
+                value = (int32_t)fixed >> 16;
+                i += 5;
+            }
+
+            m_stack.push_back(value);
+            continue;
+        }
+
+        i++;
+        switch (b0)
+        {
+            case 1:     // hstem
+            case 3:     // vstem
+            case 18:    // hstemhm
+            case 23:    // vstemhm
+                m_stemCount += (unsigned)m_stack.size() / 2;
+                m_stack.clear();
+                break;
+            case 19:    // hintmask
+            case 20:    // cntrmask
+                // The operands before the mask are an implicit vstem
+                m_stemCount += (unsigned)m_stack.size() / 2;
+                m_stack.clear();
+                i += (m_stemCount + 7) / 8;
+                break;
+            case 10:    // callsubr
+            case 29:    // callgsubr
+            {
+                auto& subrs = b0 == 10 ? font.Subrs : m_globalSubrs;
+                auto& used = b0 == 10 ? font.UsedSubrs : m_usedGlobalSubrs;
+                if (m_stack.size() == 0)
+                    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "Missing CFF subroutine index");
+
+                int index = m_stack.back() + getSubrBias(subrs.size());
+                m_stack.pop_back();
+                if (index < 0 || (size_t)index >= subrs.size())
+                    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "Invalid CFF subroutine index");
+
+                used[index] = true;
+                scanCharString(subrs[index], font, depth + 1);
+                if (m_endChar)
+                    return;
+
+                break;
+            }
+            case 11:    // return
+                return;
+            case 14:    // endchar
+                // NOTE: The endchar with the operands of the Type 1 seac
+                // composes glyphs by their standard encoding code,
+                // which would need the names of the glyphs
+                if (m_stack.size() >= 4)
+                    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedFontFormat, "CFF accented characters are not supported");
+
+                m_endChar = true;
+                return;
+            case 12:
+            {
+                unsigned b1 = i < charString.size() ? (unsigned char)charString[i] : 0;
+                i++;
+                // Other than the flex operators, the escaped operators are
+                // arithmetic and storage operators: the operands of the
+                // subroutines calls can't be followed anymore
+                if (b1 < 34 || b1 > 37)
+                    m_keepAllSubrs = true;
+
+                m_stack.clear();
+                break;
+            }
+            default:
+                m_stack.clear();
+                break;
+        }
+    }
+}
+
+vector<bufferview> CFFSubsetter::getSubsetSubrs(const vector<bufferview>& subrs, const vector<bool>& used) const
+{
+    // NOTE: The subroutines are called by index, so
+    // they are emptied, instead of being removed
+    vector<bufferview> ret = subrs;
+    if (m_keepAllSubrs)
+        return ret;
+
+    for (size_t i = 0; i < ret.size(); i++)
+    {
+        if (!used[i])
+            ret[i] = bufferview(ReturnCharString, 1);
+    }
+
+    return ret;
+}
+
+bufferview getCFFData(const bufferview& fontData)
+{
+    auto header = getView(fontData, 0, 4);
+    if (header[0] == 1)
+    {
+        // Bare CFF font, with major version 1
+        return fontData;
+    }
+
+    uint32_t version;
+    utls::ReadUInt32BE(header.data(), version);
+    if (version != 0x4F54544F && version != 0x00010000)  // "OTTO" or TrueType
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedFontFormat, "Unsupported font for CFF subsetting");
+
+    // Search the "CFF " table in the OpenType table directory
+    unsigned tableCount = readCard16(fontData, 4);
+    auto records = getView(fontData, 12, (size_t)tableCount * 16);
+    bool hasCFF2 = false;
+    for (unsigned i = 0; i < tableCount; i++)
+    {
+        uint32_t tag;
+        uint32_t offset;
+        uint32_t length;
+        utls::ReadUInt32BE(records.data() + i * 16, tag);
+        utls::ReadUInt32BE(records.data() + i * 16 + 8, offset);
+        utls::ReadUInt32BE(records.data() + i * 16 + 12, length);
+        if (tag == TTAG_CFF)
+            return getView(fontData, offset, length);
+        else if (tag == TTAG_CFF2)
+            hasCFF2 = true;
+    }
+
+    if (hasCFF2)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedFontFormat, "CFF2 fonts subsetting is not supported");
+    else
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "The font has no CFF table");
+}
+
+bufferview getView(const bufferview& data, size_t offset, size_t size)
+{
+    if (offset > data.size() || data.size() - offset < size)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "CFF data out of bounds");
+
+    return data.subspan(offset, size);
+}
+
+unsigned readCard16(const bufferview& data, size_t offset)
+{
+    uint16_t value;
+    utls::ReadUInt16BE(getView(data, offset, 2).data(), value);
+    return value;
+}
+
+void readIndex(const bufferview& data, size_t& offset, vector<bufferview>& items)
+{
+    items.clear();
+    unsigned count = readCard16(data, offset);
+    offset += 2;
+    if (count == 0)
+        return;
+
+    unsigned offSize = (unsigned char)getView(data, offset, 1)[0];
+    if (offSize == 0 || offSize > 4)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "Invalid CFF INDEX offset size");
+
+    offset++;
+    auto offsets = getView(data, offset, (size_t)(count + 1) * offSize);
+    auto readOffset = [&](unsigned index)
+    {
+        size_t ret = 0;
+        for (unsigned i = 0; i < offSize; i++)
+            ret = ret << 8 | (unsigned char)offsets[index * offSize + i];
+
+        return ret;
+    };
+
+    // NOTE: The offsets are relative to the byte preceding the data
+    size_t base = offset + offsets.size() - 1;
+    size_t prev = readOffset(0);
+    if (prev != 1)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "Invalid CFF INDEX offset");
+
+    items.reserve(count);
+    for (unsigned i = 1; i <= count; i++)
+    {
+        size_t next = readOffset(i);
+        if (next < prev)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "Invalid CFF INDEX offset");
+
+        items.push_back(getView(data, base + prev, next - prev));
+        prev = next;
+    }
+
+    offset = base + prev;
+}
+
+void readDict(const bufferview& data, DictEntries& entries)
+{
+    vector<int> values;
+    size_t operandsOffset = 0;
+    size_t i = 0;
+    while (i < data.size())
+    {
+        unsigned b0 = (unsigned char)data[i];
+        if (b0 <= 21)
+        {
+            size_t opOffset = i;
+            unsigned op = b0;
+            i++;
+            if (b0 == 12)
+            {
+                op = 1200 + (unsigned char)getView(data, i, 1)[0];
+                i++;
+            }
+
+            entries.push_back({ op, data.subspan(operandsOffset, opOffset - operandsOffset), std::move(values) });
+            values.clear();
+            operandsOffset = i;
+        }
+        else if (b0 == 28)
+        {
+            values.push_back((int16_t)readCard16(data, i + 1));
+            i += 3;
+        }
+        else if (b0 == 29)
+        {
+            uint32_t value;
+            utls::ReadUInt32BE(getView(data, i + 1, 4).data(), value);
+            values.push_back((int32_t)value);
+            i += 5;
+        }
+        else if (b0 == 30)
+        {
+            // Real number, with nibbles ending with 0xf. Its value is not needed
+            i++;
+            unsigned nibbles;
+            do
+            {
+                nibbles = (unsigned char)getView(data, i, 1)[0];
+                i++;
+            } while ((nibbles & 0x0F) != 0x0F && (nibbles & 0xF0) != 0xF0);
+            values.push_back(0);
+        }
+        else if (b0 >= 32 && b0 <= 246)
+        {
+            values.push_back((int)b0 - 139);
+            i++;
+        }
+        else if (b0 >= 247 && b0 <= 254)
+        {
+            int b1 = (unsigned char)getView(data, i + 1, 1)[0];
+            if (b0 <= 250)
+                values.push_back(((int)b0 - 247) * 256 + b1 + 108);
+            else
+                values.push_back(-((int)b0 - 251) * 256 - b1 - 108);
+            i += 2;
+        }
+        else
+        {
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "Invalid CFF DICT data");
+        }
+    }
+}
+
+const DictEntry* findEntry(const DictEntries& entries, unsigned op)
+{
+    for (auto& entry : entries)
+    {
+        if (entry.Op == op)
+            return &entry;
+    }
+
+    return nullptr;
+}
+
+size_t getOffsetValue(const DictEntry* entry, unsigned index, unsigned count)
+{
+    if (entry == nullptr || entry->Values.size() != count || entry->Values[index] < 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontFile, "Missing or invalid CFF DICT offset");
+
+    return (size_t)entry->Values[index];
+}
+
+int getSubrBias(size_t count)
+{
+    if (count < 1240)
+        return 107;
+    else if (count < 33900)
+        return 1131;
+    else
+        return 32768;
+}
+
+size_t getIndexSize(const vector<bufferview>& items)
+{
+    if (items.size() == 0)
+        return 2;
+
+    size_t dataSize = 0;
+    for (auto& item : items)
+        dataSize += item.size();
+
+    return 3 + (items.size() + 1) * getOffSize(dataSize + 1) + dataSize;
+}
+
+unsigned getOffSize(size_t offset)
+{
+    if (offset <= 0xFF)
+        return 1;
+    else if (offset <= 0xFFFF)
+        return 2;
+    else if (offset <= 0xFFFFFF)
+        return 3;
+    else
+        return 4;
+}
+
+void writeIndex(charbuff& output, const vector<bufferview>& items)
+{
+    writeCard16(output, (unsigned)items.size());
+    if (items.size() == 0)
+        return;
+
+    size_t dataSize = 0;
+    for (auto& item : items)
+        dataSize += item.size();
+
+    unsigned offSize = getOffSize(dataSize + 1);
+    output.push_back((char)offSize);
+    size_t offset = 1;
+    auto writeOffset = [&]()
+    {
+        for (unsigned i = offSize; i > 0; i--)
+            output.push_back((char)(offset >> ((i - 1) * 8)));
+    };
+
+    writeOffset();
+    for (auto& item : items)
+    {
+        offset += item.size();
+        writeOffset();
+    }
+
+    for (auto& item : items)
+        output.append(item.data(), item.size());
+}
+
+void writeCard16(charbuff& output, unsigned value)
+{
+    output.push_back((char)(value >> 8));
+    output.push_back((char)value);
+}
+
+void writeInt(charbuff& output, int32_t value)
+{
+    char buffer[4];
+    utls::WriteUInt32BE(buffer, (uint32_t)value);
+    output.push_back(29);
+    output.append(buffer, 4);
+}
+
+void writeOp(charbuff& output, unsigned op)
+{
+    if (op >= 1200)
+    {
+        output.push_back(12);
+        output.push_back((char)(op - 1200));
+    }
+    else
+    {
+        output.push_back((char)op);
+    }
+}
+
+void writeEntry(charbuff& output, const DictEntry& entry)
+{
+    output.append(entry.Operands.data(), entry.Operands.size());
+    writeOp(output, entry.Op);
+}
+
+bufferview getView(const charbuff& buffer)
+{
+    return bufferview(buffer.data(), buffer.size());
+}
@@ -0,0 +1,56 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_FONT_CFF_SUBSET_H
+#define PDF_FONT_CFF_SUBSET_H
+
+#include "PdfDeclarations.h"
+#include "PdfFontMetrics.h"
+
+namespace mm {
+
+/**
+ * This class is able to build a new CFF font with only
+ * certain glyphs from an existing CFF or OpenType CFF font.
+ *
+ * The subset is a bare CID-keyed CFF font program, as required by
+ * a /FontFile3 stream with /CIDFontType0C subtype, also when
+ * the source font is name-keyed. CFF2 fonts are not supported
+ */
+class PDFMM_API PdfFontCFFSubset final
+{
+private:
+    PdfFontCFFSubset() = delete;
+
+public:
+    /**
+     * Actually generate the subsetted font
+     *
+     * The glyph 0 of the subset is the .notdef glyph, followed by
+     * the glyphs of the map in CID order, with the CID of the map.
+     * The subroutines not called by the glyphs are emptied
+     *
+     * \param output write the font to this buffer
+     * \param metrics font metrics object for this font
+     * \param cidToGidMap the CIDs of the subset, mapped to
+     *      the GIDs of the glyphs in the source font
+     */
+    static void BuildFont(charbuff& output, const PdfFontMetrics& metrics,
+        const CIDToGIDMap& cidToGidMap);
+
+    /**
+     * Generate the subsetted font from the data of a bare
+     * CFF font or of an OpenType font with a "CFF " table
+     * \see BuildFont(charbuff&, const PdfFontMetrics&, const CIDToGIDMap&)
+     */
+    static void BuildFont(charbuff& output, const bufferview& fontData,
+        const CIDToGIDMap& cidToGidMap);
+};
+
+};
+
+#endif // PDF_FONT_CFF_SUBSET_H
@@ -21,28 +21,37 @@
 using namespace std;
 using namespace mm;
 
+// Export the /W array with the fewest entries: the CIDs are grouped
+// in runs of consecutive CIDs with the same width, and every run is
+// written either as "c_first c_last w" or appended to an array of
+// consecutive widths "c [w1 w2 ...]", choosing with a dynamic
+// programming pass over the runs of every block of consecutive CIDs
 class WidthExporter
 {
 private:
-    WidthExporter(unsigned cid, unsigned width);
+    WidthExporter();
 public:
     static PdfArray GetPdfWidths(const CIDToGIDMap& glyphWidths,
         const PdfFontMetrics& metrics);
 private:
     void update(unsigned cid, unsigned width);
-    PdfArray finish();
-    void reset(unsigned cid, unsigned width);
-    void emitSameWidth();
-    void emitArrayWidths();
+    void finish();
+    void emitBlock();
     static unsigned getPdfWidth(unsigned gid, const PdfFontMetrics& metrics,
         const Matrix2D& matrix);
 
+private:
+    struct WidthRun
+    {
+        unsigned Start;     // CID of the start of the run
+        unsigned Count;
+        unsigned Width;
+    };
+
 private:
     PdfArray m_output;
-    PdfArray m_widths;         // array of consecutive different widths
-    unsigned m_start;          // glyphIndex of start range
-    unsigned m_width;
-    unsigned m_rangeCount;     // number of processed glyphIndex'es since start of range
+    vector<WidthRun> m_runs;    // Runs of the current block of consecutive CIDs
+    vector<bool> m_isRange;     // Choices of the dynamic programming pass
 };
 
 PdfFontCID::PdfFontCID(PdfDocument& doc, const PdfFontMetricsConstPtr& metrics,
@@ -130,6 +139,33 @@ void PdfFontCID::createWidths(PdfDictionary& fontDict, const CIDToGIDMap& cidToG
     }
 }
 
+void PdfFontCID::createCIDSet(const UsedGIDsMap& usedGIDs)
+{
+    // NOTE: The CIDSet entry is optional and it's actually deprecated in PDF 2.0
+    string cidSetData;
+    for (auto& pair : usedGIDs)
+    {
+        // ISO 32000-1:2008: Table 124 – Additional font descriptor entries for CIDFonts
+        // CIDSet "The stream’s data shall be organized as a table of bits
+        // indexed by CID. The bits shall be stored in bytes with the
+        // high - order bit first.Each bit shall correspond to a CID.
+        // The most significant bit of the first byte shall correspond
+        // to CID 0, the next bit to CID 1, and so on"
+
+        static const char bits[] = { '\x80', '\x40', '\x20', '\x10', '\x08', '\x04', '\x02', '\x01' };
+        unsigned cid = pair.second.Id;
+        unsigned dataIndex = cid >> 3;
+        if (cidSetData.size() < dataIndex + 1)
+            cidSetData.resize(dataIndex + 1);
+
+        cidSetData[dataIndex] |= bits[cid & 7];
+    }
+
+    auto cidSetObj = this->GetObject().GetDocument()->GetObjects().CreateDictionaryObject();
+    cidSetObj->GetOrCreateStream().Set(cidSetData);
+    GetDescriptor().GetDictionary().AddKeyIndirect("CIDSet", cidSetObj);
+}
+
 CIDToGIDMap PdfFontCID::getIdentityCIDToGIDMap()
 {
     PDFMM_ASSERT(!IsSubsettingEnabled());
@@ -154,60 +190,98 @@ CIDToGIDMap PdfFontCID::getCIDToGIDMapSubset(const UsedGIDsMap& usedGIDs)
     return ret;
 }
 
-WidthExporter::WidthExporter(unsigned cid, unsigned width)
-{
-    reset(cid, width);
-}
+WidthExporter::WidthExporter() { }
 
 void WidthExporter::update(unsigned cid, unsigned width)
 {
-    if (cid == (m_start + m_rangeCount))
+    if (m_runs.size() != 0)
     {
-        // continous gid
-        if (width - m_width != 0)
+        auto& last = m_runs.back();
+        if (cid == last.Start + last.Count)
         {
-            // different width, so emit if previous range was with same width
-            if ((m_rangeCount != 1) && m_widths.IsEmpty())
+            if (width == last.Width)
             {
-                emitSameWidth();
-                reset(cid, width);
+                last.Count++;
                 return;
             }
-            m_widths.Add(PdfObject(static_cast<int64_t>(m_width)));
-            m_width = width;
-            m_rangeCount++;
-            return;
         }
-        // two or more gids with same width
-        if (!m_widths.IsEmpty())
+        else
         {
-            emitArrayWidths();
-            /* setup previous width as start position */
-            m_start += m_rangeCount - 1;
-            m_rangeCount = 2;
-            return;
+            // CID gap (font subset)
+            emitBlock();
         }
-        // consecutive range of same widths
-        m_rangeCount++;
-        return;
     }
-    // gid gap (font subset)
-    finish();
-    reset(cid, width);
+
+    m_runs.push_back({ cid, 1, width });
 }
 
-PdfArray WidthExporter::finish()
+void WidthExporter::finish()
 {
-    // if there is a single glyph remaining, emit it as array
-    if (!m_widths.IsEmpty() || m_rangeCount == 1)
+    emitBlock();
+}
+
+void WidthExporter::emitBlock()
+{
+    if (m_runs.size() == 0)
+        return;
+
+    // The cost of a run written as a range is 3 entries, the cost of
+    // the widths in an array is their count, plus 2 entries for the
+    // start CID and the array itself if the array is opened by the run.
+    // The cost of the block up to a run is tracked for both its forms
+    constexpr unsigned RangeCost = 3;
+    constexpr unsigned ArrayOpenCost = 2;
+    unsigned rangeCost = 0;
+    unsigned arrayCost = numeric_limits<unsigned>::max() - ArrayOpenCost;
+    m_isRange.resize(m_runs.size() * 2);
+    for (unsigned i = 0; i < m_runs.size(); i++)
     {
-        m_widths.Add(PdfObject(static_cast<int64_t>(m_width)));
-        emitArrayWidths();
-        return m_output;
+        // Choices of the previous run, by the form of the current one
+        bool rangeAfterRange = rangeCost <= arrayCost;
+        bool arrayAfterRange = rangeCost + ArrayOpenCost < arrayCost;
+        unsigned newRangeCost = std::min(rangeCost, arrayCost) + RangeCost;
+        unsigned newArrayCost = (arrayAfterRange ? rangeCost + ArrayOpenCost : arrayCost) + m_runs[i].Count;
+        m_isRange[i * 2] = rangeAfterRange;
+        m_isRange[i * 2 + 1] = arrayAfterRange;
+        rangeCost = newRangeCost;
+        arrayCost = newArrayCost;
     }
-    emitSameWidth();
 
-    return m_output;
+    // Backtrack the choices, storing the form of every run in the first slot
+    bool isRange = rangeCost <= arrayCost;
+    for (unsigned i = (unsigned)m_runs.size(); i > 0; i--)
+    {
+        bool prevIsRange = m_isRange[(i - 1) * 2 + (isRange ? 0 : 1)];
+        m_isRange[(i - 1) * 2] = isRange;
+        isRange = prevIsRange;
+    }
+
+    PdfArray* widths = nullptr;
+    for (unsigned i = 0; i < m_runs.size(); i++)
+    {
+        auto& run = m_runs[i];
+        if (m_isRange[i * 2])
+        {
+            m_output.emplace_back(static_cast<int64_t>(run.Start));
+            m_output.emplace_back(static_cast<int64_t>(run.Start + run.Count - 1));
+            m_output.emplace_back(static_cast<int64_t>(run.Width));
+            widths = nullptr;
+        }
+        else
+        {
+            if (widths == nullptr)
+            {
+                m_output.emplace_back(static_cast<int64_t>(run.Start));
+                widths = &m_output.emplace_back(PdfArray()).GetArray();
+            }
+
+            widths->reserve(widths->size() + run.Count);
+            for (unsigned j = 0; j < run.Count; j++)
+                widths->emplace_back(static_cast<int64_t>(run.Width));
+        }
+    }
+
+    m_runs.clear();
 }
 
 PdfArray WidthExporter::GetPdfWidths(const CIDToGIDMap& cidToGidMap,
@@ -217,32 +291,12 @@ PdfArray WidthExporter::GetPdfWidths(const CIDToGIDMap& cidToGidMap,
         return PdfArray();
 
     auto& matrix = metrics.GetMatrix();
-    WidthExporter exporter(0, getPdfWidth(0, metrics, matrix));
+    WidthExporter exporter;
     for (auto& pair : cidToGidMap)
         exporter.update(pair.first, getPdfWidth(pair.second, metrics, matrix));
 
-    return exporter.finish();
-}
-
-void WidthExporter::reset(unsigned cid, unsigned width)
-{
-    m_start = cid;
-    m_width = width;
-    m_rangeCount = 1;
-}
-
-void WidthExporter::emitSameWidth()
-{
-    m_output.Add(static_cast<int64_t>(m_start));
-    m_output.Add(static_cast<int64_t>(m_start + m_rangeCount - 1));
-    m_output.Add(static_cast<int64_t>(std::round(m_width)));
-}
-
-void WidthExporter::emitArrayWidths()
-{
-    m_output.Add(static_cast<int64_t>(m_start));
-    m_output.Add(m_widths);
-    m_widths.Clear();
+    exporter.finish();
+    return std::move(exporter.m_output);
 }
 
 // Return thousands of PDF units
@@ -30,6 +30,9 @@ protected:
     void embedFont() override;
     PdfObject* getDescendantFontObject() override;
     void createWidths(PdfDictionary& fontDict, const CIDToGIDMap& glyphWidths);
+    /** Create the /CIDSet of the descriptor with the CIDs of the subset
+     */
+    void createCIDSet(const UsedGIDsMap& usedGIDs);
     static CIDToGIDMap getCIDToGIDMapSubset(const UsedGIDsMap& usedGIDs);
 
 private:
@@ -34,38 +34,21 @@ void PdfFontCIDTrueType::embedFontSubset()
     createWidths(GetDescendantFont().GetDictionary(), cidToGidMap);
     m_Encoding->ExportToFont(*this);
 
+    charbuff buffer;
+    EmbedFontFileTrueType(GetDescriptor(), GetFontSubset(buffer));
+
+    // NOTE: The CIDSet is required for PDFA/1 compliance in TrueType CID fonts
+    createCIDSet(usedGIDs);
+}
+
+bool PdfFontCIDTrueType::tryBuildFontSubset(charbuff& output) const
+{
     // Prepare a gid list to be used for subsetting
+    CIDToGIDMap cidToGidMap = getCIDToGIDMapSubset(GetUsedGIDs());
     vector<unsigned> gids;
     for (auto& pair : cidToGidMap)
         gids.push_back(pair.second);
 
-    charbuff buffer;
-    PdfFontTrueTypeSubset::BuildFont(buffer, GetMetrics(), gids);
-    EmbedFontFileTrueType(GetDescriptor(), buffer);
-
-    // We prepare the /CIDSet content now. NOTE: The CIDSet
-    // entry is optional and it's actually deprecated in PDF 2.0
-    // but it's required for PDFA/1 compliance in TrueType CID fonts
-    string cidSetData;
-    for (auto& pair : usedGIDs)
-    {
-        // ISO 32000-1:2008: Table 124 – Additional font descriptor entries for CIDFonts
-        // CIDSet "The stream’s data shall be organized as a table of bits
-        // indexed by CID. The bits shall be stored in bytes with the
-        // high - order bit first.Each bit shall correspond to a CID.
-        // The most significant bit of the first byte shall correspond
-        // to CID 0, the next bit to CID 1, and so on"
-
-        static const char bits[] = { '\x80', '\x40', '\x20', '\x10', '\x08', '\x04', '\x02', '\x01' };
-        unsigned gid = pair.second.Id;
-        unsigned dataIndex = gid >> 3;
-        if (cidSetData.size() < dataIndex + 1)
-            cidSetData.resize(dataIndex + 1);
-
-        cidSetData[dataIndex] |= bits[gid & 7];
-    }
-
-    auto cidSetObj = this->GetObject().GetDocument()->GetObjects().CreateDictionaryObject();
-    cidSetObj->GetOrCreateStream().Set(cidSetData);
-    GetDescriptor().GetDictionary().AddKeyIndirect("CIDSet", cidSetObj);
+    PdfFontTrueTypeSubset::BuildFont(output, GetMetrics(), gids);
+    return true;
 }
@@ -36,6 +36,7 @@ public:
 
 protected:
     void embedFontSubset() override;
+    bool tryBuildFontSubset(charbuff& output) const override;
 };
 
 };
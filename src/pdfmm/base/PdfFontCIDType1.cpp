@@ -8,6 +8,9 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfFontCIDType1.h"
 
+#include "PdfDictionary.h"
+#include "PdfFontCFFSubset.h"
+
 using namespace std;
 using namespace mm;
 
@@ -16,8 +19,8 @@ PdfFontCIDType1::PdfFontCIDType1(PdfDocument& doc, const PdfFontMetricsConstPtr&
 
 bool PdfFontCIDType1::SupportsSubsetting() const
 {
-    // Not yet supported
-    return false;
+    // NOTE: Only CFF fonts can be subsetted, not Type1 fonts
+    return GetMetrics().GetFontFileType() == PdfFontFileType::Type1CCF;
 }
 
 PdfFontType PdfFontCIDType1::GetType() const
@@ -27,5 +30,18 @@ PdfFontType PdfFontCIDType1::GetType() const
 
 void PdfFontCIDType1::embedFontSubset()
 {
-    PDFMM_RAISE_ERROR(PdfErrorCode::NotImplemented);
+    auto& usedGIDs = GetUsedGIDs();
+    CIDToGIDMap cidToGidMap = getCIDToGIDMapSubset(usedGIDs);
+    createWidths(GetDescendantFont().GetDictionary(), cidToGidMap);
+    m_Encoding->ExportToFont(*this);
+
+    charbuff buffer;
+    EmbedFontFileType1CCF(GetDescriptor(), GetFontSubset(buffer));
+    createCIDSet(usedGIDs);
+}
+
+bool PdfFontCIDType1::tryBuildFontSubset(charbuff& output) const
+{
+    PdfFontCFFSubset::BuildFont(output, GetMetrics(), getCIDToGIDMapSubset(GetUsedGIDs()));
+    return true;
 }
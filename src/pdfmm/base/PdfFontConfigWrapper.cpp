@@ -9,8 +9,11 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfFontConfigWrapper.h"
 
+#include <charconv>
 #include <fontconfig/fontconfig.h>
 
+#include <pdfmm/private/FileSystem.h>
+
 using namespace std;
 using namespace mm;
 
@@ -22,24 +25,44 @@ using namespace mm;
 #endif
 
 PdfFontConfigWrapper::PdfFontConfigWrapper(FcConfig* fcConfig)
-    : m_FcConfig(fcConfig)
-{
-    if (fcConfig == nullptr)
-        createDefaultConfig();
-}
+    : m_FcConfig(fcConfig) { }
 
 PdfFontConfigWrapper::~PdfFontConfigWrapper()
 {
-    FcConfigDestroy(m_FcConfig);
+    if (m_FcConfig != nullptr)
+        FcConfigDestroy(m_FcConfig);
 }
 
 string PdfFontConfigWrapper::GetFontConfigFontPath(const string_view fontName,
     PdfFontStyle style, unsigned& faceIndex)
+{
+    lock_guard<mutex> lock(m_mutex);
+    FontPathKey key((string)fontName, style);
+    auto found = m_fontPaths.find(key);
+    if (found != m_fontPaths.end())
+    {
+        faceIndex = found->second.FaceIndex;
+        return found->second.Path;
+    }
+
+    string path = searchFontPath(fontName, style, faceIndex);
+    // NOTE: Fonts not found are remembered only by this
+    // wrapper, as they may be installed later
+    m_fontPaths[std::move(key)] = { path, faceIndex };
+    if (!path.empty() && !m_cacheFilePath.empty())
+        appendCacheFile(fontName, style, path, faceIndex);
+
+    return path;
+}
+
+string PdfFontConfigWrapper::searchFontPath(const string_view fontName,
+    PdfFontStyle style, unsigned& faceIndex)
 {
     FcPattern* pattern;
     FcPattern* matched;
     FcResult result = FcResultMatch;
     FcValue value;
+    faceIndex = 0;
 
     bool isItalic = (style & PdfFontStyle::Italic) == PdfFontStyle::Italic;
     bool isBold = (style & PdfFontStyle::Bold) == PdfFontStyle::Bold;
@@ -52,15 +75,15 @@ string PdfFontConfigWrapper::GetFontConfigFontPath(const string_view fontName,
 
     FcDefaultSubstitute(pattern);
 
-    if (!FcConfigSubstitute(m_FcConfig, pattern, FcMatchFont))
+    auto config = getFcConfig();
+    if (!FcConfigSubstitute(config, pattern, FcMatchFont))
     {
         FcPatternDestroy(pattern);
-        faceIndex = 0;
         return { };
     }
 
     string path;
-    matched = FcFontMatch(m_FcConfig, pattern, &result);
+    matched = FcFontMatch(config, pattern, &result);
     if (result != FcResultNoMatch)
     {
         (void)FcPatternGet(matched, FC_FILE, 0, &value);
@@ -80,15 +103,91 @@ string PdfFontConfigWrapper::GetFontConfigFontPath(const string_view fontName,
 
 void PdfFontConfigWrapper::AddFontDirectory(const string_view& path)
 {
-    if (!FcConfigAppFontAddDir(m_FcConfig, (const FcChar8*)path.data()))
+    lock_guard<mutex> lock(m_mutex);
+    if (!FcConfigAppFontAddDir(getFcConfig(), (const FcChar8*)path.data()))
         throw runtime_error("Unable to add font directory");
+
+    m_fontPaths.clear();
+}
+
+void PdfFontConfigWrapper::SetCacheFilePath(const string_view& path)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_cacheFilePath = path;
+    if (!m_cacheFilePath.empty())
+        loadCacheFile();
 }
 
 FcConfig* PdfFontConfigWrapper::GetFcConfig()
 {
+    lock_guard<mutex> lock(m_mutex);
+    return getFcConfig();
+}
+
+FcConfig* PdfFontConfigWrapper::getFcConfig()
+{
+    if (m_FcConfig == nullptr)
+        createDefaultConfig();
+
     return m_FcConfig;
 }
 
+// The cache file has a line for every font, with the style, the
+// face index, the font name and the path separated by tabs
+void PdfFontConfigWrapper::loadCacheFile()
+{
+    auto stream = utls::open_ifstream(m_cacheFilePath, ios_base::in | ios_base::binary);
+    if (!stream.is_open())
+        return;
+
+    string line;
+    while (std::getline(stream, line))
+    {
+        size_t faceIndexStart = line.find('\t');
+        size_t nameStart = faceIndexStart == string::npos ? string::npos : line.find('\t', faceIndexStart + 1);
+        size_t pathStart = nameStart == string::npos ? string::npos : line.find('\t', nameStart + 1);
+        if (pathStart == string::npos)
+            continue;
+
+        unsigned style;
+        unsigned faceIndex;
+        if (std::from_chars(line.data(), line.data() + faceIndexStart, style).ec != std::errc()
+            || std::from_chars(line.data() + faceIndexStart + 1, line.data() + nameStart, faceIndex).ec != std::errc())
+        {
+            continue;
+        }
+
+        string path = line.substr(pathStart + 1);
+        if (path.empty() || !fs::exists(fs::u8path(path)))
+            continue;
+
+        m_fontPaths[FontPathKey(line.substr(nameStart + 1, pathStart - nameStart - 1), (PdfFontStyle)style)]
+            = { std::move(path), faceIndex };
+    }
+}
+
+void PdfFontConfigWrapper::appendCacheFile(const string_view fontName, PdfFontStyle style,
+    const string_view& path, unsigned faceIndex)
+{
+    if (fontName.find_first_of("\t\n") != string_view::npos
+        || path.find_first_of("\t\n") != string_view::npos)
+    {
+        return;
+    }
+
+    // NOTE: The line is written at once at the end of the file,
+    // so processes sharing the file don't mix their entries
+    string line = utls::Format("{}\t{}\t{}\t{}\n", (unsigned)style, faceIndex, fontName, path);
+    auto stream = utls::open_ofstream(m_cacheFilePath, ios_base::out | ios_base::app | ios_base::binary);
+    if (!stream.is_open())
+    {
+        mm::LogMessage(PdfLogSeverity::Warning, "Could not open the font cache file {}", m_cacheFilePath);
+        return;
+    }
+
+    stream.write(line.data(), line.size());
+}
+
 void PdfFontConfigWrapper::createDefaultConfig()
 {
 #ifdef _WIN32
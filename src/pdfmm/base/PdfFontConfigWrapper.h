@@ -12,6 +12,8 @@
 
 #include "PdfDeclarations.h"
 
+#include <mutex>
+
 FORWARD_DECLARE_FCONFIG();
 
 namespace mm {
@@ -27,6 +29,10 @@ namespace mm {
  * will destroy the fontconfig handle.
  *
  * The fontconfig library is initialized on first used (lazy loading!)
+ *
+ * The font paths found are remembered by the wrapper, and they can be
+ * stored also in a cache file with SetCacheFilePath(), so a later
+ * process finds the same fonts without initializing fontconfig
  */
 class PDFMM_API PdfFontConfigWrapper final
 {
@@ -44,6 +50,9 @@ public:
      *  fontconfig support. Make sure to lock any FontConfig mutexes before
      *  calling this method by yourself!
      *
+     *  The result is remembered for the same name and style, and
+     *  fontconfig is not used at all for the fonts in the cache file
+     *
      *  \param fontName name of the requested font
      *  \param style font style
      *  \param faceIndex index of the face
@@ -51,8 +60,20 @@ public:
      */
     std::string GetFontConfigFontPath(const std::string_view fontName, PdfFontStyle style, unsigned& faceIndex);
 
+    /** Add a directory of application fonts
+     * \remarks It forgets the font paths found so far, as they may change
+     */
     void AddFontDirectory(const std::string_view& path);
 
+    /** Set the file where the font paths found are stored, and load
+     * the ones already stored. The file is shared by the processes
+     * using the same font configuration, the paths of the font files
+     * that don't exist anymore are ignored
+     * \param path the path of the cache file, or an empty path
+     *      to not use a cache file
+     */
+    void SetCacheFilePath(const std::string_view& path);
+
     FcConfig* GetFcConfig();
 
 private:
@@ -60,9 +81,26 @@ private:
     const PdfFontConfigWrapper& operator=(const PdfFontConfigWrapper& rhs) = delete;
 
     void createDefaultConfig();
+    FcConfig* getFcConfig();
+    std::string searchFontPath(const std::string_view fontName, PdfFontStyle style, unsigned& faceIndex);
+    void loadCacheFile();
+    void appendCacheFile(const std::string_view fontName, PdfFontStyle style,
+        const std::string_view& path, unsigned faceIndex);
+
+private:
+    struct FontPath
+    {
+        std::string Path;
+        unsigned FaceIndex;
+    };
+
+    using FontPathKey = std::pair<std::string, PdfFontStyle>;
 
 private:
+    std::mutex m_mutex;
     FcConfig* m_FcConfig;
+    std::map<FontPathKey, FontPath> m_fontPaths;
+    std::string m_cacheFilePath;
 };
 
 };
@@ -10,22 +10,27 @@
 #include "PdfFontManager.h"
 
 #include <algorithm>
+#include <atomic>
 
 #if defined(_WIN32) && defined(PDFMM_HAVE_WIN32GDI)
 #include <pdfmm/private/WindowsLeanMean.h>
 #endif // defined(_WIN32) && defined(PDFMM_HAVE_WIN32GDI)
 
 #include <pdfmm/private/FreetypePrivate.h>
+#include <pdfmm/private/PdfTracePrivate.h>
 #include FT_TRUETYPE_TABLES_H
 #include <utfcpp/utf8.h>
 
 #include "PdfDictionary.h"
+#include "PdfDocument.h"
+#include "PdfExecutor.h"
 #include "PdfInputDevice.h"
 #include "PdfOutputDevice.h"
 #include "PdfFont.h"
 #include "PdfFontMetricsFreetype.h"
 #include "PdfFontMetricsStandard14.h"
 #include "PdfFontType1.h"
+#include "PdfStreamDevice.h"
 
 using namespace std;
 using namespace mm;
@@ -38,19 +43,49 @@ static void getFontDataTTC(charbuff& buffer, const charbuff& fileBuffer, const c
 
 #endif // defined(_WIN32) && defined(PDFMM_HAVE_WIN32GDI)
 
-static unique_ptr<charbuff> getFontData(const string_view& filename, unsigned short faceIndex);
+static bool tryGetFontData(const string_view& filename, unsigned short faceIndex, datahandle& data);
 static PdfFont* matchFont(const mspan<PdfFont*>& fonts, const string_view& fontName, const PdfFontSearchParams& params);
 static PdfFont* matchFont(const mspan<PdfFont*>& fonts, const string_view& fontName,
     PdfFontMatchBehaviorFlags matchBehavior = PdfFontMatchBehaviorFlags::None);
 
 #if defined(PDFMM_HAVE_FONTCONFIG)
 shared_ptr<PdfFontConfigWrapper> PdfFontManager::m_fontConfig;
+static mutex s_fontConfigMutex;
 #endif
 
 static constexpr unsigned SUBSET_PREFIX_LEN = 6;
 
+namespace
+{
+    using SharedMetricsKey = pair<string, unsigned>;
+    using SearchKey = pair<string, PdfFontStyle>;
+
+    // The metrics of the font files shared by all the documents,
+    // keyed by the font file path and the face index
+    struct SharedMetrics
+    {
+        SharedMetrics()
+        {
+            // NOTE: Initialize FreeType first, so it's
+            // destroyed after the cached faces
+            (void)mm::GetFreeTypeLibrary();
+        }
+
+        mutex Mutex;
+        bool Enabled = false;
+        map<SharedMetricsKey, PdfFontMetricsConstPtr> Metrics;
+        map<SearchKey, PdfFontMetricsConstPtr> Searches;
+    };
+}
+
+// Incremented when the results of the font searches may change
+static atomic<unsigned> s_searchesGeneration;
+
+static SharedMetrics& getSharedMetrics();
+static void forgetFontSearches();
+
 PdfFontManager::PdfFontManager(PdfDocument& doc)
-    : m_doc(&doc)
+    : m_doc(&doc), m_searchesGeneration(s_searchesGeneration)
 {
     m_currentPrefix = "AAAAAA+";
 }
@@ -64,6 +99,8 @@ void PdfFontManager::Clear()
 {
     m_importedFonts.clear();
     m_fonts.clear();
+    m_metrics.clear();
+    m_searches.clear();
 }
 
 PdfFont* PdfFontManager::AddImported(unique_ptr<PdfFont>&& font)
@@ -103,6 +140,8 @@ PdfFont* PdfFontManager::GetLoadedFont(const PdfObject& obj)
     if (!obj.IsIndirect())
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Object is not indirect");
 
+    // Fonts may be loaded concurrently from frozen documents
+    std::lock_guard<std::mutex> lock(m_loadedFontsMutex);
     auto found = m_fonts.find(obj.GetIndirectReference());
     if (found != m_fonts.end())
     {
@@ -113,10 +152,14 @@ PdfFont* PdfFontManager::GetLoadedFont(const PdfObject& obj)
     }
 
     // Create a new font
+    PDFMM_TRACE_SCOPE(trace, FontLoad, m_doc);
     unique_ptr<PdfFont> font;
     if (!PdfFont::TryCreateFromObject(const_cast<PdfObject&>(obj), font))
         return nullptr;
 
+    PDFMM_TRACE_SET(trace, Reference, obj.GetIndirectReference());
+    PDFMM_TRACE_SET(trace, Name, font->GetName());
+
     auto inserted = m_fonts.emplace(obj.GetIndirectReference(), Storage{ true, std::move(font) });
     return inserted.first->second.Font.get();
 }
@@ -156,7 +199,10 @@ PdfFont* PdfFontManager::GetStandard14Font(PdfStandard14FontType stdFont, const
         return fonts[0];
     }
 
+    PDFMM_TRACE_SCOPE(trace, FontLoad, m_doc);
     auto font = PdfFont::CreateStandard14(*m_doc, stdFont, params);
+    PDFMM_TRACE_SET(trace, Reference, font->GetObject().GetIndirectReference());
+    PDFMM_TRACE_SET(trace, Name, font->GetName());
     return addImported(fonts, std::move(font));
 }
 
@@ -184,11 +230,30 @@ PdfFont* PdfFontManager::getImportedFont(const string_view& fontName, const stri
     if (found != m_importedFonts.end())
         return matchFont(found->second, fontName, searchParams);
 
-    shared_ptr<charbuff> buffer = getFontData(baseFontName, searchParams);
-    if (buffer == nullptr)
+    // Remember also the fonts not found, not to search them again
+    unsigned generation = s_searchesGeneration;
+    if (m_searchesGeneration != generation)
+    {
+        m_searches.clear();
+        m_searchesGeneration = generation;
+    }
+
+    PdfFontMetricsConstPtr metrics;
+    SearchKey key((string)baseFontName, searchParams.Style);
+    auto foundSearch = m_searches.find(key);
+    if (foundSearch == m_searches.end())
+    {
+        metrics = searchFontMetrics(baseFontName, searchParams, &m_metrics);
+        m_searches.emplace(std::move(key), metrics);
+    }
+    else
+    {
+        metrics = foundSearch->second;
+    }
+
+    if (metrics == nullptr)
         return nullptr;
 
-    shared_ptr<PdfFontMetrics> metrics = PdfFontMetricsFreetype::FromBuffer(buffer);
     return getImportedFont(metrics, createParams,
         [&searchParams,&fontName](const mspan<PdfFont*>& fonts) {
             return matchFont(fonts, fontName, searchParams);
@@ -207,11 +272,109 @@ PdfFontMetricsConstPtr PdfFontManager::GetFontMetrics(const string_view& fontNam
     }
 
     PdfFontSearchParams newParams = params;
-    auto fontData = getFontData(adaptSearchParams(fontName, newParams), newParams);
-    if (fontData == nullptr)
+    return searchFontMetrics(adaptSearchParams(fontName, newParams), newParams);
+}
+
+void PdfFontManager::SetSharedMetricsCacheEnabled(bool enabled)
+{
+    auto& shared = getSharedMetrics();
+    lock_guard<mutex> lock(shared.Mutex);
+    shared.Enabled = enabled;
+    if (!enabled)
+    {
+        shared.Metrics.clear();
+        shared.Searches.clear();
+    }
+}
+
+void PdfFontManager::SetSharedSubsetCacheEnabled(bool enabled)
+{
+    PdfFont::SetSharedSubsetCacheEnabled(enabled);
+}
+
+PdfFontMetricsConstPtr PdfFontManager::searchFontMetrics(const string_view& fontName,
+    const PdfFontSearchParams& params, MetricsMap* docMetrics)
+{
+    auto& shared = getSharedMetrics();
+    unsigned generation = s_searchesGeneration;
+    SearchKey searchKey((string)fontName, params.Style);
+    {
+        lock_guard<mutex> lock(shared.Mutex);
+        if (shared.Enabled)
+        {
+            auto found = shared.Searches.find(searchKey);
+            if (found != shared.Searches.end())
+                return found->second;
+        }
+    }
+
+    auto metrics = loadFontMetrics(fontName, params, docMetrics);
+
+    // NOTE: Don't remember the result if font directories were added meanwhile
+    lock_guard<mutex> lock(shared.Mutex);
+    if (shared.Enabled && s_searchesGeneration == generation)
+        shared.Searches.emplace(std::move(searchKey), metrics);
+
+    return metrics;
+}
+
+PdfFontMetricsConstPtr PdfFontManager::loadFontMetrics(const string_view& fontName,
+    const PdfFontSearchParams& params, MetricsMap* docMetrics)
+{
+    string filepath;
+    unsigned faceIndex = 0;
+#ifdef PDFMM_HAVE_FONTCONFIG
+    auto& fc = GetFontConfigWrapper();
+    filepath = fc.GetFontConfigFontPath(fontName, params.Style, faceIndex);
+#endif
+
+    // Only the fonts loaded from files are shared. The fonts of a
+    // document created from the same file, for example with different
+    // encodings, always share the metrics, hence the font data and
+    // the FreeType face. Across documents they're shared only when
+    // the shared cache is enabled
+    SharedMetricsKey key(filepath, faceIndex);
+    if (docMetrics != nullptr && !filepath.empty())
+    {
+        auto found = docMetrics->find(key);
+        if (found != docMetrics->end())
+            return found->second;
+    }
+
+    auto& shared = getSharedMetrics();
+    bool share = false;
+    if (!filepath.empty())
+    {
+        lock_guard<mutex> lock(shared.Mutex);
+        share = shared.Enabled;
+        auto found = shared.Metrics.find(key);
+        if (found != shared.Metrics.end())
+        {
+            if (docMetrics != nullptr)
+                docMetrics->emplace(std::move(key), found->second);
+
+            return found->second;
+        }
+    }
+
+    datahandle fontData;
+    if (!tryGetFontData(fontData, fontName, filepath, faceIndex, params))
         return nullptr;
 
-    return PdfFontMetricsFreetype::FromBuffer(std::move(fontData));
+    PdfFontMetricsConstPtr metrics = PdfFontMetricsFreetype::FromBuffer(fontData);
+    if (share)
+    {
+        // NOTE: The same font may have been loaded
+        // meanwhile, keep the metrics cached first
+        lock_guard<mutex> lock(shared.Mutex);
+        if (shared.Enabled)
+            metrics = shared.Metrics.emplace(key, metrics).first->second;
+    }
+
+    if (docMetrics != nullptr && !filepath.empty())
+        docMetrics->emplace(std::move(key), metrics);
+
+    return metrics;
 }
 
 void PdfFontManager::AddFontDirectory(const string_view& path)
@@ -250,15 +413,17 @@ void PdfFontManager::AddFontDirectory(const string_view& path)
     }
     while (FindNextFile(foundH, &findData) != 0);
 #endif
+
+    forgetFontSearches();
 }
 
-unique_ptr<charbuff> PdfFontManager::getFontData(const string_view& fontName,
+bool PdfFontManager::tryGetFontData(datahandle& data, const string_view& fontName,
     const PdfFontSearchParams& params)
 {
-    return getFontData(fontName, { }, 0, params);
+    return tryGetFontData(data, fontName, { }, 0, params);
 }
 
-unique_ptr<charbuff> PdfFontManager::getFontData(const string_view& fontName,
+bool PdfFontManager::tryGetFontData(datahandle& data, const string_view& fontName,
     string filepath, unsigned faceIndex, const PdfFontSearchParams& params)
 {
     if (filepath.empty())
@@ -269,16 +434,22 @@ unique_ptr<charbuff> PdfFontManager::getFontData(const string_view& fontName,
 #endif
     }
 
-    unique_ptr<charbuff> ret;
-    if (!filepath.empty())
-        ret = ::getFontData(filepath, faceIndex);
+    if (!filepath.empty() && ::tryGetFontData(filepath, faceIndex, data))
+        return true;
 
 #if defined(_WIN32) && defined(PDFMM_HAVE_WIN32GDI)
-    if (ret == nullptr)
-        ret = getWin32FontData(fontName, params);
+    charbuff::const_ptr buffer = getWin32FontData(fontName, params);
+    if (buffer != nullptr)
+    {
+        data = datahandle(buffer);
+        return true;
+    }
+#else
+    (void)fontName;
+    (void)params;
 #endif
 
-    return ret;
+    return false;
 }
 
 PdfFont* PdfFontManager::GetFont(FT_Face face, const PdfFontCreateParams& params)
@@ -316,11 +487,54 @@ PdfFont* PdfFontManager::GetFont(FT_Face face, const PdfFontCreateParams& params
 
 void PdfFontManager::EmbedFonts()
 {
-    // Embed all imported fonts
+    vector<PdfFont*> fonts;
     for (auto& pair : m_importedFonts)
     {
         for (auto& font : pair.second)
-            font->EmbedFont();
+            fonts.push_back(font);
+    }
+
+    // Build the subsets and encode the font programs concurrently,
+    // then embed all imported fonts in order, so the created
+    // objects don't depend on the scheduling of the threads
+    auto executor = m_doc->GetExecutor();
+    if (fonts.size() > 1 && executor->GetConcurrency() > 1)
+    {
+        // NOTE: Load the font data now, as the metrics
+        // may load it lazily and they can be shared
+        for (auto font : fonts)
+        {
+            if (font->IsEmbeddingEnabled())
+                (void)font->GetMetrics().GetOrLoadFontFileData();
+        }
+
+        executor->ParallelFor(fonts.size(), 1, 0, [&]()
+        {
+            return [&](size_t i)
+            {
+                if (!fonts[i]->IsEmbeddingEnabled())
+                    return;
+
+                PDFMM_TRACE_SCOPE(trace, FontSubset, m_doc);
+                fonts[i]->PrepareEmbed();
+                PDFMM_TRACE_SET(trace, Reference, fonts[i]->GetObject().GetIndirectReference());
+                PDFMM_TRACE_SET(trace, Name, fonts[i]->GetName());
+            };
+        });
+    }
+
+    // NOTE: When the fonts were prepared concurrently the
+    // subsetting is traced in two parts, by the threads
+    // preparing the fonts and by the embedding here
+    for (auto font : fonts)
+    {
+        if (!font->IsEmbeddingEnabled())
+            continue;
+
+        PDFMM_TRACE_SCOPE(trace, FontSubset, m_doc);
+        font->EmbedFont();
+        PDFMM_TRACE_SET(trace, Reference, font->GetObject().GetIndirectReference());
+        PDFMM_TRACE_SET(trace, Name, font->GetName());
     }
 
     // Clear imported font cache
@@ -422,11 +636,15 @@ PdfFont* PdfFontManager::getImportedFont(const PdfFontMetricsConstPtr& metrics,
     if (fonts.size() != 0)
         return matchFont(fonts);
 
+    PDFMM_TRACE_SCOPE(trace, FontLoad, m_doc);
     auto font = PdfFont::Create(*m_doc, metrics, params);
     PdfFont* fontptr = font.get();
     if (font == nullptr || matchFont(mspan<PdfFont*>(&fontptr, 1)) == nullptr)
         return nullptr;
 
+    PDFMM_TRACE_SET(trace, Reference, font->GetObject().GetIndirectReference());
+    PDFMM_TRACE_SET(trace, Name, font->GetName());
+
     return addImported(fonts, std::move(font));
 }
 
@@ -434,12 +652,10 @@ PdfFont* PdfFontManager::getImportedFont(const PdfFontMetricsConstPtr& metrics,
 
 void PdfFontManager::SetFontConfigWrapper(const shared_ptr<PdfFontConfigWrapper>& fontConfig)
 {
-    if (m_fontConfig == fontConfig)
-        return;
-
     if (fontConfig == nullptr)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Fontconfig wrapper can't be null");
 
+    unique_lock<mutex> lock(s_fontConfigMutex);
     m_fontConfig = fontConfig;
 }
 
@@ -451,6 +667,10 @@ PdfFontConfigWrapper& PdfFontManager::GetFontConfigWrapper()
 
 shared_ptr<PdfFontConfigWrapper> PdfFontManager::ensureInitializedFontConfig()
 {
+    // NOTE: The wrapper is created on the first font search, or
+    // with PdfLibrary::Warmup(), and fontconfig loads its
+    // configuration only when the first font path is searched
+    unique_lock<mutex> lock(s_fontConfigMutex);
     auto ret = m_fontConfig;
     if (ret == nullptr)
     {
@@ -482,36 +702,51 @@ bool PdfFontManager::EqualElement::operator()(const Descriptor& lhs, const Descr
     return lhs.EncodingId == rhs.EncodingId && lhs.Style == rhs.Style && lhs.FontName == rhs.FontName;
 }
 
-unique_ptr<charbuff> getFontData(const string_view& filename, unsigned short faceIndex)
+// The font file is mapped read-only in memory instead of being
+// copied in a heap buffer. The mapped pages are backed by the page
+// cache, so they are shared by all the processes using the file
+bool tryGetFontData(const string_view& filename, unsigned short faceIndex, datahandle& data)
 {
-    FT_Error rc;
-    FT_ULong length = 0;
-    unique_ptr<charbuff> buffer;
+    shared_ptr<MappedFileStreamDevice> device;
+    try
+    {
+        device = std::make_shared<MappedFileStreamDevice>(filename);
+    }
+    catch (PdfError& error)
+    {
+        mm::LogMessage(PdfLogSeverity::Error, "Unable to map the font file {}: {}",
+            filename, error.what());
+        return false;
+    }
+
+    bufferview view;
+    (void)device->TryGetView(view);
+
+    // Check the requested face is a valid sfnt font, as
+    // when the whole font file was read with FT_Load_Sfnt_Table
+    FT_Open_Args openArgs{ };
+    openArgs.flags = FT_OPEN_MEMORY;
+    openArgs.memory_base = (const FT_Byte*)view.data();
+    openArgs.memory_size = (FT_Long)view.size();
     FT_Face face;
-    rc = FT_New_Face(mm::GetFreeTypeLibrary(), filename.data(), faceIndex, &face);
+    FT_Error rc = FT_Open_Face(mm::GetFreeTypeLibrary(), &openArgs, faceIndex, &face);
     if (rc != 0)
     {
-        // throw an exception
-        mm::LogMessage(PdfLogSeverity::Error, "FreeType returned the error {} when calling FT_New_Face for font {}",
+        mm::LogMessage(PdfLogSeverity::Error, "FreeType returned the error {} when calling FT_Open_Face for font {}",
             (int)rc, filename);
-        return nullptr;
+        return false;
     }
 
-    unique_ptr<FT_FaceRec_, decltype(&FT_Done_Face)> face_(face, FT_Done_Face);
-    rc = FT_Load_Sfnt_Table(face, 0, 0, nullptr, &length);
-    if (rc != 0)
-        goto Error;
-
-    buffer = std::make_unique<charbuff>(length);
-    rc = FT_Load_Sfnt_Table(face, 0, 0, reinterpret_cast<FT_Byte*>(buffer->data()), &length);
-    if (rc != 0)
-        goto Error;
+    bool isSfnt = FT_IS_SFNT(face);
+    FT_Done_Face(face);
+    if (!isSfnt)
+    {
+        mm::LogMessage(PdfLogSeverity::Error, "The font {} is not a sfnt font", filename);
+        return false;
+    }
 
-    return buffer;
-Error:
-    mm::LogMessage(PdfLogSeverity::Error, "FreeType returned the error {} when calling FT_Load_Sfnt_Table for font {}",
-        (int)rc, filename);
-    return nullptr;
+    data = datahandle(view, device);
+    return true;
 }
 
 PdfFont* matchFont(const mspan<PdfFont*>& fonts, const string_view& fontName, const PdfFontSearchParams& params)
@@ -666,3 +901,17 @@ void getFontDataTTC(charbuff& buffer, const charbuff& fileBuffer, const charbuff
 }
 
 #endif // defined(_WIN32) && defined(PDFMM_HAVE_WIN32GDI)
+
+SharedMetrics& getSharedMetrics()
+{
+    static SharedMetrics s_metrics;
+    return s_metrics;
+}
+
+void forgetFontSearches()
+{
+    auto& shared = getSharedMetrics();
+    lock_guard<mutex> lock(shared.Mutex);
+    shared.Searches.clear();
+    s_searchesGeneration++;
+}
@@ -9,6 +9,8 @@
 #ifndef PDF_FONT_CACHE_H
 #define PDF_FONT_CACHE_H
 
+#include <mutex>
+
 #include "PdfDeclarations.h"
 
 #include "PdfFont.h"
@@ -68,6 +70,9 @@ public:
      *
      *  \returns a PdfFont object or nullptr if the font could
      *           not be created or found.
+     *  \remarks It's internally synchronized, so fonts can be
+     *      loaded concurrently from frozen documents
+     *  \see PdfMemDocument::Freeze
      */
     PdfFont* GetLoadedFont(const PdfObject& obj);
 
@@ -107,6 +112,29 @@ public:
 
     static void AddFontDirectory(const std::string_view& path);
 
+    /** Enable or disable a cache of the metrics of the fonts loaded
+     *  from files, shared by the font managers of all the documents,
+     *  so every font file is loaded once per process. The results of
+     *  the searches by name, also of the fonts not found, are shared
+     *  as well. The metrics are kept loaded until the cache is
+     *  disabled. Default is disabled
+     *
+     *  \remarks It's internally synchronized
+     */
+    static void SetSharedMetricsCacheEnabled(bool enabled);
+
+    /** Enable or disable a cache of the subset font programs, already
+     *  encoded with the default stream filter, shared by the fonts of
+     *  all the documents. The subsets are keyed by a hash of the font
+     *  file data, the font type and the used glyphs, so documents using
+     *  the same glyphs of a font skip both subsetting and compression.
+     *  The least recently added subsets are evicted when the cache is
+     *  full. Default is disabled
+     *
+     *  \remarks It's internally synchronized
+     */
+    static void SetSharedSubsetCacheEnabled(bool enabled);
+
 #if defined(_WIN32) && defined(PDFMM_HAVE_WIN32GDI)
     PdfFont* GetFont(HFONT font, const PdfFontCreateParams& params = { });
 #endif
@@ -183,17 +211,30 @@ private:
     using FontMap = std::unordered_map<PdfReference, Storage>;
 
     using FontMatcher = std::function<PdfFont*(const mspan<PdfFont*>&)>;
+
+    // The metrics of the font files, keyed by the
+    // font file path and the face index
+    using MetricsMap = std::map<std::pair<std::string, unsigned>, PdfFontMetricsConstPtr>;
+
+    // The results of the searches of the fonts, keyed by the base font
+    // name and the style. The fonts not found have null metrics
+    using SearchMap = std::map<std::pair<std::string, PdfFontStyle>, PdfFontMetricsConstPtr>;
 private:
 #ifdef PDFMM_HAVE_FONTCONFIG
     static std::shared_ptr<PdfFontConfigWrapper> ensureInitializedFontConfig();
 #endif // PDFMM_HAVE_FONTCONFIG
 
-    static std::unique_ptr<charbuff> getFontData(const std::string_view& fontName,
+    static bool tryGetFontData(datahandle& data, const std::string_view& fontName,
         const PdfFontSearchParams& params);
-    static std::unique_ptr<charbuff> getFontData(const std::string_view& fontName,
+    static bool tryGetFontData(datahandle& data, const std::string_view& fontName,
         std::string filepath, unsigned faceIndex, const PdfFontSearchParams& params);
     PdfFont* getImportedFont(const std::string_view& fontName, const std::string_view& baseFontName,
         const PdfFontSearchParams& searchParams, const PdfFontCreateParams& createParams);
+    static PdfFontMetricsConstPtr searchFontMetrics(const std::string_view& fontName,
+        const PdfFontSearchParams& params, MetricsMap* docMetrics = nullptr);
+    static PdfFontMetricsConstPtr loadFontMetrics(const std::string_view& fontName,
+        const PdfFontSearchParams& params, MetricsMap* docMetrics);
+
     static std::string adaptSearchParams(const std::string_view& fontName,
         PdfFontSearchParams& searchParams);
     PdfFont* getImportedFont(const PdfFontMetricsConstPtr& metrics,
@@ -213,6 +254,14 @@ private:
     ImportedFontMap m_importedFonts;
     // Map of all fonts
     FontMap m_fonts;
+    // The metrics of the font files imported in this document, shared
+    // by the fonts created from the same file with different parameters
+    MetricsMap m_metrics;
+    // The fonts searched by name, also the ones not found. They're
+    // forgotten when a font directory is added
+    SearchMap m_searches;
+    unsigned m_searchesGeneration;
+    std::mutex m_loadedFontsMutex;
 
 #ifdef PDFMM_HAVE_FONTCONFIG
     static std::shared_ptr<PdfFontConfigWrapper> m_fontConfig;
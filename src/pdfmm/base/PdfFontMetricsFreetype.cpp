@@ -14,6 +14,7 @@
 #include FT_TRUETYPE_TABLES_H
 #include FT_TYPE1_TABLES_H
 #include FT_FONT_FORMATS_H
+#include FT_ADVANCES_H
 
 #include "PdfArray.h"
 #include "PdfDictionary.h"
@@ -39,6 +40,13 @@ PdfFontMetricsFreetype::PdfFontMetricsFreetype(const datahandle& data, const Fre
     if (face == nullptr)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The buffer can't be null");
 
+    // Share the advances with the metrics of the same face
+    auto freetypeMetrics = dynamic_cast<const PdfFontMetricsFreetype*>(refMetrics);
+    if (freetypeMetrics != nullptr && freetypeMetrics->m_Face == face)
+        m_GlyphAdvances = freetypeMetrics->m_GlyphAdvances;
+    else
+        m_GlyphAdvances = std::make_shared<GlyphAdvances>();
+
     initFromFace(refMetrics);
 }
 
@@ -55,8 +63,13 @@ unique_ptr<PdfFontMetricsFreetype> PdfFontMetricsFreetype::FromMetrics(const Pdf
 
 unique_ptr<PdfFontMetricsFreetype> PdfFontMetricsFreetype::FromBuffer(const charbuff::const_ptr& buffer)
 {
-    FreeTypeFacePtr face = mm::CreateFreeTypeFace(*buffer);
-    return unique_ptr<PdfFontMetricsFreetype>(new PdfFontMetricsFreetype(buffer, face));
+    return FromBuffer(datahandle(buffer));
+}
+
+unique_ptr<PdfFontMetricsFreetype> PdfFontMetricsFreetype::FromBuffer(const datahandle& data)
+{
+    FreeTypeFacePtr face = mm::CreateFreeTypeFace(data.view());
+    return unique_ptr<PdfFontMetricsFreetype>(new PdfFontMetricsFreetype(data, face));
 }
 
 unique_ptr<PdfFontMetricsFreetype> PdfFontMetricsFreetype::FromFace(FT_Face face)
@@ -228,6 +241,7 @@ void PdfFontMetricsFreetype::initFromFace(const PdfFontMetrics* refMetrics)
 
 void PdfFontMetricsFreetype::ensureLengthsReady()
 {
+    lock_guard<mutex> lock(m_Mutex);
     if (m_LengthsReady)
         return;
 
@@ -345,17 +359,51 @@ unsigned PdfFontMetricsFreetype::GetGlyphCount() const
 
 bool PdfFontMetricsFreetype::TryGetGlyphWidth(unsigned gid, double& width) const
 {
-    if (FT_Load_Glyph(m_Face.get(), gid, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP) != 0)
+    auto& advances = getGlyphAdvances();
+    if (gid >= advances.size() || advances[gid] < 0)
     {
         width = -1;
         return false;
     }
 
-    // zero return code is success!
-    width = m_Face.get()->glyph->metrics.horiAdvance / (double)m_Face.get()->units_per_EM;
+    width = advances[gid] / (double)m_Face.get()->units_per_EM;
     return true;
 }
 
+const vector<float>& PdfFontMetricsFreetype::getGlyphAdvances() const
+{
+    std::call_once(m_GlyphAdvances->Init, [this]()
+    {
+        auto face = m_Face.get();
+        auto& values = m_GlyphAdvances->Values;
+        unsigned count = (unsigned)std::max<FT_Long>(face->num_glyphs, 0);
+        values.resize(count);
+
+        // FreeType reads the advances of sfnt fonts straight from
+        // the "hmtx" table. Fonts that fail with some glyph are
+        // read again glyph by glyph, to mark only the invalid ones
+        vector<FT_Fixed> advances(count);
+        constexpr FT_Int32 flags = FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP;
+        if (count != 0 && FT_Get_Advances(face, 0, count, flags, advances.data()) == 0)
+        {
+            for (unsigned i = 0; i < count; i++)
+                values[i] = (float)advances[i];
+        }
+        else
+        {
+            for (unsigned i = 0; i < count; i++)
+            {
+                if (FT_Load_Glyph(face, i, flags) == 0)
+                    values[i] = (float)face->glyph->metrics.horiAdvance;
+                else
+                    values[i] = -1;
+            }
+        }
+    });
+
+    return m_GlyphAdvances->Values;
+}
+
 bool PdfFontMetricsFreetype::HasUnicodeMapping() const
 {
     return m_HasUnicodeMapping;
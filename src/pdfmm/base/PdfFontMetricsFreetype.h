@@ -11,6 +11,8 @@
 
 #include "PdfDeclarations.h"
 
+#include <mutex>
+
 #include "PdfFontMetrics.h"
 #include "PdfString.h"
 
@@ -29,6 +31,12 @@ public:
 
     static std::unique_ptr<PdfFontMetricsFreetype> FromBuffer(const charbuff::const_ptr& buffer);
 
+    /** Create a metrics from the font data of the handle
+     *
+     * The data is not copied, the handle keeps it alive
+     */
+    static std::unique_ptr<PdfFontMetricsFreetype> FromBuffer(const datahandle& data);
+
     /// <summary>
     /// Create a metrics from a FT_Face
     /// </summary>
@@ -122,8 +130,19 @@ private:
 
     void ensureLengthsReady();
 
+    const std::vector<float>& getGlyphAdvances() const;
+
     void initType1Lengths(const bufferview& view);
 
+private:
+    // The horizontal advances of all the glyphs in font units,
+    // negative for invalid glyphs, shared by the metrics of a face
+    struct GlyphAdvances
+    {
+        std::once_flag Init;
+        std::vector<float> Values;
+    };
+
 private:
     datahandle m_Data;
     PdfCIDToGIDMapConstPtr m_CIDToGIDMap;
@@ -161,6 +180,12 @@ private:
     unsigned m_Length1;
     unsigned m_Length2;
     unsigned m_Length3;
+
+    std::shared_ptr<GlyphAdvances> m_GlyphAdvances;
+
+    // Serializes the computing of the lengths, as
+    // the metrics can be shared between documents
+    mutable std::mutex m_Mutex;
 };
 
 };
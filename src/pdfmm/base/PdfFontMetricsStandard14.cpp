@@ -118,15 +118,18 @@ bool PdfFontMetricsStandard14::TryGetGID(char32_t codePoint, unsigned& gid) cons
         return false;
     }
 
-    auto& map = GetStd14CPToGIDMap(m_Std14FontType);
-    auto found = map.find((unsigned short)codePoint);
-    if (found == map.end())
+    auto map = GetStd14CPToGIDMap(m_Std14FontType);
+    auto found = std::lower_bound(map.begin(), map.end(), (unsigned short)codePoint,
+        [](const Std14CPToGIDEntry& entry, unsigned short codePoint) {
+            return entry.CodePoint < codePoint;
+        });
+    if (found == map.end() || found->CodePoint != codePoint)
     {
         gid = { };
         return false;
     }
 
-    gid = found->second;
+    gid = found->GID;
     return true;
 }
 
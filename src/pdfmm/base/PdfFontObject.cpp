@@ -18,14 +18,16 @@ static constexpr unsigned DEFAULT_STD14_FIRSTCHAR = 32;
 
 PdfFontObject::PdfFontObject(PdfObject& obj, const PdfFontMetricsConstPtr& metrics,
         const PdfEncoding& encoding) :
-    PdfFont(obj, metrics, encoding) { }
+    PdfFont(obj, metrics, encoding), m_isCIDFont(false) { }
 
 unique_ptr<PdfFontObject> PdfFontObject::Create(PdfObject& obj, PdfObject& descendantObj,
     const PdfFontMetricsConstPtr& metrics, const PdfEncoding& encoding)
 {
     (void)descendantObj;
     // TODO: MAke a virtual GetDescendantFontObject()
-    return unique_ptr<PdfFontObject>(new PdfFontObject(obj, metrics, encoding));
+    unique_ptr<PdfFontObject> font(new PdfFontObject(obj, metrics, encoding));
+    font->m_isCIDFont = true;
+    return font;
 }
 
 unique_ptr<PdfFontObject> PdfFontObject::Create(PdfObject& obj, const PdfFontMetricsConstPtr& metrics, const PdfEncoding& encoding)
@@ -35,7 +37,12 @@ unique_ptr<PdfFontObject> PdfFontObject::Create(PdfObject& obj, const PdfFontMet
 
 bool PdfFontObject::tryMapCIDToGID(unsigned cid, unsigned& gid) const
 {
-    if (m_Metrics->IsStandard14FontMetrics() && !m_Encoding->HasParsedLimits())
+    if (m_isCIDFont)
+    {
+        // The /W widths of CIDFonts are indexed by CID
+        gid = cid;
+    }
+    else if (m_Metrics->IsStandard14FontMetrics() && !m_Encoding->HasParsedLimits())
     {
         gid = cid - DEFAULT_STD14_FIRSTCHAR;
     }
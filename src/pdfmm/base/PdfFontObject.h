@@ -36,6 +36,9 @@ public:
 public:
     bool IsObjectLoaded() const override;
     PdfFontType GetType() const override;
+
+private:
+    bool m_isCIDFont;   // The font has a descendant CIDFont
 };
 
 }
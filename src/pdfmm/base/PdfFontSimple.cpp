@@ -37,22 +37,19 @@ void PdfFontSimple::getWidthsArray(PdfArray& arr) const
         widths.push_back(GetCIDWidthRaw(code));
     }
 
-    arr.Clear();
-    arr.reserve(widths.size());
-
     auto matrix = m_Metrics->GetMatrix();
+    vector<int64_t> scaled(widths.size());
     for (unsigned i = 0; i < widths.size(); i++)
-        arr.Add(PdfObject(static_cast<int64_t>(std::round(widths[i] / matrix[0]))));
+        scaled[i] = static_cast<int64_t>(std::round(widths[i] / matrix[0]));
+
+    arr.Clear();
+    arr.AddNumbers(scaled);
 }
 
 void PdfFontSimple::getFontMatrixArray(PdfArray& fontMatrix) const
 {
     fontMatrix.Clear();
-    fontMatrix.Reserve(6);
-
-    auto matrix = m_Metrics->GetMatrix();
-    for (unsigned i = 0; i < 6; i++)
-        fontMatrix.Add(PdfObject(matrix[i]));
+    fontMatrix.AddReals(m_Metrics->GetMatrix());
 }
 
 void PdfFontSimple::Init()
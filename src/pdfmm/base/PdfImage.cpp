@@ -13,6 +13,7 @@
 
 #include <pdfmm/private/FileSystem.h>
 #include <pdfmm/private/PdfFiltersPrivate.h>
+#include <pdfmm/private/PdfImageConversionPrivate.h>
 
 #include "PdfDocument.h"
 #include "PdfDictionary.h"
@@ -27,10 +28,31 @@
 using namespace std;
 using namespace mm;
 
+#ifdef PDFMM_HAVE_JPEG_LIB
+struct JpegInfo
+{
+    unsigned Width = 0;
+    unsigned Height = 0;
+    unsigned ComponentCount = 0;
+    // The transform flag of the Adobe APP14 marker, -1 if missing
+    int AdobeTransform = -1;
+};
+
+static bool tryReadJpegInfo(const bufferview& data, JpegInfo& info);
+#endif // PDFMM_HAVE_JPEG_LIB
+
+static void decodeSoftMask(const PdfObject& smask, char* buffer, unsigned width, unsigned height,
+    size_t stride, unsigned alphaOffset);
+
 #ifdef PDFMM_HAVE_PNG_LIB
 #include <png.h>
+class PngSource;
 static void pngReadData(png_structp pngPtr, png_bytep data, png_size_t length);
 static void LoadFromPngContent(PdfImage& image, png_structp png, png_infop info);
+static bool tryLoadFromPngImageData(PdfImage& image, PngSource& source);
+static bool tryFindPngImageData(PngSource& source, unsigned& width, unsigned& height, int& colorType, uint32_t& length);
+static bool tryReadPngRow(png_structp png, png_bytep row);
+static bool tryReadPngImage(png_structp png, png_bytepp rows);
 #endif // PDFMM_HAVE_PNG_LIB
 
 PdfImage::PdfImage(PdfDocument& doc, const string_view& prefix)
@@ -88,16 +110,17 @@ void PdfImage::SetICCProfile(InputStream& stream, unsigned colorComponents, PdfC
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "SetImageICCProfile lColorComponents must be 1,3 or 4!");
     }
 
-    // Create a colorspace object
-    PdfObject* iccObject = this->GetDocument().GetObjects().CreateDictionaryObject();
-    iccObject->GetDictionary().AddKey("Alternate", ColorspaceToName(alternateColorSpace));
-    iccObject->GetDictionary().AddKey("N", static_cast<int64_t>(colorComponents));
-    iccObject->GetOrCreateStream().Set(stream);
+    // Get a colorspace object, shared by the images with the same profile
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    stream.CopyTo(device);
+    auto& iccObject = GetDocument().GetImageManager().getICCProfile(buffer,
+        colorComponents, alternateColorSpace);
 
     // Add the colorspace to our image
     PdfArray array;
     array.Add(PdfName("ICCBased"));
-    array.Add(iccObject->GetIndirectReference());
+    array.Add(iccObject.GetIndirectReference());
     this->GetDictionary().AddKey("ColorSpace", array);
 }
 
@@ -127,6 +150,53 @@ void PdfImage::SetData(InputStream& stream, unsigned width, unsigned height,
     this->GetObject().GetOrCreateStream().Set(stream, filters);
 }
 
+void PdfImage::SetData(InputStream& stream, unsigned width, unsigned height,
+    PdfPixelFormat format, const PdfImageConversion& conversion)
+{
+    unsigned targetWidth = conversion.Width == 0 ? width : conversion.Width;
+    unsigned targetHeight = conversion.Height == 0 ? height : conversion.Height;
+    PdfColorSpace colorSpace = conversion.ColorSpace == PdfColorSpace::Unknown
+        ? ImageConversionStream::GetColorSpace(format) : conversion.ColorSpace;
+    bool hasAlpha = format == PdfPixelFormat::ARGB || format == PdfPixelFormat::BGRA;
+
+    ImageConversionStream input(stream, width, height, format, targetWidth, targetHeight,
+        conversion.Resampling, colorSpace, conversion.PremultiplyAlpha);
+
+    // Create the smask, appending to it while
+    // the image data is being compressed
+    unique_ptr<PdfImage> smask;
+    PdfObjectStream* smaskStream = nullptr;
+    if (hasAlpha && conversion.ExtractAlpha)
+    {
+        smask.reset(new PdfImage(GetDocument()));
+        smask->SetColorSpace(PdfColorSpace::DeviceGray);
+        smask->GetDictionary().AddKey("Width", static_cast<int64_t>(targetWidth));
+        smask->GetDictionary().AddKey("Height", static_cast<int64_t>(targetHeight));
+        smask->GetDictionary().AddKey("BitsPerComponent", static_cast<int64_t>(8));
+        if (conversion.PremultiplyAlpha)
+        {
+            PdfArray matte;
+            for (unsigned i = 0; i < ImageConversionStream::GetColorComponentCount(colorSpace); i++)
+                matte.Add(static_cast<int64_t>(0));
+
+            smask->GetDictionary().AddKey("Matte", matte);
+        }
+        smaskStream = &smask->GetObject().GetOrCreateStream();
+        input.SetAlphaStream(smaskStream);
+    }
+
+    this->SetColorSpace(colorSpace);
+    if (smaskStream != nullptr)
+        smaskStream->BeginAppend();
+
+    this->SetData(input, targetWidth, targetHeight, 8);
+    if (smaskStream != nullptr)
+    {
+        smaskStream->EndAppend();
+        this->SetSoftmask(*smask);
+    }
+}
+
 void PdfImage::SetDataRaw(InputStream& stream, unsigned width, unsigned height,
     unsigned bitsPerComponent)
 {
@@ -139,6 +209,51 @@ void PdfImage::SetDataRaw(InputStream& stream, unsigned width, unsigned height,
     this->GetObject().GetOrCreateStream().SetRawData(stream, -1);
 }
 
+void PdfImage::SetDataCCITT(const bufferview& data, unsigned width, unsigned height)
+{
+    charbuff encoded;
+    mm::EncodeCCITTGroup4(encoded, data, width, height);
+
+    PdfDictionary decodeParms;
+    decodeParms.AddKey("K", static_cast<int64_t>(-1));
+    decodeParms.AddKey("Columns", static_cast<int64_t>(width));
+    decodeParms.AddKey("Rows", static_cast<int64_t>(height));
+    this->SetColorSpace(PdfColorSpace::DeviceGray);
+    this->GetDictionary().AddKey(PdfName::KeyFilter, PdfName("CCITTFaxDecode"));
+    this->GetDictionary().AddKey("DecodeParms", decodeParms);
+
+    SpanStreamDevice input(encoded);
+    this->SetDataRaw(input, width, height, 1);
+}
+
+void PdfImage::DecodeTo(charbuff& buffer, PdfPixelFormat format, unsigned stride) const
+{
+    if (stride == 0)
+        stride = m_width * ImageDecodeStream::GetPixelSize(format);
+
+    buffer.resize((size_t)stride * m_height);
+    DecodeTo(mspan<char>(buffer.data(), buffer.size()), format, stride);
+}
+
+void PdfImage::DecodeTo(const mspan<char>& buffer, PdfPixelFormat format, unsigned stride) const
+{
+    auto& obj = GetObject();
+    ImageDecodeStream decoder(obj, format, buffer.data(), stride);
+    if (buffer.size() < decoder.GetBufferSize())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The buffer is too small for the image");
+
+    obj.MustGetStream().ExtractTo(decoder);
+    decoder.Finish();
+
+    auto smask = GetDictionary().FindKey("SMask");
+    if (smask != nullptr && smask->HasStream()
+        && (format == PdfPixelFormat::ARGB || format == PdfPixelFormat::BGRA))
+    {
+        decodeSoftMask(*smask, buffer.data(), decoder.GetWidth(), decoder.GetHeight(),
+            stride == 0 ? (size_t)decoder.GetWidth() * 4 : stride, format == PdfPixelFormat::ARGB ? 0 : 3);
+    }
+}
+
 void PdfImage::LoadFromFile(const string_view& filename)
 {
     if (filename.length() > 3)
@@ -224,68 +339,61 @@ void PdfImage::LoadFromData(const unsigned char* data, size_t len)
 
 void PdfImage::LoadFromJpeg(const string_view& filename)
 {
-    FILE* file = utls::fopen(filename, "rb");
-    try
-    {
-        LoadFromJpegHandle(file, filename);
-    }
-    catch (...)
+    // The JPEG data is embedded as it is, so it's read only once
+    MappedFileStreamDevice device(filename);
+    bufferview view;
+    if (device.TryGetView(view))
     {
-        fclose(file);
-        throw;
+        LoadFromJpegData((const unsigned char*)view.data(), view.size());
+        return;
     }
 
-    fclose(file);
+    charbuff buffer;
+    BufferStreamDevice output(buffer);
+    device.CopyTo(output);
+    LoadFromJpegData((const unsigned char*)buffer.data(), buffer.size());
 }
 
-void PdfImage::LoadFromJpegHandle(FILE* inStream, const string_view& filename)
+void PdfImage::LoadFromJpegData(const unsigned char* data, size_t len)
 {
-    struct jpeg_decompress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-
-    cinfo.err = jpeg_std_error(&jerr);
-    jerr.error_exit = &JPegErrorExit;
-    jerr.emit_message = &JPegErrorOutput;
-
-    jpeg_create_decompress(&cinfo);
-
-    jpeg_stdio_src(&cinfo, inStream);
+    // Only the markers are parsed, the data is not decompressed
+    JpegInfo info;
+    if (!tryReadJpegInfo(bufferview((const char*)data, len), info))
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedImageFormat, "Invalid or unsupported JPEG data");
 
-    if (jpeg_read_header(&cinfo, TRUE) <= 0)
-    {
-        jpeg_destroy_decompress(&cinfo);
-        PDFMM_RAISE_ERROR(PdfErrorCode::UnexpectedEOF);
-    }
-
-    jpeg_start_decompress(&cinfo);
-
-    // I am not sure whether this switch is fully correct.
-    // it should handle all cases though.
-    // Index jpeg files might look strange as jpeglib+
-    // returns 1 for them.
-    switch (cinfo.output_components)
+    switch (info.ComponentCount)
     {
         case 3:
         {
             this->SetColorSpace(PdfColorSpace::DeviceRGB);
+            if (info.AdobeTransform == 0)
+            {
+                // The components are stored as RGB, not YCbCr
+                PdfDictionary decodeParms;
+                decodeParms.AddKey("ColorTransform", static_cast<int64_t>(0));
+                this->GetDictionary().AddKey("DecodeParms", decodeParms);
+            }
             break;
         }
         case 4:
         {
             this->SetColorSpace(PdfColorSpace::DeviceCMYK);
-            // The jpeg-doc ist not specific in this point, but cmyk's seem to be stored
-            // in a inverted fashion. Fix by attaching a decode array
-            PdfArray decode;
-            decode.Add(1.0);
-            decode.Add(0.0);
-            decode.Add(1.0);
-            decode.Add(0.0);
-            decode.Add(1.0);
-            decode.Add(0.0);
-            decode.Add(1.0);
-            decode.Add(0.0);
+            if (info.AdobeTransform >= 0)
+            {
+                // The CMYK data written by Adobe applications is stored
+                // inverted. Fix by attaching a decode array
+                PdfArray decode;
+                decode.Add(1.0);
+                decode.Add(0.0);
+                decode.Add(1.0);
+                decode.Add(0.0);
+                decode.Add(1.0);
+                decode.Add(0.0);
+                decode.Add(1.0);
+                decode.Add(0.0);
 
-            this->GetDictionary().AddKey("Decode", decode);
+                this->GetDictionary().AddKey("Decode", decode);
+            }
             break;
         }
         default:
@@ -296,76 +404,107 @@ void PdfImage::LoadFromJpegHandle(FILE* inStream, const string_view& filename)
     }
 
     // Set the filters key to DCTDecode
-    this->GetObject().GetDictionary().AddKey(PdfName::KeyFilter, PdfName("DCTDecode"));
+    this->GetDictionary().AddKey(PdfName::KeyFilter, PdfName("DCTDecode"));
 
     // Do not apply any filters as JPEG data is already DCT encoded.
-    FileStreamDevice input(filename);
-    this->SetDataRaw(input, cinfo.output_width, cinfo.output_height, 8);
-    jpeg_destroy_decompress(&cinfo);
+    SpanStreamDevice input((const char*)data, len);
+    this->SetDataRaw(input, info.Width, info.Height, 8);
 }
 
-void PdfImage::LoadFromJpegData(const unsigned char* data, size_t len)
+void PdfImage::DecodeJpegTo(charbuff& buffer, unsigned& width, unsigned& height,
+    const PdfJpegDecodeOptions& options) const
 {
-    struct jpeg_decompress_struct cinfo;
-    struct jpeg_error_mgr jerr;
+    auto& obj = GetObject();
+    PdfFilterList filters = PdfFilterFactory::CreateFilterList(obj);
+
+    if (filters.size() == 0 || filters.back() != PdfFilterType::DCTDecode)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedFilter, "The image is not encoded with DCTDecode");
+
+    // Undo the filters before DCTDecode, if any, and
+    // decode the JPEG data with the requested options
+    charbuff jpeg;
+    BufferStreamDevice stream(jpeg);
+    filters.pop_back();
+    if (filters.size() == 0)
+    {
+        obj.MustGetStream().CopyTo(stream);
+    }
+    else
+    {
+        auto decodeStream = PdfFilterFactory::CreateDecodeStream(filters, stream, obj.GetDictionary());
+        obj.MustGetStream().CopyTo(*decodeStream);
+        decodeStream->Flush();
+    }
 
-    cinfo.err = jpeg_std_error(&jerr);
-    jerr.error_exit = &JPegErrorExit;
-    jerr.emit_message = &JPegErrorOutput;
+    unsigned componentCount;
+    buffer.clear();
+    DecodeJpeg(buffer, jpeg, options, width, height, componentCount);
+}
 
-    jpeg_create_decompress(&cinfo);
+bool tryReadJpegInfo(const bufferview& data, JpegInfo& info)
+{
+    auto readUInt16 = [&](size_t offset) {
+        return (unsigned)((unsigned char)data[offset] << 8 | (unsigned char)data[offset + 1]);
+    };
 
-    jpeg_memory_src(&cinfo, data, len);
+    if (data.size() < 4 || (unsigned char)data[0] != 0xFF || (unsigned char)data[1] != 0xD8)
+        return false;
 
-    if (jpeg_read_header(&cinfo, TRUE) <= 0)
+    bool hasFrame = false;
+    size_t offset = 2;
+    while (true)
     {
-        jpeg_destroy_decompress(&cinfo);
-        PDFMM_RAISE_ERROR(PdfErrorCode::UnexpectedEOF);
-    }
+        // Skip the fill bytes before the marker
+        if (offset >= data.size() || (unsigned char)data[offset] != 0xFF)
+            return false;
 
-    jpeg_start_decompress(&cinfo);
+        while (offset < data.size() && (unsigned char)data[offset] == 0xFF)
+            offset++;
 
-    // I am not sure whether this switch is fully correct.
-    // it should handle all cases though.
-    // Index jpeg files might look strange as jpeglib+
-    // returns 1 for them.
-    switch (cinfo.output_components)
-    {
-        case 3:
+        if (offset >= data.size())
+            return false;
+
+        unsigned char marker = (unsigned char)data[offset];
+        offset++;
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7))
+            continue; // Standalone markers
+
+        // The frame and the APP14 marker are before
+        // the first scan, no need to read further
+        if (marker == 0xDA || marker == 0xD9)
+            return hasFrame;
+
+        if (offset + 2 > data.size())
+            return false;
+
+        size_t length = readUInt16(offset);
+        if (length < 2 || offset + length > data.size())
+            return false;
+
+        size_t segment = offset + 2;
+        size_t segmentLength = length - 2;
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
         {
-            this->SetColorSpace(PdfColorSpace::DeviceRGB);
-            break;
+            // Start of frame: precision, height, width and the components
+            if (segmentLength < 6)
+                return false;
+
+            info.Height = readUInt16(segment + 1);
+            info.Width = readUInt16(segment + 3);
+            info.ComponentCount = (unsigned char)data[segment + 5];
+            if (info.Width == 0 || info.Height == 0 || info.ComponentCount == 0)
+                return false; // The height defined by a DNL marker is not supported
+
+            hasFrame = true;
         }
-        case 4:
+        else if (marker == 0xEE && segmentLength >= 12
+            && string_view(data.data() + segment, 5) == "Adobe")
         {
-            this->SetColorSpace(PdfColorSpace::DeviceCMYK);
-            // The jpeg-doc ist not specific in this point, but cmyk's seem to be stored
-            // in a inverted fashion. Fix by attaching a decode array
-            PdfArray decode;
-            decode.Add(1.0);
-            decode.Add(0.0);
-            decode.Add(1.0);
-            decode.Add(0.0);
-            decode.Add(1.0);
-            decode.Add(0.0);
-            decode.Add(1.0);
-            decode.Add(0.0);
-
-            this->GetDictionary().AddKey("Decode", decode);
+            info.AdobeTransform = (unsigned char)data[segment + 11];
         }
-        break;
-        default:
-            this->SetColorSpace(PdfColorSpace::DeviceGray);
-            break;
-    }
 
-    // Set the filters key to DCTDecode
-    this->GetDictionary().AddKey(PdfName::KeyFilter, PdfName("DCTDecode"));
-
-    SpanStreamDevice input((const char*)data, len);
-    this->SetDataRaw(input, cinfo.output_width, cinfo.output_height, 8);
-
-    jpeg_destroy_decompress(&cinfo);
+        offset += length;
+    }
 }
 
 #endif // PDFMM_HAVE_JPEG_LIB
@@ -379,15 +518,15 @@ static void TIFFErrorWarningHandler(const char*, const char*, va_list)
 
 void PdfImage::LoadFromTiffHandle(void* handle)
 {
-
+    // NOTE: The handle is owned by the caller, that closes it also on errors
     TIFF* hInTiffHandle = (TIFF*)handle;
 
-    int32 row, width, height;
+    uint32 width, height, rowsPerStrip;
     uint16 samplesPerPixel, bitsPerSample;
     uint16* sampleInfo;
     uint16 extraSamples;
     uint16 planarConfig, photoMetric, orientation;
-    int32 resolutionUnit;
+    uint16 compression, fillOrder;
 
     TIFFGetField(hInTiffHandle, TIFFTAG_IMAGEWIDTH, &width);
     TIFFGetField(hInTiffHandle, TIFFTAG_IMAGELENGTH, &height);
@@ -397,13 +536,9 @@ void PdfImage::LoadFromTiffHandle(void* handle)
     TIFFGetFieldDefaulted(hInTiffHandle, TIFFTAG_PHOTOMETRIC, &photoMetric);
     TIFFGetFieldDefaulted(hInTiffHandle, TIFFTAG_EXTRASAMPLES, &extraSamples, &sampleInfo);
     TIFFGetFieldDefaulted(hInTiffHandle, TIFFTAG_ORIENTATION, &orientation);
-
-    resolutionUnit = 0;
-    float resX;
-    float resY;
-    TIFFGetFieldDefaulted(hInTiffHandle, TIFFTAG_XRESOLUTION, &resX);
-    TIFFGetFieldDefaulted(hInTiffHandle, TIFFTAG_YRESOLUTION, &resY);
-    TIFFGetFieldDefaulted(hInTiffHandle, TIFFTAG_RESOLUTIONUNIT, &resolutionUnit);
+    TIFFGetFieldDefaulted(hInTiffHandle, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+    TIFFGetFieldDefaulted(hInTiffHandle, TIFFTAG_COMPRESSION, &compression);
+    TIFFGetFieldDefaulted(hInTiffHandle, TIFFTAG_FILLORDER, &fillOrder);
 
     int colorChannels = samplesPerPixel - extraSamples;
 
@@ -411,21 +546,62 @@ void PdfImage::LoadFromTiffHandle(void* handle)
 
     // TODO: implement special cases
     if (TIFFIsTiled(hInTiffHandle))
-    {
-        TIFFClose(hInTiffHandle);
         PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedImageFormat);
-    }
 
     if (planarConfig != PLANARCONFIG_CONTIG && colorChannels != 1)
-    {
-        TIFFClose(hInTiffHandle);
         PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedImageFormat);
-    }
 
     if (orientation != ORIENTATION_TOPLEFT)
-    {
-        TIFFClose(hInTiffHandle);
         PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedImageFormat);
+
+    // An image in a single strip compressed with CCITT Group 4 or
+    // with self-contained JPEG data is embedded as it is, with the
+    // equivalent PDF filter. The strips can't be just concatenated
+    // otherwise, because each one is encoded on its own
+    if (TIFFNumberOfStrips(hInTiffHandle) == 1)
+    {
+        uint32 jpegTablesLength;
+        void* jpegTables;
+        if (compression == COMPRESSION_CCITTFAX4 && bitsPixel == 1 && fillOrder == FILLORDER_MSB2LSB
+            && (photoMetric == PHOTOMETRIC_MINISWHITE || photoMetric == PHOTOMETRIC_MINISBLACK))
+        {
+            PdfDictionary decodeParms;
+            decodeParms.AddKey("K", static_cast<int64_t>(-1));
+            decodeParms.AddKey("Columns", static_cast<int64_t>(width));
+            decodeParms.AddKey("Rows", static_cast<int64_t>(height));
+            this->SetColorSpace(PdfColorSpace::DeviceGray);
+            this->GetDictionary().AddKey(PdfName::KeyFilter, PdfName("CCITTFaxDecode"));
+            this->GetDictionary().AddKey("DecodeParms", decodeParms);
+
+            // The decoded black pixels are 0, and they are white
+            // if the minimum value is black
+            if (photoMetric == PHOTOMETRIC_MINISBLACK)
+            {
+                PdfArray decode;
+                decode.Add(static_cast<int64_t>(1));
+                decode.Add(static_cast<int64_t>(0));
+                this->GetDictionary().AddKey("Decode", decode);
+            }
+
+            loadTiffRawStrip(handle, width, height, 1);
+            return;
+        }
+        else if (compression == COMPRESSION_JPEG && bitsPerSample == 8 && extraSamples == 0
+            && (samplesPerPixel == 1 || samplesPerPixel == 3)
+            && TIFFGetField(hInTiffHandle, TIFFTAG_JPEGTABLES, &jpegTablesLength, &jpegTables) == 0)
+        {
+            this->SetColorSpace(samplesPerPixel == 1 ? PdfColorSpace::DeviceGray : PdfColorSpace::DeviceRGB);
+            this->GetDictionary().AddKey(PdfName::KeyFilter, PdfName("DCTDecode"));
+            loadTiffRawStrip(handle, width, height, 8);
+            return;
+        }
+    }
+
+    // Let the JPEG codec convert the YCbCr data
+    if (compression == COMPRESSION_JPEG && photoMetric == PHOTOMETRIC_YCBCR)
+    {
+        TIFFSetField(hInTiffHandle, TIFFTAG_JPEGCOLORMODE, JPEGCOLORMODE_RGB);
+        photoMetric = PHOTOMETRIC_RGB;
     }
 
     switch (photoMetric)
@@ -444,10 +620,7 @@ void PdfImage::LoadFromTiffHandle(void* handle)
             else if (bitsPixel == 8 || bitsPixel == 16)
                 SetColorSpace(PdfColorSpace::DeviceGray);
             else
-            {
-                TIFFClose(hInTiffHandle);
                 PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedImageFormat);
-            }
         }
         break;
 
@@ -465,28 +638,21 @@ void PdfImage::LoadFromTiffHandle(void* handle)
             else if (bitsPixel == 8 || bitsPixel == 16)
                 SetColorSpace(PdfColorSpace::DeviceGray);
             else
-            {
-                TIFFClose(hInTiffHandle);
                 PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedImageFormat);
-            }
         }
         break;
 
         case PHOTOMETRIC_RGB:
             if (bitsPixel != 24)
-            {
-                TIFFClose(hInTiffHandle);
                 PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedImageFormat);
-            }
+
             SetColorSpace(PdfColorSpace::DeviceRGB);
             break;
 
         case PHOTOMETRIC_SEPARATED:
             if (bitsPixel != 32)
-            {
-                TIFFClose(hInTiffHandle);
                 PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedImageFormat);
-            }
+
             SetColorSpace(PdfColorSpace::DeviceCMYK);
             break;
 
@@ -504,15 +670,14 @@ void PdfImage::LoadFromTiffHandle(void* handle)
             uint16* rgbBlue;
             TIFFGetField(hInTiffHandle, TIFFTAG_COLORMAP, &rgbRed, &rgbGreen, &rgbBlue);
 
-            char* datap = new char[numColors * 3];
-
+            charbuff colors(numColors * 3);
             for (unsigned clr = 0; clr < numColors; clr++)
             {
-                datap[3 * clr + 0] = rgbRed[clr] / 257;
-                datap[3 * clr + 1] = rgbGreen[clr] / 257;
-                datap[3 * clr + 2] = rgbBlue[clr] / 257;
+                colors[3 * clr + 0] = (char)(rgbRed[clr] / 257);
+                colors[3 * clr + 1] = (char)(rgbGreen[clr] / 257);
+                colors[3 * clr + 2] = (char)(rgbBlue[clr] / 257);
             }
-            SpanStreamDevice input((const char*)datap, numColors * 3);
+            SpanStreamDevice input(colors);
 
             // Create a colorspace object
             PdfObject* pIdxObject = this->GetDocument().GetObjects().CreateDictionaryObject();
@@ -525,38 +690,66 @@ void PdfImage::LoadFromTiffHandle(void* handle)
             array.Add(static_cast<int64_t>(numColors) - 1);
             array.Add(pIdxObject->GetIndirectReference());
             this->GetDictionary().AddKey(PdfName("ColorSpace"), array);
-
-            delete[] datap;
         }
         break;
 
         default:
-            TIFFClose(hInTiffHandle);
             PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedImageFormat);
             break;
     }
 
-    size_t scanlineSize = TIFFScanlineSize(hInTiffHandle);
-    size_t bufferSize = scanlineSize * height;
-    charbuff buffer(bufferSize);
-    for (row = 0; row < height; row++)
+    m_width = width;
+    m_height = height;
+    this->GetDictionary().AddKey("Width", static_cast<int64_t>(width));
+    this->GetDictionary().AddKey("Height", static_cast<int64_t>(height));
+    this->GetDictionary().AddKey("BitsPerComponent", static_cast<int64_t>(bitsPerSample));
+
+    // Decode the strips one at time, compressing them while they
+    // are appended, so only a strip is held in memory. With separate
+    // planes, just the strips of the first plane are read
+    if (rowsPerStrip == 0 || rowsPerStrip > height)
+        rowsPerStrip = height;
+
+    size_t scanlineSize = (size_t)TIFFScanlineSize(hInTiffHandle);
+    size_t stripSize = (size_t)TIFFStripSize(hInTiffHandle);
+    uint32 stripCount = (height + rowsPerStrip - 1) / rowsPerStrip;
+    charbuff strip(stripSize);
+    PdfFilterList filters;
+    filters.push_back(PdfFilterType::FlateDecode);
+    auto& stream = this->GetObject().GetOrCreateStream();
+    stream.BeginAppend(filters);
+    for (uint32 i = 0; i < stripCount; i++)
     {
-        if (TIFFReadScanline(hInTiffHandle,
-            &buffer[row * scanlineSize],
-            row) == (-1))
+        tmsize_t read = TIFFReadEncodedStrip(hInTiffHandle, i, strip.data(), (tmsize_t)stripSize);
+        if (read == -1)
         {
-            TIFFClose(hInTiffHandle);
+            stream.EndAppend();
             PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedImageFormat);
         }
+
+        // The last strip may have less rows
+        size_t rows = std::min(rowsPerStrip, height - i * rowsPerStrip);
+        stream.AppendBuffer(strip.data(), std::min((size_t)read, rows * scanlineSize));
     }
+    stream.EndAppend();
+}
+
+void PdfImage::loadTiffRawStrip(void* handle, unsigned width, unsigned height, unsigned bitsPerComponent)
+{
+    TIFF* hInTiffHandle = (TIFF*)handle;
+    tmsize_t size = TIFFRawStripSize(hInTiffHandle, 0);
+    if (size <= 0)
+        PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedImageFormat);
+
+    charbuff buffer((size_t)size);
+    if (TIFFReadRawStrip(hInTiffHandle, 0, buffer.data(), size) == -1)
+        PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedImageFormat);
 
     SpanStreamDevice input(buffer);
-    SetData(input, static_cast<unsigned>(width),
-        static_cast<unsigned>(height),
-        static_cast<unsigned>(bitsPerSample));
+    SetDataRaw(input, width, height, bitsPerComponent);
 }
 
-void PdfImage::LoadFromTiff(const string_view& filename)
+void* PdfImage::openTiff(const string_view& filename)
 {
     TIFFSetErrorHandler(TIFFErrorWarningHandler);
     TIFFSetWarningHandler(TIFFErrorWarningHandler);
@@ -568,12 +761,18 @@ void PdfImage::LoadFromTiff(const string_view& filename)
     auto filename16 = utf8::utf8to16((string)filename);
     TIFF* hInfile = TIFFOpenW((wchar_t*)filename16.c_str(), "rb");
 #else
-    TIFF* hInfile = TIFFOpen(filename.data(), "rb");
+    TIFF* hInfile = TIFFOpen(((string)filename).c_str(), "rb");
 #endif
 
     if (hInfile == nullptr)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::FileNotFound, filename);
 
+    return hInfile;
+}
+
+void PdfImage::LoadFromTiff(const string_view& filename)
+{
+    TIFF* hInfile = (TIFF*)openTiff(filename);
     try
     {
         LoadFromTiffHandle(hInfile);
@@ -709,13 +908,271 @@ void PdfImage::LoadFromTiffData(const unsigned char* data, size_t len)
     if (hInHandle == nullptr)
         PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
 
-    LoadFromTiffHandle(hInHandle);
+    try
+    {
+        LoadFromTiffHandle(hInHandle);
+    }
+    catch (...)
+    {
+        TIFFClose(hInHandle);
+        throw;
+    }
+
+    TIFFClose(hInHandle);
 }
 
 #endif // PDFMM_HAVE_TIFF_LIB
 
 #ifdef PDFMM_HAVE_PNG_LIB
 
+/** A sequential reader of the PNG chunks, used
+ *  to embed the image data without decoding it
+ */
+class PngSource
+{
+public:
+    virtual ~PngSource() { }
+
+    /** Read exactly the given size
+     *  \returns false if the data ended before
+     */
+    virtual bool TryRead(char* buffer, size_t size) = 0;
+
+    virtual bool TrySkip(size_t size) = 0;
+
+    /** Get a position to restart reading from
+     *  \returns false if the source can't be repositioned
+     */
+    virtual bool TryGetPosition(size_t& pos) = 0;
+
+    virtual void SetPosition(size_t pos) = 0;
+};
+
+class PngFileSource final : public PngSource
+{
+public:
+    PngFileSource(FILE* file) :
+        m_file(file) { }
+
+    bool TryRead(char* buffer, size_t size) override
+    {
+        return fread(buffer, 1, size, m_file) == size;
+    }
+
+    bool TrySkip(size_t size) override
+    {
+        return fseek(m_file, (long)size, SEEK_CUR) == 0;
+    }
+
+    bool TryGetPosition(size_t& pos) override
+    {
+        long curr = ftell(m_file);
+        if (curr < 0)
+            return false;
+
+        pos = (size_t)curr;
+        return true;
+    }
+
+    void SetPosition(size_t pos) override
+    {
+        if (fseek(m_file, (long)pos, SEEK_SET) != 0)
+            PDFMM_RAISE_ERROR(PdfErrorCode::InvalidDeviceOperation);
+    }
+
+private:
+    FILE* m_file;
+};
+
+struct PngData final : PngSource
+{
+    PngData(const unsigned char* data, png_size_t size) :
+        m_data(data), m_pos(0), m_size(size) {}
+
+    void read(png_bytep data, png_size_t length)
+    {
+        if (length > m_size - m_pos)
+        {
+            memcpy(data, &m_data[m_pos], m_size - m_pos);
+            m_pos = m_size;
+        }
+        else
+        {
+            memcpy(data, &m_data[m_pos], length);
+            m_pos += length;
+        }
+    }
+
+    bool TryRead(char* buffer, size_t size) override
+    {
+        if (size > m_size - m_pos)
+            return false;
+
+        memcpy(buffer, &m_data[m_pos], size);
+        m_pos += size;
+        return true;
+    }
+
+    bool TrySkip(size_t size) override
+    {
+        if (size > m_size - m_pos)
+            return false;
+
+        m_pos += size;
+        return true;
+    }
+
+    bool TryGetPosition(size_t& pos) override
+    {
+        pos = m_pos;
+        return true;
+    }
+
+    void SetPosition(size_t pos) override
+    {
+        m_pos = pos;
+    }
+
+private:
+    const unsigned char* m_data;
+    png_size_t m_pos;
+    png_size_t m_size;
+};
+
+/** An InputStream reading the zlib data of the consecutive IDAT chunks
+ */
+class PngImageDataInputStream final : public InputStream
+{
+public:
+    PngImageDataInputStream(PngSource& source, uint32_t firstChunkLength) :
+        m_source(&source),
+        m_remaining(firstChunkLength),
+        m_finished(false) { }
+
+protected:
+    size_t readBuffer(char* buffer, size_t size, bool& eof) override
+    {
+        size_t read = 0;
+        while (read < size && !m_finished)
+        {
+            if (m_remaining == 0)
+            {
+                // Skip the CRC and continue with the next chunk, if it's still image data
+                char header[8];
+                if (!m_source->TrySkip(4) || !m_source->TryRead(header, 8))
+                    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnexpectedEOF, "The PNG image data is truncated");
+
+                if (memcmp(header + 4, "IDAT", 4) != 0)
+                {
+                    m_finished = true;
+                    break;
+                }
+
+                utls::ReadUInt32BE(header, m_remaining);
+                continue;
+            }
+
+            size_t count = std::min(size - read, (size_t)m_remaining);
+            if (!m_source->TryRead(buffer + read, count))
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnexpectedEOF, "The PNG image data is truncated");
+
+            read += count;
+            m_remaining -= (uint32_t)count;
+        }
+
+        eof = m_finished;
+        return read;
+    }
+
+private:
+    PngSource* m_source;
+    uint32_t m_remaining;
+    bool m_finished;
+};
+
+/** An InputStream decoding the PNG image one row at time, or reading
+ *  the rows of an interlaced image decoded in advance. The alpha channel,
+ *  if any, is split and appended to the soft mask stream
+ */
+class PngImageInputStream final : public InputStream
+{
+public:
+    PngImageInputStream(png_structp png, int colorType, int depth, unsigned width, unsigned height,
+            size_t rowLen, const png_bytep* rows, png_bytep paletteTrans, int numTransColors,
+            PdfObjectStream* smask) :
+        m_png(png),
+        m_colorType(colorType),
+        m_depth(depth),
+        m_width(width),
+        m_height(height),
+        m_rowLen(rowLen),
+        m_rows(rows),
+        m_paletteTrans(paletteTrans),
+        m_numTransColors(numTransColors),
+        m_smask(smask),
+        m_rowIndex(0),
+        m_color(nullptr),
+        m_colorLen(0),
+        m_offset(0)
+    {
+        if (rows == nullptr)
+            m_row.resize(rowLen);
+
+        if (smask != nullptr)
+        {
+            m_alphaRow.resize(width);
+            if (colorType != PNG_COLOR_TYPE_PALETTE)
+                m_colorRow.resize(rowLen);
+        }
+    }
+
+protected:
+    size_t readBuffer(char* buffer, size_t size, bool& eof) override
+    {
+        size_t read = 0;
+        while (read < size)
+        {
+            if (m_offset == m_colorLen)
+            {
+                if (m_rowIndex == m_height)
+                    break;
+
+                nextRow();
+            }
+
+            size_t count = std::min(size - read, m_colorLen - m_offset);
+            memcpy(buffer + read, m_color + m_offset, count);
+            read += count;
+            m_offset += count;
+        }
+
+        eof = m_rowIndex == m_height && m_offset == m_colorLen;
+        return read;
+    }
+
+private:
+    void nextRow();
+
+private:
+    png_structp m_png;
+    int m_colorType;
+    int m_depth;
+    unsigned m_width;
+    unsigned m_height;
+    size_t m_rowLen;
+    const png_bytep* m_rows;
+    png_bytep m_paletteTrans;
+    int m_numTransColors;
+    PdfObjectStream* m_smask;
+    unsigned m_rowIndex;
+    charbuff m_row;
+    charbuff m_colorRow;
+    charbuff m_alphaRow;
+    const char* m_color;
+    size_t m_colorLen;
+    size_t m_offset;
+};
+
 void PdfImage::LoadFromPng(const std::string_view& filename)
 {
     FILE* file = utls::fopen(filename, "rb");
@@ -742,6 +1199,10 @@ void PdfImage::LoadFromPngHandle(FILE* stream)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedImageFormat, "The file could not be recognized as a PNG file");
     }
 
+    PngFileSource source(stream);
+    if (tryLoadFromPngImageData(*this, source))
+        return;
+
     png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
     if (png == nullptr)
         PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
@@ -763,31 +1224,6 @@ void PdfImage::LoadFromPngHandle(FILE* stream)
     LoadFromPngContent(*this, png, info);
 }
 
-struct PngData
-{
-    PngData(const unsigned char* data, png_size_t size) :
-        m_data(data), m_pos(0), m_size(size) {}
-
-    void read(png_bytep data, png_size_t length)
-    {
-        if (length > m_size - m_pos)
-        {
-            memcpy(data, &m_data[m_pos], m_size - m_pos);
-            m_pos = m_size;
-        }
-        else
-        {
-            memcpy(data, &m_data[m_pos], length);
-            m_pos += length;
-        }
-    }
-
-private:
-    const unsigned char* m_data;
-    png_size_t m_pos;
-    png_size_t m_size;
-};
-
 void PdfImage::LoadFromPngData(const unsigned char* data, size_t len)
 {
     if (data == nullptr)
@@ -801,6 +1237,9 @@ void PdfImage::LoadFromPngData(const unsigned char* data, size_t len)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedImageFormat, "The file could not be recognized as a PNG file");
     }
 
+    if (tryLoadFromPngImageData(*this, pngData))
+        return;
+
     png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
     if (png == nullptr)
         PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
@@ -822,6 +1261,85 @@ void PdfImage::LoadFromPngData(const unsigned char* data, size_t len)
     LoadFromPngContent(*this, png, info);
 }
 
+bool tryLoadFromPngImageData(PdfImage& image, PngSource& source)
+{
+    // Non interlaced 8 bit RGB and gray images without transparency
+    // can be embedded as they are: the PNG image data is a zlib
+    // stream of the rows, each preceded by its PNG predictor
+    size_t start;
+    if (!source.TryGetPosition(start))
+        return false;
+
+    unsigned width;
+    unsigned height;
+    int colorType;
+    uint32_t length;
+    if (!tryFindPngImageData(source, width, height, colorType, length))
+    {
+        source.SetPosition(start);
+        return false;
+    }
+
+    unsigned colors = colorType == PNG_COLOR_TYPE_RGB ? 3 : 1;
+    PdfDictionary decodeParms;
+    decodeParms.AddKey("Predictor", static_cast<int64_t>(15));
+    decodeParms.AddKey("Colors", static_cast<int64_t>(colors));
+    decodeParms.AddKey("BitsPerComponent", static_cast<int64_t>(8));
+    decodeParms.AddKey("Columns", static_cast<int64_t>(width));
+    image.SetColorSpace(colors == 3 ? PdfColorSpace::DeviceRGB : PdfColorSpace::DeviceGray);
+    image.GetDictionary().AddKey(PdfName::KeyFilter, PdfName("FlateDecode"));
+    image.GetDictionary().AddKey("DecodeParms", decodeParms);
+
+    PngImageDataInputStream input(source, length);
+    image.SetDataRaw(input, width, height, 8);
+    return true;
+}
+
+bool tryFindPngImageData(PngSource& source, unsigned& width, unsigned& height, int& colorType, uint32_t& length)
+{
+    char header[8];
+    char ihdr[13];
+    if (!source.TryRead(header, 8))
+        return false;
+
+    utls::ReadUInt32BE(header, length);
+    if (length != 13 || memcmp(header + 4, "IHDR", 4) != 0
+        || !source.TryRead(ihdr, 13) || !source.TrySkip(4))
+    {
+        return false;
+    }
+
+    uint32_t value;
+    utls::ReadUInt32BE(ihdr, value);
+    width = value;
+    utls::ReadUInt32BE(ihdr + 4, value);
+    height = value;
+    colorType = (unsigned char)ihdr[9];
+    if (ihdr[8] != 8 || (colorType != PNG_COLOR_TYPE_RGB && colorType != PNG_COLOR_TYPE_GRAY)
+        || ihdr[10] != 0 || ihdr[11] != 0 || ihdr[12] != PNG_INTERLACE_NONE)
+    {
+        return false;
+    }
+
+    while (true)
+    {
+        if (!source.TryRead(header, 8))
+            return false;
+
+        utls::ReadUInt32BE(header, length);
+        if (memcmp(header + 4, "IDAT", 4) == 0)
+            return true;
+
+        // The transparency requires a soft mask
+        if (memcmp(header + 4, "tRNS", 4) == 0
+            || memcmp(header + 4, "IEND", 4) == 0
+            || !source.TrySkip((size_t)length + 4))
+        {
+            return false;
+        }
+    }
+}
+
 void LoadFromPngContent(PdfImage& image, png_structp png, png_infop info)
 {
     png_set_sig_bytes(png, 8);
@@ -872,96 +1390,30 @@ void LoadFromPngContent(PdfImage& image, png_structp png, png_infop info)
         &color_type, &interlace, NULL, NULL);
     // End
 
-    // Read the file
-    if (setjmp(png_jmpbuf(png)) != 0)
-    {
-        png_destroy_read_struct(&png, &info, (png_infopp)NULL);
-        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
-    }
+    png_bytep paletteTrans = nullptr;
+    int numTransColors = 0;
+    bool hasAlpha = (color_type & PNG_COLOR_MASK_ALPHA) != 0
+        || (color_type == PNG_COLOR_TYPE_PALETTE
+            && png_get_valid(png, info, PNG_INFO_tRNS)
+            && png_get_tRNS(png, info, &paletteTrans, &numTransColors, NULL));
 
+    // The passes of interlaced images need the whole
+    // image, the others are decoded one row at time
     size_t rowLen = png_get_rowbytes(png, info);
-    size_t len = rowLen * height;
-    charbuff buffer(len);
-
-    unique_ptr<png_bytep[]> rows(new png_bytep[height]);
-    for (unsigned int y = 0; y < height; y++)
+    charbuff buffer;
+    unique_ptr<png_bytep[]> rows;
+    if (interlace != PNG_INTERLACE_NONE)
     {
-        rows[y] = reinterpret_cast<png_bytep>(buffer.data() + y * rowLen);
-    }
-
-    png_read_image(png, rows.get());
+        buffer.resize(rowLen * height);
+        rows.reset(new png_bytep[height]);
+        for (unsigned int y = 0; y < height; y++)
+            rows[y] = reinterpret_cast<png_bytep>(buffer.data() + y * rowLen);
 
-    png_bytep paletteTrans;
-    int numTransColors;
-    if (color_type & PNG_COLOR_MASK_ALPHA
-        || (color_type == PNG_COLOR_TYPE_PALETTE
-            && png_get_valid(png, info, PNG_INFO_tRNS)
-            && png_get_tRNS(png, info, &paletteTrans, &numTransColors, NULL)))
-    {
-        // Handle alpha channel and create smask
-        charbuff smask(width * height);
-        png_uint_32 smaskIndex = 0;
-        if (color_type == PNG_COLOR_TYPE_PALETTE)
+        if (!tryReadPngImage(png, rows.get()))
         {
-            for (png_uint_32 r = 0; r < height; r++)
-            {
-                png_bytep row = rows[r];
-                for (png_uint_32 c = 0; c < width; c++)
-                {
-                    png_byte color;
-                    switch (depth)
-                    {
-                        case 8:
-                            color = row[c];
-                            break;
-                        case 4:
-                            color = c % 2 ? row[c / 2] >> 4 : row[c / 2] & 0xF;
-                            break;
-                        case 2:
-                            color = (row[c / 4] >> c % 4 * 2) & 3;
-                            break;
-                        case 1:
-                            color = (row[c / 4] >> c % 8) & 1;
-                            break;
-                        default:
-                            PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
-                    }
-
-                    smask[smaskIndex++] = color < numTransColors ? paletteTrans[color] : 0xFF;
-                }
-            }
+            png_destroy_read_struct(&png, &info, (png_infopp)NULL);
+            PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
         }
-        else if (color_type == PNG_COLOR_TYPE_RGB_ALPHA)
-        {
-            for (png_uint_32 r = 0; r < height; r++)
-            {
-                png_bytep row = rows[r];
-                for (png_uint_32 c = 0; c < width; c++)
-                {
-                    memmove(buffer.data() + 3 * smaskIndex, row + 4 * c, 3); // 3 byte for rgb
-                    smask[smaskIndex++] = row[c * 4 + 3]; // 4th byte for alpha
-                }
-            }
-            len = 3 * width * height;
-        }
-        else if (color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
-        {
-            for (png_uint_32 r = 0; r < height; r++)
-            {
-                png_bytep row = rows[r];
-                for (png_uint_32 c = 0; c < width; c++)
-                {
-                    buffer[smaskIndex] = row[c * 2]; // 1 byte for gray
-                    smask[smaskIndex++] = row[c * 2 + 1]; // 2nd byte for alpha
-                }
-            }
-            len = width * height;
-        }
-        SpanStreamDevice smaskinput(smask);
-        PdfImage smakeImage(image.GetDocument());
-        smakeImage.SetColorSpace(PdfColorSpace::DeviceGray);
-        smakeImage.SetData(smaskinput, width, height, 8);
-        image.SetSoftmask(smakeImage);
     }
 
     // Set color space
@@ -971,14 +1423,14 @@ void LoadFromPngContent(PdfImage& image, png_structp png, png_infop info)
         int colorCount;
         png_get_PLTE(png, info, &colors, &colorCount);
 
-        char* data = new char[colorCount * 3];
+        charbuff data(colorCount * 3);
         for (int i = 0; i < colorCount; i++, colors++)
         {
             data[3 * i + 0] = colors->red;
             data[3 * i + 1] = colors->green;
             data[3 * i + 2] = colors->blue;
         }
-        SpanStreamDevice input((const char*)data, (size_t)(colorCount * 3));
+        SpanStreamDevice input(data);
         PdfObject* pIdxObject = image.GetDocument().GetObjects().CreateDictionaryObject();
         pIdxObject->GetOrCreateStream().Set(input);
 
@@ -997,13 +1449,149 @@ void LoadFromPngContent(PdfImage& image, png_structp png, png_infop info)
         image.SetColorSpace(PdfColorSpace::DeviceRGB);
     }
 
+    // Handle alpha channel and create smask, appending
+    // to it while the image data is being compressed
+    unique_ptr<PdfImage> smask;
+    PdfObjectStream* smaskStream = nullptr;
+    if (hasAlpha)
+    {
+        smask.reset(new PdfImage(image.GetDocument()));
+        smask->SetColorSpace(PdfColorSpace::DeviceGray);
+        smask->GetDictionary().AddKey("Width", static_cast<int64_t>(width));
+        smask->GetDictionary().AddKey("Height", static_cast<int64_t>(height));
+        smask->GetDictionary().AddKey("BitsPerComponent", static_cast<int64_t>(8));
+        smaskStream = &smask->GetObject().GetOrCreateStream();
+        smaskStream->BeginAppend();
+    }
+
     // Set the image data and flate compress it
-    SpanStreamDevice input(buffer);
-    image.SetData(input, width, height, depth);
+    PngImageInputStream input(png, color_type, depth, width, height, rowLen,
+        rows.get(), paletteTrans, numTransColors, smaskStream);
+    try
+    {
+        image.SetData(input, width, height, depth);
+        if (smaskStream != nullptr)
+            smaskStream->EndAppend();
+    }
+    catch (...)
+    {
+        png_destroy_read_struct(&png, &info, (png_infopp)NULL);
+        throw;
+    }
+
+    if (smask != nullptr)
+        image.SetSoftmask(*smask);
 
     png_destroy_read_struct(&png, &info, (png_infopp)NULL);
 }
 
+void PngImageInputStream::nextRow()
+{
+    png_bytep row;
+    if (m_rows == nullptr)
+    {
+        row = reinterpret_cast<png_bytep>(m_row.data());
+        if (!tryReadPngRow(m_png, row))
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The PNG image data could not be decoded");
+    }
+    else
+    {
+        row = m_rows[m_rowIndex];
+    }
+
+    m_rowIndex++;
+    m_offset = 0;
+    if (m_smask == nullptr)
+    {
+        m_color = reinterpret_cast<const char*>(row);
+        m_colorLen = m_rowLen;
+        return;
+    }
+
+    switch (m_colorType)
+    {
+        case PNG_COLOR_TYPE_PALETTE:
+        {
+            // The samples are packed starting from the high-order bits
+            for (unsigned c = 0; c < m_width; c++)
+            {
+                png_byte color;
+                switch (m_depth)
+                {
+                    case 8:
+                        color = row[c];
+                        break;
+                    case 4:
+                        color = (row[c / 2] >> (c % 2 == 0 ? 4 : 0)) & 0xF;
+                        break;
+                    case 2:
+                        color = (row[c / 4] >> (6 - c % 4 * 2)) & 3;
+                        break;
+                    case 1:
+                        color = (row[c / 8] >> (7 - c % 8)) & 1;
+                        break;
+                    default:
+                        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
+                }
+
+                m_alphaRow[c] = color < m_numTransColors ? m_paletteTrans[color] : 0xFF;
+            }
+
+            m_color = reinterpret_cast<const char*>(row);
+            m_colorLen = m_rowLen;
+            break;
+        }
+        case PNG_COLOR_TYPE_RGB_ALPHA:
+        {
+            for (unsigned c = 0; c < m_width; c++)
+            {
+                memcpy(m_colorRow.data() + 3 * c, row + 4 * c, 3); // 3 byte for rgb
+                m_alphaRow[c] = row[c * 4 + 3]; // 4th byte for alpha
+            }
+
+            m_color = m_colorRow.data();
+            m_colorLen = 3 * (size_t)m_width;
+            break;
+        }
+        case PNG_COLOR_TYPE_GRAY_ALPHA:
+        {
+            for (unsigned c = 0; c < m_width; c++)
+            {
+                m_colorRow[c] = row[c * 2]; // 1 byte for gray
+                m_alphaRow[c] = row[c * 2 + 1]; // 2nd byte for alpha
+            }
+
+            m_color = m_colorRow.data();
+            m_colorLen = m_width;
+            break;
+        }
+        default:
+            PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
+    }
+
+    m_smask->AppendBuffer(m_alphaRow.data(), m_width);
+}
+
+bool tryReadPngRow(png_structp png, png_bytep row)
+{
+    // The libpng errors jump back here, where there
+    // are no objects that would not be destroyed
+    if (setjmp(png_jmpbuf(png)))
+        return false;
+
+    png_read_row(png, row, nullptr);
+    return true;
+}
+
+bool tryReadPngImage(png_structp png, png_bytepp rows)
+{
+    if (setjmp(png_jmpbuf(png)))
+        return false;
+
+    png_read_image(png, rows);
+    return true;
+}
+
 void pngReadData(png_structp pngPtr, png_bytep data, png_size_t length)
 {
     PngData* a = (PngData*)png_get_io_ptr(pngPtr);
@@ -1049,3 +1637,34 @@ unsigned PdfImage::GetHeight() const
 {
     return m_height;
 }
+
+// Fill the alpha of the pixels with the soft mask, sampling
+// the nearest alpha if the mask has a different size
+void decodeSoftMask(const PdfObject& smask, char* buffer, unsigned width, unsigned height,
+    size_t stride, unsigned alphaOffset)
+{
+    auto& dict = smask.GetDictionary();
+    unsigned maskWidth = (unsigned)dict.MustFindKey("Width").GetNumber();
+    unsigned maskHeight = (unsigned)dict.MustFindKey("Height").GetNumber();
+    if (maskWidth == width && maskHeight == height)
+    {
+        // Decode the mask straight into the alpha
+        ImageDecodeStream decoder(smask, PdfPixelFormat::Gray, buffer, stride);
+        decoder.SetComponentTarget(4, alphaOffset);
+        smask.MustGetStream().ExtractTo(decoder);
+        decoder.Finish();
+        return;
+    }
+
+    charbuff mask((size_t)maskWidth * maskHeight);
+    ImageDecodeStream decoder(smask, PdfPixelFormat::Gray, mask.data(), maskWidth);
+    smask.MustGetStream().ExtractTo(decoder);
+    decoder.Finish();
+    for (unsigned y = 0; y < height; y++)
+    {
+        const char* maskRow = mask.data() + (size_t)((uint64_t)y * maskHeight / height) * maskWidth;
+        char* row = buffer + stride * y;
+        for (unsigned x = 0; x < width; x++)
+            row[(size_t)x * 4 + alphaOffset] = maskRow[(uint64_t)x * maskWidth / width];
+    }
+}
@@ -24,6 +24,53 @@ class InputStream;
 class PdfObject;
 class PdfIndirectObjectList;
 
+/** Options to decode the JPEG data of an image
+ */
+struct PDFMM_API PdfJpegDecodeOptions
+{
+    ///< Scale the image down by 1, 2, 4 or 8, in the DCT domain,
+    ///< which saves most of the decoding work
+    unsigned ScaleDenominator = 1;
+
+    ///< The region to decode, in pixels of the scaled image.
+    ///< The region width and height extend to the image
+    ///< edges when zero
+    unsigned RegionX = 0;
+    unsigned RegionY = 0;
+    unsigned RegionWidth = 0;
+    unsigned RegionHeight = 0;
+};
+
+/** Resampling used to scale the image data down
+ */
+enum class PdfImageResampling
+{
+    Box,        ///< Average of the covered source pixels
+    Bilinear,   ///< Interpolation of the nearest source pixels
+};
+
+/** Conversions applied to the pixels of an image while its data is set
+ */
+struct PDFMM_API PdfImageConversion
+{
+    ///< The size of the stored image, not larger than the source
+    ///< image. Zero keeps the source size
+    unsigned Width = 0;
+    unsigned Height = 0;
+    PdfImageResampling Resampling = PdfImageResampling::Box;
+
+    ///< The color space of the stored image, DeviceGray, DeviceRGB
+    ///< or DeviceCMYK. Unknown keeps the one of the pixel format
+    PdfColorSpace ColorSpace = PdfColorSpace::Unknown;
+
+    ///< Store the alpha of the ARGB and BGRA pixels as a soft mask
+    bool ExtractAlpha = true;
+
+    ///< Multiply the color components by the alpha, setting
+    ///< a zero matte in the soft mask
+    bool PremultiplyAlpha = false;
+};
+
 /** A PdfImage object is needed when ever you want to embedd an image
  *  file into a PDF document.
  *  The PdfImage object is embedded once and can be drawn as often
@@ -37,6 +84,8 @@ class PdfIndirectObjectList;
 class PDFMM_API PdfImage final : public PdfXObject
 {
     friend class PdfXObject;
+    friend class PdfImageManager;
+    friend class PdfDocument;
 
 public:
     /** Constuct a new PdfImage object
@@ -124,6 +173,21 @@ public:
     void SetData(InputStream& stream, unsigned width, unsigned height,
                       unsigned bitsPerComponent, PdfFilterList& filters);
 
+    /** Set the image data from rows of pixels, converting them on the way
+     *
+     *  The pixels are read and converted in bands of rows, so the
+     *  whole source image is never held in memory. The color space
+     *  is set accordingly and the data is flate compressed
+     *
+     *  \param stream stream supplying the rows of pixels
+     *  \param width width of the source image in pixels
+     *  \param height height of the source image in pixels
+     *  \param format the layout of the pixels
+     *  \param conversion the scaling and the color conversion to apply
+     */
+    void SetData(InputStream& stream, unsigned width, unsigned height,
+        PdfPixelFormat format, const PdfImageConversion& conversion = { });
+
     /** Set the actual image data from an input stream.
      *  The data has to be encoded already and an appropriate
      *  filters key entry has to be set manually before!
@@ -137,6 +201,41 @@ public:
     void SetDataRaw(InputStream& stream, unsigned width, unsigned height,
         unsigned bitsPerComponent);
 
+    /** Set bilevel image data, encoded with CCITT Group 4
+     *
+     *  The color space is set to DeviceGray with 1 bit per component
+     *
+     *  \param data rows of packed 1 bit pixels, starting at byte boundaries,
+     *      where 0 is black and 1 is white
+     *  \param width width of the image in pixels
+     *  \param height height of the image in pixels
+     */
+    void SetDataCCITT(const bufferview& data, unsigned width, unsigned height);
+
+    /** Decode the image data to rows of pixels
+     *
+     *  The data is decoded by the filters and converted while it's
+     *  streamed, straight into the buffer. The /Decode array, the
+     *  components of 1, 2, 4, 8 or 16 bits, the indexed palettes and
+     *  the stencil masks are handled, and the /SMask fills the alpha of
+     *  the ARGB and BGRA pixels, which are opaque otherwise. The image
+     *  color space must be a device one, CalGray, CalRGB, ICCBased or
+     *  Indexed on them, approximated with the device color spaces
+     *  \param buffer receives the rows of pixels
+     *  \param format the layout of the pixels
+     *  \param stride the length in bytes of the rows in the buffer,
+     *      or 0 for rows with no padding
+     */
+    void DecodeTo(charbuff& buffer, PdfPixelFormat format, unsigned stride = 0) const;
+
+    /** Decode the image data to rows of pixels in a buffer of the caller
+     *
+     *  \param buffer the buffer receiving the rows of pixels, large
+     *      enough for the rows with the given stride
+     *  \see DecodeTo(charbuff&, PdfPixelFormat, unsigned)
+     */
+    void DecodeTo(const mspan<char>& buffer, PdfPixelFormat format, unsigned stride = 0) const;
+
     /** Load the image data from a file
      *  \param filename
      */
@@ -155,11 +254,27 @@ public:
     void LoadFromJpeg(const std::string_view& filename);
 
     /** Load the image data from JPEG bytes
+     *
+     *  The data is embedded as it is, with the DCTDecode filter:
+     *  only the markers before the first scan are parsed
      *  \param data JPEG bytes
      *  \param len number of bytes
      */
     void LoadFromJpegData(const unsigned char* data, size_t len);
 
+    /** Decode the JPEG data of the image, optionally scaled down and
+     *  only in a region, e.g. to make thumbnails
+     *
+     *  The image must be encoded with DCTDecode as its last filter
+     *  \param buffer receives the rows of the decoded pixels, with
+     *      the components of the JPEG data for every pixel
+     *  \param width receives the width of the decoded region
+     *  \param height receives the height of the decoded region
+     *  \param options the scaling and the region to decode
+     */
+    void DecodeJpegTo(charbuff& buffer, unsigned& width, unsigned& height,
+        const PdfJpegDecodeOptions& options = { }) const;
+
 #endif // PDFMM_HAVE_JPEG_LIB
 #ifdef PDFMM_HAVE_TIFF_LIB
     /** Load the image data from a TIFF file
@@ -221,11 +336,18 @@ private:
      */
     static PdfName ColorspaceToName(PdfColorSpace colorSpace);
 
-#ifdef PDFMM_HAVE_JPEG_LIB
-    void LoadFromJpegHandle(FILE* stream, const std::string_view& filename);
-#endif // PDFMM_HAVE_JPEG_LIB
 #ifdef PDFMM_HAVE_TIFF_LIB
+    /** Load the current directory of the TIFF handle, that
+     *  is not closed, also when an error is raised
+     */
     void LoadFromTiffHandle(void* handle);
+
+    void loadTiffRawStrip(void* handle, unsigned width, unsigned height, unsigned bitsPerComponent);
+
+    /** Open a TIFF file, raising if it can't be opened
+     *  \returns the TIFF handle, to be closed by the caller
+     */
+    static void* openTiff(const std::string_view& filename);
 #endif // PDFMM_HAVE_TIFF_LIB
 #ifdef PDFMM_HAVE_PNG_LIB
     void LoadFromPngHandle(FILE* stream);
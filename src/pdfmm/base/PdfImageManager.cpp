@@ -0,0 +1,123 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfImageManager.h"
+
+#include "PdfDictionary.h"
+#include "PdfDocument.h"
+#include "PdfImage.h"
+#include "PdfObjectStream.h"
+#include "PdfStreamDevice.h"
+
+using namespace std;
+using namespace mm;
+
+static uint64_t computeChecksum(const bufferview& data);
+
+PdfImageManager::PdfImageManager(PdfDocument& doc)
+    : m_doc(&doc) { }
+
+PdfImageManager::~PdfImageManager() { }
+
+PdfImage& PdfImageManager::GetImage(const string_view& filename)
+{
+    MappedFileStreamDevice device(filename);
+    bufferview view;
+    if (device.TryGetView(view))
+        return GetImageFromData(view);
+
+    charbuff buffer;
+    BufferStreamDevice output(buffer);
+    device.CopyTo(output);
+    return GetImageFromData(buffer);
+}
+
+PdfImage& PdfImageManager::GetImageFromData(const bufferview& data)
+{
+    size_t hash;
+    uint64_t checksum;
+    auto entry = findEntry(m_images, data, 0, hash, checksum);
+    if (entry != nullptr)
+        return *entry->Image;
+
+    unique_ptr<PdfImage> image(new PdfImage(*m_doc));
+    image->LoadFromData((const unsigned char*)data.data(), data.size());
+    auto& ret = *image;
+    m_images[hash].push_back({ checksum, data.size(), 0,
+        image->GetObject().GetIndirectReference(), std::move(image) });
+    return ret;
+}
+
+void PdfImageManager::Clear()
+{
+    m_images.clear();
+    m_iccProfiles.clear();
+}
+
+PdfObject& PdfImageManager::getICCProfile(const bufferview& data, unsigned colorComponents,
+    PdfColorSpace alternateColorSpace)
+{
+    unsigned params = colorComponents << 8 | (unsigned)alternateColorSpace;
+    size_t hash;
+    uint64_t checksum;
+    auto entry = findEntry(m_iccProfiles, data, params, hash, checksum);
+    if (entry != nullptr)
+        return m_doc->GetObjects().MustGetObject(entry->Reference);
+
+    auto iccObject = m_doc->GetObjects().CreateDictionaryObject();
+    iccObject->GetDictionary().AddKey("Alternate", PdfImage::ColorspaceToName(alternateColorSpace));
+    iccObject->GetDictionary().AddKey("N", static_cast<int64_t>(colorComponents));
+    iccObject->GetOrCreateStream().Set(data);
+    m_iccProfiles[hash].push_back({ checksum, data.size(), params,
+        iccObject->GetIndirectReference(), nullptr });
+    return *iccObject;
+}
+
+PdfImageManager::Entry* PdfImageManager::findEntry(EntryMap& entries, const bufferview& data,
+    unsigned params, size_t& hash, uint64_t& checksum)
+{
+    // The data is matched by two independent hashes and its size, so
+    // the candidates don't need to be decoded again to compare them
+    hash = std::hash<string_view>()(string_view(data.data(), data.size()));
+    checksum = computeChecksum(data);
+    auto found = entries.find(hash);
+    if (found == entries.end())
+        return nullptr;
+
+    auto& candidates = found->second;
+    for (auto it = candidates.begin(); it != candidates.end(); it++)
+    {
+        if (it->Checksum != checksum || it->Size != data.size() || it->Params != params)
+            continue;
+
+        // The object may have been removed from the document
+        auto obj = m_doc->GetObjects().GetObject(it->Reference);
+        if (obj == nullptr || (it->Image != nullptr && obj != &it->Image->GetObject()))
+        {
+            candidates.erase(it);
+            return nullptr;
+        }
+
+        return &*it;
+    }
+
+    return nullptr;
+}
+
+// 64 bit FNV-1a
+uint64_t computeChecksum(const bufferview& data)
+{
+    uint64_t ret = 14695981039346656037ULL;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        ret ^= (unsigned char)data[i];
+        ret *= 1099511628211ULL;
+    }
+
+    return ret;
+}
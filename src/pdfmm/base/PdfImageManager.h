@@ -0,0 +1,96 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_IMAGE_MANAGER_H
+#define PDF_IMAGE_MANAGER_H
+
+#include "PdfDeclarations.h"
+
+#include <unordered_map>
+
+#include "PdfReference.h"
+
+namespace mm {
+
+class PdfDocument;
+class PdfImage;
+class PdfObject;
+
+/**
+ * This class assists PdfDocument with sharing the images
+ * and the ICC profiles loaded in the document
+ *
+ * The loaded data is matched by content, so the same image
+ * loaded more times, e.g. a logo drawn on every page, is
+ * written only once, and the images using identical ICC
+ * profiles reference the same colorspace stream
+ *
+ * \see PdfDocument::GetImageManager
+ */
+class PDFMM_API PdfImageManager final
+{
+    friend class PdfDocument;
+    friend class PdfImage;
+
+    PdfImageManager(const PdfImageManager&) = delete;
+    PdfImageManager& operator=(const PdfImageManager&) = delete;
+
+public:
+    ~PdfImageManager();
+
+    /** Get the image loaded from the given file. If an image
+     *  with the same data was already loaded, it's returned
+     *  instead of creating a new one
+     *  \see PdfImage::LoadFromFile
+     */
+    PdfImage& GetImage(const std::string_view& filename);
+
+    /** Get the image loaded from the given data. If an image
+     *  with the same data was already loaded, it's returned
+     *  instead of creating a new one
+     *  \see PdfImage::LoadFromData
+     */
+    PdfImage& GetImageFromData(const bufferview& data);
+
+    /** Empty the cache, the images already created are not removed
+     *  from the document
+     */
+    void Clear();
+
+private:
+    PdfImageManager(PdfDocument& doc);
+
+    /** Get the ICC profile stream with the given data and parameters,
+     *  creating it if it doesn't exist yet
+     */
+    PdfObject& getICCProfile(const bufferview& data, unsigned colorComponents,
+        PdfColorSpace alternateColorSpace);
+
+private:
+    struct Entry
+    {
+        uint64_t Checksum;
+        size_t Size;
+        unsigned Params;
+        PdfReference Reference;
+        std::unique_ptr<PdfImage> Image;
+    };
+
+    using EntryMap = std::unordered_map<size_t, std::vector<Entry>>;
+
+private:
+    Entry* findEntry(EntryMap& entries, const bufferview& data, unsigned params, size_t& hash, uint64_t& checksum);
+
+private:
+    PdfDocument* m_doc;
+    EntryMap m_images;
+    EntryMap m_iccProfiles;
+};
+
+};
+
+#endif // PDF_IMAGE_MANAGER_H
@@ -8,21 +8,166 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfImmediateWriter.h"
 
+#include <future>
+
+#include "PdfEncrypt.h"
+#include "PdfExecutor.h"
 #include "PdfFileObjectStream.h"
+#include "PdfFilter.h"
 #include "PdfMemoryObjectStream.h"
 #include "PdfObject.h"
+#include "PdfStreamDevice.h"
 #include "PdfXRef.h"
 #include "PdfXRefStream.h"
 
+using namespace std;
 using namespace mm;
 
+// A stream whose data is compressed on the executor of the
+// document once the append is ended. The compressed data is
+// held in memory until the object is written
+class PdfImmediateWriter::CompressedObjectStream final : public PdfObjectStream
+{
+public:
+    CompressedObjectStream(PdfObject& parent, const shared_ptr<PdfExecutor>& executor)
+        : PdfObjectStream(parent), m_executor(executor), m_job(std::make_shared<Job>()), m_queued(false) { }
+
+    ~CompressedObjectStream()
+    {
+        EnsureAppendClosed();
+
+        // The job may still access the buffers, which are shared with it,
+        // but the exceptions must not escape the destructor
+        if (m_future.valid())
+            m_future.wait();
+    }
+
+    void Write(OutputStream& stream, const PdfStatefulEncrypt& encrypt) override
+    {
+        wait();
+        stream.Write("stream\n");
+        if (encrypt.HasEncrypt())
+        {
+            auto output = encrypt.CreateEncryptionOutputStream(stream);
+            output->Write(m_job->Encoded);
+            output->Flush();
+        }
+        else
+        {
+            stream.Write(m_job->Encoded);
+        }
+
+        stream.Write("\nendstream\n");
+        stream.Flush();
+    }
+
+    void CopyTo(OutputStream& stream) const override
+    {
+        wait();
+        stream.Write(m_job->Encoded);
+    }
+
+    size_t GetLength() const override
+    {
+        wait();
+        return m_job->Encoded.size();
+    }
+
+    // Mark the stream as waiting to be written.
+    // \returns false if it was waiting already
+    bool TryQueue()
+    {
+        if (m_queued)
+            return false;
+
+        m_queued = true;
+        return true;
+    }
+
+    PdfObject& GetObject() { return GetParent(); }
+
+    bool IsCompressed() const
+    {
+        return !m_future.valid()
+            || m_future.wait_for(chrono::seconds(0)) == future_status::ready;
+    }
+
+protected:
+    unique_ptr<InputStream> GetInputStream() const override
+    {
+        wait();
+        return unique_ptr<InputStream>(new SpanStreamDevice(m_job->Encoded));
+    }
+
+    void BeginAppendImpl(const PdfFilterList& filters) override
+    {
+        // The previous data may be still compressed
+        wait();
+        m_job = std::make_shared<Job>();
+        m_job->Filters = filters;
+        m_job->CompressionLevel = GetEffectiveCompressionLevel();
+        m_Stream.reset(new BufferStreamDevice(m_job->Raw));
+    }
+
+    void AppendImpl(const char* data, size_t len) override
+    {
+        m_Stream->Write(data, len);
+    }
+
+    void EndAppendImpl() override
+    {
+        m_Stream->Flush();
+        m_Stream = nullptr;
+        if (m_job->Filters.size() == 0)
+        {
+            m_job->Encoded = std::move(m_job->Raw);
+            return;
+        }
+
+        auto job = m_job;
+        m_future = m_executor->RunAsync([job]()
+        {
+            BufferStreamDevice device(job->Encoded);
+            auto stream = PdfFilterFactory::CreateEncodeStream(job->Filters, device, job->CompressionLevel);
+            stream->Write(job->Raw);
+            stream->Flush();
+            job->Raw = charbuff();
+        });
+    }
+
+private:
+    // Wait for the compression, rethrowing its exception
+    void wait() const
+    {
+        if (m_future.valid())
+            m_future.get();
+    }
+
+private:
+    struct Job
+    {
+        PdfFilterList Filters;
+        PdfCompressionLevel CompressionLevel = PdfCompressionLevel::Default;
+        charbuff Raw;
+        charbuff Encoded;
+    };
+
+    shared_ptr<PdfExecutor> m_executor;
+    shared_ptr<Job> m_job;
+    mutable future<void> m_future;
+    unique_ptr<OutputStream> m_Stream;
+    bool m_queued;
+};
+
 PdfImmediateWriter::PdfImmediateWriter(PdfIndirectObjectList& objects, const PdfObject& trailer,
     OutputStreamDevice& device, PdfVersion version, PdfEncrypt* encrypt, PdfSaveOptions opts) :
     PdfWriter(objects, trailer),
     m_attached(true),
     m_Device(&device),
     m_Last(nullptr),
-    m_OpenStream(false)
+    m_OpenStream(false),
+    m_memoryStreams(false),
+    m_maxStreamsInFlight(0)
 {
     // register as observer for PdfIndirectObjectList
     GetObjects().Attach(this);
@@ -36,13 +181,18 @@ PdfImmediateWriter::PdfImmediateWriter(PdfIndirectObjectList& objects, const Pdf
     // setup encryption
     if (encrypt != nullptr)
     {
+        // NOTE: The key is generated on the copy owned by the writer
         this->SetEncrypted(*encrypt);
-        encrypt->GenerateEncryptionKey(GetIdentifier());
+        GetEncrypt()->GenerateEncryptionKey(GetIdentifier());
     }
 
     // start with writing the header
     this->SetPdfVersion(version);
     this->SetSaveOptions(opts);
+    // Object streams require a XRef stream
+    if ((opts & PdfSaveOptions::CompressObjects) != PdfSaveOptions::None)
+        this->SetUseXRefStream(true);
+
     this->WritePdfHeader(*m_Device);
 
     m_xRef.reset(GetUseXRefStream() ? new PdfXRefStream(*this) : new PdfXRef(*this));
@@ -64,6 +214,12 @@ PdfVersion PdfImmediateWriter::GetPdfVersion() const
     return PdfWriter::GetPdfVersion();
 }
 
+void PdfImmediateWriter::SetMaxStreamsInFlight(unsigned count)
+{
+    m_maxStreamsInFlight = count;
+    writeCompressedStreams(false);
+}
+
 void PdfImmediateWriter::WriteObject(const PdfObject& obj)
 {
     const int endObjLenght = 7;
@@ -82,11 +238,61 @@ void PdfImmediateWriter::WriteObject(const PdfObject& obj)
     m_Last = const_cast<PdfObject*>(&obj);
 }
 
+void PdfImmediateWriter::WriteObjects(const cspan<PdfObject*>& objects)
+{
+    writeCompressedStreams(false);
+    this->FinishLastObject();
+
+    // Serialize the whole group in memory, so
+    // it's written to the device at once
+    bool compress = GetCompressObjects();
+    size_t offset = m_Device->GetPosition();
+    m_batchBuffer.clear();
+    BufferStreamDevice device(m_batchBuffer);
+    for (auto obj : objects)
+    {
+        if (compress && CanCompressObject(*obj))
+            continue;
+
+        if (obj->HasStream() && dynamic_cast<const PdfFileObjectStream*>(obj->GetStream()) != nullptr)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Objects with file streams can't be written in groups");
+
+        m_xRef->AddInUseObject(obj->GetIndirectReference(), offset + device.GetPosition());
+        obj->Write(device, this->GetWriteFlags(), GetEncrypt(), m_buffer);
+    }
+
+    m_Device->Write(m_batchBuffer);
+
+    if (compress)
+    {
+        // Pack the other objects, the object streams
+        // are written as soon as they are full
+        m_memoryStreams = true;
+        for (auto obj : objects)
+        {
+            if (CanCompressObject(*obj))
+                CompressObject(*m_Device, *obj, m_group, *m_xRef);
+        }
+        m_memoryStreams = false;
+    }
+
+    // The objects are not needed in memory anymore
+    for (auto obj : objects)
+        GetObjects().RemoveObject(obj->GetIndirectReference(), false);
+}
+
 void PdfImmediateWriter::Finish()
 {
     // write all objects which are still in RAM
+    writeCompressedStreams(true);
     this->FinishLastObject();
 
+    // The object streams and the XRef stream are written
+    // at once, so they don't need file streams
+    m_memoryStreams = true;
+    if (m_group.References.size() != 0)
+        WriteObjectStream(*m_Device, m_group, *m_xRef);
+
     // setup encrypt dictionary
     if (GetEncrypt() != nullptr)
     {
@@ -97,27 +303,8 @@ void PdfImmediateWriter::Finish()
 
     this->WritePdfObjects(*m_Device, GetObjects(), *m_xRef);
 
-    // write the XRef
-    uint64_t lXRefOffset = static_cast<uint64_t>(m_Device->GetPosition());
+    // write the XRef, the trailer and the startxref offset
     m_xRef->Write(*m_Device, m_buffer);
-
-    // FIX-ME: The following is already done by PdfXRef now
-    PDFMM_RAISE_ERROR(PdfErrorCode::NotImplemented);
-
-    // XRef streams contain the trailer in the XRef
-    if (!GetUseXRefStream())
-    {
-        PdfObject trailer;
-
-        // if we have a dummy offset we write also a prev entry to the trailer
-        FillTrailerObject(trailer, m_xRef->GetSize(), false);
-
-        m_Device->Write("trailer\n");
-        trailer.Write(*m_Device, this->GetWriteFlags(), nullptr, m_buffer);
-    }
-
-    utls::FormatTo(m_buffer, "startxref\n{}\n%%EOF\n", lXRefOffset);
-    m_Device->Write(m_buffer);
     m_Device->Flush();
 
     // we are done now
@@ -127,9 +314,12 @@ void PdfImmediateWriter::Finish()
 
 PdfObjectStream* PdfImmediateWriter::CreateStream(PdfObject& parent)
 {
-    return m_OpenStream ?
-        static_cast<PdfObjectStream*>(new PdfMemoryObjectStream(parent)) :
-        static_cast<PdfObjectStream*>(new PdfFileObjectStream(parent, *m_Device));
+    if (m_OpenStream || m_memoryStreams)
+        return new PdfMemoryObjectStream(parent);
+    else if (m_maxStreamsInFlight != 0)
+        return new CompressedObjectStream(parent, GetObjects().GetExecutor());
+    else
+        return new PdfFileObjectStream(parent, *m_Device);
 }
 
 void PdfImmediateWriter::FinishLastObject()
@@ -144,6 +334,29 @@ void PdfImmediateWriter::FinishLastObject()
     }
 }
 
+void PdfImmediateWriter::writeCompressedStreams(bool wait)
+{
+    // The objects can't be written in the middle of a file stream
+    if (m_OpenStream)
+        return;
+
+    while (m_compressedStreams.size() != 0)
+    {
+        auto& obj = *m_compressedStreams.front();
+        auto& stream = static_cast<CompressedObjectStream&>(*obj.GetStream());
+        if (!wait && m_compressedStreams.size() <= m_maxStreamsInFlight && !stream.IsCompressed())
+            break;
+
+        this->FinishLastObject();
+
+        // The stream is encrypted while writing, on this thread
+        m_xRef->AddInUseObject(obj.GetIndirectReference(), m_Device->GetPosition());
+        obj.Write(*m_Device, this->GetWriteFlags(), GetEncrypt(), m_buffer);
+        m_compressedStreams.pop_front();
+        GetObjects().RemoveObject(obj.GetIndirectReference(), false);
+    }
+}
+
 void PdfImmediateWriter::BeginAppendStream(const PdfObjectStream& stream)
 {
     auto fileStream = dynamic_cast<const PdfFileObjectStream*>(&stream);
@@ -166,5 +379,18 @@ void PdfImmediateWriter::EndAppendStream(const PdfObjectStream& stream)
         // A PdfFileStream has to be opened before
         PDFMM_ASSERT(m_OpenStream);
         m_OpenStream = false;
+        return;
+    }
+
+    auto compressedStream = dynamic_cast<const CompressedObjectStream*>(&stream);
+    if (compressedStream != nullptr)
+    {
+        // The object is written when the data is compressed. Appending
+        // again to a stream waiting to be written doesn't queue it twice
+        auto& mstream = const_cast<CompressedObjectStream&>(*compressedStream);
+        if (mstream.TryQueue())
+            m_compressedStreams.push_back(&mstream.GetObject());
+
+        writeCompressedStreams(false);
     }
 }
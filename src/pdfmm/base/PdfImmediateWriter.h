@@ -9,6 +9,9 @@
 #define PDF_IMMEDIATE_WRITER_H
 
 #include "PdfDeclarations.h"
+
+#include <deque>
+
 #include "PdfIndirectObjectList.h"
 #include "PdfWriter.h"
 
@@ -63,8 +66,27 @@ public:
      */
     PdfVersion GetPdfVersion() const;
 
+    /** Set the maximum count of streams compressed in the background
+     *
+     *  When it's not 0, the data of the streams created afterwards is
+     *  compressed on the executor of the document, while the generation
+     *  of the document goes on. The streams are written in the order
+     *  they are finished, as soon as their compression is done, and the
+     *  generation is blocked when the given count of streams is still
+     *  waiting to be written, so the memory used stays bounded.
+     *  The default is 0, the streams are written to the device while
+     *  they are compressed on the calling thread
+     *  \param count the maximum count of streams waiting to be written
+     */
+    void SetMaxStreamsInFlight(unsigned count);
+
+    /** \returns the maximum count of streams compressed in the background
+     */
+    unsigned GetMaxStreamsInFlight() const { return m_maxStreamsInFlight; }
+
 private:
     void WriteObject(const PdfObject& obj) override;
+    void WriteObjects(const cspan<PdfObject*>& objects) override;
     void Finish() override;
     void BeginAppendStream(const PdfObjectStream& stream) override;
     void EndAppendStream(const PdfObjectStream& stream) override;
@@ -78,12 +100,26 @@ private:
      */
     void FinishLastObject();
 
+    /** Write the objects with the streams compressed in the background,
+     *  in order, as long as their compression is done
+     *  \param wait wait for the compression of all the streams
+     */
+    void writeCompressedStreams(bool wait);
+
+private:
+    class CompressedObjectStream;
+
 private:
     bool m_attached;
     OutputStreamDevice* m_Device;
     std::unique_ptr<PdfXRef> m_xRef;
     PdfObject* m_Last;
     bool m_OpenStream;
+    bool m_memoryStreams;
+    charbuff m_batchBuffer;
+    ObjectStreamGroup m_group;
+    unsigned m_maxStreamsInFlight;
+    std::deque<PdfObject*> m_compressedStreams;
 };
 
 };
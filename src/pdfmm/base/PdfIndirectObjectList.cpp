@@ -17,13 +17,18 @@
 #include "PdfObject.h"
 #include "PdfReference.h"
 #include "PdfObjectStream.h"
+#include "PdfObjectWalker.h"
 #include "PdfDocument.h"
+#include "PdfExecutor.h"
+#include "PdfMemoryGovernor.h"
+#include "PdfParserObject.h"
 
 using namespace std;
 using namespace mm;
 
 static constexpr size_t MaxReserveSize = 8388607; // cf. Table C.1 in section C.2 of PDF32000_2008.pdf
 static constexpr unsigned MaxXRefGenerationNum = 65535;
+static constexpr unsigned DefaultBatchSize = 256;
 
 struct ObjectComparatorPredicate
 {
@@ -34,15 +39,6 @@ public:
     }
 };
 
-struct ReferenceComparatorPredicate
-{
-public:
-    inline bool operator()(const PdfReference& obj1, const PdfReference& obj2) const
-    {
-        return obj1 < obj2;
-    }
-};
-
 //RG: 1) Should this class not be moved to the header file
 class ObjectsComparator
 {
@@ -69,7 +65,18 @@ PdfIndirectObjectList::PdfIndirectObjectList() :
     m_CanReuseObjectNumbers(true),
     m_Objects(CompareObject),
     m_ObjectCount(0),
-    m_StreamFactory(nullptr)
+    m_DirtyObjects(CompareObject),
+    m_BatchSize(DefaultBatchSize),
+    m_AppendingStreams(0),
+    m_StreamFactory(nullptr),
+    m_LazyObjectCount(0),
+    m_MemoryBudget(0),
+    m_LoadedMemory(0),
+    m_DecodedStreamCacheSize(0),
+    m_DecodedStreamMemory(0),
+    m_DecodedStreamCallback(-1),
+    m_ModificationCount(0),
+    m_ConcurrentWrites(false)
 {
 }
 
@@ -78,7 +85,18 @@ PdfIndirectObjectList::PdfIndirectObjectList(PdfDocument& document) :
     m_CanReuseObjectNumbers(true),
     m_Objects(CompareObject),
     m_ObjectCount(1),
-    m_StreamFactory(nullptr)
+    m_DirtyObjects(CompareObject),
+    m_BatchSize(DefaultBatchSize),
+    m_AppendingStreams(0),
+    m_StreamFactory(nullptr),
+    m_LazyObjectCount(0),
+    m_MemoryBudget(0),
+    m_LoadedMemory(0),
+    m_DecodedStreamCacheSize(0),
+    m_DecodedStreamMemory(0),
+    m_DecodedStreamCallback(-1),
+    m_ModificationCount(0),
+    m_ConcurrentWrites(false)
 {
 }
 
@@ -86,34 +104,80 @@ PdfIndirectObjectList::PdfIndirectObjectList(PdfDocument& document, const PdfInd
     m_Document(&document),
     m_CanReuseObjectNumbers(rhs.m_CanReuseObjectNumbers),
     m_Objects(CompareObject),
-    m_ObjectCount(rhs.m_ObjectCount),
-    m_FreeObjects(rhs.m_FreeObjects),
-    m_UnavailableObjects(rhs.m_UnavailableObjects),
-    m_StreamFactory(nullptr)
+    m_DirtyObjects(CompareObject),
+    m_BatchSize(DefaultBatchSize),
+    m_AppendingStreams(0),
+    m_StreamFactory(nullptr),
+    m_LazyObjectCount(0),
+    m_MemoryBudget(0),
+    m_LoadedMemory(0),
+    m_DecodedStreamCacheSize(0),
+    m_DecodedStreamMemory(0),
+    m_DecodedStreamCallback(-1),
+    m_ModificationCount(0),
+    m_ConcurrentWrites(false)
 {
+    // Copy the complete list, even if the source was not fully loaded yet
+    rhs.loadDeferred();
+    m_ObjectCount = rhs.m_ObjectCount;
+    m_FreeObjects = rhs.m_FreeObjects;
+    m_FreeObjectSet = rhs.m_FreeObjectSet;
+    m_UnavailableObjects = rhs.m_UnavailableObjects;
+
     // Copy all objects from source, resetting parent and indirect reference
+    PdfMemoryResourceScope scope(getMemoryResource());
     for (auto obj : rhs.m_Objects)
     {
         auto newObj = new PdfObject(*obj);
         newObj->SetIndirectReference(obj->GetIndirectReference());
         newObj->SetDocument(&document);
         m_Objects.insert(newObj);
+        indexObject(newObj);
     }
 }
 
 PdfIndirectObjectList::~PdfIndirectObjectList()
 {
+    if (m_DecodedStreamCallback != -1)
+        PdfMemoryGovernor::RemovePressureCallback((unsigned)m_DecodedStreamCallback);
+
     Clear();
 }
 
+pmr::memory_resource* PdfIndirectObjectList::getMemoryResource() const
+{
+    if (m_Document == nullptr)
+        return nullptr;
+
+    return m_Document->GetMemoryResource();
+}
+
+shared_ptr<PdfExecutor> PdfIndirectObjectList::GetExecutor() const
+{
+    if (m_Document == nullptr)
+        return PdfExecutor::GetDefault();
+
+    return m_Document->GetExecutor();
+}
+
 void PdfIndirectObjectList::Clear()
 {
     for (auto obj : m_Objects)
         delete obj;
 
     m_Objects.clear();
+    m_DirtyObjects.clear();
+    m_ObjectIndex.clear();
     m_ObjectCount = 1;
     m_StreamFactory = nullptr;
+    m_deferredLoader = nullptr;
+    m_LazyEntries.Clear();
+    m_LazyObjectCount = 0;
+    m_LazyObjectFactory = nullptr;
+    m_LoadedObjects.clear();
+    m_LoadedMemory = 0;
+    m_QueuedObjects.clear();
+    clearDecodedStreams();
 }
 
 PdfObject& PdfIndirectObjectList::MustGetObject(const PdfReference& ref) const
@@ -127,11 +191,73 @@ PdfObject& PdfIndirectObjectList::MustGetObject(const PdfReference& ref) const
 
 PdfObject* PdfIndirectObjectList::GetObject(const PdfReference& ref) const
 {
-    auto it = std::lower_bound(m_Objects.begin(), m_Objects.end(), ref, CompareReference);
-    if (it == m_Objects.end() || (*it)->GetIndirectReference() != ref)
+    auto lock = lockConcurrentWrites();
+    auto obj = getOrCreateObject(ref);
+    if (obj == nullptr && m_deferredLoader != nullptr)
+    {
+        // The object may be listed in a section not read yet
+        invokeDeferredLoader();
+        obj = getOrCreateObject(ref);
+    }
+
+    return obj;
+}
+
+PdfObject* PdfIndirectObjectList::getOrCreateObject(const PdfReference& ref) const
+{
+    auto obj = getObject(ref);
+    if (obj != nullptr || m_LazyObjectCount == 0 || ref.ObjectNumber() >= m_LazyEntries.GetSize())
+        return obj;
+
+    auto& entry = m_LazyEntries[ref.ObjectNumber()];
+    if (!entry.Parsed || entry.Generation != ref.GenerationNumber())
+        return nullptr;
+
+    return const_cast<PdfIndirectObjectList&>(*this).createLazyObject(ref.ObjectNumber());
+}
+
+PdfObject* PdfIndirectObjectList::getObject(const PdfReference& ref) const
+{
+    if (ref.ObjectNumber() >= m_ObjectIndex.size())
         return nullptr;
 
-    return *it;
+    auto obj = m_ObjectIndex[ref.ObjectNumber()];
+    if (obj == nullptr || obj->GetIndirectReference() == ref)
+        return obj;
+
+    // Generation mismatch, rare
+    return findObject(obj, ref);
+}
+
+PdfObject* PdfIndirectObjectList::findObject(PdfObject* sibling, const PdfReference& ref) const
+{
+    auto found = m_Objects.find(sibling);
+    PDFMM_ASSERT(found != m_Objects.end());
+    if (ref < sibling->GetIndirectReference())
+    {
+        for (auto it = found; it != m_Objects.begin(); )
+        {
+            it--;
+            if ((*it)->GetIndirectReference().ObjectNumber() != ref.ObjectNumber())
+                break;
+
+            if ((*it)->GetIndirectReference() == ref)
+                return *it;
+        }
+    }
+    else
+    {
+        for (auto it = std::next(found); it != m_Objects.end(); it++)
+        {
+            if ((*it)->GetIndirectReference().ObjectNumber() != ref.ObjectNumber())
+                break;
+
+            if ((*it)->GetIndirectReference() == ref)
+                return *it;
+        }
+    }
+
+    return nullptr;
 }
 
 unique_ptr<PdfObject> PdfIndirectObjectList::RemoveObject(const PdfReference& ref)
@@ -141,11 +267,12 @@ unique_ptr<PdfObject> PdfIndirectObjectList::RemoveObject(const PdfReference& re
 
 unique_ptr<PdfObject> PdfIndirectObjectList::RemoveObject(const PdfReference& ref, bool markAsFree)
 {
-    auto it = std::lower_bound(m_Objects.begin(), m_Objects.end(), ref, CompareReference);
-    if (it == m_Objects.end() || (*it)->GetIndirectReference() != ref)
+    invokeDeferredLoader();
+    auto obj = getOrCreateObject(ref);
+    if (obj == nullptr)
         return nullptr;
 
-    return removeObject(it, markAsFree);
+    return removeObject(m_Objects.find(obj), markAsFree);
 }
 
 unique_ptr<PdfObject> PdfIndirectObjectList::RemoveObject(const iterator& it)
@@ -158,10 +285,16 @@ unique_ptr<PdfObject> PdfIndirectObjectList::ReplaceObject(const PdfReference& r
     if (obj == nullptr)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Object must be non null");
 
-    auto it = std::lower_bound(m_Objects.begin(), m_Objects.end(), ref, CompareReference);
-    if (it == m_Objects.end())
+    invokeDeferredLoader();
+    auto found = getOrCreateObject(ref);
+    if (found == nullptr)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Unable to find object with reference {}", ref.ToString());
 
+    auto it = m_Objects.find(found);
+    m_ModificationCount++;
+    untrackDirtyObject(*found);
+    invalidateDecodedStream(ref);
+    unindexObject(it);
     auto node = m_Objects.extract(it);
     unique_ptr<PdfObject> ret(node.value());
     node.value() = obj;
@@ -176,22 +309,37 @@ unique_ptr<PdfObject> PdfIndirectObjectList::removeObject(const iterator& it, bo
     if (markAsFree)
         SafeAddFreeObject(obj->GetIndirectReference());
 
+    if (m_QueuedObjects.size() != 0)
+    {
+        auto found = std::find(m_QueuedObjects.begin(), m_QueuedObjects.end(), obj);
+        if (found != m_QueuedObjects.end())
+            m_QueuedObjects.erase(found);
+    }
+
+    m_ModificationCount++;
+    untrackDirtyObject(*obj);
+    invalidateDecodedStream(obj->GetIndirectReference());
+    unindexObject(it);
     m_Objects.erase(it);
     return unique_ptr<PdfObject>(obj);
 }
 
 PdfReference PdfIndirectObjectList::getNextFreeObject()
 {
+    // All the numbers in use must be known before assigning a new one
+    invokeDeferredLoader();
+
     // Try to first use list of free objects
     if (m_CanReuseObjectNumbers && !m_FreeObjects.empty())
     {
         PdfReference freeObjectRef = m_FreeObjects.front();
         m_FreeObjects.pop_front();
+        m_FreeObjectSet.erase(freeObjectRef);
         return freeObjectRef;
     }
 
     // If no free objects are available, create a new object with generation 0
-    uint16_t nextObjectNum = static_cast<uint16_t>(m_ObjectCount);
+    uint32_t nextObjectNum = m_ObjectCount;
     while (true)
     {
         if ((size_t)(nextObjectNum + 1) == MaxReserveSize)
@@ -218,6 +366,7 @@ PdfObject* PdfIndirectObjectList::CreateDictionaryObject(const string_view& type
     if (!subtype.empty())
         dict.AddKey(PdfName::KeySubtype, PdfName(subtype));
 
+    PdfMemoryResourceScope scope(getMemoryResource());
     auto ret = new PdfObject(std::move(dict));
     ret->setDirty();
     addNewObject(ret);
@@ -226,6 +375,7 @@ PdfObject* PdfIndirectObjectList::CreateDictionaryObject(const string_view& type
 
 PdfObject* PdfIndirectObjectList::CreateArrayObject()
 {
+    PdfMemoryResourceScope scope(getMemoryResource());
     auto ret = new PdfObject(PdfArray());
     ret->setDirty();
     addNewObject(ret);
@@ -234,6 +384,7 @@ PdfObject* PdfIndirectObjectList::CreateArrayObject()
 
 PdfObject* PdfIndirectObjectList::CreateObject(const PdfObject& obj)
 {
+    PdfMemoryResourceScope scope(getMemoryResource());
     auto ret = new PdfObject(obj);
     ret->setDirty();
     addNewObject(ret);
@@ -242,6 +393,7 @@ PdfObject* PdfIndirectObjectList::CreateObject(const PdfObject& obj)
 
 PdfObject* PdfIndirectObjectList::CreateObject(PdfObject&& obj)
 {
+    PdfMemoryResourceScope scope(getMemoryResource());
     auto ret = new PdfObject(std::move(obj));
     ret->setDirty();
     addNewObject(ret);
@@ -273,7 +425,7 @@ int32_t PdfIndirectObjectList::tryAddFreeObject(uint32_t objnum, uint32_t gennum
     // NOTE: gennum is uint32 to accomodate overflows from callers
     if (gennum >= MaxXRefGenerationNum)
     {
-        m_UnavailableObjects.insert(gennum);
+        m_UnavailableObjects.insert(objnum);
         return -1;
     }
 
@@ -283,25 +435,22 @@ int32_t PdfIndirectObjectList::tryAddFreeObject(uint32_t objnum, uint32_t gennum
 
 void PdfIndirectObjectList::AddFreeObject(const PdfReference& reference)
 {
-    auto it = std::equal_range(m_FreeObjects.begin(), m_FreeObjects.end(), reference, ReferenceComparatorPredicate());
-    if (it.first != it.second && !m_FreeObjects.empty())
+    if (!m_FreeObjectSet.insert(reference).second)
     {
         // Be sure that no reference is added twice to free list
         mm::LogMessage(PdfLogSeverity::Debug, "Adding {} to free list, is already contained in it!", reference.ObjectNumber());
         return;
     }
-    else
-    {
-        // Insert so that list stays sorted
-        m_FreeObjects.insert(it.first, reference);
 
-        // When append free objects from external doc we need plus one number objects
-        TryIncrementObjectCount(reference);
-    }
+    m_FreeObjects.push_back(reference);
+
+    // When append free objects from external doc we need plus one number objects
+    TryIncrementObjectCount(reference);
 }
 
 void PdfIndirectObjectList::addNewObject(PdfObject* obj)
 {
+    auto lock = lockConcurrentWrites();
     PdfReference ref = getNextFreeObject();
     obj->SetIndirectReference(ref);
     PushObject(obj);
@@ -311,12 +460,26 @@ void PdfIndirectObjectList::PushObject(PdfObject* obj)
 {
     obj->SetDocument(m_Document);
 
+    // The object replaces the one listed with the same reference
+    auto& ref = obj->GetIndirectReference();
+    if (m_LazyObjectCount != 0 && ref.ObjectNumber() < m_LazyEntries.GetSize())
+    {
+        auto& entry = m_LazyEntries[ref.ObjectNumber()];
+        if (entry.Parsed && entry.Generation == ref.GenerationNumber())
+        {
+            entry.Parsed = false;
+            m_LazyObjectCount--;
+        }
+    }
+
     ObjectList::node_type node;
     auto it = m_Objects.find(obj);
     if (it != m_Objects.end())
     {
         // Delete existing object and replace
         // the pointer on its node
+        untrackDirtyObject(**it);
+        unindexObject(it);
         node = m_Objects.extract(it);
         delete node.value();
         node.value() = obj;
@@ -331,6 +494,9 @@ void PdfIndirectObjectList::pushObject(ObjectList::node_type& node, PdfObject* o
         m_Objects.insert(obj);
     else
         m_Objects.insert(std::move(node));
+    indexObject(obj);
+    if (obj->IsDirty() && m_Document != nullptr)
+        m_DirtyObjects.insert(obj);
     TryIncrementObjectCount(obj->GetIndirectReference());
 }
 
@@ -339,67 +505,74 @@ void PdfIndirectObjectList::CollectGarbage()
     if (m_Document == nullptr)
         return;
 
-    unordered_set<PdfReference> referencedOjects;
-    visitObject(m_Document->GetTrailer().GetObject(), referencedOjects);
+    loadDeferred();
+
+    PdfObjectWalker walker(this);
+    walker.Walk(m_Document->GetTrailer().GetObject(), [](const PdfObject&, const PdfName*)
+    {
+        return PdfWalkAction::Continue;
+    });
+
     ObjectList newlist(CompareObject);
     for (PdfObject* obj : m_Objects)
     {
-        if (referencedOjects.find(obj->GetIndirectReference()) == referencedOjects.end())
+        if (!walker.IsVisited(obj->GetIndirectReference().ObjectNumber()))
         {
             SafeAddFreeObject(obj->GetIndirectReference());
+            untrackDirtyObject(*obj);
             continue;
         }
 
-        newlist.insert(obj);
+        // The objects are visited sorted, so hint the insertion at the end
+        newlist.insert(newlist.end(), obj);
     }
 
     m_Objects.swap(newlist);
+    rebuildIndex();
+}
+
+void PdfIndirectObjectList::indexObject(PdfObject* obj)
+{
+    uint32_t objNum = obj->GetIndirectReference().ObjectNumber();
+    if (objNum >= m_ObjectIndex.size())
+        m_ObjectIndex.resize(std::max((size_t)objNum + 1, m_ObjectIndex.size() * 2));
+
+    m_ObjectIndex[objNum] = obj;
 }
 
-void PdfIndirectObjectList::visitObject(const PdfObject& obj, unordered_set<PdfReference>& referencedObjects)
+void PdfIndirectObjectList::unindexObject(const iterator& it)
 {
-    if (obj.IsIndirect())
+    auto obj = *it;
+    uint32_t objNum = obj->GetIndirectReference().ObjectNumber();
+    if (objNum >= m_ObjectIndex.size() || m_ObjectIndex[objNum] != obj)
+        return;
+
+    // Objects with the same number are adjacent in the ordered list
+    PdfObject* sibling = nullptr;
+    auto next = std::next(it);
+    if (next != m_Objects.end() && (*next)->GetIndirectReference().ObjectNumber() == objNum)
     {
-        // Try to check if the object has been already visited
-        auto inserted = referencedObjects.insert(obj.GetIndirectReference());
-        if (!inserted.second)
-        {
-            // The object has been visited, just return
-            return;
-        }
+        sibling = *next;
     }
-
-    switch (obj.GetDataType())
+    else if (it != m_Objects.begin())
     {
-        case PdfDataType::Reference:
-        {
-            auto childObj = GetObject(obj.GetReference());
-            if (childObj == nullptr)
-                break;
-
-            visitObject(*childObj, referencedObjects);
-            break;
-        }
-        case PdfDataType::Array:
-        {
-            auto& arr = obj.GetArray();
-            for (auto& child : arr)
-                visitObject(child, referencedObjects);
-            break;
-        }
-        case PdfDataType::Dictionary:
-        {
-            auto& dict = obj.GetDictionary();
-            for (auto& pair : dict)
-                visitObject(pair.second, referencedObjects);
-            break;
-        }
-        default:
-        {
-            // Nothing to do
-            break;
-        }
+        auto prev = std::prev(it);
+        if ((*prev)->GetIndirectReference().ObjectNumber() == objNum)
+            sibling = *prev;
     }
+
+    m_ObjectIndex[objNum] = sibling;
+}
+
+void PdfIndirectObjectList::rebuildIndex()
+{
+    m_ObjectIndex.clear();
+    if (m_Objects.size() == 0)
+        return;
+
+    m_ObjectIndex.resize((size_t)(*m_Objects.rbegin())->GetIndirectReference().ObjectNumber() + 1);
+    for (auto obj : m_Objects)
+        m_ObjectIndex[obj->GetIndirectReference().ObjectNumber()] = obj;
 }
 
 void PdfIndirectObjectList::Detach(Observer* observer)
@@ -421,6 +594,7 @@ void PdfIndirectObjectList::Detach(Observer* observer)
 
 PdfObjectStream* PdfIndirectObjectList::CreateStream(PdfObject& parent)
 {
+    PdfMemoryResourceScope scope(getMemoryResource());
     PdfObjectStream* stream = m_StreamFactory == nullptr ?
         new PdfMemoryObjectStream(parent) :
         m_StreamFactory->CreateStream(parent);
@@ -435,8 +609,39 @@ void PdfIndirectObjectList::WriteObject(PdfObject& obj)
         observer->WriteObject(obj);
 }
 
+void PdfIndirectObjectList::QueueObject(PdfObject& obj)
+{
+    if (m_observers.size() == 0)
+        return;
+
+    m_QueuedObjects.push_back(&obj);
+    if (m_AppendingStreams == 0 && m_QueuedObjects.size() >= m_BatchSize)
+        FlushQueuedObjects();
+}
+
+void PdfIndirectObjectList::FlushQueuedObjects()
+{
+    // NOTE: The queue is delivered after the stream appends in progress end
+    if (m_QueuedObjects.size() == 0 || m_AppendingStreams != 0)
+        return;
+
+    // Observers may remove the objects, which
+    // also removes them from the queue
+    vector<PdfObject*> objects;
+    std::swap(objects, m_QueuedObjects);
+    for (auto& observer : m_observers)
+        observer->WriteObjects(objects);
+}
+
+void PdfIndirectObjectList::SetBatchSize(unsigned batchSize)
+{
+    m_BatchSize = batchSize == 0 ? 1 : batchSize;
+}
+
 void PdfIndirectObjectList::Finish()
 {
+    FlushQueuedObjects();
+
     // always work on a copy of the vector
     // in case a child invalidates our iterators
     // with a call to attach or detach.
@@ -447,14 +652,33 @@ void PdfIndirectObjectList::Finish()
 
 void PdfIndirectObjectList::BeginAppendStream(const PdfObjectStream& stream)
 {
+    auto lock = lockConcurrentWrites();
+    // Deliver the queue first, as the observers
+    // may write the stream data right away
+    if (m_AppendingStreams == 0)
+        FlushQueuedObjects();
+
+    m_AppendingStreams++;
     for (auto& observer : m_observers)
         observer->BeginAppendStream(stream);
 }
 
 void PdfIndirectObjectList::EndAppendStream(const PdfObjectStream& stream)
 {
+    auto lock = lockConcurrentWrites();
+    PDFMM_ASSERT(m_AppendingStreams != 0);
+    m_AppendingStreams--;
     for (auto& observer : m_observers)
         observer->EndAppendStream(stream);
+
+    if (m_AppendingStreams == 0 && m_QueuedObjects.size() >= m_BatchSize)
+        FlushQueuedObjects();
+}
+
+void PdfIndirectObjectList::Observer::WriteObjects(const cspan<PdfObject*>& objects)
+{
+    for (auto obj : objects)
+        WriteObject(*obj);
 }
 
 void PdfIndirectObjectList::SetCanReuseObjectNumbers(bool canReuseObjectNumbers)
@@ -462,11 +686,15 @@ void PdfIndirectObjectList::SetCanReuseObjectNumbers(bool canReuseObjectNumbers)
     m_CanReuseObjectNumbers = canReuseObjectNumbers;
 
     if (!m_CanReuseObjectNumbers)
+    {
         m_FreeObjects.clear();
+        m_FreeObjectSet.clear();
+    }
 }
 
 unsigned PdfIndirectObjectList::GetSize() const
 {
+    loadDeferred();
     return (unsigned)m_Objects.size();
 }
 
@@ -491,18 +719,326 @@ void PdfIndirectObjectList::TryIncrementObjectCount(const PdfReference& ref)
     }
 }
 
+void PdfIndirectObjectList::SetDeferredLoader(const function<void()>& loader)
+{
+    m_deferredLoader = loader;
+}
+
+void PdfIndirectObjectList::SetLazyObjectFactory(const function<PdfObject*(const PdfReference&, const PdfXRefEntry&)>& factory)
+{
+    m_LazyObjectFactory = factory;
+}
+
+void PdfIndirectObjectList::AddLazyObject(const PdfReference& ref, const PdfXRefEntry& entry)
+{
+    PDFMM_ASSERT(m_LazyObjectFactory != nullptr);
+    m_LazyEntries.Enlarge((int64_t)ref.ObjectNumber() + 1);
+    auto& lazyEntry = m_LazyEntries[ref.ObjectNumber()];
+    if (!lazyEntry.Parsed)
+        m_LazyObjectCount++;
+
+    lazyEntry = entry;
+    lazyEntry.Parsed = true;
+    TryIncrementObjectCount(ref);
+}
+
+void PdfIndirectObjectList::SetMemoryBudget(size_t budget)
+{
+    m_MemoryBudget = budget;
+    if (budget == 0)
+    {
+        m_LoadedObjects.clear();
+        m_LoadedMemory = 0;
+        return;
+    }
+
+    ApplyMemoryBudget();
+}
+
+void PdfIndirectObjectList::ApplyMemoryBudget()
+{
+    if (m_MemoryBudget == 0)
+        return;
+
+    // Visit the objects in load order at most once. The objects
+    // accessed since the previous visit get a second chance, which
+    // approximates the least recently used order without updating
+    // the list on every access
+    size_t count = m_LoadedObjects.size();
+    for (size_t i = 0; i < count && m_LoadedMemory > m_MemoryBudget; i++)
+    {
+        auto loaded = m_LoadedObjects.front();
+        m_LoadedObjects.pop_front();
+        auto obj = dynamic_cast<PdfParserObject*>(getObject(loaded.Reference));
+        if (obj != nullptr && obj->IsDelayedLoadDone() && !obj->IsDirty() && !obj->m_IsPinned)
+        {
+            if (obj->m_IsAccessed)
+            {
+                obj->m_IsAccessed = false;
+                m_LoadedObjects.push_back(loaded);
+                continue;
+            }
+
+            obj->FreeObjectMemory();
+        }
+
+        // NOTE: Removed, already freed, dirty or pinned objects are not tracked anymore
+        m_LoadedMemory -= loaded.Size;
+    }
+}
+
+void PdfIndirectObjectList::SetDecodedStreamCacheSize(size_t size)
+{
+    if (size == 0)
+    {
+        if (m_DecodedStreamCallback != -1)
+        {
+            PdfMemoryGovernor::RemovePressureCallback((unsigned)m_DecodedStreamCallback);
+            m_DecodedStreamCallback = -1;
+        }
+
+        clearDecodedStreams();
+        m_DecodedStreamCacheSize = 0;
+        return;
+    }
+
+    if (m_DecodedStreamCallback == -1)
+    {
+        m_DecodedStreamCallback = (int)PdfMemoryGovernor::AddPressureCallback([this](size_t size) {
+            return relieveDecodedStreams(size);
+        });
+    }
+
+    lock_guard<mutex> lock(m_DecodedStreamMutex);
+    m_DecodedStreamCacheSize = size;
+    while (m_DecodedStreamMemory > m_DecodedStreamCacheSize)
+        eraseDecodedStream(m_DecodedStreamIndex.find(m_DecodedStreams.back().Reference));
+}
+
+shared_ptr<const charbuff> PdfIndirectObjectList::findDecodedStream(const PdfObject& obj)
+{
+    lock_guard<mutex> lock(m_DecodedStreamMutex);
+    auto found = m_DecodedStreamIndex.find(obj.GetIndirectReference());
+    if (found == m_DecodedStreamIndex.end())
+        return nullptr;
+
+    m_DecodedStreams.splice(m_DecodedStreams.begin(), m_DecodedStreams, found->second);
+    return found->second->Data;
+}
+
+void PdfIndirectObjectList::cacheDecodedStream(const PdfObject& obj, const charbuff& data)
+{
+    // NOTE: Removed objects may still refer to the document
+    auto& ref = obj.GetIndirectReference();
+    if (data.size() > m_DecodedStreamCacheSize || getObject(ref) != &obj)
+        return;
+
+    // NOTE: Reserve before locking, since the
+    // pressure may evict entries of this cache too
+    size_t reserved;
+    if (!PdfMemoryGovernor::TryReserve(data.size(), reserved))
+        return;
+
+    auto cached = std::make_shared<const charbuff>(data);
+    lock_guard<mutex> lock(m_DecodedStreamMutex);
+    eraseDecodedStream(m_DecodedStreamIndex.find(ref));
+    while (m_DecodedStreamMemory + data.size() > m_DecodedStreamCacheSize)
+        eraseDecodedStream(m_DecodedStreamIndex.find(m_DecodedStreams.back().Reference));
+
+    m_DecodedStreams.push_front({ ref, std::move(cached), reserved });
+    m_DecodedStreamIndex[ref] = m_DecodedStreams.begin();
+    m_DecodedStreamMemory += data.size();
+}
+
+void PdfIndirectObjectList::invalidateDecodedStream(const PdfReference& ref)
+{
+    lock_guard<mutex> lock(m_DecodedStreamMutex);
+    eraseDecodedStream(m_DecodedStreamIndex.find(ref));
+}
+
+void PdfIndirectObjectList::clearDecodedStreams()
+{
+    lock_guard<mutex> lock(m_DecodedStreamMutex);
+    for (auto& stream : m_DecodedStreams)
+        PdfMemoryGovernor::Release(stream.Reserved);
+
+    m_DecodedStreams.clear();
+    m_DecodedStreamIndex.clear();
+    m_DecodedStreamMemory = 0;
+}
+
+size_t PdfIndirectObjectList::relieveDecodedStreams(size_t size)
+{
+    lock_guard<mutex> lock(m_DecodedStreamMutex);
+    size_t released = 0;
+    while (released < size && m_DecodedStreams.size() != 0)
+    {
+        released += m_DecodedStreams.back().Reserved;
+        eraseDecodedStream(m_DecodedStreamIndex.find(m_DecodedStreams.back().Reference));
+    }
+
+    return released;
+}
+
+void PdfIndirectObjectList::eraseDecodedStream(unordered_map<PdfReference, DecodedStreamList::iterator>::iterator it)
+{
+    if (it == m_DecodedStreamIndex.end())
+        return;
+
+    m_DecodedStreamMemory -= it->second->Data->size();
+    PdfMemoryGovernor::Release(it->second->Reserved);
+    m_DecodedStreams.erase(it->second);
+    m_DecodedStreamIndex.erase(it);
+}
+
+bool PdfIndirectObjectList::tryBeginConcurrentWrites()
+{
+    if (m_observers.size() != 0)
+        return false;
+
+    // All the numbers in use must be known before assigning
+    // new ones, and all the objects are loaded, as they
+    // can't be read concurrently from the input device
+    for (auto obj : *this)
+        obj->ForceLoad();
+
+    m_ConcurrentWrites = true;
+    return true;
+}
+
+void PdfIndirectObjectList::endConcurrentWrites()
+{
+    m_ConcurrentWrites = false;
+}
+
+unique_lock<recursive_mutex> PdfIndirectObjectList::lockConcurrentWrites() const
+{
+    if (!m_ConcurrentWrites)
+        return { };
+
+    return unique_lock<recursive_mutex>(m_ConcurrentWritesMutex);
+}
+
+void PdfIndirectObjectList::trackLoadedObject(const PdfObject& obj, size_t size)
+{
+    if (m_MemoryBudget == 0)
+        return;
+
+    m_LoadedObjects.push_back({ obj.GetIndirectReference(), size });
+    m_LoadedMemory += size;
+}
+
+void PdfIndirectObjectList::pinObject(PdfObject& obj)
+{
+    // NOTE: Don't write the flag if it's already set, so
+    // the objects of frozen documents are never written
+    if (!obj.m_IsPinned)
+        obj.m_IsPinned = true;
+}
+
+void PdfIndirectObjectList::trackDirtyObject(PdfObject& obj)
+{
+    auto lock = lockConcurrentWrites();
+    // NOTE: Removed objects may still refer to the document
+    if (getObject(obj.GetIndirectReference()) == &obj)
+        m_DirtyObjects.insert(&obj);
+}
+
+void PdfIndirectObjectList::untrackDirtyObject(PdfObject& obj)
+{
+    auto found = m_DirtyObjects.find(&obj);
+    if (found != m_DirtyObjects.end() && *found == &obj)
+        m_DirtyObjects.erase(found);
+}
+
+void PdfIndirectObjectList::collectDirtyObjects(vector<PdfObject*>& objects) const
+{
+    objects.clear();
+    auto it = m_DirtyObjects.begin();
+    while (it != m_DirtyObjects.end())
+    {
+        if ((*it)->IsDirty())
+        {
+            objects.push_back(*it);
+            it++;
+        }
+        else
+        {
+            it = m_DirtyObjects.erase(it);
+        }
+    }
+}
+
+void PdfIndirectObjectList::loadDeferred() const
+{
+    invokeDeferredLoader();
+    if (m_LazyObjectCount != 0)
+        const_cast<PdfIndirectObjectList&>(*this).loadLazyObjects();
+}
+
+void PdfIndirectObjectList::invokeDeferredLoader() const
+{
+    if (m_deferredLoader == nullptr)
+        return;
+
+    // Reset the loader before invoking it, as
+    // loading will access the list as well
+    auto loader = std::move(m_deferredLoader);
+    m_deferredLoader = nullptr;
+    loader();
+}
+
+PdfObject* PdfIndirectObjectList::createLazyObject(uint32_t objNum)
+{
+    // Unlist the object first, as creating it may look up other objects
+    auto entry = m_LazyEntries[objNum];
+    m_LazyEntries[objNum].Parsed = false;
+    m_LazyObjectCount--;
+    if (m_LazyObjectCount == 0)
+        m_LazyEntries = PdfXRefEntries();
+
+    PdfMemoryResourceScope scope(getMemoryResource());
+    auto obj = m_LazyObjectFactory(PdfReference(objNum, (uint16_t)entry.Generation), entry);
+    PushObject(obj);
+    return obj;
+}
+
+void PdfIndirectObjectList::loadLazyObjects()
+{
+    for (unsigned i = 0; m_LazyObjectCount != 0 && i < m_LazyEntries.GetSize(); i++)
+    {
+        if (m_LazyEntries[i].Parsed)
+            (void)createLazyObject(i);
+    }
+}
+
+unsigned PdfIndirectObjectList::GetObjectCount() const
+{
+    loadDeferred();
+    return m_ObjectCount;
+}
+
+const PdfReferenceList& PdfIndirectObjectList::GetFreeObjects() const
+{
+    loadDeferred();
+    return m_FreeObjects;
+}
+
 PdfIndirectObjectList::iterator PdfIndirectObjectList::begin() const
 {
+    loadDeferred();
     return m_Objects.begin();
 }
 
 PdfIndirectObjectList::iterator PdfIndirectObjectList::end() const
 {
+    loadDeferred();
     return m_Objects.end();
 }
 
 size_t PdfIndirectObjectList::size() const
 {
+    loadDeferred();
     return m_Objects.size();
 }
 
@@ -510,8 +1046,3 @@ bool PdfIndirectObjectList::CompareObject(const PdfObject* p1, const PdfObject*
 {
     return *p1 < *p2;
 }
-
-bool PdfIndirectObjectList::CompareReference(const PdfObject* obj, const PdfReference& ref)
-{
-    return obj->GetIndirectReference() < ref;
-}
@@ -9,16 +9,24 @@
 #ifndef PDF_INDIRECT_OBJECT_LIST_H
 #define PDF_INDIRECT_OBJECT_LIST_H
 
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <list>
+#include <memory_resource>
+#include <mutex>
 #include <set>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "PdfDeclarations.h"
 #include "PdfReference.h"
+#include "PdfXRefEntry.h"
 
 namespace mm {
 
 class PdfDocument;
+class PdfExecutor;
 class PdfObject;
 class PdfObjectStream;
 class PdfVariant;
@@ -41,13 +49,18 @@ class PDFMM_API PdfIndirectObjectList final
 {
     friend class PdfWriter;
     friend class PdfDocument;
+    friend class PdfMemDocument;
     friend class PdfParser;
     friend class PdfObjectStreamParser;
     friend class PdfImmediateWriter;
+    friend class PdfParserObject;
+    friend class PdfObject;
+    friend class PdfObjectStream;
+    friend class PdfSnapshotSerializer;
+    friend class PdfPageCollection;
 
 private:
     static bool CompareObject(const PdfObject* p1, const PdfObject* p2);
-    static bool CompareReference(const PdfObject* obj, const PdfReference& ref);
 
 private:
     using ObjectList = std::set<PdfObject*, decltype(CompareObject)*>;
@@ -68,6 +81,13 @@ public:
 
         virtual void WriteObject(const PdfObject& obj) = 0;
 
+        /** Called with a group of finished objects queued with
+         *  PdfIndirectObjectList::QueueObject(). The default
+         *  implementation calls WriteObject() for each object
+         *  \param objects the objects to write, in queue order
+         */
+        virtual void WriteObjects(const cspan<PdfObject*>& objects);
+
         /** Called whenever appending to a stream is started.
          *  \param stream the stream object the user currently writes to.
          */
@@ -130,7 +150,7 @@ public:
     /**
      *  \returns the highest object number in the vector
      */
-    unsigned GetObjectCount() const { return m_ObjectCount; }
+    unsigned GetObjectCount() const;
 
     /** Finds the object with the given reference
      *  and returns a pointer to it if it is found. Throws a PdfError
@@ -228,6 +248,30 @@ public:
      */
     void WriteObject(PdfObject& obj);
 
+    /** Queue a finished object to be delivered to the observers in
+     *  a group with the other queued objects, see Observer::WriteObjects().
+     *  The queue is delivered when it reaches the batch size, before
+     *  any stream append starts and when the document is finished.
+     *  Without observers the object is not queued
+     *
+     *  \param obj a complete object that won't be modified anymore
+     *  \remarks the object must not have a stream that is written
+     *      separately by a stream factory
+     */
+    void QueueObject(PdfObject& obj);
+
+    /** Deliver the queued objects to the observers now, or
+     *  as soon as the stream appends in progress end
+     */
+    void FlushQueuedObjects();
+
+    /** Set the number of queued objects that triggers a delivery
+     *  to the observers. The default is 256
+     */
+    void SetBatchSize(unsigned batchSize);
+
+    inline unsigned GetBatchSize() const { return m_BatchSize; }
+
     /** Call whenever a document is finished
      */
     void Finish();
@@ -259,6 +303,7 @@ private:
     using ReferencePointers = std::list<PdfReference*>;
     using ReferencePointersList = std::vector<ReferencePointers>;
     using ObserverList = std::vector<Observer*>;
+    using ObjectIndex = std::vector<PdfObject*>;
 
 private:
     PdfIndirectObjectList(PdfDocument& document);
@@ -308,6 +353,27 @@ private:
 
     std::unique_ptr<PdfObject> RemoveObject(const PdfReference& ref, bool markAsFree);
 
+    /** Set a function that completes the loading of the
+     *  objects, e.g. reading the deferred main xref section
+     *  of a linearized file. The function is invoked once, as
+     *  soon as an object that is not in the list is requested
+     *  or the whole list is accessed
+     */
+    void SetDeferredLoader(const std::function<void()>& loader);
+
+    /** Set the function that creates the objects listed with
+     *  AddLazyObject, from their reference and their xref entry
+     */
+    void SetLazyObjectFactory(const std::function<PdfObject*(const PdfReference&, const PdfXRefEntry&)>& factory);
+
+    /** List an in-use object read by the parser, that is created only on
+     *  its first lookup, or as soon as the whole list is accessed. Pushing
+     *  an object with the same reference drops the listed one
+     *  \param ref the reference of the object
+     *  \param entry the xref entry of the object
+     */
+    void AddLazyObject(const PdfReference& ref, const PdfXRefEntry& entry);
+
     /**
      * Deletes all objects that are not references by other objects
      * besides the trailer (which references the root dictionary, which in
@@ -321,6 +387,7 @@ private:
     std::unique_ptr<PdfObject> removeObject(const iterator& it, bool markAsFree);
 
     void addNewObject(PdfObject* obj);
+    std::pmr::memory_resource* getMemoryResource() const;
 
     /**
      * \returns the next free object reference
@@ -329,7 +396,121 @@ private:
 
     int32_t tryAddFreeObject(uint32_t objnum, uint32_t gennum);
 
-    void visitObject(const PdfObject& obj, std::unordered_set<PdfReference>& referencedObj);
+    /** Complete the loading of the list, reading the deferred
+     *  sections and creating all the objects listed lazily
+     */
+    void loadDeferred() const;
+
+    /** Invoke the deferred loader only, so all the object
+     *  numbers are known, without creating the listed objects
+     */
+    void invokeDeferredLoader() const;
+
+    PdfObject* getObject(const PdfReference& ref) const;
+
+    /** Find the object with the given reference, creating
+     *  it if it's listed lazily and not created yet
+     */
+    PdfObject* getOrCreateObject(const PdfReference& ref) const;
+
+    PdfObject* createLazyObject(uint32_t objNum);
+
+    void loadLazyObjects();
+
+    /** Find the object with given reference in the ordered
+     *  list, starting from an object with the same number
+     */
+    PdfObject* findObject(PdfObject* sibling, const PdfReference& ref) const;
+
+    /** Set the object as the one indexed for its object number
+     */
+    void indexObject(PdfObject* obj);
+
+    /** Remove the object from the index, before erasing it from
+     *  the ordered list. Another object with the same number, if
+     *  any, is indexed instead
+     */
+    void unindexObject(const iterator& it);
+
+    void rebuildIndex();
+
+    /** Track an object (or its stream) loaded from the input
+     *  device for the memory budget
+     */
+    void trackLoadedObject(const PdfObject& obj, size_t size);
+
+    /** Keep the object loaded when applying the memory budget, as
+     *  other objects hold references to its data
+     */
+    void pinObject(PdfObject& obj);
+
+    /** Track the object as modified, if it's in the list
+     */
+    void trackDirtyObject(PdfObject& obj);
+
+    void untrackDirtyObject(PdfObject& obj);
+
+    /** Collect the modified objects, sorted by reference like the list.
+     *  Objects that are not dirty anymore are purged from the tracked ones
+     */
+    void collectDirtyObjects(std::vector<PdfObject*>& objects) const;
+
+    /** \returns true if the modified objects are tracked, that
+     *      is the list belongs to a document
+     */
+    inline bool tracksDirtyObjects() const { return m_Document != nullptr; }
+
+    /** Synchronize the creation of the objects, their lookups and the
+     *  tracking of their modifications, so distinct objects can be
+     *  modified and new ones created concurrently
+     *  \returns false if observers are attached, as they write
+     *      the objects in the order they are finished
+     *  \see PdfDocument::PaintPages
+     */
+    bool tryBeginConcurrentWrites();
+
+    void endConcurrentWrites();
+
+    std::unique_lock<std::recursive_mutex> lockConcurrentWrites() const;
+
+    /** \returns the cached decoded data of the stream of the object,
+     *      or nullptr if it's not cached. The entry becomes the most
+     *      recently used. The data stays valid if the entry is evicted
+     */
+    std::shared_ptr<const charbuff> findDecodedStream(const PdfObject& obj);
+
+    /** Cache the decoded data of the stream of the object, evicting the
+     *  least recently used entries to respect the budget. Data larger
+     *  than the budget, or not fitting the budget of PdfMemoryGovernor,
+     *  is not cached
+     */
+    void cacheDecodedStream(const PdfObject& obj, const charbuff& data);
+
+    void invalidateDecodedStream(const PdfReference& ref);
+
+    void clearDecodedStreams();
+
+private:
+    struct LoadedObject
+    {
+        PdfReference Reference;
+        size_t Size;
+    };
+
+    struct DecodedStream
+    {
+        PdfReference Reference;
+        std::shared_ptr<const charbuff> Data;
+        size_t Reserved;
+    };
+
+    using DecodedStreamList = std::list<DecodedStream>;
+
+    // Evict the least recently used decoded streams, returning
+    // the size released to PdfMemoryGovernor
+    size_t relieveDecodedStreams(size_t size);
+
+    void eraseDecodedStream(std::unordered_map<PdfReference, DecodedStreamList::iterator>::iterator it);
 
 public:
     /** Iterator pointing at the beginning of the vector
@@ -351,25 +532,132 @@ public:
      */
     inline PdfDocument& GetDocument() const { return *m_Document; }
 
+    /** \returns the executor of the parent document, or
+     *           the default executor if the vector has no parent
+     *  \see PdfDocument::GetExecutor
+     */
+    std::shared_ptr<PdfExecutor> GetExecutor() const;
+
     /**
      *  \returns whether can re-use free object numbers when creating new objects.
      */
     inline bool GetCanReuseObjectNumbers() const { return m_CanReuseObjectNumbers; }
 
-    /** \returns a list of free references in this vector
+    /** \returns a list of free references in this vector, in
+     *      the order they will be reused. The list is not sorted
+     */
+    const PdfReferenceList& GetFreeObjects() const;
+
+    /** Set a budget, in bytes, for the memory of the objects loaded
+     *  on demand from the input device. When the budget is exceeded,
+     *  ApplyMemoryBudget() frees the clean objects in least recently
+     *  used order with PdfParserObject::FreeObjectMemory, and they are
+     *  read again when accessed. The memory of an object is estimated
+     *  with the bytes read from the device for it. The objects of the
+     *  pages retrieved from PdfPageCollection, and of their parent
+     *  nodes, are kept loaded, as the pages reference their data
+     *  \param budget the budget, or 0 to disable it
+     */
+    void SetMemoryBudget(size_t budget);
+
+    /** Free the memory of the least recently used clean objects
+     *  loaded on demand, until the memory budget is respected.
+     *  Objects accessed since the previous call are kept, as
+     *  the least recently used order is approximated.
+     *  It's called when a page is retrieved by index.
+     *  \remarks References to the variants and the streams of
+     *      the freed objects are invalidated
+     */
+    void ApplyMemoryBudget();
+
+    inline size_t GetMemoryBudget() const { return m_MemoryBudget; }
+
+    /** \returns the estimated memory of the objects
+     *      tracked for the memory budget
+     */
+    inline size_t GetLoadedMemory() const { return m_LoadedMemory; }
+
+    /** Set a budget, in bytes, for a cache of the decoded data of the
+     *  streams, so repeated PdfObjectStream::ExtractTo(charbuff&) and
+     *  PdfObjectStream::GetFilteredCopy() calls on an object don't
+     *  decode the stream again. The least recently used entries are
+     *  evicted when the budget is exceeded. An entry is invalidated
+     *  when the stream is written, or when the object is removed
+     *  or replaced
+     *  \param size the budget, or 0 to disable and clear the cache
+     *  \remarks The cached data is reserved from PdfMemoryGovernor too,
+     *      which evicts the least recently used entries under pressure
+     *  \remarks Changes to the /Filter and /DecodeParms keys made
+     *      directly on the stream dictionary are not tracked
+     */
+    void SetDecodedStreamCacheSize(size_t size);
+
+    inline size_t GetDecodedStreamCacheSize() const { return m_DecodedStreamCacheSize; }
+
+    /** \returns the size of the decoded data currently cached
+     */
+    inline size_t GetDecodedStreamMemory() const { return m_DecodedStreamMemory; }
+
+    /** \returns a count incremented every time an object of the list,
+     *  or a direct object nested in it, is modified, removed or replaced,
+     *  or its memory is freed. Used to invalidate the values computed
+     *  from the objects and the pointers to them
+     *  \remarks Changes to the streams are not counted
      */
-    inline const PdfReferenceList& GetFreeObjects() const { return m_FreeObjects; }
+    inline uint64_t GetModificationCount() const { return m_ModificationCount; }
 
 private:
     PdfDocument* m_Document;
     bool m_CanReuseObjectNumbers;
     ObjectList m_Objects;
+    // Objects indexed by object number, for fast lookups. Objects
+    // sharing the same number but with a different generation
+    // are found from the indexed one in the ordered list
+    ObjectIndex m_ObjectIndex;
     unsigned m_ObjectCount;
+    // Free references in reuse order, with a set
+    // to check quickly if a reference is already free
     PdfReferenceList m_FreeObjects;
+    std::unordered_set<PdfReference> m_FreeObjectSet;
     ObjectNumList m_UnavailableObjects;
+    // Objects marked dirty while in the list. The set is a superset
+    // of the dirty objects, as the objects are not untracked when
+    // the dirty flag is reset, e.g. while they are written concurrently
+    mutable ObjectList m_DirtyObjects;
 
     ObserverList m_observers;
+    // Finished objects not yet delivered to the observers
+    std::vector<PdfObject*> m_QueuedObjects;
+    unsigned m_BatchSize;
+    // Count of the stream appends in progress, the queue
+    // is not delivered while a stream is being written
+    unsigned m_AppendingStreams;
     StreamFactory* m_StreamFactory;
+    mutable std::function<void()> m_deferredLoader;
+    // The xref entries of the objects listed by the parser and not
+    // created yet, indexed by object number. The listed entries are
+    // marked as parsed. They back the list, so opening a document
+    // doesn't allocate an object for every entry
+    PdfXRefEntries m_LazyEntries;
+    unsigned m_LazyObjectCount;
+    std::function<PdfObject*(const PdfReference&, const PdfXRefEntry&)> m_LazyObjectFactory;
+    size_t m_MemoryBudget;
+    size_t m_LoadedMemory;
+    std::deque<LoadedObject> m_LoadedObjects;
+    // Cached decoded streams, the most recently used first
+    DecodedStreamList m_DecodedStreams;
+    std::unordered_map<PdfReference, DecodedStreamList::iterator> m_DecodedStreamIndex;
+    size_t m_DecodedStreamCacheSize;
+    size_t m_DecodedStreamMemory;
+    // Guards the decoded streams, which are evicted by
+    // the pressure callback from any thread
+    std::mutex m_DecodedStreamMutex;
+    int m_DecodedStreamCallback;
+    std::atomic<uint64_t> m_ModificationCount;
+    bool m_ConcurrentWrites;
+    // Recursive, as the observers and the lazy objects may look
+    // up other objects while an object is created or loaded
+    mutable std::recursive_mutex m_ConcurrentWritesMutex;
 };
 
 };
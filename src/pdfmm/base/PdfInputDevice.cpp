@@ -27,6 +27,34 @@ bool InputStreamDevice::Peek(char& ch) const
     return peek(ch);
 }
 
+bool InputStreamDevice::TryPeek(bufferview& view) const
+{
+    EnsureAccess(DeviceAccess::Read);
+    return tryPeek(view);
+}
+
+bool InputStreamDevice::TryGetView(bufferview& view) const
+{
+    view = { };
+    return false;
+}
+
+bool InputStreamDevice::tryPeek(bufferview& view) const
+{
+    if (!TryGetView(view))
+        return false;
+
+    size_t position = GetPosition();
+    if (position >= view.size())
+    {
+        view = { };
+        return false;
+    }
+
+    view = view.subspan(position);
+    return true;
+}
+
 void InputStreamDevice::checkRead() const
 {
     EnsureAccess(DeviceAccess::Read);
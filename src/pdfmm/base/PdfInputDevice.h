@@ -33,12 +33,31 @@ public:
      */
     bool Peek(char& ch) const;
 
+    /** Peek at the data following the current position that the
+     * device holds contiguously in memory, without consuming it.
+     * The view is invalidated by the next read or seek operation
+     * \returns true if some data is available, false otherwise
+     */
+    bool TryPeek(bufferview& view) const;
+
+    /** Try to get a view of the whole device data, when it's
+     * stored contiguously in memory. The view is valid as long
+     * as the device is alive and its data is not modified
+     * \returns true if the data is directly accessible, false otherwise
+     */
+    virtual bool TryGetView(bufferview& view) const;
+
 protected:
     /** Peek at next char in stream.
      *  /returns true if success, false if EOF
      */
     virtual bool peek(char& ch) const = 0;
 
+    /** Peek at the data following the current position
+     * The default implementation uses TryGetView()
+     */
+    virtual bool tryPeek(bufferview& view) const;
+
     void checkRead() const override;
 };
 
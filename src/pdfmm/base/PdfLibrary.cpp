@@ -0,0 +1,59 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfLibrary.h"
+
+#include <pdfmm/private/FreetypePrivate.h>
+#include <pdfmm/private/XmlUtils.h>
+#include <pdfmm/private/PdfEncodingPrivate.h>
+
+#include "PdfEncodingMapFactory.h"
+#include "PdfFontMetricsStandard14.h"
+#include "PdfFontManager.h"
+#include "PdfName.h"
+
+using namespace std;
+using namespace mm;
+
+static void warmupEncodingMap(const PdfEncodingMapConstPtr& map);
+
+void PdfLibrary::Warmup()
+{
+    (void)utls::GetInvariantLocale();
+    (void)PdfName("Type");
+    (void)mm::GetFreeTypeLibrary();
+    utls::InitXml();
+
+    string pdfdocenc;
+    (void)mm::TryConvertUTF8ToPdfDocEncoding("\xE2\x82\xAC", pdfdocenc);
+
+    // Build the reverse tables of the predefined encodings
+    warmupEncodingMap(PdfEncodingMapFactory::WinAnsiEncodingInstance());
+    warmupEncodingMap(PdfEncodingMapFactory::MacRomanEncodingInstance());
+    warmupEncodingMap(PdfEncodingMapFactory::MacExpertEncodingInstance());
+    warmupEncodingMap(PdfEncodingMapFactory::TwoBytesHorizontalIdentityEncodingInstance());
+    warmupEncodingMap(PdfEncodingMapFactory::TwoBytesVerticalIdentityEncodingInstance());
+
+    for (unsigned i = (unsigned)PdfStandard14FontType::TimesRoman;
+        i <= (unsigned)PdfStandard14FontType::ZapfDingbats; i++)
+    {
+        auto stdFont = (PdfStandard14FontType)i;
+        (void)PdfFontMetricsStandard14::GetInstance(stdFont);
+        warmupEncodingMap(PdfEncodingMapFactory::GetStandard14FontEncodingMap(stdFont));
+    }
+
+#ifdef PDFMM_HAVE_FONTCONFIG
+    (void)PdfFontManager::GetFontConfigWrapper().GetFcConfig();
+#endif // PDFMM_HAVE_FONTCONFIG
+}
+
+void warmupEncodingMap(const PdfEncodingMapConstPtr& map)
+{
+    PdfCharCode code;
+    (void)map->TryGetCharCode(U' ', code);
+}
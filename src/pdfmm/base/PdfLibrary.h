@@ -0,0 +1,42 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_LIBRARY_H
+#define PDF_LIBRARY_H
+
+#include "PdfDeclarations.h"
+
+namespace mm {
+
+/** Process wide operations of the library
+ *
+ * The static tables and services of the library, such as the
+ * metrics of the standard 14 fonts, the predefined encodings,
+ * libxml2, FreeType and fontconfig, are initialized on their
+ * first use, so short lived processes pay only for what they use
+ */
+class PDFMM_API PdfLibrary final
+{
+public:
+    PdfLibrary() = delete;
+
+public:
+    /** Initialize ahead of time the static tables and services
+     * that would be initialized on their first use
+     *
+     * Long running services can call this at startup, so the
+     * cost is not paid while handling the first requests.
+     * It's thread safe and it can be called more than once
+     * \remarks It loads the fontconfig configuration, if the
+     * library was built with fontconfig support
+     */
+    static void Warmup();
+};
+
+};
+
+#endif // PDF_LIBRARY_H
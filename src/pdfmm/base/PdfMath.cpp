@@ -123,12 +123,7 @@ void Matrix::ToArray(double arr[6]) const
 void Matrix::ToArray(PdfArray& arr) const
 {
     arr.Clear();
-    arr.Add(m_mat[0]);
-    arr.Add(m_mat[1]);
-    arr.Add(m_mat[2]);
-    arr.Add(m_mat[3]);
-    arr.Add(m_mat[4]);
-    arr.Add(m_mat[5]);
+    arr.AddReals(m_mat);
 }
 
 bool Matrix::operator==(const Matrix& m) const
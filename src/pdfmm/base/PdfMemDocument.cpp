@@ -15,7 +15,9 @@
 #include "PdfParser.h"
 #include "PdfArray.h"
 #include "PdfDictionary.h"
+#include "PdfExecutor.h"
 #include "PdfImmediateWriter.h"
+#include "PdfMergeContext.h"
 #include "PdfObject.h"
 #include "PdfParserObject.h"
 #include "PdfObjectStream.h"
@@ -30,6 +32,7 @@
 #include "PdfOutlines.h"
 #include "PdfPage.h"
 #include "PdfPageCollection.h"
+#include "PdfSnapshotSerializer.h"
 #include "PdfStreamDevice.h"
 
 using namespace std;
@@ -38,12 +41,17 @@ using namespace mm;
 PdfMemDocument::PdfMemDocument()
     : PdfMemDocument(false) { }
 
-PdfMemDocument::PdfMemDocument(bool empty) :
-    PdfDocument(empty),
+PdfMemDocument::PdfMemDocument(pmr::memory_resource* resource)
+    : PdfMemDocument(false, resource) { }
+
+PdfMemDocument::PdfMemDocument(bool empty, pmr::memory_resource* resource) :
+    PdfDocument(empty, resource),
     m_Version(PdfVersionDefault),
     m_InitialVersion(PdfVersionDefault),
     m_HasXRefStream(false),
-    m_PrevXRefOffset(-1)
+    m_IsFrozen(false),
+    m_PrevXRefOffset(-1),
+    m_ObjectStreamSize(0)
 {
 }
 
@@ -61,7 +69,9 @@ PdfMemDocument::PdfMemDocument(const PdfMemDocument& rhs) :
     m_Version(rhs.m_Version),
     m_InitialVersion(rhs.m_InitialVersion),
     m_HasXRefStream(rhs.m_HasXRefStream),
-    m_PrevXRefOffset(rhs.m_PrevXRefOffset)
+    m_IsFrozen(false),
+    m_PrevXRefOffset(rhs.m_PrevXRefOffset),
+    m_ObjectStreamSize(rhs.m_ObjectStreamSize)
 {
     auto encryptObj = GetTrailer().GetDictionary().FindKey("Encrypt");
     if (encryptObj != nullptr)
@@ -85,9 +95,14 @@ void PdfMemDocument::Clear()
 void PdfMemDocument::clear()
 {
     m_HasXRefStream = false;
+    m_IsFrozen = false;
     m_PrevXRefOffset = -1;
     m_Encrypt = nullptr;
+    m_LoadedEncrypt = nullptr;
+    m_ParserStats = nullptr;
+    PdfDocument::GetObjects().SetDeferredLoader(nullptr);
     m_device = nullptr;
+    m_previousDevices.clear();
 }
 
 void PdfMemDocument::initFromParser(PdfParser& parser)
@@ -112,49 +127,130 @@ void PdfMemDocument::initFromParser(PdfParser& parser)
     {
         // All PdfParser instances have a pointer to a PdfEncrypt object.
         // So we have to take ownership of it (command the parser to give it).
-        m_Encrypt = parser.TakeEncrypt();
+        // NOTE: The objects not loaded yet and the strings still encrypted
+        // refer to the loaded encryption, that is kept and never replaced
+        m_LoadedEncrypt = parser.TakeEncrypt();
+        m_Encrypt = PdfEncrypt::CreatePdfEncrypt(*m_LoadedEncrypt);
     }
 
+    auto stats = parser.GetStats();
+    if (stats != nullptr)
+        m_ParserStats.reset(new PdfParserStats(*stats));
+
     Init();
 }
 
-void PdfMemDocument::Load(const string_view& filename, const string_view& password)
+void PdfMemDocument::Load(const string_view& filename, const string_view& password, PdfLoadOptions opts)
 {
     if (filename.length() == 0)
         PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
 
-    auto device = std::make_shared<FileStreamDevice>(filename);
-    LoadFromDevice(device, password);
+    // Map the file in memory so the parser reads straight from the page cache
+    auto device = std::make_shared<MappedFileStreamDevice>(filename);
+    LoadFromDevice(device, password, opts);
 }
 
-void PdfMemDocument::LoadFromBuffer(const bufferview& buffer, const string_view& password)
+void PdfMemDocument::LoadFromBuffer(const bufferview& buffer, const string_view& password, PdfLoadOptions opts)
 {
     if (buffer.size() == 0)
         PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
 
     auto device = std::make_shared<SpanStreamDevice>(buffer);
-    LoadFromDevice(device, password);
+    LoadFromDevice(device, password, opts);
 }
 
-void PdfMemDocument::LoadFromDevice(const shared_ptr<InputStreamDevice>& device, const string_view& password)
+void PdfMemDocument::LoadFromDevice(const shared_ptr<InputStreamDevice>& device, const string_view& password, PdfLoadOptions opts)
 {
     if (device == nullptr)
         PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
 
     this->Clear();
-    loadFromDevice(device, password);
+    loadFromDevice(device, password, opts);
+}
+
+future<void> PdfMemDocument::LoadAsync(const string_view& filename, const string_view& password, PdfLoadOptions opts)
+{
+    if (filename.length() == 0)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    return GetExecutor()->RunAsync([this, filepath = string(filename), passwd = string(password), opts]()
+    {
+        this->Load(filepath, passwd, opts);
+    });
+}
+
+future<void> PdfMemDocument::LoadFromDeviceAsync(const shared_ptr<InputStreamDevice>& device,
+    const string_view& password, PdfLoadOptions opts)
+{
+    if (device == nullptr)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    return GetExecutor()->RunAsync([this, device, passwd = string(password), opts]()
+    {
+        this->LoadFromDevice(device, passwd, opts);
+    });
+}
+
+future<void> PdfMemDocument::LoadObjectsAsync(vector<PdfReference> references)
+{
+    return GetExecutor()->RunAsync([this, references = std::move(references)]()
+    {
+        auto& objects = this->GetObjects();
+        for (auto& ref : references)
+        {
+            auto obj = objects.GetObject(ref);
+            if (obj != nullptr)
+                obj->ForceLoad();
+        }
+    });
+}
+
+void PdfMemDocument::Reset()
+{
+    this->Clear();
+    m_Version = PdfVersionDefault;
+    m_InitialVersion = PdfVersionDefault;
+    InitEmpty();
 }
 
-void PdfMemDocument::loadFromDevice(const shared_ptr<InputStreamDevice>& device, const string_view& password)
+void PdfMemDocument::loadFromDevice(const shared_ptr<InputStreamDevice>& device, const string_view& password, PdfLoadOptions opts)
 {
     m_device = device;
+    PdfMemoryResourceScope scope(GetMemoryResource());
+    bool collectStats = (opts & PdfLoadOptions::CollectParserStats) != PdfLoadOptions::None;
+    bool rebuildXRef = (opts & PdfLoadOptions::RebuildBrokenXRef) != PdfLoadOptions::None;
+
+    // Reuse the parser of the previous load, that keeps its
+    // buffers and the capacity of the xref entries
+    if (m_parser == nullptr)
+        m_parser = std::make_shared<PdfParser>(PdfDocument::GetObjects());
 
-    // Call parse file instead of using the constructor
-    // so that m_Parser is initialized for encrypted documents
-    PdfParser parser(PdfDocument::GetObjects());
-    parser.SetPassword(password);
-    parser.Parse(*device, true);
-    initFromParser(parser);
+    auto parser = m_parser;
+    parser->SetPassword(password);
+    parser->SetCollectStats(collectStats);
+    parser->SetRebuildBrokenXRef(rebuildXRef);
+
+    if ((opts & PdfLoadOptions::FirstPageOnly) != PdfLoadOptions::None)
+    {
+        // The parser must survive the loading to read the
+        // deferred main xref section of linearized files
+        if (parser->ParseFirstPage(*device, true))
+        {
+            PdfDocument::GetObjects().SetDeferredLoader([this, parser]()
+            {
+                PdfMemoryResourceScope scope(GetMemoryResource());
+                parser->ParseDeferredXRef(*m_device);
+                if (m_ParserStats != nullptr)
+                    *m_ParserStats = *parser->GetStats();
+            });
+        }
+
+        initFromParser(*parser);
+        return;
+    }
+
+    parser->Parse(*device, true);
+    initFromParser(*parser);
 }
 
 void PdfMemDocument::AddPdfExtension(const PdfName& ns, int64_t level)
@@ -238,8 +334,9 @@ void PdfMemDocument::RemovePdfExtension(const PdfName& ns, int64_t level)
 
 void PdfMemDocument::Save(const string_view& filename, PdfSaveOptions options)
 {
-    FileStreamDevice device(filename, FileMode::Create);
+    BufferedFileStreamDevice device(filename, FileMode::Create);
     this->Save(device, options);
+    device.Close();
 }
 
 void PdfMemDocument::Save(OutputStreamDevice& device, PdfSaveOptions opts)
@@ -249,6 +346,11 @@ void PdfMemDocument::Save(OutputStreamDevice& device, PdfSaveOptions opts)
     PdfWriter writer(this->GetObjects(), this->GetTrailer().GetObject());
     writer.SetPdfVersion(this->GetPdfVersion());
     writer.SetSaveOptions(opts);
+    if ((opts & PdfSaveOptions::CompressObjects) != PdfSaveOptions::None)
+        writer.SetUseXRefStream(true);
+
+    if (m_ObjectStreamSize != 0)
+        writer.SetObjectStreamSize(m_ObjectStreamSize);
 
     if (m_Encrypt != nullptr)
         writer.SetEncrypted(*m_Encrypt);
@@ -264,6 +366,33 @@ void PdfMemDocument::Save(OutputStreamDevice& device, PdfSaveOptions opts)
     }
 }
 
+future<void> PdfMemDocument::SaveAsync(const string_view& filename, PdfSaveOptions opts)
+{
+    return std::async(std::launch::async, [this, filepath = string(filename), opts]()
+    {
+        BufferedFileStreamDevice file(filepath, FileMode::Create);
+        {
+            AsyncStreamDevice device(file);
+            this->Save(device, opts);
+            device.Close();
+        }
+        file.Close();
+    });
+}
+
+future<void> PdfMemDocument::SaveAsync(const shared_ptr<OutputStreamDevice>& device, PdfSaveOptions opts)
+{
+    if (device == nullptr)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    return std::async(std::launch::async, [this, device, opts]()
+    {
+        AsyncStreamDevice asyncDevice(*device);
+        this->Save(asyncDevice, opts);
+        asyncDevice.Flush();
+    });
+}
+
 void PdfMemDocument::SaveUpdate(const string_view& filename, PdfSaveOptions opts)
 {
     FileStreamDevice device(filename, FileMode::Append);
@@ -278,8 +407,12 @@ void PdfMemDocument::SaveUpdate(OutputStreamDevice& device, PdfSaveOptions opts)
     writer.SetPdfVersion(this->GetPdfVersion());
     writer.SetSaveOptions(opts);
     writer.SetPrevXRefOffset(m_PrevXRefOffset);
+    // NOTE: Objects are compressed only if the
+    // original file already has an XRef stream
     writer.SetUseXRefStream(m_HasXRefStream);
     writer.SetIncrementalUpdate(false);
+    if (m_ObjectStreamSize != 0)
+        writer.SetObjectStreamSize(m_ObjectStreamSize);
 
     if (m_Encrypt != nullptr)
         writer.SetEncrypted(*m_Encrypt);
@@ -304,6 +437,81 @@ void PdfMemDocument::SaveUpdate(OutputStreamDevice& device, PdfSaveOptions opts)
     }
 }
 
+void PdfMemDocument::LoadUpdateFromDevice(const shared_ptr<InputStreamDevice>& device)
+{
+    if (device == nullptr)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    if (m_parser == nullptr || m_device == nullptr || m_PrevXRefOffset < 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "The document was not loaded from a device");
+
+    PdfMemoryResourceScope scope(GetMemoryResource());
+    m_parser->ParseUpdate(*device, (size_t)m_PrevXRefOffset);
+    m_PrevXRefOffset = (int64_t)m_parser->GetXRefOffset();
+    m_InitialVersion = GetPdfVersion();
+    m_previousDevices.push_back(std::move(m_device));
+    m_device = device;
+}
+
+void PdfMemDocument::LoadUpdateFromBuffer(const bufferview& buffer)
+{
+    if (buffer.size() == 0)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    LoadUpdateFromDevice(std::make_shared<SpanStreamDevice>(buffer));
+}
+
+void PdfMemDocument::SaveSnapshot(const string_view& filename)
+{
+    FileStreamDevice device(filename, FileMode::Create);
+    this->SaveSnapshot(device);
+}
+
+void PdfMemDocument::SaveSnapshot(OutputStreamDevice& device)
+{
+    PdfSnapshotSerializer serializer(*this);
+    serializer.Write(m_device.get(), device);
+}
+
+void PdfMemDocument::LoadSnapshot(const string_view& snapshotFilename, const string_view& sourceFilename)
+{
+    if (snapshotFilename.length() == 0)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    auto snapshot = std::make_shared<MappedFileStreamDevice>(snapshotFilename);
+    shared_ptr<InputStreamDevice> source;
+    if (sourceFilename.length() != 0)
+        source = std::make_shared<MappedFileStreamDevice>(sourceFilename);
+
+    LoadFromSnapshot(snapshot, source);
+}
+
+void PdfMemDocument::LoadFromSnapshot(const shared_ptr<InputStreamDevice>& snapshot,
+    const shared_ptr<InputStreamDevice>& source)
+{
+    if (snapshot == nullptr)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    this->Clear();
+    m_device = source;
+    PdfMemoryResourceScope scope(GetMemoryResource());
+
+    // Read the snapshot in place when it's mapped in memory
+    bufferview view;
+    charbuff buffer;
+    if (!snapshot->TryGetView(view))
+    {
+        buffer.resize(snapshot->GetLength());
+        snapshot->Seek(0);
+        snapshot->Read(buffer.data(), buffer.size());
+        view = buffer;
+    }
+
+    PdfSnapshotSerializer serializer(*this);
+    serializer.Read(view, source.get());
+    Init();
+}
+
 void PdfMemDocument::beforeWrite(PdfSaveOptions opts)
 {
     if ((opts & PdfSaveOptions::NoModifyDateUpdate) ==
@@ -363,6 +571,16 @@ const PdfMemDocument& PdfMemDocument::InsertPages(const PdfMemDocument& doc, uns
     return *this;
 }
 
+const PdfMemDocument& PdfMemDocument::InsertPages(const PdfMemDocument& doc, unsigned atIndex, unsigned pageCount,
+    PdfMergeContext& context)
+{
+    if (&context.GetDocument() != this)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The merge context was created for another document");
+
+    context.insertPages(doc, atIndex, pageCount);
+    return *this;
+}
+
 void PdfMemDocument::SetEncrypted(const string& userPassword, const string& ownerPassword,
     PdfPermissions protection, PdfEncryptAlgorithm algorithm,
     PdfKeyLength keyLength)
@@ -385,6 +603,9 @@ void PdfMemDocument::FreeObjectMemory(PdfObject* obj, bool force)
     if (obj == nullptr)
         PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
 
+    if (m_IsFrozen)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Object memory can't be freed in a frozen document");
+
     PdfParserObject* parserObject = dynamic_cast<PdfParserObject*>(obj);
     if (parserObject == nullptr)
     {
@@ -395,6 +616,76 @@ void PdfMemDocument::FreeObjectMemory(PdfObject* obj, bool force)
     parserObject->FreeObjectMemory(force);
 }
 
+void PdfMemDocument::SetMemoryBudget(size_t budget)
+{
+    if (m_IsFrozen && budget != 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "The memory budget can't be set in a frozen document");
+
+    GetObjects().SetMemoryBudget(budget);
+}
+
+void PdfMemDocument::Freeze()
+{
+    if (m_IsFrozen)
+        return;
+
+    auto& objects = GetObjects();
+    objects.SetMemoryBudget(0);
+    for (auto obj : objects)
+        obj->ForceLoad();
+
+    GetTrailer().GetObject().ForceLoad();
+
+    // Resolve also the inherited attributes of the pages, so
+    // the caches of the pages are not filled concurrently
+    const auto& pages = GetPages();
+    for (unsigned i = 0; i < pages.GetCount(); i++)
+    {
+        auto& page = pages.GetPage(i);
+        (void)page.GetArtBox();
+        (void)page.GetTrimBox();
+        (void)page.GetBleedBox();
+        (void)page.GetRotationRaw();
+    }
+
+    m_IsFrozen = true;
+}
+
+size_t PdfMemDocument::GetMemoryBudget() const
+{
+    return GetObjects().GetMemoryBudget();
+}
+
+void PdfMemDocument::SetObjectStreamSize(unsigned size)
+{
+    m_ObjectStreamSize = size;
+}
+
+PdfMemoryStats PdfMemDocument::GetMemoryStats() const
+{
+    PdfMemoryStats stats;
+    auto& objects = GetObjects();
+    for (auto obj : objects)
+    {
+        obj->CollectMemoryUsage(stats);
+        stats.ObjectCount++;
+    }
+
+    GetTrailer().GetObject().CollectMemoryUsage(stats);
+    stats.ParserCache += objects.m_LoadedObjects.size() * sizeof(PdfIndirectObjectList::LoadedObject);
+
+    // Fonts loaded from the document use a stream
+    // object for their data, they are already accounted
+    auto& fontManager = const_cast<PdfMemDocument&>(*this).GetFontManager();
+    for (auto& pair : fontManager.m_importedFonts)
+    {
+        for (auto font : pair.second)
+            stats.Fonts += font->GetMetrics().GetOrLoadFontFileData().size();
+    }
+
+    return stats;
+}
+
 const PdfEncrypt* PdfMemDocument::GetEncrypt() const
 {
     return m_Encrypt.get();
@@ -409,3 +700,9 @@ PdfVersion PdfMemDocument::GetPdfVersion() const
 {
     return m_Version;
 }
+
+bool PdfMemDocument::TryFreeze()
+{
+    Freeze();
+    return true;
+}
@@ -13,9 +13,13 @@
 #include "PdfExtension.h"
 #include "PdfInputDevice.h"
 
+#include <future>
+
 namespace mm {
 
+class PdfMergeContext;
 class PdfParser;
+struct PdfParserStats;
 class PdfWriter;
 
 /** PdfMemDocument is the core class for reading and manipulating
@@ -37,7 +41,9 @@ class PdfWriter;
  */
 class PDFMM_API PdfMemDocument final : public PdfDocument
 {
+    friend class PdfDocumentDiff;
     friend class PdfWriter;
+    friend class PdfSnapshotSerializer;
 
 public:
     /** Construct a new PdfMemDocument
@@ -46,6 +52,20 @@ public:
 
     PdfMemDocument(const std::shared_ptr<InputStreamDevice>& device, const std::string_view& password = { });
 
+    /** Construct a new PdfMemDocument allocating its objects from a memory resource
+     *
+     *  The resource is current while the document creates objects and loads
+     *  them, also on demand, so a per job arena can release the memory of
+     *  the document at once. It must outlive every object and value allocated
+     *  from it, not only the document: objects removed with
+     *  PdfIndirectObjectList::RemoveObject, dictionaries, arrays and strings
+     *  moved or copied out of the document, and values created while a
+     *  PdfMemoryResourceScope of the resource is current still return
+     *  their memory to it when they are destroyed
+     *  \see PdfMemoryResource
+     */
+    explicit PdfMemDocument(std::pmr::memory_resource* resource);
+
     /** Construct a copy of the given document
      */
     PdfMemDocument(const PdfMemDocument& rhs);
@@ -56,12 +76,17 @@ public:
      *
      *  \param filename filename of the file which is going to be parsed/opened
      *
+     *  The file is mapped in memory with a MappedFileStreamDevice.
+     *  Use LoadFromDevice with a FileStreamDevice to read it
+     *  through a regular file stream instead.
+     *
      *  When the bForUpdate is set to true, the filename is copied
      *  for later use by WriteUpdate.
      *
      *  \see WriteUpdate, LoadFromBuffer, LoadFromDevice
      */
-    void Load(const std::string_view& filename, const std::string_view& password = { });
+    void Load(const std::string_view& filename, const std::string_view& password = { },
+        PdfLoadOptions opts = PdfLoadOptions::None);
 
     /** Load a PdfMemDocument from a buffer in memory
      *
@@ -69,15 +94,65 @@ public:
      *
      *  \see WriteUpdate, Load, LoadFromDevice
      */
-    void LoadFromBuffer(const bufferview& buffer, const std::string_view& password = { });
+    void LoadFromBuffer(const bufferview& buffer, const std::string_view& password = { },
+        PdfLoadOptions opts = PdfLoadOptions::None);
 
     /** Load a PdfMemDocument from a PdfRefCountedInputDevice
      *
      *  \param device the input device containing the PDF
+     *  \param opts with PdfLoadOptions::FirstPageOnly only the first-page
+     *      section of linearized files is read at first: the rest of the
+     *      objects is read as soon as an object outside that section is
+     *      requested, or when the whole object list is accessed
      *
      *  \see WriteUpdate, Load, LoadFromBuffer
      */
-    void LoadFromDevice(const std::shared_ptr<InputStreamDevice>& device, const std::string_view& password = { });
+    void LoadFromDevice(const std::shared_ptr<InputStreamDevice>& device, const std::string_view& password = { },
+        PdfLoadOptions opts = PdfLoadOptions::None);
+
+    /** Load a PdfMemDocument from a file without blocking the calling thread
+     *
+     *  The document is loaded by a task of the executor of the document,
+     *  see PdfDocument::GetExecutor(), so slow devices like a
+     *  RangeStreamDevice don't need a thread per document. The document
+     *  must not be accessed or destroyed until the returned future is ready
+     *
+     *  \returns a future that is ready when the document has been loaded.
+     *      It rethrows the error of the loading, if any
+     *  \see Load
+     */
+    std::future<void> LoadAsync(const std::string_view& filename, const std::string_view& password = { },
+        PdfLoadOptions opts = PdfLoadOptions::None);
+
+    /** Load a PdfMemDocument from a device without blocking the calling thread
+     *
+     *  \see LoadAsync(const std::string_view&, const std::string_view&, PdfLoadOptions)
+     */
+    std::future<void> LoadFromDeviceAsync(const std::shared_ptr<InputStreamDevice>& device,
+        const std::string_view& password = { }, PdfLoadOptions opts = PdfLoadOptions::None);
+
+    /** Load the given objects and their streams, that are otherwise read
+     *  on demand, without blocking the calling thread
+     *
+     *  The objects are loaded with PdfObject::ForceLoad() by a task of
+     *  the executor of the document. The document must not be accessed
+     *  or destroyed until the returned future is ready
+     *
+     *  \param references the objects to load. The missing ones are ignored
+     *  \returns a future that is ready when the objects have been loaded.
+     *      It rethrows the error of the loading, if any
+     */
+    std::future<void> LoadObjectsAsync(std::vector<PdfReference> references);
+
+    /** Discard the contents of the document, making it a new empty document
+     *
+     *  The parser used by the loads and the capacity of the object
+     *  tables are kept, so a document reset and loaded again in a loop
+     *  does little allocator traffic. Documents created with a pooling
+     *  memory resource also reuse the memory of the released objects
+     *  \see PdfMemDocument(std::pmr::memory_resource*)
+     */
+    void Reset();
 
     /** Save the complete document to a file
      *
@@ -97,6 +172,29 @@ public:
      */
     void Save(OutputStreamDevice& device, PdfSaveOptions opts = PdfSaveOptions::None);
 
+    /** Save the complete document to a file without blocking the calling thread
+     *
+     *  The document is serialized on a worker thread, while the data is
+     *  written to the file by a dedicated I/O thread. The document must
+     *  not be modified or destroyed until the returned future is ready
+     *
+     *  \param filename filename of the document
+     *  \returns a future that is ready when the document has been written.
+     *      It rethrows the error of the saving, if any
+     *
+     *  \see Save
+     */
+    std::future<void> SaveAsync(const std::string_view& filename, PdfSaveOptions opts = PdfSaveOptions::None);
+
+    /** Save the complete document to an output device without blocking the calling thread
+     *
+     *  \param device write to this output device. It's retained until the
+     *      returned future is ready
+     *  \see SaveAsync(const std::string_view&, PdfSaveOptions)
+     */
+    std::future<void> SaveAsync(const std::shared_ptr<OutputStreamDevice>& device,
+        PdfSaveOptions opts = PdfSaveOptions::None);
+
     /** Save the document changes to a file
      *
      *  \param filename filename of the document
@@ -129,6 +227,70 @@ public:
      */
     void SaveUpdate(OutputStreamDevice& device, PdfSaveOptions opts = PdfSaveOptions::None);
 
+    /** Absorb an incremental update of the document written with SaveUpdate
+     *
+     *  Only the cross-reference section and the trailer appended by the
+     *  update are read, and the objects written by it are rebased to the
+     *  updated file and are no longer dirty, so a following SaveUpdate
+     *  writes only the later changes. This avoids loading again the whole
+     *  file between the steps of an incremental workflow, like signing
+     *  and then adding a timestamp
+     *
+     *  \param device the updated file, that must start with the data
+     *      of the device the document was loaded from. It replaces it
+     *      as the source device of the document
+     *  \see SaveUpdate
+     */
+    void LoadUpdateFromDevice(const std::shared_ptr<InputStreamDevice>& device);
+
+    /** Absorb an incremental update of the document written with SaveUpdate
+     *
+     *  \param buffer the updated file. It must outlive the document
+     *  \see LoadUpdateFromDevice
+     */
+    void LoadUpdateFromBuffer(const bufferview& buffer);
+
+    /** Save a binary snapshot of the object graph of the document to a file
+     *
+     *  The snapshot stores the objects, the trailer and the free object
+     *  list in a compact form. The streams that are still in the source
+     *  document are stored as their offsets in it, so the snapshot can be
+     *  loaded only together with the same source. Loading a snapshot skips
+     *  the tokenization and the xref reconstruction of the source
+     *
+     *  \param filename the filename of the snapshot
+     *  \remarks Encrypted documents are not supported
+     *  \see LoadSnapshot
+     */
+    void SaveSnapshot(const std::string_view& filename);
+
+    /** Save a binary snapshot of the object graph of the document to an output device
+     *
+     *  \see SaveSnapshot(const std::string_view&)
+     */
+    void SaveSnapshot(OutputStreamDevice& device);
+
+    /** Load a PdfMemDocument from a snapshot saved with SaveSnapshot
+     *
+     *  The snapshot file is memory mapped
+     *
+     *  \param snapshotFilename the filename of the snapshot
+     *  \param sourceFilename the filename of the document the snapshot was saved from
+     *  \see SaveSnapshot, LoadFromSnapshot
+     */
+    void LoadSnapshot(const std::string_view& snapshotFilename, const std::string_view& sourceFilename);
+
+    /** Load a PdfMemDocument from a snapshot saved with SaveSnapshot
+     *
+     *  \param snapshot the device of the snapshot
+     *  \param source the device of the document the snapshot was saved from,
+     *      or nullptr if the document was not loaded from a device
+     *  	hrows PdfError with PdfErrorCode::InvalidHandle if the source
+     *      doesn't match the snapshot
+     */
+    void LoadFromSnapshot(const std::shared_ptr<InputStreamDevice>& snapshot,
+        const std::shared_ptr<InputStreamDevice>& source);
+
     /** Add a vendor-specific extension to the current PDF version.
      *  \param ns namespace of the extension
      *  \param level level of the extension
@@ -186,6 +348,21 @@ public:
      */
     const PdfMemDocument& InsertPages(const PdfMemDocument& doc, unsigned atIndex, unsigned pageCount);
 
+    /** Copies one or more pages from another PdfMemDocument to the
+     *  end of this document, using the state of a merge that
+     *  persists across calls, so the objects shared by the
+     *  inserted pages and the identical resources of different
+     *  documents are copied only once
+     *  \param doc the document to append
+     *  \param atIndex the first page number to copy (0-based)
+     *  \param pageCount the number of pages to copy
+     *  \param context the merge context, created for this document
+     *  \returns this document
+     *  \see PdfMergeContext
+     */
+    const PdfMemDocument& InsertPages(const PdfMemDocument& doc, unsigned atIndex, unsigned pageCount,
+        PdfMergeContext& context);
+
     /** Tries to free all memory allocated by the given
      *  PdfObject (variables and streams) and reads
      *  it from disk again if it is requested another time.
@@ -225,8 +402,63 @@ public:
      */
     void FreeObjectMemory(PdfObject* obj, bool force = false);
 
+    /** Set a budget, in bytes, for the memory of the objects loaded
+     *  on demand. When it's exceeded, clean objects are freed in least
+     *  recently used order with FreeObjectMemory() and they are read
+     *  again from the input device when accessed. The budget is applied
+     *  when a page is retrieved by index, so references to the variants
+     *  and the streams of the objects should not be kept across pages
+     *  \param budget the budget, or 0 to disable it
+     *  \see PdfIndirectObjectList::SetMemoryBudget
+     */
+    void SetMemoryBudget(size_t budget);
+
+    size_t GetMemoryBudget() const;
+
+    /** Freeze the document for concurrent read access. All the objects,
+     *  their streams and their nested arrays are loaded, the page cache
+     *  and the inherited attributes of the pages are filled and the
+     *  memory budget is disabled, so that reading the
+     *  document doesn't load anything anymore.
+     *
+     *  After freezing, many threads can read the document at the same
+     *  time, as long as they access the objects through const references
+     *  only: non-const accessors like PdfObject::GetDictionary() set the
+     *  dirty flag. Pages can be retrieved with the const overloads of
+     *  PdfPageCollection::GetPage() and fonts with
+     *  PdfFontManager::GetLoadedFont(), which is internally synchronized.
+     *  The document must not be modified while frozen
+     *  \remarks Loading or clearing the document unfreezes it
+     */
+    void Freeze();
+
+    /** \returns true if the document has been frozen for concurrent read access
+     *  \see Freeze
+     */
+    inline bool IsFrozen() const { return m_IsFrozen; }
+
+    /** Set the maximum count of objects packed in a single object
+     *  stream when saving with PdfSaveOptions::CompressObjects
+     *  \param size the count of objects, or 0 to use the default of
+     *      PdfWriter, which is 100
+     */
+    void SetObjectStreamSize(unsigned size);
+
+    inline unsigned GetObjectStreamSize() const { return m_ObjectStreamSize; }
+
+    /** \returns the estimated memory used by the document, broken
+     *      down by category. Objects not loaded yet are not loaded
+     *  \see PdfObject::CollectMemoryUsage
+     */
+    PdfMemoryStats GetMemoryStats() const;
+
     const PdfEncrypt* GetEncrypt() const override;
 
+    /** \returns the parser statistics of the last load, or nullptr
+     *      if it was not requested with PdfLoadOptions::CollectParserStats
+     */
+    inline const PdfParserStats* GetParserStats() const { return m_ParserStats.get(); }
+
 protected:
     /** Set the PDF Version of the document. Has to be called before Write() to
      *  have an effect.
@@ -236,11 +468,14 @@ protected:
 
     PdfVersion GetPdfVersion() const override;
 
+    bool TryFreeze() override;
+
 private:
-    PdfMemDocument(bool empty);
+    PdfMemDocument(bool empty, std::pmr::memory_resource* resource = nullptr);
 
 private:
-    void loadFromDevice(const std::shared_ptr<InputStreamDevice>& device, const std::string_view& password);
+    void loadFromDevice(const std::shared_ptr<InputStreamDevice>& device, const std::string_view& password,
+        PdfLoadOptions opts = PdfLoadOptions::None);
 
     /** Deletes one or more pages from this document
      *  It does NOT remove any PdfObjects from memory - just the reference from the pages tree.
@@ -273,9 +508,17 @@ private:
     PdfVersion m_Version;
     PdfVersion m_InitialVersion;
     bool m_HasXRefStream;
+    bool m_IsFrozen;
     int64_t m_PrevXRefOffset;
+    unsigned m_ObjectStreamSize;
     std::unique_ptr<PdfEncrypt> m_Encrypt;
+    std::unique_ptr<PdfEncrypt> m_LoadedEncrypt;
+    std::unique_ptr<PdfParserStats> m_ParserStats;
     std::shared_ptr<InputStreamDevice> m_device;
+    // The devices replaced by updates, still read by the objects not rewritten
+    std::vector<std::shared_ptr<InputStreamDevice>> m_previousDevices;
+    // NOTE: Kept between the loads to reuse its buffers
+    std::shared_ptr<PdfParser> m_parser;
 };
 
 };
@@ -0,0 +1,159 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfMemoryGovernor.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+using namespace std;
+using namespace mm;
+
+namespace
+{
+    struct PressureCallbacks
+    {
+        // NOTE: It's held while the callbacks run, so a removed
+        // callback is guaranteed not to be running anymore
+        mutex Mutex;
+        unsigned NextId = 0;
+        map<unsigned, PdfMemoryPressureCallback> Callbacks;
+    };
+
+    // Mark the thread running the pressure callbacks, so
+    // a reservation made by them doesn't run them again
+    class RelievingScope final
+    {
+    public:
+        RelievingScope();
+        ~RelievingScope();
+    };
+}
+
+static PressureCallbacks& getPressureCallbacks();
+static bool tryAdd(size_t size, size_t budget);
+static bool relievePressure(size_t size, size_t budget);
+
+static atomic<size_t> s_budget(0);
+static atomic<size_t> s_usage(0);
+static thread_local bool t_relieving = false;
+
+void PdfMemoryGovernor::SetBudget(size_t budget)
+{
+    s_budget.store(budget, memory_order_relaxed);
+}
+
+size_t PdfMemoryGovernor::GetBudget()
+{
+    return s_budget.load(memory_order_relaxed);
+}
+
+size_t PdfMemoryGovernor::GetUsage()
+{
+    return s_usage.load(memory_order_relaxed);
+}
+
+unsigned PdfMemoryGovernor::AddPressureCallback(const PdfMemoryPressureCallback& callback)
+{
+    auto& callbacks = getPressureCallbacks();
+    lock_guard<mutex> lock(callbacks.Mutex);
+    unsigned id = callbacks.NextId++;
+    callbacks.Callbacks[id] = callback;
+    return id;
+}
+
+void PdfMemoryGovernor::RemovePressureCallback(unsigned id)
+{
+    auto& callbacks = getPressureCallbacks();
+    lock_guard<mutex> lock(callbacks.Mutex);
+    callbacks.Callbacks.erase(id);
+}
+
+size_t PdfMemoryGovernor::Reserve(size_t size)
+{
+    size_t reserved;
+    if (!TryReserve(size, reserved))
+    {
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::MemoryBudgetExceeded, utls::Format(
+            "Can't reserve {} bytes with {} bytes used of the {} bytes budget", size, GetUsage(), GetBudget()));
+    }
+
+    return reserved;
+}
+
+bool PdfMemoryGovernor::TryReserve(size_t size, size_t& reserved)
+{
+    reserved = 0;
+    size_t budget = s_budget.load(memory_order_relaxed);
+    if (budget == 0)
+        return true;
+
+    if (!tryAdd(size, budget))
+    {
+        if (size > budget || t_relieving || !relievePressure(size, budget))
+            return false;
+    }
+
+    reserved = size;
+    return true;
+}
+
+void PdfMemoryGovernor::Release(size_t size) noexcept
+{
+    if (size != 0)
+        s_usage.fetch_sub(size, memory_order_relaxed);
+}
+
+RelievingScope::RelievingScope()
+{
+    t_relieving = true;
+}
+
+RelievingScope::~RelievingScope()
+{
+    t_relieving = false;
+}
+
+// Add the size to the usage if it fits the budget
+bool tryAdd(size_t size, size_t budget)
+{
+    size_t usage = s_usage.load(memory_order_relaxed);
+    do
+    {
+        if (size > budget || usage > budget - size)
+            return false;
+    } while (!s_usage.compare_exchange_weak(usage, usage + size, memory_order_relaxed));
+
+    return true;
+}
+
+// Invoke the pressure callbacks, in registration order,
+// until the size fits the budget
+bool relievePressure(size_t size, size_t budget)
+{
+    auto& callbacks = getPressureCallbacks();
+    lock_guard<mutex> lock(callbacks.Mutex);
+    RelievingScope scope;
+    for (auto& pair : callbacks.Callbacks)
+    {
+        if (tryAdd(size, budget))
+            return true;
+
+        size_t usage = s_usage.load(memory_order_relaxed);
+        (void)pair.second(usage + size > budget ? usage + size - budget : 0);
+    }
+
+    return tryAdd(size, budget);
+}
+
+PressureCallbacks& getPressureCallbacks()
+{
+    static PressureCallbacks s_callbacks;
+    return s_callbacks;
+}
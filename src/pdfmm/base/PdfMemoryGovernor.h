@@ -0,0 +1,94 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_MEMORY_GOVERNOR_H
+#define PDF_MEMORY_GOVERNOR_H
+
+#include "PdfDeclarations.h"
+
+#include <functional>
+
+namespace mm {
+
+/** A callback relieving the memory pressure, evicting cached data
+ * \param size the size the callback should try to release at least
+ * \returns the size actually released to the governor
+ * \remarks The callback may be invoked by any thread, so it must
+ * synchronize with the users of the data it evicts, and it must
+ * not reserve memory itself
+ */
+using PdfMemoryPressureCallback = std::function<size_t(size_t size)>;
+
+/** A process wide budget for the memory held by the documents
+ *
+ * The objects allocated through PdfMemoryResource, the data of the
+ * memory object streams, the decoded stream caches of the documents
+ * and the shared cache of the font subsets reserve their memory from
+ * the governor. When a reservation would exceed the budget, the
+ * registered pressure callbacks are invoked first, so the caches evict
+ * their least recently used entries. If the reservation still exceeds
+ * the budget, the operation that needs the memory fails with
+ * PdfErrorCode::MemoryBudgetExceeded, while the caches just skip
+ * caching the data
+ *
+ * \remarks The memory is accounted only while a budget is set. The
+ * reservations are estimates of the data sizes, not of the allocator
+ * overhead, so the budget should leave some room to the process limit.
+ * The memory of the containers of the objects, and of the transient
+ * buffers of the operations, is not accounted
+ */
+class PDFMM_API PdfMemoryGovernor final
+{
+public:
+    PdfMemoryGovernor() = delete;
+
+public:
+    /** Set the process wide budget
+     * \param budget the budget in bytes, or 0 to disable the accounting
+     * \remarks The memory reserved before the budget is set is not accounted
+     */
+    static void SetBudget(size_t budget);
+
+    static size_t GetBudget();
+
+    /** \returns the memory currently reserved
+     */
+    static size_t GetUsage();
+
+    /** Register a callback invoked when a reservation would exceed the budget
+     * \returns the id of the callback, to remove it
+     */
+    static unsigned AddPressureCallback(const PdfMemoryPressureCallback& callback);
+
+    /** Remove a pressure callback. When it returns, the callback
+     * is not running and it won't be invoked anymore
+     */
+    static void RemovePressureCallback(unsigned id);
+
+    /** Reserve memory, relieving the pressure if the budget would be exceeded
+     * \returns the size reserved, to be released with Release(). It's 0
+     *      when no budget is set
+     * \exception PdfErrorCode::MemoryBudgetExceeded if the budget would
+     *      be exceeded even after the pressure callbacks were invoked
+     */
+    static size_t Reserve(size_t size);
+
+    /** Try to reserve memory, relieving the pressure if the budget would be exceeded
+     * \param reserved the size reserved, to be released with Release()
+     * \returns false if the budget would be exceeded even after the
+     *      pressure callbacks were invoked
+     */
+    static bool TryReserve(size_t size, size_t& reserved);
+
+    /** Release memory reserved with Reserve() or TryReserve()
+     */
+    static void Release(size_t size) noexcept;
+};
+
+};
+
+#endif // PDF_MEMORY_GOVERNOR_H
@@ -12,14 +12,28 @@
 #include "PdfArray.h"
 #include "PdfEncrypt.h"
 #include "PdfFilter.h"
+#include "PdfMemoryGovernor.h"
 #include "PdfObject.h"
 #include "PdfStreamDevice.h"
 
 using namespace std;
 using namespace mm;
 
+// The reserved memory is released when the
+// last copy of the stream sharing it is destroyed
+struct PdfMemoryObjectStream::Buffer
+{
+    ~Buffer()
+    {
+        PdfMemoryGovernor::Release(Reserved);
+    }
+
+    charbuff Data;
+    size_t Reserved = 0;
+};
+
 PdfMemoryObjectStream::PdfMemoryObjectStream(PdfObject& parent)
-    : PdfObjectStream(parent)
+    : PdfObjectStream(parent), m_buffer(std::make_shared<Buffer>())
 {
 }
 
@@ -30,20 +44,25 @@ PdfMemoryObjectStream::~PdfMemoryObjectStream()
 
 unique_ptr<InputStream> PdfMemoryObjectStream::GetInputStream() const
 {
-    return std::unique_ptr<InputStream>(new SpanStreamDevice(m_buffer));
+    return std::unique_ptr<InputStream>(new SpanStreamDevice(m_buffer->Data));
 }
 
 void PdfMemoryObjectStream::BeginAppendImpl(const PdfFilterList& filters)
 {
-    m_buffer.clear();
+    // Don't modify the buffer if it's shared with copies of the stream
+    if (m_buffer.use_count() == 1)
+        m_buffer->Data.clear();
+    else
+        m_buffer = std::make_shared<Buffer>();
+
     if (filters.size() == 0)
     {
-        m_Stream = unique_ptr<BufferStreamDevice>(new BufferStreamDevice(m_buffer));
+        m_Stream = unique_ptr<BufferStreamDevice>(new BufferStreamDevice(m_buffer->Data));
     }
     else
     {
-        m_BufferStream = unique_ptr<BufferStreamDevice>(new BufferStreamDevice(m_buffer));
-        m_Stream = PdfFilterFactory::CreateEncodeStream(filters, *m_BufferStream);
+        m_BufferStream = unique_ptr<BufferStreamDevice>(new BufferStreamDevice(m_buffer->Data));
+        m_Stream = PdfFilterFactory::CreateEncodeStream(filters, *m_BufferStream, GetEffectiveCompressionLevel());
     }
 }
 
@@ -62,11 +81,36 @@ void PdfMemoryObjectStream::EndAppendImpl()
         m_BufferStream->Flush();
         m_BufferStream = nullptr;
     }
+
+    // Adjust the reservation to the written data. If it
+    // doesn't fit the budget the data is dropped
+    auto& buffer = *m_buffer;
+    size_t size = buffer.Data.size();
+    if (size < buffer.Reserved)
+    {
+        PdfMemoryGovernor::Release(buffer.Reserved - size);
+        buffer.Reserved = size;
+    }
+    else if (size > buffer.Reserved)
+    {
+        try
+        {
+            buffer.Reserved += PdfMemoryGovernor::Reserve(size - buffer.Reserved);
+        }
+        catch (PdfError&)
+        {
+            buffer.Data.clear();
+            buffer.Data.shrink_to_fit();
+            PdfMemoryGovernor::Release(buffer.Reserved);
+            buffer.Reserved = 0;
+            throw;
+        }
+    }
 }
 
 void PdfMemoryObjectStream::CopyTo(OutputStream& stream) const
 {
-    stream.Write(m_buffer.data(), m_buffer.size());
+    stream.Write(m_buffer->Data.data(), m_buffer->Data.size());
 }
 
 void PdfMemoryObjectStream::CopyFrom(const PdfObjectStream& rhs)
@@ -91,9 +135,10 @@ void PdfMemoryObjectStream::Write(OutputStream& stream, const PdfStatefulEncrypt
     stream.Write("stream\n");
     if (encrypt.HasEncrypt())
     {
-        charbuff encrypted;
-        encrypt.EncryptTo(encrypted, { this->Get(), this->GetLength() });
-        stream.Write(encrypted);
+        // Encrypt while writing, not to hold a copy of the data
+        auto output = encrypt.CreateEncryptionOutputStream(stream);
+        output->Write(string_view(this->Get(), this->GetLength()));
+        output->Flush();
     }
     else
     {
@@ -106,12 +151,12 @@ void PdfMemoryObjectStream::Write(OutputStream& stream, const PdfStatefulEncrypt
 
 const char* PdfMemoryObjectStream::Get() const
 {
-    return m_buffer.data();
+    return m_buffer->Data.data();
 }
 
 size_t PdfMemoryObjectStream::GetLength() const
 {
-    return m_buffer.size();
+    return m_buffer->Data.size();
 }
 
 PdfMemoryObjectStream& PdfMemoryObjectStream::operator=(const PdfMemoryObjectStream& rhs)
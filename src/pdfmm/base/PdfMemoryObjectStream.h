@@ -28,6 +28,8 @@ class PdfObject;
  *  to draw onto a page or binary data like a font or an image.
  *
  *  A PdfMemoryObjectStream is implicitly shared and can therefore be copied very quickly.
+ *  Copies share the same buffer, which is copied on write, so copying
+ *  documents or importing pages doesn't duplicate the stream data
  */
 class PDFMM_API PdfMemoryObjectStream final : public PdfObjectStream
 {
@@ -69,7 +71,12 @@ private:
     void copyFrom(const PdfMemoryObjectStream& rhs);
 
  private:
-    charbuff m_buffer;
+    // The data with the memory reserved for it from PdfMemoryGovernor
+    struct Buffer;
+
+    // Shared with the copies of the stream. It's never
+    // modified, it's replaced when appending instead
+    std::shared_ptr<Buffer> m_buffer;
     std::unique_ptr<OutputStream> m_Stream;
     std::unique_ptr<OutputStream> m_BufferStream;
 };
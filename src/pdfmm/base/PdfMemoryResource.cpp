@@ -0,0 +1,84 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfMemoryResource.h"
+
+#include "PdfMemoryGovernor.h"
+
+using namespace std;
+using namespace mm;
+
+// The resource of a block, and whether the block was reserved from
+// PdfMemoryGovernor, are stored in a header before it, keeping the
+// alignment guaranteed by the global operator new
+constexpr size_t HeaderSize = alignof(std::max_align_t);
+static_assert(HeaderSize >= sizeof(pmr::memory_resource*) + sizeof(bool), "The header can't hold the resource");
+
+static thread_local pmr::memory_resource* t_current = nullptr;
+
+pmr::memory_resource* PdfMemoryResource::GetCurrent()
+{
+    return t_current;
+}
+
+bool PdfMemoryResource::IsSupported()
+{
+#ifdef PDFMM_HAVE_MEMORY_RESOURCE
+    return true;
+#else
+    return false;
+#endif // PDFMM_HAVE_MEMORY_RESOURCE
+}
+
+void* PdfMemoryResource::Allocate(size_t size)
+{
+    auto resource = t_current;
+    if (resource == nullptr)
+        resource = pmr::new_delete_resource();
+
+    size_t reserved = PdfMemoryGovernor::Reserve(size + HeaderSize);
+    char* block;
+    try
+    {
+        block = (char*)resource->allocate(size + HeaderSize, HeaderSize);
+    }
+    catch (...)
+    {
+        PdfMemoryGovernor::Release(reserved);
+        throw;
+    }
+
+    *(pmr::memory_resource**)block = resource;
+    *(bool*)(block + sizeof(pmr::memory_resource*)) = reserved != 0;
+    return block + HeaderSize;
+}
+
+void PdfMemoryResource::Deallocate(void* ptr, size_t size) noexcept
+{
+    if (ptr == nullptr)
+        return;
+
+    auto block = (char*)ptr - HeaderSize;
+    auto resource = *(pmr::memory_resource**)block;
+    bool reserved = *(bool*)(block + sizeof(pmr::memory_resource*));
+    resource->deallocate(block, size + HeaderSize, HeaderSize);
+    if (reserved)
+        PdfMemoryGovernor::Release(size + HeaderSize);
+}
+
+PdfMemoryResourceScope::PdfMemoryResourceScope(pmr::memory_resource* resource)
+    : m_previous(t_current)
+{
+    if (resource != nullptr)
+        t_current = resource;
+}
+
+PdfMemoryResourceScope::~PdfMemoryResourceScope()
+{
+    t_current = m_previous;
+}
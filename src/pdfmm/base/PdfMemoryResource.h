@@ -0,0 +1,96 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_MEMORY_RESOURCE_H
+#define PDF_MEMORY_RESOURCE_H
+
+#include <memory_resource>
+
+#include "PdfDeclarations.h"
+
+namespace mm {
+
+/** Route the allocations of the library to polymorphic memory resources
+ *
+ * The objects, the values of the arrays, dictionaries, strings and
+ * raw data held by objects, and the object streams are allocated from
+ * the memory resource current for the allocating thread, and they are
+ * released to the resource they were allocated from. A document created
+ * with a memory resource makes it current while it loads and creates
+ * objects, see PdfMemDocument::PdfMemDocument(std::pmr::memory_resource*),
+ * and PdfMemoryResourceScope makes it current for other operations
+ *
+ * \remarks The buffers of charbuff, such as the stream data, and the
+ * nodes of the containers keep the global heap, since they use the
+ * standard allocators. The worker threads of the parallel operations
+ * use the global heap too, so resources that are not thread safe,
+ * like std::pmr::monotonic_buffer_resource, can be used. The
+ * resource must outlive all the objects allocated from it, also the
+ * ones that outlive the document, e.g. removed from it or moved out
+ * \remarks The blocks are reserved from PdfMemoryGovernor, when it has a budget
+ * \remarks The allocations are routed only if the library was built
+ * with PDFMM_WITH_MEMORY_RESOURCE
+ */
+class PDFMM_API PdfMemoryResource final
+{
+public:
+    PdfMemoryResource() = delete;
+
+public:
+    /** \returns the resource current for the calling
+     * thread, or nullptr if it's the global heap
+     */
+    static std::pmr::memory_resource* GetCurrent();
+
+    /** \returns true if the library was built with memory resource support
+     */
+    static bool IsSupported();
+
+    /** Allocate a block from the current resource, remembering
+     * the resource to release it with Deallocate
+     * \exception PdfErrorCode::MemoryBudgetExceeded if the block
+     *      doesn't fit the budget of PdfMemoryGovernor
+     */
+    static void* Allocate(size_t size);
+
+    static void Deallocate(void* ptr, size_t size) noexcept;
+};
+
+/** Make a memory resource current for the calling thread until the scope ends
+ */
+class PDFMM_API PdfMemoryResourceScope final
+{
+public:
+    /**
+     * \param resource the resource, or nullptr to keep the current one
+     */
+    PdfMemoryResourceScope(std::pmr::memory_resource* resource);
+
+    ~PdfMemoryResourceScope();
+
+private:
+    PdfMemoryResourceScope(const PdfMemoryResourceScope&) = delete;
+    PdfMemoryResourceScope& operator=(const PdfMemoryResourceScope&) = delete;
+
+private:
+    std::pmr::memory_resource* m_previous;
+};
+
+};
+
+// Declare the allocation operators of a class hierarchy
+// allocated from the current memory resource
+#ifdef PDFMM_HAVE_MEMORY_RESOURCE
+#define PDFMM_DECLARE_MEMORY_RESOURCE_ALLOCATION \
+public: \
+    static void* operator new(size_t size) { return mm::PdfMemoryResource::Allocate(size); } \
+    static void operator delete(void* ptr, size_t size) noexcept { mm::PdfMemoryResource::Deallocate(ptr, size); }
+#else // PDFMM_HAVE_MEMORY_RESOURCE
+#define PDFMM_DECLARE_MEMORY_RESOURCE_ALLOCATION
+#endif // PDFMM_HAVE_MEMORY_RESOURCE
+
+#endif // PDF_MEMORY_RESOURCE_H
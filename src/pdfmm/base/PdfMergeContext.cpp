@@ -0,0 +1,389 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfMergeContext.h"
+
+#include <openssl/evp.h>
+
+#include "PdfArray.h"
+#include "PdfDictionary.h"
+#include "PdfMemDocument.h"
+#include "PdfObjectStream.h"
+#include "PdfPage.h"
+#include "PdfPageCollection.h"
+#include "PdfStreamDevice.h"
+#include "PdfStreamedDocument.h"
+
+using namespace std;
+using namespace mm;
+
+static bool canShareObject(const PdfObject& obj);
+static void serializeObjectData(const PdfVariant& variant, const PdfObjectStream* stream, charbuff& buffer);
+static string computeDigest(const bufferview& data);
+
+PdfMergeContext::PdfMergeContext(PdfMemDocument& doc)
+    : m_doc(&doc), m_streamed(false), m_source(nullptr) { }
+
+PdfMergeContext::PdfMergeContext(PdfStreamedDocument& doc)
+    : m_doc(&doc), m_streamed(true), m_source(nullptr) { }
+
+void PdfMergeContext::AppendDocument(const string_view& filename, const string_view& password)
+{
+    PdfMemDocument doc;
+    doc.Load(filename, password);
+    appendDocument(doc);
+}
+
+void PdfMergeContext::AppendDocument(const shared_ptr<InputStreamDevice>& device, const string_view& password)
+{
+    PdfMemDocument doc;
+    doc.LoadFromDevice(device, password);
+    appendDocument(doc);
+}
+
+void PdfMergeContext::appendDocument(PdfMemDocument& doc)
+{
+    try
+    {
+        insertPages(doc, 0, doc.GetPages().GetCount());
+        if (m_streamed)
+            writeCopiedObjects();
+    }
+    catch (...)
+    {
+        m_source = nullptr;
+        m_created.clear();
+        throw;
+    }
+
+    // The source is closed by the caller, so the references
+    // mapped from it can't be used anymore
+    m_source = nullptr;
+    m_references.clear();
+    m_stops.clear();
+}
+
+void PdfMergeContext::insertPages(const PdfMemDocument& doc, unsigned atIndex, unsigned pageCount)
+{
+    if (atIndex + pageCount > doc.GetPages().GetCount())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Invalid page range");
+
+    const PdfName inheritableAttributes[] = {
+        PdfName("Resources"),
+        PdfName("MediaBox"),
+        PdfName("CropBox"),
+        PdfName("Rotate"),
+    };
+
+    setSource(doc);
+    m_pageReferences.clear();
+
+    // Create the pages first, so the references
+    // to them from the copied objects are mapped
+    vector<PdfObject*> pages;
+    pages.reserve(pageCount);
+    for (unsigned i = atIndex; i < atIndex + pageCount; i++)
+    {
+        auto& page = doc.GetPages().GetPage(i);
+        auto pageObj = m_doc->GetObjects().CreateDictionaryObject();
+        m_pageReferences[page.GetObject().GetIndirectReference()] = pageObj->GetIndirectReference();
+        if (m_streamed)
+            m_created.push_back(pageObj->GetIndirectReference());
+        pages.push_back(pageObj);
+    }
+
+    for (unsigned i = 0; i < pageCount; i++)
+    {
+        auto& page = doc.GetPages().GetPage(atIndex + i);
+        PdfObject copy(page.GetObject().GetVariant());
+        auto& dict = copy.GetDictionary();
+        dict.RemoveKey("Parent");
+        for (auto& name : inheritableAttributes)
+        {
+            if (dict.HasKey(name))
+                continue;
+
+            auto attribute = page.GetInheritedKey(name);
+            if (attribute != nullptr)
+                dict.AddKey(name, *attribute);
+        }
+
+        (void)copyReferences(copy);
+        *pages[i] = std::move(copy);
+    }
+
+    if (m_streamed)
+    {
+        // The pages are written with the other copied objects,
+        // so the page tree can't be walked to insert them
+        m_doc->GetPages().appendPagesToRoot(pages);
+    }
+    else
+    {
+        m_doc->GetPages().InsertPages(m_doc->GetPages().GetCount(), pages);
+    }
+}
+
+void PdfMergeContext::setSource(const PdfMemDocument& doc)
+{
+    if (m_source == &doc)
+        return;
+
+    m_source = &doc;
+    m_references.clear();
+    m_stops.clear();
+
+    // The catalog and the page tree nodes are not
+    // copied, nor the pages that are not inserted
+    m_stops.insert(doc.GetCatalog().GetObject().GetIndirectReference());
+    vector<const PdfObject*> stack;
+    stack.push_back(&doc.GetPages().GetObject());
+    m_stops.insert(stack.back()->GetIndirectReference());
+    while (stack.size() != 0)
+    {
+        auto node = stack.back();
+        stack.pop_back();
+        auto kids = node->GetDictionary().FindKey("Kids");
+        if (kids == nullptr || !kids->IsArray())
+            continue;
+
+        PdfReference ref;
+        for (auto& kid : kids->GetArray())
+        {
+            if (!kid.TryGetReference(ref) || !m_stops.insert(ref).second)
+                continue;
+
+            auto kidObj = doc.GetObjects().GetObject(ref);
+            if (kidObj != nullptr && kidObj->IsDictionary())
+                stack.push_back(kidObj);
+        }
+    }
+}
+
+void PdfMergeContext::writeCopiedObjects()
+{
+    // The objects with streams are written by the
+    // streams themselves, as soon as they are copied
+    auto& objects = m_doc->GetObjects();
+    for (auto& ref : m_created)
+    {
+        auto obj = objects.GetObject(ref);
+        if (obj != nullptr && !obj->HasStream())
+            objects.QueueObject(*obj);
+    }
+
+    objects.FlushQueuedObjects();
+    m_created.clear();
+}
+
+bool PdfMergeContext::copyReferences(PdfObject& obj)
+{
+    // References to objects that are not copied are replaced with null
+    bool bound = false;
+    vector<PdfObject*> stack;
+    stack.push_back(&obj);
+    while (stack.size() != 0)
+    {
+        auto child = stack.back();
+        stack.pop_back();
+        switch (child->GetDataType())
+        {
+            case PdfDataType::Reference:
+            {
+                auto ref = copyObject(child->GetReference(), bound);
+                if (ref.IsIndirect())
+                    child->SetReference(ref);
+                else
+                    *child = PdfObject(PdfVariant::NullValue);
+                break;
+            }
+            case PdfDataType::Array:
+            {
+                for (auto& item : child->GetArray())
+                    stack.push_back(&item);
+                break;
+            }
+            case PdfDataType::Dictionary:
+            {
+                for (auto& pair : child->GetDictionary())
+                    stack.push_back(&pair.second);
+                break;
+            }
+            default:
+            {
+                // Nothing to do
+                break;
+            }
+        }
+    }
+
+    return bound;
+}
+
+PdfReference PdfMergeContext::copyObject(const PdfReference& ref, bool& bound)
+{
+    auto found = m_pageReferences.find(ref);
+    if (found != m_pageReferences.end())
+    {
+        bound = true;
+        return found->second;
+    }
+
+    found = m_references.find(ref);
+    if (found != m_references.end())
+        return found->second;
+
+    if (m_stops.find(ref) != m_stops.end())
+        return { };
+
+    auto obj = m_source->GetObjects().GetObject(ref);
+    if (obj == nullptr)
+        return { };
+
+    auto& objects = m_doc->GetObjects();
+    if (m_copying.find(ref) != m_copying.end())
+    {
+        // The object is in a cycle: create it now, its data is set when
+        // its copy is complete. The objects in a cycle are not shared
+        auto target = objects.CreateObject(PdfObject(PdfVariant::NullValue));
+        m_pageReferences[ref] = target->GetIndirectReference();
+        if (m_streamed)
+            m_created.push_back(target->GetIndirectReference());
+        bound = true;
+        return target->GetIndirectReference();
+    }
+
+    m_copying.insert(ref);
+    PdfObject copy(obj->GetVariant());
+    bool copyBound = copyReferences(copy);
+    m_copying.erase(ref);
+
+    // The streams are copied from the source
+    // object, without copying them twice
+    PdfObject* target;
+    found = m_pageReferences.find(ref);
+    if (found != m_pageReferences.end())
+    {
+        target = &objects.MustGetObject(found->second);
+        *target = std::move(copy);
+        copyBound = true;
+    }
+    else if (copyBound || !canShareObject(*obj))
+    {
+        target = objects.CreateObject(std::move(copy));
+        m_pageReferences[ref] = target->GetIndirectReference();
+        if (m_streamed)
+            m_created.push_back(target->GetIndirectReference());
+        copyBound = true;
+    }
+    else
+    {
+        size_t hash;
+        string digest;
+        auto identical = findIdentical(copy, obj->GetStream(), hash, digest);
+        if (identical.IsIndirect())
+        {
+            m_references[ref] = identical;
+            return identical;
+        }
+
+        target = objects.CreateObject(std::move(copy));
+        m_references[ref] = target->GetIndirectReference();
+        m_hashes[hash].push_back({ target->GetIndirectReference(), std::move(digest) });
+        if (m_streamed)
+            m_created.push_back(target->GetIndirectReference());
+    }
+
+    if (obj->HasStream())
+        target->GetOrCreateStream() = obj->MustGetStream();
+
+    bound |= copyBound;
+    return target->GetIndirectReference();
+}
+
+PdfReference PdfMergeContext::findIdentical(const PdfObject& obj, const PdfObjectStream* stream,
+    size_t& hash, string& digest)
+{
+    serializeObjectData(obj.GetVariant(), stream, m_buffer);
+    hash = std::hash<string_view>()(m_buffer);
+
+    // The copies written to a streamed document can't be
+    // read back, so they are matched by digest instead
+    if (m_streamed)
+        digest = computeDigest(m_buffer);
+
+    auto found = m_hashes.find(hash);
+    if (found == m_hashes.end())
+        return { };
+
+    for (auto& candidate : found->second)
+    {
+        if (m_streamed)
+        {
+            if (candidate.Digest == digest)
+                return candidate.Reference;
+
+            continue;
+        }
+
+        auto candidateObj = m_doc->GetObjects().GetObject(candidate.Reference);
+        if (candidateObj == nullptr)
+            continue;
+
+        serializeObjectData(candidateObj->GetVariant(), candidateObj->GetStream(), m_candidateBuffer);
+        if (m_candidateBuffer == m_buffer)
+            return candidate.Reference;
+    }
+
+    return { };
+}
+
+bool canShareObject(const PdfObject& obj)
+{
+    const PdfDictionary* dict;
+    if (!obj.TryGetDictionary(dict))
+        return true;
+
+    // The nodes of the document hierarchies, e.g. pages, fields
+    // and outline items, are identified by their references
+    if (dict->HasKey("Parent") || dict->HasKey("P"))
+        return false;
+
+    auto type = dict->FindKeyAs<PdfName>(PdfName::KeyType);
+    return type != "Page" && type != "Pages" && type != "Catalog"
+        && type != "Annot" && type != "Sig" && type != "XRef" && type != "ObjStm";
+}
+
+void serializeObjectData(const PdfVariant& variant, const PdfObjectStream* stream, charbuff& buffer)
+{
+    buffer.clear();
+    BufferStreamDevice device(buffer);
+    charbuff temp;
+    variant.Write(device, PdfWriteFlags::None, { }, temp);
+    if (stream != nullptr)
+    {
+        device.Write("\nstream\n");
+        stream->CopyTo(device);
+    }
+}
+
+string computeDigest(const bufferview& data)
+{
+    unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned length;
+    if (ctx == nullptr
+        || EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr) != 1
+        || EVP_DigestUpdate(ctx.get(), data.data(), data.size()) != 1
+        || EVP_DigestFinal_ex(ctx.get(), digest, &length) != 1)
+    {
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error SHA256-hashing object data");
+    }
+
+    return string(reinterpret_cast<const char*>(digest), length);
+}
@@ -0,0 +1,137 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_MERGE_CONTEXT_H
+#define PDF_MERGE_CONTEXT_H
+
+#include "PdfDeclarations.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "PdfReference.h"
+
+namespace mm {
+
+class InputStreamDevice;
+class PdfDocument;
+class PdfMemDocument;
+class PdfObject;
+class PdfObjectStream;
+class PdfStreamedDocument;
+
+/**
+ * State of the merge of several documents in the same document,
+ * kept across calls of PdfMemDocument::InsertPages
+ *
+ * Only the objects reachable from the inserted pages are copied,
+ * and the references are mapped through a table, so the objects
+ * inserted with more calls from the same source document are
+ * copied only once. The copied objects are also matched by
+ * content, so the identical resources of different source
+ * documents, e.g. the same fonts or images, are copied only once.
+ * The outlines, the AcroForm and the other document-level objects
+ * are not copied, and the references to them are replaced with null.
+ *
+ * A source document must not be modified between the calls using
+ * the same context
+ *
+ * A context created for a PdfStreamedDocument merges whole documents
+ * with AppendDocument(): every source is loaded, its pages and the
+ * objects they reference are copied and written to the device, and
+ * the source is closed before the next one is loaded. The pages are
+ * added to the root node of the page tree and, as the other copied
+ * objects, they can't be accessed anymore after the call. The identical
+ * resources are still copied once, matching them by a digest of their
+ * data, so the memory used is the one of a source document plus the
+ * index of the shared resources
+ */
+class PDFMM_API PdfMergeContext final
+{
+    friend class PdfMemDocument;
+
+public:
+    /** Create a context to merge documents in the given one
+     */
+    PdfMergeContext(PdfMemDocument& doc);
+
+    /** Create a context to merge documents in the given streamed
+     *  document, writing the copied objects as soon as possible
+     */
+    PdfMergeContext(PdfStreamedDocument& doc);
+
+public:
+    /** Append all the pages of the document in the given file
+     */
+    void AppendDocument(const std::string_view& filename, const std::string_view& password = { });
+
+    /** Append all the pages of the document read from the given device
+     */
+    void AppendDocument(const std::shared_ptr<InputStreamDevice>& device, const std::string_view& password = { });
+
+public:
+    inline PdfDocument& GetDocument() const { return *m_doc; }
+
+private:
+    PdfMergeContext(const PdfMergeContext&) = delete;
+    PdfMergeContext& operator=(const PdfMergeContext&) = delete;
+
+private:
+    void insertPages(const PdfMemDocument& doc, unsigned atIndex, unsigned pageCount);
+
+    void appendDocument(PdfMemDocument& doc);
+
+    void setSource(const PdfMemDocument& doc);
+
+    // Write the objects copied from the current
+    // source and free them, for streamed documents
+    void writeCopiedObjects();
+
+    /** Copy the objects referenced by the given object and map the references
+     *  \returns true if the object references an object bound to the inserted pages
+     */
+    bool copyReferences(PdfObject& obj);
+
+    PdfReference copyObject(const PdfReference& ref, bool& bound);
+
+    PdfReference findIdentical(const PdfObject& obj, const PdfObjectStream* stream,
+        size_t& hash, std::string& digest);
+
+private:
+    struct Candidate
+    {
+        PdfReference Reference;
+        // The digest of the data, for the objects that
+        // may be written and freed before matching them
+        std::string Digest;
+    };
+
+private:
+    PdfDocument* m_doc;
+    bool m_streamed;
+    const PdfMemDocument* m_source;
+    // The copied objects that can be shared by pages, by their source
+    // reference, kept while the source document doesn't change
+    std::unordered_map<PdfReference, PdfReference> m_references;
+    // The copied objects bound to the inserted pages, e.g. the pages
+    // themselves and the annotations, only for the current call
+    std::unordered_map<PdfReference, PdfReference> m_pageReferences;
+    // The page tree of the source document, where copying stops
+    std::unordered_set<PdfReference> m_stops;
+    // The objects being copied, to detect cycles
+    std::unordered_set<PdfReference> m_copying;
+    // The copied objects that can be shared by pages, by hash of their data
+    std::unordered_map<size_t, std::vector<Candidate>> m_hashes;
+    // The objects created for the current source, for streamed documents
+    std::vector<PdfReference> m_created;
+    charbuff m_buffer;
+    charbuff m_candidateBuffer;
+};
+
+};
+
+#endif // PDF_MERGE_CONTEXT_H
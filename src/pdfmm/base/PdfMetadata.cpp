@@ -16,7 +16,7 @@ using namespace std;
 using namespace mm;
 
 PdfMetadata::PdfMetadata(PdfDocument& doc)
-    : m_doc(&doc), m_initialized(false), m_xmpSynced(false)
+    : m_doc(&doc), m_initialized(false), m_xmpSynced(false), m_xmpLoaded(false)
 {
 }
 
@@ -271,6 +271,9 @@ void PdfMetadata::SyncXMPMetadata(bool forceCreationXMP)
 
 unique_ptr<PdfXMPPacket> PdfMetadata::TakeXMPPacket()
 {
+    if (m_initialized)
+        ensureXMPLoaded();
+
     if (m_packet == nullptr)
         return nullptr;
 
@@ -286,6 +289,7 @@ unique_ptr<PdfXMPPacket> PdfMetadata::TakeXMPPacket()
 
 void PdfMetadata::EnsureXMPMetadata()
 {
+    ensureXMPLoaded();
     if (m_packet == nullptr)
         mm::UpdateOrCreateXMPMetadata(m_packet, m_metadata);
 
@@ -305,6 +309,7 @@ void PdfMetadata::invalidate()
 {
     m_initialized = false;
     m_xmpSynced = false;
+    m_xmpLoaded = false;
     m_metadata = { };
 }
 
@@ -322,9 +327,12 @@ void PdfMetadata::ensureInitialized()
     m_metadata.Producer = info.GetProducer();
     m_metadata.CreationDate = info.GetCreationDate();
     m_metadata.ModDate = info.GetModDate();
+
+    // Just stream the packet for the values: its tree is
+    // built only when the XMP metadata must be changed
     auto metadataValue = m_doc->GetCatalog().GetMetadataStreamValue();
-    auto xmpMetadata = mm::GetXMPMetadata(metadataValue, m_packet);
-    if (m_packet != nullptr)
+    PdfXMPMetadata xmpMetadata;
+    if (mm::TryReadXMPMetadata(metadataValue, xmpMetadata))
     {
         if (m_metadata.Title == nullptr)
             m_metadata.Title = xmpMetadata.Title;
@@ -349,8 +357,20 @@ void PdfMetadata::ensureInitialized()
     m_initialized = true;
 }
 
+void PdfMetadata::ensureXMPLoaded()
+{
+    ensureInitialized();
+    if (m_xmpLoaded)
+        return;
+
+    auto metadataValue = m_doc->GetCatalog().GetMetadataStreamValue();
+    (void)mm::GetXMPMetadata(metadataValue, m_packet);
+    m_xmpLoaded = true;
+}
+
 void PdfMetadata::syncXMPMetadata(bool forceCreationXMP)
 {
+    ensureXMPLoaded();
     if (m_packet == nullptr && !forceCreationXMP)
         return;
 
@@ -148,6 +148,7 @@ namespace mm
 
         void setKeywords(nullable<const PdfString&> keywords, bool syncXMP = false);
         void ensureInitialized();
+        void ensureXMPLoaded();
         void syncXMPMetadata(bool forceCreationXMP);
         void invalidate();
 
@@ -156,6 +157,7 @@ namespace mm
         PdfXMPMetadata m_metadata;
         bool m_initialized;
         bool m_xmpSynced;
+        bool m_xmpLoaded;
         std::unique_ptr<PdfXMPPacket> m_packet;
     };
 }
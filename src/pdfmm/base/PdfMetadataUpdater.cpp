@@ -0,0 +1,446 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfMetadataUpdater.h"
+
+#include <algorithm>
+
+#include "PdfArray.h"
+#include "PdfDate.h"
+#include "PdfIndirectObjectList.h"
+#include "PdfObjectStream.h"
+#include "PdfObjectStreamParser.h"
+#include "PdfParser.h"
+#include "PdfParserObject.h"
+#include "PdfStreamDevice.h"
+
+using namespace std;
+using namespace mm;
+
+using ObjectOffsets = vector<pair<PdfReference, size_t>>;
+
+static unsigned getByteWidth(uint64_t value);
+static void writeBigEndian(char*& cursor, uint64_t value, unsigned width);
+
+PdfMetadataUpdater::PdfMetadataUpdater()
+{
+    reset();
+}
+
+void PdfMetadataUpdater::Load(const string_view& filename)
+{
+    if (filename.length() == 0)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    FileStreamDevice device(filename);
+    LoadFromDevice(device);
+}
+
+void PdfMetadataUpdater::LoadFromBuffer(const bufferview& buffer)
+{
+    if (buffer.size() == 0)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    SpanStreamDevice device(buffer);
+    LoadFromDevice(device);
+}
+
+void PdfMetadataUpdater::LoadFromDevice(InputStreamDevice& device)
+{
+    reset();
+
+    {
+        // Read only the xref sections and the trailers. The
+        // objects list stays empty, it's just required by the parser
+        PdfIndirectObjectList objects;
+        PdfParser parser(objects);
+        if (!parser.IsPdfFile(device))
+            PDFMM_RAISE_ERROR(PdfErrorCode::NoPdfFile);
+
+        parser.ReadDocumentStructure(device);
+        m_entries = std::move(parser.m_entries);
+        m_trailer = parser.GetTrailer().GetDictionary();
+        m_prevXRefOffset = parser.GetXRefOffset();
+        m_hasXRefStream = parser.HasXRefStream();
+    }
+
+    auto encryptObj = m_trailer.GetKey("Encrypt");
+    if (encryptObj != nullptr && !encryptObj->IsNull())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NotImplemented, "The metadata of encrypted files can't be updated");
+
+    m_size = std::max((uint32_t)m_trailer.FindKeyAs<int64_t>(PdfName::KeySize, 0), (uint32_t)m_entries.GetSize());
+
+    auto catalogObj = m_trailer.GetKey("Root");
+    if (catalogObj == nullptr || !catalogObj->IsReference())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "The trailer has no /Root reference");
+
+    m_catalogRef = catalogObj->GetReference();
+    m_catalog = readObject(device, m_catalogRef);
+    if (!m_catalog->IsDictionary())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "The catalog is not a dictionary");
+
+    auto metadataObj = m_catalog->GetDictionary().GetKey("Metadata");
+    if (metadataObj != nullptr && metadataObj->IsReference())
+        readMetadata(device, metadataObj->GetReference());
+
+    auto infoObj = m_trailer.GetKey("Info");
+    if (infoObj != nullptr)
+    {
+        if (infoObj->IsReference())
+            m_infoRef = infoObj->GetReference();
+
+        auto info = resolve(device, *infoObj);
+        PdfDictionary* dict;
+        if (info->TryGetDictionary(dict))
+        {
+            for (auto& pair : *dict)
+                m_Info.AddKey(pair.first, *resolve(device, pair.second));
+        }
+    }
+
+    m_savedInfo = m_Info;
+
+    // Release the xref entries, they are not needed anymore
+    m_entries.Clear();
+}
+
+void PdfMetadataUpdater::SaveUpdate(const string_view& filename, PdfSaveOptions opts)
+{
+    FileStreamDevice device(filename, FileMode::Append);
+    SaveUpdate(device, opts);
+}
+
+void PdfMetadataUpdater::SaveUpdate(OutputStreamDevice& device, PdfSaveOptions opts)
+{
+    if (m_catalog == nullptr)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "No file was loaded");
+
+    if (!IsDirty())
+        return;
+
+    if ((opts & PdfSaveOptions::NoModifyDateUpdate) == PdfSaveOptions::None)
+        m_Info.AddKey("ModDate", PdfDate().ToString());
+
+    PdfWriteFlags writeFlags = PdfWriteFlags::None;
+    if ((opts & PdfSaveOptions::Clean) != PdfSaveOptions::None)
+        writeFlags = PdfWriteFlags::Clean;
+    else if ((opts & PdfSaveOptions::Minimal) != PdfSaveOptions::None)
+        writeFlags = PdfWriteFlags::Minimal;
+
+    device.Seek(0, SeekDirection::End);
+
+    // Start the update on a new line, the file may not end with one
+    device.Write('\n');
+
+    ObjectOffsets offsets;
+    charbuff buffer;
+    if (m_Info != m_savedInfo)
+    {
+        // An /Info dictionary direct in the trailer, or
+        // missing, is written as a new indirect object
+        if (!m_infoRef.IsIndirect())
+            m_infoRef = createReference();
+
+        PdfObject info(m_Info);
+        offsets.push_back({ m_infoRef, device.GetPosition() });
+        writeObject(device, info, m_infoRef, writeFlags, buffer);
+    }
+
+    if (m_metadataDirty)
+    {
+        bool addToCatalog = !m_metadataRef.IsIndirect();
+        if (addToCatalog)
+            m_metadataRef = createReference();
+
+        PdfDictionary dict;
+        dict.AddKey(PdfName::KeyType, PdfName("Metadata"));
+        dict.AddKey(PdfName::KeySubtype, PdfName("XML"));
+        PdfObject metadata(dict);
+
+        // NOTE: The XMP packet is stored unfiltered, so it can be found by
+        // applications scanning the file, as recommended by the specification
+        metadata.GetOrCreateStream().Set(m_Metadata, { });
+        offsets.push_back({ m_metadataRef, device.GetPosition() });
+        writeObject(device, metadata, m_metadataRef, writeFlags, buffer);
+
+        if (addToCatalog)
+        {
+            m_catalog->GetDictionary().AddKey("Metadata", m_metadataRef);
+            offsets.push_back({ m_catalogRef, device.GetPosition() });
+            writeObject(device, *m_catalog, m_catalogRef, writeFlags, buffer);
+        }
+    }
+
+    std::sort(offsets.begin(), offsets.end(), [](auto& lhs, auto& rhs) {
+        return lhs.first.ObjectNumber() < rhs.first.ObjectNumber();
+    });
+
+    size_t xrefOffset = device.GetPosition();
+    if (m_hasXRefStream)
+        writeXRefStream(device, offsets, writeFlags, buffer);
+    else
+        writeXRefTable(device, offsets, buffer);
+
+    utls::FormatTo(buffer, "startxref\n{}\n%%EOF\n", xrefOffset);
+    device.Write(buffer);
+    device.Flush();
+
+    // Chain a following update to this one
+    m_prevXRefOffset = xrefOffset;
+    m_savedInfo = m_Info;
+    m_metadataDirty = false;
+}
+
+void PdfMetadataUpdater::SetMetadataPacket(const bufferview& packet)
+{
+    m_Metadata = packet;
+    m_HasMetadata = true;
+    m_metadataDirty = true;
+}
+
+bool PdfMetadataUpdater::IsDirty() const
+{
+    return m_metadataDirty || m_Info != m_savedInfo;
+}
+
+void PdfMetadataUpdater::reset()
+{
+    m_entries.Clear();
+    m_trailer.Clear();
+    m_catalog = nullptr;
+    m_catalogRef = { };
+    m_infoRef = { };
+    m_metadataRef = { };
+    m_prevXRefOffset = 0;
+    m_size = 0;
+    m_hasXRefStream = false;
+    m_Info.Clear();
+    m_savedInfo.Clear();
+    m_Metadata.clear();
+    m_HasMetadata = false;
+    m_metadataDirty = false;
+}
+
+unique_ptr<PdfObject> PdfMetadataUpdater::readObject(InputStreamDevice& device, const PdfReference& ref)
+{
+    auto& entry = getEntry(ref, XRefEntryType::Unknown);
+    switch (entry.Type)
+    {
+        case XRefEntryType::InUse:
+        {
+            // The object is not bound to a document, so
+            // the references it contains are not resolved
+            unique_ptr<PdfParserObject> obj(new PdfParserObject(nullptr, ref, device, (ssize_t)entry.Offset));
+            // NOTE: Access the variant to read the object now
+            (void)obj->GetDataType();
+            return obj;
+        }
+        case XRefEntryType::Compressed:
+        {
+            auto obj = readCompressedObject(device, ref.ObjectNumber(), (uint32_t)entry.ObjectNumber);
+            obj->SetIndirectReference(ref);
+            return obj;
+        }
+        default:
+        {
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Object {} is free", ref.ToString());
+        }
+    }
+}
+
+void PdfMetadataUpdater::readMetadata(InputStreamDevice& device, const PdfReference& ref)
+{
+    // Streams are never in object streams
+    auto& entry = getEntry(ref, XRefEntryType::InUse);
+    PdfParserObject stream(nullptr, ref, device, (ssize_t)entry.Offset);
+    auto& dict = stream.GetDictionary();
+    auto lengthObj = dict.GetKey(PdfName::KeyLength);
+    if (lengthObj != nullptr && lengthObj->IsReference())
+        dict.AddKey(PdfName::KeyLength, *readObject(device, lengthObj->GetReference()));
+
+    stream.ParseStream();
+    stream.MustGetStream().ExtractTo(m_Metadata);
+    m_metadataRef = ref;
+    m_HasMetadata = true;
+}
+
+const PdfXRefEntry& PdfMetadataUpdater::getEntry(const PdfReference& ref, XRefEntryType type) const
+{
+    if (ref.ObjectNumber() >= m_entries.GetSize())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Object {} is not in the xref entries", ref.ToString());
+
+    auto& entry = m_entries[ref.ObjectNumber()];
+    if (!entry.Parsed || (type != XRefEntryType::Unknown && entry.Type != type))
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Object {} is not in the xref entries", ref.ToString());
+
+    return entry;
+}
+
+unique_ptr<PdfObject> PdfMetadataUpdater::readCompressedObject(InputStreamDevice& device, uint32_t objNum, uint32_t streamNum)
+{
+    auto& entry = getEntry(PdfReference(streamNum, 0), XRefEntryType::InUse);
+    PdfParserObject stream(nullptr, PdfReference(streamNum, 0), device, (ssize_t)entry.Offset);
+    auto& dict = stream.GetDictionary();
+
+    // Resolve an indirect stream length, as the
+    // stream object is not bound to a document
+    auto lengthObj = dict.GetKey(PdfName::KeyLength);
+    if (lengthObj != nullptr && lengthObj->IsReference())
+        dict.AddKey(PdfName::KeyLength, *readObject(device, lengthObj->GetReference()));
+
+    stream.ParseStream();
+
+    PdfIndirectObjectList objects;
+    PdfObjectStreamParser parser(stream, objects, std::make_shared<charbuff>(PdfTokenizer::BufferSize));
+    PdfObjectStreamParser::ObjectList read;
+    parser.Read({ (int64_t)objNum }, read);
+    if (read.size() == 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Object {} 0 R not found in object stream {} 0 R", objNum, streamNum);
+
+    return std::move(read.front());
+}
+
+unique_ptr<PdfObject> PdfMetadataUpdater::resolve(InputStreamDevice& device, const PdfObject& obj)
+{
+    if (obj.IsReference())
+        return readObject(device, obj.GetReference());
+    else
+        return unique_ptr<PdfObject>(new PdfObject(obj));
+}
+
+PdfReference PdfMetadataUpdater::createReference()
+{
+    return PdfReference(m_size++, 0);
+}
+
+void PdfMetadataUpdater::writeObject(OutputStreamDevice& device, PdfObject& obj, const PdfReference& ref,
+    PdfWriteFlags writeFlags, charbuff& buffer)
+{
+    obj.SetIndirectReference(ref);
+    obj.Write(device, writeFlags, nullptr, buffer);
+}
+
+void PdfMetadataUpdater::writeXRefTable(OutputStreamDevice& device, const ObjectOffsets& offsets, charbuff& buffer)
+{
+    device.Write("xref\n");
+
+    // Write a subsection for every run of consecutive object numbers
+    size_t i = 0;
+    while (i < offsets.size())
+    {
+        size_t count = 1;
+        while (i + count < offsets.size()
+            && offsets[i + count].first.ObjectNumber() == offsets[i].first.ObjectNumber() + count)
+        {
+            count++;
+        }
+
+        utls::FormatTo(buffer, "{} {}\n", offsets[i].first.ObjectNumber(), count);
+        device.Write(buffer);
+        for (size_t j = i; j < i + count; j++)
+        {
+            utls::FormatTo(buffer, "{:010} {:05} n \n", offsets[j].second, offsets[j].first.GenerationNumber());
+            device.Write(buffer);
+        }
+
+        i += count;
+    }
+
+    device.Write("trailer\n");
+    PdfObject trailer(createTrailer());
+    trailer.Write(device, PdfWriteFlags::None, nullptr, buffer);
+}
+
+void PdfMetadataUpdater::writeXRefStream(OutputStreamDevice& device, ObjectOffsets& offsets,
+    PdfWriteFlags writeFlags, charbuff& buffer)
+{
+    // The xref stream lists itself too
+    auto xrefRef = createReference();
+    offsets.push_back({ xrefRef, device.GetPosition() });
+
+    uint64_t maxOffset = 0;
+    uint16_t maxGeneration = 0;
+    PdfArray indices;
+    size_t i = 0;
+    while (i < offsets.size())
+    {
+        size_t count = 1;
+        while (i + count < offsets.size()
+            && offsets[i + count].first.ObjectNumber() == offsets[i].first.ObjectNumber() + count)
+        {
+            count++;
+        }
+
+        indices.Add(static_cast<int64_t>(offsets[i].first.ObjectNumber()));
+        indices.Add(static_cast<int64_t>(count));
+        i += count;
+    }
+
+    for (auto& pair : offsets)
+    {
+        maxOffset = std::max(maxOffset, (uint64_t)pair.second);
+        maxGeneration = std::max(maxGeneration, pair.first.GenerationNumber());
+    }
+
+    unsigned wArray[3] = { 1, std::max(getByteWidth(maxOffset), 1u), getByteWidth(maxGeneration) };
+    charbuff data(offsets.size() * (wArray[0] + wArray[1] + wArray[2]));
+    char* cursor = data.data();
+    for (auto& pair : offsets)
+    {
+        writeBigEndian(cursor, (uint64_t)XRefEntryType::InUse, wArray[0]);
+        writeBigEndian(cursor, pair.second, wArray[1]);
+        writeBigEndian(cursor, pair.first.GenerationNumber(), wArray[2]);
+    }
+
+    const int64_t wValues[3] = { wArray[0], wArray[1], wArray[2] };
+    PdfArray wArr;
+    wArr.AddNumbers(wValues);
+
+    auto trailer = createTrailer();
+    trailer.AddKey(PdfName::KeyType, PdfName("XRef"));
+    trailer.AddKey("Index", indices);
+    trailer.AddKey("W", wArr);
+    PdfObject xref(trailer);
+    xref.GetOrCreateStream().Set(data);
+    writeObject(device, xref, xrefRef, writeFlags, buffer);
+}
+
+PdfDictionary PdfMetadataUpdater::createTrailer() const
+{
+    PdfDictionary trailer;
+    trailer.AddKey(PdfName::KeySize, static_cast<int64_t>(m_size));
+    trailer.AddKey("Root", m_catalogRef);
+    if (m_infoRef.IsIndirect())
+        trailer.AddKey("Info", m_infoRef);
+
+    // NOTE: The /ID of the file is kept as it is
+    auto id = m_trailer.GetKey("ID");
+    if (id != nullptr)
+        trailer.AddKey("ID", *id);
+
+    trailer.AddKey("Prev", static_cast<int64_t>(m_prevXRefOffset));
+    return trailer;
+}
+
+unsigned getByteWidth(uint64_t value)
+{
+    unsigned ret = 0;
+    while (value != 0)
+    {
+        ret++;
+        value >>= 8;
+    }
+
+    return ret;
+}
+
+void writeBigEndian(char*& cursor, uint64_t value, unsigned width)
+{
+    for (unsigned i = width; i > 0; i--)
+        *cursor++ = (char)((value >> ((i - 1) * 8)) & 0xFF);
+}
@@ -0,0 +1,140 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_METADATA_UPDATER_H
+#define PDF_METADATA_UPDATER_H
+
+#include "PdfDeclarations.h"
+#include "PdfDictionary.h"
+#include "PdfReference.h"
+#include "PdfXRefEntry.h"
+
+namespace mm {
+
+class InputStreamDevice;
+class OutputStreamDevice;
+class PdfObject;
+
+/**
+ * Update the /Info dictionary and the XMP metadata of a PDF file
+ * with an incremental update, without loading the document
+ *
+ * Like PdfDocumentInfoProbe, only the xref sections, the trailers, the
+ * catalog, the /Info dictionary and the metadata stream are read, and
+ * no object is created for the other xref entries. The update appended
+ * by SaveUpdate() holds just the modified objects, a new xref section
+ * of the same kind of the last one, and a trailer chained to the
+ * previous one with /Prev. Encrypted files are not supported
+ */
+class PDFMM_API PdfMetadataUpdater final
+{
+public:
+    PdfMetadataUpdater();
+
+    /** Read the metadata of a PDF file
+     *
+     *  \param filename filename of the file to read
+     */
+    void Load(const std::string_view& filename);
+
+    /** Read the metadata of a PDF file in memory
+     *
+     *  \param buffer the buffer containing the PDF file
+     */
+    void LoadFromBuffer(const bufferview& buffer);
+
+    /** Read the metadata of a PDF file from an input device
+     *
+     *  \param device the input device to read from
+     */
+    void LoadFromDevice(InputStreamDevice& device);
+
+    /** Append the update to a file, that must be the one loaded
+     *
+     *  \param filename filename of the file to update
+     */
+    void SaveUpdate(const std::string_view& filename, PdfSaveOptions opts = PdfSaveOptions::None);
+
+    /** Append the update to an output device, that must start
+     *  with the data of the file loaded. Nothing is written if the
+     *  metadata was not modified. The updater can be modified and
+     *  saved again, to append a further update
+     *
+     *  \param device write to this output device
+     */
+    void SaveUpdate(OutputStreamDevice& device, PdfSaveOptions opts = PdfSaveOptions::None);
+
+public:
+    /** \returns the /Info dictionary of the file, empty if
+     *      it has none. The indirect values are resolved
+     */
+    inline PdfDictionary& GetInfo() { return m_Info; }
+    inline const PdfDictionary& GetInfo() const { return m_Info; }
+
+    /** \returns the XMP packet of the catalog /Metadata
+     *      stream, or nullptr if the file has none
+     */
+    inline const charbuff* GetMetadataPacket() const { return m_HasMetadata ? &m_Metadata : nullptr; }
+
+    /** Replace the XMP packet of the catalog /Metadata stream,
+     *  or add the stream if the file has none
+     */
+    void SetMetadataPacket(const bufferview& packet);
+
+    /** \returns true if the /Info dictionary or the XMP packet were modified
+     */
+    bool IsDirty() const;
+
+private:
+    void reset();
+
+    /** Read the indirect object with the given reference. Object
+     *  references in the read object are not resolved
+     */
+    std::unique_ptr<PdfObject> readObject(InputStreamDevice& device, const PdfReference& ref);
+
+    void readMetadata(InputStreamDevice& device, const PdfReference& ref);
+
+    const PdfXRefEntry& getEntry(const PdfReference& ref, XRefEntryType type) const;
+
+    std::unique_ptr<PdfObject> readCompressedObject(InputStreamDevice& device, uint32_t objNum, uint32_t streamNum);
+
+    std::unique_ptr<PdfObject> resolve(InputStreamDevice& device, const PdfObject& obj);
+
+    PdfReference createReference();
+
+    void writeObject(OutputStreamDevice& device, PdfObject& obj, const PdfReference& ref,
+        PdfWriteFlags writeFlags, charbuff& buffer);
+
+    void writeXRefTable(OutputStreamDevice& device, const std::vector<std::pair<PdfReference, size_t>>& offsets,
+        charbuff& buffer);
+
+    void writeXRefStream(OutputStreamDevice& device, std::vector<std::pair<PdfReference, size_t>>& offsets,
+        PdfWriteFlags writeFlags, charbuff& buffer);
+
+    PdfDictionary createTrailer() const;
+
+private:
+    PdfXRefEntries m_entries;
+    PdfDictionary m_trailer;
+    std::unique_ptr<PdfObject> m_catalog;
+    PdfReference m_catalogRef;
+    PdfReference m_infoRef;
+    PdfReference m_metadataRef;
+    size_t m_prevXRefOffset;
+    uint32_t m_size;
+    bool m_hasXRefStream;
+    PdfDictionary m_Info;
+    PdfDictionary m_savedInfo;
+    charbuff m_Metadata;
+    bool m_HasMetadata;
+    bool m_metadataDirty;
+};
+
+};
+
+#endif // PDF_METADATA_UPDATER_H
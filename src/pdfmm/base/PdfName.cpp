@@ -9,6 +9,8 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfName.h"
 
+#include <unordered_map>
+
 #include <pdfmm/private/PdfEncodingPrivate.h>
 
 #include "PdfOutputDevice.h"
@@ -22,6 +24,7 @@ template<typename T>
 void hexchr(const unsigned char ch, T& it);
 
 static void EscapeNameTo(string& dst, const string_view& view);
+static bool isEscapeFree(const string_view& view);
 static string UnescapeName(const string_view& view);
 
 const PdfName PdfName::KeyNull = PdfName();
@@ -35,7 +38,7 @@ const PdfName PdfName::KeyType = PdfName("Type");
 const PdfName PdfName::KeyFilter = PdfName("Filter");
 
 PdfName::PdfName()
-    : m_data(new NameData{ true, { }, nullptr })
+    : m_data(getEmptyData())
 {
 }
 
@@ -59,9 +62,21 @@ PdfName::PdfName(const PdfName& rhs)
 {
 }
 
+PdfName::PdfName(const shared_ptr<NameData>& data)
+    : m_data(data)
+{
+}
+
 PdfName::PdfName(charbuff&& buff)
-    : m_data(new NameData{ false, std::move(buff), nullptr })
 {
+    auto atom = tryGetAtom(buff);
+    if (atom == nullptr)
+    {
+        bool escapeFree = isEscapeFree(buff);
+        m_data = std::make_shared<NameData>(NameData{ false, std::move(buff), nullptr, 0, 0, escapeFree });
+    }
+    else
+        m_data = atom->m_data;
 }
 
 void PdfName::initFromUtf8String(const string_view& view)
@@ -71,7 +86,15 @@ void PdfName::initFromUtf8String(const string_view& view)
 
     if (view.length() == 0)
     {
-        m_data.reset(new NameData{ true, { }, nullptr });
+        m_data = getEmptyData();
+        return;
+    }
+
+    // NOTE: Interned names are plain ASCII, so the raw data equals the view
+    auto atom = tryGetAtom(view);
+    if (atom != nullptr)
+    {
+        m_data = atom->m_data;
         return;
     }
 
@@ -80,13 +103,25 @@ void PdfName::initFromUtf8String(const string_view& view)
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidName, "Characters in string must be PdfDocEncoding character set");
 
     if (isAsciiEqual)
-        m_data.reset(new NameData{ true, charbuff(view), nullptr });
+    {
+        m_data = std::make_shared<NameData>(NameData{ true, charbuff(view), nullptr, 0, 0, isEscapeFree(view) });
+    }
     else
-        m_data.reset(new NameData{ true, (charbuff)mm::ConvertUTF8ToPdfDocEncoding(view), std::make_unique<string>(view) });
+    {
+        auto chars = (charbuff)mm::ConvertUTF8ToPdfDocEncoding(view);
+        bool escapeFree = isEscapeFree(chars);
+        m_data = std::make_shared<NameData>(NameData{ true, std::move(chars), std::make_unique<string>(view), 0, 0, escapeFree });
+    }
 }
 
 PdfName PdfName::FromEscaped(const string_view& view)
 {
+    // Interned names have no escape sequences: they
+    // share the same data and don't allocate
+    auto atom = tryGetAtom(view);
+    if (atom != nullptr)
+        return *atom;
+
     return FromRaw(UnescapeName(view));
 }
 
@@ -101,7 +136,14 @@ void PdfName::Write(OutputStreamDevice& device, PdfWriteFlags,
     (void)encrypt;
     // Allow empty names, which are legal according to the PDF specification
     device.Write('/');
-    if (m_data->Chars.size() != 0)
+    if (m_data->Chars.size() == 0)
+        return;
+
+    if (m_data->IsEscapeFree)
+    {
+        device.Write(m_data->Chars);
+    }
+    else
     {
         EscapeNameTo(buffer, m_data->Chars);
         device.Write(buffer);
@@ -113,6 +155,9 @@ string PdfName::GetEscapedName() const
     if (m_data->Chars.size() == 0)
         return string();
 
+    if (m_data->IsEscapeFree)
+        return m_data->Chars;
+
     string ret;
     EscapeNameTo(ret, m_data->Chars);
     return ret;
@@ -184,6 +229,18 @@ void EscapeNameTo(string& dst, const string_view& view)
     }
 }
 
+// Check if the raw name is written as is, without escape sequences
+bool isEscapeFree(const string_view& view)
+{
+    for (char ch : view)
+    {
+        if (!PdfTokenizer::IsRegular(ch) || !PdfTokenizer::IsPrintable(ch) || ch == '#')
+            return false;
+    }
+
+    return true;
+}
+
 /** Interpret the passed string as an escaped PDF name
  *  and return the unescaped form.
  *
@@ -241,6 +298,14 @@ const string& PdfName::GetRawData() const
     return m_data->Chars;
 }
 
+size_t PdfName::GetHash() const
+{
+    if (m_data->AtomId != 0)
+        return m_data->Hash;
+
+    return hash<string_view>()(m_data->Chars);
+}
+
 const PdfName& PdfName::operator=(const PdfName& rhs)
 {
     m_data = rhs.m_data;
@@ -252,15 +317,16 @@ bool PdfName::operator==(const PdfName& rhs) const
     if (this->m_data == rhs.m_data)
         return true;
 
+    // Different interned names have different data
+    if (this->m_data->AtomId != 0 && rhs.m_data->AtomId != 0)
+        return false;
+
     return this->m_data->Chars == rhs.m_data->Chars;
 }
 
 bool PdfName::operator!=(const PdfName& rhs) const
 {
-    if (this->m_data == rhs.m_data)
-        return false;
-
-    return this->m_data->Chars != rhs.m_data->Chars;
+    return !operator==(rhs);
 }
 
 bool PdfName::operator==(const char* str) const
@@ -297,6 +363,9 @@ bool PdfName::operator!=(const string_view& view) const
 
 bool PdfName::operator<(const PdfName& rhs) const
 {
+    if (this->m_data == rhs.m_data)
+        return false;
+
     return this->m_data->Chars < rhs.m_data->Chars;
 }
 
@@ -305,6 +374,97 @@ PdfName::operator string_view() const
     return m_data->Chars;
 }
 
+const shared_ptr<PdfName::NameData>& PdfName::getEmptyData()
+{
+    static shared_ptr<NameData> s_emptyData = std::make_shared<NameData>(NameData{ true, { }, nullptr, 0, 0, true });
+    return s_emptyData;
+}
+
+struct PdfName::AtomTable
+{
+    // Indexed by atom id - 1
+    vector<PdfName> Atoms;
+    unordered_map<string_view, const PdfName*> Map;
+};
+
+const PdfName::AtomTable& PdfName::getAtomTable()
+{
+    // The table is immutable after its initialization, so it's safe
+    // to use from multiple threads. The keys are views on the names
+    // data, which is never modified since the names are plain ASCII
+    static AtomTable s_atoms = []() {
+        AtomTable ret;
+        unsigned atomId = 1;
+        for (string_view name : {
+            "Type", "Subtype", "Length", "Filter", "DecodeParms", "FlateDecode",
+            "Predictor", "Columns", "Size", "Index", "Prev", "Root", "Info", "ID",
+            "XRef", "ObjStm", "N", "First", "Extends", "Catalog", "Pages", "Page",
+            "Kids", "Count", "Parent", "MediaBox", "CropBox", "Rotate", "Resources",
+            "Contents", "Annots", "Font", "XObject", "ExtGState", "ColorSpace",
+            "Pattern", "Shading", "ProcSet", "PDF", "Text", "ImageB", "ImageC",
+            "Image", "Form", "BBox", "Matrix", "Width", "Height", "BitsPerComponent",
+            "DeviceRGB", "DeviceGray", "DeviceCMYK", "Type1", "TrueType", "Type0",
+            "BaseFont", "Encoding", "WinAnsiEncoding", "ToUnicode", "FirstChar",
+            "LastChar", "Widths", "FontDescriptor", "FontName", "Flags", "FontBBox",
+            "ItalicAngle", "Ascent", "Descent", "CapHeight", "StemV", "FontFile2",
+            "DescendantFonts", "Annot", "Link", "Widget", "Rect", "Border", "A",
+            "S", "URI", "Dest", "P", "F", "D", "Outlines", "Title", "Next", "Last",
+            "Names", "Metadata", "XML", "StructParents", "Group", "Transparency",
+            "CS", "SMask", "Mask", "Decode", "Interpolate", "Linearized", "W", "DW",
+            "CIDFontType2", "CIDSystemInfo", "Registry", "Ordering", "Supplement",
+            "CIDToGIDMap", "Identity", "Identity-H", "FontFile", "FontFile3",
+            "Differences", "MissingWidth", "Producer", "Creator", "CreationDate",
+            "ModDate", "Author", "Subject", "Keywords", "Encrypt", "AcroForm",
+            "Fields", "FT", "T", "V", "DA", "AP", "AS", "MK", "Ff", "DR", "Off",
+            "GS0", "F1", "F2", "Im0", "Im1", "CA", "ca", "LW", "BM", "Normal",
+            "DCTDecode", "ASCIIHexDecode", "ASCII85Decode", "LZWDecode", "Indexed",
+            "ICCBased", "Alternate", "Lang", "MarkInfo", "StructTreeRoot", "ViewerPreferences"
+            })
+        {
+            ret.Atoms.push_back(PdfName(std::make_shared<NameData>(NameData{ true, charbuff(name), nullptr,
+                atomId++, hash<string_view>()(name), isEscapeFree(name) })));
+        }
+
+        // NOTE: Map the names after the vector is complete, as pointers
+        // to the elements are not stable while it grows
+        for (auto& atom : ret.Atoms)
+            ret.Map.emplace(atom.m_data->Chars, &atom);
+
+        return ret;
+    }();
+    return s_atoms;
+}
+
+const PdfName* PdfName::tryGetAtom(const string_view& rawdata)
+{
+    auto& map = getAtomTable().Map;
+    auto found = map.find(rawdata);
+    if (found == map.end())
+        return nullptr;
+
+    return found->second;
+}
+
+const PdfName* PdfName::getAtom() const
+{
+    if (m_data->AtomId == 0)
+        return nullptr;
+
+    return &getAtomTable().Atoms[m_data->AtomId - 1];
+}
+
+size_t PdfName::getMemoryUsage() const
+{
+    if (m_data->AtomId != 0 || m_data == getEmptyData())
+        return 0;
+
+    size_t ret = sizeof(NameData) + utls::GetHeapSize(m_data->Chars);
+    if (m_data->Utf8String != nullptr)
+        ret += sizeof(string) + utls::GetHeapSize(*m_data->Utf8String);
+
+    return ret;
+}
+
 /**
  * This function writes a hex encoded representation of the character
  * `ch' to `buf', advancing the iterator by two steps.
@@ -64,7 +64,8 @@ public:
      *          without the leading / .
      *
      *  There is no corresponding GetEscapedLength(), since
-     *  generating the return value is somewhat expensive.
+     *  generating the return value is somewhat expensive,
+     *  unless the name has no characters to escape
      */
     std::string GetEscapedName() const;
 
@@ -84,6 +85,11 @@ public:
      */
     const std::string& GetRawData() const;
 
+    /** \returns the hash of the raw data of this name object,
+     *      which is precomputed for the interned common names
+     */
+    size_t GetHash() const;
+
     /** Assign another name to this object
      *  \param rhs another PdfName object
      */
@@ -129,6 +135,24 @@ public:
     static const PdfName KeyFilter;
 
 private:
+    friend class PdfVariant;
+    friend class PdfObject;
+
+    struct NameData;
+    PdfName(const std::shared_ptr<NameData>& data);
+
+    /** \returns the immortal instance of the interned name
+     *      with the same data, or nullptr if the name is not interned.
+     *      Variants holding an interned name point to it, so
+     *      they don't allocate
+     */
+    const PdfName* getAtom() const;
+
+    /** \returns the memory of the shared data of the name,
+     *      or 0 if it's interned
+     */
+    size_t getMemoryUsage() const;
+
     void expandUtf8String() const;
     void initFromUtf8String(const std::string_view& view);
 
@@ -141,7 +165,26 @@ private:
         // It can store also the utf8 expanded string, if coincident
         charbuff Chars;
         std::unique_ptr<std::string> Utf8String;
+        // Id of the interned common names, or 0. Names with
+        // the same raw data of an interned name share its data
+        unsigned AtomId;
+        size_t Hash;
+        // True if the raw data has no characters to escape, so
+        // it's written as is. Names are mostly plain ASCII
+        bool IsEscapeFree;
     };
+
+    // Empty names are never modified, so they all share the same data
+    static const std::shared_ptr<NameData>& getEmptyData();
+
+    struct AtomTable;
+    static const AtomTable& getAtomTable();
+
+    /** \returns the interned name with the given
+     *      raw data, or nullptr if there's none
+     */
+    static const PdfName* tryGetAtom(const std::string_view& rawdata);
+
 private:
     std::shared_ptr<NameData> m_data;
 };
@@ -157,7 +200,7 @@ namespace std
     {
         size_t operator()(const mm::PdfName& name) const noexcept
         {
-            return hash<string_view>()(name.GetRawData());
+            return name.GetHash();
         }
     };
 }
@@ -8,11 +8,14 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfNameTree.h"
 
+#include <algorithm>
+
 #include "PdfDocument.h"
 #include "PdfArray.h"
 #include "PdfDictionary.h"
 #include "PdfOutputDevice.h"
 
+using namespace std;
 using namespace mm;
 
 #define BALANCE_TREE_MAX 65
@@ -21,6 +24,11 @@ using namespace mm;
 #define BALANCE_TREE_MAX 9
 */
 
+using NameTreeValues = vector<pair<PdfString, PdfObject>>;
+
+static void sortValues(NameTreeValues& values);
+static PdfArray createLimits(const PdfObject& first, const PdfObject& last);
+
 class PdfNameTreeNode
 {
 public:
@@ -326,21 +334,148 @@ void PdfNameTree::AddValue(const PdfName& tree, const PdfString& key, const PdfO
         PDFMM_RAISE_ERROR(PdfErrorCode::InternalLogic);
 }
 
+void PdfNameTree::AddValues(const PdfName& tree, NameTreeValues values)
+{
+    sortValues(values);
+
+    // Merge the values already in the tree, which are overwritten
+    // by the new ones, as the last of the duplicated keys is kept
+    auto& root = *this->GetRootNode(tree, true);
+    NameTreeValues existing;
+    MoveToList(root, existing);
+    if (existing.size() != 0)
+    {
+        sortValues(existing);
+        NameTreeValues merged;
+        merged.reserve(existing.size() + values.size());
+        std::merge(std::make_move_iterator(existing.begin()), std::make_move_iterator(existing.end()),
+            std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()),
+            std::back_inserter(merged), [](const pair<PdfString, PdfObject>& lhs, const pair<PdfString, PdfObject>& rhs) {
+                return lhs.first.GetString() < rhs.first.GetString();
+            });
+        values = std::move(merged);
+        sortValues(values);
+    }
+
+    auto& rootDict = root.GetDictionary();
+    rootDict.RemoveKey("Kids");
+    rootDict.RemoveKey("Names");
+    rootDict.RemoveKey("Limits");
+    if (values.size() == 0)
+        return;
+
+    if (values.size() <= BALANCE_TREE_MAX)
+    {
+        PdfArray names;
+        names.reserve(values.size() * 2);
+        for (auto& pair : values)
+        {
+            names.Add(pair.first);
+            names.Add(std::move(pair.second));
+        }
+
+        rootDict.AddKey("Names", std::move(names));
+        return;
+    }
+
+    // Fill the leaves evenly, then group the nodes in the
+    // same way, a level at a time, until the root holds them
+    auto& objects = this->GetObject().GetDocument()->GetObjects();
+    vector<PdfObject*> nodes;
+    size_t count = (values.size() + BALANCE_TREE_MAX - 1) / BALANCE_TREE_MAX;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t begin = values.size() * i / count;
+        size_t end = values.size() * (i + 1) / count;
+        PdfArray names;
+        names.reserve((end - begin) * 2);
+        for (size_t j = begin; j < end; j++)
+        {
+            names.Add(values[j].first);
+            names.Add(std::move(values[j].second));
+        }
+
+        auto leaf = objects.CreateDictionaryObject();
+        leaf->GetDictionary().AddKey("Limits", createLimits(values[begin].first, values[end - 1].first));
+        leaf->GetDictionary().AddKey("Names", std::move(names));
+        nodes.push_back(leaf);
+    }
+
+    while (nodes.size() > BALANCE_TREE_MAX)
+    {
+        vector<PdfObject*> parents;
+        count = (nodes.size() + BALANCE_TREE_MAX - 1) / BALANCE_TREE_MAX;
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t begin = nodes.size() * i / count;
+            size_t end = nodes.size() * (i + 1) / count;
+            PdfArray kids;
+            kids.reserve(end - begin);
+            for (size_t j = begin; j < end; j++)
+                kids.Add(nodes[j]->GetIndirectReference());
+
+            auto node = objects.CreateDictionaryObject();
+            node->GetDictionary().AddKey("Limits", createLimits(
+                nodes[begin]->GetDictionary().MustFindKey("Limits").GetArray()[0],
+                nodes[end - 1]->GetDictionary().MustFindKey("Limits").GetArray()[1]));
+            node->GetDictionary().AddKey("Kids", std::move(kids));
+            parents.push_back(node);
+        }
+
+        nodes = std::move(parents);
+    }
+
+    // Root node is not allowed to have a limits key
+    PdfArray kids;
+    kids.reserve(nodes.size());
+    for (auto node : nodes)
+        kids.Add(node->GetIndirectReference());
+
+    rootDict.AddKey("Kids", std::move(kids));
+}
+
 PdfObject* PdfNameTree::GetValue(const PdfName& tree, const PdfString& key) const
 {
-    auto obj = this->GetRootNode(tree);
     PdfObject* result = nullptr;
+    auto& objects = this->GetObject().GetDocument()->GetObjects();
+    auto index = m_Indices.find(tree);
+    if (index != m_Indices.end() && index->second.ModificationCount != objects.GetModificationCount())
+    {
+        m_Indices.erase(index);
+        index = m_Indices.end();
+    }
 
-    if (obj != nullptr)
+    if (index == m_Indices.end())
+    {
+        auto obj = this->GetRootNode(tree);
+        if (obj != nullptr)
+            result = this->GetKeyValue(*obj, key);
+    }
+    else
     {
-        result = this->GetKeyValue(*obj, key);
-        if (result != nullptr && result->IsReference())
-            result = this->GetObject().GetDocument()->GetObjects().GetObject(result->GetReference());
+        auto found = index->second.Values.find(key.GetString());
+        if (found != index->second.Values.end())
+            result = found->second;
     }
 
+    if (result != nullptr && result->IsReference())
+        result = objects.GetObject(result->GetReference());
+
     return result;
 }
 
+void PdfNameTree::BuildIndex(const PdfName& tree)
+{
+    auto& index = m_Indices[tree];
+    index.Values.clear();
+    auto obj = this->GetRootNode(tree);
+    if (obj != nullptr)
+        AddToIndex(*obj, index.Values);
+
+    // Resolving the nodes doesn't modify the document
+    index.ModificationCount = this->GetObject().GetDocument()->GetObjects().GetModificationCount();
+}
+
 PdfObject* PdfNameTree::GetKeyValue(PdfObject& obj, const PdfString& key) const
 {
     if (PdfNameTree::CheckLimits(obj, key) != PdfNameLimits::Inside)
@@ -348,7 +483,36 @@ PdfObject* PdfNameTree::GetKeyValue(PdfObject& obj, const PdfString& key) const
 
     if (obj.GetDictionary().HasKey("Kids"))
     {
+        // The kids are sorted, so search with a binary search the kid
+        // whose limits include the key. Kids without limits or not found
+        // make the binary search unreliable, and then all kids are searched
         auto& kids = obj.GetDictionary().MustFindKey("Kids").GetArray();
+        size_t low = 0;
+        size_t high = kids.size();
+        while (low < high)
+        {
+            size_t mid = low + (high - low) / 2;
+            auto childObj = this->GetObject().GetDocument()->GetObjects().GetObject(kids[mid].GetReference());
+            if (childObj == nullptr || !childObj->GetDictionary().HasKey("Limits"))
+                break;
+
+            switch (PdfNameTree::CheckLimits(*childObj, key))
+            {
+                case PdfNameLimits::Before:
+                    high = mid;
+                    break;
+                case PdfNameLimits::After:
+                    low = mid + 1;
+                    break;
+                case PdfNameLimits::Inside:
+                default:
+                    return GetKeyValue(*childObj, key);
+            }
+        }
+
+        if (low >= high)
+            return nullptr;
+
         for (auto& child : kids)
         {
             auto childObj = this->GetObject().GetDocument()->GetObjects().GetObject(child.GetReference());
@@ -372,28 +536,58 @@ PdfObject* PdfNameTree::GetKeyValue(PdfObject& obj, const PdfString& key) const
     }
     else
     {
-        auto& names = obj.GetDictionary().MustFindKey("Names").GetArray();
-        PdfArray::iterator it = names.begin();
+        return GetNamesValue(obj, key);
+    }
 
-        // a names array is a set of PdfString/PdfObject pairs
-        // so we loop in sets of two - getting each pair
-        while (it != names.end())
+    return nullptr;
+}
+
+PdfObject* PdfNameTree::GetNamesValue(PdfObject& obj, const PdfString& key) const
+{
+    // a names array is a set of PdfString/PdfObject pairs
+    // sorted by key, so we search the pairs with a binary search
+    auto& names = obj.GetDictionary().MustFindKey("Names").GetArray();
+    auto& keyStr = key.GetString();
+    PdfObject* value = nullptr;
+    size_t low = 0;
+    size_t high = names.size() / 2;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        int compare = names[mid * 2].GetString().GetString().compare(keyStr);
+        if (compare == 0)
         {
-            if (it->GetString() == key)
-            {
-                it++;
-                if (it->IsReference())
-                    return this->GetObject().GetDocument()->GetObjects().GetObject((*it).GetReference());
+            value = &names[mid * 2 + 1];
+            break;
+        }
+        else if (compare > 0)
+        {
+            high = mid;
+        }
+        else
+        {
+            low = mid + 1;
+        }
+    }
 
-                return &(*it);
+    if (value == nullptr)
+    {
+        // Fall back to a linear search, as some
+        // producers write unsorted names arrays
+        for (size_t i = 0; i + 1 < names.size(); i += 2)
+        {
+            if (names[i].GetString() == key)
+            {
+                value = &names[i + 1];
+                break;
             }
-
-            it += 2;
         }
-
     }
 
-    return nullptr;
+    if (value != nullptr && value->IsReference())
+        return this->GetObject().GetDocument()->GetObjects().GetObject(value->GetReference());
+
+    return value;
 }
 
 PdfObject* PdfNameTree::GetRootNode(const PdfName& name, bool create) const
@@ -491,6 +685,68 @@ void PdfNameTree::AddToDictionary(PdfObject& obj, PdfDictionary& dict)
     }
 }
 
+void PdfNameTree::AddToIndex(PdfObject& obj, unordered_map<string, PdfObject*>& values, int depth)
+{
+    // Prevent stack overflow with loops in the kids
+    const int maxRecursionDepth = 1000;
+    if (depth > maxRecursionDepth)
+        PDFMM_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
+
+    if (obj.GetDictionary().HasKey("Kids"))
+    {
+        auto& kids = obj.GetDictionary().MustFindKey("Kids").GetArray();
+        for (auto& child : kids)
+        {
+            auto childObj = this->GetObject().GetDocument()->GetObjects().GetObject(child.GetReference());
+            if (childObj != nullptr)
+                this->AddToIndex(*childObj, values, depth + 1);
+        }
+    }
+    else if (obj.GetDictionary().HasKey("Names"))
+    {
+        // The first occurrence of a key is kept, like in a linear search
+        auto& names = obj.GetDictionary().MustFindKey("Names").GetArray();
+        for (size_t i = 0; i + 1 < names.size(); i += 2)
+            values.emplace(names[i].GetString().GetString(), &names[i + 1]);
+    }
+}
+
+void PdfNameTree::MoveToList(PdfObject& obj, NameTreeValues& values, int depth)
+{
+    // Prevent stack overflow with loops in the kids
+    const int maxRecursionDepth = 1000;
+    if (depth > maxRecursionDepth)
+        PDFMM_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
+
+    auto& objects = this->GetObject().GetDocument()->GetObjects();
+    auto kidsObj = obj.GetDictionary().FindKey("Kids");
+    if (kidsObj != nullptr && kidsObj->IsArray())
+    {
+        PdfReference ref;
+        for (auto& child : kidsObj->GetArray())
+        {
+            PdfObject* childObj;
+            if (!child.TryGetReference(ref) || (childObj = objects.GetObject(ref)) == nullptr)
+                continue;
+
+            this->MoveToList(*childObj, values, depth + 1);
+            (void)objects.RemoveObject(ref);
+        }
+    }
+
+    auto namesObj = obj.GetDictionary().FindKey("Names");
+    if (namesObj != nullptr && namesObj->IsArray())
+    {
+        auto& names = namesObj->GetArray();
+        const PdfString* key;
+        for (size_t i = 0; i + 1 < names.size(); i += 2)
+        {
+            if (names[i].TryGetString(key))
+                values.emplace_back(*key, std::move(names[i + 1]));
+        }
+    }
+}
+
 PdfObject* PdfNameTree::GetJavaScriptNode(bool create) const
 {
     return this->GetRootNode("JavaScript", create);
@@ -500,3 +756,33 @@ PdfObject* PdfNameTree::GetDestsNode(bool create) const
 {
     return this->GetRootNode("Dests", create);
 }
+
+// Sort the values by key, keeping the last of the duplicated keys
+void sortValues(NameTreeValues& values)
+{
+    std::stable_sort(values.begin(), values.end(), [](const pair<PdfString, PdfObject>& lhs, const pair<PdfString, PdfObject>& rhs) {
+        return lhs.first.GetString() < rhs.first.GetString();
+    });
+
+    size_t count = 0;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        if (count != 0 && values[count - 1].first.GetString() == values[i].first.GetString())
+            count--;
+
+        if (count != i)
+            values[count] = std::move(values[i]);
+
+        count++;
+    }
+
+    values.resize(count);
+}
+
+PdfArray createLimits(const PdfObject& first, const PdfObject& last)
+{
+    PdfArray limits;
+    limits.Add(first);
+    limits.Add(last);
+    return limits;
+}
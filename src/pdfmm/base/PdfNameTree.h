@@ -10,12 +10,16 @@
 
 #include "PdfDeclarations.h"
 
+#include <map>
+#include <unordered_map>
+
 #include "PdfElement.h"
+#include "PdfName.h"
+#include "PdfString.h"
 
 namespace mm {
 
 class PdfDictionary;
-class PdfName;
 class PdfObject;
 class PdfString;
 class PdfIndirectObjectList;
@@ -48,6 +52,17 @@ public:
      */
     void AddValue(const PdfName& tree, const PdfString& key, const PdfObject& value);
 
+    /** Insert many keys and values in one of the dictionaries of the name tree.
+     *  The values are sorted once, merged with the ones already in the tree,
+     *  and the tree is rewritten balanced, with the leaves and the nodes
+     *  filled evenly, which is much faster than inserting them one by one
+     *  \param tree name of the tree to insert the values in
+     *  \param values the keys and the values to insert, in any order. The keys
+     *      already in the tree are overwritten, and of the duplicated keys the
+     *      last one is kept
+     */
+    void AddValues(const PdfName& tree, std::vector<std::pair<PdfString, PdfObject>> values);
+
     /** Get the object referenced by a string key in one of the dictionaries
      *  of the name tree.
      *  \param tree name of the tree to search for the key.
@@ -58,6 +73,15 @@ public:
      */
     PdfObject* GetValue(const PdfName& tree, const PdfString& key) const;
 
+    /** Index all the keys of one of the dictionaries of the name tree,
+     *  with a single walk of the tree, so the following lookups in
+     *  it with GetValue() are hash lookups, e.g. to resolve many
+     *  named destinations. The index is dropped when the document
+     *  is modified, and the lookups walk the tree again
+     *  \param tree name of the tree to index
+     */
+    void BuildIndex(const PdfName& tree);
+
     /** Tests whether a certain nametree has a value.
      *
      *  It is generally faster to use GetValue and check for nullptr
@@ -119,6 +143,11 @@ private:
      */
     PdfObject* GetRootNode(const PdfName& name, bool create = false) const;
 
+    /** Find the value for key in the names array of a leaf node,
+     *  with a binary search as the array is sorted
+     */
+    PdfObject* GetNamesValue(PdfObject& obj, const PdfString& key) const;
+
     /** Recursively walk through the name tree and find the value for key.
      *  \param obj the name tree
      *  \param key the key to find a value for
@@ -132,6 +161,24 @@ private:
      *  \param dict a dictionary
      */
     void AddToDictionary(PdfObject& obj, PdfDictionary& dict);
+
+    void AddToIndex(PdfObject& obj, std::unordered_map<std::string, PdfObject*>& values, int depth = 0);
+
+    /** Move the keys and the values of a node and of its children to a list,
+     *  removing the children
+     */
+    void MoveToList(PdfObject& obj, std::vector<std::pair<PdfString, PdfObject>>& values, int depth = 0);
+
+private:
+    struct NameIndex
+    {
+        uint64_t ModificationCount;
+        std::unordered_map<std::string, PdfObject*> Values;
+    };
+
+private:
+    // The indices of the trees, by name of the tree
+    mutable std::map<PdfName, NameIndex> m_Indices;
 };
 
 };
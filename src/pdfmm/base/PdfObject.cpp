@@ -11,12 +11,17 @@
 
 #include "PdfDocument.h"
 #include "PdfArray.h"
+#include "PdfData.h"
 #include "PdfDictionary.h"
 #include "PdfEncrypt.h"
 #include "PdfFileObjectStream.h"
 #include "PdfMemoryObjectStream.h"
+#include "PdfSpillObjectStream.h"
+#include "PdfParserObject.h"
 #include "PdfStreamDevice.h"
 
+#include <pdfmm/private/PdfTracePrivate.h>
+
 using namespace std;
 using namespace mm;
 
@@ -160,9 +165,17 @@ void PdfObject::SetDocument(PdfDocument* document)
 
 void PdfObject::DelayedLoad() const
 {
+    // NOTE: Don't write the flag if it's already set, so
+    // the objects of frozen documents are never written
+    if (!m_IsAccessed)
+        m_IsAccessed = true;
+
     if (m_IsDelayedLoadDone)
         return;
 
+    PDFMM_TRACE_SCOPE(trace, ObjectLoad, m_Document);
+    PDFMM_TRACE_SET(trace, Reference, m_IndirectReference);
+    PdfMemoryResourceScope scope(m_Document == nullptr ? nullptr : m_Document->GetMemoryResource());
     const_cast<PdfObject&>(*this).DelayedLoadImpl();
     m_IsDelayedLoadDone = true;
     const_cast<PdfObject&>(*this).SetVariantOwner();
@@ -203,35 +216,62 @@ void PdfObject::initObject()
     // By default delayed load is disabled
     m_IsDelayedLoadDone = true;
     m_IsDelayedLoadStreamDone = true;
+    m_IsAccessed = false;
+    m_IsPinned = false;
 }
 
 void PdfObject::Write(OutputStreamDevice& device, PdfWriteFlags writeMode,
-    const PdfEncrypt* encrypt_, charbuff& buffer) const
+    const PdfEncrypt* encrypt, charbuff& buffer) const
+{
+    write(device, writeMode, m_IndirectReference, nullptr, encrypt, buffer);
+}
+
+void PdfObject::write(OutputStreamDevice& device, PdfWriteFlags writeMode, const PdfReference& reference,
+    PdfVariant* variant, const PdfEncrypt* encrypt_, charbuff& buffer) const
 {
     DelayedLoad();
-    DelayedLoadStream();
+    if (variant == nullptr)
+        variant = &const_cast<PdfObject&>(*this).m_Variant;
+
+    // Streams not loaded yet are copied as they are from the
+    // source, as they can't be modified without loading them
+    size_t rawStreamLength;
+    bool rawStream = !m_IsDelayedLoadStreamDone && encrypt_ == nullptr
+        && TryGetRawStreamLength(rawStreamLength);
+    if (!rawStream)
+        DelayedLoadStream();
 
     PdfStatefulEncrypt encrypt;
     if (encrypt_ != nullptr)
-        encrypt = PdfStatefulEncrypt(*encrypt_, m_IndirectReference);
+        encrypt = PdfStatefulEncrypt(*encrypt_, reference);
 
-    if (m_IndirectReference.IsIndirect())
+    bool minimal = (writeMode & (PdfWriteFlags::Clean | PdfWriteFlags::Minimal)) == PdfWriteFlags::Minimal;
+    if (reference.IsIndirect())
     {
-        if ((writeMode & PdfWriteFlags::Clean) == PdfWriteFlags::None
-            && (writeMode & PdfWriteFlags::NoPDFAPreserve) != PdfWriteFlags::None)
+        buffer.clear();
+        utls::AppendNumberTo(buffer, reference.ObjectNumber());
+        buffer.push_back(' ');
+        utls::AppendNumberTo(buffer, reference.GenerationNumber());
+        if (minimal || ((writeMode & PdfWriteFlags::Clean) == PdfWriteFlags::None
+            && (writeMode & PdfWriteFlags::NoPDFAPreserve) != PdfWriteFlags::None))
         {
-            utls::FormatTo(buffer, "{} {} obj", m_IndirectReference.ObjectNumber(), m_IndirectReference.GenerationNumber());
-            device.Write(buffer);
+            buffer.append(" obj");
         }
         else
         {
             // PDF/A compliance requires all objects to be written in a clean way
-            utls::FormatTo(buffer, "{} {} obj\n", m_IndirectReference.ObjectNumber(), m_IndirectReference.GenerationNumber());
-            device.Write(buffer);
+            buffer.append(" obj\n");
         }
+        device.Write(buffer);
     }
 
-    if (m_Stream != nullptr)
+    if (rawStream)
+    {
+        // Add the key without triggering SetDirty
+        variant->GetDictionary()
+            .AddKey(PdfName::KeyLength, static_cast<int64_t>(rawStreamLength), true);
+    }
+    else if (m_Stream != nullptr)
     {
         // Set length if it is a key
         auto fileStream = dynamic_cast<PdfFileObjectStream*>(m_Stream.get());
@@ -244,18 +284,31 @@ void PdfObject::Write(OutputStreamDevice& device, PdfWriteFlags writeMode,
                 length = encrypt.CalculateStreamLength(length);
 
             // Add the key without triggering SetDirty
-            const_cast<PdfObject&>(*this).m_Variant.GetDictionary()
+            variant->GetDictionary()
                 .AddKey(PdfName::KeyLength, static_cast<int64_t>(length), true);
         }
     }
 
-    m_Variant.Write(device, writeMode, encrypt, buffer);
-    device.Write('\n');
+    variant->Write(device, writeMode, encrypt, buffer);
 
-    if (m_Stream != nullptr)
+    // The "stream" and "endobj" keywords can follow a delimiter with no separator
+    if (!minimal || !reference.IsIndirect() || !IsDelimitedDataType(variant->GetDataType()))
+        device.Write('\n');
+
+    if (rawStream)
+    {
+        device.Write("stream\n");
+        WriteRawStream(device);
+        device.Write("\nendstream\n");
+    }
+    else if (m_Stream != nullptr && dynamic_cast<PdfFileObjectStream*>(m_Stream.get()) == nullptr)
+    {
+        // NOTE: The data of file streams is written
+        // to the device while it's appended
         m_Stream->Write(device, encrypt);
+    }
 
-    if (m_IndirectReference.IsIndirect())
+    if (reference.IsIndirect())
         device.Write("endobj\n");
 
     // After write we ca reset the dirty flag
@@ -370,6 +423,10 @@ void PdfObject::moveStreamFrom(PdfObject& obj)
 {
     obj.DelayedLoadStream();
     m_Stream = std::move(obj.m_Stream);
+    if (m_Document != nullptr && m_IndirectReference.IsIndirect())
+        m_Document->GetObjects().invalidateDecodedStream(m_IndirectReference);
+    if (obj.m_Document != nullptr && obj.m_IndirectReference.IsIndirect())
+        obj.m_Document->GetObjects().invalidateDecodedStream(obj.m_IndirectReference);
 }
 
 void PdfObject::EnableDelayedLoading()
@@ -389,6 +446,24 @@ void PdfObject::DelayedLoadStreamImpl()
     PDFMM_RAISE_ERROR(PdfErrorCode::InternalLogic);
 }
 
+bool PdfObject::TryGetRawStreamLength(size_t& length) const
+{
+    length = 0;
+    return false;
+}
+
+void PdfObject::WriteRawStream(OutputStreamDevice& device) const
+{
+    (void)device;
+    PDFMM_RAISE_ERROR(PdfErrorCode::InternalLogic);
+}
+
+bool PdfObject::TryGetRawStreamView(bufferview& view) const
+{
+    view = { };
+    return false;
+}
+
 void PdfObject::Assign(const PdfObject& rhs)
 {
     if (&rhs == this)
@@ -480,6 +555,8 @@ void PdfObject::SetDirty()
     {
         // Set dirty only if is indirect object
         setDirty();
+        if (m_Document != nullptr)
+            m_Document->GetObjects().m_ModificationCount++;
     }
     else if (m_Parent != nullptr)
     {
@@ -491,7 +568,12 @@ void PdfObject::SetDirty()
 
 void PdfObject::setDirty()
 {
+    if (m_IsDirty)
+        return;
+
     m_IsDirty = true;
+    if (m_Document != nullptr && m_IndirectReference.IsIndirect())
+        m_Document->GetObjects().trackDirtyObject(*this);
 }
 
 void PdfObject::resetDirty()
@@ -519,6 +601,138 @@ const PdfVariant& PdfObject::GetVariant() const
     return m_Variant;
 }
 
+void PdfObject::ForceLoad() const
+{
+    // Load the object, its stream and the nested arrays
+    // read on demand, visiting the direct objects
+    (void)HasStream();
+    vector<const PdfObject*> stack;
+    stack.push_back(this);
+    while (stack.size() != 0)
+    {
+        auto current = stack.back();
+        stack.pop_back();
+        const PdfArray* arr;
+        const PdfDictionary* dict;
+        if (current->TryGetArray(arr))
+        {
+            for (auto& child : *arr)
+                stack.push_back(&child);
+        }
+        else if (current->TryGetDictionary(dict))
+        {
+            for (auto& pair : *dict)
+                stack.push_back(&pair.second);
+        }
+    }
+}
+
+size_t PdfObject::GetMemoryUsage() const
+{
+    PdfMemoryStats stats;
+    CollectMemoryUsage(stats);
+    return stats.GetTotal();
+}
+
+void PdfObject::CollectMemoryUsage(PdfMemoryStats& stats) const
+{
+    stats.Objects += sizeof(PdfObject);
+    if (dynamic_cast<const PdfParserObject*>(this) != nullptr)
+        stats.ParserCache += sizeof(PdfParserObject) - sizeof(PdfObject);
+
+    collectDataMemoryUsage(stats);
+}
+
+void PdfObject::collectDataMemoryUsage(PdfMemoryStats& stats) const
+{
+    // NOTE: Access the variant directly, so objects are not loaded
+    switch (m_Variant.GetDataType())
+    {
+        case PdfDataType::Name:
+        {
+            auto& name = m_Variant.GetName();
+            if (name.getAtom() != &name)
+                stats.Names += sizeof(PdfName) + name.getMemoryUsage();
+            break;
+        }
+        case PdfDataType::String:
+        {
+            stats.Strings += sizeof(PdfString) + m_Variant.GetString().getMemoryUsage();
+            break;
+        }
+        case PdfDataType::Array:
+        {
+            auto& arr = m_Variant.GetArray();
+            stats.Arrays += sizeof(PdfArray) + arr.m_Objects.capacity() * sizeof(PdfObject);
+            stats.ParserCache += arr.getLazySourceMemoryUsage();
+            for (auto& child : arr.m_Objects)
+                child.collectDataMemoryUsage(stats);
+            break;
+        }
+        case PdfDataType::Dictionary:
+        {
+            auto& dict = m_Variant.GetDictionary();
+            stats.Dictionaries += sizeof(PdfDictionary) + dict.m_Map.getMemoryUsage();
+            for (auto& pair : dict.m_Map)
+            {
+                stats.Names += pair.first.getMemoryUsage();
+                pair.second.collectDataMemoryUsage(stats);
+            }
+            break;
+        }
+        case PdfDataType::RawData:
+        {
+            auto& data = static_cast<const PdfData&>(*m_Variant.m_Data.Data);
+            stats.Objects += sizeof(PdfData) + utls::GetHeapSize(data.GetBuffer());
+            break;
+        }
+        default:
+        {
+            // Stored in the variant
+            break;
+        }
+    }
+
+    if (m_Stream != nullptr)
+    {
+        auto memStream = dynamic_cast<const PdfMemoryObjectStream*>(m_Stream.get());
+        const PdfSpillObjectStream* spillStream;
+        if (memStream != nullptr)
+        {
+            stats.Streams += sizeof(PdfMemoryObjectStream) + sizeof(charbuff)
+                + memStream->GetLength();
+        }
+        else if ((spillStream = dynamic_cast<const PdfSpillObjectStream*>(m_Stream.get())) != nullptr)
+        {
+            // Only the data held in memory is counted
+            stats.Streams += sizeof(PdfSpillObjectStream) + spillStream->GetMemoryLength();
+        }
+        else
+        {
+            stats.Streams += sizeof(PdfFileObjectStream);
+        }
+    }
+}
+
+PdfMemoryStats::PdfMemoryStats() :
+    Objects(0),
+    Names(0),
+    Strings(0),
+    Arrays(0),
+    Dictionaries(0),
+    Streams(0),
+    Fonts(0),
+    ParserCache(0),
+    ObjectCount(0)
+{
+}
+
+size_t PdfMemoryStats::GetTotal() const
+{
+    return Objects + Names + Strings + Arrays + Dictionaries
+        + Streams + Fonts + ParserCache;
+}
+
 PdfDataType PdfObject::GetDataType() const
 {
     DelayedLoad();
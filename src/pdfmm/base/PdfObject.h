@@ -11,6 +11,7 @@
 
 #include "PdfVariant.h"
 #include "PdfObjectStream.h"
+#include "PdfMemoryResource.h"
 
 namespace mm {
 
@@ -22,6 +23,28 @@ class PdfArray;
 class PdfDocument;
 class PdfDataContainer;
 
+/** Estimated memory usage, in bytes, broken down by category
+ *
+ *  Data shared between copies, like interned names and
+ *  memory stream buffers, is counted for every holder
+ */
+struct PDFMM_API PdfMemoryStats final
+{
+    PdfMemoryStats();
+
+    size_t Objects;         ///< The objects themselves, including numbers, references and raw data
+    size_t Names;           ///< Names not interned, as values or dictionary keys
+    size_t Strings;         ///< String values
+    size_t Arrays;          ///< Array storage, excluding the element values
+    size_t Dictionaries;    ///< Dictionary storage, excluding the key and value data
+    size_t Streams;         ///< Stream objects and memory stream buffers
+    size_t Fonts;           ///< Font file data of the fonts imported in the document
+    size_t ParserCache;     ///< State kept to load objects and nested arrays on demand
+    unsigned ObjectCount;   ///< Number of indirect objects accounted
+
+    size_t GetTotal() const;
+};
+
 /**
  * This class represents a PDF indirect Object in memory
  *
@@ -40,10 +63,18 @@ class PDFMM_API PdfObject
     friend class PdfArray;
     friend class PdfDictionary;
     friend class PdfDocument;
+    friend class PdfDocumentSplitter;
     friend class PdfObjectStream;
     friend class PdfDataContainer;
     friend class PdfObjectStreamParser;
     friend class PdfParser;
+    friend class PdfSnapshotSerializer;
+    friend class PdfDocumentDiff;
+    friend class PdfDocumentHasher;
+    friend class PdfMetadataUpdater;
+    friend class PdfWriter;
+
+    PDFMM_DECLARE_MEMORY_RESOURCE_ALLOCATION
 
 public:
 
@@ -346,6 +377,25 @@ public:
 
     const PdfVariant& GetVariant() const;
 
+    /** Load now the object, its stream and the nested arrays
+     *  that are read on demand, so no further reading from the
+     *  input device happens when the object is accessed or written.
+     *  Referenced indirect objects are not loaded
+     */
+    void ForceLoad() const;
+
+    /** \returns the estimated memory used by this object, including
+     *      its contained objects and its stream
+     *  \remarks Objects not loaded yet are not loaded
+     */
+    size_t GetMemoryUsage() const;
+
+    /** Add the estimated memory used by this object, including its
+     *  contained objects and its stream, to the given stats
+     *  \remarks Objects not loaded yet are not loaded
+     */
+    void CollectMemoryUsage(PdfMemoryStats& stats) const;
+
 public:
     /** This operator is required for sorting a list of
      *  PdfObject instances. It compares the object number. If object numbers
@@ -420,6 +470,11 @@ public:
      */
     inline bool IsDelayedLoadDone() const { return m_IsDelayedLoadDone; }
 
+    /** Returns true if the stream, if any, is loaded or delayed
+     *  loading of the stream is disabled
+     */
+    inline bool IsDelayedLoadStreamDone() const { return m_IsDelayedLoadStreamDone; }
+
     const PdfObjectStream* GetStream() const;
     PdfObjectStream* GetStream();
 
@@ -454,6 +509,26 @@ protected:
 
     virtual void DelayedLoadStreamImpl();
 
+    /** Get the length of the stream data that can be copied as is
+     *  from the source with WriteRawStream(), when the stream is
+     *  not loaded yet. The default implementation returns false
+     *  \returns false if the stream must be loaded to be written
+     */
+    virtual bool TryGetRawStreamLength(size_t& length) const;
+
+    /** Copy the stream data as is from the source to the device,
+     *  without loading it. Called only if TryGetRawStreamLength()
+     *  succeeded and the stream is not loaded yet
+     */
+    virtual void WriteRawStream(OutputStreamDevice& device) const;
+
+    /** Get a view of the stream data as it is in the source, when
+     *  the stream is not loaded yet and the source is contiguous in
+     *  memory. The view can be read concurrently, but getting it
+     *  reads the source. The default implementation returns false
+     */
+    virtual bool TryGetRawStreamView(bufferview& view) const;
+
     /** Sets the dirty flag of this PdfVariant
      *
      *  \see IsDirty
@@ -524,6 +599,18 @@ private:
 
     void moveStreamFrom(PdfObject& obj);
 
+    /** Write the object as the given indirect reference, and with the
+     *  given variant in place of its own one if not nullptr. Used
+     *  by PdfWriter to write the objects renumbered
+     */
+    void write(OutputStreamDevice& device, PdfWriteFlags writeMode, const PdfReference& reference,
+        PdfVariant* variant, const PdfEncrypt* encrypt, charbuff& buffer) const;
+
+    /** Collect the memory used by the data of this
+     *  object, excluding the object itself
+     */
+    void collectDataMemoryUsage(PdfMemoryStats& stats) const;
+
     // Shared initialization between all the ctors
     void initObject();
 
@@ -538,6 +625,8 @@ private:
 
     mutable bool m_IsDelayedLoadDone;
     mutable bool m_IsDelayedLoadStreamDone;
+    mutable bool m_IsAccessed; // Used to approximate the least recently used objects
+    bool m_IsPinned; // Kept loaded with a memory budget, as other objects reference its data
     std::unique_ptr<PdfObjectStream> m_Stream;
     // Tracks whether deferred loading is still pending (in which case it'll be
     // false). If true, deferred loading is not required or has been completed.
@@ -0,0 +1,156 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfObjectInputStream.h"
+
+#include "PdfDictionary.h"
+#include "PdfFilter.h"
+#include "PdfObject.h"
+#include "PdfObjectStream.h"
+
+using namespace std;
+using namespace mm;
+
+// The size of the chunks of encoded data decoded at once. The
+// window holds the data decoded from a single chunk
+static constexpr size_t ChunkSize = 16384;
+
+class PdfObjectInputStream::WindowOutputStream final : public OutputStream
+{
+public:
+    WindowOutputStream(charbuff& window)
+        : m_window(&window) { }
+
+protected:
+    void writeBuffer(const char* buffer, size_t size) override
+    {
+        m_window->append(buffer, size);
+    }
+
+private:
+    charbuff* m_window;
+};
+
+PdfObjectInputStream::PdfObjectInputStream(const PdfObjectStream& stream)
+    : m_windowPosition(0), m_Position(0), m_inputEof(false)
+{
+    if (stream.getDecodedStreamCache() != nullptr)
+    {
+        // Keep caching the decoded data
+        stream.ExtractTo(m_window);
+        m_inputEof = true;
+        return;
+    }
+
+    m_input = stream.GetInputStream();
+    auto filters = PdfFilterFactory::CreateFilterList(*stream.m_Parent);
+    if (filters.size() != 0)
+    {
+        m_output.reset(new WindowOutputStream(m_window));
+        m_decodeStream = PdfFilterFactory::CreateDecodeStream(filters, *m_output,
+            stream.m_Parent->GetDictionary());
+    }
+
+    m_chunk.resize(ChunkSize);
+}
+
+PdfObjectInputStream::~PdfObjectInputStream() { }
+
+size_t PdfObjectInputStream::GetLength() const
+{
+    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NotImplemented, "The decoded length is not known while decoding");
+}
+
+bool PdfObjectInputStream::Eof() const
+{
+    return m_windowPosition == m_window.size() && m_inputEof;
+}
+
+size_t PdfObjectInputStream::readBuffer(char* buffer, size_t size, bool& eof)
+{
+    size_t count = 0;
+    while (count < size)
+    {
+        if (m_windowPosition == m_window.size() && !fillWindow())
+            break;
+
+        size_t read = std::min(size - count, m_window.size() - m_windowPosition);
+        std::memcpy(buffer + count, m_window.data() + m_windowPosition, read);
+        m_windowPosition += read;
+        count += read;
+    }
+
+    m_Position += count;
+    eof = Eof();
+    return count;
+}
+
+bool PdfObjectInputStream::readChar(char& ch)
+{
+    if (m_windowPosition == m_window.size() && !fillWindow())
+    {
+        ch = '\0';
+        return false;
+    }
+
+    ch = m_window[m_windowPosition];
+    m_windowPosition++;
+    m_Position++;
+    return true;
+}
+
+bool PdfObjectInputStream::peek(char& ch) const
+{
+    auto& mref = const_cast<PdfObjectInputStream&>(*this);
+    if (m_windowPosition == m_window.size() && !mref.fillWindow())
+    {
+        ch = '\0';
+        return false;
+    }
+
+    ch = m_window[m_windowPosition];
+    return true;
+}
+
+bool PdfObjectInputStream::tryPeek(bufferview& view) const
+{
+    auto& mref = const_cast<PdfObjectInputStream&>(*this);
+    if (m_windowPosition == m_window.size() && !mref.fillWindow())
+    {
+        view = { };
+        return false;
+    }
+
+    // The rest of the window is contiguous in memory
+    view = bufferview(m_window.data() + m_windowPosition, m_window.size() - m_windowPosition);
+    return true;
+}
+
+bool PdfObjectInputStream::fillWindow()
+{
+    m_window.clear();
+    m_windowPosition = 0;
+    while (m_window.size() == 0 && !m_inputEof)
+    {
+        if (m_decodeStream == nullptr)
+        {
+            m_window.resize(ChunkSize);
+            m_window.resize(m_input->Read(m_window.data(), ChunkSize, m_inputEof));
+            continue;
+        }
+
+        size_t read = m_input->Read(m_chunk.data(), ChunkSize, m_inputEof);
+        m_decodeStream->Write(m_chunk.data(), read);
+
+        // Flushing ends the filters, writing the data they still hold
+        if (m_inputEof)
+            m_decodeStream->Flush();
+    }
+
+    return m_window.size() != 0;
+}
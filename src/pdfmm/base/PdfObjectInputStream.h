@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_OBJECT_INPUT_STREAM_H
+#define PDF_OBJECT_INPUT_STREAM_H
+
+#include "PdfInputDevice.h"
+#include "PdfOutputStream.h"
+
+namespace mm {
+
+class PdfObjectStream;
+
+/**
+ * An input device reading the decoded data of a stream
+ *
+ * The data is read from the stream in chunks, which are decoded
+ * through the filters into a window the reads consume, so the decoded
+ * data is never held whole. When the document caches the decoded
+ * streams, the data is extracted whole and cached like ExtractTo() does
+ */
+class PDFMM_API PdfObjectInputStream final : public InputStreamDevice
+{
+    class WindowOutputStream;
+
+public:
+    PdfObjectInputStream(const PdfObjectStream& stream);
+
+    ~PdfObjectInputStream();
+
+public:
+    size_t GetLength() const override;
+    size_t GetPosition() const override { return m_Position; }
+    bool Eof() const override;
+
+protected:
+    size_t readBuffer(char* buffer, size_t size, bool& eof) override;
+    bool readChar(char& ch) override;
+    bool peek(char& ch) const override;
+    bool tryPeek(bufferview& view) const override;
+
+private:
+    /** Decode the next chunks of the stream, until some data is
+     *  available in the window or the stream ends
+     *  \returns false if the stream ended
+     */
+    bool fillWindow();
+
+private:
+    std::unique_ptr<InputStream> m_input;
+    std::unique_ptr<WindowOutputStream> m_output;
+    std::unique_ptr<OutputStream> m_decodeStream;
+    charbuff m_chunk;
+    charbuff m_window;
+    size_t m_windowPosition;
+    size_t m_Position;
+    bool m_inputEof;
+};
+
+}
+
+#endif // PDF_OBJECT_INPUT_STREAM_H
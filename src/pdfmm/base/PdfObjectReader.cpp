@@ -0,0 +1,246 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfObjectReader.h"
+
+#include <algorithm>
+
+#include "PdfDictionary.h"
+#include "PdfEncrypt.h"
+#include "PdfIndirectObjectList.h"
+#include "PdfObjectStreamParser.h"
+#include "PdfParser.h"
+#include "PdfParserObject.h"
+#include "PdfStreamDevice.h"
+
+using namespace std;
+using namespace mm;
+
+static bool isObjectStream(const PdfObject& obj);
+
+PdfObjectReader::PdfObjectReader() :
+    m_buffer(std::make_shared<charbuff>(PdfTokenizer::BufferSize))
+{
+    reset();
+}
+
+PdfObjectReader::~PdfObjectReader() { }
+
+bool PdfObjectReader::Read(const string_view& filename, const Callback& callback, PdfObjectReaderMode mode)
+{
+    if (filename.length() == 0)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    FileStreamDevice device(filename);
+    return ReadFromDevice(device, callback, mode);
+}
+
+bool PdfObjectReader::ReadFromBuffer(const bufferview& buffer, const Callback& callback, PdfObjectReaderMode mode)
+{
+    if (buffer.size() == 0)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    SpanStreamDevice device(buffer);
+    return ReadFromDevice(device, callback, mode);
+}
+
+bool PdfObjectReader::ReadFromDevice(InputStreamDevice& device, const Callback& callback, PdfObjectReaderMode mode)
+{
+    reset();
+
+    {
+        // Read only the xref sections and the trailers. The
+        // objects list stays empty, it's just required by the parser
+        PdfIndirectObjectList objects;
+        PdfParser parser(objects);
+        if (!parser.IsPdfFile(device))
+            PDFMM_RAISE_ERROR(PdfErrorCode::NoPdfFile);
+
+        switch (mode)
+        {
+            case PdfObjectReaderMode::XRef:
+                parser.ReadDocumentStructure(device);
+                break;
+            case PdfObjectReaderMode::Scan:
+                parser.rebuildXRef(device);
+                break;
+            default:
+                PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
+        }
+
+        m_PdfVersion = parser.GetPdfVersion();
+        auto encryptObj = parser.GetTrailer().GetDictionary().GetKey("Encrypt");
+        m_IsEncrypted = encryptObj != nullptr && !encryptObj->IsNull();
+        if (m_IsEncrypted)
+        {
+            if (encryptObj->IsReference())
+                m_encryptReference = encryptObj->GetReference();
+
+            parser.readEncrypt(device);
+            if (!parser.m_Encrypt->Authenticate(m_password, parser.GetDocumentId()))
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidPassword, "A password is required to read this PDF file");
+
+            m_encrypt = std::move(parser.m_Encrypt);
+        }
+
+        m_entries = std::move(parser.m_entries);
+    }
+
+    // The encryption dictionary is read as any other object, without decrypting it
+    if (m_encryptReference.IsIndirect() && m_encryptReference.ObjectNumber() < m_entries.GetSize())
+        m_entries[m_encryptReference.ObjectNumber()].Parsed = true;
+
+    // Read the objects in the order they are stored, and collect
+    // the compressed objects to read them after their stream
+    vector<pair<uint64_t, unsigned>> offsets;
+    for (unsigned i = 0; i < m_entries.GetSize(); i++)
+    {
+        auto& entry = m_entries[i];
+        if (!entry.Parsed)
+            continue;
+
+        if (entry.Type == XRefEntryType::InUse)
+            offsets.push_back({ entry.Offset, i });
+        else if (entry.Type == XRefEntryType::Compressed)
+            m_compressedObjects[(uint32_t)entry.ObjectNumber].push_back(i);
+    }
+
+    std::sort(offsets.begin(), offsets.end());
+    bool ret = true;
+    for (auto& offset : offsets)
+    {
+        if (!readObject(device, offset.second, callback))
+        {
+            ret = false;
+            break;
+        }
+    }
+
+    // Release the xref entries, they are not needed anymore
+    m_entries.Clear();
+    m_compressedObjects.clear();
+    m_encrypt = nullptr;
+    return ret;
+}
+
+bool PdfObjectReader::readObject(InputStreamDevice& device, unsigned objNum, const Callback& callback)
+{
+    auto& entry = m_entries[objNum];
+    PdfReference ref(objNum, (uint16_t)entry.Generation);
+
+    // The object is not bound to a document, so
+    // the references it contains are not resolved
+    unique_ptr<PdfParserObject> obj(new PdfParserObject(nullptr, ref, device, (ssize_t)entry.Offset));
+    PdfObjectReaderEntry read = { ref, obj.get(), 0, false, 0, -1 };
+    try
+    {
+        if (m_encrypt != nullptr && ref != m_encryptReference)
+            obj->SetEncrypt(m_encrypt.get());
+
+        // NOTE: Access the variant to read the object now
+        (void)obj->GetDataType();
+        if (obj->HasStreamToParse())
+        {
+            read.HasStream = true;
+            read.StreamOffset = obj->findStreamDataOffset();
+            read.StreamLength = resolveStreamLength(device, *obj);
+        }
+    }
+    catch (PdfError& e)
+    {
+        mm::LogMessage(PdfLogSeverity::Warning, "Skipping broken object {} at offset {} ({})",
+            ref.ToString(), entry.Offset, PdfError::ErrorName(e.GetError()));
+        return true;
+    }
+
+    if (!callback(read))
+        return false;
+
+    if (read.HasStream && isObjectStream(*obj))
+        return readObjectStream(*obj, callback);
+
+    return true;
+}
+
+bool PdfObjectReader::readObjectStream(PdfParserObject& stream, const Callback& callback)
+{
+    uint32_t streamNum = stream.GetIndirectReference().ObjectNumber();
+    auto found = m_compressedObjects.find(streamNum);
+    if (found == m_compressedObjects.end())
+        return true;
+
+    PdfObjectStreamParser::ObjectList objects;
+    try
+    {
+        // The list is required by the parser, the objects are returned
+        PdfIndirectObjectList list;
+        PdfObjectStreamParser parser(stream, list, m_buffer);
+        parser.Read(found->second, objects);
+    }
+    catch (PdfError& e)
+    {
+        mm::LogMessage(PdfLogSeverity::Warning, "Skipping broken object stream {} ({})",
+            stream.GetIndirectReference().ToString(), PdfError::ErrorName(e.GetError()));
+        return true;
+    }
+
+    for (auto& obj : objects)
+    {
+        PdfObjectReaderEntry read = { obj->GetIndirectReference(), obj.get(), streamNum, false, 0, -1 };
+        if (!callback(read))
+            return false;
+
+        obj.reset();
+    }
+
+    return true;
+}
+
+ssize_t PdfObjectReader::resolveStreamLength(InputStreamDevice& device, PdfParserObject& obj)
+{
+    auto& dict = obj.GetDictionary();
+    auto lengthObj = dict.GetKey(PdfName::KeyLength);
+    if (lengthObj == nullptr)
+        return -1;
+
+    int64_t length;
+    if (lengthObj->TryGetNumber(length))
+        return length < 0 ? -1 : (ssize_t)length;
+
+    PdfReference ref;
+    if (!lengthObj->TryGetReference(ref) || ref.ObjectNumber() >= m_entries.GetSize())
+        return -1;
+
+    auto& entry = m_entries[ref.ObjectNumber()];
+    if (!entry.Parsed || entry.Type != XRefEntryType::InUse)
+        return -1;
+
+    PdfParserObject lengthParsed(nullptr, ref, device, (ssize_t)entry.Offset);
+    if (!lengthParsed.TryGetNumber(length) || length < 0)
+        return -1;
+
+    // Replace the indirect length, so the callback can read the stream
+    dict.AddKey(PdfName::KeyLength, length);
+    return (ssize_t)length;
+}
+
+void PdfObjectReader::reset()
+{
+    m_entries.Clear();
+    m_compressedObjects.clear();
+    m_encrypt = nullptr;
+    m_encryptReference = PdfReference();
+    m_PdfVersion = PdfVersion::Unknown;
+    m_IsEncrypted = false;
+}
+
+bool isObjectStream(const PdfObject& obj)
+{
+    auto type = obj.GetDictionary().GetKey(PdfName::KeyType);
+    return type != nullptr && type->IsName() && type->GetName() == "ObjStm";
+}
@@ -0,0 +1,130 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_OBJECT_READER_H
+#define PDF_OBJECT_READER_H
+
+#include "PdfDeclarations.h"
+#include "PdfReference.h"
+#include "PdfXRefEntry.h"
+
+#include <functional>
+#include <unordered_map>
+
+namespace mm {
+
+class InputStreamDevice;
+class PdfEncrypt;
+class PdfObject;
+class PdfParserObject;
+
+enum class PdfObjectReaderMode
+{
+    XRef,       ///< Read the objects listed by the xref sections of the file
+    Scan,       ///< Read the objects found by a linear scan of the file, for files with a broken xref
+};
+
+/** An object read by PdfObjectReader
+ */
+struct PDFMM_API PdfObjectReaderEntry
+{
+    PdfReference Reference;
+    const PdfObject* Object;        ///< The object. The references it contains are not resolved
+    uint32_t ObjectStreamNumber;    ///< The number of the object stream holding the object, or 0
+    bool HasStream;
+    size_t StreamOffset;            ///< The offset of the stream data in the device
+    ssize_t StreamLength;           ///< The stored length of the stream data, or -1 if it's unknown
+};
+
+/**
+ * Read the objects of a PDF file one at a time, without loading the document
+ *
+ * The objects are passed to a callback and released as soon as it
+ * returns, so only the xref entries are kept in memory. The objects
+ * are read in the order they are stored in the file, and the objects
+ * of an object stream follow the stream. The stream data is read
+ * only if the callback accesses it, or to decode the object streams.
+ * The strings of encrypted files are decrypted. Broken objects are
+ * skipped with a warning
+ */
+class PDFMM_API PdfObjectReader final
+{
+public:
+    /** The callback receiving the objects
+     *  \returns false to stop reading
+     */
+    using Callback = std::function<bool(const PdfObjectReaderEntry& entry)>;
+
+public:
+    PdfObjectReader();
+
+    ~PdfObjectReader();
+
+    /** Read the objects of a PDF file
+     *
+     *  \param filename filename of the file to read
+     *  \returns false if the callback stopped the reading
+     */
+    bool Read(const std::string_view& filename, const Callback& callback,
+        PdfObjectReaderMode mode = PdfObjectReaderMode::XRef);
+
+    /** Read the objects of a PDF file in memory
+     *
+     *  \param buffer the buffer containing the PDF file
+     *  \returns false if the callback stopped the reading
+     */
+    bool ReadFromBuffer(const bufferview& buffer, const Callback& callback,
+        PdfObjectReaderMode mode = PdfObjectReaderMode::XRef);
+
+    /** Read the objects of a PDF file from an input device
+     *
+     *  \param device the input device to read from
+     *  \returns false if the callback stopped the reading
+     */
+    bool ReadFromDevice(InputStreamDevice& device, const Callback& callback,
+        PdfObjectReaderMode mode = PdfObjectReaderMode::XRef);
+
+public:
+    /** Set the password used to decrypt encrypted files
+     */
+    inline void SetPassword(const std::string_view& password) { m_password = password; }
+
+    /** \returns the version of the last file read, as stated by the header
+     */
+    inline PdfVersion GetPdfVersion() const { return m_PdfVersion; }
+
+    /** \returns true if the last file read is encrypted
+     */
+    inline bool IsEncrypted() const { return m_IsEncrypted; }
+
+private:
+    bool readObject(InputStreamDevice& device, unsigned objNum, const Callback& callback);
+
+    bool readObjectStream(PdfParserObject& stream, const Callback& callback);
+
+    /** Resolve the /Length of a stream. Indirect lengths are
+     *  read from the file, if they are not compressed, and they
+     *  replace the reference so the stream can be read
+     */
+    ssize_t resolveStreamLength(InputStreamDevice& device, PdfParserObject& obj);
+
+    void reset();
+
+private:
+    PdfXRefEntries m_entries;
+    std::unordered_map<uint32_t, std::vector<int64_t>> m_compressedObjects;
+    std::unique_ptr<PdfEncrypt> m_encrypt;
+    PdfReference m_encryptReference;
+    std::shared_ptr<charbuff> m_buffer;
+    std::string m_password;
+    PdfVersion m_PdfVersion;
+    bool m_IsEncrypted;
+};
+
+};
+
+#endif // PDF_OBJECT_READER_H
@@ -9,6 +9,9 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfObjectStream.h"
 
+#include <pdfmm/private/PdfPoolPrivate.h>
+#include <pdfmm/private/PdfTracePrivate.h>
+
 #include "PdfDocument.h"
 #include "PdfArray.h"
 #include "PdfFilter.h"
@@ -19,24 +22,155 @@
 using namespace std;
 using namespace mm;
 
+namespace
+{
+    // Writes the decoded data up to the maximum size, raising when
+    // it's exceeded, so the filters and the reading of the stream
+    // stop at the first block past the limit
+    class LimitedOutputStream final : public OutputStream
+    {
+    public:
+        LimitedOutputStream(OutputStream& stream, size_t maxSize, bool truncate)
+            : m_stream(&stream), m_remaining(maxSize), m_truncate(truncate), m_truncated(false) { }
+
+        bool IsTruncated() const { return m_truncated; }
+
+    protected:
+        void writeBuffer(const char* buffer, size_t size) override
+        {
+            if (size <= m_remaining)
+            {
+                m_stream->Write(buffer, size);
+                m_remaining -= size;
+                return;
+            }
+
+            if (!m_truncate)
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The decoded stream exceeds the maximum size");
+
+            m_stream->Write(buffer, m_remaining);
+            m_remaining = 0;
+            m_truncated = true;
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The decoded stream was truncated");
+        }
+
+        void flush() override
+        {
+            m_stream->Flush();
+        }
+
+    private:
+        OutputStream* m_stream;
+        size_t m_remaining;
+        bool m_truncate;
+        bool m_truncated;
+    };
+
+#ifdef PDFMM_HAVE_TRACING
+    // Counts the decoded bytes written to the stream
+    class CountingOutputStream final : public OutputStream
+    {
+    public:
+        CountingOutputStream(OutputStream& stream)
+            : m_stream(&stream), m_count(0) { }
+
+        size_t GetCount() const { return m_count; }
+
+    protected:
+        void writeBuffer(const char* buffer, size_t size) override
+        {
+            m_stream->Write(buffer, size);
+            m_count += size;
+        }
+
+        void flush() override
+        {
+            m_stream->Flush();
+        }
+
+    private:
+        OutputStream* m_stream;
+        size_t m_count;
+    };
+#endif // PDFMM_HAVE_TRACING
+}
+
 enum PdfFilterType PdfObjectStream::DefaultFilter = PdfFilterType::FlateDecode;
 
 PdfObjectStream::PdfObjectStream(PdfObject& parent)
-    : m_Parent(&parent), m_Append(false)
+    : m_Parent(&parent), m_Append(false), m_CompressionLevel(PdfCompressionLevel::Default)
 {
 }
 
 PdfObjectStream::~PdfObjectStream() { }
 
 void PdfObjectStream::ExtractTo(charbuff& buffer) const
+{
+    auto cache = getDecodedStreamCache();
+    if (cache == nullptr)
+    {
+        extractTo(buffer);
+        return;
+    }
+
+    auto cached = cache->findDecodedStream(*m_Parent);
+    if (cached != nullptr)
+    {
+        buffer = *cached;
+        return;
+    }
+
+    extractTo(buffer);
+    cache->cacheDecodedStream(*m_Parent, buffer);
+}
+
+void PdfObjectStream::extractTo(charbuff& buffer) const
 {
     buffer.clear();
+    PdfFilterList filters = PdfFilterFactory::CreateFilterList(*m_Parent);
+    if (filters.size() == 1)
+    {
+        // Decode the whole data at once, so the filter
+        // can use its one-shot path, if it has one
+        auto filter = PdfFilterFactory::Create(filters.front());
+        if (filter == nullptr)
+            PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedFilter);
+
+        const PdfDictionary* decodeParms = nullptr;
+        auto decodeParmsObj = m_Parent->GetDictionary().FindKey("DecodeParms");
+        if (decodeParmsObj != nullptr && decodeParmsObj->IsDictionary())
+            decodeParms = &decodeParmsObj->GetDictionary();
+
+        PDFMM_TRACE_SCOPE(trace, StreamDecode, m_Parent->GetDocument());
+        PdfScratchBuffer encoded;
+        BufferStreamDevice stream(*encoded);
+        GetInputStream()->CopyTo(stream);
+        filter->DecodeTo(buffer, *encoded, decodeParms);
+        PDFMM_TRACE_SET(trace, Reference, m_Parent->GetIndirectReference());
+        PDFMM_TRACE_SET(trace, Filter, filters.front());
+        PDFMM_TRACE_SET(trace, InputLength, encoded->size());
+        PDFMM_TRACE_SET(trace, OutputLength, buffer.size());
+        return;
+    }
+
     BufferStreamDevice stream(buffer);
     ExtractTo(stream);
 }
 
 void PdfObjectStream::ExtractTo(OutputStream& stream) const
 {
+    auto cache = getDecodedStreamCache();
+    if (cache != nullptr)
+    {
+        auto cached = cache->findDecodedStream(*m_Parent);
+        if (cached != nullptr)
+        {
+            stream.Write(cached->data(), cached->size());
+            stream.Flush();
+            return;
+        }
+    }
+
     PdfFilterList filters = PdfFilterFactory::CreateFilterList(*m_Parent);
     auto inputStream = GetInputStream();
     if (filters.size() == 0)
@@ -45,6 +179,26 @@ void PdfObjectStream::ExtractTo(OutputStream& stream) const
     }
     else
     {
+        PDFMM_TRACE_SCOPE(trace, StreamDecode, m_Parent->GetDocument());
+#ifdef PDFMM_HAVE_TRACING
+        if (trace.IsEnabled())
+        {
+            CountingOutputStream counting(stream);
+            auto decodeStream = PdfFilterFactory::CreateDecodeStream(filters, counting,
+                m_Parent->GetDictionary());
+
+            inputStream->CopyTo(*decodeStream);
+            decodeStream.reset();
+            auto& ev = trace.GetEvent();
+            ev.Reference = m_Parent->GetIndirectReference();
+            ev.Filter = filters.front();
+            ev.InputLength = GetLength();
+            ev.OutputLength = counting.GetCount();
+            stream.Flush();
+            return;
+        }
+#endif // PDFMM_HAVE_TRACING
+
         auto decodeStream = PdfFilterFactory::CreateDecodeStream(filters, stream,
             m_Parent->GetDictionary());
 
@@ -54,11 +208,41 @@ void PdfObjectStream::ExtractTo(OutputStream& stream) const
     stream.Flush();
 }
 
+void PdfObjectStream::ExtractTo(charbuff& buffer, const PdfStreamDecodeOptions& options) const
+{
+    buffer.clear();
+    BufferStreamDevice stream(buffer);
+    ExtractTo(stream, options);
+}
+
+void PdfObjectStream::ExtractTo(OutputStream& stream, const PdfStreamDecodeOptions& options) const
+{
+    if (options.MaxSize == 0)
+    {
+        ExtractTo(stream);
+        return;
+    }
+
+    LimitedOutputStream limited(stream, options.MaxSize, options.Truncate);
+    try
+    {
+        ExtractTo(limited);
+    }
+    catch (PdfError&)
+    {
+        // The truncation aborts the filters, so
+        // the data decoded so far is complete
+        if (!limited.IsTruncated())
+            throw;
+
+        stream.Flush();
+    }
+}
+
 charbuff PdfObjectStream::GetFilteredCopy() const
 {
     charbuff ret;
-    StringStreamDevice stream(ret);
-    ExtractTo(stream);
+    ExtractTo(ret);
     return ret;
 }
 
@@ -81,6 +265,18 @@ void PdfObjectStream::CopyFrom(const PdfObjectStream& rhs)
     this->SetRawData(*stream);
 }
 
+PdfCompressionLevel PdfObjectStream::GetEffectiveCompressionLevel() const
+{
+    if (m_CompressionLevel != PdfCompressionLevel::Default)
+        return m_CompressionLevel;
+
+    auto document = m_Parent->GetDocument();
+    if (document == nullptr)
+        return PdfCompressionLevel::Default;
+
+    return document->GetCompressionLevel();
+}
+
 void PdfObjectStream::EnsureAppendClosed()
 {
     PDFMM_RAISE_LOGIC_IF(m_Append, "EndAppend() should be called after appending to stream");
@@ -96,6 +292,24 @@ void PdfObjectStream::Set(const char* buffer, size_t size, const PdfFilterList&
     if (size == 0)
         return;
 
+    if (filters.size() == 1)
+    {
+        // Encode the whole data at once, so the filter
+        // can use its one-shot path, if it has one
+        auto filter = PdfFilterFactory::Create(filters.front(), GetEffectiveCompressionLevel());
+        if (filter != nullptr && filter->CanEncode())
+        {
+            charbuff encoded;
+            filter->EncodeTo(encoded, { buffer, size });
+            m_Parent->GetDictionary().AddKey(PdfName::KeyFilter,
+                PdfName(PdfFilterFactory::FilterTypeToName(filters.front())));
+            this->BeginAppend({ }, true, false, true);
+            AppendImpl(encoded.data(), encoded.size());
+            this->endAppend();
+            return;
+        }
+    }
+
     this->BeginAppend(filters);
     AppendImpl(buffer, size);
     this->endAppend();
@@ -108,12 +322,11 @@ void PdfObjectStream::Set(const bufferview& buffer)
 
 void PdfObjectStream::Set(const char* buffer, size_t size)
 {
-    if (size == 0)
-        return;
+    PdfFilterList filters;
+    if (DefaultFilter != PdfFilterType::None)
+        filters.push_back(DefaultFilter);
 
-    this->BeginAppend();
-    AppendImpl(buffer, size);
-    this->endAppend();
+    Set(buffer, size, filters);
 }
 
 void PdfObjectStream::Set(InputStream& stream)
@@ -208,11 +421,14 @@ void PdfObjectStream::BeginAppend(const PdfFilterList& filters, bool clearExisti
 
     auto document = m_Parent->GetDocument();
     if (document != nullptr)
+    {
+        invalidateDecodedStream();
         document->GetObjects().BeginAppendStream(*this);
+    }
 
-    charbuff buffer;
+    PdfScratchBuffer buffer;
     if (!clearExisting && this->GetLength() != 0)
-        this->ExtractTo(buffer);
+        this->ExtractTo(*buffer);
 
     if (filters.size() == 0)
     {
@@ -235,8 +451,8 @@ void PdfObjectStream::BeginAppend(const PdfFilterList& filters, bool clearExisti
 
     this->BeginAppendImpl(filters);
     m_Append = true;
-    if (buffer.size() != 0)
-        AppendImpl(buffer.data(), buffer.size());
+    if (buffer->size() != 0)
+        AppendImpl(buffer->data(), buffer->size());
 }
 
 void PdfObjectStream::EndAppend()
@@ -252,7 +468,31 @@ void PdfObjectStream::endAppend()
 
     PdfDocument* document;
     if ((document = m_Parent->GetDocument()) != nullptr)
+    {
+        // NOTE: The existing data may have been
+        // cached again while beginning the append
+        invalidateDecodedStream();
         document->GetObjects().EndAppendStream(*this);
+    }
+}
+
+PdfIndirectObjectList* PdfObjectStream::getDecodedStreamCache() const
+{
+    // The data being appended is not complete yet
+    auto document = m_Parent->GetDocument();
+    if (m_Append || document == nullptr || !m_Parent->IsIndirect()
+        || document->GetObjects().GetDecodedStreamCacheSize() == 0)
+    {
+        return nullptr;
+    }
+
+    return &document->GetObjects();
+}
+
+void PdfObjectStream::invalidateDecodedStream()
+{
+    if (m_Parent->IsIndirect())
+        m_Parent->GetDocument()->GetObjects().invalidateDecodedStream(m_Parent->GetIndirectReference());
 }
 
 PdfObjectStream& PdfObjectStream::Append(const string_view& view)
@@ -13,14 +13,29 @@
 
 #include "PdfFilter.h"
 #include "PdfEncrypt.h"
+#include "PdfMemoryResource.h"
 
 namespace mm {
 
 class InputStream;
 class PdfName;
 class PdfObject;
+class PdfIndirectObjectList;
 class OutputStream;
 
+/** Limits to the decoding of a stream, against the streams
+ *  that expand to much more data than expected
+ */
+struct PDFMM_API PdfStreamDecodeOptions
+{
+    ///< The maximum size of the decoded data, unlimited when zero
+    size_t MaxSize = 0;
+
+    ///< Stop decoding at MaxSize and keep the first bytes, e.g. to
+    ///< read the headers of the data, instead of raising an error
+    bool Truncate = false;
+};
+
 /** A PDF stream can be appended to any PdfObject
  *  and can contain arbitrary data.
  *
@@ -38,6 +53,8 @@ class PDFMM_API PdfObjectStream
     friend class PdfParserObject;
     friend class PdfObjectInputStream;
 
+    PDFMM_DECLARE_MEMORY_RESOURCE_ALLOCATION
+
 public:
     /** The default filter to use when changing the stream content.
      *  It's a static member and applies to all newly created/changed streams.
@@ -211,19 +228,54 @@ public:
      *  The caller has to the buffer.
      *
      *  \param buffer pointer to the buffer
+     *  \remarks When the document has a decoded stream cache, the
+     *      data is served from and stored in the cache
+     *  \see PdfIndirectObjectList::SetDecodedStreamCacheSize
      */
     void ExtractTo(charbuff& buffer) const;
 
     /** Get a filtered copy of a the stream and write it to an OutputStream
      *
      *  \param stream filtered data is written to this stream.
+     *  \remarks The data is served from the decoded stream cache
+     *      of the document, if present, but it's not stored there
      */
     void ExtractTo(OutputStream& stream) const;
 
+    /** Get the stream filtered by all the filters, limiting the size
+     *  of the decoded data. The decoding stops reading the stream as
+     *  soon as the limit is reached
+     *
+     *  \param buffer receives the decoded data
+     *  \param options the maximum size of the decoded data and
+     *      whether to keep only the first bytes when it is exceeded
+     *  \throws PdfError with PdfErrorCode::ValueOutOfRange if the
+     *      decoded data exceed the maximum size and it's not truncated
+     */
+    void ExtractTo(charbuff& buffer, const PdfStreamDecodeOptions& options) const;
+
+    /** Get the stream filtered by all the filters, limiting the size
+     *  of the decoded data
+     *
+     *  \param stream filtered data is written to this stream
+     *  \see ExtractTo(charbuff&, const PdfStreamDecodeOptions&)
+     */
+    void ExtractTo(OutputStream& stream, const PdfStreamDecodeOptions& options) const;
+
     charbuff GetFilteredCopy() const;
 
     void MoveTo(PdfObject& obj);
 
+    /** Set the level used by the Flate filter when changing the stream content
+     *
+     *  \param level the compression level. PdfCompressionLevel::Default
+     *      uses the compression level of the document
+     *  \see PdfDocument::SetCompressionLevel
+     */
+    void SetCompressionLevel(PdfCompressionLevel level) { m_CompressionLevel = level; }
+
+    inline PdfCompressionLevel GetCompressionLevel() const { return m_CompressionLevel; }
+
     /** Create a copy of a PdfObjectStream object
      *  \param rhs the object to clone
      *  \returns a reference to this object
@@ -263,6 +315,11 @@ protected:
 
     PdfObject& GetParent() { return *m_Parent; }
 
+    /** \returns the compression level of the stream or, if
+     *  it's not set, the compression level of the document
+     */
+    PdfCompressionLevel GetEffectiveCompressionLevel() const;
+
     virtual std::unique_ptr<InputStream> GetInputStream() const = 0;
 
 private:
@@ -270,6 +327,15 @@ private:
 
     void endAppend();
 
+    void extractTo(charbuff& buffer) const;
+
+    /** \returns the list of the document caching the decoded
+     *      data of the stream, or nullptr if it's not cached
+     */
+    PdfIndirectObjectList* getDecodedStreamCache() const;
+
+    void invalidateDecodedStream();
+
     void SetRawData(InputStream& stream, ssize_t len, bool markObjectDirty);
 
     void BeginAppend(const PdfFilterList& filters, bool clearExisting, bool deleteFilters, bool markObjectDirty);
@@ -277,6 +343,7 @@ private:
 private:
     PdfObject* m_Parent;
     bool m_Append;
+    PdfCompressionLevel m_CompressionLevel;
 };
 
 };
@@ -30,6 +30,14 @@ PdfObjectStreamParser::PdfObjectStreamParser(PdfParserObject& parser,
 }
 
 void PdfObjectStreamParser::Parse(ObjectIdList const& list)
+{
+    ObjectList objects;
+    Read(list, objects);
+    for (auto& obj : objects)
+        m_Objects->PushObject(obj.release());
+}
+
+void PdfObjectStreamParser::Read(ObjectIdList const& list, ObjectList& objects)
 {
     int64_t num = m_Parser->GetDictionary().FindKeyAs<int64_t>("N", 0);
     int64_t first = m_Parser->GetDictionary().FindKeyAs<int64_t>("First", 0);
@@ -37,11 +45,11 @@ void PdfObjectStreamParser::Parse(ObjectIdList const& list)
     charbuff buffer;
     m_Parser->GetOrCreateStream().ExtractTo(buffer);
 
-    this->ReadObjectsFromStream(buffer.data(), buffer.size(), num, first, list);
+    this->ReadObjectsFromStream(buffer.data(), buffer.size(), num, first, list, objects);
     m_Parser = nullptr;
 }
 
-void PdfObjectStreamParser::ReadObjectsFromStream(char* buffer, size_t bufferLen, int64_t num, int64_t first, ObjectIdList const& list)
+void PdfObjectStreamParser::ReadObjectsFromStream(char* buffer, size_t bufferLen, int64_t num, int64_t first, ObjectIdList const& list, ObjectList& objects)
 {
     SpanStreamDevice device(buffer, bufferLen);
     PdfTokenizer tokenizer(m_buffer);
@@ -78,9 +86,9 @@ void PdfObjectStreamParser::ReadObjectsFromStream(char* buffer, size_t bufferLen
             // The generation number of an object stream and of any
             // compressed object is implicitly zero
             PdfReference reference(static_cast<uint32_t>(objNo), 0);
-            auto obj = new PdfObject(std::move(var));
+            unique_ptr<PdfObject> obj(new PdfObject(std::move(var)));
             obj->SetIndirectReference(reference);
-            m_Objects->PushObject(obj);
+            objects.push_back(std::move(obj));
         }
 
         // move back to the position inside of the table of contents
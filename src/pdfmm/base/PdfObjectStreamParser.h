@@ -28,6 +28,8 @@ class PdfObjectStreamParser
 {
 public:
     using ObjectIdList = std::vector<int64_t>;
+    using ObjectList = std::vector<std::unique_ptr<PdfObject>>;
+
     /**
      * Create a new PdfObjectStreamParserObject from an existing
      * PdfParserObject. The PdfParserObject will be removed and deleted.
@@ -41,8 +43,20 @@ public:
 
     void Parse(ObjectIdList const&);
 
+    /** Decode the stream and read the objects in the supplied list,
+     *  without adding them to the objects vector
+     *
+     *  It doesn't modify the objects vector, so streams can be read
+     *  concurrently once their data and all the objects they may
+     *  reference are loaded, provided each parser has its own buffer
+     *
+     *  \param list ids of the objects to read
+     *  \param objects the read objects are appended here
+     */
+    void Read(ObjectIdList const& list, ObjectList& objects);
+
 private:
-    void ReadObjectsFromStream(char* buffer, size_t lBufferLen, int64_t lNum, int64_t lFirst, ObjectIdList const&);
+    void ReadObjectsFromStream(char* buffer, size_t lBufferLen, int64_t lNum, int64_t lFirst, ObjectIdList const&, ObjectList& objects);
 
 private:
     PdfParserObject* m_Parser;
@@ -0,0 +1,180 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_OBJECT_WALKER_H
+#define PDF_OBJECT_WALKER_H
+
+#include "PdfArray.h"
+#include "PdfDictionary.h"
+#include "PdfIndirectObjectList.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace mm {
+
+enum class PdfWalkAction
+{
+    Continue,       ///< Walk the children of the value, or the object a reference points to
+    SkipChildren,   ///< Don't walk the children of the value, nor the object a reference points to
+    Stop,           ///< Stop the walk
+};
+
+/** Walk a graph of objects without recursion
+ *
+ * The values are visited depth first, in the order they are stored,
+ * with an explicit stack, so deeply nested or long chains of objects
+ * don't exhaust the call stack. The references are followed, if
+ * an object list is given, and the indirect objects are visited once,
+ * marked in a bitmap indexed by object number. The visitor receives
+ * a reference first, then the object it points to, with the same key
+ */
+template <typename TObject>
+class PdfObjectWalkerBase final
+{
+public:
+    /** The visitor of the values
+     *  \param key the key of the value in the dictionary containing it, or nullptr
+     */
+    using Visitor = std::function<PdfWalkAction(TObject& obj, const PdfName* key)>;
+
+public:
+    /**
+     * \param objects the objects where to resolve the references,
+     *      or nullptr to not follow them
+     */
+    PdfObjectWalkerBase(const PdfIndirectObjectList* objects = nullptr);
+
+public:
+    /** Walk the graph from a root. The objects visited by the
+     *  previous walks are not visited again, until Reset()
+     *  \returns false if the visitor stopped the walk
+     */
+    bool Walk(TObject& root, const Visitor& visitor);
+
+    /** Forget the objects visited
+     */
+    void Reset();
+
+    bool IsVisited(uint32_t objectNumber) const;
+
+private:
+    bool tryMarkVisited(uint32_t objectNumber);
+
+private:
+    struct WalkItem
+    {
+        TObject* Object;
+        const PdfName* Key;
+    };
+
+private:
+    const PdfIndirectObjectList* m_objects;
+    std::vector<bool> m_visited;
+    std::vector<WalkItem> m_stack;
+};
+
+using PdfObjectWalker = PdfObjectWalkerBase<const PdfObject>;
+using PdfMutableObjectWalker = PdfObjectWalkerBase<PdfObject>;
+
+template <typename TObject>
+PdfObjectWalkerBase<TObject>::PdfObjectWalkerBase(const PdfIndirectObjectList* objects)
+    : m_objects(objects) { }
+
+template <typename TObject>
+bool PdfObjectWalkerBase<TObject>::Walk(TObject& root, const Visitor& visitor)
+{
+    if (root.IsIndirect())
+        (void)tryMarkVisited(root.GetIndirectReference().ObjectNumber());
+
+    m_stack.clear();
+    m_stack.push_back({ &root, nullptr });
+    while (m_stack.size() != 0)
+    {
+        auto item = m_stack.back();
+        m_stack.pop_back();
+        auto action = visitor(*item.Object, item.Key);
+        if (action == PdfWalkAction::SkipChildren)
+            continue;
+
+        if (action == PdfWalkAction::Stop)
+        {
+            m_stack.clear();
+            return false;
+        }
+
+        auto& obj = *item.Object;
+        switch (obj.GetDataType())
+        {
+            case PdfDataType::Reference:
+            {
+                if (m_objects == nullptr)
+                    break;
+
+                auto ref = obj.GetReference();
+                auto resolved = m_objects->GetObject(ref);
+                if (resolved != nullptr && tryMarkVisited(ref.ObjectNumber()))
+                    m_stack.push_back({ resolved, item.Key });
+
+                break;
+            }
+            case PdfDataType::Array:
+            {
+                auto& arr = obj.GetArray();
+                for (unsigned i = arr.GetSize(); i > 0; i--)
+                    m_stack.push_back({ &arr[i - 1], nullptr });
+
+                break;
+            }
+            case PdfDataType::Dictionary:
+            {
+                // Push the values reversed, so they are visited in order
+                size_t start = m_stack.size();
+                for (auto& pair : obj.GetDictionary())
+                    m_stack.push_back({ &pair.second, &pair.first });
+
+                std::reverse(m_stack.begin() + start, m_stack.end());
+                break;
+            }
+            default:
+            {
+                // Nothing to do
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+template <typename TObject>
+void PdfObjectWalkerBase<TObject>::Reset()
+{
+    m_visited.clear();
+}
+
+template <typename TObject>
+bool PdfObjectWalkerBase<TObject>::IsVisited(uint32_t objectNumber) const
+{
+    return objectNumber < m_visited.size() && m_visited[objectNumber];
+}
+
+template <typename TObject>
+bool PdfObjectWalkerBase<TObject>::tryMarkVisited(uint32_t objectNumber)
+{
+    if (objectNumber >= m_visited.size())
+        m_visited.resize(std::max((size_t)objectNumber + 1, m_visited.size() * 2));
+    else if (m_visited[objectNumber])
+        return false;
+
+    m_visited[objectNumber] = true;
+    return true;
+}
+
+};
+
+#endif // PDF_OBJECT_WALKER_H
@@ -4,387 +4,173 @@
 using namespace std;
 using namespace mm;
 
-PdfOperator mm::GetPdfOperator(const string_view& opstr)
+namespace
 {
-    PdfOperator op;
-    if (!TryGetPdfOperator(opstr, op))
-        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidName, "Invalid operator");
+    struct OperatorInfo
+    {
+        PdfOperator Operator;
+        string_view Name;
+        int OperandCount;     // -1 means variadic number of operands
+    };
 
-    return op;
-}
+    // The operators, indexed by their PdfOperator value
+    constexpr OperatorInfo s_operators[] = {
+        { PdfOperator::Unknown, { }, 0 },
+        { PdfOperator::w, "w"sv, 1 },
+        { PdfOperator::J, "J"sv, 1 },
+        { PdfOperator::j, "j"sv, 1 },
+        { PdfOperator::M, "M"sv, 1 },
+        { PdfOperator::d, "d"sv, 2 },
+        { PdfOperator::ri, "ri"sv, 1 },
+        { PdfOperator::i, "i"sv, 1 },
+        { PdfOperator::gs, "gs"sv, 1 },
+        { PdfOperator::q, "q"sv, 0 },
+        { PdfOperator::Q, "Q"sv, 0 },
+        { PdfOperator::cm, "cm"sv, 6 },
+        { PdfOperator::m, "m"sv, 2 },
+        { PdfOperator::l, "l"sv, 2 },
+        { PdfOperator::c, "c"sv, 6 },
+        { PdfOperator::v, "v"sv, 4 },
+        { PdfOperator::y, "y"sv, 4 },
+        { PdfOperator::h, "h"sv, 0 },
+        { PdfOperator::re, "re"sv, 4 },
+        { PdfOperator::S, "S"sv, 0 },
+        { PdfOperator::s, "s"sv, 0 },
+        { PdfOperator::f, "f"sv, 0 },
+        { PdfOperator::F, "F"sv, 0 },
+        { PdfOperator::f_Star, "f*"sv, 0 },
+        { PdfOperator::B, "B"sv, 0 },
+        { PdfOperator::B_Star, "B*"sv, 0 },
+        { PdfOperator::b, "b"sv, 0 },
+        { PdfOperator::b_Star, "b*"sv, 0 },
+        { PdfOperator::n, "n"sv, 0 },
+        { PdfOperator::W, "W"sv, 0 },
+        { PdfOperator::W_Star, "W*"sv, 0 },
+        { PdfOperator::BT, "BT"sv, 0 },
+        { PdfOperator::ET, "ET"sv, 0 },
+        { PdfOperator::Tc, "Tc"sv, 1 },
+        { PdfOperator::Tw, "Tw"sv, 1 },
+        { PdfOperator::Tz, "Tz"sv, 1 },
+        { PdfOperator::TL, "TL"sv, 1 },
+        { PdfOperator::Tf, "Tf"sv, 2 },
+        { PdfOperator::Tr, "Tr"sv, 1 },
+        { PdfOperator::Ts, "Ts"sv, 1 },
+        { PdfOperator::Td, "Td"sv, 2 },
+        { PdfOperator::TD, "TD"sv, 2 },
+        { PdfOperator::Tm, "Tm"sv, 6 },
+        { PdfOperator::T_Star, "T*"sv, 0 },
+        { PdfOperator::Tj, "Tj"sv, 1 },
+        { PdfOperator::TJ, "TJ"sv, 1 },
+        { PdfOperator::Quote, "'"sv, 1 },
+        { PdfOperator::DoubleQuote, "\""sv, 3 },
+        { PdfOperator::d0, "d0"sv, 2 },
+        { PdfOperator::d1, "d1"sv, 6 },
+        { PdfOperator::CS, "CS"sv, 1 },
+        { PdfOperator::cs, "cs"sv, 1 },
+        { PdfOperator::SC, "SC"sv, -1 },
+        { PdfOperator::SCN, "SCN"sv, -1 },
+        { PdfOperator::sc, "sc"sv, -1 },
+        { PdfOperator::scn, "scn"sv, -1 },
+        { PdfOperator::G, "G"sv, 1 },
+        { PdfOperator::g, "g"sv, 1 },
+        { PdfOperator::RG, "RG"sv, 3 },
+        { PdfOperator::rg, "rg"sv, 3 },
+        { PdfOperator::K, "K"sv, 4 },
+        { PdfOperator::k, "k"sv, 4 },
+        { PdfOperator::sh, "sh"sv, 1 },
+        { PdfOperator::BI, "BI"sv, 0 },
+        { PdfOperator::ID, "ID"sv, 0 },
+        { PdfOperator::EI, "EI"sv, 0 },
+        { PdfOperator::Do, "Do"sv, 1 },
+        { PdfOperator::MP, "MP"sv, 1 },
+        { PdfOperator::DP, "DP"sv, 2 },
+        { PdfOperator::BMC, "BMC"sv, 1 },
+        { PdfOperator::BDC, "BDC"sv, 2 },
+        { PdfOperator::EMC, "EMC"sv, 0 },
+        { PdfOperator::BX, "BX"sv, 0 },
+        { PdfOperator::EX, "EX"sv, 0 },
+    };
 
-bool mm::TryGetPdfOperator(const string_view& opstr, PdfOperator& op)
-{
-    if (opstr == "w")
-    {
-        op = PdfOperator::w;
-        return true;
-    }
-    else if (opstr == "J")
-    {
-        op = PdfOperator::J;
-        return true;
-    }
-    else if (opstr == "j")
-    {
-        op = PdfOperator::j;
-        return true;
-    }
-    else if (opstr == "M")
-    {
-        op = PdfOperator::M;
-        return true;
-    }
-    else if (opstr == "d")
-    {
-        op = PdfOperator::d;
-        return true;
-    }
-    else if (opstr == "ri")
-    {
-        op = PdfOperator::ri;
-        return true;
-    }
-    else if (opstr == "i")
-    {
-        op = PdfOperator::i;
-        return true;
-    }
-    else if (opstr == "gs")
-    {
-        op = PdfOperator::gs;
-        return true;
-    }
-    else if (opstr == "q")
-    {
-        op = PdfOperator::q;
-        return true;
-    }
-    else if (opstr == "Q")
-    {
-        op = PdfOperator::Q;
-        return true;
-    }
-    else if (opstr == "cm")
-    {
-        op = PdfOperator::cm;
-        return true;
-    }
-    else if (opstr == "m")
-    {
-        op = PdfOperator::m;
-        return true;
-    }
-    else if (opstr == "l")
-    {
-        op = PdfOperator::l;
-        return true;
-    }
-    else if (opstr == "c")
-    {
-        op = PdfOperator::c;
-        return true;
-    }
-    else if (opstr == "v")
-    {
-        op = PdfOperator::v;
-        return true;
-    }
-    else if (opstr == "y")
-    {
-        op = PdfOperator::y;
-        return true;
-    }
-    else if (opstr == "h")
-    {
-        op = PdfOperator::h;
-        return true;
-    }
-    else if (opstr == "re")
-    {
-        op = PdfOperator::re;
-        return true;
-    }
-    else if (opstr == "S")
-    {
-        op = PdfOperator::S;
-        return true;
-    }
-    else if (opstr == "s")
-    {
-        op = PdfOperator::s;
-        return true;
-    }
-    else if (opstr == "f")
-    {
-        op = PdfOperator::f;
-        return true;
-    }
-    else if (opstr == "F")
-    {
-        op = PdfOperator::F;
-        return true;
-    }
-    else if (opstr == "f*")
-    {
-        op = PdfOperator::f_Star;
-        return true;
-    }
-    else if (opstr == "B")
-    {
-        op = PdfOperator::B;
-        return true;
-    }
-    else if (opstr == "B*")
-    {
-        op = PdfOperator::B_Star;
-        return true;
-    }
-    else if (opstr == "b")
-    {
-        op = PdfOperator::b;
-        return true;
-    }
-    else if (opstr == "b*")
-    {
-        op = PdfOperator::b_Star;
-        return true;
-    }
-    else if (opstr == "n")
-    {
-        op = PdfOperator::n;
-        return true;
-    }
-    else if (opstr == "W")
-    {
-        op = PdfOperator::W;
-        return true;
-    }
-    else if (opstr == "W*")
-    {
-        op = PdfOperator::W_Star;
-        return true;
-    }
-    else if (opstr == "BT")
-    {
-        op = PdfOperator::BT;
-        return true;
-    }
-    else if (opstr == "ET")
-    {
-        op = PdfOperator::ET;
-        return true;
-    }
-    else if (opstr == "Tc")
-    {
-        op = PdfOperator::Tc;
-        return true;
-    }
-    else if (opstr == "Tw")
-    {
-        op = PdfOperator::Tw;
-        return true;
-    }
-    else if (opstr == "Tz")
-    {
-        op = PdfOperator::Tz;
-        return true;
-    }
-    else if (opstr == "TL")
-    {
-        op = PdfOperator::TL;
-        return true;
-    }
-    else if (opstr == "Tf")
-    {
-        op = PdfOperator::Tf;
-        return true;
-    }
-    else if (opstr == "Tr")
-    {
-        op = PdfOperator::Tr;
-        return true;
-    }
-    else if (opstr == "Ts")
-    {
-        op = PdfOperator::Ts;
-        return true;
-    }
-    else if (opstr == "Td")
-    {
-        op = PdfOperator::Td;
-        return true;
-    }
-    else if (opstr == "TD")
-    {
-        op = PdfOperator::TD;
-        return true;
-    }
-    else if (opstr == "Tm")
-    {
-        op = PdfOperator::Tm;
-        return true;
-    }
-    else if (opstr == "T*")
-    {
-        op = PdfOperator::T_Star;
-        return true;
-    }
-    else if (opstr == "Tj")
-    {
-        op = PdfOperator::Tj;
-        return true;
-    }
-    else if (opstr == "TJ")
-    {
-        op = PdfOperator::TJ;
-        return true;
-    }
-    else if (opstr == "'")
-    {
-        op = PdfOperator::Quote;
-        return true;
-    }
-    else if (opstr == "\"")
-    {
-        op = PdfOperator::DoubleQuote;
-        return true;
-    }
-    else if (opstr == "d0")
-    {
-        op = PdfOperator::d0;
-        return true;
-    }
-    else if (opstr == "d1")
-    {
-        op = PdfOperator::d1;
-        return true;
-    }
-    else if (opstr == "CS")
-    {
-        op = PdfOperator::CS;
-        return true;
-    }
-    else if (opstr == "cs")
-    {
-        op = PdfOperator::cs;
-        return true;
-    }
-    else if (opstr == "SC")
-    {
-        op = PdfOperator::SC;
-        return true;
-    }
-    else if (opstr == "SCN")
-    {
-        op = PdfOperator::SCN;
-        return true;
-    }
-    else if (opstr == "sc")
-    {
-        op = PdfOperator::sc;
-        return true;
-    }
-    else if (opstr == "scn")
-    {
-        op = PdfOperator::scn;
-        return true;
-    }
-    else if (opstr == "G")
-    {
-        op = PdfOperator::G;
-        return true;
-    }
-    else if (opstr == "g")
-    {
-        op = PdfOperator::g;
-        return true;
-    }
-    else if (opstr == "RG")
-    {
-        op = PdfOperator::RG;
-        return true;
-    }
-    else if (opstr == "rg")
-    {
-        op = PdfOperator::rg;
-        return true;
-    }
-    else if (opstr == "K")
-    {
-        op = PdfOperator::K;
-        return true;
-    }
-    else if (opstr == "k")
-    {
-        op = PdfOperator::k;
-        return true;
-    }
-    else if (opstr == "sh")
-    {
-        op = PdfOperator::sh;
-        return true;
-    }
-    else if (opstr == "BI")
-    {
-        op = PdfOperator::BI;
-        return true;
-    }
-    else if (opstr == "ID")
-    {
-        op = PdfOperator::ID;
-        return true;
-    }
-    else if (opstr == "EI")
-    {
-        op = PdfOperator::EI;
-        return true;
-    }
-    else if (opstr == "Do")
-    {
-        op = PdfOperator::Do;
-        return true;
-    }
-    else if (opstr == "MP")
-    {
-        op = PdfOperator::MP;
-        return true;
-    }
-    else if (opstr == "DP")
-    {
-        op = PdfOperator::DP;
-        return true;
-    }
-    else if (opstr == "BMC")
+    constexpr unsigned OperatorCount = (unsigned)std::size(s_operators);
+    static_assert((unsigned)PdfOperator::EX == OperatorCount - 1, "The operator table must follow the PdfOperator values");
+
+    // The operator names are at most 3 characters, so they are
+    // packed in an integer key and looked up in a table built at
+    // compile time. The multiplier of the hash is chosen so that
+    // the hash is perfect, i.e. the operators don't collide
+    constexpr unsigned HashTableSize = 256;
+    constexpr unsigned MaxOperatorLength = 3;
+
+    constexpr uint32_t getOperatorKey(const string_view& opstr)
     {
-        op = PdfOperator::BMC;
-        return true;
+        uint32_t key = 0;
+        for (unsigned i = 0; i < opstr.size(); i++)
+            key = key << 8 | (unsigned char)opstr[i];
+
+        return key;
     }
-    else if (opstr == "BDC")
+
+    constexpr unsigned getOperatorHash(uint32_t key)
     {
-        op = PdfOperator::BDC;
-        return true;
+        return (uint32_t)(key * 0xCC3954A7u) >> 24;
     }
-    else if (opstr == "EMC")
+
+    constexpr array<unsigned char, HashTableSize> createOperatorTable()
     {
-        op = PdfOperator::EMC;
-        return true;
+        array<unsigned char, HashTableSize> table { };
+        for (unsigned i = 1; i < OperatorCount; i++)
+            table[getOperatorHash(getOperatorKey(s_operators[i].Name))] = (unsigned char)i;
+
+        return table;
     }
-    else if (opstr == "BX")
+
+    constexpr bool isOperatorHashPerfect()
     {
-        op = PdfOperator::BX;
+        array<bool, HashTableSize> used { };
+        for (unsigned i = 1; i < OperatorCount; i++)
+        {
+            unsigned index = getOperatorHash(getOperatorKey(s_operators[i].Name));
+            if (used[index])
+                return false;
+
+            used[index] = true;
+        }
+
         return true;
     }
-    else if (opstr == "EX")
+
+    static_assert(isOperatorHashPerfect(), "The operator hash must have no collisions");
+
+    constexpr array<unsigned char, HashTableSize> s_operatorTable = createOperatorTable();
+}
+
+PdfOperator mm::GetPdfOperator(const string_view& opstr)
+{
+    PdfOperator op;
+    if (!TryGetPdfOperator(opstr, op))
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidName, "Invalid operator");
+
+    return op;
+}
+
+bool mm::TryGetPdfOperator(const string_view& opstr, PdfOperator& op)
+{
+    if (opstr.size() == 0 || opstr.size() > MaxOperatorLength)
     {
-        op = PdfOperator::EX;
-        return true;
+        op = PdfOperator::Unknown;
+        return false;
     }
-    else
+
+    // The unknown operator at index 0 has an empty name, which never matches
+    auto& info = s_operators[s_operatorTable[getOperatorHash(getOperatorKey(opstr))]];
+    if (info.Name != opstr)
     {
         op = PdfOperator::Unknown;
         return false;
     }
+
+    op = info.Operator;
+    return true;
 }
 
 int mm::GetOperandCount(PdfOperator op)
@@ -398,232 +184,15 @@ int mm::GetOperandCount(PdfOperator op)
 
 bool mm::TryGetOperandCount(PdfOperator op, int& count)
 {
-    switch (op)
+    unsigned index = (unsigned)op;
+    if (index == 0 || index >= OperatorCount)
     {
-        case PdfOperator::w:
-            count = 1;
-            return true;
-        case PdfOperator::J:
-            count = 1;
-            return true;
-        case PdfOperator::j:
-            count = 1;
-            return true;
-        case PdfOperator::M:
-            count = 1;
-            return true;
-        case PdfOperator::d:
-            count = 2;
-            return true;
-        case PdfOperator::ri:
-            count = 1;
-            return true;
-        case PdfOperator::i:
-            count = 1;
-            return true;
-        case PdfOperator::gs:
-            count = 1;
-            return true;
-        case PdfOperator::q:
-            count = 0;
-            return true;
-        case PdfOperator::Q:
-            count = 0;
-            return true;
-        case PdfOperator::cm:
-            count = 6;
-            return true;
-        case PdfOperator::m:
-            count = 2;
-            return true;
-        case PdfOperator::l:
-            count = 2;
-            return true;
-        case PdfOperator::c:
-            count = 6;
-            return true;
-        case PdfOperator::v:
-            count = 4;
-            return true;
-        case PdfOperator::y:
-            count = 4;
-            return true;
-        case PdfOperator::h:
-            count = 0;
-            return true;
-        case PdfOperator::re:
-            count = 4;
-            return true;
-        case PdfOperator::S:
-            count = 0;
-            return true;
-        case PdfOperator::s:
-            count = 0;
-            return true;
-        case PdfOperator::f:
-            count = 0;
-            return true;
-        case PdfOperator::F:
-            count = 0;
-            return true;
-        case PdfOperator::f_Star:
-            count = 0;
-            return true;
-        case PdfOperator::B:
-            count = 0;
-            return true;
-        case PdfOperator::B_Star:
-            count = 0;
-            return true;
-        case PdfOperator::b:
-            count = 0;
-            return true;
-        case PdfOperator::b_Star:
-            count = 0;
-            return true;
-        case PdfOperator::n:
-            count = 0;
-            return true;
-        case PdfOperator::W:
-            count = 0;
-            return true;
-        case PdfOperator::W_Star:
-            count = 0;
-            return true;
-        case PdfOperator::BT:
-            count = 0;
-            return true;
-        case PdfOperator::ET:
-            count = 0;
-            return true;
-        case PdfOperator::Tc:
-            count = 1;
-            return true;
-        case PdfOperator::Tw:
-            count = 1;
-            return true;
-        case PdfOperator::Tz:
-            count = 1;
-            return true;
-        case PdfOperator::TL:
-            count = 1;
-            return true;
-        case PdfOperator::Tf:
-            count = 2;
-            return true;
-        case PdfOperator::Tr:
-            count = 1;
-            return true;
-        case PdfOperator::Ts:
-            count = 1;
-            return true;
-        case PdfOperator::Td:
-            count = 2;
-            return true;
-        case PdfOperator::TD:
-            count = 2;
-            return true;
-        case PdfOperator::Tm:
-            count = 6;
-            return true;
-        case PdfOperator::T_Star:
-            count = 0;
-            return true;
-        case PdfOperator::Tj:
-            count = 1;
-            return true;
-        case PdfOperator::TJ:
-            count = 1;
-            return true;
-        case PdfOperator::Quote:
-            count = 1;
-            return true;
-        case PdfOperator::DoubleQuote:
-            count = 3;
-            return true;
-        case PdfOperator::d0:
-            count = 2;
-            return true;
-        case PdfOperator::d1:
-            count = 6;
-            return true;
-        case PdfOperator::CS:
-            count = 1;
-            return true;
-        case PdfOperator::cs:
-            count = 1;
-            return true;
-        case PdfOperator::SC:
-            count = -1;
-            return true;
-        case PdfOperator::SCN:
-            count = -1;
-            return true;
-        case PdfOperator::sc:
-            count = -1;
-            return true;
-        case PdfOperator::scn:
-            count = -1;
-            return true;
-        case PdfOperator::G:
-            count = 1;
-            return true;
-        case PdfOperator::g:
-            count = 1;
-            return true;
-        case PdfOperator::RG:
-            count = 3;
-            return true;
-        case PdfOperator::rg:
-            count = 3;
-            return true;
-        case PdfOperator::K:
-            count = 4;
-            return true;
-        case PdfOperator::k:
-            count = 4;
-            return true;
-        case PdfOperator::sh:
-            count = 1;
-            return true;
-        case PdfOperator::BI:
-            count = 0;
-            return true;
-        case PdfOperator::ID:
-            count = 0;
-            return true;
-        case PdfOperator::EI:
-            count = 0;
-            return true;
-        case PdfOperator::Do:
-            count = 1;
-            return true;
-        case PdfOperator::MP:
-            count = 1;
-            return true;
-        case PdfOperator::DP:
-            count = 2;
-            return true;
-        case PdfOperator::BMC:
-            count = 1;
-            return true;
-        case PdfOperator::BDC:
-            count = 2;
-            return true;
-        case PdfOperator::EMC:
-            count = 0;
-            return true;
-        case PdfOperator::BX:
-            count = 0;
-            return true;
-        case PdfOperator::EX:
-            count = 0;
-            return true;
-        default:
-        case PdfOperator::Unknown:
-            count = 0;
-            return false;
+        count = 0;
+        return false;
     }
+
+    count = s_operators[index].OperandCount;
+    return true;
 }
 
 string_view mm::GetPdfOperatorName(PdfOperator op)
@@ -637,376 +206,13 @@ string_view mm::GetPdfOperatorName(PdfOperator op)
 
 bool mm::TryGetPdfOperatorName(PdfOperator op, string_view& opstr)
 {
-    switch (op)
+    unsigned index = (unsigned)op;
+    if (index == 0 || index >= OperatorCount)
     {
-        case PdfOperator::w:
-        {
-            opstr = "w";
-            return true;
-        }
-        case PdfOperator::J:
-        {
-            opstr = "J";
-            return true;
-        }
-        case PdfOperator::j:
-        {
-            opstr = "j";
-            return true;
-        }
-        case PdfOperator::M:
-        {
-            opstr = "M";
-            return true;
-        }
-        case PdfOperator::d:
-        {
-            opstr = "d";
-            return true;
-        }
-        case PdfOperator::ri:
-        {
-            opstr = "ri";
-            return true;
-        }
-        case PdfOperator::i:
-        {
-            opstr = "i";
-            return true;
-        }
-        case PdfOperator::gs:
-        {
-            opstr = "gs";
-            return true;
-        }
-        case PdfOperator::q:
-        {
-            opstr = "q";
-            return true;
-        }
-        case PdfOperator::Q:
-        {
-            opstr = "Q";
-            return true;
-        }
-        case PdfOperator::cm:
-        {
-            opstr = "cm";
-            return true;
-        }
-        case PdfOperator::m:
-        {
-            opstr = "m";
-            return true;
-        }
-        case PdfOperator::l:
-        {
-            opstr = "l";
-            return true;
-        }
-        case PdfOperator::c:
-        {
-            opstr = "c";
-            return true;
-        }
-        case PdfOperator::v:
-        {
-            opstr = "v";
-            return true;
-        }
-        case PdfOperator::y:
-        {
-            opstr = "y";
-            return true;
-        }
-        case PdfOperator::h:
-        {
-            opstr = "h";
-            return true;
-        }
-        case PdfOperator::re:
-        {
-            opstr = "re";
-            return true;
-        }
-        case PdfOperator::S:
-        {
-            opstr = "S";
-            return true;
-        }
-        case PdfOperator::s:
-        {
-            opstr = "s";
-            return true;
-        }
-        case PdfOperator::f:
-        {
-            opstr = "f";
-            return true;
-        }
-        case PdfOperator::F:
-        {
-            opstr = "F";
-            return true;
-        }
-        case PdfOperator::f_Star:
-        {
-            opstr = "f*";
-            return true;
-        }
-        case PdfOperator::B:
-        {
-            opstr = "B";
-            return true;
-        }
-        case PdfOperator::B_Star:
-        {
-            opstr = "B*";
-            return true;
-        }
-        case PdfOperator::b:
-        {
-            opstr = "b";
-            return true;
-        }
-        case PdfOperator::b_Star:
-        {
-            opstr = "b*";
-            return true;
-        }
-        case PdfOperator::n:
-        {
-            opstr = "n";
-            return true;
-        }
-        case PdfOperator::W:
-        {
-            opstr = "W";
-            return true;
-        }
-        case PdfOperator::W_Star:
-        {
-            opstr = "W*";
-            return true;
-        }
-        case PdfOperator::BT:
-        {
-            opstr = "BT";
-            return true;
-        }
-        case PdfOperator::ET:
-        {
-            opstr = "ET";
-            return true;
-        }
-        case PdfOperator::Tc:
-        {
-            opstr = "Tc";
-            return true;
-        }
-        case PdfOperator::Tw:
-        {
-            opstr = "Tw";
-            return true;
-        }
-        case PdfOperator::Tz:
-        {
-            opstr = "Tz";
-            return true;
-        }
-        case PdfOperator::TL:
-        {
-            opstr = "TL";
-            return true;
-        }
-        case PdfOperator::Tf:
-        {
-            opstr = "Tf";
-            return true;
-        }
-        case PdfOperator::Tr:
-        {
-            opstr = "Tr";
-            return true;
-        }
-        case PdfOperator::Ts:
-        {
-            opstr = "Ts";
-            return true;
-        }
-        case PdfOperator::Td:
-        {
-            opstr = "Td";
-            return true;
-        }
-        case PdfOperator::TD:
-        {
-            opstr = "TD";
-            return true;
-        }
-        case PdfOperator::Tm:
-        {
-            opstr = "Tm";
-            return true;
-        }
-        case PdfOperator::T_Star:
-        {
-            opstr = "T*";
-            return true;
-        }
-        case PdfOperator::Tj:
-        {
-            opstr = "Tj";
-            return true;
-        }
-        case PdfOperator::TJ:
-        {
-            opstr = "TJ";
-            return true;
-        }
-        case PdfOperator::Quote:
-        {
-            opstr = "'";
-            return true;
-        }
-        case PdfOperator::DoubleQuote:
-        {
-            opstr = "\"";
-            return true;
-        }
-        case PdfOperator::d0:
-        {
-            opstr = "d0";
-            return true;
-        }
-        case PdfOperator::d1:
-        {
-            opstr = "d1";
-            return true;
-        }
-        case PdfOperator::CS:
-        {
-            opstr = "CS";
-            return true;
-        }
-        case PdfOperator::cs:
-        {
-            opstr = "cs";
-            return true;
-        }
-        case PdfOperator::SC:
-        {
-            opstr = "SC";
-            return true;
-        }
-        case PdfOperator::SCN:
-        {
-            opstr = "SCN";
-            return true;
-        }
-        case PdfOperator::sc:
-        {
-            opstr = "sc";
-            return true;
-        }
-        case PdfOperator::scn:
-        {
-            opstr = "scn";
-            return true;
-        }
-        case PdfOperator::G:
-        {
-            opstr = "G";
-            return true;
-        }
-        case PdfOperator::g:
-        {
-            opstr = "g";
-            return true;
-        }
-        case PdfOperator::RG:
-        {
-            opstr = "RG";
-            return true;
-        }
-        case PdfOperator::rg:
-        {
-            opstr = "rg";
-            return true;
-        }
-        case PdfOperator::K:
-        {
-            opstr = "K";
-            return true;
-        }
-        case PdfOperator::k:
-        {
-            opstr = "k";
-            return true;
-        }
-        case PdfOperator::sh:
-        {
-            opstr = "sh";
-            return true;
-        }
-        case PdfOperator::BI:
-        {
-            opstr = "BI";
-            return true;
-        }
-        case PdfOperator::ID:
-        {
-            opstr = "ID";
-            return true;
-        }
-        case PdfOperator::EI:
-        {
-            opstr = "EI";
-            return true;
-        }
-        case PdfOperator::Do:
-        {
-            opstr = "Do";
-            return true;
-        }
-        case PdfOperator::MP:
-        {
-            opstr = "MP";
-            return true;
-        }
-        case PdfOperator::DP:
-        {
-            opstr = "DP";
-            return true;
-        }
-        case PdfOperator::BMC:
-        {
-            opstr = "BMC";
-            return true;
-        }
-        case PdfOperator::BDC:
-        {
-            opstr = "BDC";
-            return true;
-        }
-        case PdfOperator::EMC:
-        {
-            opstr = "EMC";
-            return true;
-        }
-        case PdfOperator::BX:
-        {
-            opstr = "BX";
-            return true;
-        }
-        case PdfOperator::EX:
-        {
-            opstr = "EX";
-            return true;
-        }
-        case PdfOperator::Unknown:
-        default:
-            opstr = { };
-            return true;
+        opstr = { };
+        return false;
     }
+
+    opstr = s_operators[index].Name;
+    return true;
 }
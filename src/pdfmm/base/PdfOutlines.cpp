@@ -8,6 +8,8 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfOutlines.h"
 
+#include <unordered_set>
+
 #include "PdfDocument.h"
 #include "PdfArray.h"
 #include "PdfDictionary.h"
@@ -48,19 +50,22 @@ PdfOutlineItem::PdfOutlineItem(PdfObject& obj, PdfOutlineItem* parentOutline, Pd
     : PdfDictionaryElement(obj), m_ParentOutline(parentOutline), m_Prev(previous),
     m_Next(nullptr), m_First(nullptr), m_Last(nullptr), m_destination(nullptr), m_action(nullptr)
 {
-    PdfReference first, next;
-
-    if (this->GetObject().GetDictionary().HasKey("First"))
-    {
-        first = this->GetObject().GetDictionary().GetKey("First")->GetReference();
-        m_First = new PdfOutlineItem(obj.GetDocument()->GetObjects().MustGetObject(first), this, nullptr);
-    }
+}
 
-    if (this->GetObject().GetDictionary().HasKey("Next"))
-    {
-        next = this->GetObject().GetDictionary().GetKey("Next")->GetReference();
-        m_Next = new PdfOutlineItem(obj.GetDocument()->GetObjects().MustGetObject(next), parentOutline, this);
-    }
+PdfOutlineItem::PdfOutlineItem(PdfDocument& doc, const PdfOutlineNode& node, PdfOutlineItem* parentOutline) :
+    PdfDictionaryElement(doc),
+    m_ParentOutline(parentOutline), m_Prev(nullptr), m_Next(nullptr),
+    m_First(nullptr), m_Last(nullptr), m_destination(nullptr), m_action(nullptr)
+{
+    auto& dict = this->GetObject().GetDictionary();
+    dict.AddKey("Parent", parentOutline->GetObject().GetIndirectReference());
+    dict.AddKey("Title", node.Title);
+    if (node.Destination != nullptr)
+        SetDestination(node.Destination);
+    if (node.Action != nullptr)
+        SetAction(node.Action);
+    if (node.Format != PdfOutlineFormat::Default)
+        SetTextFormat(node.Format);
 }
 
 PdfOutlineItem::PdfOutlineItem(PdfDocument& doc)
@@ -71,8 +76,24 @@ PdfOutlineItem::PdfOutlineItem(PdfDocument& doc)
 
 PdfOutlineItem::~PdfOutlineItem()
 {
-    delete m_Next;
-    delete m_First;
+    // Delete the siblings and the children without
+    // recursion, so long outlines don't overflow the stack
+    vector<PdfOutlineItem*> stack;
+    stack.push_back(m_Next);
+    stack.push_back(m_First);
+    while (stack.size() != 0)
+    {
+        auto item = stack.back();
+        stack.pop_back();
+        if (item == nullptr)
+            continue;
+
+        stack.push_back(item->m_Next);
+        stack.push_back(item->m_First);
+        item->m_Next = nullptr;
+        item->m_First = nullptr;
+        delete item;
+    }
 }
 
 PdfOutlineItem* PdfOutlineItem::CreateChild(const PdfString& title, const shared_ptr<PdfDestination>& dest)
@@ -140,6 +161,143 @@ void PdfOutlineItem::InsertChildInternal(PdfOutlineItem* item, bool checkParent)
     this->GetObject().GetDictionary().AddKey("Last", m_Last->GetObject().GetIndirectReference());
 }
 
+void PdfOutlineItem::CreateChildren(const vector<PdfOutlineNode>& nodes)
+{
+    if (nodes.size() == 0)
+        return;
+
+    struct Entry
+    {
+        PdfOutlineItem* Item;
+        const PdfOutlineNode* Node;
+        int ParentIndex;
+        int64_t Count;
+    };
+
+    struct Group
+    {
+        PdfOutlineItem* Parent;
+        int ParentIndex;
+        const vector<PdfOutlineNode>* Nodes;
+    };
+
+    // Create the items one group of siblings at a time. The entries of
+    // the children always follow the entry of their parent
+    auto& doc = *GetObject().GetDocument();
+    vector<Entry> entries;
+    vector<Group> groups;
+    groups.push_back({ this, -1, &nodes });
+    while (groups.size() != 0)
+    {
+        auto group = groups.back();
+        groups.pop_back();
+        auto parent = group.Parent;
+        for (auto& node : *group.Nodes)
+        {
+            auto item = new PdfOutlineItem(doc, node, parent);
+            if (parent->m_Last == nullptr)
+            {
+                parent->SetFirst(item);
+            }
+            else
+            {
+                parent->m_Last->SetNext(item);
+                item->SetPrevious(parent->m_Last);
+            }
+
+            parent->m_Last = item;
+            entries.push_back({ item, &node, group.ParentIndex, 0 });
+            if (node.Children.size() != 0)
+                groups.push_back({ item, (int)entries.size() - 1, &node.Children });
+        }
+
+        parent->SetLast(parent->m_Last);
+    }
+
+    // Compute the counts from the leaves: the count is the number
+    // of descendants that are visible when the item is open
+    int64_t added = 0;
+    for (size_t i = entries.size(); i > 0; i--)
+    {
+        auto& entry = entries[i - 1];
+        int64_t visible = 1 + (entry.Node->Open ? entry.Count : 0);
+        if (entry.ParentIndex == -1)
+            added += visible;
+        else
+            entries[entry.ParentIndex].Count += visible;
+
+        if (entry.Count != 0)
+        {
+            entry.Item->GetObject().GetDictionary().AddKey("Count",
+                entry.Node->Open ? entry.Count : -entry.Count);
+        }
+    }
+
+    updateCount(added);
+}
+
+void PdfOutlineItem::updateCount(int64_t added)
+{
+    // Open items have a positive count, that is also added
+    // to the ancestors. The outlines dictionary is always open
+    auto item = this;
+    while (item != nullptr)
+    {
+        auto& dict = item->GetObject().GetDictionary();
+        int64_t count = dict.FindKeyAs<int64_t>("Count", 0);
+        bool open = count > 0 || dict.FindKeyAs<PdfName>(PdfName::KeyType) == "Outlines";
+        dict.AddKey("Count", open ? count + added : count - added);
+        if (!open)
+            break;
+
+        item = item->m_ParentOutline;
+    }
+}
+
+PdfOutlineItemIterable PdfOutlineItem::GetDescendants()
+{
+    return PdfOutlineItemIterable(*this);
+}
+
+void PdfOutlineItem::loadItems()
+{
+    // Load the outline tree without recursion, so long outlines
+    // don't overflow the stack. Items already loaded are not loaded
+    // again, to stop on loops of malformed documents
+    auto& objects = GetObject().GetDocument()->GetObjects();
+    unordered_set<PdfReference> loaded;
+    loaded.insert(GetObject().GetIndirectReference());
+    vector<PdfOutlineItem*> stack;
+    auto loadNext = [&](PdfOutlineItem* item) {
+        // Load the siblings following the given item
+        while (true)
+        {
+            stack.push_back(item);
+            auto nextObj = item->GetObject().GetDictionary().GetKey("Next");
+            PdfReference next;
+            if (nextObj == nullptr || !nextObj->TryGetReference(next) || !loaded.insert(next).second)
+                return item;
+
+            item->m_Next = new PdfOutlineItem(objects.MustGetObject(next), item->m_ParentOutline, item);
+            item = item->m_Next;
+        }
+    };
+
+    (void)loadNext(this);
+    while (stack.size() != 0)
+    {
+        auto item = stack.back();
+        stack.pop_back();
+        auto firstObj = item->GetObject().GetDictionary().GetKey("First");
+        PdfReference first;
+        if (firstObj == nullptr || !firstObj->TryGetReference(first) || !loaded.insert(first).second)
+            continue;
+
+        item->m_First = new PdfOutlineItem(objects.MustGetObject(first), item, nullptr);
+        item->m_Last = loadNext(item->m_First);
+    }
+}
+
 PdfOutlineItem* PdfOutlineItem::CreateNext(const PdfString& title, const shared_ptr<PdfDestination>& dest)
 {
     PdfOutlineItem* item = new PdfOutlineItem(*this->GetObject().GetDocument(), title, dest, m_ParentOutline);
@@ -364,9 +522,64 @@ PdfOutlines::PdfOutlines(PdfDocument& doc)
 PdfOutlines::PdfOutlines(PdfObject& obj)
     : PdfOutlineItem(obj, nullptr, nullptr)
 {
+    loadItems();
 }
 
 PdfOutlineItem* PdfOutlines::CreateRoot(const PdfString& title)
 {
     return this->CreateChild(title, std::make_shared<PdfDestination>(*GetObject().GetDocument()));
 }
+
+PdfOutlineItemIterable::PdfOutlineItemIterable(PdfOutlineItem& root)
+    : m_root(&root) { }
+
+PdfOutlineItemIterable::iterator PdfOutlineItemIterable::begin() const
+{
+    return iterator(m_root, m_root->First());
+}
+
+PdfOutlineItemIterable::iterator PdfOutlineItemIterable::end() const
+{
+    return iterator(m_root, nullptr);
+}
+
+PdfOutlineItemIterable::iterator::iterator()
+    : m_root(nullptr), m_item(nullptr) { }
+
+PdfOutlineItemIterable::iterator::iterator(PdfOutlineItem* root, PdfOutlineItem* item)
+    : m_root(root), m_item(item) { }
+
+bool PdfOutlineItemIterable::iterator::operator==(const iterator& rhs) const
+{
+    return m_item == rhs.m_item;
+}
+
+bool PdfOutlineItemIterable::iterator::operator!=(const iterator& rhs) const
+{
+    return m_item != rhs.m_item;
+}
+
+PdfOutlineItemIterable::iterator& PdfOutlineItemIterable::iterator::operator++()
+{
+    if (m_item->First() != nullptr)
+    {
+        m_item = m_item->First();
+        return *this;
+    }
+
+    // Go up until an item with a following sibling is found
+    auto item = m_item;
+    while (item != nullptr && item != m_root)
+    {
+        if (item->Next() != nullptr)
+        {
+            m_item = item->Next();
+            return *this;
+        }
+
+        item = item->GetParentOutline();
+    }
+
+    m_item = nullptr;
+    return *this;
+}
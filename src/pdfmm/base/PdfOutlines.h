@@ -11,6 +11,7 @@
 #include "PdfDeclarations.h"
 
 #include "PdfElement.h"
+#include "PdfString.h"
 
 namespace mm {
 
@@ -18,7 +19,6 @@ class PdfDestination;
 class PdfAction;
 class PdfObject;
 class PdfOutlineItem;
-class PdfString;
 class PdfIndirectObjectList;
 
 /**
@@ -33,6 +33,66 @@ enum class PdfOutlineFormat
     BoldItalic = 0x03,   ///< Bold Italic
 };
 
+/**
+ * Description of an outline item and its children,
+ * to create a whole outline tree in a single pass
+ *
+ * \see PdfOutlineItem::CreateChildren
+ */
+struct PdfOutlineNode
+{
+    PdfString Title;
+    std::shared_ptr<PdfDestination> Destination;   ///< Destination of the item, or nullptr
+    std::shared_ptr<PdfAction> Action;             ///< Action of the item, or nullptr
+    PdfOutlineFormat Format = PdfOutlineFormat::Default;
+    bool Open = false;                             ///< If true the children of the item are shown
+    std::vector<PdfOutlineNode> Children;
+};
+
+/**
+ * Helper class to iterate all the descendants of an
+ * outline item in preorder, without recursion
+ */
+class PDFMM_API PdfOutlineItemIterable final
+{
+    friend class PdfOutlineItem;
+
+private:
+    PdfOutlineItemIterable(PdfOutlineItem& root);
+
+public:
+    class PDFMM_API iterator final
+    {
+        friend class PdfOutlineItemIterable;
+    public:
+        using difference_type = void;
+        using value_type = PdfOutlineItem*;
+        using pointer = void;
+        using reference = PdfOutlineItem*;
+        using iterator_category = std::forward_iterator_tag;
+    private:
+        iterator(PdfOutlineItem* root, PdfOutlineItem* item);
+    public:
+        iterator();
+        iterator(const iterator&) = default;
+        iterator& operator=(const iterator&) = default;
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+        iterator& operator++();
+        PdfOutlineItem* operator*() const { return m_item; }
+    private:
+        PdfOutlineItem* m_root;
+        PdfOutlineItem* m_item;
+    };
+
+public:
+    iterator begin() const;
+    iterator end() const;
+
+private:
+    PdfOutlineItem* m_root;
+};
+
 /**
  * A PDF outline item has an title and a destination.
  * It is an element in the documents outline which shows
@@ -78,6 +138,24 @@ public:
      */
     void InsertChild(PdfOutlineItem* item);
 
+    /** Create the given items and all their descendants
+     *  as children of this item, after the existing ones
+     *
+     *  The outline dictionaries, including their /Count,
+     *  are written in a single pass, so it's much faster
+     *  than creating large outlines one item at a time.
+     *  The /Count of this item and its open ancestors
+     *  is updated once
+     *
+     *  \param nodes the description of the items to create
+     */
+    void CreateChildren(const std::vector<PdfOutlineNode>& nodes);
+
+    /** Get all the descendants of this item in preorder,
+     *  i.e. every item is followed by its children
+     */
+    PdfOutlineItemIterable GetDescendants();
+
     /**
      * \returns the previous item or nullptr if this is the first on the current level
      */
@@ -197,6 +275,8 @@ private:
 
     void InsertChildInternal(PdfOutlineItem* item, bool checkParent);
 
+    void updateCount(int64_t added);
+
 protected:
     /** Create a new PdfOutlineItem dictionary
      *  \param parent parent vector of objects
@@ -233,6 +313,14 @@ protected:
      */
     PdfOutlineItem(PdfObject& obj, PdfOutlineItem* parentOutline, PdfOutlineItem* previous);
 
+    /** Load the following items and the children of this
+     *  item, after it was created from an existing PdfObject
+     */
+    void loadItems();
+
+private:
+    PdfOutlineItem(PdfDocument& doc, const PdfOutlineNode& node, PdfOutlineItem* parentOutline);
+
 private:
     PdfOutlineItem* m_ParentOutline;
 
@@ -9,6 +9,8 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfPage.h"
 
+#include <unordered_set>
+
 #include "PdfDictionary.h"
 #include "PdfRect.h"
 #include "PdfVariant.h"
@@ -16,12 +18,19 @@
 #include "PdfObjectStream.h"
 #include "PdfColor.h"
 #include "PdfDocument.h"
+#include "PdfAnnotation.h"
+#include "PdfStringStream.h"
 
 using namespace std;
 using namespace mm;
 
 static int normalize(int value, int start, int end);
 static PdfResources* getResources(PdfObject& obj, const deque<PdfObject*>& listOfParents);
+static bool tryGetNormalAppearance(const PdfDictionary& annotDict, PdfObject*& appearance);
+static bool tryGetFlattenMatrix(const PdfObject& form, const PdfRect& rect, double matrix[6]);
+
+// The names of the page boxes, in the order of PdfPage::PageBoxType
+static constexpr string_view PageBoxNames[] = { "MediaBox", "CropBox", "TrimBox", "BleedBox", "ArtBox" };
 
 PdfPage::PdfPage(PdfDocument& parent, const PdfRect& size)
     : PdfDictionaryElement(parent, "Page"), m_Contents(nullptr)
@@ -86,6 +95,47 @@ void PdfPage::EnsureResourcesCreated()
     m_Resources.reset(new PdfResources(GetDictionary()));
 }
 
+void PdfPage::EnsureOwnResources()
+{
+    if (m_Resources == nullptr)
+    {
+        EnsureResourcesCreated();
+        return;
+    }
+
+    auto& dict = GetDictionary();
+    auto resourcesObj = dict.GetKey("Resources");
+    if (resourcesObj == &m_Resources->GetObject())
+    {
+        bool owned = true;
+        for (auto& pair : m_Resources->GetDictionary())
+        {
+            if (pair.second.IsReference())
+            {
+                owned = false;
+                break;
+            }
+        }
+
+        if (owned)
+            return;
+    }
+
+    const auto& resources = const_cast<const PdfResources&>(*m_Resources).GetDictionary();
+    PdfDictionary ownResources;
+    for (auto& pair : resources)
+    {
+        auto value = resources.FindKey(pair.first);
+        const PdfDictionary* typeDict;
+        if (value != nullptr && value->TryGetDictionary(typeDict))
+            ownResources.AddKey(pair.first, *typeDict);
+        else
+            ownResources.AddKey(pair.first, pair.second);
+    }
+
+    m_Resources.reset(new PdfResources(dict.AddKey("Resources", std::move(ownResources))));
+}
+
 PdfObjectStream& PdfPage::GetStreamForAppending(PdfStreamAppendFlags flags)
 {
     EnsureContentsCreated();
@@ -203,44 +253,75 @@ const PdfObject* PdfPage::GetInheritedKeyFromObject(const string_view& key, cons
     return obj;
 }
 
-PdfRect PdfPage::GetPageBox(const string_view& inBox) const
+PdfRect PdfPage::GetPageBox(PageBoxType type) const
+{
+    auto& cache = getAttributesCache();
+    unsigned flag = 1u << (unsigned)type;
+    if ((cache.ValidMask & flag) == 0)
+    {
+        cache.Boxes[(unsigned)type] = computePageBox(type);
+        cache.ValidMask |= flag;
+    }
+
+    return cache.Boxes[(unsigned)type];
+}
+
+PdfRect PdfPage::computePageBox(PageBoxType type) const
 {
-    PdfRect	pageBox;
+    PdfRect pageBox;
 
     // Take advantage of inherited values - walking up the tree if necessary
-    auto obj = GetInheritedKeyFromObject(inBox, this->GetObject());
+    auto obj = GetInheritedKeyFromObject(PageBoxNames[(unsigned)type], this->GetObject());
 
     // assign the value of the box from the array
     if (obj != nullptr && obj->IsArray())
     {
         pageBox.FromArray(obj->GetArray());
     }
-    else if (inBox == "ArtBox" ||
-        inBox == "BleedBox" ||
-        inBox == "TrimBox")
+    else if (type == PageBoxType::Crop)
+    {
+        // If crop box is not specified then
+        // default to MediaBox per PDF Spec (3.6.2)
+        pageBox = GetPageBox(PageBoxType::Media);
+    }
+    else if (type != PageBoxType::Media)
     {
         // If those page boxes are not specified then
         // default to CropBox per PDF Spec (3.6.2)
-        pageBox = GetPageBox("CropBox");
+        pageBox = GetPageBox(PageBoxType::Crop);
     }
-    else if (inBox == "CropBox")
+
+    return pageBox;
+}
+
+PdfPage::AttributesCache& PdfPage::getAttributesCache() const
+{
+    auto document = this->GetObject().GetDocument();
+    uint64_t modificationCount = document == nullptr ? 0 : document->GetObjects().GetModificationCount();
+    if (document == nullptr || modificationCount != m_Attributes.ModificationCount)
     {
-        // If crop box is not specified then
-        // default to MediaBox per PDF Spec (3.6.2)
-        pageBox = GetPageBox("MediaBox");
+        m_Attributes.ModificationCount = modificationCount;
+        m_Attributes.ValidMask = 0;
     }
 
-    return pageBox;
+    return m_Attributes;
 }
 
 int PdfPage::GetRotationRaw() const
 {
+    auto& cache = getAttributesCache();
+    constexpr unsigned flag = 1u << std::size(PageBoxNames);
+    if ((cache.ValidMask & flag) != 0)
+        return cache.Rotation;
+
     int rot = 0;
 
     auto obj = GetInheritedKeyFromObject("Rotate", this->GetObject());
     if (obj != nullptr && (obj->IsNumber() || obj->GetReal()))
         rot = static_cast<int>(obj->GetNumber());
 
+    cache.Rotation = rot;
+    cache.ValidMask |= flag;
     return rot;
 }
 
@@ -294,6 +375,133 @@ PdfAnnotation* PdfPage::CreateAnnotation(PdfAnnotationType annotType, const PdfR
     return pAnnot;
 }
 
+unsigned PdfPage::FlattenAnnotations()
+{
+    auto arr = GetAnnotationsArray();
+    if (arr == nullptr || arr->GetSize() == 0)
+        return 0;
+
+    auto& objects = GetObject().GetDocument()->GetObjects();
+    vector<bool> flattened(arr->GetSize());
+    unordered_set<PdfReference> flattenedRefs;
+    PdfStringStream ops;
+    unsigned nameIndex = 0;
+    unsigned count = 0;
+    for (unsigned i = 0; i < arr->GetSize(); i++)
+    {
+        auto& annotObj = arr->FindAt(i);
+        PdfDictionary* dict;
+        PdfObject* appearance = nullptr;
+        if (!annotObj.TryGetDictionary(dict) || !tryGetNormalAppearance(*dict, appearance))
+            continue;
+
+        flattened[i] = true;
+        flattenedRefs.insert(annotObj.GetIndirectReference());
+        count++;
+
+        int64_t flags = 0;
+        auto flagsObj = dict->FindKey("F");
+        if (flagsObj != nullptr)
+            (void)flagsObj->TryGetNumber(flags);
+
+        auto rectObj = dict->FindKey("Rect");
+        double matrix[6];
+        if (appearance == nullptr || !appearance->GetIndirectReference().IsIndirect()
+            || (flags & (int64_t)(PdfAnnotationFlags::Hidden | PdfAnnotationFlags::NoView)) != 0
+            || rectObj == nullptr || !rectObj->IsArray() || rectObj->GetArray().GetSize() != 4
+            || !tryGetFlattenMatrix(*appearance, PdfRect(rectObj->GetArray()), matrix))
+        {
+            continue;
+        }
+
+        // Appearance streams are form XObjects, even if /Subtype is omitted
+        auto& formDict = appearance->GetDictionary();
+        if (!formDict.HasKey("Subtype"))
+            formDict.AddKey("Subtype", PdfName("Form"));
+
+        auto& resources = GetOrCreateResources();
+        string name;
+        do
+        {
+            name = "Flat" + std::to_string(nameIndex++);
+        } while (resources.GetResource("XObject", name) != nullptr);
+
+        resources.AddResource("XObject", name, appearance);
+        ops << "q" << endl
+            << matrix[0] << " " << matrix[1] << " "
+            << matrix[2] << " " << matrix[3] << " "
+            << matrix[4] << " " << matrix[5] << " cm" << endl
+            << "/" << name << " Do" << endl << "Q" << endl;
+    }
+
+    if (count == 0)
+        return 0;
+
+    // The popups of the flattened annotations would be orphaned
+    for (unsigned i = 0; i < arr->GetSize(); i++)
+    {
+        PdfDictionary* dict;
+        if (flattened[i] || !arr->FindAt(i).TryGetDictionary(dict))
+            continue;
+
+        auto subtype = dict->FindKey("Subtype");
+        auto parent = dict->GetKey("Parent");
+        if (subtype != nullptr && subtype->IsName() && subtype->GetName() == "Popup"
+            && parent != nullptr && parent->IsReference()
+            && flattenedRefs.find(parent->GetReference()) != flattenedRefs.end())
+        {
+            flattened[i] = true;
+        }
+    }
+
+    if (ops.GetSize() != 0)
+    {
+        // Wrap the existing contents, so the state they leave doesn't
+        // affect the appearances, without decoding them
+        GetStreamForAppending(PdfStreamAppendFlags::Prepend | PdfStreamAppendFlags::NoSaveRestorePrior)
+            .Set("q\n"sv);
+        auto& stream = GetStreamForAppending(PdfStreamAppendFlags::NoSaveRestorePrior);
+        stream.BeginAppend();
+        stream.Append("Q\n");
+        stream.Append(ops.GetString());
+        stream.EndAppend();
+    }
+
+    // Remove the annotations in a single pass, removing their
+    // objects only after the array doesn't reference them anymore
+    PdfArray kept;
+    vector<PdfReference> removed;
+    for (unsigned i = 0; i < arr->GetSize(); i++)
+    {
+        if (!flattened[i])
+        {
+            kept.Add((*arr)[i]);
+            continue;
+        }
+
+        auto& annotObj = arr->FindAt(i);
+        auto found = m_mapAnnotations.find(&annotObj);
+        if (found != m_mapAnnotations.end())
+        {
+            delete found->second;
+            m_mapAnnotations.erase(found);
+        }
+
+        if (annotObj.GetIndirectReference().IsIndirect())
+            removed.push_back(annotObj.GetIndirectReference());
+    }
+
+    if (kept.GetSize() == 0)
+        GetDictionary().RemoveKey("Annots");
+    else
+        *arr = kept;
+
+    for (auto& ref : removed)
+        objects.RemoveObject(ref);
+
+    return count;
+}
+
 PdfAnnotation* PdfPage::GetAnnotation(unsigned index)
 {
     PdfAnnotation* annot;
@@ -593,27 +801,27 @@ PdfResources& PdfPage::GetOrCreateResources()
 
 PdfRect PdfPage::GetMediaBox() const
 {
-    return GetPageBox("MediaBox");
+    return GetPageBox(PageBoxType::Media);
 }
 
 PdfRect PdfPage::GetCropBox() const
 {
-    return GetPageBox("CropBox");
+    return GetPageBox(PageBoxType::Crop);
 }
 
 PdfRect PdfPage::GetTrimBox() const
 {
-    return GetPageBox("TrimBox");
+    return GetPageBox(PageBoxType::Trim);
 }
 
 PdfRect PdfPage::GetBleedBox() const
 {
-    return GetPageBox("BleedBox");
+    return GetPageBox(PageBoxType::Bleed);
 }
 
 PdfRect PdfPage::GetArtBox() const
 {
-    return GetPageBox("ArtBox");
+    return GetPageBox(PageBoxType::Art);
 }
 
 const PdfObject* PdfPage::GetInheritedKey(const PdfName& name) const
@@ -646,3 +854,87 @@ PdfResources* getResources(PdfObject& obj, const deque<PdfObject*>& listOfParent
 
     return new PdfResources(*resources);
 }
+
+bool tryGetNormalAppearance(const PdfDictionary& annotDict, PdfObject*& appearance)
+{
+    appearance = nullptr;
+    auto apObj = annotDict.FindKey("AP");
+    const PdfDictionary* apDict;
+    if (apObj == nullptr || !apObj->TryGetDictionary(apDict))
+        return false;
+
+    auto normal = const_cast<PdfDictionary&>(*apDict).FindKey("N");
+    if (normal == nullptr)
+        return false;
+
+    if (normal->HasStream())
+    {
+        appearance = normal;
+        return true;
+    }
+
+    // The appearance of the current state. Without a
+    // matching state the annotation is not visible
+    PdfDictionary* states;
+    auto state = annotDict.FindKey("AS");
+    if (normal->TryGetDictionary(states) && state != nullptr && state->IsName())
+    {
+        auto stateAppearance = states->FindKey(state->GetName());
+        if (stateAppearance != nullptr && stateAppearance->HasStream())
+            appearance = stateAppearance;
+    }
+
+    return true;
+}
+
+// Compute the matrix that maps the appearance to the annotation
+// rectangle, following the algorithm of the PDF specification: the
+// bounding box transformed by /Matrix is fitted to the rectangle
+bool tryGetFlattenMatrix(const PdfObject& form, const PdfRect& rect, double matrix[6])
+{
+    auto& dict = form.GetDictionary();
+    auto bboxObj = dict.FindKey("BBox");
+    if (bboxObj == nullptr || !bboxObj->IsArray() || bboxObj->GetArray().GetSize() != 4)
+        return false;
+
+    PdfRect bbox(bboxObj->GetArray());
+    double formMatrix[6] = { 1, 0, 0, 1, 0, 0 };
+    auto matrixObj = dict.FindKey("Matrix");
+    if (matrixObj != nullptr && matrixObj->IsArray() && matrixObj->GetArray().GetSize() == 6)
+    {
+        auto& arr = matrixObj->GetArray();
+        for (unsigned i = 0; i < 6; i++)
+            formMatrix[i] = arr[i].GetReal();
+    }
+
+    double corners[4][2] = {
+        { bbox.GetLeft(), bbox.GetBottom() },
+        { bbox.GetRight(), bbox.GetBottom() },
+        { bbox.GetLeft(), bbox.GetTop() },
+        { bbox.GetRight(), bbox.GetTop() },
+    };
+    double left = numeric_limits<double>::max();
+    double bottom = numeric_limits<double>::max();
+    double right = numeric_limits<double>::lowest();
+    double top = numeric_limits<double>::lowest();
+    for (auto& corner : corners)
+    {
+        double x = formMatrix[0] * corner[0] + formMatrix[2] * corner[1] + formMatrix[4];
+        double y = formMatrix[1] * corner[0] + formMatrix[3] * corner[1] + formMatrix[5];
+        left = std::min(left, x);
+        bottom = std::min(bottom, y);
+        right = std::max(right, x);
+        top = std::max(top, y);
+    }
+
+    if (right - left == 0 || top - bottom == 0)
+        return false;
+
+    matrix[0] = rect.GetWidth() / (right - left);
+    matrix[1] = 0;
+    matrix[2] = 0;
+    matrix[3] = rect.GetHeight() / (top - bottom);
+    matrix[4] = rect.GetLeft() - left * matrix[0];
+    matrix[5] = rect.GetBottom() - bottom * matrix[3];
+    return true;
+}
@@ -19,12 +19,18 @@
 #include "PdfField.h"
 #include "PdfResources.h"
 
+#include <mutex>
+#include <unordered_map>
+
 namespace mm {
 
 class PdfDocument;
 class PdfDictionary;
 class PdfIndirectObjectList;
 class InputStream;
+class PdfFont;
+class PdfContentsCache;
+struct PdfTextState;
 
 struct PdfTextEntry final
 {
@@ -36,10 +42,112 @@ struct PdfTextEntry final
     double RawY;
 };
 
+/** A text entry as produced by the extraction, passed to a
+ *  PdfTextEntryHandler. The text view is valid only for the
+ *  duration of the call
+ */
+struct PdfTextEntryView final
+{
+    std::string_view Text;
+    int Page;
+    double X;
+    double Y;
+    double RawX;
+    double RawY;
+    double Length;          ///< The width of the text, in text space units
+    const PdfFont* Font;    ///< The font of the first string of the entry, may be nullptr
+    double FontSize;        ///< The font size of the first string of the entry
+};
+
+using PdfTextEntryHandler = std::function<void(const PdfTextEntryView& entry)>;
+
+/** A cache of the strings decoded by the fonts, so the strings
+ * repeated in the contents, like table labels or running headers, are
+ * decoded and measured once. For every font the most recently used
+ * strings are kept, by their encoded bytes, with their text and their
+ * unscaled width. The cache is bound to a single document, and it can
+ * be shared by the text extractions of all its pages
+ * \remarks It's internally synchronized
+ */
+class PDFMM_API PdfTextDecodeCache final
+{
+public:
+    /**
+     * \param capacity the count of strings kept for every font
+     */
+    PdfTextDecodeCache(unsigned capacity = 256);
+
+    ~PdfTextDecodeCache();
+
+    /** Decode the string with the font of the state, and compute its width
+     * \param decoded the decoded text
+     * \param width the width of the string, scaled by the state
+     */
+    void Decode(const PdfString& str, const PdfTextState& state, std::string& decoded, double& width);
+
+    /** Remove the strings of all the fonts
+     */
+    void Clear();
+
+private:
+    PdfTextDecodeCache(const PdfTextDecodeCache&) = delete;
+    PdfTextDecodeCache& operator=(const PdfTextDecodeCache&) = delete;
+
+    struct FontCache;
+
+private:
+    unsigned m_capacity;
+    std::mutex m_mutex;
+    std::unordered_map<const PdfFont*, std::unique_ptr<FontCache>> m_fonts;
+};
+
 struct PdfTextExtractParams
 {
     nullable<PdfRect> ClipRect;
-    PdfTextExtractFlags Flags;
+    PdfTextExtractFlags Flags = PdfTextExtractFlags::None;
+
+    /** Optional cache of the XObject forms, to be shared
+     *  between the extractions of the pages of a document
+     */
+    std::shared_ptr<PdfContentsCache> ContentsCache;
+
+    /** Optional cache of the decoded strings, to be shared between
+     *  the extractions of the pages of a document. If not set, the
+     *  strings are cached during the extraction of a page only
+     */
+    std::shared_ptr<PdfTextDecodeCache> DecodeCache;
+};
+
+struct PdfContentsBoundsParams
+{
+    /** The columns and rows of the coverage grid over the
+     *  page rect. No grid is computed if any is 0
+     */
+    unsigned GridColumns = 0;
+    unsigned GridRows = 0;
+
+    /** Optional cache of the XObject forms, to be shared
+     *  between the computations of the pages of a document
+     */
+    std::shared_ptr<PdfContentsCache> ContentsCache;
+};
+
+/** The extent of the content drawn on a page, as computed by
+ *  PdfPage::ComputeContentsBounds(). All the coordinates are in
+ *  the default user space, with no page rotation applied
+ */
+struct PdfContentsBounds final
+{
+    bool IsEmpty = true;    ///< True if nothing is drawn inside the page rect
+    PdfRect BoundingBox;    ///< Union of the extents of the drawn objects, clipped to the page rect
+    unsigned GridColumns = 0;
+    unsigned GridRows = 0;
+
+    /** The cells of the coverage grid, by rows starting from the bottom
+     *  left corner of the page rect. A cell is true if it intersects
+     *  the extent of some drawn object
+     */
+    std::vector<bool> Grid;
 };
 
 /** PdfPage is one page in the pdf document.
@@ -50,6 +158,8 @@ class PDFMM_API PdfPage final : public PdfDictionaryElement, public PdfCanvas
 {
     PDFMM_UNIT_TEST(PdfPageTest);
     friend class PdfPageCollection;
+    friend class PdfStamper;
+    friend class PdfDocument;
 
 private:
     /** Create a new PdfPage object.
@@ -78,6 +188,25 @@ public:
         const std::string_view& pattern = { },
         const PdfTextExtractParams& params = { }) const;
 
+    /** Extract the text of the page, pushing every entry to the
+     *  handler as soon as it's produced, without accumulating them
+     */
+    void ExtractTextTo(const PdfTextEntryHandler& handler,
+        const PdfTextExtractParams& params) const;
+
+    void ExtractTextTo(const PdfTextEntryHandler& handler,
+        const std::string_view& pattern = { },
+        const PdfTextExtractParams& params = { }) const;
+
+    /** Compute the extent of the content drawn on the page. The
+     *  drawn objects are measured from their geometry, with no
+     *  rasterization: paths, text from the font metrics, images,
+     *  shadings and XObject forms, limited by the clipping paths.
+     *  The extents are the axis aligned boxes of the objects,
+     *  regardless of their color
+     */
+    PdfContentsBounds ComputeContentsBounds(const PdfContentsBoundsParams& params = { }) const;
+
     PdfRect GetRect() const override;
 
     bool HasRotation(double& teta) const override;
@@ -198,6 +327,20 @@ public:
      */
     void DeleteAnnotation(PdfObject& annotObj);
 
+    /** Flatten the annotations of this page into its contents
+     *
+     *  The normal appearances of the annotations are drawn by a single
+     *  content stream appended to the page, and the annotations are
+     *  removed. The existing content streams are not decoded, they are
+     *  just wrapped in a q/Q pair. Annotations without a normal appearance
+     *  are kept, apart from the popups of the flattened ones. Hidden
+     *  annotations are removed without drawing them
+     *  \remarks The form fields of the flattened widgets are not removed,
+     *      use PdfDocument::FlattenAnnotations() to remove them too
+     *  \returns the count of the flattened annotations
+     */
+    unsigned FlattenAnnotations();
+
     /** Method for getting a value that can be inherited
      *  Possible names that can be inherited according to
      *  the PDF specification are: Resources, MediaBox, CropBox and Rotate
@@ -246,11 +389,36 @@ private:
     void EnsureContentsCreated();
     void EnsureResourcesCreated();
 
+    /** Make the resources a direct dictionary of the page, copying
+     *  the inherited or shared ones, together with the dictionaries
+     *  of the resource types, so adding resources to the page
+     *  doesn't modify the objects shared with other pages
+     */
+    void EnsureOwnResources();
+
+    enum class PageBoxType
+    {
+        Media,
+        Crop,
+        Trim,
+        Bleed,
+        Art,
+    };
+
     /** Get the bounds of a specified page box in PDF units.
      * This function is internal, since there are wrappers for all standard boxes
      *  \returns PdfRect the page box
      */
-    PdfRect GetPageBox(const std::string_view& inBox) const;
+    PdfRect GetPageBox(PageBoxType type) const;
+
+    PdfRect computePageBox(PageBoxType type) const;
+
+    struct AttributesCache;
+
+    /** \returns the cache of the inherited attributes, cleared
+     *  if the objects of the document were modified since filling it
+     */
+    AttributesCache& getAttributesCache() const;
 
     /** Method for getting a key value that could be inherited (such as the boxes, resources, etc.)
      *  \returns PdfObject - the result of the key fetching or nullptr
@@ -270,10 +438,22 @@ private:
 private:
     using AnnotationDirectMap = std::map<PdfObject*, PdfAnnotation*>;
 
+    // The effective values of the inherited attributes, resolved
+    // walking up the page tree only once while the document
+    // is not modified. The rotation is after the boxes in the mask
+    struct AttributesCache
+    {
+        uint64_t ModificationCount = 0;
+        unsigned ValidMask = 0;
+        PdfRect Boxes[5];
+        int Rotation = 0;
+    };
+
 private:
     std::unique_ptr<PdfContents> m_Contents;
     std::unique_ptr<PdfResources> m_Resources;
     AnnotationDirectMap m_mapAnnotations;
+    mutable AttributesCache m_Attributes;
 };
 
 };
@@ -23,7 +23,9 @@ using namespace mm;
 
 PdfPageCollection::PdfPageCollection(PdfDocument& doc)
     : PdfDictionaryElement(doc, "Pages"),
-    m_cache(0)
+    m_cache(0),
+    m_hasPageIndices(false),
+    m_maxKidsCount(0)
 {
     GetObject().GetDictionary().AddKey("Kids", PdfArray());
     GetObject().GetDictionary().AddKey("Count", static_cast<int64_t>(0));
@@ -31,7 +33,9 @@ PdfPageCollection::PdfPageCollection(PdfDocument& doc)
 
 PdfPageCollection::PdfPageCollection(PdfObject& pagesRoot)
     : PdfDictionaryElement(pagesRoot),
-    m_cache(GetChildCount(pagesRoot)) { }
+    m_cache(GetChildCount(pagesRoot)),
+    m_hasPageIndices(false),
+    m_maxKidsCount(0) { }
 
 PdfPageCollection::~PdfPageCollection()
 {
@@ -45,6 +49,9 @@ unsigned PdfPageCollection::GetCount() const
 
 PdfPage& PdfPageCollection::GetPage(unsigned index)
 {
+    // Pages are usually processed one by one, so the objects of
+    // the previous pages can be freed here to respect the budget
+    GetDocument().GetObjects().ApplyMemoryBudget();
     if (index >= GetCount())
         PDFMM_RAISE_ERROR(PdfErrorCode::PageNotFound);
 
@@ -53,6 +60,7 @@ PdfPage& PdfPageCollection::GetPage(unsigned index)
 
 const PdfPage& PdfPageCollection::GetPage(unsigned index) const
 {
+    GetDocument().GetObjects().ApplyMemoryBudget();
     if (index >= GetCount())
         PDFMM_RAISE_ERROR(PdfErrorCode::PageNotFound);
 
@@ -71,6 +79,13 @@ PdfPage& PdfPageCollection::getPage(unsigned index)
     PdfObject* pageObj = this->GetPageNode(index, this->GetRoot(), parents);
     if (pageObj != nullptr)
     {
+        // The page references the data of its object and of the parent
+        // nodes, e.g. the resources, so they must not be freed
+        auto& objects = GetDocument().GetObjects();
+        objects.pinObject(*pageObj);
+        for (auto parent : parents)
+            objects.pinObject(*parent);
+
         page = new PdfPage(*pageObj, parents);
         m_cache.SetPage(index, page);
         return *page;
@@ -91,9 +106,24 @@ const PdfPage& PdfPageCollection::GetPage(const PdfReference& ref) const
 
 PdfPage& PdfPageCollection::getPage(const PdfReference& ref)
 {
-    // We have to search through all pages,
-    // as this is the only way
-    // to instantiate the PdfPage with a correct list of parents
+    if (!m_hasPageIndices)
+        buildPageIndices();
+
+    auto found = m_pageIndices.find(ref);
+    if (found == m_pageIndices.end())
+        PDFMM_RAISE_ERROR(PdfErrorCode::PageNotFound);
+
+    if (found->second < this->GetCount())
+    {
+        // The page is instantiated by the index, that is
+        // the only way to get a correct list of parents
+        auto& page = this->getPage(found->second);
+        if (page.GetObject().GetIndirectReference() == ref)
+            return page;
+    }
+
+    // The /Count of the nodes is not consistent with
+    // the tree, search through all pages instead
     for (unsigned i = 0; i < this->GetCount(); i++)
     {
         auto& page = this->getPage(i);
@@ -149,6 +179,8 @@ void PdfPageCollection::InsertPages(unsigned atIndex, const vector<PdfObject*>&
             pagesTree.push_back(&this->GetObject());
             // Use -1 as index to insert before the empty kids array
             InsertPagesIntoNode(this->GetObject(), pagesTree, -1, pages);
+            if (m_maxKidsCount != 0)
+                BalancePageNodes(pagesTree);
         }
     }
     else
@@ -156,9 +188,43 @@ void PdfPageCollection::InsertPages(unsigned atIndex, const vector<PdfObject*>&
         PdfObject* parentNode = parents.back();
         int posInKids = this->GetPosInKids(*pivotPage, parentNode);
         InsertPagesIntoNode(*parentNode, parents, insertAfterPivot ? posInKids : posInKids - 1, pages);
+        if (m_maxKidsCount != 0)
+            BalancePageNodes(parents);
     }
 
     m_cache.InsertPlaceHolders(atIndex, (unsigned)pages.size());
+    if (m_hasPageIndices)
+    {
+        for (auto& pair : m_pageIndices)
+        {
+            if (pair.second >= atIndex)
+                pair.second += (unsigned)pages.size();
+        }
+
+        for (unsigned i = 0; i < pages.size(); i++)
+            m_pageIndices.emplace(pages[i]->GetIndirectReference(), atIndex + i);
+    }
+}
+
+void PdfPageCollection::appendPagesToRoot(const vector<PdfObject*>& pages)
+{
+    auto& root = GetRoot();
+    auto& kids = root.GetDictionary().MustFindKey("Kids").GetArray();
+    unsigned index = this->GetCount();
+    kids.reserve(kids.size() + pages.size());
+    for (auto page : pages)
+    {
+        page->GetDictionary().AddKey("Parent", root.GetIndirectReference());
+        kids.emplace_back(page->GetIndirectReference());
+    }
+
+    root.GetDictionary().AddKey("Count", static_cast<int64_t>(index + pages.size()));
+    m_cache.InsertPlaceHolders(index, (unsigned)pages.size());
+    if (m_hasPageIndices)
+    {
+        for (unsigned i = 0; i < pages.size(); i++)
+            m_pageIndices.emplace(pages[i]->GetIndirectReference(), index + i);
+    }
 }
 
 PdfPage* PdfPageCollection::CreatePage(const PdfRect& size)
@@ -219,6 +285,18 @@ void PdfPageCollection::DeletePage(unsigned atIndex)
         PdfObject* parent = parents.back();
         unsigned kidsIndex = (unsigned)this->GetPosInKids(*pageNode, parent);
         DeletePageFromNode(*parent, parents, kidsIndex, *pageNode);
+        if (m_hasPageIndices)
+        {
+            auto found = m_pageIndices.find(pageNode->GetIndirectReference());
+            if (found != m_pageIndices.end() && found->second == atIndex)
+                m_pageIndices.erase(found);
+
+            for (auto& pair : m_pageIndices)
+            {
+                if (pair.second > atIndex)
+                    pair.second--;
+            }
+        }
     }
     else
     {
@@ -229,6 +307,85 @@ void PdfPageCollection::DeletePage(unsigned atIndex)
     }
 }
 
+void PdfPageCollection::SetMaxKidsCount(unsigned count)
+{
+    // Nodes need at least two kids to be split
+    if (count == 1)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The maximum count of kids must be at least 2");
+
+    m_maxKidsCount = count;
+}
+
+void PdfPageCollection::LoadPages()
+{
+    PdfObjectList parents;
+    m_pageIndices.clear();
+    visitPages(GetRoot(), 0, GetCount(), parents,
+        [&](unsigned index, PdfObject& pageObj, const PdfObjectList& parents)
+        {
+            if (m_cache.GetPage(index) == nullptr)
+                m_cache.SetPage(index, new PdfPage(pageObj, parents));
+
+            m_pageIndices.emplace(pageObj.GetIndirectReference(), index);
+        });
+    m_hasPageIndices = true;
+}
+
+void PdfPageCollection::buildPageIndices()
+{
+    PdfObjectList parents;
+    m_pageIndices.clear();
+    visitPages(GetRoot(), 0, GetCount(), parents,
+        [&](unsigned index, PdfObject& pageObj, const PdfObjectList&)
+        {
+            m_pageIndices.emplace(pageObj.GetIndirectReference(), index);
+        });
+    m_hasPageIndices = true;
+}
+
+void PdfPageCollection::visitPages(PdfObject& node, unsigned index, unsigned count,
+    PdfObjectList& parents, const PageVisitor& visitor)
+{
+    // NOTE: The pages of a subtree are skipped by its /Count,
+    // as in GetPageNode(), and pages exceeding it are ignored
+    auto kidsObj = node.GetDictionary().FindKey("Kids");
+    if (kidsObj == nullptr || !kidsObj->IsArray())
+        return;
+
+    unsigned end = index + count;
+    parents.push_back(&node);
+    for (auto& child : kidsObj->GetArray())
+    {
+        if (index >= end)
+            break;
+
+        if (!child.IsReference())
+            continue;
+
+        PdfObject* childObj = GetRoot().GetDocument()->GetObjects().GetObject(child.GetReference());
+        if (childObj == nullptr || !childObj->IsDictionary())
+            continue;
+
+        if (this->IsTypePages(*childObj))
+        {
+            unsigned childCount = std::min(GetChildCount(*childObj), end - index);
+
+            // Skip cycles in the tree
+            if (std::find(parents.begin(), parents.end(), childObj) == parents.end())
+                visitPages(*childObj, index, childCount, parents, visitor);
+
+            index += childCount;
+        }
+        else if (this->IsTypePage(*childObj))
+        {
+            visitor(index, *childObj, parents);
+            index++;
+        }
+    }
+
+    parents.pop_back();
+}
+
 PdfObject* PdfPageCollection::GetPageNode(unsigned index, PdfObject& parent,
     PdfObjectList& parents)
 {
@@ -401,7 +558,7 @@ void PdfPageCollection::InsertPagesIntoNode(PdfObject& parent, const PdfObjectLi
         {
             for (vector<PdfObject*>::const_iterator itPages = pages.begin(); itPages != pages.end(); itPages++)
             {
-                newKids.Add((*itPages)->GetIndirectReference());    // Push all new kids at once
+                newKids.emplace_back((*itPages)->GetIndirectReference());    // Push all new kids at once
             }
             isPushedIn = true;
         }
@@ -414,7 +571,7 @@ void PdfPageCollection::InsertPagesIntoNode(PdfObject& parent, const PdfObjectLi
     {
         for (vector<PdfObject*>::const_iterator itPages = pages.begin(); itPages != pages.end(); itPages++)
         {
-            newKids.Add((*itPages)->GetIndirectReference());    // Push all new kids at once
+            newKids.emplace_back((*itPages)->GetIndirectReference());    // Push all new kids at once
         }
         isPushedIn = true;
     }
@@ -478,6 +635,97 @@ void PdfPageCollection::DeletePageNode(PdfObject& parent, unsigned index)
     kids.erase(kids.begin() + index);
 }
 
+void PdfPageCollection::BalancePageNodes(PdfObjectList parents)
+{
+    while (parents.size() != 0)
+    {
+        auto& node = *parents.back();
+        const PdfArray& kids = node.GetDictionary().MustFindKey("Kids").GetArray();
+        if (kids.GetSize() <= m_maxKidsCount)
+            return;
+
+        // Split the kids in the least count of even groups
+        unsigned groupCount = (kids.GetSize() + m_maxKidsCount - 1) / m_maxKidsCount;
+        vector<PdfArray> groups(groupCount);
+        unsigned kidIndex = 0;
+        for (unsigned i = 0; i < groupCount; i++)
+        {
+            unsigned groupSize = kids.GetSize() / groupCount + (i < kids.GetSize() % groupCount ? 1 : 0);
+            groups[i].reserve(groupSize);
+            for (unsigned j = 0; j < groupSize; j++)
+                groups[i].Add(kids[kidIndex++]);
+        }
+
+        if (&node == &GetRoot())
+        {
+            // The root can't be replaced, so the groups become
+            // its kids, and the root is checked again
+            PdfArray newKids;
+            newKids.reserve(groupCount);
+            for (auto& group : groups)
+                newKids.emplace_back(CreatePageNode(group, node).GetIndirectReference());
+
+            node.GetDictionary().AddKey("Kids", newKids);
+            continue;
+        }
+
+        // The node keeps the first group, and the other
+        // ones are inserted next to it in the parent
+        parents.pop_back();
+        auto& parent = *parents.back();
+        PdfArray newKids;
+        newKids.reserve(groupCount - 1);
+        for (unsigned i = 1; i < groupCount; i++)
+        {
+            auto& newNode = CreatePageNode(groups[i], parent);
+
+            // The inheritable attributes must be kept by the moved kids
+            for (auto key : { "Resources", "MediaBox", "CropBox", "Rotate" })
+            {
+                auto value = node.GetDictionary().GetKey(key);
+                if (value != nullptr)
+                    newNode.GetDictionary().AddKey(key, *value);
+            }
+
+            newKids.emplace_back(newNode.GetIndirectReference());
+        }
+
+        unsigned count = 0;
+        for (auto& kid : groups[0])
+        {
+            auto kidObj = GetRoot().GetDocument()->GetObjects().GetObject(kid.GetReference());
+            count += kidObj != nullptr && this->IsTypePages(*kidObj) ? GetChildCount(*kidObj) : 1;
+        }
+
+        node.GetDictionary().AddKey("Kids", groups[0]);
+        node.GetDictionary().AddKey("Count", static_cast<int64_t>(count));
+
+        auto& parentKids = parent.GetDictionary().MustFindKey("Kids").GetArray();
+        int posInKids = GetPosInKids(node, &parent);
+        parentKids.insert(parentKids.begin() + posInKids + 1, newKids.begin(), newKids.end());
+    }
+}
+
+PdfObject& PdfPageCollection::CreatePageNode(const PdfArray& kids, const PdfObject& parent)
+{
+    auto& node = *GetRoot().GetDocument()->GetObjects().CreateDictionaryObject("Pages");
+    unsigned count = 0;
+    for (auto& kid : kids)
+    {
+        auto kidObj = GetRoot().GetDocument()->GetObjects().GetObject(kid.GetReference());
+        if (kidObj == nullptr)
+            continue;
+
+        kidObj->GetDictionary().AddKey("Parent", node.GetIndirectReference());
+        count += this->IsTypePages(*kidObj) ? GetChildCount(*kidObj) : 1;
+    }
+
+    node.GetDictionary().AddKey("Kids", kids);
+    node.GetDictionary().AddKey("Count", static_cast<int64_t>(count));
+    node.GetDictionary().AddKey("Parent", parent.GetIndirectReference());
+    return node;
+}
+
 unsigned PdfPageCollection::ChangePagesCount(PdfObject& pageObj, int delta)
 {
     // Increment or decrement inPagesDict's Count by inDelta, and return the new count.
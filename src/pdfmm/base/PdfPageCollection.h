@@ -15,6 +15,8 @@
 #include "PdfArray.h"
 #include "PdfPageTreeCache.h"
 
+#include <unordered_map>
+
 namespace mm {
 
 class PdfObject;
@@ -29,6 +31,7 @@ class PdfRect;
 class PDFMM_API PdfPageCollection final : public PdfDictionaryElement
 {
     friend class PdfDocument;
+    friend class PdfMergeContext;
     using PdfObjectList = std::deque<PdfObject*>;
 
 public:
@@ -85,7 +88,8 @@ public:
      *  The new pages are owned by the pages tree and will get deleted along
      *  with it!
      *  Note: this function will attach all new pages onto the same page node
-     *  which can cause the tree to be unbalanced if
+     *  which can cause the tree to be unbalanced, unless a maximum count
+     *  of kids is set (see SetMaxKidsCount())
      *
      *  \param sizes a vector of PdfRect specifying the size of each of the pages to create (i.e the /MediaBox key) in PDF units
      */
@@ -113,10 +117,41 @@ public:
      */
     void DeletePage(unsigned atIndex);
 
+    /** Instantiate all the pages with a single walk of the tree,
+     *  so the following accesses by index or by reference don't
+     *  walk the tree. Pages already instantiated are kept
+     */
+    void LoadPages();
+
+    /** Set the maximum count of kids of the nodes of the tree. When
+     *  inserting pages, the nodes exceeding it are split like in a
+     *  B-tree, so the tree stays balanced. 0, the default, means
+     *  no limit, that is pages are just added to the existing nodes
+     */
+    void SetMaxKidsCount(unsigned count);
+
+public:
+    inline unsigned GetMaxKidsCount() const { return m_maxKidsCount; }
+
 private:
     PdfPage& getPage(unsigned index);
     PdfPage& getPage(const PdfReference& ref);
 
+    /** Build the index of the pages by their reference, with
+     *  a single walk of the tree
+     */
+    void buildPageIndices();
+
+    using PageVisitor = std::function<void(unsigned index, PdfObject& pageObj, const PdfObjectList& parents)>;
+
+    /** Visit the pages of the subtree of the node, with the same
+     *  indices given by GetPageNode()
+     * \param index the index of the first page of the subtree
+     * \param count the count of the pages of the subtree, as in /Count
+     */
+    void visitPages(PdfObject& node, unsigned index, unsigned count,
+        PdfObjectList& parents, const PageVisitor& visitor);
+
     /**
      * Insert page at the given index
      * \remarks Can be used by PdfDocument
@@ -170,6 +205,13 @@ private:
     void InsertPagesIntoNode(PdfObject& node, const PdfObjectList& parents,
         int index, const std::vector<PdfObject*>& pages);
 
+    /**
+     * Append page objects to the kids of the root node, without walking
+     * the tree, so the pages already inserted may be written and freed.
+     * The maximum count of kids of the nodes is not respected
+     */
+    void appendPagesToRoot(const std::vector<PdfObject*>& pages);
+
     /**
      * Delete a page object from a pages node
      *
@@ -190,6 +232,20 @@ private:
      */
     void DeletePageNode(PdfObject& parent, unsigned index);
 
+    /**
+     * Split the nodes with more kids than the maximum, from the last
+     * node of parents up to the root
+     *
+     * \param parents list of the pages nodes, the last being the node
+     *                where pages were inserted
+     */
+    void BalancePageNodes(PdfObjectList parents);
+
+    /**
+     * Create a pages node with the given kids, updating their parent
+     */
+    PdfObject& CreatePageNode(const PdfArray& kids, const PdfObject& parent);
+
     /**
      * Tests if a page node is emtpy
      *
@@ -204,6 +260,12 @@ private:
 
 private:
       PdfPageTreeCache m_cache;
+      // Index of the pages by their reference, built on the first
+      // lookup by reference and kept updated when pages are
+      // inserted or deleted
+      std::unordered_map<PdfReference, unsigned> m_pageIndices;
+      bool m_hasPageIndices;
+      unsigned m_maxKidsCount;
 };
 
 };
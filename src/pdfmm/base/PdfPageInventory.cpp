@@ -0,0 +1,316 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfPageInventory.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "PdfArray.h"
+#include "PdfContentsReader.h"
+#include "PdfDictionary.h"
+#include "PdfDocument.h"
+#include "PdfObjectStream.h"
+#include "PdfPage.h"
+#include "PdfResources.h"
+#include "PdfStreamDevice.h"
+
+using namespace std;
+using namespace mm;
+
+static void readImage(const PdfObject& obj, PdfInventoryImage& image);
+static void readFont(const PdfObject& obj, PdfInventoryFont& font);
+static const PdfObject* findResource(const PdfDictionary* resources, const string_view& type, const string_view& name);
+static bool isSubsetName(const string_view& name);
+
+PdfPageInventory::PdfPageInventory(const PdfPage& page, PdfPageInventoryFlags flags)
+{
+    collect(page, flags);
+}
+
+void PdfPageInventory::collect(const PdfPage& page, PdfPageInventoryFlags flags)
+{
+    // The forms are walked with their resources, or with the
+    // resources of the canvas drawing them if they have none
+    struct Canvas
+    {
+        const PdfObject* Form;
+        const PdfDictionary* Resources;
+    };
+
+    auto pageResources = page.GetResources();
+    vector<Canvas> stack;
+    stack.push_back({ nullptr, pageResources == nullptr ? nullptr : &pageResources->GetDictionary() });
+    unordered_set<const PdfObject*> visited;
+    vector<const PdfObject*> forms;
+    while (stack.size() != 0)
+    {
+        auto canvas = stack.back();
+        stack.pop_back();
+        forms.clear();
+        if (canvas.Resources != nullptr)
+            collectResources(*canvas.Resources, forms);
+
+        if ((flags & PdfPageInventoryFlags::SkipContents) == PdfPageInventoryFlags::None)
+            readContents(canvas.Form == nullptr ? &page : nullptr, canvas.Form, canvas.Resources);
+
+        // Push the forms reversed, so they are walked in order
+        for (auto it = forms.rbegin(); it != forms.rend(); it++)
+        {
+            if (!visited.insert(*it).second)
+                continue;
+
+            auto resources = (*it)->GetDictionary().FindKey("Resources");
+            stack.push_back({ *it, resources != nullptr && resources->IsDictionary()
+                ? &resources->GetDictionary() : canvas.Resources });
+        }
+    }
+
+    m_imageIndices.clear();
+    m_fontIndices.clear();
+    if ((flags & PdfPageInventoryFlags::UsedOnly) != PdfPageInventoryFlags::None)
+    {
+        m_images.erase(std::remove_if(m_images.begin(), m_images.end(),
+            [](const PdfInventoryImage& image) { return image.UseCount == 0; }), m_images.end());
+        m_fonts.erase(std::remove_if(m_fonts.begin(), m_fonts.end(),
+            [](const PdfInventoryFont& font) { return font.UseCount == 0; }), m_fonts.end());
+    }
+}
+
+void PdfPageInventory::collectResources(const PdfDictionary& resources, vector<const PdfObject*>& forms)
+{
+    auto xobjects = resources.FindKey("XObject");
+    if (xobjects != nullptr && xobjects->IsDictionary())
+    {
+        for (auto& pair : xobjects->GetDictionary().GetIndirectIterator())
+        {
+            if (pair.second == nullptr || !pair.second->IsDictionary())
+                continue;
+
+            auto subtype = pair.second->GetDictionary().FindKeyAs<PdfName>(PdfName::KeySubtype);
+            if (subtype == "Form")
+            {
+                forms.push_back(pair.second);
+            }
+            else if (subtype == "Image" && m_imageIndices.find(pair.second) == m_imageIndices.end())
+            {
+                m_imageIndices[pair.second] = (unsigned)m_images.size();
+                auto& image = m_images.emplace_back();
+                image.Name = pair.first;
+                readImage(*pair.second, image);
+            }
+        }
+    }
+
+    auto fonts = resources.FindKey("Font");
+    if (fonts != nullptr && fonts->IsDictionary())
+    {
+        for (auto& pair : fonts->GetDictionary().GetIndirectIterator())
+        {
+            if (pair.second == nullptr || !pair.second->IsDictionary()
+                || m_fontIndices.find(pair.second) != m_fontIndices.end())
+            {
+                continue;
+            }
+
+            m_fontIndices[pair.second] = (unsigned)m_fonts.size();
+            auto& font = m_fonts.emplace_back();
+            font.Name = pair.first;
+            readFont(*pair.second, font);
+        }
+    }
+}
+
+void PdfPageInventory::readContents(const PdfPage* page, const PdfObject* form, const PdfDictionary* resources)
+{
+    unique_ptr<PdfContentsReader> reader;
+    charbuff buffer;
+    if (page != nullptr)
+    {
+        reader.reset(new PdfContentsReader(*page));
+    }
+    else
+    {
+        auto stream = form->GetStream();
+        if (stream == nullptr)
+            return;
+
+        stream->ExtractTo(buffer);
+        reader.reset(new PdfContentsReader(std::make_shared<SpanStreamDevice>(buffer)));
+    }
+
+    PdfRawContent content;
+    while (reader->TryReadNextRaw(content))
+    {
+        if (content.Type != PdfContentType::Operator)
+            continue;
+
+        // The name is the first of the expected operands, which
+        // are the last ones if there is spurious content
+        size_t count = content.Operands.size();
+        if (content.Operator == PdfOperator::Do && count >= 1
+            && content.Operands[count - 1].Type == PdfRawOperandType::Name)
+        {
+            auto image = findImage(findResource(resources, "XObject", content.Operands[count - 1].Data));
+            if (image != nullptr)
+                image->UseCount++;
+        }
+        else if (content.Operator == PdfOperator::Tf && count >= 2
+            && content.Operands[count - 2].Type == PdfRawOperandType::Name)
+        {
+            auto font = findFont(findResource(resources, "Font", content.Operands[count - 2].Data));
+            if (font != nullptr)
+                font->UseCount++;
+        }
+    }
+}
+
+PdfInventoryImage* PdfPageInventory::findImage(const PdfObject* obj)
+{
+    auto found = m_imageIndices.find(obj);
+    if (found == m_imageIndices.end())
+        return nullptr;
+
+    return &m_images[found->second];
+}
+
+PdfInventoryFont* PdfPageInventory::findFont(const PdfObject* obj)
+{
+    auto found = m_fontIndices.find(obj);
+    if (found == m_fontIndices.end())
+        return nullptr;
+
+    return &m_fonts[found->second];
+}
+
+void readImage(const PdfObject& obj, PdfInventoryImage& image)
+{
+    auto& dict = obj.GetDictionary();
+    image.Reference = obj.GetIndirectReference();
+    image.Width = (unsigned)dict.FindKeyAs<int64_t>("Width", 0);
+    image.Height = (unsigned)dict.FindKeyAs<int64_t>("Height", 0);
+    image.IsImageMask = dict.FindKeyAs<bool>("ImageMask", false);
+    image.BitsPerComponent = image.IsImageMask ? 1 : (unsigned)dict.FindKeyAs<int64_t>("BitsPerComponent", 0);
+    image.HasSoftMask = dict.HasKey("SMask");
+
+    auto colorSpace = dict.FindKey("ColorSpace");
+    const PdfName* name;
+    if (colorSpace != nullptr)
+    {
+        if (colorSpace->TryGetName(name))
+            image.ColorSpace = *name;
+        else if (colorSpace->IsArray() && colorSpace->GetArray().GetSize() != 0
+            && colorSpace->GetArray().FindAt(0).TryGetName(name))
+        {
+            image.ColorSpace = *name;
+        }
+    }
+
+    // NOTE: The filters are read from the
+    // dictionary, the stream is not decoded
+    image.Filters = PdfFilterFactory::CreateFilterList(obj);
+}
+
+void readFont(const PdfObject& obj, PdfInventoryFont& font)
+{
+    auto& dict = obj.GetDictionary();
+    font.Reference = obj.GetIndirectReference();
+    font.BaseFont = dict.FindKeyAs<PdfName>("BaseFont").GetString();
+    font.IsSubset = isSubsetName(font.BaseFont);
+
+    // The font descriptor of the composite fonts is in the descendant font
+    auto subtype = dict.FindKeyAs<PdfName>(PdfName::KeySubtype);
+    const PdfDictionary* descriptorOwner = &dict;
+    if (subtype == "Type0")
+    {
+        auto descendants = dict.FindKey("DescendantFonts");
+        if (descendants == nullptr || !descendants->IsArray() || descendants->GetArray().GetSize() == 0
+            || !descendants->GetArray().FindAt(0).IsDictionary())
+        {
+            return;
+        }
+
+        descriptorOwner = &descendants->GetArray().FindAt(0).GetDictionary();
+        subtype = descriptorOwner->FindKeyAs<PdfName>(PdfName::KeySubtype);
+        if (subtype == "CIDFontType0")
+            font.Type = PdfFontType::CIDType1;
+        else if (subtype == "CIDFontType2")
+            font.Type = PdfFontType::CIDTrueType;
+    }
+    else if (subtype == "Type1" || subtype == "MMType1")
+    {
+        font.Type = PdfFontType::Type1;
+    }
+    else if (subtype == "TrueType")
+    {
+        font.Type = PdfFontType::TrueType;
+    }
+    else if (subtype == "Type3")
+    {
+        // The glyphs of Type3 fonts are always in the document
+        font.Type = PdfFontType::Type3;
+        font.FontFileType = PdfFontFileType::Type3;
+        font.IsEmbedded = true;
+        return;
+    }
+
+    auto descriptor = descriptorOwner->FindKey("FontDescriptor");
+    if (descriptor == nullptr || !descriptor->IsDictionary())
+        return;
+
+    auto& descriptorDict = descriptor->GetDictionary();
+    const PdfObject* fontFile;
+    if (descriptorDict.HasKey("FontFile"))
+    {
+        font.FontFileType = PdfFontFileType::Type1;
+        font.IsEmbedded = true;
+    }
+    else if (descriptorDict.HasKey("FontFile2"))
+    {
+        font.FontFileType = PdfFontFileType::TrueType;
+        font.IsEmbedded = true;
+    }
+    else if ((fontFile = descriptorDict.FindKey("FontFile3")) != nullptr && fontFile->IsDictionary())
+    {
+        font.IsEmbedded = true;
+        auto fontFileSubtype = fontFile->GetDictionary().FindKeyAs<PdfName>(PdfName::KeySubtype);
+        if (fontFileSubtype == "Type1C")
+            font.FontFileType = PdfFontFileType::Type1CCF;
+        else if (fontFileSubtype == "CIDFontType0C")
+            font.FontFileType = PdfFontFileType::CIDType1;
+        else if (fontFileSubtype == "OpenType")
+            font.FontFileType = PdfFontFileType::OpenType;
+    }
+}
+
+const PdfObject* findResource(const PdfDictionary* resources, const string_view& type, const string_view& name)
+{
+    if (resources == nullptr)
+        return nullptr;
+
+    auto typeDict = resources->FindKey(type);
+    if (typeDict == nullptr || !typeDict->IsDictionary())
+        return nullptr;
+
+    return typeDict->GetDictionary().FindKey(name);
+}
+
+// The subset fonts have a tag of 6 uppercase letters and "+"
+bool isSubsetName(const string_view& name)
+{
+    if (name.length() < 7 || name[6] != '+')
+        return false;
+
+    for (unsigned i = 0; i < 6; i++)
+    {
+        if (name[i] < 'A' || name[i] > 'Z')
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,104 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_PAGE_INVENTORY_H
+#define PDF_PAGE_INVENTORY_H
+
+#include "PdfDeclarations.h"
+#include "PdfFilter.h"
+#include "PdfName.h"
+#include "PdfReference.h"
+
+#include <unordered_map>
+
+namespace mm {
+
+class PdfDictionary;
+class PdfObject;
+class PdfPage;
+
+enum class PdfPageInventoryFlags
+{
+    None = 0,
+    SkipContents = 1,   ///< Don't read the content streams, the use counts are zero
+    UsedOnly = 2,       ///< Omit the images and the fonts not used by the content streams
+};
+
+/** An image in the resources of a page
+ */
+struct PDFMM_API PdfInventoryImage
+{
+    PdfReference Reference;
+    PdfName Name;               ///< The name of the image in the first resources found
+    unsigned Width = 0;
+    unsigned Height = 0;
+    unsigned BitsPerComponent = 0;
+    PdfName ColorSpace;         ///< The name of the color space, or of its family
+    PdfFilterList Filters;
+    bool IsImageMask = false;
+    bool HasSoftMask = false;
+    unsigned UseCount = 0;      ///< The count of the Do operators drawing the image
+};
+
+/** A font in the resources of a page
+ */
+struct PDFMM_API PdfInventoryFont
+{
+    PdfReference Reference;
+    PdfName Name;               ///< The name of the font in the first resources found
+    std::string BaseFont;       ///< The /BaseFont, with the subset prefix if any
+    PdfFontType Type = PdfFontType::Unknown;
+    PdfFontFileType FontFileType = PdfFontFileType::Unknown; ///< The type of the embedded font program
+    bool IsEmbedded = false;
+    bool IsSubset = false;
+    unsigned UseCount = 0;      ///< The count of the Tf operators selecting the font
+};
+
+/**
+ * Collect the images and the fonts used by a page straight from the
+ * dictionaries, without creating PdfImage or PdfFont instances
+ *
+ * The resources of the page and of the XObject forms they contain are
+ * walked, every image and font is listed once, and the content streams
+ * of the page and of the forms are scanned for the Do and Tf operators
+ * with PdfContentsReader::TryReadNextRaw(). The content of a form is
+ * scanned once, however many times it's drawn. The images and the font
+ * programs are neither decoded nor loaded
+ */
+class PDFMM_API PdfPageInventory final
+{
+public:
+    PdfPageInventory(const PdfPage& page, PdfPageInventoryFlags flags = PdfPageInventoryFlags::None);
+
+public:
+    /** \returns the images, in the order they are found
+     */
+    inline const std::vector<PdfInventoryImage>& GetImages() const { return m_images; }
+
+    /** \returns the fonts, in the order they are found
+     */
+    inline const std::vector<PdfInventoryFont>& GetFonts() const { return m_fonts; }
+
+private:
+    void collect(const PdfPage& page, PdfPageInventoryFlags flags);
+    void collectResources(const PdfDictionary& resources, std::vector<const PdfObject*>& forms);
+    void readContents(const PdfPage* page, const PdfObject* form, const PdfDictionary* resources);
+    PdfInventoryImage* findImage(const PdfObject* obj);
+    PdfInventoryFont* findFont(const PdfObject* obj);
+
+private:
+    std::vector<PdfInventoryImage> m_images;
+    std::vector<PdfInventoryFont> m_fonts;
+    std::unordered_map<const PdfObject*, unsigned> m_imageIndices;
+    std::unordered_map<const PdfObject*, unsigned> m_fontIndices;
+};
+
+};
+
+ENABLE_BITMASK_OPERATORS(mm::PdfPageInventoryFlags);
+
+#endif // PDF_PAGE_INVENTORY_H
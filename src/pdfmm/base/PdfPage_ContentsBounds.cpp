@@ -0,0 +1,631 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfPage.h"
+
+#include "PdfDocument.h"
+#include "PdfTextState.h"
+#include "PdfMath.h"
+#include "PdfXObjectForm.h"
+#include "PdfContentsReader.h"
+#include "PdfFont.h"
+
+using namespace std;
+using namespace mm;
+
+static constexpr double Infinity = numeric_limits<double>::infinity();
+
+// An axis aligned box in the default user space
+struct BoundsBox
+{
+    double Left = Infinity;
+    double Bottom = Infinity;
+    double Right = -Infinity;
+    double Top = -Infinity;
+
+    bool IsEmpty() const;
+    void Add(const Vector2& point);
+    void Add(const BoundsBox& box);
+    void Intersect(const BoundsBox& box);
+    void Grow(double amount);
+};
+
+struct GraphicsState
+{
+    Matrix CTM;
+    BoundsBox Clip;
+    double LineWidth = 1;
+    PdfTextState TextState;
+    double Leading = 0;
+    double Rise = 0;
+};
+
+struct FormState
+{
+    const PdfCanvas* Canvas;
+    size_t StateCount;      // Count of the states before the form
+};
+
+struct BoundsContext
+{
+public:
+    BoundsContext(const PdfPage& page, const PdfContentsBoundsParams& params);
+public:
+    void Paint(BoundsBox box, bool stroke = false);
+    void PaintUnitSquare();
+    void AddPathPoint(double x, double y);
+    void EndPath();
+    void ShowText(const PdfString& str);
+    void AdvanceText(double tx);
+    void NextLine(double tx, double ty);
+    void BeginForm(const PdfXObjectForm& form);
+    void EndForm();
+    void SetFont(const PdfName& name, double size);
+    PdfContentsBounds GetResult();
+    GraphicsState& Current() { return States.back(); }
+private:
+    void markGrid(const BoundsBox& box);
+    double getStrokeExpansion();
+private:
+    const PdfPage& m_page;
+public:
+    vector<GraphicsState> States;
+    vector<FormState> Forms;
+    Matrix T_m;     // The text matrices are not part of the graphics state
+    Matrix T_lm;
+    BoundsBox Path;
+    bool ClipPending = false;
+private:
+    PdfRect m_pageRect;
+    BoundsBox m_bounds;
+    PdfContentsBounds m_result;
+};
+
+static bool tryRead(const PdfVariantStack& stack, double* values, unsigned count);
+
+PdfContentsBounds PdfPage::ComputeContentsBounds(const PdfContentsBoundsParams& params) const
+{
+    BoundsContext context(*this, params);
+
+    PdfContentReaderArgs args;
+    args.Cache = params.ContentsCache;
+    PdfContentsReader reader(*this, args);
+    PdfContent content;
+    double values[6];
+    while (reader.TryReadNext(content))
+    {
+        switch (content.Type)
+        {
+            case PdfContentType::Operator:
+            {
+                if ((content.Warnings & PdfContentWarnings::InvalidOperator)
+                    != PdfContentWarnings::None)
+                {
+                    // Ignore invalid operators
+                    continue;
+                }
+
+                auto& state = context.Current();
+                switch (content.Operator)
+                {
+                    case PdfOperator::q:
+                    {
+                        context.States.push_back(state);
+                        break;
+                    }
+                    case PdfOperator::Q:
+                    {
+                        // Don't restore states saved outside the current form
+                        if (context.States.size() > context.Forms.back().StateCount + 1)
+                            context.States.pop_back();
+                        break;
+                    }
+                    case PdfOperator::cm:
+                    {
+                        if (tryRead(content.Stack, values, 6))
+                            state.CTM = Matrix::FromArray(values) * state.CTM;
+                        break;
+                    }
+                    case PdfOperator::w:
+                    {
+                        if (tryRead(content.Stack, values, 1))
+                            state.LineWidth = values[0];
+                        break;
+                    }
+                    case PdfOperator::m:
+                    case PdfOperator::l:
+                    {
+                        if (tryRead(content.Stack, values, 2))
+                            context.AddPathPoint(values[0], values[1]);
+                        break;
+                    }
+                    case PdfOperator::c:
+                    {
+                        // The curve lies inside the hull of its control points
+                        if (tryRead(content.Stack, values, 6))
+                        {
+                            context.AddPathPoint(values[0], values[1]);
+                            context.AddPathPoint(values[2], values[3]);
+                            context.AddPathPoint(values[4], values[5]);
+                        }
+                        break;
+                    }
+                    case PdfOperator::v:
+                    case PdfOperator::y:
+                    {
+                        if (tryRead(content.Stack, values, 4))
+                        {
+                            context.AddPathPoint(values[0], values[1]);
+                            context.AddPathPoint(values[2], values[3]);
+                        }
+                        break;
+                    }
+                    case PdfOperator::re:
+                    {
+                        if (tryRead(content.Stack, values, 4))
+                        {
+                            context.AddPathPoint(values[0], values[1]);
+                            context.AddPathPoint(values[0] + values[2], values[1]);
+                            context.AddPathPoint(values[0], values[1] + values[3]);
+                            context.AddPathPoint(values[0] + values[2], values[1] + values[3]);
+                        }
+                        break;
+                    }
+                    case PdfOperator::W:
+                    case PdfOperator::W_Star:
+                    {
+                        // The clipping path is applied by the
+                        // next painting operator
+                        context.ClipPending = true;
+                        break;
+                    }
+                    case PdfOperator::S:
+                    case PdfOperator::s:
+                    case PdfOperator::B:
+                    case PdfOperator::B_Star:
+                    case PdfOperator::b:
+                    case PdfOperator::b_Star:
+                    {
+                        context.Paint(context.Path, true);
+                        context.EndPath();
+                        break;
+                    }
+                    case PdfOperator::f:
+                    case PdfOperator::F:
+                    case PdfOperator::f_Star:
+                    {
+                        context.Paint(context.Path);
+                        context.EndPath();
+                        break;
+                    }
+                    case PdfOperator::n:
+                    {
+                        context.EndPath();
+                        break;
+                    }
+                    case PdfOperator::sh:
+                    {
+                        // The shading fills the current clipping region
+                        context.Paint(state.Clip);
+                        break;
+                    }
+                    case PdfOperator::BT:
+                    {
+                        context.T_m = Matrix();
+                        context.T_lm = Matrix();
+                        break;
+                    }
+                    case PdfOperator::Tc:
+                    {
+                        if (tryRead(content.Stack, values, 1))
+                            state.TextState.CharSpacing = values[0];
+                        break;
+                    }
+                    case PdfOperator::Tw:
+                    {
+                        if (tryRead(content.Stack, values, 1))
+                            state.TextState.WordSpacing = values[0];
+                        break;
+                    }
+                    case PdfOperator::Tz:
+                    {
+                        if (tryRead(content.Stack, values, 1))
+                            state.TextState.FontScale = values[0] / 100;
+                        break;
+                    }
+                    case PdfOperator::TL:
+                    {
+                        if (tryRead(content.Stack, values, 1))
+                            state.Leading = values[0];
+                        break;
+                    }
+                    case PdfOperator::Tf:
+                    {
+                        const PdfName* name;
+                        if (content.Stack[1].TryGetName(name) && content.Stack[0].TryGetReal(values[0]))
+                            context.SetFont(*name, values[0]);
+                        break;
+                    }
+                    case PdfOperator::Tr:
+                    {
+                        if (tryRead(content.Stack, values, 1))
+                            state.TextState.RenderingMode = (PdfTextRenderingMode)((int)values[0] + 1);
+                        break;
+                    }
+                    case PdfOperator::Ts:
+                    {
+                        if (tryRead(content.Stack, values, 1))
+                            state.Rise = values[0];
+                        break;
+                    }
+                    case PdfOperator::Td:
+                    case PdfOperator::TD:
+                    {
+                        if (tryRead(content.Stack, values, 2))
+                        {
+                            if (content.Operator == PdfOperator::TD)
+                                state.Leading = -values[1];
+
+                            context.NextLine(values[0], values[1]);
+                        }
+                        break;
+                    }
+                    case PdfOperator::Tm:
+                    {
+                        if (tryRead(content.Stack, values, 6))
+                        {
+                            context.T_lm = Matrix::FromArray(values);
+                            context.T_m = context.T_lm;
+                        }
+                        break;
+                    }
+                    case PdfOperator::T_Star:
+                    {
+                        context.NextLine(0, -state.Leading);
+                        break;
+                    }
+                    case PdfOperator::Tj:
+                    case PdfOperator::Quote:
+                    case PdfOperator::DoubleQuote:
+                    {
+                        const PdfString* str;
+                        if (!content.Stack[0].TryGetString(str))
+                            break;
+
+                        if (content.Operator == PdfOperator::DoubleQuote)
+                        {
+                            // Operator " arguments: aw ac string "
+                            (void)content.Stack[2].TryGetReal(state.TextState.WordSpacing);
+                            (void)content.Stack[1].TryGetReal(state.TextState.CharSpacing);
+                        }
+
+                        if (content.Operator != PdfOperator::Tj)
+                            context.NextLine(0, -state.Leading);
+
+                        context.ShowText(*str);
+                        break;
+                    }
+                    case PdfOperator::TJ:
+                    {
+                        const PdfArray* array;
+                        if (!content.Stack[0].TryGetArray(array))
+                            break;
+
+                        for (auto& obj : *array)
+                        {
+                            const PdfString* str;
+                            if (obj.TryGetString(str))
+                            {
+                                context.ShowText(*str);
+                            }
+                            else if (obj.TryGetReal(values[0]))
+                            {
+                                // The number is expressed in thousandths of a unit of text space
+                                context.AdvanceText(-values[0] / 1000 * state.TextState.FontSize * state.TextState.FontScale);
+                            }
+                        }
+                        break;
+                    }
+                    default:
+                    {
+                        // Ignore all the other operators
+                        break;
+                    }
+                }
+
+                break;
+            }
+            case PdfContentType::ImageDictionary:
+            {
+                // Images are drawn in the unit square
+                context.PaintUnitSquare();
+                break;
+            }
+            case PdfContentType::DoXObject:
+            {
+                if (content.XObject->GetType() == PdfXObjectType::Image)
+                {
+                    context.PaintUnitSquare();
+                }
+                else if (content.XObject->GetType() == PdfXObjectType::Form
+                    && (content.Warnings & PdfContentWarnings::RecursiveXObject) == PdfContentWarnings::None)
+                {
+                    // The form content follows
+                    context.BeginForm(static_cast<const PdfXObjectForm&>(*content.XObject));
+                }
+
+                break;
+            }
+            case PdfContentType::EndXObjectForm:
+            {
+                context.EndForm();
+                break;
+            }
+            default:
+            {
+                // Ignore the other contents
+                break;
+            }
+        }
+    }
+
+    return context.GetResult();
+}
+
+BoundsContext::BoundsContext(const PdfPage& page, const PdfContentsBoundsParams& params)
+    : m_page(page), m_pageRect(page.GetRect())
+{
+    GraphicsState state;
+    state.Clip.Add(Vector2(m_pageRect.GetLeft(), m_pageRect.GetBottom()));
+    state.Clip.Add(Vector2(m_pageRect.GetRight(), m_pageRect.GetTop()));
+    States.push_back(state);
+    Forms.push_back({ &page, 0 });
+
+    if (params.GridColumns != 0 && params.GridRows != 0)
+    {
+        m_result.GridColumns = params.GridColumns;
+        m_result.GridRows = params.GridRows;
+        m_result.Grid.resize((size_t)params.GridColumns * params.GridRows);
+    }
+}
+
+void BoundsContext::Paint(BoundsBox box, bool stroke)
+{
+    if (stroke)
+        box.Grow(getStrokeExpansion());
+
+    box.Intersect(Current().Clip);
+    if (box.IsEmpty())
+        return;
+
+    m_bounds.Add(box);
+    markGrid(box);
+}
+
+void BoundsContext::PaintUnitSquare()
+{
+    auto& ctm = Current().CTM;
+    BoundsBox box;
+    box.Add(Vector2(0, 0) * ctm);
+    box.Add(Vector2(1, 0) * ctm);
+    box.Add(Vector2(0, 1) * ctm);
+    box.Add(Vector2(1, 1) * ctm);
+    Paint(box);
+}
+
+void BoundsContext::AddPathPoint(double x, double y)
+{
+    Path.Add(Vector2(x, y) * Current().CTM);
+}
+
+void BoundsContext::EndPath()
+{
+    if (ClipPending)
+    {
+        Current().Clip.Intersect(Path);
+        ClipPending = false;
+    }
+
+    Path = { };
+}
+
+void BoundsContext::ShowText(const PdfString& str)
+{
+    auto& state = Current();
+    auto& textState = state.TextState;
+    double width;
+    double ascent;
+    double descent;
+    if (textState.Font == nullptr)
+    {
+        // Without metrics, assume the glyphs as wide
+        // as half the font size, and as tall as it
+        width = str.GetRawData().size() * textState.FontSize * textState.FontScale / 2;
+        ascent = textState.FontSize;
+        descent = 0;
+    }
+    else
+    {
+        width = textState.Font->GetStringWidth(str, textState);
+        ascent = textState.Font->GetAscent(textState);
+        descent = textState.Font->GetDescent(textState);
+        if (ascent <= descent)
+        {
+            ascent = textState.FontSize;
+            descent = 0;
+        }
+    }
+
+    if (textState.RenderingMode != PdfTextRenderingMode::Invisible
+        && textState.RenderingMode != PdfTextRenderingMode::AddToClipPath)
+    {
+        auto m = T_m * state.CTM;
+        BoundsBox box;
+        box.Add(Vector2(0, descent + state.Rise) * m);
+        box.Add(Vector2(width, descent + state.Rise) * m);
+        box.Add(Vector2(0, ascent + state.Rise) * m);
+        box.Add(Vector2(width, ascent + state.Rise) * m);
+        Paint(box);
+    }
+
+    AdvanceText(width);
+}
+
+void BoundsContext::AdvanceText(double tx)
+{
+    T_m = Matrix::CreateTranslation(Vector2(tx, 0)) * T_m;
+}
+
+void BoundsContext::NextLine(double tx, double ty)
+{
+    T_lm = Matrix::CreateTranslation(Vector2(tx, ty)) * T_lm;
+    T_m = T_lm;
+}
+
+void BoundsContext::BeginForm(const PdfXObjectForm& form)
+{
+    Forms.push_back({ &form, States.size() });
+    States.push_back(Current());
+    auto& state = Current();
+    state.CTM = form.GetMatrix() * state.CTM;
+
+    // The form is clipped by its bounding box
+    auto rect = form.GetRect();
+    BoundsBox bbox;
+    bbox.Add(Vector2(rect.GetLeft(), rect.GetBottom()) * state.CTM);
+    bbox.Add(Vector2(rect.GetRight(), rect.GetBottom()) * state.CTM);
+    bbox.Add(Vector2(rect.GetLeft(), rect.GetTop()) * state.CTM);
+    bbox.Add(Vector2(rect.GetRight(), rect.GetTop()) * state.CTM);
+    state.Clip.Intersect(bbox);
+}
+
+void BoundsContext::EndForm()
+{
+    PDFMM_ASSERT(Forms.size() > 1);
+    States.resize(Forms.back().StateCount);
+    Forms.pop_back();
+}
+
+void BoundsContext::SetFont(const PdfName& name, double size)
+{
+    auto& textState = Current().TextState;
+    textState.FontSize = size;
+    auto fontObj = Forms.back().Canvas->GetFromResources("Font", name);
+    if (fontObj == nullptr || (textState.Font = m_page.GetDocument().GetFontManager().GetLoadedFont(*fontObj)) == nullptr)
+    {
+        mm::LogMessage(PdfLogSeverity::Warning, "Unable to find font object {}", name.GetString());
+        textState.Font = nullptr;
+    }
+}
+
+PdfContentsBounds BoundsContext::GetResult()
+{
+    if (!m_bounds.IsEmpty())
+    {
+        m_result.IsEmpty = false;
+        m_result.BoundingBox = PdfRect::FromCorners(m_bounds.Left, m_bounds.Bottom, m_bounds.Right, m_bounds.Top);
+    }
+
+    return std::move(m_result);
+}
+
+void BoundsContext::markGrid(const BoundsBox& box)
+{
+    if (m_result.Grid.size() == 0)
+        return;
+
+    double cellWidth = m_pageRect.GetWidth() / m_result.GridColumns;
+    double cellHeight = m_pageRect.GetHeight() / m_result.GridRows;
+    // The cells just touched by the right or top edge are not covered
+    auto getCell = [](double offset, double cellSize, unsigned count, bool upperEdge)
+    {
+        double cell = upperEdge ? std::ceil(offset / cellSize) - 1 : std::floor(offset / cellSize);
+        if (cell < 0)
+            return 0u;
+        else if (cell >= count)
+            return count - 1;
+        else
+            return (unsigned)cell;
+    };
+
+    unsigned left = getCell(box.Left - m_pageRect.GetLeft(), cellWidth, m_result.GridColumns, false);
+    unsigned right = std::max(left, getCell(box.Right - m_pageRect.GetLeft(), cellWidth, m_result.GridColumns, true));
+    unsigned bottom = getCell(box.Bottom - m_pageRect.GetBottom(), cellHeight, m_result.GridRows, false);
+    unsigned top = std::max(bottom, getCell(box.Top - m_pageRect.GetBottom(), cellHeight, m_result.GridRows, true));
+    for (unsigned row = bottom; row <= top; row++)
+    {
+        for (unsigned col = left; col <= right; col++)
+            m_result.Grid[(size_t)row * m_result.GridColumns + col] = true;
+    }
+}
+
+double BoundsContext::getStrokeExpansion()
+{
+    // Half the line width, scaled by the largest scale of the
+    // CTM. Miter joins may exceed it, approximate it anyway
+    auto& state = Current();
+    auto& ctm = state.CTM;
+    double scale = std::max(std::sqrt(ctm[0] * ctm[0] + ctm[1] * ctm[1]),
+        std::sqrt(ctm[2] * ctm[2] + ctm[3] * ctm[3]));
+    return std::abs(state.LineWidth) / 2 * scale;
+}
+
+bool BoundsBox::IsEmpty() const
+{
+    return Left > Right || Bottom > Top;
+}
+
+void BoundsBox::Add(const Vector2& point)
+{
+    Left = std::min(Left, point.X);
+    Bottom = std::min(Bottom, point.Y);
+    Right = std::max(Right, point.X);
+    Top = std::max(Top, point.Y);
+}
+
+void BoundsBox::Add(const BoundsBox& box)
+{
+    Left = std::min(Left, box.Left);
+    Bottom = std::min(Bottom, box.Bottom);
+    Right = std::max(Right, box.Right);
+    Top = std::max(Top, box.Top);
+}
+
+void BoundsBox::Intersect(const BoundsBox& box)
+{
+    Left = std::max(Left, box.Left);
+    Bottom = std::max(Bottom, box.Bottom);
+    Right = std::min(Right, box.Right);
+    Top = std::min(Top, box.Top);
+}
+
+void BoundsBox::Grow(double amount)
+{
+    if (IsEmpty())
+        return;
+
+    Left -= amount;
+    Bottom -= amount;
+    Right += amount;
+    Top += amount;
+}
+
+// Read the operands in the order they appear in the content stream
+bool tryRead(const PdfVariantStack& stack, double* values, unsigned count)
+{
+    if (stack.GetSize() < count)
+        return false;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        if (!stack[count - 1 - i].TryGetReal(values[i]))
+            return false;
+    }
+
+    return true;
+}
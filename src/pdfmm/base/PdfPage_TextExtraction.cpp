@@ -10,6 +10,7 @@
 
 #include <regex>
 #include <deque>
+#include <list>
 #include <stack>
 
 #include "PdfDocument.h"
@@ -27,6 +28,11 @@ using namespace mm;
 
 constexpr double SAME_LINE_THRESHOLD = 0.01;
 constexpr double SPACE_SEPARATION_EPSILON = 0.0000001;
+// Thresholds of the reading order layout, relative to the font height
+constexpr double LAYOUT_LINE_TOLERANCE = 0.5;       // Baseline distance of runs in the same line
+constexpr double LAYOUT_WORD_GAP = 0.1;             // Gap between runs to be separated by a space
+constexpr double LAYOUT_COLUMN_GAP = 1.5;           // Gap between runs in different columns
+constexpr double LAYOUT_COLUMN_SPACING = 2.5;       // Baseline distance of lines in the same column
 #define ASSERT(condition, message, ...) if (!condition)\
     mm::LogMessage(PdfLogSeverity::Warning, message, ##__VA_ARGS__);
 
@@ -47,7 +53,6 @@ struct TextState
 
     double GetCharWidth(char32_t ch) const;
     double GetStringWidth(const string_view& str) const;        // utf8 string
-    double GetStringWidth(const PdfString& encodedStr) const;   // pdf encoded
 };
 
 class StatefulString
@@ -70,6 +75,22 @@ struct EntryOptions
     bool IgnoreCase;
     bool TrimSpaces;
     bool TokenizeWords;
+    bool ReadingOrder;
+};
+
+// An entry produced in content order, to be arranged by the reading order layout
+struct TextRun
+{
+    string Text;
+    double X;           // Position in the canonical frame
+    double Y;
+    double RawX;
+    double RawY;
+    double Length;      // Width in text space units
+    double Width;       // Width and font height in the canonical frame
+    double Height;
+    const PdfFont* Font;
+    double FontSize;
 };
 
 using StringChunk = list<StatefulString>;
@@ -102,7 +123,7 @@ struct XObjectState
 struct ExtractionContext
 {
 public:
-    ExtractionContext(vector<PdfTextEntry> &entries, const PdfPage &page, const string_view &pattern,
+    ExtractionContext(const PdfTextEntryHandler &handler, const PdfPage &page, const string_view &pattern,
         const EntryOptions &options, const nullable<PdfRect> &clipRect);
 public:
     void BeginText();
@@ -131,18 +152,21 @@ public:
     const EntryOptions Options;
     const nullable<PdfRect> ClipRect;
     unique_ptr<Matrix> Rotation;
-    vector<PdfTextEntry> &Entries;
+    const PdfTextEntryHandler &Handler;
     StringChunkPtr Chunk = std::make_unique<StringChunk>();
     StringChunkList Chunks;
     TextStateStack States;
     vector<XObjectState> XObjectStateIndices;
+    shared_ptr<PdfTextDecodeCache> DecodeCache;
+    vector<TextRun> Runs;               // The entries to be arranged, if in reading order
     double CurrentEntryT_rm_y = NaN;    // Tracks line changing
     double PrevChunkT_rm_x = 0;         // Tracks space separation
     bool BlockOpen = false;
 };
 
 static EntryOptions FromFlags(PdfTextExtractFlags flags);
-static bool DecodeString(const PdfString &str, TextState &state, string &decoded, double &length);
+static bool DecodeString(const PdfString &str, PdfTextDecodeCache &cache, TextState &state,
+    string &decoded, double &length);
 static bool AreEqual(double lhs, double rhs);
 static bool IsWhiteSpaceChunk(const StringChunk &chunk);
 static void SplitChunkBySpaces(vector<StringChunkPtr> &splittedChunks, const StringChunk &chunk);
@@ -150,15 +174,92 @@ static void SplitStringBySpaces(vector<StatefulString> &separatedStrings, const
 static void TrimSpacesBegin(StringChunk &chunk);
 static void TrimSpacesEnd(StringChunk &chunk);
 static double GetStringWidth(const string_view &str, const TextState &state);
-static void addEntry(vector<PdfTextEntry> &textEntries, StringChunkList &strings,
+static void addEntry(const PdfTextEntryHandler &handler, StringChunkList &strings,
     const string_view &pattern, const EntryOptions &options, const nullable<PdfRect> &clipRect,
-    int pageIndex, const Matrix* rotation);
-static void addEntry(vector<PdfTextEntry> &textEntries, StringChunkList &strings,
+    int pageIndex, const Matrix* rotation, vector<TextRun>* runs);
+static void addEntry(const PdfTextEntryHandler &handler, StringChunkList &strings,
     const string_view &pattern, bool ignoreCase, bool trimSpaces, const nullable<PdfRect> &clipRect,
-    int pageIndex, const Matrix* rotation);
+    int pageIndex, const Matrix* rotation, vector<TextRun>* runs);
+static void arrangeRuns(const PdfTextEntryHandler &handler, vector<TextRun> &runs,
+    const string_view &pattern, const EntryOptions &options, int pageIndex);
 static void read(const PdfVariantStack& stack, double &tx, double &ty);
 static void read(const PdfVariantStack& stack, double &a, double &b, double &c, double &d, double &e, double &f);
 
+struct PdfTextDecodeCache::FontCache
+{
+    struct Entry
+    {
+        string Key;
+        string Text;
+        double GlyphsWidth;     // The sum of the widths of the glyphs, for a unit font size
+        unsigned CIDCount;
+    };
+
+    // The entries, most recently used first
+    list<Entry> Entries;
+    unordered_map<string_view, list<Entry>::iterator> Index;
+};
+
+PdfTextDecodeCache::PdfTextDecodeCache(unsigned capacity)
+    : m_capacity(capacity == 0 ? 1 : capacity) { }
+
+PdfTextDecodeCache::~PdfTextDecodeCache() { }
+
+void PdfTextDecodeCache::Decode(const PdfString& str, const PdfTextState& state, string& decoded, double& width)
+{
+    PDFMM_ASSERT(state.Font != nullptr);
+    auto& font = *state.Font;
+    auto& key = str.GetRawData();
+
+    unique_lock<mutex> lock(m_mutex);
+    auto& fontCache = m_fonts[&font];
+    if (fontCache == nullptr)
+        fontCache.reset(new FontCache());
+
+    auto& entries = fontCache->Entries;
+    auto found = fontCache->Index.find(key);
+    if (found == fontCache->Index.end())
+    {
+        FontCache::Entry entry;
+        entry.Key = key;
+        entry.Text = font.GetEncoding().ConvertToUtf8(str);
+
+        // Measure the string like PdfFont::GetStringWidth(), ignoring
+        // failures, but unscaled, so it can be scaled by any state
+        vector<PdfCID> cids;
+        (void)font.GetEncoding().TryConvertToCIDs(str, cids);
+        PdfTextState unscaled;
+        unscaled.Font = &font;
+        unscaled.FontSize = 1;
+        unscaled.FontScale = 1;
+        unscaled.CharSpacing = 0;
+        (void)font.TryGetStringAdvances(cids, unscaled, { }, entry.GlyphsWidth);
+        entry.CIDCount = (unsigned)cids.size();
+
+        entries.push_front(std::move(entry));
+        fontCache->Index[entries.front().Key] = entries.begin();
+        if (entries.size() > m_capacity)
+        {
+            fontCache->Index.erase(entries.back().Key);
+            entries.pop_back();
+        }
+    }
+    else
+    {
+        entries.splice(entries.begin(), entries, found->second);
+    }
+
+    auto& entry = entries.front();
+    decoded = entry.Text;
+    width = (entry.GlyphsWidth * state.FontSize + entry.CIDCount * state.CharSpacing) * state.FontScale;
+}
+
+void PdfTextDecodeCache::Clear()
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_fonts.clear();
+}
+
 void PdfPage::ExtractTextTo(vector<PdfTextEntry>& entries, const PdfTextExtractParams& params) const
 {
     ExtractTextTo(entries, { }, params);
@@ -167,10 +268,27 @@ void PdfPage::ExtractTextTo(vector<PdfTextEntry>& entries, const PdfTextExtractP
 void PdfPage::ExtractTextTo(vector<PdfTextEntry>& entries, const string_view& pattern,
     const PdfTextExtractParams& params) const
 {
-    ExtractionContext context(entries, *this, pattern, FromFlags(params.Flags), params.ClipRect);
+    ExtractTextTo([&entries](const PdfTextEntryView& entry) {
+        entries.push_back({ (string)entry.Text, entry.Page, entry.X, entry.Y, entry.RawX, entry.RawY });
+    }, pattern, params);
+}
+
+void PdfPage::ExtractTextTo(const PdfTextEntryHandler& handler, const PdfTextExtractParams& params) const
+{
+    ExtractTextTo(handler, { }, params);
+}
+
+void PdfPage::ExtractTextTo(const PdfTextEntryHandler& handler, const string_view& pattern,
+    const PdfTextExtractParams& params) const
+{
+    ExtractionContext context(handler, *this, pattern, FromFlags(params.Flags), params.ClipRect);
+    context.DecodeCache = params.DecodeCache == nullptr
+        ? std::make_shared<PdfTextDecodeCache>() : params.DecodeCache;
 
     // Look FIGURE 4.1 Graphics objects
-    PdfContentsReader reader(*this);
+    PdfContentReaderArgs args;
+    args.Cache = params.ContentsCache;
+    PdfContentsReader reader(*this, args);
     PdfContent content;
     while (reader.TryReadNext(content))
     {
@@ -280,7 +398,7 @@ void PdfPage::ExtractTextTo(vector<PdfTextEntry>& entries, const string_view& pa
 
                         string decoded;
                         double length;
-                        if (DecodeString(str, *context.States.Current, decoded, length)
+                        if (DecodeString(str, *context.DecodeCache, *context.States.Current, decoded, length)
                             && decoded.length() != 0)
                         {
                             context.PushString({ decoded, length, *context.States.Current }, true);
@@ -307,7 +425,8 @@ void PdfPage::ExtractTextTo(vector<PdfTextEntry>& entries, const string_view& pa
                             {
                                 string decoded;
                                 double length;
-                                if (DecodeString(obj.GetString(), *context.States.Current, decoded, length)
+                                if (DecodeString(obj.GetString(), *context.DecodeCache, *context.States.Current,
+                                        decoded, length)
                                     && decoded.length() != 0)
                                 {
                                     context.PushString({ decoded, length, *context.States.Current });
@@ -402,10 +521,13 @@ void PdfPage::ExtractTextTo(vector<PdfTextEntry>& entries, const string_view& pa
     // After finishing processing tokens, one entry may still
     // be inside the chunks
     context.TryAddLastEntry();
+    if (context.Options.ReadingOrder)
+        arrangeRuns(handler, context.Runs, pattern, context.Options, context.PageIndex);
 }
 
-void addEntry(vector<PdfTextEntry> &textEntries, StringChunkList &chunks, const string_view &pattern,
-    const EntryOptions &options, const nullable<PdfRect> &clipRect, int pageIndex, const Matrix* rotation)
+void addEntry(const PdfTextEntryHandler &handler, StringChunkList &chunks, const string_view &pattern,
+    const EntryOptions &options, const nullable<PdfRect> &clipRect, int pageIndex, const Matrix* rotation,
+    vector<TextRun>* runs)
 {
     if (options.TokenizeWords)
     {
@@ -458,19 +580,20 @@ void addEntry(vector<PdfTextEntry> &textEntries, StringChunkList &chunks, const
 
         for (auto& batch : batches)
         {
-            addEntry(textEntries, *batch, pattern, options.IgnoreCase,
-                options.TrimSpaces, clipRect, pageIndex, rotation);
+            addEntry(handler, *batch, pattern, options.IgnoreCase,
+                options.TrimSpaces, clipRect, pageIndex, rotation, runs);
         }
     }
     else
     {
-        addEntry(textEntries, chunks, pattern, options.IgnoreCase,
-            options.TrimSpaces, clipRect, pageIndex, rotation);
+        addEntry(handler, chunks, pattern, options.IgnoreCase,
+            options.TrimSpaces, clipRect, pageIndex, rotation, runs);
     }
 }
 
-void addEntry(vector<PdfTextEntry> &textEntries, StringChunkList &chunks, const string_view &pattern,
-    bool ignoreCase, bool trimSpaces, const nullable<PdfRect> &clipRect, int pageIndex, const Matrix* rotation)
+void addEntry(const PdfTextEntryHandler &handler, StringChunkList &chunks, const string_view &pattern,
+    bool ignoreCase, bool trimSpaces, const nullable<PdfRect> &clipRect, int pageIndex, const Matrix* rotation,
+    vector<TextRun>* runs)
 {
     if (trimSpaces)
     {
@@ -517,13 +640,32 @@ void addEntry(vector<PdfTextEntry> &textEntries, StringChunkList &chunks, const
     }
 
     outstringstream stream;
+    double length = 0;
     for (auto &chunk : chunks)
     {
         for (auto &str : *chunk)
+        {
             stream << str.String;
+            length += str.Length;
+        }
     }
 
     string str = stream.take_str();
+    auto& state = firstStr.State.PdfState;
+    Vector2 pos(firstStr.Pos.X, firstStr.Pos.Y);
+    if (rotation != nullptr)
+        pos = pos * (*rotation);
+
+    if (runs != nullptr)
+    {
+        // The pattern is matched by the arranged entries
+        auto scale = firstStr.State.T_rm.GetScale();
+        runs->push_back({ std::move(str), pos.X, pos.Y, firstStr.Pos.X, firstStr.Pos.Y,
+            length, length * scale.X, state.FontSize * scale.Y, state.Font, state.FontSize });
+        chunks.clear();
+        return;
+    }
+
     if (pattern.length() != 0)
     {
         auto flags = regex_constants::ECMAScript;
@@ -540,19 +682,189 @@ void addEntry(vector<PdfTextEntry> &textEntries, StringChunkList &chunks, const
         }
     }
 
-    // Rotate to canonical frame
-    if (rotation == nullptr)
+    // Rotated to canonical frame
+    handler({ str, pageIndex, pos.X, pos.Y, firstStr.Pos.X, firstStr.Pos.Y, length, state.Font, state.FontSize });
+    chunks.clear();
+}
+
+// Arrange the runs in reading order. The runs are sorted by position
+// once, grouped in lines with a sweep from the top of the page, and the
+// close runs of a line are grouped in segments. A second sweep groups
+// the segments in columns, continuing the column of the previous lines
+// overlapping the segment the most, so the entries are emitted column
+// by column instead of interleaving the lines of the columns
+void arrangeRuns(const PdfTextEntryHandler &handler, vector<TextRun> &runs,
+    const string_view &pattern, const EntryOptions &options, int pageIndex)
+{
+    struct Segment
+    {
+        size_t Begin;       // The range of the runs of the segment
+        size_t End;
+        double Left;
+        double Right;
+        double Y;
+        double Height;
+        unsigned Line;
+    };
+
+    struct Column
+    {
+        double Left;        // The extent of the last segment of the column
+        double Right;
+        double Y;
+        double Height;
+        unsigned Line;
+        vector<size_t> Segments;
+    };
+
+    std::sort(runs.begin(), runs.end(), [](const TextRun& lhs, const TextRun& rhs) {
+        if (lhs.Y != rhs.Y)
+            return lhs.Y > rhs.Y;
+
+        return lhs.X < rhs.X;
+    });
+
+    vector<Segment> segments;
+    unsigned line = 0;
+    for (size_t begin = 0; begin < runs.size(); line++)
+    {
+        // The line holds the runs with the baseline close to the first one
+        double lineY = runs[begin].Y;
+        double lineHeight = runs[begin].Height;
+        size_t end = begin + 1;
+        while (end < runs.size()
+            && lineY - runs[end].Y <= LAYOUT_LINE_TOLERANCE * std::max(lineHeight, runs[end].Height))
+        {
+            end++;
+        }
+
+        std::sort(runs.begin() + begin, runs.begin() + end, [](const TextRun& lhs, const TextRun& rhs) {
+            return lhs.X < rhs.X;
+        });
+
+        for (size_t i = begin; i < end; i++)
+        {
+            auto& run = runs[i];
+            if (i != begin)
+            {
+                auto& segment = segments.back();
+                double height = std::max(segment.Height, run.Height);
+                if (run.X - segment.Right < LAYOUT_COLUMN_GAP * height)
+                {
+                    segment.End = i + 1;
+                    segment.Right = std::max(segment.Right, run.X + run.Width);
+                    segment.Height = height;
+                    continue;
+                }
+            }
+
+            segments.push_back({ i, i + 1, run.X, run.X + run.Width, lineY, run.Height, line });
+        }
+
+        begin = end;
+    }
+
+    vector<Column> columns;
+    vector<size_t> openColumns;
+    for (size_t i = 0; i < segments.size(); i++)
     {
-        textEntries.push_back({ str, pageIndex, firstStr.Pos.X, firstStr.Pos.Y, firstStr.Pos.X, firstStr.Pos.Y });
+        auto& segment = segments[i];
+
+        // The segments are sorted from the top, so the columns
+        // too far above can't be continued by the next ones
+        openColumns.erase(std::remove_if(openColumns.begin(), openColumns.end(), [&](size_t index) {
+            auto& column = columns[index];
+            return column.Y - segment.Y > LAYOUT_COLUMN_SPACING * std::max(column.Height, segment.Height);
+        }), openColumns.end());
+
+        size_t found = columns.size();
+        double maxOverlap = 0;
+        for (size_t index : openColumns)
+        {
+            // A column has a single segment per line
+            auto& column = columns[index];
+            if (column.Line == segment.Line)
+                continue;
+
+            double overlap = std::min(column.Right, segment.Right) - std::max(column.Left, segment.Left);
+            if (overlap > maxOverlap)
+            {
+                maxOverlap = overlap;
+                found = index;
+            }
+        }
+
+        if (found == columns.size())
+        {
+            columns.push_back({ });
+            openColumns.push_back(found);
+        }
+
+        auto& column = columns[found];
+        column.Left = segment.Left;
+        column.Right = segment.Right;
+        column.Y = segment.Y;
+        column.Height = segment.Height;
+        column.Line = segment.Line;
+        column.Segments.push_back(i);
     }
-    else
+
+    unique_ptr<regex> patternRegex;
+    if (pattern.length() != 0)
     {
-        Vector2 rawp(firstStr.Pos.X, firstStr.Pos.Y);
-        auto p_1 = rawp * (*rotation);
-        textEntries.push_back({ str, pageIndex, p_1.X, p_1.Y, firstStr.Pos.X, firstStr.Pos.Y });
+        auto flags = regex_constants::ECMAScript;
+        if (options.IgnoreCase)
+            flags |= regex_constants::icase;
+
+        patternRegex.reset(new regex((string)pattern, flags));
     }
 
-    chunks.clear();
+    auto pushEntry = [&](const string_view& text, const TextRun& first, double length)
+    {
+        if (patternRegex != nullptr && !std::regex_search(text.begin(), text.end(), *patternRegex))
+            return;
+
+        handler({ text, pageIndex, first.X, first.Y, first.RawX, first.RawY, length, first.Font, first.FontSize });
+    };
+
+    string text;
+    for (auto& column : columns)
+    {
+        for (size_t index : column.Segments)
+        {
+            auto& segment = segments[index];
+            if (options.TokenizeWords)
+            {
+                for (size_t i = segment.Begin; i < segment.End; i++)
+                    pushEntry(runs[i].Text, runs[i], runs[i].Length);
+
+                continue;
+            }
+
+            // Join the runs, separating them with a space if
+            // they are apart and not separated by spaces already
+            text.clear();
+            double right = 0;
+            for (size_t i = segment.Begin; i < segment.End; i++)
+            {
+                auto& run = runs[i];
+                if (i != segment.Begin && run.X - right > LAYOUT_WORD_GAP * std::max(segment.Height, run.Height)
+                    && text.length() != 0 && !std::isspace((unsigned char)text.back())
+                    && run.Text.length() != 0 && !std::isspace((unsigned char)run.Text.front()))
+                {
+                    text.push_back(' ');
+                }
+
+                text.append(run.Text);
+                right = std::max(right, run.X + run.Width);
+            }
+
+            auto& first = runs[segment.Begin];
+            double length = first.Width == 0 ? first.Length
+                : (segment.Right - segment.Left) * first.Length / first.Width;
+            pushEntry(text, first, length);
+        }
+    }
 }
 
 void read(const PdfVariantStack& tokens, double & tx, double & ty)
@@ -571,7 +883,8 @@ void read(const PdfVariantStack& tokens, double & a, double & b, double & c, dou
     a = tokens[5].GetReal();
 }
 
-bool DecodeString(const PdfString &str, TextState &state, string &decoded, double &length)
+bool DecodeString(const PdfString &str, PdfTextDecodeCache &cache, TextState &state,
+    string &decoded, double &length)
 {
     if (state.PdfState.Font == nullptr)
     {
@@ -586,8 +899,7 @@ bool DecodeString(const PdfString &str, TextState &state, string &decoded, doubl
         return false;
     }
 
-    decoded = state.PdfState.Font->GetEncoding().ConvertToUtf8(str);
-    length = state.GetStringWidth(str);
+    cache.Decode(str, state.PdfState, decoded, length);
     return true;
 }
 
@@ -660,14 +972,14 @@ void TextStateStack::push(const TextState & state)
     m_current = &m_states.top();
 }
 
-ExtractionContext::ExtractionContext(vector<PdfTextEntry> &entries, const PdfPage &page, const string_view &pattern,
+ExtractionContext::ExtractionContext(const PdfTextEntryHandler &handler, const PdfPage &page, const string_view &pattern,
     const EntryOptions & options, const nullable<PdfRect>& clipRect) :
     m_page(page),
     PageIndex(page.GetPageNumber() - 1),
     Pattern(pattern),
     Options(options),
     ClipRect(clipRect),
-    Entries(entries)
+    Handler(handler)
 {
     // Determine page rotation transformation
     double teta;
@@ -816,7 +1128,8 @@ const PdfCanvas& ExtractionContext::getActualCanvas()
 
 void ExtractionContext::addEntry()
 {
-    ::addEntry(Entries, Chunks, Pattern, Options, ClipRect, PageIndex, Rotation.get());
+    ::addEntry(Handler, Chunks, Pattern, Options, ClipRect, PageIndex, Rotation.get(),
+        Options.ReadingOrder ? &Runs : nullptr);
 }
 
 void ExtractionContext::tryAddEntry()
@@ -824,8 +1137,10 @@ void ExtractionContext::tryAddEntry()
     PDFMM_ASSERT(Chunk != nullptr);
     if (Chunks.size() > 0 || Chunk->size() > 0)
     {
+        // NOTE: In reading order the strings apart are split, as
+        // the layout arranges them by their position anyway
         if (!AreEqual(States.Current->T_rm.Get<Ty>(), CurrentEntryT_rm_y)
-            || (Options.TokenizeWords && areChunksSplitted()))
+            || ((Options.TokenizeWords || Options.ReadingOrder) && areChunksSplitted()))
         {
             // Current entry is not on same line or it's separated by space
             TryPushChunk();
@@ -990,16 +1305,12 @@ double TextState::GetStringWidth(const string_view& str) const
     return PdfState.Font->GetStringWidth(str, PdfState);
 }
 
-double TextState::GetStringWidth(const PdfString& encodedStr) const
-{
-    return PdfState.Font->GetStringWidth(encodedStr, PdfState);
-}
-
 EntryOptions FromFlags(PdfTextExtractFlags flags)
 {
     EntryOptions ret;
     ret.IgnoreCase = (flags & PdfTextExtractFlags::IgnoreCase) != PdfTextExtractFlags::None;
     ret.TokenizeWords = (flags & PdfTextExtractFlags::TokenizeWords) != PdfTextExtractFlags::None;
     ret.TrimSpaces = (flags & PdfTextExtractFlags::KeepWhiteTokens) == PdfTextExtractFlags::None || ret.TokenizeWords;
+    ret.ReadingOrder = (flags & PdfTextExtractFlags::ReadingOrder) != PdfTextExtractFlags::None;
     return ret;
 }
@@ -37,6 +37,7 @@ constexpr unsigned BEZIER_POINTS = 13;
 constexpr double ARC_MAGIC = 0.552284749;
 
 string expandTabs(const string_view& str, unsigned tabWidth, unsigned nTabCnt);
+static void writeHexString(PdfStringStream& stream, const bufferview& encoded);
 
 inline bool IsNewLineChar(char32_t ch)
 {
@@ -53,12 +54,16 @@ inline bool IsSpaceChar(char32_t ch)
 
 PdfPainter::PdfPainter(PdfPainterFlags flags) :
     m_flags(flags),
+    m_optimizeState((flags & PdfPainterFlags::OptimizeState) != PdfPainterFlags::None),
     m_stream(nullptr),
     m_canvas(nullptr),
     m_PainterGraphicsState(*this, m_GraphicsState),
     m_PainterTextState(*this, m_TextState),
     m_TabWidth(4),
     m_isTextOpen(false),
+    m_isTextPending(false),
+    m_textX(0),
+    m_textY(0),
     m_lpx(0),
     m_lpy(0),
     m_lpx2(0),
@@ -119,6 +124,7 @@ void PdfPainter::FinishDrawing()
 
 void PdfPainter::finishDrawing()
 {
+    closePendingText();
     if (m_stream != nullptr)
     {
         if ((m_flags & PdfPainterFlags::NoSaveRestorePrior) == PdfPainterFlags::NoSaveRestorePrior)
@@ -171,6 +177,10 @@ void PdfPainter::finishDrawing()
 
     // Reset temporary stream
     m_tmpStream.Clear();
+
+    // The next canvas starts with the default state
+    m_emittedState = { };
+    m_savedStates.clear();
 }
 
 void PdfPainter::SetStrokingShadingPattern(const PdfShadingPattern& pattern)
@@ -345,6 +355,7 @@ void PdfPainter::SetClipRect(const PdfRect& rect)
 void PdfPainter::SetClipRect(double x, double y, double width, double height)
 {
     checkStream();
+    writeGraphicsState();
     m_tmpStream << x << " "
         << y << " "
         << width << " "
@@ -355,6 +366,7 @@ void PdfPainter::SetClipRect(double x, double y, double width, double height)
 void PdfPainter::DrawLine(double startX, double startY, double endX, double endY)
 {
     checkStream();
+    writeGraphicsState();
 
     m_tmpStream << startX << " "
         << startY
@@ -368,6 +380,7 @@ void PdfPainter::Rectangle(double x, double y, double width, double height,
     double roundX, double roundY)
 {
     checkStream();
+    writeGraphicsState();
     if (static_cast<int>(roundX) || static_cast<int>(roundY))
     {
         double w = width, h = height,
@@ -400,6 +413,7 @@ void PdfPainter::Ellipse(double x, double y, double width, double height)
     double dPointY[BEZIER_POINTS];
 
     checkStream();
+    writeGraphicsState();
 
     convertRectToBezier(x, y, width, height, dPointX, dPointY);
 
@@ -442,6 +456,35 @@ void PdfPainter::Circle(double x, double y, double radius)
 
 void PdfPainter::DrawText(const string_view& str, double x, double y)
 {
+    if (m_optimizeState)
+    {
+        // Draw consecutive texts in the same text object
+        openStream();
+        checkTextModeClosed();
+        checkFont();
+
+        writeGraphicsState();
+        if (!m_isTextPending)
+        {
+            m_tmpStream << "BT" << endl;
+            m_isTextPending = true;
+            m_textX = 0;
+            m_textY = 0;
+        }
+
+        writeTextState();
+
+        // Td moves relatively to the start of the current line: round the
+        // offsets to the written precision so the position doesn't drift
+        double factor = std::pow(10, m_tmpStream.GetPrecision());
+        double offsetX = std::round((x - m_textX) * factor) / factor;
+        double offsetY = std::round((y - m_textY) * factor) / factor;
+        m_textX += offsetX;
+        m_textY += offsetY;
+        drawText(str, offsetX, offsetY, false, false);
+        return;
+    }
+
     checkStream();
     checkTextModeClosed();
     checkFont();
@@ -490,6 +533,94 @@ void PdfPainter::drawText(const std::string_view& str, double x, double y, bool
     m_tmpStream << " Tj" << endl;
 }
 
+void PdfPainter::DrawTextRuns(const cspan<PdfTextRun>& runs)
+{
+    checkStream();
+    checkTextModeClosed();
+    checkFont();
+    if (runs.size() == 0)
+        return;
+
+    writeGraphicsState();
+    m_tmpStream << "BT" << endl;
+    writeTextState();
+
+    auto& font = *m_TextState.Font;
+    auto& encoding = font.GetEncoding();
+    double factor = std::pow(10, m_tmpStream.GetPrecision());
+
+    // The TJ adjustments are expressed in thousandths of text space unit,
+    // scaled by the font size and the horizontal scaling
+    double adjustScale = m_TextState.FontSize * m_TextState.FontScale;
+    bool canAdjust = adjustScale > 0;
+    if (canAdjust)
+        adjustScale = 1000 / adjustScale;
+
+    string expanded;
+    charbuff encoded;
+    double lineX = 0;   // Start of the current line
+    double lineY = 0;
+    double endX = 0;    // End of the previous run
+    bool isArrayOpen = false;
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        auto& run = runs[i];
+        string_view text = run.Text;
+        if (text.find('\t') != string_view::npos)
+        {
+            expanded = this->expandTabs(text);
+            text = expanded;
+        }
+
+        if (!encoding.TryConvertToEncoded(text, encoded))
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The provided string can't be converted to CID encoding");
+
+        if (isArrayOpen && run.Y == runs[i - 1].Y && run.X >= endX)
+        {
+            // Continue the array on the same baseline, moving
+            // the run by the gap from the previous one
+            double adjust = std::round((endX - run.X) * adjustScale * factor) / factor;
+            if (adjust != 0)
+            {
+                m_tmpStream << " " << adjust << " ";
+                endX -= adjust / adjustScale;
+            }
+        }
+        else
+        {
+            if (isArrayOpen)
+                m_tmpStream << "] TJ" << endl;
+
+            // Td moves relatively to the start of the current line
+            double offsetX = std::round((run.X - lineX) * factor) / factor;
+            double offsetY = std::round((run.Y - lineY) * factor) / factor;
+            lineX += offsetX;
+            lineY += offsetY;
+            endX = lineX;
+            m_tmpStream << offsetX << " " << offsetY << " Td [";
+            isArrayOpen = true;
+        }
+
+        writeHexString(m_tmpStream, encoded);
+
+        // Measure the run only if the next one may continue the array
+        if (canAdjust && i + 1 < runs.size() && runs[i + 1].Y == run.Y)
+        {
+            double width;
+            (void)font.TryGetStringWidth(text, m_TextState, width);
+            endX += width;
+        }
+        else
+        {
+            // Prevent the next run from continuing the array
+            endX = numeric_limits<double>::infinity();
+        }
+    }
+
+    m_tmpStream << "] TJ" << endl;
+    m_tmpStream << "ET" << endl;
+}
+
 void PdfPainter::BeginText(double x, double y)
 {
     checkStream();
@@ -513,6 +644,12 @@ void PdfPainter::AddText(const string_view& str)
     checkStream();
     checkFont();
     checkTextModeOpened();
+    if (m_optimizeState)
+    {
+        writeGraphicsState();
+        writeTextState();
+    }
+
     auto expStr = this->expandTabs(str);
 
     // TODO: Underline and Strikeout not yet supported
@@ -547,6 +684,7 @@ void PdfPainter::DrawMultiLineText(const string_view& str, double x, double y, d
     if (width <= 0.0 || height <= 0.0) // nonsense arguments
         return;
 
+    writeGraphicsState();
     m_tmpStream << "BT" << endl;
     writeTextState();
     drawMultiLineText(str, x, y, width, height, hAlignment, vAlignment, clip, skipSpaces);
@@ -562,6 +700,7 @@ void PdfPainter::DrawTextAligned(const string_view& str, double x, double y, dou
     checkTextModeClosed();
     checkFont();
 
+    writeGraphicsState();
     m_tmpStream << "BT" << endl;
     writeTextState();
     drawTextAligned(str, x, y, width, hAlignment);
@@ -801,6 +940,13 @@ void PdfPainter::DrawImage(const PdfImage& obj, double x, double y, double scale
         scaleY * obj.GetRect().GetHeight());
 }
 
+void PdfPainter::DrawImage(const string_view& filename, double x, double y, double scaleX, double scaleY)
+{
+    checkStream();
+    auto& image = m_canvas->GetElement().GetDocument().GetImageManager().GetImage(filename);
+    this->DrawImage(image, x, y, scaleX, scaleY);
+}
+
 void PdfPainter::DrawXObject(const PdfXObject& obj, double x, double y, double scaleX, double scaleY)
 {
     checkStream();
@@ -809,6 +955,7 @@ void PdfPainter::DrawXObject(const PdfXObject& obj, double x, double y, double s
     // already and is not in memory anymore in this case.
     this->addToPageResources("XObject", obj.GetIdentifier(), obj.GetObject());
 
+    writeGraphicsState();
     m_tmpStream << "q" << endl
         << scaleX << " 0 0 "
         << scaleY << " "
@@ -834,6 +981,7 @@ void PdfPainter::LineTo(double x, double y)
 void PdfPainter::MoveTo(double x, double y)
 {
     checkStream();
+    writeGraphicsState();
     m_tmpStream << x << " "
         << y
         << " m" << endl;
@@ -1130,12 +1278,14 @@ void PdfPainter::Close()
 void PdfPainter::Stroke()
 {
     checkStream();
+    writeGraphicsState();
     m_tmpStream << "S" << endl;
 }
 
 void PdfPainter::Fill(bool useEvenOddRule)
 {
     checkStream();
+    writeGraphicsState();
     if (useEvenOddRule)
         m_tmpStream << "f*" << endl;
     else
@@ -1145,6 +1295,7 @@ void PdfPainter::Fill(bool useEvenOddRule)
 void PdfPainter::FillAndStroke(bool useEvenOddRule)
 {
     checkStream();
+    writeGraphicsState();
     if (useEvenOddRule)
         m_tmpStream << "B*" << endl;
     else
@@ -1170,12 +1321,23 @@ void PdfPainter::Save()
 {
     checkStream();
     m_tmpStream << "q" << endl;
+    if (m_optimizeState)
+        m_savedStates.push_back({ m_GraphicsState, m_TextState, m_emittedState });
 }
 
 void PdfPainter::Restore()
 {
     checkStream();
     m_tmpStream << "Q" << endl;
+    if (m_optimizeState && m_savedStates.size() != 0)
+    {
+        // "Q" restores both the state set and the state written
+        auto& saved = m_savedStates.back();
+        m_GraphicsState = std::move(saved.GraphicsState);
+        m_TextState = saved.TextState;
+        m_emittedState = std::move(saved.Emitted);
+        m_savedStates.pop_back();
+    }
 }
 
 
@@ -1206,11 +1368,13 @@ void PdfPainter::Rectangle(const PdfRect& rect, double roundX, double roundY)
 
 void PdfPainter::BeginMarkedContext(const string_view& tag)
 {
+    closePendingText();
     m_tmpStream << '/' << tag << " BMC" << endl;
 }
 
 void PdfPainter::EndMarkedContext()
 {
+    closePendingText();
     m_tmpStream << "EMC" << endl;
 }
 
@@ -1278,6 +1442,10 @@ void PdfPainter::SetTransformationMatrix(const Matrix& matrix)
 
 void PdfPainter::SetLineWidth(double value)
 {
+    // With optimized state the state is written when drawing
+    if (m_optimizeState)
+        return;
+
     checkStream();
     setLineWidth(value);
 }
@@ -1289,31 +1457,71 @@ void PdfPainter::setLineWidth(double width)
 
 void PdfPainter::SetMiterLimit(double value)
 {
+    if (m_optimizeState)
+        return;
+
     checkStream();
+    setMiterLimit(value);
+}
+
+void PdfPainter::setMiterLimit(double value)
+{
     m_tmpStream << value << " M" << endl;
 }
 
 void PdfPainter::SetLineCapStyle(PdfLineCapStyle style)
 {
+    if (m_optimizeState)
+        return;
+
     checkStream();
+    setLineCapStyle(style);
+}
+
+void PdfPainter::setLineCapStyle(PdfLineCapStyle style)
+{
     m_tmpStream << static_cast<int>(style) << " J" << endl;
 }
 
 void PdfPainter::SetLineJoinStyle(PdfLineJoinStyle style)
 {
+    if (m_optimizeState)
+        return;
+
     checkStream();
+    setLineJoinStyle(style);
+}
+
+void PdfPainter::setLineJoinStyle(PdfLineJoinStyle style)
+{
     m_tmpStream << static_cast<int>(style) << " j" << endl;
 }
 
 void PdfPainter::SetRenderingIntent(const string_view& intent)
 {
+    if (m_optimizeState)
+        return;
+
     checkStream();
+    setRenderingIntent(intent);
+}
+
+void PdfPainter::setRenderingIntent(const string_view& intent)
+{
     m_tmpStream << "/" << intent << " ri" << endl;
 }
 
 void PdfPainter::SetFillColor(const PdfColor& color)
 {
+    if (m_optimizeState)
+        return;
+
     checkStream();
+    setFillColor(color);
+}
+
+void PdfPainter::setFillColor(const PdfColor& color)
+{
     switch (color.GetColorSpace())
     {
         default:
@@ -1365,7 +1573,15 @@ void PdfPainter::SetFillColor(const PdfColor& color)
 
 void PdfPainter::SetStrokeColor(const PdfColor& color)
 {
+    if (m_optimizeState)
+        return;
+
     checkStream();
+    setStrokeColor(color);
+}
+
+void PdfPainter::setStrokeColor(const PdfColor& color)
+{
     switch (color.GetColorSpace())
     {
         default:
@@ -1415,8 +1631,95 @@ void PdfPainter::SetStrokeColor(const PdfColor& color)
     }
 }
 
+void PdfPainter::writeGraphicsState()
+{
+    if (!m_optimizeState)
+        return;
+
+    auto& emitted = m_emittedState.GraphicsState;
+    if (emitted.LineWidth != m_GraphicsState.LineWidth)
+    {
+        setLineWidth(m_GraphicsState.LineWidth);
+        emitted.LineWidth = m_GraphicsState.LineWidth;
+    }
+
+    if (emitted.MiterLimit != m_GraphicsState.MiterLimit)
+    {
+        setMiterLimit(m_GraphicsState.MiterLimit);
+        emitted.MiterLimit = m_GraphicsState.MiterLimit;
+    }
+
+    if (emitted.LineCapStyle != m_GraphicsState.LineCapStyle)
+    {
+        setLineCapStyle(m_GraphicsState.LineCapStyle);
+        emitted.LineCapStyle = m_GraphicsState.LineCapStyle;
+    }
+
+    if (emitted.LineJoinStyle != m_GraphicsState.LineJoinStyle)
+    {
+        setLineJoinStyle(m_GraphicsState.LineJoinStyle);
+        emitted.LineJoinStyle = m_GraphicsState.LineJoinStyle;
+    }
+
+    if (emitted.RenderingIntent != m_GraphicsState.RenderingIntent)
+    {
+        setRenderingIntent(m_GraphicsState.RenderingIntent);
+        emitted.RenderingIntent = m_GraphicsState.RenderingIntent;
+    }
+
+    if (emitted.FillColor != m_GraphicsState.FillColor)
+    {
+        setFillColor(m_GraphicsState.FillColor);
+        emitted.FillColor = m_GraphicsState.FillColor;
+    }
+
+    if (emitted.StrokeColor != m_GraphicsState.StrokeColor)
+    {
+        setStrokeColor(m_GraphicsState.StrokeColor);
+        emitted.StrokeColor = m_GraphicsState.StrokeColor;
+    }
+}
+
 void PdfPainter::writeTextState()
 {
+    if (m_optimizeState)
+    {
+        // The text state is kept across text objects
+        auto& emitted = m_emittedState.TextState;
+        if (emitted.Font != m_TextState.Font || emitted.FontSize != m_TextState.FontSize)
+        {
+            setFont(m_TextState.Font, m_TextState.FontSize);
+            emitted.Font = m_TextState.Font;
+            emitted.FontSize = m_TextState.FontSize;
+        }
+
+        if (emitted.FontScale != m_TextState.FontScale)
+        {
+            setFontScale(m_TextState.FontScale);
+            emitted.FontScale = m_TextState.FontScale;
+        }
+
+        if (emitted.CharSpacing != m_TextState.CharSpacing)
+        {
+            setCharSpacing(m_TextState.CharSpacing);
+            emitted.CharSpacing = m_TextState.CharSpacing;
+        }
+
+        if (emitted.WordSpacing != m_TextState.WordSpacing)
+        {
+            setWordSpacing(m_TextState.WordSpacing);
+            emitted.WordSpacing = m_TextState.WordSpacing;
+        }
+
+        if (emitted.RenderingMode != m_TextState.RenderingMode)
+        {
+            setTextRenderingMode(m_TextState.RenderingMode);
+            emitted.RenderingMode = m_TextState.RenderingMode;
+        }
+
+        return;
+    }
+
     if (m_TextState.Font != nullptr)
         setFont(m_TextState.Font, m_TextState.FontSize);
 
@@ -1438,14 +1741,15 @@ void PdfPainter::SetFont(const PdfFont* font, double fontSize)
     if (font == nullptr)
         return;
 
-    this->addToPageResources("Font", font->GetIdentifier(), font->GetObject());
-    if (m_isTextOpen)
+    if (m_isTextOpen && !m_optimizeState)
         setFont(font, fontSize);
 }
 
 void PdfPainter::setFont(const PdfFont* font, double fontSize)
 {
-    checkStream();
+    // The text state survives the canvas, so the font is
+    // added to the resources of the canvas where it's used
+    this->addToPageResources("Font", font->GetIdentifier(), font->GetObject());
     m_tmpStream << "/" << font->GetIdentifier().GetString()
         << " " << fontSize
         << " Tf" << endl;
@@ -1453,49 +1757,45 @@ void PdfPainter::setFont(const PdfFont* font, double fontSize)
 
 void PdfPainter::SetFontScale(double value)
 {
-    if (m_isTextOpen)
+    if (m_isTextOpen && !m_optimizeState)
         setFontScale(value);
 }
 
 void PdfPainter::setFontScale(double value)
 {
-    checkStream();
     m_tmpStream << value * 100 << " Tz" << endl;
 }
 
 void PdfPainter::SetCharSpacing(double value)
 {
-    if (m_isTextOpen)
+    if (m_isTextOpen && !m_optimizeState)
         setCharSpacing(value);
 }
 
 void PdfPainter::setCharSpacing(double value)
 {
-    checkStream();
     m_tmpStream << value << " Tc" << endl;
 }
 
 void PdfPainter::SetWordSpacing(double value)
 {
-    if (m_isTextOpen)
+    if (m_isTextOpen && !m_optimizeState)
         setWordSpacing(value);
 }
 
 void PdfPainter::setWordSpacing(double value)
 {
-    checkStream();
     m_tmpStream << value << " Tw" << endl;
 }
 
 void PdfPainter::SetTextRenderingMode(PdfTextRenderingMode value)
 {
-    if (m_isTextOpen)
+    if (m_isTextOpen && !m_optimizeState)
         setTextRenderingMode(value);
 }
 
 void PdfPainter::setTextRenderingMode(PdfTextRenderingMode value)
 {
-    checkStream();
     m_tmpStream << (int)value << " Tr" << endl;
 }
 
@@ -1519,12 +1819,28 @@ string PdfPainter::expandTabs(const string_view& str) const
 }
 
 void PdfPainter::checkStream()
+{
+    closePendingText();
+    openStream();
+}
+
+void PdfPainter::openStream()
 {
     if (m_stream != nullptr)
         return;
 
     PDFMM_RAISE_LOGIC_IF(m_canvas == nullptr, "Call SetCanvas() first before doing drawing operations");
-    m_stream = &m_canvas->GetStreamForAppending((PdfStreamAppendFlags)(m_flags & (~PdfPainterFlags::NoSaveRestore)));
+    m_stream = &m_canvas->GetStreamForAppending((PdfStreamAppendFlags)(m_flags
+        & (PdfPainterFlags::Prepend | PdfPainterFlags::NoSaveRestorePrior)));
+}
+
+void PdfPainter::closePendingText()
+{
+    if (!m_isTextPending)
+        return;
+
+    m_tmpStream << "ET" << endl;
+    m_isTextPending = false;
 }
 
 void PdfPainter::checkFont()
@@ -1564,6 +1880,18 @@ string expandTabs(const string_view& str, unsigned tabWidth, unsigned tabCount)
     return ret;
 }
 
+void writeHexString(PdfStringStream& stream, const bufferview& encoded)
+{
+    constexpr const char* HexDigits = "0123456789ABCDEF";
+    stream << '<';
+    for (char ch : encoded)
+    {
+        unsigned char byte = (unsigned char)ch;
+        stream << HexDigits[byte >> 4] << HexDigits[byte & 0x0F];
+    }
+    stream << '>';
+}
+
 PdfGraphicsStateWrapper::PdfGraphicsStateWrapper(PdfPainter& painter, PdfGraphicsState& state)
     : m_painter(&painter), m_state(&state) { }
 
@@ -40,6 +40,16 @@ enum class PdfPainterFlags
     NoSaveRestorePrior = 2, ///< Do not perform a Save/Restore or previous content. Implies RawCoordinates
     NoSaveRestore = 4,      ///< Do not perform a Save/Restore of added content in this painting session
     RawCoordinates = 8,     ///< Does nothing for now
+    OptimizeState = 16,     ///< Write the graphics and text state operators only when drawing, and only if they differ from the state in effect
+};
+
+/** A text run positioned on the page, to be drawn with PdfPainter::DrawTextRuns
+ */
+struct PdfTextRun final
+{
+    std::string_view Text;
+    double X;
+    double Y;
 };
 
 class PdfPainter;
@@ -367,6 +377,18 @@ public:
      */
     void DrawTextAligned(const std::string_view& str, double x, double y, double width, PdfHorizontalAlignment hAlignment);
 
+    /** Draw many single-line text runs with the current font in one text object.
+     *  You have to call SetFont before calling this function.
+     *
+     *  Every run is encoded and written once. Consecutive runs on the same
+     *  baseline are written in a single TJ array, positioned with glyph
+     *  adjustments, the others are positioned with relative Td operators
+     *  \param runs the runs to draw, in the order they should be drawn
+     *
+     *  \see SetFont()
+     */
+    void DrawTextRuns(const cspan<PdfTextRun>& runs);
+
     /** Begin drawing multiple text strings on a page using a given font object.
      *  You have to call SetFont before calling this function.
      *
@@ -437,6 +459,17 @@ public:
      */
     void DrawImage(const PdfImage& obj, double x, double y, double scaleX = 1.0, double scaleY = 1.0);
 
+    /** Draw an image loaded from a file on the current page. The image
+     *  is shared with the other drawings of the same file in the document
+     *  \param filename the image file
+     *  \param x the x coordinate (bottom left position of the image)
+     *  \param y the y coordinate (bottom position of the image)
+     *  \param scaleX option scaling factor in x direction
+     *  \param scaleY option scaling factor in y direction
+     *  \see PdfImageManager::GetImage
+     */
+    void DrawImage(const std::string_view& filename, double x, double y, double scaleX = 1.0, double scaleY = 1.0);
+
     /** Draw an XObject on the current page. For PdfImage use DrawImage.
      *
      *  \param x the x coordinate (bottom left position of the XObject)
@@ -675,7 +708,14 @@ private:
     void SetTextRenderingMode(PdfTextRenderingMode value);
 
 private:
+    void writeGraphicsState();
     void writeTextState();
+    void setMiterLimit(double value);
+    void setLineCapStyle(PdfLineCapStyle style);
+    void setLineJoinStyle(PdfLineJoinStyle style);
+    void setFillColor(const PdfColor& color);
+    void setStrokeColor(const PdfColor& color);
+    void setRenderingIntent(const std::string_view& intent);
     void setFont(const PdfFont* font, double fontSize);
     void setFontScale(double value);
     void setCharSpacing(double value);
@@ -739,13 +779,33 @@ private:
      */
     std::string expandTabs(const std::string_view& str) const;
     void checkStream();
+    void openStream();
+    void closePendingText();
     void checkFont();
     void checkTextModeOpened();
     void checkTextModeClosed();
     void finishDrawing();
 
+private:
+    /** The graphics and text state in effect in the content stream,
+     *  as written by the painter with PdfPainterFlags::OptimizeState
+     */
+    struct EmittedState
+    {
+        PdfGraphicsState GraphicsState;
+        PdfTextState TextState;
+    };
+
+    struct SavedState
+    {
+        PdfGraphicsState GraphicsState;
+        PdfTextState TextState;
+        EmittedState Emitted;
+    };
+
 private:
     PdfPainterFlags m_flags;
+    bool m_optimizeState;
 
     /** All drawing operations work on this stream.
      *  This object may not be nullptr. If it is nullptr any function accessing it should
@@ -772,6 +832,20 @@ private:
      */
     bool m_isTextOpen;
 
+    /** The state written in the content stream, and the
+     *  states saved with "q", with PdfPainterFlags::OptimizeState
+     */
+    EmittedState m_emittedState;
+    std::vector<SavedState> m_savedStates;
+
+    /** With PdfPainterFlags::OptimizeState the text object of
+     *  DrawText() is kept open for the next texts. The start
+     *  of the current line in the pending text object
+     */
+    bool m_isTextPending;
+    double m_textX;
+    double m_textY;
+
     /** temporary stream buffer
      */
     PdfStringStream  m_tmpStream;
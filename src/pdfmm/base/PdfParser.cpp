@@ -12,28 +12,42 @@
 #include "PdfArray.h"
 #include "PdfDictionary.h"
 #include "PdfEncrypt.h"
+#include "PdfExecutor.h"
 #include "PdfInputDevice.h"
 #include "PdfMemoryObjectStream.h"
 #include "PdfObjectStreamParser.h"
 #include "PdfOutputDevice.h"
+#include "PdfStreamDevice.h"
 #include "PdfObjectStream.h"
 #include "PdfVariant.h"
 #include "PdfXRefStreamParserObject.h"
 
+#include <pdfmm/private/PdfCharScanPrivate.h>
+#include <pdfmm/private/PdfTracePrivate.h>
+
 #include <algorithm>
+#include <atomic>
 
 constexpr unsigned PDF_VERSION_LENGHT = 3;
 constexpr unsigned PDF_MAGIC_LENGHT = 8;
 constexpr unsigned PDF_XREF_ENTRY_SIZE = 20;
 constexpr unsigned PDF_XREF_BUF = 512;
 constexpr unsigned MAX_XREF_SESSION_COUNT = 512;
+constexpr unsigned PDF_OBJECT_HEADER_BUF = 48;
 
 using namespace std;
 using namespace mm;
 
 static bool CheckEOL(char e1, char e2);
 static bool CheckXRefEntryType(char c);
+static bool tryParseXRefEntry(const char* buffer, uint64_t& offset, uint32_t& generation, char& type);
 static bool ReadMagicWord(char ch, unsigned& cursoridx);
+static ssize_t findTokenBackward(const char* buffer, size_t size, const string_view& token);
+static bool checkObjectHeader(const char* buffer, size_t size, uint32_t objNum);
+static bool tryReadObjectHeader(const char* buffer, size_t size, uint32_t& objNum);
+static bool tryReadObjectHeaderBackward(const char* buffer, size_t pos, uint32_t& objNum, uint16_t& gen, size_t& headerPos);
+static void parallelFor(const PdfIndirectObjectList& objects, size_t count, size_t batchSize, unsigned threadCount,
+    const PdfExecutor::WorkerFactory& createWorker);
 
 static unsigned s_MaxObjectCount = (1U << 23) - 1;
 
@@ -75,11 +89,53 @@ private:
     unsigned& m_RecursionDepth;
 };
 
+class PdfStatsTimer
+{
+    // RAII timer that adds the time spent in a scope to a
+    // parser statistics entry. It does nothing if time is nullptr
+
+public:
+    PdfStatsTimer(chrono::nanoseconds* time)
+        : m_time(time)
+    {
+        if (m_time != nullptr)
+            m_start = chrono::steady_clock::now();
+    }
+
+    ~PdfStatsTimer()
+    {
+        if (m_time != nullptr)
+            *m_time += chrono::steady_clock::now() - m_start;
+    }
+
+private:
+    chrono::nanoseconds* m_time;
+    chrono::steady_clock::time_point m_start;
+};
+
+PdfParserStats::PdfParserStats() :
+    ReadDocumentStructureTime(0),
+    ReadXRefContentsTime(0),
+    ReadObjectsTime(0),
+    EncryptionSetupTime(0),
+    ReadCompressedObjectsTime(0),
+    XRefBytesRead(0),
+    ObjectBytesRead(0),
+    ObjectCount(0),
+    XRefSectionCount(0),
+    BrokenObjectCount(0),
+    ShadowedXRefEntryCount(0)
+{
+}
+
 PdfParser::PdfParser(PdfIndirectObjectList& objects) :
     m_buffer(std::make_shared<charbuff>(PdfTokenizer::BufferSize)),
     m_tokenizer(m_buffer, true),
     m_Objects(&objects),
-    m_StrictParsing(false)
+    m_StrictParsing(false),
+    m_RebuildBrokenXRef(false),
+    m_ParseThreadCount(1),
+    m_CollectStats(false)
 {
     this->Reset();
 }
@@ -98,17 +154,30 @@ void PdfParser::Reset()
     m_HasXRefStream = false;
     m_XRefOffset = 0;
     m_XRefLinearizedOffset = 0;
+    m_DeferXRef = false;
+    m_SkipPreviousXRef = false;
+    m_DeferredXRefOffset = -1;
+    m_FirstPageObjectNumber = 0;
+    m_loadedEntries.clear();
     m_LastEOFOffset = 0;
 
     m_Trailer = nullptr;
     m_entries.Clear();
     m_ObjectStreams.clear();
+    m_visitedXRefOffsets.clear();
 
     m_Encrypt = nullptr;
 
     m_IgnoreBrokenObjects = true;
+    m_XRefRebuilt = false;
     m_IncrementalUpdateCount = 0;
     m_RecursionDepth = 0;
+    m_Stats = PdfParserStats();
+
+    // NOTE: The buffers and the capacity of the containers are
+    // kept, so a parser reused for many files starts warm
+    m_tokenizer.clearTokenQueue();
+    m_tokenizer.m_depth = 0;
 }
 
 void PdfParser::Parse(InputStreamDevice& device, bool loadOnDemand)
@@ -122,7 +191,7 @@ void PdfParser::Parse(InputStreamDevice& device, bool loadOnDemand)
         if (!IsPdfFile(device))
             PDFMM_RAISE_ERROR(PdfErrorCode::NoPdfFile);
 
-        ReadDocumentStructure(device);
+        readDocumentStructure(device);
         ReadObjects(device);
     }
     catch (PdfError& e)
@@ -142,8 +211,218 @@ void PdfParser::Parse(InputStreamDevice& device, bool loadOnDemand)
     }
 }
 
+bool PdfParser::ParseFirstPage(InputStreamDevice& device, bool loadOnDemand)
+{
+    Reset();
+
+    m_LoadOnDemand = loadOnDemand;
+
+    try
+    {
+        if (!IsPdfFile(device))
+            PDFMM_RAISE_ERROR(PdfErrorCode::NoPdfFile);
+
+        if (!tryReadLinearizationDict(device))
+        {
+            // Not linearized, just read the whole document
+            readDocumentStructure(device);
+            ReadObjects(device);
+            return false;
+        }
+
+        try
+        {
+            // Read the first-page section, deferring the /Prev main section.
+            // NOTE: The "startxref" of a linearized file points
+            // to the first-page section as well
+            PdfStatsTimer timer(m_CollectStats ? &m_Stats.ReadXRefContentsTime : nullptr);
+            m_DeferXRef = true;
+            ReadXRefContents(device, m_XRefLinearizedOffset);
+            m_DeferXRef = false;
+            m_XRefOffset = m_XRefLinearizedOffset;
+        }
+        catch (PdfError& e)
+        {
+            PDFMM_PUSH_FRAME_INFO(e, "Unable to load first-page xref entries");
+            throw e;
+        }
+
+        auto encrypt = m_Trailer->GetDictionary().GetKey("Encrypt");
+        if (HasDeferredXRef() && encrypt != nullptr && !encrypt->IsNull())
+        {
+            // The encryption setup requires the full xref, don't
+            // bother splitting the loading of encrypted documents
+            PdfStatsTimer timer(m_CollectStats ? &m_Stats.ReadXRefContentsTime : nullptr);
+            size_t offset = (size_t)m_DeferredXRefOffset;
+            m_DeferredXRefOffset = -1;
+            ReadXRefContents(device, offset);
+        }
+
+        ReadObjects(device);
+
+        if (HasDeferredXRef())
+        {
+            // Remember the entries that have been read in the first pass
+            m_loadedEntries.resize(m_entries.GetSize());
+            for (unsigned i = 0; i < m_entries.GetSize(); i++)
+                m_loadedEntries[i] = m_entries[i].Parsed;
+        }
+    }
+    catch (PdfError& e)
+    {
+        if (e.GetError() == PdfErrorCode::InvalidPassword)
+        {
+            // Do not clean up, expect user to call ParseFile again
+            throw e;
+        }
+
+        Reset();
+        PDFMM_PUSH_FRAME_INFO(e, "Unable to load objects from file");
+        throw e;
+    }
+
+    return HasDeferredXRef();
+}
+
+bool PdfParser::TryFindPassword(InputStreamDevice& device, const cspan<string_view>& passwords, string& password)
+{
+    Reset();
+    password.clear();
+    try
+    {
+        if (!IsPdfFile(device))
+            PDFMM_RAISE_ERROR(PdfErrorCode::NoPdfFile);
+
+        readDocumentStructure(device);
+        readEncrypt(device);
+    }
+    catch (PdfError& e)
+    {
+        Reset();
+        PDFMM_PUSH_FRAME_INFO(e, "Unable to read the encryption dictionary");
+        throw e;
+    }
+
+    // Any password opens a document that is not encrypted
+    if (m_Encrypt == nullptr)
+        return true;
+
+    PdfStatsTimer timer(m_CollectStats ? &m_Stats.EncryptionSetupTime : nullptr);
+    auto documentId = GetDocumentId();
+    unsigned threadCount = m_ParseThreadCount == 0 ? m_Objects->GetExecutor()->GetConcurrency() : m_ParseThreadCount;
+
+    // Every worker authenticates its own copy of the encryption, as
+    // authenticating computes the keys. The first matching password
+    // in the list is found, the following ones are skipped then
+    atomic<size_t> found(passwords.size());
+    parallelFor(*m_Objects, passwords.size(), 1, threadCount, [&]()
+    {
+        auto encrypt = std::shared_ptr<PdfEncrypt>(PdfEncrypt::CreatePdfEncrypt(*m_Encrypt));
+        return [&passwords, &documentId, &found, encrypt](size_t i)
+        {
+            if (i > found || !encrypt->Authenticate(passwords[i], documentId))
+                return;
+
+            size_t curr = found;
+            while (i < curr && !found.compare_exchange_weak(curr, i));
+        };
+    });
+
+    if (found == passwords.size())
+        return false;
+
+    password = passwords[found];
+    m_password = password;
+    return true;
+}
+
+void PdfParser::ParseDeferredXRef(InputStreamDevice& device)
+{
+    if (!HasDeferredXRef())
+        return;
+
+    size_t offset = (size_t)m_DeferredXRefOffset;
+    m_DeferredXRefOffset = -1;
+    try
+    {
+        {
+            PdfStatsTimer timer(m_CollectStats ? &m_Stats.ReadXRefContentsTime : nullptr);
+            ReadXRefContents(device, offset);
+        }
+
+        PdfStatsTimer timer(m_CollectStats ? &m_Stats.ReadObjectsTime : nullptr);
+        ReadObjectsInternal(device);
+    }
+    catch (PdfError& e)
+    {
+        PDFMM_PUSH_FRAME_INFO(e, "Unable to load the main xref section");
+        throw e;
+    }
+
+    m_loadedEntries.clear();
+}
+
+void PdfParser::ParseUpdate(InputStreamDevice& device, size_t prevXRefOffset)
+{
+    // The deferred main section refers to the previous entries
+    m_Objects->loadDeferred();
+
+    device.Seek(0, SeekDirection::End);
+    size_t fileSize = device.GetPosition();
+    if (fileSize <= m_FileSize)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidXRef, "The device doesn't hold an update of the document");
+
+    m_FileSize = fileSize;
+    m_entries.Clear();
+    m_Trailer = nullptr;
+    m_visitedXRefOffsets.clear();
+    m_SkipPreviousXRef = true;
+    try
+    {
+        CheckEOFMarker(device);
+        FindXRef(device, &m_XRefOffset);
+        ReadXRefContents(device, m_XRefOffset);
+    }
+    catch (PdfError& e)
+    {
+        m_SkipPreviousXRef = false;
+        PDFMM_PUSH_FRAME_INFO(e, "Unable to load the update xref section");
+        throw e;
+    }
+    m_SkipPreviousXRef = false;
+
+    if (m_Trailer == nullptr || m_Trailer->GetDictionary().FindKeyAs<int64_t>("Prev", -1) != (int64_t)prevXRefOffset)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidXRef, "The update doesn't follow the loaded document");
+
+    for (unsigned i = 0; i < m_entries.GetSize(); i++)
+    {
+        auto& entry = m_entries[i];
+        if (!entry.Parsed || entry.Type != XRefEntryType::InUse)
+            continue;
+
+        auto obj = m_Objects->GetObject(PdfReference(i, (uint16_t)entry.Generation));
+        if (obj == nullptr || !obj->IsDelayedLoadDone())
+            continue;
+
+        // NOTE: The objects compressed in object streams are left dirty,
+        // as they can't be read again from an offset
+        auto parserObj = dynamic_cast<PdfParserObject*>(obj);
+        if (parserObj != nullptr)
+        {
+            parserObj->m_device = &device;
+            parserObj->m_Offset = (size_t)entry.Offset;
+        }
+
+        obj->ResetDirty();
+    }
+
+    m_entries.Clear();
+}
+
 void PdfParser::ReadDocumentStructure(InputStreamDevice& device)
 {
+    PdfStatsTimer timer(m_CollectStats ? &m_Stats.ReadDocumentStructureTime : nullptr);
+
     // position at the end of the file to search the xref table.
     device.Seek(0, SeekDirection::End);
     m_FileSize = device.GetPosition();
@@ -179,6 +458,7 @@ void PdfParser::ReadDocumentStructure(InputStreamDevice& device)
         // line in case of linearized PDFs. See ISO 32000-1:2008
         // "F.3.11 Main Cross-Reference and Trailer"
         // https://stackoverflow.com/a/70564329/213871
+        PdfStatsTimer timer(m_CollectStats ? &m_Stats.ReadXRefContentsTime : nullptr);
         ReadXRefContents(device, m_XRefOffset);
     }
     catch (PdfError& e)
@@ -202,6 +482,327 @@ void PdfParser::ReadDocumentStructure(InputStreamDevice& device)
     }
 }
 
+void PdfParser::readDocumentStructure(InputStreamDevice& device)
+{
+    if (!m_RebuildBrokenXRef)
+    {
+        ReadDocumentStructure(device);
+        return;
+    }
+
+    try
+    {
+        ReadDocumentStructure(device);
+        if (m_Trailer != nullptr && m_Trailer->GetDictionary().HasKey("Root")
+            && checkXRefOffsets(device))
+        {
+            return;
+        }
+
+        mm::LogMessage(PdfLogSeverity::Warning, "The xref entries are inconsistent, rebuilding them");
+    }
+    catch (PdfError& e)
+    {
+        mm::LogMessage(PdfLogSeverity::Warning, "Unable to read the xref entries ({}), rebuilding them",
+            PdfError::ErrorName(e.GetError()));
+    }
+
+    rebuildXRef(device);
+}
+
+bool PdfParser::hasObjectHeader(InputStreamDevice& device, size_t offset)
+{
+    // NOTE: The object number is not checked, as a different
+    // number is only reported when parsing the object
+    if (offset >= m_FileSize)
+        return false;
+
+    char buffer[PDF_OBJECT_HEADER_BUF];
+    bool eof;
+    device.Seek(offset);
+    size_t read = device.Read(buffer, PDF_OBJECT_HEADER_BUF, eof);
+    uint32_t objNum;
+    return tryReadObjectHeader(buffer, read, objNum);
+}
+
+bool PdfParser::checkXRefOffsets(InputStreamDevice& device)
+{
+    char buffer[PDF_OBJECT_HEADER_BUF];
+    for (unsigned i = 0; i < m_entries.GetSize(); i++)
+    {
+        auto& entry = m_entries[i];
+        if (!entry.Parsed || entry.Type != XRefEntryType::InUse || entry.Offset == 0)
+            continue;
+
+        if (entry.Offset >= m_FileSize)
+            return false;
+
+        bool eof;
+        device.Seek((size_t)entry.Offset);
+        size_t read = device.Read(buffer, PDF_OBJECT_HEADER_BUF, eof);
+        if (!checkObjectHeader(buffer, read, i))
+            return false;
+    }
+
+    return true;
+}
+
+void PdfParser::rebuildXRef(InputStreamDevice& device)
+{
+    PdfStatsTimer timer(m_CollectStats ? &m_Stats.ReadDocumentStructureTime : nullptr);
+
+    m_entries.Clear();
+    m_Trailer = nullptr;
+    m_visitedXRefOffsets.clear();
+    m_IncrementalUpdateCount = 0;
+    m_XRefOffset = 0;
+    m_XRefRebuilt = true;
+
+    device.Seek(0, SeekDirection::End);
+    m_FileSize = device.GetPosition();
+
+    // Offsets after the "trailer" keywords and of
+    // the objects that look like xref streams
+    vector<size_t> trailerOffsets;
+    vector<size_t> xrefStreamOffsets;
+    size_t objOffset = numeric_limits<size_t>::max();
+
+    // Search the keywords in the [from, to) range of the buffer. The
+    // object headers are read backward from the "obj" keyword, and the
+    // following objects override the previous ones with the same number,
+    // as it happens with incremental updates
+    auto scan = [&](const char* buffer, size_t from, size_t to, size_t length, size_t bufferOffset)
+    {
+        for (size_t i = from; ; i++)
+        {
+            i += FindAnyChar(buffer + i, to - i, 'j', 't', 'X');
+            if (i == to)
+                break;
+
+            switch (buffer[i])
+            {
+                case 'j':
+                {
+                    uint32_t objNum;
+                    uint16_t gen;
+                    size_t headerPos;
+                    if (i >= 2 && buffer[i - 2] == 'o' && buffer[i - 1] == 'b'
+                        && (i + 1 == length || !PdfTokenizer::IsRegular(buffer[i + 1]))
+                        && tryReadObjectHeaderBackward(buffer, i - 2, objNum, gen, headerPos)
+                        && objNum < s_MaxObjectCount)
+                    {
+                        objOffset = bufferOffset + headerPos;
+                        m_entries.Enlarge((int64_t)objNum + 1);
+                        auto& entry = m_entries[objNum];
+                        entry = PdfXRefEntry::CreateInUse(objOffset, gen);
+                        entry.Parsed = true;
+                    }
+                    break;
+                }
+                case 't':
+                {
+                    if (length - i >= 7 && std::memcmp(buffer + i, "trailer", 7) == 0
+                        && (i == 0 || !PdfTokenizer::IsRegular(buffer[i - 1]))
+                        && (i + 7 == length || !PdfTokenizer::IsRegular(buffer[i + 7])))
+                    {
+                        trailerOffsets.push_back(bufferOffset + i + 7);
+                    }
+                    break;
+                }
+                case 'X':
+                {
+                    // Remember the object owning the "/XRef" name, which
+                    // is supposedly the value of the /Type key
+                    if (i >= 1 && buffer[i - 1] == '/' && length - i >= 4
+                        && std::memcmp(buffer + i, "XRef", 4) == 0
+                        && (i + 4 == length || !PdfTokenizer::IsRegular(buffer[i + 4]))
+                        && objOffset != numeric_limits<size_t>::max()
+                        && (xrefStreamOffsets.size() == 0 || xrefStreamOffsets.back() != objOffset))
+                    {
+                        xrefStreamOffsets.push_back(objOffset);
+                    }
+                    break;
+                }
+            }
+        }
+    };
+
+    bufferview view;
+    if (device.TryGetView(view))
+    {
+        scan(view.data(), 0, view.size(), view.size(), 0);
+    }
+    else
+    {
+        // Read the file in large blocks, keeping the tail of the
+        // previous block in front of the buffer so the object headers
+        // and the keywords across two blocks are still found
+        constexpr size_t BlockSize = 1 << 20;
+        constexpr size_t Overlap = 64;
+        charbuff buffer(BlockSize + 2 * Overlap);
+        size_t kept = 0;
+        size_t from = 0;
+        size_t bufferOffset = 0;
+        device.Seek(0);
+        while (true)
+        {
+            bool eof;
+            size_t read = device.Read(buffer.data() + kept, BlockSize, eof);
+            size_t length = kept + read;
+            if (eof || read == 0)
+            {
+                scan(buffer.data(), from, length, length, bufferOffset);
+                break;
+            }
+
+            // Leave room for the longest keyword and the following character
+            size_t to = std::max(from, length < 8 ? 0 : length - 8);
+            scan(buffer.data(), from, to, length, bufferOffset);
+
+            size_t keepStart = to > Overlap ? to - Overlap : 0;
+            std::memmove(buffer.data(), buffer.data() + keepStart, length - keepStart);
+            kept = length - keepStart;
+            from = to - keepStart;
+            bufferOffset += keepStart;
+        }
+    }
+
+    m_Stats.XRefBytesRead += m_FileSize;
+    if (m_entries.GetSize() == 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidXRef, "No objects found while rebuilding the xref entries");
+
+    if (!m_entries[0].Parsed)
+    {
+        // The object 0 is always the head of the free objects list
+        m_entries[0] = PdfXRefEntry::CreateFree(0, 65535);
+        m_entries[0].Parsed = true;
+    }
+
+    // Read the trailer dictionaries and the xref streams from
+    // the newest, merging only the missing keys of the older ones
+    vector<pair<size_t, bool>> trailers;
+    for (size_t offset : trailerOffsets)
+        trailers.push_back({ offset, false });
+    for (size_t offset : xrefStreamOffsets)
+        trailers.push_back({ offset, true });
+    std::sort(trailers.begin(), trailers.end(), std::greater<pair<size_t, bool>>());
+
+    for (auto& trailer : trailers)
+    {
+        try
+        {
+            if (trailer.second)
+            {
+                readRebuiltXRefStream(device, trailer.first);
+            }
+            else
+            {
+                device.Seek(trailer.first);
+                unique_ptr<PdfParserObject> trailerObj(new PdfParserObject(m_Objects->GetDocument(), device));
+                trailerObj->SetIsTrailer(true);
+                (void)trailerObj->GetDictionary();
+                mergeRebuiltTrailer(std::move(trailerObj));
+            }
+        }
+        catch (PdfError&)
+        {
+            mm::LogMessage(PdfLogSeverity::Warning, "Skipping broken {} at offset {}",
+                trailer.second ? "xref stream" : "trailer", trailer.first);
+        }
+    }
+
+    if (m_Trailer == nullptr)
+        m_Trailer.reset(new PdfObject(PdfDictionary()));
+
+    PdfReference catalog;
+    if (!m_Trailer->GetDictionary().HasKey("Root"))
+    {
+        if (tryFindRebuiltCatalog(device, catalog))
+            m_Trailer->GetDictionary().AddKey("Root", catalog);
+        else
+            mm::LogMessage(PdfLogSeverity::Warning, "No catalog found while rebuilding the xref entries");
+    }
+
+    if (!m_Trailer->GetDictionary().HasKey(PdfName::KeySize))
+        m_Trailer->GetDictionary().AddKey(PdfName::KeySize, (int64_t)m_entries.GetSize());
+}
+
+void PdfParser::readRebuiltXRefStream(InputStreamDevice& device, size_t offset)
+{
+    // Only the compressed entries are taken from the xref stream:
+    // the offsets of the other objects are the scanned ones
+    PdfXRefEntries entries;
+    device.Seek(offset);
+    unique_ptr<PdfXRefStreamParserObject> xrefObj(new PdfXRefStreamParserObject(m_Objects->GetDocument(), device, entries));
+    xrefObj->Parse();
+    xrefObj->ParseStream();
+    xrefObj->ReadXRefTable();
+    m_Stats.XRefSectionCount++;
+    m_HasXRefStream = true;
+
+    for (unsigned i = 0; i < entries.GetSize(); i++)
+    {
+        auto& entry = entries[i];
+        if (!entry.Parsed || entry.Type != XRefEntryType::Compressed
+            || (i < m_entries.GetSize() && m_entries[i].Parsed))
+        {
+            continue;
+        }
+
+        m_entries.Enlarge((int64_t)i + 1);
+        m_entries[i] = entry;
+    }
+
+    mergeRebuiltTrailer(std::move(xrefObj));
+}
+
+bool PdfParser::tryFindRebuiltCatalog(InputStreamDevice& device, PdfReference& catalog)
+{
+    // There's no usable trailer: look for the newest
+    // catalog, parsing the objects from the end of the file
+    vector<pair<uint64_t, unsigned>> offsets;
+    for (unsigned i = 0; i < m_entries.GetSize(); i++)
+    {
+        auto& entry = m_entries[i];
+        if (entry.Parsed && entry.Type == XRefEntryType::InUse)
+            offsets.push_back({ entry.Offset, i });
+    }
+    std::sort(offsets.begin(), offsets.end(), std::greater<pair<uint64_t, unsigned>>());
+
+    for (auto& pair : offsets)
+    {
+        try
+        {
+            PdfReference reference(pair.second, (uint16_t)m_entries[pair.second].Generation);
+            PdfParserObject obj(m_Objects->GetDocument(), reference, device, (ssize_t)pair.first);
+            const PdfDictionary* dict;
+            if (!obj.TryGetDictionary(dict))
+                continue;
+
+            auto typeObj = dict->GetKey(PdfName::KeyType);
+            if (typeObj != nullptr && typeObj->IsName() && typeObj->GetName() == "Catalog")
+            {
+                catalog = reference;
+                return true;
+            }
+        }
+        catch (PdfError&)
+        {
+            // Skip the broken object
+        }
+    }
+
+    return false;
+}
+
+void PdfParser::mergeRebuiltTrailer(unique_ptr<PdfObject> trailer)
+{
+    if (m_Trailer == nullptr)
+        m_Trailer = std::move(trailer);
+    else
+        MergeTrailer(*trailer);
+}
+
 bool PdfParser::IsPdfFile(InputStreamDevice& device)
 {
     unsigned i = 0;
@@ -277,6 +878,10 @@ void PdfParser::ReadNextTrailer(InputStreamDevice& device)
             MergeTrailer(*trailer);
         }
 
+        // NOTE: The trailer is parsed on the first access
+        (void)trailer->GetDictionary();
+        m_Stats.XRefBytesRead += trailer->GetReadLength();
+
         if (trailer->GetDictionary().HasKey("XRefStm"))
         {
             // Whenever we read a XRefStm key, 
@@ -306,7 +911,7 @@ void PdfParser::ReadNextTrailer(InputStreamDevice& device)
                 size_t offset = static_cast<size_t>(trailer->GetDictionary().FindKeyAs<int64_t>("Prev", 0));
 
                 if (m_visitedXRefOffsets.find(offset) == m_visitedXRefOffsets.end())
-                    ReadXRefContents(device, offset);
+                    readPreviousXRef(device, offset);
                 else
                     mm::LogMessage(PdfLogSeverity::Warning, "XRef contents at offset {} requested twice, skipping the second read",
                         static_cast<int64_t>(offset));
@@ -320,8 +925,68 @@ void PdfParser::ReadNextTrailer(InputStreamDevice& device)
     }
     else // Else belongs to IsNextToken("trailer") and not to HasKey("Prev")
     {
-        PDFMM_RAISE_ERROR(PdfErrorCode::NoTrailer);
+        PDFMM_RAISE_ERROR(PdfErrorCode::NoTrailer);
+    }
+}
+
+bool PdfParser::tryReadLinearizationDict(InputStreamDevice& device)
+{
+    // ISO 32000-1:2008 "F.3.3 Linearization Parameter Dictionary (Part 2)":
+    // the dictionary shall be the first indirect object in the file
+    size_t position = device.GetPosition();
+    device.Seek(0, SeekDirection::End);
+    m_FileSize = device.GetPosition();
+    device.Seek(position);
+
+    PdfVariant variant;
+    try
+    {
+        (void)m_tokenizer.ReadNextNumber(device);
+        (void)m_tokenizer.ReadNextNumber(device);
+        if (!m_tokenizer.IsNextToken(device, "obj"))
+            return false;
+
+        m_tokenizer.ReadNextVariant(device, variant);
+        if (!m_tokenizer.IsNextToken(device, "endobj"))
+            return false;
+    }
+    catch (PdfError&)
+    {
+        // Not a valid linearization dictionary
+        return false;
+    }
+
+    PdfDictionary* dict;
+    if (!variant.TryGetDictionary(dict) || dict->FindKey("Linearized") == nullptr)
+        return false;
+
+    // If the file length differs from /L, the file has been
+    // incrementally updated and the linearization is no longer valid
+    int64_t length = dict->FindKeyAs<int64_t>("L", -1);
+    int64_t firstPage = dict->FindKeyAs<int64_t>("O", -1);
+    if (length != (int64_t)m_FileSize || firstPage <= 0)
+        return false;
+
+    m_FirstPageObjectNumber = (uint32_t)firstPage;
+    m_XRefLinearizedOffset = device.GetPosition();
+    return true;
+}
+
+void PdfParser::readPreviousXRef(InputStreamDevice& device, size_t offset)
+{
+    if (m_SkipPreviousXRef)
+        return;
+
+    if (m_DeferXRef)
+    {
+        // This is the main xref section of a linearized
+        // file, which is read only when requested
+        m_DeferXRef = false;
+        m_DeferredXRefOffset = (ssize_t)offset;
+        return;
     }
+
+    ReadXRefContents(device, offset);
 }
 
 void PdfParser::FindXRef(InputStreamDevice& device, size_t* xRefOffset)
@@ -406,6 +1071,9 @@ void PdfParser::ReadXRefContents(InputStreamDevice& device, size_t offset, bool
         }
     }
 
+    PDFMM_TRACE_SCOPE(trace, XRefSectionRead, &m_Objects->GetDocument());
+    m_Stats.XRefSectionCount++;
+
     // read all xref subsections
     for (unsigned xrefSectionCount = 0; ; xrefSectionCount++)
     {
@@ -451,6 +1119,11 @@ void PdfParser::ReadXRefContents(InputStreamDevice& device, size_t offset, bool
         }
     }
 
+    m_Stats.XRefBytesRead += device.GetPosition() - offset;
+    PDFMM_TRACE_SET(trace, Offset, offset);
+    PDFMM_TRACE_SET(trace, InputLength, device.GetPosition() - offset);
+    PDFMM_TRACE_END(trace);
+
     try
     {
         ReadNextTrailer(device);
@@ -497,44 +1170,55 @@ void PdfParser::ReadXRefSubsection(InputStreamDevice& device, int64_t& firstObje
     while (device.Peek(ch) && m_tokenizer.IsWhitespace(ch))
         (void)device.ReadChar();
 
-    unsigned index = 0;
-    char* buffer = m_buffer->data();
-    while (index < objectCount)
+    // The sections are read from the newest one, and the parsed entries
+    // are already defined by a newer section. Skip the subsection if all
+    // its entries are parsed, so older sections only fill the gaps
+    unsigned first = (unsigned)firstObject;
+    unsigned count = (unsigned)objectCount;
+    size_t length = (size_t)count * PDF_XREF_ENTRY_SIZE;
+    unsigned parsedCount = 0;
+    while (parsedCount < count && m_entries[first + parsedCount].Parsed)
+        parsedCount++;
+
+    if (parsedCount == count && device.GetPosition() + length <= m_FileSize)
     {
-        device.Read(buffer, PDF_XREF_ENTRY_SIZE);
-
-        char empty1;
-        char empty2;
-        buffer[PDF_XREF_ENTRY_SIZE] = '\0';
-
-        unsigned objIndex = static_cast<unsigned>(firstObject + index);
+        device.Seek((ssize_t)length, SeekDirection::Current);
+        m_Stats.ShadowedXRefEntryCount += count;
+        return;
+    }
 
-        auto& entry = m_entries[objIndex];
-        if (objIndex < m_entries.GetSize() && !entry.Parsed)
+    // Read the entries in blocks, parsing only the ones not yet defined
+    unsigned blockCount = (unsigned)(m_buffer->size() / PDF_XREF_ENTRY_SIZE);
+    char* buffer = m_buffer->data();
+    bool eof = false;
+    unsigned index = 0;
+    while (index < count && !eof)
+    {
+        unsigned readCount = std::min(count - index, blockCount);
+        size_t read = device.Read(buffer, (size_t)readCount * PDF_XREF_ENTRY_SIZE, eof);
+        readCount = (unsigned)(read / PDF_XREF_ENTRY_SIZE);
+        for (unsigned i = 0; i < readCount; i++, index++)
         {
-            uint64_t variant = 0;
-            uint32_t generation = 0;
-            char chType = 0;
-
-            // XRefEntry is defined in PDF spec section 7.5.4 Cross-Reference Table as
-            // nnnnnnnnnn ggggg n eol
-            // nnnnnnnnnn is 10-digit offset number with max value 9999999999 (bigger than 2**32 = 4GB)
-            // ggggg is a 5-digit generation number with max value 99999 (smaller than 2**17)
-            // eol is a 2-character end-of-line sequence
-            int read = sscanf(buffer, "%10" SCNu64 " %5" SCNu32 " %c%c%c",
-                &variant, &generation, &chType, &empty1, &empty2);
-
-            if (!CheckXRefEntryType(chType))
-                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidXRef, "Invalid used keyword, must be eiter 'n' or 'f'");
-
-            XRefEntryType type = XRefEntryTypeFromChar(chType);
+            auto& entry = m_entries[first + index];
+            if (entry.Parsed)
+            {
+                m_Stats.ShadowedXRefEntryCount++;
+                continue;
+            }
 
-            if (read != 5 || !CheckEOL(empty1, empty2))
+            uint64_t variant;
+            uint32_t generation;
+            char chType;
+            if (!tryParseXRefEntry(buffer + i * PDF_XREF_ENTRY_SIZE, variant, generation, chType))
             {
-                // part of XrefEntry is missing, or i/o error
+                // part of XrefEntry is missing
                 PDFMM_RAISE_ERROR(PdfErrorCode::InvalidXRef);
             }
 
+            if (!CheckXRefEntryType(chType))
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidXRef, "Invalid used keyword, must be eiter 'n' or 'f'");
+
+            XRefEntryType type = XRefEntryTypeFromChar(chType);
             switch (type)
             {
                 case XRefEntryType::Free:
@@ -567,14 +1251,13 @@ void PdfParser::ReadXRefSubsection(InputStreamDevice& device, int64_t& firstObje
             entry.Type = type;
             entry.Parsed = true;
         }
-
-        index++;
     }
 
-    if (index != (unsigned)objectCount)
+    if (index != count)
     {
+        // The device ended before the last entry
         mm::LogMessage(PdfLogSeverity::Warning, "Count of readobject is {}. Expected {}", index, objectCount);
-        PDFMM_RAISE_ERROR(PdfErrorCode::NoXRef);
+        PDFMM_RAISE_ERROR(PdfErrorCode::UnexpectedEOF);
     }
 }
 
@@ -582,6 +1265,7 @@ void PdfParser::ReadXRefStreamContents(InputStreamDevice& device, size_t offset,
 {
     PdfRecursionGuard guard(m_RecursionDepth);
 
+    PDFMM_TRACE_SCOPE(trace, XRefSectionRead, &m_Objects->GetDocument());
     device.Seek(offset);
     auto xrefObjTrailer = new PdfXRefStreamParserObject(m_Objects->GetDocument(), device, m_entries);
     try
@@ -596,6 +1280,9 @@ void PdfParser::ReadXRefStreamContents(InputStreamDevice& device, size_t offset,
         throw ex;
     }
 
+    m_Stats.XRefSectionCount++;
+    m_Stats.XRefBytesRead += xrefObjTrailer->GetReadLength();
+
     unique_ptr<PdfXRefStreamParserObject> xrefObjectTemp;
     if (m_Trailer == nullptr)
     {
@@ -607,10 +1294,13 @@ void PdfParser::ReadXRefStreamContents(InputStreamDevice& device, size_t offset,
         MergeTrailer(*xrefObjTrailer);
     }
 
+    PDFMM_TRACE_SET(trace, Offset, offset);
+    PDFMM_TRACE_SET(trace, InputLength, xrefObjTrailer->GetReadLength());
     if (readOnlyTrailer)
         return;
 
     xrefObjTrailer->ReadXRefTable();
+    PDFMM_TRACE_END(trace);
 
     // Check for a previous XRefStm or xref table
     size_t previousOffset;
@@ -623,7 +1313,10 @@ void PdfParser::ReadXRefStreamContents(InputStreamDevice& device, size_t offset,
             // PDFs that have been through multiple PDF tools may have a mix of xref tables (ISO 32000-1 7.5.4) 
             // and XRefStm streams (ISO 32000-1 7.5.8.1) and in the Prev chain, 
             // so call ReadXRefContents (which deals with both) instead of ReadXRefStreamContents 
-            ReadXRefContents(device, previousOffset, readOnlyTrailer);
+            if (readOnlyTrailer)
+                ReadXRefContents(device, previousOffset, readOnlyTrailer);
+            else
+                readPreviousXRef(device, previousOffset);
         }
         catch (PdfError& e)
         {
@@ -641,54 +1334,13 @@ void PdfParser::ReadXRefStreamContents(InputStreamDevice& device, size_t offset,
 void PdfParser::ReadObjects(InputStreamDevice& device)
 {
     PDFMM_ASSERT(m_Trailer != nullptr);
-    // Check for encryption and make sure that the encryption object
+    PdfStatsTimer timer(m_CollectStats ? &m_Stats.ReadObjectsTime : nullptr);
+    // Make sure that the encryption object
     // is loaded before all other objects
-    PdfObject* encrypt = m_Trailer->GetDictionary().GetKey("Encrypt");
-    if (encrypt != nullptr && !encrypt->IsNull())
+    readEncrypt(device);
+    if (m_Encrypt != nullptr)
     {
-#ifdef PDFMM_VERBOSE_DEBUG
-        mm::LogMessage(PdfLogSeverity::Debug, "The PDF file is encrypted");
-#endif // PDFMM_VERBOSE_DEBUG
-
-        if (encrypt->IsReference())
-        {
-            unsigned i = encrypt->GetReference().ObjectNumber();
-            if (i <= 0 || i >= m_entries.GetSize())
-            {
-                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidEncryptionDict,
-                    "Encryption dictionary references a nonexistent object {} {} R",
-                    encrypt->GetReference().ObjectNumber(), encrypt->GetReference().GenerationNumber());
-            }
-
-            // The encryption dictionary is not encrypted
-            unique_ptr<PdfParserObject> obj(new PdfParserObject(device, (ssize_t)m_entries[i].Offset));
-            try
-            {
-                obj->Parse();
-                // Never add the encryption dictionary to m_Objects
-                // we create a new one, if we need it for writing
-                // m_Objects->push_back( obj );
-                m_entries[i].Parsed = false;
-                m_Encrypt = PdfEncrypt::CreatePdfEncrypt(*obj);
-            }
-            catch (PdfError& e)
-            {
-                PDFMM_PUSH_FRAME_INFO(e, "Error while loading object {} {} R",
-                    obj->GetIndirectReference().ObjectNumber(),
-                    obj->GetIndirectReference().GenerationNumber());
-                throw e;
-
-            }
-        }
-        else if (encrypt->IsDictionary())
-        {
-            m_Encrypt = PdfEncrypt::CreatePdfEncrypt(*encrypt);
-        }
-        else
-        {
-            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidEncryptionDict,
-                "The encryption entry in the trailer is neither an object nor a reference");
-        }
+        PdfStatsTimer encryptTimer(m_CollectStats ? &m_Stats.EncryptionSetupTime : nullptr);
 
         // Generate encryption keys
         bool isAuthenticated = m_Encrypt->Authenticate(m_password, this->GetDocumentId());
@@ -703,8 +1355,91 @@ void PdfParser::ReadObjects(InputStreamDevice& device)
     ReadObjectsInternal(device);
 }
 
+void PdfParser::readEncrypt(InputStreamDevice& device)
+{
+    // Check for encryption
+    PdfObject* encrypt = m_Trailer->GetDictionary().GetKey("Encrypt");
+    if (encrypt == nullptr || encrypt->IsNull())
+        return;
+
+#ifdef PDFMM_VERBOSE_DEBUG
+    mm::LogMessage(PdfLogSeverity::Debug, "The PDF file is encrypted");
+#endif // PDFMM_VERBOSE_DEBUG
+    PdfStatsTimer encryptTimer(m_CollectStats ? &m_Stats.EncryptionSetupTime : nullptr);
+
+    if (encrypt->IsReference())
+    {
+        unsigned i = encrypt->GetReference().ObjectNumber();
+        if (i <= 0 || i >= m_entries.GetSize())
+        {
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidEncryptionDict,
+                "Encryption dictionary references a nonexistent object {} {} R",
+                encrypt->GetReference().ObjectNumber(), encrypt->GetReference().GenerationNumber());
+        }
+
+        // The encryption dictionary is not encrypted
+        unique_ptr<PdfParserObject> obj(new PdfParserObject(device, (ssize_t)m_entries[i].Offset));
+        try
+        {
+            obj->Parse();
+            // Never add the encryption dictionary to m_Objects
+            // we create a new one, if we need it for writing
+            // m_Objects->push_back( obj );
+            m_entries[i].Parsed = false;
+            m_Encrypt = PdfEncrypt::CreatePdfEncrypt(*obj);
+        }
+        catch (PdfError& e)
+        {
+            PDFMM_PUSH_FRAME_INFO(e, "Error while loading object {} {} R",
+                obj->GetIndirectReference().ObjectNumber(),
+                obj->GetIndirectReference().GenerationNumber());
+            throw e;
+
+        }
+    }
+    else if (encrypt->IsDictionary())
+    {
+        m_Encrypt = PdfEncrypt::CreatePdfEncrypt(*encrypt);
+    }
+    else
+    {
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidEncryptionDict,
+            "The encryption entry in the trailer is neither an object nor a reference");
+    }
+}
+
 void PdfParser::ReadObjectsInternal(InputStreamDevice& device)
 {
+    // Objects are parsed concurrently only when fully loading
+    // a document from contiguous memory. The streams of documents
+    // encrypted with AES are also decrypted concurrently, while RC4
+    // streams share the key schedule of the encryption and are
+    // read serially, as the objects of these documents
+    unsigned threadCount = m_ParseThreadCount == 0 ? m_Objects->GetExecutor()->GetConcurrency() : m_ParseThreadCount;
+    bufferview view;
+    bool parseParallel = !m_LoadOnDemand && threadCount > 1
+        && (m_Encrypt == nullptr
+            || m_Encrypt->GetEncryptAlgorithm() == PdfEncryptAlgorithm::AESV2
+#ifdef PDFMM_HAVE_LIBIDN
+            || m_Encrypt->GetEncryptAlgorithm() == PdfEncryptAlgorithm::AESV3
+#endif
+            )
+        && device.TryGetView(view);
+    vector<PdfParserObject*> objectsToParse;
+
+    // The objects of encrypted documents read serially are parsed
+    // below, skipping the broken ones in lenient mode: check their
+    // headers first, so the objects with a broken header are
+    // skipped without raising an error for each of them
+    bool checkHeaders = m_IgnoreBrokenObjects && m_Encrypt != nullptr && !parseParallel;
+
+    // When loading on demand, the in-use objects are just listed with their
+    // xref entries and created on their first lookup, so the time and the
+    // memory to open a document don't scale with the count of the objects
+    bool createLazily = m_LoadOnDemand && !checkHeaders;
+    if (createLazily)
+        setLazyObjectFactory(device);
+
     // Read objects
     for (unsigned i = 0; i < m_entries.GetSize(); i++)
     {
@@ -715,6 +1450,12 @@ void PdfParser::ReadObjectsInternal(InputStreamDevice& device)
             << entry.Offset << " "
             << entry.Generation << endl;
 #endif
+        if (i < m_loadedEntries.size() && m_loadedEntries[i])
+        {
+            // Already read from the first-page section
+            continue;
+        }
+
         if (entry.Parsed)
         {
             switch (entry.Type)
@@ -724,11 +1465,30 @@ void PdfParser::ReadObjectsInternal(InputStreamDevice& device)
                     if (entry.Offset > 0)
                     {
                         PdfReference reference(i, (uint16_t)entry.Generation);
+                        if (createLazily)
+                        {
+                            m_Objects->AddLazyObject(reference, entry);
+                            break;
+                        }
+
                         unique_ptr<PdfParserObject> obj(new PdfParserObject(m_Objects->GetDocument(), reference, device, (ssize_t)entry.Offset));
+                        if (checkHeaders && !hasObjectHeader(device, (size_t)entry.Offset))
+                        {
+                            mm::LogMessage(PdfLogSeverity::Error, "Broken header of object {} {} R, Offset={}, Index={}",
+                                reference.ObjectNumber(), reference.GenerationNumber(), entry.Offset, i);
+                            m_Objects->SafeAddFreeObject(reference);
+                            m_Stats.BrokenObjectCount++;
+                            break;
+                        }
+
                         try
                         {
                             obj->SetEncrypt(m_Encrypt.get());
-                            if (m_Encrypt != nullptr && obj->IsDictionary())
+                            obj->SetLazyNestedArrays(m_LoadOnDemand);
+                            obj->SetLazyStringDecryption(m_LoadOnDemand);
+                            // NOTE: The XRef streams of objects parsed concurrently
+                            // are searched later, not to parse the objects here
+                            if (m_Encrypt != nullptr && !parseParallel && obj->IsDictionary())
                             {
                                 auto typeObj = obj->GetDictionary().GetKey(PdfName::KeyType);
                                 if (typeObj != nullptr && typeObj->IsName() && typeObj->GetName() == "XRef")
@@ -740,6 +1500,9 @@ void PdfParser::ReadObjectsInternal(InputStreamDevice& device)
                                 }
                             }
 
+                            if (parseParallel)
+                                objectsToParse.push_back(obj.get());
+
                             m_Objects->PushObject(obj.release());
                         }
                         catch (PdfError& e)
@@ -751,6 +1514,7 @@ void PdfParser::ReadObjectsInternal(InputStreamDevice& device)
                                     obj->GetIndirectReference().GenerationNumber(),
                                     entry.Offset, i);
                                 m_Objects->SafeAddFreeObject(reference);
+                                m_Stats.BrokenObjectCount++;
                             }
                             else
                             {
@@ -793,14 +1557,18 @@ void PdfParser::ReadObjectsInternal(InputStreamDevice& device)
                     break;
                 }
                 case XRefEntryType::Compressed:
-                    // CHECK-ME
+                {
+                    // Group the compressed objects by the containing
+                    // object stream, to read them all in a single pass
+                    m_ObjectStreams[(uint32_t)entry.ObjectNumber].push_back(static_cast<int64_t>(i));
                     break;
+                }
                 default:
                     PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
 
             }
         }
-        else if (i != 0) // Unparsed
+        else if (i != 0 && !HasDeferredXRef()) // Unparsed
         {
             m_Objects->AddFreeObject(PdfReference(i, 1));
         }
@@ -812,24 +1580,41 @@ void PdfParser::ReadObjectsInternal(InputStreamDevice& device)
         // robustly from all places which are either free or unparsed
     }
 
+    if (parseParallel)
+    {
+        parseObjectsParallel(view, objectsToParse, threadCount);
+        if (m_Encrypt != nullptr)
+        {
+            replaceEncryptedXRefStreams(device, objectsToParse);
+            decryptStreamsParallel(view, objectsToParse, threadCount);
+        }
+    }
+
     // all normal objects including object streams are available now,
     // we can parse the object streams safely now.
     //
     // Note that even if demand loading is enabled we still currently read all
     // objects from the stream into memory then free the stream.
     //
-    for (unsigned i = 0; i < m_entries.GetSize(); i++)
-    {
-        PdfXRefEntry& entry = m_entries[i];
-        if (entry.Parsed && entry.Type == XRefEntryType::Compressed) // we have an compressed object stream
-        {
 #ifndef VERBOSE_DEBUG_DISABLED
-            if (m_LoadOnDemand) cerr << "Demand loading on, but can't demand-load from object stream." << endl;
+    if (m_LoadOnDemand && m_ObjectStreams.size() != 0)
+        cerr << "Demand loading on, but can't demand-load from object stream." << endl;
 #endif
-            ReadCompressedObjectFromStream((uint32_t)entry.ObjectNumber, static_cast<int>(entry.Index));
+    {
+        PdfStatsTimer timer(m_CollectStats ? &m_Stats.ReadCompressedObjectsTime : nullptr);
+        if (parseParallel && m_ObjectStreams.size() > 1)
+        {
+            readObjectStreamsParallel(threadCount);
+        }
+        else
+        {
+            for (auto& pair : m_ObjectStreams)
+                ReadCompressedObjectFromStream(pair.first, pair.second);
         }
     }
 
+    m_ObjectStreams.clear();
+
     if (!m_LoadOnDemand)
     {
         // Force loading of streams. We can't do this during the initial
@@ -838,26 +1623,175 @@ void PdfParser::ReadObjectsInternal(InputStreamDevice& device)
         // in a second pass, or (if demand loading is enabled) defer it for later.
         for (auto objToLoad : *m_Objects)
         {
+            // NOTE: Objects read from object streams are already fully loaded
             auto obj = dynamic_cast<PdfParserObject*>(objToLoad);
-            obj->ParseStream();
+            if (obj != nullptr)
+                obj->ParseStream();
         }
     }
 
     UpdateDocumentVersion();
+
+    if (m_CollectStats)
+    {
+        // Objects parsed in previous passes are counted again. The objects
+        // listed lazily are counted without creating them
+        m_Stats.ObjectCount = (unsigned)m_Objects->m_Objects.size() + m_Objects->m_LazyObjectCount;
+        m_Stats.ObjectBytesRead = 0;
+        for (auto obj : m_Objects->m_Objects)
+        {
+            auto parserObj = dynamic_cast<PdfParserObject*>(obj);
+            if (parserObj != nullptr)
+                m_Stats.ObjectBytesRead += parserObj->GetReadLength();
+        }
+    }
+}
+
+void PdfParser::setLazyObjectFactory(InputStreamDevice& device)
+{
+    // NOTE: The factory outlives the parsing, so it doesn't refer to
+    // the parser. The device and the encryption are kept by the document
+    auto doc = &m_Objects->GetDocument();
+    auto encrypt = m_Encrypt.get();
+    m_Objects->SetLazyObjectFactory([doc, device = &device, encrypt](const PdfReference& reference, const PdfXRefEntry& entry)
+    {
+        unique_ptr<PdfParserObject> obj(new PdfParserObject(*doc, reference, *device, (ssize_t)entry.Offset));
+        obj->SetEncrypt(encrypt);
+        obj->SetLazyNestedArrays(true);
+        obj->SetLazyStringDecryption(true);
+        if (encrypt == nullptr)
+            return obj.release();
+
+        try
+        {
+            if (obj->IsDictionary())
+            {
+                auto typeObj = obj->GetDictionary().GetKey(PdfName::KeyType);
+                if (typeObj != nullptr && typeObj->IsName() && typeObj->GetName() == "XRef")
+                {
+                    // XRef is never encrypted
+                    obj.reset(new PdfParserObject(*doc, reference, *device, (ssize_t)entry.Offset));
+                    obj->DelayedLoad();
+                }
+            }
+        }
+        catch (PdfError& e)
+        {
+            PDFMM_PUSH_FRAME_INFO(e, "Error while loading object {} {} R, Offset={}",
+                reference.ObjectNumber(), reference.GenerationNumber(), entry.Offset);
+            throw e;
+        }
+
+        return obj.release();
+    });
+}
+
+void PdfParser::parseObjectsParallel(const bufferview& view, const vector<PdfParserObject*>& objects, unsigned threadCount)
+{
+    // Objects are handed out in small batches to keep the
+    // workers balanced, since object sizes vary a lot
+    constexpr size_t BatchSize = 64;
+    parallelFor(*m_Objects, objects.size(), BatchSize, threadCount, [&]()
+    {
+        // Each worker reads from a private cursor on the same data
+        auto device = std::make_shared<SpanStreamDevice>(view);
+        return [&objects, device](size_t i)
+        {
+            objects[i]->Parse(*device);
+        };
+    });
+}
+
+void PdfParser::replaceEncryptedXRefStreams(InputStreamDevice& device, vector<PdfParserObject*>& objects)
+{
+    for (auto& obj : objects)
+    {
+        if (!obj->IsDictionary())
+            continue;
+
+        auto typeObj = obj->GetDictionary().GetKey(PdfName::KeyType);
+        if (typeObj == nullptr || !typeObj->IsName() || typeObj->GetName() != "XRef")
+            continue;
+
+        // XRef is never encrypted
+        auto reference = obj->GetIndirectReference();
+        unique_ptr<PdfParserObject> newObj(new PdfParserObject(m_Objects->GetDocument(), reference, device, (ssize_t)obj->GetOffset()));
+        newObj->DelayedLoad();
+        obj = newObj.get();
+        (void)m_Objects->ReplaceObject(reference, newObj.release());
+    }
+}
+
+void PdfParser::decryptStreamsParallel(const bufferview& view, const vector<PdfParserObject*>& objects, unsigned threadCount)
+{
+    vector<PdfParserObject*> streams;
+    for (auto obj : objects)
+    {
+        if (obj->HasStreamToParse())
+            streams.push_back(obj);
+    }
+
+    // Stream sizes vary even more than object sizes, so
+    // they are handed out one at a time
+    parallelFor(*m_Objects, streams.size(), 1, threadCount, [&]()
+    {
+        auto device = std::make_shared<SpanStreamDevice>(view);
+        return [&streams, device](size_t i)
+        {
+            streams[i]->DecryptStream(*device);
+        };
+    });
 }
 
-void PdfParser::ReadCompressedObjectFromStream(uint32_t objNo, int index)
+void PdfParser::readObjectStreamsParallel(unsigned threadCount)
 {
-    // NOTE: index of the compressed object is ignored since
-    // we eagerly read all the objects from the stream
-    (void)index;
+    // Load sequentially the object streams data from the input device:
+    // after that decoding the streams doesn't read the device
+    // anymore nor modifies the objects vector
+    vector<PdfParserObject*> streams;
+    vector<const PdfObjectStreamParser::ObjectIdList*> objectIds;
+    for (auto& pair : m_ObjectStreams)
+    {
+        auto stream = getObjectStream(pair.first);
+        if (stream == nullptr)
+            continue;
+
+        stream->ParseStream();
+        streams.push_back(stream);
+        objectIds.push_back(&pair.second);
+    }
+
+    vector<PdfObjectStreamParser::ObjectList> objects(streams.size());
+    parallelFor(*m_Objects, streams.size(), 1, threadCount, [&]()
+    {
+        // The tokenizer buffer can't be shared between threads
+        auto buffer = std::make_shared<charbuff>(PdfTokenizer::BufferSize);
+        return [&, buffer](size_t i)
+        {
+            PdfObjectStreamParser parserObject(*streams[i], *m_Objects, buffer);
+            parserObject.Read(*objectIds[i], objects[i]);
+        };
+    });
+
+    for (auto& streamObjects : objects)
+    {
+        for (auto& obj : streamObjects)
+            m_Objects->PushObject(obj.release());
+    }
+}
 
-    // If we already have read all objects from this stream just return
-    if (m_ObjectStreams.find(objNo) != m_ObjectStreams.end())
+void PdfParser::ReadCompressedObjectFromStream(uint32_t objNo, const vector<int64_t>& objectIds)
+{
+    auto stream = getObjectStream(objNo);
+    if (stream == nullptr)
         return;
 
-    m_ObjectStreams.insert(objNo);
+    PdfObjectStreamParser parserObject(*stream, *m_Objects, m_buffer);
+    parserObject.Parse(objectIds);
+}
 
+PdfParserObject* PdfParser::getObjectStream(uint32_t objNo)
+{
     // generation number of object streams is always 0
     auto stream = dynamic_cast<PdfParserObject*>(m_Objects->GetObject(PdfReference(objNo, 0)));
     if (stream == nullptr)
@@ -865,7 +1799,8 @@ void PdfParser::ReadCompressedObjectFromStream(uint32_t objNo, int index)
         if (m_IgnoreBrokenObjects)
         {
             mm::LogMessage(PdfLogSeverity::Error, "Loading of object {} 0 R failed!", objNo);
-            return;
+            m_Stats.BrokenObjectCount++;
+            return nullptr;
         }
         else
         {
@@ -873,19 +1808,7 @@ void PdfParser::ReadCompressedObjectFromStream(uint32_t objNo, int index)
         }
     }
 
-    PdfObjectStreamParser::ObjectIdList list;
-    for (unsigned i = 0; i < m_entries.GetSize(); i++)
-    {
-        PdfXRefEntry& entry = m_entries[i];
-        if (entry.Parsed && entry.Type == XRefEntryType::Compressed &&
-            m_entries[i].ObjectNumber == objNo)
-        {
-            list.push_back(static_cast<int64_t>(i));
-        }
-    }
-
-    PdfObjectStreamParser parserObject(*stream, *m_Objects, m_buffer);
-    parserObject.Parse(list);
+    return stream;
 }
 
 void PdfParser::FindTokenBackward(InputStreamDevice& device, const char* token, size_t range)
@@ -902,13 +1825,7 @@ void PdfParser::FindTokenBackward(InputStreamDevice& device, const char* token,
 
     // search backwards in the buffer in case the buffer contains null bytes
     // because it is right after a stream (can't use strstr for this reason)
-    ssize_t i; // Do not use an unsigned variable here
-    size_t tokenLen = char_traits<char>::length(token);
-    for (i = searchSize - tokenLen; i >= 0; i--)
-    {
-        if (std::strncmp(buffer + i, token, tokenLen) == 0)
-            break;
-    }
+    ssize_t i = findTokenBackward(buffer, searchSize, token);
 
     if (i == 0)
         PDFMM_RAISE_ERROR(PdfErrorCode::InternalLogic);
@@ -931,13 +1848,7 @@ void PdfParser::FindToken2(InputStreamDevice& device, const char* token, const s
 
     // search backwards in the buffer in case the buffer contains null bytes
     // because it is right after a stream (can't use strstr for this reason)
-    ssize_t i; // Do not use an unsigned variable here
-    size_t tokenLen = char_traits<char>::length(token);
-    for (i = searchSize - tokenLen; i >= 0; i--)
-    {
-        if (std::strncmp(buffer + i, token, tokenLen) == 0)
-            break;
-    }
+    ssize_t i = findTokenBackward(buffer, searchSize, token);
 
     if (i == 0)
         PDFMM_RAISE_ERROR(PdfErrorCode::InternalLogic);
@@ -1002,31 +1913,45 @@ void PdfParser::CheckEOFMarker(InputStreamDevice& device)
     }
     else
     {
-        // Search for the Marker from the end of the file
-        ssize_t currentPos = (ssize_t)device.GetPosition();
-
-        bool found = false;
-        while (true)
+        // Search for the Marker from the end of the file. Read large
+        // blocks, since there may be a lot of garbage after the marker
+        size_t eofPos = string_view::npos;
+        bufferview view;
+        if (device.TryGetView(view))
+        {
+            eofPos = string_view(view.data(), view.size()).rfind(EOFToken);
+        }
+        else
         {
-            device.Read(buff, EOFTokenLen);
-            if (std::strncmp(buff, EOFToken, EOFTokenLen) == 0)
+            constexpr size_t BlockSize = 65536;
+            charbuff block(BlockSize);
+            size_t end = m_FileSize;
+            while (true)
             {
-                found = true;
-                break;
-            }
+                size_t start = end > BlockSize ? end - BlockSize : 0;
+                device.Seek((ssize_t)start, SeekDirection::Begin);
+                device.Read(block.data(), end - start);
+                size_t found = string_view(block.data(), end - start).rfind(EOFToken);
+                if (found != string_view::npos)
+                {
+                    eofPos = start + found;
+                    break;
+                }
 
-            currentPos--;
-            if (currentPos < 0)
-                break;
+                if (start == 0)
+                    break;
 
-            device.Seek(currentPos, SeekDirection::Begin);
+                // Overlap the blocks so a marker crossing them is found
+                end = start + EOFTokenLen - 1;
+            }
         }
 
         // Try and deal with garbage by offsetting the buffer reads in PdfParser from now on
-        if (found)
-            m_LastEOFOffset = (m_FileSize - (device.GetPosition() - 1)) + EOFTokenLen;
-        else
+        if (eofPos == string_view::npos)
             PDFMM_RAISE_ERROR(PdfErrorCode::NoEOFToken);
+
+        device.Seek((ssize_t)(eofPos + EOFTokenLen), SeekDirection::Begin);
+        m_LastEOFOffset = (m_FileSize - (eofPos + EOFTokenLen - 1)) + EOFTokenLen;
     }
 }
 
@@ -1059,6 +1984,14 @@ void PdfParser::SetMaxObjectCount(unsigned maxObjectCount)
 }
 
 // Read magic word keeping cursor
+// Returns the position of the last occurrence of
+// the token in the buffer, or -1 if not found
+ssize_t findTokenBackward(const char* buffer, size_t size, const string_view& token)
+{
+    size_t pos = string_view(buffer, size).rfind(token);
+    return pos == string_view::npos ? -1 : (ssize_t)pos;
+}
+
 bool ReadMagicWord(char ch, unsigned& cursoridx)
 {
     bool readchar;
@@ -1099,3 +2032,128 @@ bool ReadMagicWord(char ch, unsigned& cursoridx)
 
     return false;
 }
+
+void parallelFor(const PdfIndirectObjectList& objects, size_t count, size_t batchSize, unsigned threadCount,
+    const PdfExecutor::WorkerFactory& createWorker)
+{
+    objects.GetExecutor()->ParallelFor(count, batchSize, threadCount, createWorker);
+}
+
+bool checkObjectHeader(const char* buffer, size_t size, uint32_t objNum)
+{
+    uint32_t num;
+    return tryReadObjectHeader(buffer, size, num) && num == objNum;
+}
+
+bool tryReadObjectHeader(const char* buffer, size_t size, uint32_t& objNum)
+{
+    // Accept the "N G obj" header of the object, possibly preceded by whitespaces
+    size_t i = FindNonWhitespace(buffer, size);
+    uint64_t num = 0;
+    size_t start = i;
+    for (; i < size && i - start < 10 && buffer[i] >= '0' && buffer[i] <= '9'; i++)
+        num = num * 10 + (unsigned)(buffer[i] - '0');
+
+    if (i == start || num > numeric_limits<uint32_t>::max() || i == size || !PdfTokenizer::IsWhitespace(buffer[i]))
+        return false;
+
+    objNum = (uint32_t)num;
+
+    i += FindNonWhitespace(buffer + i, size - i);
+    start = i;
+    for (; i < size && i - start < 5 && buffer[i] >= '0' && buffer[i] <= '9'; i++);
+
+    if (i == start || i == size || !PdfTokenizer::IsWhitespace(buffer[i]))
+        return false;
+
+    i += FindNonWhitespace(buffer + i, size - i);
+    return size - i >= 3 && std::memcmp(buffer + i, "obj", 3) == 0
+        && (size - i == 3 || !PdfTokenizer::IsRegular(buffer[i + 3]));
+}
+
+bool tryReadObjectHeaderBackward(const char* buffer, size_t pos, uint32_t& objNum, uint16_t& gen, size_t& headerPos)
+{
+    // Read backward the generation and the object
+    // numbers before the "obj" keyword at pos
+    auto readNumber = [buffer](size_t& i, size_t maxDigits, uint64_t& num)
+    {
+        if (i == 0 || !PdfTokenizer::IsWhitespace(buffer[i - 1]))
+            return false;
+
+        while (i > 0 && PdfTokenizer::IsWhitespace(buffer[i - 1]))
+            i--;
+
+        size_t end = i;
+        while (i > 0 && end - i < maxDigits && buffer[i - 1] >= '0' && buffer[i - 1] <= '9')
+            i--;
+
+        if (i == end)
+            return false;
+
+        num = 0;
+        for (size_t j = i; j < end; j++)
+            num = num * 10 + (unsigned)(buffer[j] - '0');
+
+        return true;
+    };
+
+    size_t i = pos;
+    uint64_t genNum;
+    uint64_t num;
+    if (!readNumber(i, 5, genNum) || genNum > numeric_limits<uint16_t>::max()
+        || !readNumber(i, 10, num) || num > numeric_limits<uint32_t>::max()
+        || (i > 0 && PdfTokenizer::IsRegular(buffer[i - 1])))
+    {
+        return false;
+    }
+
+    objNum = (uint32_t)num;
+    gen = (uint16_t)genNum;
+    headerPos = i;
+    return true;
+}
+
+// Parse a xref table entry, defined in ISO 32000-1:2008 7.5.4 "Cross-Reference
+// Table" as "nnnnnnnnnn ggggg n eol", where nnnnnnnnnn is the 10-digit offset
+// or number of the next free object, ggggg is the 5-digit generation number
+// and eol is a 2-character end-of-line sequence
+bool tryParseXRefEntry(const char* buffer, uint64_t& offset, uint32_t& generation, char& type)
+{
+    const char* it = buffer;
+    const char* end = buffer + PDF_XREF_ENTRY_SIZE;
+    auto skipWhitespaces = [&]()
+    {
+        while (it != end && PdfTokenizer::IsWhitespace(*it))
+            it++;
+    };
+    auto readNumber = [&](unsigned maxDigits, uint64_t& value)
+    {
+        value = 0;
+        unsigned digits = 0;
+        while (it != end && digits < maxDigits && *it >= '0' && *it <= '9')
+        {
+            value = value * 10 + (uint64_t)(*it - '0');
+            it++;
+            digits++;
+        }
+
+        return digits != 0;
+    };
+
+    uint64_t gen;
+    skipWhitespaces();
+    if (!readNumber(10, offset))
+        return false;
+
+    skipWhitespaces();
+    if (!readNumber(5, gen))
+        return false;
+
+    skipWhitespaces();
+    if (end - it < 3)
+        return false;
+
+    generation = (uint32_t)gen;
+    type = it[0];
+    return CheckEOL(it[1], it[2]);
+}
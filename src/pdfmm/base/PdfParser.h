@@ -9,6 +9,8 @@
 #ifndef PDF_PARSER_H
 #define PDF_PARSER_H
 
+#include <chrono>
+
 #include "PdfDeclarations.h"
 #include "PdfParserObject.h"
 #include "PdfXRefEntry.h"
@@ -21,6 +23,32 @@ class PdfEncrypt;
 class PdfString;
 class PdfParserObject;
 
+/** Timings and counters of the last parsing, collected
+ *  when enabled with PdfParser::SetCollectStats
+ *
+ *  Timings of nested phases are also included in the
+ *  enclosing ones, e.g. ReadXRefContentsTime is part of
+ *  ReadDocumentStructureTime
+ */
+struct PDFMM_API PdfParserStats final
+{
+    PdfParserStats();
+
+    std::chrono::nanoseconds ReadDocumentStructureTime;
+    std::chrono::nanoseconds ReadXRefContentsTime;
+    std::chrono::nanoseconds ReadObjectsTime;
+    std::chrono::nanoseconds EncryptionSetupTime;
+    std::chrono::nanoseconds ReadCompressedObjectsTime;
+    size_t XRefBytesRead;           ///< Bytes read from the device for the xref sections and the trailers
+    size_t ObjectBytesRead;         ///< Bytes read from the device for the objects loaded while parsing
+    unsigned ObjectCount;           ///< Number of objects created
+    unsigned XRefSectionCount;      ///< Number of xref tables and xref streams read
+    unsigned BrokenObjectCount;     ///< Number of broken objects skipped
+    unsigned ShadowedXRefEntryCount; ///< Number of entries of xref tables skipped, as already defined by newer sections
+
+    inline size_t GetBytesRead() const { return XRefBytesRead + ObjectBytesRead; }
+};
+
 /**
  * PdfParser reads a PDF file into memory.
  * The file can be modified in memory and written back using
@@ -32,6 +60,9 @@ class PDFMM_API PdfParser
     PDFMM_UNIT_TEST(PdfParserTest);
     friend class PdfDocument;
     friend class PdfWriter;
+    friend class PdfDocumentInfoProbe;
+    friend class PdfMetadataUpdater;
+    friend class PdfObjectReader;
 
 public:
     /** Create a new PdfParser object
@@ -64,6 +95,61 @@ public:
      */
     void Parse(InputStreamDevice& device, bool loadOnDemand = true);
 
+    /** Open a PDF file and, if it is linearized, parse only the
+     *  first-page cross-reference section and the objects listed there.
+     *  The main cross-reference section is deferred and can be
+     *  read later with ParseDeferredXRef.
+     *
+     *  Files that are not linearized, or that have been updated
+     *  since they were linearized, are parsed completely as with Parse().
+     *  The first-page section alone is also not used for encrypted files.
+     *
+     *  \param device the input device to read from
+     *  \param loadOnDemand If true all objects will be read from the file at
+     *                       the time they are accessed first.
+     *  \returns true if only the first-page section was read
+     *
+     *  \see Parse, ParseDeferredXRef
+     */
+    bool ParseFirstPage(InputStreamDevice& device, bool loadOnDemand = true);
+
+    /** Read the document structure and the encryption dictionary
+     *  of a PDF file, and try a list of candidate passwords against
+     *  it without loading any object. The passwords are tried
+     *  concurrently as set with SetParseThreadCount, which
+     *  pays off with the iterated hashes of AES-256 R6.
+     *  The password found is also set as with SetPassword, so
+     *  the file can be parsed next with Parse()
+     *
+     *  \param device the input device to read from
+     *  \param passwords the candidate user or owner passwords
+     *  \param password the first matching password in the list,
+     *      or empty if the document is not encrypted
+     *  \returns false if the document is encrypted and
+     *      none of the passwords opens it
+     */
+    bool TryFindPassword(InputStreamDevice& device, const cspan<std::string_view>& passwords, std::string& password);
+
+    /** Read the main cross-reference section deferred by ParseFirstPage
+     *  and all the objects that were not read yet. Does nothing
+     *  if there's no deferred section
+     *
+     *  \param device the same input device supplied to ParseFirstPage
+     */
+    void ParseDeferredXRef(InputStreamDevice& device);
+
+    /** Read the cross-reference section appended to the document by an
+     *  incremental update, without following the /Prev chain, and rebase
+     *  the modified objects written by the update to their new offsets.
+     *  The objects are then no longer dirty
+     *
+     *  \param device the updated file, that must start with
+     *      the data of the device the document was parsed from
+     *  \param prevXRefOffset the offset of the cross-reference section
+     *      the update refers to with /Prev
+     */
+    void ParseUpdate(InputStreamDevice& device, size_t prevXRefOffset);
+
     /**
      * \returns true if this PdfWriter creates an encrypted PDF file
      */
@@ -178,10 +264,93 @@ public:
      */
     inline void SetIgnoreBrokenObjects(bool broken) { m_IgnoreBrokenObjects = broken; }
 
+    /**
+     * \return if the xref entries are rebuilt when they are broken
+     *
+     * \see SetRebuildBrokenXRef
+     */
+    inline bool GetRebuildBrokenXRef() const { return m_RebuildBrokenXRef; }
+
+    /**
+     * Specify if the parser should rebuild the cross-reference
+     * entries and the trailer when the xref sections can't be read,
+     * or when the offsets they list don't point to the stated objects.
+     * The entries are rebuilt with a single sequential scan of the file
+     * for the "N G obj" object headers, the "trailer" keywords
+     * and the xref streams.
+     *
+     * Default is false. When enabled, the offsets of the
+     * in use entries are verified after reading the xref sections
+     *
+     * \param rebuild if true broken xref entries will be rebuilt
+     * \see IsXRefRebuilt
+     */
+    inline void SetRebuildBrokenXRef(bool rebuild) { m_RebuildBrokenXRef = rebuild; }
+
+    /**
+     * \returns true if the xref entries of the last parsed
+     *      file have been rebuilt because they were broken
+     */
+    inline bool IsXRefRebuilt() const { return m_XRefRebuilt; }
+
+    /**
+     * \return the number of threads used to parse objects
+     *
+     * \see SetParseThreadCount
+     */
+    inline unsigned GetParseThreadCount() const { return m_ParseThreadCount; }
+
+    /**
+     * Specify how many threads should be used to parse the
+     * objects and to decode the object streams when they
+     * are not loaded on demand.
+     *
+     * Default is 1, meaning objects are parsed sequentially.
+     * Objects are parsed concurrently only if the input device
+     * data is contiguous in memory (see InputStreamDevice::TryGetView)
+     * and the document is not encrypted, otherwise this setting is ignored.
+     * The setting is also used by TryFindPassword.
+     *
+     * The threads are run by the executor of the document, see
+     * PdfDocument::SetExecutor, and are capped to its concurrency
+     *
+     * \param threadCount number of threads to use, or 0 to
+     *      use the concurrency of the executor
+     */
+    inline void SetParseThreadCount(unsigned threadCount) { m_ParseThreadCount = threadCount; }
+
+    /**
+     * Enable/disable the collection of the parsing
+     * statistics. Default is disabled
+     *
+     * \see GetStats
+     */
+    inline void SetCollectStats(bool collectStats) { m_CollectStats = collectStats; }
+
+    /**
+     * \returns the statistics of the last parsing,
+     *      or nullptr if collection is not enabled
+     *
+     * \see SetCollectStats
+     */
+    inline const PdfParserStats* GetStats() const { return m_CollectStats ? &m_Stats : nullptr; }
+
     inline size_t GetXRefOffset() const { return m_XRefOffset; }
 
     inline bool HasXRefStream() const { return m_HasXRefStream; }
 
+    /**
+     * \returns true if the main cross-reference section
+     *      has been deferred by ParseFirstPage
+     */
+    inline bool HasDeferredXRef() const { return m_DeferredXRefOffset >= 0; }
+
+    /**
+     * \returns the object number of the first page object as stated
+     *      in the linearization dictionary, or 0 if the file is not linearized
+     */
+    inline uint32_t GetFirstPageObjectNumber() const { return m_FirstPageObjectNumber; }
+
 private:
     /** Searches backwards from the end of the file
      *  and tries to find a token.
@@ -209,6 +378,43 @@ private:
      */
     void ReadDocumentStructure(InputStreamDevice& device);
 
+    /** Read the document structure and, if enabled,
+     *  rebuild the xref entries when they are broken
+     *
+     *  \see SetRebuildBrokenXRef
+     */
+    void readDocumentStructure(InputStreamDevice& device);
+
+    /** Check that the in use entries point to the
+     *  headers of the stated objects
+     */
+    bool checkXRefOffsets(InputStreamDevice& device);
+
+    /** Check without raising that there's an object
+     *  header at the given offset
+     */
+    bool hasObjectHeader(InputStreamDevice& device, size_t offset);
+
+    /** Rebuild the xref entries and the trailer with a single
+     *  sequential scan of the whole file, discarding the entries
+     *  read so far
+     */
+    void rebuildXRef(InputStreamDevice& device);
+
+    /** Read the compressed entries of a xref stream found while
+     *  rebuilding the xref entries, and merge its trailer
+     */
+    void readRebuiltXRefStream(InputStreamDevice& device, size_t offset);
+
+    /** Find the newest document catalog between the rebuilt entries
+     *
+     *  \param catalog the reference of the found catalog
+     *  \returns true if the catalog was found
+     */
+    bool tryFindRebuiltCatalog(InputStreamDevice& device, PdfReference& catalog);
+
+    void mergeRebuiltTrailer(std::unique_ptr<PdfObject> trailer);
+
     /** Merge the information of this trailer object
      *  in the parsers main trailer object.
      *  \param trailer take the keys to merge from this dictionary.
@@ -260,6 +466,11 @@ private:
      */
     void ReadObjects(InputStreamDevice& device);
 
+    /** Create the encryption from the encryption dictionary
+     *  referenced by the trailer, if any, not authenticated yet
+     */
+    void readEncrypt(InputStreamDevice& device);
+
     /** Reads all objects from the pdf into memory
      *  from the previously read entries
      *
@@ -274,18 +485,41 @@ private:
      */
     void ReadObjectsInternal(InputStreamDevice& device);
 
-    /** Read the object with index from the object stream nObjNo
-     *  and push it on the objects vector
-     *
-     *  All objects are read from this stream and the stream object
-     *  is free'd from memory. Further calls who try to read from the
-     *  same stream simply do nothing.
+    /** Set the factory of the objects listed lazily by the
+     *  objects vector, which reads them from the device
+     */
+    void setLazyObjectFactory(InputStreamDevice& device);
+
+    /** Parse the supplied objects concurrently, each worker
+     *  reading from a private cursor on the device contiguous data
+     */
+    void parseObjectsParallel(const bufferview& view, const std::vector<PdfParserObject*>& objects, unsigned threadCount);
+
+    /** Parse again without encryption the XRef streams among the
+     *  supplied objects, replacing them in the objects vector
+     */
+    void replaceEncryptedXRefStreams(InputStreamDevice& device, std::vector<PdfParserObject*>& objects);
+
+    /** Decrypt concurrently the streams of the supplied objects,
+     *  which are then set when the streams are parsed
+     */
+    void decryptStreamsParallel(const bufferview& view, const std::vector<PdfParserObject*>& objects, unsigned threadCount);
+
+    /** Read the objects with the given ids from the object stream objNo
+     *  and push them on the objects vector
      *
      *  \param objNo object number of the stream object
-     *  \param index index of the object which should be parsed
+     *  \param objectIds object numbers of the objects contained in the stream
      *
      */
-    void ReadCompressedObjectFromStream(uint32_t objNo, int index);
+    void ReadCompressedObjectFromStream(uint32_t objNo, const std::vector<int64_t>& objectIds);
+
+    /** Decode all the object streams concurrently and push
+     *  the contained objects on the objects vector
+     */
+    void readObjectStreamsParallel(unsigned threadCount);
+
+    PdfParserObject* getObjectStream(uint32_t objNo);
 
     /** Checks the magic number at the start of the pdf file
      *  and sets the m_PdfVersion member to the correct version
@@ -297,6 +531,19 @@ private:
 
     void ReadNextTrailer(InputStreamDevice& device);
 
+    /** Try to read the linearization parameter dictionary, which must
+     *  be the first object in the file, and validate it against the file length.
+     *  On success the device is positioned after the dictionary, where
+     *  the first-page cross-reference section starts
+     *
+     *  \returns true if the file is linearized
+     */
+    bool tryReadLinearizationDict(InputStreamDevice& device);
+
+    /** Either read the xref section at the given /Prev offset,
+     *  or defer it if it's the main section of a linearized file
+     */
+    void readPreviousXRef(InputStreamDevice& device, size_t offset);
 
     /** Checks for the existence of the %%EOF marker at the end of the file.
      *  When strict mode is off it will also attempt to setup the parser to ignore
@@ -338,21 +585,32 @@ private:
     bool m_HasXRefStream;
     size_t m_XRefOffset;
     size_t m_XRefLinearizedOffset;
+    bool m_DeferXRef;
+    bool m_SkipPreviousXRef;
+    ssize_t m_DeferredXRefOffset;
+    uint32_t m_FirstPageObjectNumber;
+    std::vector<bool> m_loadedEntries;
     size_t m_FileSize;
     size_t m_LastEOFOffset;
 
     PdfXRefEntries m_entries;
     PdfIndirectObjectList* m_Objects;
 
-    std::unique_ptr<PdfParserObject> m_Trailer;
+    std::unique_ptr<PdfObject> m_Trailer;
     std::unique_ptr<PdfEncrypt> m_Encrypt;
 
     std::string m_password;
 
-    std::set<int> m_ObjectStreams;
+    // Object stream number -> compressed object numbers
+    std::map<uint32_t, std::vector<int64_t>> m_ObjectStreams;
 
     bool m_StrictParsing;
     bool m_IgnoreBrokenObjects;
+    bool m_RebuildBrokenXRef;
+    bool m_XRefRebuilt;
+    unsigned m_ParseThreadCount;
+    bool m_CollectStats;
+    PdfParserStats m_Stats;
 
     unsigned m_IncrementalUpdateCount;
     unsigned m_RecursionDepth;
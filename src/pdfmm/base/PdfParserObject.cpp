@@ -15,13 +15,17 @@
 #include "PdfEncrypt.h"
 #include "PdfInputDevice.h"
 #include "PdfInputStream.h"
+#include "PdfOutputDevice.h"
 #include "PdfParser.h"
 #include "PdfObjectStream.h"
+#include "PdfStreamDevice.h"
 #include "PdfVariant.h"
 
 using namespace mm;
 using namespace std;
 
+static constexpr size_t RawStreamChunkSize = 1024 * 1024;
+
 PdfParserObject::PdfParserObject(PdfDocument& doc, const PdfReference& indirectReference, InputStreamDevice& device, ssize_t offset)
     : PdfParserObject(&doc, indirectReference, device, offset)
 {
@@ -43,9 +47,13 @@ PdfParserObject::PdfParserObject(PdfDocument* doc, const PdfReference& indirectR
     m_device(&device),
     m_Encrypt(nullptr),
     m_IsTrailer(false),
+    m_LazyNestedArrays(false),
+    m_LazyStringDecryption(false),
     m_Offset(offset < 0 ? device.GetPosition() : offset),
     m_HasStream(false),
-    m_StreamOffset(0)
+    m_StreamOffset(0),
+    m_ReadLength(0),
+    m_DecryptedStreamLength(0)
 {
     // Parsed objects by definition are initially not dirty
     resetDirty();
@@ -64,6 +72,22 @@ void PdfParserObject::Parse()
     DelayedLoad();
 }
 
+void PdfParserObject::Parse(InputStreamDevice& device)
+{
+    auto prevDevice = m_device;
+    m_device = &device;
+    try
+    {
+        DelayedLoad();
+    }
+    catch (...)
+    {
+        m_device = prevDevice;
+        throw;
+    }
+    m_device = prevDevice;
+}
+
 void PdfParserObject::ParseStream()
 {
     // It's really just a call to DelayedLoad
@@ -73,11 +97,15 @@ void PdfParserObject::ParseStream()
 void PdfParserObject::DelayedLoadImpl()
 {
     PdfTokenizer tokenizer;
+    tokenizer.SetLazyNestedArrays(m_LazyNestedArrays);
+    tokenizer.SetLazyStringDecryption(m_LazyStringDecryption);
     m_device->Seek(m_Offset);
     if (!m_IsTrailer)
         checkReference(tokenizer);
 
     Parse(tokenizer);
+    m_ReadLength = m_device->GetPosition() - m_Offset;
+    trackLoaded(m_ReadLength);
 }
 
 void PdfParserObject::DelayedLoadStreamImpl()
@@ -101,6 +129,68 @@ void PdfParserObject::DelayedLoadStreamImpl()
     }
 }
 
+bool PdfParserObject::TryGetRawStreamLength(size_t& length) const
+{
+    // Encrypted data can't be copied, as the
+    // output may use a different key
+    int64_t size;
+    if (!m_HasStream || m_Encrypt != nullptr
+        || !m_Variant.GetDictionary().MustFindKey(PdfName::KeyLength).TryGetNumber(size)
+        || size < 0)
+    {
+        length = 0;
+        return false;
+    }
+
+    length = (size_t)size;
+    return true;
+}
+
+void PdfParserObject::WriteRawStream(OutputStreamDevice& device) const
+{
+    size_t length;
+    if (!TryGetRawStreamLength(length))
+        PDFMM_RAISE_ERROR(PdfErrorCode::InternalLogic);
+
+    bufferview view;
+    if (TryGetRawStreamView(view))
+    {
+        // Write straight from the mapped or in memory data
+        device.Write(view.data(), view.size());
+    }
+    else
+    {
+        size_t offset = findStreamDataOffset();
+        unique_ptr<char[]> chunk(new char[std::min(length, RawStreamChunkSize)]);
+        m_device->Seek(offset);
+        while (length != 0)
+        {
+            size_t count = std::min(length, RawStreamChunkSize);
+            m_device->Read(chunk.get(), count);
+            device.Write(chunk.get(), count);
+            length -= count;
+        }
+    }
+}
+
+bool PdfParserObject::TryGetRawStreamView(bufferview& view) const
+{
+    size_t length;
+    bufferview deviceView;
+    if (!TryGetRawStreamLength(length) || !m_device->TryGetView(deviceView))
+    {
+        view = { };
+        return false;
+    }
+
+    size_t offset = findStreamDataOffset();
+    if (offset + length > deviceView.size())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnexpectedEOF, "Unexpected EOF when reading stream");
+
+    view = bufferview(deviceView.data() + offset, length);
+    return true;
+}
+
 PdfReference PdfParserObject::ReadReference(PdfTokenizer& tokenizer)
 {
     m_device->Seek(m_Offset);
@@ -164,16 +254,96 @@ void PdfParserObject::parseStream()
 {
     PDFMM_ASSERT(IsDelayedLoadDone());
 
-    int64_t size = -1;
-    char ch;
+    if (m_DecryptedStream != nullptr)
+    {
+        // Set stream data decrypted in advance without marking the object dirty
+        SpanStreamDevice input(*m_DecryptedStream);
+        getOrCreateStream().SetRawData(input, -1, false);
+        m_DecryptedStream.reset();
+        m_ReadLength += m_DecryptedStreamLength;
+        trackLoaded(m_DecryptedStreamLength);
+        return;
+    }
+
+    int64_t size = seekStreamData();
 
+    // Set stream raw data without marking the object dirty
+    if (m_Encrypt != nullptr)
+    {
+        auto input = m_Encrypt->CreateEncryptionInputStream(*m_device, static_cast<size_t>(size), GetIndirectReference());
+        getOrCreateStream().SetRawData(*input, static_cast<ssize_t>(size), false);
+    }
+    else
+    {
+        getOrCreateStream().SetRawData(*m_device, static_cast<ssize_t>(size), false);
+    }
+
+    size_t streamLength = m_device->GetPosition() - m_StreamOffset;
+    m_ReadLength += streamLength;
+    trackLoaded(streamLength);
+}
+
+void PdfParserObject::DecryptStream(InputStreamDevice& device)
+{
+    PDFMM_ASSERT(IsDelayedLoadDone() && m_HasStream);
+    auto prevDevice = m_device;
+    m_device = &device;
+    try
+    {
+        int64_t size = seekStreamData();
+        if (m_Encrypt != nullptr)
+        {
+            unique_ptr<charbuff> decrypted(new charbuff());
+            auto input = m_Encrypt->CreateEncryptionInputStream(device, static_cast<size_t>(size), GetIndirectReference());
+            BufferStreamDevice output(*decrypted);
+            input->CopyTo(output);
+            m_DecryptedStreamLength = device.GetPosition() - m_StreamOffset;
+            m_DecryptedStream = std::move(decrypted);
+        }
+    }
+    catch (PdfError& e)
+    {
+        m_device = prevDevice;
+        PDFMM_PUSH_FRAME_INFO(e, "Unable to parse the stream for object {} {} R",
+            GetIndirectReference().ObjectNumber(),
+            GetIndirectReference().GenerationNumber());
+        throw;
+    }
+    m_device = prevDevice;
+}
+
+int64_t PdfParserObject::seekStreamData()
+{
+    int64_t size = -1;
     auto& lengthObj = this->m_Variant.GetDictionary().MustFindKey(PdfName::KeyLength);
     if (!lengthObj.TryGetNumber(size))
         PDFMM_RAISE_ERROR(PdfErrorCode::InvalidStreamLength);
 
-    m_device->Seek(m_StreamOffset);
+    size_t streamOffset = findStreamDataOffset();
+    m_device->Seek(streamOffset);	// reset it before reading!
+    if (m_Encrypt != nullptr && !m_Encrypt->IsMetadataEncrypted())
+    {
+        // If metadata is not encrypted the Filter is set to "Crypt"
+        auto filterObj = this->m_Variant.GetDictionary().FindKey(PdfName::KeyFilter);
+        if (filterObj != nullptr && filterObj->IsArray())
+        {
+            auto& filters = filterObj->GetArray();
+            for (unsigned i = 0; i < filters.GetSize(); i++)
+            {
+                auto& obj = filters.FindAt(i);
+                if (obj.IsName() && obj.GetName() == "Crypt")
+                    m_Encrypt = nullptr;
+            }
+        }
+    }
+
+    return size;
+}
 
-    size_t streamOffset;
+size_t PdfParserObject::findStreamDataOffset() const
+{
+    char ch;
+    m_device->Seek(m_StreamOffset);
     while (true)
     {
         if (!m_device->Peek(ch))
@@ -194,7 +364,8 @@ void PdfParserObject::parseStream()
             // RETURN and a LINE FEED or just a LINE FEED, and not by a CARRIAGE
             // RETURN alone"
             case '\r':
-                streamOffset = m_device->GetPosition();
+            {
+                size_t streamOffset = m_device->GetPosition();
                 (void)m_device->ReadChar();
                 if (!m_device->Peek(ch))
                     PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnexpectedEOF, "Unexpected EOF when reading stream");
@@ -204,46 +375,23 @@ void PdfParserObject::parseStream()
                     (void)m_device->ReadChar();
                     streamOffset = m_device->GetPosition();
                 }
-                goto ReadStream;
+                return streamOffset;
+            }
             case '\n':
                 (void)m_device->ReadChar();
-                streamOffset = m_device->GetPosition();
-                goto ReadStream;
+                return m_device->GetPosition();
             // Assume malformed PDF with no whitespaces after the stream keyword
             default:
-                streamOffset = m_device->GetPosition();
-                goto ReadStream;
-        }
-    }
-
-ReadStream:
-    m_device->Seek(streamOffset);	// reset it before reading!
-    if (m_Encrypt != nullptr && !m_Encrypt->IsMetadataEncrypted())
-    {
-        // If metadata is not encrypted the Filter is set to "Crypt"
-        auto filterObj = this->m_Variant.GetDictionary().FindKey(PdfName::KeyFilter);
-        if (filterObj != nullptr && filterObj->IsArray())
-        {
-            auto& filters = filterObj->GetArray();
-            for (unsigned i = 0; i < filters.GetSize(); i++)
-            {
-                auto& obj = filters.FindAt(i);
-                if (obj.IsName() && obj.GetName() == "Crypt")
-                    m_Encrypt = nullptr;
-            }
+                return m_device->GetPosition();
         }
     }
+}
 
-    // Set stream raw data without marking the object dirty
-    if (m_Encrypt != nullptr)
-    {
-        auto input = m_Encrypt->CreateEncryptionInputStream(*m_device, static_cast<size_t>(size), GetIndirectReference());
-        getOrCreateStream().SetRawData(*input, static_cast<ssize_t>(size), false);
-    }
-    else
-    {
-        getOrCreateStream().SetRawData(*m_device, static_cast<ssize_t>(size), false);
-    }
+void PdfParserObject::trackLoaded(size_t size)
+{
+    auto document = GetDocument();
+    if (document != nullptr)
+        document->GetObjects().trackLoadedObject(*this, size);
 }
 
 void PdfParserObject::checkReference(PdfTokenizer& tokenizer)
@@ -259,20 +407,17 @@ void PdfParserObject::checkReference(PdfTokenizer& tokenizer)
 
 PdfReference PdfParserObject::readReference(PdfTokenizer& tokenizer)
 {
-    PdfReference reference;
-    try
+    // NOTE: Read the header without raising, so the
+    // error is raised once, with no intermediate frames
+    int64_t obj;
+    int64_t gen;
+    if (!tokenizer.TryReadNextNumber(*m_device, obj)
+        || !tokenizer.TryReadNextNumber(*m_device, gen))
     {
-        int64_t obj = tokenizer.ReadNextNumber(*m_device);
-        int64_t gen = tokenizer.ReadNextNumber(*m_device);
-        reference = PdfReference(static_cast<uint32_t>(obj), static_cast<uint16_t>(gen));
-
-    }
-    catch (PdfError& e)
-    {
-        PDFMM_PUSH_FRAME_INFO(e, "Object and generation number cannot be read");
-        throw e;
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoNumber, "Object and generation number cannot be read");
     }
 
+    PdfReference reference(static_cast<uint32_t>(obj), static_cast<uint16_t>(gen));
     if (!tokenizer.IsNextToken(*m_device, "obj"))
     {
         PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoObject, "Error while reading object {} {} R: Next token is not 'obj'",
@@ -287,8 +432,14 @@ void PdfParserObject::FreeObjectMemory(bool force)
     if (!this->IsDirty() || force)
     {
         if (IsDelayedLoadDone())
+        {
             m_Variant = PdfVariant();
 
+            // The pointers to the data of the object are invalidated
+            if (GetDocument() != nullptr)
+                GetDocument()->GetObjects().m_ModificationCount++;
+        }
+
         FreeStream();
         EnableDelayedLoading();
         EnableDelayedLoadingStream();
@@ -24,6 +24,10 @@ class PdfEncrypt;
 class PDFMM_API PdfParserObject : public PdfObject
 {
     friend class PdfParser;
+    friend class PdfDocumentInfoProbe;
+    friend class PdfMetadataUpdater;
+    friend class PdfObjectReader;
+    friend class PdfSnapshotSerializer;
 
 private:
     /** Parse the object data from the given file handle starting at
@@ -90,9 +94,23 @@ public:
 
     inline void SetIsTrailer(bool isTrailer) { m_IsTrailer = isTrailer; }
 
+    /** Defer the reading of large arrays nested in the object, as
+     *  /Annots or /Widths arrays, until they are accessed. The input
+     *  device must outlive the object, as with load on demand
+     */
+    inline void SetLazyNestedArrays(bool lazyNestedArrays) { m_LazyNestedArrays = lazyNestedArrays; }
+
+    /** Keep the strings of the object encrypted until they are
+     *  accessed. The encryption must outlive the object
+     */
+    inline void SetLazyStringDecryption(bool lazyStringDecryption) { m_LazyStringDecryption = lazyStringDecryption; }
+
 protected:
     void DelayedLoadImpl() override;
     void DelayedLoadStreamImpl() override;
+    bool TryGetRawStreamLength(size_t& length) const override;
+    void WriteRawStream(OutputStreamDevice& device) const override;
+    bool TryGetRawStreamView(bufferview& view) const override;
     PdfReference ReadReference(PdfTokenizer& tokenizer);
     void Parse(PdfTokenizer& tokenizer);
 
@@ -108,17 +126,58 @@ private:
      */
     void parseStream();
 
+    /** Seek the device to the stream data, and disable the
+     *  decryption of the stream if it has a /Crypt filter
+     *  \returns the length of the stream data
+     */
+    int64_t seekStreamData();
+
+    /** Skip the end of line after the stream keyword
+     *  \returns the offset of the stream data in the device
+     */
+    size_t findStreamDataOffset() const;
+
     PdfReference readReference(PdfTokenizer& tokenizer);
 
     void checkReference(PdfTokenizer& tokenizer);
 
+    /** Track the loaded data for the memory budget of the document
+     */
+    void trackLoaded(size_t size);
+
+    /** Parse the object reading from the supplied device, which
+     *  must expose the same data of the device the object was created with.
+     *  Used by PdfParser to parse objects concurrently with
+     *  device cursors private to each thread
+     */
+    void Parse(InputStreamDevice& device);
+
+    /** Read and decrypt the stream data from the supplied device,
+     *  as in Parse(InputStreamDevice&). The decrypted data is set
+     *  as the stream later by ParseStream(), as setting the stream
+     *  notifies the document and can't be done concurrently.
+     *  It does nothing if the stream is not encrypted
+     */
+    void DecryptStream(InputStreamDevice& device);
+
+    /** \returns the number of bytes read from the device
+     *  to parse the object and its stream
+     */
+    inline size_t GetReadLength() const { return m_ReadLength; }
+
 private:
     InputStreamDevice*m_device;
     PdfEncrypt* m_Encrypt;
     bool m_IsTrailer;
+    bool m_LazyNestedArrays;
+    bool m_LazyStringDecryption;
     size_t m_Offset;
     bool m_HasStream;
     size_t m_StreamOffset;
+    size_t m_ReadLength;
+    // Stream data decrypted by DecryptStream(), not set yet
+    std::unique_ptr<charbuff> m_DecryptedStream;
+    size_t m_DecryptedStreamLength;
 };
 
 };
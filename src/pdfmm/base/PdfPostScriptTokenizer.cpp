@@ -8,9 +8,22 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfPostScriptTokenizer.h"
 
+#include <pdfmm/private/charconv_compat.h>
+
 using namespace std;
 using namespace mm;
 
+enum class NumberScan
+{
+    NotNumber,
+    Integer,
+    Real,
+    Invalid,
+};
+
+static bool tryGetHexValue(char ch, unsigned char& value);
+static NumberScan scanNumber(const string_view& token, int64_t& integer, double& real);
+
 PdfPostScriptTokenizer::PdfPostScriptTokenizer()
     : PdfTokenizer(false) { }
 
@@ -54,10 +67,33 @@ bool PdfPostScriptTokenizer::TryReadNext(InputStreamDevice& device, PdfPostScrip
             break;
     }
 
-    PdfLiteralDataType dataType = DetermineDataType(device, token, tokenType, variant);
-
     // asume we read a variant unless we discover otherwise later.
     psTokenType = PdfPostScriptTokenType::Variant;
+    if (tokenType == PdfTokenType::Literal)
+    {
+        // Content streams are mostly numbers: parse them
+        // right away, before the generic type detection
+        int64_t integer;
+        double real;
+        switch (scanNumber(token, integer, real))
+        {
+            case NumberScan::Integer:
+                variant = PdfVariant(integer);
+                return true;
+            case NumberScan::Real:
+                variant = PdfVariant(real);
+                return true;
+            case NumberScan::Invalid:
+                // Don't consume the token
+                this->EnqueueToken(token, tokenType);
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoNumber, token);
+            default:
+                // Continue evaluating data type
+                break;
+        }
+    }
+
+    PdfLiteralDataType dataType = DetermineDataType(device, token, tokenType, variant);
     switch (dataType)
     {
         case PdfLiteralDataType::Null:
@@ -93,3 +129,263 @@ bool PdfPostScriptTokenizer::TryReadNext(InputStreamDevice& device, PdfPostScrip
 
     return true;
 }
+
+bool PdfPostScriptTokenizer::TryReadNextRaw(InputStreamDevice& device, PdfPostScriptTokenType& psTokenType,
+    string_view& keyword, PdfRawOperand& operand, charbuff& buffer)
+{
+    PdfTokenType tokenType;
+    string_view token;
+    keyword = { };
+    operand = { };
+    bool gotToken = PdfTokenizer::TryReadNextToken(device, token, tokenType);
+    if (!gotToken)
+    {
+        psTokenType = PdfPostScriptTokenType::Unknown;
+        return false;
+    }
+
+    // asume we read an operand unless we discover otherwise later
+    psTokenType = PdfPostScriptTokenType::Variant;
+    size_t offset = buffer.size();
+    switch (tokenType)
+    {
+        case PdfTokenType::BraceLeft:
+            psTokenType = PdfPostScriptTokenType::ProcedureEnter;
+            return true;
+        case PdfTokenType::BraceRight:
+            psTokenType = PdfPostScriptTokenType::ProcedureExit;
+            return true;
+        case PdfTokenType::SquareBracketLeft:
+            operand.Type = PdfRawOperandType::ArrayBegin;
+            return true;
+        case PdfTokenType::SquareBracketRight:
+            operand.Type = PdfRawOperandType::ArrayEnd;
+            return true;
+        case PdfTokenType::DoubleAngleBracketsLeft:
+            operand.Type = PdfRawOperandType::DictionaryBegin;
+            return true;
+        case PdfTokenType::DoubleAngleBracketsRight:
+            operand.Type = PdfRawOperandType::DictionaryEnd;
+            return true;
+        case PdfTokenType::ParenthesisLeft:
+            ReadStringTo(device, buffer);
+            operand.Type = PdfRawOperandType::String;
+            operand.Data = string_view(buffer.data() + offset, buffer.size() - offset);
+            return true;
+        case PdfTokenType::AngleBracketLeft:
+            ReadHexStringTo(device, buffer);
+            operand.Type = PdfRawOperandType::HexString;
+            operand.Data = string_view(buffer.data() + offset, buffer.size() - offset);
+            return true;
+        case PdfTokenType::Slash:
+            readRawName(device, buffer);
+            operand.Type = PdfRawOperandType::Name;
+            operand.Data = string_view(buffer.data() + offset, buffer.size() - offset);
+            return true;
+        case PdfTokenType::Literal:
+            // Continue evaluating the literal
+            break;
+        default:
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidEnumValue, "Unsupported token at this context");
+    }
+
+    if (token == "null")
+    {
+        operand.Type = PdfRawOperandType::Null;
+        return true;
+    }
+    else if (token == "true" || token == "false")
+    {
+        operand.Type = PdfRawOperandType::Bool;
+        operand.Number = token == "true" ? 1 : 0;
+        return true;
+    }
+
+    int64_t integer;
+    double real;
+    switch (scanNumber(token, integer, real))
+    {
+        case NumberScan::Integer:
+            operand.Number = (double)integer;
+            break;
+        case NumberScan::Real:
+            operand.Number = real;
+            break;
+        case NumberScan::Invalid:
+            // Don't consume the token
+            this->EnqueueToken(token, tokenType);
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoNumber, token);
+        default:
+            // Assume we have a keyword
+            keyword = token;
+            psTokenType = PdfPostScriptTokenType::Keyword;
+            return true;
+    }
+
+    operand.Type = PdfRawOperandType::Number;
+    return true;
+}
+
+void PdfPostScriptTokenizer::readRawName(InputStreamDevice& device, charbuff& buffer)
+{
+    // Empty names are handled as in PdfTokenizer::ReadName()
+    char ch;
+    if (!device.Peek(ch) || IsWhitespace(ch))
+        return;
+
+    PdfTokenType tokenType;
+    string_view token;
+    bool gotToken = this->TryReadNextToken(device, token, tokenType);
+    if (!gotToken || tokenType != PdfTokenType::Literal)
+    {
+        if (gotToken)
+            EnqueueToken(token, tokenType);
+
+        return;
+    }
+
+    // Unescape the #xx hex codes, see PdfName::FromEscaped()
+    unsigned char hi;
+    unsigned char lo;
+    for (size_t i = 0; i < token.size(); i++)
+    {
+        if (token[i] == '#' && i + 2 < token.size()
+            && tryGetHexValue(token[i + 1], hi) && tryGetHexValue(token[i + 2], lo))
+        {
+            buffer.push_back((char)(hi << 4 | lo));
+            i += 2;
+        }
+        else
+        {
+            buffer.push_back(token[i]);
+        }
+    }
+}
+
+bool tryGetHexValue(char ch, unsigned char& value)
+{
+    if (ch >= '0' && ch <= '9')
+        value = (unsigned char)(ch - '0');
+    else if (ch >= 'A' && ch <= 'F')
+        value = (unsigned char)(ch - 'A' + 10);
+    else if (ch >= 'a' && ch <= 'f')
+        value = (unsigned char)(ch - 'a' + 10);
+    else
+        return false;
+
+    return true;
+}
+
+// Scan the number while classifying the token, with no
+// intermediate string. As std::from_chars, trailing
+// malformed characters are ignored, as in "1.2.3"
+NumberScan scanNumber(const string_view& token, int64_t& integer, double& real)
+{
+    // Powers of 10 that are exactly representable as a double
+    static constexpr double s_pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    // Integers up to 2^53 are exactly representable as a double
+    constexpr uint64_t MaxMantissa = (uint64_t)1 << 53;
+
+    const char* it = token.data();
+    const char* end = it + token.size();
+    bool negative = false;
+    if (it != end && (*it == '-' || *it == '+'))
+    {
+        negative = *it == '-';
+        it++;
+    }
+
+    const char* begin = it;
+    const char* numberEnd = nullptr;
+    uint64_t mantissa = 0;
+    unsigned digitCount = 0;
+    unsigned decimalCount = 0;
+    bool hasDot = false;
+    bool overflow = false;
+    for (; it != end; it++)
+    {
+        char ch = *it;
+        if (ch >= '0' && ch <= '9')
+        {
+            if (numberEnd != nullptr)
+                continue;
+
+            digitCount++;
+            if (hasDot)
+                decimalCount++;
+
+            if (mantissa > (MaxMantissa - 9) / 10)
+                overflow = true;
+            else
+                mantissa = mantissa * 10 + (unsigned)(ch - '0');
+        }
+        else if (ch == '.')
+        {
+            if (numberEnd == nullptr)
+            {
+                if (hasDot)
+                    numberEnd = it;
+                else
+                    hasDot = true;
+            }
+        }
+        else if (ch == '-' || ch == '+')
+        {
+            // Signs are allowed only at the beginning
+            if (numberEnd == nullptr)
+                numberEnd = it;
+        }
+        else
+        {
+            return NumberScan::NotNumber;
+        }
+    }
+
+    if (digitCount == 0)
+        return NumberScan::Invalid;
+
+    if (numberEnd == nullptr)
+        numberEnd = end;
+
+    if (overflow || decimalCount >= std::size(s_pow10))
+    {
+        // Fallback to the general parsing, that handles
+        // any number of significant digits
+        if (hasDot)
+        {
+            if (std::from_chars(begin, numberEnd, real, chars_format::fixed).ec != std::errc())
+                return NumberScan::Invalid;
+
+            if (negative)
+                real = -real;
+
+            return NumberScan::Real;
+        }
+        else
+        {
+            if (std::from_chars(negative ? begin - 1 : begin, numberEnd, integer).ec != std::errc())
+                return NumberScan::Invalid;
+
+            return NumberScan::Integer;
+        }
+    }
+
+    if (hasDot)
+    {
+        // Dividing exactly represented values gives
+        // the correctly rounded result
+        real = (double)mantissa / s_pow10[decimalCount];
+        if (negative)
+            real = -real;
+
+        return NumberScan::Real;
+    }
+    else
+    {
+        integer = negative ? -(int64_t)mantissa : (int64_t)mantissa;
+        return NumberScan::Integer;
+    }
+}
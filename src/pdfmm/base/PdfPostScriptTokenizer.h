@@ -30,6 +30,32 @@ enum class PdfPostScriptTokenType
     ProcedureExit, ///< Procedure enter delimiter
 };
 
+/** Type of an operand read without creating a PdfVariant
+ */
+enum class PdfRawOperandType
+{
+    Unknown = 0,
+    Null,
+    Bool,             ///< The value is in Number, as 0 or 1
+    Number,           ///< Integer or real number, the value is in Number
+    String,           ///< The unescaped string bytes are in Data
+    HexString,        ///< The decoded string bytes are in Data
+    Name,             ///< The unescaped name, without the leading '/', is in Data
+    ArrayBegin,       ///< The following operands are elements of an array, up to ArrayEnd
+    ArrayEnd,
+    DictionaryBegin,  ///< The following operands are keys and values of a dictionary, up to DictionaryEnd
+    DictionaryEnd,
+};
+
+/** An operand read without creating a PdfVariant
+ */
+struct PdfRawOperand
+{
+    PdfRawOperandType Type = PdfRawOperandType::Unknown;
+    double Number = 0;
+    std::string_view Data;
+};
+
 /** This class is a parser for general PostScript content in PDF documents.
  */
 class PDFMM_API PdfPostScriptTokenizer final : private PdfTokenizer
@@ -41,6 +67,20 @@ public:
     bool TryReadNext(InputStreamDevice& device, PdfPostScriptTokenType& tokenType, std::string_view& keyword, PdfVariant& variant);
     void ReadNextVariant(InputStreamDevice& device, PdfVariant& variant);
     bool TryReadNextVariant(InputStreamDevice& device, PdfVariant& variant);
+
+    /** Read the next token without creating a PdfVariant
+     *
+     * Numbers are parsed in the operand. The data of strings, hex strings
+     * and names is decoded by appending it to the buffer, which is not
+     * cleared. The operand data views the buffer, so it's invalidated
+     * when the buffer is modified. Arrays and dictionaries are reported
+     * by their delimiters
+     */
+    bool TryReadNextRaw(InputStreamDevice& device, PdfPostScriptTokenType& tokenType, std::string_view& keyword,
+        PdfRawOperand& operand, charbuff& buffer);
+
+private:
+    void readRawName(InputStreamDevice& device, charbuff& buffer);
 };
 
 };
@@ -26,3 +26,8 @@ PdfRadioButton::PdfRadioButton(PdfPage& page, const PdfRect& rect)
     : PdfButton(PdfFieldType::RadioButton, page, rect)
 {
 }
+
+void PdfRadioButton::CreateAppearances(const PdfName& onState, PdfButtonStyle style)
+{
+    createAppearances(style, onState);
+}
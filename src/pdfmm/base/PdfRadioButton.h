@@ -25,6 +25,17 @@ namespace mm
         PdfRadioButton(PdfDocument& doc, PdfAnnotation* widget, bool insertInAcroform);
 
         PdfRadioButton(PdfPage& page, const PdfRect& rect);
+
+        /** Generate the on and off appearance streams
+         *
+         *  The appearances are shared by all the radio buttons of the
+         *  document with the same size and style, so many identical
+         *  radio buttons reference a single pair of XObjects
+         *
+         *  \param onState the name of the on state of this button
+         *  \param style the look of the on state
+         */
+        void CreateAppearances(const PdfName& onState, PdfButtonStyle style = PdfButtonStyle::Circle);
     };
 }
 
@@ -50,11 +50,9 @@ PdfRect::PdfRect(const PdfArray& arr)
 
 void PdfRect::ToArray(PdfArray& arr) const
 {
+    const double values[4] = { m_Left, m_Bottom, m_Width + m_Left, m_Height + m_Bottom };
     arr.Clear();
-    arr.Add(PdfObject(m_Left));
-    arr.Add(PdfObject(m_Bottom));
-    arr.Add(PdfObject((m_Width + m_Left)));
-    arr.Add(PdfObject((m_Height + m_Bottom)));
+    arr.AddReals(values);
 }
 
 string PdfRect::ToString() const
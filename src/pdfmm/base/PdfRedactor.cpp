@@ -0,0 +1,1070 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfRedactor.h"
+
+#include "PdfDocument.h"
+#include "PdfPage.h"
+#include "PdfPageCollection.h"
+#include "PdfPainter.h"
+#include "PdfContentsReader.h"
+#include "PdfOperatorUtils.h"
+#include "PdfFont.h"
+#include "PdfFontManager.h"
+#include "PdfExecutor.h"
+#include "PdfMath.h"
+#include "PdfTextState.h"
+#include "PdfXObjectForm.h"
+
+using namespace std;
+using namespace mm;
+
+static constexpr double Infinity = numeric_limits<double>::infinity();
+
+namespace
+{
+    // An axis aligned box in the default user space
+    struct RedactBox
+    {
+        double Left = Infinity;
+        double Bottom = Infinity;
+        double Right = -Infinity;
+        double Top = -Infinity;
+
+        bool IsEmpty() const;
+        void Add(const Vector2& point);
+        void Intersect(const RedactBox& box);
+        void Grow(double amount);
+        bool Intersects(const PdfRect& rect) const;
+        bool IsInside(const PdfRect& rect) const;
+    };
+
+    struct RedactState
+    {
+        Matrix CTM;
+        RedactBox Clip;
+        double LineWidth = 1;
+        PdfTextState TextState;
+        double Leading = 0;
+        double Rise = 0;
+    };
+
+    // A glyph of a shown string, with the raw
+    // bytes of its code and its advance
+    struct RedactGlyph
+    {
+        string_view Code;
+        double Advance;
+    };
+
+    // Rewrites the content stream of a page, tracking
+    // the state like PdfPage::ComputeContentsBounds()
+    class PageRedactor final
+    {
+    public:
+        PageRedactor(const PdfPage& page, const vector<PdfRect>& rects);
+
+        // Returns the count of the operations removed or clipped
+        unsigned Redact(charbuff& buffer);
+
+    private:
+        void handleOperator(const PdfContent& content);
+        void handleXObject(const PdfContent& content);
+        void addPathPoint(double x, double y);
+        void paintPath(const string_view& op, bool stroke);
+        void endPath();
+        void showText(const PdfContent& content);
+        bool tryRedactString(const PdfString& str, string& array);
+        void splitGlyphs(const PdfString& str, double& ascent, double& descent);
+        bool tryWriteClippedOut(const RedactBox& box, const string_view& painting);
+        void setFont(const PdfName& name, double size);
+        void nextLine(double tx, double ty);
+        RedactBox getUnitSquareBox(const Matrix& m) const;
+        bool isRedacted(const RedactBox& box) const;
+        double getStrokeExpansion();
+        void writeOperands(const PdfContent& content);
+        void writeOperator(const string_view& op);
+        RedactState& current() { return m_states.back(); }
+
+    private:
+        const PdfPage* m_page;
+        const vector<PdfRect>* m_rects;
+        charbuff* m_buffer;
+        vector<RedactState> m_states;
+        Matrix m_T_m;
+        Matrix m_T_lm;
+        RedactBox m_path;
+        nullable<size_t> m_pathOffset;  // Offset of the current path in the output
+        string_view m_clipOp;           // W or W*, if a clip is pending
+        bool m_dropInlineImage;
+        unsigned m_count;
+        vector<PdfCID> m_cids;
+        vector<double> m_advances;
+        vector<RedactGlyph> m_glyphs;
+        string m_operands;
+        string m_token;
+    };
+}
+
+static void preloadFonts(PdfFontManager& fontManager, const PdfCanvas& canvas);
+static bool tryRead(const PdfVariantStack& stack, double* values, unsigned count);
+static bool tryInvert(const Matrix& m, Matrix& inverse);
+static void writeMatrix(const Matrix& m, string& str);
+static void appendReal(double value, string& str);
+static void writeReal(double value, string& str);
+
+PdfRedactor::PdfRedactor() { }
+
+void PdfRedactor::AddRect(unsigned pageIndex, const PdfRect& rect)
+{
+    m_rects[pageIndex].push_back(rect);
+}
+
+void PdfRedactor::SetFillColor(const nullable<PdfColor>& color)
+{
+    m_fillColor = color;
+}
+
+unsigned PdfRedactor::Redact(PdfDocument& doc, unsigned threadCount)
+{
+    // NOTE: Access the pages through the const collection,
+    // which is safe to read concurrently from frozen documents
+    const auto& collection = const_cast<const PdfPageCollection&>(doc.GetPages());
+    vector<pair<unsigned, const vector<PdfRect>*>> pages;
+    for (auto& pair : m_rects)
+    {
+        if (pair.first >= collection.GetCount())
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Page index {} is out of range", pair.first);
+
+        pages.push_back({ pair.first, &pair.second });
+    }
+
+    auto executor = doc.GetExecutor();
+    if (threadCount == 0)
+        threadCount = executor->GetConcurrency();
+
+    threadCount = std::min(threadCount, (unsigned)pages.size());
+    if (threadCount > 1 && doc.TryFreeze())
+    {
+        // Load the fonts of the pages upfront, so the
+        // threads find them already in the cache
+        for (auto& page : pages)
+            preloadFonts(doc.GetFontManager(), collection.GetPage(page.first));
+    }
+    else
+    {
+        threadCount = 1;
+    }
+
+    // Read all the pages before modifying any of them
+    vector<charbuff> buffers(pages.size());
+    vector<unsigned> counts(pages.size());
+    executor->ParallelFor(pages.size(), 1, threadCount, [&]()
+    {
+        return [&](size_t i)
+        {
+            PageRedactor redactor(collection.GetPage(pages[i].first), *pages[i].second);
+            counts[i] = redactor.Redact(buffers[i]);
+        };
+    });
+
+    unsigned ret = 0;
+    for (unsigned i = 0; i < pages.size(); i++)
+    {
+        auto& page = doc.GetPages().GetPage(pages[i].first);
+        if (counts[i] != 0)
+        {
+            auto& contents = page.GetOrCreateContents();
+            contents.Reset();
+            contents.GetStreamForAppending(PdfStreamAppendFlags::NoSaveRestorePrior).Set(buffers[i]);
+            ret += counts[i];
+        }
+
+        if (m_fillColor.has_value())
+        {
+            PdfPainter painter;
+            painter.SetCanvas(&page);
+            painter.GetGraphicsState().SetFillColor(*m_fillColor);
+            for (auto& rect : *pages[i].second)
+                painter.Rectangle(rect);
+
+            painter.Fill();
+            painter.FinishDrawing();
+        }
+    }
+
+    return ret;
+}
+
+void PdfRedactor::Clear()
+{
+    m_rects.clear();
+}
+
+PageRedactor::PageRedactor(const PdfPage& page, const vector<PdfRect>& rects)
+    : m_page(&page), m_rects(&rects), m_buffer(nullptr), m_dropInlineImage(false), m_count(0)
+{
+    auto pageRect = page.GetRect();
+    RedactState state;
+    state.Clip.Add(Vector2(pageRect.GetLeft(), pageRect.GetBottom()));
+    state.Clip.Add(Vector2(pageRect.GetRight(), pageRect.GetTop()));
+    m_states.push_back(state);
+}
+
+unsigned PageRedactor::Redact(charbuff& buffer)
+{
+    buffer.clear();
+    m_buffer = &buffer;
+
+    // NOTE: The forms are not followed, they are
+    // reported with the XObject they draw
+    PdfContentReaderArgs args;
+    args.Flags = PdfContentReaderFlags::DontFollowXObjectForms;
+    PdfContentsReader reader(*m_page, args);
+    PdfContent content;
+    while (reader.TryReadNext(content))
+    {
+        switch (content.Type)
+        {
+            case PdfContentType::Operator:
+            {
+                handleOperator(content);
+                break;
+            }
+            case PdfContentType::DoXObject:
+            {
+                handleXObject(content);
+                break;
+            }
+            case PdfContentType::ImageDictionary:
+            {
+                // Images are drawn in the unit square
+                m_dropInlineImage = isRedacted(getUnitSquareBox(current().CTM));
+                if (m_dropInlineImage)
+                {
+                    m_count++;
+                    break;
+                }
+
+                m_buffer->append("BI");
+                for (auto& pair : content.InlineImageDictionary)
+                {
+                    m_buffer->append(" /");
+                    m_buffer->append(pair.first.GetEscapedName());
+                    pair.second.GetVariant().ToString(m_token);
+                    m_buffer->push_back(' ');
+                    m_buffer->append(m_token);
+                }
+
+                m_buffer->append(" ID ");
+                break;
+            }
+            case PdfContentType::ImageData:
+            {
+                if (m_dropInlineImage)
+                    break;
+
+                // The data includes the whitespace before EI, if any
+                m_buffer->append(content.InlineImageData);
+                if ((content.Warnings & PdfContentWarnings::MissingEndImage) == PdfContentWarnings::None)
+                    m_buffer->append("EI\n");
+                break;
+            }
+            case PdfContentType::UnexpectedKeyword:
+            {
+                // Custom operators or invalid content are kept as they are
+                writeOperands(content);
+                writeOperator(content.Keyword);
+                break;
+            }
+            default:
+            {
+                // Other contents are not reported when
+                // XObject forms are not followed
+                break;
+            }
+        }
+    }
+
+    m_buffer = nullptr;
+    return m_count;
+}
+
+void PageRedactor::handleOperator(const PdfContent& content)
+{
+    writeOperands(content);
+    auto op = GetPdfOperatorName(content.Operator);
+    if ((content.Warnings & PdfContentWarnings::InvalidOperator) != PdfContentWarnings::None)
+    {
+        // Keep the invalid operators as they are
+        writeOperator(op);
+        return;
+    }
+
+    double values[6];
+    auto& state = current();
+    switch (content.Operator)
+    {
+        case PdfOperator::q:
+        {
+            m_states.push_back(state);
+            break;
+        }
+        case PdfOperator::Q:
+        {
+            if (m_states.size() > 1)
+                m_states.pop_back();
+            break;
+        }
+        case PdfOperator::cm:
+        {
+            if (tryRead(content.Stack, values, 6))
+                state.CTM = Matrix::FromArray(values) * state.CTM;
+            break;
+        }
+        case PdfOperator::w:
+        {
+            if (tryRead(content.Stack, values, 1))
+                state.LineWidth = values[0];
+            break;
+        }
+        case PdfOperator::m:
+        case PdfOperator::l:
+        {
+            if (tryRead(content.Stack, values, 2))
+                addPathPoint(values[0], values[1]);
+            break;
+        }
+        case PdfOperator::c:
+        {
+            // The curve lies inside the hull of its control points
+            if (tryRead(content.Stack, values, 6))
+            {
+                addPathPoint(values[0], values[1]);
+                addPathPoint(values[2], values[3]);
+                addPathPoint(values[4], values[5]);
+            }
+            break;
+        }
+        case PdfOperator::v:
+        case PdfOperator::y:
+        {
+            if (tryRead(content.Stack, values, 4))
+            {
+                addPathPoint(values[0], values[1]);
+                addPathPoint(values[2], values[3]);
+            }
+            break;
+        }
+        case PdfOperator::re:
+        {
+            if (tryRead(content.Stack, values, 4))
+            {
+                addPathPoint(values[0], values[1]);
+                addPathPoint(values[0] + values[2], values[1]);
+                addPathPoint(values[0], values[1] + values[3]);
+                addPathPoint(values[0] + values[2], values[1] + values[3]);
+            }
+            break;
+        }
+        case PdfOperator::W:
+        case PdfOperator::W_Star:
+        {
+            // The clipping operator is written with the
+            // operator ending the path, which applies it
+            m_clipOp = op;
+            return;
+        }
+        case PdfOperator::S:
+        case PdfOperator::s:
+        case PdfOperator::B:
+        case PdfOperator::B_Star:
+        case PdfOperator::b:
+        case PdfOperator::b_Star:
+        {
+            paintPath(op, true);
+            return;
+        }
+        case PdfOperator::f:
+        case PdfOperator::F:
+        case PdfOperator::f_Star:
+        {
+            paintPath(op, false);
+            return;
+        }
+        case PdfOperator::n:
+        {
+            if (m_clipOp.size() != 0)
+                writeOperator(m_clipOp);
+
+            writeOperator(op);
+            endPath();
+            return;
+        }
+        case PdfOperator::sh:
+        {
+            // The shading fills the current clipping region
+            if (!isRedacted(state.Clip))
+                break;
+
+            m_count++;
+            m_buffer->resize(m_buffer->size() - m_operands.size());
+            (void)tryWriteClippedOut(state.Clip, m_operands + "sh\n");
+            return;
+        }
+        case PdfOperator::BT:
+        {
+            m_T_m = Matrix();
+            m_T_lm = Matrix();
+            break;
+        }
+        case PdfOperator::Tc:
+        {
+            if (tryRead(content.Stack, values, 1))
+                state.TextState.CharSpacing = values[0];
+            break;
+        }
+        case PdfOperator::Tw:
+        {
+            if (tryRead(content.Stack, values, 1))
+                state.TextState.WordSpacing = values[0];
+            break;
+        }
+        case PdfOperator::Tz:
+        {
+            if (tryRead(content.Stack, values, 1))
+                state.TextState.FontScale = values[0] / 100;
+            break;
+        }
+        case PdfOperator::TL:
+        {
+            if (tryRead(content.Stack, values, 1))
+                state.Leading = values[0];
+            break;
+        }
+        case PdfOperator::Tf:
+        {
+            const PdfName* name;
+            if (content.Stack[1].TryGetName(name) && content.Stack[0].TryGetReal(values[0]))
+                setFont(*name, values[0]);
+            break;
+        }
+        case PdfOperator::Tr:
+        {
+            if (tryRead(content.Stack, values, 1))
+                state.TextState.RenderingMode = (PdfTextRenderingMode)((int)values[0] + 1);
+            break;
+        }
+        case PdfOperator::Ts:
+        {
+            if (tryRead(content.Stack, values, 1))
+                state.Rise = values[0];
+            break;
+        }
+        case PdfOperator::Td:
+        case PdfOperator::TD:
+        {
+            if (tryRead(content.Stack, values, 2))
+            {
+                if (content.Operator == PdfOperator::TD)
+                    state.Leading = -values[1];
+
+                nextLine(values[0], values[1]);
+            }
+            break;
+        }
+        case PdfOperator::Tm:
+        {
+            if (tryRead(content.Stack, values, 6))
+            {
+                m_T_lm = Matrix::FromArray(values);
+                m_T_m = m_T_lm;
+            }
+            break;
+        }
+        case PdfOperator::T_Star:
+        {
+            nextLine(0, -state.Leading);
+            break;
+        }
+        case PdfOperator::Tj:
+        case PdfOperator::Quote:
+        case PdfOperator::DoubleQuote:
+        case PdfOperator::TJ:
+        {
+            showText(content);
+            return;
+        }
+        default:
+        {
+            // Write all the other operators as they are
+            break;
+        }
+    }
+
+    writeOperator(op);
+}
+
+void PageRedactor::handleXObject(const PdfContent& content)
+{
+    auto& xobj = *content.XObject;
+    RedactBox box;
+    if (xobj.GetType() == PdfXObjectType::Image)
+    {
+        box = getUnitSquareBox(current().CTM);
+    }
+    else if (xobj.GetType() == PdfXObjectType::Form)
+    {
+        // The form is clipped by its bounding box
+        auto m = static_cast<const PdfXObjectForm&>(xobj).GetMatrix() * current().CTM;
+        auto rect = xobj.GetRect();
+        box.Add(Vector2(rect.GetLeft(), rect.GetBottom()) * m);
+        box.Add(Vector2(rect.GetRight(), rect.GetBottom()) * m);
+        box.Add(Vector2(rect.GetLeft(), rect.GetTop()) * m);
+        box.Add(Vector2(rect.GetRight(), rect.GetTop()) * m);
+    }
+
+    box.Intersect(current().Clip);
+    if (isRedacted(box))
+    {
+        m_count++;
+        return;
+    }
+
+    writeOperands(content);
+    writeOperator("Do");
+}
+
+void PageRedactor::addPathPoint(double x, double y)
+{
+    if (!m_pathOffset.has_value())
+        m_pathOffset = m_buffer->size() - m_operands.size();
+
+    m_path.Add(Vector2(x, y) * current().CTM);
+}
+
+void PageRedactor::paintPath(const string_view& op, bool stroke)
+{
+    auto box = m_path;
+    if (stroke)
+        box.Grow(getStrokeExpansion());
+
+    box.Intersect(current().Clip);
+    if (!m_pathOffset.has_value() || !isRedacted(box))
+    {
+        if (m_clipOp.size() != 0)
+            writeOperator(m_clipOp);
+
+        writeOperator(op);
+        endPath();
+        return;
+    }
+
+    m_count++;
+    string path = m_buffer->substr(*m_pathOffset);
+    m_buffer->resize(*m_pathOffset);
+    bool covered = false;
+    for (auto& rect : *m_rects)
+    {
+        if (box.IsInside(rect))
+        {
+            covered = true;
+            break;
+        }
+    }
+
+    if (!covered)
+    {
+        string painting = path;
+        painting.append(op);
+        painting.push_back('\n');
+        (void)tryWriteClippedOut(box, painting);
+    }
+
+    if (m_clipOp.size() != 0)
+    {
+        // Apply the clipping path, without painting it
+        m_buffer->append(path);
+        writeOperator(m_clipOp);
+        writeOperator("n");
+    }
+
+    endPath();
+}
+
+void PageRedactor::endPath()
+{
+    if (m_clipOp.size() != 0)
+    {
+        current().Clip.Intersect(m_path);
+        m_clipOp = { };
+    }
+
+    m_path = { };
+    m_pathOffset = nullptr;
+}
+
+void PageRedactor::showText(const PdfContent& content)
+{
+    auto& state = current();
+    auto& textState = state.TextState;
+    string array = "[";
+    bool redacted = false;
+    if (content.Operator == PdfOperator::TJ)
+    {
+        const PdfArray* arr;
+        if (!content.Stack[0].TryGetArray(arr))
+        {
+            writeOperator("TJ");
+            return;
+        }
+
+        double adjustment;
+        for (auto& obj : *arr)
+        {
+            const PdfString* str;
+            if (obj.TryGetString(str))
+            {
+                redacted |= tryRedactString(*str, array);
+            }
+            else if (obj.TryGetReal(adjustment))
+            {
+                // The number is expressed in thousandths of a unit of text space
+                m_T_m = Matrix::CreateTranslation(Vector2(-adjustment / 1000
+                    * textState.FontSize * textState.FontScale, 0)) * m_T_m;
+                writeReal(adjustment, m_token);
+                array.append(m_token);
+                array.push_back(' ');
+            }
+        }
+    }
+    else
+    {
+        const PdfString* str;
+        if (!content.Stack[0].TryGetString(str))
+        {
+            writeOperator(GetPdfOperatorName(content.Operator));
+            return;
+        }
+
+        if (content.Operator == PdfOperator::DoubleQuote)
+        {
+            // Operator " arguments: aw ac string "
+            (void)content.Stack[2].TryGetReal(textState.WordSpacing);
+            (void)content.Stack[1].TryGetReal(textState.CharSpacing);
+        }
+
+        if (content.Operator != PdfOperator::Tj)
+            nextLine(0, -state.Leading);
+
+        redacted = tryRedactString(*str, array);
+    }
+
+    if (!redacted)
+    {
+        writeOperator(GetPdfOperatorName(content.Operator));
+        return;
+    }
+
+    // Rewrite the operator as TJ, moving the line first
+    m_count++;
+    m_buffer->resize(m_buffer->size() - m_operands.size());
+    if (content.Operator == PdfOperator::DoubleQuote)
+    {
+        writeReal(textState.WordSpacing, m_token);
+        m_buffer->append(m_token);
+        m_buffer->append(" Tw ");
+        writeReal(textState.CharSpacing, m_token);
+        m_buffer->append(m_token);
+        m_buffer->append(" Tc\n");
+    }
+
+    if (content.Operator == PdfOperator::Quote || content.Operator == PdfOperator::DoubleQuote)
+        m_buffer->append("T*\n");
+
+    if (array.back() == ' ')
+        array.pop_back();
+
+    array.push_back(']');
+    m_buffer->append(array);
+    writeOperator("TJ");
+}
+
+bool PageRedactor::tryRedactString(const PdfString& str, string& array)
+{
+    auto& state = current();
+    auto& textState = state.TextState;
+    double ascent;
+    double descent;
+    splitGlyphs(str, ascent, descent);
+
+    // Glyphs are removed regardless of the rendering mode,
+    // so invisible text can't be extracted either
+    auto m = m_T_m * state.CTM;
+    double x = 0;
+    size_t removedCount = 0;
+    for (auto& glyph : m_glyphs)
+    {
+        RedactBox box;
+        box.Add(Vector2(x, descent + state.Rise) * m);
+        box.Add(Vector2(x + glyph.Advance, descent + state.Rise) * m);
+        box.Add(Vector2(x, ascent + state.Rise) * m);
+        box.Add(Vector2(x + glyph.Advance, ascent + state.Rise) * m);
+        x += glyph.Advance;
+        if (isRedacted(box))
+        {
+            // Mark the glyph as removed
+            glyph.Code = { };
+            removedCount++;
+        }
+    }
+
+    m_T_m = Matrix::CreateTranslation(Vector2(x, 0)) * m_T_m;
+    if (removedCount == 0)
+    {
+        str.ToString(m_token);
+        array.append(m_token);
+        array.push_back(' ');
+        return false;
+    }
+
+    // Replace the runs of removed glyphs with
+    // adjustments of the same advance
+    double scale = textState.FontSize * textState.FontScale;
+    string run;
+    double removedAdvance = 0;
+    auto flush = [&]()
+    {
+        if (run.size() != 0)
+        {
+            PdfString::FromRaw(run, str.IsHex()).ToString(m_token);
+            array.append(m_token);
+            array.push_back(' ');
+            run.clear();
+        }
+
+        if (removedAdvance != 0 && scale != 0)
+        {
+            writeReal(-removedAdvance * 1000 / scale, m_token);
+            array.append(m_token);
+            array.push_back(' ');
+        }
+
+        removedAdvance = 0;
+    };
+
+    for (auto& glyph : m_glyphs)
+    {
+        if (glyph.Code.data() == nullptr)
+        {
+            if (run.size() != 0)
+                flush();
+
+            removedAdvance += glyph.Advance;
+        }
+        else
+        {
+            if (removedAdvance != 0)
+                flush();
+
+            run.append(glyph.Code);
+        }
+    }
+
+    flush();
+    return true;
+}
+
+void PageRedactor::splitGlyphs(const PdfString& str, double& ascent, double& descent)
+{
+    auto& state = current();
+    auto& textState = state.TextState;
+    auto& raw = str.GetRawData();
+    m_glyphs.clear();
+    if (textState.Font == nullptr)
+    {
+        // Without metrics, assume the glyphs as wide
+        // as half the font size, and as tall as it
+        double advance = textState.FontSize * textState.FontScale / 2;
+        for (size_t i = 0; i < raw.size(); i++)
+            m_glyphs.push_back({ string_view(raw).substr(i, 1), advance });
+
+        ascent = textState.FontSize;
+        descent = 0;
+        return;
+    }
+
+    auto& font = *textState.Font;
+    ascent = font.GetAscent(textState);
+    descent = font.GetDescent(textState);
+    if (ascent <= descent)
+    {
+        ascent = textState.FontSize;
+        descent = 0;
+    }
+
+    m_cids.clear();
+    (void)font.GetEncoding().TryConvertToCIDs(str, m_cids);
+    m_advances.resize(m_cids.size());
+    double width;
+    (void)font.TryGetStringAdvances(m_cids, textState, m_advances, width);
+
+    // Check the code units rebuild the string, to map
+    // every glyph to its bytes
+    size_t offset = 0;
+    for (size_t i = 0; i < m_cids.size(); i++)
+    {
+        auto& unit = m_cids[i].Unit;
+        if (offset + unit.CodeSpaceSize > raw.size())
+            break;
+
+        double advance = m_advances[i];
+        if (unit.CodeSpaceSize == 1 && unit.Code == 32)
+        {
+            // The word spacing applies to the single byte code 32
+            advance += textState.WordSpacing * textState.FontScale;
+        }
+
+        m_glyphs.push_back({ string_view(raw).substr(offset, unit.CodeSpaceSize), advance });
+        offset += unit.CodeSpaceSize;
+    }
+
+    if (offset != raw.size())
+    {
+        // Treat the whole string as a single glyph
+        m_glyphs.clear();
+        m_glyphs.push_back({ raw, font.GetStringWidth(str, textState) });
+    }
+}
+
+bool PageRedactor::tryWriteClippedOut(const RedactBox& box, const string_view& painting)
+{
+    if (!isRedacted(box))
+        return false;
+
+    auto& ctm = current().CTM;
+    Matrix inverse;
+    if (!tryInvert(ctm, inverse))
+    {
+        // The painting is degenerate, just remove it
+        return true;
+    }
+
+    // Clip out the rectangles in the default user space, intersecting
+    // the clipping path with the outside of each rectangle in turn
+    m_buffer->append("q\n");
+    writeMatrix(inverse, *m_buffer);
+    for (auto& rect : *m_rects)
+    {
+        if (!box.Intersects(rect))
+            continue;
+
+        RedactBox outer = box;
+        outer.Add(Vector2(rect.GetLeft(), rect.GetBottom()));
+        outer.Add(Vector2(rect.GetRight(), rect.GetTop()));
+        outer.Grow(1);
+        appendReal(outer.Left, *m_buffer);
+        appendReal(outer.Bottom, *m_buffer);
+        appendReal(outer.Right - outer.Left, *m_buffer);
+        appendReal(outer.Top - outer.Bottom, *m_buffer);
+        m_buffer->append("re ");
+        appendReal(rect.GetLeft(), *m_buffer);
+        appendReal(rect.GetBottom(), *m_buffer);
+        appendReal(rect.GetWidth(), *m_buffer);
+        appendReal(rect.GetHeight(), *m_buffer);
+        m_buffer->append("re W* n\n");
+    }
+
+    writeMatrix(ctm, *m_buffer);
+    m_buffer->append(painting);
+    m_buffer->append("Q\n");
+    return true;
+}
+
+void PageRedactor::setFont(const PdfName& name, double size)
+{
+    auto& textState = current().TextState;
+    textState.FontSize = size;
+    auto fontObj = m_page->GetFromResources("Font", name);
+    if (fontObj == nullptr || (textState.Font = m_page->GetDocument().GetFontManager().GetLoadedFont(*fontObj)) == nullptr)
+    {
+        mm::LogMessage(PdfLogSeverity::Warning, "Unable to find font object {}", name.GetString());
+        textState.Font = nullptr;
+    }
+}
+
+void PageRedactor::nextLine(double tx, double ty)
+{
+    m_T_lm = Matrix::CreateTranslation(Vector2(tx, ty)) * m_T_lm;
+    m_T_m = m_T_lm;
+}
+
+RedactBox PageRedactor::getUnitSquareBox(const Matrix& m) const
+{
+    RedactBox box;
+    box.Add(Vector2(0, 0) * m);
+    box.Add(Vector2(1, 0) * m);
+    box.Add(Vector2(0, 1) * m);
+    box.Add(Vector2(1, 1) * m);
+    return box;
+}
+
+bool PageRedactor::isRedacted(const RedactBox& box) const
+{
+    for (auto& rect : *m_rects)
+    {
+        if (box.Intersects(rect))
+            return true;
+    }
+
+    return false;
+}
+
+double PageRedactor::getStrokeExpansion()
+{
+    // Half the line width, scaled by the largest scale of the CTM
+    auto& state = current();
+    auto& ctm = state.CTM;
+    double scale = std::max(std::sqrt(ctm[0] * ctm[0] + ctm[1] * ctm[1]),
+        std::sqrt(ctm[2] * ctm[2] + ctm[3] * ctm[3]));
+    return std::abs(state.LineWidth) / 2 * scale;
+}
+
+void PageRedactor::writeOperands(const PdfContent& content)
+{
+    // Iterate the operands from the bottom of the stack. The
+    // operands are written in the output at once, so the
+    // operators rewritten can remove them
+    m_operands.clear();
+    for (auto it = content.Stack.rbegin(); it != content.Stack.rend(); it++)
+    {
+        it->ToString(m_token);
+        m_operands.append(m_token);
+        m_operands.push_back(' ');
+    }
+
+    m_buffer->append(m_operands);
+}
+
+void PageRedactor::writeOperator(const string_view& op)
+{
+    m_buffer->append(op);
+    m_buffer->push_back('\n');
+}
+
+bool RedactBox::IsEmpty() const
+{
+    return Left > Right || Bottom > Top;
+}
+
+void RedactBox::Add(const Vector2& point)
+{
+    Left = std::min(Left, point.X);
+    Bottom = std::min(Bottom, point.Y);
+    Right = std::max(Right, point.X);
+    Top = std::max(Top, point.Y);
+}
+
+void RedactBox::Intersect(const RedactBox& box)
+{
+    Left = std::max(Left, box.Left);
+    Bottom = std::max(Bottom, box.Bottom);
+    Right = std::min(Right, box.Right);
+    Top = std::min(Top, box.Top);
+}
+
+void RedactBox::Grow(double amount)
+{
+    if (IsEmpty())
+        return;
+
+    Left -= amount;
+    Bottom -= amount;
+    Right += amount;
+    Top += amount;
+}
+
+bool RedactBox::Intersects(const PdfRect& rect) const
+{
+    // Boxes just touching the rectangle don't intersect it
+    return !IsEmpty() && Left < rect.GetRight() && Right > rect.GetLeft()
+        && Bottom < rect.GetTop() && Top > rect.GetBottom();
+}
+
+bool RedactBox::IsInside(const PdfRect& rect) const
+{
+    return Left >= rect.GetLeft() && Right <= rect.GetRight()
+        && Bottom >= rect.GetBottom() && Top <= rect.GetTop();
+}
+
+void preloadFonts(PdfFontManager& fontManager, const PdfCanvas& canvas)
+{
+    auto resources = canvas.GetResources();
+    if (resources == nullptr)
+        return;
+
+    for (auto& pair : resources->GetResourceIterator("Font"))
+    {
+        if (pair.second->IsIndirect())
+            (void)fontManager.GetLoadedFont(*pair.second);
+    }
+}
+
+// Read the operands in the order they appear in the content stream
+bool tryRead(const PdfVariantStack& stack, double* values, unsigned count)
+{
+    if (stack.GetSize() < count)
+        return false;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        if (!stack[count - 1 - i].TryGetReal(values[i]))
+            return false;
+    }
+
+    return true;
+}
+
+bool tryInvert(const Matrix& m, Matrix& inverse)
+{
+    double det = m[0] * m[3] - m[1] * m[2];
+    if (std::abs(det) < 1e-12)
+        return false;
+
+    double a = m[3] / det;
+    double b = -m[1] / det;
+    double c = -m[2] / det;
+    double d = m[0] / det;
+    inverse = Matrix::FromCoefficients(a, b, c, d,
+        -(m[4] * a + m[5] * c), -(m[4] * b + m[5] * d));
+    return true;
+}
+
+void writeMatrix(const Matrix& m, string& str)
+{
+    for (unsigned i = 0; i < 6; i++)
+        appendReal(m[i], str);
+
+    str.append("cm\n");
+}
+
+// Append the number followed by a space
+void appendReal(double value, string& str)
+{
+    string token;
+    writeReal(value, token);
+    str.append(token);
+    str.push_back(' ');
+}
+
+void writeReal(double value, string& str)
+{
+    utls::FormatTo(str, value, 6);
+    if (str == "-0")
+        str = "0";
+}
@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_REDACTOR_H
+#define PDF_REDACTOR_H
+
+#include "PdfDeclarations.h"
+
+#include <map>
+
+#include "PdfColor.h"
+#include "PdfRect.h"
+
+namespace mm {
+
+class PdfDocument;
+
+/**
+ * Remove the contents of the pages that lie inside rectangles
+ *
+ * The content stream of every page with rectangles is read once,
+ * tracking the graphics and the text state, and it's rewritten without
+ * the content inside the rectangles. The redactor:
+ * - removes the single glyphs of the text showing operators that
+ *   intersect a rectangle, replacing them with TJ adjustments, so the
+ *   glyphs kept don't move. Invisible text is removed as well;
+ * - removes the paths inside a rectangle, and clips out the rectangles
+ *   from the paths and the shadings that intersect them;
+ * - removes the images and the XObject forms that intersect a rectangle.
+ *   The forms are removed whole, since they may be shared by other pages.
+ *
+ * The pages are read concurrently, on the executor of the document,
+ * and the contents of the modified pages are replaced with a single
+ * stream. Annotations are not modified
+ */
+class PDFMM_API PdfRedactor final
+{
+public:
+    PdfRedactor();
+
+    /** Add a rectangle to redact
+     * \param pageIndex the index of the page
+     * \param rect the rectangle, in the default user space of the page
+     */
+    void AddRect(unsigned pageIndex, const PdfRect& rect);
+
+    /** Set the color the rectangles are filled with after removing
+     * the contents, or null not to fill them. The default is null
+     */
+    void SetFillColor(const nullable<PdfColor>& color);
+
+    /** Redact the pages of the document
+     * \param threadCount the maximum count of threads reading the pages,
+     *      or 0 to use the concurrency of the executor of the document
+     * \returns the count of the operations removed or clipped
+     */
+    unsigned Redact(PdfDocument& doc, unsigned threadCount = 0);
+
+    /** Remove all the rectangles
+     */
+    void Clear();
+
+private:
+    std::map<unsigned, std::vector<PdfRect>> m_rects;
+    nullable<PdfColor> m_fillColor;
+};
+
+};
+
+#endif // PDF_REDACTOR_H
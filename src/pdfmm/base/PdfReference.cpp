@@ -29,7 +29,7 @@ void PdfReference::Write(OutputStreamDevice& device, PdfWriteFlags writeMode, ch
     if ((writeMode & PdfWriteFlags::NoInlineLiteral) == PdfWriteFlags::None)
         device.Write(' '); // Write space before the reference
 
-    utls::FormatTo(buffer, "{} {} R", m_ObjectNo, m_GenerationNo);
+    ToString(buffer);
     device.Write(buffer);
 }
 
@@ -43,7 +43,10 @@ string PdfReference::ToString() const
 void PdfReference::ToString(string& str) const
 {
     str.clear();
-    utls::FormatTo(str, "{} {} R", m_ObjectNo, m_GenerationNo);
+    utls::AppendNumberTo(str, m_ObjectNo);
+    str.push_back(' ');
+    utls::AppendNumberTo(str, m_GenerationNo);
+    str.append(" R");
 }
 
 bool PdfReference::operator<(const PdfReference& rhs) const
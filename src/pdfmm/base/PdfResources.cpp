@@ -11,15 +11,16 @@
 #include "PdfDictionary.h"
 #include "PdfCanvas.h"
 #include "PdfColor.h"
+#include "PdfDocument.h"
 
 using namespace std;
 using namespace mm;
 
 PdfResources::PdfResources(PdfObject& obj)
-    : PdfDictionaryElement(obj) { }
+    : PdfDictionaryElement(obj), m_CacheModificationCount(0) { }
 
 PdfResources::PdfResources(PdfDictionary& dict)
-    : PdfDictionaryElement(dict.AddKey("Resources", PdfDictionary()))
+    : PdfDictionaryElement(dict.AddKey("Resources", PdfDictionary())), m_CacheModificationCount(0)
 {
     GetDictionary().AddKey("ProcSet", PdfCanvas::GetProcSet());
 }
@@ -28,6 +29,7 @@ void PdfResources::AddResource(const PdfName& type, const PdfName& key, const Pd
 {
     auto& dict = getOrCreateDictionary(type);
     dict.AddKeyIndirectSafe(key, obj);
+    m_Cache.clear();
 }
 
 void PdfResources::AddResource(const PdfName& type, const PdfName& key, const PdfObject* obj)
@@ -37,6 +39,8 @@ void PdfResources::AddResource(const PdfName& type, const PdfName& key, const Pd
         dict.RemoveKey(key);
     else
         dict.AddKeyIndirect(key, obj);
+
+    m_Cache.clear();
 }
 
 PdfDictionaryIndirectIterable PdfResources::GetResourceIterator(const string_view& type)
@@ -64,11 +68,13 @@ void PdfResources::RemoveResource(const string_view& type, const string_view& ke
         return;
 
     dict->RemoveKey(key);
+    m_Cache.clear();
 }
 
 void PdfResources::RemoveResources(const string_view& type)
 {
     GetDictionary().RemoveKey(type);
+    m_Cache.clear();
 }
 
 PdfObject* PdfResources::GetResource(const string_view& type, const string_view& key)
@@ -125,6 +131,33 @@ void PdfResources::AddColorResource(const PdfColor& color)
 }
 
 PdfObject* PdfResources::getResource(const string_view& type, const string_view& key) const
+{
+    // Detached resources are not cached, as their
+    // modifications can't be detected
+    auto document = GetObject().GetDocument();
+    if (document == nullptr)
+        return findResource(type, key);
+
+    uint64_t modificationCount = document->GetObjects().GetModificationCount();
+    if (modificationCount != m_CacheModificationCount)
+    {
+        m_Cache.clear();
+        m_CacheModificationCount = modificationCount;
+    }
+
+    size_t hash = std::hash<string_view>()(type) * 31 + std::hash<string_view>()(key);
+    for (auto& cached : m_Cache)
+    {
+        if (cached.Hash == hash && cached.Key == key && cached.Type == type)
+            return cached.Object;
+    }
+
+    auto obj = findResource(type, key);
+    m_Cache.push_back({ hash, (string)type, (string)key, obj });
+    return obj;
+}
+
+PdfObject* PdfResources::findResource(const string_view& type, const string_view& key) const
 {
     PdfDictionary* dict;
     auto typeObj = const_cast<PdfResources&>(*this).GetDictionary().FindKey(type);
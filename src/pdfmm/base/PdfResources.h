@@ -53,8 +53,24 @@ public:
     void AddColorResource(const PdfColor& color);
 private:
     PdfObject* getResource(const std::string_view& type, const std::string_view& key) const;
+    PdfObject* findResource(const std::string_view& type, const std::string_view& key) const;
     bool tryGetDictionary(const std::string_view& type, PdfDictionary*& dict) const;
     PdfDictionary& getOrCreateDictionary(const std::string_view& type);
+
+private:
+    struct CachedResource
+    {
+        size_t Hash;
+        std::string Type;
+        std::string Key;
+        PdfObject* Object;
+    };
+
+private:
+    // Resources already looked up, also the missing ones, valid while
+    // the modification count of the document doesn't change
+    mutable std::vector<CachedResource> m_Cache;
+    mutable uint64_t m_CacheModificationCount;
 };
 
 };
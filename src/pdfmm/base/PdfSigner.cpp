@@ -7,6 +7,8 @@
 
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfSigner.h"
+#include <unordered_set>
+#include "PdfArray.h"
 #include "PdfDictionary.h"
 #include "PdfStreamDevice.h"
 
@@ -15,18 +17,41 @@ using namespace mm;
 
 constexpr const char* ByteRangeBeacon = "[ 0 1234567890 1234567890 1234567890]";
 constexpr size_t BufferSize = 65536;
+// The largest data following the /ByteRange beacon kept in memory
+constexpr size_t MaxKeptTailSize = 4 * 1024 * 1024;
 
 static size_t readForSignature(StreamDevice& device,
     size_t conentsBeaconOffset, size_t conentsBeaconSize,
     char* buffer, size_t size);
 static void adjustByteRange(StreamDevice& device, size_t byteRangeOffset,
-    size_t conentsBeaconOffset, size_t conentsBeaconSize, charbuff& buffer);
+    size_t conentsBeaconOffset, size_t conentsBeaconSize, charbuff& byteRange, charbuff& buffer);
 static void setSignature(StreamDevice& device, const string_view& sigData,
     size_t conentsBeaconOffset, charbuff& buffer);
 static void prepareBeaconsData(size_t signatureSize, string& contentsBeacon, string& byteRangeBeacon);
+static void collectSignatures(const PdfObject& field, unordered_set<const PdfObject*>& visited,
+    vector<PdfSignatureDigest>& signatures);
+static void readByteRange(const PdfObject& signature, size_t length,
+    vector<pair<size_t, size_t>>& byteRange);
+
+namespace
+{
+    // A range of the file covered by a signature
+    struct SignedRange
+    {
+        size_t Offset;
+        size_t End;
+        unsigned Index;
+    };
+}
 
 PdfSigner::~PdfSigner() { }
 
+size_t PdfSigner::GetSignatureSize() const
+{
+    // Inferred with a dry run
+    return 0;
+}
+
 string PdfSigner::GetSignatureFilter() const
 {
     // Default value
@@ -37,8 +62,13 @@ void mm::SignDocument(PdfMemDocument& doc, StreamDevice& device, PdfSigner& sign
     PdfSignature& signature, PdfSaveOptions opts)
 {
     charbuff signatureBuf;
-    signer.ComputeSignature(signatureBuf, true);
-    size_t beaconSize = signatureBuf.size();
+    size_t beaconSize = signer.GetSignatureSize();
+    if (beaconSize == 0)
+    {
+        signer.ComputeSignature(signatureBuf, true);
+        beaconSize = signatureBuf.size();
+    }
+
     PdfSignatureBeacons beacons;
     prepareBeaconsData(beaconSize, beacons.ContentsBeacon, beacons.ByteRangeBeacon);
     signature.PrepareForSigning(signer.GetSignatureFilter(), signer.GetSignatureSubFilter(),
@@ -58,23 +88,80 @@ void mm::SignDocument(PdfMemDocument& doc, StreamDevice& device, PdfSigner& sign
         acroForm->GetDictionary().RemoveKey("NeedAppearances");
     }
 
-    doc.SaveUpdate(device, opts);
-    device.Flush();
+    // Hash the data already in the device, then the update while
+    // it's being written. The hashing stops at the /ByteRange beacon,
+    // as it's overwritten after writing with the actual byte range
+    signer.Reset();
+    charbuff buffer(BufferSize);
+    size_t length = device.GetLength();
+    device.Seek(0);
+    for (size_t offset = 0; offset < length; )
+    {
+        size_t readSize = std::min(BufferSize, length - offset);
+        device.Read(buffer.data(), readSize);
+        signer.AppendData({ buffer.data(), readSize });
+        offset += readSize;
+    }
 
-    charbuff buffer;
-    adjustByteRange(device, *beacons.ByteRangeOffset, *beacons.ContentsOffset,
-        beacons.ContentsBeacon.size(), buffer);
+    // The data following the /ByteRange beacon is also kept, to hash
+    // it when the beacon is replaced without reading it back from the
+    // device. Large updates are read back instead
+    auto& byteRangeOffset = *beacons.ByteRangeOffset;
+    charbuff tail;
+    bool keepTail = true;
+    HashingStreamDevice hashingDevice(device, [&](size_t offset, const bufferview& data) {
+        // NOTE: The beacon offset is set just before the beacon is written
+        size_t size = data.size();
+        if (byteRangeOffset != 0)
+            size = offset < byteRangeOffset ? std::min(size, byteRangeOffset - offset) : 0;
+
+        if (size != 0)
+            signer.AppendData({ data.data(), size });
+
+        if (byteRangeOffset == 0 || size == data.size() || !keepTail)
+            return;
+
+        tail.append(data.data() + size, data.size() - size);
+        if (tail.size() > MaxKeptTailSize)
+        {
+            keepTail = false;
+            charbuff().swap(tail);
+        }
+    });
+    doc.SaveUpdate(hashingDevice, opts);
     device.Flush();
 
-    // Read data from the device to prepare the signature
-    signer.Reset();
-    device.Seek(0);
-    size_t readBytes;
-    buffer.resize(BufferSize);
-    while ((readBytes = readForSignature(device, *beacons.ContentsOffset, beacons.ContentsBeacon.size(),
-        buffer.data(), BufferSize)) != 0)
+    if (byteRangeOffset == 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "The signature beacons were not written");
+
+    size_t contentsOffset = *beacons.ContentsOffset;
+    size_t contentsSize = beacons.ContentsBeacon.size();
+    if (contentsOffset < byteRangeOffset)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "The /Contents beacon precedes the /ByteRange beacon");
+
+    charbuff byteRange;
+    adjustByteRange(device, byteRangeOffset, contentsOffset, contentsSize, byteRange, buffer);
+    if (keepTail)
     {
-        signer.AppendData({ buffer.data(), readBytes });
+        // Hash the kept data with the actual byte range, skipping the contents
+        std::memcpy(tail.data(), byteRange.data(), byteRange.size());
+        size_t contentsStart = contentsOffset - byteRangeOffset;
+        signer.AppendData({ tail.data(), contentsStart });
+        signer.AppendData({ tail.data() + contentsStart + contentsSize, tail.size() - contentsStart - contentsSize });
+    }
+    else
+    {
+        device.Flush();
+
+        // Read the data following the /ByteRange beacon, skipping the contents
+        device.Seek(byteRangeOffset);
+        size_t readBytes;
+        buffer.resize(BufferSize);
+        while ((readBytes = readForSignature(device, contentsOffset, contentsSize,
+            buffer.data(), BufferSize)) != 0)
+        {
+            signer.AppendData({ buffer.data(), readBytes });
+        }
     }
 
     signer.ComputeSignature(signatureBuf, false);
@@ -85,10 +172,117 @@ void mm::SignDocument(PdfMemDocument& doc, StreamDevice& device, PdfSigner& sign
     // beacon size previously cached to fill all
     // available reserved space for the /Contents
     signatureBuf.resize(beaconSize);
-    setSignature(device, signatureBuf, *beacons.ContentsOffset, buffer);
+    setSignature(device, signatureBuf, contentsOffset, buffer);
     device.Flush();
 }
 
+PdfSignatureDigester::~PdfSignatureDigester() { }
+
+vector<PdfSignatureDigest> mm::ComputeSignatureDigests(PdfDocument& doc,
+    InputStreamDevice& device, const PdfSignatureDigesterFactory& createDigester)
+{
+    vector<PdfSignatureDigest> signatures;
+    auto acroForm = doc.GetAcroForm();
+    if (acroForm == nullptr)
+        return signatures;
+
+    auto fields = acroForm->GetDictionary().FindKey("Fields");
+    if (fields == nullptr || !fields->IsArray())
+        return signatures;
+
+    unordered_set<const PdfObject*> visited;
+    auto& fieldsArr = fields->GetArray();
+    for (unsigned i = 0; i < fieldsArr.GetSize(); i++)
+        collectSignatures(fieldsArr.FindAt(i), visited, signatures);
+
+    if (signatures.size() == 0)
+        return signatures;
+
+    size_t length = device.GetLength();
+    vector<unique_ptr<PdfSignatureDigester>> digesters;
+    vector<SignedRange> ranges;
+    for (unsigned i = 0; i < signatures.size(); i++)
+    {
+        auto& signature = signatures[i];
+        readByteRange(*signature.Signature, length, signature.ByteRange);
+        for (auto& range : signature.ByteRange)
+            ranges.push_back({ range.first, range.first + range.second, i });
+
+        auto digester = createDigester(*signature.Signature);
+        if (digester == nullptr)
+            PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+        digesters.push_back(std::move(digester));
+    }
+
+    // Read the file once from the first signed byte to the last,
+    // appending every chunk read to the digesters of the signatures
+    // covering it. The file order is also the order of the ranges
+    // of every signature, as they don't overlap
+    std::sort(ranges.begin(), ranges.end(), [](const SignedRange& lhs, const SignedRange& rhs) {
+        return lhs.Offset < rhs.Offset;
+    });
+
+    size_t end = 0;
+    for (auto& range : ranges)
+        end = std::max(end, range.End);
+
+    charbuff buffer(BufferSize);
+    size_t next = 0;
+    size_t offset = ranges[0].Offset;
+    device.Seek(offset);
+    while (offset < end)
+    {
+        // Skip the data not covered by any signature, as the ranges
+        // starting before are all ended
+        if (next < ranges.size() && offset < ranges[next].Offset)
+        {
+            bool covered = false;
+            for (unsigned i = 0; i < next; i++)
+            {
+                if (ranges[i].End > offset)
+                {
+                    covered = true;
+                    break;
+                }
+            }
+
+            if (!covered)
+            {
+                offset = ranges[next].Offset;
+                device.Seek(offset);
+            }
+        }
+
+        size_t readSize = std::min(BufferSize, end - offset);
+        if (next < ranges.size() && offset < ranges[next].Offset)
+            readSize = std::min(readSize, ranges[next].Offset - offset);
+
+        device.Read(buffer.data(), readSize);
+        size_t readEnd = offset + readSize;
+        while (next < ranges.size() && ranges[next].Offset < readEnd)
+            next++;
+
+        for (unsigned i = 0; i < next; i++)
+        {
+            auto& range = ranges[i];
+            if (range.End <= offset)
+                continue;
+
+            size_t from = std::max(range.Offset, offset);
+            size_t to = std::min(range.End, readEnd);
+            digesters[range.Index]->AppendData({ buffer.data() + (from - offset), to - from });
+        }
+
+        offset = readEnd;
+    }
+
+    for (unsigned i = 0; i < signatures.size(); i++)
+        digesters[i]->ComputeDigest(signatures[i].Digest);
+
+    return signatures;
+}
+
 size_t readForSignature(StreamDevice& device, size_t conentsBeaconOffset, size_t conentsBeaconSize,
     char* buffer, size_t bufferSize)
 {
@@ -128,18 +322,23 @@ size_t readForSignature(StreamDevice& device, size_t conentsBeaconOffset, size_t
 }
 
 void adjustByteRange(StreamDevice& device, size_t byteRangeOffset,
-    size_t conentsBeaconOffset, size_t conentsBeaconSize, charbuff& buffer)
+    size_t conentsBeaconOffset, size_t conentsBeaconSize, charbuff& byteRange, charbuff& buffer)
 {
     // Get final position
     size_t fileEnd = device.GetLength();
+    const int64_t byteRangeValues[4] = {
+        0,
+        static_cast<int64_t>(conentsBeaconOffset),
+        static_cast<int64_t>(conentsBeaconOffset + conentsBeaconSize),
+        static_cast<int64_t>(fileEnd - (conentsBeaconOffset + conentsBeaconSize))
+    };
     PdfArray arr;
-    arr.Add(PdfObject(static_cast<int64_t>(0)));
-    arr.Add(PdfObject(static_cast<int64_t>(conentsBeaconOffset)));
-    arr.Add(PdfObject(static_cast<int64_t>(conentsBeaconOffset + conentsBeaconSize)));
-    arr.Add(PdfObject(static_cast<int64_t>(fileEnd - (conentsBeaconOffset + conentsBeaconSize))));
+    arr.AddNumbers(byteRangeValues);
 
+    BufferStreamDevice byteRangeDevice(byteRange);
+    arr.Write(byteRangeDevice, PdfWriteFlags::None, { }, buffer);
     device.Seek(byteRangeOffset);
-    arr.Write(device, PdfWriteFlags::None, { }, buffer);
+    device.Write(byteRange);
 }
 
 void setSignature(StreamDevice& device, const string_view& contentsData,
@@ -160,3 +359,56 @@ void prepareBeaconsData(size_t signatureSize, string& contentsBeacon, string& by
                                                          // as an hex string
     byteRangeBeacon.resize(char_traits<char>::length(ByteRangeBeacon), ' ');
 }
+
+void collectSignatures(const PdfObject& field, unordered_set<const PdfObject*>& visited,
+    vector<PdfSignatureDigest>& signatures)
+{
+    if (!field.IsDictionary() || !visited.insert(&field).second)
+        return;
+
+    auto& dict = field.GetDictionary();
+    auto signature = dict.FindKey("V");
+    auto type = dict.FindKeyParent("FT");
+    if (signature != nullptr && signature->IsDictionary()
+        && type != nullptr && type->IsName() && type->GetName() == "Sig")
+    {
+        PdfSignatureDigest digest;
+        digest.Field = &field;
+        digest.Signature = signature;
+        auto contents = signature->GetDictionary().FindKey("Contents");
+        if (contents != nullptr && contents->IsString())
+            digest.Contents = contents->GetString().GetRawData();
+
+        // Fields with no /ByteRange are not signed yet
+        if (signature->GetDictionary().HasKey("ByteRange"))
+            signatures.push_back(std::move(digest));
+    }
+
+    auto kids = dict.FindKey("Kids");
+    if (kids == nullptr || !kids->IsArray())
+        return;
+
+    auto& arr = kids->GetArray();
+    for (unsigned i = 0; i < arr.GetSize(); i++)
+        collectSignatures(arr.FindAt(i), visited, signatures);
+}
+
+void readByteRange(const PdfObject& signature, size_t length, vector<pair<size_t, size_t>>& byteRange)
+{
+    auto& arr = signature.GetDictionary().MustFindKey("ByteRange").GetArray();
+    if (arr.GetSize() % 2 != 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "The signature /ByteRange has an odd count of numbers");
+
+    // The ranges must be ascending and not overlapping
+    size_t end = 0;
+    for (unsigned i = 0; i < arr.GetSize(); i += 2)
+    {
+        int64_t offset = arr.FindAt(i).GetNumber();
+        int64_t size = arr.FindAt(i + 1).GetNumber();
+        if (offset < (int64_t)end || size < 0 || (uint64_t)offset + (uint64_t)size > length)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Invalid signature /ByteRange");
+
+        byteRange.push_back({ (size_t)offset, (size_t)size });
+        end = (size_t)(offset + size);
+    }
+}
@@ -16,6 +16,7 @@
 namespace mm
 {
     class StreamDevice;
+    class InputStreamDevice;
 
     class PDFMM_API PdfSigner
     {
@@ -42,6 +43,13 @@ namespace mm
          */
         virtual void ComputeSignature(charbuff& buffer, bool dryrun) = 0;
 
+        /**
+         * Should return the size of the signature, if known in advance,
+         * to reserve its space in the /Contents. The default returns 0,
+         * and the size is inferred with ComputeSignature(buffer, true)
+         */
+        virtual size_t GetSignatureSize() const;
+
         /**
          * Should return the signature /Filter, for example "Adobe.PPKLite"
          */
@@ -58,6 +66,60 @@ namespace mm
         virtual std::string GetSignatureType() const = 0;
     };
 
+    /** Computes the digest of the document data covered by a
+     * signature, the verification counterpart of PdfSigner
+     */
+    class PDFMM_API PdfSignatureDigester
+    {
+    public:
+        virtual ~PdfSignatureDigester();
+
+        /**
+         * Called incrementally with the document raw data covered
+         * by the /ByteRange of the signature, in the file order
+         * \param data incremental raw data
+         */
+        virtual void AppendData(const bufferview& data) = 0;
+
+        /**
+         * Called to compute the digest when all the data has been appended
+         * \param digest The buffer that will hold the digest
+         */
+        virtual void ComputeDigest(charbuff& digest) = 0;
+    };
+
+    /** The data to verify a signature, as computed by ComputeSignatureDigests
+     */
+    struct PdfSignatureDigest
+    {
+        // The signature field
+        const PdfObject* Field = nullptr;
+        // The signature dictionary, the /V of the field
+        const PdfObject* Signature = nullptr;
+        // The offsets and the lengths of the /ByteRange
+        std::vector<std::pair<size_t, size_t>> ByteRange;
+        // The /Contents of the signature, as a CMS blob
+        charbuff Contents;
+        charbuff Digest;
+    };
+
+    /** Create the digester for the given signature
+     *  dictionary, for example inspecting the /SubFilter
+     */
+    using PdfSignatureDigesterFactory = std::function<std::unique_ptr<PdfSignatureDigester>(const PdfObject& signature)>;
+
+    /** Enumerate the signed signature fields of the document and
+     * compute the digests of all their /ByteRange with a single
+     * sequential read of the device, as the ranges of the signatures
+     * of every incremental revision overlap
+     * \param doc the document loaded from the device
+     * \param device the device the document has been loaded from
+     * \param createDigester called to create the digester of every signature
+     * \returns the signatures in the order of the fields
+     */
+    std::vector<PdfSignatureDigest> ComputeSignatureDigests(PdfDocument& doc,
+        InputStreamDevice& device, const PdfSignatureDigesterFactory& createDigester);
+
     /** Sign the document on the given signature field
      * \param doc the document to be signed
      * \param device the input/output device where the document will be saved
@@ -0,0 +1,536 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfSnapshotSerializer.h"
+
+#include <cstring>
+
+#include "PdfArray.h"
+#include "PdfDictionary.h"
+#include "PdfIndirectObjectList.h"
+#include "PdfMemDocument.h"
+#include "PdfObjectStream.h"
+#include "PdfParserObject.h"
+#include "PdfStreamDevice.h"
+
+using namespace std;
+using namespace mm;
+
+static constexpr string_view SnapshotMagic = "PDFMMSNP";
+static constexpr uint32_t SnapshotFormatVersion = 1;
+// The length of the tail of the source document that is hashed
+// to detect a different source. It includes the last xref section
+static constexpr size_t SourceTailLength = 4096;
+// Deeper objects are rejected, as done by the tokenizer
+static constexpr unsigned MaxObjectDepth = 1000;
+
+namespace
+{
+    enum class SnapshotTag : uint8_t
+    {
+        Null = 0,
+        False,
+        True,
+        Number,
+        Real,
+        String,
+        HexString,
+        Name,
+        Reference,
+        Array,
+        Dictionary,
+    };
+
+    enum class SnapshotObjectFlags : uint8_t
+    {
+        None = 0,
+        HasOffset = 1,          ///< The object can be read again from the source at the offset
+        HasSourceStream = 2,    ///< The stream is read from the source at the offset
+        HasInlineStream = 4,    ///< The stream data is in the snapshot
+    };
+}
+
+ENABLE_BITMASK_OPERATORS(SnapshotObjectFlags);
+
+static uint64_t hashSourceTail(InputStreamDevice& source, size_t& length);
+
+PdfSnapshotSerializer::PdfSnapshotSerializer(PdfMemDocument& doc) :
+    m_doc(&doc),
+    m_cursor(nullptr),
+    m_end(nullptr) { }
+
+void PdfSnapshotSerializer::Write(InputStreamDevice* source, OutputStreamDevice& device)
+{
+    if (m_doc->GetEncrypt() != nullptr)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidEncryptionDict, "Snapshots of encrypted documents are not supported");
+
+    // Serialize the body first, collecting the names to intern
+    m_buffer.clear();
+    m_nameIds.clear();
+    m_names.clear();
+    writeObject(m_doc->GetTrailer().GetObject(), 0);
+
+    auto& objects = m_doc->GetObjects();
+    vector<const PdfObject*> objectList;
+    objectList.reserve(objects.GetSize());
+    for (auto obj : objects)
+        objectList.push_back(obj);
+
+    writeUInt32((uint32_t)objectList.size());
+    for (auto obj : objectList)
+    {
+        auto& ref = obj->GetIndirectReference();
+        writeUInt32(ref.ObjectNumber());
+        writeUInt16(ref.GenerationNumber());
+
+        // Read the object first, so the presence of the stream is known
+        (void)obj->GetVariant();
+
+        // NOTE: Modified objects can't be read again from the source
+        auto parserObj = dynamic_cast<const PdfParserObject*>(obj);
+        if (parserObj != nullptr && (obj->IsDirty() || parserObj->GetOffset() < 0))
+            parserObj = nullptr;
+
+        auto flags = SnapshotObjectFlags::None;
+        if (parserObj != nullptr)
+        {
+            flags |= SnapshotObjectFlags::HasOffset;
+            if (parserObj->HasStreamToParse())
+                flags |= SnapshotObjectFlags::HasSourceStream;
+        }
+        else if (obj->HasStream())
+        {
+            flags |= SnapshotObjectFlags::HasInlineStream;
+        }
+
+        writeUInt8((uint8_t)flags);
+        if (parserObj != nullptr)
+            writeUInt64((uint64_t)parserObj->GetOffset());
+
+        writeObject(*obj, 0);
+
+        if ((flags & SnapshotObjectFlags::HasSourceStream) != SnapshotObjectFlags::None)
+        {
+            writeUInt64(parserObj->m_StreamOffset);
+        }
+        else if ((flags & SnapshotObjectFlags::HasInlineStream) != SnapshotObjectFlags::None)
+        {
+            charbuff data;
+            BufferStreamDevice stream(data);
+            obj->GetStream()->CopyTo(stream);
+            writeData(data);
+        }
+    }
+
+    auto& freeObjects = objects.GetFreeObjects();
+    writeUInt32((uint32_t)freeObjects.size());
+    for (auto& ref : freeObjects)
+    {
+        writeUInt32(ref.ObjectNumber());
+        writeUInt16(ref.GenerationNumber());
+    }
+
+    writeUInt32((uint32_t)objects.m_UnavailableObjects.size());
+    for (auto objnum : objects.m_UnavailableObjects)
+        writeUInt32(objnum);
+
+    writeUInt32(objects.GetObjectCount());
+
+    // Then write the header and the names
+    charbuff body = std::move(m_buffer);
+    m_buffer.clear();
+    m_buffer.append(SnapshotMagic.data(), SnapshotMagic.size());
+    writeUInt32(SnapshotFormatVersion);
+
+    size_t sourceLength = 0;
+    uint64_t sourceHash = 0;
+    if (source != nullptr)
+        sourceHash = hashSourceTail(*source, sourceLength);
+
+    writeUInt64(sourceLength);
+    writeUInt64(sourceHash);
+    writeUInt8((uint8_t)m_doc->m_Version);
+    writeUInt8(m_doc->m_HasXRefStream ? 1 : 0);
+    writeUInt64((uint64_t)m_doc->m_PrevXRefOffset);
+
+    writeUInt32((uint32_t)m_names.size());
+    for (auto& name : m_names)
+        writeData(name.GetRawData());
+
+    device.Write(m_buffer.data(), m_buffer.size());
+    device.Write(body.data(), body.size());
+    m_buffer.clear();
+}
+
+void PdfSnapshotSerializer::Read(const bufferview& snapshot, InputStreamDevice* source)
+{
+    m_cursor = snapshot.data();
+    m_end = snapshot.data() + snapshot.size();
+    m_names.clear();
+
+    if (string_view(readRaw(SnapshotMagic.size()), SnapshotMagic.size()) != SnapshotMagic)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "The data is not a document snapshot");
+
+    uint32_t formatVersion = readUInt32();
+    if (formatVersion != SnapshotFormatVersion)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Unsupported snapshot format version {}", formatVersion);
+
+    size_t sourceLength = (size_t)readUInt64();
+    uint64_t sourceHash = readUInt64();
+    if (sourceLength != 0)
+    {
+        if (source == nullptr)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The snapshot requires the source document");
+
+        size_t actualLength;
+        if (hashSourceTail(*source, actualLength) != sourceHash || actualLength != sourceLength)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The source document doesn't match the snapshot");
+    }
+
+    m_doc->m_Version = (PdfVersion)readUInt8();
+    m_doc->m_InitialVersion = m_doc->m_Version;
+    m_doc->m_HasXRefStream = readUInt8() != 0;
+    m_doc->m_PrevXRefOffset = (int64_t)readUInt64();
+
+    uint32_t nameCount = readUInt32();
+    if (nameCount > (size_t)(m_end - m_cursor) / 4)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid snapshot name count");
+
+    m_names.reserve(nameCount);
+    for (uint32_t i = 0; i < nameCount; i++)
+        m_names.push_back(PdfName::FromRaw(readData()));
+
+    // NOTE: The trailer is set when the objects it refers to are added
+    auto trailer = std::make_unique<PdfObject>(readObject(0));
+
+    auto& objects = m_doc->GetObjects();
+    uint32_t objectCount = readUInt32();
+    for (uint32_t i = 0; i < objectCount; i++)
+    {
+        uint32_t objnum = readUInt32();
+        uint16_t gennum = readUInt16();
+        PdfReference ref(objnum, gennum);
+        auto flags = (SnapshotObjectFlags)readUInt8();
+        size_t offset = 0;
+        if ((flags & SnapshotObjectFlags::HasOffset) != SnapshotObjectFlags::None)
+            offset = (size_t)readUInt64();
+
+        auto obj = readObject(0);
+        if ((flags & SnapshotObjectFlags::HasOffset) != SnapshotObjectFlags::None)
+        {
+            if (source == nullptr)
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The snapshot requires the source document");
+
+            // Restore a loaded parser object, so its stream and, when
+            // its memory is freed, the object are read from the source
+            unique_ptr<PdfParserObject> parserObj(new PdfParserObject(*m_doc, ref, *source, (ssize_t)offset));
+            parserObj->m_Variant = std::move(obj.m_Variant);
+            parserObj->m_IsDelayedLoadDone = true;
+            parserObj->SetVariantOwner();
+            if ((flags & SnapshotObjectFlags::HasSourceStream) != SnapshotObjectFlags::None)
+            {
+                parserObj->m_HasStream = true;
+                parserObj->m_StreamOffset = (size_t)readUInt64();
+            }
+            else
+            {
+                parserObj->m_IsDelayedLoadStreamDone = true;
+            }
+
+            objects.PushObject(parserObj.release());
+        }
+        else
+        {
+            unique_ptr<PdfObject> newObj(new PdfObject(std::move(obj.m_Variant)));
+            newObj->SetIndirectReference(ref);
+            if ((flags & SnapshotObjectFlags::HasInlineStream) != SnapshotObjectFlags::None)
+            {
+                SpanStreamDevice input(readData());
+                newObj->getOrCreateStream().SetRawData(input);
+            }
+
+            objects.PushObject(newObj.release());
+        }
+    }
+
+    uint32_t freeCount = readUInt32();
+    for (uint32_t i = 0; i < freeCount; i++)
+    {
+        uint32_t objnum = readUInt32();
+        uint16_t gennum = readUInt16();
+        objects.AddFreeObject(PdfReference(objnum, gennum));
+    }
+
+    uint32_t unavailableCount = readUInt32();
+    for (uint32_t i = 0; i < unavailableCount; i++)
+        objects.m_UnavailableObjects.insert(readUInt32());
+
+    uint32_t count = readUInt32();
+    if (count > objects.m_ObjectCount)
+        objects.m_ObjectCount = count;
+
+    m_doc->SetTrailer(std::move(trailer));
+
+    m_names.clear();
+}
+
+void PdfSnapshotSerializer::writeObject(const PdfObject& obj, unsigned depth)
+{
+    if (depth > MaxObjectDepth)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The object is too deep to be stored in a snapshot");
+
+    switch (obj.GetDataType())
+    {
+        case PdfDataType::Null:
+            writeUInt8((uint8_t)SnapshotTag::Null);
+            break;
+        case PdfDataType::Bool:
+            writeUInt8((uint8_t)(obj.GetBool() ? SnapshotTag::True : SnapshotTag::False));
+            break;
+        case PdfDataType::Number:
+            writeUInt8((uint8_t)SnapshotTag::Number);
+            writeUInt64((uint64_t)obj.GetNumber());
+            break;
+        case PdfDataType::Real:
+        {
+            double real = obj.GetRealStrict();
+            uint64_t bits;
+            std::memcpy(&bits, &real, sizeof(bits));
+            writeUInt8((uint8_t)SnapshotTag::Real);
+            writeUInt64(bits);
+            break;
+        }
+        case PdfDataType::String:
+        {
+            auto& str = obj.GetString();
+            writeUInt8((uint8_t)(str.IsHex() ? SnapshotTag::HexString : SnapshotTag::String));
+            writeData(str.GetRawData());
+            break;
+        }
+        case PdfDataType::Name:
+            writeUInt8((uint8_t)SnapshotTag::Name);
+            writeName(obj.GetName());
+            break;
+        case PdfDataType::Reference:
+        {
+            auto ref = obj.GetReference();
+            writeUInt8((uint8_t)SnapshotTag::Reference);
+            writeUInt32(ref.ObjectNumber());
+            writeUInt16(ref.GenerationNumber());
+            break;
+        }
+        case PdfDataType::Array:
+        {
+            auto& arr = obj.GetArray();
+            writeUInt8((uint8_t)SnapshotTag::Array);
+            writeUInt32(arr.GetSize());
+            for (auto& child : arr)
+                writeObject(child, depth + 1);
+            break;
+        }
+        case PdfDataType::Dictionary:
+        {
+            auto& dict = obj.GetDictionary();
+            writeUInt8((uint8_t)SnapshotTag::Dictionary);
+            writeUInt32((uint32_t)dict.GetSize());
+            for (auto& pair : dict)
+            {
+                writeName(pair.first);
+                writeObject(pair.second, depth + 1);
+            }
+            break;
+        }
+        default:
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Raw data can't be stored in a snapshot");
+    }
+}
+
+void PdfSnapshotSerializer::writeName(const PdfName& name)
+{
+    auto found = m_nameIds.find(name.GetRawData());
+    if (found != m_nameIds.end())
+    {
+        writeUInt32(found->second);
+        return;
+    }
+
+    // NOTE: The key views the data of the stored name, which is shared
+    // by the copies of the name, so it stays valid when the list grows
+    uint32_t id = (uint32_t)m_names.size();
+    m_names.push_back(name);
+    m_nameIds.emplace(m_names.back().GetRawData(), id);
+    writeUInt32(id);
+}
+
+void PdfSnapshotSerializer::writeUInt8(uint8_t value)
+{
+    m_buffer.push_back((char)value);
+}
+
+void PdfSnapshotSerializer::writeUInt16(uint16_t value)
+{
+    char buf[2];
+    utls::WriteUInt16BE(buf, value);
+    m_buffer.append(buf, 2);
+}
+
+void PdfSnapshotSerializer::writeUInt32(uint32_t value)
+{
+    char buf[4];
+    utls::WriteUInt32BE(buf, value);
+    m_buffer.append(buf, 4);
+}
+
+void PdfSnapshotSerializer::writeUInt64(uint64_t value)
+{
+    writeUInt32((uint32_t)(value >> 32));
+    writeUInt32((uint32_t)value);
+}
+
+void PdfSnapshotSerializer::writeData(const bufferview& view)
+{
+    writeUInt64(view.size());
+    m_buffer.append(view.data(), view.size());
+}
+
+PdfObject PdfSnapshotSerializer::readObject(unsigned depth)
+{
+    if (depth > MaxObjectDepth)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "The snapshot object is too deep");
+
+    auto tag = (SnapshotTag)readUInt8();
+    switch (tag)
+    {
+        case SnapshotTag::Null:
+            return PdfObject(PdfVariant::NullValue);
+        case SnapshotTag::False:
+            return PdfObject(false);
+        case SnapshotTag::True:
+            return PdfObject(true);
+        case SnapshotTag::Number:
+            return PdfObject((int64_t)readUInt64());
+        case SnapshotTag::Real:
+        {
+            uint64_t bits = readUInt64();
+            double real;
+            std::memcpy(&real, &bits, sizeof(real));
+            return PdfObject(real);
+        }
+        case SnapshotTag::String:
+        case SnapshotTag::HexString:
+            return PdfObject(PdfString::FromRaw(readData(), tag == SnapshotTag::HexString));
+        case SnapshotTag::Name:
+            return PdfObject(readName());
+        case SnapshotTag::Reference:
+        {
+            uint32_t objnum = readUInt32();
+            uint16_t gennum = readUInt16();
+            return PdfObject(PdfReference(objnum, gennum));
+        }
+        case SnapshotTag::Array:
+        {
+            uint32_t size = readUInt32();
+            if (size > (size_t)(m_end - m_cursor))
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid snapshot array size");
+
+            PdfArray arr;
+            arr.Reserve(size);
+            for (uint32_t i = 0; i < size; i++)
+                arr.Add(readObject(depth + 1));
+
+            return PdfObject(std::move(arr));
+        }
+        case SnapshotTag::Dictionary:
+        {
+            uint32_t size = readUInt32();
+            PdfDictionary dict;
+            for (uint32_t i = 0; i < size; i++)
+            {
+                auto& key = readName();
+                dict.AddKey(key, readObject(depth + 1));
+            }
+
+            return PdfObject(std::move(dict));
+        }
+        default:
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid snapshot object tag {}", (unsigned)tag);
+    }
+}
+
+const PdfName& PdfSnapshotSerializer::readName()
+{
+    uint32_t id = readUInt32();
+    if (id >= m_names.size())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid snapshot name id");
+
+    return m_names[id];
+}
+
+uint8_t PdfSnapshotSerializer::readUInt8()
+{
+    return (uint8_t)*readRaw(1);
+}
+
+uint16_t PdfSnapshotSerializer::readUInt16()
+{
+    uint16_t value;
+    utls::ReadUInt16BE(readRaw(2), value);
+    return value;
+}
+
+uint32_t PdfSnapshotSerializer::readUInt32()
+{
+    uint32_t value;
+    utls::ReadUInt32BE(readRaw(4), value);
+    return value;
+}
+
+uint64_t PdfSnapshotSerializer::readUInt64()
+{
+    uint64_t high = readUInt32();
+    uint64_t low = readUInt32();
+    return (high << 32) | low;
+}
+
+bufferview PdfSnapshotSerializer::readData()
+{
+    uint64_t size = readUInt64();
+    if (size > (uint64_t)(m_end - m_cursor))
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnexpectedEOF, "Unexpected end of the snapshot");
+
+    return bufferview(readRaw((size_t)size), (size_t)size);
+}
+
+const char* PdfSnapshotSerializer::readRaw(size_t size)
+{
+    if (size > (size_t)(m_end - m_cursor))
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnexpectedEOF, "Unexpected end of the snapshot");
+
+    auto ret = m_cursor;
+    m_cursor += size;
+    return ret;
+}
+
+uint64_t hashSourceTail(InputStreamDevice& source, size_t& length)
+{
+    // 64 bit FNV-1a, which is stable across platforms
+    length = source.GetLength();
+    size_t tailLength = std::min(length, SourceTailLength);
+    charbuff tail(tailLength);
+    source.Seek(length - tailLength);
+    source.Read(tail.data(), tailLength);
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < tailLength; i++)
+    {
+        hash ^= (unsigned char)tail[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
@@ -0,0 +1,77 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_SNAPSHOT_SERIALIZER_H
+#define PDF_SNAPSHOT_SERIALIZER_H
+
+#include "PdfName.h"
+
+#include <unordered_map>
+
+namespace mm {
+
+class PdfMemDocument;
+class PdfObject;
+class InputStreamDevice;
+class OutputStreamDevice;
+
+/**
+ * A utility class for PdfMemDocument that saves and restores the
+ * object graph of a loaded document in a binary snapshot
+ *
+ * The snapshot has a header with a magic and the format version,
+ * the length and a hash of the tail of the source document, the
+ * table of the interned names, the trailer, the objects and the
+ * free object list. The streams read from the source document are
+ * stored as their offset in it, the others are stored inline.
+ * Integers are big endian
+ */
+class PdfSnapshotSerializer
+{
+public:
+    PdfSnapshotSerializer(PdfMemDocument& doc);
+
+    /** Write the snapshot of the document
+     *  \param source the device the document was loaded from, if any
+     */
+    void Write(InputStreamDevice* source, OutputStreamDevice& device);
+
+    /** Restore the document from the snapshot
+     *  \param source the device the snapshot was saved from. It must outlive the document
+     */
+    void Read(const bufferview& snapshot, InputStreamDevice* source);
+
+private:
+    void writeObject(const PdfObject& obj, unsigned depth);
+    void writeName(const PdfName& name);
+    void writeUInt8(uint8_t value);
+    void writeUInt16(uint16_t value);
+    void writeUInt32(uint32_t value);
+    void writeUInt64(uint64_t value);
+    void writeData(const bufferview& view);
+
+    PdfObject readObject(unsigned depth);
+    const PdfName& readName();
+    uint8_t readUInt8();
+    uint16_t readUInt16();
+    uint32_t readUInt32();
+    uint64_t readUInt64();
+    bufferview readData();
+    const char* readRaw(size_t size);
+
+private:
+    PdfMemDocument* m_doc;
+    charbuff m_buffer;
+    std::unordered_map<std::string_view, uint32_t> m_nameIds;
+    const char* m_cursor;
+    const char* m_end;
+    std::vector<PdfName> m_names;
+};
+
+};
+
+#endif // PDF_SNAPSHOT_SERIALIZER_H
@@ -0,0 +1,379 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfSpillObjectStream.h"
+
+#include <atomic>
+#include <mutex>
+#include <random>
+
+#include <pdfmm/private/FileSystem.h>
+#include <pdfmm/private/PdfPoolPrivate.h>
+
+#include "PdfFilter.h"
+#include "PdfObject.h"
+#include "PdfStreamDevice.h"
+
+using namespace std;
+using namespace mm;
+
+// The size of the chunks written to and read from the scratch file
+static constexpr size_t SpillChunkSize = 64 * 1024;
+static constexpr unsigned MaxScratchFileAttempts = 16;
+
+namespace mm
+{
+    // The scratch file shared by the streams of a factory. The data is
+    // only appended, and it's read and written under a lock, because
+    // the streams may be written concurrently
+    class PdfSpillStorage final
+    {
+    public:
+        PdfSpillStorage(size_t threshold, const string_view& directory);
+        ~PdfSpillStorage();
+
+    public:
+        /** Append the data at the end of the file
+         * \returns the offset of the data
+         */
+        size_t Append(const char* data, size_t size);
+
+        void Read(size_t offset, char* buffer, size_t size);
+
+        size_t GetLength();
+
+        size_t GetThreshold() const { return m_threshold; }
+
+    private:
+        void open();
+
+    private:
+        size_t m_threshold;
+        string m_directory;
+        mutex m_mutex;
+        unique_ptr<FileStreamDevice> m_device;
+        string m_filepath;
+        size_t m_length;
+    };
+}
+
+class PdfSpillObjectStream::SpillOutputStream final : public OutputStream
+{
+public:
+    SpillOutputStream(PdfSpillStorage& storage, Data& data)
+        : m_storage(&storage), m_data(&data) { }
+
+protected:
+    void writeBuffer(const char* buffer, size_t size) override
+    {
+        auto& data = *m_data;
+        data.Length += size;
+        if (data.Extents.size() == 0 && data.Length <= m_storage->GetThreshold())
+        {
+            data.Buffer.append(buffer, size);
+            return;
+        }
+
+        // Above the threshold the buffer stages the chunks written to the file
+        if (data.Buffer.size() + size < SpillChunkSize)
+        {
+            data.Buffer.append(buffer, size);
+            return;
+        }
+
+        spillBuffer();
+        if (size < SpillChunkSize)
+            data.Buffer.append(buffer, size);
+        else
+            spill(buffer, size);
+    }
+
+    void flush() override
+    {
+        if (m_data->Extents.size() != 0)
+            spillBuffer();
+    }
+
+private:
+    void spillBuffer()
+    {
+        auto& data = *m_data;
+        if (data.Buffer.size() == 0)
+            return;
+
+        spill(data.Buffer.data(), data.Buffer.size());
+        data.Buffer.clear();
+        if (data.Buffer.capacity() > SpillChunkSize)
+            data.Buffer.shrink_to_fit();
+    }
+
+    void spill(const char* buffer, size_t size)
+    {
+        size_t offset = m_storage->Append(buffer, size);
+        auto& extents = m_data->Extents;
+
+        // The data of a stream is contiguous in the file, unless
+        // other streams were spilled while appending to it
+        if (extents.size() != 0 && extents.back().Offset + extents.back().Length == offset)
+            extents.back().Length += size;
+        else
+            extents.push_back({ offset, size });
+    }
+
+private:
+    PdfSpillStorage* m_storage;
+    Data* m_data;
+};
+
+class PdfSpillObjectStream::SpillInputStream final : public InputStream
+{
+public:
+    SpillInputStream(const shared_ptr<PdfSpillStorage>& storage, const shared_ptr<const Data>& data)
+        : m_storage(storage), m_data(data), m_extentIndex(0), m_position(0) { }
+
+protected:
+    size_t readBuffer(char* buffer, size_t size, bool& eof) override
+    {
+        auto& data = *m_data;
+        if (data.Extents.size() == 0)
+        {
+            size_t read = std::min(size, data.Buffer.size() - m_position);
+            std::memcpy(buffer, data.Buffer.data() + m_position, read);
+            m_position += read;
+            eof = m_position == data.Buffer.size();
+            return read;
+        }
+
+        size_t read = 0;
+        while (read < size && m_extentIndex < data.Extents.size())
+        {
+            auto& extent = data.Extents[m_extentIndex];
+            size_t toRead = std::min(size - read, extent.Length - m_position);
+            m_storage->Read(extent.Offset + m_position, buffer + read, toRead);
+            read += toRead;
+            m_position += toRead;
+            if (m_position == extent.Length)
+            {
+                m_extentIndex++;
+                m_position = 0;
+            }
+        }
+
+        eof = m_extentIndex == data.Extents.size();
+        return read;
+    }
+
+private:
+    shared_ptr<PdfSpillStorage> m_storage;
+    shared_ptr<const Data> m_data;
+    size_t m_extentIndex;
+    size_t m_position;
+};
+
+PdfSpillObjectStream::PdfSpillObjectStream(PdfObject& parent, const shared_ptr<PdfSpillStorage>& storage)
+    : PdfObjectStream(parent), m_storage(storage), m_data(std::make_shared<Data>())
+{
+}
+
+PdfSpillObjectStream::~PdfSpillObjectStream()
+{
+    EnsureAppendClosed();
+}
+
+unique_ptr<InputStream> PdfSpillObjectStream::GetInputStream() const
+{
+    return unique_ptr<InputStream>(new SpillInputStream(m_storage, m_data));
+}
+
+void PdfSpillObjectStream::BeginAppendImpl(const PdfFilterList& filters)
+{
+    // Don't modify the data if it's shared with copies of the stream
+    m_data = std::make_shared<Data>();
+    if (filters.size() == 0)
+    {
+        m_Stream = unique_ptr<OutputStream>(new SpillOutputStream(*m_storage, *m_data));
+    }
+    else
+    {
+        m_SpillStream = unique_ptr<OutputStream>(new SpillOutputStream(*m_storage, *m_data));
+        m_Stream = PdfFilterFactory::CreateEncodeStream(filters, *m_SpillStream, GetEffectiveCompressionLevel());
+    }
+}
+
+void PdfSpillObjectStream::AppendImpl(const char* data, size_t len)
+{
+    m_Stream->Write(data, len);
+}
+
+void PdfSpillObjectStream::EndAppendImpl()
+{
+    m_Stream->Flush();
+    m_Stream = nullptr;
+
+    if (m_SpillStream != nullptr)
+    {
+        m_SpillStream->Flush();
+        m_SpillStream = nullptr;
+    }
+}
+
+void PdfSpillObjectStream::CopyTo(OutputStream& stream) const
+{
+    if (m_data->Extents.size() == 0)
+    {
+        stream.Write(m_data->Buffer.data(), m_data->Buffer.size());
+        return;
+    }
+
+    PdfScratchBuffer buffer;
+    buffer->resize(SpillChunkSize);
+    for (auto& extent : m_data->Extents)
+    {
+        for (size_t offset = 0; offset < extent.Length; offset += SpillChunkSize)
+        {
+            size_t size = std::min(SpillChunkSize, extent.Length - offset);
+            m_storage->Read(extent.Offset + offset, buffer->data(), size);
+            stream.Write(buffer->data(), size);
+        }
+    }
+}
+
+void PdfSpillObjectStream::CopyFrom(const PdfObjectStream& rhs)
+{
+    auto spillStream = dynamic_cast<const PdfSpillObjectStream*>(&rhs);
+    if (spillStream == nullptr || spillStream->m_storage != m_storage)
+    {
+        PdfObjectStream::CopyFrom(rhs);
+        return;
+    }
+
+    m_data = spillStream->m_data;
+}
+
+void PdfSpillObjectStream::Write(OutputStream& stream, const PdfStatefulEncrypt& encrypt)
+{
+    stream.Write("stream\n");
+    if (encrypt.HasEncrypt())
+    {
+        // Encrypt while writing, not to hold a copy of the data
+        auto output = encrypt.CreateEncryptionOutputStream(stream);
+        CopyTo(*output);
+        output->Flush();
+    }
+    else
+    {
+        CopyTo(stream);
+    }
+
+    stream.Write("\nendstream\n");
+    stream.Flush();
+}
+
+size_t PdfSpillObjectStream::GetLength() const
+{
+    return m_data->Length;
+}
+
+bool PdfSpillObjectStream::IsSpilled() const
+{
+    return m_data->Extents.size() != 0;
+}
+
+size_t PdfSpillObjectStream::GetMemoryLength() const
+{
+    return m_data->Buffer.size();
+}
+
+PdfSpillStreamFactory::PdfSpillStreamFactory(size_t threshold, const string_view& directory)
+    : m_storage(std::make_shared<PdfSpillStorage>(threshold, directory))
+{
+}
+
+PdfSpillStreamFactory::~PdfSpillStreamFactory() { }
+
+PdfObjectStream* PdfSpillStreamFactory::CreateStream(PdfObject& parent)
+{
+    return new PdfSpillObjectStream(parent, m_storage);
+}
+
+size_t PdfSpillStreamFactory::GetSpilledLength() const
+{
+    return m_storage->GetLength();
+}
+
+size_t PdfSpillStreamFactory::GetThreshold() const
+{
+    return m_storage->GetThreshold();
+}
+
+PdfSpillStorage::PdfSpillStorage(size_t threshold, const string_view& directory)
+    : m_threshold(threshold), m_directory(directory), m_length(0) { }
+
+PdfSpillStorage::~PdfSpillStorage()
+{
+    if (m_device == nullptr)
+        return;
+
+    m_device = nullptr;
+    error_code ec;
+    fs::remove(fs::u8path(m_filepath), ec);
+}
+
+size_t PdfSpillStorage::Append(const char* data, size_t size)
+{
+    unique_lock<mutex> lock(m_mutex);
+    if (m_device == nullptr)
+        open();
+
+    size_t offset = m_length;
+    m_device->Seek(offset);
+    m_device->Write(data, size);
+    m_length += size;
+    return offset;
+}
+
+void PdfSpillStorage::Read(size_t offset, char* buffer, size_t size)
+{
+    unique_lock<mutex> lock(m_mutex);
+    if (m_device == nullptr || offset + size > m_length)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The spilled data is out of the scratch file");
+
+    m_device->Seek(offset);
+    m_device->Read(buffer, size);
+}
+
+size_t PdfSpillStorage::GetLength()
+{
+    unique_lock<mutex> lock(m_mutex);
+    return m_length;
+}
+
+void PdfSpillStorage::open()
+{
+    static atomic<unsigned> s_counter;
+    auto directory = m_directory.empty() ? fs::temp_directory_path() : fs::u8path(m_directory);
+    random_device random;
+    for (unsigned i = 0; i < MaxScratchFileAttempts; i++)
+    {
+        auto filepath = (directory / fs::u8path(utls::Format("pdfmm-spill-{:08x}-{}.tmp",
+            random(), s_counter++))).u8string();
+        try
+        {
+            // Fail if the file exists, not to overwrite a file of another process
+            m_device.reset(new FileStreamDevice(filepath, FileMode::CreateNew, DeviceAccess::ReadWrite));
+            m_filepath = filepath;
+            return;
+        }
+        catch (PdfError&)
+        {
+            // Try another name
+        }
+    }
+
+    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::FileNotFound, "Unable to create a scratch file in {}", directory.u8string());
+}
@@ -0,0 +1,128 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_SPILL_OBJECT_STREAM_H
+#define PDF_SPILL_OBJECT_STREAM_H
+
+#include "PdfDeclarations.h"
+
+#include "PdfObjectStream.h"
+#include "PdfIndirectObjectList.h"
+
+namespace mm {
+
+class PdfSpillStorage;
+
+/** A PDF stream that is held in memory while it's small and
+ *  is moved to a scratch file when it grows above a threshold
+ *
+ * The data of the streams above the threshold are appended to a
+ * scratch file shared by the streams of the same factory, and they
+ * are read back only when needed, e.g. when the document is written.
+ * Like PdfMemoryObjectStream, the copies share the data, which is
+ * never modified: the space of the data replaced in the scratch file
+ * is not reused, and the file is removed when the factory and all
+ * the streams created by it are destroyed
+ * \see PdfSpillStreamFactory
+ */
+class PDFMM_API PdfSpillObjectStream final : public PdfObjectStream
+{
+    friend class PdfSpillStreamFactory;
+    class SpillOutputStream;
+    class SpillInputStream;
+
+private:
+    PdfSpillObjectStream(PdfObject& parent, const std::shared_ptr<PdfSpillStorage>& storage);
+
+public:
+    ~PdfSpillObjectStream();
+
+    void Write(OutputStream& stream, const PdfStatefulEncrypt& encrypt) override;
+
+    void CopyTo(OutputStream& stream) const override;
+
+    size_t GetLength() const override;
+
+    /** \returns true if the data is in the scratch file
+     */
+    bool IsSpilled() const;
+
+    /** \returns the length of the data held in memory
+     */
+    size_t GetMemoryLength() const;
+
+protected:
+    std::unique_ptr<InputStream> GetInputStream() const override;
+    void BeginAppendImpl(const PdfFilterList& filters) override;
+    void AppendImpl(const char* data, size_t len) override;
+    void EndAppendImpl() override;
+    void CopyFrom(const PdfObjectStream& rhs) override;
+
+private:
+    // A range of the data in the scratch file
+    struct Extent
+    {
+        size_t Offset;
+        size_t Length;
+    };
+
+    // The data of the stream, shared with its copies. It's never
+    // modified, it's replaced when appending instead
+    struct Data
+    {
+        charbuff Buffer;
+        std::vector<Extent> Extents;
+        size_t Length = 0;
+    };
+
+private:
+    std::shared_ptr<PdfSpillStorage> m_storage;
+    std::shared_ptr<Data> m_data;
+    std::unique_ptr<OutputStream> m_Stream;
+    std::unique_ptr<OutputStream> m_SpillStream;
+};
+
+/** A stream factory that creates PdfSpillObjectStream instances, to
+ *  hold the large streams of a PdfMemDocument in a scratch file
+ *
+ * Set it with PdfIndirectObjectList::SetStreamFactory() after the
+ * document is loaded or created, as loading resets the factory, and
+ * before creating or modifying the streams. The factory must outlive
+ * the document, or be reset before it's destroyed, while the scratch
+ * file lives until the last stream using it is destroyed
+ */
+class PDFMM_API PdfSpillStreamFactory final : public PdfIndirectObjectList::StreamFactory
+{
+public:
+    static constexpr size_t DefaultThreshold = 4 * 1024 * 1024;
+
+public:
+    /**
+     * \param threshold the stream length above which the data is moved to the scratch file
+     * \param directory the directory of the scratch file, or empty for the temporary directory
+     */
+    PdfSpillStreamFactory(size_t threshold = DefaultThreshold, const std::string_view& directory = { });
+
+    ~PdfSpillStreamFactory();
+
+public:
+    PdfObjectStream* CreateStream(PdfObject& parent) override;
+
+    /** \returns the length of the scratch file, including the
+     *  replaced data, or 0 if no stream was spilled yet
+     */
+    size_t GetSpilledLength() const;
+
+    size_t GetThreshold() const;
+
+private:
+    std::shared_ptr<PdfSpillStorage> m_storage;
+};
+
+};
+
+#endif // PDF_SPILL_OBJECT_STREAM_H
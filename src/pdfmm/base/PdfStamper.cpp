@@ -0,0 +1,133 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfStamper.h"
+
+#include "PdfArray.h"
+#include "PdfDictionary.h"
+#include "PdfDocument.h"
+#include "PdfPage.h"
+#include "PdfPageCollection.h"
+#include "PdfStringStream.h"
+#include "PdfXObjectForm.h"
+
+using namespace std;
+using namespace mm;
+
+PdfStamper::PdfStamper(const PdfXObjectForm& form)
+    : m_form(&form), m_underlay(false) { }
+
+void PdfStamper::SetMatrix(const Matrix& matrix)
+{
+    m_matrix = matrix;
+    m_stampStreams.clear();
+}
+
+void PdfStamper::SetUnderlay(bool underlay)
+{
+    m_underlay = underlay;
+    m_stampStreams.clear();
+}
+
+void PdfStamper::Stamp(PdfDocument& doc)
+{
+    auto& pages = doc.GetPages();
+    for (unsigned i = 0; i < pages.GetCount(); i++)
+        Stamp(pages.GetPage(i));
+}
+
+void PdfStamper::Stamp(PdfPage& page)
+{
+    auto& doc = page.GetDocument();
+    if (&doc != &m_form->GetDocument())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The form belongs to another document");
+
+    // Add the form with its identifier, unless the resources
+    // use it already for another object. The resources shared
+    // by more pages get the form only once
+    auto& formObj = m_form->GetObject();
+    auto& resources = page.GetOrCreateResources();
+    PdfName name = m_form->GetIdentifier();
+    unsigned nameIndex = 0;
+    const PdfObject* resource;
+    while ((resource = resources.GetResource("XObject", name.GetString())) != nullptr
+        && resource->GetIndirectReference() != formObj.GetIndirectReference())
+    {
+        name = PdfName(string(m_form->GetIdentifier().GetString()) + "_" + std::to_string(nameIndex++));
+    }
+
+    if (resource == nullptr)
+        resources.AddResource("XObject", name, formObj);
+
+    // Build a new direct /Contents array with the references to the
+    // existing streams, so an array shared by more pages is not modified
+    auto& dict = page.GetObject().GetDictionary();
+    PdfArray contents;
+    auto contentsObj = dict.GetKey("Contents");
+    if (contentsObj != nullptr)
+    {
+        auto resolved = dict.FindKey("Contents");
+        if (resolved != nullptr && resolved->IsArray())
+        {
+            for (auto& item : resolved->GetArray())
+                contents.Add(item);
+        }
+        else
+        {
+            contents.Add(*contentsObj);
+        }
+    }
+
+    auto& stampStream = getStampStream(doc, name);
+    if (m_underlay)
+    {
+        contents.insert(contents.begin(), stampStream);
+    }
+    else
+    {
+        // The stamp stream closes the q of the wrap stream
+        contents.insert(contents.begin(), getWrapStream(doc));
+        contents.Add(stampStream);
+    }
+
+    dict.AddKey("Contents", std::move(contents));
+    page.m_Contents.reset(new PdfContents(page, dict.MustFindKey("Contents")));
+}
+
+const PdfReference& PdfStamper::getStampStream(PdfDocument& doc, const PdfName& name)
+{
+    auto found = m_stampStreams.find(name);
+    if (found != m_stampStreams.end())
+        return found->second;
+
+    PdfStringStream ops;
+    if (!m_underlay)
+        ops << "Q" << endl;
+
+    ops << "q" << endl
+        << m_matrix[0] << " " << m_matrix[1] << " "
+        << m_matrix[2] << " " << m_matrix[3] << " "
+        << m_matrix[4] << " " << m_matrix[5] << " cm" << endl
+        << "/" << name.GetString() << " Do" << endl << "Q" << endl;
+
+    auto obj = doc.GetObjects().CreateDictionaryObject();
+    obj->GetOrCreateStream().Set(ops.GetString());
+    return m_stampStreams.emplace(name, obj->GetIndirectReference()).first->second;
+}
+
+const PdfReference& PdfStamper::getWrapStream(PdfDocument& doc)
+{
+    if (!m_wrapStream.IsIndirect())
+    {
+        auto obj = doc.GetObjects().CreateDictionaryObject();
+        obj->GetOrCreateStream().Set("q\n"sv);
+        m_wrapStream = obj->GetIndirectReference();
+    }
+
+    return m_wrapStream;
+}
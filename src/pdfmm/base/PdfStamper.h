@@ -0,0 +1,83 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_STAMPER_H
+#define PDF_STAMPER_H
+
+#include "PdfDeclarations.h"
+
+#include <map>
+
+#include "PdfMath.h"
+#include "PdfName.h"
+#include "PdfReference.h"
+
+namespace mm {
+
+class PdfDocument;
+class PdfPage;
+class PdfXObjectForm;
+
+/**
+ * Stamp a XObject form, e.g. a watermark, a barcode or a Bates
+ * number, on existing pages without rewriting their contents
+ *
+ * The form is added once to the resources of the pages, under a name
+ * not used yet, and a small content stream drawing it is added to the
+ * /Contents array of the pages. The existing content streams are not
+ * decoded: they are wrapped in a q/Q pair with shared streams, so the
+ * state they leave doesn't affect the stamp. The content streams of
+ * the stamp are shared by all the pages too, so a document saved
+ * with PdfMemDocument::SaveUpdate() contains only the new streams
+ * and the changed page dictionaries, or resource dictionaries
+ */
+class PDFMM_API PdfStamper final
+{
+public:
+    /** Create a stamper drawing the given form
+     *  \param form the form to stamp, in the document of the pages
+     */
+    PdfStamper(const PdfXObjectForm& form);
+
+    /** Set the transformation of the form, in the default user
+     *  space of the pages. The default is the identity
+     */
+    void SetMatrix(const Matrix& matrix);
+
+    /** Draw the form below the existing contents, instead of above them
+     */
+    void SetUnderlay(bool underlay);
+
+    /** Stamp the form on a page
+     */
+    void Stamp(PdfPage& page);
+
+    /** Stamp the form on all the pages of a document
+     */
+    void Stamp(PdfDocument& doc);
+
+private:
+    PdfStamper(const PdfStamper&) = delete;
+    PdfStamper& operator=(const PdfStamper&) = delete;
+
+private:
+    // The shared content streams of the stamp, for the
+    // ones drawing it and for the wrapping of the contents
+    const PdfReference& getStampStream(PdfDocument& doc, const PdfName& name);
+    const PdfReference& getWrapStream(PdfDocument& doc);
+
+private:
+    const PdfXObjectForm* m_form;
+    Matrix m_matrix;
+    bool m_underlay;
+    std::map<PdfName, PdfReference> m_stampStreams;
+    PdfReference m_wrapStream;
+};
+
+};
+
+#endif // PDF_STAMPER_H
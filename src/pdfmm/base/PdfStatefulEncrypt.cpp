@@ -16,12 +16,24 @@ void PdfStatefulEncrypt::EncryptTo(charbuff& out, const bufferview& view) const
     m_encrypt->EncryptTo(out, view, m_currReference);
 }
 
+void PdfStatefulEncrypt::EncryptTo(char* out, const bufferview& view) const
+{
+    PDFMM_INVARIANT(m_encrypt != nullptr);
+    m_encrypt->EncryptTo(out, view, m_currReference);
+}
+
 void PdfStatefulEncrypt::DecryptTo(charbuff& out, const bufferview& view) const
 {
     PDFMM_INVARIANT(m_encrypt != nullptr);
     m_encrypt->DecryptTo(out, view, m_currReference);
 }
 
+unique_ptr<OutputStream> PdfStatefulEncrypt::CreateEncryptionOutputStream(OutputStream& stream) const
+{
+    PDFMM_INVARIANT(m_encrypt != nullptr);
+    return m_encrypt->CreateEncryptionOutputStream(stream, m_currReference);
+}
+
 size_t PdfStatefulEncrypt::CalculateStreamLength(size_t length) const
 {
     PDFMM_INVARIANT(m_encrypt != nullptr);
@@ -10,6 +10,7 @@
 
 #include "PdfDeclarations.h"
 #include "PdfReference.h"
+#include "PdfOutputStream.h"
 
 namespace mm
 {
@@ -26,10 +27,20 @@ namespace mm
          */
         void EncryptTo(charbuff& out, const bufferview& view) const;
 
+        /** Encrypt a character span into a buffer
+         *  \param out the buffer, of CalculateStreamLength(view.size()) characters
+         */
+        void EncryptTo(char* out, const bufferview& view) const;
+
         /** Decrypt a character span
          */
         void DecryptTo(charbuff& out, const bufferview& view) const;
 
+        /** Create a stream that encrypts the data written to it
+         *  \see PdfEncrypt::CreateEncryptionOutputStream
+         */
+        std::unique_ptr<OutputStream> CreateEncryptionOutputStream(OutputStream& stream) const;
+
         size_t CalculateStreamLength(size_t length) const;
 
         bool HasEncrypt() const { return m_encrypt != nullptr; }
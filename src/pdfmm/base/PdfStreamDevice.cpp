@@ -10,9 +10,21 @@
 #include "PdfStreamDevice.h"
 
 #include <fstream>
+#include <cerrno>
 
 #include <pdfmm/private/FileSystem.h>
 
+#ifdef _WIN32
+#include <utfcpp/utf8.h>
+#include <pdfmm/private/WindowsLeanMean.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif // _WIN32
+
 using namespace std;
 using namespace mm;
 
@@ -406,6 +418,9 @@ fstream* FileStreamDevice::getFileStream(const string_view& filename, FileMode m
         case FileMode::CreateNew:
             if (fs::exists(filename))
                 PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "The file must not exist");
+            // NOTE: Without ios_base::trunc opening for
+            // reading/writing fails if the file doesn't exist
+            openmode |= ios_base::trunc;
             break;
         case FileMode::Create:
             openmode |= ios_base::trunc;
@@ -452,6 +467,526 @@ fstream* FileStreamDevice::getFileStream(const string_view& filename, FileMode m
     return stream;
 }
 
+MappedFileStreamDevice::MappedFileStreamDevice(const string_view& filepath) :
+    StreamDevice(DeviceAccess::Read),
+    m_Filepath(filepath),
+    m_buffer(nullptr),
+    m_Length(0),
+    m_Position(0)
+#ifdef _WIN32
+    , m_mapping(nullptr)
+#endif // _WIN32
+{
+#ifdef _WIN32
+    auto filepath16 = utf8::utf8to16(m_Filepath);
+    HANDLE file = CreateFileW((LPCWSTR)filepath16.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to open file {}: {}", filepath, utls::GetWin32ErrorMessage(GetLastError()));
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        unsigned rc = GetLastError();
+        CloseHandle(file);
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to get size of file {}: {}", filepath, utls::GetWin32ErrorMessage(rc));
+    }
+
+    m_Length = (size_t)size.QuadPart;
+    if (m_Length == 0)
+    {
+        // Empty files can't be mapped
+        CloseHandle(file);
+        return;
+    }
+
+    // NOTE: The mapping keeps a reference to the file, so
+    // the file handle can be closed immediately after
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    unsigned rc = GetLastError();
+    CloseHandle(file);
+    if (mapping == nullptr)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to map file {}: {}", filepath, utls::GetWin32ErrorMessage(rc));
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        rc = GetLastError();
+        CloseHandle(mapping);
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to map file {}: {}", filepath, utls::GetWin32ErrorMessage(rc));
+    }
+
+    m_mapping = mapping;
+    m_buffer = (const char*)view;
+#else // _WIN32
+    int fd = ::open(m_Filepath.c_str(), O_RDONLY);
+    if (fd == -1)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to open file {}: {}", filepath, std::strerror(errno));
+
+    struct stat st;
+    if (::fstat(fd, &st) == -1)
+    {
+        int err = errno;
+        ::close(fd);
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to get size of file {}: {}", filepath, std::strerror(err));
+    }
+
+    m_Length = (size_t)st.st_size;
+    if (m_Length == 0)
+    {
+        // Empty files can't be mapped
+        ::close(fd);
+        return;
+    }
+
+    // NOTE: The mapping keeps a reference to the file, so
+    // the file descriptor can be closed immediately after
+    void* view = ::mmap(nullptr, m_Length, PROT_READ, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    ::close(fd);
+    if (view == MAP_FAILED)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to map file {}: {}", filepath, std::strerror(err));
+
+    m_buffer = (const char*)view;
+#endif // _WIN32
+}
+
+MappedFileStreamDevice::~MappedFileStreamDevice()
+{
+    unmap();
+}
+
+size_t MappedFileStreamDevice::GetLength() const
+{
+    return m_Length;
+}
+
+size_t MappedFileStreamDevice::GetPosition() const
+{
+    return m_Position;
+}
+
+bool MappedFileStreamDevice::Eof() const
+{
+    return m_Position == m_Length;
+}
+
+bool MappedFileStreamDevice::CanSeek() const
+{
+    return true;
+}
+
+bool MappedFileStreamDevice::TryGetView(bufferview& view) const
+{
+    view = bufferview(m_buffer, m_Length);
+    return true;
+}
+
+void MappedFileStreamDevice::writeBuffer(const char* buffer, size_t size)
+{
+    (void)buffer;
+    (void)size;
+    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Mapped file device is read only");
+}
+
+size_t MappedFileStreamDevice::readBuffer(char* buffer, size_t size, bool& eof)
+{
+    size_t readCount = std::min(size, m_Length - m_Position);
+    std::memcpy(buffer, m_buffer + m_Position, readCount);
+    m_Position += readCount;
+    eof = m_Position == m_Length;
+    return readCount;
+}
+
+bool MappedFileStreamDevice::readChar(char& ch)
+{
+    if (m_Position == m_Length)
+    {
+        ch = '\0';
+        return false;
+    }
+
+    ch = m_buffer[m_Position];
+    m_Position++;
+    return true;
+}
+
+bool MappedFileStreamDevice::peek(char& ch) const
+{
+    if (m_Position == m_Length)
+    {
+        ch = '\0';
+        return false;
+    }
+
+    ch = m_buffer[m_Position];
+    return true;
+}
+
+void MappedFileStreamDevice::seek(ssize_t offset, SeekDirection direction)
+{
+    m_Position = SeekPosition(m_Position, m_Length, offset, direction);
+}
+
+void MappedFileStreamDevice::close()
+{
+    unmap();
+}
+
+void MappedFileStreamDevice::unmap()
+{
+    if (m_buffer == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_buffer);
+    CloseHandle((HANDLE)m_mapping);
+    m_mapping = nullptr;
+#else // _WIN32
+    ::munmap(const_cast<char*>(m_buffer), m_Length);
+#endif // _WIN32
+    m_buffer = nullptr;
+    m_Length = 0;
+    m_Position = 0;
+}
+
+BufferedFileStreamDevice::BufferedFileStreamDevice(const string_view& filepath, FileMode mode, size_t bufferSize) :
+    StreamDevice(DeviceAccess::Write),
+    m_Filepath(filepath),
+    m_BufferSize(bufferSize == 0 ? DefaultBufferSize : bufferSize),
+    m_bufferOffset(0),
+    m_Length(0),
+    m_Position(0)
+{
+#ifdef _WIN32
+    DWORD disposition;
+    switch (mode)
+    {
+        case FileMode::CreateNew:
+            disposition = CREATE_NEW;
+            break;
+        case FileMode::Create:
+            disposition = CREATE_ALWAYS;
+            break;
+        case FileMode::Open:
+        case FileMode::Append:
+            disposition = OPEN_EXISTING;
+            break;
+        case FileMode::OpenOrCreate:
+            disposition = OPEN_ALWAYS;
+            break;
+        case FileMode::Truncate:
+            disposition = TRUNCATE_EXISTING;
+            break;
+        default:
+            PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
+    }
+
+    auto filepath16 = utf8::utf8to16(m_Filepath);
+    HANDLE file = CreateFileW((LPCWSTR)filepath16.c_str(), GENERIC_WRITE, FILE_SHARE_READ,
+        nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to open file {}: {}", filepath, utls::GetWin32ErrorMessage(GetLastError()));
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        unsigned rc = GetLastError();
+        CloseHandle(file);
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to get size of file {}: {}", filepath, utls::GetWin32ErrorMessage(rc));
+    }
+
+    m_handle = file;
+    m_Length = (size_t)size.QuadPart;
+#else // _WIN32
+    int flags = O_WRONLY;
+    switch (mode)
+    {
+        case FileMode::CreateNew:
+            flags |= O_CREAT | O_EXCL;
+            break;
+        case FileMode::Create:
+            flags |= O_CREAT | O_TRUNC;
+            break;
+        case FileMode::Open:
+        case FileMode::Append:
+            break;
+        case FileMode::OpenOrCreate:
+            flags |= O_CREAT;
+            break;
+        case FileMode::Truncate:
+            flags |= O_TRUNC;
+            break;
+        default:
+            PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
+    }
+
+    int fd = ::open(m_Filepath.c_str(), flags, 0666);
+    if (fd == -1)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to open file {}: {}", filepath, std::strerror(errno));
+
+    struct stat st;
+    if (::fstat(fd, &st) == -1)
+    {
+        int err = errno;
+        ::close(fd);
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to get size of file {}: {}", filepath, std::strerror(err));
+    }
+
+    m_fd = fd;
+    m_Length = (size_t)st.st_size;
+    m_filePosition = 0;
+#endif // _WIN32
+
+    if (mode == FileMode::Append)
+    {
+        m_Position = m_Length;
+        m_bufferOffset = m_Length;
+#ifndef _WIN32
+        // Keep the sequential writes vectored
+        if (::lseek(m_fd, 0, SEEK_END) != -1)
+            m_filePosition = m_Length;
+#endif // _WIN32
+    }
+
+    m_buffer.reserve(m_BufferSize);
+}
+
+BufferedFileStreamDevice::~BufferedFileStreamDevice()
+{
+    try
+    {
+        flushBuffer();
+    }
+    catch (PdfError& e)
+    {
+        mm::LogMessage(PdfLogSeverity::Error, "Unable to write the buffered data to {}: {}", m_Filepath, e.what());
+    }
+
+    closeFile();
+}
+
+size_t BufferedFileStreamDevice::GetLength() const
+{
+    return m_Length;
+}
+
+size_t BufferedFileStreamDevice::GetPosition() const
+{
+    return m_Position;
+}
+
+bool BufferedFileStreamDevice::Eof() const
+{
+    return m_Position == m_Length;
+}
+
+bool BufferedFileStreamDevice::CanSeek() const
+{
+    return true;
+}
+
+void BufferedFileStreamDevice::writeBuffer(const char* buffer, size_t size)
+{
+    size_t bufferEnd = m_bufferOffset + m_buffer.size();
+    if (m_Position < m_bufferOffset || m_Position > bufferEnd)
+    {
+        // Writing outside the buffered range, e.g. after a seek
+        flushBuffer();
+        m_bufferOffset = m_Position;
+        bufferEnd = m_Position;
+    }
+
+    if (m_Position < bufferEnd)
+    {
+        // Overwrite the buffered data in place
+        size_t count = std::min(size, bufferEnd - m_Position);
+        std::memcpy(m_buffer.data() + (m_Position - m_bufferOffset), buffer, count);
+        m_Position += count;
+        buffer += count;
+        size -= count;
+        if (size == 0)
+            return;
+    }
+
+    if (m_buffer.size() + size <= m_BufferSize)
+    {
+        m_buffer.append(buffer, size);
+    }
+    else if (size >= m_BufferSize)
+    {
+        // Large payloads are not copied, they are
+        // written together with the buffered data
+        writeData(m_bufferOffset, m_buffer.data(), m_buffer.size(), buffer, size);
+        m_buffer.clear();
+        m_bufferOffset = m_Position + size;
+    }
+    else
+    {
+        flushBuffer();
+        m_buffer.append(buffer, size);
+    }
+
+    m_Position += size;
+    if (m_Position > m_Length)
+        m_Length = m_Position;
+}
+
+void BufferedFileStreamDevice::flush()
+{
+    flushBuffer();
+}
+
+size_t BufferedFileStreamDevice::readBuffer(char* buffer, size_t size, bool& eof)
+{
+    (void)buffer;
+    (void)size;
+    (void)eof;
+    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Buffered file device is write only");
+}
+
+bool BufferedFileStreamDevice::readChar(char& ch)
+{
+    (void)ch;
+    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Buffered file device is write only");
+}
+
+bool BufferedFileStreamDevice::peek(char& ch) const
+{
+    (void)ch;
+    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Buffered file device is write only");
+}
+
+void BufferedFileStreamDevice::seek(ssize_t offset, SeekDirection direction)
+{
+    // NOTE: The buffered data is flushed only if
+    // the next write is outside the buffered range
+    m_Position = SeekPosition(m_Position, m_Length, offset, direction);
+}
+
+void BufferedFileStreamDevice::close()
+{
+    flushBuffer();
+    closeFile();
+}
+
+void BufferedFileStreamDevice::flushBuffer()
+{
+    if (m_buffer.size() == 0)
+        return;
+
+    writeData(m_bufferOffset, m_buffer.data(), m_buffer.size(), nullptr, 0);
+    m_bufferOffset += m_buffer.size();
+    m_buffer.clear();
+}
+
+void BufferedFileStreamDevice::writeData(size_t offset, const char* data1, size_t size1, const char* data2, size_t size2)
+{
+#ifdef _WIN32
+    writeAt(offset, data1, size1);
+    writeAt(offset + size1, data2, size2);
+#else // _WIN32
+    if (m_fd == -1)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "The file {} is closed", m_Filepath);
+
+    if (offset != m_filePosition)
+    {
+        // Positional writes don't move the file offset
+        writeAt(offset, data1, size1);
+        writeAt(offset + size1, data2, size2);
+        return;
+    }
+
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<char*>(data1);
+    iov[0].iov_len = size1;
+    iov[1].iov_base = const_cast<char*>(data2);
+    iov[1].iov_len = size2;
+    unsigned index = size1 == 0 ? 1 : 0;
+    while (index < 2)
+    {
+        ssize_t written = ::writev(m_fd, iov + index, (int)(2 - index));
+        if (written == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to write file {}: {}", m_Filepath, std::strerror(errno));
+        }
+
+        m_filePosition += (size_t)written;
+
+        // Skip the written vectors after a partial write
+        while (index < 2 && (size_t)written >= iov[index].iov_len)
+        {
+            written -= (ssize_t)iov[index].iov_len;
+            index++;
+        }
+
+        if (index < 2)
+        {
+            iov[index].iov_base = (char*)iov[index].iov_base + written;
+            iov[index].iov_len -= (size_t)written;
+        }
+    }
+#endif // _WIN32
+}
+
+void BufferedFileStreamDevice::writeAt(size_t offset, const char* data, size_t size)
+{
+#ifdef _WIN32
+    if (m_handle == nullptr)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "The file {} is closed", m_Filepath);
+
+    while (size != 0)
+    {
+        OVERLAPPED overlapped{ };
+        overlapped.Offset = (DWORD)offset;
+        overlapped.OffsetHigh = (DWORD)((uint64_t)offset >> 32);
+        DWORD written;
+        if (!WriteFile((HANDLE)m_handle, data, (DWORD)std::min(size, (size_t)0x40000000), &written, &overlapped))
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to write file {}: {}", m_Filepath, utls::GetWin32ErrorMessage(GetLastError()));
+
+        offset += written;
+        data += written;
+        size -= written;
+    }
+#else // _WIN32
+    while (size != 0)
+    {
+        ssize_t written = ::pwrite(m_fd, data, size, (off_t)offset);
+        if (written == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to write file {}: {}", m_Filepath, std::strerror(errno));
+        }
+
+        offset += (size_t)written;
+        data += written;
+        size -= (size_t)written;
+    }
+#endif // _WIN32
+}
+
+void BufferedFileStreamDevice::closeFile()
+{
+#ifdef _WIN32
+    if (m_handle == nullptr)
+        return;
+
+    CloseHandle((HANDLE)m_handle);
+    m_handle = nullptr;
+#else // _WIN32
+    if (m_fd == -1)
+        return;
+
+    ::close(m_fd);
+    m_fd = -1;
+#endif // _WIN32
+}
+
 NullStreamDevice::NullStreamDevice()
     : StreamDevice(DeviceAccess::ReadWrite), m_Length(0), m_Position(0)
 {
@@ -510,6 +1045,399 @@ void NullStreamDevice::seek(ssize_t offset, SeekDirection direction)
     m_Position = SeekPosition(m_Position, m_Length, offset, direction);
 }
 
+HashingStreamDevice::HashingStreamDevice(OutputStreamDevice& device, const HashAppendFunction& append) :
+    m_device(&device),
+    m_append(append),
+    m_HashedLength(device.GetLength())
+{
+}
+
+size_t HashingStreamDevice::GetLength() const
+{
+    return m_device->GetLength();
+}
+
+size_t HashingStreamDevice::GetPosition() const
+{
+    return m_device->GetPosition();
+}
+
+bool HashingStreamDevice::Eof() const
+{
+    return m_device->Eof();
+}
+
+bool HashingStreamDevice::CanSeek() const
+{
+    return m_device->CanSeek();
+}
+
+void HashingStreamDevice::writeBuffer(const char* buffer, size_t size)
+{
+    size_t position = m_device->GetPosition();
+    m_device->Write(buffer, size);
+
+    // Hash only the data extending the already hashed one
+    size_t end = position + size;
+    if (position > m_HashedLength || end <= m_HashedLength)
+        return;
+
+    size_t skip = m_HashedLength - position;
+    m_append(m_HashedLength, bufferview(buffer + skip, size - skip));
+    m_HashedLength = end;
+}
+
+void HashingStreamDevice::flush()
+{
+    m_device->Flush();
+}
+
+void HashingStreamDevice::seek(ssize_t offset, SeekDirection direction)
+{
+    m_device->Seek(offset, direction);
+}
+
+AsyncStreamDevice::AsyncStreamDevice(OutputStreamDevice& device, size_t bufferSize, unsigned bufferCount) :
+    m_device(&device),
+    m_BufferSize(bufferSize),
+    m_current(0),
+    m_Length(device.GetLength()),
+    m_Position(device.GetPosition()),
+    m_first(0),
+    m_pendingCount(0),
+    m_stop(false),
+    m_errorReported(false)
+{
+    if (bufferSize == 0 || bufferCount == 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The buffer size and count must be greater than zero");
+
+    m_buffers.resize(bufferCount);
+    for (auto& buffer : m_buffers)
+        buffer.reserve(bufferSize);
+
+    m_thread = std::thread(&AsyncStreamDevice::run, this);
+}
+
+AsyncStreamDevice::~AsyncStreamDevice()
+{
+    // Log only the errors not already thrown to the caller
+    bool errorReported = m_errorReported;
+    try
+    {
+        drain();
+    }
+    catch (...)
+    {
+        if (!errorReported)
+            mm::LogMessage(PdfLogSeverity::Error, "Unable to write the buffered data");
+    }
+
+    stop();
+}
+
+size_t AsyncStreamDevice::GetLength() const
+{
+    return m_Length;
+}
+
+size_t AsyncStreamDevice::GetPosition() const
+{
+    return m_Position;
+}
+
+bool AsyncStreamDevice::Eof() const
+{
+    return m_Position == m_Length;
+}
+
+bool AsyncStreamDevice::CanSeek() const
+{
+    return m_device->CanSeek();
+}
+
+void AsyncStreamDevice::writeBuffer(const char* buffer, size_t size)
+{
+    m_Position += size;
+    if (m_Position > m_Length)
+        m_Length = m_Position;
+
+    while (size != 0)
+    {
+        auto& current = m_buffers[m_current];
+        if (current.size() == m_BufferSize)
+        {
+            submit();
+            continue;
+        }
+
+        size_t copied = std::min(size, m_BufferSize - current.size());
+        current.append(buffer, copied);
+        buffer += copied;
+        size -= copied;
+    }
+}
+
+void AsyncStreamDevice::flush()
+{
+    drain();
+    m_device->Flush();
+}
+
+void AsyncStreamDevice::seek(ssize_t offset, SeekDirection direction)
+{
+    // The I/O thread is idle after draining, so
+    // the wrapped device can be accessed directly
+    drain();
+    m_device->Seek(offset, direction);
+    m_Position = m_device->GetPosition();
+}
+
+void AsyncStreamDevice::close()
+{
+    drain();
+    stop();
+}
+
+void AsyncStreamDevice::submit()
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_pendingCount++;
+    m_condition.notify_all();
+    m_condition.wait(lock, [this]() { return m_pendingCount < m_buffers.size(); });
+
+    // The next free buffer follows the pending ones
+    m_current = (m_first + m_pendingCount) % m_buffers.size();
+    m_buffers[m_current].clear();
+    rethrowError();
+}
+
+void AsyncStreamDevice::drain()
+{
+    unique_lock<mutex> lock(m_mutex);
+    if (m_buffers[m_current].size() != 0)
+    {
+        m_pendingCount++;
+        m_condition.notify_all();
+    }
+
+    m_condition.wait(lock, [this]() { return m_pendingCount == 0; });
+    m_current = m_first;
+    m_buffers[m_current].clear();
+    rethrowError();
+}
+
+void AsyncStreamDevice::rethrowError()
+{
+    if (m_error == nullptr)
+        return;
+
+    m_errorReported = true;
+    std::rethrow_exception(m_error);
+}
+
+void AsyncStreamDevice::stop()
+{
+    if (!m_thread.joinable())
+        return;
+
+    {
+        unique_lock<mutex> lock(m_mutex);
+        m_stop = true;
+        m_condition.notify_all();
+    }
+
+    m_thread.join();
+}
+
+void AsyncStreamDevice::run()
+{
+    unique_lock<mutex> lock(m_mutex);
+    while (true)
+    {
+        m_condition.wait(lock, [this]() { return m_pendingCount != 0 || m_stop; });
+        if (m_pendingCount == 0)
+            return;
+
+        // Write the buffer without holding the lock. After
+        // a failure the remaining buffers are just discarded
+        auto& buffer = m_buffers[m_first];
+        if (m_error == nullptr)
+        {
+            lock.unlock();
+            try
+            {
+                m_device->Write(buffer.data(), buffer.size());
+            }
+            catch (...)
+            {
+                lock.lock();
+                m_error = std::current_exception();
+                lock.unlock();
+            }
+            lock.lock();
+        }
+
+        m_first = (m_first + 1) % (unsigned)m_buffers.size();
+        m_pendingCount--;
+        m_condition.notify_all();
+    }
+}
+
+RangeStreamDevice::RangeStreamDevice(size_t length, const RangeFetchFunction& fetch,
+    size_t blockSize, unsigned cacheBlockCount, unsigned readAheadBlockCount) :
+    StreamDevice(DeviceAccess::Read),
+    m_fetch(fetch),
+    m_Length(length),
+    m_Position(0),
+    m_BlockSize(blockSize),
+    m_CacheBlockCount(cacheBlockCount),
+    m_ReadAheadBlockCount(readAheadBlockCount),
+    m_currentBlock(nullptr),
+    m_FetchCount(0)
+{
+    if (m_fetch == nullptr)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The fetch function must be non null");
+
+    if (m_BlockSize == 0 || m_CacheBlockCount == 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Block size and cached block count must be positive");
+}
+
+size_t RangeStreamDevice::GetLength() const
+{
+    return m_Length;
+}
+
+size_t RangeStreamDevice::GetPosition() const
+{
+    return m_Position;
+}
+
+bool RangeStreamDevice::Eof() const
+{
+    return m_Position == m_Length;
+}
+
+bool RangeStreamDevice::CanSeek() const
+{
+    return true;
+}
+
+void RangeStreamDevice::writeBuffer(const char* buffer, size_t size)
+{
+    (void)buffer;
+    (void)size;
+    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Range device is read only");
+}
+
+size_t RangeStreamDevice::readBuffer(char* buffer, size_t size, bool& eof)
+{
+    size_t readCount = std::min(size, m_Length - m_Position);
+    size_t remaining = readCount;
+    while (remaining != 0)
+    {
+        auto& block = getBlock(m_Position / m_BlockSize);
+        size_t blockOffset = m_Position % m_BlockSize;
+        size_t count = std::min(remaining, block.Data.size() - blockOffset);
+        std::memcpy(buffer, block.Data.data() + blockOffset, count);
+        buffer += count;
+        remaining -= count;
+        m_Position += count;
+    }
+
+    eof = m_Position == m_Length;
+    return readCount;
+}
+
+bool RangeStreamDevice::readChar(char& ch)
+{
+    if (!peek(ch))
+        return false;
+
+    m_Position++;
+    return true;
+}
+
+bool RangeStreamDevice::peek(char& ch) const
+{
+    if (m_Position == m_Length)
+    {
+        ch = '\0';
+        return false;
+    }
+
+    ch = getBlock(m_Position / m_BlockSize).Data[m_Position % m_BlockSize];
+    return true;
+}
+
+void RangeStreamDevice::seek(ssize_t offset, SeekDirection direction)
+{
+    m_Position = SeekPosition(m_Position, m_Length, offset, direction);
+}
+
+const RangeStreamDevice::Block& RangeStreamDevice::getBlock(size_t index) const
+{
+    // Fast path for consecutive reads in the same block
+    if (m_currentBlock != nullptr && m_currentBlock->Index == index)
+        return *m_currentBlock;
+
+    auto found = m_blockMap.find(index);
+    if (found == m_blockMap.end())
+        return fetchBlocks(index);
+
+    // Mark the block as the most recently used
+    m_blocks.splice(m_blocks.begin(), m_blocks, found->second);
+    m_currentBlock = &*found->second;
+    return *m_currentBlock;
+}
+
+const RangeStreamDevice::Block& RangeStreamDevice::fetchBlocks(size_t index) const
+{
+    // Read ahead the following blocks that are not cached yet,
+    // without exceeding the cache size
+    size_t blockCount = (m_Length + m_BlockSize - 1) / m_BlockSize;
+    size_t fetchCount = 1;
+    while (fetchCount <= m_ReadAheadBlockCount && fetchCount < m_CacheBlockCount
+        && index + fetchCount < blockCount
+        && m_blockMap.find(index + fetchCount) == m_blockMap.end())
+    {
+        fetchCount++;
+    }
+
+    size_t offset = index * m_BlockSize;
+    size_t size = std::min(fetchCount * m_BlockSize, m_Length - offset);
+    charbuff data(size);
+    size_t read = m_fetch(offset, data.data(), size);
+    m_FetchCount++;
+    if (read != size)
+    {
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnexpectedEOF,
+            "Unable to fetch range at offset {}: read {} bytes, expected {}", offset, read, size);
+    }
+
+    // Insert the blocks in reverse order, so the
+    // requested one is the most recently used
+    for (size_t i = fetchCount; i-- > 0; )
+    {
+        if (m_blocks.size() == m_CacheBlockCount)
+        {
+            // Evict the least recently used block
+            auto& last = m_blocks.back();
+            if (m_currentBlock == &last)
+                m_currentBlock = nullptr;
+
+            m_blockMap.erase(last.Index);
+            m_blocks.pop_back();
+        }
+
+        size_t blockOffset = i * m_BlockSize;
+        m_blocks.push_front({ index + i, charbuff(data.substr(blockOffset, m_BlockSize)) });
+        m_blockMap[index + i] = m_blocks.begin();
+    }
+
+    m_currentBlock = &m_blocks.front();
+    return *m_currentBlock;
+}
+
 SpanStreamDevice::SpanStreamDevice(const char* buffer, size_t size)
     : StreamDevice(DeviceAccess::Read), m_buffer(const_cast<char*>(buffer)), m_Length(size), m_Position(0)
 {
@@ -565,6 +1493,12 @@ bool SpanStreamDevice::CanSeek() const
     return true;
 }
 
+bool SpanStreamDevice::TryGetView(bufferview& view) const
+{
+    view = bufferview(m_buffer, m_Length);
+    return true;
+}
+
 void SpanStreamDevice::writeBuffer(const char* buffer, size_t size)
 {
     if (m_Position + size > m_Length)
@@ -11,6 +11,13 @@
 
 #include <ostream>
 #include <fstream>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #include "PdfInputDevice.h"
 #include "PdfOutputDevice.h"
@@ -123,6 +130,219 @@ private:
     std::string m_Filepath;
 };
 
+/** A read only device that maps the supplied file in memory
+ *
+ * All reads are plain memory accesses in the mapped view,
+ * bypassing the std::fstream machinery used by FileStreamDevice
+ */
+class PDFMM_API MappedFileStreamDevice final : public StreamDevice
+{
+public:
+    /** Open for reading the supplied filepath and map it in memory
+     */
+    MappedFileStreamDevice(const std::string_view& filepath);
+
+    ~MappedFileStreamDevice();
+
+public:
+    size_t GetLength() const override;
+
+    size_t GetPosition() const override;
+
+    bool Eof() const override;
+
+    bool CanSeek() const override;
+
+    bool TryGetView(bufferview& view) const override;
+
+    const std::string& GetFilepath() const { return m_Filepath; }
+
+protected:
+    void writeBuffer(const char* buffer, size_t size) override;
+    size_t readBuffer(char* buffer, size_t size, bool& eof) override;
+    bool readChar(char& ch) override;
+    bool peek(char& ch) const override;
+    void seek(ssize_t offset, SeekDirection direction) override;
+    void close() override;
+
+private:
+    void unmap();
+
+private:
+    MappedFileStreamDevice(const MappedFileStreamDevice&) = delete;
+    MappedFileStreamDevice& operator=(const MappedFileStreamDevice&) = delete;
+
+private:
+    std::string m_Filepath;
+    const char* m_buffer;
+    size_t m_Length;
+    size_t m_Position;
+#ifdef _WIN32
+    void* m_mapping;
+#endif // _WIN32
+};
+
+/** A write only file device that collects the small writes in
+ *  a large buffer, so they are written to the file in few system calls
+ *
+ *  Writes larger than the buffer pass through it, together with
+ *  the pending buffered data in a single vectored write. The data
+ *  is written at explicit file offsets, so seeking back to overwrite
+ *  already written data doesn't require repositioning the file
+ */
+class PDFMM_API BufferedFileStreamDevice final : public StreamDevice
+{
+public:
+    static constexpr size_t DefaultBufferSize = 256 * 1024;
+
+public:
+    /** Open for writing the supplied filepath with the given filemode
+     *
+     *  \param bufferSize the size of the write buffer
+     */
+    BufferedFileStreamDevice(const std::string_view& filepath, FileMode mode = FileMode::Create,
+        size_t bufferSize = DefaultBufferSize);
+
+    ~BufferedFileStreamDevice();
+
+public:
+    size_t GetLength() const override;
+
+    size_t GetPosition() const override;
+
+    bool Eof() const override;
+
+    bool CanSeek() const override;
+
+    const std::string& GetFilepath() const { return m_Filepath; }
+
+    inline size_t GetBufferSize() const { return m_BufferSize; }
+
+protected:
+    void writeBuffer(const char* buffer, size_t size) override;
+    void flush() override;
+    size_t readBuffer(char* buffer, size_t size, bool& eof) override;
+    bool readChar(char& ch) override;
+    bool peek(char& ch) const override;
+    void seek(ssize_t offset, SeekDirection direction) override;
+    void close() override;
+
+private:
+    void flushBuffer();
+
+    /** Write the two buffers contiguously at the given file offset
+     */
+    void writeData(size_t offset, const char* data1, size_t size1, const char* data2, size_t size2);
+
+    void writeAt(size_t offset, const char* data, size_t size);
+
+    void closeFile();
+
+private:
+    BufferedFileStreamDevice(const BufferedFileStreamDevice&) = delete;
+    BufferedFileStreamDevice& operator=(const BufferedFileStreamDevice&) = delete;
+
+private:
+    std::string m_Filepath;
+    size_t m_BufferSize;
+    charbuff m_buffer;
+    size_t m_bufferOffset;      // File offset of the buffered data
+    size_t m_Length;
+    size_t m_Position;
+#ifdef _WIN32
+    void* m_handle;
+#else // _WIN32
+    int m_fd;
+    size_t m_filePosition;      // Offset of the file descriptor
+#endif // _WIN32
+};
+
+/** Function that reads a byte range of the remote data, e.g.
+ *  with an HTTP range request
+ *
+ *  \param offset the offset of the range to read
+ *  \param buffer the buffer to read into
+ *  \param size the size of the range to read
+ *  \returns the number of bytes read. It must be equal to size
+ */
+using RangeFetchFunction = std::function<size_t(size_t offset, char* buffer, size_t size)>;
+
+/** A read only device that fetches the data on demand in
+ *  fixed size blocks, e.g. from an object storage service
+ *
+ *  The fetched blocks are kept in a LRU cache. A miss fetches
+ *  the missing block together with the following ones in a single
+ *  range, so sequential reads don't require a fetch per block.
+ *  Combined with the parser loading on demand, only the ranges
+ *  actually touched are fetched
+ */
+class PDFMM_API RangeStreamDevice final : public StreamDevice
+{
+public:
+    /** Create a device reading from the supplied function
+     *
+     *  \param length the total length of the data
+     *  \param fetch the function used to read the data ranges
+     *  \param blockSize the size of the cached blocks
+     *  \param cacheBlockCount the maximum number of cached blocks
+     *  \param readAheadBlockCount the number of blocks fetched
+     *      after a missing one
+     */
+    RangeStreamDevice(size_t length, const RangeFetchFunction& fetch,
+        size_t blockSize = 65536, unsigned cacheBlockCount = 64,
+        unsigned readAheadBlockCount = 1);
+
+public:
+    size_t GetLength() const override;
+
+    size_t GetPosition() const override;
+
+    bool Eof() const override;
+
+    bool CanSeek() const override;
+
+    /** \returns the number of calls to the fetch function so far
+     */
+    inline unsigned GetFetchCount() const { return m_FetchCount; }
+
+protected:
+    void writeBuffer(const char* buffer, size_t size) override;
+    size_t readBuffer(char* buffer, size_t size, bool& eof) override;
+    bool readChar(char& ch) override;
+    bool peek(char& ch) const override;
+    void seek(ssize_t offset, SeekDirection direction) override;
+
+private:
+    struct Block
+    {
+        size_t Index;
+        charbuff Data;
+    };
+
+    // Most recently used blocks first
+    using BlockList = std::list<Block>;
+
+private:
+    const Block& getBlock(size_t index) const;
+    const Block& fetchBlocks(size_t index) const;
+
+private:
+    RangeStreamDevice(const RangeStreamDevice&) = delete;
+    RangeStreamDevice& operator=(const RangeStreamDevice&) = delete;
+
+private:
+    RangeFetchFunction m_fetch;
+    size_t m_Length;
+    size_t m_Position;
+    size_t m_BlockSize;
+    unsigned m_CacheBlockCount;
+    unsigned m_ReadAheadBlockCount;
+    mutable BlockList m_blocks;
+    mutable std::unordered_map<size_t, BlockList::iterator> m_blockMap;
+    mutable const Block* m_currentBlock;
+    mutable unsigned m_FetchCount;
+};
+
 template <typename TContainer>
 class ContainerStreamDevice final : public StreamDevice
 {
@@ -148,6 +368,12 @@ public:
 
     bool Eof() const override { return m_Position == m_container->size(); }
 
+    bool TryGetView(bufferview& view) const override
+    {
+        view = bufferview(m_container->data(), m_container->size());
+        return true;
+    }
+
 protected:
     void writeBuffer(const char* buffer, size_t size) override
     {
@@ -227,6 +453,8 @@ public:
 
     bool CanSeek() const override;
 
+    bool TryGetView(bufferview& view) const override;
+
 protected:
     void writeBuffer(const char* buffer, size_t size) override;
     size_t readBuffer(char* buffer, size_t size, bool& eof) override;
@@ -270,6 +498,137 @@ private:
     size_t m_Position;
 };
 
+/** Function that receives the data written to a HashingStreamDevice
+ *
+ *  \param offset the offset of the data in the device
+ *  \param data the written data
+ */
+using HashAppendFunction = std::function<void(size_t offset, const bufferview& data)>;
+
+/** A write only device that forwards the writes to another device
+ *  and feeds the written data to a digest, so computing the digest
+ *  doesn't require reading the output back
+ *
+ *  Only the data written past the end of the data already hashed
+ *  is passed to the append function, so overwriting previous data
+ *  after seeking back is not hashed again. The data already in the
+ *  wrapped device when the wrapper is created is considered hashed
+ */
+class PDFMM_API HashingStreamDevice final : public OutputStreamDevice
+{
+public:
+    HashingStreamDevice(OutputStreamDevice& device, const HashAppendFunction& append);
+
+public:
+    size_t GetLength() const override;
+
+    size_t GetPosition() const override;
+
+    bool Eof() const override;
+
+    bool CanSeek() const override;
+
+    /** \returns the length of the data fed to the append function,
+     *  including the data already in the wrapped device
+     */
+    inline size_t GetHashedLength() const { return m_HashedLength; }
+
+protected:
+    void writeBuffer(const char* buffer, size_t size) override;
+    void flush() override;
+    void seek(ssize_t offset, SeekDirection direction) override;
+
+private:
+    HashingStreamDevice(const HashingStreamDevice&) = delete;
+    HashingStreamDevice& operator=(const HashingStreamDevice&) = delete;
+
+private:
+    OutputStreamDevice* m_device;
+    HashAppendFunction m_append;
+    size_t m_HashedLength;
+};
+
+/** A write only device that forwards the writes to another
+ *  device from a dedicated I/O thread
+ *
+ *  The data is collected in a ring of buffers: a full buffer is
+ *  handed to the I/O thread and the writing continues in the next
+ *  one, waiting only when all the buffers are still pending. Seeking
+ *  and flushing wait for the pending buffers to be written. Errors
+ *  of the wrapped device are rethrown by the following operation
+ */
+class PDFMM_API AsyncStreamDevice final : public OutputStreamDevice
+{
+public:
+    static constexpr size_t DefaultBufferSize = 256 * 1024;
+    static constexpr unsigned DefaultBufferCount = 4;
+
+public:
+    /** Create a device writing to the supplied one
+     *
+     *  \param bufferSize the size of each buffer
+     *  \param bufferCount the number of buffers in the ring
+     */
+    AsyncStreamDevice(OutputStreamDevice& device, size_t bufferSize = DefaultBufferSize,
+        unsigned bufferCount = DefaultBufferCount);
+
+    ~AsyncStreamDevice();
+
+public:
+    size_t GetLength() const override;
+
+    size_t GetPosition() const override;
+
+    bool Eof() const override;
+
+    bool CanSeek() const override;
+
+protected:
+    void writeBuffer(const char* buffer, size_t size) override;
+    void flush() override;
+    void seek(ssize_t offset, SeekDirection direction) override;
+    void close() override;
+
+private:
+    /** Hand the current buffer to the I/O thread and
+     *  wait for a free one
+     */
+    void submit();
+
+    /** Hand the current buffer to the I/O thread and
+     *  wait for all the pending buffers to be written
+     */
+    void drain();
+
+    void rethrowError();
+
+    void stop();
+
+    void run();
+
+private:
+    AsyncStreamDevice(const AsyncStreamDevice&) = delete;
+    AsyncStreamDevice& operator=(const AsyncStreamDevice&) = delete;
+
+private:
+    OutputStreamDevice* m_device;
+    size_t m_BufferSize;
+    std::vector<charbuff> m_buffers;
+    unsigned m_current;
+    size_t m_Length;
+    size_t m_Position;
+
+    // State shared with the I/O thread
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    unsigned m_first;
+    unsigned m_pendingCount;
+    bool m_stop;
+    std::exception_ptr m_error;
+    bool m_errorReported;
+    std::thread m_thread;
+};
+
 using VectorStreamDevice = ContainerStreamDevice<std::vector<char>>;
 using StringStreamDevice = ContainerStreamDevice<std::string>;
 using BufferStreamDevice = ContainerStreamDevice<charbuff>;
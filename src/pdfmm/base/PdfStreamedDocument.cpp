@@ -41,6 +41,11 @@ void PdfStreamedDocument::Close()
     this->GetObjects().Finish();
 }
 
+void PdfStreamedDocument::SetMaxStreamsInFlight(unsigned count)
+{
+    m_Writer->SetMaxStreamsInFlight(count);
+}
+
 PdfVersion PdfStreamedDocument::GetPdfVersion() const
 {
     return m_Writer->GetPdfVersion();
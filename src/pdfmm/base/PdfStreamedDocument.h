@@ -23,6 +23,13 @@ namespace mm {
  *  This results in faster document generation and
  *  less memory being used.
  *
+ *  Other objects are kept in memory until the document
+ *  is closed, unless they are queued as finished with
+ *  PdfIndirectObjectList::QueueObject(): queued objects are
+ *  written in batches and then removed from memory, so they
+ *  must not be accessed anymore. With PdfSaveOptions::CompressObjects
+ *  the queued objects without streams are packed in object streams.
+ *
  *  Please use PdfMemDocument if you intend to work
  *  on the object structure of a PDF file.
  *
@@ -89,6 +96,13 @@ public:
      */
     void Close();
 
+    /** Set the maximum count of streams compressed in the background,
+     *  on the executor of the document, or 0 to compress them while
+     *  they are written. It applies to the streams created afterwards
+     *  \see PdfImmediateWriter::SetMaxStreamsInFlight
+     */
+    void SetMaxStreamsInFlight(unsigned count);
+
 public:
     const PdfEncrypt* GetEncrypt() const override;
 
@@ -11,6 +11,7 @@
 
 #include <utfcpp/utf8.h>
 
+#include <pdfmm/private/PdfAsciiCodecPrivate.h>
 #include <pdfmm/private/PdfEncodingPrivate.h>
 
 #include "PdfEncrypt.h"
@@ -35,12 +36,12 @@ static char getEscapedCharacter(char ch);
 static StringEncoding getEncoding(const string_view& view);
 
 PdfString::PdfString()
-    : m_data(new StringData{ PdfStringState::Ascii, { } }), m_isHex(false)
+    : m_data(std::make_shared<StringData>(StringData{ PdfStringState::Ascii, { }, { } })), m_isHex(false)
 {
 }
 
 PdfString::PdfString(charbuff&& buff, bool isHex)
-    : m_data(new StringData{ PdfStringState::RawBuffer, std::move(buff) }), m_isHex(isHex)
+    : m_data(std::make_shared<StringData>(StringData{ PdfStringState::RawBuffer, std::move(buff), { } })), m_isHex(isHex)
 {
 }
 
@@ -119,14 +120,14 @@ void PdfString::Write(OutputStreamDevice& device, PdfWriteFlags writeMode,
     const PdfStatefulEncrypt& encrypt, charbuff& buffer) const
 {
     (void)writeMode;
-    (void)buffer; // TODO: Just use the supplied buffer istead of the many ones below
+    ensureDecrypted();
 
     // Strings in PDF documents may contain \0 especially if they are encrypted
     // this case has to be handled!
 
     // We are not encrypting the empty strings (was access violation)!
     string_view dataview;
-    u16string string16;
+    string string16;
     string pdfDocEncoded;
     switch (m_data->State)
     {
@@ -145,69 +146,67 @@ void PdfString::Write(OutputStreamDevice& device, PdfWriteFlags writeMode,
         case PdfStringState::Unicode:
         {
             // Prepend utf-16 BE BOM
-            string16.push_back((char16_t)(0xFEFF));
-            utf8::utf8to16(m_data->Chars.data(), m_data->Chars.data() + m_data->Chars.size(), std::back_inserter(string16));
-#ifdef PDFMM_IS_LITTLE_ENDIAN
-            // Ensure the output will be BE
-            utls::ByteSwap(string16);
-#endif
-            dataview = string_view((const char*)string16.data(), string16.size() * sizeof(char16_t));
+            string16.push_back((char)0xFE);
+            string16.push_back((char)0xFF);
+            mm::ConvertUTF8ToUTF16BE(m_data->Chars, string16);
+            dataview = string_view(string16);
             break;
         }
         default:
             PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
     }
 
-    charbuff tempBuffer;
-    if (encrypt.HasEncrypt() && dataview.size() > 0)
+    bool encrypted = encrypt.HasEncrypt() && dataview.size() > 0;
+    if (m_isHex)
     {
-        charbuff encrypted;
-        encrypt.EncryptTo(encrypted, dataview);
-        encrypted.swap(tempBuffer);
-        dataview = string_view(tempBuffer.data(), tempBuffer.size());
+        // Serialize the string in the supplied buffer, so it's written
+        // to the device at once. The encrypted data is written in the
+        // second half of the digits, and it's encoded there in place
+        size_t length = encrypted ? encrypt.CalculateStreamLength(dataview.size()) : dataview.size();
+        buffer.resize(length * 2 + 2);
+        buffer[0] = '<';
+        char* digits = buffer.data() + 1;
+        if (encrypted)
+        {
+            encrypt.EncryptTo(digits + length, dataview);
+            mm::EncodeHexDigits(digits, digits + length, length);
+        }
+        else
+        {
+            mm::EncodeHexDigits(digits, dataview.data(), length);
+        }
+
+        buffer[length * 2 + 1] = '>';
+        device.Write(buffer);
+        return;
     }
 
-    device.Write(m_isHex ? '<' : '(');
-    if (dataview.size() > 0)
+    charbuff encryptedData;
+    if (encrypted)
     {
-        char ch;
-        const char* buffer = dataview.data();
-        size_t len = dataview.size();
+        encrypt.EncryptTo(encryptedData, dataview);
+        dataview = string_view(encryptedData.data(), encryptedData.size());
+    }
 
-        if (m_isHex)
+    buffer.clear();
+    buffer.reserve(dataview.size() + 2);
+    buffer.push_back('(');
+    for (char ch : dataview)
+    {
+        char escaped = getEscapedCharacter(ch);
+        if (escaped == '\0')
         {
-            char data[2];
-            while (len-- != 0)
-            {
-                ch = *buffer;
-                utls::WriteCharHexTo(data, ch);
-                device.Write(string_view(data, 2));
-                buffer++;
-            }
+            buffer.push_back(ch);
         }
         else
         {
-            char ch;
-            while (len-- != 0)
-            {
-                ch = *buffer;
-                char escaped = getEscapedCharacter(ch);
-                if (escaped == '\0')
-                {
-                    device.Write(ch);
-                }
-                else
-                {
-                    device.Write('\\');
-                    device.Write(escaped);
-                }
-
-                buffer++;
-            }
+            buffer.push_back('\\');
+            buffer.push_back(escaped);
         }
     }
 
-    device.Write(m_isHex ? '>' : ')');
+    buffer.push_back(')');
+    device.Write(buffer);
 }
 
 PdfStringState PdfString::GetState() const
@@ -223,11 +222,15 @@ const string& PdfString::GetString() const
 
 bool PdfString::IsEmpty() const
 {
+    ensureDecrypted();
     return m_data->Chars.empty();
 }
 
 const PdfString& PdfString::operator=(const PdfString& rhs)
 {
+    // NOTE: Copies don't share the decryption, as they
+    // may outlive the encryption of the document
+    rhs.ensureDecrypted();
     this->m_data = rhs.m_data;
     this->m_isHex = rhs.m_isHex;
     return *this;
@@ -244,6 +247,8 @@ bool PdfString::operator==(const PdfString& rhs) const
     if (this->m_data == rhs.m_data)
         return true;
 
+    this->ensureDecrypted();
+    rhs.ensureDecrypted();
     return this->m_data->Chars == rhs.m_data->Chars;
 }
 
@@ -276,6 +281,8 @@ bool PdfString::operator!=(const PdfString& rhs) const
     if (this->m_data == rhs.m_data)
         return false;
 
+    this->ensureDecrypted();
+    rhs.ensureDecrypted();
     return this->m_data->Chars != rhs.m_data->Chars;
 }
 
@@ -310,19 +317,37 @@ void PdfString::initFromUtf8String(const string_view& view)
 
     if (view.length() == 0)
     {
-        m_data.reset(new StringData{ PdfStringState::Ascii, { } });
+        m_data = std::make_shared<StringData>(StringData{ PdfStringState::Ascii, { }, { } });
         return;
     }
 
     bool isAsciiEqual;
     if (mm::CheckValidUTF8ToPdfDocEcondingChars(view, isAsciiEqual))
-        m_data.reset(new StringData{ isAsciiEqual ? PdfStringState::Ascii : PdfStringState::PdfDocEncoding, charbuff(view) });
+        m_data = std::make_shared<StringData>(StringData{ isAsciiEqual ? PdfStringState::Ascii : PdfStringState::PdfDocEncoding, charbuff(view), { } });
     else
-        m_data.reset(new StringData{ PdfStringState::Unicode, charbuff(view) });
+        m_data = std::make_shared<StringData>(StringData{ PdfStringState::Unicode, charbuff(view), { } });
+}
+
+void PdfString::deferDecryption(const PdfStatefulEncrypt& encrypt)
+{
+    if (m_data->Chars.size() != 0)
+        m_data->Encrypt = encrypt;
+}
+
+void PdfString::ensureDecrypted() const
+{
+    if (!m_data->Encrypt.HasEncrypt())
+        return;
+
+    charbuff decrypted;
+    m_data->Encrypt.DecryptTo(decrypted, m_data->Chars);
+    m_data->Chars.swap(decrypted);
+    m_data->Encrypt = { };
 }
 
 void PdfString::evaluateString() const
 {
+    ensureDecrypted();
     switch (m_data->State)
     {
         case PdfStringState::Ascii:
@@ -381,6 +406,11 @@ void PdfString::evaluateString() const
 }
 
 // Returns true only if same state or it's valid text string
+size_t PdfString::getMemoryUsage() const
+{
+    return sizeof(StringData) + utls::GetHeapSize(m_data->Chars);
+}
+
 bool PdfString::canPerformComparison(const PdfString& lhs, const PdfString& rhs)
 {
     if (lhs.m_data->State == rhs.m_data->State)
@@ -397,6 +427,7 @@ const string& PdfString::GetRawData() const
     if (m_data->State != PdfStringState::RawBuffer)
         throw runtime_error("The string buffer has been evaluated");
 
+    ensureDecrypted();
     return m_data->Chars;
 }
 
@@ -26,6 +26,9 @@ namespace mm {
  */
 class PDFMM_API PdfString final : public PdfDataProvider
 {
+    friend class PdfObject;
+    friend class PdfTokenizer;
+
 public:
     /** Create an empty string
      */
@@ -142,15 +145,28 @@ private:
      *
      */
     void initFromUtf8String(const std::string_view& view);
+
+    /** Keep the raw buffer of the string encrypted until the contents
+     *  are accessed the first time, or the string is copied. The
+     *  encryption must outlive the string
+     */
+    void deferDecryption(const PdfStatefulEncrypt& encrypt);
+    void ensureDecrypted() const;
     void evaluateString() const;
     bool isValidText() const;
     static bool canPerformComparison(const PdfString& lhs, const PdfString& rhs);
 
+    /** \returns the memory of the shared data of the string
+     */
+    size_t getMemoryUsage() const;
+
 private:
     struct StringData
     {
         PdfStringState State;
         charbuff Chars;
+        // Set when Chars are still encrypted
+        PdfStatefulEncrypt Encrypt;
     };
 
 private:
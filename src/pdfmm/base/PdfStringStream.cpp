@@ -8,66 +8,129 @@
 #include <pdfmm/private/PdfDeclarationsPrivate.h>
 #include "PdfStringStream.h"
 
-#include <pdfmm/private/outstringstream.h>
+#include <pdfmm/private/charconv_compat.h>
 
 using namespace std;
-using namespace cmn;
 using namespace mm;
 
-PdfStringStream::PdfStringStream()
-    : m_stream(new outstringstream())
+namespace
 {
-    m_stream->imbue(utls::GetInvariantLocale());
+    // Stream buffer with no put area, appending directly
+    // to the buffer of the PdfStringStream
+    class StringAppendBuffer final : public streambuf
+    {
+    public:
+        StringAppendBuffer(string& str)
+            : m_str(&str) { }
+
+    protected:
+        int_type overflow(int_type ch) override
+        {
+            if (traits_type::eq_int_type(ch, traits_type::eof()))
+                return traits_type::not_eof(ch);
+
+            m_str->push_back(traits_type::to_char_type(ch));
+            return ch;
+        }
+
+        streamsize xsputn(const char_type* s, streamsize count) override
+        {
+            m_str->append(s, (size_t)count);
+            return count;
+        }
+
+    private:
+        string* m_str;
+    };
 }
 
+PdfStringStream::PdfStringStream()
+    : m_precision(6) { }
+
+PdfStringStream::~PdfStringStream() { }
+
 PdfStringStream& PdfStringStream::operator<<(float val)
 {
-    utls::FormatTo(m_temp, val, (unsigned short)m_stream->precision());
-    (*m_stream) << m_temp;
+    utls::FormatTo(m_temp, val, m_precision);
+    m_buffer.append(m_temp);
     return *this;
 }
 
 PdfStringStream& PdfStringStream::operator<<(double val)
 {
-    utls::FormatTo(m_temp, val, (unsigned char)m_stream->precision());
-    (*m_stream) << m_temp;
+    utls::FormatTo(m_temp, val, m_precision);
+    m_buffer.append(m_temp);
     return *this;
 }
 
 PdfStringStream& PdfStringStream::operator<<(
     std::ostream& (*pfn)(std::ostream&))
 {
-    pfn(*m_stream);
+    // The buffer has nothing to flush, so std::endl is just a new line
+    if (pfn == static_cast<std::ostream& (*)(std::ostream&)>(std::endl))
+        m_buffer.push_back('\n');
+    else
+        pfn(getStream());
+
     return *this;
 }
 
 string_view PdfStringStream::GetString() const
 {
-    return static_cast<const outstringstream&>(*m_stream).str();
+    return m_buffer;
 }
 
 string PdfStringStream::TakeString()
 {
-    return static_cast<outstringstream&>(*m_stream).take_str();
+    string ret = std::move(m_buffer);
+    m_buffer.clear();
+    return ret;
 }
 
 void PdfStringStream::Clear()
 {
-    static_cast<outstringstream&>(*m_stream).clear();
+    m_buffer.clear();
     m_temp.clear();
 }
 
 void PdfStringStream::SetPrecision(unsigned short value)
 {
-    (void)m_stream->precision(value);
+    m_precision = value;
+    if (m_stream != nullptr)
+        (void)m_stream->precision(value);
 }
 
 unsigned short PdfStringStream::GetPrecision() const
 {
-    return (unsigned short)m_stream->precision();
+    return m_precision;
 }
 
 unsigned PdfStringStream::GetSize() const
 {
-    return (unsigned)static_cast<const outstringstream&>(*m_stream).size();
+    return (unsigned)m_buffer.size();
+}
+
+void PdfStringStream::appendNumber(int64_t value)
+{
+    utls::AppendNumberTo(m_buffer, value);
+}
+
+void PdfStringStream::appendNumber(uint64_t value)
+{
+    char buffer[20];
+    auto result = std::to_chars(buffer, buffer + std::size(buffer), value);
+    m_buffer.append(buffer, result.ptr - buffer);
+}
+
+ostream& PdfStringStream::getStream()
+{
+    if (m_stream == nullptr)
+    {
+        m_streamBuffer.reset(new StringAppendBuffer(m_buffer));
+        m_stream.reset(new ostream(m_streamBuffer.get()));
+        m_stream->imbue(utls::GetInvariantLocale());
+        (void)m_stream->precision(m_precision);
+    }
+
+    return *m_stream;
 }
@@ -10,19 +10,40 @@
 
 #include "PdfDeclarations.h"
 
+#include <type_traits>
+
 namespace mm
 {
     /** A specialized Pdf output string stream
+     *
+     * Strings, characters and numbers are appended directly to
+     * the buffer, without going through std::ostream formatting.
+     * Other types are written with a std::ostream over the same
+     * buffer, using the invariant locale
      */
     class PDFMM_API PdfStringStream
     {
     public:
         PdfStringStream();
 
+        ~PdfStringStream();
+
         template <typename T>
         inline PdfStringStream& operator<<(T const& val)
         {
-            (*m_stream) << val;
+            if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>)
+                m_buffer.push_back((char)val);
+            else if constexpr (std::is_same_v<T, bool>)
+                m_buffer.push_back(val ? '1' : '0');
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+                appendNumber((int64_t)val);
+            else if constexpr (std::is_integral_v<T>)
+                appendNumber((uint64_t)val);
+            else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+                m_buffer.append(std::string_view(val));
+            else
+                getStream() << val;
+
             return *this;
         }
 
@@ -46,10 +67,21 @@ namespace mm
 
         unsigned GetSize() const;
 
-        explicit operator std::ostream& () { return *m_stream; }
+        explicit operator std::ostream& () { return getStream(); }
+
+    private:
+        PdfStringStream(const PdfStringStream&) = delete;
+        PdfStringStream& operator=(const PdfStringStream&) = delete;
+
+        void appendNumber(int64_t value);
+        void appendNumber(uint64_t value);
+        std::ostream& getStream();
 
     private:
+        std::string m_buffer;
         std::string m_temp;
+        unsigned short m_precision;
+        std::unique_ptr<std::streambuf> m_streamBuffer;
         std::unique_ptr<std::ostream> m_stream;
     };
 }
@@ -0,0 +1,234 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfTextIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <regex>
+
+#include "PdfDocument.h"
+#include "PdfContentsReader.h"
+#include "PdfStreamDevice.h"
+
+using namespace std;
+using namespace mm;
+
+// "PDFMMTIX" followed by the format version
+static constexpr char IndexMagic[] = { 'P', 'D', 'F', 'M', 'M', 'T', 'I', 'X' };
+static constexpr uint32_t IndexVersion = 1;
+
+static void writeDouble(OutputStream& stream, double value);
+static double readDouble(InputStream& stream);
+
+PdfTextIndex::PdfTextIndex()
+    : m_PageCount(0), m_OccurrenceCount(0) { }
+
+void PdfTextIndex::Build(const PdfDocument& doc)
+{
+    Clear();
+
+    PdfTextExtractParams params;
+    params.Flags = PdfTextExtractFlags::TokenizeWords;
+    params.ContentsCache = std::make_shared<PdfContentsCache>();
+    params.DecodeCache = std::make_shared<PdfTextDecodeCache>();
+
+    auto& pages = doc.GetPages();
+    m_PageCount = pages.GetCount();
+    for (unsigned i = 0; i < m_PageCount; i++)
+    {
+        pages.GetPage(i).ExtractTextTo([&](const PdfTextEntryView& entry)
+        {
+            addWord(entry.Text, { m_OccurrenceCount, i, PdfRect(entry.X, entry.Y, entry.Length, entry.FontSize) });
+        }, params);
+    }
+}
+
+vector<PdfTextIndexMatch> PdfTextIndex::Find(const string_view& word, bool ignoreCase) const
+{
+    vector<pair<unsigned, PdfTextIndexMatch>> matches;
+    if (ignoreCase)
+    {
+        auto found = m_foldedWords.find(utls::ToLower(word));
+        if (found != m_foldedWords.end())
+        {
+            for (auto spelling : found->second)
+                appendMatches(matches, *m_words.find(*spelling));
+        }
+    }
+    else
+    {
+        auto found = m_words.find((string)word);
+        if (found != m_words.end())
+            appendMatches(matches, *found);
+    }
+
+    return sortMatches(matches);
+}
+
+vector<PdfTextIndexMatch> PdfTextIndex::Search(const string_view& pattern, PdfTextExtractFlags flags) const
+{
+    auto regexFlags = regex_constants::ECMAScript;
+    if ((flags & PdfTextExtractFlags::IgnoreCase) != PdfTextExtractFlags::None)
+        regexFlags |= regex_constants::icase;
+
+    // Match every distinct word once, instead of every occurrence
+    regex pieces_regex((string)pattern, regexFlags);
+    vector<pair<unsigned, PdfTextIndexMatch>> matches;
+    for (auto& pair : m_words)
+    {
+        if (std::regex_search(pair.first, pieces_regex))
+            appendMatches(matches, pair);
+    }
+
+    return sortMatches(matches);
+}
+
+void PdfTextIndex::Save(const string_view& filename) const
+{
+    BufferedFileStreamDevice device(filename, FileMode::Create);
+    Save(device);
+    device.Close();
+}
+
+void PdfTextIndex::Save(OutputStream& stream) const
+{
+    stream.Write(IndexMagic, std::size(IndexMagic));
+    utls::WriteUInt32BE(stream, IndexVersion);
+    utls::WriteUInt32BE(stream, m_PageCount);
+    utls::WriteUInt32BE(stream, (uint32_t)m_words.size());
+    for (auto& pair : m_words)
+    {
+        utls::WriteUInt32BE(stream, (uint32_t)pair.first.size());
+        stream.Write(pair.first);
+        utls::WriteUInt32BE(stream, (uint32_t)pair.second.size());
+        for (auto& occurrence : pair.second)
+        {
+            utls::WriteUInt32BE(stream, occurrence.Position);
+            utls::WriteUInt32BE(stream, occurrence.Page);
+            writeDouble(stream, occurrence.Rect.GetLeft());
+            writeDouble(stream, occurrence.Rect.GetBottom());
+            writeDouble(stream, occurrence.Rect.GetWidth());
+            writeDouble(stream, occurrence.Rect.GetHeight());
+        }
+    }
+}
+
+void PdfTextIndex::Load(const string_view& filename)
+{
+    FileStreamDevice device(filename);
+    Load(device);
+}
+
+void PdfTextIndex::Load(InputStream& stream)
+{
+    Clear();
+
+    char magic[std::size(IndexMagic)];
+    stream.Read(magic, std::size(magic));
+    uint32_t version;
+    utls::ReadUInt32BE(stream, version);
+    if (std::memcmp(magic, IndexMagic, std::size(IndexMagic)) != 0 || version != IndexVersion)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid text index");
+
+    uint32_t pageCount;
+    uint32_t wordCount;
+    utls::ReadUInt32BE(stream, pageCount);
+    utls::ReadUInt32BE(stream, wordCount);
+    string word;
+    for (uint32_t i = 0; i < wordCount; i++)
+    {
+        uint32_t length;
+        utls::ReadUInt32BE(stream, length);
+        word.resize(length);
+        stream.Read(word.data(), length);
+
+        uint32_t count;
+        utls::ReadUInt32BE(stream, count);
+        for (uint32_t j = 0; j < count; j++)
+        {
+            uint32_t position;
+            uint32_t page;
+            utls::ReadUInt32BE(stream, position);
+            utls::ReadUInt32BE(stream, page);
+            if (page >= pageCount)
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Invalid page index in text index");
+
+            double left = readDouble(stream);
+            double bottom = readDouble(stream);
+            double width = readDouble(stream);
+            double height = readDouble(stream);
+            addWord(word, { position, page, PdfRect(left, bottom, width, height) });
+        }
+    }
+
+    m_PageCount = pageCount;
+}
+
+void PdfTextIndex::Clear()
+{
+    m_words.clear();
+    m_foldedWords.clear();
+    m_PageCount = 0;
+    m_OccurrenceCount = 0;
+}
+
+void PdfTextIndex::addWord(const string_view& word, const Occurrence& occurrence)
+{
+    auto inserted = m_words.try_emplace((string)word);
+    if (inserted.second)
+        m_foldedWords[utls::ToLower(word)].push_back(&inserted.first->first);
+
+    inserted.first->second.push_back(occurrence);
+    m_OccurrenceCount++;
+}
+
+void PdfTextIndex::appendMatches(vector<pair<unsigned, PdfTextIndexMatch>>& matches,
+    const WordMap::value_type& pair)
+{
+    for (auto& occurrence : pair.second)
+        matches.push_back({ occurrence.Position, { pair.first, occurrence.Page, occurrence.Rect } });
+}
+
+vector<PdfTextIndexMatch> PdfTextIndex::sortMatches(vector<pair<unsigned, PdfTextIndexMatch>>& matches)
+{
+    // Sort the matches by their position in the document, that is the
+    // reading order of the extraction, regardless the matched word
+    std::sort(matches.begin(), matches.end(),
+        [](const pair<unsigned, PdfTextIndexMatch>& lhs, const pair<unsigned, PdfTextIndexMatch>& rhs)
+        {
+            return lhs.first < rhs.first;
+        });
+
+    vector<PdfTextIndexMatch> ret;
+    ret.reserve(matches.size());
+    for (auto& match : matches)
+        ret.push_back(std::move(match.second));
+
+    return ret;
+}
+
+void writeDouble(OutputStream& stream, double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    utls::WriteUInt32BE(stream, (uint32_t)(bits >> 32));
+    utls::WriteUInt32BE(stream, (uint32_t)bits);
+}
+
+double readDouble(InputStream& stream)
+{
+    uint32_t high;
+    uint32_t low;
+    utls::ReadUInt32BE(stream, high);
+    utls::ReadUInt32BE(stream, low);
+    uint64_t bits = (uint64_t)high << 32 | low;
+    double ret;
+    std::memcpy(&ret, &bits, sizeof(ret));
+    return ret;
+}
@@ -0,0 +1,112 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_TEXT_INDEX_H
+#define PDF_TEXT_INDEX_H
+
+#include "PdfDeclarations.h"
+#include "PdfRect.h"
+
+#include <unordered_map>
+
+namespace mm {
+
+class PdfDocument;
+class InputStream;
+class OutputStream;
+
+/** An occurrence of a word in the document
+ */
+struct PdfTextIndexMatch final
+{
+    std::string Word;
+    unsigned Page;
+    PdfRect Rect;   ///< Lies on the baseline, with the width of the word and the height of the font size
+};
+
+/**
+ * A positional inverted index of the words of a document, built
+ * once from the text extraction, so that later searches are index
+ * lookups instead of a full extraction of the pages.
+ *
+ * The index can be saved next to the PDF and loaded back
+ */
+class PDFMM_API PdfTextIndex final
+{
+public:
+    PdfTextIndex();
+
+    /** Build the index of the words of all the pages of the document,
+     *  replacing the current content. The XObject forms shared by the
+     *  pages are tokenized once
+     */
+    void Build(const PdfDocument& doc);
+
+    /** Find the occurrences of a word
+     *
+     *  \param ignoreCase match the word ignoring the case of ASCII letters
+     *  \returns the occurrences, in reading order
+     */
+    std::vector<PdfTextIndexMatch> Find(const std::string_view& word, bool ignoreCase = false) const;
+
+    /** Find the occurrences of the words matching a regular expression,
+     *  the same as with PdfPage::ExtractTextTo() and the flag
+     *  PdfTextExtractFlags::TokenizeWords
+     *
+     *  \param flags only PdfTextExtractFlags::IgnoreCase is considered
+     *  \returns the occurrences, in reading order
+     */
+    std::vector<PdfTextIndexMatch> Search(const std::string_view& pattern,
+        PdfTextExtractFlags flags = PdfTextExtractFlags::None) const;
+
+    void Save(const std::string_view& filename) const;
+
+    void Save(OutputStream& stream) const;
+
+    void Load(const std::string_view& filename);
+
+    void Load(InputStream& stream);
+
+    void Clear();
+
+public:
+    /** \returns the count of the distinct words
+     */
+    inline unsigned GetWordCount() const { return (unsigned)m_words.size(); }
+
+    /** \returns the count of the pages of the indexed document
+     */
+    inline unsigned GetPageCount() const { return m_PageCount; }
+
+private:
+    struct Occurrence
+    {
+        unsigned Position;  // Position of the word in the document
+        unsigned Page;
+        PdfRect Rect;
+    };
+
+    using WordMap = std::unordered_map<std::string, std::vector<Occurrence>>;
+
+    void addWord(const std::string_view& word, const Occurrence& occurrence);
+
+    static void appendMatches(std::vector<std::pair<unsigned, PdfTextIndexMatch>>& matches,
+        const WordMap::value_type& pair);
+
+    static std::vector<PdfTextIndexMatch> sortMatches(std::vector<std::pair<unsigned, PdfTextIndexMatch>>& matches);
+
+private:
+    WordMap m_words;
+    // Lower case word -> the words with that spelling
+    std::unordered_map<std::string, std::vector<const std::string*>> m_foldedWords;
+    unsigned m_PageCount;
+    unsigned m_OccurrenceCount;
+};
+
+};
+
+#endif // PDF_TEXT_INDEX_H
@@ -0,0 +1,218 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfTextSpatialIndex.h"
+
+#include <algorithm>
+
+#include "PdfFont.h"
+#include "PdfTextState.h"
+
+using namespace std;
+using namespace mm;
+
+// Maximum count of the children of a node
+static constexpr unsigned NodeCapacity = 16;
+
+PdfTextSpatialIndex::PdfTextSpatialIndex() { }
+
+void PdfTextSpatialIndex::Build(const PdfPage& page, const PdfTextExtractParams& params)
+{
+    Clear();
+    page.ExtractTextTo([&](const PdfTextEntryView& entry)
+    {
+        double ascent = entry.FontSize;
+        double descent = 0;
+        if (entry.Font != nullptr)
+        {
+            PdfTextState state;
+            state.Font = entry.Font;
+            state.FontSize = entry.FontSize;
+            ascent = entry.Font->GetAscent(state);
+            descent = entry.Font->GetDescent(state);
+        }
+
+        // Make sure the rect includes the start of the entry
+        Box rect;
+        rect.Left = std::min(entry.RawX, entry.RawX + entry.Length);
+        rect.Right = std::max(entry.RawX, entry.RawX + entry.Length);
+        rect.Bottom = std::min(entry.RawY, entry.RawY + descent);
+        rect.Top = std::max(entry.RawY, entry.RawY + ascent);
+        m_entries.push_back({ { (string)entry.Text, entry.Page, entry.X, entry.Y, entry.RawX, entry.RawY }, rect });
+    }, params);
+
+    buildTree();
+}
+
+vector<PdfTextEntry> PdfTextSpatialIndex::Find(const PdfRect& rect) const
+{
+    return find(rect, false);
+}
+
+vector<PdfTextEntry> PdfTextSpatialIndex::FindIntersecting(const PdfRect& rect) const
+{
+    return find(rect, true);
+}
+
+void PdfTextSpatialIndex::Clear()
+{
+    m_entries.clear();
+    m_items.clear();
+    m_nodes.clear();
+}
+
+vector<PdfTextEntry> PdfTextSpatialIndex::find(const PdfRect& rect, bool intersecting) const
+{
+    vector<PdfTextEntry> ret;
+    if (m_nodes.size() == 0)
+        return ret;
+
+    Box query = { rect.GetLeft(), rect.GetBottom(), rect.GetRight(), rect.GetTop() };
+    auto intersects = [&query](const Box& box)
+    {
+        return box.Left <= query.Right && box.Right >= query.Left
+            && box.Bottom <= query.Top && box.Top >= query.Bottom;
+    };
+
+    vector<unsigned> indices;
+    vector<unsigned> nodes;
+    // The root is the last node
+    nodes.push_back((unsigned)m_nodes.size() - 1);
+    while (nodes.size() != 0)
+    {
+        auto& node = m_nodes[nodes.back()];
+        nodes.pop_back();
+        if (!intersects(node.Rect))
+            continue;
+
+        if (!node.IsLeaf)
+        {
+            for (unsigned i = 0; i < node.Count; i++)
+                nodes.push_back(node.First + i);
+
+            continue;
+        }
+
+        for (unsigned i = 0; i < node.Count; i++)
+        {
+            auto& item = m_items[node.First + i];
+            if (intersecting)
+            {
+                if (intersects(item.Rect))
+                    indices.push_back(item.Index);
+            }
+            else
+            {
+                // Same check of PdfTextExtractParams::ClipRect
+                auto& entry = m_entries[item.Index].TextEntry;
+                if (rect.Contains(entry.RawX, entry.RawY))
+                    indices.push_back(item.Index);
+            }
+        }
+    }
+
+    // Restore the order of the extraction
+    std::sort(indices.begin(), indices.end());
+    ret.reserve(indices.size());
+    for (unsigned index : indices)
+        ret.push_back(m_entries[index].TextEntry);
+
+    return ret;
+}
+
+// Pack the tree bottom up with the Sort-Tile-Recursive
+// algorithm: the boxes are sorted by x in vertical slices,
+// each slice is sorted by y and packed in nodes
+void PdfTextSpatialIndex::buildTree()
+{
+    if (m_entries.size() == 0)
+        return;
+
+    m_items.reserve(m_entries.size());
+    for (unsigned i = 0; i < m_entries.size(); i++)
+        m_items.push_back({ m_entries[i].Rect, i });
+
+    auto centerX = [](const Box& box) { return box.Left + box.Right; };
+    auto centerY = [](const Box& box) { return box.Bottom + box.Top; };
+
+    // Pack a level of boxes, returning the packed ranges of them
+    auto pack = [&](auto& boxes, auto getBox)
+    {
+        vector<pair<unsigned, unsigned>> ranges;
+        unsigned count = (unsigned)boxes.size();
+        unsigned nodeCount = (count + NodeCapacity - 1) / NodeCapacity;
+        unsigned sliceCount = (unsigned)std::ceil(std::sqrt((double)nodeCount));
+        unsigned sliceSize = sliceCount * NodeCapacity;
+        std::sort(boxes.begin(), boxes.end(), [&](auto& lhs, auto& rhs)
+        {
+            return centerX(getBox(lhs)) < centerX(getBox(rhs));
+        });
+
+        for (unsigned slice = 0; slice < count; slice += sliceSize)
+        {
+            unsigned sliceEnd = std::min(slice + sliceSize, count);
+            std::sort(boxes.begin() + slice, boxes.begin() + sliceEnd, [&](auto& lhs, auto& rhs)
+            {
+                return centerY(getBox(lhs)) < centerY(getBox(rhs));
+            });
+
+            for (unsigned first = slice; first < sliceEnd; first += NodeCapacity)
+                ranges.push_back({ first, std::min(first + NodeCapacity, sliceEnd) - first });
+        }
+
+        return ranges;
+    };
+
+    auto getUnion = [](auto begin, auto end, auto getBox)
+    {
+        Box ret = getBox(*begin);
+        for (auto it = begin + 1; it != end; it++)
+        {
+            auto& box = getBox(*it);
+            ret.Left = std::min(ret.Left, box.Left);
+            ret.Bottom = std::min(ret.Bottom, box.Bottom);
+            ret.Right = std::max(ret.Right, box.Right);
+            ret.Top = std::max(ret.Top, box.Top);
+        }
+        return ret;
+    };
+
+    auto getItemBox = [](const Item& item) -> const Box& { return item.Rect; };
+    auto getNodeBox = [](const Node& node) -> const Box& { return node.Rect; };
+
+    // Create the leaves
+    vector<Node> level;
+    for (auto& range : pack(m_items, getItemBox))
+    {
+        auto begin = m_items.begin() + range.first;
+        level.push_back({ getUnion(begin, begin + range.second, getItemBox), range.first, range.second, true });
+    }
+
+    // Create the upper levels, appending every level after
+    // its children, until the root
+    while (true)
+    {
+        if (level.size() == 1)
+        {
+            m_nodes.push_back(level[0]);
+            break;
+        }
+
+        auto ranges = pack(level, getNodeBox);
+        unsigned offset = (unsigned)m_nodes.size();
+        m_nodes.insert(m_nodes.end(), level.begin(), level.end());
+        vector<Node> parents;
+        for (auto& range : ranges)
+        {
+            auto begin = level.begin() + range.first;
+            parents.push_back({ getUnion(begin, begin + range.second, getNodeBox), offset + range.first, range.second, false });
+        }
+
+        level = std::move(parents);
+    }
+}
@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_TEXT_SPATIAL_INDEX_H
+#define PDF_TEXT_SPATIAL_INDEX_H
+
+#include "PdfPage.h"
+
+namespace mm {
+
+/**
+ * A spatial index of the text entries of a page, so that many regions
+ * of the same page can be queried with a single extraction. The
+ * entries are kept in a static R-tree, packed when the index is built.
+ *
+ * The coordinates of the queries are the same as PdfTextExtractParams::ClipRect,
+ * that is the coordinates of the page, with no rotation applied
+ */
+class PDFMM_API PdfTextSpatialIndex final
+{
+public:
+    PdfTextSpatialIndex();
+
+    /** Extract the text of the page and index the entries,
+     *  replacing the current content
+     */
+    void Build(const PdfPage& page, const PdfTextExtractParams& params = { });
+
+    /** Find the entries starting inside the rect, the same as
+     *  extracting the text with PdfTextExtractParams::ClipRect
+     *  \returns the entries, in the order of the extraction
+     */
+    std::vector<PdfTextEntry> Find(const PdfRect& rect) const;
+
+    /** Find the entries whose glyph rect intersects the rect. The glyph rect
+     *  of an entry spans its length, and the ascent and the descent of its font
+     *  \returns the entries, in the order of the extraction
+     */
+    std::vector<PdfTextEntry> FindIntersecting(const PdfRect& rect) const;
+
+    void Clear();
+
+public:
+    inline unsigned GetEntryCount() const { return (unsigned)m_entries.size(); }
+
+private:
+    struct Box
+    {
+        double Left;
+        double Bottom;
+        double Right;
+        double Top;
+    };
+
+    struct Item
+    {
+        Box Rect;
+        unsigned Index;     // Index of the entry
+    };
+
+    struct Node
+    {
+        Box Rect;
+        unsigned First;     // First child node, or first item for leaves
+        unsigned Count;
+        bool IsLeaf;
+    };
+
+    struct Entry
+    {
+        PdfTextEntry TextEntry;
+        Box Rect;
+    };
+
+    std::vector<PdfTextEntry> find(const PdfRect& rect, bool intersecting) const;
+
+    void buildTree();
+
+private:
+    std::vector<Entry> m_entries;
+    std::vector<Item> m_items;
+    std::vector<Node> m_nodes;
+};
+
+};
+
+#endif // PDF_TEXT_SPATIAL_INDEX_H
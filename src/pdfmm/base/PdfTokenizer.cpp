@@ -10,6 +10,7 @@
 #include "PdfTokenizer.h"
 
 #include <pdfmm/private/charconv_compat.h>
+#include <pdfmm/private/PdfCharScanPrivate.h>
 
 #include "PdfArray.h"
 #include "PdfDictionary.h"
@@ -23,9 +24,50 @@
 using namespace std;
 using namespace mm;
 
+// Nested arrays shorter than this are always read immediately
+constexpr size_t LazyArrayMinLength = 4096;
+
+// The state of the scan of an array, that must
+// skip brackets in comments and literal strings
+struct ArraySkipState
+{
+    unsigned Depth = 1;
+    unsigned StringDepth = 0;
+    bool Escape = false;
+    bool Comment = false;
+};
+
+class PdfNestingGuard
+{
+    // RAII counter of the nesting depth of the containers being read
+
+public:
+    PdfNestingGuard(unsigned& depth)
+        : m_depth(depth)
+    {
+        // Bound the recursion of the readers, and of the
+        // functions copying and comparing the values read
+        constexpr unsigned MaxNestingDepth = 256;
+
+        if (m_depth == MaxNestingDepth)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::BrokenFile, "Too deeply nested arrays or dictionaries");
+
+        m_depth++;
+    }
+
+    ~PdfNestingGuard()
+    {
+        m_depth--;
+    }
+
+private:
+    unsigned& m_depth;
+};
+
 static char getEscapedCharacter(char ch);
 static void readHexString(InputStreamDevice& device, charbuff& buffer);
 static bool isOctalChar(char ch);
+static bool skipArrayChars(const char* data, size_t length, size_t& pos, ArraySkipState& state);
 
 PdfTokenizer::PdfTokenizer(bool readReferences)
     : PdfTokenizer(std::make_shared<charbuff>(BufferSize), readReferences)
@@ -33,7 +75,8 @@ PdfTokenizer::PdfTokenizer(bool readReferences)
 }
 
 PdfTokenizer::PdfTokenizer(const shared_ptr<charbuff>& buffer, bool readReferences)
-    : m_buffer(buffer), m_readReferences(readReferences)
+    : m_buffer(buffer), m_readReferences(readReferences), m_lazyNestedArrays(false), m_lazyStringDecryption(false), m_depth(0),
+    m_tokenQueueStart(0), m_tokenQueueCount(0), m_hasDequeuedNumber(false), m_dequeuedNumber(0)
 {
     if (buffer == nullptr)
         PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
@@ -51,20 +94,29 @@ bool PdfTokenizer::TryReadNextToken(InputStreamDevice& device, string_view& toke
     size_t bufferSize = m_buffer->size();
 
     // check first if there are queued tokens and return them first
-    if (m_tokenQueque.size() != 0)
+    m_hasDequeuedNumber = false;
+    if (m_tokenQueueCount != 0)
     {
-        TokenizerPair pair = m_tokenQueque.front();
-        m_tokenQueque.pop_front();
+        auto& queued = m_tokenQueue[m_tokenQueueStart];
+        m_tokenQueueStart = (m_tokenQueueStart + 1) % TokenQueueSize;
+        m_tokenQueueCount--;
 
-        tokenType = pair.second;
+        tokenType = queued.Type;
+        m_hasDequeuedNumber = queued.HasNumber;
+        m_dequeuedNumber = queued.Number;
 
         // make sure buffer is \0 terminated
-        strncpy(buffer, pair.first.c_str(), bufferSize);
-        buffer[bufferSize - 1] = '\0';
-        token = buffer;
+        size_t length = std::min(queued.Token.size(), bufferSize - 1);
+        std::memcpy(buffer, queued.Token.data(), length);
+        buffer[length] = '\0';
+        token = string_view(buffer, length);
         return true;
     }
 
+    bufferview view;
+    if (device.TryGetView(view))
+        return tryReadNextToken(device, view, token, tokenType);
+
     tokenType = PdfTokenType::Literal;
 
     char ch1;
@@ -72,6 +124,20 @@ bool PdfTokenizer::TryReadNextToken(InputStreamDevice& device, string_view& toke
     size_t count = 0;
     while (count + 1 < bufferSize) // NOTE: Including the null termination
     {
+        // Skip whitespace runs in the data the device holds in
+        // memory at once, if any, using the vectorized scanning
+        if (count == 0 && device.TryPeek(view))
+        {
+            size_t skip = FindNonWhitespace(view.data(), view.size());
+            if (skip != 0)
+            {
+                // NOTE: The buffer is used as scratch space, as no
+                // token character has been read yet
+                device.Read(buffer, std::min(skip, bufferSize));
+                continue;
+            }
+        }
+
         if (!device.Peek(ch1))
             goto Eof;
 
@@ -155,6 +221,19 @@ bool PdfTokenizer::TryReadNextToken(InputStreamDevice& device, string_view& toke
                 tokenType = tokenDelimiterType;
                 break;
             }
+
+            // Read the rest of regular token characters the device
+            // holds in memory at once, if any
+            if (device.TryPeek(view))
+            {
+                size_t read = FindWhitespaceOrDelimiter(view.data(),
+                    std::min(view.size(), bufferSize - 1 - count));
+                if (read != 0)
+                {
+                    device.Read(buffer + count, read);
+                    count += read;
+                }
+            }
         }
     }
 
@@ -175,6 +254,97 @@ Eof:
     goto Exit;
 }
 
+// Same as the buffered tokenization above, but returning a token pointing
+// directly in the device data. The position of the device is updated
+// only once the token has been read
+bool PdfTokenizer::tryReadNextToken(InputStreamDevice& device, const bufferview& view, string_view& token, PdfTokenType& tokenType)
+{
+    const char* data = view.data();
+    size_t length = view.size();
+    size_t pos = device.GetPosition();
+    // NOTE: Keep the same token length limit of the buffered tokenization
+    size_t maxLength = m_buffer->size() - 1;
+    tokenType = PdfTokenType::Literal;
+
+    // Skip leading whitespaces and comments
+    while (true)
+    {
+        pos += FindNonWhitespace(data + pos, length - pos);
+        if (pos == length)
+        {
+            device.Seek(pos);
+            token = { };
+            return false;
+        }
+
+        if (data[pos] != '%')
+            break;
+
+        // Consume all characters before the next line break
+        do
+        {
+            pos++;
+        } while (pos != length && data[pos] != '\n' && data[pos] != '\r');
+    }
+
+    size_t start = pos;
+    size_t end;
+    char ch = data[pos];
+    PdfTokenType tokenDelimiterType;
+    if (ch == '<' || ch == '>')
+    {
+        pos++;
+        if (pos != length)
+        {
+            // Are we opening/closing a dictionary?
+            if (data[pos] == ch)
+            {
+                pos++;
+                if (ch == '<')
+                    tokenType = PdfTokenType::DoubleAngleBracketsLeft;
+                else
+                    tokenType = PdfTokenType::DoubleAngleBracketsRight;
+            }
+            else
+            {
+                if (ch == '<')
+                    tokenType = PdfTokenType::AngleBracketLeft;
+                else
+                    tokenType = PdfTokenType::AngleBracketRight;
+            }
+        }
+
+        end = pos;
+    }
+    else if (IsTokenDelimiter(ch, tokenDelimiterType))
+    {
+        // All delimeters except << and >> are one-character tokens
+        pos++;
+        end = pos;
+        tokenType = tokenDelimiterType;
+    }
+    else
+    {
+        pos++;
+        pos += FindWhitespaceOrDelimiter(data + pos, std::min(length - pos, maxLength - 1));
+
+        end = pos;
+        if (pos != length && pos - start < maxLength && data[pos] == '%')
+        {
+            // Comments are treated as token-delimiting whitespace
+            // and they are consumed before returning the token
+            do
+            {
+                pos++;
+            } while (pos != length && data[pos] != '\n' && data[pos] != '\r');
+        }
+    }
+
+    device.Seek(pos);
+    token = string_view(data + start, end - start);
+    return true;
+}
+
 bool PdfTokenizer::IsNextToken(InputStreamDevice& device, const string_view& token)
 {
     if (token.length() == 0)
@@ -207,6 +377,23 @@ int64_t PdfTokenizer::ReadNextNumber(InputStreamDevice& device)
     return static_cast<int64_t>(num);
 }
 
+bool PdfTokenizer::TryReadNextNumber(InputStreamDevice& device, int64_t& value)
+{
+    PdfTokenType tokenType;
+    string_view token;
+    if (!this->TryReadNextToken(device, token, tokenType))
+        return false;
+
+    if (std::from_chars(token.data(), token.data() + token.size(), value).ec != std::errc())
+    {
+        // Don't consume the token
+        this->EnqueueToken(token, tokenType);
+        return false;
+    }
+
+    return true;
+}
+
 void PdfTokenizer::ReadNextVariant(InputStreamDevice& device, PdfVariant& variant, const PdfStatefulEncrypt& encrypt)
 {
     if (!TryReadNextVariant(device, variant, encrypt))
@@ -261,46 +448,50 @@ PdfTokenizer::PdfLiteralDataType PdfTokenizer::DetermineDataType(InputStreamDevi
                 return PdfLiteralDataType::Bool;
             }
 
+            // NOTE: The token may not be null terminated
+            int64_t num;
             PdfLiteralDataType dataType = PdfLiteralDataType::Number;
-            const char* start = token.data();
-            while (*start)
+            if (!tryGetDequeuedNumber(token, num))
             {
-                if (*start == '.')
+                for (char ch : token)
                 {
-                    dataType = PdfLiteralDataType::Real;
-                }
-                else if (!(isdigit(*start) || *start == '-' || *start == '+'))
-                {
-                    dataType = PdfLiteralDataType::Unknown;
-                    break;
+                    if (ch == '.')
+                    {
+                        dataType = PdfLiteralDataType::Real;
+                    }
+                    else if (!(isdigit(ch) || ch == '-' || ch == '+'))
+                    {
+                        dataType = PdfLiteralDataType::Unknown;
+                        break;
+                    }
                 }
 
-                start++;
-            }
-
-            if (dataType == PdfLiteralDataType::Real)
-            {
-                double val;
-                if (std::from_chars(token.data(), token.data() + token.length(), val, chars_format::fixed).ec != std::errc())
+                if (dataType == PdfLiteralDataType::Real)
                 {
-                    // Don't consume the token
-                    this->EnqueueToken(token, tokenType);
-                    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoNumber, token);
-                }
+                    double val;
+                    if (std::from_chars(token.data(), token.data() + token.length(), val, chars_format::fixed).ec != std::errc())
+                    {
+                        // Don't consume the token
+                        this->EnqueueToken(token, tokenType);
+                        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoNumber, token);
+                    }
 
-                variant = PdfVariant(val);
-                return PdfLiteralDataType::Real;
-            }
-            else if (dataType == PdfLiteralDataType::Number)
-            {
-                int64_t num;
-                if (std::from_chars(token.data(), token.data() + token.size(), num).ec != std::errc())
+                    variant = PdfVariant(val);
+                    return PdfLiteralDataType::Real;
+                }
+                else if (dataType == PdfLiteralDataType::Number)
                 {
-                    // Don't consume the token
-                    this->EnqueueToken(token, tokenType);
-                    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoNumber, token);
+                    if (std::from_chars(token.data(), token.data() + token.size(), num).ec != std::errc())
+                    {
+                        // Don't consume the token
+                        this->EnqueueToken(token, tokenType);
+                        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::NoNumber, token);
+                    }
                 }
+            }
 
+            if (dataType == PdfLiteralDataType::Number)
+            {
                 variant = PdfVariant(num);
                 if (!m_readReferences)
                     return PdfLiteralDataType::Number;
@@ -309,6 +500,12 @@ PdfTokenizer::PdfLiteralDataType PdfTokenizer::DetermineDataType(InputStreamDevi
                 // we cannot be sure that there is another token
                 // on the input device, so if we hit EOF just return
                 // EPdfDataType::Number .
+                // With contiguous input data the tokens are not
+                // enqueued back, but just read again later. Otherwise
+                // they are enqueued with their parsed numeric value
+                bufferview view;
+                bool canRewind = m_tokenQueueCount == 0 && device.TryGetView(view);
+                size_t position = canRewind ? device.GetPosition() : 0;
                 PdfTokenType secondTokenType;
                 string_view nextToken;
                 bool gotToken = this->TryReadNextToken(device, nextToken, secondTokenType);
@@ -319,23 +516,43 @@ PdfTokenizer::PdfLiteralDataType PdfTokenizer::DetermineDataType(InputStreamDevi
                 }
                 if (secondTokenType != PdfTokenType::Literal)
                 {
-                    this->EnqueueToken(nextToken, secondTokenType);
+                    if (canRewind)
+                        device.Seek(position);
+                    else
+                        this->EnqueueToken(nextToken, secondTokenType);
                     return PdfLiteralDataType::Number;
                 }
 
-                if (std::from_chars(nextToken.data(), nextToken.data() + nextToken.length(), num).ec != std::errc())
+                if (!tryGetDequeuedNumber(nextToken, num)
+                    && std::from_chars(nextToken.data(), nextToken.data() + nextToken.length(), num).ec != std::errc())
                 {
                     // Don't consume the token
-                    this->EnqueueToken(nextToken, secondTokenType);
+                    if (canRewind)
+                        device.Seek(position);
+                    else
+                        this->EnqueueToken(nextToken, secondTokenType);
                     return PdfLiteralDataType::Number;
                 }
 
-                string tmp(nextToken);
+                // Keep the second token in the next free slot of the
+                // queue, that is not used when reading the third one
+                if (!canRewind)
+                {
+                    auto& queued = reserveQueuedToken(nextToken, secondTokenType);
+                    queued.HasNumber = true;
+                    queued.Number = num;
+                }
+
                 PdfTokenType thirdTokenType;
                 gotToken = this->TryReadNextToken(device, nextToken, thirdTokenType);
                 if (!gotToken)
                 {
-                    // No third token, so it can't be a reference
+                    // No third token, so it can't be a reference,
+                    // but don't lose the second token
+                    if (canRewind)
+                        device.Seek(position);
+                    else
+                        m_tokenQueueCount++;
                     return PdfLiteralDataType::Number;
                 }
                 if (thirdTokenType == PdfTokenType::Literal &&
@@ -346,8 +563,22 @@ PdfTokenizer::PdfLiteralDataType PdfTokenizer::DetermineDataType(InputStreamDevi
                 }
                 else
                 {
-                    this->EnqueueToken(tmp, secondTokenType);
-                    this->EnqueueToken(nextToken, thirdTokenType);
+                    if (canRewind)
+                    {
+                        device.Seek(position);
+                    }
+                    else
+                    {
+                        int64_t thirdNum;
+                        bool isNumber = thirdTokenType == PdfTokenType::Literal
+                            && (tryGetDequeuedNumber(nextToken, thirdNum)
+                                || std::from_chars(nextToken.data(), nextToken.data() + nextToken.length(), thirdNum).ec == std::errc());
+                        m_tokenQueueCount++;
+                        auto& queued = reserveQueuedToken(nextToken, thirdTokenType);
+                        queued.HasNumber = isNumber;
+                        queued.Number = isNumber ? thirdNum : 0;
+                        m_tokenQueueCount++;
+                    }
                     return PdfLiteralDataType::Number;
                 }
             }
@@ -403,6 +634,7 @@ bool PdfTokenizer::tryReadDataType(InputStreamDevice& device, PdfLiteralDataType
 
 void PdfTokenizer::ReadDictionary(InputStreamDevice& device, PdfVariant& variant, const PdfStatefulEncrypt& encrypt)
 {
+    PdfNestingGuard guard(m_depth);
     PdfVariant val;
     PdfName key;
     PdfTokenType tokenType;
@@ -466,6 +698,10 @@ void PdfTokenizer::ReadDictionary(InputStreamDevice& device, PdfVariant& variant
 
 void PdfTokenizer::ReadArray(InputStreamDevice& device, PdfVariant& variant, const PdfStatefulEncrypt& encrypt)
 {
+    if (m_lazyNestedArrays && m_depth != 0 && tryReadLazyArray(device, variant, encrypt))
+        return;
+
+    PdfNestingGuard guard(m_depth);
     string_view token;
     PdfTokenType tokenType;
     PdfVariant var;
@@ -486,7 +722,96 @@ void PdfTokenizer::ReadArray(InputStreamDevice& device, PdfVariant& variant, con
     }
 }
 
+bool PdfTokenizer::tryReadLazyArray(InputStreamDevice& device, PdfVariant& variant, const PdfStatefulEncrypt& encrypt)
+{
+    // The device must be positioned right after the opening
+    // bracket, which is not the case if tokens are enqueued
+    if (m_tokenQueueCount != 0)
+        return false;
+
+    size_t position = device.GetPosition();
+    size_t endPosition;
+    ArraySkipState state;
+    bufferview view;
+    if (device.TryGetView(view))
+    {
+        endPosition = position;
+        if (!skipArrayChars(view.data(), view.size(), endPosition, state))
+            return false;
+    }
+    else
+    {
+        // Start reading a small chunk, as most arrays are short
+        size_t chunkSize = 256;
+        size_t chunkPosition = position;
+        while (true)
+        {
+            bool eof;
+            size_t read = device.Read(m_buffer->data(), std::min(chunkSize, m_buffer->size()), eof);
+            size_t pos = 0;
+            if (skipArrayChars(m_buffer->data(), read, pos, state))
+            {
+                endPosition = chunkPosition + pos;
+                break;
+            }
+
+            if (eof || read == 0)
+            {
+                // Let the regular reading report the error
+                device.Seek(position);
+                return false;
+            }
+
+            chunkPosition += read;
+            chunkSize = m_buffer->size();
+        }
+    }
+
+    // NOTE: The length includes the opening bracket
+    if (endPosition - position + 1 < LazyArrayMinLength)
+    {
+        device.Seek(position);
+        return false;
+    }
+
+    device.Seek(endPosition);
+    variant = PdfArray();
+    variant.GetArray().setLazySource(device, position - 1, encrypt);
+    return true;
+}
+
 void PdfTokenizer::ReadString(InputStreamDevice& device, PdfVariant& variant, const PdfStatefulEncrypt& encrypt)
+{
+    m_charBuffer.clear();
+    ReadStringTo(device, m_charBuffer);
+
+    if (m_charBuffer.size() != 0)
+    {
+        if (encrypt.HasEncrypt() && m_lazyStringDecryption)
+        {
+            variant = PdfString::FromRaw({ m_charBuffer.data(), m_charBuffer.size() }, false);
+            deferDecryption(variant, encrypt);
+        }
+        else if (encrypt.HasEncrypt())
+        {
+            charbuff decrypted;
+            encrypt.DecryptTo(decrypted, { m_charBuffer.data(), m_charBuffer.size() });
+            variant = PdfString(std::move(decrypted), false);
+        }
+        else
+        {
+            variant = PdfString::FromRaw({ m_charBuffer.data(), m_charBuffer.size() }, false);
+        }
+    }
+    else
+    {
+        // NOTE: The string is empty but ensure it will be
+        // initialized as a raw buffer first
+        variant = PdfString::FromRaw({ }, false);
+    }
+}
+
+void PdfTokenizer::ReadStringTo(InputStreamDevice& device, charbuff& buffer)
 {
     char ch;
     bool escape = false;
@@ -495,7 +820,6 @@ void PdfTokenizer::ReadString(InputStreamDevice& device, PdfVariant& variant, co
     char octValue = 0;
     int balanceCount = 0; // Balanced parathesis do not have to be escaped in strings
 
-    m_charBuffer.clear();
     while (device.Read(ch))
     {
         if (escape)
@@ -518,11 +842,11 @@ void PdfTokenizer::ReadString(InputStreamDevice& device, PdfVariant& variant, co
                     // No octal character anymore,
                     // so the octal sequence must be ended
                     // and the character has to be treated as normal character!
-                    m_charBuffer.push_back(octValue);
+                    buffer.push_back(octValue);
 
                     if (ch != '\\')
                     {
-                        m_charBuffer.push_back(ch);
+                        buffer.push_back(ch);
                         escape = false;
                     }
 
@@ -537,7 +861,7 @@ void PdfTokenizer::ReadString(InputStreamDevice& device, PdfVariant& variant, co
 
                 if (octCharCount == 3)
                 {
-                    m_charBuffer.push_back(octValue);
+                    buffer.push_back(octValue);
                     escape = false;
                     octEscape = false;
                     octCharCount = 0;
@@ -560,7 +884,7 @@ void PdfTokenizer::ReadString(InputStreamDevice& device, PdfVariant& variant, co
                     // Handle plain escape sequences
                     char escapedCh = getEscapedCharacter(ch);
                     if (escapedCh != '\0')
-                        m_charBuffer.push_back(escapedCh);
+                        buffer.push_back(escapedCh);
                 }
 
                 escape = false;
@@ -579,39 +903,77 @@ void PdfTokenizer::ReadString(InputStreamDevice& device, PdfVariant& variant, co
 
             escape = ch == '\\';
             if (!escape)
-                m_charBuffer.push_back(static_cast<char>(ch));
+                buffer.push_back(static_cast<char>(ch));
         }
     }
 
     // In case the string ends with a octal escape sequence
     if (octEscape)
-        m_charBuffer.push_back(octValue);
+        buffer.push_back(octValue);
+}
 
-    if (m_charBuffer.size() != 0)
+void PdfTokenizer::ReadHexStringTo(InputStreamDevice& device, charbuff& buffer)
+{
+    char ch;
+    unsigned char value = 0;
+    bool highNibble = true;
+    while (device.Read(ch))
     {
-        if (encrypt.HasEncrypt())
+        // end of stream reached
+        if (ch == '>')
+            break;
+
+        // only a hex digits
+        unsigned char nibble;
+        if (isdigit(ch))
+            nibble = (unsigned char)(ch - '0');
+        else if (ch >= 'A' && ch <= 'F')
+            nibble = (unsigned char)(ch - 'A' + 10);
+        else if (ch >= 'a' && ch <= 'f')
+            nibble = (unsigned char)(ch - 'a' + 10);
+        else
+            continue;
+
+        if (highNibble)
         {
-            charbuff decrypted;
-            encrypt.DecryptTo(decrypted, { m_charBuffer.data(), m_charBuffer.size() });
-            variant = PdfString(std::move(decrypted), false);
+            value = (unsigned char)(nibble << 4);
+            highNibble = false;
         }
         else
         {
-            variant = PdfString::FromRaw({ m_charBuffer.data(), m_charBuffer.size() }, false);
+            buffer.push_back((char)(value | nibble));
+            highNibble = true;
         }
     }
+
+    // pad to an even length if necessary
+    if (!highNibble)
+        buffer.push_back((char)value);
+}
+
+void PdfTokenizer::ReadHexString(InputStreamDevice& device, PdfVariant& variant, const PdfStatefulEncrypt& encrypt)
+{
+    readHexString(device, m_charBuffer);
+    string_view hexView(m_charBuffer.size() ? m_charBuffer.data() : "", m_charBuffer.size());
+    if (m_lazyStringDecryption)
+    {
+        variant = PdfString::FromHexData(hexView);
+        deferDecryption(variant, encrypt);
+    }
     else
     {
-        // NOTE: The string is empty but ensure it will be
-        // initialized as a raw buffer first
-        variant = PdfString::FromRaw({ }, false);
+        variant = PdfString::FromHexData(hexView, encrypt);
     }
 }
 
-void PdfTokenizer::ReadHexString(InputStreamDevice& device, PdfVariant& variant, const PdfStatefulEncrypt& encrypt)
+void PdfTokenizer::deferDecryption(PdfVariant& variant, const PdfStatefulEncrypt& encrypt)
 {
-    readHexString(device, m_charBuffer);
-    variant = PdfString::FromHexData({ m_charBuffer.size() ? m_charBuffer.data() : "", m_charBuffer.size() }, encrypt);
+    if (!encrypt.HasEncrypt())
+        return;
+
+    // NOTE: Set the decryption on the string held by the variant,
+    // as copying a string with pending decryption decrypts it
+    const_cast<PdfString&>(variant.GetString()).deferDecryption(encrypt);
 }
 
 void PdfTokenizer::ReadName(InputStreamDevice& device, PdfVariant& variant)
@@ -649,7 +1011,41 @@ void PdfTokenizer::ReadName(InputStreamDevice& device, PdfVariant& variant)
 
 void PdfTokenizer::EnqueueToken(const string_view& token, PdfTokenType tokenType)
 {
-    m_tokenQueque.push_back(TokenizerPair(string(token), tokenType));
+    (void)reserveQueuedToken(token, tokenType);
+    m_tokenQueueCount++;
+}
+
+PdfTokenizer::QueuedToken& PdfTokenizer::reserveQueuedToken(const string_view& token, PdfTokenType tokenType)
+{
+    if (m_tokenQueueCount == TokenQueueSize)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Too many tokens pushed back");
+
+    // NOTE: The slot strings keep their capacity, so
+    // pushing back tokens doesn't allocate memory
+    auto& queued = m_tokenQueue[(m_tokenQueueStart + m_tokenQueueCount) % TokenQueueSize];
+    queued.Token.assign(token.data(), token.size());
+    queued.Type = tokenType;
+    queued.HasNumber = false;
+    queued.Number = 0;
+    return queued;
+}
+
+// Get the numeric value of the token last read, if it was
+// dequeued with the value parsed by the reference lookahead
+bool PdfTokenizer::tryGetDequeuedNumber(const string_view& token, int64_t& num) const
+{
+    if (!m_hasDequeuedNumber || token.data() != m_buffer->data())
+        return false;
+
+    num = m_dequeuedNumber;
+    return true;
+}
+
+void PdfTokenizer::clearTokenQueue()
+{
+    m_tokenQueueStart = 0;
+    m_tokenQueueCount = 0;
+    m_hasDequeuedNumber = false;
 }
 
 bool PdfTokenizer::IsWhitespace(char ch)
@@ -814,3 +1210,54 @@ bool isOctalChar(char ch)
             return false;
     }
 }
+
+bool skipArrayChars(const char* data, size_t length, size_t& pos, ArraySkipState& state)
+{
+    for (; pos < length; pos++)
+    {
+        char ch = data[pos];
+        if (state.Comment)
+        {
+            if (ch == '\r' || ch == '\n')
+                state.Comment = false;
+        }
+        else if (state.StringDepth != 0)
+        {
+            if (state.Escape)
+                state.Escape = false;
+            else if (ch == '\\')
+                state.Escape = true;
+            else if (ch == '(')
+                state.StringDepth++;
+            else if (ch == ')')
+                state.StringDepth--;
+        }
+        else
+        {
+            switch (ch)
+            {
+                case '%':
+                    state.Comment = true;
+                    break;
+                case '(':
+                    state.StringDepth = 1;
+                    break;
+                case '[':
+                    state.Depth++;
+                    break;
+                case ']':
+                    state.Depth--;
+                    if (state.Depth == 0)
+                    {
+                        pos++;
+                        return true;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    return false;
+}
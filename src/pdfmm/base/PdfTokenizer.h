@@ -13,7 +13,7 @@
 #include "PdfInputDevice.h"
 #include "PdfStatefulEncrypt.h"
 
-#include <deque>
+#include <array>
 
 namespace mm {
 
@@ -54,12 +54,14 @@ public:
     /** Reads the next token from the current file position
      *  ignoring all comments.
      *
-     *  \param[out] token On true return, set to a pointer to the read
-     *                     token (a nullptr-terminated C string). The pointer is
-     *                     to memory owned by PdfTokenizer and must NOT be
-     *                     freed.  The contents are invalidated on the next
-     *                     call to tryReadNextToken(..) and by the destruction of
-     *                     the PdfTokenizer. Undefined on false return.
+     *  \param[out] token On true return, set to a view of the read
+     *                     token. The view is to memory owned by PdfTokenizer,
+     *                     or directly to the device data if it's contiguous in
+     *                     memory (see InputStreamDevice::TryGetView), and it
+     *                     is not guaranteed to be null terminated. The contents
+     *                     are invalidated on the next call to tryReadNextToken(..)
+     *                     and by the destruction of the PdfTokenizer.
+     *                     Undefined on false return.
      *
      *  \param[out] tokenType On true return, if not nullptr the type of the read token
      *                     will be stored into this parameter. Undefined on false
@@ -95,6 +97,15 @@ public:
      */
     int64_t ReadNextNumber(InputStreamDevice& device);
 
+    /** Read the next number from the current file position
+     *  ignoring all comments, without raising on malformed data
+     *
+     *  \param[out] value the read number, undefined on false return
+     *  \returns false if there are no more tokens or the next token
+     *      is not a number. In the latter case the token is not consumed
+     */
+    bool TryReadNextNumber(InputStreamDevice& device, int64_t& value);
+
     /** Read the next variant from the current file position
      *  ignoring all comments.
      *
@@ -214,6 +225,16 @@ protected:
      */
     void ReadHexString(InputStreamDevice& device, PdfVariant& variant, const PdfStatefulEncrypt& encrypt);
 
+    /** Read a string from the input device, appending
+     *  the unescaped characters to the buffer
+     */
+    static void ReadStringTo(InputStreamDevice& device, charbuff& buffer);
+
+    /** Read a hex string from the input device, appending
+     *  the decoded bytes to the buffer
+     */
+    static void ReadHexStringTo(InputStreamDevice& device, charbuff& buffer);
+
     /** Read a name from the input device
      *  and store it into a variant.
      *
@@ -231,17 +252,52 @@ protected:
      */
     PdfLiteralDataType DetermineDataType(InputStreamDevice& device, const std::string_view& token, PdfTokenType tokenType, PdfVariant& variant);
 
+    /** Defer the reading of large arrays nested in other arrays or
+     *  dictionaries, which are read again from the device when they are
+     *  accessed the first time. The device must outlive the read variants
+     */
+    inline void SetLazyNestedArrays(bool lazyNestedArrays) { m_lazyNestedArrays = lazyNestedArrays; }
+
+    /** Keep the read strings encrypted until their contents are
+     *  accessed the first time. The encryption must outlive the read variants
+     */
+    inline void SetLazyStringDecryption(bool lazyStringDecryption) { m_lazyStringDecryption = lazyStringDecryption; }
+
 private:
+    bool tryReadNextToken(InputStreamDevice& device, const bufferview& view, std::string_view& token, PdfTokenType& tokenType);
     bool tryReadDataType(InputStreamDevice& device, PdfLiteralDataType dataType, PdfVariant& variant, const PdfStatefulEncrypt& encrypt);
+    bool tryReadLazyArray(InputStreamDevice& device, PdfVariant& variant, const PdfStatefulEncrypt& encrypt);
+    static void deferDecryption(PdfVariant& variant, const PdfStatefulEncrypt& encrypt);
+    bool tryGetDequeuedNumber(const std::string_view& token, int64_t& num) const;
+    void clearTokenQueue();
 
 private:
-    using TokenizerPair = std::pair<std::string, PdfTokenType>;
-    using TokenizerQueque = std::deque<TokenizerPair>;
+    // A token pushed back in the queue, with its
+    // numeric value if it was already parsed
+    struct QueuedToken
+    {
+        std::string Token;
+        PdfTokenType Type = PdfTokenType::Unknown;
+        bool HasNumber = false;
+        int64_t Number = 0;
+    };
+
+    // The reference lookahead pushes back at most two tokens
+    static constexpr unsigned TokenQueueSize = 2;
+
+    QueuedToken& reserveQueuedToken(const std::string_view& token, PdfTokenType type);
 
 private:
     std::shared_ptr<charbuff> m_buffer;
     bool m_readReferences;
-    TokenizerQueque m_tokenQueque;
+    bool m_lazyNestedArrays;
+    bool m_lazyStringDecryption;
+    unsigned m_depth;
+    std::array<QueuedToken, TokenQueueSize> m_tokenQueue;
+    unsigned m_tokenQueueStart;
+    unsigned m_tokenQueueCount;
+    bool m_hasDequeuedNumber;
+    int64_t m_dequeuedNumber;
     charbuff m_charBuffer;
 };
 
@@ -0,0 +1,51 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <pdfmm/private/PdfDeclarationsPrivate.h>
+#include "PdfTrace.h"
+
+#include <atomic>
+
+#include "PdfDocument.h"
+
+using namespace std;
+using namespace mm;
+
+static atomic<PdfTraceSink*> s_globalSink(nullptr);
+
+PdfTraceSink::~PdfTraceSink() { }
+
+void PdfTrace::SetGlobalSink(PdfTraceSink* sink)
+{
+    s_globalSink.store(sink, memory_order_release);
+}
+
+PdfTraceSink* PdfTrace::GetGlobalSink()
+{
+    return s_globalSink.load(memory_order_acquire);
+}
+
+bool PdfTrace::IsSupported()
+{
+#ifdef PDFMM_HAVE_TRACING
+    return true;
+#else
+    return false;
+#endif // PDFMM_HAVE_TRACING
+}
+
+PdfTraceSink* PdfTrace::GetSink(const PdfDocument* document)
+{
+    if (document != nullptr)
+    {
+        auto sink = document->GetTraceSink();
+        if (sink != nullptr)
+            return sink;
+    }
+
+    return s_globalSink.load(memory_order_acquire);
+}
@@ -0,0 +1,100 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_TRACE_H
+#define PDF_TRACE_H
+
+#include <chrono>
+
+#include "PdfDeclarations.h"
+#include "PdfReference.h"
+
+namespace mm {
+
+class PdfDocument;
+
+enum class PdfTraceEventType
+{
+    ObjectLoad,         ///< The delayed load of an object read from a file
+    StreamDecode,       ///< The decoding of the data of a stream
+    FontLoad,           ///< The creation of a font, loaded from an object or imported
+    FontSubset,         ///< The subsetting and the embedding of an imported font
+    XRefSectionRead,    ///< The reading of a xref table or stream
+    WriterPhase,        ///< A phase of the writing of a document
+    ContentsProfile,    ///< The profiling of the contents of a page or of a XObject form
+};
+
+/** An event received by a PdfTraceSink
+ *
+ * Only the fields meaningful for the type of the event are set,
+ * the others have their default value
+ */
+struct PDFMM_API PdfTraceEvent
+{
+    PdfTraceEventType Type = PdfTraceEventType::ObjectLoad;
+    const PdfDocument* Document = nullptr;          ///< The document, nullptr if unknown
+    std::chrono::nanoseconds Duration { };
+    PdfReference Reference;                         ///< The object loaded or decoded, or the font object
+    PdfFilterType Filter = PdfFilterType::None;     ///< StreamDecode: the first filter of the stream
+    size_t Offset = 0;                              ///< XRefSectionRead, WriterPhase: the offset of the section or of the written data
+    size_t InputLength = 0;                         ///< The count of bytes read or decoded
+    size_t OutputLength = 0;                        ///< The count of bytes produced or written. ContentsProfile: the count of operators
+    std::string_view Name;                          ///< FontLoad, FontSubset: the font name. WriterPhase: the phase. ContentsProfile: "page" or "form"
+};
+
+/** An interface receiving the events traced by the library
+ *
+ * A sink can be set globally, with PdfTrace::SetGlobalSink, or
+ * for a single document, with PdfDocument::SetTraceSink. The
+ * events are delivered when the traced operation completes.
+ *
+ * Events may be delivered concurrently from the threads used
+ * by the library, for example when embedding fonts or loading
+ * frozen documents, so OnEvent must be thread safe. It must
+ * not throw, either
+ *
+ * \remarks Events are delivered only if the library was built
+ * with PDFMM_WITH_TRACING, otherwise the tracing code is
+ * compiled out and the sinks are never called
+ */
+class PDFMM_API PdfTraceSink
+{
+public:
+    virtual ~PdfTraceSink();
+
+    virtual void OnEvent(const PdfTraceEvent& ev) = 0;
+};
+
+class PDFMM_API PdfTrace final
+{
+public:
+    PdfTrace() = delete;
+
+public:
+    /** Set the sink receiving the events of all the documents
+     * without a sink of their own
+     *
+     * \param sink the sink, or nullptr to stop tracing. It's not owned
+     * and it must be kept alive until it's replaced
+     */
+    static void SetGlobalSink(PdfTraceSink* sink);
+
+    static PdfTraceSink* GetGlobalSink();
+
+    /** \returns true if the library was built with tracing support
+     */
+    static bool IsSupported();
+
+    /** \returns the sink of the given document, if it has
+     * one, or the global sink
+     */
+    static PdfTraceSink* GetSink(const PdfDocument* document);
+};
+
+};
+
+#endif // PDF_TRACE_H
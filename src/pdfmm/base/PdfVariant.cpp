@@ -18,6 +18,10 @@
 using namespace mm;
 using namespace std;
 
+// Names and strings are stored out of line, so the variant
+// fits a 64 bit number or a reference with the data type
+static_assert(sizeof(PdfVariant) <= 16, "PdfVariant should be 16 bytes at most");
+
 constexpr unsigned short DefaultPrecision = 6;
 
 PdfVariant PdfVariant::NullValue;
@@ -55,7 +59,7 @@ PdfVariant::PdfVariant(const PdfString& str)
 PdfVariant::PdfVariant(const PdfName& name)
     : PdfVariant(PdfDataType::Name)
 {
-    m_Data.Data = new PdfName(name);
+    m_Data.Data = newName(name);
 }
 
 PdfVariant::PdfVariant(const PdfReference& ref)
@@ -125,13 +129,17 @@ void PdfVariant::clear()
     {
         case PdfDataType::Array:
         case PdfDataType::Dictionary:
-        case PdfDataType::Name:
         case PdfDataType::String:
         case PdfDataType::RawData:
         {
             delete m_Data.Data;
             break;
         }
+        case PdfDataType::Name:
+        {
+            deleteName((PdfName*)m_Data.Data);
+            break;
+        }
 
         case PdfDataType::Reference:
         case PdfDataType::Bool:
@@ -165,7 +173,8 @@ void PdfVariant::Write(OutputStreamDevice& device, PdfWriteFlags writeMode,
             if ((writeMode & PdfWriteFlags::NoInlineLiteral) == PdfWriteFlags::None)
                 device.Write(' '); // Write space before numbers
 
-            utls::FormatTo(buffer, "{}", m_Data.Number);
+            buffer.clear();
+            utls::AppendNumberTo(buffer, m_Data.Number);
             device.Write(buffer);
             break;
         }
@@ -273,7 +282,7 @@ void PdfVariant::assign(const PdfVariant& rhs)
         }
         case PdfDataType::Name:
         {
-            m_Data.Data = new PdfName(*static_cast<const PdfName*>(rhs.m_Data.Data));
+            m_Data.Data = newName(*static_cast<const PdfName*>(rhs.m_Data.Data));
             break;
         }
         case PdfDataType::String:
@@ -833,7 +842,17 @@ void PdfVariant::SetName(const PdfName& name)
     if (m_DataType != PdfDataType::Name)
         PDFMM_RAISE_ERROR(PdfErrorCode::InvalidDataType);
 
-    *((PdfName*)m_Data.Data) = name;
+    auto current = (PdfName*)m_Data.Data;
+    if (current->getAtom() != current && name.getAtom() == nullptr)
+    {
+        // Reuse the allocated name
+        *current = name;
+        return;
+    }
+
+    auto newname = newName(name);
+    deleteName(current);
+    m_Data.Data = newname;
 }
 
 void PdfVariant::SetString(const PdfString& str)
@@ -906,3 +925,18 @@ bool PdfVariant::IsReference() const
 {
     return m_DataType == PdfDataType::Reference;
 }
+
+PdfName* PdfVariant::newName(const PdfName& name)
+{
+    auto atom = name.getAtom();
+    if (atom == nullptr)
+        return new PdfName(name);
+
+    return const_cast<PdfName*>(atom);
+}
+
+void PdfVariant::deleteName(PdfName* name)
+{
+    if (name->getAtom() != name)
+        delete name;
+}
@@ -36,6 +36,7 @@ class PDFMM_API PdfVariant final
 {
     friend class PdfArray;
     friend class PdfDictionary;
+    friend class PdfObject;
 
 private:
     PdfVariant(PdfDataType type);
@@ -325,6 +326,12 @@ private:
     bool tryGetName(const PdfName*& name) const;
     bool tryGetString(const PdfString*& str) const;
 
+    /** Interned names are not copied, the variant
+     *  points to their immortal instance instead
+     */
+    static PdfName* newName(const PdfName& name);
+    static void deleteName(PdfName* name);
+
 private:
     /**
      * It's an easy mistake to pass a pointer to a PdfVariant when trying to
@@ -12,6 +12,7 @@
 #include "PdfData.h"
 #include "PdfDate.h"
 #include "PdfDictionary.h"
+#include "PdfExecutor.h"
 #include "PdfObject.h"
 #include "PdfParser.h"
 #include "PdfParserObject.h"
@@ -21,6 +22,14 @@
 #include "PdfXRefStream.h"
 #include "PdfStreamDevice.h"
 
+#include <pdfmm/private/PdfTracePrivate.h>
+
+#include <limits>
+#include <unordered_map>
+
+#include <openssl/md5.h>
+#include <openssl/evp.h>
+
 #define PDF_MAGIC           "\xe2\xe3\xcf\xd3\n"
 // 10 spaces
 #define LINEARIZATION_PADDING "          "
@@ -28,7 +37,169 @@
 using namespace std;
 using namespace mm;
 
+// Maximum count of objects and of stream bytes
+// serialized concurrently before being written
+static constexpr size_t MaxBatchObjectCount = 1024;
+static constexpr size_t MaxBatchStreamSize = 16 * 1024 * 1024;
+static constexpr unsigned DefaultObjectStreamSize = 100;
+// The index in the object stream is written with 2 bytes in the XRef stream
+static constexpr unsigned MaxObjectStreamSize = 65535;
+static constexpr uint16_t MaxGenerationNumber = 65535;
+
+// Values not known yet when the linearized file is written,
+// as wide as the largest offsets allowed in XRef tables
+static constexpr int64_t LinearizationPlaceholder = 9999999999;
+
 static PdfWriteFlags ToWriteFlags(PdfSaveOptions opts);
+static unsigned getBitCount(uint64_t value);
+
+struct PdfWriter::LinearizedLayout
+{
+    struct Page
+    {
+        vector<PdfObject*> Objects;     // The page object comes first
+        vector<unsigned> SharedIds;     // Entries of the shared object hint table used by the page
+    };
+
+    /** Write the page offset and shared object hint tables,
+     *  see ISO 32000-1:2008 F.4 "Hint Tables"
+     *  \param sharedTableOffset the offset of the shared object hint table in the data
+     */
+    void WriteHintTables(charbuff& data, size_t& sharedTableOffset) const;
+
+    uint32_t GetNumber(const PdfObject& obj) const
+    {
+        return References.at(obj.GetIndirectReference()).ObjectNumber();
+    }
+
+    uint64_t GetLength(const PdfObject& first, const PdfObject& last) const
+    {
+        return Ends[GetNumber(last)] - Offsets[GetNumber(first)];
+    }
+
+    /** The offsets in the hint tables don't account for the hint stream
+     */
+    uint64_t GetHintOffset(const PdfObject& obj) const
+    {
+        uint64_t offset = Offsets[GetNumber(obj)];
+        return offset > HintOffset ? offset - HintLength : offset;
+    }
+
+    vector<PdfObject*> DocumentObjects;     // The catalog, document-level objects and the encryption dictionary
+    vector<Page> Pages;                     // The objects of the first page are in the first-page section
+    vector<PdfObject*> SharedObjects;       // Objects used by more pages after the first
+    vector<PdfObject*> OtherObjects;
+    unordered_map<PdfReference, PdfReference> References;   // The written reference of each object
+    uint32_t LinearizationNumber = 0;       // The first object of the first-page section
+    uint32_t HintStreamNumber = 0;
+    uint32_t Size = 0;
+    vector<uint64_t> Offsets;               // By written object number
+    vector<uint64_t> Ends;
+    uint64_t HintOffset = 0;
+    uint64_t HintLength = 0;
+};
+
+// XRef section of a linearized file. The trailer of the first-page
+// section refers to the main section with /Prev, while the trailer
+// of the main section has only /Size, and the "startxref" of both
+// is given, see ISO 32000-1:2008 F.3 "Linearized PDF Document Structure"
+class LinearizedXRef final : public PdfXRef
+{
+public:
+    LinearizedXRef(PdfWriter& writer, const unordered_map<PdfReference, PdfReference>& references,
+            uint32_t size, uint64_t prevOffset, uint64_t startOffset) :
+        PdfXRef(writer),
+        m_references(&references),
+        m_size(size),
+        m_prevOffset(prevOffset),
+        m_startOffset(startOffset) { }
+
+    uint64_t GetOffset() const override
+    {
+        return m_startOffset;
+    }
+
+protected:
+    void EndWriteImpl(OutputStreamDevice& device, charbuff& buffer) override
+    {
+        PdfObject trailer;
+        if (m_prevOffset == 0)
+        {
+            GetWriter().FillTrailerObject(trailer, m_size, true);
+        }
+        else
+        {
+            GetWriter().FillTrailerObject(trailer, m_size, false);
+            auto& dict = trailer.GetDictionary();
+            for (auto key : { "Root", "Info", "Encrypt" })
+            {
+                PdfReference ref;
+                auto value = dict.GetKey(key);
+                if (value == nullptr || !value->TryGetReference(ref))
+                    continue;
+
+                auto found = m_references->find(ref);
+                if (found == m_references->end())
+                    dict.RemoveKey(key);
+                else
+                    value->SetReference(found->second);
+            }
+            dict.AddKey("Prev", static_cast<int64_t>(m_prevOffset));
+        }
+
+        device.Write("trailer\n");
+
+        // NOTE: Do not encrypt the trailer dictionary
+        trailer.Write(device, GetWriter().GetWriteFlags(), nullptr, buffer);
+    }
+
+private:
+    const unordered_map<PdfReference, PdfReference>* m_references;
+    uint32_t m_size;
+    uint64_t m_prevOffset;
+    uint64_t m_startOffset;
+};
+
+// Writes the bit fields of the hint tables, most significant bit first
+class HintBitWriter
+{
+public:
+    HintBitWriter(charbuff& buffer)
+        : m_buffer(&buffer), m_current(0), m_bitCount(0) { }
+
+    void Write(uint64_t value, unsigned bitCount)
+    {
+        for (unsigned i = bitCount; i != 0; i--)
+        {
+            m_current = (uint8_t)((m_current << 1) | ((value >> (i - 1)) & 1));
+            m_bitCount++;
+            if (m_bitCount == 8)
+            {
+                m_buffer->push_back((char)m_current);
+                m_current = 0;
+                m_bitCount = 0;
+            }
+        }
+    }
+
+    /** Pad the last byte with zero bits. Every item of the
+     *  per-page and the per-group entries starts at a byte boundary
+     */
+    void Flush()
+    {
+        if (m_bitCount == 0)
+            return;
+
+        m_buffer->push_back((char)(m_current << (8 - m_bitCount)));
+        m_current = 0;
+        m_bitCount = 0;
+    }
+
+private:
+    charbuff* m_buffer;
+    uint8_t m_current;
+    unsigned m_bitCount;
+};
 
 PdfWriter::PdfWriter(PdfIndirectObjectList* objects, const PdfObject& trailer, PdfVersion version) :
     m_Objects(objects),
@@ -38,6 +209,7 @@ PdfWriter::PdfWriter(PdfIndirectObjectList* objects, const PdfObject& trailer, P
     m_EncryptObj(nullptr),
     m_SaveOptions(PdfSaveOptions::None),
     m_WriteFlags(PdfWriteFlags::None),
+    m_ObjectStreamSize(DefaultObjectStreamSize),
     m_PrevXRefOffset(0),
     m_IncrementalUpdate(false),
     m_rewriteXRefTable(false)
@@ -85,23 +257,62 @@ void PdfWriter::Write(OutputStreamDevice& device)
         m_Encrypt->CreateEncryptionDictionary(m_EncryptObj->GetDictionary());
     }
 
-    unique_ptr<PdfXRef> xRef;
-    if (m_UseXRefStream)
-        xRef.reset(new PdfXRefStream(*this));
-    else
-        xRef.reset(new PdfXRef(*this));
+    if (!m_IncrementalUpdate && (m_SaveOptions & PdfSaveOptions::DeduplicateObjects) != PdfSaveOptions::None)
+    {
+        PDFMM_TRACE_SCOPE(trace, WriterPhase, &m_Objects->GetDocument());
+        PDFMM_TRACE_SET(trace, Name, "deduplicate");
+        deduplicateObjects();
+    }
+
+    // NOTE: Linearized files are always written with XRef tables
+    bool linearize = !m_IncrementalUpdate
+        && (m_SaveOptions & PdfSaveOptions::Linearize) != PdfSaveOptions::None;
 
     try
     {
-        if (!m_IncrementalUpdate)
-            WritePdfHeader(device);
+        LinearizedLayout layout;
+        if (linearize && planLinearization(layout))
+        {
+            PDFMM_TRACE_SCOPE(trace, WriterPhase, &m_Objects->GetDocument());
+            PDFMM_TRACE_SET(trace, Name, "linearized");
+            PDFMM_TRACE_SET(trace, Offset, device.GetPosition());
+            writeLinearized(device, layout);
+            PDFMM_TRACE_SET(trace, OutputLength, device.GetPosition() - trace.GetEvent().Offset);
+        }
+        else
+        {
+            unique_ptr<PdfXRef> xRef;
+            if (m_UseXRefStream)
+                xRef.reset(new PdfXRefStream(*this));
+            else
+                xRef.reset(new PdfXRef(*this));
 
-        WritePdfObjects(device, *m_Objects, *xRef);
+            if (!m_IncrementalUpdate)
+            {
+                PDFMM_TRACE_SCOPE(trace, WriterPhase, &m_Objects->GetDocument());
+                PDFMM_TRACE_SET(trace, Name, "header");
+                PDFMM_TRACE_SET(trace, Offset, device.GetPosition());
+                WritePdfHeader(device);
+                PDFMM_TRACE_SET(trace, OutputLength, device.GetPosition() - trace.GetEvent().Offset);
+            }
 
-        if (m_IncrementalUpdate)
-            xRef->SetFirstEmptyBlock();
+            {
+                PDFMM_TRACE_SCOPE(trace, WriterPhase, &m_Objects->GetDocument());
+                PDFMM_TRACE_SET(trace, Name, "objects");
+                PDFMM_TRACE_SET(trace, Offset, device.GetPosition());
+                WritePdfObjects(device, *m_Objects, *xRef);
+                PDFMM_TRACE_SET(trace, OutputLength, device.GetPosition() - trace.GetEvent().Offset);
+            }
 
-        xRef->Write(device, m_buffer);
+            PDFMM_TRACE_SCOPE(trace, WriterPhase, &m_Objects->GetDocument());
+            PDFMM_TRACE_SET(trace, Name, "xref");
+            PDFMM_TRACE_SET(trace, Offset, device.GetPosition());
+            if (m_IncrementalUpdate)
+                xRef->SetFirstEmptyBlock();
+
+            xRef->Write(device, m_buffer);
+            PDFMM_TRACE_SET(trace, OutputLength, device.GetPosition() - trace.GetEvent().Offset);
+        }
     }
     catch (PdfError& e)
     {
@@ -112,10 +323,13 @@ void PdfWriter::Write(OutputStreamDevice& device)
             m_EncryptObj = nullptr;
         }
 
+        m_duplicates.clear();
         PDFMM_PUSH_FRAME(e);
         throw e;
     }
 
+    m_duplicates.clear();
+
     // P.Zent: Delete Encryption dictionary (cannot be reused)
     if (m_EncryptObj != nullptr)
     {
@@ -132,8 +346,18 @@ void PdfWriter::WritePdfHeader(OutputStreamDevice& device)
 
 void PdfWriter::WritePdfObjects(OutputStreamDevice& device, const PdfIndirectObjectList& objects, PdfXRef& xref)
 {
-    for (PdfObject* obj : objects)
+    // NOTE: Encryption keeps state that can't be shared between threads
+    bool concurrent = (m_SaveOptions & PdfSaveOptions::ConcurrentWrite) != PdfSaveOptions::None
+        && m_Encrypt == nullptr && m_Objects->GetExecutor()->GetConcurrency() > 1;
+    vector<PdfObject*> batch;
+    size_t batchStreamSize = 0;
+    bool compress = GetCompressObjects();
+    ObjectStreamGroup group;
+    auto writeObject = [&](PdfObject* obj)
     {
+        if (m_duplicates.size() != 0 && m_duplicates.find(obj->GetIndirectReference()) != m_duplicates.end())
+            return;
+
         if (m_IncrementalUpdate)
         {
             if (!obj->IsDirty())
@@ -153,7 +377,7 @@ void PdfWriter::WritePdfObjects(OutputStreamDevice& device, const PdfIndirectObj
                         if (parserObject->GetOffset() - objRefLength > 0)
                         {
                             xref.AddInUseObject(obj->GetIndirectReference(), parserObject->GetOffset() - objRefLength);
-                            continue;
+                            return;
                         }
                     }
                 }
@@ -162,7 +386,7 @@ void PdfWriter::WritePdfObjects(OutputStreamDevice& device, const PdfIndirectObj
                     // The object will not be output in the XRef entries but it will be
                     // counted in trailer's /Size
                     xref.AddInUseObject(obj->GetIndirectReference(), nullptr);
-                    continue;
+                    return;
                 }
             }
         }
@@ -173,17 +397,821 @@ void PdfWriter::WritePdfObjects(OutputStreamDevice& device, const PdfIndirectObj
             // offset of the object and not retrieve it from the device
             xref.AddInUseObject(obj->GetIndirectReference(), 0xFFFFFFFF);
         }
+        else if (compress && CanCompressObject(*obj))
+        {
+            CompressObject(device, *obj, group, xref);
+        }
+        else if (concurrent)
+        {
+            // The objects must be read from the input device
+            // now, as it can't be accessed concurrently
+            obj->ForceLoad();
+            auto stream = obj->GetStream();
+            if (stream != nullptr)
+                batchStreamSize += stream->GetLength();
+
+            batch.push_back(obj);
+            if (batch.size() == MaxBatchObjectCount || batchStreamSize >= MaxBatchStreamSize)
+            {
+                writeBatch(device, batch, xref);
+                batch.clear();
+                batchStreamSize = 0;
+            }
+        }
         else
         {
             xref.AddInUseObject(obj->GetIndirectReference(), device.GetPosition());
             // Also make sure that we do not encrypt the encryption dictionary!
             obj->Write(device, m_WriteFlags, obj == m_EncryptObj ? nullptr : m_Encrypt.get(), m_buffer);
         }
+    };
+
+    if (m_IncrementalUpdate && !m_rewriteXRefTable && objects.tracksDirtyObjects())
+    {
+        // The unmodified objects are not written in the entry list, they
+        // are only counted in the trailer /Size, so visit just the modified ones
+        objects.loadDeferred();
+        if (objects.m_Objects.size() != 0)
+            xref.AddInUseObject((*objects.m_Objects.rbegin())->GetIndirectReference(), nullptr);
+
+        vector<PdfObject*> dirtyObjects;
+        objects.collectDirtyObjects(dirtyObjects);
+        for (PdfObject* obj : dirtyObjects)
+            writeObject(obj);
+    }
+    else
+    {
+        for (PdfObject* obj : objects)
+            writeObject(obj);
     }
 
-    for (auto& freeObjectRef : objects.GetFreeObjects())
+    if (batch.size() != 0)
+        writeBatch(device, batch, xref);
+
+    if (group.References.size() != 0)
+        WriteObjectStream(device, group, xref);
+
+    // The free objects are not sorted, sort them to
+    // fill the xref blocks sequentially
+    vector<PdfReference> freeObjects(objects.GetFreeObjects().begin(), objects.GetFreeObjects().end());
+    for (auto& ref : m_duplicates)
     {
+        // The merged objects are free in the written file
+        uint16_t generation = ref.GenerationNumber();
+        if (generation < MaxGenerationNumber)
+            generation++;
+
+        freeObjects.push_back(PdfReference(ref.ObjectNumber(), generation));
+    }
+
+    std::sort(freeObjects.begin(), freeObjects.end());
+    for (auto& freeObjectRef : freeObjects)
         xref.AddFreeObject(freeObjectRef);
+}
+
+bool PdfWriter::GetCompressObjects() const
+{
+    return (m_SaveOptions & PdfSaveOptions::CompressObjects) != PdfSaveOptions::None
+        && m_UseXRefStream;
+}
+
+bool PdfWriter::CanCompressObject(const PdfObject& obj) const
+{
+    // Stream objects and objects with non zero generation can't
+    // be in object streams, see ISO 32000-1:2008 7.5.7 "Object Streams".
+    // The encryption dictionary must be readable before decrypting.
+    // NOTE: Check streams not loaded yet without loading them
+    size_t rawStreamLength;
+    obj.DelayedLoad();
+    if (obj.TryGetRawStreamLength(rawStreamLength))
+        return false;
+
+    return !obj.HasStream() && obj.GetIndirectReference().GenerationNumber() == 0
+        && &obj != m_EncryptObj;
+}
+
+void PdfWriter::CompressObject(OutputStreamDevice& device, PdfObject& obj, ObjectStreamGroup& group, PdfXRef& xref)
+{
+    // The strings of the objects in object streams
+    // are not encrypted, the whole stream is
+    if (group.References.size() != 0)
+        group.Offsets.push_back(' ');
+
+    utls::AppendNumberTo(group.Offsets, obj.GetIndirectReference().ObjectNumber());
+    group.Offsets.push_back(' ');
+    utls::AppendNumberTo(group.Offsets, (int64_t)group.Data.size());
+    group.References.push_back(obj.GetIndirectReference());
+
+    BufferStreamDevice dataDevice(group.Data);
+    obj.GetVariant().Write(dataDevice, m_WriteFlags, { }, m_buffer);
+    group.Data.push_back('\n');
+    obj.ResetDirty();
+
+    if (group.References.size() >= m_ObjectStreamSize)
+        WriteObjectStream(device, group, xref);
+}
+
+void PdfWriter::WriteObjectStream(OutputStreamDevice& device, ObjectStreamGroup& group, PdfXRef& xref)
+{
+    // Create the stream object in the document only to write it,
+    // so it's assigned a free object number and it's encrypted
+    auto objStm = m_Objects->CreateDictionaryObject("ObjStm");
+    auto& dict = objStm->GetDictionary();
+    group.Offsets.push_back('\n');
+    dict.AddKey("N", (int64_t)group.References.size());
+    dict.AddKey("First", (int64_t)group.Offsets.size());
+    group.Offsets.append(group.Data);
+    objStm->GetOrCreateStream().Set(group.Offsets);
+
+    auto streamRef = objStm->GetIndirectReference();
+    xref.AddInUseObject(streamRef, device.GetPosition());
+    objStm->Write(device, m_WriteFlags, m_Encrypt.get(), m_buffer);
+    for (unsigned i = 0; i < group.References.size(); i++)
+        xref.AddCompressedObject(group.References[i], streamRef.ObjectNumber(), i);
+
+    // NOTE: The object number stays unavailable, as it's in the written file
+    m_Objects->RemoveObject(streamRef, false);
+    group.References.clear();
+    group.Offsets.clear();
+    group.Data.clear();
+}
+
+bool PdfWriter::planLinearization(LinearizedLayout& layout)
+{
+    PdfReference rootRef;
+    auto root = m_Trailer->GetDictionary().GetKey("Root");
+    PdfObject* catalog;
+    if (root == nullptr || !root->TryGetReference(rootRef)
+        || (catalog = m_Objects->GetObject(rootRef)) == nullptr)
+    {
+        return false;
+    }
+
+    // The page tree and the document-level objects are
+    // not part of the objects of the pages
+    unordered_set<PdfReference> stop;
+    stop.insert(rootRef);
+    vector<PdfObject*> pages;
+    collectPages(*catalog, pages, stop);
+    if (pages.size() == 0)
+        return false;
+
+    layout.DocumentObjects.push_back(catalog);
+    for (auto key : { "ViewerPreferences", "OpenAction" })
+    {
+        PdfReference ref;
+        PdfObject* obj;
+        auto value = catalog->GetDictionary().GetKey(key);
+        if (value != nullptr && value->TryGetReference(ref)
+            && stop.find(ref) == stop.end() && (obj = m_Objects->GetObject(ref)) != nullptr)
+        {
+            layout.DocumentObjects.push_back(obj);
+            stop.insert(ref);
+        }
+    }
+
+    if (m_EncryptObj != nullptr)
+    {
+        layout.DocumentObjects.push_back(m_EncryptObj);
+        stop.insert(m_EncryptObj->GetIndirectReference());
+    }
+
+    // The first-page section has all the objects used by the first
+    // page. They are shared object hint table entries as well
+    vector<PdfReference> reached;
+    layout.Pages.resize(pages.size());
+    auto& firstPage = layout.Pages[0].Objects;
+    collectPageObjects(*pages[0], stop, firstPage, reached);
+    unordered_map<PdfReference, unsigned> sharedIds;
+    for (unsigned i = 0; i < firstPage.size(); i++)
+    {
+        auto& ref = firstPage[i]->GetIndirectReference();
+        stop.insert(ref);
+        if (i != 0)
+            sharedIds[ref] = i;
+    }
+
+    // The objects used by a single page after the first are written
+    // after the page object, the ones used by more pages are shared
+    vector<vector<PdfObject*>> pageObjects(pages.size());
+    unordered_map<PdfReference, unsigned> pageCounts;
+    for (unsigned i = 1; i < pages.size(); i++)
+    {
+        reached.clear();
+        collectPageObjects(*pages[i], stop, pageObjects[i], reached);
+        for (auto obj : pageObjects[i])
+            pageCounts[obj->GetIndirectReference()]++;
+
+        for (auto& ref : reached)
+        {
+            auto found = sharedIds.find(ref);
+            if (found != sharedIds.end())
+                layout.Pages[i].SharedIds.push_back(found->second);
+        }
+    }
+
+    for (unsigned i = 1; i < pages.size(); i++)
+    {
+        auto& page = layout.Pages[i];
+        for (auto obj : pageObjects[i])
+        {
+            auto& ref = obj->GetIndirectReference();
+            if (pageCounts[ref] == 1)
+            {
+                page.Objects.push_back(obj);
+                continue;
+            }
+
+            auto inserted = sharedIds.insert({ ref, (unsigned)(firstPage.size() + layout.SharedObjects.size()) });
+            if (inserted.second)
+                layout.SharedObjects.push_back(obj);
+
+            page.SharedIds.push_back(inserted.first->second);
+        }
+    }
+
+    // The objects after the first-page section are numbered from 1,
+    // the objects of each page consecutively, see ISO 32000-1:2008 F.4.1
+    uint32_t number = 1;
+    auto assignNumber = [&](const PdfObject& obj) {
+        layout.References[obj.GetIndirectReference()] = PdfReference(number, 0);
+        number++;
+    };
+
+    for (unsigned i = 1; i < layout.Pages.size(); i++)
+    {
+        for (auto obj : layout.Pages[i].Objects)
+            assignNumber(*obj);
+    }
+
+    for (auto obj : layout.SharedObjects)
+        assignNumber(*obj);
+
+    // The remaining objects, e.g. the page tree and the outlines, come last
+    unordered_set<PdfReference> firstPageSection;
+    for (auto obj : layout.DocumentObjects)
+        firstPageSection.insert(obj->GetIndirectReference());
+
+    for (auto obj : firstPage)
+        firstPageSection.insert(obj->GetIndirectReference());
+
+    for (PdfObject* obj : *m_Objects)
+    {
+        auto& ref = obj->GetIndirectReference();
+        if ((m_duplicates.size() != 0 && m_duplicates.find(ref) != m_duplicates.end())
+            || layout.References.find(ref) != layout.References.end()
+            || firstPageSection.find(ref) != firstPageSection.end())
+        {
+            continue;
+        }
+
+        layout.OtherObjects.push_back(obj);
+        assignNumber(*obj);
+    }
+
+    layout.LinearizationNumber = number++;
+    for (auto obj : layout.DocumentObjects)
+        assignNumber(*obj);
+
+    layout.HintStreamNumber = number++;
+    for (auto obj : firstPage)
+        assignNumber(*obj);
+
+    layout.Size = number;
+    return true;
+}
+
+void PdfWriter::writeLinearized(OutputStreamDevice& device, LinearizedLayout& layout)
+{
+    layout.Offsets.resize(layout.Size);
+    layout.Ends.resize(layout.Size);
+    auto& firstPage = layout.Pages[0].Objects;
+
+    WritePdfHeader(device);
+
+    // The linearization parameter dictionary, see ISO 32000-1:2008 Table F.1
+    charbuff linearizationBuffer;
+    auto serializeLinearization = [&](int64_t fileLength, int64_t firstPageEnd, int64_t mainXRefEntryOffset) {
+        PdfObject linearization;
+        auto& dict = linearization.GetDictionary();
+        dict.AddKey("Linearized", static_cast<int64_t>(1));
+        dict.AddKey("L", fileLength);
+        PdfArray hint;
+        hint.Add(static_cast<int64_t>(layout.HintOffset));
+        hint.Add(static_cast<int64_t>(layout.HintLength));
+        dict.AddKey("H", hint);
+        dict.AddKey("O", static_cast<int64_t>(layout.GetNumber(*firstPage[0])));
+        dict.AddKey("E", firstPageEnd);
+        dict.AddKey("N", static_cast<int64_t>(layout.Pages.size()));
+        dict.AddKey("T", mainXRefEntryOffset);
+        linearizationBuffer.clear();
+        BufferStreamDevice bufferDevice(linearizationBuffer);
+        linearization.write(bufferDevice, m_WriteFlags, PdfReference(layout.LinearizationNumber, 0),
+            nullptr, nullptr, m_buffer);
+    };
+
+    charbuff firstXRefBuffer;
+    auto serializeFirstXRef = [&](int64_t mainXRefOffset) {
+        // NOTE: The buffer starts at offset 0, so the
+        // "startxref" of the section is 0 as required
+        LinearizedXRef xref(*this, layout.References, layout.Size, (uint64_t)mainXRefOffset, 0);
+        for (uint32_t i = layout.LinearizationNumber; i < layout.Size; i++)
+            xref.AddInUseObject(PdfReference(i, 0), layout.Offsets[i]);
+
+        firstXRefBuffer.clear();
+        BufferStreamDevice bufferDevice(firstXRefBuffer);
+        xref.Write(bufferDevice, m_buffer);
+    };
+
+    // The hint stream is not compressed, so its size doesn't depend on the values
+    charbuff hintData;
+    auto writeHintStream = [&]() {
+        size_t sharedTableOffset;
+        layout.WriteHintTables(hintData, sharedTableOffset);
+        PdfObject hint;
+        hint.GetDictionary().AddKey("S", static_cast<int64_t>(sharedTableOffset));
+        hint.GetOrCreateStream().Set(hintData, PdfFilterList());
+        hint.write(device, m_WriteFlags, PdfReference(layout.HintStreamNumber, 0),
+            nullptr, m_Encrypt.get(), m_buffer);
+    };
+
+    // Write the placeholders of the values not known yet
+    size_t linearizationOffset = device.GetPosition();
+    layout.Offsets[layout.LinearizationNumber] = linearizationOffset;
+    layout.HintOffset = LinearizationPlaceholder;
+    layout.HintLength = LinearizationPlaceholder;
+    serializeLinearization(LinearizationPlaceholder, LinearizationPlaceholder, LinearizationPlaceholder);
+    size_t linearizationSize = linearizationBuffer.size();
+    device.Write(linearizationBuffer);
+
+    size_t firstXRefOffset = device.GetPosition();
+    serializeFirstXRef(LinearizationPlaceholder);
+    size_t firstXRefSize = firstXRefBuffer.size();
+    device.Write(firstXRefBuffer);
+
+    for (auto obj : layout.DocumentObjects)
+        writeRenumberedObject(device, *obj, layout);
+
+    layout.HintOffset = device.GetPosition();
+    layout.HintLength = 0;
+    layout.Offsets[layout.HintStreamNumber] = layout.HintOffset;
+    writeHintStream();
+    layout.HintLength = device.GetPosition() - layout.HintOffset;
+
+    for (auto obj : firstPage)
+        writeRenumberedObject(device, *obj, layout);
+
+    size_t firstPageEnd = device.GetPosition();
+    for (unsigned i = 1; i < layout.Pages.size(); i++)
+    {
+        for (auto obj : layout.Pages[i].Objects)
+            writeRenumberedObject(device, *obj, layout);
+    }
+
+    for (auto obj : layout.SharedObjects)
+        writeRenumberedObject(device, *obj, layout);
+
+    for (auto obj : layout.OtherObjects)
+        writeRenumberedObject(device, *obj, layout);
+
+    // The main XRef section has the objects after the first-page section
+    size_t mainXRefOffset = device.GetPosition();
+    {
+        LinearizedXRef xref(*this, layout.References, layout.Size, 0, firstXRefOffset);
+        for (uint32_t i = 1; i < layout.LinearizationNumber; i++)
+            xref.AddInUseObject(PdfReference(i, 0), layout.Offsets[i]);
+
+        xref.Write(device, m_buffer);
+    }
+
+    size_t fileLength = device.GetPosition();
+    if (fileLength > numeric_limits<uint32_t>::max())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Linearized files can't be larger than 4 GiB");
+
+    // Overwrite the placeholders, padding the values with spaces
+    device.Seek(layout.HintOffset);
+    writeHintStream();
+    if (device.GetPosition() != layout.HintOffset + layout.HintLength)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "The hint stream size changed");
+
+    serializeFirstXRef(mainXRefOffset);
+    if (firstXRefBuffer.size() > firstXRefSize)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "The first-page XRef section size changed");
+
+    firstXRefBuffer.resize(firstXRefSize, ' ');
+    device.Seek(firstXRefOffset);
+    device.Write(firstXRefBuffer);
+
+    // /T is the offset of the end of line before the
+    // first entry of the main XRef section, see Table F.1
+    size_t mainXRefEntryOffset = mainXRefOffset
+        + utls::Format("xref\n0 {}", layout.LinearizationNumber).size();
+    serializeLinearization((int64_t)fileLength, (int64_t)firstPageEnd, (int64_t)mainXRefEntryOffset);
+    if (linearizationBuffer.size() > linearizationSize)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "The linearization dictionary size changed");
+
+    // Pad the dictionary before "endobj"
+    constexpr size_t endObjLength = 7;
+    linearizationBuffer.insert(linearizationBuffer.end() - endObjLength,
+        linearizationSize - linearizationBuffer.size(), ' ');
+    device.Seek(linearizationOffset);
+    device.Write(linearizationBuffer);
+    device.Seek(fileLength);
+}
+
+void PdfWriter::LinearizedLayout::WriteHintTables(charbuff& data, size_t& sharedTableOffset) const
+{
+    // NOTE: The lengths are written with 32 bits fields, so the
+    // size of the tables doesn't depend on the written objects
+    data.clear();
+    HintBitWriter writer(data);
+    size_t minObjectCount = numeric_limits<size_t>::max();
+    size_t maxObjectCount = 0;
+    uint64_t minPageLength = numeric_limits<uint64_t>::max();
+    size_t maxSharedCount = 0;
+    for (auto& page : Pages)
+    {
+        minObjectCount = std::min(minObjectCount, page.Objects.size());
+        maxObjectCount = std::max(maxObjectCount, page.Objects.size());
+        minPageLength = std::min(minPageLength, GetLength(*page.Objects.front(), *page.Objects.back()));
+        maxSharedCount = std::max(maxSharedCount, page.SharedIds.size());
+    }
+
+    auto& firstPage = Pages[0].Objects;
+    size_t sharedCount = firstPage.size() + SharedObjects.size();
+    unsigned objectCountBits = getBitCount(maxObjectCount - minObjectCount);
+    unsigned sharedCountBits = getBitCount(maxSharedCount);
+    unsigned sharedIdBits = getBitCount(sharedCount - 1);
+
+    // Page offset hint table header, see ISO 32000-1:2008 Table F.3.
+    // The content streams are accounted as the whole pages
+    writer.Write(minObjectCount, 32);
+    writer.Write(GetHintOffset(*firstPage[0]), 32);
+    writer.Write(objectCountBits, 16);
+    writer.Write(minPageLength, 32);
+    writer.Write(32, 16);
+    writer.Write(0, 32);
+    writer.Write(0, 16);
+    writer.Write(minPageLength, 32);
+    writer.Write(32, 16);
+    writer.Write(sharedCountBits, 16);
+    writer.Write(sharedIdBits, 16);
+    writer.Write(0, 16);
+    writer.Write(1, 16);
+
+    // Per-page entries, see Table F.4. Each item is written for all the
+    // pages in sequence. The numerators of the shared object references
+    // and the content stream offsets are written with 0 bits
+    for (auto& page : Pages)
+        writer.Write(page.Objects.size() - minObjectCount, objectCountBits);
+    writer.Flush();
+    for (auto& page : Pages)
+        writer.Write(GetLength(*page.Objects.front(), *page.Objects.back()) - minPageLength, 32);
+    writer.Flush();
+    for (auto& page : Pages)
+        writer.Write(page.SharedIds.size(), sharedCountBits);
+    writer.Flush();
+    for (auto& page : Pages)
+    {
+        for (unsigned id : page.SharedIds)
+            writer.Write(id, sharedIdBits);
+    }
+    writer.Flush();
+    for (auto& page : Pages)
+        writer.Write(GetLength(*page.Objects.front(), *page.Objects.back()) - minPageLength, 32);
+    writer.Flush();
+
+    // Shared object hint table header, see Table F.5. The entries are the
+    // objects of the first page, then the ones in the shared objects section
+    sharedTableOffset = data.size();
+    uint64_t minGroupLength = numeric_limits<uint64_t>::max();
+    for (auto obj : firstPage)
+        minGroupLength = std::min(minGroupLength, GetLength(*obj, *obj));
+    for (auto obj : SharedObjects)
+        minGroupLength = std::min(minGroupLength, GetLength(*obj, *obj));
+
+    if (SharedObjects.size() == 0)
+    {
+        writer.Write(0, 32);
+        writer.Write(0, 32);
+    }
+    else
+    {
+        writer.Write(GetNumber(*SharedObjects[0]), 32);
+        writer.Write(GetHintOffset(*SharedObjects[0]), 32);
+    }
+    writer.Write(firstPage.size(), 32);
+    writer.Write(sharedCount, 32);
+    writer.Write(0, 16);
+    writer.Write(minGroupLength, 32);
+    writer.Write(32, 16);
+
+    // Shared object group entries, see Table F.6. Every
+    // group has a single object and no MD5 signature
+    for (auto obj : firstPage)
+        writer.Write(GetLength(*obj, *obj) - minGroupLength, 32);
+    for (auto obj : SharedObjects)
+        writer.Write(GetLength(*obj, *obj) - minGroupLength, 32);
+    writer.Flush();
+    for (size_t i = 0; i < sharedCount; i++)
+        writer.Write(0, 1);
+    writer.Flush();
+}
+
+void PdfWriter::writeRenumberedObject(OutputStreamDevice& device, const PdfObject& obj, LinearizedLayout& layout)
+{
+    // Write a copy of the object data with the references replaced.
+    // References to objects that are not written are replaced with null
+    PdfObject renumbered(obj.GetVariant());
+    vector<PdfObject*> stack;
+    stack.push_back(&renumbered);
+    while (stack.size() != 0)
+    {
+        auto child = stack.back();
+        stack.pop_back();
+        switch (child->GetDataType())
+        {
+            case PdfDataType::Reference:
+            {
+                auto found = layout.References.find(child->GetReference());
+                if (found == layout.References.end())
+                    *child = PdfObject(PdfVariant::NullValue);
+                else
+                    child->SetReference(found->second);
+                break;
+            }
+            case PdfDataType::Array:
+            {
+                for (auto& item : child->GetArray())
+                    stack.push_back(&item);
+                break;
+            }
+            case PdfDataType::Dictionary:
+            {
+                for (auto& pair : child->GetDictionary())
+                    stack.push_back(&pair.second);
+                break;
+            }
+            default:
+            {
+                // Nothing to do
+                break;
+            }
+        }
+    }
+
+    auto& reference = layout.References.at(obj.GetIndirectReference());
+    layout.Offsets[reference.ObjectNumber()] = device.GetPosition();
+    // Also make sure that we do not encrypt the encryption dictionary!
+    obj.write(device, m_WriteFlags, reference, &renumbered.m_Variant,
+        &obj == m_EncryptObj ? nullptr : m_Encrypt.get(), m_buffer);
+    layout.Ends[reference.ObjectNumber()] = device.GetPosition();
+}
+
+void PdfWriter::collectPages(const PdfObject& catalog, vector<PdfObject*>& pages,
+    unordered_set<PdfReference>& nodes) const
+{
+    PdfReference ref;
+    auto pagesRoot = catalog.GetDictionary().GetKey("Pages");
+    if (pagesRoot == nullptr || !pagesRoot->TryGetReference(ref))
+        return;
+
+    vector<PdfReference> stack;
+    stack.push_back(ref);
+    while (stack.size() != 0)
+    {
+        ref = stack.back();
+        stack.pop_back();
+        const PdfDictionary* dict;
+        auto node = m_Objects->GetObject(ref);
+        if (node == nullptr || !node->TryGetDictionary(dict) || !nodes.insert(ref).second)
+            continue;
+
+        const PdfArray* kids;
+        auto kidsObj = dict->FindKey("Kids");
+        if (kidsObj == nullptr || !kidsObj->TryGetArray(kids))
+        {
+            pages.push_back(node);
+            continue;
+        }
+
+        // Push the kids in reverse order, so the pages are collected in order
+        for (auto it = kids->rbegin(); it != kids->rend(); it++)
+        {
+            if (it->TryGetReference(ref))
+                stack.push_back(ref);
+        }
+    }
+}
+
+void PdfWriter::collectPageObjects(PdfObject& page, const unordered_set<PdfReference>& stop,
+    vector<PdfObject*>& objects, vector<PdfReference>& reached) const
+{
+    unordered_set<PdfReference> visited;
+    visited.insert(page.GetIndirectReference());
+    objects.push_back(&page);
+    vector<const PdfObject*> stack;
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        stack.push_back(objects[i]);
+        while (stack.size() != 0)
+        {
+            auto child = stack.back();
+            stack.pop_back();
+            switch (child->GetDataType())
+            {
+                case PdfDataType::Reference:
+                {
+                    auto ref = child->GetReference();
+                    if (!visited.insert(ref).second)
+                        break;
+
+                    if (stop.find(ref) != stop.end())
+                    {
+                        reached.push_back(ref);
+                        break;
+                    }
+
+                    auto obj = m_Objects->GetObject(ref);
+                    if (obj != nullptr)
+                        objects.push_back(obj);
+
+                    break;
+                }
+                case PdfDataType::Array:
+                {
+                    for (auto& item : child->GetArray())
+                        stack.push_back(&item);
+                    break;
+                }
+                case PdfDataType::Dictionary:
+                {
+                    // The page tree nodes and the parent
+                    // fields are not part of the page
+                    for (auto& pair : child->GetDictionary())
+                    {
+                        if (pair.first != "Parent")
+                            stack.push_back(&pair.second);
+                    }
+                    break;
+                }
+                default:
+                {
+                    // Nothing to do
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void PdfWriter::deduplicateObjects()
+{
+    // The objects referenced by the trailer must stay distinct
+    unordered_set<PdfReference> excluded;
+    for (auto& pair : m_Trailer->GetDictionary())
+    {
+        PdfReference ref;
+        if (pair.second.TryGetReference(ref))
+            excluded.insert(ref);
+    }
+
+    charbuff buffer;
+    charbuff candidateBuffer;
+    while (true)
+    {
+        // Objects not merged so far, by hash of their data
+        unordered_map<size_t, vector<PdfObject*>> candidates;
+        unordered_map<PdfReference, PdfReference> merged;
+        for (PdfObject* obj : *m_Objects)
+        {
+            if (m_duplicates.find(obj->GetIndirectReference()) != m_duplicates.end()
+                || !canDeduplicateObject(*obj, excluded))
+            {
+                continue;
+            }
+
+            serializeObjectData(*obj, buffer);
+            auto& bucket = candidates[std::hash<string_view>()(buffer)];
+            PdfObject* found = nullptr;
+            for (auto candidate : bucket)
+            {
+                serializeObjectData(*candidate, candidateBuffer);
+                if (candidateBuffer == buffer)
+                {
+                    found = candidate;
+                    break;
+                }
+            }
+
+            if (found == nullptr)
+            {
+                bucket.push_back(obj);
+            }
+            else
+            {
+                merged[obj->GetIndirectReference()] = found->GetIndirectReference();
+                m_duplicates.insert(obj->GetIndirectReference());
+            }
+        }
+
+        if (merged.size() == 0)
+            break;
+
+        // Point the references to the kept objects
+        vector<PdfObject*> stack;
+        for (PdfObject* obj : *m_Objects)
+        {
+            if (m_duplicates.find(obj->GetIndirectReference()) != m_duplicates.end())
+                continue;
+
+            stack.push_back(obj);
+            while (stack.size() != 0)
+            {
+                auto child = stack.back();
+                stack.pop_back();
+                switch (child->GetDataType())
+                {
+                    case PdfDataType::Reference:
+                    {
+                        auto found = merged.find(child->GetReference());
+                        if (found != merged.end())
+                            child->SetReference(found->second);
+                        break;
+                    }
+                    case PdfDataType::Array:
+                    {
+                        for (auto& item : child->GetArray())
+                            stack.push_back(&item);
+                        break;
+                    }
+                    case PdfDataType::Dictionary:
+                    {
+                        for (auto& pair : child->GetDictionary())
+                            stack.push_back(&pair.second);
+                        break;
+                    }
+                    default:
+                    {
+                        // Nothing to do
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool PdfWriter::canDeduplicateObject(const PdfObject& obj, const unordered_set<PdfReference>& excluded) const
+{
+    if (&obj == m_EncryptObj || excluded.find(obj.GetIndirectReference()) != excluded.end())
+        return false;
+
+    const PdfDictionary* dict;
+    if (!obj.TryGetDictionary(dict))
+        return true;
+
+    // The nodes of the document hierarchies, e.g. pages, fields
+    // and outline items, are identified by their references
+    if (dict->HasKey("Parent") || dict->HasKey("P"))
+        return false;
+
+    auto type = dict->FindKeyAs<PdfName>(PdfName::KeyType);
+    return type != "Page" && type != "Pages" && type != "Catalog"
+        && type != "Annot" && type != "Sig" && type != "XRef" && type != "ObjStm";
+}
+
+void PdfWriter::serializeObjectData(const PdfObject& obj, charbuff& buffer)
+{
+    buffer.clear();
+    BufferStreamDevice device(buffer);
+    obj.GetVariant().Write(device, PdfWriteFlags::None, { }, m_buffer);
+    auto stream = obj.GetStream();
+    if (stream != nullptr)
+    {
+        device.Write("\nstream\n");
+        stream->CopyTo(device);
+    }
+}
+
+void PdfWriter::writeBatch(OutputStreamDevice& device, const cspan<PdfObject*>& objects, PdfXRef& xref)
+{
+    // Serialize the objects concurrently, then write them in order
+    vector<charbuff> buffers(objects.size());
+    m_Objects->GetExecutor()->ParallelFor(objects.size(), 1, 0, [&]()
+    {
+        auto buffer = std::make_shared<charbuff>();
+        return [&, buffer](size_t i)
+        {
+            BufferStreamDevice objDevice(buffers[i]);
+            objects[i]->Write(objDevice, m_WriteFlags, nullptr, *buffer);
+        };
+    });
+
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        xref.AddInUseObject(objects[i]->GetIndirectReference(), device.GetPosition());
+        device.Write(buffers[i]);
     }
 }
 
@@ -225,7 +1253,7 @@ void PdfWriter::FillTrailerObject(PdfObject& trailer, size_t size, bool onlySize
 
 void PdfWriter::CreateFileIdentifier(PdfString& identifier, const PdfObject& trailer, PdfString* originalIdentifier)
 {
-    NullStreamDevice length;
+    NullStreamDevice nullDevice;
     unique_ptr<PdfObject> info;
     bool originalIdentifierFound = false;
 
@@ -292,15 +1320,23 @@ void PdfWriter::CreateFileIdentifier(PdfString& identifier, const PdfObject& tra
     }
 
     info->GetDictionary().AddKey("Location", PdfString("SOMEFILENAME"));
-    info->Write(length, m_WriteFlags, nullptr, m_buffer);
 
-    charbuff buffer(length.GetLength());
-    StringStreamDevice device(buffer);
+    // Calculate the MD5 sum while serializing the dictionary
+    unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+    if (ctx == nullptr || EVP_DigestInit_ex(ctx.get(), EVP_md5(), nullptr) != 1)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing MD5 hashing engine");
+
+    HashingStreamDevice device(nullDevice, [&ctx](size_t, const bufferview& data) {
+        if (EVP_DigestUpdate(ctx.get(), data.data(), data.size()) != 1)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error MD5-hashing data");
+    });
     info->Write(device, m_WriteFlags, nullptr, m_buffer);
 
-    // calculate the MD5 Sum
-    identifier = PdfEncryptMD5Base::GetMD5String(reinterpret_cast<unsigned char*>(buffer.data()),
-        static_cast<unsigned>(length.GetLength()));
+    char digest[MD5_DIGEST_LENGTH];
+    if (EVP_DigestFinal_ex(ctx.get(), reinterpret_cast<unsigned char*>(digest), nullptr) != 1)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error MD5-hashing data");
+
+    identifier = PdfString::FromRaw({ digest, MD5_DIGEST_LENGTH });
 
     if (originalIdentifier != nullptr && !originalIdentifierFound)
         *originalIdentifier = identifier;
@@ -316,6 +1352,11 @@ void PdfWriter::SetEncrypted(const PdfEncrypt& encrypt)
     m_Encrypt = PdfEncrypt::CreatePdfEncrypt(encrypt);
 }
 
+void PdfWriter::SetObjectStreamSize(unsigned size)
+{
+    m_ObjectStreamSize = std::clamp(size, 1u, MaxObjectStreamSize);
+}
+
 void PdfWriter::SetUseXRefStream(bool useXRefStream)
 {
     if (useXRefStream && m_Version < PdfVersion::V1_5)
@@ -326,8 +1367,23 @@ void PdfWriter::SetUseXRefStream(bool useXRefStream)
 
 PdfWriteFlags ToWriteFlags(PdfSaveOptions opts)
 {
-    if (opts == PdfSaveOptions::Clean)
+    if ((opts & PdfSaveOptions::Clean) != PdfSaveOptions::None)
         return PdfWriteFlags::Clean;
 
+    if ((opts & PdfSaveOptions::Minimal) != PdfSaveOptions::None)
+        return PdfWriteFlags::Minimal;
+
     return PdfWriteFlags::None;
 }
+
+unsigned getBitCount(uint64_t value)
+{
+    unsigned ret = 0;
+    while (value != 0)
+    {
+        ret++;
+        value >>= 1;
+    }
+
+    return ret;
+}
@@ -63,6 +63,14 @@ public:
      */
     void SetUseXRefStream(bool useXRefStream);
 
+    /** Set the maximum count of objects packed in a single object
+     *  stream, when writing with PdfSaveOptions::CompressObjects.
+     *  The default is 100
+     */
+    void SetObjectStreamSize(unsigned size);
+
+    inline unsigned GetObjectStreamSize() const { return m_ObjectStreamSize; }
+
     /** Set the written document to be encrypted using a PdfEncrypt object
      *
      *  \param encrypt an encryption object which is used to encrypt the written PDF file
@@ -172,6 +180,94 @@ protected:
     void SetIdentifier(const PdfString& identifier) { m_identifier = identifier; }
     void SetEncryptObj(PdfObject* obj);
 
+protected:
+    /** Objects serialized to be packed in an object stream
+     */
+    struct ObjectStreamGroup
+    {
+        std::vector<PdfReference> References;
+        std::string Offsets;    // Pairs of object number and offset
+        charbuff Data;
+    };
+
+    /** \returns true if objects are packed in object streams, that is
+     *      PdfSaveOptions::CompressObjects is set and an XRef stream is used
+     */
+    bool GetCompressObjects() const;
+
+    /** \returns true if the object can be packed in an object stream
+     */
+    bool CanCompressObject(const PdfObject& obj) const;
+
+    /** Serialize the object in the group, writing the group
+     *  as an object stream when it's full. The object
+     *  can be removed from memory after the call
+     */
+    void CompressObject(OutputStreamDevice& device, PdfObject& obj, ObjectStreamGroup& group, PdfXRef& xref);
+
+    /** Write the packed objects as an object stream and add them to the xref
+     */
+    void WriteObjectStream(OutputStreamDevice& device, ObjectStreamGroup& group, PdfXRef& xref);
+
+private:
+    /** Objects of a linearized file in the order they are
+     *  written, with their new numbers and written offsets
+     */
+    struct LinearizedLayout;
+
+    /** Order the objects for a linearized file and renumber them,
+     *  see ISO 32000-1:2008 Annex F "Linearized PDF"
+     *  \returns false if the document has no pages to linearize
+     */
+    bool planLinearization(LinearizedLayout& layout);
+
+    /** Write the linearized file. The linearization dictionary,
+     *  the first-page XRef section and the hint stream are written
+     *  with placeholder values, which are overwritten at the end
+     */
+    void writeLinearized(OutputStreamDevice& device, LinearizedLayout& layout);
+
+    /** Write the object with its new number, replacing
+     *  the references to the renumbered objects
+     */
+    void writeRenumberedObject(OutputStreamDevice& device, const PdfObject& obj, LinearizedLayout& layout);
+
+    /** Collect the pages in document order, adding them
+     *  and the page tree nodes to the set of nodes
+     */
+    void collectPages(const PdfObject& catalog, std::vector<PdfObject*>& pages,
+        std::unordered_set<PdfReference>& nodes) const;
+
+    /** Collect the page and the objects reachable from it, not following the
+     *  /Parent keys. The objects in the stop set are not visited and
+     *  they are collected in the list of reached objects
+     */
+    void collectPageObjects(PdfObject& page, const std::unordered_set<PdfReference>& stop,
+        std::vector<PdfObject*>& objects, std::vector<PdfReference>& reached) const;
+
+    /** Serialize the objects on multiple threads, then
+     *  write them in order adding them to the xref
+     */
+    void writeBatch(OutputStreamDevice& device, const cspan<PdfObject*>& objects, PdfXRef& xref);
+
+    /** Find the objects identical to a previous one in the list and
+     *  point the references to the latter. Merging objects can make their
+     *  referrers identical, so the list is visited until no object is merged.
+     *  The merged objects are kept in the list, they are skipped
+     *  when writing, as the document may still refer to them
+     */
+    void deduplicateObjects();
+
+    /** \returns false if the object must stay distinct even if it's
+     *      identical to another one, e.g. pages and annotations
+     */
+    bool canDeduplicateObject(const PdfObject& obj, const std::unordered_set<PdfReference>& excluded) const;
+
+    /** Serialize the object data, and its raw stream if
+     *  any, to compare it with the other objects
+     */
+    void serializeObjectData(const PdfObject& obj, charbuff& buffer);
+
 protected:
     charbuff m_buffer;
 
@@ -188,12 +284,14 @@ private:
 
     PdfSaveOptions m_SaveOptions;
     PdfWriteFlags m_WriteFlags;
+    unsigned m_ObjectStreamSize;
 
     PdfString m_identifier;
     PdfString m_originalIdentifier; // used for incremental update
     int64_t m_PrevXRefOffset;
     bool m_IncrementalUpdate;
     bool m_rewriteXRefTable; // Only used if incremental update
+    std::unordered_set<PdfReference> m_duplicates; // Merged objects that are not written
 };
 
 };
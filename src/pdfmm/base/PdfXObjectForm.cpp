@@ -11,6 +11,7 @@
 #include "PdfDictionary.h"
 #include "PdfDocument.h"
 #include "PdfPage.h"
+#include "PdfPainter.h"
 
 using namespace std;
 using namespace mm;
@@ -81,6 +82,18 @@ void PdfXObjectForm::SetRect(const PdfRect& rect)
     m_Rect = rect;
 }
 
+void PdfXObjectForm::StampOn(PdfCanvas& canvas, double x, double y)
+{
+    if (&canvas == static_cast<PdfCanvas*>(this))
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "An XObject can't be drawn on itself");
+
+    EnsureResourcesCreated();
+    PdfPainter painter;
+    painter.SetCanvas(&canvas);
+    painter.DrawXObject(*this, x, y);
+    painter.FinishDrawing();
+}
+
 PdfResources* PdfXObjectForm::getResources() const
 {
     return m_Resources.get();
@@ -119,12 +132,8 @@ void PdfXObjectForm::initXObject(const PdfRect& rect)
     if (m_Matrix.IsEmpty())
     {
         // This matrix is the same for all PdfXObjects so cache it
-        m_Matrix.Add(PdfObject(static_cast<int64_t>(1)));
-        m_Matrix.Add(PdfObject(static_cast<int64_t>(0)));
-        m_Matrix.Add(PdfObject(static_cast<int64_t>(0)));
-        m_Matrix.Add(PdfObject(static_cast<int64_t>(1)));
-        m_Matrix.Add(PdfObject(static_cast<int64_t>(0)));
-        m_Matrix.Add(PdfObject(static_cast<int64_t>(0)));
+        const int64_t identity[6] = { 1, 0, 0, 1, 0, 0 };
+        m_Matrix.AddNumbers(identity);
     }
 
     PdfArray bbox;
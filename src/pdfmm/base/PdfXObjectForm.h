@@ -68,6 +68,17 @@ public:
      */
     void SetRect(const PdfRect& rect);
 
+    /** Draw this XObject on a canvas, e.g. to repeat the same header
+     *  or footer on many pages. The content is written only once in
+     *  the document, and the canvas just references this XObject in
+     *  its resources. Record the content first, drawing on this
+     *  XObject with a PdfPainter
+     *  \param canvas the canvas to draw on, e.g. a PdfPage
+     *  \param x the x coordinate of the origin of this XObject on the canvas
+     *  \param y the y coordinate of the origin of this XObject on the canvas
+     */
+    void StampOn(PdfCanvas& canvas, double x = 0, double y = 0);
+
 public:
     inline PdfResources* GetResources() { return m_Resources.get(); }
     inline const PdfResources* GetResources() const { return m_Resources.get(); }
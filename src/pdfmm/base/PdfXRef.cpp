@@ -20,8 +20,10 @@
 using namespace std;
 using namespace mm;
 
+static void writePaddedNumber(char* dst, unsigned width, uint64_t value);
+
 PdfXRef::PdfXRef(PdfWriter& writer)
-    : m_maxObjCount(0), m_writer(&writer), m_offset(0)
+    : m_maxObjCount(0), m_hasFirstEmptyBlock(false), m_writer(&writer), m_offset(0)
 {
 
 }
@@ -30,181 +32,162 @@ PdfXRef::~PdfXRef() { }
 
 void PdfXRef::AddInUseObject(const PdfReference& ref, nullable<uint64_t> offset)
 {
-    addObject(ref, offset, true);
+    if (offset == nullptr)
+    {
+        // Objects with no offset provided will not be written
+        // in the entry list
+        if (ref.ObjectNumber() > m_maxObjCount)
+            m_maxObjCount = ref.ObjectNumber();
+
+        return;
+    }
+
+    addObject(XRefItem(ref, offset.value()));
 }
 
 void PdfXRef::AddFreeObject(const PdfReference& ref)
 {
-    addObject(ref, nullptr, false);
+    addObject(XRefItem(ref));
 }
 
-void PdfXRef::addObject(const PdfReference& ref, nullable<uint64_t> offset, bool inUse)
+void PdfXRef::AddCompressedObject(const PdfReference& ref, uint32_t streamObjNum, unsigned index)
 {
-    if (ref.ObjectNumber() > m_maxObjCount)
-        m_maxObjCount = ref.ObjectNumber();
-
-    if (inUse && offset == nullptr)
-    {
-        // Objects with no offset provided will not be written
-        // in the entry list
-        return;
-    }
-
-    bool insertDone = false;
+    addObject(XRefItem(ref, streamObjNum, index));
+}
 
-    for (auto& block : m_blocks)
-    {
-        if (block.InsertItem(ref, offset, inUse))
-        {
-            insertDone = true;
-            break;
-        }
-    }
+void PdfXRef::addObject(const XRefItem& item)
+{
+    if (item.Reference.ObjectNumber() > m_maxObjCount)
+        m_maxObjCount = item.Reference.ObjectNumber();
 
-    if (!insertDone)
-    {
-        PdfXRefBlock block;
-        block.First = ref.ObjectNumber();
-        block.Count = 1;
-        if (inUse)
-            block.Items.push_back(XRefItem(ref, offset.value()));
-        else
-            block.FreeItems.push_back(ref);
-
-        m_blocks.push_back(block);
-        std::sort(m_blocks.begin(), m_blocks.end());
-    }
+    m_items.push_back(item);
 }
 
 void PdfXRef::Write(OutputStreamDevice& device, charbuff& buffer)
 {
-    auto it = m_blocks.begin();
-    XRefItemList::const_iterator itItems;
-    ReferenceList::const_iterator itFree;
-    const PdfReference* nextFree = nullptr;
+    // Stop in case we have no entries at all
+    if (m_items.size() == 0 && !m_hasFirstEmptyBlock)
+        PDFMM_RAISE_ERROR(PdfErrorCode::NoXRef);
+
+    sortItems();
 
-    uint32_t first = 0;
-    uint32_t count = 0;
+    // The free entries form a linked list, each pointing to the
+    // object number of the next one, from the entry of object 0
+    auto findNextFree = [&](size_t index) {
+        for (; index < m_items.size(); index++)
+        {
+            if (m_items[index].Type == XRefEntryType::Free)
+                break;
+        }
 
-    mergeBlocks();
+        return index;
+    };
+    auto getFreeNumber = [&](size_t index) -> uint32_t {
+        return index == m_items.size() ? 0 : m_items[index].Reference.ObjectNumber();
+    };
 
     m_offset = device.GetPosition();
     this->BeginWrite(device, buffer);
-    while (it != m_blocks.end())
-    {
-        auto& block = *it;
-        count = block.Count;
-        first = block.First;
-        itFree = block.FreeItems.begin();
-        itItems = block.Items.begin();
 
-        if (first == 1)
+    // The subsection of the first object is extended to the
+    // object 0, which is written with the bogus free entry
+    bool writeFirstEntry = m_hasFirstEmptyBlock
+        || (m_items.size() != 0 && m_items[0].Reference.ObjectNumber() == 1);
+    size_t nextFree = findNextFree(0);
+    size_t i = 0;
+    while (writeFirstEntry || i < m_items.size())
+    {
+        uint32_t first = writeFirstEntry ? 0 : m_items[i].Reference.ObjectNumber();
+        uint32_t next = writeFirstEntry ? 1 : first;
+        size_t end = i;
+        while (end < m_items.size() && m_items[end].Reference.ObjectNumber() == next)
         {
-            first--;
-            count++;
+            end++;
+            next++;
         }
 
-        // when there is only one, then we need to start with 0 and the bogus object...
-        this->WriteSubSection(device, first, count, buffer);
-
-        if (first == 0)
+        this->WriteSubSection(device, first, next - first, buffer);
+        if (writeFirstEntry)
         {
-            const PdfReference* firstFree = getFirstFreeObject(it, itFree);
             this->WriteXRefEntry(device, PdfReference(0, EMPTY_OBJECT_GENERATION),
-                PdfXRefEntry::CreateFree(firstFree == nullptr ? 0 : firstFree->ObjectNumber(), EMPTY_OBJECT_GENERATION),
-                buffer);
+                PdfXRefEntry::CreateFree(getFreeNumber(nextFree), EMPTY_OBJECT_GENERATION), buffer);
+            writeFirstEntry = false;
         }
 
-        while (itItems != block.Items.end())
+        for (; i < end; i++)
         {
-            // check if there is a free object at the current position
-            while (itFree != block.FreeItems.end() &&
-                *itFree < itItems->Reference)
+            auto& item = m_items[i];
+            switch (item.Type)
             {
-                uint16_t genNo = itFree->GenerationNumber();
-
-                // get a pointer to the next free object
-                nextFree = this->getNextFreeObject(it, itFree);
-
-                // write free object
-                this->WriteXRefEntry(device, *itFree,
-                    PdfXRefEntry::CreateFree(nextFree == nullptr ? 0 : nextFree->ObjectNumber(), genNo), buffer);
-                itFree++;
+                case XRefEntryType::Free:
+                {
+                    nextFree = findNextFree(i + 1);
+                    this->WriteXRefEntry(device, item.Reference,
+                        PdfXRefEntry::CreateFree(getFreeNumber(nextFree), item.Reference.GenerationNumber()), buffer);
+                    break;
+                }
+                case XRefEntryType::Compressed:
+                {
+                    this->WriteXRefEntry(device, item.Reference,
+                        PdfXRefEntry::CreateCompressed((uint32_t)item.Offset, item.Index), buffer);
+                    break;
+                }
+                default:
+                {
+                    this->WriteXRefEntry(device, item.Reference,
+                        PdfXRefEntry::CreateInUse(item.Offset, item.Reference.GenerationNumber()), buffer);
+                    break;
+                }
             }
-
-            this->WriteXRefEntry(device, itItems->Reference,
-                PdfXRefEntry::CreateInUse(itItems->Offset, itItems->Reference.GenerationNumber()), buffer);
-            itItems++;
-        }
-
-        // Check if there are any free objects left!
-        while (itFree != block.FreeItems.end())
-        {
-            uint16_t genNo = itFree->GenerationNumber();
-
-            // get a pointer to the next free object
-            nextFree = this->getNextFreeObject(it, itFree);
-
-            // write free object
-            this->WriteXRefEntry(device, *itFree,
-                PdfXRefEntry::CreateFree(nextFree  == nullptr ? 0 : nextFree->ObjectNumber(), genNo), buffer);
-            itFree++;
         }
-
-        it++;
     }
 
     endWrite(device, buffer);
 }
 
-const PdfReference* PdfXRef::getFirstFreeObject(XRefBlockList::const_iterator itBlock, ReferenceList::const_iterator itFree) const
+void PdfXRef::sortItems()
 {
-    // find the next free object
-    while (itBlock != m_blocks.end())
+    auto getNumber = [](const XRefItem& item) { return item.Reference.ObjectNumber(); };
+
+    // The objects are usually added in order
+    bool sorted = true;
+    uint32_t maxNumber = 0;
+    for (size_t i = 0; i < m_items.size(); i++)
     {
-        if (itFree != itBlock->FreeItems.end())
-            break; // got a free object
+        uint32_t number = getNumber(m_items[i]);
+        if (i != 0 && number < getNumber(m_items[i - 1]))
+            sorted = false;
 
-        itBlock++;
-        if (itBlock != m_blocks.end())
-            itFree = itBlock->FreeItems.begin();
+        maxNumber = std::max(maxNumber, number);
     }
 
-    // if there is another free object, return it
-    if (itBlock != m_blocks.end() &&
-        itFree != itBlock->FreeItems.end())
+    if (!sorted)
     {
-        return &(*itFree);
-    }
-
-    return nullptr;
-}
+        // Stable LSD radix sort by object number, 8 bits per pass,
+        // stopping after the most significant byte that is used
+        XRefItemList temp;
+        temp.reserve(m_items.size());
+        for (unsigned shift = 0; shift < 32 && (maxNumber >> shift) != 0; shift += 8)
+        {
+            size_t offsets[257] = { };
+            for (auto& item : m_items)
+                offsets[((getNumber(item) >> shift) & 0xFF) + 1]++;
 
-const PdfReference* PdfXRef::getNextFreeObject(XRefBlockList::const_iterator itBlock, ReferenceList::const_iterator itFree) const
-{
-    // check if itFree points to a valid free object at the moment
-    if (itFree != itBlock->FreeItems.end())
-        itFree++; // we currently have a free object, so go to the next one
+            for (unsigned j = 1; j < 257; j++)
+                offsets[j] += offsets[j - 1];
 
-    // find the next free object
-    while (itBlock != m_blocks.end())
-    {
-        if (itFree != itBlock->FreeItems.end())
-            break; // got a free object
+            temp.resize(m_items.size(), XRefItem(PdfReference()));
+            for (auto& item : m_items)
+                temp[offsets[(getNumber(item) >> shift) & 0xFF]++] = item;
 
-        itBlock++;
-        if (itBlock != m_blocks.end())
-            itFree = itBlock->FreeItems.begin();
-    }
-
-    // if there is another free object, return it
-    if (itBlock != m_blocks.end() &&
-        itFree != itBlock->FreeItems.end())
-    {
-        return &(*itFree);
+            std::swap(m_items, temp);
+        }
     }
 
-    return nullptr;
+    // Keep the first entry added for an object number
+    m_items.erase(std::unique(m_items.begin(), m_items.end(),
+        [&](const XRefItem& lhs, const XRefItem& rhs) { return getNumber(lhs) == getNumber(rhs); }),
+        m_items.end());
 }
 
 uint32_t PdfXRef::GetSize() const
@@ -213,40 +196,6 @@ uint32_t PdfXRef::GetSize() const
     return m_maxObjCount + 1;
 }
 
-void PdfXRef::mergeBlocks()
-{
-    auto it = m_blocks.begin();
-    auto itNext = it + 1;
-
-    // Stop in case we have no blocks at all
-    if (it == m_blocks.end())
-        PDFMM_RAISE_ERROR(PdfErrorCode::NoXRef);
-
-    while (itNext != m_blocks.end())
-    {
-        auto& curr = *it;
-        auto& next = *itNext;
-        if (next.First == curr.First + curr.Count)
-        {
-            // merge the two 
-            curr.Count += next.Count;
-
-            curr.Items.reserve(curr.Items.size() + next.Items.size());
-            curr.Items.insert(curr.Items.end(), next.Items.begin(), next.Items.end());
-
-            curr.FreeItems.reserve(curr.FreeItems.size() + next.FreeItems.size());
-            curr.FreeItems.insert(curr.FreeItems.end(), next.FreeItems.begin(), next.FreeItems.end());
-
-            itNext = m_blocks.erase(itNext);
-            it = itNext - 1;
-        }
-        else
-        {
-            it = itNext++;
-        }
-    }
-}
-
 void PdfXRef::BeginWrite(OutputStreamDevice& device, charbuff& buffer)
 {
     (void)buffer;
@@ -258,7 +207,11 @@ void PdfXRef::WriteSubSection(OutputStreamDevice& device, uint32_t first, uint32
 #ifndef VERBOSE_DEBUG_DISABLED
     mm::LogMessage(PdfLogSeverity::Debug, "Writing XRef section: {} {}", first, count);
 #endif // DEBUG
-    utls::FormatTo(buffer, "{} {}\n", first, count);
+    buffer.clear();
+    utls::AppendNumberTo(buffer, first);
+    buffer.push_back(' ');
+    utls::AppendNumberTo(buffer, count);
+    buffer.push_back('\n');
     device.Write(buffer);
 }
 
@@ -282,7 +235,18 @@ void PdfXRef::WriteXRefEntry(OutputStreamDevice& device, const PdfReference& ref
             PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
     }
 
-    utls::FormatTo(buffer, "{:010d} {:05d} {} \n", variant, entry.Generation, XRefEntryTypeToChar(entry.Type));
+    if (variant > 9999999999)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "XRef entry offset {} doesn't fit 10 digits", variant);
+
+    // Write the fixed size entry "nnnnnnnnnn ggggg n \n" directly
+    buffer.resize(20);
+    writePaddedNumber(buffer.data(), 10, variant);
+    buffer[10] = ' ';
+    writePaddedNumber(buffer.data() + 11, 5, entry.Generation);
+    buffer[16] = ' ';
+    buffer[17] = XRefEntryTypeToChar(entry.Type);
+    buffer[18] = ' ';
+    buffer[19] = '\n';
     device.Write(buffer);
 }
 
@@ -308,10 +272,7 @@ void PdfXRef::endWrite(OutputStreamDevice& device, charbuff& buffer)
 
 void PdfXRef::SetFirstEmptyBlock()
 {
-    PdfXRefBlock block;
-    block.First = 0;
-    block.Count = 1;
-    m_blocks.insert(m_blocks.begin(), block);
+    m_hasFirstEmptyBlock = true;
 }
 
 bool PdfXRef::ShouldSkipWrite(const PdfReference& ref)
@@ -321,54 +282,11 @@ bool PdfXRef::ShouldSkipWrite(const PdfReference& ref)
     return false;
 }
 
-bool PdfXRef::PdfXRefBlock::InsertItem(const PdfReference& ref, nullable<uint64_t> offset, bool inUse)
+void writePaddedNumber(char* dst, unsigned width, uint64_t value)
 {
-    PDFMM_ASSERT(!inUse || offset.has_value());
-    if (ref.ObjectNumber() == First + Count)
-    {
-        // Insert at back
-        Count++;
-
-        if (inUse)
-            Items.push_back(XRefItem(ref, offset.value()));
-        else
-            FreeItems.push_back(ref);
-
-        return true; // no sorting required
-    }
-    else if (ref.ObjectNumber() == First - 1)
-    {
-        // Insert at front 
-        First--;
-        Count++;
-
-        // This is known to be slow, but should not occur actually
-        if (inUse)
-            Items.insert(Items.begin(), XRefItem(ref, offset.value()));
-        else
-            FreeItems.insert(FreeItems.begin(), ref);
-
-        return true; // no sorting required
-    }
-    else if (ref.ObjectNumber() > First - 1 &&
-        ref.ObjectNumber() < First + Count)
+    for (unsigned i = width; i != 0; i--)
     {
-        // Insert at back
-        Count++;
-
-        if (inUse)
-        {
-            Items.push_back(XRefItem(ref, offset.value()));
-            std::sort(Items.begin(), Items.end());
-        }
-        else
-        {
-            FreeItems.push_back(ref);
-            std::sort(FreeItems.begin(), FreeItems.end());
-        }
-
-        return true;
+        dst[i - 1] = (char)('0' + value % 10);
+        value /= 10;
     }
-
-    return false;
 }
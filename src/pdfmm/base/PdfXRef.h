@@ -28,44 +28,22 @@ class PdfXRef
 protected:
     struct XRefItem
     {
+        XRefItem(const PdfReference& ref)
+            : Reference(ref), Offset(0), Index(0), Type(XRefEntryType::Free) { }
+
         XRefItem(const PdfReference& ref, uint64_t off)
-            : Reference(ref), Offset(off) { }
+            : Reference(ref), Offset(off), Index(0), Type(XRefEntryType::InUse) { }
 
-        PdfReference Reference;
-        uint64_t Offset;
+        XRefItem(const PdfReference& ref, uint32_t streamObjNum, unsigned index)
+            : Reference(ref), Offset(streamObjNum), Index(index), Type(XRefEntryType::Compressed) { }
 
-        bool operator<(const XRefItem& rhs) const
-        {
-            return this->Reference < rhs.Reference;
-        }
+        PdfReference Reference;
+        uint64_t Offset;    // The number of the object stream for compressed objects
+        unsigned Index;     // The index in the object stream for compressed objects
+        XRefEntryType Type;
     };
 
     using XRefItemList = std::vector<XRefItem>;
-    using ReferenceList = std::vector<PdfReference>;
-
-    struct PdfXRefBlock
-    {
-        PdfXRefBlock()
-            : First(0), Count(0) { }
-
-        PdfXRefBlock(const PdfXRefBlock& rhs) = default;
-
-        bool InsertItem(const PdfReference& ref, nullable<uint64_t> offset, bool bUsed);
-
-        bool operator<(const PdfXRefBlock& rhs) const
-        {
-            return First < rhs.First;
-        }
-
-        PdfXRefBlock& operator=(const PdfXRefBlock& rhs) = default;
-
-        uint32_t First;
-        uint32_t Count;
-        XRefItemList Items;
-        ReferenceList FreeItems;
-    };
-
-    using XRefBlockList = std::vector<PdfXRefBlock>;
 
 public:
     PdfXRef(PdfWriter& pWriter);
@@ -93,6 +71,15 @@ public:
      */
     void AddFreeObject(const PdfReference& ref);
 
+    /** Add an object written in an object stream to the XRef table.
+     *  Only XRef streams can have such entries
+     *
+     *  \param ref reference of this object
+     *  \param streamObjNum the object number of the object stream
+     *  \param index the index of the object in the object stream
+     */
+    void AddCompressedObject(const PdfReference& ref, uint32_t streamObjNum, unsigned index);
+
     /** Write the XRef table to an output device.
      *
      *  \param device an output device (usually a PDF file)
@@ -163,7 +150,7 @@ protected:
     virtual void EndWriteImpl(OutputStreamDevice& device, charbuff& buffer);
 
 private:
-    void addObject(const PdfReference& ref, nullable<uint64_t> offset, bool inUse);
+    void addObject(const XRefItem& item);
 
     /** Called at the end of writing the XRef table.
      *  Sub classes can overload this method to finish a XRef table.
@@ -173,20 +160,18 @@ private:
      */
     void endWrite(OutputStreamDevice& device, charbuff& buffer);
 
-    const PdfReference* getFirstFreeObject(XRefBlockList::const_iterator itBlock, ReferenceList::const_iterator itFree) const;
-    const PdfReference* getNextFreeObject(XRefBlockList::const_iterator itBlock, ReferenceList::const_iterator itFree) const;
-
-    /** Merge all xref blocks that follow immediately after each other
-     *  into a single block.
-     *
-     *  This results in slightly smaller PDF files which are easier to parse
-     *  for other applications.
+    /** Sort the items by object number, with a radix sort if they
+     *  were not added in order, and remove the duplicated ones
      */
-    void mergeBlocks();
+    void sortItems();
 
 private:
     uint32_t m_maxObjCount;
-    XRefBlockList m_blocks;
+    // The entries of all the objects, in a single list that is
+    // sorted once when writing, so the subsections are contiguous
+    // runs of object numbers that are emitted in a linear pass
+    XRefItemList m_items;
+    bool m_hasFirstEmptyBlock;
     PdfWriter* m_writer;
     uint64_t m_offset;
 };
@@ -14,8 +14,12 @@
 #include "PdfWriter.h"
 #include "PdfDictionary.h"
 
+using namespace std;
 using namespace mm;
 
+static unsigned getByteWidth(uint64_t value);
+static void writeBigEndian(char*& cursor, uint64_t value, unsigned width);
+
 PdfXRefStream::PdfXRefStream(PdfWriter& writer) :
     PdfXRef(writer),
     m_xrefStreamEntryIndex(-1),
@@ -70,41 +74,123 @@ void PdfXRefStream::WriteXRefEntry(OutputStreamDevice& device, const PdfReferenc
     switch (entry.Type)
     {
         case XRefEntryType::Free:
-            stmEntry.Variant = AS_BIG_ENDIAN(static_cast<uint32_t>(entry.ObjectNumber));
+            stmEntry.Variant = entry.ObjectNumber;
+            stmEntry.Generation = entry.Generation;
             break;
         case XRefEntryType::InUse:
-            stmEntry.Variant = AS_BIG_ENDIAN(static_cast<uint32_t>(entry.Offset));
+            stmEntry.Variant = entry.Offset;
+            stmEntry.Generation = entry.Generation;
+            break;
+        case XRefEntryType::Compressed:
+            // The object number of the object stream and the index in it
+            stmEntry.Variant = entry.ObjectNumber;
+            stmEntry.Generation = entry.Index;
             break;
         default:
             PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
     }
 
-    stmEntry.Generation = AS_BIG_ENDIAN(static_cast<uint16_t>(entry.Generation));
     m_rawEntries.push_back(stmEntry);
 }
 
 void PdfXRefStream::EndWriteImpl(OutputStreamDevice& device, charbuff& buffer)
 {
-    PdfArray wArr;
-    wArr.Add(static_cast<int64_t>(sizeof(XRefStreamEntry::Type)));
-    wArr.Add(static_cast<int64_t>(sizeof(XRefStreamEntry::Variant)));
-    wArr.Add(static_cast<int64_t>(sizeof(XRefStreamEntry::Generation)));
- 
-    m_xrefStreamObj->GetDictionary().AddKey("Index", m_indices);
-    m_xrefStreamObj->GetDictionary().AddKey("W", wArr);
- 
     // Set the actual offset of the XRefStm object
-    uint32_t offset = (uint32_t)device.GetPosition();
+    uint64_t offset = device.GetPosition();
     PDFMM_ASSERT(m_xrefStreamEntryIndex >= 0);
-    m_rawEntries[m_xrefStreamEntryIndex].Variant = AS_BIG_ENDIAN(offset);
- 
+    m_rawEntries[m_xrefStreamEntryIndex].Variant = offset;
+
+    // Compute the smallest /W widths that fit the actual values
+    uint64_t maxVariant = 0;
+    uint32_t maxGeneration = 0;
+    for (auto& entry : m_rawEntries)
+    {
+        maxVariant = std::max(maxVariant, entry.Variant);
+        maxGeneration = std::max(maxGeneration, entry.Generation);
+    }
+
+    unsigned wArray[3] = { 1, std::max(getByteWidth(maxVariant), 1u), getByteWidth(maxGeneration) };
+    PdfArray wArr;
+    for (unsigned i = 0; i < 3; i++)
+        wArr.Add(static_cast<int64_t>(wArray[i]));
+
+    auto& dict = m_xrefStreamObj->GetDictionary();
+    dict.AddKey("Index", m_indices);
+    dict.AddKey("W", wArr);
+
     // Write the actual entries data to the XRefStm object stream
-    auto& stream = m_xrefStreamObj->GetOrCreateStream();
-    stream.BeginAppend();
-    stream.AppendBuffer((const char*)m_rawEntries.data(), m_rawEntries.size() * sizeof(XRefStreamEntry));
-    stream.EndAppend();
+    writeEntries(m_xrefStreamObj->GetOrCreateStream(), wArray);
     GetWriter().FillTrailerObject(*m_xrefStreamObj, this->GetSize(), false);
 
     m_xrefStreamObj->Write(device, GetWriter().GetWriteFlags(), nullptr, buffer); // CHECK-ME: Requires encryption info??
-    m_offset = offset;
+    m_offset = (int64_t)offset;
+}
+
+void PdfXRefStream::writeEntries(PdfObjectStream& stream, const unsigned wArray[3])
+{
+    unsigned rowSize = wArray[0] + wArray[1] + wArray[2];
+    bool usePredictor = PdfObjectStream::DefaultFilter == PdfFilterType::FlateDecode;
+    auto& dict = m_xrefStreamObj->GetDictionary();
+
+    // Rows of consecutive entries differ mostly in the low bytes of
+    // the offset: with the PNG Up predictor each row is stored as the
+    // difference with the previous one, which Flate compresses better
+    charbuff data;
+    data.resize(m_rawEntries.size() * (rowSize + (usePredictor ? 1 : 0)));
+    charbuff prevRow(rowSize);
+    charbuff row(rowSize);
+    char* cursor = data.data();
+    for (auto& entry : m_rawEntries)
+    {
+        char* rowCursor = row.data();
+        writeBigEndian(rowCursor, entry.Type, wArray[0]);
+        writeBigEndian(rowCursor, entry.Variant, wArray[1]);
+        writeBigEndian(rowCursor, entry.Generation, wArray[2]);
+        if (usePredictor)
+        {
+            *cursor++ = 2; // PNG Up
+            for (unsigned i = 0; i < rowSize; i++)
+                cursor[i] = (char)((unsigned char)row[i] - (unsigned char)prevRow[i]);
+
+            std::swap(row, prevRow);
+        }
+        else
+        {
+            std::memcpy(cursor, row.data(), rowSize);
+        }
+
+        cursor += rowSize;
+    }
+
+    if (usePredictor)
+    {
+        PdfDictionary decodeParms;
+        decodeParms.AddKey("Predictor", static_cast<int64_t>(12));
+        decodeParms.AddKey("Columns", static_cast<int64_t>(rowSize));
+        dict.AddKey("DecodeParms", decodeParms);
+        stream.Set(data.data(), data.size(), { PdfFilterType::FlateDecode });
+    }
+    else
+    {
+        dict.RemoveKey("DecodeParms");
+        stream.Set(data.data(), data.size());
+    }
+}
+
+unsigned getByteWidth(uint64_t value)
+{
+    unsigned ret = 0;
+    while (value != 0)
+    {
+        ret++;
+        value >>= 8;
+    }
+
+    return ret;
+}
+
+void writeBigEndian(char*& cursor, uint64_t value, unsigned width)
+{
+    for (unsigned i = width; i > 0; i--)
+        *cursor++ = (char)((value >> ((i - 1) * 8)) & 0xFF);
 }
@@ -17,6 +17,7 @@
 namespace mm {
 
 class PdfIndirectObjectList;
+class PdfObjectStream;
 
 /**
  * Creates an XRef table that is a stream object.
@@ -50,15 +51,17 @@ protected:
     void EndWriteImpl(OutputStreamDevice& device, charbuff& buffer) override;
 
 private:
-#pragma pack(push, 1)
-    // TODO: Handle for different byte size for object number/offset/generation
+    // The entry fields, stored unpacked; the /W widths are
+    // computed only when writing, from the maximum values
     struct XRefStreamEntry
     {
         uint8_t Type;
-        uint32_t Variant; // Can be an object number or an offset
-        uint16_t Generation;
+        uint64_t Variant; // Can be an object number or an offset
+        uint32_t Generation; // Generation or index in the object stream
     };
-#pragma pack(pop)
+
+private:
+    void writeEntries(PdfObjectStream& stream, const unsigned wArray[3]);
 
 private:
     std::vector<XRefStreamEntry> m_rawEntries;
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <string>
+#include <memory>
 #include "span.h"
 
 namespace COMMON_NAMESPACE
@@ -134,6 +135,8 @@ namespace COMMON_NAMESPACE
     /** A const data provider that can hold a view to a
      * static segments or a shared buffer
      *
+     * The view can also be kept alive by any shared owner,
+     * such as a memory mapped file
      */
     template <typename = void>
     class datahandle_t final
@@ -143,12 +146,14 @@ namespace COMMON_NAMESPACE
         datahandle_t(const bufferview& view)
             : m_view(view) { }
         datahandle_t(const charbuff_t<>::const_ptr& buff)
-            : m_view(*buff), m_buff(buff) { }
+            : m_view(*buff), m_owner(buff) { }
+        datahandle_t(const bufferview& view, const std::shared_ptr<const void>& owner)
+            : m_view(view), m_owner(owner) { }
     public:
         const bufferview& view() const { return m_view; }
     private:
         bufferview m_view;
-        charbuff_t<>::const_ptr m_buff;
+        std::shared_ptr<const void> m_owner;
     };
 
     using datahandle = datahandle_t<>;
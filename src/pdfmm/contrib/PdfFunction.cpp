@@ -12,8 +12,12 @@
 #include <pdfmm/base/PdfDictionary.h>
 #include <pdfmm/base/PdfObjectStream.h>
 
+using namespace std;
 using namespace mm;
 
+static PdfArray getUnitDomain();
+static unsigned getStopComponents(const PdfColor& color, float* components);
+
 PdfFunction::PdfFunction(PdfDocument& doc, PdfFunctionType functionType, const PdfArray& domain)
     : PdfDictionaryElement(doc)
 {
@@ -52,6 +56,92 @@ void PdfSampledFunction::Init(const PdfArray& domain, const PdfArray& range, con
     this->GetObject().GetOrCreateStream().EndAppend();
 }
 
+PdfSampledFunction::PdfSampledFunction(PdfDocument& doc, const cspan<PdfGradientStop>& stops, unsigned sampleCount)
+    : PdfFunction(doc, PdfFunctionType::Sampled, getUnitDomain())
+{
+    Init(stops, sampleCount);
+}
+
+void PdfSampledFunction::Init(const cspan<PdfGradientStop>& stops, unsigned sampleCount)
+{
+    if (stops.size() < 2)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "A gradient needs at least two stops");
+
+    if (sampleCount < 2)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "A sampled function needs at least two samples");
+
+    PdfColorSpace colorSpace = stops[0].Color.GetColorSpace();
+    unsigned componentCount = 0;
+    vector<float> components(stops.size() * 4);
+    for (size_t i = 0; i < stops.size(); i++)
+    {
+        if (stops[i].Color.GetColorSpace() != colorSpace)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "The colors of the gradient stops don't have the same color space");
+
+        if (stops[i].Offset < 0 || stops[i].Offset > 1 || (i != 0 && stops[i].Offset < stops[i - 1].Offset))
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The gradient stops must be sorted by offset, between 0 and 1");
+
+        componentCount = getStopComponents(stops[i].Color, components.data() + i * 4);
+    }
+
+    // The samples are encoded with 8 bits over the range of the components
+    float minimums[4];
+    float scales[4];
+    PdfArray range;
+    for (unsigned i = 0; i < componentCount; i++)
+    {
+        double min = 0;
+        double max = 1;
+        if (colorSpace == PdfColorSpace::Lab)
+        {
+            min = i == 0 ? 0 : -128;
+            max = i == 0 ? 100 : 127;
+        }
+
+        range.Add(min);
+        range.Add(max);
+        minimums[i] = (float)min;
+        scales[i] = (float)(255 / (max - min));
+    }
+
+    charbuff samples(sampleCount * componentCount);
+    size_t stopIndex = 0;
+    for (unsigned i = 0; i < sampleCount; i++)
+    {
+        double position = (double)i / (sampleCount - 1);
+        while (stopIndex + 2 < stops.size() && position > stops[stopIndex + 1].Offset)
+            stopIndex++;
+
+        double start = stops[stopIndex].Offset;
+        double end = stops[stopIndex + 1].Offset;
+        float weight;
+        if (position <= start)
+            weight = 0;
+        else if (position >= end)
+            weight = 1;
+        else
+            weight = (float)((position - start) / (end - start));
+
+        const float* startComponents = components.data() + stopIndex * 4;
+        const float* endComponents = startComponents + 4;
+        for (unsigned j = 0; j < componentCount; j++)
+        {
+            float value = startComponents[j] + (endComponents[j] - startComponents[j]) * weight;
+            float encoded = (value - minimums[j]) * scales[j] + 0.5f;
+            samples[i * componentCount + j] = (char)(uint8_t)std::clamp(encoded, 0.0f, 255.0f);
+        }
+    }
+
+    PdfArray size;
+    size.Add(static_cast<int64_t>(sampleCount));
+
+    this->GetObject().GetDictionary().AddKey("Range", range);
+    this->GetObject().GetDictionary().AddKey("Size", size);
+    this->GetObject().GetDictionary().AddKey("Order", static_cast<int64_t>(1));
+    this->GetObject().GetDictionary().AddKey("BitsPerSample", static_cast<int64_t>(8));
+    this->GetObject().GetOrCreateStream().Set(samples);
+}
+
 PdfExponentialFunction::PdfExponentialFunction(PdfDocument& doc, const PdfArray& domain, const PdfArray& c0, const PdfArray& c1, double exponent)
     : PdfFunction(doc, PdfFunctionType::Exponential, domain)
 {
@@ -83,3 +173,36 @@ void PdfStitchingFunction::Init(const PdfFunction::List& functions, const PdfArr
     this->GetObject().GetDictionary().AddKey("Bounds", bounds);
     this->GetObject().GetDictionary().AddKey("Encode", encode);
 }
+
+PdfArray getUnitDomain()
+{
+    PdfArray domain;
+    domain.Add(0.0);
+    domain.Add(1.0);
+    return domain;
+}
+
+unsigned getStopComponents(const PdfColor& color, float* components)
+{
+    switch (color.GetColorSpace())
+    {
+        case PdfColorSpace::DeviceGray:
+        case PdfColorSpace::DeviceRGB:
+        case PdfColorSpace::DeviceCMYK:
+        case PdfColorSpace::Lab:
+        {
+            auto compact = color.ToCompact();
+            unsigned count = color.GetColorSpace() == PdfColorSpace::DeviceGray ? 1
+                : (color.GetColorSpace() == PdfColorSpace::DeviceCMYK ? 4 : 3);
+            std::copy(compact.Components, compact.Components + count, components);
+            return count;
+        }
+        case PdfColorSpace::Separation:
+        {
+            components[0] = (float)color.GetDensity();
+            return 1;
+        }
+        default:
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::CannotConvertColor, "Colorspace not supported in PdfSampledFunction");
+    }
+}
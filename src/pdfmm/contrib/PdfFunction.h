@@ -13,6 +13,7 @@
 #include <list>
 
 #include <pdfmm/base/PdfElement.h>
+#include <pdfmm/base/PdfColor.h>
 
 namespace mm {
 
@@ -29,6 +30,15 @@ enum class PdfFunctionType
     PostScript = 4  ///< A PostScript calculator function (Type4)
 };
 
+/**
+ * A color stop of a multi-stop gradient
+ */
+struct PDFMM_API PdfGradientStop
+{
+    double Offset;   ///< The position of the stop, between 0 and 1
+    PdfColor Color;  ///< The color at the position
+};
+
 /**
  * This class defines a PdfFunction.
  * A function can be used in various ways in a PDF file.
@@ -83,11 +93,29 @@ public:
      */
     PdfSampledFunction(PdfDocument& doc, const PdfArray& domain, const PdfArray& range, const PdfFunction::Sample& samples);
 
+    /** Create a new PdfSampledFunction object with a single input in
+     *  the [0 1] domain, which interpolates linearly between the colors
+     *  of a multi-stop gradient
+     *
+     *  The lookup table is computed in a single pass over the stops,
+     *  so the cost doesn't depend on the number of stops
+     *
+     *  \param doc parent document
+     *  \param stops the stops of the gradient, sorted by offset. All the
+     *                colors must have the same color space
+     *  \param sampleCount the number of entries of the lookup table
+     */
+    PdfSampledFunction(PdfDocument& doc, const cspan<PdfGradientStop>& stops, unsigned sampleCount = 256);
+
 private:
     /** Initialize this object.
      */
     void Init(const PdfArray& domain, const PdfArray& range, const PdfFunction::Sample& samples);
 
+    /** Initialize this object from the stops of a gradient
+     */
+    void Init(const cspan<PdfGradientStop>& stops, unsigned sampleCount);
+
 };
 
 /** This class is a PdfExponentialFunction.
@@ -22,6 +22,9 @@
 using namespace std;
 using namespace mm;
 
+static PdfArray getUnitDomain();
+static PdfObject getColorSpaceObject(PdfDocument& doc, const PdfColor& color);
+
 PdfShadingPattern::PdfShadingPattern(PdfDocument& doc, PdfShadingPatternType shadingType)
     : PdfDictionaryElement(doc, "Pattern")
 {
@@ -143,13 +146,27 @@ void PdfShadingPattern::Init(PdfShadingPatternType shadingType)
     }
 }
 
+void PdfShadingPattern::initFunctionShading(const PdfArray& coords, const PdfObject& colorSpace, const PdfObject& function)
+{
+    PdfArray extend;
+    extend.Add(true);
+    extend.Add(true);
+
+    PdfDictionary& shading = this->GetObject().GetDictionary().MustFindKey("Shading").GetDictionary();
+    shading.AddKey("ColorSpace", colorSpace);
+    shading.AddKey("Coords", coords);
+    shading.AddKey("Function", function.GetIndirectReference());
+    shading.AddKey("Extend", extend);
+}
+
 PdfAxialShadingPattern::PdfAxialShadingPattern(PdfDocument& doc, double x0, double y0, double x1, double y1, const PdfColor& start, const PdfColor& end)
     : PdfShadingPattern(doc, PdfShadingPatternType::Axial)
 {
     Init(x0, y0, x1, y1, start, end);
 }
 
-void PdfAxialShadingPattern::Init(double x0, double y0, double x1, double y1, const PdfColor& start, const PdfColor& end)
+PdfAxialShadingPattern::PdfAxialShadingPattern(PdfDocument& doc, double x0, double y0, double x1, double y1, const cspan<PdfGradientStop>& stops)
+    : PdfShadingPattern(doc, PdfShadingPatternType::Axial)
 {
     PdfArray coords;
     coords.Add(x0);
@@ -157,62 +174,30 @@ void PdfAxialShadingPattern::Init(double x0, double y0, double x1, double y1, co
     coords.Add(x1);
     coords.Add(y1);
 
-    if (start.GetColorSpace() != end.GetColorSpace())
-        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Colorspace of start and end color in PdfAxialShadingPattern does not match");
-
-    PdfArray c0 = start.ToArray();
-    PdfArray c1 = end.ToArray();
-    PdfArray extend;
-
-    extend.Add(true);
-    extend.Add(true);
-
-    PdfArray domain;
-    domain.Add(0.0);
-    domain.Add(1.0);
-
-    PdfExponentialFunction function(*this->GetObject().GetDocument(), domain, c0, c1, 1.0);
-
-    PdfDictionary& shading = this->GetObject().GetDictionary().GetKey(PdfName("Shading"))->GetDictionary();
-
-    switch (start.GetColorSpace())
-    {
-        case PdfColorSpace::DeviceRGB:
-            shading.AddKey("ColorSpace", PdfName("DeviceRGB"));
-            break;
-
-        case PdfColorSpace::DeviceCMYK:
-            shading.AddKey("ColorSpace", PdfName("DeviceCMYK"));
-            break;
-
-        case PdfColorSpace::DeviceGray:
-            shading.AddKey("ColorSpace", PdfName("DeviceGray"));
-            break;
+    PdfSampledFunction function(doc, stops);
+    initFunctionShading(coords, getColorSpaceObject(doc, stops[0].Color), function.GetObject());
+}
 
-        case PdfColorSpace::Lab:
-        {
-            PdfObject* csp = start.BuildColorSpace(*this->GetObject().GetDocument());
-            shading.AddKey("ColorSpace", csp->GetIndirectReference());
-        }
-        break;
+PdfAxialShadingPattern::PdfAxialShadingPattern(PdfDocument& doc, const PdfArray& coords, const PdfObject& colorSpace, const PdfObject& function)
+    : PdfShadingPattern(doc, PdfShadingPatternType::Axial)
+{
+    initFunctionShading(coords, colorSpace, function);
+}
 
-        case PdfColorSpace::Separation:
-        {
-            PdfObject* csp = start.BuildColorSpace(*this->GetObject().GetDocument());
-            shading.AddKey("ColorSpace", csp->GetIndirectReference());
-        }
-        break;
+void PdfAxialShadingPattern::Init(double x0, double y0, double x1, double y1, const PdfColor& start, const PdfColor& end)
+{
+    PdfArray coords;
+    coords.Add(x0);
+    coords.Add(y0);
+    coords.Add(x1);
+    coords.Add(y1);
 
-        case PdfColorSpace::Indexed:
-        case PdfColorSpace::Unknown:
-        default:
-            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::CannotConvertColor, "Colorspace not supported in PdfAxialShadingPattern");
-            break;
-    }
+    if (start.GetColorSpace() != end.GetColorSpace())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Colorspace of start and end color in PdfAxialShadingPattern does not match");
 
-    shading.AddKey("Coords", coords);
-    shading.AddKey("Function", function.GetObject().GetIndirectReference());
-    shading.AddKey("Extend", extend);
+    auto& doc = *this->GetObject().GetDocument();
+    PdfExponentialFunction function(doc, getUnitDomain(), start.ToArray(), end.ToArray(), 1.0);
+    initFunctionShading(coords, getColorSpaceObject(doc, start), function.GetObject());
 }
 
 PdfFunctionBaseShadingPattern::PdfFunctionBaseShadingPattern(PdfDocument& doc, const PdfColor& llCol, const PdfColor& ulCol, const PdfColor& lrCol, const PdfColor& urCol, const PdfArray& matrix)
@@ -384,7 +369,8 @@ PdfRadialShadingPattern::PdfRadialShadingPattern(PdfDocument& doc, double x0, do
     Init(x0, y0, r0, x1, y1, r1, start, end);
 }
 
-void PdfRadialShadingPattern::Init(double x0, double y0, double r0, double x1, double y1, double r1, const PdfColor& start, const PdfColor& end)
+PdfRadialShadingPattern::PdfRadialShadingPattern(PdfDocument& doc, double x0, double y0, double r0, double x1, double y1, double r1, const cspan<PdfGradientStop>& stops)
+    : PdfShadingPattern(doc, PdfShadingPatternType::Radial)
 {
     PdfArray coords;
     coords.Add(x0);
@@ -394,62 +380,32 @@ void PdfRadialShadingPattern::Init(double x0, double y0, double r0, double x1, d
     coords.Add(y1);
     coords.Add(r1);
 
-    if (start.GetColorSpace() != end.GetColorSpace())
-        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Colorspace of start and end color in PdfRadialShadingPattern does not match");
-
-    PdfArray c0 = start.ToArray();
-    PdfArray c1 = end.ToArray();
-    PdfArray extend;
-
-    extend.Add(true);
-    extend.Add(true);
-
-    PdfArray domain;
-    domain.Add(0.0);
-    domain.Add(1.0);
-
-    PdfExponentialFunction function(*this->GetObject().GetDocument(), domain, c0, c1, 1.0);
-
-    PdfDictionary& shading = this->GetObject().GetDictionary().GetKey("Shading")->GetDictionary();
-
-    switch (start.GetColorSpace())
-    {
-        case PdfColorSpace::DeviceRGB:
-            shading.AddKey("ColorSpace", PdfName("DeviceRGB"));
-            break;
-
-        case PdfColorSpace::DeviceCMYK:
-            shading.AddKey("ColorSpace", PdfName("DeviceCMYK"));
-            break;
-
-        case PdfColorSpace::DeviceGray:
-            shading.AddKey("ColorSpace", PdfName("DeviceGray"));
-            break;
+    PdfSampledFunction function(doc, stops);
+    initFunctionShading(coords, getColorSpaceObject(doc, stops[0].Color), function.GetObject());
+}
 
-        case PdfColorSpace::Lab:
-        {
-            PdfObject* csp = start.BuildColorSpace(*this->GetObject().GetDocument());
-            shading.AddKey("ColorSpace", csp->GetIndirectReference());
-        }
-        break;
+PdfRadialShadingPattern::PdfRadialShadingPattern(PdfDocument& doc, const PdfArray& coords, const PdfObject& colorSpace, const PdfObject& function)
+    : PdfShadingPattern(doc, PdfShadingPatternType::Radial)
+{
+    initFunctionShading(coords, colorSpace, function);
+}
 
-        case PdfColorSpace::Separation:
-        {
-            PdfObject* csp = start.BuildColorSpace(*this->GetObject().GetDocument());
-            shading.AddKey("ColorSpace", csp->GetIndirectReference());
-        }
-        break;
+void PdfRadialShadingPattern::Init(double x0, double y0, double r0, double x1, double y1, double r1, const PdfColor& start, const PdfColor& end)
+{
+    PdfArray coords;
+    coords.Add(x0);
+    coords.Add(y0);
+    coords.Add(r0);
+    coords.Add(x1);
+    coords.Add(y1);
+    coords.Add(r1);
 
-        case PdfColorSpace::Indexed:
-        case PdfColorSpace::Unknown:
-        default:
-            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::CannotConvertColor, "Colorspace not supported in PdfRadialShadingPattern");
-            break;
-    }
+    if (start.GetColorSpace() != end.GetColorSpace())
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Colorspace of start and end color in PdfRadialShadingPattern does not match");
 
-    shading.AddKey("Coords", coords);
-    shading.AddKey("Function", function.GetObject().GetIndirectReference());
-    shading.AddKey("Extend", extend);
+    auto& doc = *this->GetObject().GetDocument();
+    PdfExponentialFunction function(doc, getUnitDomain(), start.ToArray(), end.ToArray(), 1.0);
+    initFunctionShading(coords, getColorSpaceObject(doc, start), function.GetObject());
 }
 
 PdfTriangleShadingPattern::PdfTriangleShadingPattern(PdfDocument& doc, double x0, double y0, const PdfColor& color0, double x1, double y1, const PdfColor& color1, double dX2, double dY2, const PdfColor& color2)
@@ -523,3 +479,200 @@ void PdfTriangleShadingPattern::Init(double x0, double y0, const PdfColor& color
 
     shadingObject->GetOrCreateStream().Set(buff, len);
 }
+
+PdfShadingCache::PdfShadingCache(PdfDocument& doc)
+    : m_doc(&doc) { }
+
+PdfShadingCache::~PdfShadingCache() { }
+
+PdfShadingPattern& PdfShadingCache::GetAxialShading(double x0, double y0, double x1, double y1, const PdfColor& start, const PdfColor& end)
+{
+    PdfGradientStop stops[] = { { 0, start }, { 1, end } };
+    return GetAxialShading(x0, y0, x1, y1, stops);
+}
+
+PdfShadingPattern& PdfShadingCache::GetAxialShading(double x0, double y0, double x1, double y1, const cspan<PdfGradientStop>& stops)
+{
+    PdfArray coords;
+    coords.Add(x0);
+    coords.Add(y0);
+    coords.Add(x1);
+    coords.Add(y1);
+    return getShading(PdfShadingPatternType::Axial, coords, stops);
+}
+
+PdfShadingPattern& PdfShadingCache::GetRadialShading(double x0, double y0, double r0, double x1, double y1, double r1, const PdfColor& start, const PdfColor& end)
+{
+    PdfGradientStop stops[] = { { 0, start }, { 1, end } };
+    return GetRadialShading(x0, y0, r0, x1, y1, r1, stops);
+}
+
+PdfShadingPattern& PdfShadingCache::GetRadialShading(double x0, double y0, double r0, double x1, double y1, double r1, const cspan<PdfGradientStop>& stops)
+{
+    PdfArray coords;
+    coords.Add(x0);
+    coords.Add(y0);
+    coords.Add(r0);
+    coords.Add(x1);
+    coords.Add(y1);
+    coords.Add(r1);
+    return getShading(PdfShadingPatternType::Radial, coords, stops);
+}
+
+void PdfShadingCache::Clear()
+{
+    m_shadings.clear();
+    m_functions.clear();
+    m_colorSpaces.clear();
+}
+
+PdfShadingPattern& PdfShadingCache::getShading(PdfShadingPatternType type, const PdfArray& coords, const cspan<PdfGradientStop>& stops)
+{
+    if (stops.size() < 2)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "A gradient needs at least two stops");
+
+    for (size_t i = 1; i < stops.size(); i++)
+    {
+        if (stops[i].Color.GetColorSpace() != stops[0].Color.GetColorSpace())
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "The colors of the gradient stops don't have the same color space");
+    }
+
+    string colorSpaceKey;
+    PdfObject colorSpace = getColorSpace(stops[0].Color, colorSpaceKey);
+    string functionKey = colorSpaceKey;
+    PdfObject& function = getFunction(stops, functionKey);
+
+    string key = type == PdfShadingPatternType::Axial ? "A" : "R";
+    key.append(coords.ToString());
+    key.append(functionKey);
+    auto found = m_shadings.find(key);
+    if (found != m_shadings.end())
+    {
+        // The pattern may have been removed from the document
+        auto& shading = *found->second;
+        if (m_doc->GetObjects().GetObject(shading.GetObject().GetIndirectReference()) == &shading.GetObject())
+            return shading;
+
+        m_shadings.erase(found);
+    }
+
+    unique_ptr<PdfShadingPattern> shading;
+    if (type == PdfShadingPatternType::Axial)
+        shading.reset(new PdfAxialShadingPattern(*m_doc, coords, colorSpace, function));
+    else
+        shading.reset(new PdfRadialShadingPattern(*m_doc, coords, colorSpace, function));
+
+    auto& ret = *shading;
+    m_shadings[key] = std::move(shading);
+    return ret;
+}
+
+PdfObject& PdfShadingCache::getFunction(const cspan<PdfGradientStop>& stops, string& key)
+{
+    PdfArray stopsArr;
+    for (auto& stop : stops)
+    {
+        stopsArr.Add(stop.Offset);
+        stopsArr.Add(stop.Color.ToArray());
+    }
+
+    key.append(stopsArr.ToString());
+    auto function = getObject(m_functions, key);
+    if (function != nullptr)
+        return *function;
+
+    // Two colors at the ends are interpolated exactly by
+    // an exponential function, more compact than samples
+    if (stops.size() == 2 && stops[0].Offset == 0 && stops[1].Offset == 1)
+    {
+        PdfExponentialFunction exponential(*m_doc, getUnitDomain(), stops[0].Color.ToArray(), stops[1].Color.ToArray(), 1.0);
+        function = &exponential.GetObject();
+    }
+    else
+    {
+        PdfSampledFunction sampled(*m_doc, stops);
+        function = &sampled.GetObject();
+    }
+
+    m_functions[key] = function->GetIndirectReference();
+    return *function;
+}
+
+PdfObject PdfShadingCache::getColorSpace(const PdfColor& color, string& key)
+{
+    switch (color.GetColorSpace())
+    {
+        case PdfColorSpace::DeviceGray:
+        case PdfColorSpace::DeviceRGB:
+        case PdfColorSpace::DeviceCMYK:
+        {
+            PdfName name = PdfColor::GetNameForColorSpace(color.GetColorSpace());
+            key = name.GetString();
+            return name;
+        }
+        case PdfColorSpace::Lab:
+        {
+            key = "Lab";
+            break;
+        }
+        case PdfColorSpace::Separation:
+        {
+            // Separations with the same colorant are assumed
+            // to have the same alternate color
+            key = "Separation/";
+            key.append(color.GetName());
+            key.push_back('/');
+            key.append(PdfColor::GetNameForColorSpace(color.GetAlternateColorSpace()).GetString());
+            break;
+        }
+        default:
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::CannotConvertColor, "Colorspace not supported in PdfShadingCache");
+    }
+
+    auto colorSpace = getObject(m_colorSpaces, key);
+    if (colorSpace == nullptr)
+    {
+        colorSpace = color.BuildColorSpace(*m_doc);
+        m_colorSpaces[key] = colorSpace->GetIndirectReference();
+    }
+
+    return colorSpace->GetIndirectReference();
+}
+
+PdfObject* PdfShadingCache::getObject(const unordered_map<string, PdfReference>& objects, const string& key)
+{
+    auto found = objects.find(key);
+    if (found == objects.end())
+        return nullptr;
+
+    // The object may have been removed from the document
+    return m_doc->GetObjects().GetObject(found->second);
+}
+
+PdfArray getUnitDomain()
+{
+    PdfArray domain;
+    domain.Add(0.0);
+    domain.Add(1.0);
+    return domain;
+}
+
+PdfObject getColorSpaceObject(PdfDocument& doc, const PdfColor& color)
+{
+    switch (color.GetColorSpace())
+    {
+        case PdfColorSpace::DeviceRGB:
+        case PdfColorSpace::DeviceCMYK:
+        case PdfColorSpace::DeviceGray:
+            return PdfColor::GetNameForColorSpace(color.GetColorSpace());
+
+        case PdfColorSpace::Lab:
+        case PdfColorSpace::Separation:
+            return color.BuildColorSpace(doc)->GetIndirectReference();
+
+        case PdfColorSpace::Indexed:
+        case PdfColorSpace::Unknown:
+        default:
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::CannotConvertColor, "Colorspace not supported in PdfShadingPattern");
+    }
+}
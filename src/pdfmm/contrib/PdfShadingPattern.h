@@ -12,9 +12,13 @@
 #include <pdfmm/base/PdfName.h>
 #include <pdfmm/base/PdfElement.h>
 
+#include <unordered_map>
+
 namespace mm {
 
 class PdfColor;
+class PdfShadingCache;
+struct PdfGradientStop;
 class PdfObject;
 class PdfPage;
 class PdfWriter;
@@ -53,6 +57,14 @@ protected:
      */
     PdfShadingPattern(PdfDocument& doc, PdfShadingPatternType shadingType);
 
+    /** Set the keys of an axial or radial shading
+     *
+     *  \param coords the coordinates of the shading
+     *  \param colorSpace the color space, either a name or a reference
+     *  \param function the function object computing the colors
+     */
+    void initFunctionShading(const PdfArray& coords, const PdfObject& colorSpace, const PdfObject& function);
+
 private:
     /** Initialize the object
      *
@@ -87,7 +99,22 @@ public:
      */
     PdfAxialShadingPattern(PdfDocument& doc, double x0, double y0, double x1, double y1, const PdfColor& start, const PdfColor& end);
 
+    /** Create an axial shading pattern with a multi-stop gradient
+     *
+     *  \param doc the parent
+     *  \param x0 the starting x coordinate
+     *  \param y0 the starting y coordinate
+     *  \param x1 the ending x coordinate
+     *  \param y1 the ending y coordinate
+     *  \param stops the stops of the gradient, sorted by offset
+     *  \see PdfSampledFunction
+     */
+    PdfAxialShadingPattern(PdfDocument& doc, double x0, double y0, double x1, double y1, const cspan<PdfGradientStop>& stops);
+
 private:
+    friend class PdfShadingCache;
+
+    PdfAxialShadingPattern(PdfDocument& doc, const PdfArray& coords, const PdfObject& colorSpace, const PdfObject& function);
 
     /** Initialize an axial shading pattern
      *
@@ -153,7 +180,24 @@ public:
      */
     PdfRadialShadingPattern(PdfDocument& doc, double x0, double y0, double r0, double x1, double y1, double r1, const PdfColor& start, const PdfColor& end);
 
+    /** Create an radial shading pattern with a multi-stop gradient
+     *
+     *  \param doc the parent
+     *  \param x0 the inner circles x coordinate
+     *  \param y0 the inner circles y coordinate
+     *  \param r0 the inner circles radius
+     *  \param x1 the outer circles x coordinate
+     *  \param y1 the outer circles y coordinate
+     *  \param r1 the outer circles radius
+     *  \param stops the stops of the gradient, sorted by offset
+     *  \see PdfSampledFunction
+     */
+    PdfRadialShadingPattern(PdfDocument& doc, double x0, double y0, double r0, double x1, double y1, double r1, const cspan<PdfGradientStop>& stops);
+
 private:
+    friend class PdfShadingCache;
+
+    PdfRadialShadingPattern(PdfDocument& doc, const PdfArray& coords, const PdfObject& colorSpace, const PdfObject& function);
 
     /** Initialize an radial shading pattern
      *
@@ -208,6 +252,60 @@ private:
     void Init(double x0, double y0, const PdfColor& color0, double x1, double y1, const PdfColor& color1, double x2, double y2, const PdfColor& color2);
 };
 
+/** A cache of axial and radial shading patterns of a document
+ *
+ * Shadings with the same coordinates and colors are created only
+ * once, and the functions and color spaces are shared between
+ * shadings with different coordinates
+ */
+class PDFMM_API PdfShadingCache final
+{
+public:
+    PdfShadingCache(PdfDocument& doc);
+    ~PdfShadingCache();
+
+public:
+    /** Get an axial shading pattern between two colors
+     *  \see PdfAxialShadingPattern
+     */
+    PdfShadingPattern& GetAxialShading(double x0, double y0, double x1, double y1, const PdfColor& start, const PdfColor& end);
+
+    /** Get an axial shading pattern with a multi-stop gradient
+     *  \see PdfAxialShadingPattern
+     */
+    PdfShadingPattern& GetAxialShading(double x0, double y0, double x1, double y1, const cspan<PdfGradientStop>& stops);
+
+    /** Get a radial shading pattern between two colors
+     *  \see PdfRadialShadingPattern
+     */
+    PdfShadingPattern& GetRadialShading(double x0, double y0, double r0, double x1, double y1, double r1, const PdfColor& start, const PdfColor& end);
+
+    /** Get a radial shading pattern with a multi-stop gradient
+     *  \see PdfRadialShadingPattern
+     */
+    PdfShadingPattern& GetRadialShading(double x0, double y0, double r0, double x1, double y1, double r1, const cspan<PdfGradientStop>& stops);
+
+    /** Forget all the cached objects, which stay in the document
+     */
+    void Clear();
+
+private:
+    PdfShadingPattern& getShading(PdfShadingPatternType type, const PdfArray& coords, const cspan<PdfGradientStop>& stops);
+    PdfObject& getFunction(const cspan<PdfGradientStop>& stops, std::string& key);
+    PdfObject getColorSpace(const PdfColor& color, std::string& key);
+    PdfObject* getObject(const std::unordered_map<std::string, PdfReference>& objects, const std::string& key);
+
+private:
+    PdfShadingCache(const PdfShadingCache&) = delete;
+    PdfShadingCache& operator=(const PdfShadingCache&) = delete;
+
+private:
+    PdfDocument* m_doc;
+    std::unordered_map<std::string, std::unique_ptr<PdfShadingPattern>> m_shadings;
+    std::unordered_map<std::string, PdfReference> m_functions;
+    std::unordered_map<std::string, PdfReference> m_colorSpaces;
+};
+
 };
 
 #endif // PDF_SHADING_PATTERN_H
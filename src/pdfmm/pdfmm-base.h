@@ -12,14 +12,21 @@
 #include "base/PdfMath.h"
 #include "base/PdfOperatorUtils.h"
 #include "base/PdfArray.h"
+#include "base/PdfAValidator.h"
 #include "base/PdfCanvas.h"
 #include "base/PdfColor.h"
 #include "base/PdfContentsReader.h"
+#include "base/PdfContentsOptimizer.h"
+#include "base/PdfContentsProfiler.h"
 #include "base/PdfPostScriptTokenizer.h"
 #include "base/PdfData.h"
 #include "base/PdfDataProvider.h"
 #include "base/PdfDate.h"
 #include "base/PdfDictionary.h"
+#include "base/PdfDocumentDiff.h"
+#include "base/PdfDocumentHasher.h"
+#include "base/PdfDocumentInfoProbe.h"
+#include "base/PdfDocumentSplitter.h"
 #include "base/PdfEncoding.h"
 #include "base/PdfCMapEncoding.h"
 #include "base/PdfEncodingFactory.h"
@@ -41,18 +48,31 @@
 #include "base/PdfStreamDevice.h"
 #include "base/PdfImmediateWriter.h"
 #include "base/PdfMemoryObjectStream.h"
+#include "base/PdfSpillObjectStream.h"
+#include "base/PdfMergeContext.h"
+#include "base/PdfMetadataUpdater.h"
 #include "base/PdfName.h"
 #include "base/PdfObject.h"
+#include "base/PdfObjectReader.h"
 #include "base/PdfObjectStreamParser.h"
+#include "base/PdfObjectWalker.h"
 #include "base/PdfParser.h"
 #include "base/PdfParserObject.h"
 #include "base/PdfXRefStreamParserObject.h"
 #include "base/PdfRect.h"
+#include "base/PdfRedactor.h"
 #include "base/PdfReference.h"
 #include "base/PdfSigner.h"
+#include "base/PdfStamper.h"
 #include "base/PdfObjectStream.h"
+#include "base/PdfObjectInputStream.h"
 #include "base/PdfString.h"
 #include "base/PdfTokenizer.h"
+#include "base/PdfTrace.h"
+#include "base/PdfExecutor.h"
+#include "base/PdfMemoryResource.h"
+#include "base/PdfMemoryGovernor.h"
+#include "base/PdfLibrary.h"
 #include "base/PdfVariant.h"
 #include "base/PdfIndirectObjectList.h"
 #include "base/PdfWriter.h"
@@ -99,8 +119,11 @@
 #include "base/PdfPage.h"
 #include "base/PdfPageTreeCache.h"
 #include "base/PdfPageCollection.h"
+#include "base/PdfPageInventory.h"
 #include "base/PdfPainter.h"
 #include "base/PdfStreamedDocument.h"
+#include "base/PdfTextIndex.h"
+#include "base/PdfTextSpatialIndex.h"
 #include "base/PdfXObject.h"
 #include "base/PdfXObjectForm.h"
 #include "base/PdfXObjectPostScript.h"
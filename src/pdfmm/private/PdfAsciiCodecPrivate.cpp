@@ -0,0 +1,275 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfAsciiCodecPrivate.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define PDFMM_ASCII_CODEC_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PDFMM_ASCII_CODEC_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+using namespace mm;
+
+namespace
+{
+    constexpr unsigned char InvalidHexValue = 0xFF;
+
+    constexpr array<unsigned char, 256> getHexValues()
+    {
+        array<unsigned char, 256> ret{ };
+        for (unsigned i = 0; i < 256; i++)
+            ret[i] = InvalidHexValue;
+        for (unsigned i = 0; i < 10; i++)
+            ret['0' + i] = (unsigned char)i;
+        for (unsigned i = 0; i < 6; i++)
+        {
+            ret['A' + i] = (unsigned char)(10 + i);
+            ret['a' + i] = (unsigned char)(10 + i);
+        }
+        return ret;
+    }
+}
+
+static constexpr array<unsigned char, 256> s_hexValues = getHexValues();
+static constexpr char s_hexDigits[] = "0123456789ABCDEF";
+
+#ifdef PDFMM_ASCII_CODEC_SSE2
+
+static unsigned countTrailingZeros(unsigned mask);
+static __m128i toHexDigits(__m128i nibbles);
+static bool tryGetHexValues(__m128i chars, __m128i& values);
+static __m128i packHexValues(__m128i values);
+
+#elif defined(PDFMM_ASCII_CODEC_NEON)
+
+static uint8x16_t toHexDigits(uint8x16_t nibbles);
+static bool tryGetHexValues(uint8x16_t chars, uint8x16_t& values);
+
+#endif
+
+void mm::EncodeHexDigits(char* dst, const char* src, size_t length)
+{
+    size_t i = 0;
+#if defined(PDFMM_ASCII_CODEC_SSE2)
+    __m128i lowMask = _mm_set1_epi8(0x0F);
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i high = toHexDigits(_mm_and_si128(_mm_srli_epi16(bytes, 4), lowMask));
+        __m128i low = toHexDigits(_mm_and_si128(bytes, lowMask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2 + 16), _mm_unpackhi_epi8(high, low));
+    }
+#elif defined(PDFMM_ASCII_CODEC_NEON)
+    for (; i + 16 <= length; i += 16)
+    {
+        uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        uint8x16x2_t digits;
+        digits.val[0] = toHexDigits(vshrq_n_u8(bytes, 4));
+        digits.val[1] = toHexDigits(vandq_u8(bytes, vdupq_n_u8(0x0F)));
+        vst2q_u8(reinterpret_cast<uint8_t*>(dst + i * 2), digits);
+    }
+#endif
+
+    for (; i < length; i++)
+    {
+        dst[i * 2] = s_hexDigits[((unsigned char)src[i]) >> 4];
+        dst[i * 2 + 1] = s_hexDigits[src[i] & 0x0F];
+    }
+}
+
+size_t mm::DecodeHexDigits(char* dst, const char* src, size_t length)
+{
+    size_t i = 0;
+#if defined(PDFMM_ASCII_CODEC_SSE2)
+    for (; i + 32 <= length; i += 32)
+    {
+        __m128i values1;
+        __m128i values2;
+        if (!tryGetHexValues(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), values1)
+            || !tryGetHexValues(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16)), values2))
+        {
+            break; // Find the exact position below
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i / 2),
+            _mm_packus_epi16(packHexValues(values1), packHexValues(values2)));
+    }
+#elif defined(PDFMM_ASCII_CODEC_NEON)
+    for (; i + 32 <= length; i += 32)
+    {
+        // Load the high digits and the low digits in separate vectors
+        uint8x16x2_t chars = vld2q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        uint8x16_t high;
+        uint8x16_t low;
+        if (!tryGetHexValues(chars.val[0], high) || !tryGetHexValues(chars.val[1], low))
+            break; // Find the exact position below
+
+        vst1q_u8(reinterpret_cast<uint8_t*>(dst + i / 2), vorrq_u8(vshlq_n_u8(high, 4), low));
+    }
+#endif
+
+    for (; i + 2 <= length; i += 2)
+    {
+        unsigned char high = s_hexValues[(unsigned char)src[i]];
+        unsigned char low = s_hexValues[(unsigned char)src[i + 1]];
+        if (high == InvalidHexValue || low == InvalidHexValue)
+            break;
+
+        dst[i / 2] = (char)((high << 4) | low);
+    }
+
+    return i;
+}
+
+size_t mm::FindNonAscii85Digit(const char* buffer, size_t length)
+{
+    size_t i = 0;
+#if defined(PDFMM_ASCII_CODEC_SSE2)
+    // Move the digits range at the bottom of the signed
+    // range, so it can be checked with a single comparison
+    __m128i offset = _mm_set1_epi8((char)(0x80 - '!'));
+    __m128i limit = _mm_set1_epi8((char)(-128 + 85));
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i chars = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i)), offset);
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmplt_epi8(chars, limit)) ^ 0xFFFFU;
+        if (mask != 0)
+            return i + countTrailingZeros(mask);
+    }
+#elif defined(PDFMM_ASCII_CODEC_NEON)
+    for (; i + 16 <= length; i += 16)
+    {
+        uint8x16_t chars = vsubq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(buffer + i)), vdupq_n_u8('!'));
+        if (vminvq_u8(vcltq_u8(chars, vdupq_n_u8(85))) == 0)
+            break; // Find the exact position below
+    }
+#endif
+
+    for (; i < length; i++)
+    {
+        if (buffer[i] < '!' || buffer[i] > 'u')
+            return i;
+    }
+
+    return length;
+}
+
+size_t mm::EncodeAscii85Groups(char* dst, const char* src, size_t groupCount)
+{
+    char* start = dst;
+    for (size_t i = 0; i < groupCount; i++)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(src + i * 4);
+        uint32_t tuple = (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16
+            | (uint32_t)bytes[2] << 8 | (uint32_t)bytes[3];
+        if (tuple == 0)
+        {
+            *dst++ = 'z';
+            continue;
+        }
+
+        // The divisions by a constant are compiled as multiplications
+        dst[4] = (char)(tuple % 85 + '!');
+        tuple /= 85;
+        dst[3] = (char)(tuple % 85 + '!');
+        tuple /= 85;
+        dst[2] = (char)(tuple % 85 + '!');
+        tuple /= 85;
+        dst[1] = (char)(tuple % 85 + '!');
+        dst[0] = (char)(tuple / 85 + '!');
+        dst += 5;
+    }
+
+    return (size_t)(dst - start);
+}
+
+void mm::DecodeAscii85Groups(char* dst, const char* src, size_t groupCount)
+{
+    for (size_t i = 0; i < groupCount; i++)
+    {
+        const char* digits = src + i * 5;
+        uint32_t tuple = (uint32_t)(digits[0] - '!');
+        tuple = tuple * 85 + (uint32_t)(digits[1] - '!');
+        tuple = tuple * 85 + (uint32_t)(digits[2] - '!');
+        tuple = tuple * 85 + (uint32_t)(digits[3] - '!');
+        tuple = tuple * 85 + (uint32_t)(digits[4] - '!');
+        dst[i * 4] = (char)(tuple >> 24);
+        dst[i * 4 + 1] = (char)(tuple >> 16);
+        dst[i * 4 + 2] = (char)(tuple >> 8);
+        dst[i * 4 + 3] = (char)tuple;
+    }
+}
+
+#ifdef PDFMM_ASCII_CODEC_SSE2
+
+unsigned countTrailingZeros(unsigned mask)
+{
+#ifdef _MSC_VER
+    unsigned long ret;
+    _BitScanForward(&ret, mask);
+    return (unsigned)ret;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+__m128i toHexDigits(__m128i nibbles)
+{
+    __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('A' - '0' - 10));
+    return _mm_add_epi8(nibbles, _mm_add_epi8(_mm_set1_epi8('0'), letters));
+}
+
+bool tryGetHexValues(__m128i chars, __m128i& values)
+{
+    // The unsigned comparisons are done flipping the sign bit
+    __m128i signBit = _mm_set1_epi8((char)0x80);
+    __m128i digits = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i isDigit = _mm_cmplt_epi8(_mm_xor_si128(digits, signBit), _mm_set1_epi8((char)(-128 + 10)));
+    __m128i letters = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isLetter = _mm_cmplt_epi8(_mm_xor_si128(letters, signBit), _mm_set1_epi8((char)(-128 + 6)));
+    values = _mm_or_si128(_mm_and_si128(isDigit, digits),
+        _mm_and_si128(isLetter, _mm_add_epi8(letters, _mm_set1_epi8(10))));
+    return _mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) == 0xFFFF;
+}
+
+__m128i packHexValues(__m128i values)
+{
+    // Join the high value in the even byte with the low
+    // value in the odd byte of every 16 bits lane
+    return _mm_and_si128(_mm_or_si128(_mm_slli_epi16(values, 4), _mm_srli_epi16(values, 8)),
+        _mm_set1_epi16(0x00FF));
+}
+
+#elif defined(PDFMM_ASCII_CODEC_NEON)
+
+uint8x16_t toHexDigits(uint8x16_t nibbles)
+{
+    return vaddq_u8(nibbles, vbslq_u8(vcgtq_u8(nibbles, vdupq_n_u8(9)),
+        vdupq_n_u8('A' - 10), vdupq_n_u8('0')));
+}
+
+bool tryGetHexValues(uint8x16_t chars, uint8x16_t& values)
+{
+    uint8x16_t digits = vsubq_u8(chars, vdupq_n_u8('0'));
+    uint8x16_t isDigit = vcltq_u8(digits, vdupq_n_u8(10));
+    uint8x16_t letters = vsubq_u8(vorrq_u8(chars, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t isLetter = vcltq_u8(letters, vdupq_n_u8(6));
+    values = vbslq_u8(isDigit, digits, vaddq_u8(letters, vdupq_n_u8(10)));
+    return vminvq_u8(vorrq_u8(isDigit, isLetter)) != 0;
+}
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_ASCII_CODEC_PRIVATE_H
+#define PDF_ASCII_CODEC_PRIVATE_H
+
+namespace mm
+{
+    /** Encode the buffer as uppercase hexadecimal digits
+     *
+     * The encoding is vectorized when SSE2 or NEON are available
+     * \param dst the destination, of at least 2 * length characters
+     * \remarks The encoding can be done in place, with the source
+     * at dst + length, since every block is read before its digits
+     * are written and the digits never reach the unread source
+     */
+    void EncodeHexDigits(char* dst, const char* src, size_t length);
+
+    /** Decode the pairs of hexadecimal digits at the start of the
+     * buffer, until the first character that is not a digit
+     *
+     * The decoding is vectorized when SSE2 or NEON are available
+     * \param dst the destination, of at least length / 2 bytes
+     * \returns the number of read characters, which is always even
+     */
+    size_t DecodeHexDigits(char* dst, const char* src, size_t length);
+
+    /** Find the first character in the buffer that is not in the
+     * ASCII85 digit range '!' - 'u'
+     *
+     * The search is vectorized when SSE2 or NEON are available
+     * \returns the index of the found character, or length if not found
+     */
+    size_t FindNonAscii85Digit(const char* buffer, size_t length);
+
+    /** Encode the given number of 4 bytes groups as ASCII85, with
+     * the groups of all zeros encoded as 'z'
+     *
+     * \param dst the destination, of at least 5 * groupCount characters
+     * \returns the number of written characters
+     */
+    size_t EncodeAscii85Groups(char* dst, const char* src, size_t groupCount);
+
+    /** Decode the given number of 5 ASCII85 digits groups
+     *
+     * \param dst the destination, of at least 4 * groupCount bytes
+     */
+    void DecodeAscii85Groups(char* dst, const char* src, size_t groupCount);
+}
+
+#endif // PDF_ASCII_CODEC_PRIVATE_H
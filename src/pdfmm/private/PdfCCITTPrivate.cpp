@@ -0,0 +1,663 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfCCITTPrivate.h"
+
+using namespace std;
+using namespace mm;
+
+// The rows are handled as lists of changing elements, the positions
+// where the color changes, starting from white. Every list ends with
+// three times the row length, so the searches never go past the end
+constexpr unsigned LineSentinelCount = 3;
+
+// The longest run and mode codes, used as lookup table widths
+constexpr unsigned WhiteLookupBits = 12;
+constexpr unsigned BlackLookupBits = 13;
+constexpr unsigned ModeLookupBits = 7;
+constexpr unsigned EolCode = 1;
+constexpr unsigned EolLength = 12;
+
+namespace
+{
+    struct CCITTCode
+    {
+        uint16_t Code;
+        uint8_t Length;
+        uint16_t Run;
+    };
+
+    // A decoded run, a negative run means an invalid code
+    struct RunEntry
+    {
+        int16_t Run;
+        uint8_t Length;
+    };
+
+    enum class CodingMode : uint8_t
+    {
+        Invalid = 0,
+        Pass,
+        Horizontal,
+        Vertical,
+    };
+
+    struct ModeEntry
+    {
+        CodingMode Mode;
+        int8_t Offset;      // a1 - b1 of the vertical modes
+        uint8_t Length;
+    };
+
+    struct LookupTables
+    {
+        RunEntry White[1 << WhiteLookupBits];
+        RunEntry Black[1 << BlackLookupBits];
+        ModeEntry Modes[1 << ModeLookupBits];
+    };
+
+    // Read bits from the most significant, with zeros past the end
+    class BitReader
+    {
+    public:
+        BitReader(const bufferview& input)
+            : m_input(input.data()), m_size(input.size()), m_pos(0),
+            m_bits(0), m_bitCount(0), m_consumed(0) { }
+
+        unsigned Peek(unsigned count)
+        {
+            if (m_bitCount < count)
+                fill();
+
+            return (unsigned)(m_bits >> (64 - count));
+        }
+
+        void Skip(unsigned count)
+        {
+            if (m_bitCount < count)
+                fill();
+
+            m_bits <<= count;
+            m_bitCount -= count;
+            m_consumed += count;
+        }
+
+        void AlignToByte()
+        {
+            Skip((unsigned)((8 - m_consumed % 8) % 8));
+        }
+
+        bool IsAtEnd() const
+        {
+            return m_consumed >= m_size * 8;
+        }
+
+    private:
+        void fill()
+        {
+            for (; m_bitCount <= 56; m_pos++)
+            {
+                uint64_t byte = m_pos < m_size ? (unsigned char)m_input[m_pos] : 0;
+                m_bits |= byte << (56 - m_bitCount);
+                m_bitCount += 8;
+            }
+        }
+
+    private:
+        const char* m_input;
+        size_t m_size;
+        size_t m_pos;
+        uint64_t m_bits;
+        unsigned m_bitCount;
+        size_t m_consumed;
+    };
+
+    class BitWriter
+    {
+    public:
+        BitWriter(charbuff& output)
+            : m_output(&output), m_bits(0), m_bitCount(0) { }
+
+        void Write(unsigned code, unsigned length)
+        {
+            m_bits = (m_bits << length) | code;
+            m_bitCount += length;
+            while (m_bitCount >= 8)
+            {
+                m_bitCount -= 8;
+                m_output->push_back((char)(m_bits >> m_bitCount));
+            }
+        }
+
+        void Flush()
+        {
+            if (m_bitCount != 0)
+                Write(0, 8 - m_bitCount);
+        }
+
+    private:
+        charbuff* m_output;
+        uint64_t m_bits;
+        unsigned m_bitCount;
+    };
+}
+
+// The codes of the ITU-T T.4 recommendation, 4.1.2 "Coding scheme"
+static constexpr CCITTCode s_whiteTerminatingCodes[] = {
+    { 0b00110101, 8, 0 }, { 0b000111, 6, 1 }, { 0b0111, 4, 2 },
+    { 0b1000, 4, 3 }, { 0b1011, 4, 4 }, { 0b1100, 4, 5 },
+    { 0b1110, 4, 6 }, { 0b1111, 4, 7 }, { 0b10011, 5, 8 },
+    { 0b10100, 5, 9 }, { 0b00111, 5, 10 }, { 0b01000, 5, 11 },
+    { 0b001000, 6, 12 }, { 0b000011, 6, 13 }, { 0b110100, 6, 14 },
+    { 0b110101, 6, 15 }, { 0b101010, 6, 16 }, { 0b101011, 6, 17 },
+    { 0b0100111, 7, 18 }, { 0b0001100, 7, 19 }, { 0b0001000, 7, 20 },
+    { 0b0010111, 7, 21 }, { 0b0000011, 7, 22 }, { 0b0000100, 7, 23 },
+    { 0b0101000, 7, 24 }, { 0b0101011, 7, 25 }, { 0b0010011, 7, 26 },
+    { 0b0100100, 7, 27 }, { 0b0011000, 7, 28 }, { 0b00000010, 8, 29 },
+    { 0b00000011, 8, 30 }, { 0b00011010, 8, 31 }, { 0b00011011, 8, 32 },
+    { 0b00010010, 8, 33 }, { 0b00010011, 8, 34 }, { 0b00010100, 8, 35 },
+    { 0b00010101, 8, 36 }, { 0b00010110, 8, 37 }, { 0b00010111, 8, 38 },
+    { 0b00101000, 8, 39 }, { 0b00101001, 8, 40 }, { 0b00101010, 8, 41 },
+    { 0b00101011, 8, 42 }, { 0b00101100, 8, 43 }, { 0b00101101, 8, 44 },
+    { 0b00000100, 8, 45 }, { 0b00000101, 8, 46 }, { 0b00001010, 8, 47 },
+    { 0b00001011, 8, 48 }, { 0b01010010, 8, 49 }, { 0b01010011, 8, 50 },
+    { 0b01010100, 8, 51 }, { 0b01010101, 8, 52 }, { 0b00100100, 8, 53 },
+    { 0b00100101, 8, 54 }, { 0b01011000, 8, 55 }, { 0b01011001, 8, 56 },
+    { 0b01011010, 8, 57 }, { 0b01011011, 8, 58 }, { 0b01001010, 8, 59 },
+    { 0b01001011, 8, 60 }, { 0b00110010, 8, 61 }, { 0b00110011, 8, 62 },
+    { 0b00110100, 8, 63 },
+};
+
+static constexpr CCITTCode s_whiteMakeupCodes[] = {
+    { 0b11011, 5, 64 }, { 0b10010, 5, 128 }, { 0b010111, 6, 192 },
+    { 0b0110111, 7, 256 }, { 0b00110110, 8, 320 }, { 0b00110111, 8, 384 },
+    { 0b01100100, 8, 448 }, { 0b01100101, 8, 512 }, { 0b01101000, 8, 576 },
+    { 0b01100111, 8, 640 }, { 0b011001100, 9, 704 }, { 0b011001101, 9, 768 },
+    { 0b011010010, 9, 832 }, { 0b011010011, 9, 896 }, { 0b011010100, 9, 960 },
+    { 0b011010101, 9, 1024 }, { 0b011010110, 9, 1088 }, { 0b011010111, 9, 1152 },
+    { 0b011011000, 9, 1216 }, { 0b011011001, 9, 1280 }, { 0b011011010, 9, 1344 },
+    { 0b011011011, 9, 1408 }, { 0b010011000, 9, 1472 }, { 0b010011001, 9, 1536 },
+    { 0b010011010, 9, 1600 }, { 0b011000, 6, 1664 }, { 0b010011011, 9, 1728 },
+};
+
+static constexpr CCITTCode s_blackTerminatingCodes[] = {
+    { 0b0000110111, 10, 0 }, { 0b010, 3, 1 }, { 0b11, 2, 2 },
+    { 0b10, 2, 3 }, { 0b011, 3, 4 }, { 0b0011, 4, 5 },
+    { 0b0010, 4, 6 }, { 0b00011, 5, 7 }, { 0b000101, 6, 8 },
+    { 0b000100, 6, 9 }, { 0b0000100, 7, 10 }, { 0b0000101, 7, 11 },
+    { 0b0000111, 7, 12 }, { 0b00000100, 8, 13 }, { 0b00000111, 8, 14 },
+    { 0b000011000, 9, 15 }, { 0b0000010111, 10, 16 }, { 0b0000011000, 10, 17 },
+    { 0b0000001000, 10, 18 }, { 0b00001100111, 11, 19 }, { 0b00001101000, 11, 20 },
+    { 0b00001101100, 11, 21 }, { 0b00000110111, 11, 22 }, { 0b00000101000, 11, 23 },
+    { 0b00000010111, 11, 24 }, { 0b00000011000, 11, 25 }, { 0b000011001010, 12, 26 },
+    { 0b000011001011, 12, 27 }, { 0b000011001100, 12, 28 }, { 0b000011001101, 12, 29 },
+    { 0b000001101000, 12, 30 }, { 0b000001101001, 12, 31 }, { 0b000001101010, 12, 32 },
+    { 0b000001101011, 12, 33 }, { 0b000011010010, 12, 34 }, { 0b000011010011, 12, 35 },
+    { 0b000011010100, 12, 36 }, { 0b000011010101, 12, 37 }, { 0b000011010110, 12, 38 },
+    { 0b000011010111, 12, 39 }, { 0b000001101100, 12, 40 }, { 0b000001101101, 12, 41 },
+    { 0b000011011010, 12, 42 }, { 0b000011011011, 12, 43 }, { 0b000001010100, 12, 44 },
+    { 0b000001010101, 12, 45 }, { 0b000001010110, 12, 46 }, { 0b000001010111, 12, 47 },
+    { 0b000001100100, 12, 48 }, { 0b000001100101, 12, 49 }, { 0b000001010010, 12, 50 },
+    { 0b000001010011, 12, 51 }, { 0b000000100100, 12, 52 }, { 0b000000110111, 12, 53 },
+    { 0b000000111000, 12, 54 }, { 0b000000100111, 12, 55 }, { 0b000000101000, 12, 56 },
+    { 0b000001011000, 12, 57 }, { 0b000001011001, 12, 58 }, { 0b000000101011, 12, 59 },
+    { 0b000000101100, 12, 60 }, { 0b000001011010, 12, 61 }, { 0b000001100110, 12, 62 },
+    { 0b000001100111, 12, 63 },
+};
+
+static constexpr CCITTCode s_blackMakeupCodes[] = {
+    { 0b0000001111, 10, 64 }, { 0b000011001000, 12, 128 }, { 0b000011001001, 12, 192 },
+    { 0b000001011011, 12, 256 }, { 0b000000110011, 12, 320 }, { 0b000000110100, 12, 384 },
+    { 0b000000110101, 12, 448 }, { 0b0000001101100, 13, 512 }, { 0b0000001101101, 13, 576 },
+    { 0b0000001001010, 13, 640 }, { 0b0000001001011, 13, 704 }, { 0b0000001001100, 13, 768 },
+    { 0b0000001001101, 13, 832 }, { 0b0000001110010, 13, 896 }, { 0b0000001110011, 13, 960 },
+    { 0b0000001110100, 13, 1024 }, { 0b0000001110101, 13, 1088 }, { 0b0000001110110, 13, 1152 },
+    { 0b0000001110111, 13, 1216 }, { 0b0000001010010, 13, 1280 }, { 0b0000001010011, 13, 1344 },
+    { 0b0000001010100, 13, 1408 }, { 0b0000001010101, 13, 1472 }, { 0b0000001011010, 13, 1536 },
+    { 0b0000001011011, 13, 1600 }, { 0b0000001100100, 13, 1664 }, { 0b0000001100101, 13, 1728 },
+};
+
+static constexpr CCITTCode s_extendedMakeupCodes[] = {
+    { 0b00000001000, 11, 1792 }, { 0b00000001100, 11, 1856 }, { 0b00000001101, 11, 1920 },
+    { 0b000000010010, 12, 1984 }, { 0b000000010011, 12, 2048 }, { 0b000000010100, 12, 2112 },
+    { 0b000000010101, 12, 2176 }, { 0b000000010110, 12, 2240 }, { 0b000000010111, 12, 2304 },
+    { 0b000000011100, 12, 2368 }, { 0b000000011101, 12, 2432 }, { 0b000000011110, 12, 2496 },
+    { 0b000000011111, 12, 2560 },
+};
+
+static const LookupTables& getLookupTables();
+static void fillLookup(RunEntry* table, unsigned tableBits, const CCITTCode* codes, size_t count);
+static int readRun(BitReader& reader, const LookupTables& tables, bool white);
+static void writeRun(BitWriter& writer, unsigned run, bool white);
+static bool decodeRow1D(BitReader& reader, const LookupTables& tables, vector<unsigned>& codingLine, unsigned columns);
+static bool decodeRow2D(BitReader& reader, const LookupTables& tables, const vector<unsigned>& refLine,
+    vector<unsigned>& codingLine, unsigned columns);
+static size_t findB1(const vector<unsigned>& refLine, size_t index, int a0, unsigned color);
+static void closeLine(vector<unsigned>& line, unsigned columns);
+static void writeRow(char* row, const vector<unsigned>& line, unsigned columns, bool blackIs1);
+static void fillBits(unsigned char* row, unsigned start, unsigned end, bool value);
+static void readChanges(const unsigned char* row, unsigned columns, bool blackIs1, vector<unsigned>& line);
+static bool skipEol(BitReader& reader);
+
+void mm::DecodeCCITT(charbuff& output, const bufferview& input, const CCITTParameters& params)
+{
+    if (params.Columns == 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Invalid CCITT columns");
+
+    auto& tables = getLookupTables();
+    unsigned columns = params.Columns;
+    size_t rowSize = (columns + 7) / 8;
+
+    // The reference line of the first row is all white
+    vector<unsigned> refLine;
+    vector<unsigned> codingLine;
+    closeLine(refLine, columns);
+    BitReader reader(input);
+    if (params.Rows != 0)
+        output.reserve(output.size() + rowSize * params.Rows);
+
+    for (unsigned rowIndex = 0; params.Rows == 0 || rowIndex < params.Rows; rowIndex++)
+    {
+        if (params.EncodedByteAlign && (params.K < 0 || !params.EndOfLine))
+            reader.AlignToByte();
+
+        // The end of line codes are accepted also when not required.
+        // Two of them in a row end the data, as the Group 4 end of
+        // block or the Group 3 return to control do
+        if (skipEol(reader) && params.EndOfBlock)
+        {
+            unsigned next = params.K > 0 ? reader.Peek(EolLength + 1) : reader.Peek(EolLength);
+            if (next == (params.K > 0 ? (1U << EolLength | EolCode) : EolCode))
+                break;
+        }
+
+        if (reader.IsAtEnd())
+            break;
+
+        bool twoDimensional = params.K < 0;
+        if (params.K > 0)
+        {
+            // The tag bit of the mixed encoding, 1 for one-dimensional rows
+            twoDimensional = reader.Peek(1) == 0;
+            reader.Skip(1);
+        }
+
+        codingLine.clear();
+        bool valid = twoDimensional
+            ? decodeRow2D(reader, tables, refLine, codingLine, columns)
+            : decodeRow1D(reader, tables, codingLine, columns);
+        if (!valid)
+        {
+            if (reader.IsAtEnd())
+                break; // Truncated data
+
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidStream, "Invalid CCITT code");
+        }
+
+        closeLine(codingLine, columns);
+        size_t offset = output.size();
+        output.resize(offset + rowSize);
+        writeRow(output.data() + offset, codingLine, columns, params.BlackIs1);
+        std::swap(refLine, codingLine);
+    }
+}
+
+void mm::EncodeCCITTGroup4(charbuff& output, const bufferview& input, unsigned columns, unsigned rows,
+    bool blackIs1)
+{
+    size_t rowSize = (columns + 7) / 8;
+    if (columns == 0 || input.size() < rowSize * rows)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Invalid CCITT image size");
+
+    BitWriter writer(output);
+    vector<unsigned> refLine;
+    vector<unsigned> codingLine;
+    closeLine(refLine, columns);
+    for (unsigned i = 0; i < rows; i++)
+    {
+        readChanges(reinterpret_cast<const unsigned char*>(input.data()) + i * rowSize, columns, blackIs1, codingLine);
+
+        // The same choices of the decoder, see ITU-T T.4 4.2.1.3.4 "Coding procedure"
+        int a0 = -1;
+        unsigned color = 0;
+        size_t a1Index = 0;
+        size_t b1Index = 0;
+        while (a0 < (int)columns)
+        {
+            b1Index = findB1(refLine, b1Index, a0, color);
+            unsigned b1 = refLine[b1Index];
+            unsigned b2 = refLine[b1Index + 1];
+            unsigned a1 = codingLine[a1Index];
+            if (b2 < a1)
+            {
+                writer.Write(0b0001, 4);
+                a0 = (int)b2;
+                continue;
+            }
+
+            int offset = (int)a1 - (int)b1;
+            switch (offset)
+            {
+                case 0:
+                    writer.Write(0b1, 1);
+                    break;
+                case 1:
+                    writer.Write(0b011, 3);
+                    break;
+                case 2:
+                    writer.Write(0b000011, 6);
+                    break;
+                case 3:
+                    writer.Write(0b0000011, 7);
+                    break;
+                case -1:
+                    writer.Write(0b010, 3);
+                    break;
+                case -2:
+                    writer.Write(0b000010, 6);
+                    break;
+                case -3:
+                    writer.Write(0b0000010, 7);
+                    break;
+                default:
+                {
+                    unsigned a2 = codingLine[a1Index + 1];
+                    writer.Write(0b001, 3);
+                    writeRun(writer, a1 - (unsigned)std::max(a0, 0), color == 0);
+                    writeRun(writer, a2 - a1, color != 0);
+                    a0 = (int)a2;
+                    a1Index += 2;
+                    continue;
+                }
+            }
+
+            a0 = (int)a1;
+            color ^= 1;
+            a1Index++;
+        }
+
+        std::swap(refLine, codingLine);
+    }
+
+    // The end of block marker
+    writer.Write(EolCode, EolLength);
+    writer.Write(EolCode, EolLength);
+    writer.Flush();
+}
+
+const LookupTables& getLookupTables()
+{
+    static unique_ptr<LookupTables> s_tables = []() {
+        unique_ptr<LookupTables> ret(new LookupTables());
+        std::memset(ret->White, 0xFF, sizeof(ret->White));
+        std::memset(ret->Black, 0xFF, sizeof(ret->Black));
+        fillLookup(ret->White, WhiteLookupBits, s_whiteTerminatingCodes, std::size(s_whiteTerminatingCodes));
+        fillLookup(ret->White, WhiteLookupBits, s_whiteMakeupCodes, std::size(s_whiteMakeupCodes));
+        fillLookup(ret->White, WhiteLookupBits, s_extendedMakeupCodes, std::size(s_extendedMakeupCodes));
+        fillLookup(ret->Black, BlackLookupBits, s_blackTerminatingCodes, std::size(s_blackTerminatingCodes));
+        fillLookup(ret->Black, BlackLookupBits, s_blackMakeupCodes, std::size(s_blackMakeupCodes));
+        fillLookup(ret->Black, BlackLookupBits, s_extendedMakeupCodes, std::size(s_extendedMakeupCodes));
+
+        // The codes of the two-dimensional modes, see ITU-T T.4 4.2.1.3.2
+        // "Coding modes". The extensions are not supported
+        const struct { unsigned Code; uint8_t Length; ModeEntry Entry; } modes[] = {
+            { 0b0001, 4, { CodingMode::Pass, 0, 4 } },
+            { 0b001, 3, { CodingMode::Horizontal, 0, 3 } },
+            { 0b1, 1, { CodingMode::Vertical, 0, 1 } },
+            { 0b011, 3, { CodingMode::Vertical, 1, 3 } },
+            { 0b000011, 6, { CodingMode::Vertical, 2, 6 } },
+            { 0b0000011, 7, { CodingMode::Vertical, 3, 7 } },
+            { 0b010, 3, { CodingMode::Vertical, -1, 3 } },
+            { 0b000010, 6, { CodingMode::Vertical, -2, 6 } },
+            { 0b0000010, 7, { CodingMode::Vertical, -3, 7 } },
+        };
+        for (auto& mode : modes)
+        {
+            unsigned shift = ModeLookupBits - mode.Length;
+            for (unsigned i = 0; i < (1U << shift); i++)
+                ret->Modes[mode.Code << shift | i] = mode.Entry;
+        }
+
+        return ret;
+    }();
+    return *s_tables;
+}
+
+void fillLookup(RunEntry* table, unsigned tableBits, const CCITTCode* codes, size_t count)
+{
+    // Every code fills all the entries starting with it
+    for (size_t i = 0; i < count; i++)
+    {
+        auto& code = codes[i];
+        unsigned shift = tableBits - code.Length;
+        for (unsigned j = 0; j < (1U << shift); j++)
+            table[code.Code << shift | j] = { (int16_t)code.Run, code.Length };
+    }
+}
+
+int readRun(BitReader& reader, const LookupTables& tables, bool white)
+{
+    // The make up codes are followed by more codes
+    int run = 0;
+    while (true)
+    {
+        auto& entry = white ? tables.White[reader.Peek(WhiteLookupBits)]
+            : tables.Black[reader.Peek(BlackLookupBits)];
+        if (entry.Run < 0)
+            return -1;
+
+        reader.Skip(entry.Length);
+        run += entry.Run;
+        if (entry.Run < 64)
+            return run;
+    }
+}
+
+void writeRun(BitWriter& writer, unsigned run, bool white)
+{
+    const CCITTCode* terminating = white ? s_whiteTerminatingCodes : s_blackTerminatingCodes;
+    const CCITTCode* makeup = white ? s_whiteMakeupCodes : s_blackMakeupCodes;
+    while (run >= 2624)
+    {
+        auto& code = s_extendedMakeupCodes[std::size(s_extendedMakeupCodes) - 1];
+        writer.Write(code.Code, code.Length);
+        run -= code.Run;
+    }
+
+    if (run >= 1792)
+    {
+        auto& code = s_extendedMakeupCodes[run / 64 - 1792 / 64];
+        writer.Write(code.Code, code.Length);
+        run -= code.Run;
+    }
+    else if (run >= 64)
+    {
+        auto& code = makeup[run / 64 - 1];
+        writer.Write(code.Code, code.Length);
+        run -= code.Run;
+    }
+
+    writer.Write(terminating[run].Code, terminating[run].Length);
+}
+
+bool decodeRow1D(BitReader& reader, const LookupTables& tables, vector<unsigned>& codingLine, unsigned columns)
+{
+    unsigned a0 = 0;
+    bool white = true;
+    while (a0 < columns)
+    {
+        int run = readRun(reader, tables, white);
+        if (run < 0)
+            return false;
+
+        a0 = std::min(a0 + (unsigned)run, columns);
+        codingLine.push_back(a0);
+        white = !white;
+    }
+
+    return true;
+}
+
+bool decodeRow2D(BitReader& reader, const LookupTables& tables, const vector<unsigned>& refLine,
+    vector<unsigned>& codingLine, unsigned columns)
+{
+    int a0 = -1;
+    unsigned color = 0;
+    size_t b1Index = 0;
+    while (a0 < (int)columns)
+    {
+        b1Index = findB1(refLine, b1Index, a0, color);
+        auto& mode = tables.Modes[reader.Peek(ModeLookupBits)];
+        reader.Skip(mode.Length);
+        switch (mode.Mode)
+        {
+            case CodingMode::Pass:
+            {
+                a0 = (int)refLine[b1Index + 1];
+                break;
+            }
+            case CodingMode::Horizontal:
+            {
+                int run1 = readRun(reader, tables, color == 0);
+                int run2 = run1 < 0 ? -1 : readRun(reader, tables, color != 0);
+                if (run2 < 0)
+                    return false;
+
+                unsigned a1 = std::min((unsigned)(std::max(a0, 0) + run1), columns);
+                unsigned a2 = std::min(a1 + (unsigned)run2, columns);
+                codingLine.push_back(a1);
+                codingLine.push_back(a2);
+                a0 = (int)a2;
+                break;
+            }
+            case CodingMode::Vertical:
+            {
+                int a1 = (int)refLine[b1Index] + mode.Offset;
+                if (a1 < 0 || a1 < a0)
+                    return false;
+
+                a0 = std::min(a1, (int)columns);
+                codingLine.push_back((unsigned)a0);
+                color ^= 1;
+                break;
+            }
+            default:
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t findB1(const vector<unsigned>& refLine, size_t index, int a0, unsigned color)
+{
+    // b1 is the first changing element on the reference line after
+    // a0 and to the opposite color. The even elements are changes to
+    // black. The search starts from the previous b1, which may be
+    // after a0 after the vertical modes to the left
+    while (index > 0 && (int)refLine[index - 1] > a0)
+        index--;
+    while ((int)refLine[index] <= a0)
+        index++;
+    if ((index & 1) != color)
+        index++;
+
+    return index;
+}
+
+void closeLine(vector<unsigned>& line, unsigned columns)
+{
+    for (unsigned i = 0; i < LineSentinelCount; i++)
+        line.push_back(columns);
+}
+
+void writeRow(char* row, const vector<unsigned>& line, unsigned columns, bool blackIs1)
+{
+    // Fill the row with white, then draw the black runs
+    auto pixels = reinterpret_cast<unsigned char*>(row);
+    std::memset(pixels, blackIs1 ? 0 : 0xFF, (columns + 7) / 8);
+    for (size_t i = 0; i + 1 < line.size() && line[i] < columns; i += 2)
+        fillBits(pixels, line[i], std::min(line[i + 1], columns), blackIs1);
+}
+
+void fillBits(unsigned char* row, unsigned start, unsigned end, bool value)
+{
+    if (start >= end)
+        return;
+
+    unsigned first = start / 8;
+    unsigned last = (end - 1) / 8;
+    unsigned char firstMask = (unsigned char)(0xFF >> (start % 8));
+    unsigned char lastMask = (unsigned char)(0xFF << (7 - (end - 1) % 8));
+    if (first == last)
+        firstMask &= lastMask;
+
+    if (value)
+        row[first] |= firstMask;
+    else
+        row[first] &= ~firstMask;
+
+    if (first == last)
+        return;
+
+    std::memset(row + first + 1, value ? 0xFF : 0, last - first - 1);
+    if (value)
+        row[last] |= lastMask;
+    else
+        row[last] &= ~lastMask;
+}
+
+void readChanges(const unsigned char* row, unsigned columns, bool blackIs1, vector<unsigned>& line)
+{
+    // Whole bytes of the current color are skipped at once
+    line.clear();
+    unsigned char whiteByte = blackIs1 ? 0 : 0xFF;
+    bool white = true;
+    unsigned i = 0;
+    while (i < columns)
+    {
+        unsigned char current = white ? whiteByte : (unsigned char)~whiteByte;
+        if (i % 8 == 0 && row[i / 8] == current)
+        {
+            i += 8;
+            continue;
+        }
+
+        bool pixelWhite = (((row[i / 8] >> (7 - i % 8)) & 1) != 0) != blackIs1;
+        if (pixelWhite != white)
+        {
+            line.push_back(i);
+            white = pixelWhite;
+        }
+
+        i++;
+    }
+
+    for (i = 0; i < LineSentinelCount; i++)
+        line.push_back(columns);
+}
+
+bool skipEol(BitReader& reader)
+{
+    // Skip the fill bits, then the end of line code
+    while (reader.Peek(EolLength) == 0)
+    {
+        if (reader.IsAtEnd())
+            return false;
+
+        reader.Skip(1);
+    }
+
+    if (reader.Peek(EolLength) != EolCode)
+        return false;
+
+    reader.Skip(EolLength);
+    return true;
+}
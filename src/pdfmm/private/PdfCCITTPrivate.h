@@ -0,0 +1,42 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_CCITT_PRIVATE_H
+#define PDF_CCITT_PRIVATE_H
+
+namespace mm
+{
+    /** The parameters of the CCITTFaxDecode filter,
+     * see the PDF reference, 7.4.6 "CCITTFaxDecode Filter"
+     */
+    struct CCITTParameters
+    {
+        int K = 0;
+        bool EndOfLine = false;
+        bool EncodedByteAlign = false;
+        unsigned Columns = 1728;
+        unsigned Rows = 0;
+        bool EndOfBlock = true;
+        bool BlackIs1 = false;
+    };
+
+    /** Decode CCITT Group 3 or Group 4 encoded data as rows of packed
+     * 1 bit pixels, appended to the output
+     *
+     * The data is decoded as far as it's available, a truncated
+     * row is not written
+     */
+    void DecodeCCITT(charbuff& output, const bufferview& input, const CCITTParameters& params);
+
+    /** Encode the given rows of packed 1 bit pixels with CCITT Group 4,
+     * that is K -1, ending with the end of block marker
+     */
+    void EncodeCCITTGroup4(charbuff& output, const bufferview& input, unsigned columns, unsigned rows,
+        bool blackIs1 = false);
+}
+
+#endif // PDF_CCITT_PRIVATE_H
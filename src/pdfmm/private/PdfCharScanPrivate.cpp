@@ -0,0 +1,223 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfCharScanPrivate.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define PDFMM_CHAR_SCAN_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PDFMM_CHAR_SCAN_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+using namespace mm;
+
+namespace
+{
+    enum CharClass : unsigned char
+    {
+        Regular = 0,
+        Whitespace = 1,
+        Delimiter = 2,
+    };
+
+    constexpr array<unsigned char, 256> getCharClasses()
+    {
+        array<unsigned char, 256> ret{ };
+        for (unsigned char ch : { '\0', '\t', '\n', '\f', '\r', ' ' })
+            ret[ch] = Whitespace;
+        for (unsigned char ch : { '(', ')', '<', '>', '[', ']', '{', '}', '/', '%' })
+            ret[ch] = Delimiter;
+        return ret;
+    }
+}
+
+static constexpr array<unsigned char, 256> s_charClasses = getCharClasses();
+
+#ifdef PDFMM_CHAR_SCAN_SSE2
+
+static unsigned countTrailingZeros(unsigned mask);
+static __m128i getWhitespaceMask(__m128i chars);
+static __m128i getDelimiterMask(__m128i chars);
+
+#elif defined(PDFMM_CHAR_SCAN_NEON)
+
+static uint8x16_t getWhitespaceMask(uint8x16_t chars);
+static uint8x16_t getDelimiterMask(uint8x16_t chars);
+
+#endif
+
+size_t mm::FindNonWhitespace(const char* buffer, size_t length)
+{
+    // Most of the times there are no or few whitespaces to skip
+    size_t i = 0;
+    if (length == 0 || s_charClasses[(unsigned char)buffer[0]] != Whitespace)
+        return 0;
+
+#if defined(PDFMM_CHAR_SCAN_SSE2)
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(getWhitespaceMask(chars)) ^ 0xFFFFU;
+        if (mask != 0)
+            return i + countTrailingZeros(mask);
+    }
+#elif defined(PDFMM_CHAR_SCAN_NEON)
+    for (; i + 16 <= length; i += 16)
+    {
+        uint8x16_t chars = vld1q_u8(reinterpret_cast<const uint8_t*>(buffer + i));
+        if (vminvq_u8(getWhitespaceMask(chars)) == 0)
+            break; // Find the exact position below
+    }
+#endif
+
+    for (; i < length; i++)
+    {
+        if (s_charClasses[(unsigned char)buffer[i]] != Whitespace)
+            return i;
+    }
+
+    return length;
+}
+
+size_t mm::FindWhitespaceOrDelimiter(const char* buffer, size_t length)
+{
+    size_t i = 0;
+#if defined(PDFMM_CHAR_SCAN_SSE2)
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_or_si128(getWhitespaceMask(chars), getDelimiterMask(chars)));
+        if (mask != 0)
+            return i + countTrailingZeros(mask);
+    }
+#elif defined(PDFMM_CHAR_SCAN_NEON)
+    for (; i + 16 <= length; i += 16)
+    {
+        uint8x16_t chars = vld1q_u8(reinterpret_cast<const uint8_t*>(buffer + i));
+        if (vmaxvq_u8(vorrq_u8(getWhitespaceMask(chars), getDelimiterMask(chars))) != 0)
+            break; // Find the exact position below
+    }
+#endif
+
+    for (; i < length; i++)
+    {
+        if (s_charClasses[(unsigned char)buffer[i]] != Regular)
+            return i;
+    }
+
+    return length;
+}
+
+size_t mm::FindAnyChar(const char* buffer, size_t length, char ch1, char ch2, char ch3)
+{
+    size_t i = 0;
+#if defined(PDFMM_CHAR_SCAN_SSE2)
+    __m128i chars1 = _mm_set1_epi8(ch1);
+    __m128i chars2 = _mm_set1_epi8(ch2);
+    __m128i chars3 = _mm_set1_epi8(ch3);
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(
+            _mm_cmpeq_epi8(chars, chars1), _mm_cmpeq_epi8(chars, chars2)), _mm_cmpeq_epi8(chars, chars3)));
+        if (mask != 0)
+            return i + countTrailingZeros(mask);
+    }
+#elif defined(PDFMM_CHAR_SCAN_NEON)
+    uint8x16_t chars1 = vdupq_n_u8((uint8_t)ch1);
+    uint8x16_t chars2 = vdupq_n_u8((uint8_t)ch2);
+    uint8x16_t chars3 = vdupq_n_u8((uint8_t)ch3);
+    for (; i + 16 <= length; i += 16)
+    {
+        uint8x16_t chars = vld1q_u8(reinterpret_cast<const uint8_t*>(buffer + i));
+        if (vmaxvq_u8(vorrq_u8(vorrq_u8(vceqq_u8(chars, chars1), vceqq_u8(chars, chars2)), vceqq_u8(chars, chars3))) != 0)
+            break; // Find the exact position below
+    }
+#endif
+
+    for (; i < length; i++)
+    {
+        if (buffer[i] == ch1 || buffer[i] == ch2 || buffer[i] == ch3)
+            return i;
+    }
+
+    return length;
+}
+
+#ifdef PDFMM_CHAR_SCAN_SSE2
+
+unsigned countTrailingZeros(unsigned mask)
+{
+#ifdef _MSC_VER
+    unsigned long ret;
+    _BitScanForward(&ret, mask);
+    return (unsigned)ret;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+__m128i getWhitespaceMask(__m128i chars)
+{
+    __m128i ret = _mm_cmpeq_epi8(chars, _mm_setzero_si128());
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8('\t')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8('\n')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8('\f')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8('\r')));
+    return _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')));
+}
+
+__m128i getDelimiterMask(__m128i chars)
+{
+    __m128i ret = _mm_cmpeq_epi8(chars, _mm_set1_epi8('('));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8(')')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8('<')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8('>')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8('[')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8(']')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8('{')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8('}')));
+    ret = _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8('/')));
+    return _mm_or_si128(ret, _mm_cmpeq_epi8(chars, _mm_set1_epi8('%')));
+}
+
+#elif defined(PDFMM_CHAR_SCAN_NEON)
+
+uint8x16_t getWhitespaceMask(uint8x16_t chars)
+{
+    uint8x16_t ret = vceqq_u8(chars, vdupq_n_u8(0));
+    ret = vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8('\t')));
+    ret = vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8('\n')));
+    ret = vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8('\f')));
+    ret = vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8('\r')));
+    return vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8(' ')));
+}
+
+uint8x16_t getDelimiterMask(uint8x16_t chars)
+{
+    uint8x16_t ret = vceqq_u8(chars, vdupq_n_u8('('));
+    ret = vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8(')')));
+    ret = vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8('<')));
+    ret = vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8('>')));
+    ret = vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8('[')));
+    ret = vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8(']')));
+    ret = vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8('{')));
+    ret = vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8('}')));
+    ret = vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8('/')));
+    return vorrq_u8(ret, vceqq_u8(chars, vdupq_n_u8('%')));
+}
+
+#endif
@@ -0,0 +1,39 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_CHAR_SCAN_PRIVATE_H
+#define PDF_CHAR_SCAN_PRIVATE_H
+
+namespace mm
+{
+    /** Find the first character in the buffer that is not a
+     * whitespace according to the PDF reference
+     *
+     * The search is vectorized when SSE2 or NEON are available
+     * \returns the index of the found character, or length if not found
+     */
+    size_t FindNonWhitespace(const char* buffer, size_t length);
+
+    /** Find the first character in the buffer that is either a
+     * whitespace or a delimiter according to the PDF reference,
+     * which is the end of a regular token
+     *
+     * The search is vectorized when SSE2 or NEON are available
+     * \returns the index of the found character, or length if not found
+     */
+    size_t FindWhitespaceOrDelimiter(const char* buffer, size_t length);
+
+    /** Find the first occurrence of any of the three characters
+     * in the buffer
+     *
+     * The search is vectorized when SSE2 or NEON are available
+     * \returns the index of the found character, or length if not found
+     */
+    size_t FindAnyChar(const char* buffer, size_t length, char ch1, char ch2, char ch3);
+}
+
+#endif // PDF_CHAR_SCAN_PRIVATE_H
@@ -75,6 +75,16 @@
  */
 #define VERBOSE_DEBUG_DISABLED
 
+/** \def PDFMM_MAX_LOG_SEVERITY
+ *  The integral value of the least severe PdfLogSeverity that
+ *  mm::LogMessage can log. Less severe messages are compiled out,
+ *  regardless of PdfError::SetMaxLoggingSeverity. Defaults to
+ *  PdfLogSeverity::Debug, that is every message can be logged
+ */
+#ifndef PDFMM_MAX_LOG_SEVERITY
+#define PDFMM_MAX_LOG_SEVERITY 4
+#endif
+
 // Should we do lots of extra (expensive) sanity checking?  You should not
 // define this on production builds because of the runtime cost and because it
 // might cause the library to abort() if it notices something nasty.
@@ -148,6 +158,16 @@ namespace mm
 
     std::string_view GetPdfVersionName(PdfVersion version);
 
+    /** \returns true if the values of the type are literals, that
+     *  are written spaced unless PdfWriteFlags::NoInlineLiteral is set
+     */
+    bool IsLiteralDataType(PdfDataType type);
+
+    /** \returns true if the serialization of the values of
+     *  the type ends with a delimiter, e.g. ')' or '>' for strings
+     */
+    bool IsDelimitedDataType(PdfDataType type);
+
     constexpr double DEG2RAD = std::numbers::pi / 180;
     constexpr double RAD2DEG = 180 / std::numbers::pi;
 
@@ -160,9 +180,24 @@ namespace mm
      */
     void LogMessage(PdfLogSeverity logSeverity, const std::string_view& msg);
 
+    /** \returns true if messages with the given severity are logged,
+     *  checking the compile time and the runtime maximum severities
+     */
+    inline bool IsLogMessageEnabled(PdfLogSeverity logSeverity)
+    {
+        return (int)logSeverity <= PDFMM_MAX_LOG_SEVERITY
+            && PdfError::IsLoggingSeverityEnabled(logSeverity);
+    }
+
+    /** Log a formatted message. The arguments are formatted only
+     *  if messages with the given severity are logged
+     */
     template <typename... Args>
     void LogMessage(PdfLogSeverity logSeverity, const std::string_view& msg, const Args&... args)
     {
+        if (!IsLogMessageEnabled(logSeverity))
+            return;
+
         LogMessage(logSeverity, COMMON_FORMAT(msg, args...));
     }
 }
@@ -226,14 +261,24 @@ namespace utls
 
     void ReadUtf16LEString(const mm::bufferview& buffer, std::string& utf8str);
 
+    // Format the number in fixed notation with the given
+    // maximum count of decimal digits, removing trailing zeroes
     void FormatTo(std::string& str, float value, unsigned short precision);
 
     void FormatTo(std::string& str, double value, unsigned short precision);
 
+    // Append the decimal representation of the number to the supplied string
+    void AppendNumberTo(std::string& str, int64_t value);
+
     std::string ToLower(const std::string_view& str);
 
     std::string Trim(const std::string_view& str, char ch);
 
+    /** \returns the memory allocated out of line by the string,
+     *      which is 0 when the characters are stored in the object
+     */
+    size_t GetHeapSize(const std::string& str);
+
     // https://stackoverflow.com/a/38140932/213871
     inline void hash_combine(std::size_t& seed)
     {
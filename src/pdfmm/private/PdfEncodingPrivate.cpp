@@ -10,11 +10,25 @@
 #include "PdfEncodingPrivate.h"
 
 #include <utfcpp/utf8.h>
+#include "utfcpp_extensions.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define PDFMM_ENCODING_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PDFMM_ENCODING_NEON
+#include <arm_neon.h>
+#endif
 
 using namespace std;
 using namespace mm;
 
 static const unordered_map<char32_t, char>& getUTF8ToPdfEncodingMap();
+static size_t findNonPrintableAscii(const char* buffer, size_t length);
+static size_t findNonAscii(const char* buffer, size_t length);
+static size_t findNonAsciiUTF16BE(const char* buffer, size_t length);
+static void appendAsciiAsUTF16BE(const char* buffer, size_t length, string& u16bestr);
+static void appendUTF16BEAsAscii(const char* buffer, size_t length, string& u8str);
 
 static const char32_t s_cEncoding[] = {
     0x0000,
@@ -285,6 +299,11 @@ bool mm::CheckValidUTF8ToPdfDocEcondingChars(const string_view& view, bool& isAs
     auto end = view.end();
     while (it != end)
     {
+        // Printable ASCII characters are the same in PdfDocEncoding
+        it += findNonPrintableAscii(&*it, end - it);
+        if (it == end)
+            break;
+
         cp = utf8::next(it, end);
         unordered_map<char32_t, char>::const_iterator found;
         if (cp > 0xFFFF || (found = map.find(cp)) == map.end())
@@ -330,12 +349,19 @@ bool mm::TryConvertUTF8ToPdfDocEncoding(const string_view& view, string& pdfdoce
     auto& map = getUTF8ToPdfEncodingMap();
 
     pdfdocencstr.clear();
+    pdfdocencstr.reserve(view.size());
 
     char32_t cp = 0;
     auto it = view.begin();
     auto end = view.end();
     while (it != end)
     {
+        size_t count = findNonPrintableAscii(&*it, end - it);
+        pdfdocencstr.append(&*it, count);
+        it += count;
+        if (it == end)
+            break;
+
         cp = utf8::next(it, end);
         unordered_map<char32_t, char>::const_iterator found;
         if (cp > 0xFFFF || (found = map.find(cp)) == map.end())
@@ -361,9 +387,16 @@ string mm::ConvertPdfDocEncodingToUTF8(const string_view& view, bool& isAsciiEqu
 void mm::ConvertPdfDocEncodingToUTF8(const string_view& view, string& u8str, bool& isAsciiEqual)
 {
     u8str.clear();
+    u8str.reserve(view.size());
     isAsciiEqual = true;
     for (size_t i = 0; i < view.length(); i++)
     {
+        size_t count = findNonPrintableAscii(view.data() + i, view.length() - i);
+        u8str.append(view.data() + i, count);
+        i += count;
+        if (i == view.length())
+            break;
+
         unsigned char ch = (unsigned char)view[i];
         char32_t mappedCode = s_cEncoding[ch];
         if (mappedCode >= 0x80 || ch != (char)mappedCode) // >= 128 or different mapped code
@@ -373,6 +406,67 @@ void mm::ConvertPdfDocEncodingToUTF8(const string_view& view, string& u8str, boo
     }
 }
 
+void mm::ConvertUTF16BEToUTF8(const string_view& view, string& u8str)
+{
+    if (view.size() % 2 == 1)
+        throw range_error("Invalid utf16 range");
+
+    u8str.reserve(u8str.size() + view.size() / 2);
+    const char* data = view.data();
+    size_t length = view.size();
+    size_t pos = 0;
+    while (pos < length)
+    {
+        size_t count = findNonAsciiUTF16BE(data + pos, length - pos);
+        appendUTF16BEAsAscii(data + pos, count, u8str);
+        pos += count;
+        if (pos == length)
+            break;
+
+        // Convert the run of non ASCII code units up to the next
+        // ASCII one, which can't split a surrogate pair
+        size_t end = pos + 2;
+        while (end < length && !(data[end] == 0 && (unsigned char)data[end + 1] < 0x80))
+            end += 2;
+
+        utf8::u16bechariterable iterable(data + pos, end - pos);
+        utf8::utf16to8(iterable.begin(), iterable.end(), std::back_inserter(u8str));
+        pos = end;
+    }
+}
+
+void mm::ConvertUTF8ToUTF16BE(const string_view& view, string& u16bestr)
+{
+    u16bestr.reserve(u16bestr.size() + view.size() * 2);
+    u16string u16tmp;
+    const char* data = view.data();
+    size_t length = view.size();
+    size_t pos = 0;
+    while (pos < length)
+    {
+        size_t count = findNonAscii(data + pos, length - pos);
+        appendAsciiAsUTF16BE(data + pos, count, u16bestr);
+        pos += count;
+        if (pos == length)
+            break;
+
+        // Convert the run of non ASCII bytes up to the next ASCII
+        // one, which can't split the sequence of a code point
+        size_t end = pos + 1;
+        while (end < length && (unsigned char)data[end] >= 0x80)
+            end++;
+
+        u16tmp.clear();
+        utf8::utf8to16(data + pos, data + end, std::back_inserter(u16tmp));
+        for (char16_t unit : u16tmp)
+        {
+            u16bestr.push_back((char)(unit >> 8));
+            u16bestr.push_back((char)(unit & 0xFF));
+        }
+        pos = end;
+    }
+}
+
 const unordered_map<char32_t, char>& getUTF8ToPdfEncodingMap()
 {
     struct Map : public unordered_map<char32_t, char>
@@ -394,3 +488,162 @@ const unordered_map<char32_t, char>& getUTF8ToPdfEncodingMap()
     static Map map;
     return map;
 }
+
+size_t findNonPrintableAscii(const char* buffer, size_t length)
+{
+    size_t i = 0;
+#if defined(PDFMM_ENCODING_SSE2)
+    // NOTE: Bytes >= 0x80 are negative in the signed comparisons
+    __m128i lower = _mm_set1_epi8(0x1F);
+    __m128i upper = _mm_set1_epi8(0x7F);
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+        __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(chars, lower), _mm_cmplt_epi8(chars, upper));
+        if (_mm_movemask_epi8(printable) != 0xFFFF)
+            break; // Find the exact position below
+    }
+#elif defined(PDFMM_ENCODING_NEON)
+    uint8x16_t lower = vdupq_n_u8(0x20);
+    uint8x16_t upper = vdupq_n_u8(0x7E);
+    for (; i + 16 <= length; i += 16)
+    {
+        uint8x16_t chars = vld1q_u8(reinterpret_cast<const uint8_t*>(buffer + i));
+        if (vminvq_u8(vandq_u8(vcgeq_u8(chars, lower), vcleq_u8(chars, upper))) == 0)
+            break; // Find the exact position below
+    }
+#endif
+
+    for (; i < length; i++)
+    {
+        unsigned char ch = (unsigned char)buffer[i];
+        if (ch < 0x20 || ch > 0x7E)
+            return i;
+    }
+
+    return length;
+}
+
+size_t findNonAscii(const char* buffer, size_t length)
+{
+    size_t i = 0;
+#if defined(PDFMM_ENCODING_SSE2)
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+        if (_mm_movemask_epi8(chars) != 0)
+            break; // Find the exact position below
+    }
+#elif defined(PDFMM_ENCODING_NEON)
+    for (; i + 16 <= length; i += 16)
+    {
+        uint8x16_t chars = vld1q_u8(reinterpret_cast<const uint8_t*>(buffer + i));
+        if (vmaxvq_u8(chars) >= 0x80)
+            break; // Find the exact position below
+    }
+#endif
+
+    for (; i < length; i++)
+    {
+        if ((unsigned char)buffer[i] >= 0x80)
+            return i;
+    }
+
+    return length;
+}
+
+// Returns the length in bytes of the run
+// of ASCII code units in the utf-16 BE buffer
+size_t findNonAsciiUTF16BE(const char* buffer, size_t length)
+{
+    size_t i = 0;
+#if defined(PDFMM_ENCODING_SSE2)
+    // Loaded as 16 bit little endian lanes, the code units have
+    // the high byte in the low bits: the ASCII code units have
+    // zero high byte and the low byte < 0x80
+    __m128i nonAsciiBits = _mm_set1_epi16((short)0x80FF);
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+        __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(units, nonAsciiBits), _mm_setzero_si128());
+        if (_mm_movemask_epi8(ascii) != 0xFFFF)
+            break; // Find the exact position below
+    }
+#elif defined(PDFMM_ENCODING_NEON)
+    for (; i + 32 <= length; i += 32)
+    {
+        // Deinterleave the high and the low bytes
+        uint8x16x2_t units = vld2q_u8(reinterpret_cast<const uint8_t*>(buffer + i));
+        if (vmaxvq_u8(units.val[0]) != 0 || vmaxvq_u8(units.val[1]) >= 0x80)
+            break; // Find the exact position below
+    }
+#endif
+
+    for (; i + 2 <= length; i += 2)
+    {
+        if (buffer[i] != 0 || (unsigned char)buffer[i + 1] >= 0x80)
+            return i;
+    }
+
+    return i;
+}
+
+void appendAsciiAsUTF16BE(const char* buffer, size_t length, string& u16bestr)
+{
+    size_t offset = u16bestr.size();
+    u16bestr.resize(offset + length * 2);
+    char* dst = u16bestr.data() + offset;
+    size_t i = 0;
+#if defined(PDFMM_ENCODING_SSE2)
+    for (; i + 16 <= length; i += 16)
+    {
+        // Interleave zero high bytes before the chars
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), _mm_unpacklo_epi8(_mm_setzero_si128(), chars));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2 + 16), _mm_unpackhi_epi8(_mm_setzero_si128(), chars));
+    }
+#elif defined(PDFMM_ENCODING_NEON)
+    for (; i + 16 <= length; i += 16)
+    {
+        uint8x16x2_t units;
+        units.val[0] = vdupq_n_u8(0);
+        units.val[1] = vld1q_u8(reinterpret_cast<const uint8_t*>(buffer + i));
+        vst2q_u8(reinterpret_cast<uint8_t*>(dst + i * 2), units);
+    }
+#endif
+
+    for (; i < length; i++)
+    {
+        dst[i * 2] = 0;
+        dst[i * 2 + 1] = buffer[i];
+    }
+}
+
+void appendUTF16BEAsAscii(const char* buffer, size_t length, string& u8str)
+{
+    size_t count = length / 2;
+    size_t offset = u8str.size();
+    u8str.resize(offset + count);
+    char* dst = u8str.data() + offset;
+    size_t i = 0;
+#if defined(PDFMM_ENCODING_SSE2)
+    for (; i + 16 <= count; i += 16)
+    {
+        // Shift the low bytes of the code units in
+        // the low bits of the lanes, and pack them
+        __m128i units1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i * 2));
+        __m128i units2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i * 2 + 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+            _mm_packus_epi16(_mm_srli_epi16(units1, 8), _mm_srli_epi16(units2, 8)));
+    }
+#elif defined(PDFMM_ENCODING_NEON)
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x2_t units = vld2q_u8(reinterpret_cast<const uint8_t*>(buffer + i * 2));
+        vst1q_u8(reinterpret_cast<uint8_t*>(dst + i), units.val[1]);
+    }
+#endif
+
+    for (; i < count; i++)
+        dst[i] = buffer[i * 2 + 1];
+}
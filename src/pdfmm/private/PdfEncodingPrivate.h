@@ -30,6 +30,18 @@ namespace mm
     std::string ConvertUTF8ToPdfDocEncoding(const std::string_view& view);
     std::string ConvertPdfDocEncodingToUTF8(const std::string_view& view, bool& isAsciiEqual);
     void ConvertPdfDocEncodingToUTF8(const std::string_view& view, std::string& u8str, bool& isAsciiEqual);
+
+    /** Append the utf-8 conversion of the given utf-16 BE string, without BOM
+     *
+     * Runs of ASCII characters are converted with SSE2 or NEON, when available
+     */
+    void ConvertUTF16BEToUTF8(const std::string_view& view, std::string& u8str);
+
+    /** Append the utf-16 BE conversion of the given utf-8 string, without BOM
+     *
+     * Runs of ASCII characters are converted with SSE2 or NEON, when available
+     */
+    void ConvertUTF8ToUTF16BE(const std::string_view& view, std::string& u16bestr);
 }
 
 #endif // PDF_ENCODING_PRIVATE_H
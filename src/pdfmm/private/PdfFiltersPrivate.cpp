@@ -7,8 +7,12 @@
 
 #include "PdfDeclarationsPrivate.h"
 #include "PdfFiltersPrivate.h"
+#include "PdfAsciiCodecPrivate.h"
+#include "PdfCharScanPrivate.h"
+#include "PdfPredictorPrivate.h"
 
 #include <pdfmm/base/PdfDictionary.h>
+#include <pdfmm/base/PdfImage.h>
 #include <pdfmm/base/PdfTokenizer.h>
 #include <pdfmm/base/PdfStreamDevice.h>
 
@@ -18,17 +22,6 @@ extern "C" {
 }
 #endif // PDFMM_HAVE_JPEG_LIB
 
-#ifdef PDFMM_HAVE_TIFF_LIB
-extern "C" {
-#ifdef _WIN32		// For O_RDONLY
-    // TODO: DS
-#else
-#include <sys/stat.h>
-#include <fcntl.h>
-#endif
-}
-#endif // PDFMM_HAVE_TIFF_LIB
-
 using namespace std;
 using namespace mm;
 
@@ -68,14 +61,15 @@ public:
         }
 
         m_CurrRowIndex = 0;
-        m_BytesPerPixel = (m_BytesPerComponent * m_Colors) >> 3;
+        // The filters operate on bytes, with the bytes
+        // of the pixels to the left for less than 8 bits
+        m_BytesPerPixel = std::max((m_BytesPerComponent * m_Colors) >> 3, 1);
         m_Rows = (m_ColumnCount * m_Colors * m_BytesPerComponent) >> 3;
 
         m_Prev.resize(m_Rows);
         memset(m_Prev.data(), 0, sizeof(char) * m_Rows);
-
-        m_UpperLeftPixelComponents.resize(m_BytesPerPixel);
-        memset(m_UpperLeftPixelComponents.data(), 0, sizeof(char) * m_BytesPerPixel);
+        m_Curr.resize(m_Rows);
+        m_Row.resize(m_Rows);
     }
 
     void Decode(const char* buffer, size_t len, OutputStream* stream)
@@ -86,116 +80,102 @@ public:
             return;
         }
 
-        while (len--)
+        while (len != 0)
         {
             if (m_NextByteIsPredictor)
             {
                 m_CurrPredictor = *buffer + 10;
                 m_NextByteIsPredictor = false;
+                buffer++;
+                len--;
+                continue;
+            }
+
+            // Whole rows are decoded at once, straight from the
+            // input when available, otherwise they are collected
+            const char* row;
+            size_t count = std::min(len, (size_t)(m_Rows - m_CurrRowIndex));
+            if (m_CurrRowIndex == 0 && count == (size_t)m_Rows)
+            {
+                row = buffer;
             }
             else
             {
-                switch (m_CurrPredictor)
-                {
-                    case 2: // Tiff Predictor
-                    {
-                        if (m_BytesPerComponent == 8)
-                        {   // Same as png sub
-                            int prev = (m_CurrRowIndex - m_BytesPerPixel < 0
-                                ? 0 : m_Prev[m_CurrRowIndex - m_BytesPerPixel]);
-                            m_Prev[m_CurrRowIndex] = *buffer + prev;
-                            break;
-                        }
-
-                        // TODO: implement tiff predictor for other than 8 BPC
-                        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidPredictor, "tiff predictors other than 8 BPC are not implemented");
-                        break;
-                    }
-                    case 10: // png none
-                    {
-                        m_Prev[m_CurrRowIndex] = *buffer;
-                        break;
-                    }
-                    case 11: // png sub
-                    {
-                        int prev = (m_CurrRowIndex - m_BytesPerPixel < 0
-                            ? 0 : m_Prev[m_CurrRowIndex - m_BytesPerPixel]);
-                        m_Prev[m_CurrRowIndex] = *buffer + prev;
-                        break;
-                    }
-                    case 12: // png up
-                    {
-                        m_Prev[m_CurrRowIndex] += *buffer;
-                        break;
-                    }
-                    case 13: // png average
-                    {
-                        int prev = (m_CurrRowIndex - m_BytesPerPixel < 0
-                            ? 0 : m_Prev[m_CurrRowIndex - m_BytesPerPixel]);
-                        m_Prev[m_CurrRowIndex] = ((prev + m_Prev[m_CurrRowIndex]) >> 1) + *buffer;
-                        break;
-                    }
-                    case 14: // png paeth
-                    {
-                        int nLeftByteIndex = m_CurrRowIndex - m_BytesPerPixel;
-
-                        int a = nLeftByteIndex < 0 ? 0 : static_cast<unsigned char>(m_Prev[nLeftByteIndex]);
-                        int b = static_cast<unsigned char>(m_Prev[m_CurrRowIndex]);
-
-                        int nCurrComponentIndex = m_CurrRowIndex % m_BytesPerPixel;
-                        int c = nLeftByteIndex < 0 ? 0 : static_cast<unsigned char>(m_UpperLeftPixelComponents[nCurrComponentIndex]);
-
-                        int p = a + b - c;
-
-                        int pa = p - a;
-                        if (pa < 0)
-                            pa = -pa;
-
-                        int pb = p - b;
-                        if (pb < 0)
-                            pb = -pb;
-
-                        int pc = p - c;
-                        if (pc < 0)
-                            pc = -pc;
-
-                        char closestByte;
-                        if (pa <= pb && pa <= pc)
-                            closestByte = a;
-                        else if (pb <= pc)
-                            closestByte = b;
-                        else
-                            closestByte = c;
-
-                        // Save the byte we're about to clobber for the next pixel's prediction
-                        m_UpperLeftPixelComponents[nCurrComponentIndex] = m_Prev[m_CurrRowIndex];
-
-                        m_Prev[m_CurrRowIndex] = *buffer + closestByte;
-                        break;
-                    }
-                    case 15: // png optimum
-                        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidPredictor, "png optimum predictor is not implemented");
-                        break;
-
-                    default:
-                    {
-                        //PDFMM_RAISE_ERROR( EPdfError::InvalidPredictor );
-                        break;
-                    }
+                memcpy(m_Row.data() + m_CurrRowIndex, buffer, count);
+                row = m_Row.data();
+            }
+
+            buffer += count;
+            len -= count;
+            m_CurrRowIndex += (int)count;
+            if (m_CurrRowIndex < m_Rows)
+                break;
+
+            // One line finished
+            decodeRow(row);
+            m_CurrRowIndex = 0;
+            m_NextByteIsPredictor = (m_CurrPredictor >= 10);
+            stream->Write(m_Prev.data(), m_Rows);
+        }
+    }
+
+private:
+    void decodeRow(const char* row)
+    {
+        switch (m_CurrPredictor)
+        {
+            case 2: // Tiff Predictor
+            {
+                if (m_BytesPerComponent == 8)
+                {   // Same as png sub
+                    UnfilterPngSub(m_Curr.data(), row, m_Rows, m_BytesPerPixel);
+                    break;
                 }
 
-                m_CurrRowIndex++;
+                // TODO: implement tiff predictor for other than 8 BPC
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidPredictor, "tiff predictors other than 8 BPC are not implemented");
+                break;
             }
+            case 10: // png none
+            {
+                memcpy(m_Curr.data(), row, m_Rows);
+                break;
+            }
+            case 11: // png sub
+            {
+                UnfilterPngSub(m_Curr.data(), row, m_Rows, m_BytesPerPixel);
+                break;
+            }
+            case 12: // png up
+            {
+                UnfilterPngUp(m_Curr.data(), row, m_Prev.data(), m_Rows);
+                break;
+            }
+            case 13: // png average
+            {
+                UnfilterPngAverage(m_Curr.data(), row, m_Prev.data(), m_Rows, m_BytesPerPixel);
+                break;
+            }
+            case 14: // png paeth
+            {
+                UnfilterPngPaeth(m_Curr.data(), row, m_Prev.data(), m_Rows, m_BytesPerPixel);
+                break;
+            }
+            case 15: // png optimum
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidPredictor, "png optimum predictor is not implemented");
+                break;
 
-            buffer++;
-
-            if (m_CurrRowIndex >= m_Rows)
-            {   // One line finished
-                m_CurrRowIndex = 0;
-                m_NextByteIsPredictor = (m_CurrPredictor >= 10);
-                stream->Write(m_Prev.data(), m_Rows);
+            default:
+            {
+                //PDFMM_RAISE_ERROR( EPdfError::InvalidPredictor );
+                // Repeat the previous row
+                memcpy(m_Curr.data(), m_Prev.data(), m_Rows);
+                break;
             }
         }
+
+        // The decoded row is the upper row of the next one
+        m_Prev.swap(m_Curr);
     }
 
 private:
@@ -212,12 +192,9 @@ private:
 
     bool m_NextByteIsPredictor;
 
-    charbuff m_Prev;
-
-    // The PNG Paeth predictor uses the values of the pixel above and to the left
-    // of the current pixel. But we overwrite the row above as we go, so we'll
-    // have to store the bytes of the upper-left pixel separately.
-    charbuff m_UpperLeftPixelComponents;
+    charbuff m_Prev;    // The previous decoded row
+    charbuff m_Curr;    // The row being decoded
+    charbuff m_Row;     // The encoded row, when split between input buffers
 };
 
 } // end anonymous namespace
@@ -231,19 +208,9 @@ PdfHexFilter::PdfHexFilter()
 
 void PdfHexFilter::EncodeBlockImpl(const char* buffer, size_t len)
 {
-    char data[2];
-    while (len--)
-    {
-        data[0] = (*buffer & 0xF0) >> 4;
-        data[0] += (data[0] > 9 ? 'A' - 10 : '0');
-
-        data[1] = (*buffer & 0x0F);
-        data[1] += (data[1] > 9 ? 'A' - 10 : '0');
-
-        GetStream()->Write(data, 2);
-
-        buffer++;
-    }
+    m_buffer.resize(len * 2);
+    mm::EncodeHexDigits(m_buffer.data(), buffer, len);
+    GetStream()->Write(m_buffer.data(), m_buffer.size());
 }
 
 void PdfHexFilter::BeginDecodeImpl(const PdfDictionary*)
@@ -254,16 +221,33 @@ void PdfHexFilter::BeginDecodeImpl(const PdfDictionary*)
 
 void PdfHexFilter::DecodeBlockImpl(const char* buffer, size_t len)
 {
-    unsigned char val;
-    while (len--)
+    // The runs of digits are decoded in bulk, the whitespaces
+    // are skipped in bulk and the other characters one by one
+    m_buffer.resize(len / 2 + 1);
+    char* decoded = m_buffer.data();
+    size_t i = 0;
+    while (i < len)
     {
-        if (PdfTokenizer::IsWhitespace(*buffer))
+        if (m_Low)
         {
-            buffer++;
+            size_t read = mm::DecodeHexDigits(decoded, buffer + i, len - i);
+            decoded += read / 2;
+            i += read;
+            if (i == len)
+                break;
+        }
+
+        if (PdfTokenizer::IsWhitespace(buffer[i]))
+        {
+            i += mm::FindNonWhitespace(buffer + i, len - i);
             continue;
         }
 
-        (void)utls::TryGetHexValue(*buffer, val);
+        // NOTE: Invalid characters are decoded as 0
+        unsigned char val;
+        if (!utls::TryGetHexValue(buffer[i], val))
+            val = 0;
+
         if (m_Low)
         {
             m_DecodedByte = (char)(val & 0x0F);
@@ -273,21 +257,23 @@ void PdfHexFilter::DecodeBlockImpl(const char* buffer, size_t len)
         {
             m_DecodedByte = (char)((m_DecodedByte << 4) | val);
             m_Low = true;
-
-            GetStream()->Write(&m_DecodedByte, 1);
+            *decoded++ = m_DecodedByte;
         }
 
-        buffer++;
+        i++;
     }
+
+    GetStream()->Write(m_buffer.data(), (size_t)(decoded - m_buffer.data()));
 }
 
 void PdfHexFilter::EndDecodeImpl()
 {
     if (!m_Low)
     {
-        // an odd number of bytes was read,
-        // so the last byte is 0
-        GetStream()->Write(&m_DecodedByte, 1);
+        // An odd number of digits was read,
+        // so the last digit is 0
+        char decoded = (char)(m_DecodedByte << 4);
+        GetStream()->Write(&decoded, 1);
     }
 }
 
@@ -336,34 +322,41 @@ void PdfAscii85Filter::BeginEncodeImpl()
 
 void PdfAscii85Filter::EncodeBlockImpl(const char* buffer, size_t len)
 {
-    unsigned c;
-    const char* z = "z";
+    m_buffer.resize((len / 4 + 1) * 5);
+    char* encoded = m_buffer.data();
 
-    while (len)
-    {
-        c = *buffer & 0xFF;
-        switch (m_count++) {
-            case 0: m_tuple |= (c << 24); break;
-            case 1: m_tuple |= (c << 16); break;
-            case 2: m_tuple |= (c << 8); break;
-            case 3:
-                m_tuple |= c;
-                if (m_tuple == 0)
-                {
-                    GetStream()->Write(z, 1);
-                }
-                else
-                {
-                    this->EncodeTuple(m_tuple, m_count);
-                }
+    // Complete the tuple of the previous block, then encode
+    // the whole groups in bulk and keep the rest for later
+    for (; len != 0 && m_count != 0; len--, buffer++)
+        encoded += addEncodedByte(encoded, (unsigned char)*buffer);
 
-                m_tuple = 0;
-                m_count = 0;
-                break;
-        }
-        len--;
-        buffer++;
-    }
+    size_t groupCount = len / 4;
+    encoded += mm::EncodeAscii85Groups(encoded, buffer, groupCount);
+    buffer += groupCount * 4;
+    len -= groupCount * 4;
+
+    for (; len != 0; len--, buffer++)
+        encoded += addEncodedByte(encoded, (unsigned char)*buffer);
+
+    GetStream()->Write(m_buffer.data(), (size_t)(encoded - m_buffer.data()));
+}
+
+size_t PdfAscii85Filter::addEncodedByte(char* encoded, unsigned char ch)
+{
+    m_tuple |= (unsigned)ch << (24 - m_count * 8);
+    m_count++;
+    if (m_count != 4)
+        return 0;
+
+    char group[4] = {
+        static_cast<char>(m_tuple >> 24),
+        static_cast<char>(m_tuple >> 16),
+        static_cast<char>(m_tuple >> 8),
+        static_cast<char>(m_tuple),
+    };
+    m_tuple = 0;
+    m_count = 0;
+    return mm::EncodeAscii85Groups(encoded, group, 1);
 }
 
 void PdfAscii85Filter::EndEncodeImpl()
@@ -381,33 +374,44 @@ void PdfAscii85Filter::BeginDecodeImpl(const PdfDictionary*)
 
 void PdfAscii85Filter::DecodeBlockImpl(const char* buffer, size_t len)
 {
+    // NOTE: Every 'z' is decoded as 4 bytes
+    m_buffer.resize(len * 4);
+    char* decoded = m_buffer.data();
     bool foundEndMarker = false;
-
     while (len != 0 && !foundEndMarker)
     {
-        switch (*buffer)
+        size_t digitCount = mm::FindNonAscii85Digit(buffer, len);
+        if (digitCount != 0)
         {
-            default:
-                if (*buffer < '!' || *buffer > 'u')
-                {
-                    PDFMM_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
-                }
+            // Complete the tuple of the previous characters, then
+            // decode the whole groups in bulk and keep the rest
+            size_t read = 0;
+            for (; read < digitCount && m_count != 0; read++)
+                decoded += addDecodedDigit(decoded, buffer[read]);
+
+            size_t groupCount = (digitCount - read) / 5;
+            mm::DecodeAscii85Groups(decoded, buffer + read, groupCount);
+            decoded += groupCount * 4;
+            read += groupCount * 5;
+
+            for (; read < digitCount; read++)
+                decoded += addDecodedDigit(decoded, buffer[read]);
+
+            buffer += digitCount;
+            len -= digitCount;
+            continue;
+        }
 
-                m_tuple += (*buffer - '!') * s_Powers85[m_count++];
-                if (m_count == 5)
-                {
-                    WidePut(m_tuple, 4);
-                    m_count = 0;
-                    m_tuple = 0;
-                }
-                break;
+        switch (*buffer)
+        {
             case 'z':
                 if (m_count != 0)
                 {
                     PDFMM_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
                 }
 
-                this->WidePut(0, 4);
+                std::memset(decoded, 0, 4);
+                decoded += 4;
                 break;
             case '~':
                 buffer++;
@@ -418,13 +422,39 @@ void PdfAscii85Filter::DecodeBlockImpl(const char* buffer, size_t len)
                 foundEndMarker = true;
                 break;
             case '\n': case '\r': case '\t': case ' ':
-            case '\0': case '\f': case '\b': case 0177:
+            case '\0': case '\f':
+            {
+                size_t skip = mm::FindNonWhitespace(buffer, len);
+                buffer += skip;
+                len -= skip;
+                continue;
+            }
+            case '\b': case 0177:
                 break;
+            default:
+                PDFMM_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
         }
 
         len--;
         buffer++;
     }
+
+    GetStream()->Write(m_buffer.data(), (size_t)(decoded - m_buffer.data()));
+}
+
+size_t PdfAscii85Filter::addDecodedDigit(char* decoded, char ch)
+{
+    m_tuple += (ch - '!') * s_Powers85[m_count++];
+    if (m_count != 5)
+        return 0;
+
+    decoded[0] = static_cast<char>(m_tuple >> 24);
+    decoded[1] = static_cast<char>(m_tuple >> 16);
+    decoded[2] = static_cast<char>(m_tuple >> 8);
+    decoded[3] = static_cast<char>(m_tuple);
+    m_count = 0;
+    m_tuple = 0;
+    return 4;
 }
 
 void PdfAscii85Filter::EndDecodeImpl()
@@ -470,20 +500,15 @@ void PdfAscii85Filter::WidePut(unsigned tuple, int bytes) const
 
 #pragma endregion PdfFlateFilter
 
-PdfFlateFilter::PdfFlateFilter()
+PdfFlateFilter::PdfFlateFilter(PdfCompressionLevel level)
+    : m_Level(level)
 {
     memset(m_buffer, 0, sizeof(m_buffer));
-    memset(&m_stream, 0, sizeof(m_stream));
 }
 
 void PdfFlateFilter::BeginEncodeImpl()
 {
-    m_stream.zalloc = Z_NULL;
-    m_stream.zfree = Z_NULL;
-    m_stream.opaque = Z_NULL;
-
-    if (deflateInit(&m_stream, Z_DEFAULT_COMPRESSION))
-        PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
+    m_deflate = AcquireDeflateContext(getZlibLevel());
 }
 
 void PdfFlateFilter::EncodeBlockImpl(const char* buffer, size_t len)
@@ -495,21 +520,22 @@ void PdfFlateFilter::EncodeBlockInternal(const char* buffer, size_t len, int nMo
 {
     int nWrittenData = 0;
 
-    m_stream.avail_in = static_cast<unsigned>(len);
-    m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(buffer));
+    m_deflate->avail_in = static_cast<unsigned>(len);
+    m_deflate->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(buffer));
 
     do
     {
-        m_stream.avail_out = PDFMM_FILTER_INTERNAL_BUFFER_SIZE;
-        m_stream.next_out = m_buffer;
+        m_deflate->avail_out = PDFMM_FILTER_INTERNAL_BUFFER_SIZE;
+        m_deflate->next_out = m_buffer;
 
-        if (deflate(&m_stream, nMode) == Z_STREAM_ERROR)
+        if (deflate(m_deflate.get(), nMode) == Z_STREAM_ERROR)
         {
+            m_deflate.reset();
             FailEncodeDecode();
             PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
         }
 
-        nWrittenData = PDFMM_FILTER_INTERNAL_BUFFER_SIZE - m_stream.avail_out;
+        nWrittenData = PDFMM_FILTER_INTERNAL_BUFFER_SIZE - m_deflate->avail_out;
         try
         {
             if (nWrittenData > 0)
@@ -520,30 +546,26 @@ void PdfFlateFilter::EncodeBlockInternal(const char* buffer, size_t len, int nMo
         catch (PdfError& e)
         {
             // clean up after any output stream errors
+            m_deflate.reset();
             FailEncodeDecode();
             PDFMM_PUSH_FRAME(e);
             throw e;
         }
-    } while (m_stream.avail_out == 0);
+    } while (m_deflate->avail_out == 0);
 }
 
 void PdfFlateFilter::EndEncodeImpl()
 {
     this->EncodeBlockInternal(nullptr, 0, Z_FINISH);
-    deflateEnd(&m_stream);
+    m_deflate.reset();
 }
 
 void PdfFlateFilter::BeginDecodeImpl(const PdfDictionary* decodeParms)
 {
-    m_stream.zalloc = Z_NULL;
-    m_stream.zfree = Z_NULL;
-    m_stream.opaque = Z_NULL;
-
     if (decodeParms != nullptr)
         m_Predictor.reset(new PdfPredictorDecoder(*decodeParms));
 
-    if (inflateInit(&m_stream) != Z_OK)
-        PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
+    m_inflate = AcquireInflateContext();
 }
 
 void PdfFlateFilter::DecodeBlockImpl(const char* buffer, size_t len)
@@ -551,22 +573,22 @@ void PdfFlateFilter::DecodeBlockImpl(const char* buffer, size_t len)
     int flateErr;
     unsigned writtenDataSize;
 
-    m_stream.avail_in = static_cast<unsigned>(len);
-    m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(buffer));
+    m_inflate->avail_in = static_cast<unsigned>(len);
+    m_inflate->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(buffer));
 
     do
     {
-        m_stream.avail_out = PDFMM_FILTER_INTERNAL_BUFFER_SIZE;
-        m_stream.next_out = m_buffer;
+        m_inflate->avail_out = PDFMM_FILTER_INTERNAL_BUFFER_SIZE;
+        m_inflate->next_out = m_buffer;
 
-        switch ((flateErr = inflate(&m_stream, Z_NO_FLUSH)))
+        switch ((flateErr = inflate(m_inflate.get(), Z_NO_FLUSH)))
         {
             case Z_NEED_DICT:
             case Z_DATA_ERROR:
             case Z_MEM_ERROR:
             {
                 mm::LogMessage(PdfLogSeverity::Error, "Flate Decoding Error from ZLib: {}", flateErr);
-                (void)inflateEnd(&m_stream);
+                m_inflate.reset();
 
                 FailEncodeDecode();
                 PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
@@ -575,7 +597,7 @@ void PdfFlateFilter::DecodeBlockImpl(const char* buffer, size_t len)
                 break;
         }
 
-        writtenDataSize = PDFMM_FILTER_INTERNAL_BUFFER_SIZE - m_stream.avail_out;
+        writtenDataSize = PDFMM_FILTER_INTERNAL_BUFFER_SIZE - m_inflate->avail_out;
         try
         {
             if (m_Predictor != nullptr)
@@ -585,26 +607,191 @@ void PdfFlateFilter::DecodeBlockImpl(const char* buffer, size_t len)
         }
         catch (PdfError& e)
         {
-            // clean up after any output stream errors
+            // clean up after any output stream errors, e.g.
+            // when the decoded data reached a size limit
+            m_inflate.reset();
             FailEncodeDecode();
             PDFMM_PUSH_FRAME(e);
             throw e;
         }
-    } while (m_stream.avail_out == 0);
+    } while (m_inflate->avail_out == 0);
 }
 
 void PdfFlateFilter::EndDecodeImpl()
 {
-    (void)inflateEnd(&m_stream);
+    m_inflate.reset();
     m_Predictor.reset();
 }
 
+#ifdef PDFMM_HAVE_LIBDEFLATE
+
+namespace
+{
+    struct LibdeflateReleaser
+    {
+        void operator()(libdeflate_compressor* compressor) const { libdeflate_free_compressor(compressor); }
+        void operator()(libdeflate_decompressor* decompressor) const { libdeflate_free_decompressor(decompressor); }
+    };
+}
+
+// The libdeflate state is reused by the thread, as the zlib
+// contexts, one compressor for every level from 0 to 12
+static thread_local unique_ptr<libdeflate_compressor, LibdeflateReleaser> s_compressors[13];
+static thread_local unique_ptr<libdeflate_decompressor, LibdeflateReleaser> s_decompressor;
+
+bool PdfFlateFilter::EncodeToImpl(charbuff& outBuffer, const bufferview& inBuffer)
+{
+    // libdeflate levels range from 0 to 12, 6 being its default
+    int level = m_Level == PdfCompressionLevel::Default ? 6 : std::min((int)m_Level, 12);
+    auto& compressor = s_compressors[level];
+    if (compressor == nullptr)
+    {
+        compressor.reset(libdeflate_alloc_compressor(level));
+        if (compressor == nullptr)
+            PDFMM_RAISE_ERROR(PdfErrorCode::OutOfMemory);
+    }
+
+    size_t offset = outBuffer.size();
+    outBuffer.resize(offset + libdeflate_zlib_compress_bound(compressor.get(), inBuffer.size()));
+    size_t size = libdeflate_zlib_compress(compressor.get(), inBuffer.data(), inBuffer.size(),
+        outBuffer.data() + offset, outBuffer.size() - offset);
+    if (size == 0)
+    {
+        outBuffer.resize(offset);
+        PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
+    }
+
+    outBuffer.resize(offset + size);
+    return true;
+}
+
+bool PdfFlateFilter::DecodeToImpl(charbuff& outBuffer, const bufferview& inBuffer, const PdfDictionary* decodeParms)
+{
+    // Predictors are applied progressively
+    if (decodeParms != nullptr)
+        return false;
+
+    auto& decompressor = s_decompressor;
+    if (decompressor == nullptr)
+    {
+        decompressor.reset(libdeflate_alloc_decompressor());
+        if (decompressor == nullptr)
+            PDFMM_RAISE_ERROR(PdfErrorCode::OutOfMemory);
+    }
+
+    // The decoded size is unknown, so grow the
+    // output until the whole data fits in it
+    size_t offset = outBuffer.size();
+    size_t capacity = std::max(inBuffer.size() * 4, (size_t)PDFMM_FILTER_INTERNAL_BUFFER_SIZE);
+    while (true)
+    {
+        outBuffer.resize(offset + capacity);
+        size_t size;
+        switch (libdeflate_zlib_decompress(decompressor.get(), inBuffer.data(), inBuffer.size(),
+            outBuffer.data() + offset, capacity, &size))
+        {
+            case LIBDEFLATE_SUCCESS:
+                outBuffer.resize(offset + size);
+                return true;
+            case LIBDEFLATE_INSUFFICIENT_SPACE:
+                capacity *= 2;
+                break;
+            default:
+                // Let zlib handle damaged or truncated data
+                outBuffer.resize(offset);
+                return false;
+        }
+    }
+}
+
+#else // PDFMM_HAVE_LIBDEFLATE
+
+bool PdfFlateFilter::EncodeToImpl(charbuff& outBuffer, const bufferview& inBuffer)
+{
+    if (inBuffer.size() > numeric_limits<uInt>::max())
+        return false;
+
+    auto stream = AcquireDeflateContext(getZlibLevel());
+
+    // Deflate directly into the output, sized with the worst case bound
+    size_t offset = outBuffer.size();
+    size_t bound = deflateBound(stream.get(), static_cast<uLong>(inBuffer.size()));
+    if (bound > numeric_limits<uInt>::max())
+        return false;
+
+    outBuffer.resize(offset + bound);
+    stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(inBuffer.data()));
+    stream->avail_in = static_cast<uInt>(inBuffer.size());
+    stream->next_out = reinterpret_cast<Bytef*>(outBuffer.data() + offset);
+    stream->avail_out = static_cast<uInt>(bound);
+    int rc = deflate(stream.get(), Z_FINISH);
+    size_t size = bound - stream->avail_out;
+    if (rc != Z_STREAM_END)
+    {
+        outBuffer.resize(offset);
+        PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
+    }
+
+    outBuffer.resize(offset + size);
+    return true;
+}
+
+bool PdfFlateFilter::DecodeToImpl(charbuff& outBuffer, const bufferview& inBuffer, const PdfDictionary* decodeParms)
+{
+    // Predictors are applied progressively
+    if (decodeParms != nullptr || inBuffer.size() > numeric_limits<uInt>::max())
+        return false;
+
+    auto stream = AcquireInflateContext();
+
+    // Inflate directly into the output, growing
+    // it until the whole data fits in it
+    size_t offset = outBuffer.size();
+    size_t capacity = std::max(inBuffer.size() * 4, (size_t)PDFMM_FILTER_INTERNAL_BUFFER_SIZE);
+    size_t size = 0;
+    stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(inBuffer.data()));
+    stream->avail_in = static_cast<uInt>(inBuffer.size());
+    int rc;
+    do
+    {
+        if (size == capacity)
+            capacity *= 2;
+
+        outBuffer.resize(offset + capacity);
+        uInt available = static_cast<uInt>(std::min(capacity - size, (size_t)numeric_limits<uInt>::max()));
+        stream->next_out = reinterpret_cast<Bytef*>(outBuffer.data() + offset + size);
+        stream->avail_out = available;
+        rc = inflate(stream.get(), Z_NO_FLUSH);
+        size += available - stream->avail_out;
+        if (rc == Z_NEED_DICT || rc == Z_DATA_ERROR || rc == Z_MEM_ERROR)
+        {
+            // Let the progressive decoding report the error
+            outBuffer.resize(offset);
+            return false;
+        }
+    } while (rc != Z_STREAM_END && stream->avail_out == 0);
+
+    outBuffer.resize(offset + size);
+    return true;
+}
+
+#endif // PDFMM_HAVE_LIBDEFLATE
+
+int PdfFlateFilter::getZlibLevel() const
+{
+    // zlib levels range from 0 to 9
+    if (m_Level == PdfCompressionLevel::Default)
+        return Z_DEFAULT_COMPRESSION;
+
+    return std::min((int)m_Level, Z_BEST_COMPRESSION);
+}
+
 #pragma endregion // PdfFlateFilter
 
 #pragma region PdfRLEFilter
 
 PdfRLEFilter::PdfRLEFilter()
-    : m_CodeLen(0)
+    : m_CodeLen(0), m_Finished(false)
 {
 }
 
@@ -626,34 +813,43 @@ void PdfRLEFilter::EndEncodeImpl()
 void PdfRLEFilter::BeginDecodeImpl(const PdfDictionary*)
 {
     m_CodeLen = 0;
+    m_Finished = false;
 }
 
 void PdfRLEFilter::DecodeBlockImpl(const char* buffer, size_t len)
 {
-    while (len-- != 0)
+    // The literals are written at once, as far as the block
+    // goes, and the runs are written from a filled buffer
+    const char* end = buffer + len;
+    while (buffer != end && !m_Finished)
     {
-        if (m_CodeLen == 0)
-        {
-            m_CodeLen = static_cast<int>(*buffer);
-        }
-        else if (m_CodeLen == 128)
+        if (m_CodeLen > 0)
         {
-            break;
+            size_t count = std::min((size_t)m_CodeLen, (size_t)(end - buffer));
+            GetStream()->Write(buffer, count);
+            buffer += count;
+            m_CodeLen -= (int)count;
         }
-        else if (m_CodeLen <= 127)
+        else if (m_CodeLen < 0)
         {
-            GetStream()->Write(buffer, 1);
-            m_CodeLen--;
+            char run[128];
+            std::memset(run, *buffer, (size_t)-m_CodeLen);
+            GetStream()->Write(run, (size_t)-m_CodeLen);
+            buffer++;
+            m_CodeLen = 0;
         }
-        else if (m_CodeLen >= 129)
+        else
         {
-            m_CodeLen = 257 - m_CodeLen;
-
-            while (m_CodeLen--)
-                GetStream()->Write(buffer, 1);
+            // 0 to 127 are followed by 1 to 128 literal bytes, 129 to
+            // 255 by a byte repeated 128 to 2 times, 128 ends the data
+            unsigned char length = (unsigned char)*buffer++;
+            if (length < 128)
+                m_CodeLen = length + 1;
+            else if (length == 128)
+                m_Finished = true;
+            else
+                m_CodeLen = -(257 - length);
         }
-
-        buffer++;
     }
 }
 
@@ -661,15 +857,20 @@ void PdfRLEFilter::DecodeBlockImpl(const char* buffer, size_t len)
 
 #pragma region PdfLZWFilter
 
-const unsigned short PdfLZWFilter::s_masks[] = { 0x01FF, 0x03FF, 0x07FF, 0x0FFF };
+static constexpr unsigned LzwTableSize = 4096;
+static constexpr unsigned LzwNoCode = LzwTableSize;
+
 const unsigned short PdfLZWFilter::s_clear = 0x0100;      // clear table
 const unsigned short PdfLZWFilter::s_eod = 0x0101;      // end of data
 
 PdfLZWFilter::PdfLZWFilter() :
-    m_mask(0),
+    m_nextCode(0),
+    m_prevCode(LzwNoCode),
     m_code_len(0),
-    m_character(0),
-    m_First(false)
+    m_EarlyChange(1),
+    m_bits(0),
+    m_bitCount(0),
+    m_Finished(false)
 {
 }
 
@@ -690,111 +891,107 @@ void PdfLZWFilter::EndEncodeImpl()
 
 void PdfLZWFilter::BeginDecodeImpl(const PdfDictionary* decodeParms)
 {
-    m_mask = 0;
-    m_code_len = 9;
-    m_character = 0;
-
-    m_First = true;
-
+    m_bits = 0;
+    m_bitCount = 0;
+    m_Finished = false;
+    m_EarlyChange = 1;
     if (decodeParms != nullptr)
+    {
+        m_EarlyChange = decodeParms->FindKeyAs<int64_t>("EarlyChange", 1) == 0 ? 0 : 1;
         m_Predictor.reset(new PdfPredictorDecoder(*decodeParms));
+    }
 
     InitTable();
 }
 
 void PdfLZWFilter::DecodeBlockImpl(const char* buffer, size_t len)
 {
-    unsigned buffer_size = 0;
-    const unsigned buffer_max = 24;
-
-    uint32_t old = 0;
-    uint32_t code = 0;
-    uint32_t codeBuff = 0;
-
-    TLzwItem item;
-
-    vector<unsigned char> data;
-    if (m_First)
+    // The strings of all the codes of the block are written
+    // in a single buffer, which is written once at the end
+    size_t pos = 0;
+    size_t inputPos = 0;
+    while (!m_Finished)
     {
-        m_character = *buffer;
-        m_First = false;
-    }
-
-    while (len)
-    {
-        // Fill the buffer
-        while (buffer_size <= (buffer_max - 8) && len)
+        if (m_bitCount < m_code_len)
         {
-            codeBuff <<= 8;
-            codeBuff |= static_cast<uint32_t>(static_cast<unsigned char>(*buffer));
-            buffer_size += 8;
-
-            buffer++;
-            len--;
+            fillBits(buffer, len, inputPos);
+            if (m_bitCount < m_code_len)
+                break; // Wait for more data
         }
 
-        // read from the buffer
-        while (buffer_size >= m_code_len)
+        unsigned code = (unsigned)(m_bits >> (64 - m_code_len));
+        m_bits <<= m_code_len;
+        m_bitCount -= m_code_len;
+
+        if (code == PdfLZWFilter::s_clear)
+        {
+            InitTable();
+            continue;
+        }
+        else if (code == PdfLZWFilter::s_eod)
         {
-            code = (codeBuff >> (buffer_size - m_code_len)) & PdfLZWFilter::s_masks[m_mask];
-            buffer_size -= m_code_len;
+            m_Finished = true;
+            break;
+        }
 
-            if (code == PdfLZWFilter::s_clear)
-            {
-                m_mask = 0;
-                m_code_len = 9;
+        if (m_prevCode == LzwNoCode)
+        {
+            // The first code after a clear is always a single byte
+            if (code >= PdfLZWFilter::s_clear)
+                PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Invalid LZW code");
 
-                InitTable();
-            }
-            else if (code == PdfLZWFilter::s_eod)
-            {
-                len = 0;
-                break;
-            }
-            else
-            {
-                if (code >= m_table.size())
-                {
-                    if (old >= m_table.size())
-                    {
-                        PDFMM_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
-                    }
-                    data = m_table[old].value;
-                    data.push_back(m_character);
-                }
-                else
-                    data = m_table[code].value;
+            pos = writeCode(code, pos);
+            m_prevCode = code;
+            continue;
+        }
 
-                // Write data to the output device
-                if (m_Predictor != nullptr)
-                    m_Predictor->Decode(reinterpret_cast<char*>(&(data[0])), data.size(), GetStream());
-                else
-                    GetStream()->Write(reinterpret_cast<char*>(&(data[0])), data.size());
+        unsigned char first;
+        if (code < m_nextCode)
+        {
+            pos = writeCode(code, pos);
+            first = m_table[code].First;
+        }
+        else if (code == m_nextCode && m_nextCode < LzwTableSize)
+        {
+            // The code being defined: the previous string
+            // followed by its own first byte
+            pos = writeCode(m_prevCode, pos);
+            first = m_table[m_prevCode].First;
+            m_buffer.resize(std::max(m_buffer.size(), pos + 1));
+            m_buffer[pos] = (char)first;
+            pos++;
+        }
+        else
+        {
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Invalid LZW code");
+        }
 
-                m_character = data[0];
-                if (old < m_table.size()) // fix the first loop
-                    data = m_table[old].value;
-                data.push_back(m_character);
+        if (m_nextCode < LzwTableSize)
+        {
+            auto& prev = m_table[m_prevCode];
+            m_table[m_nextCode] = { (uint16_t)m_prevCode, (uint16_t)(prev.Length + 1), first, prev.First };
+            m_nextCode++;
+
+            // With early change the code length increases one code before
+            unsigned limit = m_nextCode + m_EarlyChange;
+            if (limit >= 2048)
+                m_code_len = 12;
+            else if (limit >= 1024)
+                m_code_len = 11;
+            else if (limit >= 512)
+                m_code_len = 10;
+        }
 
-                item.value = data;
-                m_table.push_back(item);
+        m_prevCode = code;
+    }
 
-                old = code;
+    if (pos == 0)
+        return;
 
-                switch (m_table.size())
-                {
-                    case 511:
-                    case 1023:
-                    case 2047:
-                        m_code_len++;
-                        m_mask++;
-                        break;
-                    default:
-                        break;
-                }
-            }
-        }
-    }
+    if (m_Predictor != nullptr)
+        m_Predictor->Decode(m_buffer.data(), pos, GetStream());
+    else
+        GetStream()->Write(m_buffer.data(), pos);
 }
 
 void PdfLZWFilter::EndDecodeImpl()
@@ -804,22 +1001,56 @@ void PdfLZWFilter::EndDecodeImpl()
 
 void PdfLZWFilter::InitTable()
 {
-    constexpr unsigned LZW_TABLE_SIZE = 4096;
-    TLzwItem item;
+    m_table.resize(LzwTableSize);
+    for (unsigned i = 0; i <= 255; i++)
+        m_table[i] = { (uint16_t)LzwNoCode, 1, (unsigned char)i, (unsigned char)i };
 
-    m_table.clear();
-    m_table.reserve(LZW_TABLE_SIZE);
+    m_nextCode = PdfLZWFilter::s_eod + 1;
+    m_prevCode = LzwNoCode;
+    m_code_len = 9;
+}
 
-    for (int i = 0; i <= 255; i++)
+void PdfLZWFilter::fillBits(const char* buffer, size_t len, size_t& pos)
+{
+    if (len - pos >= 8)
     {
-        item.value.clear();
-        item.value.push_back(static_cast<unsigned char>(i));
-        m_table.push_back(item);
+        // Take as many whole bytes of a big endian
+        // 64 bits word as there is room for
+        uint64_t word;
+        std::memcpy(&word, buffer + pos, 8);
+        word = FROM_BIG_ENDIAN(word);
+        unsigned count = (64 - m_bitCount) / 8;
+        uint64_t bits = word >> m_bitCount;
+        unsigned unused = 64 - m_bitCount - count * 8;
+        m_bits |= bits & ~((uint64_t(1) << unused) - 1);
+        m_bitCount += count * 8;
+        pos += count;
+        return;
     }
 
-    // Add dummy entry, which is never used by decoder
-    item.value.clear();
-    m_table.push_back(item);
+    for (; pos < len && m_bitCount <= 56; pos++)
+    {
+        m_bits |= (uint64_t)(unsigned char)buffer[pos] << (56 - m_bitCount);
+        m_bitCount += 8;
+    }
+}
+
+size_t PdfLZWFilter::writeCode(unsigned code, size_t pos)
+{
+    // Write the string backwards following the prefixes
+    unsigned length = m_table[code].Length;
+    if (pos + length > m_buffer.size())
+        m_buffer.resize(std::max(m_buffer.size() * 2, pos + length + LzwTableSize));
+
+    char* dst = m_buffer.data() + pos + length - 1;
+    for (unsigned i = 0; i < length; i++)
+    {
+        auto& entry = m_table[code];
+        *dst-- = (char)entry.Suffix;
+        code = entry.Prefix;
+    }
+
+    return pos + length;
 }
 
 #pragma endregion // PdfLZWFilter
@@ -852,12 +1083,7 @@ extern "C"
 /*
  * The actual filter implementation
  */
-PdfDCTFilter::PdfDCTFilter()
-    : m_Device(nullptr)
-{
-    memset(&m_cinfo, 0, sizeof(struct jpeg_decompress_struct));
-    memset(&m_jerr, 0, sizeof(struct jpeg_error_mgr));
-}
+PdfDCTFilter::PdfDCTFilter() { }
 
 void PdfDCTFilter::BeginEncodeImpl()
 {
@@ -876,83 +1102,163 @@ void PdfDCTFilter::EndEncodeImpl()
 
 void PdfDCTFilter::BeginDecodeImpl(const PdfDictionary*)
 {
-    // Setup variables for JPEGLib
-    string error;
-    m_cinfo.client_data = &error;
-    m_cinfo.err = jpeg_std_error(&m_jerr);
-    m_jerr.error_exit = &JPegErrorExit;
-    m_jerr.emit_message = &JPegErrorOutput;
-
-    jpeg_create_decompress(&m_cinfo);
-
-    if (error.length() != 0)
-        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedImageFormat, error);
-
-    m_Device = new StringStreamDevice(m_buffer);
+    m_buffer.clear();
 }
 
 void PdfDCTFilter::DecodeBlockImpl(const char* buffer, size_t len)
 {
-    m_Device->Write(string_view(buffer, len));
+    m_buffer.append(buffer, len);
 }
 
 void PdfDCTFilter::EndDecodeImpl()
 {
-    delete m_Device;
-    m_Device = nullptr;
+    unsigned width;
+    unsigned height;
+    unsigned componentCount;
+    m_decoded.clear();
+    DecodeJpeg(m_decoded, m_buffer, { }, width, height, componentCount);
+    GetStream()->Write(m_decoded.data(), m_decoded.size());
+}
+
+void mm::DecodeJpeg(charbuff& output, const bufferview& input, const PdfJpegDecodeOptions& options,
+    unsigned& width, unsigned& height, unsigned& componentCount)
+{
+    unsigned denom = options.ScaleDenominator;
+    if (denom != 1 && denom != 2 && denom != 4 && denom != 8)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The JPEG scale must be 1/1, 1/2, 1/4 or 1/8");
+
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    string error;
+    cinfo.client_data = &error;
+    cinfo.err = jpeg_std_error(&jerr);
+    jerr.error_exit = &JPegErrorExit;
+    jerr.emit_message = &JPegErrorOutput;
 
-    mm::jpeg_memory_src(&m_cinfo, reinterpret_cast<JOCTET*>(m_buffer.data()), m_buffer.size());
+    jpeg_create_decompress(&cinfo);
 
-    if (jpeg_read_header(&m_cinfo, TRUE) <= 0)
+    auto checkError = [&]() {
+        if (error.length() != 0)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedImageFormat, error);
+    };
+
+    try
     {
-        jpeg_destroy_decompress(&m_cinfo);
+        checkError();
+        mm::jpeg_memory_src(&cinfo, reinterpret_cast<const JOCTET*>(input.data()), input.size());
+        if (jpeg_read_header(&cinfo, TRUE) <= 0)
+        {
+            checkError();
+            PDFMM_RAISE_ERROR(PdfErrorCode::UnexpectedEOF);
+        }
 
-        PDFMM_RAISE_ERROR(PdfErrorCode::UnexpectedEOF);
-    }
+        // The scaling is done by the IDCT, with smaller
+        // transforms, so the skipped pixels are never computed
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = denom;
+        jpeg_start_decompress(&cinfo);
+        checkError();
 
-    jpeg_start_decompress(&m_cinfo);
+        componentCount = (unsigned)cinfo.output_components;
+        if (componentCount != 1 && componentCount != 3 && componentCount != 4)
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "DCTDecode unknown components");
 
-    unsigned rowBytes = (unsigned)(m_cinfo.output_width * m_cinfo.output_components);
-    const int componentCount = m_cinfo.output_components;
+        unsigned imageWidth = cinfo.output_width;
+        unsigned imageHeight = cinfo.output_height;
+        if (options.RegionX >= imageWidth || options.RegionY >= imageHeight
+            || options.RegionWidth > imageWidth - options.RegionX
+            || options.RegionHeight > imageHeight - options.RegionY)
+        {
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The region is outside the JPEG image");
+        }
 
-    // buffer will be deleted by jpeg_destroy_decompress
-    JSAMPARRAY scanLines = (*m_cinfo.mem->alloc_sarray)(reinterpret_cast<j_common_ptr>(&m_cinfo), JPOOL_IMAGE, rowBytes, 1);
-    charbuff buffer(rowBytes);
-    while (m_cinfo.output_scanline < m_cinfo.output_height)
-    {
-        jpeg_read_scanlines(&m_cinfo, scanLines, 1);
-        if (componentCount == 4)
+        width = options.RegionWidth == 0 ? imageWidth - options.RegionX : options.RegionWidth;
+        height = options.RegionHeight == 0 ? imageHeight - options.RegionY : options.RegionHeight;
+
+        // With libjpeg-turbo only the iMCU columns of the region are
+        // decoded, and the rows before the region are skipped without
+        // the IDCT. The offset of the cropped rows is aligned to the
+        // iMCU, so the first columns may be still outside the region
+        unsigned skipColumns = options.RegionX;
+        unsigned skipRows = options.RegionY;
+#ifdef LIBJPEG_TURBO_VERSION_NUMBER
+        if (width != imageWidth)
         {
-            for (unsigned i = 0, c = 0; i < m_cinfo.output_width; i++, c += 4)
-            {
-                buffer[c + 0] = scanLines[0][i * 4 + 0];
-                buffer[c + 1] = scanLines[0][i * 4 + 1];
-                buffer[c + 2] = scanLines[0][i * 4 + 2];
-                buffer[c + 3] = scanLines[0][i * 4 + 3];
-            }
+            JDIMENSION cropX = options.RegionX;
+            JDIMENSION cropWidth = width;
+            jpeg_crop_scanline(&cinfo, &cropX, &cropWidth);
+            checkError();
+            skipColumns = options.RegionX - cropX;
         }
-        else if (componentCount == 3)
+
+        if (skipRows != 0)
         {
-            for (unsigned i = 0, c = 0; i < m_cinfo.output_width; i++, c += 3)
-            {
-                buffer[c + 0] = scanLines[0][i * 3 + 0];
-                buffer[c + 1] = scanLines[0][i * 3 + 1];
-                buffer[c + 2] = scanLines[0][i * 3 + 2];
-            }
+            jpeg_skip_scanlines(&cinfo, skipRows);
+            checkError();
+            skipRows = 0;
         }
-        else if (componentCount == 1)
+#endif // LIBJPEG_TURBO_VERSION_NUMBER
+
+        size_t rowSize = (size_t)width * componentCount;
+        size_t scanlineSize = (size_t)cinfo.output_width * componentCount;
+        size_t offset = output.size();
+        output.resize(offset + rowSize * height);
+
+        // Rows that are not cropped are decoded directly in the output,
+        // some at a time, for the decoders that output more rows at once
+        JSAMPARRAY scanline = (*cinfo.mem->alloc_sarray)(reinterpret_cast<j_common_ptr>(&cinfo),
+            JPOOL_IMAGE, (JDIMENSION)scanlineSize, 1);
+        constexpr unsigned MaxRows = 16;
+        JSAMPROW rows[MaxRows];
+        for (unsigned i = 0; i < skipRows; i++)
         {
-            memcpy(buffer.data(), scanLines[0], m_cinfo.output_width);
+            jpeg_read_scanlines(&cinfo, scanline, 1);
+            checkError();
         }
-        else
+
+        unsigned y = 0;
+        while (y < height)
         {
-            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "DCTDecode unknown components");
+            JDIMENSION read;
+            if (scanlineSize == rowSize)
+            {
+                unsigned count = std::min(height - y, MaxRows);
+                for (unsigned i = 0; i < count; i++)
+                    rows[i] = reinterpret_cast<JSAMPROW>(output.data() + offset + (y + i) * rowSize);
+
+                read = jpeg_read_scanlines(&cinfo, rows, count);
+            }
+            else
+            {
+                read = jpeg_read_scanlines(&cinfo, scanline, 1);
+                if (read != 0)
+                {
+                    std::memcpy(output.data() + offset + y * rowSize,
+                        scanline[0] + (size_t)skipColumns * componentCount, rowSize);
+                }
+            }
+
+            checkError();
+            if (read == 0)
+                PDFMM_RAISE_ERROR(PdfErrorCode::UnexpectedEOF);
+
+            y += read;
         }
 
-        GetStream()->Write(reinterpret_cast<char*>(buffer.data()), rowBytes);
+        if (cinfo.output_scanline < cinfo.output_height)
+            jpeg_abort_decompress(&cinfo);
+        else
+            jpeg_finish_decompress(&cinfo);
+
+        checkError();
+    }
+    catch (...)
+    {
+        jpeg_destroy_decompress(&cinfo);
+        throw;
     }
 
-    jpeg_destroy_decompress(&m_cinfo);
+    jpeg_destroy_decompress(&cinfo);
 }
 
 /*
@@ -1109,41 +1415,7 @@ void mm::jpeg_memory_src(j_decompress_ptr cinfo, const JOCTET* buffer, size_t bu
 
 #pragma region PdfCCITTFilter
 
-#ifdef PDFMM_HAVE_TIFF_LIB
-
-#ifdef DS_CCITT_DEVELOPMENT_CODE
-
-static tsize_t dummy_read(thandle_t, tdata_t, tsize_t)
-{
-    return 0;
-}
-
-static tsize_t dummy_write(thandle_t, tdata_t, tsize_t size)
-{
-    return size;
-}
-
-static toff_t dummy_seek(thandle_t, toff_t, int)
-{
-
-}
-
-static int dummy_close(thandle_t)
-{
-
-}
-
-static toff_t dummy_size(thandle_t)
-{
-
-}
-
-#endif
-
-PdfCCITTFilter::PdfCCITTFilter()
-    : m_tiff(nullptr)
-{
-}
+PdfCCITTFilter::PdfCCITTFilter() { }
 
 void PdfCCITTFilter::BeginEncodeImpl()
 {
@@ -1160,68 +1432,35 @@ void PdfCCITTFilter::EndEncodeImpl()
     PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedFilter);
 }
 
-void PdfCCITTFilter::BeginDecodeImpl(const PdfDictionary* dict)
+void PdfCCITTFilter::BeginDecodeImpl(const PdfDictionary* decodeParms)
 {
-#ifdef DS_CCITT_DEVELOPMENT_CODE
-
-    if (dict == nullptr)
-        PDFMM_RAISE_ERROR_INFO(EPdfError::InvalidHandle, "PdfCCITTFilter required a DecodeParms dictionary");
-
-    m_tiff = TIFFClientOpen("pdfmm", "w", reinterpret_cast<thandle_t>(-1),
-        dummy_read, dummy_write,
-        dummy_seek, dummy_close, dummy_size, nullptr, nullptr);
-
-    if (m_tiff == nullptr)
-        PDFMM_RAISE_ERROR_INFO(EPdfError::InvalidHandle, "TIFFClientOpen failed");
-
-    m_tiff->tif_mode = O_RDONLY;
-
-    TIFFSetField(m_tiff, TIFFTAG_IMAGEWIDTH, dict->GetAs<int64_t>(PdfName("Columns"), 1728));
-    TIFFSetField(m_tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
-    TIFFSetField(m_tiff, TIFFTAG_BITSPERSAMPLE, 1);
-    TIFFSetField(m_tiff, TIFFTAG_FILLORDER, FILLORDER_LSB2MSB);
-    TIFFSetField(m_tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
-    TIFFSetField(m_tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISWHITE);
-    TIFFSetField(m_tiff, TIFFTAG_YRESOLUTION, 196.);
-    TIFFSetField(m_tiff, TIFFTAG_RESOLUTIONUNIT, RESUNIT_INCH);
-
-    /*
-    m_tiff->tif_scanlinesize = TIFFSetField(m_tiff);
-
-    if (dict != nullptr)
+    m_params = { };
+    if (decodeParms != nullptr)
     {
-        int64_t encoding = dict->GetAs<int64_t>(PdfName("K"), 0);
-        if (encoding == 0) // pure 1D encoding, Group3 1D
-        {
-            TIFFSetField(faxTIFF, TIFFTAG_GROUP3OPTIONS, GROUP3OPT_1DENCODING);
-        }
-        else if (encoding < 0) // pure 2D encoding, Group4
-        {
-            TIFFSetField(faxTIFF, TIFFTAG_GROUP4OPTIONS, GROUP4OPT_2DENCODING);
-        }
-        else //if (encoding > 0)  // mixed, Group3 2D
-        {
-            TIFFSetField(faxTIFF, TIFFTAG_GROUP3OPTIONS, GROUP3OPT_2DENCODING);
-        }
+        m_params.K = (int)decodeParms->FindKeyAs<int64_t>("K", 0);
+        m_params.EndOfLine = decodeParms->FindKeyAs<bool>("EndOfLine", false);
+        m_params.EncodedByteAlign = decodeParms->FindKeyAs<bool>("EncodedByteAlign", false);
+        m_params.Columns = (unsigned)decodeParms->FindKeyAs<int64_t>("Columns", 1728);
+        m_params.Rows = (unsigned)decodeParms->FindKeyAs<int64_t>("Rows", 0);
+        m_params.EndOfBlock = decodeParms->FindKeyAs<bool>("EndOfBlock", true);
+        m_params.BlackIs1 = decodeParms->FindKeyAs<bool>("BlackIs1", false);
     }
-    */
 
-#else // DS_CCITT_DEVELOPMENT_CODE
-    (void)dict;
-    PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedFilter);
-#endif // DS_CCITT_DEVELOPMENT_CODE
+    m_buffer.clear();
 }
 
-void PdfCCITTFilter::DecodeBlockImpl(const char*, size_t)
+void PdfCCITTFilter::DecodeBlockImpl(const char* buffer, size_t len)
 {
-    PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedFilter);
+    m_buffer.append(buffer, len);
 }
 
 void PdfCCITTFilter::EndDecodeImpl()
 {
-    PDFMM_RAISE_ERROR(PdfErrorCode::UnsupportedFilter);
+    // The rows are decoded straight into a single buffer
+    m_decoded.clear();
+    mm::DecodeCCITT(m_decoded, m_buffer, m_params);
+    GetStream()->Write(m_decoded.data(), m_decoded.size());
+    m_buffer.clear();
 }
 
-#endif // PDFMM_HAVE_TIFF_LIB
-
 #pragma endregion // PdfCCITTFilter
@@ -20,7 +20,12 @@
 
 #include <pdfmm/base/PdfFilter.h>
 
-#include <zlib.h>
+#include "PdfCCITTPrivate.h"
+#include "PdfPoolPrivate.h"
+
+#ifdef PDFMM_HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif // PDFMM_HAVE_LIBDEFLATE
 
 #ifdef PDFMM_HAVE_JPEG_LIB
 extern "C" {
@@ -84,6 +89,7 @@ public:
 private:
     char m_DecodedByte;
     bool m_Low;
+    charbuff m_buffer;
 };
 
 /** The Ascii85 filter.
@@ -114,10 +120,13 @@ public:
 private:
     void EncodeTuple(unsigned tuple, int bytes);
     void WidePut(unsigned tuple, int bytes) const;
+    size_t addEncodedByte(char* encoded, unsigned char ch);
+    size_t addDecodedDigit(char* decoded, char ch);
 
 private:
     int m_count;
     unsigned m_tuple;
+    charbuff m_buffer;
 };
 
 /** The Flate filter.
@@ -125,7 +134,7 @@ private:
 class PdfFlateFilter final : public PdfFilter
 {
 public:
-    PdfFlateFilter();
+    PdfFlateFilter(PdfCompressionLevel level = PdfCompressionLevel::Default);
 
     inline bool CanEncode() const override { return true; }
 
@@ -145,13 +154,23 @@ public:
 
     inline PdfFilterType GetType() const override { return PdfFilterType::FlateDecode; }
 
+protected:
+    bool EncodeToImpl(charbuff& outBuffer, const bufferview& inBuffer) override;
+
+    bool DecodeToImpl(charbuff& outBuffer, const bufferview& inBuffer, const PdfDictionary* decodeParms) override;
+
 private:
     void EncodeBlockInternal(const char* buffer, size_t len, int nMode);
 
+    int getZlibLevel() const;
+
 private:
+    PdfCompressionLevel m_Level;
     unsigned char m_buffer[PDFMM_FILTER_INTERNAL_BUFFER_SIZE];
 
-    z_stream m_stream;
+    // Contexts from the thread local pool, held while encoding or decoding
+    ZlibDeflatePtr m_deflate;
+    ZlibInflatePtr m_inflate;
     std::shared_ptr<PdfPredictorDecoder> m_Predictor;
 };
 
@@ -179,22 +198,26 @@ public:
     inline PdfFilterType GetType() const override { return PdfFilterType::RunLengthDecode; }
 
 private:
+    // The literal bytes left to copy when positive,
+    // the length of a pending run when negative
     int m_CodeLen;
+    bool m_Finished;
 };
 
 /** The LZW filter.
  */
 class PdfLZWFilter final : public PdfFilter
 {
-    struct TLzwItem
+    // The strings of the codes are stored as the code of the string
+    // without the last byte, plus the last byte
+    struct CodeEntry
     {
-        std::vector<unsigned char> value;
+        uint16_t Prefix;
+        uint16_t Length;
+        unsigned char Suffix;
+        unsigned char First;
     };
 
-    using TLzwTable = std::vector<TLzwItem>;
-    using TILzwTable = TLzwTable::iterator;
-    using TCILzwTable = TLzwTable::const_iterator;
-
 public:
     PdfLZWFilter();
 
@@ -218,20 +241,25 @@ public:
 
 private:
     void InitTable();
+    void fillBits(const char* buffer, size_t len, size_t& pos);
+    size_t writeCode(unsigned code, size_t pos);
 
 private:
-    static const unsigned short s_masks[4];
     static const unsigned short s_clear;
     static const unsigned short s_eod;
 
-    TLzwTable m_table;
-
-    unsigned m_mask;
+    std::vector<CodeEntry> m_table;
+    unsigned m_nextCode;
+    unsigned m_prevCode;
     unsigned m_code_len;
-    unsigned char m_character;
+    unsigned m_EarlyChange;
 
-    bool m_First;
+    // The pending input bits, starting from the most significant
+    uint64_t m_bits;
+    unsigned m_bitCount;
+    bool m_Finished;
 
+    charbuff m_buffer;
     std::shared_ptr<PdfPredictorDecoder> m_Predictor;
 };
 
@@ -274,20 +302,27 @@ public:
     inline PdfFilterType GetType() const override { return PdfFilterType::DCTDecode; }
 
 private:
-    struct jpeg_decompress_struct m_cinfo;
-    struct jpeg_error_mgr m_jerr;
-
     charbuff m_buffer;
-    OutputStreamDevice* m_Device;
+    charbuff m_decoded;
 };
 
-#endif // PDFMM_HAVE_JPEG_LIB
+struct PdfJpegDecodeOptions;
 
-#ifdef PDFMM_HAVE_TIFF_LIB
+/** Decode JPEG data, optionally scaled down and only in a region
+ *
+ *  The DCT scaling and the cropping of libjpeg-turbo are used when
+ *  available, otherwise the rows outside the region are discarded
+ *  \see PdfImage::DecodeJpegTo
+ */
+void DecodeJpeg(charbuff& output, const bufferview& input, const PdfJpegDecodeOptions& options,
+    unsigned& width, unsigned& height, unsigned& componentCount);
 
-/** The CCITT filter can decoded CCITTFaxDecode compressed data.
+#endif // PDFMM_HAVE_JPEG_LIB
+
+/** The CCITT filter can decode CCITTFaxDecode compressed data.
  *
- *  This filter requires TIFFlib to be available
+ *  The data is collected and decoded at the end. Encoding requires
+ *  the image size, see PdfImage::SetDataCCITT()
  */
 class PdfCCITTFilter final : public PdfFilter
 {
@@ -313,11 +348,11 @@ public:
     inline PdfFilterType GetType() const override { return PdfFilterType::CCITTFaxDecode; }
 
 private:
-    TIFF* m_tiff;
+    CCITTParameters m_params;
+    charbuff m_buffer;
+    charbuff m_decoded;
 };
 
-#endif // PDFMM_HAVE_TIFF_LIB
-
 };
 
 
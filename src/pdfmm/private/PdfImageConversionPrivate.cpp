@@ -0,0 +1,1020 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfImageConversionPrivate.h"
+
+#include <pdfmm/base/PdfArray.h>
+#include <pdfmm/base/PdfDictionary.h>
+#include <pdfmm/base/PdfObjectStream.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define PDFMM_IMAGE_CONVERSION_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace mm;
+
+constexpr unsigned NoRowIndex = numeric_limits<unsigned>::max();
+
+static void unpackRow(const uint8_t* src, uint8_t* dst, size_t pixelCount, PdfPixelFormat format);
+static void accumulateRow(uint32_t* sums, const uint8_t* row, size_t count);
+static void blendRows(uint16_t* dst, const uint8_t* row0, const uint8_t* row1, unsigned weight, size_t count);
+static void convertColors(const uint8_t* src, unsigned stride, PdfColorSpace srcColorSpace,
+    uint8_t* dst, PdfColorSpace dstColorSpace, size_t pixelCount);
+static void premultiplyAlpha(uint8_t* colors, unsigned colorCount, const uint8_t* alpha, unsigned stride, size_t pixelCount);
+static uint8_t getGray(unsigned r, unsigned g, unsigned b);
+static uint8_t divide255(unsigned value);
+static PdfColorSpace getDeviceColorSpace(const PdfObject* colorSpace);
+static void invertSamples(const uint8_t* src, uint8_t* dst, size_t count);
+static void packRow(const uint8_t* colors, uint8_t* dst, size_t pixelCount, PdfPixelFormat format);
+static void reorderPixels(uint8_t* pixels, size_t pixelCount, PdfPixelFormat format);
+
+ImageConversionStream::ImageConversionStream(InputStream& source, unsigned width, unsigned height,
+        PdfPixelFormat format, unsigned targetWidth, unsigned targetHeight,
+        PdfImageResampling resampling, PdfColorSpace colorSpace,
+        bool premultiplyAlpha) :
+    m_source(&source),
+    m_width(width),
+    m_height(height),
+    m_format(format),
+    m_targetWidth(targetWidth),
+    m_targetHeight(targetHeight),
+    m_resampling(resampling),
+    m_sourceColorSpace(GetColorSpace(format)),
+    m_colorSpace(colorSpace),
+    m_premultiplyAlpha(premultiplyAlpha),
+    m_alpha(nullptr),
+    m_hasAlpha(format == PdfPixelFormat::ARGB || format == PdfPixelFormat::BGRA),
+    m_sourceRowIndex(0),
+    m_rowIndices{ NoRowIndex, NoRowIndex },
+    m_rowIndex(0),
+    m_offset(0)
+{
+    unsigned colorCount = GetColorComponentCount(m_colorSpace);
+    if (m_sourceColorSpace == PdfColorSpace::Unknown || colorCount == 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidEnumValue, "Unsupported pixel format or color space");
+
+    if (width == 0 || height == 0 || targetWidth == 0 || targetHeight == 0
+        || targetWidth > width || targetHeight > height)
+    {
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The image data can only be scaled down");
+    }
+
+    m_channelCount = GetColorComponentCount(m_sourceColorSpace) + (m_hasAlpha ? 1 : 0);
+    size_t rowLength = (size_t)width * m_channelCount;
+    m_sourceRow.resize(rowLength);
+    m_rows[0].resize(rowLength);
+    m_scaledRow.resize((size_t)targetWidth * m_channelCount);
+    if (targetWidth != width || targetHeight != height)
+    {
+        if (resampling == PdfImageResampling::Bilinear)
+        {
+            m_rows[1].resize(rowLength);
+            m_blendedRow.resize(rowLength);
+            m_columns.resize(targetWidth);
+            m_weights.resize(targetWidth);
+            for (unsigned x = 0; x < targetWidth; x++)
+            {
+                // Sample at the center of the target pixel
+                double sx = std::max(0.0, (x + 0.5) * width / targetWidth - 0.5);
+                m_columns[x] = std::min((unsigned)sx, width - 1);
+                m_weights[x] = std::min(256U, (unsigned)((sx - m_columns[x]) * 256 + 0.5));
+            }
+        }
+        else
+        {
+            m_sums.resize(rowLength);
+            m_columns.resize(targetWidth + 1);
+            for (unsigned x = 0; x <= targetWidth; x++)
+                m_columns[x] = (unsigned)((uint64_t)x * width / targetWidth);
+        }
+    }
+
+    m_colorRow.resize((size_t)targetWidth * colorCount);
+    if (m_hasAlpha)
+        m_alphaRow.resize(targetWidth);
+
+    m_offset = m_colorRow.size();
+}
+
+unsigned ImageConversionStream::GetColorComponentCount(PdfColorSpace colorSpace)
+{
+    switch (colorSpace)
+    {
+        case PdfColorSpace::DeviceGray:
+            return 1;
+        case PdfColorSpace::DeviceRGB:
+            return 3;
+        case PdfColorSpace::DeviceCMYK:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+PdfColorSpace ImageConversionStream::GetColorSpace(PdfPixelFormat format)
+{
+    switch (format)
+    {
+        case PdfPixelFormat::ARGB:
+        case PdfPixelFormat::BGRA:
+        case PdfPixelFormat::RGB24:
+        case PdfPixelFormat::BGR24:
+            return PdfColorSpace::DeviceRGB;
+        case PdfPixelFormat::Gray:
+            return PdfColorSpace::DeviceGray;
+        case PdfPixelFormat::CMYK:
+            return PdfColorSpace::DeviceCMYK;
+        default:
+            return PdfColorSpace::Unknown;
+    }
+}
+
+size_t ImageConversionStream::readBuffer(char* buffer, size_t size, bool& eof)
+{
+    size_t read = 0;
+    while (read < size)
+    {
+        if (m_offset == m_colorRow.size())
+        {
+            if (m_rowIndex == m_targetHeight)
+                break;
+
+            nextRow();
+        }
+
+        size_t count = std::min(size - read, m_colorRow.size() - m_offset);
+        memcpy(buffer + read, m_colorRow.data() + m_offset, count);
+        read += count;
+        m_offset += count;
+    }
+
+    eof = m_rowIndex == m_targetHeight && m_offset == m_colorRow.size();
+    return read;
+}
+
+void ImageConversionStream::nextRow()
+{
+    // Scale first, so the other stages handle only the target pixels
+    const uint8_t* row;
+    if (m_targetWidth == m_width && m_targetHeight == m_height)
+    {
+        row = getSourceRow(m_rowIndex);
+    }
+    else
+    {
+        if (m_resampling == PdfImageResampling::Bilinear)
+            scaleBilinear();
+        else
+            scaleBox();
+
+        row = m_scaledRow.data();
+    }
+
+    auto colors = reinterpret_cast<uint8_t*>(m_colorRow.data());
+    convertColors(row, m_channelCount, m_sourceColorSpace, colors, m_colorSpace, m_targetWidth);
+    if (m_hasAlpha)
+    {
+        const uint8_t* alpha = row + m_channelCount - 1;
+        if (m_premultiplyAlpha)
+            premultiplyAlpha(colors, GetColorComponentCount(m_colorSpace), alpha, m_channelCount, m_targetWidth);
+
+        if (m_alpha != nullptr)
+        {
+            for (unsigned x = 0; x < m_targetWidth; x++)
+                m_alphaRow[x] = (char)alpha[(size_t)x * m_channelCount];
+
+            m_alpha->AppendBuffer(m_alphaRow.data(), m_alphaRow.size());
+        }
+    }
+
+    m_rowIndex++;
+    m_offset = 0;
+}
+
+void ImageConversionStream::scaleBox()
+{
+    unsigned y0 = (unsigned)((uint64_t)m_rowIndex * m_height / m_targetHeight);
+    unsigned y1 = (unsigned)((uint64_t)(m_rowIndex + 1) * m_height / m_targetHeight);
+    std::fill(m_sums.begin(), m_sums.end(), 0);
+    for (unsigned y = y0; y < y1; y++)
+        accumulateRow(m_sums.data(), getSourceRow(y), m_sums.size());
+
+    for (unsigned x = 0; x < m_targetWidth; x++)
+    {
+        unsigned x0 = m_columns[x];
+        unsigned x1 = m_columns[x + 1];
+        // Divide by multiplying with the reciprocal in 32.32 fixed point
+        uint64_t count = (uint64_t)(x1 - x0) * (y1 - y0);
+        uint64_t reciprocal = ((1ULL << 32) + count / 2) / count;
+        for (unsigned c = 0; c < m_channelCount; c++)
+        {
+            uint64_t sum = 0;
+            for (unsigned sx = x0; sx < x1; sx++)
+                sum += m_sums[(size_t)sx * m_channelCount + c];
+
+            m_scaledRow[(size_t)x * m_channelCount + c] = (uint8_t)std::min<uint64_t>(255,
+                (sum * reciprocal + (1ULL << 31)) >> 32);
+        }
+    }
+}
+
+void ImageConversionStream::scaleBilinear()
+{
+    // Sample at the center of the target pixel
+    double sy = std::max(0.0, (m_rowIndex + 0.5) * m_height / m_targetHeight - 0.5);
+    unsigned y0 = std::min((unsigned)sy, m_height - 1);
+    unsigned y1 = std::min(y0 + 1, m_height - 1);
+    unsigned weight = std::min(256U, (unsigned)((sy - y0) * 256 + 0.5));
+
+    // The rows are requested in increasing order
+    auto row0 = getSourceRow(y0);
+    auto row1 = getSourceRow(y1);
+    blendRows(m_blendedRow.data(), row0, row1, weight, m_blendedRow.size());
+
+    for (unsigned x = 0; x < m_targetWidth; x++)
+    {
+        size_t offset0 = (size_t)m_columns[x] * m_channelCount;
+        size_t offset1 = (size_t)std::min(m_columns[x] + 1, m_width - 1) * m_channelCount;
+        unsigned weight1 = m_weights[x];
+        unsigned weight0 = 256 - weight1;
+        for (unsigned c = 0; c < m_channelCount; c++)
+        {
+            m_scaledRow[(size_t)x * m_channelCount + c] = (uint8_t)((m_blendedRow[offset0 + c] * weight0
+                + m_blendedRow[offset1 + c] * weight1 + 32768) >> 16);
+        }
+    }
+}
+
+const uint8_t* ImageConversionStream::getSourceRow(unsigned index)
+{
+    for (unsigned i = 0; i < 2; i++)
+    {
+        if (m_rowIndices[i] == index)
+            return m_rows[i].data();
+    }
+
+    PDFMM_ASSERT(index >= m_sourceRowIndex);
+    // With two cached rows, they are requested in pairs of
+    // consecutive rows, so the row with the same parity is older
+    unsigned slot = m_rows[1].size() == 0 ? 0 : index % 2;
+    while (m_sourceRowIndex < index)
+    {
+        m_source->Read(m_sourceRow.data(), m_sourceRow.size());
+        m_sourceRowIndex++;
+    }
+
+    readSourceRow(m_rows[slot].data());
+    m_rowIndices[slot] = index;
+    return m_rows[slot].data();
+}
+
+void ImageConversionStream::readSourceRow(uint8_t* row)
+{
+    m_source->Read(m_sourceRow.data(), m_sourceRow.size());
+    unpackRow(reinterpret_cast<const uint8_t*>(m_sourceRow.data()), row, m_width, m_format);
+    m_sourceRowIndex++;
+}
+
+ImageDecodeStream::ImageDecodeStream(const PdfObject& image, PdfPixelFormat format,
+        char* buffer, size_t stride) :
+    m_buffer(reinterpret_cast<uint8_t*>(buffer)),
+    m_stride(stride),
+    m_format(format),
+    m_colorSpace(ImageConversionStream::GetColorSpace(format)),
+    m_indexed(false),
+    m_uniformLookup(false),
+    m_identityLookup(false),
+    m_invertedLookup(false),
+    m_pixelSize(GetPixelSize(format)),
+    m_componentOffset(0),
+    m_componentTarget(false),
+    m_rowOffset(0),
+    m_rowIndex(0)
+{
+    if (m_colorSpace == PdfColorSpace::Unknown)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidEnumValue, "Unsupported pixel format");
+
+    auto& dict = image.GetDictionary();
+    m_width = (unsigned)dict.MustFindKey("Width").GetNumber();
+    m_height = (unsigned)dict.MustFindKey("Height").GetNumber();
+    if (m_width == 0 || m_height == 0)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Invalid image size");
+
+    size_t rowLength = (size_t)m_width * m_pixelSize;
+    if (m_stride == 0)
+        m_stride = rowLength;
+    else if (m_stride < rowLength)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The stride is shorter than the rows");
+
+    if (dict.FindKeyAs<bool>("ImageMask", false))
+    {
+        // The stencil masks are decoded as gray, black where painted
+        m_bitsPerComponent = 1;
+        m_componentCount = 1;
+        m_sourceColorSpace = PdfColorSpace::DeviceGray;
+    }
+    else
+    {
+        m_bitsPerComponent = (unsigned)dict.FindKeyAs<int64_t>("BitsPerComponent", 8);
+        auto colorSpace = dict.FindKey("ColorSpace");
+        const PdfName* name;
+        if (colorSpace != nullptr && colorSpace->IsArray() && colorSpace->GetArray().GetSize() == 4
+            && colorSpace->GetArray().FindAt(0).TryGetName(name) && (*name == "Indexed" || *name == "I"))
+        {
+            m_indexed = true;
+            m_componentCount = 1;
+            initPalette(colorSpace->GetArray());
+        }
+        else
+        {
+            m_sourceColorSpace = getDeviceColorSpace(colorSpace);
+            m_componentCount = ImageConversionStream::GetColorComponentCount(m_sourceColorSpace);
+        }
+    }
+
+    switch (m_bitsPerComponent)
+    {
+        case 1:
+        case 2:
+        case 4:
+        case 8:
+        case 16:
+            break;
+        default:
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Unsupported bits per component");
+    }
+
+    // The samples of 16 bits are looked up by their high byte
+    initLookupTables(dict.FindKey("Decode"), m_bitsPerComponent == 16 ? 255 : (1U << m_bitsPerComponent) - 1);
+    m_row.resize(((size_t)m_width * m_componentCount * m_bitsPerComponent + 7) / 8);
+    m_components.resize((size_t)m_width * m_componentCount);
+    m_colors.resize((size_t)m_width * ImageConversionStream::GetColorComponentCount(m_colorSpace));
+}
+
+void ImageDecodeStream::SetComponentTarget(unsigned pixelSize, unsigned offset)
+{
+    if (m_format != PdfPixelFormat::Gray || offset >= pixelSize)
+        PDFMM_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    if (m_stride < (size_t)m_width * pixelSize)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The stride is shorter than the rows");
+
+    m_pixelSize = pixelSize;
+    m_componentOffset = offset;
+    m_componentTarget = true;
+}
+
+void ImageDecodeStream::Finish()
+{
+    if (m_rowOffset != 0)
+    {
+        std::fill(m_row.begin() + m_rowOffset, m_row.end(), '\0');
+        convertRow(reinterpret_cast<const uint8_t*>(m_row.data()));
+        m_rowOffset = 0;
+    }
+
+    std::fill(m_row.begin(), m_row.end(), '\0');
+    while (m_rowIndex < m_height)
+        convertRow(reinterpret_cast<const uint8_t*>(m_row.data()));
+}
+
+unsigned ImageDecodeStream::GetPixelSize(PdfPixelFormat format)
+{
+    switch (format)
+    {
+        case PdfPixelFormat::ARGB:
+        case PdfPixelFormat::BGRA:
+        case PdfPixelFormat::CMYK:
+            return 4;
+        case PdfPixelFormat::RGB24:
+        case PdfPixelFormat::BGR24:
+            return 3;
+        case PdfPixelFormat::Gray:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+size_t ImageDecodeStream::GetBufferSize() const
+{
+    return m_stride * (m_height - 1) + (size_t)m_width * m_pixelSize;
+}
+
+void ImageDecodeStream::writeBuffer(const char* buffer, size_t size)
+{
+    auto data = reinterpret_cast<const uint8_t*>(buffer);
+    size_t rowLength = m_row.size();
+    while (size != 0 && m_rowIndex < m_height)
+    {
+        if (m_rowOffset == 0 && size >= rowLength)
+        {
+            // Convert the row straight from the data written
+            convertRow(data);
+            data += rowLength;
+            size -= rowLength;
+            continue;
+        }
+
+        size_t count = std::min(size, rowLength - m_rowOffset);
+        memcpy(m_row.data() + m_rowOffset, data, count);
+        m_rowOffset += count;
+        data += count;
+        size -= count;
+        if (m_rowOffset == rowLength)
+        {
+            convertRow(reinterpret_cast<const uint8_t*>(m_row.data()));
+            m_rowOffset = 0;
+        }
+    }
+}
+
+void ImageDecodeStream::initLookupTables(const PdfObject* decode, unsigned maxValue)
+{
+    const PdfArray* decodeArr = nullptr;
+    if (decode != nullptr && decode->IsArray() && decode->GetArray().GetSize() >= m_componentCount * 2)
+        decodeArr = &decode->GetArray();
+
+    m_lookupTables.resize((size_t)m_componentCount * 256);
+    for (unsigned c = 0; c < m_componentCount; c++)
+    {
+        // By default the samples map to the whole range, or to the indices
+        double min = 0;
+        double max = m_indexed ? maxValue : 1;
+        if (decodeArr != nullptr)
+        {
+            min = decodeArr->FindAt(c * 2).GetReal();
+            max = decodeArr->FindAt(c * 2 + 1).GetReal();
+        }
+
+        uint8_t* table = m_lookupTables.data() + (size_t)c * 256;
+        for (unsigned sample = 0; sample <= maxValue; sample++)
+        {
+            double value = min + sample * (max - min) / maxValue;
+            if (!m_indexed)
+                value *= 255;
+
+            table[sample] = (uint8_t)(std::clamp(value, 0.0, 255.0) + 0.5);
+        }
+    }
+
+    m_uniformLookup = true;
+    for (unsigned c = 1; c < m_componentCount; c++)
+    {
+        if (memcmp(m_lookupTables.data(), m_lookupTables.data() + (size_t)c * 256, 256) != 0)
+        {
+            m_uniformLookup = false;
+            break;
+        }
+    }
+
+    if (!m_uniformLookup)
+        return;
+
+    auto table = m_lookupTables.data();
+    if (m_bitsPerComponent == 8)
+    {
+        m_identityLookup = true;
+        m_invertedLookup = true;
+        for (unsigned sample = 0; sample < 256; sample++)
+        {
+            m_identityLookup &= table[sample] == sample;
+            m_invertedLookup &= table[sample] == 255 - sample;
+        }
+    }
+    else if (m_bitsPerComponent < 8)
+    {
+        unsigned samplesPerByte = 8 / m_bitsPerComponent;
+        m_expansionTable.resize((size_t)samplesPerByte * 256);
+        for (unsigned byte = 0; byte < 256; byte++)
+        {
+            for (unsigned i = 0; i < samplesPerByte; i++)
+            {
+                unsigned sample = (byte >> (8 - m_bitsPerComponent * (i + 1))) & maxValue;
+                m_expansionTable[(size_t)byte * samplesPerByte + i] = table[sample];
+            }
+        }
+    }
+}
+
+// Read the palette [/Indexed base hival lookup], converting it
+// to the target color space. The indices past hival are clamped
+void ImageDecodeStream::initPalette(const PdfArray& indexed)
+{
+    m_sourceColorSpace = getDeviceColorSpace(&indexed.FindAt(1));
+    unsigned baseCount = ImageConversionStream::GetColorComponentCount(m_sourceColorSpace);
+    unsigned hival = (unsigned)std::clamp<int64_t>(indexed.FindAt(2).GetNumber(), 0, 255);
+    charbuff lookup;
+    auto& lookupObj = indexed.FindAt(3);
+    if (lookupObj.IsString())
+        lookup = lookupObj.GetString().GetRawData();
+    else if (lookupObj.HasStream())
+        lookupObj.MustGetStream().ExtractTo(lookup);
+    else
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid indexed color space lookup");
+
+    vector<uint8_t> colors((size_t)baseCount * 256);
+    for (unsigned i = 0; i < 256; i++)
+    {
+        size_t offset = (size_t)std::min(i, hival) * baseCount;
+        for (unsigned c = 0; c < baseCount && offset + c < lookup.size(); c++)
+            colors[(size_t)i * baseCount + c] = (uint8_t)lookup[offset + c];
+    }
+
+    m_palette.resize((size_t)ImageConversionStream::GetColorComponentCount(m_colorSpace) * 256);
+    convertColors(colors.data(), baseCount, m_sourceColorSpace, m_palette.data(), m_colorSpace, 256);
+}
+
+void ImageDecodeStream::convertRow(const uint8_t* row)
+{
+    uint8_t* dst = m_buffer + m_stride * m_rowIndex;
+    size_t sampleCount = (size_t)m_width * m_componentCount;
+
+    // The formats with the components in the order of the color
+    // space are converted straight into the buffer
+    bool direct = !m_componentTarget && (m_format == PdfPixelFormat::Gray
+        || m_format == PdfPixelFormat::RGB24 || m_format == PdfPixelFormat::CMYK);
+    uint8_t* colors = direct ? dst : m_colors.data();
+    if (direct && !m_indexed && m_sourceColorSpace == m_colorSpace)
+    {
+        auto components = unpackSamples(row, dst);
+        if (components != dst)
+            memcpy(dst, components, sampleCount);
+
+        m_rowIndex++;
+        return;
+    }
+
+    auto components = unpackSamples(row, m_components.data());
+    if (m_indexed)
+    {
+        unsigned colorCount = ImageConversionStream::GetColorComponentCount(m_colorSpace);
+        for (unsigned x = 0; x < m_width; x++)
+            memcpy(colors + (size_t)x * colorCount, m_palette.data() + (size_t)components[x] * colorCount, colorCount);
+    }
+    else
+    {
+        convertColors(components, m_componentCount, m_sourceColorSpace, colors, m_colorSpace, m_width);
+    }
+
+    if (m_componentTarget)
+    {
+        for (unsigned x = 0; x < m_width; x++)
+            dst[(size_t)x * m_pixelSize + m_componentOffset] = colors[x];
+    }
+    else if (!direct)
+    {
+        packRow(colors, dst, m_width, m_format);
+    }
+
+    m_rowIndex++;
+}
+
+// Unpack the samples of a row to bytes, through the lookup tables.
+// The row itself is returned when the samples are unchanged
+const uint8_t* ImageDecodeStream::unpackSamples(const uint8_t* row, uint8_t* dst)
+{
+    size_t count = (size_t)m_width * m_componentCount;
+    size_t i = 0;
+    if (m_bitsPerComponent == 8 && m_identityLookup)
+    {
+        return row;
+    }
+    else if (m_bitsPerComponent == 8 && m_invertedLookup)
+    {
+        invertSamples(row, dst, count);
+        return dst;
+    }
+    else if (m_expansionTable.size() != 0)
+    {
+        // Expand the whole bytes, the samples of the last one follow
+        unsigned samplesPerByte = 8 / m_bitsPerComponent;
+        for (; i + samplesPerByte <= count; i += samplesPerByte)
+            memcpy(dst + i, m_expansionTable.data() + (size_t)row[i / samplesPerByte] * samplesPerByte, samplesPerByte);
+    }
+
+    unsigned mask = (1U << std::min(m_bitsPerComponent, 8U)) - 1;
+    unsigned component = (unsigned)(i % m_componentCount);
+    for (; i < count; i++)
+    {
+        unsigned sample;
+        if (m_bitsPerComponent == 16)
+        {
+            sample = row[i * 2];
+        }
+        else
+        {
+            size_t bit = i * m_bitsPerComponent;
+            sample = (row[bit / 8] >> (8 - m_bitsPerComponent - bit % 8)) & mask;
+        }
+
+        dst[i] = m_lookupTables[(size_t)component * 256 + sample];
+        if (++component == m_componentCount)
+            component = 0;
+    }
+
+    return dst;
+}
+
+// Reorder the components to RGB, gray or CMYK followed by the alpha
+void unpackRow(const uint8_t* src, uint8_t* dst, size_t pixelCount, PdfPixelFormat format)
+{
+    size_t i = 0;
+    switch (format)
+    {
+        case PdfPixelFormat::ARGB:
+        {
+#ifdef PDFMM_IMAGE_CONVERSION_SSE2
+            // Rotate every little endian 32 bit pixel by 8 bits
+            for (; i + 4 <= pixelCount; i += 4)
+            {
+                __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+                pixels = _mm_or_si128(_mm_srli_epi32(pixels, 8), _mm_slli_epi32(pixels, 24));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), pixels);
+            }
+#endif // PDFMM_IMAGE_CONVERSION_SSE2
+            for (; i < pixelCount; i++)
+            {
+                auto pixel = src + i * 4;
+                auto unpacked = dst + i * 4;
+                unpacked[0] = pixel[1];
+                unpacked[1] = pixel[2];
+                unpacked[2] = pixel[3];
+                unpacked[3] = pixel[0];
+            }
+            break;
+        }
+        case PdfPixelFormat::BGRA:
+        {
+#ifdef PDFMM_IMAGE_CONVERSION_SSE2
+            // Swap the first and the third byte of every 32 bit pixel
+            __m128i lowMask = _mm_set1_epi32(0xFF);
+            __m128i keepMask = _mm_set1_epi32((int)0xFF00FF00);
+            for (; i + 4 <= pixelCount; i += 4)
+            {
+                __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+                __m128i swapped = _mm_or_si128(
+                    _mm_and_si128(_mm_srli_epi32(pixels, 16), lowMask),
+                    _mm_slli_epi32(_mm_and_si128(pixels, lowMask), 16));
+                pixels = _mm_or_si128(_mm_and_si128(pixels, keepMask), swapped);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), pixels);
+            }
+#endif // PDFMM_IMAGE_CONVERSION_SSE2
+            for (; i < pixelCount; i++)
+            {
+                auto pixel = src + i * 4;
+                auto unpacked = dst + i * 4;
+                unpacked[0] = pixel[2];
+                unpacked[1] = pixel[1];
+                unpacked[2] = pixel[0];
+                unpacked[3] = pixel[3];
+            }
+            break;
+        }
+        case PdfPixelFormat::BGR24:
+        {
+            for (; i < pixelCount; i++)
+            {
+                auto pixel = src + i * 3;
+                auto unpacked = dst + i * 3;
+                unpacked[0] = pixel[2];
+                unpacked[1] = pixel[1];
+                unpacked[2] = pixel[0];
+            }
+            break;
+        }
+        case PdfPixelFormat::RGB24:
+        {
+            memcpy(dst, src, pixelCount * 3);
+            break;
+        }
+        case PdfPixelFormat::Gray:
+        {
+            memcpy(dst, src, pixelCount);
+            break;
+        }
+        case PdfPixelFormat::CMYK:
+        {
+            memcpy(dst, src, pixelCount * 4);
+            break;
+        }
+        default:
+            PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
+    }
+}
+
+void accumulateRow(uint32_t* sums, const uint8_t* row, size_t count)
+{
+    size_t i = 0;
+#ifdef PDFMM_IMAGE_CONVERSION_SSE2
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i words[2] = { _mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero) };
+        for (unsigned j = 0; j < 2; j++)
+        {
+            auto sums0 = reinterpret_cast<__m128i*>(sums + i + j * 8);
+            auto sums1 = reinterpret_cast<__m128i*>(sums + i + j * 8 + 4);
+            _mm_storeu_si128(sums0, _mm_add_epi32(_mm_loadu_si128(sums0), _mm_unpacklo_epi16(words[j], zero)));
+            _mm_storeu_si128(sums1, _mm_add_epi32(_mm_loadu_si128(sums1), _mm_unpackhi_epi16(words[j], zero)));
+        }
+    }
+#endif // PDFMM_IMAGE_CONVERSION_SSE2
+    for (; i < count; i++)
+        sums[i] += row[i];
+}
+
+// Blend the rows with the given weight of the second one, out of
+// 256, to values in 8.8 fixed point
+void blendRows(uint16_t* dst, const uint8_t* row0, const uint8_t* row1, unsigned weight, size_t count)
+{
+    size_t i = 0;
+    unsigned weight0 = 256 - weight;
+#ifdef PDFMM_IMAGE_CONVERSION_SSE2
+    // NOTE: The products fit 16 bits, as 255 * 256 < 65536
+    __m128i zero = _mm_setzero_si128();
+    __m128i weights0 = _mm_set1_epi16((short)weight0);
+    __m128i weights1 = _mm_set1_epi16((short)weight);
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i bytes0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + i));
+        __m128i bytes1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + i));
+        __m128i low = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpacklo_epi8(bytes0, zero), weights0),
+            _mm_mullo_epi16(_mm_unpacklo_epi8(bytes1, zero), weights1));
+        __m128i high = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpackhi_epi8(bytes0, zero), weights0),
+            _mm_mullo_epi16(_mm_unpackhi_epi8(bytes1, zero), weights1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), low);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), high);
+    }
+#endif // PDFMM_IMAGE_CONVERSION_SSE2
+    for (; i < count; i++)
+        dst[i] = (uint16_t)(row0[i] * weight0 + row1[i] * weight);
+}
+
+void convertColors(const uint8_t* src, unsigned stride, PdfColorSpace srcColorSpace,
+    uint8_t* dst, PdfColorSpace dstColorSpace, size_t pixelCount)
+{
+    switch (srcColorSpace)
+    {
+        case PdfColorSpace::DeviceRGB:
+        {
+            for (size_t i = 0; i < pixelCount; i++, src += stride)
+            {
+                if (dstColorSpace == PdfColorSpace::DeviceRGB)
+                {
+                    dst[0] = src[0];
+                    dst[1] = src[1];
+                    dst[2] = src[2];
+                    dst += 3;
+                }
+                else if (dstColorSpace == PdfColorSpace::DeviceGray)
+                {
+                    *dst = getGray(src[0], src[1], src[2]);
+                    dst++;
+                }
+                else
+                {
+                    // Naive conversion, with full black generation
+                    unsigned max = std::max({ src[0], src[1], src[2] });
+                    for (unsigned c = 0; c < 3; c++)
+                        dst[c] = max == 0 ? 0 : (uint8_t)((max - src[c]) * 255 / max);
+                    dst[3] = (uint8_t)(255 - max);
+                    dst += 4;
+                }
+            }
+            break;
+        }
+        case PdfColorSpace::DeviceGray:
+        {
+            for (size_t i = 0; i < pixelCount; i++, src += stride)
+            {
+                if (dstColorSpace == PdfColorSpace::DeviceRGB)
+                {
+                    dst[0] = *src;
+                    dst[1] = *src;
+                    dst[2] = *src;
+                    dst += 3;
+                }
+                else if (dstColorSpace == PdfColorSpace::DeviceGray)
+                {
+                    *dst = *src;
+                    dst++;
+                }
+                else
+                {
+                    dst[0] = 0;
+                    dst[1] = 0;
+                    dst[2] = 0;
+                    dst[3] = (uint8_t)(255 - *src);
+                    dst += 4;
+                }
+            }
+            break;
+        }
+        case PdfColorSpace::DeviceCMYK:
+        {
+            for (size_t i = 0; i < pixelCount; i++, src += stride)
+            {
+                if (dstColorSpace == PdfColorSpace::DeviceCMYK)
+                {
+                    memcpy(dst, src, 4);
+                    dst += 4;
+                    continue;
+                }
+
+                unsigned r = 255 - std::min(255U, (unsigned)src[0] + src[3]);
+                unsigned g = 255 - std::min(255U, (unsigned)src[1] + src[3]);
+                unsigned b = 255 - std::min(255U, (unsigned)src[2] + src[3]);
+                if (dstColorSpace == PdfColorSpace::DeviceRGB)
+                {
+                    dst[0] = (uint8_t)r;
+                    dst[1] = (uint8_t)g;
+                    dst[2] = (uint8_t)b;
+                    dst += 3;
+                }
+                else
+                {
+                    *dst = getGray(r, g, b);
+                    dst++;
+                }
+            }
+            break;
+        }
+        default:
+            PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
+    }
+}
+
+void premultiplyAlpha(uint8_t* colors, unsigned colorCount, const uint8_t* alpha, unsigned stride, size_t pixelCount)
+{
+    for (size_t i = 0; i < pixelCount; i++, alpha += stride)
+    {
+        for (unsigned c = 0; c < colorCount; c++, colors++)
+            *colors = divide255(*colors * *alpha);
+    }
+}
+
+// ITU-R BT.601 luma, in 8 bit fixed point
+uint8_t getGray(unsigned r, unsigned g, unsigned b)
+{
+    return (uint8_t)((r * 77 + g * 150 + b * 29 + 128) >> 8);
+}
+
+// Divide by 255 with rounding, exact for the products of two bytes
+uint8_t divide255(unsigned value)
+{
+    value += 128;
+    return (uint8_t)((value + (value >> 8)) >> 8);
+}
+
+// Get the device color space with the same components, for the
+// device color spaces and for those approximated with them
+PdfColorSpace getDeviceColorSpace(const PdfObject* colorSpace)
+{
+    if (colorSpace == nullptr)
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedImageFormat, "The image has no color space");
+
+    const PdfName* name;
+    const PdfArray* arr = nullptr;
+    if (colorSpace->IsArray())
+    {
+        arr = &colorSpace->GetArray();
+        if (arr->GetSize() == 0 || !arr->FindAt(0).TryGetName(name))
+            PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid color space");
+    }
+    else if (!colorSpace->TryGetName(name))
+    {
+        PDFMM_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid color space");
+    }
+
+    if (*name == "DeviceGray" || *name == "G" || *name == "CalGray")
+        return PdfColorSpace::DeviceGray;
+    else if (*name == "DeviceRGB" || *name == "RGB" || *name == "CalRGB")
+        return PdfColorSpace::DeviceRGB;
+    else if (*name == "DeviceCMYK" || *name == "CMYK")
+        return PdfColorSpace::DeviceCMYK;
+
+    if (*name == "ICCBased" && arr != nullptr && arr->GetSize() >= 2)
+    {
+        switch (arr->FindAt(1).GetDictionary().FindKeyAs<int64_t>("N", 0))
+        {
+            case 1:
+                return PdfColorSpace::DeviceGray;
+            case 3:
+                return PdfColorSpace::DeviceRGB;
+            case 4:
+                return PdfColorSpace::DeviceCMYK;
+            default:
+                break;
+        }
+    }
+
+    PDFMM_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedImageFormat, "Unsupported image color space");
+}
+
+void invertSamples(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    size_t i = 0;
+#ifdef PDFMM_IMAGE_CONVERSION_SSE2
+    __m128i ones = _mm_set1_epi8((char)0xFF);
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(bytes, ones));
+    }
+#endif // PDFMM_IMAGE_CONVERSION_SSE2
+    for (; i < count; i++)
+        dst[i] = (uint8_t)(255 - src[i]);
+}
+
+// Pack the RGB colors to the pixels of the formats
+// with a different order of the components
+void packRow(const uint8_t* colors, uint8_t* dst, size_t pixelCount, PdfPixelFormat format)
+{
+    switch (format)
+    {
+        case PdfPixelFormat::BGR24:
+        {
+            for (size_t i = 0; i < pixelCount; i++, colors += 3, dst += 3)
+            {
+                dst[0] = colors[2];
+                dst[1] = colors[1];
+                dst[2] = colors[0];
+            }
+            break;
+        }
+        case PdfPixelFormat::ARGB:
+        case PdfPixelFormat::BGRA:
+        {
+            // Expand to opaque RGBA, then reorder the pixels
+            uint8_t* pixels = dst;
+            for (size_t i = 0; i < pixelCount; i++, colors += 3, pixels += 4)
+            {
+                pixels[0] = colors[0];
+                pixels[1] = colors[1];
+                pixels[2] = colors[2];
+                pixels[3] = 255;
+            }
+            reorderPixels(dst, pixelCount, format);
+            break;
+        }
+        default:
+            PDFMM_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
+    }
+}
+
+// Reorder RGBA pixels in place to ARGB or BGRA
+void reorderPixels(uint8_t* pixels, size_t pixelCount, PdfPixelFormat format)
+{
+    size_t i = 0;
+    if (format == PdfPixelFormat::ARGB)
+    {
+#ifdef PDFMM_IMAGE_CONVERSION_SSE2
+        // Rotate every little endian 32 bit pixel by 8 bits
+        for (; i + 4 <= pixelCount; i += 4)
+        {
+            auto ptr = reinterpret_cast<__m128i*>(pixels + i * 4);
+            __m128i values = _mm_loadu_si128(ptr);
+            _mm_storeu_si128(ptr, _mm_or_si128(_mm_slli_epi32(values, 8), _mm_srli_epi32(values, 24)));
+        }
+#endif // PDFMM_IMAGE_CONVERSION_SSE2
+        for (; i < pixelCount; i++)
+        {
+            auto pixel = pixels + i * 4;
+            uint8_t alpha = pixel[3];
+            pixel[3] = pixel[2];
+            pixel[2] = pixel[1];
+            pixel[1] = pixel[0];
+            pixel[0] = alpha;
+        }
+    }
+    else
+    {
+#ifdef PDFMM_IMAGE_CONVERSION_SSE2
+        // Swap the first and the third byte of every 32 bit pixel
+        __m128i lowMask = _mm_set1_epi32(0xFF);
+        __m128i keepMask = _mm_set1_epi32((int)0xFF00FF00);
+        for (; i + 4 <= pixelCount; i += 4)
+        {
+            auto ptr = reinterpret_cast<__m128i*>(pixels + i * 4);
+            __m128i values = _mm_loadu_si128(ptr);
+            __m128i swapped = _mm_or_si128(
+                _mm_and_si128(_mm_srli_epi32(values, 16), lowMask),
+                _mm_slli_epi32(_mm_and_si128(values, lowMask), 16));
+            _mm_storeu_si128(ptr, _mm_or_si128(_mm_and_si128(values, keepMask), swapped));
+        }
+#endif // PDFMM_IMAGE_CONVERSION_SSE2
+        for (; i < pixelCount; i++)
+            std::swap(pixels[i * 4], pixels[i * 4 + 2]);
+    }
+}
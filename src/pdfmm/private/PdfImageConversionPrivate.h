@@ -0,0 +1,180 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_IMAGE_CONVERSION_PRIVATE_H
+#define PDF_IMAGE_CONVERSION_PRIVATE_H
+
+#include <pdfmm/base/PdfImage.h>
+#include <pdfmm/base/PdfInputStream.h>
+#include <pdfmm/base/PdfOutputStream.h>
+
+namespace mm
+{
+    class PdfArray;
+    class PdfObject;
+    class PdfObjectStream;
+
+    /** An input stream reading rows of pixels from a source stream
+     * and supplying them scaled down and converted to another color
+     * space, with 8 bits per component
+     *
+     * Only the source rows needed by the current output row are
+     * kept, so the memory used depends only on the image width
+     */
+    class ImageConversionStream final : public InputStream
+    {
+    public:
+        ImageConversionStream(InputStream& source, unsigned width, unsigned height,
+            PdfPixelFormat format, unsigned targetWidth, unsigned targetHeight,
+            PdfImageResampling resampling, PdfColorSpace colorSpace,
+            bool premultiplyAlpha);
+
+    public:
+        /** Set the stream where the rows of the alpha of the pixels
+         *  are appended, or nullptr to drop them
+         */
+        void SetAlphaStream(PdfObjectStream* alpha) { m_alpha = alpha; }
+
+        /** Get the number of color components of the given
+         *  color space, 0 if the space is not supported
+         */
+        static unsigned GetColorComponentCount(PdfColorSpace colorSpace);
+
+        /** Get the color space of the given pixel format,
+         *  PdfColorSpace::Unknown if the format is not supported
+         */
+        static PdfColorSpace GetColorSpace(PdfPixelFormat format);
+
+    protected:
+        size_t readBuffer(char* buffer, size_t size, bool& eof) override;
+
+    private:
+        void nextRow();
+        void scaleBox();
+        void scaleBilinear();
+        const uint8_t* getSourceRow(unsigned index);
+        void readSourceRow(uint8_t* row);
+
+    private:
+        InputStream* m_source;
+        unsigned m_width;
+        unsigned m_height;
+        PdfPixelFormat m_format;
+        unsigned m_targetWidth;
+        unsigned m_targetHeight;
+        PdfImageResampling m_resampling;
+        PdfColorSpace m_sourceColorSpace;
+        PdfColorSpace m_colorSpace;
+        bool m_premultiplyAlpha;
+        PdfObjectStream* m_alpha;
+        unsigned m_channelCount;
+        bool m_hasAlpha;
+        unsigned m_sourceRowIndex;
+        charbuff m_sourceRow;
+        // The unpacked source rows, with the color components
+        // in RGB, gray or CMYK order followed by the alpha
+        std::vector<uint8_t> m_rows[2];
+        unsigned m_rowIndices[2];
+        std::vector<uint8_t> m_scaledRow;
+        std::vector<uint32_t> m_sums;
+        std::vector<uint16_t> m_blendedRow;
+        // For every target column, the first source column and for
+        // bilinear resampling the weight of the next one, out of 256
+        std::vector<unsigned> m_columns;
+        std::vector<unsigned> m_weights;
+        unsigned m_rowIndex;
+        charbuff m_colorRow;
+        charbuff m_alphaRow;
+        size_t m_offset;
+    };
+
+    /** An output stream receiving the decoded data of an image and
+     * writing the rows of pixels, converted to a pixel format,
+     * straight into a buffer
+     *
+     * The samples are mapped through /Decode with a lookup table for
+     * every component, and the palette of an indexed image is converted
+     * once to the target color space. Only a partial source row is
+     * kept, the complete rows are converted from the written data
+     */
+    class ImageDecodeStream final : public OutputStream
+    {
+    public:
+        /**
+         * \param stride the length of the rows of the buffer, or 0
+         *      for rows with no padding
+         */
+        ImageDecodeStream(const PdfObject& image, PdfPixelFormat format,
+            char* buffer, size_t stride);
+
+    public:
+        /** Write the gray of the pixels into a single byte of the pixels
+         *  of the buffer, leaving the others, e.g. to fill the alpha
+         *  from a soft mask. The pixel format must be gray
+         *  \param pixelSize the size of the pixels of the buffer
+         *  \param offset the offset of the byte in the pixels
+         */
+        void SetComponentTarget(unsigned pixelSize, unsigned offset);
+
+        /** Convert the rows missing from the data as zero samples
+         */
+        void Finish();
+
+        /** Get the size of the pixels of the given format
+         */
+        static unsigned GetPixelSize(PdfPixelFormat format);
+
+        /** Get the size of the buffer required by the rows
+         */
+        size_t GetBufferSize() const;
+
+        inline unsigned GetWidth() const { return m_width; }
+        inline unsigned GetHeight() const { return m_height; }
+
+    protected:
+        void writeBuffer(const char* buffer, size_t size) override;
+
+    private:
+        void initLookupTables(const PdfObject* decode, unsigned maxValue);
+        void initPalette(const PdfArray& indexed);
+        void convertRow(const uint8_t* row);
+        const uint8_t* unpackSamples(const uint8_t* row, uint8_t* dst);
+
+    private:
+        uint8_t* m_buffer;
+        size_t m_stride;
+        PdfPixelFormat m_format;
+        unsigned m_width;
+        unsigned m_height;
+        unsigned m_bitsPerComponent;
+        unsigned m_componentCount;
+        PdfColorSpace m_sourceColorSpace;
+        PdfColorSpace m_colorSpace;
+        bool m_indexed;
+        // A table of 256 entries for every component, indexed by the
+        // samples or by their high byte, to the components or the indices
+        std::vector<uint8_t> m_lookupTables;
+        bool m_uniformLookup;
+        bool m_identityLookup;
+        bool m_invertedLookup;
+        // For the samples of less than 8 bits, when the tables
+        // are the same, the samples of every byte looked up
+        std::vector<uint8_t> m_expansionTable;
+        // The colors of the 256 indices, in the target color space
+        std::vector<uint8_t> m_palette;
+        unsigned m_pixelSize;
+        unsigned m_componentOffset;
+        bool m_componentTarget;
+        charbuff m_row;
+        size_t m_rowOffset;
+        unsigned m_rowIndex;
+        std::vector<uint8_t> m_components;
+        std::vector<uint8_t> m_colors;
+    };
+}
+
+#endif // PDF_IMAGE_CONVERSION_PRIVATE_H
@@ -0,0 +1,152 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfPoolPrivate.h"
+
+using namespace std;
+using namespace mm;
+
+// The maximum count of the entries of every pool
+static constexpr size_t MaxPoolSize = 4;
+// Larger scratch buffers are freed, not to hold their memory
+static constexpr size_t MaxScratchBufferCapacity = 4 * 1024 * 1024;
+
+namespace
+{
+    class Pools final
+    {
+    public:
+        ~Pools();
+
+    public:
+        vector<z_stream*> InflateContexts;
+        vector<z_stream*> DeflateContexts;
+        vector<unique_ptr<charbuff>> ScratchBuffers;
+    };
+}
+
+static thread_local Pools s_pools;
+// NOTE: The pools may be destroyed before other thread local or
+// static objects that still release entries, which are freed then
+static thread_local bool s_poolsDestroyed = false;
+
+static z_stream* newZlibStream();
+
+ZlibInflatePtr mm::AcquireInflateContext()
+{
+    if (!s_poolsDestroyed && s_pools.InflateContexts.size() != 0)
+    {
+        ZlibInflatePtr ret(s_pools.InflateContexts.back());
+        s_pools.InflateContexts.pop_back();
+        if (inflateReset(ret.get()) != Z_OK)
+            PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
+
+        return ret;
+    }
+
+    unique_ptr<z_stream> stream(newZlibStream());
+    if (inflateInit(stream.get()) != Z_OK)
+        PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
+
+    return ZlibInflatePtr(stream.release());
+}
+
+ZlibDeflatePtr mm::AcquireDeflateContext(int level)
+{
+    if (!s_poolsDestroyed && s_pools.DeflateContexts.size() != 0)
+    {
+        ZlibDeflatePtr ret(s_pools.DeflateContexts.back());
+        s_pools.DeflateContexts.pop_back();
+        // NOTE: Changing the parameters of a context
+        // just reset is allowed, as it has no input
+        if (deflateReset(ret.get()) != Z_OK
+            || deflateParams(ret.get(), level, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
+        }
+
+        return ret;
+    }
+
+    unique_ptr<z_stream> stream(newZlibStream());
+    if (deflateInit(stream.get(), level) != Z_OK)
+        PDFMM_RAISE_ERROR(PdfErrorCode::Flate);
+
+    return ZlibDeflatePtr(stream.release());
+}
+
+void ZlibInflateReleaser::operator()(z_stream* stream) const
+{
+    if (!s_poolsDestroyed && s_pools.InflateContexts.size() < MaxPoolSize)
+    {
+        s_pools.InflateContexts.push_back(stream);
+        return;
+    }
+
+    (void)inflateEnd(stream);
+    delete stream;
+}
+
+void ZlibDeflateReleaser::operator()(z_stream* stream) const
+{
+    if (!s_poolsDestroyed && s_pools.DeflateContexts.size() < MaxPoolSize)
+    {
+        s_pools.DeflateContexts.push_back(stream);
+        return;
+    }
+
+    (void)deflateEnd(stream);
+    delete stream;
+}
+
+PdfScratchBuffer::PdfScratchBuffer()
+{
+    if (!s_poolsDestroyed && s_pools.ScratchBuffers.size() != 0)
+    {
+        m_buffer = std::move(s_pools.ScratchBuffers.back());
+        s_pools.ScratchBuffers.pop_back();
+    }
+    else
+    {
+        m_buffer.reset(new charbuff());
+    }
+}
+
+PdfScratchBuffer::~PdfScratchBuffer()
+{
+    if (s_poolsDestroyed || s_pools.ScratchBuffers.size() >= MaxPoolSize
+        || m_buffer->capacity() > MaxScratchBufferCapacity)
+    {
+        return;
+    }
+
+    m_buffer->clear();
+    s_pools.ScratchBuffers.push_back(std::move(m_buffer));
+}
+
+Pools::~Pools()
+{
+    s_poolsDestroyed = true;
+    for (auto stream : InflateContexts)
+    {
+        (void)inflateEnd(stream);
+        delete stream;
+    }
+
+    for (auto stream : DeflateContexts)
+    {
+        (void)deflateEnd(stream);
+        delete stream;
+    }
+}
+
+z_stream* newZlibStream()
+{
+    // NOTE: Value initialization sets the default allocators
+    return new z_stream();
+}
@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_POOL_PRIVATE_H
+#define PDF_POOL_PRIVATE_H
+
+#include <memory>
+
+#include <zlib.h>
+
+namespace mm
+{
+    // Thread local pools of the memory used temporarily by the filters
+    // and the streams. Without them, processing many small streams
+    // allocates again for every stream the zlib state, that is about
+    // 256KB for deflate and 40KB for inflate, and the scratch buffers.
+    // Only a few entries are kept for every thread, the others are freed
+
+    struct ZlibInflateReleaser
+    {
+        void operator()(z_stream* stream) const;
+    };
+
+    struct ZlibDeflateReleaser
+    {
+        void operator()(z_stream* stream) const;
+    };
+
+    using ZlibInflatePtr = std::unique_ptr<z_stream, ZlibInflateReleaser>;
+    using ZlibDeflatePtr = std::unique_ptr<z_stream, ZlibDeflateReleaser>;
+
+    /** Get an inflate context ready for a new stream. A context
+     * taken from the pool is reset with inflateReset, and it's
+     * given back to the pool when released
+     * \throws PdfError with PdfErrorCode::Flate if a new context
+     *     can't be initialized
+     */
+    ZlibInflatePtr AcquireInflateContext();
+
+    /** Get a deflate context ready for a new stream with the given
+     * zlib compression level. A context taken from the pool is
+     * reset with deflateReset, and its level set with deflateParams
+     * \throws PdfError with PdfErrorCode::Flate if a new context
+     *     can't be initialized
+     */
+    ZlibDeflatePtr AcquireDeflateContext(int level);
+
+    /** A scratch buffer borrowed from the pool, empty when acquired.
+     * It's given back to the pool with its capacity when destroyed,
+     * unless it grew too large to be kept
+     */
+    class PdfScratchBuffer final
+    {
+    public:
+        PdfScratchBuffer();
+        ~PdfScratchBuffer();
+
+        inline charbuff& operator*() { return *m_buffer; }
+        inline charbuff* operator->() { return m_buffer.get(); }
+
+    private:
+        PdfScratchBuffer(const PdfScratchBuffer&) = delete;
+        PdfScratchBuffer& operator=(const PdfScratchBuffer&) = delete;
+
+    private:
+        std::unique_ptr<charbuff> m_buffer;
+    };
+}
+
+#endif // PDF_POOL_PRIVATE_H
@@ -0,0 +1,187 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfPredictorPrivate.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define PDFMM_PREDICTOR_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PDFMM_PREDICTOR_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+using namespace mm;
+
+static unsigned char paethPredictor(unsigned char a, unsigned char b, unsigned char c);
+
+#ifdef PDFMM_PREDICTOR_SSE2
+
+static __m128i loadPixel(const char* buffer, unsigned bytesPerPixel);
+static void storePixel(char* buffer, __m128i pixel, unsigned bytesPerPixel);
+static __m128i absEpi16(__m128i value);
+static __m128i selectSi128(__m128i mask, __m128i a, __m128i b);
+
+#endif
+
+void mm::UnfilterPngSub(char* curr, const char* row, size_t length, unsigned bytesPerPixel)
+{
+    size_t i = 0;
+#if defined(PDFMM_PREDICTOR_SSE2)
+    if (bytesPerPixel == 1)
+    {
+        // Running sum of the 16 bytes with shifted additions,
+        // plus the last decoded byte of the previous block
+        __m128i last = _mm_setzero_si128();
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+            bytes = _mm_add_epi8(bytes, _mm_slli_si128(bytes, 1));
+            bytes = _mm_add_epi8(bytes, _mm_slli_si128(bytes, 2));
+            bytes = _mm_add_epi8(bytes, _mm_slli_si128(bytes, 4));
+            bytes = _mm_add_epi8(bytes, _mm_slli_si128(bytes, 8));
+            bytes = _mm_add_epi8(bytes, last);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(curr + i), bytes);
+            last = _mm_set1_epi8(curr[i + 15]);
+        }
+    }
+    else if (bytesPerPixel == 3 || bytesPerPixel == 4)
+    {
+        // The components of a pixel are decoded at once
+        __m128i left = _mm_setzero_si128();
+        for (; i + bytesPerPixel <= length; i += bytesPerPixel)
+        {
+            left = _mm_add_epi8(loadPixel(row + i, bytesPerPixel), left);
+            storePixel(curr + i, left, bytesPerPixel);
+        }
+    }
+#endif
+
+    for (; i < length; i++)
+        curr[i] = (char)(row[i] + (i < bytesPerPixel ? 0 : curr[i - bytesPerPixel]));
+}
+
+void mm::UnfilterPngUp(char* curr, const char* row, const char* up, size_t length)
+{
+    size_t i = 0;
+#if defined(PDFMM_PREDICTOR_SSE2)
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i bytes = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + i)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(curr + i), bytes);
+    }
+#elif defined(PDFMM_PREDICTOR_NEON)
+    for (; i + 16 <= length; i += 16)
+    {
+        uint8x16_t bytes = vaddq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(row + i)),
+            vld1q_u8(reinterpret_cast<const uint8_t*>(up + i)));
+        vst1q_u8(reinterpret_cast<uint8_t*>(curr + i), bytes);
+    }
+#endif
+
+    for (; i < length; i++)
+        curr[i] = (char)(row[i] + up[i]);
+}
+
+void mm::UnfilterPngAverage(char* curr, const char* row, const char* up, size_t length, unsigned bytesPerPixel)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned left = i < bytesPerPixel ? 0 : (unsigned char)curr[i - bytesPerPixel];
+        curr[i] = (char)(row[i] + ((left + (unsigned char)up[i]) >> 1));
+    }
+}
+
+void mm::UnfilterPngPaeth(char* curr, const char* row, const char* up, size_t length, unsigned bytesPerPixel)
+{
+    size_t i = 0;
+#if defined(PDFMM_PREDICTOR_SSE2)
+    if (bytesPerPixel == 3 || bytesPerPixel == 4)
+    {
+        // The predictors of the components of a pixel are computed at
+        // once with 16 bits arithmetic. "a" is the left pixel, "b"
+        // the upper pixel and "c" the upper left pixel
+        __m128i zero = _mm_setzero_si128();
+        __m128i a = zero;
+        __m128i c = zero;
+        for (; i + bytesPerPixel <= length; i += bytesPerPixel)
+        {
+            __m128i b = _mm_unpacklo_epi8(loadPixel(up + i, bytesPerPixel), zero);
+            __m128i pa = _mm_sub_epi16(b, c);
+            __m128i pb = _mm_sub_epi16(a, c);
+            __m128i pc = absEpi16(_mm_add_epi16(pa, pb));
+            pa = absEpi16(pa);
+            pb = absEpi16(pb);
+            __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+            __m128i nearest = selectSi128(_mm_cmpeq_epi16(smallest, pa), a,
+                selectSi128(_mm_cmpeq_epi16(smallest, pb), b, c));
+            __m128i pixel = _mm_add_epi8(loadPixel(row + i, bytesPerPixel), _mm_packus_epi16(nearest, nearest));
+            storePixel(curr + i, pixel, bytesPerPixel);
+            a = _mm_unpacklo_epi8(pixel, zero);
+            c = b;
+        }
+    }
+#endif
+
+    for (; i < length; i++)
+    {
+        if (i < bytesPerPixel)
+        {
+            curr[i] = (char)(row[i] + up[i]);
+        }
+        else
+        {
+            curr[i] = (char)(row[i] + paethPredictor((unsigned char)curr[i - bytesPerPixel],
+                (unsigned char)up[i], (unsigned char)up[i - bytesPerPixel]));
+        }
+    }
+}
+
+unsigned char paethPredictor(unsigned char a, unsigned char b, unsigned char c)
+{
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    else if (pb <= pc)
+        return b;
+    else
+        return c;
+}
+
+#ifdef PDFMM_PREDICTOR_SSE2
+
+__m128i loadPixel(const char* buffer, unsigned bytesPerPixel)
+{
+    // NOTE: Load exactly the bytes of the pixel, not to read past the row
+    int32_t pixel = 0;
+    std::memcpy(&pixel, buffer, bytesPerPixel);
+    return _mm_cvtsi32_si128(pixel);
+}
+
+void storePixel(char* buffer, __m128i pixel, unsigned bytesPerPixel)
+{
+    int32_t value = _mm_cvtsi128_si32(pixel);
+    std::memcpy(buffer, &value, bytesPerPixel);
+}
+
+__m128i absEpi16(__m128i value)
+{
+    return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+}
+
+__m128i selectSi128(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_PREDICTOR_PRIVATE_H
+#define PDF_PREDICTOR_PRIVATE_H
+
+namespace mm
+{
+    // Functions to undo the PNG filters of a row, see the PNG
+    // specification, 9 "Filtering". The decoded row is written in
+    // "curr", which must not overlap with the other rows. "up" is the
+    // previous decoded row, all zeros for the first row.
+    // The Sub and Paeth filters are vectorized for 1, 3 and 4 bytes
+    // per pixel, the Up filter for any, when SSE2 is available.
+    // The Up filter is vectorized also when NEON is available
+
+    /** Undo the PNG Sub filter, that is also the TIFF predictor 2 for 8 bits per component
+     */
+    void UnfilterPngSub(char* curr, const char* row, size_t length, unsigned bytesPerPixel);
+
+    /** Undo the PNG Up filter
+     */
+    void UnfilterPngUp(char* curr, const char* row, const char* up, size_t length);
+
+    /** Undo the PNG Average filter
+     */
+    void UnfilterPngAverage(char* curr, const char* row, const char* up, size_t length, unsigned bytesPerPixel);
+
+    /** Undo the PNG Paeth filter
+     */
+    void UnfilterPngPaeth(char* curr, const char* row, const char* up, size_t length, unsigned bytesPerPixel);
+}
+
+#endif // PDF_PREDICTOR_PRIVATE_H
@@ -13,7 +13,15 @@
 
 namespace mm {
 
-using Std14CPToGIDMap = std::unordered_map<unsigned short, unsigned char>;
+struct Std14CPToGIDEntry
+{
+    unsigned short CodePoint;
+    unsigned char GID;
+};
+
+/** The code points of a font mapped to its glyphs, sorted by code point
+ */
+using Std14CPToGIDMap = cspan<Std14CPToGIDEntry>;
 
 std::string_view GetStandard14FontName(PdfStandard14FontType stdFont);
 
@@ -25,7 +33,7 @@ bool IsStandard14Font(const std::string_view& fontName, bool useAltNames, PdfSta
 
 const unsigned short* GetStd14FontWidths(PdfStandard14FontType stdFont, unsigned& size);
 
-const Std14CPToGIDMap& GetStd14CPToGIDMap(PdfStandard14FontType stdFont);
+Std14CPToGIDMap GetStd14CPToGIDMap(PdfStandard14FontType stdFont);
 
 bufferview GetStandard14FontFileData(PdfStandard14FontType stdFont);
 
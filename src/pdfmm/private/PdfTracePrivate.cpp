@@ -0,0 +1,43 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfTracePrivate.h"
+
+#ifdef PDFMM_HAVE_TRACING
+
+using namespace std;
+using namespace mm;
+
+TraceScope::TraceScope(PdfTraceEventType type, const PdfDocument* document)
+    : m_sink(PdfTrace::GetSink(document))
+{
+    if (m_sink == nullptr)
+        return;
+
+    m_event.Type = type;
+    m_event.Document = document;
+    m_start = chrono::steady_clock::now();
+}
+
+TraceScope::~TraceScope()
+{
+    End();
+}
+
+void TraceScope::End()
+{
+    if (m_sink == nullptr)
+        return;
+
+    m_event.Duration = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - m_start);
+    auto sink = m_sink;
+    m_sink = nullptr;
+    sink->OnEvent(m_event);
+}
+
+#endif // PDFMM_HAVE_TRACING
@@ -0,0 +1,63 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public License 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef PDF_TRACE_PRIVATE_H
+#define PDF_TRACE_PRIVATE_H
+
+#include <pdfmm/base/PdfTrace.h>
+
+// The tracing hooks. Without PDFMM_HAVE_TRACING they expand to
+// nothing, and the expressions of the traced values are not evaluated
+//
+// PDFMM_TRACE_SCOPE(name, type, document) starts an event, delivered
+// when the scope ends or when PDFMM_TRACE_END(name) is called.
+// PDFMM_TRACE_SET(name, field, value) sets a field of the event,
+// evaluating the value only if a sink is listening
+
+#ifdef PDFMM_HAVE_TRACING
+
+namespace mm
+{
+    class TraceScope final
+    {
+    public:
+        TraceScope(PdfTraceEventType type, const PdfDocument* document);
+        ~TraceScope();
+
+    public:
+        /** Deliver the event now, instead of at the end of the scope
+         */
+        void End();
+
+        inline bool IsEnabled() const { return m_sink != nullptr; }
+
+        inline PdfTraceEvent& GetEvent() { return m_event; }
+
+    private:
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+
+    private:
+        PdfTraceSink* m_sink;
+        std::chrono::steady_clock::time_point m_start;
+        PdfTraceEvent m_event;
+    };
+}
+
+#define PDFMM_TRACE_SCOPE(name, type, document) mm::TraceScope name(mm::PdfTraceEventType::type, document)
+#define PDFMM_TRACE_SET(name, field, value) do { if (name.IsEnabled()) name.GetEvent().field = value; } while (false)
+#define PDFMM_TRACE_END(name) name.End()
+
+#else // PDFMM_HAVE_TRACING
+
+#define PDFMM_TRACE_SCOPE(name, type, document)
+#define PDFMM_TRACE_SET(name, field, value) do { } while (false)
+#define PDFMM_TRACE_END(name) do { } while (false)
+
+#endif // PDFMM_HAVE_TRACING
+
+#endif // PDF_TRACE_PRIVATE_H
@@ -1,6 +1,7 @@
 #include "PdfDeclarationsPrivate.h"
 #include "XMPUtils.h"
 
+#include <libxml/parser.h>
 #include <libxml/xmlsave.h>
 
 #include "XmlUtils.h"
@@ -47,7 +48,43 @@ enum class XMPListType
     Bag,
 };
 
-static unordered_map<string, XMPListType> s_knownListNodes = {
+namespace
+{
+    struct KnownListNode
+    {
+        string_view Name;
+        XMPListType Type;
+    };
+
+    // The state of the streaming read of the XMP properties. It follows
+    // the lookups done on the normalized packet by GetXMPMetadata:
+    // the first property found in the top level rdf:Description
+    // elements wins, even if it has no usable value
+    struct XMPReadContext
+    {
+        static constexpr unsigned PropertyCount = (unsigned)XMPMetadataKind::PdfARevision;
+
+        bool HasXMPMeta = false;
+        bool RDFVisited = false;
+        unsigned Depth = 0;
+        unsigned RDFDepth = 0;
+        unsigned DescriptionDepth = 0;
+        // The property being read and the element whose text is captured
+        nullable<XMPMetadataKind> Property;
+        bool PropertyIsList = false;
+        unsigned ContainerCount = 0;
+        unsigned ItemCount = 0;
+        unsigned CaptureDepth = 0;
+        string Text;
+        // The simple properties set as attributes of the current
+        // rdf:Description, that come after its child elements
+        vector<pair<XMPMetadataKind, nullable<string>>> Attributes;
+        bool Found[PropertyCount] = { };
+        nullable<string> Values[PropertyCount];
+    };
+}
+
+static constexpr KnownListNode s_knownListNodes[] = {
     { "dc:date", XMPListType::Seq },
     { "dc:language", XMPListType::Bag },
 };
@@ -80,6 +117,12 @@ static string getNodeName(xmlNodePtr node);
 static string getAttributeName(xmlAttrPtr attr);
 static nullable<PdfString> getListElementText(xmlNodePtr elem);
 static nullable<PdfString> getElementText(xmlNodePtr elem);
+static bool tryGetXMPProperty(const string_view& prefix, const string_view& name, XMPMetadataKind& kind, bool& isList);
+static void xmpReadStartElement(void* ctx, const xmlChar* localname, const xmlChar* prefix, const xmlChar* uri,
+    int nbNamespaces, const xmlChar** namespaces, int nbAttributes, int nbDefaulted, const xmlChar** attributes);
+static void xmpReadEndElement(void* ctx, const xmlChar* localname, const xmlChar* prefix, const xmlChar* uri);
+static void xmpReadCharacters(void* ctx, const xmlChar* ch, int len);
+static void setXMPPropertyValue(XMPReadContext& context, XMPMetadataKind kind, nullable<string> value);
 
 PdfXMPMetadata mm::GetXMPMetadata(const string_view& xmpview, unique_ptr<PdfXMPPacket>& packet)
 {
@@ -148,6 +191,56 @@ PdfXMPMetadata mm::GetXMPMetadata(const string_view& xmpview, unique_ptr<PdfXMPP
     return metadata;
 }
 
+bool mm::TryReadXMPMetadata(const string_view& xmpview, PdfXMPMetadata& metadata)
+{
+    utls::InitXml();
+
+    xmlSAXHandler handler;
+    memset(&handler, 0, sizeof(handler));
+    handler.initialized = XML_SAX2_MAGIC;
+    handler.startElementNs = xmpReadStartElement;
+    handler.endElementNs = xmpReadEndElement;
+    handler.characters = xmpReadCharacters;
+    handler.cdataBlock = xmpReadCharacters;
+
+    XMPReadContext context;
+    if (xmlSAXUserParseMemory(&handler, &context, xmpview.data(), (int)xmpview.size()) != 0
+        || !context.HasXMPMeta)
+    {
+        return false;
+    }
+
+    auto getValue = [&context](XMPMetadataKind kind) -> const nullable<string>&
+    {
+        return context.Values[(unsigned)kind];
+    };
+
+    metadata = { };
+    auto& part = getValue(XMPMetadataKind::PdfALevel);
+    auto& conformance = getValue(XMPMetadataKind::PdfAConformance);
+    if (part.has_value() && conformance.has_value())
+        metadata.PdfaLevel = getPDFALevelFromString(*part + *conformance);
+
+    nullable<PdfString>* strings[] = { &metadata.Title, &metadata.Author, &metadata.Subject,
+        &metadata.Keywords, &metadata.Creator, &metadata.Producer };
+    for (unsigned i = 0; i < std::size(strings); i++)
+    {
+        auto& value = getValue((XMPMetadataKind)i);
+        if (value.has_value())
+            *strings[i] = PdfString(*value);
+    }
+
+    auto& creationDate = getValue(XMPMetadataKind::CreationDate);
+    if (creationDate.has_value())
+        metadata.CreationDate = PdfDate::ParseW3C(PdfString(*creationDate));
+
+    auto& modDate = getValue(XMPMetadataKind::ModDate);
+    if (modDate.has_value())
+        metadata.ModDate = PdfDate::ParseW3C(PdfString(*modDate));
+
+    return true;
+}
+
 void mm::UpdateOrCreateXMPMetadata(unique_ptr<PdfXMPPacket>& packet, const PdfXMPMetadata& metatata)
 {
     utls::InitXml();
@@ -316,15 +409,16 @@ void tryFixArrayElement(xmlDocPtr doc, xmlNodePtr& node, const string& nodeConte
         return;
 
     auto nodename = getNodeName(node);
-    auto found = s_knownListNodes.find(nodename);
-    if (found == s_knownListNodes.end())
+    auto found = std::find_if(std::begin(s_knownListNodes), std::end(s_knownListNodes),
+        [&nodename](const KnownListNode& node) { return node.Name == nodename; });
+    if (found == std::end(s_knownListNodes))
         return;
 
     // Delete existing content
     xmlNodeSetContent(node, nullptr);
 
     xmlNodePtr newNode;
-    setListNodeContent(doc, node, found->second, cspan<string>(&nodeContent, 1), newNode);
+    setListNodeContent(doc, node, found->Type, cspan<string>(&nodeContent, 1), newNode);
     node = newNode;
 }
 
@@ -927,3 +1021,211 @@ string PdfXMPPacket::ToString() const
     ToString(ret);
     return ret;
 }
+
+bool tryGetXMPProperty(const string_view& prefix, const string_view& name, XMPMetadataKind& kind, bool& isList)
+{
+    // NOTE: xmp:CreatorTool is read as a list, as done by GetXMPMetadata
+    isList = false;
+    if (prefix == "dc")
+    {
+        isList = true;
+        if (name == "title")
+            kind = XMPMetadataKind::Title;
+        else if (name == "creator")
+            kind = XMPMetadataKind::Author;
+        else if (name == "description")
+            kind = XMPMetadataKind::Subject;
+        else
+            return false;
+    }
+    else if (prefix == "pdf")
+    {
+        if (name == "Keywords")
+            kind = XMPMetadataKind::Keywords;
+        else if (name == "Producer")
+            kind = XMPMetadataKind::Producer;
+        else
+            return false;
+    }
+    else if (prefix == "xmp")
+    {
+        if (name == "CreatorTool")
+        {
+            kind = XMPMetadataKind::Creator;
+            isList = true;
+        }
+        else if (name == "CreateDate")
+        {
+            kind = XMPMetadataKind::CreationDate;
+        }
+        else if (name == "ModifyDate")
+        {
+            kind = XMPMetadataKind::ModDate;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    else if (prefix == "pdfaid")
+    {
+        if (name == "part")
+            kind = XMPMetadataKind::PdfALevel;
+        else if (name == "conformance")
+            kind = XMPMetadataKind::PdfAConformance;
+        else
+            return false;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+void xmpReadStartElement(void* ctx, const xmlChar* localname, const xmlChar* prefix, const xmlChar* uri,
+    int nbNamespaces, const xmlChar** namespaces, int nbAttributes, int nbDefaulted, const xmlChar** attributes)
+{
+    (void)uri;
+    (void)nbNamespaces;
+    (void)namespaces;
+    (void)nbDefaulted;
+    auto& context = *(XMPReadContext*)ctx;
+    context.Depth++;
+    string_view name = (const char*)localname;
+    string_view prefixStr = prefix == nullptr ? string_view() : (const char*)prefix;
+    if (context.Depth == 1)
+    {
+        context.HasXMPMeta = name == "xmpmeta";
+        return;
+    }
+
+    if (context.RDFDepth == 0)
+    {
+        // Only the first rdf:RDF child of x:xmpmeta is considered
+        if (context.Depth == 2 && !context.RDFVisited && prefixStr == "rdf" && name == "RDF")
+        {
+            context.RDFDepth = context.Depth;
+            context.RDFVisited = true;
+        }
+
+        return;
+    }
+
+    if (context.DescriptionDepth == 0)
+    {
+        if (context.Depth == context.RDFDepth + 1 && prefixStr == "rdf" && name == "Description")
+        {
+            context.DescriptionDepth = context.Depth;
+            XMPMetadataKind kind;
+            bool isList;
+            for (int i = 0; i < nbAttributes; i++)
+            {
+                auto attr = attributes + i * 5;
+                if (attr[1] == nullptr
+                    || !tryGetXMPProperty((const char*)attr[1], (const char*)attr[0], kind, isList))
+                {
+                    continue;
+                }
+
+                // Lists set as attributes have no items
+                if (isList)
+                    context.Attributes.push_back({ kind, { } });
+                else
+                    context.Attributes.push_back({ kind, string((const char*)attr[3], attr[4] - attr[3]) });
+            }
+        }
+
+        return;
+    }
+
+    if (context.Depth == context.DescriptionDepth + 1)
+    {
+        XMPMetadataKind kind;
+        bool isList;
+        if (!tryGetXMPProperty(prefixStr, name, kind, isList) || context.Found[(unsigned)kind])
+            return;
+
+        context.Property = kind;
+        context.PropertyIsList = isList;
+        context.ContainerCount = 0;
+        context.ItemCount = 0;
+        if (!isList)
+        {
+            context.CaptureDepth = context.Depth;
+            context.Text.clear();
+        }
+
+        return;
+    }
+
+    if (!context.Property.has_value() || !context.PropertyIsList)
+        return;
+
+    // Lists are read from the first item of the first container
+    if (context.Depth == context.DescriptionDepth + 2)
+    {
+        context.ContainerCount++;
+    }
+    else if (context.Depth == context.DescriptionDepth + 3 && context.ContainerCount == 1)
+    {
+        context.ItemCount++;
+        if (context.ItemCount == 1)
+        {
+            context.CaptureDepth = context.Depth;
+            context.Text.clear();
+        }
+    }
+}
+
+void xmpReadEndElement(void* ctx, const xmlChar* localname, const xmlChar* prefix, const xmlChar* uri)
+{
+    (void)localname;
+    (void)prefix;
+    (void)uri;
+    auto& context = *(XMPReadContext*)ctx;
+    if (context.CaptureDepth == context.Depth)
+    {
+        context.CaptureDepth = 0;
+        setXMPPropertyValue(context, *context.Property, std::move(context.Text));
+        context.Property = nullptr;
+    }
+    else if (context.Property.has_value() && context.Depth == context.DescriptionDepth + 1)
+    {
+        // A list without items
+        setXMPPropertyValue(context, *context.Property, { });
+        context.Property = nullptr;
+    }
+    else if (context.DescriptionDepth != 0 && context.Depth == context.DescriptionDepth)
+    {
+        // The attributes of the rdf:Description come after its child elements
+        for (auto& pair : context.Attributes)
+            setXMPPropertyValue(context, pair.first, std::move(pair.second));
+
+        context.Attributes.clear();
+        context.DescriptionDepth = 0;
+    }
+    else if (context.RDFDepth != 0 && context.Depth == context.RDFDepth)
+    {
+        context.RDFDepth = 0;
+    }
+
+    context.Depth--;
+}
+
+void xmpReadCharacters(void* ctx, const xmlChar* ch, int len)
+{
+    auto& context = *(XMPReadContext*)ctx;
+    if (context.CaptureDepth != 0)
+        context.Text.append((const char*)ch, (size_t)len);
+}
+
+void setXMPPropertyValue(XMPReadContext& context, XMPMetadataKind kind, nullable<string> value)
+{
+    if (context.Found[(unsigned)kind])
+        return;
+
+    context.Found[(unsigned)kind] = true;
+    context.Values[(unsigned)kind] = std::move(value);
+}
@@ -7,6 +7,10 @@
 namespace mm
 {
     PdfXMPMetadata PDFMM_API GetXMPMetadata(const std::string_view& xmpview, std::unique_ptr<PdfXMPPacket>& packet);
+    /** Read the metadata streaming the packet, without building its tree
+     * \returns false if the packet is not valid XMP
+     */
+    bool PDFMM_API TryReadXMPMetadata(const std::string_view& xmpview, PdfXMPMetadata& metadata);
     void PDFMM_API UpdateOrCreateXMPMetadata(std::unique_ptr<PdfXMPPacket>& packet, const PdfXMPMetadata& metatata);
 }
 
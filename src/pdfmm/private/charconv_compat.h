@@ -3,18 +3,24 @@
 
 #include <charconv>
 
-// Older gcc and clang may have no floating point from_chars
+// Older gcc and clang may have no floating point from_chars/to_chars
 #if defined(__GNUC__) && !defined(__clang__) && __GNUC__ < 11
 #define WANT_FROM_CHARS
+#define WANT_TO_CHARS
 #define WANT_CHARS_FORMAT
 #elif defined(__clang__) && __clang_major__ < 14
 #define WANT_FROM_CHARS
+#define WANT_TO_CHARS
 #endif
 
 #if defined(WANT_CHARS_FORMAT) || defined(WANT_FROM_CHARS)
 #include <fast_float.h>
 #endif
 
+#ifdef WANT_TO_CHARS
+#include "format_compat.h"
+#endif
+
 #ifdef WANT_CHARS_FORMAT
 
 namespace std
@@ -41,4 +47,26 @@ namespace std
 
 #endif // WANT_FROM_CHARS
 
+#ifdef WANT_TO_CHARS
+
+namespace std
+{
+    // Fixed notation only, which is all is needed for PDF
+    // numbers. Fallback to the formatting library, which
+    // has its own shortest and fixed precision algorithms
+    template <typename T, typename = enable_if_t<is_floating_point_v<T>>>
+    to_chars_result to_chars(char* first, char* last,
+        T value, chars_format fmt, int precision)
+    {
+        (void)fmt;
+        auto ret = format_to_n(first, last - first, "{:.{}f}", value, precision);
+        if ((size_t)ret.size > (size_t)(last - first))
+            return { last, errc::value_too_large };
+
+        return { ret.out, errc() };
+    }
+}
+
+#endif // WANT_TO_CHARS
+
 #endif // CHARCONV_COMPAT_H
@@ -0,0 +1,101 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include "BenchUtils.h"
+
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+using namespace mm;
+
+charbuff BenchUtils::CreateBilevel(unsigned width, unsigned height)
+{
+    unsigned rowSize = (width + 7) / 8;
+    charbuff ret(rowSize * height);
+    std::memset(ret.data(), 0xFF, ret.size());
+    for (unsigned y = 0; y < height; y++)
+    {
+        for (unsigned x = 0; x < width; x++)
+        {
+            bool black;
+            if (y % 40 < 3)
+            {
+                black = x > width / 3;
+            }
+            else if (y % 40 >= 10 && y % 40 < 30)
+            {
+                unsigned glyph = (x / 11 + y / 40) % 7;
+                black = glyph < 5 && ((x + y) % 11 == 0 || x % 11 == glyph + 3);
+            }
+            else
+            {
+                black = false;
+            }
+
+            if (black)
+                ret[y * rowSize + x / 8] &= (char)~(0x80 >> (x % 8));
+        }
+    }
+
+    return ret;
+}
+
+void BenchUtils::ResetPeakMemory()
+{
+#ifdef __linux__
+    // Writing 5 resets the peak resident set size, since Linux 4.0
+    ofstream stream("/proc/self/clear_refs");
+    if (stream)
+        stream << "5";
+#endif // __linux__
+}
+
+size_t BenchUtils::GetPeakMemory()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+
+    return counters.PeakWorkingSetSize;
+#elif defined(__linux__)
+    // The peak in the status file is the one that can be reset
+    ifstream stream("/proc/self/status");
+    string line;
+    while (std::getline(stream, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return (size_t)std::stoull(line.substr(6)) * 1024;
+    }
+
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;
+#else
+    return (size_t)usage.ru_maxrss * 1024;
+#endif // __APPLE__
+#endif
+}
+
+void BenchUtils::SetPeakMemoryCounter(benchmark::State& state)
+{
+    state.counters["peak_rss"] = benchmark::Counter((double)GetPeakMemory(),
+        benchmark::Counter::kDefaults, benchmark::Counter::kIs1024);
+}
@@ -0,0 +1,50 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <benchmark/benchmark.h>
+
+#include <pdfmm/pdfmm.h>
+
+namespace mm
+{
+    void RegisterFilterBenchmarks();
+    void RegisterDocumentBenchmarks();
+    void RegisterStringBenchmarks();
+
+    /**
+     * This class contains utility methods that are
+     * shared between the benchmarks
+     */
+    class BenchUtils
+    {
+    public:
+        /** Create a bilevel page with text-like strokes and bars,
+         *  packed 1 bit per pixel with 0 for black
+         */
+        static charbuff CreateBilevel(unsigned width, unsigned height);
+
+        /** Reset the peak resident set size of the process to the
+         *  current one, where supported. On other platforms the peak
+         *  is the one since the start of the process
+         */
+        static void ResetPeakMemory();
+
+        /** Get the peak resident set size of the process in bytes
+         */
+        static size_t GetPeakMemory();
+
+        /** Set the "peak_rss" counter of the benchmark with
+         *  the peak memory since the last reset
+         */
+        static void SetPeakMemoryCounter(benchmark::State& state);
+    };
+}
+
+#endif // BENCH_UTILS_H
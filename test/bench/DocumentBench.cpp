@@ -0,0 +1,383 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include "BenchUtils.h"
+
+#include <iostream>
+
+using namespace std;
+using namespace mm;
+
+// The documents are benchmarked on a corpus generated at startup, so
+// the results are comparable between builds. Every document of the
+// corpus is measured loading on demand and in full, saving, saving
+// incrementally, extracting its text and merging its pages. The
+// generation of the documents is measured as painting. The throughput
+// is reported in bytes of the saved document and in pages per second,
+// together with the peak resident set size ("peak_rss"), which includes
+// the corpus. Use --benchmark_format=json to get machine readable results
+
+namespace
+{
+    struct DocumentCorpus
+    {
+        string Name;
+        charbuff Data;
+        unsigned PageCount = 0;
+        bool HasText = true;
+    };
+
+    using PaintFunction = function<void(PdfMemDocument& doc)>;
+}
+
+static constexpr unsigned SmallPageCount = 4;
+static constexpr unsigned LargePageCount = 400;
+static constexpr unsigned CJKPageCount = 50;
+static constexpr unsigned ScannedPageCount = 10;
+static constexpr unsigned ScanWidth = 2480;
+static constexpr unsigned ScanHeight = 3508;
+
+static void registerBenchmark(const string& name, const function<void(benchmark::State&)>& run);
+static void registerCorpus(const shared_ptr<DocumentCorpus>& corpus);
+static void registerPaint(const string_view& name, unsigned pageCount, const PaintFunction& paint);
+static shared_ptr<DocumentCorpus> createCorpus(const string_view& name, PdfMemDocument& doc,
+    PdfSaveOptions opts = PdfSaveOptions::None);
+static void paintText(PdfMemDocument& doc, unsigned pageCount);
+static void paintCJKText(PdfMemDocument& doc, PdfFont& font, unsigned pageCount);
+static void paintScanned(PdfMemDocument& doc, const charbuff& scan, unsigned pageCount);
+static PdfFont* findCJKFont(PdfMemDocument& doc);
+static void loadFully(PdfMemDocument& doc);
+static void setCounters(benchmark::State& state, size_t size, unsigned pageCount);
+
+void mm::RegisterDocumentBenchmarks()
+{
+    {
+        PdfMemDocument doc;
+        paintText(doc, SmallPageCount);
+        registerCorpus(createCorpus("small", doc));
+    }
+
+    {
+        PdfMemDocument doc;
+        paintText(doc, LargePageCount);
+        registerCorpus(createCorpus("large", doc));
+
+        // Compressed object streams require a XRef stream
+        registerCorpus(createCorpus("objstm", doc, PdfSaveOptions::CompressObjects));
+
+        try
+        {
+            doc.SetEncrypted({ }, "owner", PdfPermissions::Default,
+                PdfEncryptAlgorithm::AESV2, PdfKeyLength::L128);
+            registerCorpus(createCorpus("encrypted", doc));
+        }
+        catch (const PdfError& e)
+        {
+            cerr << "Encryption not available, skipping the encrypted document: " << e.what() << endl;
+        }
+    }
+
+    {
+        PdfMemDocument doc;
+        auto font = findCJKFont(doc);
+        if (font == nullptr)
+        {
+            cerr << "No CJK font found, skipping the CJK document" << endl;
+        }
+        else
+        {
+            paintCJKText(doc, *font, CJKPageCount);
+            registerCorpus(createCorpus("cjk", doc));
+
+            registerPaint("cjk", CJKPageCount, [](PdfMemDocument& doc) {
+                paintCJKText(doc, *findCJKFont(doc), CJKPageCount);
+            });
+        }
+    }
+
+    auto scan = make_shared<charbuff>(BenchUtils::CreateBilevel(ScanWidth, ScanHeight));
+    {
+        PdfMemDocument doc;
+        paintScanned(doc, *scan, ScannedPageCount);
+        auto corpus = createCorpus("scanned", doc);
+        corpus->HasText = false;
+        registerCorpus(corpus);
+    }
+
+    registerPaint("text", LargePageCount, [](PdfMemDocument& doc) {
+        paintText(doc, LargePageCount);
+    });
+    registerPaint("scanned", ScannedPageCount, [scan](PdfMemDocument& doc) {
+        paintScanned(doc, *scan, ScannedPageCount);
+    });
+}
+
+void registerBenchmark(const string& name, const function<void(benchmark::State&)>& run)
+{
+    benchmark::RegisterBenchmark(name.c_str(), [run](benchmark::State& state) {
+        try
+        {
+            run(state);
+        }
+        catch (const PdfError& e)
+        {
+            state.SkipWithError(e.what());
+        }
+    });
+}
+
+void registerCorpus(const shared_ptr<DocumentCorpus>& corpus)
+{
+    string prefix = "/" + corpus->Name;
+
+    registerBenchmark("Load" + prefix + "/OnDemand", [corpus](benchmark::State& state) {
+        BenchUtils::ResetPeakMemory();
+        for (auto _ : state)
+        {
+            PdfMemDocument doc;
+            doc.LoadFromBuffer(corpus->Data);
+        }
+
+        setCounters(state, corpus->Data.size(), corpus->PageCount);
+    });
+
+    registerBenchmark("Load" + prefix + "/Full", [corpus](benchmark::State& state) {
+        BenchUtils::ResetPeakMemory();
+        for (auto _ : state)
+        {
+            PdfMemDocument doc;
+            doc.LoadFromBuffer(corpus->Data);
+            loadFully(doc);
+        }
+
+        setCounters(state, corpus->Data.size(), corpus->PageCount);
+    });
+
+    registerBenchmark("Save" + prefix, [corpus](benchmark::State& state) {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(corpus->Data);
+        loadFully(doc);
+        charbuff output;
+        BenchUtils::ResetPeakMemory();
+        for (auto _ : state)
+        {
+            output.clear();
+            BufferStreamDevice device(output);
+            doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+        }
+
+        setCounters(state, output.size(), corpus->PageCount);
+    });
+
+    registerBenchmark("SaveUpdate" + prefix, [corpus](benchmark::State& state) {
+        charbuff output;
+        BenchUtils::ResetPeakMemory();
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            PdfMemDocument doc;
+            doc.LoadFromBuffer(corpus->Data);
+            doc.GetMetadata().SetTitle(PdfString("Updated"));
+            doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            output.clear();
+            state.ResumeTiming();
+
+            BufferStreamDevice device(output);
+            doc.SaveUpdate(device, PdfSaveOptions::NoModifyDateUpdate);
+        }
+
+        setCounters(state, output.size(), corpus->PageCount);
+    });
+
+    if (corpus->HasText)
+    {
+        registerBenchmark("ExtractText" + prefix, [corpus](benchmark::State& state) {
+            PdfMemDocument doc;
+            doc.LoadFromBuffer(corpus->Data);
+            BenchUtils::ResetPeakMemory();
+            size_t entryCount = 0;
+            for (auto _ : state)
+            {
+                auto& pages = doc.GetPages();
+                for (unsigned i = 0; i < pages.GetCount(); i++)
+                {
+                    pages.GetPage(i).ExtractTextTo([&entryCount](const PdfTextEntryView&) {
+                        entryCount++;
+                    });
+                }
+            }
+
+            benchmark::DoNotOptimize(entryCount);
+            setCounters(state, corpus->Data.size(), corpus->PageCount);
+        });
+    }
+
+    registerBenchmark("InsertPages" + prefix, [corpus](benchmark::State& state) {
+        PdfMemDocument source;
+        source.LoadFromBuffer(corpus->Data);
+        BenchUtils::ResetPeakMemory();
+        for (auto _ : state)
+        {
+            // The pages are inserted twice, so the second copy
+            // shares the resources of the first one
+            PdfMemDocument doc;
+            PdfMergeContext context(doc);
+            doc.InsertPages(source, 0, corpus->PageCount, context);
+            doc.InsertPages(source, 0, corpus->PageCount, context);
+        }
+
+        setCounters(state, corpus->Data.size() * 2, corpus->PageCount * 2);
+    });
+}
+
+void registerPaint(const string_view& name, unsigned pageCount, const PaintFunction& paint)
+{
+    registerBenchmark("Paint/" + string(name), [pageCount, paint](benchmark::State& state) {
+        BenchUtils::ResetPeakMemory();
+        for (auto _ : state)
+        {
+            PdfMemDocument doc;
+            paint(doc);
+        }
+
+        setCounters(state, 0, pageCount);
+    });
+}
+
+shared_ptr<DocumentCorpus> createCorpus(const string_view& name, PdfMemDocument& doc, PdfSaveOptions opts)
+{
+    auto ret = make_shared<DocumentCorpus>();
+    ret->Name = name;
+    ret->PageCount = doc.GetPages().GetCount();
+    BufferStreamDevice device(ret->Data);
+    doc.Save(device, opts | PdfSaveOptions::NoModifyDateUpdate);
+    return ret;
+}
+
+void paintText(PdfMemDocument& doc, unsigned pageCount)
+{
+    static const char* Words[] = { "lorem", "ipsum", "dolor", "sit", "amet", "consectetur",
+        "adipiscing", "elit", "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore" };
+
+    auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+    uint32_t seed = 1;
+    auto next = [&](unsigned max) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % max;
+    };
+
+    PdfPainter painter;
+    string line;
+    for (unsigned i = 0; i < pageCount; i++)
+    {
+        auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        painter.SetCanvas(page);
+        painter.GetTextState().SetFont(font, 10);
+        for (unsigned j = 0; j < 60; j++)
+        {
+            line.clear();
+            for (unsigned k = 0; k < 12; k++)
+            {
+                line.append(Words[next(std::size(Words))]);
+                line.push_back(' ');
+            }
+
+            painter.DrawText(line, 50, 800 - j * 12.5);
+        }
+
+        painter.GetGraphicsState().SetLineWidth(0.5);
+        for (unsigned j = 0; j < 20; j++)
+            painter.DrawLine(50, 40 + j, 50 + next(500), 40 + j);
+
+        painter.FinishDrawing();
+    }
+}
+
+void paintCJKText(PdfMemDocument& doc, PdfFont& font, unsigned pageCount)
+{
+    uint32_t seed = 1;
+    auto next = [&](unsigned max) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % max;
+    };
+
+    PdfPainter painter;
+    string line;
+    for (unsigned i = 0; i < pageCount; i++)
+    {
+        auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        painter.SetCanvas(page);
+        painter.GetTextState().SetFont(&font, 12);
+        for (unsigned j = 0; j < 50; j++)
+        {
+            line.clear();
+            for (unsigned k = 0; k < 35; k++)
+            {
+                // Common ideographs, UTF-8 encoded
+                char32_t code = 0x4E00 + next(0x1000);
+                line.push_back((char)(0xE0 | (code >> 12)));
+                line.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+                line.push_back((char)(0x80 | (code & 0x3F)));
+            }
+
+            painter.DrawText(line, 50, 800 - j * 15);
+        }
+
+        painter.FinishDrawing();
+    }
+}
+
+void paintScanned(PdfMemDocument& doc, const charbuff& scan, unsigned pageCount)
+{
+    // Every page has its own image, as the scans of a document
+    PdfPainter painter;
+    for (unsigned i = 0; i < pageCount; i++)
+    {
+        auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        PdfImage image(doc);
+        image.SetDataCCITT(scan, ScanWidth, ScanHeight);
+        painter.SetCanvas(page);
+        painter.DrawImage(image, 0, 0, 72.0 / 300, 72.0 / 300);
+        painter.FinishDrawing();
+    }
+}
+
+PdfFont* findCJKFont(PdfMemDocument& doc)
+{
+    PdfFontSearchParams params;
+    params.MatchBehavior = PdfFontMatchBehaviorFlags::MatchExactName;
+    for (auto name : { "Noto Sans CJK SC", "Noto Sans CJK JP", "Source Han Sans SC",
+        "WenQuanYi Zen Hei", "Microsoft YaHei", "MS Gothic", "PingFang SC" })
+    {
+        // Make sure the font is not a substitute with no ideographs
+        unsigned gid;
+        auto font = doc.GetFontManager().GetFont(name, params);
+        if (font != nullptr && font->GetMetrics().TryGetGID(0x4E00, gid))
+            return font;
+    }
+
+    return nullptr;
+}
+
+void loadFully(PdfMemDocument& doc)
+{
+    for (auto obj : doc.GetObjects())
+    {
+        (void)obj->GetDataType();
+        (void)obj->GetStream();
+    }
+}
+
+void setCounters(benchmark::State& state, size_t size, unsigned pageCount)
+{
+    if (size != 0)
+        state.SetBytesProcessed((int64_t)(state.iterations() * size));
+
+    state.counters["pages"] = benchmark::Counter((double)(state.iterations() * pageCount),
+        benchmark::Counter::kIsRate);
+    BenchUtils::SetPeakMemoryCounter(state);
+}
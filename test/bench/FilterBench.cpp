@@ -0,0 +1,386 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include "BenchUtils.h"
+
+#include <unordered_map>
+
+#include <pdfmm/private/PdfCCITTPrivate.h>
+#include <pdfmm/private/PdfFiltersPrivate.h>
+#include <pdfmm/private/Format.h>
+
+using namespace std;
+using namespace mm;
+
+// The filters are benchmarked on generated corpora, so the results
+// are comparable between builds. Every filter that can decode is
+// measured decoding whole buffers with DecodeTo() and blocks with
+// DecodeBlock(), and likewise for encoding. The throughput is always
+// the one of the decoded data. JBIG2Decode, JPXDecode and Crypt
+// have no filter implementation and are not measured
+
+namespace
+{
+    struct Corpus
+    {
+        PdfFilterType Type;
+        charbuff Encoded;
+        charbuff Decoded;
+        PdfDictionary DecodeParms;
+        bool HasDecodeParms = false;
+
+        const PdfDictionary* GetDecodeParms() const
+        {
+            return HasDecodeParms ? &DecodeParms : nullptr;
+        }
+    };
+}
+
+static constexpr size_t BlockSize = 4096;
+
+static void registerCorpus(const string_view& name, const shared_ptr<Corpus>& corpus);
+static void registerEncoded(PdfFilterType type, const string_view& name, charbuff encoded,
+    const PdfDictionary* decodeParms = nullptr);
+static void registerDecoded(PdfFilterType type, const string_view& name, const charbuff& decoded);
+static charbuff createText(size_t size);
+static charbuff createImage(unsigned rowLength, unsigned rowCount);
+static charbuff createRandom(size_t size);
+static charbuff encodeRunLength(const bufferview& data);
+static charbuff encodeLzw(const bufferview& data);
+#ifdef PDFMM_HAVE_JPEG_LIB
+static charbuff encodeJpeg(const charbuff& pixels, unsigned width, unsigned height);
+#endif // PDFMM_HAVE_JPEG_LIB
+
+void mm::RegisterFilterBenchmarks()
+{
+    auto text = createText(4 * 1024 * 1024);
+    auto image = createImage(1024 * 3, 1366);
+    auto random = createRandom(1024 * 1024);
+
+    // A page at 300 DPI
+    constexpr unsigned PageWidth = 2480;
+    constexpr unsigned PageHeight = 3508;
+    auto page = BenchUtils::CreateBilevel(PageWidth, PageHeight);
+
+    registerDecoded(PdfFilterType::ASCIIHexDecode, "text", text);
+    registerDecoded(PdfFilterType::ASCIIHexDecode, "random", random);
+    registerDecoded(PdfFilterType::ASCII85Decode, "text", text);
+    registerDecoded(PdfFilterType::ASCII85Decode, "random", random);
+    registerDecoded(PdfFilterType::FlateDecode, "text", text);
+    registerDecoded(PdfFilterType::FlateDecode, "image", image);
+    registerEncoded(PdfFilterType::LZWDecode, "text", encodeLzw(text));
+    registerEncoded(PdfFilterType::LZWDecode, "image", encodeLzw(image));
+    registerEncoded(PdfFilterType::RunLengthDecode, "text", encodeRunLength(text));
+    registerEncoded(PdfFilterType::RunLengthDecode, "page", encodeRunLength(page));
+
+    charbuff ccitt;
+    EncodeCCITTGroup4(ccitt, page, PageWidth, PageHeight);
+    PdfDictionary ccittParms;
+    ccittParms.AddKey("K", (int64_t)-1);
+    ccittParms.AddKey("Columns", (int64_t)PageWidth);
+    registerEncoded(PdfFilterType::CCITTFaxDecode, "page", std::move(ccitt), &ccittParms);
+
+#ifdef PDFMM_HAVE_JPEG_LIB
+    registerEncoded(PdfFilterType::DCTDecode, "image", encodeJpeg(image, 1024, 1366));
+#endif // PDFMM_HAVE_JPEG_LIB
+}
+
+void registerDecoded(PdfFilterType type, const string_view& name, const charbuff& decoded)
+{
+    charbuff encoded;
+    PdfFilterFactory::Create(type)->EncodeTo(encoded, decoded);
+    registerEncoded(type, name, std::move(encoded));
+}
+
+void registerEncoded(PdfFilterType type, const string_view& name, charbuff encoded,
+    const PdfDictionary* decodeParms)
+{
+    auto corpus = make_shared<Corpus>();
+    corpus->Type = type;
+    corpus->Encoded = std::move(encoded);
+    if (decodeParms != nullptr)
+    {
+        corpus->DecodeParms = *decodeParms;
+        corpus->HasDecodeParms = true;
+    }
+
+    PdfFilterFactory::Create(type)->DecodeTo(corpus->Decoded, corpus->Encoded, corpus->GetDecodeParms());
+    registerCorpus(name, corpus);
+}
+
+void registerCorpus(const string_view& name, const shared_ptr<Corpus>& corpus)
+{
+    string prefix = PdfFilterFactory::FilterTypeToName(corpus->Type);
+    prefix.push_back('/');
+    prefix.append(name);
+    prefix.push_back('/');
+
+    auto setCounters = [](benchmark::State& state, const Corpus& corpus) {
+        state.SetBytesProcessed((int64_t)(state.iterations() * corpus.Decoded.size()));
+        state.counters["ratio"] = (double)corpus.Decoded.size() / corpus.Encoded.size();
+    };
+
+    if (PdfFilterFactory::Create(corpus->Type)->CanEncode())
+    {
+        benchmark::RegisterBenchmark((prefix + "EncodeTo").c_str(), [corpus, setCounters](benchmark::State& state) {
+            auto filter = PdfFilterFactory::Create(corpus->Type);
+            charbuff output;
+            for (auto _ : state)
+            {
+                output.clear();
+                filter->EncodeTo(output, corpus->Decoded);
+            }
+
+            setCounters(state, *corpus);
+        });
+
+        benchmark::RegisterBenchmark((prefix + "EncodeBlock").c_str(), [corpus, setCounters](benchmark::State& state) {
+            auto filter = PdfFilterFactory::Create(corpus->Type);
+            charbuff output;
+            for (auto _ : state)
+            {
+                output.clear();
+                BufferStreamDevice device(output);
+                filter->BeginEncode(device);
+                auto& data = corpus->Decoded;
+                for (size_t i = 0; i < data.size(); i += BlockSize)
+                    filter->EncodeBlock({ data.data() + i, std::min(BlockSize, data.size() - i) });
+
+                filter->EndEncode();
+            }
+
+            setCounters(state, *corpus);
+        });
+    }
+
+    benchmark::RegisterBenchmark((prefix + "DecodeTo").c_str(), [corpus, setCounters](benchmark::State& state) {
+        auto filter = PdfFilterFactory::Create(corpus->Type);
+        charbuff output;
+        for (auto _ : state)
+        {
+            output.clear();
+            filter->DecodeTo(output, corpus->Encoded, corpus->GetDecodeParms());
+        }
+
+        setCounters(state, *corpus);
+    });
+
+    benchmark::RegisterBenchmark((prefix + "DecodeBlock").c_str(), [corpus, setCounters](benchmark::State& state) {
+        auto filter = PdfFilterFactory::Create(corpus->Type);
+        charbuff output;
+        for (auto _ : state)
+        {
+            output.clear();
+            BufferStreamDevice device(output);
+            filter->BeginDecode(device, corpus->GetDecodeParms());
+            auto& data = corpus->Encoded;
+            for (size_t i = 0; i < data.size(); i += BlockSize)
+                filter->DecodeBlock({ data.data() + i, std::min(BlockSize, data.size() - i) });
+
+            filter->EndDecode();
+        }
+
+        setCounters(state, *corpus);
+    });
+}
+
+charbuff createText(size_t size)
+{
+    // Content stream operators, with varying operands
+    charbuff ret;
+    uint32_t seed = 1;
+    auto next = [&](unsigned max) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % max;
+    };
+
+    while (ret.size() < size)
+    {
+        switch (next(3))
+        {
+            case 0:
+                ret.append(utls::Format("BT /F{} {} Tf {}.{} {}.{} Td (Lorem ipsum dolor sit amet) Tj ET\n",
+                    next(4), 8 + next(8), next(600), next(100), next(800), next(100)));
+                break;
+            case 1:
+                ret.append(utls::Format("{}.{} {}.{} m {}.{} {}.{} l S\n", next(600), next(100),
+                    next(800), next(100), next(600), next(100), next(800), next(100)));
+                break;
+            default:
+                ret.append(utls::Format("q {} 0 0 {} {} {} cm /Im{} Do Q\n", next(300), next(300),
+                    next(600), next(800), next(10)));
+                break;
+        }
+    }
+
+    ret.resize(size);
+    return ret;
+}
+
+charbuff createImage(unsigned rowLength, unsigned rowCount)
+{
+    // A smooth gradient with some noise
+    charbuff ret(rowLength * rowCount);
+    uint32_t seed = 1;
+    for (unsigned i = 0; i < rowCount; i++)
+    {
+        for (unsigned j = 0; j < rowLength; j++)
+        {
+            seed = seed * 1103515245 + 12345;
+            ret[i * rowLength + j] = (char)(i + j * 3 + ((seed >> 16) % 7));
+        }
+    }
+
+    return ret;
+}
+
+charbuff createRandom(size_t size)
+{
+    charbuff ret(size);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < size; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        ret[i] = (char)(seed >> 16);
+    }
+
+    return ret;
+}
+
+charbuff encodeRunLength(const bufferview& data)
+{
+    // Runs of at least 3 equal bytes are encoded as repeats,
+    // the other bytes as literals
+    charbuff ret;
+    size_t i = 0;
+    while (i < data.size())
+    {
+        size_t run = 1;
+        while (i + run < data.size() && run < 128 && data[i + run] == data[i])
+            run++;
+
+        if (run >= 3)
+        {
+            ret.push_back((char)(257 - run));
+            ret.push_back(data[i]);
+            i += run;
+            continue;
+        }
+
+        size_t start = i;
+        while (i < data.size() && i - start < 128
+            && !(i + 2 < data.size() && data[i] == data[i + 1] && data[i] == data[i + 2]))
+        {
+            i++;
+        }
+
+        ret.push_back((char)(i - start - 1));
+        ret.append(data.data() + start, i - start);
+    }
+
+    ret.push_back((char)128);
+    return ret;
+}
+
+charbuff encodeLzw(const bufferview& data)
+{
+    // A plain LZW encoder with /EarlyChange 1, which clears the
+    // code table when full. The decoder defines every code one code
+    // later than the encoder, so the code length follows the decoder table
+    charbuff ret;
+    uint32_t bits = 0;
+    unsigned bitCount = 0;
+    unsigned nextCode = 258;
+    unsigned writtenCount = 0;
+    unordered_map<uint32_t, unsigned> codes;
+    auto write = [&](unsigned code) {
+        unsigned limit = 258 + (writtenCount == 0 ? 0 : writtenCount - 1) + 1;
+        unsigned codeLength = limit >= 2048 ? 12 : (limit >= 1024 ? 11 : (limit >= 512 ? 10 : 9));
+        bits = (bits << codeLength) | code;
+        bitCount += codeLength;
+        while (bitCount >= 8)
+        {
+            ret.push_back((char)(bits >> (bitCount - 8)));
+            bitCount -= 8;
+        }
+        writtenCount++;
+    };
+
+    write(256);
+    writtenCount = 0;
+    int prefix = -1;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        unsigned char ch = (unsigned char)data[i];
+        if (prefix < 0)
+        {
+            prefix = ch;
+            continue;
+        }
+
+        uint32_t key = (uint32_t)prefix << 8 | ch;
+        auto found = codes.find(key);
+        if (found != codes.end())
+        {
+            prefix = (int)found->second;
+            continue;
+        }
+
+        write((unsigned)prefix);
+        codes[key] = nextCode++;
+        if (nextCode == 4096)
+        {
+            write(256);
+            writtenCount = 0;
+            codes.clear();
+            nextCode = 258;
+        }
+        prefix = ch;
+    }
+
+    if (prefix >= 0)
+        write((unsigned)prefix);
+    write(257);
+    if (bitCount != 0)
+        ret.push_back((char)(bits << (8 - bitCount)));
+
+    return ret;
+}
+
+#ifdef PDFMM_HAVE_JPEG_LIB
+
+charbuff encodeJpeg(const charbuff& pixels, unsigned width, unsigned height)
+{
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    unsigned char* data = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&cinfo, &data, &size);
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 85, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < height)
+    {
+        JSAMPROW row = (JSAMPROW)const_cast<char*>(pixels.data() + (size_t)cinfo.next_scanline * width * 3);
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    charbuff ret(size);
+    std::memcpy(ret.data(), data, size);
+    free(data);
+    return ret;
+}
+
+#endif // PDFMM_HAVE_JPEG_LIB
@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include "BenchUtils.h"
+
+#include <pdfmm/private/PdfEncodingPrivate.h>
+
+using namespace std;
+using namespace mm;
+
+// The conversions of the text strings are benchmarked on short strings,
+// typical of metadata, outlines and form values, both plain ASCII and
+// mixed with accented letters and CJK ideographs. The throughput is
+// the one of the utf-8 data
+
+static void registerCorpus(const string_view& name, const string& utf8);
+static string createText(const string_view& fragment, size_t size);
+
+void mm::RegisterStringBenchmarks()
+{
+    registerCorpus("Ascii", createText("Quarterly report: revenue and outlook (2022) ", 256));
+    registerCorpus("Latin", createText(u8"Résumé des résultats financiers de l'année ", 256));
+    registerCorpus("Mixed", createText(u8"Invoice 請求書 No. 2022-0042 ", 256));
+}
+
+void registerCorpus(const string_view& name, const string& utf8)
+{
+    string prefix = "String/";
+    prefix.append(name);
+    prefix.push_back('/');
+
+    string utf16be;
+    ConvertUTF8ToUTF16BE(utf8, utf16be);
+    string pdfDocEncoded;
+    bool hasPdfDocEncoding = TryConvertUTF8ToPdfDocEncoding(utf8, pdfDocEncoded);
+
+    auto setCounters = [size = utf8.size()](benchmark::State& state) {
+        state.SetBytesProcessed((int64_t)(state.iterations() * size));
+    };
+
+    benchmark::RegisterBenchmark((prefix + "UTF16BEToUTF8").c_str(), [utf16be, setCounters](benchmark::State& state) {
+        string output;
+        for (auto _ : state)
+        {
+            output.clear();
+            ConvertUTF16BEToUTF8(utf16be, output);
+            benchmark::DoNotOptimize(output.data());
+        }
+
+        setCounters(state);
+    });
+
+    benchmark::RegisterBenchmark((prefix + "UTF8ToUTF16BE").c_str(), [utf8, setCounters](benchmark::State& state) {
+        string output;
+        for (auto _ : state)
+        {
+            output.clear();
+            ConvertUTF8ToUTF16BE(utf8, output);
+            benchmark::DoNotOptimize(output.data());
+        }
+
+        setCounters(state);
+    });
+
+    if (!hasPdfDocEncoding)
+        return;
+
+    benchmark::RegisterBenchmark((prefix + "PdfDocEncodingToUTF8").c_str(), [pdfDocEncoded, setCounters](benchmark::State& state) {
+        string output;
+        bool isAsciiEqual;
+        for (auto _ : state)
+        {
+            ConvertPdfDocEncodingToUTF8(pdfDocEncoded, output, isAsciiEqual);
+            benchmark::DoNotOptimize(output.data());
+        }
+
+        setCounters(state);
+    });
+
+    benchmark::RegisterBenchmark((prefix + "UTF8ToPdfDocEncoding").c_str(), [utf8, setCounters](benchmark::State& state) {
+        string output;
+        for (auto _ : state)
+        {
+            (void)TryConvertUTF8ToPdfDocEncoding(utf8, output);
+            benchmark::DoNotOptimize(output.data());
+        }
+
+        setCounters(state);
+    });
+
+    benchmark::RegisterBenchmark((prefix + "CheckPdfDocEncoding").c_str(), [utf8, setCounters](benchmark::State& state) {
+        bool isAsciiEqual;
+        for (auto _ : state)
+            benchmark::DoNotOptimize(CheckValidUTF8ToPdfDocEcondingChars(utf8, isAsciiEqual));
+
+        setCounters(state);
+    });
+}
+
+string createText(const string_view& fragment, size_t size)
+{
+    string ret;
+    while (ret.size() < size)
+        ret.append(fragment);
+
+    return ret;
+}
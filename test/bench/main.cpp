@@ -0,0 +1,26 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include "BenchUtils.h"
+
+using namespace std;
+using namespace mm;
+
+int main(int argc, char** argv)
+{
+    PdfError::SetMaxLoggingSeverity(PdfLogSeverity::Warning);
+    RegisterFilterBenchmarks();
+    RegisterDocumentBenchmarks();
+    RegisterStringBenchmarks();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -2201,3 +2201,67 @@ TEST_CASE("testRGBtoCMYKConversions")
         REQUIRE(rgbColor == cmykColor.ConvertToRGB());
     }
 }
+
+TEST_CASE("testBulkColorConversions")
+{
+    // The bulk conversions match the ones of single colors
+    vector<PdfColor> colors = {
+        PdfColor(0.1, 0.5, 0.9),
+        PdfColor(0.0, 0.0, 0.0),
+        PdfColor(1.0, 0.25, 0.0),
+        PdfColor(0.7, 0.7, 0.2),
+        PdfColor(0.3, 0.6, 0.3),
+    };
+    vector<float> rgb;
+    for (auto& color : colors)
+    {
+        rgb.push_back((float)color.GetRed());
+        rgb.push_back((float)color.GetGreen());
+        rgb.push_back((float)color.GetBlue());
+    }
+
+    vector<float> cmyk(colors.size() * 4);
+    PdfColor::ConvertColors(PdfColorSpace::DeviceRGB, rgb, PdfColorSpace::DeviceCMYK, cmyk);
+    vector<float> gray(colors.size());
+    PdfColor::ConvertColors(PdfColorSpace::DeviceCMYK, cmyk, PdfColorSpace::DeviceGray, gray);
+    vector<float> converted(colors.size() * 3);
+    PdfColor::ConvertColors(PdfColorSpace::DeviceCMYK, cmyk, PdfColorSpace::DeviceRGB, converted);
+    for (unsigned i = 0; i < colors.size(); i++)
+    {
+        auto cmykColor = colors[i].ConvertToCMYK();
+        REQUIRE(cmyk[i * 4] == Approx(cmykColor.GetCyan()).margin(1e-6));
+        REQUIRE(cmyk[i * 4 + 1] == Approx(cmykColor.GetMagenta()).margin(1e-6));
+        REQUIRE(cmyk[i * 4 + 2] == Approx(cmykColor.GetYellow()).margin(1e-6));
+        REQUIRE(cmyk[i * 4 + 3] == Approx(cmykColor.GetBlack()).margin(1e-6));
+        REQUIRE(gray[i] == Approx(cmykColor.ConvertToGrayScale().GetGrayScale()).margin(1e-6));
+        for (unsigned c = 0; c < 3; c++)
+            REQUIRE(converted[i * 3 + c] == Approx(rgb[i * 3 + c]).margin(1e-6));
+    }
+
+    // CIE-Lab colors are converted through sRGB
+    vector<float> lab = { 100.0f, 0.0f, 0.0f, 50.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    PdfColor::ConvertColors(PdfColorSpace::Lab, lab, PdfColorSpace::DeviceRGB, converted);
+    for (unsigned c = 0; c < 3; c++)
+    {
+        REQUIRE(converted[c] == Approx(1.0).margin(1e-3));
+        REQUIRE(converted[3 + c] == Approx(0.4663).margin(1e-3));
+        REQUIRE(converted[6 + c] == Approx(0.0).margin(1e-6));
+    }
+
+    // Compact colors are converted in place
+    vector<PdfCompactColor> compact = {
+        colors[0].ToCompact(),
+        PdfColor(0.5).ToCompact(),
+        PdfColor::CreateCieLab(50.0, 0.0, 0.0).ToCompact(),
+    };
+    PdfColor::ConvertColors(compact, PdfColorSpace::DeviceRGB);
+    REQUIRE(PdfColor::FromCompact(compact[1]) == PdfColor(0.5, 0.5, 0.5));
+    REQUIRE(compact[0].ColorSpace == PdfColorSpace::DeviceRGB);
+    REQUIRE(compact[0].Components[1] == 0.5f);
+    REQUIRE(compact[2].Components[0] == Approx(0.4663).margin(1e-3));
+
+    ASSERT_THROW_WITH_ERROR_CODE(PdfColor::ConvertColors(PdfColorSpace::DeviceRGB, cmyk,
+        PdfColorSpace::DeviceGray, gray), PdfErrorCode::ValueOutOfRange);
+    ASSERT_THROW_WITH_ERROR_CODE(PdfColor::ConvertColors(PdfColorSpace::DeviceRGB, rgb,
+        PdfColorSpace::Lab, converted), PdfErrorCode::CannotConvertColor);
+}
@@ -144,3 +144,47 @@ void deconstruct(const PdfDate& date, date::year_month_day& ymd, date::hh_mm_ss<
         time = date::hh_mm_ss<chrono::seconds>(chrono::floor<chrono::seconds>(secondsFromEpoch - dp));
     }
 }
+
+TEST_CASE("testDateComponents")
+{
+    PdfDateComponents components;
+    REQUIRE(PdfDate::TryParse("D:19981223195207-08'30'", components));
+    REQUIRE(components.Year == 1998);
+    REQUIRE(components.Month == 12);
+    REQUIRE(components.Day == 23);
+    REQUIRE(components.Hour == 19);
+    REQUIRE(components.Minute == 52);
+    REQUIRE(components.Second == 7);
+    REQUIRE(components.MinutesFromUtc == -510);
+
+    // The missing components have their default values
+    REQUIRE(PdfDate::TryParse("D:2020", components));
+    REQUIRE(components.Year == 2020);
+    REQUIRE(components.Month == 1);
+    REQUIRE(components.Day == 1);
+    REQUIRE(!components.MinutesFromUtc.has_value());
+
+    // The view doesn't need to be terminated
+    string_view buffer = "D:20200315120820+01'00'garbage";
+    REQUIRE(PdfDate::TryParse(buffer.substr(0, 23), components));
+    REQUIRE(components.MinutesFromUtc == 60);
+    REQUIRE(!PdfDate::TryParse(buffer, components));
+
+    REQUIRE(PdfDate::TryParseW3C("1998-12-23T19:52:07Z", components));
+    REQUIRE(components.Second == 7);
+    REQUIRE(components.MinutesFromUtc == 0);
+    REQUIRE(!PdfDate::TryParseW3C("1998/12/23", components));
+}
+
+TEST_CASE("testDateToString")
+{
+    string_view dates[] = { "D:19981223195207-08'00'", "D:20200315120820+01'30'", "D:20120120135959Z" };
+    for (auto& str : dates)
+    {
+        INFO(str);
+        REQUIRE(PdfDate::Parse(str).ToString().GetString() == str);
+    }
+
+    REQUIRE(PdfDate::ParseW3C("1998-12-23T19:52:07-08:00").ToStringW3C().GetString() == "1998-12-23T19:52:07-08:00");
+    REQUIRE(PdfDate::ParseW3C("2012-01-20T13:59:59Z").ToString().GetString() == "D:20120120135959Z");
+}
@@ -37,3 +37,191 @@ TEST_CASE("testSaveIncremental")
     doc.SaveUpdate(testPath);
     doc.Load(testPath);
 }
+
+TEST_CASE("testMappedFileDevice")
+{
+    string_view testString = "Hello World Mapped!";
+    auto testPath = TestUtils::GetTestOutputFilePath("testMappedFileDevice.txt");
+    {
+        FileStreamDevice output(testPath, FileMode::Create);
+        output.Write(testString);
+    }
+
+    MappedFileStreamDevice device(testPath);
+    REQUIRE(device.GetLength() == testString.size());
+    bufferview view;
+    REQUIRE(device.TryGetView(view));
+    REQUIRE(view.size() == testString.size());
+
+    char ch;
+    REQUIRE(device.Peek(ch));
+    REQUIRE(ch == 'H');
+    device.Seek(6);
+    char buffer[5];
+    device.Read(buffer, 5);
+    REQUIRE(string_view(buffer, 5) == "World");
+    device.Seek(0, SeekDirection::End);
+    REQUIRE(device.Eof());
+    REQUIRE(!device.Read(ch));
+}
+
+TEST_CASE("testRangeDevice")
+{
+    string data;
+    for (unsigned i = 0; i < 1000; i++)
+        data.append(utls::Format("{:04} ", i));
+
+    unsigned fetchedBytes = 0;
+    RangeStreamDevice device(data.size(), [&](size_t offset, char* buffer, size_t size)
+    {
+        fetchedBytes += (unsigned)size;
+        std::memcpy(buffer, data.data() + offset, size);
+        return size;
+    }, 100, 4, 1);
+    REQUIRE(device.GetLength() == data.size());
+    REQUIRE(device.GetFetchCount() == 0);
+
+    // A miss fetches the block together with the following one
+    char buffer[10];
+    device.Seek(1000);
+    device.Read(buffer, 10);
+    REQUIRE(string_view(buffer, 10) == "0200 0201 ");
+    REQUIRE(device.GetFetchCount() == 1);
+    REQUIRE(fetchedBytes == 200);
+
+    // Reads across the cached blocks don't fetch
+    device.Seek(1095);
+    device.Read(buffer, 10);
+    REQUIRE(string_view(buffer, 10) == "0219 0220 ");
+    REQUIRE(device.GetFetchCount() == 1);
+
+    // Reading the whole data evicts the older blocks
+    string read(data.size(), '\0');
+    device.Seek(0);
+    device.Read(read.data(), read.size());
+    REQUIRE(read == data);
+    device.Seek(1000);
+    char ch;
+    REQUIRE(device.Peek(ch));
+    REQUIRE(ch == '0');
+    REQUIRE(device.GetFetchCount() == 27);
+    device.Seek(0, SeekDirection::End);
+    REQUIRE(device.Eof());
+    REQUIRE(!device.Read(ch));
+}
+
+TEST_CASE("testBufferedFileDevice")
+{
+    auto testPath = TestUtils::GetTestOutputFilePath("testBufferedFileDevice.txt");
+    string expected;
+    {
+        BufferedFileStreamDevice device(testPath, FileMode::Create, 64);
+        REQUIRE(device.GetBufferSize() == 64);
+        for (unsigned i = 0; i < 100; i++)
+        {
+            auto chunk = utls::Format("{:03} ", i);
+            device.Write(chunk);
+            expected.append(chunk);
+        }
+
+        // Large payloads pass through the buffer
+        string large(1000, 'x');
+        device.Write(large);
+        expected.append(large);
+        device.Write("end");
+        expected.append("end");
+        REQUIRE(device.GetLength() == expected.size());
+
+        // Overwrite data still in the buffer and data already written
+        device.Seek(device.GetPosition() - 3);
+        device.Write("END");
+        expected.replace(expected.size() - 3, 3, "END");
+        device.Seek(4);
+        device.Write("one ");
+        expected.replace(4, 4, "one ");
+        device.Seek(0, SeekDirection::End);
+        REQUIRE(device.Eof());
+        device.Close();
+    }
+    {
+        BufferedFileStreamDevice device(testPath, FileMode::Append);
+        REQUIRE(device.GetPosition() == expected.size());
+        device.Write(" appended");
+        expected.append(" appended");
+    }
+
+    MappedFileStreamDevice input(testPath);
+    bufferview view;
+    REQUIRE(input.TryGetView(view));
+    REQUIRE(string_view(view.data(), view.size()) == expected);
+}
+
+TEST_CASE("testHashingDevice")
+{
+    charbuff buffer(string_view("existing "));
+    BufferStreamDevice device(buffer);
+    device.Seek(0, SeekDirection::End);
+    string hashed;
+    size_t expectedOffset = buffer.size();
+    HashingStreamDevice hashing(device, [&](size_t offset, const bufferview& data) {
+        REQUIRE(offset == expectedOffset);
+        hashed.append(data.data(), data.size());
+        expectedOffset += data.size();
+    });
+    REQUIRE(hashing.GetHashedLength() == 9);
+
+    hashing.Write("Hello ");
+    hashing.Write("World");
+    REQUIRE(hashed == "Hello World");
+    REQUIRE(hashing.GetPosition() == 20);
+
+    // Overwritten data is not hashed again, only the data
+    // extending the already hashed one
+    hashing.Seek(15);
+    hashing.Write("W0rld!!");
+    REQUIRE(hashed == "Hello World!!");
+    REQUIRE(hashing.GetHashedLength() == 22);
+    REQUIRE(buffer == "existing Hello W0rld!!");
+}
+
+TEST_CASE("testAsyncDevice")
+{
+    charbuff buffer;
+    string expected;
+    {
+        BufferStreamDevice output(buffer);
+        AsyncStreamDevice device(output, 16, 2);
+        for (unsigned i = 0; i < 100; i++)
+        {
+            auto chunk = utls::Format("{:03} ", i);
+            device.Write(chunk);
+            expected.append(chunk);
+        }
+
+        string large(100, 'x');
+        device.Write(large);
+        expected.append(large);
+        REQUIRE(device.GetLength() == expected.size());
+        REQUIRE(device.GetPosition() == expected.size());
+
+        // Seeking waits for the pending data to be written
+        device.Seek(4);
+        REQUIRE(buffer.size() == expected.size());
+        device.Write("one ");
+        expected.replace(4, 4, "one ");
+        device.Seek(0, SeekDirection::End);
+        device.Write("end");
+        expected.append("end");
+        device.Flush();
+        REQUIRE(buffer == expected);
+        device.Write(" destroyed");
+        expected.append(" destroyed");
+    }
+    REQUIRE(buffer == expected);
+
+    // Errors of the wrapped device are rethrown
+    SpanStreamDevice readOnly("read only");
+    AsyncStreamDevice device(readOnly, 4, 2);
+    device.Write("data");
+    ASSERT_THROW_WITH_ERROR_CODE(device.Flush(), PdfErrorCode::InternalLogic);
+}
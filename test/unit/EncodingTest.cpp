@@ -271,6 +271,136 @@ TEST_CASE("testGetCharCode")
     outofRangeHelper(differenceEncoding);
 }
 
+TEST_CASE("testGlyphNames")
+{
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint("A"sv) == U'A');
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint("Euro"sv) == U'€');
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint("zero"sv) == U'0');
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint("a9"sv) == U'✠');
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint("uni20AC"sv) == U'€');
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint("notaglyphname"sv) == U'\0');
+
+    REQUIRE(PdfDifferenceEncoding::CodePointToName(U'A') == "A");
+    REQUIRE(PdfDifferenceEncoding::CodePointToName(U' ') == "space");
+    REQUIRE(PdfDifferenceEncoding::CodePointToName(U'€') == "Euro");
+    REQUIRE(PdfDifferenceEncoding::CodePointToName(U'✠') == "a9");
+    REQUIRE(PdfDifferenceEncoding::CodePointToName(U'') == "unie000");
+
+    // The reverse lookup of the built-in encodings gives
+    // the last code of the code points with more codes
+    auto& winAnsi = *PdfEncodingMapFactory::WinAnsiEncodingInstance();
+    map<char32_t, unsigned> lastCodes;
+    vector<char32_t> codePoints;
+    for (unsigned i = 0; i < 256; i++)
+    {
+        codePoints.clear();
+        REQUIRE(winAnsi.TryGetCodePoints(PdfCharCode(i), codePoints));
+        REQUIRE(codePoints.size() == 1);
+        lastCodes[codePoints[0]] = i;
+    }
+
+    PdfCharCode code;
+    for (auto& pair : lastCodes)
+    {
+        REQUIRE(winAnsi.TryGetCharCode(pair.first, code));
+        REQUIRE(code.Code == pair.second);
+    }
+
+    REQUIRE(!winAnsi.TryGetCharCode(U'一', code));
+}
+
+TEST_CASE("testCharCodeMap")
+{
+    PdfCharCodeMap map;
+    map.PushMapping({ 0x41, 1 }, U'A');
+    map.PushMapping({ 0x0102, 2 }, U'B');
+    map.PushMapping({ 0x0001, 2 }, U'C');
+    codepoint ffi[] = { U'f', U'f', U'i' };
+    codepoint ff[] = { U'f', U'f' };
+    map.PushMapping({ 0x0103, 2 }, ffi);
+    map.PushMapping({ 0x0104, 2 }, ff);
+    map.PushMapping({ 0x0105, 2 }, U'f');
+    map.PushMapping({ 0x10000, 3 }, U'D');
+    // Remap a code unit
+    map.PushMapping({ 0x0001, 2 }, U'E');
+    REQUIRE(map.GetSize() == 7);
+
+    vector<codepoint> codePoints;
+    REQUIRE(map.TryGetCodePoints({ 0x41, 1 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'A' });
+    REQUIRE(map.TryGetCodePoints({ 0x0103, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'f', U'f', U'i' });
+    REQUIRE(map.TryGetCodePoints({ 0x0001, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'E' });
+    REQUIRE(map.TryGetCodePoints({ 0x10000, 3 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'D' });
+    REQUIRE(!map.TryGetCodePoints({ 0x0000, 2 }, codePoints));
+    REQUIRE(!map.TryGetCodePoints({ 0x0106, 2 }, codePoints));
+    REQUIRE(!map.TryGetCodePoints({ 0x10001, 3 }, codePoints));
+    REQUIRE(codePoints.size() == 0);
+
+    // The longest ligature is matched
+    PdfCharCode code;
+    string_view str = "ffiffBf";
+    auto it = str.begin();
+    vector<unsigned> codes;
+    while (it != str.end())
+    {
+        REQUIRE(map.TryGetNextCharCode(it, str.end(), code));
+        codes.push_back(code.Code);
+    }
+    REQUIRE(codes == vector<unsigned>{ 0x0103, 0x0104, 0x0102, 0x0105 });
+
+    REQUIRE(map.TryGetCharCode(ff, code));
+    REQUIRE(code == PdfCharCode(0x0104, 2));
+    REQUIRE(map.TryGetCharCode(U'E', code));
+    REQUIRE(code == PdfCharCode(0x0001, 2));
+    REQUIRE(!map.TryGetCharCode(U'C', code));
+    REQUIRE(!map.TryGetCharCode(U'i', code));
+
+    // The lookups still work after the map is moved
+    PdfCharCodeMap moved(std::move(map));
+    REQUIRE(moved.TryGetCodePoints({ 0x0102, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'B' });
+    REQUIRE(moved.TryGetCharCode(U'D', code));
+    REQUIRE(code == PdfCharCode(0x10000, 3));
+}
+
+TEST_CASE("testCMapCache")
+{
+    string_view toUnicode =
+        "2 beginbfchar\n"
+        "<0001> <0041>\n"
+        "<0002> <0066006C>\n"
+        "endbfchar\n";
+
+    // Identical CMaps share the parsed map, also across documents
+    PdfMemDocument doc1;
+    auto cmapObj1 = doc1.GetObjects().CreateDictionaryObject();
+    cmapObj1->GetOrCreateStream().Set(toUnicode);
+    PdfMemDocument doc2;
+    auto cmapObj2 = doc2.GetObjects().CreateDictionaryObject();
+    cmapObj2->GetOrCreateStream().Set(toUnicode);
+    auto cmapObj3 = doc2.GetObjects().CreateDictionaryObject();
+    cmapObj3->GetOrCreateStream().Set(string(toUnicode).replace(toUnicode.find("0041"), 4, "0042"));
+
+    auto map1 = PdfCMapEncoding::CreateFromObject(*cmapObj1);
+    auto map2 = PdfCMapEncoding::CreateFromObject(*cmapObj2);
+    auto map3 = PdfCMapEncoding::CreateFromObject(*cmapObj3);
+    auto& cmap1 = dynamic_cast<PdfCMapEncoding&>(*map1);
+    auto& cmap2 = dynamic_cast<PdfCMapEncoding&>(*map2);
+    auto& cmap3 = dynamic_cast<PdfCMapEncoding&>(*map3);
+    REQUIRE(&cmap1.GetCharMap() == &cmap2.GetCharMap());
+    REQUIRE(&cmap1.GetCharMap() != &cmap3.GetCharMap());
+
+    vector<codepoint> codePoints;
+    REQUIRE(cmap2.TryGetCodePoints({ 0x0002, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'f', U'l' });
+    REQUIRE(cmap3.TryGetCodePoints({ 0x0001, 2 }, codePoints));
+    REQUIRE(codePoints == vector<codepoint>{ U'B' });
+    REQUIRE(cmap2.GetLimits().MaxCodeSize == 2);
+}
+
 TEST_CASE("testToUnicodeParse")
 {
     string_view toUnicode =
@@ -345,3 +475,33 @@ void outofRangeHelper(PdfEncoding& encoding)
     (void)encoding.GetCodePoint(encoding.GetLastChar());
     REQUIRE(encoding.GetCodePoint(encoding.GetLastChar().Code + 1) == U'\0');
 }
+
+TEST_CASE("testOneByteConversions")
+{
+    auto encoding = PdfEncodingFactory::CreateWinAnsiEncoding();
+    REQUIRE(encoding.ConvertToUtf8(PdfString::FromRaw("Caf\xE9 \x80"sv)) == "Caf\xC3\xA9 \xE2\x82\xAC");
+
+    PdfMemDocument doc;
+    PdfFontCreateParams params;
+    params.Encoding = encoding;
+    auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica, params);
+    REQUIRE(font->GetEncoding().ConvertToEncoded("Caf\xC3\xA9 \xE2\x82\xAC") == "Caf\xE9 \x80");
+
+    // One byte /ToUnicode map with a ligature
+    string_view toUnicode =
+        "2 beginbfchar\n"
+        "<01> <00660069>\n"
+        "<02> <0041>\n"
+        "endbfchar\n";
+    auto toUnicodeObj = doc.GetObjects().CreateDictionaryObject();
+    toUnicodeObj->GetOrCreateStream().Set(toUnicode);
+    PdfEncoding cmapEncoding(std::make_shared<PdfIdentityEncoding>(1), PdfCMapEncoding::CreateFromObject(*toUnicodeObj));
+
+    string utf8str;
+    REQUIRE(cmapEncoding.TryConvertToUtf8(PdfString::FromRaw("\x02\x01\x02"sv), utf8str));
+    REQUIRE(utf8str == "AfiA");
+
+    INFO("The unmapped code 0x43 falls back to the raw char code");
+    REQUIRE(!cmapEncoding.TryConvertToUtf8(PdfString::FromRaw("\x02\x43"sv), utf8str));
+    REQUIRE(utf8str == "AC");
+}
@@ -127,6 +127,74 @@ TEST_CASE("testAESV2")
     //TestEncrypt(encrypt);
 }
 
+TEST_CASE("testAESV2OutputStream")
+{
+    auto encrypt = PdfEncrypt::CreatePdfEncrypt(PDF_USER_PASSWORD, PDF_OWNER_PASSWORD, s_protection,
+        PdfEncryptAlgorithm::AESV2,
+        PdfKeyLength::L128);
+    encrypt->GenerateEncryptionKey(PdfString::FromHexData("BF37541A9083A51619AD5924ECF156DF"));
+
+    string data;
+    for (unsigned i = 0; i < 10000; i++)
+        data.append(utls::Format("Line {}\n", i));
+
+    // Write the data in uneven chunks, larger and
+    // smaller than the buffer of the stream
+    charbuff encrypted;
+    {
+        BufferStreamDevice device(encrypted);
+        auto output = encrypt->CreateEncryptionOutputStream(device, PdfReference(7, 0));
+        size_t offset = 0;
+        for (size_t chunkSize = 1; offset < data.size(); chunkSize = chunkSize * 3 + 1)
+        {
+            size_t size = std::min(chunkSize, data.size() - offset);
+            output->Write(data.data() + offset, size);
+            offset += size;
+        }
+        output->Flush();
+        // Flushing again doesn't write the final block twice
+        output->Flush();
+    }
+
+    REQUIRE(encrypted.size() == encrypt->CalculateStreamLength(data.size()));
+
+    charbuff expected;
+    encrypt->EncryptTo(expected, data, PdfReference(7, 0));
+    REQUIRE(encrypted == expected);
+
+    charbuff decrypted;
+    encrypt->DecryptTo(decrypted, encrypted, PdfReference(7, 0));
+    REQUIRE(decrypted == data);
+}
+
+TEST_CASE("testStreamedDocumentAESV2")
+{
+    string data;
+    for (unsigned i = 0; i < 10000; i++)
+        data.append(utls::Format("Line {}\n", i));
+
+    auto encrypt = PdfEncrypt::CreatePdfEncrypt(PDF_USER_PASSWORD, PDF_OWNER_PASSWORD, s_protection,
+        PdfEncryptAlgorithm::AESV2,
+        PdfKeyLength::L128);
+
+    charbuff buffer;
+    PdfReference ref;
+    {
+        auto device = std::make_shared<BufferStreamDevice>(buffer);
+        PdfStreamedDocument doc(device, PdfVersionDefault, encrypt.get());
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto obj = doc.GetObjects().CreateDictionaryObject();
+        obj->GetOrCreateStream().Set(data);
+        ref = obj->GetIndirectReference();
+        doc.Close();
+    }
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer, PDF_USER_PASSWORD);
+    REQUIRE(loaded.GetObjects().MustGetObject(ref).MustGetStream().GetFilteredCopy() == data);
+    REQUIRE(loaded.GetObjects().MustGetObject(ref).MustGetStream().GetFilteredCopy() == data);
+}
+
 #ifdef PDFMM_HAVE_LIBIDN
 
 TEST_CASE("testAESV3")
@@ -243,6 +311,154 @@ TEST_CASE("testLoadEncrypedFilePdfMemDocument")
     document.Load(tempFile, PDF_USER_PASSWORD);
 }
 
+TEST_CASE("testFindPassword")
+{
+    string tempFile = TestUtils::GetTestOutputFilePath("testFindPassword.pdf");
+    createEncryptedPdf(tempFile);
+
+    FileStreamDevice device(tempFile);
+    PdfIndirectObjectList objects;
+    PdfParser parser(objects);
+    parser.SetParseThreadCount(4);
+
+    string password;
+    vector<string_view> wrongPasswords = { "wrong", "other", "" };
+    REQUIRE(!parser.TryFindPassword(device, wrongPasswords, password));
+    REQUIRE(objects.GetSize() == 0);
+
+    vector<string_view> passwords = { "wrong", PDF_USER_PASSWORD, "owner", "other" };
+    REQUIRE(parser.TryFindPassword(device, passwords, password));
+    REQUIRE(password == PDF_USER_PASSWORD);
+    REQUIRE(objects.GetSize() == 0);
+
+    PdfMemDocument doc;
+    doc.Load(tempFile, password);
+    REQUIRE(doc.GetPages().GetCount() == 1);
+}
+
+TEST_CASE("testLoadEncryptedFileParallel")
+{
+    // Write encrypted streams, indexed by a XRef stream.
+    // NOTE: The trailer has no /Root, that can't be resolved without a document
+    PdfMemDocument doc;
+    for (unsigned i = 0; i < 100; i++)
+    {
+        auto obj = doc.GetObjects().CreateDictionaryObject();
+        obj->GetDictionary().AddKey("Name", PdfString(utls::Format("String {}", i)));
+        obj->GetOrCreateStream().Set(utls::Format("Stream data {}", i));
+    }
+
+    auto encrypt = PdfEncrypt::CreatePdfEncrypt(PDF_USER_PASSWORD, PDF_OWNER_PASSWORD, s_protection,
+        PdfEncryptAlgorithm::AESV2, PdfKeyLength::L128);
+    PdfObject trailer;
+    charbuff buffer;
+    BufferStreamDevice output(buffer);
+    PdfWriter writer(doc.GetObjects(), trailer);
+    writer.SetUseXRefStream(true);
+    writer.SetEncrypted(*encrypt);
+    writer.Write(output);
+
+    SpanStreamDevice device1(buffer);
+    PdfIndirectObjectList objects1;
+    PdfParser parser1(objects1);
+    parser1.SetPassword(PDF_USER_PASSWORD);
+    parser1.Parse(device1, false);
+
+    SpanStreamDevice device2(buffer);
+    PdfIndirectObjectList objects2;
+    PdfParser parser2(objects2);
+    parser2.SetPassword(PDF_USER_PASSWORD);
+    parser2.SetParseThreadCount(4);
+    parser2.Parse(device2, false);
+
+    REQUIRE(parser2.HasXRefStream());
+    REQUIRE(objects1.GetSize() == objects2.GetSize());
+    auto it2 = objects2.begin();
+    for (auto obj1 : objects1)
+    {
+        auto obj2 = *it2;
+        REQUIRE(obj1->GetIndirectReference() == obj2->GetIndirectReference());
+        REQUIRE(obj1->GetVariant().ToString() == obj2->GetVariant().ToString());
+        REQUIRE(obj1->HasStream() == obj2->HasStream());
+        if (obj1->HasStream())
+            REQUIRE(obj1->GetStream()->GetFilteredCopy() == obj2->GetStream()->GetFilteredCopy());
+        it2++;
+    }
+}
+
+TEST_CASE("testLoadEncryptedStringsOnDemand")
+{
+    // NOTE: The trailer has no /Root, that can't be resolved without a document
+    PdfMemDocument doc;
+    for (unsigned i = 0; i < 10; i++)
+    {
+        auto obj = doc.GetObjects().CreateDictionaryObject();
+        obj->GetDictionary().AddKey("Name", PdfString(utls::Format("String {}", i)));
+        obj->GetDictionary().AddKey("Data", PdfString::FromRaw(utls::Format("Data {}", i)));
+    }
+
+    auto encrypt = PdfEncrypt::CreatePdfEncrypt(PDF_USER_PASSWORD, PDF_OWNER_PASSWORD, s_protection,
+        PdfEncryptAlgorithm::AESV2, PdfKeyLength::L128);
+    PdfObject trailer;
+    charbuff buffer;
+    BufferStreamDevice output(buffer);
+    PdfWriter writer(doc.GetObjects(), trailer);
+    writer.SetEncrypted(*encrypt);
+    writer.Write(output);
+
+    // The strings are decrypted when accessed, or copied
+    SpanStreamDevice device(buffer);
+    PdfIndirectObjectList objects;
+    PdfParser parser(objects);
+    parser.SetPassword(PDF_USER_PASSWORD);
+    parser.Parse(device, true);
+
+    unsigned i = 0;
+    for (auto obj : objects)
+    {
+        if (!obj->GetDictionary().HasKey("Name"))
+            continue;
+
+        auto& name = obj->GetDictionary().MustFindKey("Name").GetString();
+        REQUIRE(name.GetState() == PdfStringState::RawBuffer);
+        REQUIRE(name.GetString() == utls::Format("String {}", i));
+        PdfString data = obj->GetDictionary().MustFindKey("Data").GetString();
+        REQUIRE(data.IsHex());
+        REQUIRE(data.GetRawData() == utls::Format("Data {}", i));
+        i++;
+    }
+
+    REQUIRE(i == 10);
+}
+
+TEST_CASE("testWriteEncryptedHexStrings")
+{
+    PdfString documentId = PdfString::FromHexData("BF37541A9083A51619AD5924ECF156DF");
+    auto encryptRC4 = PdfEncrypt::CreatePdfEncrypt(PDF_USER_PASSWORD, PDF_OWNER_PASSWORD, s_protection,
+        PdfEncryptAlgorithm::RC4V2, PdfKeyLength::L128);
+    auto encryptAES = PdfEncrypt::CreatePdfEncrypt(PDF_USER_PASSWORD, PDF_OWNER_PASSWORD, s_protection,
+        PdfEncryptAlgorithm::AESV2, PdfKeyLength::L128);
+    for (auto encrypt : { encryptRC4.get(), encryptAES.get() })
+    {
+        encrypt->GenerateEncryptionKey(documentId);
+        PdfStatefulEncrypt statefulEncrypt(*encrypt, PdfReference(7, 0));
+        for (size_t length = 1; length < s_encBuffer.size(); length += 7)
+        {
+            string_view data(s_encBuffer.data(), length);
+            string written;
+            StringStreamDevice device(written);
+            charbuff buffer;
+            PdfString::FromRaw(data).Write(device, PdfWriteFlags::None, statefulEncrypt, buffer);
+            REQUIRE(written.front() == '<');
+            REQUIRE(written.back() == '>');
+            REQUIRE(written.size() == statefulEncrypt.CalculateStreamLength(length) * 2 + 2);
+
+            auto read = PdfString::FromHexData(string_view(written).substr(1, written.size() - 2), statefulEncrypt);
+            REQUIRE(read.GetRawData() == data);
+        }
+    }
+}
+
 void testAuthenticate(PdfEncrypt& encrypt)
 {
     PdfString documentId = PdfString::FromHexData("BF37541A9083A51619AD5924ECF156DF");
@@ -7,11 +7,26 @@
  */
 
 #include <PdfTest.h>
+#include <pdfmm/private/PdfCCITTPrivate.h>
+#include <pdfmm/private/PdfFiltersPrivate.h>
+#include "TestUtils.h"
+
+#include <cctype>
+#include <chrono>
 
 using namespace std;
 using namespace mm;
 
 static void testFilter(PdfFilterType filterType, const bufferview& buffer);
+static charbuff encodePngRows(const charbuff& image, unsigned rowLength, unsigned bytesPerPixel, unsigned pngFilter);
+static charbuff createTestImage(unsigned rowLength, unsigned rowCount);
+static charbuff encodeLzw(const bufferview& data, bool earlyChange);
+static charbuff createBilevelImage(unsigned width, unsigned height);
+static charbuff packBits(const string_view& bits);
+static charbuff encodeChain(const charbuff& image, unsigned rowLength);
+#ifdef PDFMM_HAVE_JPEG_LIB
+static charbuff encodeJpeg(const charbuff& pixels, unsigned width, unsigned height);
+#endif // PDFMM_HAVE_JPEG_LIB
 
 static string_view s_testBuffer1 = "Man is distinguished, not only by his reason, but by this singular passion from other animals, which is a lust of the mind, that by a perseverance of delight in the continued and indefatigable generation of knowledge, exceeds the short vehemence of any carnal pleasure.";
 
@@ -35,11 +50,785 @@ TEST_CASE("testFilters")
 
 TEST_CASE("testCCITT")
 {
-    unique_ptr<PdfFilter> filter = PdfFilterFactory::Create(PdfFilterType::CCITTFaxDecode);
-    if (filter == nullptr)
-        INFO("!!! ePdfFilter_CCITTFaxDecode not implemented skipping test!");
+    // Group 4, with runs longer than the extended make up codes
+    for (unsigned width : { 37, 1728, 2700 })
+    {
+        auto image = createBilevelImage(width, 120);
+        PdfDictionary decodeParms;
+        decodeParms.AddKey("K", (int64_t)-1);
+        decodeParms.AddKey("Columns", (int64_t)width);
+        decodeParms.AddKey("Rows", (int64_t)120);
+        charbuff encoded;
+        EncodeCCITTGroup4(encoded, image, width, 120);
+        if (width > 37)
+            REQUIRE(encoded.size() < image.size());
+        charbuff decoded;
+        PdfFilterFactory::Create(PdfFilterType::CCITTFaxDecode)->DecodeTo(decoded, encoded, &decodeParms);
+        REQUIRE(decoded == image);
+
+        // Without rows the data ends at the end of block
+        decodeParms.RemoveKey("Rows");
+        decoded.clear();
+        PdfFilterFactory::Create(PdfFilterType::CCITTFaxDecode)->DecodeTo(decoded, encoded, &decodeParms);
+        REQUIRE(decoded == image);
+
+        // With 1 for black
+        for (auto& ch : image)
+            ch = (char)~ch;
+        encoded.clear();
+        EncodeCCITTGroup4(encoded, image, width, 120, true);
+        decodeParms.AddKey("BlackIs1", true);
+        decoded.clear();
+        PdfFilterFactory::Create(PdfFilterType::CCITTFaxDecode)->DecodeTo(decoded, encoded, &decodeParms);
+        REQUIRE(decoded.size() == image.size());
+        // NOTE: The pad bits are white also with 1 for black
+        if (width % 8 == 0)
+            REQUIRE(decoded == image);
+    }
+
+    // Group 3 one-dimensional with end of lines: a "WWWBBBWW" row
+    // and a white row
+    PdfDictionary decodeParms;
+    decodeParms.AddKey("Columns", (int64_t)8);
+    decodeParms.AddKey("EndOfLine", true);
+    charbuff decoded;
+    PdfFilterFactory::Create(PdfFilterType::CCITTFaxDecode)->DecodeTo(decoded,
+        packBits("000000000001" "1000" "10" "0111" "000000000001" "10011"), &decodeParms);
+    REQUIRE(decoded == charbuff({ (char)0xE3, (char)0xFF }));
+
+    // Group 3 mixed, the second row is two-dimensional with
+    // three vertical mode codes
+    decodeParms.AddKey("K", (int64_t)2);
+    decoded.clear();
+    PdfFilterFactory::Create(PdfFilterType::CCITTFaxDecode)->DecodeTo(decoded,
+        packBits("000000000001" "1" "1000" "10" "0111" "000000000001" "0" "111"), &decodeParms);
+    REQUIRE(decoded == charbuff({ (char)0xE3, (char)0xE3 }));
+
+    // Bilevel images are stored encoded
+    PdfMemDocument doc;
+    auto imageData = createBilevelImage(300, 200);
+    PdfImage image(doc);
+    image.SetDataCCITT(imageData, 300, 200);
+    auto& stream = image.GetObject().MustGetStream();
+    REQUIRE(stream.GetLength() < imageData.size());
+    charbuff extracted;
+    stream.ExtractTo(extracted);
+    REQUIRE(extracted == imageData);
+}
+
+TEST_CASE("benchmarkCCITTDecode", "[.]")
+{
+    // A page at 300 DPI
+    constexpr unsigned Width = 2480;
+    constexpr unsigned Height = 3508;
+    auto image = createBilevelImage(Width, Height);
+    charbuff encoded;
+    auto start = chrono::steady_clock::now();
+    EncodeCCITTGroup4(encoded, image, Width, Height);
+    auto encodeElapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+
+    PdfDictionary decodeParms;
+    decodeParms.AddKey("K", (int64_t)-1);
+    decodeParms.AddKey("Columns", (int64_t)Width);
+    start = chrono::steady_clock::now();
+    charbuff decoded;
+    PdfFilterFactory::Create(PdfFilterType::CCITTFaxDecode)->DecodeTo(decoded, encoded, &decodeParms);
+    auto decodeElapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    REQUIRE(decoded == image);
+    WARN("Encoded " << image.size() << " bytes to " << encoded.size() << " bytes in "
+        << encodeElapsed.count() << " ms, decoded in " << decodeElapsed.count() << " ms");
+}
+
+TEST_CASE("testFlateCompressionLevel")
+{
+    string data;
+    for (unsigned i = 0; i < 5000; i++)
+        data.append(utls::Format("{} {} ", s_testBuffer1.substr(i % 50, 20), i));
+
+    auto encode = [&](PdfCompressionLevel level) {
+        charbuff encoded;
+        PdfFilterFactory::Create(PdfFilterType::FlateDecode, level)->EncodeTo(encoded, data);
+        charbuff decoded;
+        PdfFilterFactory::Create(PdfFilterType::FlateDecode)->DecodeTo(decoded, encoded);
+        REQUIRE(decoded == data);
+        return encoded;
+    };
+    auto stored = encode(PdfCompressionLevel::None);
+    auto fastest = encode(PdfCompressionLevel::Fastest);
+    auto best = encode(PdfCompressionLevel::Best);
+    REQUIRE(stored.size() > data.size());
+    REQUIRE(fastest.size() < data.size());
+    REQUIRE(best.size() <= fastest.size());
+    REQUIRE(encode(PdfCompressionLevel::Archival).size() <= best.size());
+
+    // The progressive encoding uses the level as well
+    charbuff encoded;
+    {
+        BufferStreamDevice device(encoded);
+        auto stream = PdfFilterFactory::CreateEncodeStream({ PdfFilterType::FlateDecode },
+            device, PdfCompressionLevel::None);
+        stream->Write(data);
+        stream->Flush();
+    }
+    REQUIRE(encoded.size() > data.size());
+
+    // Truncated data is decoded as far as possible
+    charbuff truncated;
+    PdfFilterFactory::Create(PdfFilterType::FlateDecode)->DecodeTo(truncated,
+        bufferview(best.data(), best.size() / 2));
+    REQUIRE(truncated.size() != 0);
+    REQUIRE(truncated.size() < data.size());
+    REQUIRE(data.compare(0, truncated.size(), truncated.data(), truncated.size()) == 0);
+
+    // The level of the stream overrides the level of the document
+    PdfMemDocument doc;
+    doc.SetCompressionLevel(PdfCompressionLevel::None);
+    auto& storedStream = doc.GetObjects().CreateDictionaryObject()->GetOrCreateStream();
+    storedStream.Set(data);
+    REQUIRE(storedStream.GetLength() > data.size());
+    auto& bestStream = doc.GetObjects().CreateDictionaryObject()->GetOrCreateStream();
+    bestStream.SetCompressionLevel(PdfCompressionLevel::Best);
+    bestStream.Set(data);
+    REQUIRE(bestStream.GetLength() == best.size());
+    charbuff extracted;
+    storedStream.ExtractTo(extracted);
+    REQUIRE(extracted == data);
+    bestStream.ExtractTo(extracted);
+    REQUIRE(extracted == data);
+}
+
+TEST_CASE("testFlateContextReuse")
+{
+    // The zlib contexts are reused by the thread, also after
+    // failures, and more can be in use at the same time
+    string data = utls::Format("{} {}", s_testBuffer1, s_testBuffer1);
+    charbuff encoded;
+    PdfFilterFactory::Create(PdfFilterType::FlateDecode)->EncodeTo(encoded, data);
+    charbuff damaged = encoded;
+    for (unsigned i = 2; i < damaged.size(); i += 3)
+        damaged[i] = (char)~damaged[i];
+
+    for (unsigned i = 0; i < 10; i++)
+    {
+        charbuff decoded1;
+        charbuff decoded2;
+        BufferStreamDevice device1(decoded1);
+        BufferStreamDevice device2(decoded2);
+        auto stream1 = PdfFilterFactory::CreateDecodeStream({ PdfFilterType::FlateDecode }, device1);
+        auto stream2 = PdfFilterFactory::CreateDecodeStream({ PdfFilterType::FlateDecode }, device2);
+        stream1->Write(encoded.data(), encoded.size() / 2);
+        stream2->Write(encoded.data(), encoded.size());
+        stream1->Write(encoded.data() + encoded.size() / 2, encoded.size() - encoded.size() / 2);
+        stream2->Flush();
+        stream1->Flush();
+        REQUIRE(decoded1 == data);
+        REQUIRE(decoded2 == data);
+
+        charbuff failed;
+        ASSERT_THROW_WITH_ERROR_CODE(PdfFilterFactory::Create(PdfFilterType::FlateDecode)->DecodeTo(failed, damaged),
+            PdfErrorCode::Flate);
+    }
+}
+
+TEST_CASE("benchmarkSmallFlateStreams", "[.]")
+{
+    constexpr unsigned StreamCount = 100000;
+    string data = utls::Format("{} {}", s_testBuffer1, s_testBuffer1);
+    auto start = chrono::steady_clock::now();
+    charbuff encoded;
+    charbuff decoded;
+    for (unsigned i = 0; i < StreamCount; i++)
+    {
+        encoded.clear();
+        PdfFilterFactory::Create(PdfFilterType::FlateDecode)->EncodeTo(encoded, data);
+        {
+            decoded.clear();
+            BufferStreamDevice device(decoded);
+            auto stream = PdfFilterFactory::CreateDecodeStream({ PdfFilterType::FlateDecode }, device);
+            stream->Write(encoded.data(), encoded.size());
+            stream->Flush();
+        }
+    }
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    REQUIRE(decoded == data);
+    WARN("Encoded and decoded " << StreamCount << " Flate streams of " << data.size() << " bytes in "
+        << elapsed.count() << " ms");
+}
+
+TEST_CASE("testAsciiFilters")
+{
+    charbuff data(1000);
+    for (unsigned i = 0; i < data.size(); i++)
+        data[i] = (char)(i * 7 + i / 13);
+    // A group of zeros, encoded as 'z' in ASCII85
+    std::memset(data.data() + 500, 0, 8);
+
+    charbuff hex;
+    PdfFilterFactory::Create(PdfFilterType::ASCIIHexDecode)->EncodeTo(hex, data);
+    REQUIRE(hex.size() == data.size() * 2);
+    REQUIRE(hex.substr(0, 8) == "00070E15");
+    charbuff ascii85;
+    PdfFilterFactory::Create(PdfFilterType::ASCII85Decode)->EncodeTo(ascii85, data);
+    charbuff decoded;
+    PdfFilterFactory::Create(PdfFilterType::ASCII85Decode)->DecodeTo(decoded, "9jqo^BlbD-");
+    REQUIRE(decoded == "Man is d");
+
+    // Insert whitespaces and lowercase digits, and decode
+    // in blocks that split the digits in every position
+    auto decodeSplit = [&](PdfFilterType type, const charbuff& encoded) {
+        charbuff spaced;
+        for (size_t i = 0; i < encoded.size(); i++)
+        {
+            if (i % 64 == 63)
+                spaced.append("\r\n");
+            else if (i % 41 == 40)
+                spaced.append("   \t ");
+            spaced.push_back(type == PdfFilterType::ASCIIHexDecode ? (char)std::tolower(encoded[i]) : encoded[i]);
+        }
+
+        for (size_t blockSize : { 1, 7, 33, 4096 })
+        {
+            charbuff ret;
+            BufferStreamDevice device(ret);
+            auto stream = PdfFilterFactory::CreateDecodeStream({ type }, device);
+            for (size_t i = 0; i < spaced.size(); i += blockSize)
+                stream->Write(spaced.data() + i, std::min(blockSize, spaced.size() - i));
+            stream->Flush();
+            REQUIRE(ret == data);
+        }
+    };
+    decodeSplit(PdfFilterType::ASCIIHexDecode, hex);
+    decodeSplit(PdfFilterType::ASCII85Decode, ascii85);
+
+    // An odd number of hex digits ends with a 0 digit
+    decoded.clear();
+    PdfFilterFactory::Create(PdfFilterType::ASCIIHexDecode)->DecodeTo(decoded, "4a4B4");
+    REQUIRE(decoded == "JK@");
 }
 
+TEST_CASE("benchmarkAsciiFilters", "[.]")
+{
+    charbuff data(16 * 1024 * 1024);
+    for (unsigned i = 0; i < data.size(); i++)
+        data[i] = (char)(i * 7 + i / 13);
+
+    for (auto type : { PdfFilterType::ASCIIHexDecode, PdfFilterType::ASCII85Decode })
+    {
+        auto start = chrono::steady_clock::now();
+        charbuff encoded;
+        PdfFilterFactory::Create(type)->EncodeTo(encoded, data);
+        auto encodeElapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+
+        // Lines of 64 characters, as usually found in documents
+        charbuff lines;
+        for (size_t i = 0; i < encoded.size(); i += 64)
+        {
+            lines.append(encoded.data() + i, std::min((size_t)64, encoded.size() - i));
+            lines.push_back('\n');
+        }
+
+        start = chrono::steady_clock::now();
+        charbuff decoded;
+        PdfFilterFactory::Create(type)->DecodeTo(decoded, lines);
+        auto decodeElapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        REQUIRE(decoded == data);
+        WARN(PdfFilterFactory::FilterTypeToName(type) << ": encoded " << data.size() << " bytes in "
+            << encodeElapsed.count() << " ms, decoded in " << decodeElapsed.count() << " ms");
+    }
+}
+
+TEST_CASE("testRunLengthDecode")
+{
+    // Literals of 1 and 3 bytes, runs of 2 and 128
+    // bytes and the end of data, after which the
+    // bytes are ignored
+    const string_view encoded("\x00" "a" "\x02" "bcd" "\xFF" "e" "\x81" "f" "\x80" "gh", 12);
+    string expected = "abcdee" + string(128, 'f');
+    charbuff decoded;
+    PdfFilterFactory::Create(PdfFilterType::RunLengthDecode)->DecodeTo(decoded, encoded);
+    REQUIRE(decoded == expected);
+
+    for (size_t blockSize : { 1, 2, 5 })
+    {
+        decoded.clear();
+        BufferStreamDevice device(decoded);
+        auto stream = PdfFilterFactory::CreateDecodeStream({ PdfFilterType::RunLengthDecode }, device);
+        for (size_t i = 0; i < encoded.size(); i += blockSize)
+            stream->Write(encoded.data() + i, std::min(blockSize, encoded.size() - i));
+        stream->Flush();
+        REQUIRE(decoded == expected);
+    }
+}
+
+TEST_CASE("testLZWDecode")
+{
+    // Repeated text fills the code table many times, while the
+    // runs of the same byte use the codes as they are defined
+    string data;
+    for (unsigned i = 0; i < 3000; i++)
+    {
+        data.append(utls::Format("{} {} ", s_testBuffer1.substr(i % 50, 20 + i % 17), i));
+        if (i % 500 == 0)
+            data.append(1000, 'a');
+    }
+
+    for (bool earlyChange : { true, false })
+    {
+        auto encoded = encodeLzw(data, earlyChange);
+        PdfDictionary decodeParms;
+        decodeParms.AddKey("EarlyChange", (int64_t)(earlyChange ? 1 : 0));
+        charbuff decoded;
+        PdfFilterFactory::Create(PdfFilterType::LZWDecode)->DecodeTo(decoded, encoded, &decodeParms);
+        REQUIRE(decoded == data);
+
+        // The codes are split between the blocks in every position
+        PdfDictionary streamDict;
+        streamDict.AddKey("DecodeParms", decodeParms);
+        for (size_t blockSize : { 1, 3, 7, 4096 })
+        {
+            charbuff ret;
+            BufferStreamDevice device(ret);
+            auto stream = PdfFilterFactory::CreateDecodeStream({ PdfFilterType::LZWDecode }, device,
+                streamDict);
+            for (size_t i = 0; i < encoded.size(); i += blockSize)
+                stream->Write(encoded.data() + i, std::min(blockSize, encoded.size() - i));
+            stream->Flush();
+            REQUIRE(ret == data);
+        }
+    }
+
+    // The example of the PDF reference, 7.4.4.2 "Details of LZW Encoding"
+    const unsigned char example[] = { 0x80, 0x0B, 0x60, 0x50, 0x22, 0x0C, 0x0C, 0x85, 0x01 };
+    charbuff decoded;
+    PdfFilterFactory::Create(PdfFilterType::LZWDecode)->DecodeTo(decoded,
+        bufferview(reinterpret_cast<const char*>(example), sizeof(example)));
+    REQUIRE(decoded == string_view("-----A---B"));
+}
+
+TEST_CASE("benchmarkLZWDecode", "[.]")
+{
+    string data;
+    for (unsigned i = 0; i < 200000; i++)
+        data.append(utls::Format("{} {} ", s_testBuffer1.substr(i % 50, 20 + i % 17), i));
+
+    auto encoded = encodeLzw(data, true);
+    auto start = chrono::steady_clock::now();
+    charbuff decoded;
+    PdfFilterFactory::Create(PdfFilterType::LZWDecode)->DecodeTo(decoded, encoded);
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    REQUIRE(decoded == data);
+    WARN("Decoded " << decoded.size() << " bytes from " << encoded.size() << " LZW bytes in "
+        << elapsed.count() << " ms");
+}
+
+TEST_CASE("testPredictorDecode")
+{
+    // Odd row lengths test also the remainders of the vectorized
+    // loops, and many rows make them span more input buffers
+    for (unsigned colors : { 1, 2, 3, 4, 6 })
+    {
+        unsigned rowLength = 37 * colors;
+        auto image = createTestImage(rowLength, 300);
+        PdfDictionary decodeParms;
+        decodeParms.AddKey("Colors", (int64_t)colors);
+        decodeParms.AddKey("Columns", (int64_t)37);
+        for (unsigned pngFilter = 0; pngFilter <= 5; pngFilter++)
+        {
+            INFO(utls::Format("Colors {}, PNG filter {}", colors, pngFilter));
+            charbuff encoded;
+            PdfFilterFactory::Create(PdfFilterType::FlateDecode)->EncodeTo(encoded,
+                encodePngRows(image, rowLength, colors, pngFilter));
+            // The filter of every row is read from the data, whatever
+            // the PNG predictor is
+            decodeParms.AddKey("Predictor", (int64_t)(10 + pngFilter % 5));
+            charbuff decoded;
+            PdfFilterFactory::Create(PdfFilterType::FlateDecode)->DecodeTo(decoded, encoded, &decodeParms);
+            REQUIRE(decoded == image);
+        }
+
+        // TIFF predictor 2 is the same as PNG Sub for 8 bits per component
+        charbuff subEncoded = encodePngRows(image, rowLength, colors, 1);
+        charbuff tiffEncoded;
+        for (unsigned i = 0; i < 300; i++)
+            tiffEncoded.append(subEncoded.data() + i * (rowLength + 1) + 1, rowLength);
+        charbuff encoded;
+        PdfFilterFactory::Create(PdfFilterType::FlateDecode)->EncodeTo(encoded, tiffEncoded);
+        decodeParms.AddKey("Predictor", (int64_t)2);
+        charbuff decoded;
+        PdfFilterFactory::Create(PdfFilterType::FlateDecode)->DecodeTo(decoded, encoded, &decodeParms);
+        REQUIRE(decoded == image);
+    }
+}
+
+TEST_CASE("benchmarkPredictorDecode", "[.]")
+{
+    constexpr unsigned Columns = 4000;
+    constexpr unsigned RowCount = 1000;
+    for (unsigned colors : { 1, 3, 4 })
+    {
+        unsigned rowLength = Columns * colors;
+        auto image = createTestImage(rowLength, RowCount);
+        PdfDictionary decodeParms;
+        decodeParms.AddKey("Colors", (int64_t)colors);
+        decodeParms.AddKey("Columns", (int64_t)Columns);
+        decodeParms.AddKey("Predictor", (int64_t)15);
+        for (unsigned pngFilter : { 1, 2, 4 })
+        {
+            charbuff encoded;
+            PdfFilterFactory::Create(PdfFilterType::FlateDecode, PdfCompressionLevel::Fastest)->EncodeTo(encoded,
+                encodePngRows(image, rowLength, colors, pngFilter));
+            auto start = chrono::steady_clock::now();
+            charbuff decoded;
+            PdfFilterFactory::Create(PdfFilterType::FlateDecode)->DecodeTo(decoded, encoded, &decodeParms);
+            auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+            REQUIRE(decoded == image);
+            WARN("Decoded " << decoded.size() << " bytes with PNG filter " << pngFilter << " and "
+                << colors << " bytes per pixel in " << elapsed.count() << " ms");
+        }
+    }
+}
+
+TEST_CASE("testFilterChain")
+{
+    constexpr unsigned Columns = 37;
+    constexpr unsigned RowLength = Columns * 3;
+    auto image = createTestImage(RowLength, 300);
+    auto encoded = encodeChain(image, RowLength);
+
+    PdfMemDocument doc;
+    auto& obj = *doc.GetObjects().CreateDictionaryObject();
+    PdfArray filters;
+    filters.Add(PdfName("ASCII85Decode"));
+    filters.Add(PdfName("FlateDecode"));
+    obj.GetDictionary().AddKey(PdfName::KeyFilter, filters);
+    PdfDictionary predictorParms;
+    predictorParms.AddKey("Predictor", (int64_t)12);
+    predictorParms.AddKey("Colors", (int64_t)3);
+    predictorParms.AddKey("Columns", (int64_t)Columns);
+    PdfArray decodeParms;
+    decodeParms.Add(PdfObject(PdfVariant::NullValue));
+    decodeParms.Add(predictorParms);
+    obj.GetDictionary().AddKey("DecodeParms", decodeParms);
+    SpanStreamDevice input(encoded);
+    obj.GetOrCreateStream().SetRawData(input);
+
+    charbuff extracted;
+    obj.MustGetStream().ExtractTo(extracted);
+    REQUIRE(extracted == image);
+
+    // The blocks written to the chain are split in every position
+    // of the stages, and a single dictionary is given to all filters
+    PdfDictionary streamDict;
+    streamDict.AddKey("DecodeParms", predictorParms);
+    for (size_t blockSize : { 1, 7, 4096, 100000 })
+    {
+        charbuff decoded;
+        BufferStreamDevice device(decoded);
+        auto stream = PdfFilterFactory::CreateDecodeStream({ PdfFilterType::ASCII85Decode,
+            PdfFilterType::FlateDecode }, device, streamDict);
+        for (size_t i = 0; i < encoded.size(); i += blockSize)
+            stream->Write(encoded.data() + i, std::min(blockSize, encoded.size() - i));
+        stream->Flush();
+        REQUIRE(decoded == image);
+    }
+
+    // Corrupted data in the middle of the chain
+    charbuff corrupted;
+    PdfFilterFactory::Create(PdfFilterType::ASCII85Decode)->EncodeTo(corrupted, "not deflated data");
+    charbuff decoded;
+    BufferStreamDevice device(decoded);
+    auto stream = PdfFilterFactory::CreateDecodeStream({ PdfFilterType::ASCII85Decode,
+        PdfFilterType::FlateDecode }, device);
+    REQUIRE_THROWS_AS([&]() {
+        stream->Write(corrupted);
+        stream->Flush();
+    }(), PdfError);
+}
+
+TEST_CASE("benchmarkFilterChain", "[.]")
+{
+    constexpr unsigned RowLength = 3000 * 3;
+    auto image = createTestImage(RowLength, 2000);
+    auto encoded = encodeChain(image, RowLength);
+    PdfDictionary predictorParms;
+    predictorParms.AddKey("Predictor", (int64_t)12);
+    predictorParms.AddKey("Colors", (int64_t)3);
+    predictorParms.AddKey("Columns", (int64_t)(RowLength / 3));
+    PdfDictionary streamDict;
+    streamDict.AddKey("DecodeParms", predictorParms);
+
+    auto start = chrono::steady_clock::now();
+    charbuff decoded;
+    BufferStreamDevice device(decoded);
+    SpanStreamDevice input(encoded);
+    auto stream = PdfFilterFactory::CreateDecodeStream({ PdfFilterType::ASCII85Decode,
+        PdfFilterType::FlateDecode }, device, streamDict);
+    input.CopyTo(*stream);
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    REQUIRE(decoded == image);
+    WARN("Decoded " << encoded.size() << " bytes with ASCII85, Flate and PNG predictors in "
+        << elapsed.count() << " ms");
+}
+
+TEST_CASE("testDecodeLimits")
+{
+    // Zeros compress about 1000:1, as in a decompression bomb
+    charbuff zeros(16 * 1024 * 1024);
+    charbuff deflated;
+    PdfFilterFactory::Create(PdfFilterType::FlateDecode)->EncodeTo(deflated, zeros);
+    charbuff encoded;
+    PdfFilterFactory::Create(PdfFilterType::ASCII85Decode)->EncodeTo(encoded, deflated);
+
+    PdfMemDocument doc;
+    auto& flateObj = *doc.GetObjects().CreateDictionaryObject();
+    flateObj.GetDictionary().AddKey(PdfName::KeyFilter, PdfName("FlateDecode"));
+    SpanStreamDevice flateInput(deflated);
+    flateObj.GetOrCreateStream().SetRawData(flateInput);
+
+    auto& chainObj = *doc.GetObjects().CreateDictionaryObject();
+    PdfArray filters;
+    filters.Add(PdfName("ASCII85Decode"));
+    filters.Add(PdfName("FlateDecode"));
+    chainObj.GetDictionary().AddKey(PdfName::KeyFilter, filters);
+    SpanStreamDevice chainInput(encoded);
+    chainObj.GetOrCreateStream().SetRawData(chainInput);
+
+    auto& rawObj = *doc.GetObjects().CreateDictionaryObject();
+    rawObj.GetOrCreateStream().Set(s_testBuffer1, { });
+
+    PdfStreamDecodeOptions options;
+    options.MaxSize = 1000;
+    options.Truncate = true;
+    charbuff decoded;
+    for (auto obj : { &flateObj, &chainObj })
+    {
+        obj->MustGetStream().ExtractTo(decoded, options);
+        REQUIRE(decoded.size() == 1000);
+        REQUIRE(std::memcmp(decoded.data(), zeros.data(), 1000) == 0);
+    }
+
+    rawObj.MustGetStream().ExtractTo(decoded, options);
+    REQUIRE(decoded == s_testBuffer1);
+    options.MaxSize = 10;
+    rawObj.MustGetStream().ExtractTo(decoded, options);
+    REQUIRE(decoded == s_testBuffer1.substr(0, 10));
+
+    options.Truncate = false;
+    for (auto obj : { &flateObj, &chainObj, &rawObj })
+        ASSERT_THROW_WITH_ERROR_CODE(obj->MustGetStream().ExtractTo(decoded, options), PdfErrorCode::ValueOutOfRange);
+
+    // The limit is not exceeded by the data of the exact size
+    options.MaxSize = zeros.size();
+    chainObj.MustGetStream().ExtractTo(decoded, options);
+    REQUIRE(decoded == zeros);
+    options.MaxSize = s_testBuffer1.size();
+    rawObj.MustGetStream().ExtractTo(decoded, options);
+    REQUIRE(decoded == s_testBuffer1);
+}
+
+TEST_CASE("testDecodedStreamCache")
+{
+    charbuff buffer1(s_testBuffer1);
+    charbuff buffer2(s_testBuffer1.substr(0, 100));
+    PdfMemDocument doc;
+    auto& objects = doc.GetObjects();
+    auto& obj1 = *objects.CreateDictionaryObject();
+    obj1.GetOrCreateStream().Set(buffer1);
+    auto& obj2 = *objects.CreateDictionaryObject();
+    obj2.GetOrCreateStream().Set(buffer2);
+    objects.SetDecodedStreamCacheSize(buffer1.size() + buffer2.size());
+
+    charbuff decoded;
+    obj1.MustGetStream().ExtractTo(decoded);
+    REQUIRE(decoded == buffer1);
+    REQUIRE(obj2.MustGetStream().GetFilteredCopy() == buffer2);
+    REQUIRE(objects.GetDecodedStreamMemory() == buffer1.size() + buffer2.size());
+
+    // Removing the filter directly is not tracked, so the
+    // decoded data is served from the cache
+    obj1.GetDictionary().RemoveKey(PdfName::KeyFilter);
+    obj1.MustGetStream().ExtractTo(decoded);
+    REQUIRE(decoded == buffer1);
+    charbuff streamed;
+    BufferStreamDevice stream(streamed);
+    obj1.MustGetStream().ExtractTo(stream);
+    REQUIRE(streamed == buffer1);
+
+    // Writing the stream invalidates the cached data
+    obj1.MustGetStream().Set(buffer2);
+    REQUIRE(objects.GetDecodedStreamMemory() == buffer2.size());
+    obj1.MustGetStream().ExtractTo(decoded);
+    REQUIRE(decoded == buffer2);
+
+    // The least recently used entry, obj2, is evicted
+    auto& obj3 = *objects.CreateDictionaryObject();
+    obj3.GetOrCreateStream().Set(buffer1);
+    REQUIRE(obj3.MustGetStream().GetFilteredCopy() == buffer1);
+    REQUIRE(objects.GetDecodedStreamMemory() == buffer1.size() + buffer2.size());
+    obj2.GetDictionary().RemoveKey(PdfName::KeyFilter);
+    REQUIRE(obj2.MustGetStream().GetFilteredCopy() != buffer2);
+
+    // Data larger than the budget is not cached
+    objects.SetDecodedStreamCacheSize(buffer1.size() - 1);
+    size_t memory = objects.GetDecodedStreamMemory();
+    REQUIRE(memory < buffer1.size());
+    obj3.MustGetStream().ExtractTo(decoded);
+    REQUIRE(decoded == buffer1);
+    REQUIRE(objects.GetDecodedStreamMemory() == memory);
+
+    objects.SetDecodedStreamCacheSize(0);
+    REQUIRE(objects.GetDecodedStreamMemory() == 0);
+}
+
+#ifdef PDFMM_HAVE_JPEG_LIB
+
+TEST_CASE("testDCTDecode")
+{
+    constexpr unsigned Width = 203;
+    constexpr unsigned Height = 117;
+    auto jpeg = encodeJpeg(createTestImage(Width * 3, Height), Width, Height);
+    PdfMemDocument doc;
+    PdfImage image(doc);
+    image.LoadFromJpegData(reinterpret_cast<const unsigned char*>(jpeg.data()), jpeg.size());
+
+    charbuff full;
+    unsigned width;
+    unsigned height;
+    image.DecodeJpegTo(full, width, height);
+    REQUIRE(width == Width);
+    REQUIRE(height == Height);
+    REQUIRE(full.size() == Width * Height * 3);
+    charbuff extracted;
+    image.GetObject().MustGetStream().ExtractTo(extracted);
+    REQUIRE(extracted == full);
+
+    // The components are not subsampled, so the pixels of
+    // the regions are the same of the full image
+    auto requireRegion = [](const charbuff& region, unsigned width, unsigned height,
+        const charbuff& full, unsigned fullWidth, unsigned x, unsigned y)
+    {
+        REQUIRE(region.size() == width * height * 3);
+        for (unsigned i = 0; i < height; i++)
+        {
+            REQUIRE(std::memcmp(region.data() + i * width * 3,
+                full.data() + ((y + i) * fullWidth + x) * 3, width * 3) == 0);
+        }
+    };
+
+    charbuff region;
+    PdfJpegDecodeOptions options;
+    options.RegionX = 37;
+    options.RegionY = 21;
+    options.RegionWidth = 70;
+    options.RegionHeight = 50;
+    image.DecodeJpegTo(region, width, height, options);
+    REQUIRE(width == 70);
+    REQUIRE(height == 50);
+    requireRegion(region, width, height, full, Width, 37, 21);
+
+    options.RegionX = 150;
+    options.RegionY = 100;
+    options.RegionWidth = 0;
+    options.RegionHeight = 0;
+    image.DecodeJpegTo(region, width, height, options);
+    REQUIRE(width == Width - 150);
+    REQUIRE(height == Height - 100);
+    requireRegion(region, width, height, full, Width, 150, 100);
+
+    // The scaled sizes are rounded up
+    charbuff scaled;
+    options = { };
+    options.ScaleDenominator = 4;
+    image.DecodeJpegTo(scaled, width, height, options);
+    REQUIRE(width == 51);
+    REQUIRE(height == 30);
+    REQUIRE(scaled.size() == 51 * 30 * 3);
+
+    options.RegionX = 9;
+    options.RegionY = 5;
+    options.RegionWidth = 20;
+    options.RegionHeight = 10;
+    image.DecodeJpegTo(region, width, height, options);
+    requireRegion(region, width, height, scaled, 51, 9, 5);
+
+    options = { };
+    options.ScaleDenominator = 3;
+    ASSERT_THROW_WITH_ERROR_CODE(image.DecodeJpegTo(region, width, height, options), PdfErrorCode::ValueOutOfRange);
+    options = { };
+    options.RegionX = 100;
+    options.RegionWidth = Width;
+    ASSERT_THROW_WITH_ERROR_CODE(image.DecodeJpegTo(region, width, height, options), PdfErrorCode::ValueOutOfRange);
+}
+
+TEST_CASE("testJpegPassthrough")
+{
+    auto jpeg = encodeJpeg(createTestImage(31 * 3, 17), 31, 17);
+    PdfMemDocument doc;
+    PdfImage image(doc);
+    image.LoadFromJpegData(reinterpret_cast<const unsigned char*>(jpeg.data()), jpeg.size());
+    REQUIRE(image.GetWidth() == 31);
+    REQUIRE(image.GetHeight() == 17);
+    REQUIRE(image.GetDictionary().MustFindKey("Filter").GetName() == "DCTDecode");
+    charbuff data;
+    BufferStreamDevice output(data);
+    image.GetObject().MustGetStream().CopyTo(output);
+    REQUIRE(data == jpeg);
+
+    // Only the markers before the first scan are read: an Adobe CMYK
+    // image is inverted, without decoding the scan data
+    const unsigned char cmyk[] = {
+        0xFF, 0xD8,
+        0xFF, 0xEE, 0x00, 0x0E, 'A', 'd', 'o', 'b', 'e', 0x00, 0x64, 0x00, 0x00, 0x00, 0x00, 0x02,
+        0xFF, 0xC0, 0x00, 0x0B, 0x08, 0x00, 0x05, 0x00, 0x07, 0x04, 0x00, 0x00, 0x00,
+        0xFF, 0xDA, 0x00, 0x00,
+    };
+    PdfImage cmykImage(doc);
+    cmykImage.LoadFromJpegData(cmyk, sizeof(cmyk));
+    REQUIRE(cmykImage.GetWidth() == 7);
+    REQUIRE(cmykImage.GetHeight() == 5);
+    REQUIRE(cmykImage.GetDictionary().MustFindKey("ColorSpace").GetName() == "DeviceCMYK");
+    REQUIRE(cmykImage.GetDictionary().MustFindKey("Decode").GetArray().size() == 8);
+
+    ASSERT_THROW_WITH_ERROR_CODE(cmykImage.LoadFromJpegData(cmyk, 20), PdfErrorCode::UnsupportedImageFormat);
+}
+
+TEST_CASE("benchmarkDCTDecode", "[.]")
+{
+    constexpr unsigned Width = 4000;
+    constexpr unsigned Height = 3000;
+    auto jpeg = encodeJpeg(createTestImage(Width * 3, Height), Width, Height);
+    PdfMemDocument doc;
+    PdfImage image(doc);
+    image.LoadFromJpegData(reinterpret_cast<const unsigned char*>(jpeg.data()), jpeg.size());
+
+    charbuff decoded;
+    unsigned width;
+    unsigned height;
+    auto start = chrono::steady_clock::now();
+    image.DecodeJpegTo(decoded, width, height);
+    auto fullElapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+
+    PdfJpegDecodeOptions options;
+    options.ScaleDenominator = 8;
+    start = chrono::steady_clock::now();
+    image.DecodeJpegTo(decoded, width, height, options);
+    auto scaledElapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    REQUIRE(width == Width / 8);
+
+    options = { };
+    options.RegionX = Width / 2;
+    options.RegionY = Height / 2;
+    options.RegionWidth = 256;
+    options.RegionHeight = 256;
+    start = chrono::steady_clock::now();
+    image.DecodeJpegTo(decoded, width, height, options);
+    auto regionElapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    WARN("Decoded " << Width << "x" << Height << " JPEG in " << fullElapsed.count() << " ms, scaled 1/8 in "
+        << scaledElapsed.count() << " ms, a 256x256 region in " << regionElapsed.count() << " ms");
+}
+
+#endif // PDFMM_HAVE_JPEG_LIB
+
 void testFilter(PdfFilterType filterType, const bufferview& view)
 {
     charbuff encoded;
@@ -99,3 +888,245 @@ void testFilter(PdfFilterType filterType, const bufferview& view)
 
     INFO("\t-> Test succeeded!");
 }
+
+charbuff createTestImage(unsigned rowLength, unsigned rowCount)
+{
+    // A smooth gradient with some noise, like the images that
+    // are usually encoded with predictors
+    charbuff ret(rowLength * rowCount);
+    uint32_t seed = 1;
+    for (unsigned i = 0; i < rowCount; i++)
+    {
+        for (unsigned j = 0; j < rowLength; j++)
+        {
+            seed = seed * 1103515245 + 12345;
+            ret[i * rowLength + j] = (char)(i + j * 3 + ((seed >> 16) % 7));
+        }
+    }
+
+    return ret;
+}
+
+charbuff encodePngRows(const charbuff& image, unsigned rowLength, unsigned bytesPerPixel, unsigned pngFilter)
+{
+    // Filter the rows, see the PNG specification, 9 "Filtering".
+    // The filter 5 stands for a different filter for every row
+    unsigned rowCount = (unsigned)(image.size() / rowLength);
+    charbuff ret;
+    auto get = [&](int row, int index) -> int {
+        if (row < 0 || index < 0)
+            return 0;
+
+        return (unsigned char)image[row * rowLength + index];
+    };
+
+    for (int i = 0; i < (int)rowCount; i++)
+    {
+        unsigned filter = pngFilter == 5 ? i % 5 : pngFilter;
+        ret.push_back((char)filter);
+        for (int j = 0; j < (int)rowLength; j++)
+        {
+            int a = get(i, j - bytesPerPixel);
+            int b = get(i - 1, j);
+            int c = get(i - 1, j - bytesPerPixel);
+            int predicted;
+            switch (filter)
+            {
+                case 1:
+                    predicted = a;
+                    break;
+                case 2:
+                    predicted = b;
+                    break;
+                case 3:
+                    predicted = (a + b) / 2;
+                    break;
+                case 4:
+                {
+                    int p = a + b - c;
+                    int pa = std::abs(p - a);
+                    int pb = std::abs(p - b);
+                    int pc = std::abs(p - c);
+                    predicted = pa <= pb && pa <= pc ? a : (pb <= pc ? b : c);
+                    break;
+                }
+                default:
+                    predicted = 0;
+                    break;
+            }
+
+            ret.push_back((char)(get(i, j) - predicted));
+        }
+    }
+
+    return ret;
+}
+
+charbuff encodeLzw(const bufferview& data, bool earlyChange)
+{
+    // A plain LZW encoder, which clears the code table when full.
+    // The decoder defines every code one code later than the
+    // encoder, so the code length follows the decoder table
+    charbuff ret;
+    uint32_t bits = 0;
+    unsigned bitCount = 0;
+    unsigned nextCode = 258;
+    unsigned writtenCount = 0;
+    unordered_map<uint32_t, unsigned> codes;
+    auto write = [&](unsigned code) {
+        unsigned limit = 258 + (writtenCount == 0 ? 0 : writtenCount - 1) + (earlyChange ? 1 : 0);
+        unsigned codeLength = limit >= 2048 ? 12 : (limit >= 1024 ? 11 : (limit >= 512 ? 10 : 9));
+        bits = (bits << codeLength) | code;
+        bitCount += codeLength;
+        while (bitCount >= 8)
+        {
+            ret.push_back((char)(bits >> (bitCount - 8)));
+            bitCount -= 8;
+        }
+        writtenCount++;
+    };
+
+    write(256);
+    writtenCount = 0;
+    int prefix = -1;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        unsigned char ch = (unsigned char)data[i];
+        if (prefix < 0)
+        {
+            prefix = ch;
+            continue;
+        }
+
+        uint32_t key = (uint32_t)prefix << 8 | ch;
+        auto found = codes.find(key);
+        if (found != codes.end())
+        {
+            prefix = (int)found->second;
+            continue;
+        }
+
+        write((unsigned)prefix);
+        codes[key] = nextCode++;
+        if (nextCode == 4096)
+        {
+            write(256);
+            writtenCount = 0;
+            codes.clear();
+            nextCode = 258;
+        }
+        prefix = ch;
+    }
+
+    if (prefix >= 0)
+        write((unsigned)prefix);
+    write(257);
+    if (bitCount != 0)
+        ret.push_back((char)(bits << (8 - bitCount)));
+
+    return ret;
+}
+
+charbuff encodeChain(const charbuff& image, unsigned rowLength)
+{
+    // PNG Up rows, deflated and then encoded with ASCII85
+    charbuff deflated;
+    PdfFilterFactory::Create(PdfFilterType::FlateDecode)->EncodeTo(deflated,
+        encodePngRows(image, rowLength, 3, 2));
+    charbuff ret;
+    PdfFilterFactory::Create(PdfFilterType::ASCII85Decode)->EncodeTo(ret, deflated);
+    return ret;
+}
+
+charbuff createBilevelImage(unsigned width, unsigned height)
+{
+    // Text-like strokes, bars and a noisy area, with 0 for black
+    // and the pad bits white
+    unsigned rowSize = (width + 7) / 8;
+    charbuff ret(rowSize * height);
+    std::memset(ret.data(), 0xFF, ret.size());
+    uint32_t seed = 1;
+    for (unsigned y = 0; y < height; y++)
+    {
+        for (unsigned x = 0; x < width; x++)
+        {
+            bool black;
+            if (y % 40 < 3)
+            {
+                black = x > width / 3;
+            }
+            else if (y > height / 2 && x < width / 16)
+            {
+                seed = seed * 1103515245 + 12345;
+                black = ((seed >> 16) & 3) == 0;
+            }
+            else if (y % 40 >= 10 && y % 40 < 30)
+            {
+                unsigned glyph = (x / 11 + y / 40) % 7;
+                black = glyph < 5 && ((x + y) % 11 == 0 || x % 11 == glyph + 3);
+            }
+            else
+            {
+                black = false;
+            }
+
+            if (black)
+                ret[y * rowSize + x / 8] &= (char)~(0x80 >> (x % 8));
+        }
+    }
+
+    return ret;
+}
+
+charbuff packBits(const string_view& bits)
+{
+    charbuff ret((bits.size() + 7) / 8);
+    for (size_t i = 0; i < bits.size(); i++)
+    {
+        if (bits[i] == '1')
+            ret[i / 8] |= (char)(0x80 >> (i % 8));
+    }
+
+    return ret;
+}
+
+#ifdef PDFMM_HAVE_JPEG_LIB
+
+charbuff encodeJpeg(const charbuff& pixels, unsigned width, unsigned height)
+{
+    // Encode RGB pixels without chroma subsampling
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    unsigned char* data = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&cinfo, &data, &size);
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 90, TRUE);
+    for (int i = 0; i < cinfo.num_components; i++)
+    {
+        cinfo.comp_info[i].h_samp_factor = 1;
+        cinfo.comp_info[i].v_samp_factor = 1;
+    }
+
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < height)
+    {
+        JSAMPROW row = (JSAMPROW)const_cast<char*>(pixels.data() + (size_t)cinfo.next_scanline * width * 3);
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    charbuff ret(size);
+    std::memcpy(ret.data(), data, size);
+    free(data);
+    return ret;
+}
+
+#endif // PDFMM_HAVE_JPEG_LIB
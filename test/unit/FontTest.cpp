@@ -9,6 +9,10 @@
 #include <PdfTest.h>
 
 #include <pdfmm/private/FreetypePrivate.h>
+#include <pdfmm/base/PdfFontCFFSubset.h>
+#include "TestUtils.h"
+
+#include FT_CID_H
 
 using namespace std;
 using namespace mm;
@@ -44,6 +48,233 @@ TEST_CASE("testFonts")
     FcFontSetDestroy(fontSet);
 }
 
+TEST_CASE("testSharedMetricsCache")
+{
+    PdfFontManager::SetSharedMetricsCacheEnabled(true);
+    auto metrics = PdfFontManager::GetFontMetrics("LiberationSans");
+    REQUIRE(metrics != nullptr);
+    REQUIRE(PdfFontManager::GetFontMetrics("LiberationSans") == metrics);
+
+    // The fonts of different documents share the metrics
+    PdfMemDocument doc1;
+    PdfMemDocument doc2;
+    auto font1 = doc1.GetFontManager().GetFont("LiberationSans");
+    auto font2 = doc2.GetFontManager().GetFont("LiberationSans");
+    REQUIRE(font1 != nullptr);
+    REQUIRE(font2 != nullptr);
+    REQUIRE(&font1->GetMetrics() == metrics.get());
+    REQUIRE(&font2->GetMetrics() == metrics.get());
+
+    PdfFontManager::SetSharedMetricsCacheEnabled(false);
+    REQUIRE(PdfFontManager::GetFontMetrics("LiberationSans") != metrics);
+}
+
+TEST_CASE("testFontSearchCache")
+{
+    // The results of the searches are remembered, also for the
+    // fonts that are not found, and the same fonts are returned
+    PdfMemDocument doc;
+    auto font1 = doc.GetFontManager().GetFont("NotInstalledFontName");
+    REQUIRE(doc.GetFontManager().GetFont("NotInstalledFontName") == font1);
+    auto font2 = doc.GetFontManager().GetFont("LiberationSans-Bold");
+    REQUIRE(font2 != nullptr);
+    REQUIRE(doc.GetFontManager().GetFont("LiberationSans-Bold") == font2);
+
+    // Shared searches return the same metrics to every document
+    PdfFontManager::SetSharedMetricsCacheEnabled(true);
+    auto metrics = PdfFontManager::GetFontMetrics("NotInstalledFontName");
+    REQUIRE(PdfFontManager::GetFontMetrics("NotInstalledFontName") == metrics);
+
+    // Adding a font directory forgets the searches, but the fonts
+    // already imported in the document are still found
+    PdfFontManager::AddFontDirectory((TestUtils::GetTestInputPath() / "Fonts").u8string());
+    REQUIRE(doc.GetFontManager().GetFont("LiberationSans-Bold") == font2);
+    PdfFontManager::SetSharedMetricsCacheEnabled(false);
+}
+
+TEST_CASE("testDocumentMetricsSharing")
+{
+    // The fonts of a document from the same file share
+    // the metrics, also with different encodings
+    PdfMemDocument doc;
+    auto font1 = doc.GetFontManager().GetFont("LiberationSans");
+    PdfFontCreateParams params;
+    params.Encoding = PdfEncodingFactory::CreateWinAnsiEncoding();
+    auto font2 = doc.GetFontManager().GetFont("LiberationSans", params);
+    REQUIRE(font1 != nullptr);
+    REQUIRE(font2 != nullptr);
+    REQUIRE(font1 != font2);
+    REQUIRE(&font1->GetMetrics() == &font2->GetMetrics());
+
+    // Different documents don't share them without the shared cache
+    PdfMemDocument doc2;
+    auto font3 = doc2.GetFontManager().GetFont("LiberationSans");
+    REQUIRE(font3 != nullptr);
+    REQUIRE(&font3->GetMetrics() != &font1->GetMetrics());
+}
+
+TEST_CASE("testFontPathCache")
+{
+    auto cachePath = TestUtils::GetTestOutputFilePath("testFontPathCache.txt");
+    fs::remove(fs::u8path(cachePath));
+
+    unsigned faceIndex;
+    string fontPath;
+    {
+        PdfFontConfigWrapper wrapper;
+        wrapper.SetCacheFilePath(cachePath);
+        fontPath = wrapper.GetFontConfigFontPath("LiberationSans", PdfFontStyle::Regular, faceIndex);
+        REQUIRE(!fontPath.empty());
+        REQUIRE(wrapper.GetFontConfigFontPath("LiberationSans", PdfFontStyle::Regular, faceIndex) == fontPath);
+    }
+
+    // Add an entry by hand for a font fontconfig doesn't know, with
+    // the path of an existing file, and one with a missing file
+    {
+        ofstream stream(fs::u8path(cachePath), ios_base::out | ios_base::app);
+        stream << "0\t1\tPdfmmCachedFont\t" << cachePath << "\n";
+        stream << "0\t0\tPdfmmMissingFont\t" << fontPath << ".missing\n";
+    }
+
+    PdfFontConfigWrapper wrapper;
+    wrapper.SetCacheFilePath(cachePath);
+    REQUIRE(wrapper.GetFontConfigFontPath("LiberationSans", PdfFontStyle::Regular, faceIndex) == fontPath);
+    REQUIRE(wrapper.GetFontConfigFontPath("PdfmmCachedFont", PdfFontStyle::Regular, faceIndex) == cachePath);
+    REQUIRE(faceIndex == 1);
+    REQUIRE(wrapper.GetFontConfigFontPath("PdfmmMissingFont", PdfFontStyle::Regular, faceIndex) != fontPath + ".missing");
+}
+
+TEST_CASE("testMappedFontData")
+{
+    unsigned faceIndex;
+    auto fontPath = PdfFontManager::GetFontConfigWrapper().GetFontConfigFontPath(
+        "LiberationSans", PdfFontStyle::Regular, faceIndex);
+    REQUIRE(!fontPath.empty());
+
+    // The data of the metrics is the mapped font file
+    auto metrics = PdfFontManager::GetFontMetrics("LiberationSans");
+    REQUIRE(metrics != nullptr);
+    ifstream stream(fs::u8path(fontPath), ios_base::in | ios_base::binary);
+    string fileData((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
+    auto data = metrics->GetOrLoadFontFileData();
+    REQUIRE(string_view(data.data(), data.size()) == fileData);
+}
+
+TEST_CASE("testGlyphWidths")
+{
+    auto metrics = PdfFontManager::GetFontMetrics("LiberationSans");
+    REQUIRE(metrics != nullptr);
+    FT_Face face = metrics->GetOrLoadFace();
+    REQUIRE(face != nullptr);
+
+    // The table of the advances matches the glyphs loaded one by one
+    double width;
+    for (unsigned gid = 0; gid < (unsigned)face->num_glyphs; gid++)
+    {
+        REQUIRE(FT_Load_Glyph(face, gid, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP) == 0);
+        REQUIRE(metrics->TryGetGlyphWidth(gid, width));
+        REQUIRE(width == face->glyph->metrics.horiAdvance / (double)face->units_per_EM);
+    }
+
+    REQUIRE(!metrics->TryGetGlyphWidth((unsigned)face->num_glyphs, width));
+}
+
+TEST_CASE("testEmbedFontsConcurrently")
+{
+    // The subsets of the fonts are built concurrently when saving
+    PdfMemDocument doc;
+    auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    PdfPainter painter;
+    painter.SetCanvas(page);
+    double y = 100;
+    for (auto name : { "DejaVuSans", "DejaVuSerif", "DejaVuSansMono" })
+    {
+        auto font = doc.GetFontManager().GetFont(name);
+        REQUIRE(font != nullptr);
+        painter.GetTextState().SetFont(font, 16);
+        painter.DrawText("Hello World", 100, y);
+        y += 50;
+    }
+    painter.FinishDrawing();
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    unsigned fontFileCount = 0;
+    for (auto obj : loaded.GetObjects())
+    {
+        if (!obj->IsDictionary() || !obj->GetDictionary().HasKey("FontFile2"))
+            continue;
+
+        auto& dict = obj->GetDictionary();
+
+        auto& fontFile = dict.MustFindKey("FontFile2");
+        auto data = fontFile.MustGetStream().GetFilteredCopy();
+        REQUIRE((int64_t)data.size() == fontFile.GetDictionary().MustFindKey("Length1").GetNumber());
+        FT_Face face;
+        REQUIRE(TryCreateFreeTypeFace(data, face));
+        FT_Done_Face(face);
+        fontFileCount++;
+    }
+
+    REQUIRE(fontFileCount == 3);
+}
+
+TEST_CASE("testSharedSubsetCache")
+{
+    auto createDocument = [](const string_view& text, charbuff& fontFile)
+    {
+        PdfMemDocument doc;
+        auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto font = doc.GetFontManager().GetFont("LiberationSans");
+        REQUIRE(font != nullptr);
+        PdfPainter painter;
+        painter.SetCanvas(page);
+        painter.GetTextState().SetFont(font, 16);
+        painter.DrawText(text, 100, 100);
+        painter.FinishDrawing();
+
+        charbuff buffer;
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+
+        PdfMemDocument loaded;
+        loaded.LoadFromBuffer(buffer);
+        for (auto obj : loaded.GetObjects())
+        {
+            if (!obj->IsDictionary() || !obj->GetDictionary().HasKey("FontFile2"))
+                continue;
+
+            auto& stream = obj->GetDictionary().MustFindKey("FontFile2").MustGetStream();
+            fontFile = stream.GetFilteredCopy();
+            FT_Face face;
+            REQUIRE(TryCreateFreeTypeFace(fontFile, face));
+            FT_Done_Face(face);
+        }
+        REQUIRE(fontFile.size() != 0);
+    };
+
+    // Documents using the same glyphs reuse the same subset
+    PdfFontManager::SetSharedSubsetCacheEnabled(true);
+    charbuff fontFile1;
+    charbuff fontFile2;
+    charbuff fontFile3;
+    createDocument("Invoice 1234", fontFile1);
+    createDocument("Invoice 1234", fontFile2);
+    createDocument("Invoice 5678", fontFile3);
+    REQUIRE(fontFile1 == fontFile2);
+    REQUIRE(fontFile1 != fontFile3);
+
+    // The subsets are the same built without the cache
+    PdfFontManager::SetSharedSubsetCacheEnabled(false);
+    charbuff fontFile4;
+    createDocument("Invoice 5678", fontFile4);
+    REQUIRE(fontFile3 == fontFile4);
+}
+
 void testSingleFont(FcPattern* font)
 {
     PdfMemDocument doc;
@@ -104,3 +335,452 @@ bool getFontInfo(FcPattern* pFont, string& fontFamily, string& fontPath,
 }
 
 #endif // PDFMM_HAVE_FONTCONFIG
+
+TEST_CASE("testStringAdvances")
+{
+    PdfMemDocument doc;
+    PdfFontCreateParams params;
+    params.Encoding = PdfEncodingFactory::CreateWinAnsiEncoding();
+    auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica, params);
+    PdfTextState state;
+    state.Font = font;
+    state.FontSize = 12;
+    state.CharSpacing = 1;
+
+    const char32_t codePoints[] = { U'H', U'e', U'l', U'l', U'o' };
+    double advances[std::size(codePoints)];
+    double width;
+    REQUIRE(font->TryGetStringAdvances(codePoints, state, advances, width));
+    double expectedWidth = 0;
+    for (size_t i = 0; i < std::size(codePoints); i++)
+    {
+        REQUIRE(advances[i] == font->GetCharWidth(codePoints[i], state));
+        expectedWidth += advances[i];
+    }
+    REQUIRE(width == expectedWidth);
+    REQUIRE(font->GetStringWidth("Hello"sv, state) == Approx(width));
+    REQUIRE(advances[2] == advances[3]);
+
+    // Only the total width
+    double totalWidth;
+    REQUIRE(font->TryGetStringAdvances(codePoints, state, { }, totalWidth));
+    REQUIRE(totalWidth == width);
+
+    // Missing glyphs get the default width
+    const char32_t missing[] = { U'H', U'一' };
+    REQUIRE(!font->TryGetStringAdvances(missing, state, advances, width));
+    REQUIRE(advances[1] == font->GetDefaultCharWidth(state));
+
+    // The CIDs of an encoded string
+    auto encoded = font->GetEncoding().ConvertToEncoded("Hello");
+    vector<PdfCID> cids;
+    REQUIRE(font->GetEncoding().TryConvertToCIDs(PdfString::FromRaw(encoded), cids));
+    REQUIRE(cids.size() == std::size(codePoints));
+    REQUIRE(font->TryGetStringAdvances(cids, state, advances, width));
+    REQUIRE(width == Approx(expectedWidth));
+
+    double tooFew[2];
+    REQUIRE_THROWS_AS(font->TryGetStringAdvances(codePoints, state, tooFew, width), PdfError);
+}
+
+TEST_CASE("testStandard14FontData")
+{
+    // The built-in font files are inflated on first use
+    for (unsigned i = (unsigned)PdfStandard14FontType::TimesRoman;
+        i <= (unsigned)PdfStandard14FontType::ZapfDingbats; i++)
+    {
+        auto metrics = PdfFontMetricsStandard14::GetInstance((PdfStandard14FontType)i);
+        auto data = metrics->GetOrLoadFontFileData();
+        REQUIRE(data.size() > 4);
+        // CFF header, major version 1
+        REQUIRE(data[0] == 1);
+        REQUIRE(metrics->GetOrLoadFontFileData().data() == data.data());
+        FT_Face face;
+        REQUIRE(TryCreateFreeTypeFace(data, face));
+        FT_Done_Face(face);
+
+        unsigned gid;
+        if (i < (unsigned)PdfStandard14FontType::Symbol)
+        {
+            REQUIRE(metrics->TryGetGID(U'A', gid));
+            REQUIRE(gid != 0);
+        }
+        REQUIRE(!metrics->TryGetGID(U'一', gid));
+    }
+}
+
+TEST_CASE("testEmbedStandard14Subset")
+{
+    // The embedded standard 14 fonts are CFF fonts, which get subsetted
+    PdfMemDocument doc;
+    auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+    REQUIRE(font->IsSubsettingEnabled());
+    PdfPainter painter;
+    painter.SetCanvas(page);
+    painter.GetTextState().SetFont(font, 16);
+    painter.DrawText("Hello World", 100, 100);
+    painter.FinishDrawing();
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    unsigned fontFileCount = 0;
+    for (auto obj : loaded.GetObjects())
+    {
+        if (!obj->IsDictionary() || !obj->GetDictionary().HasKey("FontFile3"))
+            continue;
+
+        auto& fontFile = obj->GetDictionary().MustFindKey("FontFile3");
+        REQUIRE(fontFile.GetDictionary().MustFindKey(PdfName::KeySubtype).GetName() == "CIDFontType0C");
+        auto data = fontFile.MustGetStream().GetFilteredCopy();
+        REQUIRE(data.size() < font->GetMetrics().GetOrLoadFontFileData().size());
+        FT_Face face;
+        REQUIRE(TryCreateFreeTypeFace(data, face));
+        FT_Done_Face(face);
+        fontFileCount++;
+    }
+
+    REQUIRE(fontFileCount == 1);
+}
+
+TEST_CASE("testCIDWidthsAndToUnicode")
+{
+    PdfMemDocument doc;
+    auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+    string text = "ABCDEFGHIJ llll xyz";
+    PdfPainter painter;
+    painter.SetCanvas(page);
+    painter.GetTextState().SetFont(font, 16);
+    painter.DrawText(text, 100, 100);
+    painter.FinishDrawing();
+    doc.GetFontManager().EmbedFonts();
+
+    auto& fontDict = font->GetObject().GetDictionary();
+    auto& descendantDict = fontDict.MustFindKey("DescendantFonts").GetArray().FindAt(0).GetDictionary();
+    auto& widths = descendantDict.MustFindKey("W").GetArray();
+
+    // Expand the /W array, made of "c_first c_last w" and "c [w1 w2 ...]" entries
+    map<unsigned, int64_t> cidWidths;
+    unsigned rangeCount = 0;
+    for (unsigned i = 0; i < widths.GetSize(); )
+    {
+        unsigned cid = (unsigned)widths[i].GetNumber();
+        auto& next = widths.FindAt(i + 1);
+        if (next.IsArray())
+        {
+            auto& arr = next.GetArray();
+            for (unsigned j = 0; j < arr.GetSize(); j++)
+                REQUIRE(cidWidths.insert({ cid + j, arr[j].GetNumber() }).second);
+
+            i += 2;
+        }
+        else
+        {
+            unsigned lastCid = (unsigned)next.GetNumber();
+            for (unsigned j = cid; j <= lastCid; j++)
+                REQUIRE(cidWidths.insert({ j, widths[i + 2].GetNumber() }).second);
+
+            rangeCount++;
+            i += 3;
+        }
+    }
+
+    // The four "l" are a single run of the same width
+    REQUIRE(rangeCount != 0);
+
+    auto& metrics = font->GetMetrics();
+    auto encoded = font->GetEncoding().ConvertToEncoded(text);
+    auto cids = font->GetEncoding().ConvertToCIDs(PdfString::FromRaw(encoded));
+    REQUIRE(cids.size() == text.size());
+    for (unsigned i = 0; i < text.size(); i++)
+    {
+        unsigned gid;
+        REQUIRE(metrics.TryGetGID((char32_t)text[i], gid));
+        REQUIRE(cidWidths[cids[i].Id] == (int64_t)std::round(metrics.GetGlyphWidth(gid) / metrics.GetMatrix()[0]));
+    }
+
+    // The consecutive letters are coalesced in bfrange entries
+    auto& toUnicodeObj = fontDict.MustFindKey("ToUnicode");
+    charbuff toUnicode = toUnicodeObj.MustGetStream().GetFilteredCopy();
+    REQUIRE(toUnicode.find("beginbfrange") != string::npos);
+    PdfEncoding parsed(std::make_shared<PdfIdentityEncoding>(cids[0].Unit.CodeSpaceSize), PdfCMapEncoding::CreateFromObject(toUnicodeObj));
+    REQUIRE(parsed.ConvertToUtf8(PdfString::FromRaw(encoded)) == text);
+}
+
+TEST_CASE("testLoadedCIDFontWidths")
+{
+    // The /W widths of a loaded CIDFont are indexed by CID,
+    // also when the CMap doesn't start from code 0
+    PdfMemDocument doc;
+    auto& cmap = *doc.GetObjects().CreateDictionaryObject("CMap");
+    cmap.GetDictionary().AddKey("CMapName", PdfName("Test-H"));
+    cmap.GetOrCreateStream().Set(
+        "begincmap\n"
+        "1 begincodespacerange\n<0000> <FFFF>\nendcodespacerange\n"
+        "1 begincidrange\n<0041> <0043> 10\nendcidrange\n"
+        "endcmap\n"sv);
+
+    auto& descriptor = *doc.GetObjects().CreateDictionaryObject("FontDescriptor");
+    descriptor.GetDictionary().AddKey("FontName", PdfName("Test"));
+    auto& cidFont = *doc.GetObjects().CreateDictionaryObject("Font", "CIDFontType2");
+    cidFont.GetDictionary().AddKey("BaseFont", PdfName("Test"));
+    cidFont.GetDictionary().AddKeyIndirect("FontDescriptor", &descriptor);
+    cidFont.GetDictionary().AddKey("DW", PdfVariant((int64_t)1000));
+    PdfArray cidWidths;
+    cidWidths.AddNumbers(vector<int64_t>{ 500, 600, 700 });
+    PdfArray widths;
+    widths.Add(PdfVariant((int64_t)10));
+    widths.Add(cidWidths);
+    cidFont.GetDictionary().AddKey("W", widths);
+
+    auto& fontObj = *doc.GetObjects().CreateDictionaryObject("Font", "Type0");
+    fontObj.GetDictionary().AddKey("BaseFont", PdfName("Test"));
+    fontObj.GetDictionary().AddKeyIndirect("Encoding", &cmap);
+    PdfArray descendants;
+    descendants.Add(cidFont.GetIndirectReference());
+    fontObj.GetDictionary().AddKey("DescendantFonts", descendants);
+
+    auto font = doc.GetFontManager().GetLoadedFont(fontObj);
+    REQUIRE(font != nullptr);
+    PdfTextState state;
+    state.Font = font;
+    state.FontSize = 10;
+    auto encoded = PdfString::FromRaw("\x00\x41\x00\x42\x00\x43"sv);
+    auto cids = font->GetEncoding().ConvertToCIDs(encoded);
+    REQUIRE(cids.size() == 3);
+    REQUIRE(cids[0].Id == 10);
+    REQUIRE(cids[2].Id == 12);
+    REQUIRE(font->GetStringWidth(encoded, state) == Approx(5 + 6 + 7));
+}
+
+TEST_CASE("testCIDToGIDMap")
+{
+    PdfMemDocument doc;
+    auto& mapObj = *doc.GetObjects().CreateDictionaryObject();
+    mapObj.GetOrCreateStream().Set("\x00\x00\x00\x03\x01\x02\x00\x00\xFF\x80"sv);
+    auto map = PdfCIDToGIDMap::Create(mapObj, PdfGlyphAccess::FontProgram);
+    REQUIRE(map.GetSize() == 5);
+    unsigned gid;
+    REQUIRE(map.TryMapCIDToGID(2, gid));
+    REQUIRE(gid == 0x0102);
+    REQUIRE(map.TryMapCIDToGID(4, gid));
+    REQUIRE(gid == 0xFF80);
+    REQUIRE(!map.TryMapCIDToGID(5, gid));
+
+    // The sparse maps are written with zeroes for the missing CIDs
+    PdfCIDToGIDMap sparse(CIDToGIDMap{ { 1, 7 }, { 2, 8 }, { 5, 0x1234 } }, PdfGlyphAccess::FontProgram);
+    REQUIRE(sparse.TryMapCIDToGID(5, gid));
+    REQUIRE(gid == 0x1234);
+    REQUIRE(!sparse.TryMapCIDToGID(3, gid));
+    auto& fontObj = *doc.GetObjects().CreateDictionaryObject();
+    sparse.ExportTo(fontObj);
+    auto exported = fontObj.GetDictionary().MustFindKey("CIDToGIDMap").MustGetStream().GetFilteredCopy();
+    REQUIRE(exported == "\x00\x00\x00\x07\x00\x08\x00\x00\x00\x00\x12\x34"sv);
+}
+
+static charbuff buildTestCFFFont();
+static void appendCFFIndex(charbuff& output, const vector<charbuff>& items);
+static void appendCFFNumber(charbuff& output, int value);
+static charbuff getOutlinePoints(FT_Face face, unsigned gid);
+
+TEST_CASE("testCFFSubset")
+{
+    auto font = buildTestCFFFont();
+    FT_Face face;
+    REQUIRE(TryCreateFreeTypeFace(font, face));
+    REQUIRE(face->num_glyphs == 5);
+
+    // The glyphs call a local and a global subroutine
+    charbuff subset;
+    CIDToGIDMap cidToGidMap = { { 1, 2 }, { 5, 3 } };
+    PdfFontCFFSubset::BuildFont(subset, font, cidToGidMap);
+
+    // NOTE: FreeType addresses the glyphs of CID-keyed fonts by CID
+    FT_Face subsetFace;
+    REQUIRE(TryCreateFreeTypeFace(subset, subsetFace));
+    REQUIRE(subsetFace->num_glyphs == 6);
+    FT_Bool isCID;
+    REQUIRE(FT_Get_CID_Is_Internally_CID_Keyed(subsetFace, &isCID) == 0);
+    REQUIRE(isCID);
+    REQUIRE(getOutlinePoints(subsetFace, 1) == getOutlinePoints(face, 2));
+    REQUIRE(getOutlinePoints(subsetFace, 5) == getOutlinePoints(face, 3));
+    REQUIRE(FT_Load_Glyph(subsetFace, 3, FT_LOAD_NO_SCALE) != 0);
+
+    // The subroutine not called by the subset is emptied
+    const char unusedSubr[] = { (char)(139 + 17), (char)(139 + 23), 5, 11 };
+    REQUIRE(font.find(string_view(unusedSubr, 4)) != string::npos);
+    REQUIRE(subset.find(string_view(unusedSubr, 4)) == string::npos);
+
+    FT_Done_Face(subsetFace);
+    FT_Done_Face(face);
+}
+
+// Build a name-keyed CFF font with the standard ISOAdobe charset,
+// where ".notdef" is followed by "space", "exclam", "quotedbl"
+// and "numbersign". Glyph 2 calls a local subroutine and
+// glyph 3 a global one
+charbuff buildTestCFFFont()
+{
+    auto charString = [](const vector<int>& values) {
+        // Operators are encoded as negative values
+        charbuff ret;
+        for (int value : values)
+        {
+            if (value < 0)
+                ret.push_back((char)-value);
+            else
+                appendCFFNumber(ret, value - 1000);
+        }
+        return ret;
+    };
+
+    constexpr int rmoveto = -21;
+    constexpr int rlineto = -5;
+    constexpr int callsubr = -10;
+    constexpr int callgsubr = -29;
+    constexpr int return_ = -11;
+    constexpr int endchar = -14;
+    auto n = [](int value) { return value + 1000; };
+
+    vector<charbuff> charStrings = {
+        charString({ n(500), endchar }),
+        charString({ n(250), endchar }),
+        charString({ n(100), n(100), rmoveto, n(-107), callsubr, endchar }),
+        charString({ n(100), n(100), rmoveto, n(200), n(0), rlineto, n(-107), callgsubr, endchar }),
+        charString({ n(100), n(100), rmoveto, n(300), n(300), rlineto, endchar }),
+    };
+    vector<charbuff> subrs = {
+        charString({ n(200), n(0), rlineto, n(0), n(200), rlineto, return_ }),
+        charString({ n(17), n(23), rlineto, return_ }),
+    };
+    vector<charbuff> globalSubrs = {
+        charString({ n(0), n(300), rlineto, n(-200), n(0), rlineto, return_ }),
+    };
+
+    // The Private DICT with the local subroutines after it
+    charbuff privateDict;
+    appendCFFNumber(privateDict, 0);
+    privateDict.push_back(20);              // defaultWidthX
+    appendCFFNumber(privateDict, 0);
+    privateDict.push_back(21);              // nominalWidthX
+    // The offset of the subroutines is written in 1 byte
+    appendCFFNumber(privateDict, (int)privateDict.size() + 2);
+    privateDict.push_back(19);              // Subrs
+
+    // The Top DICT offsets are written in 5 bytes, to be known in advance
+    auto topDict = [](int charStringsOffset, int privateSize, int privateOffset) {
+        charbuff ret;
+        auto appendInt = [&](int value) {
+            ret.push_back(29);
+            for (int i = 3; i >= 0; i--)
+                ret.push_back((char)(value >> (8 * i)));
+        };
+        appendInt(charStringsOffset);
+        ret.push_back(17);                  // CharStrings
+        appendInt(privateSize);
+        appendInt(privateOffset);
+        ret.push_back(18);                  // Private
+        return ret;
+    };
+
+    charbuff header;
+    header.append({ 1, 0, 4, 1 });
+    appendCFFIndex(header, { charbuff(string("TestCFF")) });
+    charbuff tmp;
+    appendCFFIndex(tmp, { topDict(0, 0, 0) });
+    size_t charStringsOffset = header.size() + tmp.size();
+    charbuff strings;
+    appendCFFIndex(strings, { });
+    appendCFFIndex(strings, globalSubrs);
+    charStringsOffset += strings.size();
+    charbuff charStringsIndex;
+    appendCFFIndex(charStringsIndex, charStrings);
+    size_t privateOffset = charStringsOffset + charStringsIndex.size();
+
+    charbuff ret = header;
+    appendCFFIndex(ret, { topDict((int)charStringsOffset, (int)privateDict.size(), (int)privateOffset) });
+    ret.append(strings);
+    ret.append(charStringsIndex);
+    ret.append(privateDict);
+    appendCFFIndex(ret, subrs);
+    return ret;
+}
+
+void appendCFFIndex(charbuff& output, const vector<charbuff>& items)
+{
+    output.push_back((char)(items.size() >> 8));
+    output.push_back((char)items.size());
+    if (items.size() == 0)
+        return;
+
+    // Use 2 bytes offsets
+    output.push_back(2);
+    unsigned offset = 1;
+    for (size_t i = 0; i <= items.size(); i++)
+    {
+        output.push_back((char)(offset >> 8));
+        output.push_back((char)offset);
+        if (i < items.size())
+            offset += (unsigned)items[i].size();
+    }
+
+    for (auto& item : items)
+        output.append(item);
+}
+
+void appendCFFNumber(charbuff& output, int value)
+{
+    if (value >= -107 && value <= 107)
+    {
+        output.push_back((char)(value + 139));
+    }
+    else if (value >= 108 && value <= 1131)
+    {
+        value -= 108;
+        output.push_back((char)((value >> 8) + 247));
+        output.push_back((char)value);
+    }
+    else if (value >= -1131 && value <= -108)
+    {
+        value = -value - 108;
+        output.push_back((char)((value >> 8) + 251));
+        output.push_back((char)value);
+    }
+    else
+    {
+        output.push_back(28);
+        output.push_back((char)(value >> 8));
+        output.push_back((char)value);
+    }
+}
+
+charbuff getOutlinePoints(FT_Face face, unsigned gid)
+{
+    REQUIRE(FT_Load_Glyph(face, gid, FT_LOAD_NO_SCALE | FT_LOAD_NO_HINTING) == 0);
+    auto& outline = face->glyph->outline;
+    REQUIRE(outline.n_points != 0);
+    return charbuff(string(reinterpret_cast<const char*>(outline.points), outline.n_points * sizeof(FT_Vector)));
+}
+
+TEST_CASE("testWarmup")
+{
+    PdfLibrary::Warmup();
+    auto metrics = PdfFontMetricsStandard14::GetInstance(PdfStandard14FontType::Helvetica);
+
+    // Warming up again keeps the instances already created
+    PdfLibrary::Warmup();
+    REQUIRE(PdfFontMetricsStandard14::GetInstance(PdfStandard14FontType::Helvetica) == metrics);
+
+    PdfMemDocument doc;
+    auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    PdfPainter painter;
+    painter.SetCanvas(page);
+    painter.GetTextState().SetFont(doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica), 12);
+    painter.DrawText("Hello", 100, 100);
+    painter.FinishDrawing();
+}
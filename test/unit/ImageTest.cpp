@@ -0,0 +1,430 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <PdfTest.h>
+#include "TestUtils.h"
+
+#ifdef PDFMM_HAVE_TIFF_LIB
+#include <tiffio.h>
+#endif // PDFMM_HAVE_TIFF_LIB
+
+using namespace std;
+using namespace mm;
+
+#ifdef PDFMM_HAVE_PNG_LIB
+static charbuff createPng(unsigned width, unsigned height, unsigned char colorType, const charbuff& pixels);
+#endif // PDFMM_HAVE_PNG_LIB
+
+#ifdef PDFMM_HAVE_PNG_LIB
+
+TEST_CASE("testLoadPngImages")
+{
+    PdfMemDocument doc;
+    charbuff rgb(string_view("abcdefghijkl"));
+
+    // 8 bit RGB images are embedded as they are
+    PdfImage image(doc);
+    auto png = createPng(2, 2, 2, rgb);
+    image.LoadFromPngData((const unsigned char*)png.data(), png.size());
+    REQUIRE(image.GetWidth() == 2);
+    REQUIRE(image.GetHeight() == 2);
+    REQUIRE(image.GetDictionary().MustFindKey("DecodeParms").GetDictionary().MustFindKey("Predictor").GetNumber() == 15);
+    charbuff data;
+    image.GetObject().MustGetStream().ExtractTo(data);
+    REQUIRE(data == rgb);
+
+    // The alpha channel is split to the soft mask while decoding
+    charbuff rgba(string_view("abc1def2ghi3jkl4"));
+    PdfImage alphaImage(doc);
+    png = createPng(2, 2, 6, rgba);
+    alphaImage.LoadFromPngData((const unsigned char*)png.data(), png.size());
+    REQUIRE(!alphaImage.GetDictionary().HasKey("DecodeParms"));
+    alphaImage.GetObject().MustGetStream().ExtractTo(data);
+    REQUIRE(data == rgb);
+    auto& smask = alphaImage.GetDictionary().MustFindKey("SMask");
+    REQUIRE(smask.GetDictionary().MustFindKey("Width").GetNumber() == 2);
+    smask.MustGetStream().ExtractTo(data);
+    REQUIRE(data == "1234");
+}
+
+TEST_CASE("testShareImages")
+{
+    PdfMemDocument doc;
+    auto png = createPng(2, 2, 2, charbuff(string_view("abcdefghijkl")));
+    auto& manager = doc.GetImageManager();
+
+    // The same data loaded more times is the same image
+    auto& image = manager.GetImageFromData(png);
+    unsigned objectCount = doc.GetObjects().GetSize();
+    REQUIRE(&manager.GetImageFromData(png) == &image);
+    auto other = createPng(2, 2, 2, charbuff(string_view("abcdefghijkm")));
+    REQUIRE(&manager.GetImageFromData(other) != &image);
+    REQUIRE(doc.GetObjects().GetSize() == objectCount + 1);
+
+    // The images drawn from the same file too
+    auto testPath = TestUtils::GetTestOutputFilePath("ShareImages.png");
+    {
+        FileStreamDevice output(testPath, FileMode::Create);
+        output.Write(png);
+    }
+    auto& page = *doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    PdfPainter painter;
+    painter.SetCanvas(&page);
+    painter.DrawImage(testPath, 0, 0);
+    painter.DrawImage(testPath, 100, 100);
+    painter.FinishDrawing();
+    REQUIRE(&manager.GetImage(testPath) == &image);
+    REQUIRE(page.GetResources()->GetDictionary().MustFindKey("XObject").GetDictionary().GetSize() == 1);
+
+    // The identical ICC profiles are shared
+    string_view profile = "icc profile data";
+    SpanStreamDevice input1(profile);
+    image.SetICCProfile(input1, 3);
+    objectCount = doc.GetObjects().GetSize();
+    PdfImage otherImage(doc);
+    SpanStreamDevice input2(profile);
+    otherImage.SetICCProfile(input2, 3);
+    REQUIRE(doc.GetObjects().GetSize() == objectCount + 1);
+    REQUIRE(otherImage.GetDictionary().MustFindKey("ColorSpace").GetArray()[1].GetReference()
+        == image.GetDictionary().MustFindKey("ColorSpace").GetArray()[1].GetReference());
+}
+
+#endif // PDFMM_HAVE_PNG_LIB
+
+#ifdef PDFMM_HAVE_TIFF_LIB
+
+TEST_CASE("testAppendTiffPages")
+{
+    auto testPath = TestUtils::GetTestOutputFilePath("AppendTiffPages.tif");
+    TIFF* tiff = TIFFOpen(testPath.c_str(), "w");
+    REQUIRE(tiff != nullptr);
+
+    // A bilevel image compressed with CCITT Group 4 in a single strip
+    unsigned char bilevel[] = { 0xF0, 0x0F, 0x00, 0xFF };
+    TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, 16);
+    TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, 2);
+    TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 1);
+    TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+    TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, 2);
+    TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_CCITTFAX4);
+    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISWHITE);
+    TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    REQUIRE(TIFFWriteEncodedStrip(tiff, 0, bilevel, sizeof(bilevel)) != -1);
+    REQUIRE(TIFFWriteDirectory(tiff));
+
+    // A grayscale image compressed with LZW in more strips, the
+    // last one with less rows
+    unsigned char gray[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 };
+    TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, 4);
+    TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, 5);
+    TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+    TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+    TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, 2);
+    TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+    TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tiff, TIFFTAG_XRESOLUTION, 144.0f);
+    TIFFSetField(tiff, TIFFTAG_YRESOLUTION, 144.0f);
+    TIFFSetField(tiff, TIFFTAG_RESOLUTIONUNIT, RESUNIT_INCH);
+    for (unsigned i = 0; i < 3; i++)
+    {
+        tmsize_t size = i == 2 ? 4 : 8;
+        REQUIRE(TIFFWriteEncodedStrip(tiff, i, gray + i * 8, size) != -1);
+    }
+    REQUIRE(TIFFWriteDirectory(tiff));
+
+    // A palette image
+    unsigned char indices[] = { 0, 1, 2, 3 };
+    vector<uint16_t> red(256), green(256), blue(256);
+    red[1] = 0xFFFF;
+    green[2] = 0xFFFF;
+    blue[3] = 0xFFFF;
+    red[3] = 0x8080;
+    TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, 2);
+    TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, 2);
+    TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+    TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+    TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, 2);
+    TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
+    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_PALETTE);
+    TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tiff, TIFFTAG_COLORMAP, red.data(), green.data(), blue.data());
+    REQUIRE(TIFFWriteEncodedStrip(tiff, 0, indices, sizeof(indices)) != -1);
+    REQUIRE(TIFFWriteDirectory(tiff));
+    TIFFClose(tiff);
+
+    PdfMemDocument doc;
+    REQUIRE(doc.AppendTiffPages(testPath) == 3);
+    REQUIRE(doc.GetPages().GetCount() == 3);
+
+    auto getImage = [&](unsigned pageIndex)
+    {
+        auto& page = doc.GetPages().GetPage(pageIndex);
+        auto& xobjects = page.GetResources()->GetDictionary().MustFindKey("XObject").GetDictionary();
+        REQUIRE(xobjects.GetSize() == 1);
+        auto& obj = doc.GetObjects().MustGetObject(xobjects.begin()->second.GetReference());
+        unique_ptr<PdfImage> image;
+        REQUIRE(PdfXObject::TryCreateFromObject(obj, image));
+        return image;
+    };
+
+    // The Group 4 data is embedded as it is
+    auto image = getImage(0);
+    REQUIRE(image->GetDictionary().MustFindKey("Filter").GetName() == "CCITTFaxDecode");
+    REQUIRE(image->GetDictionary().MustFindKey("DecodeParms").GetDictionary().MustFindKey("K").GetNumber() == -1);
+    charbuff pixels;
+    image->DecodeTo(pixels, PdfPixelFormat::Gray);
+    REQUIRE(pixels == charbuff(string_view(
+        "\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00"
+        "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00", 32)));
+
+    // The strips are decoded and compressed again
+    image = getImage(1);
+    REQUIRE(image->GetWidth() == 4);
+    REQUIRE(image->GetHeight() == 5);
+    REQUIRE(image->GetDictionary().MustFindKey("Filter").GetName() == "FlateDecode");
+    image->DecodeTo(pixels, PdfPixelFormat::Gray);
+    REQUIRE(pixels == charbuff(string_view((const char*)gray, sizeof(gray))));
+    auto rect = doc.GetPages().GetPage(1).GetMediaBox();
+    REQUIRE(rect.GetWidth() == 2);
+    REQUIRE(rect.GetHeight() == 2.5);
+
+    image = getImage(2);
+    auto& colorSpace = image->GetDictionary().MustFindKey("ColorSpace").GetArray();
+    REQUIRE(colorSpace[0].GetName() == "Indexed");
+    REQUIRE(colorSpace[2].GetNumber() == 255);
+    image->DecodeTo(pixels, PdfPixelFormat::RGB24);
+    REQUIRE(pixels == charbuff(string_view(
+        "\x00\x00\x00\xFF\x00\x00\x00\xFF\x00\x80\x00\xFF", 12)));
+}
+
+#endif // PDFMM_HAVE_TIFF_LIB
+
+TEST_CASE("testConvertImageData")
+{
+    PdfMemDocument doc;
+    // BGRA pixels, wider than the vectorized kernels
+    constexpr unsigned Width = 10;
+    charbuff bgra;
+    for (unsigned i = 0; i < Width * 2; i++)
+    {
+        bgra.push_back((char)(i * 3));
+        bgra.push_back((char)(i * 5));
+        bgra.push_back((char)(i * 7));
+        bgra.push_back((char)(255 - i));
+    }
+
+    // The channels are reordered and the alpha goes to the soft mask
+    PdfImage image(doc);
+    SpanStreamDevice input(bgra);
+    image.SetData(input, Width, 2, PdfPixelFormat::BGRA);
+    charbuff data;
+    image.GetObject().MustGetStream().ExtractTo(data);
+    REQUIRE(data.size() == Width * 2 * 3);
+    charbuff alpha;
+    image.GetDictionary().MustFindKey("SMask").MustGetStream().ExtractTo(alpha);
+    REQUIRE(alpha.size() == Width * 2);
+    for (unsigned i = 0; i < Width * 2; i++)
+    {
+        REQUIRE((unsigned char)data[i * 3] == i * 7);
+        REQUIRE((unsigned char)data[i * 3 + 1] == i * 5);
+        REQUIRE((unsigned char)data[i * 3 + 2] == i * 3);
+        REQUIRE((unsigned char)alpha[i] == 255 - i);
+    }
+
+    // Box downsampling to gray, averaging 2x2 pixels
+    PdfImageConversion conversion;
+    conversion.Width = Width / 2;
+    conversion.Height = 1;
+    conversion.ColorSpace = PdfColorSpace::DeviceGray;
+    conversion.ExtractAlpha = false;
+    PdfImage grayImage(doc);
+    input.Seek(0);
+    grayImage.SetData(input, Width, 2, PdfPixelFormat::BGRA, conversion);
+    REQUIRE(!grayImage.GetDictionary().HasKey("SMask"));
+    REQUIRE(grayImage.GetWidth() == Width / 2);
+    grayImage.GetObject().MustGetStream().ExtractTo(data);
+    REQUIRE(data.size() == Width / 2);
+    for (unsigned x = 0; x < Width / 2; x++)
+    {
+        // The sum of the indices of the 2x2 pixels is 8x + 22
+        unsigned r = (7 * (8 * x + 22) + 2) / 4;
+        unsigned g = (5 * (8 * x + 22) + 2) / 4;
+        unsigned b = (3 * (8 * x + 22) + 2) / 4;
+        REQUIRE((unsigned char)data[x] == (r * 77 + g * 150 + b * 29 + 128) >> 8);
+    }
+
+    // Bilinear downsampling
+    conversion = { };
+    conversion.Width = 2;
+    conversion.Resampling = PdfImageResampling::Bilinear;
+    PdfImage bilinearImage(doc);
+    SpanStreamDevice grayInput(string_view("\x00\x64\xC8\xFF", 4));
+    bilinearImage.SetData(grayInput, 4, 1, PdfPixelFormat::Gray, conversion);
+    bilinearImage.GetObject().MustGetStream().ExtractTo(data);
+    REQUIRE(data == string_view("\x32\xE4", 2));
+
+    // Color space conversion
+    conversion = { };
+    conversion.ColorSpace = PdfColorSpace::DeviceCMYK;
+    PdfImage cmykImage(doc);
+    SpanStreamDevice rgbInput(string_view("\xFF\x00\x00\x80\x80\x80", 6));
+    cmykImage.SetData(rgbInput, 2, 1, PdfPixelFormat::RGB24, conversion);
+    cmykImage.GetObject().MustGetStream().ExtractTo(data);
+    REQUIRE(data == string_view("\x00\xFF\xFF\x00\x00\x00\x00\x7F", 8));
+
+    // Premultiplied alpha, with the matte in the soft mask
+    conversion = { };
+    conversion.PremultiplyAlpha = true;
+    PdfImage premultipliedImage(doc);
+    SpanStreamDevice argbInput(string_view("\x80\xFF\x40\x00", 4));
+    premultipliedImage.SetData(argbInput, 1, 1, PdfPixelFormat::ARGB, conversion);
+    premultipliedImage.GetObject().MustGetStream().ExtractTo(data);
+    REQUIRE(data == string_view("\x80\x20\x00", 3));
+    auto& smask = premultipliedImage.GetDictionary().MustFindKey("SMask");
+    REQUIRE(smask.GetDictionary().MustFindKey("Matte").GetArray().size() == 3);
+
+    // The data can only be scaled down
+    conversion = { };
+    conversion.Width = 5;
+    ASSERT_THROW_WITH_ERROR_CODE(image.SetData(grayInput, 4, 1, PdfPixelFormat::Gray, conversion),
+        PdfErrorCode::ValueOutOfRange);
+}
+
+TEST_CASE("testDecodeImageData")
+{
+    PdfMemDocument doc;
+    // BGRA pixels, wider than the vectorized kernels
+    constexpr unsigned Width = 10;
+    charbuff bgra;
+    for (unsigned i = 0; i < Width * 2; i++)
+    {
+        bgra.push_back((char)(i * 3));
+        bgra.push_back((char)(i * 5));
+        bgra.push_back((char)(i * 7));
+        bgra.push_back((char)(255 - i));
+    }
+
+    // The soft mask is merged back into the alpha
+    PdfImage image(doc);
+    SpanStreamDevice input(bgra);
+    image.SetData(input, Width, 2, PdfPixelFormat::BGRA);
+    charbuff pixels;
+    image.DecodeTo(pixels, PdfPixelFormat::BGRA);
+    REQUIRE(pixels == bgra);
+
+    // Rows with padding, opaque without the soft mask
+    constexpr unsigned Stride = Width * 4 + 8;
+    charbuff padded(Stride * 2);
+    std::fill(padded.begin(), padded.end(), '\x7F');
+    image.GetDictionary().RemoveKey("SMask");
+    image.DecodeTo(mspan<char>(padded.data(), padded.size()), PdfPixelFormat::ARGB, Stride);
+    for (unsigned y = 0; y < 2; y++)
+    {
+        for (unsigned x = 0; x < Width; x++)
+        {
+            unsigned i = y * Width + x;
+            auto pixel = padded.data() + y * Stride + x * 4;
+            REQUIRE((unsigned char)pixel[0] == 255);
+            REQUIRE((unsigned char)pixel[1] == i * 7);
+            REQUIRE((unsigned char)pixel[2] == i * 5);
+            REQUIRE((unsigned char)pixel[3] == i * 3);
+        }
+
+        REQUIRE(padded[y * Stride + Width * 4] == '\x7F');
+    }
+
+    // The buffer must hold the rows
+    ASSERT_THROW_WITH_ERROR_CODE(image.DecodeTo(mspan<char>(padded.data(), Stride), PdfPixelFormat::ARGB, Stride),
+        PdfErrorCode::ValueOutOfRange);
+
+    // Indexed samples of 2 bits, looked up in the palette
+    PdfArray indexed;
+    indexed.Add(PdfName("DeviceRGB"));
+    indexed.Add(PdfObject((int64_t)2));
+    indexed.Add(PdfString::FromRaw(string_view("\xFF\x00\x00\x00\xFF\x00\x00\x00\xFF", 9)));
+    PdfImage indexedImage(doc);
+    indexedImage.SetColorSpace(PdfColorSpace::Indexed, &indexed);
+    SpanStreamDevice indexedInput(string_view("\x1B", 1));
+    indexedImage.SetData(indexedInput, 4, 1, 2);
+    indexedImage.DecodeTo(pixels, PdfPixelFormat::RGB24);
+    REQUIRE(pixels == string_view("\xFF\x00\x00\x00\xFF\x00\x00\x00\xFF\x00\x00\xFF", 12));
+
+    // Inverted samples of 1 bit, with a partial last byte
+    PdfImage bilevelImage(doc);
+    bilevelImage.SetColorSpace(PdfColorSpace::DeviceGray);
+    PdfArray decode;
+    decode.Add(PdfObject((int64_t)1));
+    decode.Add(PdfObject((int64_t)0));
+    bilevelImage.GetDictionary().AddKey("Decode", decode);
+    SpanStreamDevice bilevelInput(string_view("\xA5\x80", 2));
+    bilevelImage.SetData(bilevelInput, 10, 1, 1);
+    bilevelImage.DecodeTo(pixels, PdfPixelFormat::Gray);
+    REQUIRE(pixels == string_view("\x00\xFF\x00\xFF\xFF\x00\xFF\x00\x00\xFF", 10));
+}
+
+#ifdef PDFMM_HAVE_PNG_LIB
+
+static void writeUInt32BE(char* buffer, uint32_t value)
+{
+    buffer[0] = (char)(value >> 24);
+    buffer[1] = (char)(value >> 16);
+    buffer[2] = (char)(value >> 8);
+    buffer[3] = (char)value;
+}
+
+static void appendPngChunk(charbuff& png, const string_view& type, const string_view& data)
+{
+    char length[4];
+    writeUInt32BE(length, (uint32_t)data.size());
+    png.append(length, 4);
+    size_t start = png.size();
+    png.append(type);
+    png.append(data);
+
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = start; i < png.size(); i++)
+    {
+        crc ^= (unsigned char)png[i];
+        for (unsigned k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+
+    char crcBytes[4];
+    writeUInt32BE(crcBytes, crc ^ 0xFFFFFFFF);
+    png.append(crcBytes, 4);
+}
+
+charbuff createPng(unsigned width, unsigned height, unsigned char colorType, const charbuff& pixels)
+{
+    // 8 bit, non interlaced, every row with no PNG predictor
+    charbuff png(string_view("\x89PNG\r\n\x1A\n", 8));
+    char ihdr[13] = { };
+    writeUInt32BE(ihdr, width);
+    writeUInt32BE(ihdr + 4, height);
+    ihdr[8] = 8;
+    ihdr[9] = (char)colorType;
+    appendPngChunk(png, "IHDR", string_view(ihdr, 13));
+
+    size_t rowLen = pixels.size() / height;
+    charbuff rows;
+    for (unsigned i = 0; i < height; i++)
+    {
+        rows.push_back(0);
+        rows.append(pixels.data() + i * rowLen, rowLen);
+    }
+
+    // Split the image data in two chunks
+    charbuff encoded;
+    PdfFilterFactory::Create(PdfFilterType::FlateDecode)->EncodeTo(encoded, rows);
+    appendPngChunk(png, "IDAT", string_view(encoded.data(), encoded.size() / 2));
+    appendPngChunk(png, "IDAT", string_view(encoded.data() + encoded.size() / 2, encoded.size() - encoded.size() / 2));
+    appendPngChunk(png, "IEND", { });
+    return png;
+}
+
+#endif // PDFMM_HAVE_PNG_LIB
@@ -93,6 +93,13 @@ TEST_CASE("testWrite")
     TestNameWrite("Length\001\002\003Spaces", "/Length#01#02#03Spaces");
     TestNameWrite("Tab\tTest", "/Tab#09Test");
     TestNameWrite("ANPA 723-0 AdPro", "/ANPA#20723-0#20AdPro");
+
+    // Names with no characters to escape, also interned, are written as is
+    TestNameWrite("Type", "/Type");
+    TestNameWrite("PlainName-1.5", "/PlainName-1.5");
+    TestNameWrite("Hash#Sign", "/Hash#23Sign");
+    REQUIRE(PdfName::FromRaw(string_view("Null\0Byte", 9)).GetRawData().size() == 9);
+    REQUIRE_THROWS(PdfName::FromRaw(string_view("Null\0Byte", 9)).GetEscapedName());
 }
 
 TEST_CASE("testFromEscaped")
@@ -101,6 +108,26 @@ TEST_CASE("testFromEscaped")
     TestFromEscape("Length#20With#20Spaces", "Length With Spaces");
 }
 
+TEST_CASE("testInternedNames")
+{
+    // Common names are equal and have the same hash
+    // regardless of how they are created
+    PdfName name1("Type");
+    auto name2 = PdfName::FromEscaped("Ty#70e");
+    auto name3 = PdfName::FromRaw(string_view("Type"));
+    REQUIRE(name1 == PdfName::KeyType);
+    REQUIRE(name2 == PdfName::KeyType);
+    REQUIRE(name3 == PdfName::KeyType);
+    REQUIRE(name1.GetRawData().data() == PdfName::KeyType.GetRawData().data());
+    REQUIRE(name2.GetRawData().data() == PdfName::KeyType.GetRawData().data());
+    REQUIRE(std::hash<PdfName>()(name2) == std::hash<string_view>()("Type"));
+
+    REQUIRE(PdfName::KeyType != PdfName::KeySubtype);
+    REQUIRE(PdfName("Typ") != PdfName::KeyType);
+    REQUIRE(PdfName("Types") != PdfName::KeyType);
+    REQUIRE(std::hash<PdfName>()(PdfName("Types")) == std::hash<string_view>()("Types"));
+}
+
 //
 // Test encoding of names.
 // pszString : internal representation, ie unencoded name
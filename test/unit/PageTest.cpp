@@ -37,3 +37,558 @@ TEST_CASE("testEmptyContentsStream")
     auto& pageObj = page2.GetObject();
     REQUIRE(!pageObj.GetDictionary().HasKey("Contents"));
 }
+
+TEST_CASE("testInsertPagesSharesStreams")
+{
+    PdfMemDocument doc;
+    PdfPage* page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    page->GetOrCreateContents().GetStreamForAppending().Set("0 0 m 100 100 l S"sv, { });
+
+    PdfMemDocument doc2;
+    doc2.InsertPages(doc, 0, 1);
+    auto& contents1 = page->GetContents()->GetObject().GetArray();
+    auto& contents2 = doc2.GetPages().GetPage(0).GetContents()->GetObject().GetArray();
+    auto& stream1 = dynamic_cast<PdfMemoryObjectStream&>(contents1.FindAt(contents1.GetSize() - 1).MustGetStream());
+    auto& stream2 = dynamic_cast<PdfMemoryObjectStream&>(contents2.FindAt(contents2.GetSize() - 1).MustGetStream());
+
+    // The copied stream shares the buffer until it's modified
+    REQUIRE(stream1.Get() == stream2.Get());
+    stream2.Set("0 0 m 50 50 l S"sv, { });
+    REQUIRE(stream1.Get() != stream2.Get());
+    REQUIRE(string_view(stream1.Get(), stream1.GetLength()) == "0 0 m 100 100 l S");
+    REQUIRE(string_view(stream2.Get(), stream2.GetLength()) == "0 0 m 50 50 l S");
+}
+
+TEST_CASE("testContentsBounds")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+        doc.GetPages().CreatePage(PdfRect(0, 0, 400, 400));
+        auto page = doc.GetPages().CreatePage(PdfRect(0, 0, 400, 400));
+        PdfPainter painter;
+        painter.SetCanvas(page);
+        painter.Rectangle(50, 50, 100, 50);
+        painter.Fill();
+
+        // Clipped out entirely
+        painter.Save();
+        painter.SetClipRect(0, 0, 10, 10);
+        painter.Rectangle(300, 300, 50, 50);
+        painter.Fill();
+        painter.Restore();
+
+        painter.GetTextState().SetFont(font, 10);
+        painter.DrawText("Hello", 250, 250);
+        painter.FinishDrawing();
+
+        // The form content is clipped by its bounding box
+        PdfXObjectForm form(doc, PdfRect(0, 0, 50, 50));
+        PdfPainter formPainter;
+        formPainter.SetCanvas(&form);
+        formPainter.Rectangle(0, 0, 100, 100);
+        formPainter.Fill();
+        formPainter.FinishDrawing();
+
+        PdfPainter xobjPainter;
+        xobjPainter.SetCanvas(doc.GetPages().CreatePage(PdfRect(0, 0, 400, 400)));
+        xobjPainter.DrawXObject(form, 200, 100);
+        xobjPainter.FinishDrawing();
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    auto bounds = doc.GetPages().GetPage(0).ComputeContentsBounds();
+    REQUIRE(bounds.IsEmpty);
+
+    PdfContentsBoundsParams params;
+    params.GridColumns = 4;
+    params.GridRows = 4;
+    bounds = doc.GetPages().GetPage(1).ComputeContentsBounds(params);
+    REQUIRE(!bounds.IsEmpty);
+    REQUIRE(bounds.BoundingBox.GetLeft() == 50);
+    REQUIRE(bounds.BoundingBox.GetBottom() == 50);
+    REQUIRE(bounds.BoundingBox.GetRight() > 250);
+    REQUIRE(bounds.BoundingBox.GetRight() < 300);
+    REQUIRE(bounds.BoundingBox.GetTop() > 255);
+    REQUIRE(bounds.BoundingBox.GetTop() < 262);
+
+    // The rect covers the cells (0, 0) and (1, 0), the text the cell (2, 2)
+    REQUIRE(bounds.Grid.size() == 16);
+    vector<bool> expected = {
+        true, true, false, false,
+        false, false, false, false,
+        false, false, true, false,
+        false, false, false, false,
+    };
+    REQUIRE(bounds.Grid == expected);
+
+    bounds = doc.GetPages().GetPage(2).ComputeContentsBounds();
+    REQUIRE(!bounds.IsEmpty);
+    REQUIRE(bounds.BoundingBox.GetLeft() == 200);
+    REQUIRE(bounds.BoundingBox.GetBottom() == 100);
+    REQUIRE(bounds.BoundingBox.GetWidth() == 50);
+    REQUIRE(bounds.BoundingBox.GetHeight() == 50);
+}
+
+TEST_CASE("testInheritedAttributesCache")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto& pageDict = doc.GetPages().GetPage(0).GetObject().GetDictionary();
+        auto& rootDict = doc.GetPages().GetObject().GetDictionary();
+        rootDict.AddKey("MediaBox", pageDict.MustGetKey("MediaBox"));
+        rootDict.AddKey("Rotate", (int64_t)90);
+        pageDict.RemoveKey("MediaBox");
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    auto& page = doc.GetPages().GetPage(0);
+    REQUIRE(page.GetMediaBox().GetWidth() == 595);
+    REQUIRE(page.GetCropBox().GetWidth() == 595);
+    REQUIRE(page.GetRotationRaw() == 90);
+
+    // Reading doesn't invalidate the cache
+    auto modificationCount = doc.GetObjects().GetModificationCount();
+    REQUIRE(page.GetTrimBox().GetWidth() == 595);
+    REQUIRE(doc.GetObjects().GetModificationCount() == modificationCount);
+
+    // Modifying an ancestor or the page invalidates it
+    auto& rootDict = doc.GetPages().GetObject().GetDictionary();
+    PdfArray mediaBox;
+    PdfPage::CreateStandardPageSize(PdfPageSize::A5).ToArray(mediaBox);
+    rootDict.AddKey("MediaBox", mediaBox);
+    REQUIRE(page.GetMediaBox().GetWidth() == 420);
+    REQUIRE(page.GetArtBox().GetWidth() == 420);
+    rootDict.FindKey("MediaBox")->GetArray()[2] = PdfObject(100.0);
+    REQUIRE(page.GetMediaBox().GetWidth() == 100);
+    rootDict.AddKey("Rotate", (int64_t)180);
+    REQUIRE(page.GetRotationRaw() == 180);
+    page.SetRotationRaw(270);
+    REQUIRE(page.GetRotationRaw() == 270);
+    page.SetMediaBox(PdfRect(0, 0, 50, 50));
+    REQUIRE(page.GetCropBox().GetWidth() == 50);
+    page.SetTrimBox(PdfRect(0, 0, 40, 40));
+    REQUIRE(page.GetTrimBox().GetWidth() == 40);
+}
+
+TEST_CASE("testResourcesCache")
+{
+    PdfMemDocument doc;
+    auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    auto& resources = page->GetOrCreateResources();
+    auto font1 = doc.GetObjects().CreateDictionaryObject("Font");
+    auto font2 = doc.GetObjects().CreateDictionaryObject("Font");
+    REQUIRE(resources.GetResource("Font", "F1") == nullptr);
+    resources.AddResource("Font", "F1", font1);
+    REQUIRE(resources.GetResource("Font", "F1") == font1);
+    REQUIRE(resources.GetResource("Font", "F1") == font1);
+    REQUIRE(resources.GetResource("XObject", "F1") == nullptr);
+
+    // Modifications of the dictionaries invalidate the cache
+    resources.GetDictionary().MustFindKey("Font").GetDictionary().AddKey("F1", font2->GetIndirectReference());
+    REQUIRE(resources.GetResource("Font", "F1") == font2);
+    resources.RemoveResource("Font", "F1");
+    REQUIRE(resources.GetResource("Font", "F1") == nullptr);
+    resources.AddResource("Font", "F2", font1);
+    REQUIRE(resources.GetResource("Font", "F2") == font1);
+    resources.RemoveResources("Font");
+    REQUIRE(resources.GetResource("Font", "F2") == nullptr);
+}
+
+TEST_CASE("testPageInventory")
+{
+    PdfMemDocument doc;
+    auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    PdfFontCreateParams params;
+    params.Encoding = PdfEncodingFactory::CreateWinAnsiEncoding();
+    params.Flags = PdfFontCreateFlags::DontEmbed;
+    auto helvetica = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica, params);
+    auto times = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::TimesRoman);
+
+    PdfImage image(doc);
+    SpanStreamDevice input(string_view("\x00\x40\x80\xFF", 4));
+    image.SetData(input, 2, 2, PdfPixelFormat::Gray);
+    PdfImage unused(doc);
+    input.Seek(0);
+    unused.SetData(input, 1, 1, PdfPixelFormat::Gray);
+
+    // The text of the form uses a font not used by the page
+    PdfXObjectForm form(doc, PdfRect(0, 0, 100, 100));
+    PdfPainter painter;
+    painter.SetCanvas(&form);
+    painter.GetTextState().SetFont(helvetica, 12);
+    painter.DrawText("Form", 10, 10);
+    painter.FinishDrawing();
+
+    painter.SetCanvas(page);
+    painter.DrawImage(image, 0, 0);
+    painter.DrawXObject(form, 100, 100);
+    painter.DrawXObject(form, 200, 200);
+    painter.GetTextState().SetFont(times, 12);
+    painter.DrawText("Page", 100, 100);
+    painter.FinishDrawing();
+    page->GetResources()->AddResource("XObject", "Unused", unused.GetObject().GetIndirectReference());
+
+    PdfPageInventory inventory(*page);
+    auto& images = inventory.GetImages();
+    REQUIRE(images.size() == 2);
+    auto& drawn = images[0].Reference == image.GetObject().GetIndirectReference() ? images[0] : images[1];
+    REQUIRE(drawn.UseCount == 1);
+    REQUIRE(drawn.Width == 2);
+    REQUIRE(drawn.Height == 2);
+    REQUIRE(drawn.BitsPerComponent == 8);
+    REQUIRE(drawn.ColorSpace == "DeviceGray");
+    REQUIRE(drawn.Filters == PdfFilterList{ PdfFilterType::FlateDecode });
+
+    // The form content is read once, however many times it's drawn
+    doc.GetFontManager().EmbedFonts();
+    PdfPageInventory fontInventory(*page);
+    auto& fonts = fontInventory.GetFonts();
+    REQUIRE(fonts.size() == 2);
+    auto& helveticaFont = fonts[0].Reference == helvetica->GetObject().GetIndirectReference() ? fonts[0] : fonts[1];
+    auto& timesFont = &helveticaFont == &fonts[0] ? fonts[1] : fonts[0];
+    REQUIRE(helveticaFont.UseCount == 1);
+    REQUIRE(helveticaFont.BaseFont == "Helvetica");
+    REQUIRE(helveticaFont.Type == PdfFontType::Type1);
+    REQUIRE(!helveticaFont.IsEmbedded);
+    REQUIRE(!helveticaFont.IsSubset);
+    REQUIRE(timesFont.UseCount == 1);
+    REQUIRE(timesFont.Type == PdfFontType::CIDType1);
+    REQUIRE(timesFont.IsEmbedded);
+    REQUIRE(timesFont.FontFileType == PdfFontFileType::CIDType1);
+    REQUIRE(timesFont.IsSubset);
+
+    PdfPageInventory usedInventory(*page, PdfPageInventoryFlags::UsedOnly);
+    REQUIRE(usedInventory.GetImages().size() == 1);
+    REQUIRE(usedInventory.GetImages()[0].Reference == image.GetObject().GetIndirectReference());
+
+    PdfPageInventory resourcesInventory(*page, PdfPageInventoryFlags::SkipContents);
+    REQUIRE(resourcesInventory.GetFonts().size() == 2);
+    REQUIRE(resourcesInventory.GetFonts()[0].UseCount == 0);
+}
+
+TEST_CASE("testFlattenAnnotations")
+{
+    PdfMemDocument doc;
+    auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    page->GetOrCreateContents().GetStreamForAppending().Set("0 0 m 100 100 l S"sv, { });
+    auto original = &page->GetContents()->GetObject().GetArray().FindAt(0);
+
+    PdfXObjectForm appearance(doc, PdfRect(0, 0, 50, 10));
+    {
+        PdfTextBox textBox(*page, PdfRect(10, 20, 100, 20));
+        textBox.SetName(PdfString("text"));
+        textBox.GetWidgetAnnotation()->SetAppearanceStream(appearance);
+    }
+
+    // Hidden annotations are removed without drawing them
+    auto hidden = page->CreateAnnotation(PdfAnnotationType::Square, PdfRect(200, 200, 10, 10));
+    hidden->SetAppearanceStream(appearance);
+    hidden->SetFlags(PdfAnnotationFlags::Hidden);
+
+    // Annotations without appearance are kept
+    page->CreateAnnotation(PdfAnnotationType::Text, PdfRect(300, 300, 10, 10));
+    REQUIRE(page->GetAnnotationCount() == 3);
+    REQUIRE(doc.GetAcroForm() != nullptr);
+
+    doc.FlattenAnnotations();
+    REQUIRE(page->GetAnnotationCount() == 1);
+    REQUIRE(page->GetAnnotation(0)->GetType() == PdfAnnotationType::Text);
+    REQUIRE(doc.GetAcroForm() == nullptr);
+    REQUIRE(!doc.GetCatalog().GetDictionary().HasKey("AcroForm"));
+
+    // The existing contents are wrapped, not rewritten
+    auto& contents = page->GetContents()->GetObject().GetArray();
+    REQUIRE(contents.GetSize() == 3);
+    REQUIRE(&contents.FindAt(1) == original);
+    charbuff buffer;
+    contents.FindAt(0).MustGetStream().ExtractTo(buffer);
+    REQUIRE(buffer == "q\n");
+    buffer.clear();
+    contents.FindAt(2).MustGetStream().ExtractTo(buffer);
+    REQUIRE(buffer == "Q\nq\n2 0 0 2 10 20 cm\n/Flat0 Do\nQ\n");
+    REQUIRE(page->GetResources()->GetResource("XObject", "Flat0") == &appearance.GetObject());
+}
+
+TEST_CASE("testRedactor")
+{
+    charbuff buffer;
+    double helloWidth;
+    {
+        PdfMemDocument doc;
+        auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+        PdfXObjectForm form(doc, PdfRect(0, 0, 50, 50));
+        PdfPainter formPainter;
+        formPainter.SetCanvas(&form);
+        formPainter.Rectangle(0, 0, 50, 50);
+        formPainter.Fill();
+        formPainter.FinishDrawing();
+
+        for (unsigned i = 0; i < 2; i++)
+        {
+            PdfPainter painter;
+            painter.SetCanvas(doc.GetPages().CreatePage(PdfRect(0, 0, 400, 400)));
+            painter.GetTextState().SetFont(font, 20);
+            helloWidth = font->GetStringWidth("Hello "sv, (const PdfTextState&)painter.GetTextState());
+            painter.DrawText("Hello World", 50, 300);
+            painter.Rectangle(50, 50, 100, 100);
+            painter.Fill();
+            painter.Rectangle(300, 50, 20, 20);
+            painter.Fill();
+            painter.DrawXObject(form, 200, 200);
+            painter.FinishDrawing();
+        }
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    PdfRedactor redactor;
+    // "World", half of the first rect and the second rect, part of the form
+    redactor.AddRect(1, PdfRect(50 + helloWidth + 1, 290, 200, 40));
+    redactor.AddRect(1, PdfRect(100, 0, 250, 120));
+    redactor.AddRect(1, PdfRect(210, 210, 10, 10));
+    redactor.SetFillColor(PdfColor(0, 0, 0));
+    REQUIRE(redactor.Redact(doc, 2) == 4);
+
+    charbuff redacted;
+    {
+        BufferStreamDevice device(redacted);
+        doc.Save(device);
+    }
+
+    doc.LoadFromBuffer(redacted);
+    auto extracted = doc.ExtractText();
+    REQUIRE(extracted[0].size() == 1);
+    REQUIRE(extracted[0][0].Text == "Hello World");
+    REQUIRE(extracted[1].size() == 1);
+    REQUIRE(extracted[1][0].Text == "Hello");
+
+    // The rects filled, the clipped out rect and the text are left
+    auto bounds = doc.GetPages().GetPage(1).ComputeContentsBounds();
+    REQUIRE(bounds.BoundingBox.GetLeft() == 50);
+    REQUIRE(bounds.BoundingBox.GetRight() == 350);
+
+    PdfCanvasInputDevice input(doc.GetPages().GetPage(1));
+    string contents;
+    StringStreamDevice output(contents);
+    input.CopyTo(output);
+    REQUIRE(contents.find("Do") == string::npos);
+    REQUIRE(contents.find("W* n") != string::npos);
+}
+
+TEST_CASE("testContentsProfiler")
+{
+    PdfMemDocument doc;
+    PdfXObjectForm form(doc, PdfRect(0, 0, 50, 50));
+    PdfPainter formPainter;
+    formPainter.SetCanvas(&form);
+    formPainter.Rectangle(0, 0, 50, 50);
+    formPainter.Fill();
+    formPainter.FinishDrawing();
+
+    auto page = doc.GetPages().CreatePage(PdfRect(0, 0, 400, 400));
+    page->GetOrCreateResources().AddResource("XObject", "Fm1", form.GetObject().GetIndirectReference());
+    page->GetOrCreateContents().GetStreamForAppending(PdfStreamAppendFlags::NoSaveRestorePrior).Set(
+        "q q 10 10 m 20 20 l 30 10 l h S Q 0 0 5 5 re f Q "
+        "BT (a) Tj [(b) 10 (c)] TJ ET /Fm1 Do /Fm1 Do "
+        "BI /W 1 /H 1 /BPC 8 /CS /G ID \x01 EI foo"sv);
+    page->GetOrCreateContents().GetStreamForAppending(PdfStreamAppendFlags::NoSaveRestorePrior).Set("Q"sv);
+    doc.GetPages().CreatePage(PdfRect(0, 0, 400, 400));
+
+    PdfContentsProfiler profiler;
+    auto profile = profiler.Profile(doc);
+    REQUIRE(profile.Pages.size() == 2);
+    auto& pageProfile = profile.Pages[0];
+    REQUIRE(pageProfile.Reference == page->GetObject().GetIndirectReference());
+    REQUIRE(!pageProfile.IsForm);
+    REQUIRE(pageProfile.StreamLengths.size() == 2);
+    REQUIRE(pageProfile.StreamLengths[1] == 1);
+    REQUIRE(pageProfile.GetOperatorCount(PdfOperator::q) == 2);
+    REQUIRE(pageProfile.GetOperatorCount(PdfOperator::Q) == 3);
+    REQUIRE(pageProfile.GetOperatorCount(PdfOperator::Do) == 2);
+    REQUIRE(pageProfile.GetOperatorCount(PdfOperator::Unknown) == 1);
+    REQUIRE(pageProfile.PathSegmentCount == 7);
+    REQUIRE(pageProfile.TextShowCount == 2);
+    REQUIRE(pageProfile.FormCount == 2);
+    REQUIRE(pageProfile.ImageCount == 1);
+    REQUIRE(pageProfile.InlineImageCount == 1);
+    REQUIRE(pageProfile.MaxNestingDepth == 2);
+    REQUIRE(profile.Pages[1].GetContentsLength() == 0);
+
+    // The form drawn twice is profiled once
+    REQUIRE(profile.Forms.size() == 1);
+    REQUIRE(profile.Forms[0].IsForm);
+    REQUIRE(profile.Forms[0].Reference == form.GetObject().GetIndirectReference());
+    REQUIRE(profile.Forms[0].PathSegmentCount == 4);
+    REQUIRE(profile.Forms[0].GetOperatorCount(PdfOperator::f) == 1);
+    REQUIRE(profiler.Profile(form).PathSegmentCount == 4);
+}
+
+TEST_CASE("testStamper")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        for (unsigned i = 0; i < 3; i++)
+        {
+            auto page = doc.GetPages().CreatePage(PdfRect(0, 0, 400, 400));
+            page->GetOrCreateContents().GetStreamForAppending().Set(utls::Format("({}) Tj", i), { });
+            (void)page->GetOrCreateResources();
+        }
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    PdfXObjectForm form(doc, PdfRect(0, 0, 50, 50));
+    form.GetObject().GetOrCreateStream().Set("0 0 50 50 re f"sv, { });
+
+    // The identifier of the form is used by another object on the first page
+    auto& first = doc.GetPages().GetPage(0);
+    first.GetOrCreateResources().AddResource("XObject", form.GetIdentifier(), PdfObject(PdfDictionary()));
+
+    PdfStamper stamper(form);
+    stamper.SetMatrix(Matrix::CreateTranslation(Vector2(100, 200)));
+    stamper.Stamp(doc);
+
+    // Only the pages, the form and the new streams are written in the update
+    charbuff updated = buffer;
+    {
+        BufferStreamDevice device(updated);
+        doc.SaveUpdate(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+    string_view update = string_view(updated).substr(buffer.size());
+    unsigned objCount = 0;
+    for (size_t pos = update.find(" 0 obj"); pos != string_view::npos; pos = update.find(" 0 obj", pos + 1))
+        objCount++;
+    // The pages, the form, the wrap stream and the stamp streams of the two names
+    REQUIRE(objCount == 7);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(updated);
+    for (unsigned i = 0; i < 3; i++)
+    {
+        auto& page = loaded.GetPages().GetPage(i);
+        string name = string(form.GetIdentifier().GetString());
+        if (i == 0)
+            name += "_0";
+
+        REQUIRE(page.GetResources()->GetResource("XObject", name)->GetIndirectReference() == form.GetObject().GetIndirectReference());
+        PdfCanvasInputDevice input(page);
+        string contents;
+        StringStreamDevice output(contents);
+        input.CopyTo(output);
+        REQUIRE(contents == utls::Format("q\n\n({}) Tj\nQ\nq\n1 0 0 1 100 200 cm\n/{} Do\nQ\n", i, name));
+    }
+
+    // The content streams of the stamp are shared by the pages
+    auto& contents0 = loaded.GetPages().GetPage(0).GetObject().GetDictionary().MustFindKey("Contents").GetArray();
+    auto& contents1 = loaded.GetPages().GetPage(1).GetObject().GetDictionary().MustFindKey("Contents").GetArray();
+    auto& contents2 = loaded.GetPages().GetPage(2).GetObject().GetDictionary().MustFindKey("Contents").GetArray();
+    REQUIRE(contents0[0].GetReference() == contents1[0].GetReference());
+    REQUIRE(contents1[2].GetReference() == contents2[2].GetReference());
+    REQUIRE(contents0[2].GetReference() != contents1[2].GetReference());
+}
+
+TEST_CASE("testAcroFormFieldLookup")
+{
+    PdfMemDocument doc;
+    auto& page = *doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    for (unsigned i = 0; i < 50; i++)
+    {
+        PdfTextBox textBox(page, PdfRect(10, 10 + i * 10, 100, 10));
+        textBox.SetName(PdfString(utls::Format("text{}", i)));
+    }
+
+    PdfComboBox comboBox(page, PdfRect(200, 10, 100, 10));
+    comboBox.SetName(PdfString("group"));
+    auto child = comboBox.CreateChildField(page, PdfRect(200, 30, 100, 10));
+    child->SetName(PdfString("choice"));
+    auto& choice = static_cast<PdfComboBox&>(*child);
+    choice.InsertItem(PdfString("first"));
+    choice.InsertItem(PdfString("second"));
+
+    auto& form = *doc.GetAcroForm();
+    REQUIRE(form.GetField("text7") != nullptr);
+    REQUIRE(form.GetField("text7")->GetFullName() == "text7");
+    REQUIRE(form.GetField("group.choice")->GetType() == PdfFieldType::ComboBox);
+    REQUIRE(form.GetField("missing") == nullptr);
+
+    // Fields added after the index is built are found
+    PdfTextBox textBox(page, PdfRect(300, 10, 100, 10));
+    textBox.SetName(PdfString("late"));
+    REQUIRE(form.GetField("late") != nullptr);
+
+    // Renamed fields are found with the new name only
+    textBox.SetName(PdfString("renamed"));
+    REQUIRE(form.GetField("late") == nullptr);
+    REQUIRE(form.GetField("renamed") != nullptr);
+
+    form.FillFields({
+        { "text3", PdfString("value3") },
+        { "text42", PdfString("value42") },
+        { "group.choice", PdfString("second") },
+    });
+    REQUIRE(static_cast<PdfTextBox&>(*form.GetField("text3")).GetText() == "value3");
+    REQUIRE(static_cast<PdfTextBox&>(*form.GetField("text42")).GetText() == "value42");
+    REQUIRE(choice.GetSelectedIndex() == 1);
+    REQUIRE(form.GetNeedAppearances());
+
+    ASSERT_THROW_WITH_ERROR_CODE(form.FillFields({ { "missing", PdfString("value") } }), PdfErrorCode::NoObject);
+    ASSERT_THROW_WITH_ERROR_CODE(form.FillFields({ { "group.choice", PdfString("third") } }), PdfErrorCode::ValueOutOfRange);
+}
+
+TEST_CASE("testShareButtonAppearances")
+{
+    PdfMemDocument doc;
+    auto& page = *doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    auto getNormal = [](PdfField& field) -> PdfDictionary& {
+        return field.GetWidgetAnnotation()->GetDictionary().MustFindKey("AP")
+            .GetDictionary().MustFindKey("N").GetDictionary();
+    };
+
+    PdfCheckBox check1(page, PdfRect(10, 10, 12, 12));
+    check1.CreateAppearances();
+    PdfCheckBox check2(page, PdfRect(10, 30, 12, 12));
+    check2.CreateAppearances();
+    PdfCheckBox cross(page, PdfRect(10, 50, 12, 12));
+    cross.CreateAppearances(PdfButtonStyle::Cross);
+    PdfCheckBox larger(page, PdfRect(10, 70, 14, 14));
+    larger.CreateAppearances();
+    PdfRadioButton radio(page, PdfRect(10, 90, 12, 12));
+    radio.CreateAppearances("Choice1", PdfButtonStyle::Check);
+
+    auto& normal1 = getNormal(check1);
+    auto& normal2 = getNormal(check2);
+    REQUIRE(normal1.MustGetKey("Yes").GetReference() == normal2.MustGetKey("Yes").GetReference());
+    REQUIRE(normal1.MustGetKey("Off").GetReference() == normal2.MustGetKey("Off").GetReference());
+    REQUIRE(normal1.MustGetKey("Yes").GetReference() != normal1.MustGetKey("Off").GetReference());
+    REQUIRE(check1.GetWidgetAnnotation()->GetDictionary().MustFindKey("AS").GetName() == "Off");
+
+    // The style, the size and the type select different appearances
+    REQUIRE(getNormal(cross).MustGetKey("Yes").GetReference() != normal1.MustGetKey("Yes").GetReference());
+    REQUIRE(getNormal(cross).MustGetKey("Off").GetReference() != normal1.MustGetKey("Off").GetReference());
+    REQUIRE(getNormal(larger).MustGetKey("Yes").GetReference() != normal1.MustGetKey("Yes").GetReference());
+    REQUIRE(getNormal(radio).MustGetKey("Choice1").GetReference() != normal1.MustGetKey("Yes").GetReference());
+
+    // Removed appearances are created again
+    doc.GetObjects().RemoveObject(normal1.MustGetKey("Yes").GetReference());
+    PdfCheckBox check3(page, PdfRect(10, 110, 12, 12));
+    check3.CreateAppearances();
+    REQUIRE(doc.GetObjects().GetObject(getNormal(check3).MustGetKey("Yes").GetReference()) != nullptr);
+}
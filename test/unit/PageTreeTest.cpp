@@ -39,6 +39,8 @@ static void testGetPages(PdfMemDocument& doc);
 static void testInsert(PdfMemDocument& doc);
 static void testDeleteAll(PdfMemDocument& doc);
 static void testGetPagesReverse(PdfMemDocument& doc);
+static void testBalancedNode(PdfMemDocument& doc, const PdfObject& node, unsigned depth,
+    unsigned maxKidsCount, vector<PdfReference>& pages, vector<unsigned>& depths);
 
 TEST_CASE("testEmptyDoc")
 {
@@ -188,6 +190,83 @@ TEST_CASE("testDeleteAll")
     testDeleteAll(doc);
 }
 
+TEST_CASE("testGetPageByReference")
+{
+    PdfMemDocument doc;
+    PdfPageTest::CreateTestTreeCustom(doc);
+    auto& pages = doc.GetPages();
+    vector<PdfReference> refs;
+    for (unsigned i = 0; i < pages.GetCount(); i++)
+        refs.push_back(pages.GetPage(i).GetObject().GetIndirectReference());
+
+    for (unsigned i = 0; i < refs.size(); i++)
+        REQUIRE(isPageNumber(pages.GetPage(refs[i]), i));
+
+    // The lookup follows the insertions and the deletions
+    auto inserted = pages.InsertPage(10, PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    REQUIRE(&pages.GetPage(inserted->GetObject().GetIndirectReference()) == inserted);
+    REQUIRE(isPageNumber(pages.GetPage(refs[10]), 10));
+    REQUIRE(&pages.GetPage(refs[10]) == &pages.GetPage(11));
+
+    pages.DeletePage(0);
+    ASSERT_THROW_WITH_ERROR_CODE(pages.GetPage(refs[0]), PdfErrorCode::PageNotFound);
+    REQUIRE(&pages.GetPage(inserted->GetObject().GetIndirectReference()) == &pages.GetPage(9));
+    REQUIRE(&pages.GetPage(refs[TEST_NUM_PAGES - 1]) == &pages.GetPage(TEST_NUM_PAGES - 1));
+}
+
+TEST_CASE("testLoadPages")
+{
+    PdfMemDocument doc;
+    PdfPageTest::CreateTestTreeCustom(doc);
+    auto& pages = doc.GetPages();
+    auto& page = pages.GetPage(5);
+
+    // Pages already instantiated are kept
+    pages.LoadPages();
+    REQUIRE(&pages.GetPage(5) == &page);
+    for (unsigned i = 0; i < TEST_NUM_PAGES; i++)
+    {
+        auto& page = pages.GetPage(i);
+        REQUIRE(isPageNumber(page, i));
+        REQUIRE(&pages.GetPage(page.GetObject().GetIndirectReference()) == &page);
+    }
+
+    testDeleteAll(doc);
+}
+
+TEST_CASE("testBalancedTree")
+{
+    PdfMemDocument doc;
+    auto& pages = doc.GetPages();
+    pages.SetMaxKidsCount(4);
+    pages.CreatePages(vector<PdfRect>(50, PdfPage::CreateStandardPageSize(PdfPageSize::A4)));
+    for (unsigned i = 0; i < 20; i++)
+        pages.InsertPage(i * 2, PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    pages.DeletePage(3);
+
+    vector<PdfReference> expected;
+    for (unsigned i = 0; i < pages.GetCount(); i++)
+        expected.push_back(pages.GetPage(i).GetObject().GetIndirectReference());
+
+    // All the pages are at the same depth, in nodes with at most 4 kids
+    vector<PdfReference> refs;
+    vector<unsigned> depths;
+    testBalancedNode(doc, pages.GetObject(), 0, 4, refs, depths);
+    REQUIRE(pages.GetCount() == 69);
+    REQUIRE(refs == expected);
+    REQUIRE(std::all_of(depths.begin(), depths.end(), [&](unsigned depth) { return depth == depths[0]; }));
+
+    // The pages instantiated after the balancing have a correct tree
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device);
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    REQUIRE(loaded.GetPages().GetCount() == 69);
+    for (unsigned i = 0; i < loaded.GetPages().GetCount(); i++)
+        REQUIRE(loaded.GetPages().GetPage(i).GetObject().GetIndirectReference() == expected[i]);
+}
+
 void testGetPages(PdfMemDocument& doc)
 {
     for (unsigned i = 0; i < TEST_NUM_PAGES; i++)
@@ -498,3 +577,27 @@ void appendChildNode(PdfObject& parent, PdfObject& child)
     // 3. Add Parent key to the child
     child.GetDictionary().AddKey("Parent", parent.GetIndirectReference());
 }
+
+void testBalancedNode(PdfMemDocument& doc, const PdfObject& node, unsigned depth,
+    unsigned maxKidsCount, vector<PdfReference>& pages, vector<unsigned>& depths)
+{
+    auto& kids = node.GetDictionary().MustFindKey("Kids").GetArray();
+    REQUIRE(kids.GetSize() <= maxKidsCount);
+    unsigned prevCount = (unsigned)pages.size();
+    for (auto& kid : kids)
+    {
+        auto& kidObj = *doc.GetObjects().GetObject(kid.GetReference());
+        REQUIRE(kidObj.GetDictionary().MustGetKey("Parent").GetReference() == node.GetIndirectReference());
+        if (kidObj.GetDictionary().MustFindKey("Type").GetName() == "Pages")
+        {
+            testBalancedNode(doc, kidObj, depth + 1, maxKidsCount, pages, depths);
+        }
+        else
+        {
+            pages.push_back(kid.GetReference());
+            depths.push_back(depth);
+        }
+    }
+
+    REQUIRE(node.GetDictionary().MustFindKey("Count").GetNumber() == (int64_t)(pages.size() - prevCount));
+}
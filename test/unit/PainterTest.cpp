@@ -7,6 +7,10 @@
  */
 
 #include <PdfTest.h>
+#include "TestUtils.h"
+
+#include <chrono>
+#include <unordered_set>
 
 using namespace std;
 using namespace mm;
@@ -39,6 +43,346 @@ TEST_CASE("testAppend")
     REQUIRE(out == "q\nBT (Hello) Tj ET\nQ\nq\n1 1 1 rg\nQ\n");
 }
 
+TEST_CASE("testNumberFormatting")
+{
+    PdfMemDocument doc;
+    PdfPage* page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+
+    PdfPainter painter;
+    painter.SetCanvas(page);
+    painter.DrawLine(0, 100, 12.5, -0.25);
+    painter.DrawLine(1.0 / 3, 1e7, 0.1234567, 2);
+    painter.FinishDrawing();
+
+    PdfCanvasInputDevice input(doc.GetPages().GetPage(0));
+    string out;
+    StringStreamDevice output(out);
+    input.CopyTo(output);
+
+    REQUIRE(out == "q\n0 100 m 12.5 -0.25 l S\n0.333333 10000000 m 0.123457 2 l S\nQ\n");
+}
+
+TEST_CASE("testOptimizeState")
+{
+    PdfMemDocument doc;
+    PdfPage* page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+
+    PdfPainter painter(PdfPainterFlags::OptimizeState);
+    painter.SetCanvas(page);
+    auto& state = painter.GetGraphicsState();
+
+    // The state is written only when drawing, and only if changed
+    state.SetFillColor(PdfColor(1, 0, 0));
+    state.SetFillColor(PdfColor(0, 1, 0));
+    state.SetLineWidth(2);
+    painter.Rectangle(0, 0, 10, 10);
+    painter.Fill();
+    painter.Rectangle(10, 0, 10, 10);
+    painter.Fill();
+
+    // The state is restored with "Q", and written again if needed
+    painter.Save();
+    state.SetFillColor(PdfColor(0, 0, 1));
+    painter.Rectangle(20, 0, 10, 10);
+    painter.Fill();
+    painter.Restore();
+    REQUIRE(state.GetFillColor() == PdfColor(0, 1, 0));
+    painter.Rectangle(30, 0, 10, 10);
+    painter.Fill();
+    state.SetFillColor(PdfColor(0, 0, 1));
+    painter.Rectangle(40, 0, 10, 10);
+    painter.Fill();
+
+    // Consecutive texts share the text object and the text state
+    painter.GetTextState().SetFont(font, 10);
+    painter.DrawText("A", 100, 100);
+    painter.DrawText("B", 100, 90);
+    painter.DrawLine(0, 0, 10, 10);
+    painter.DrawText("C", 100, 80);
+    painter.FinishDrawing();
+
+    PdfCanvasInputDevice input(doc.GetPages().GetPage(0));
+    string out;
+    StringStreamDevice output(out);
+    input.CopyTo(output);
+
+    REQUIRE(out == "q\n"
+        "2 w\n0 1 0 rg\n0 0 10 10 re\nf\n10 0 10 10 re\nf\n"
+        "q\n0 0 1 rg\n20 0 10 10 re\nf\nQ\n30 0 10 10 re\nf\n0 0 1 rg\n40 0 10 10 re\nf\n"
+        "BT\n/Ft5 10 Tf\n100 100 Td <02> Tj\n0 -10 Td <03> Tj\nET\n"
+        "0 0 m 10 10 l S\n"
+        "BT\n100 80 Td <04> Tj\nET\n"
+        "Q\n");
+}
+
+TEST_CASE("testDrawTextRuns")
+{
+    PdfMemDocument doc;
+    PdfPage* page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+
+    PdfPainter painter;
+    painter.SetCanvas(page);
+    painter.GetTextState().SetFont(font, 10);
+
+    // "A" is 6.67 wide, so "B" is moved by 13.33 in the same array
+    vector<PdfTextRun> runs = {
+        { "A", 100, 100 },
+        { "B", 120, 100 },
+        { "C", 100, 90 },
+        { "A", 80, 90 },
+    };
+    painter.DrawTextRuns(runs);
+    painter.FinishDrawing();
+
+    PdfCanvasInputDevice input(doc.GetPages().GetPage(0));
+    string out;
+    StringStreamDevice output(out);
+    input.CopyTo(output);
+
+    REQUIRE(out == "q\n"
+        "BT\n/Ft5 10 Tf\n"
+        "100 100 Td [<02> -1333 <03>] TJ\n"
+        "0 -10 Td [<04>] TJ\n"
+        "-20 0 Td [<02>] TJ\n"
+        "ET\n"
+        "Q\n");
+}
+
+TEST_CASE("testXObjectFormStamp")
+{
+    PdfMemDocument doc;
+    PdfXObjectForm form(doc, PdfRect(0, 0, 100, 20));
+
+    PdfPainter painter;
+    painter.SetCanvas(&form);
+    painter.Rectangle(0, 0, 100, 20);
+    painter.Stroke();
+    painter.FinishDrawing();
+
+    unsigned objectCount = 0;
+    for (unsigned i = 0; i < 3; i++)
+    {
+        PdfPage* page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        if (i == 0)
+            objectCount = doc.GetObjects().GetObjectCount();
+
+        form.StampOn(*page, 10, 20);
+    }
+
+    for (unsigned i = 0; i < 3; i++)
+    {
+        auto& page = doc.GetPages().GetPage(i);
+        PdfCanvasInputDevice input(page);
+        string out;
+        StringStreamDevice output(out);
+        input.CopyTo(output);
+        REQUIRE(out == "q\nq\n1 0 0 1 10 20 cm\n/" + form.GetIdentifier().GetString() + " Do\nQ\nQ\n");
+        REQUIRE(page.GetResources()->GetResource("XObject", form.GetIdentifier())->GetIndirectReference()
+            == form.GetObject().GetIndirectReference());
+    }
+
+    // The form is not copied: every page adds only
+    // itself, its contents array and its contents stream
+    REQUIRE(doc.GetObjects().GetObjectCount() == objectCount + 2 + 2 * 3);
+    REQUIRE_THROWS_AS(form.StampOn(form), PdfError);
+}
+
+TEST_CASE("testFontResourcesOnNextCanvas")
+{
+    // The text state is kept when the canvas changes
+    PdfMemDocument doc;
+    auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+    PdfPainter painter;
+    for (unsigned i = 0; i < 2; i++)
+    {
+        auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        painter.SetCanvas(page);
+        painter.GetTextState().SetFont(font, 10);
+        painter.DrawText("Hello", 50, 50);
+        painter.FinishDrawing();
+        REQUIRE(page->GetFromResources("Font", font->GetIdentifier()) == &font->GetObject());
+    }
+}
+
+TEST_CASE("testPaintPagesConcurrently")
+{
+    constexpr unsigned PageCount = 16;
+    charbuff buffer;
+    {
+        // The pages share their resources
+        PdfMemDocument doc;
+        auto helvetica = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+        auto resources = doc.GetObjects().CreateDictionaryObject();
+        auto& fonts = resources->GetDictionary().AddKey("Font", PdfDictionary()).GetDictionary();
+        fonts.AddKeyIndirect(helvetica->GetIdentifier(), &helvetica->GetObject());
+        for (unsigned i = 0; i < PageCount; i++)
+        {
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            page->GetDictionary().AddKeyIndirect("Resources", resources);
+        }
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    doc.SetExecutor(std::make_shared<PdfThreadPool>(4));
+    auto sharedResources = doc.GetPages().GetPage(0).GetDictionary().GetKey("Resources")->GetReference();
+    auto font = doc.GetFontManager().GetFont("LiberationSans");
+    REQUIRE(font != nullptr);
+    doc.PaintPages({ }, [&](PdfPage& page, unsigned index)
+    {
+        // Every page creates a graphics state of its own
+        PdfExtGState extGState(doc);
+        extGState.SetFillOpacity(index / (double)PageCount);
+
+        PdfPainter painter;
+        painter.SetCanvas(&page);
+        painter.SetExtGState(extGState);
+        painter.GetTextState().SetFont(font, 12);
+        painter.DrawText(utls::Format("Page {} \xC3\x84\xC3\xB6\xC3\x9F {}", index, (char)('A' + index)), 100, 700);
+        painter.FinishDrawing();
+    }, 4);
+
+    unordered_set<PdfReference> references;
+    for (auto obj : doc.GetObjects())
+        REQUIRE(references.insert(obj->GetIndirectReference()).second);
+
+    auto& shared = doc.GetObjects().MustGetObject(sharedResources).GetDictionary();
+    REQUIRE(shared.GetSize() == 1);
+    REQUIRE(shared.MustFindKey("Font").GetDictionary().GetSize() == 1);
+    for (unsigned i = 0; i < PageCount; i++)
+    {
+        auto& page = doc.GetPages().GetPage(i);
+        REQUIRE(page.GetDictionary().MustFindKey("Resources").GetDictionary().GetSize() > 0);
+        REQUIRE(!page.GetDictionary().GetKey("Resources")->IsReference());
+        REQUIRE(page.GetResources()->GetResource("Font", font->GetIdentifier()) == &font->GetObject());
+        auto& extGStates = page.GetResources()->GetDictionary().MustFindKey("ExtGState").GetDictionary();
+        REQUIRE(extGStates.GetSize() == 1);
+        for (auto& pair : extGStates.GetIndirectIterator())
+            REQUIRE(pair.second->GetDictionary().MustFindKey("ca").GetReal() == i / (double)PageCount);
+    }
+
+    charbuff output;
+    BufferStreamDevice device(output);
+    doc.Save(device);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(output);
+    auto extracted = loaded.ExtractText();
+    REQUIRE(extracted.size() == PageCount);
+    for (unsigned i = 0; i < PageCount; i++)
+    {
+        REQUIRE(extracted[i].size() == 1);
+        REQUIRE(extracted[i][0].Text == utls::Format("Page {} \xC3\x84\xC3\xB6\xC3\x9F {}", i, (char)('A' + i)));
+    }
+}
+
+TEST_CASE("testShadingCache")
+{
+    PdfMemDocument doc;
+    PdfShadingCache cache(doc);
+
+    auto& shading = cache.GetAxialShading(0, 0, 100, 0, PdfColor(1, 0, 0), PdfColor(0, 0, 1));
+    unsigned objectCount = doc.GetObjects().GetSize();
+    REQUIRE(&cache.GetAxialShading(0, 0, 100, 0, PdfColor(1, 0, 0), PdfColor(0, 0, 1)) == &shading);
+    REQUIRE(doc.GetObjects().GetSize() == objectCount);
+
+    // The function is shared between shadings with different coordinates
+    auto& other = cache.GetRadialShading(0, 0, 0, 0, 0, 50, PdfColor(1, 0, 0), PdfColor(0, 0, 1));
+    REQUIRE(&other != &shading);
+    REQUIRE(other.GetObject().GetDictionary().MustFindKey("Shading").GetDictionary().GetKey("Function")->GetReference()
+        == shading.GetObject().GetDictionary().MustFindKey("Shading").GetDictionary().GetKey("Function")->GetReference());
+
+    PdfGradientStop stops[] = {
+        { 0, PdfColor(1, 0, 0) },
+        { 0.5, PdfColor(0, 1, 0) },
+        { 1, PdfColor(0, 0, 1) },
+    };
+    auto& gradient = cache.GetAxialShading(0, 0, 100, 0, stops);
+    objectCount = doc.GetObjects().GetSize();
+    REQUIRE(&cache.GetAxialShading(0, 0, 100, 0, stops) == &gradient);
+    REQUIRE(doc.GetObjects().GetSize() == objectCount);
+
+    auto& function = gradient.GetObject().GetDictionary().MustFindKey("Shading").GetDictionary().MustFindKey("Function");
+    REQUIRE(function.GetDictionary().MustFindKey("FunctionType").GetNumber() == 0);
+    REQUIRE(function.GetDictionary().MustFindKey("Size").GetArray()[0].GetNumber() == 256);
+    REQUIRE(function.GetDictionary().MustFindKey("Range").GetArray().GetSize() == 6);
+
+    PdfSampledFunction sampled(doc, stops, 5);
+    auto samples = sampled.GetObject().MustGetStream().GetFilteredCopy();
+    REQUIRE(string_view(samples.data(), samples.size()) == string_view("\xFF\x00\x00\x80\x80\x00\x00\xFF\x00\x00\x80\x80\x00\x00\xFF", 15));
+
+    PdfGradientStop mixed[] = {
+        { 0, PdfColor(1, 0, 0) },
+        { 1, PdfColor(0.5) },
+    };
+    ASSERT_THROW_WITH_ERROR_CODE(cache.GetAxialShading(0, 0, 100, 0, mixed), PdfErrorCode::InvalidDataType);
+}
+
+TEST_CASE("testCanvasInputDeviceStreams")
+{
+    PdfMemDocument doc;
+    PdfPage* page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+
+    // Content large enough to be decoded in several chunks
+    string large;
+    for (unsigned i = 0; i < 20000; i++)
+        large.append(utls::Format("{} {} m {} {} l S\n", i, i * 2, i * 3, i * 4));
+
+    auto& streams = page->GetOrCreateContents().GetObject().GetArray();
+    for (auto content : { string_view(large), string_view(), string_view("BT (Hello) Tj ET") })
+    {
+        auto& streamObj = *doc.GetObjects().CreateDictionaryObject();
+        streamObj.GetOrCreateStream().Set(content);
+        streams.Add(streamObj.GetIndirectReference());
+    }
+
+    auto& firstObj = *doc.GetObjects().GetObject(streams[0].GetReference());
+    REQUIRE(firstObj.GetDictionary().HasKey("Filter"));
+    auto& firstStream = *firstObj.GetStream();
+    REQUIRE(firstStream.GetLength() < large.size());
+
+    PdfObjectInputStream stream(firstStream);
+    string out;
+    StringStreamDevice output(out);
+    stream.CopyTo(output);
+    REQUIRE(out == large);
+    REQUIRE(stream.Eof());
+    REQUIRE(stream.GetPosition() == large.size());
+
+    PdfCanvasInputDevice input(*page);
+    string canvasOut;
+    StringStreamDevice canvasOutput(canvasOut);
+    input.CopyTo(canvasOutput);
+    REQUIRE(canvasOut == large + "\nBT (Hello) Tj ET");
+}
+
+TEST_CASE("benchmarkContentStreamWrite", "[.]")
+{
+    auto start = chrono::steady_clock::now();
+    PdfMemDocument doc;
+    for (unsigned i = 0; i < 20; i++)
+    {
+        PdfPage* page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        PdfPainter painter;
+        painter.SetCanvas(page);
+        for (unsigned j = 0; j < 20000; j++)
+            painter.DrawLine(j * 0.0137, j * 0.0291, 595.276 - j * 0.0173, 841.89 - j * 0.0219);
+
+        painter.FinishDrawing();
+    }
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device);
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+    WARN("Painted and written " << buffer.size() << " bytes in " << elapsed.count() << " ms");
+}
+
 void CompareStreamContent(PdfObjectStream& stream, const string_view& expected)
 {
     charbuff buffer;
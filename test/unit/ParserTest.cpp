@@ -18,18 +18,25 @@
        in those situations
 */
 
+#include <atomic>
 #include <limits>
 
+#include <set>
 #include <sstream>
+#include <thread>
 
 #include <PdfTest.h>
 
+#include "TestUtils.h"
+
 using namespace std;
 using namespace mm;
 
 static string generateXRefEntries(size_t count);
 static bool canOutOfMemoryKillUnitTests();
 static void testReadXRefSubsection();
+static void testParallelParsing(const string_view& buffer);
+static string generateLinearizedDocument(bool withCatalog);
 
 // this value is from Table C.1 in Appendix C.2 Architectural Limits in PDF 32000-1:2008
 // on 32-bit systems sizeof(PdfParser::TXRefEntry)=16 => max size of m_offsets=16*8,388,607 = 134 MB
@@ -1803,6 +1810,630 @@ TEST_CASE("testReadObjects")
     }
 }
 
+TEST_CASE("testParallelReadObjects")
+{
+    constexpr unsigned objectCount = 500;
+    string docbuff = "%PDF-1.4\n";
+    vector<size_t> offsets;
+    for (unsigned i = 1; i <= objectCount; i++)
+    {
+        offsets.push_back(docbuff.size());
+        docbuff.append(utls::Format("{} 0 obj\n<< /Index {} /Name /Name{} /Array [ (String {}) {}.5 {} 0 R ] >>\nendobj\n",
+            i, i, i, i, i, i == objectCount ? 1 : i + 1));
+    }
+
+    size_t xrefOffset = docbuff.size();
+    docbuff.append(utls::Format("xref\n0 {}\n0000000000 65535 f\r\n", objectCount + 1));
+    for (size_t offset : offsets)
+        docbuff.append(utls::Format("{:010} 00000 n\r\n", offset));
+
+    docbuff.append(utls::Format("trailer\n<< /Size {} >>\nstartxref\n{}\n%%EOF\n",
+        objectCount + 1, xrefOffset));
+
+    testParallelParsing(docbuff);
+}
+
+TEST_CASE("testParallelReadObjectStreams")
+{
+    // Write uncompressed object streams, indexed by an uncompressed xref stream
+    constexpr unsigned streamCount = 20;
+    constexpr unsigned objectsPerStream = 30;
+    constexpr unsigned xrefObjNo = streamCount * (objectsPerStream + 1) + 1;
+    string docbuff = "%PDF-1.5\n";
+    vector<size_t> offsets;
+    for (unsigned i = 0; i < streamCount; i++)
+    {
+        string header;
+        string objects;
+        for (unsigned j = 0; j < objectsPerStream; j++)
+        {
+            unsigned objNo = streamCount + 1 + i * objectsPerStream + j;
+            header.append(utls::Format("{} {} ", objNo, objects.size()));
+            objects.append(utls::Format("<< /Index {} /Array [ (String {}) {}.5 ] >> ", objNo, objNo, objNo));
+        }
+
+        offsets.push_back(docbuff.size());
+        docbuff.append(utls::Format("{} 0 obj\n<< /Type /ObjStm /N {} /First {} /Length {} >>\nstream\n",
+            i + 1, objectsPerStream, header.size(), header.size() + objects.size()));
+        docbuff.append(header).append(objects).append("\nendstream\nendobj\n");
+    }
+
+    auto appendEntry = [](string& buff, unsigned type, unsigned field2, unsigned field3)
+    {
+        buff.push_back((char)type);
+        for (int shift = 24; shift >= 0; shift -= 8)
+            buff.push_back((char)((field2 >> shift) & 0xFF));
+        buff.push_back((char)((field3 >> 8) & 0xFF));
+        buff.push_back((char)(field3 & 0xFF));
+    };
+
+    size_t xrefOffset = docbuff.size();
+    string xref;
+    appendEntry(xref, 0, 0, 0xFFFF);
+    for (size_t offset : offsets)
+        appendEntry(xref, 1, (unsigned)offset, 0);
+    for (unsigned i = 0; i < streamCount; i++)
+    {
+        for (unsigned j = 0; j < objectsPerStream; j++)
+            appendEntry(xref, 2, i + 1, j);
+    }
+    appendEntry(xref, 1, (unsigned)xrefOffset, 0);
+
+    docbuff.append(utls::Format("{} 0 obj\n<< /Type /XRef /Size {} /W [ 1 4 2 ] /Length {} >>\nstream\n",
+        xrefObjNo, xrefObjNo + 1, xref.size()));
+    docbuff.append(xref).append(utls::Format("\nendstream\nendobj\nstartxref\n{}\n%%EOF\n", xrefOffset));
+
+    testParallelParsing(docbuff);
+}
+
+TEST_CASE("testTrailingGarbage")
+{
+    string docbuff = "%PDF-1.4\n";
+    vector<size_t> offsets;
+    for (unsigned i = 1; i <= 3; i++)
+    {
+        offsets.push_back(docbuff.size());
+        docbuff.append(utls::Format("{} 0 obj\n<< /Index {} >>\nendobj\n", i, i));
+    }
+
+    size_t xrefOffset = docbuff.size();
+    docbuff.append("xref\n0 4\n0000000000 65535 f\r\n");
+    for (size_t offset : offsets)
+        docbuff.append(utls::Format("{:010} 00000 n\r\n", offset));
+
+    docbuff.append(utls::Format("trailer\n<< /Size 4 >>\nstartxref\n{}\n%%EOF\n", xrefOffset));
+
+    // Add more garbage than the size of the blocks read
+    // when searching the EOF marker in non contiguous devices
+    for (unsigned i = 0; i < 20000; i++)
+        docbuff.append("%EOF ");
+
+    auto test = [](InputStreamDevice& device)
+    {
+        PdfIndirectObjectList objects;
+        PdfParser parser(objects);
+        parser.Parse(device, false);
+        REQUIRE(objects.GetSize() == 3);
+        REQUIRE(objects.MustGetObject(PdfReference(3, 0)).GetDictionary().FindKeyAs<int64_t>("Index") == 3);
+    };
+
+    SpanStreamDevice device(docbuff);
+    test(device);
+
+    istringstream stream(docbuff);
+    StandardStreamDevice stdDevice(stream);
+    test(stdDevice);
+}
+
+TEST_CASE("testParseLinearizedFirstPage")
+{
+    auto docbuff = generateLinearizedDocument(false);
+    SpanStreamDevice device(docbuff);
+    PdfIndirectObjectList objects;
+    PdfParser parser(objects);
+    REQUIRE(parser.ParseFirstPage(device, false));
+    REQUIRE(parser.HasDeferredXRef());
+    REQUIRE(parser.GetFirstPageObjectNumber() == 6);
+
+    // Only the objects of the first-page section are read
+    auto page = objects.GetObject(PdfReference(6, 0));
+    REQUIRE(page != nullptr);
+    REQUIRE(objects.GetObject(PdfReference(1, 0)) == nullptr);
+
+    parser.ParseDeferredXRef(device);
+    REQUIRE(!parser.HasDeferredXRef());
+    REQUIRE(objects.GetSize() == 8);
+    REQUIRE(objects.GetObject(PdfReference(6, 0)) == page);
+    REQUIRE(objects.MustGetObject(PdfReference(3, 0)).GetDictionary().FindKeyAs<int64_t>("Index") == 3);
+
+    // Non linearized files are fully read
+    PdfIndirectObjectList objects2;
+    PdfParser parser2(objects2);
+    SpanStreamDevice device2("%PDF-1.4\n1 0 obj\n<< /Index 1 >>\nendobj\n"
+        "xref\n0 2\n0000000000 65535 f\r\n0000000009 00000 n\r\n"
+        "trailer\n<< /Size 2 >>\nstartxref\n39\n%%EOF\n");
+    REQUIRE(!parser2.ParseFirstPage(device2, false));
+    REQUIRE(!parser2.HasDeferredXRef());
+    REQUIRE(objects2.GetSize() == 1);
+}
+
+TEST_CASE("testLoadLinearizedFirstPage")
+{
+    auto docbuff = generateLinearizedDocument(true);
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(docbuff, { }, PdfLoadOptions::FirstPageOnly);
+    auto& pages = doc.GetPages();
+    REQUIRE(pages.GetCount() == 2);
+    REQUIRE(pages.GetPage(0).GetMediaBox().GetWidth() == 100);
+
+    // The second page is read from the deferred main section
+    REQUIRE(pages.GetPage(1).GetMediaBox().GetWidth() == 200);
+    REQUIRE(doc.GetObjects().GetSize() == 8);
+}
+
+TEST_CASE("testParserStats")
+{
+    string docbuff = "%PDF-1.4\n";
+    vector<size_t> offsets;
+    for (unsigned i = 1; i <= 3; i++)
+    {
+        offsets.push_back(docbuff.size());
+        docbuff.append(utls::Format("{} 0 obj\n<< /Index {} >>\nendobj\n", i, i));
+    }
+
+    size_t xrefOffset = docbuff.size();
+    docbuff.append("xref\n0 4\n0000000000 65535 f\r\n");
+    for (size_t offset : offsets)
+        docbuff.append(utls::Format("{:010} 00000 n\r\n", offset));
+
+    docbuff.append(utls::Format("trailer\n<< /Size 4 >>\nstartxref\n{}\n%%EOF\n", xrefOffset));
+
+    SpanStreamDevice device(docbuff);
+    PdfIndirectObjectList objects;
+    PdfParser parser(objects);
+    REQUIRE(parser.GetStats() == nullptr);
+    parser.SetCollectStats(true);
+    parser.Parse(device, false);
+
+    auto stats = parser.GetStats();
+    REQUIRE(stats != nullptr);
+    REQUIRE(stats->ObjectCount == 3);
+    REQUIRE(stats->XRefSectionCount == 1);
+    REQUIRE(stats->BrokenObjectCount == 0);
+    REQUIRE(stats->ObjectBytesRead == 3 * string_view("1 0 obj\n<< /Index 1 >>\nendobj").size());
+    REQUIRE(stats->XRefBytesRead == string_view("xref\n0 4\n").size() + 4 * 20
+        + string_view("trailer\n<< /Size 4 >>").size());
+    REQUIRE(stats->ReadDocumentStructureTime >= stats->ReadXRefContentsTime);
+    REQUIRE(stats->ReadObjectsTime.count() > 0);
+}
+
+TEST_CASE("testShadowedXRefEntries")
+{
+    string docbuff = "%PDF-1.4\n";
+    vector<size_t> offsets;
+    for (unsigned i = 1; i <= 3; i++)
+    {
+        offsets.push_back(docbuff.size());
+        docbuff.append(utls::Format("{} 0 obj\n<< /Index {} >>\nendobj\n", i, i));
+    }
+
+    size_t prevOffset = docbuff.size();
+    docbuff.append(utls::Format("xref\n0 1\n0000000000 65535 f\r\n1 2\n{:010} 00000 n\r\n{:010} 00000 n\r\n"
+        "3 1\n{:010} 00000 n\r\n", offsets[0], offsets[1], offsets[2]));
+    docbuff.append("trailer\n<< /Size 4 >>\nstartxref\n0\n%%EOF\n");
+
+    // Objects 1 and 2 are updated with an incremental
+    // update, shadowing the whole older subsection
+    for (unsigned i = 1; i <= 2; i++)
+    {
+        offsets[i - 1] = docbuff.size();
+        docbuff.append(utls::Format("{} 0 obj\n<< /Index {} >>\nendobj\n", i, i + 10));
+    }
+
+    size_t xrefOffset = docbuff.size();
+    docbuff.append(utls::Format("xref\n1 2\n{:010} 00000 n\r\n{:010} 00000 n\r\n", offsets[0], offsets[1]));
+    docbuff.append(utls::Format("trailer\n<< /Size 4 /Prev {} >>\nstartxref\n{}\n%%EOF\n", prevOffset, xrefOffset));
+
+    SpanStreamDevice device(docbuff);
+    PdfIndirectObjectList objects;
+    PdfParser parser(objects);
+    parser.SetCollectStats(true);
+    parser.Parse(device, false);
+
+    auto stats = parser.GetStats();
+    REQUIRE(stats->XRefSectionCount == 2);
+    REQUIRE(stats->ShadowedXRefEntryCount == 2);
+    REQUIRE(objects.MustGetObject(PdfReference(1, 0)).GetDictionary().MustFindKey("Index").GetNumber() == 11);
+    REQUIRE(objects.MustGetObject(PdfReference(2, 0)).GetDictionary().MustFindKey("Index").GetNumber() == 12);
+    REQUIRE(objects.MustGetObject(PdfReference(3, 0)).GetDictionary().MustFindKey("Index").GetNumber() == 3);
+}
+
+TEST_CASE("testRebuildBrokenXRef")
+{
+    string docbuff = "%PDF-1.4\n";
+    vector<size_t> offsets;
+    for (unsigned i = 1; i <= 3; i++)
+    {
+        offsets.push_back(docbuff.size());
+        docbuff.append(utls::Format("{} 0 obj\n<< /Index {} >>\nendobj\n", i, i));
+    }
+
+    // Object 2 is updated with a following revision
+    offsets[1] = docbuff.size();
+    docbuff.append("2 0 obj\n<< /Index 4 >>\nendobj\n");
+
+    // The offsets in the xref table are all wrong
+    size_t xrefOffset = docbuff.size();
+    docbuff.append("xref\n0 4\n0000000000 65535 f\r\n");
+    for (size_t offset : offsets)
+        docbuff.append(utls::Format("{:010} 00000 n\r\n", offset + 3));
+
+    docbuff.append(utls::Format("trailer\n<< /Size 4 >>\nstartxref\n{}\n%%EOF\n", xrefOffset));
+
+    {
+        SpanStreamDevice device(docbuff);
+        PdfIndirectObjectList objects;
+        PdfParser parser(objects);
+        REQUIRE_THROWS(parser.Parse(device, false));
+    }
+
+    auto checkObjects = [&](InputStreamDevice& device)
+    {
+        PdfIndirectObjectList objects;
+        PdfParser parser(objects);
+        parser.SetRebuildBrokenXRef(true);
+        parser.Parse(device, false);
+        REQUIRE(parser.IsXRefRebuilt());
+        REQUIRE(parser.GetTrailer().GetDictionary().FindKeyAs<int64_t>("Size") == 4);
+        REQUIRE(objects.GetSize() == 3);
+        for (unsigned i = 1; i <= 3; i++)
+        {
+            auto obj = objects.GetObject(PdfReference(i, 0));
+            REQUIRE(obj != nullptr);
+            REQUIRE(obj->GetDictionary().FindKeyAs<int64_t>("Index") == (i == 2 ? 4 : i));
+        }
+    };
+
+    SpanStreamDevice device(docbuff);
+    checkObjects(device);
+
+    // Files without the xref section and the startxref
+    // keyword are rebuilt as well, also reading in blocks
+    docbuff.resize(xrefOffset);
+    docbuff.append("trailer\n<< /Size 4 >>\n");
+    auto testPath = TestUtils::GetTestOutputFilePath("testRebuildBrokenXRef.pdf");
+    {
+        FileStreamDevice output(testPath, FileMode::Create);
+        output.Write(docbuff);
+    }
+    FileStreamDevice input(testPath);
+    checkObjects(input);
+}
+
+TEST_CASE("testWriteXRefFreeEntries")
+{
+    PdfMemDocument doc;
+    vector<PdfReference> refs;
+    for (unsigned i = 0; i < 6; i++)
+    {
+        auto obj = doc.GetObjects().CreateDictionaryObject();
+        obj->GetDictionary().AddKey("Index", (int64_t)i);
+        refs.push_back(obj->GetIndirectReference());
+    }
+
+    // The free entries are written in a linked list, from the entry of object 0
+    doc.GetObjects().RemoveObject(refs[4]);
+    doc.GetObjects().RemoveObject(refs[1]);
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+    auto xrefOffset = buffer.rfind("xref\n0 ");
+    REQUIRE(xrefOffset != string::npos);
+    REQUIRE(buffer.find(utls::Format("{:010} 65535 f", refs[1].ObjectNumber()), xrefOffset) != string::npos);
+    REQUIRE(buffer.find(utls::Format("{:010} 00001 f", refs[4].ObjectNumber()), xrefOffset) != string::npos);
+    REQUIRE(buffer.find("0000000000 00001 f", xrefOffset) != string::npos);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    for (unsigned i = 0; i < refs.size(); i++)
+    {
+        auto obj = loaded.GetObjects().GetObject(refs[i]);
+        if (i == 1 || i == 4)
+        {
+            REQUIRE(obj == nullptr);
+        }
+        else
+        {
+            REQUIRE(obj != nullptr);
+            REQUIRE(obj->GetDictionary().FindKeyAs<int64_t>("Index") == i);
+        }
+    }
+}
+
+TEST_CASE("testDocumentInfoProbe")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        for (unsigned i = 0; i < 3; i++)
+            doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfDocumentInfoProbe probe;
+    probe.LoadFromBuffer(buffer);
+    REQUIRE(probe.GetPageCount() == 3);
+    REQUIRE(probe.GetPdfVersion() == PdfVersionDefault);
+    REQUIRE(!probe.IsEncrypted());
+    REQUIRE(probe.GetInfo() != nullptr);
+    REQUIRE(probe.GetInfo()->HasKey("Producer"));
+    REQUIRE(probe.GetInfo()->HasKey("CreationDate"));
+}
+
+TEST_CASE("testMetadataUpdater")
+{
+    auto check = [](PdfSaveOptions opts)
+    {
+        charbuff buffer;
+        {
+            PdfMemDocument doc;
+            doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            doc.GetTrailer().GetDictionary().MustFindKey("Info").GetDictionary().AddKey("Title", PdfString("Original"));
+            BufferStreamDevice device(buffer);
+            doc.Save(device, opts);
+        }
+
+        charbuff original = buffer;
+        PdfMetadataUpdater updater;
+        updater.LoadFromBuffer(buffer);
+        REQUIRE(updater.GetInfo().MustFindKey("Title").GetString().GetString() == "Original");
+        REQUIRE(updater.GetMetadataPacket() == nullptr);
+        REQUIRE(!updater.IsDirty());
+
+        updater.GetInfo().AddKey("Title", PdfString("Updated"));
+        updater.GetInfo().AddKey("Keywords", PdfString("one, two"));
+        updater.SetMetadataPacket(string_view("<x:xmpmeta xmlns:x=\"adobe:ns:meta/\"/>"));
+        REQUIRE(updater.IsDirty());
+        {
+            BufferStreamDevice device(buffer);
+            updater.SaveUpdate(device, PdfSaveOptions::NoModifyDateUpdate);
+        }
+
+        // The update is appended, and holds just the modified objects
+        REQUIRE(!updater.IsDirty());
+        REQUIRE(buffer.size() > original.size());
+        REQUIRE(buffer.substr(0, original.size()) == original);
+        REQUIRE(buffer.size() - original.size() < 1024);
+
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(buffer);
+        REQUIRE(doc.GetMetadata().GetTitle()->GetString() == "Updated");
+        REQUIRE(doc.GetMetadata().GetKeywordsRaw()->GetString() == "one, two");
+        REQUIRE(doc.GetPages().GetCount() == 1);
+        auto metadata = doc.GetCatalog().GetDictionary().FindKey("Metadata");
+        REQUIRE(metadata != nullptr);
+        REQUIRE(metadata->MustGetStream().GetFilteredCopy() == "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\"/>");
+
+        // A further update is chained to the previous one
+        updater.GetInfo().AddKey("Title", PdfString("Again"));
+        {
+            BufferStreamDevice device(buffer);
+            updater.SaveUpdate(device, PdfSaveOptions::NoModifyDateUpdate);
+        }
+
+        PdfMetadataUpdater reloaded;
+        reloaded.LoadFromBuffer(buffer);
+        REQUIRE(reloaded.GetInfo().MustFindKey("Title").GetString().GetString() == "Again");
+        REQUIRE(reloaded.GetInfo().MustFindKey("Keywords").GetString().GetString() == "one, two");
+        REQUIRE(*reloaded.GetMetadataPacket() == *updater.GetMetadataPacket());
+    };
+
+    check(PdfSaveOptions::NoModifyDateUpdate);
+    check(PdfSaveOptions::NoModifyDateUpdate | PdfSaveOptions::CompressObjects);
+}
+
+TEST_CASE("testObjectReader")
+{
+    charbuff buffer;
+    PdfReference streamRef;
+    {
+        PdfMemDocument doc;
+        for (unsigned i = 0; i < 3; i++)
+            doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto obj = doc.GetObjects().CreateDictionaryObject("Test");
+        obj->GetOrCreateStream().Set("stream data");
+        streamRef = obj->GetIndirectReference();
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::CompressObjects);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    charbuff streamData = doc.GetObjects().MustGetObject(streamRef).MustGetStream().GetFilteredCopy();
+
+    auto checkObjects = [&](PdfObjectReaderMode mode)
+    {
+        set<PdfReference> refs;
+        unsigned compressedCount = 0;
+        bool streamFound = false;
+        PdfObjectReader reader;
+        bool completed = reader.ReadFromBuffer(buffer, [&](const PdfObjectReaderEntry& entry)
+        {
+            refs.insert(entry.Reference);
+            if (entry.ObjectStreamNumber != 0)
+                compressedCount++;
+
+            if (entry.Reference == streamRef)
+            {
+                // The stream data is located without reading it
+                REQUIRE(entry.HasStream);
+                REQUIRE(entry.StreamLength > 0);
+                REQUIRE(string_view(buffer).substr(entry.StreamOffset + entry.StreamLength).find("endstream") <= 2);
+                REQUIRE(entry.Object->MustGetStream().GetFilteredCopy() == streamData);
+                streamFound = true;
+            }
+            return true;
+        }, mode);
+
+        REQUIRE(completed);
+        REQUIRE(streamFound);
+        REQUIRE(compressedCount != 0);
+        for (auto obj : doc.GetObjects())
+            REQUIRE(refs.find(obj->GetIndirectReference()) != refs.end());
+    };
+
+    checkObjects(PdfObjectReaderMode::XRef);
+    checkObjects(PdfObjectReaderMode::Scan);
+
+    // The callback stops the reading
+    unsigned count = 0;
+    PdfObjectReader reader;
+    REQUIRE(!reader.ReadFromBuffer(buffer, [&](const PdfObjectReaderEntry&)
+    {
+        count++;
+        return false;
+    }));
+    REQUIRE(count == 1);
+    REQUIRE(reader.GetPdfVersion() == PdfVersion::V1_5);
+    REQUIRE(!reader.IsEncrypted());
+}
+
+TEST_CASE("testLazyNestedArrays")
+{
+    // The large nested array contains brackets in comments
+    // and strings, that must not end the array
+    string widths;
+    for (unsigned i = 0; i < 2000; i++)
+        widths.append(utls::Format("{} ", i));
+
+    string docbuff = "%PDF-1.4\n";
+    size_t offset = docbuff.size();
+    docbuff.append(utls::Format("1 0 obj\n<< /Small [ 1 2 ] /Widths [ {}[ 3 (a]\\)b) ] % ]\n(c)] /Next 5 >>\nendobj\n", widths));
+    size_t xrefOffset = docbuff.size();
+    docbuff.append(utls::Format("xref\n0 2\n0000000000 65535 f\r\n{:010} 00000 n\r\n", offset));
+    docbuff.append(utls::Format("trailer\n<< /Size 2 >>\nstartxref\n{}\n%%EOF\n", xrefOffset));
+
+    auto checkObject = [](InputStreamDevice& device)
+    {
+        PdfIndirectObjectList objects;
+        PdfParser parser(objects);
+        parser.Parse(device, true);
+        auto& dict = objects.MustGetObject(PdfReference(1, 0)).GetDictionary();
+        REQUIRE(dict.FindKeyAs<int64_t>("Next") == 5);
+        REQUIRE(dict.MustFindKey("Small").GetArray().GetSize() == 2);
+
+        // Reading the dictionary keys moved the device
+        // far from the array, that is read on access
+        device.Seek(0);
+        auto& widths = dict.MustFindKey("Widths").GetArray();
+        REQUIRE(widths.GetSize() == 2002);
+        REQUIRE(widths[1999].GetNumber() == 1999);
+        REQUIRE(widths[2000].GetArray()[1].GetString().GetString() == "a])b");
+        REQUIRE(widths[2001].GetString().GetString() == "c");
+        REQUIRE(widths[0].GetParent() == &widths);
+        REQUIRE(!objects.MustGetObject(PdfReference(1, 0)).IsDirty());
+        REQUIRE(device.GetPosition() == 0);
+    };
+
+    SpanStreamDevice device(docbuff);
+    checkObject(device);
+
+    auto testPath = TestUtils::GetTestOutputFilePath("testLazyNestedArrays.pdf");
+    {
+        FileStreamDevice output(testPath, FileMode::Create);
+        output.Write(docbuff);
+    }
+    FileStreamDevice input(testPath);
+    checkObject(input);
+}
+
+TEST_CASE("testMemoryBudget")
+{
+    constexpr unsigned PageCount = 20;
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        for (unsigned i = 0; i < PageCount; i++)
+        {
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            auto contents = doc.GetObjects().CreateDictionaryObject();
+            string data;
+            for (unsigned j = 0; j < 200; j++)
+                data.append(utls::Format("{} {} m {} {} l S\n", i, j, j, i));
+            contents->GetOrCreateStream().Set(data, { });
+            page->GetObject().GetDictionary().AddKeyIndirect("Contents", contents);
+        }
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    constexpr size_t Budget = 16384;
+    doc.SetMemoryBudget(Budget);
+    REQUIRE(doc.GetMemoryBudget() == Budget);
+
+    auto checkPage = [&](unsigned i)
+    {
+        auto& page = doc.GetPages().GetPage(i);
+        auto& contents = page.GetObject().GetDictionary().MustFindKey("Contents");
+        auto data = contents.MustGetStream().GetFilteredCopy();
+        REQUIRE(data.size() > 0);
+        REQUIRE(data.substr(0, data.find(' ')) == std::to_string(i));
+        return contents.GetIndirectReference();
+    };
+
+    auto firstContents = checkPage(0);
+    for (unsigned i = 1; i < PageCount; i++)
+        checkPage(i);
+
+    // The objects of the first pages were freed and
+    // are read again from the device when accessed
+    REQUIRE(!doc.GetObjects().MustGetObject(firstContents).IsDelayedLoadDone());
+    (void)doc.GetPages().GetPage(0);
+    REQUIRE(doc.GetObjects().GetLoadedMemory() <= Budget);
+    checkPage(0);
+}
+
+TEST_CASE("testMemoryBudgetPageResources")
+{
+    constexpr unsigned PageCount = 10;
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        for (unsigned i = 0; i < PageCount; i++)
+        {
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            PdfArray procSet;
+            procSet.Add(PdfName("PDF"));
+            PdfDictionary resources;
+            resources.AddKey("ProcSet", procSet);
+            page->GetObject().GetDictionary().AddKey("Resources", resources);
+        }
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    doc.SetMemoryBudget(1);
+    auto& page = doc.GetPages().GetPage(0);
+    REQUIRE(page.GetResources() != nullptr);
+    for (unsigned i = 1; i < PageCount; i++)
+        (void)doc.GetPages().GetPage(i);
+
+    // The objects of the cached pages are not freed, as the pages
+    // reference their data. The budget is applied twice, as the
+    // objects accessed since the previous time are kept
+    doc.GetObjects().ApplyMemoryBudget();
+    doc.GetObjects().ApplyMemoryBudget();
+    REQUIRE(page.GetDictionary().GetKey("Resources") == &page.GetResources()->GetObject());
+    REQUIRE(page.GetResources()->GetDictionary().MustFindKey("ProcSet").GetArray().size() == 1);
+    REQUIRE(&doc.GetPages().GetPage(0) == &page);
+    REQUIRE(page.GetDictionary().GetKey("Resources") == &page.GetResources()->GetObject());
+}
+
 TEST_CASE("testIsPdfFile")
 {
     try
@@ -1982,6 +2613,86 @@ TEST_CASE("testSaveIncrementalRoundTrip")
     }
 }
 
+void testParallelParsing(const string_view& buffer)
+{
+    SpanStreamDevice device1(buffer);
+    PdfIndirectObjectList objects1;
+    PdfParser parser1(objects1);
+    parser1.Parse(device1, false);
+
+    SpanStreamDevice device2(buffer);
+    PdfIndirectObjectList objects2;
+    PdfParser parser2(objects2);
+    parser2.SetParseThreadCount(4);
+    parser2.Parse(device2, false);
+
+    REQUIRE(objects1.GetSize() == objects2.GetSize());
+    auto it2 = objects2.begin();
+    for (auto obj1 : objects1)
+    {
+        auto obj2 = *it2;
+        REQUIRE(obj1->GetIndirectReference() == obj2->GetIndirectReference());
+        REQUIRE(obj1->GetVariant().ToString() == obj2->GetVariant().ToString());
+        it2++;
+    }
+}
+
+string generateLinearizedDocument(bool withCatalog)
+{
+    // Objects 4-8 are the first-page section, 1-3 the remaining objects
+    const char* objects[] = {
+        "<< /Type /Page /Parent 7 0 R /MediaBox [ 0 0 200 200 ] /Resources 2 0 R >>",
+        "<< /Index 2 >>",
+        "<< /Index 3 >>",
+        nullptr,
+        "<< /Type /Catalog /Pages 7 0 R >>",
+        "<< /Type /Page /Parent 7 0 R /MediaBox [ 0 0 100 100 ] >>",
+        "<< /Type /Pages /Kids [ 6 0 R 1 0 R ] /Count 2 >>",
+        "<< /Producer (pdfmm) >>",
+    };
+
+    // Numbers are padded, so the offsets computed in the
+    // first iteration are valid for the second one
+    string docbuff;
+    size_t offsets[9] = { };
+    size_t fileLength = 0;
+    size_t firstPageXRefOffset = 0;
+    size_t mainXRefOffset = 0;
+    for (unsigned pass = 0; pass < 2; pass++)
+    {
+        docbuff = "%PDF-1.4\n";
+        offsets[4] = docbuff.size();
+        docbuff.append(utls::Format("4 0 obj\n<< /Linearized 1 /L {:010} /H [ 0 0 ] /O 6 /E 0 /N 2 /T 0 >>\nendobj\n", fileLength));
+        firstPageXRefOffset = docbuff.size();
+        string xref("xref\n4 5\n");
+        for (unsigned i = 4; i <= 8; i++)
+            xref.append(utls::Format("{:010} 00000 n\r\n", offsets[i]));
+        docbuff.append(xref);
+        docbuff.append(utls::Format("trailer\n<< /Size 9 {}/Info 8 0 R /Prev {:010} >>\nstartxref\n0\n%%EOF\n",
+            withCatalog ? "/Root 5 0 R " : "", mainXRefOffset));
+
+        for (unsigned i = 5; i <= 8; i++)
+        {
+            offsets[i] = docbuff.size();
+            docbuff.append(utls::Format("{} 0 obj\n{}\nendobj\n", i, objects[i - 1]));
+        }
+        for (unsigned i = 1; i <= 3; i++)
+        {
+            offsets[i] = docbuff.size();
+            docbuff.append(utls::Format("{} 0 obj\n{}\nendobj\n", i, objects[i - 1]));
+        }
+
+        mainXRefOffset = docbuff.size();
+        docbuff.append("xref\n0 4\n0000000000 65535 f\r\n");
+        for (unsigned i = 1; i <= 3; i++)
+            docbuff.append(utls::Format("{:010} 00000 n\r\n", offsets[i]));
+        docbuff.append(utls::Format("trailer\n<< /Size 9 >>\nstartxref\n{}\n%%EOF\n", firstPageXRefOffset));
+        fileLength = docbuff.size();
+    }
+
+    return docbuff;
+}
+
 string generateXRefEntries(size_t count)
 {
     string strXRefEntries;
@@ -2046,3 +2757,340 @@ bool canOutOfMemoryKillUnitTests()
 }
 
 
+
+TEST_CASE("testMemoryStats")
+{
+    PdfObject obj;
+    auto& dict = obj.GetDictionary();
+    dict.AddKey(PdfName::KeyType, PdfName("Page"));
+    size_t usage = obj.GetMemoryUsage();
+    REQUIRE(usage >= sizeof(PdfObject) + sizeof(PdfDictionary));
+
+    // Names not interned and strings are stored out of line
+    dict.AddKey("CustomKeyWithALongName", PdfString("A string value longer than the inline storage"));
+    PdfMemoryStats stats;
+    obj.CollectMemoryUsage(stats);
+    REQUIRE(stats.Names > 0);
+    REQUIRE(stats.Strings > sizeof(PdfString));
+    REQUIRE(stats.GetTotal() > usage);
+
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto contents = doc.GetObjects().CreateDictionaryObject();
+        contents->GetOrCreateStream().Set(string(10000, ' '), { });
+        page->GetObject().GetDictionary().AddKeyIndirect("Contents", contents);
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    // Loading on demand, objects are not loaded by the accounting
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    auto loadedStats = doc.GetMemoryStats();
+    REQUIRE(loadedStats.ObjectCount == doc.GetObjects().GetSize());
+    REQUIRE(loadedStats.Streams < 10000);
+    REQUIRE(loadedStats.ParserCache > 0);
+
+    auto& page = doc.GetPages().GetPage(0);
+    (void)page.GetObject().GetDictionary().MustFindKey("Contents").MustGetStream().GetLength();
+    loadedStats = doc.GetMemoryStats();
+    REQUIRE(loadedStats.Streams >= 10000);
+}
+
+TEST_CASE("testFrozenDocument")
+{
+    constexpr unsigned PageCount = 16;
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        for (unsigned i = 0; i < PageCount; i++)
+        {
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            auto contents = doc.GetObjects().CreateDictionaryObject();
+            contents->GetOrCreateStream().Set(utls::Format("{} 0 m 100 100 l S", i));
+            page->GetObject().GetDictionary().AddKeyIndirect("Contents", contents);
+        }
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    doc.SetMemoryBudget(4096);
+    doc.Freeze();
+    REQUIRE(doc.IsFrozen());
+    REQUIRE(doc.GetMemoryBudget() == 0);
+    for (auto obj : doc.GetObjects())
+        REQUIRE(obj->IsDelayedLoadDone());
+
+    // Read the pages concurrently through const references
+    const PdfMemDocument& cdoc = doc;
+    vector<std::thread> threads;
+    std::atomic<unsigned> failures(0);
+    for (unsigned t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&cdoc, &failures]()
+        {
+            for (unsigned i = 0; i < PageCount; i++)
+            {
+                auto& page = cdoc.GetPages().GetPage(i);
+                auto& contents = page.GetObject().GetDictionary().MustFindKey("Contents");
+                auto data = contents.MustGetStream().GetFilteredCopy();
+                if (data.substr(0, data.find(' ')) != std::to_string(i))
+                    failures++;
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    REQUIRE(failures == 0);
+    for (auto obj : doc.GetObjects())
+        REQUIRE(!obj->IsDirty());
+    REQUIRE_THROWS(doc.SetMemoryBudget(4096));
+
+    doc.LoadFromBuffer(buffer);
+    REQUIRE(!doc.IsFrozen());
+}
+
+TEST_CASE("testXRefStreamWidths")
+{
+    PdfMemDocument doc;
+    doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    PdfReference lastRef;
+    for (unsigned i = 0; i < 300; i++)
+    {
+        auto obj = doc.GetObjects().CreateDictionaryObject("Test");
+        obj->GetDictionary().AddKey("Index", (int64_t)i);
+        lastRef = obj->GetIndirectReference();
+    }
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::NoModifyDateUpdate | PdfSaveOptions::CompressObjects);
+
+    // The offsets fit in 2 bytes and the generations/indices
+    // also in 2 bytes, because the free head has generation 65535
+    size_t xrefPos = buffer.find("/XRef");
+    REQUIRE(xrefPos != string::npos);
+    size_t xrefStart = buffer.rfind('\n', buffer.rfind(" obj", xrefPos)) + 1;
+    SpanStreamDevice input(buffer);
+    PdfParserObject xrefObj(input, xrefStart);
+    xrefObj.Parse();
+    auto& wArr = xrefObj.GetDictionary().MustFindKey("W").GetArray();
+    REQUIRE(wArr[0].GetNumber() == 1);
+    REQUIRE(wArr[1].GetNumber() == 2);
+    REQUIRE(wArr[2].GetNumber() == 2);
+    auto& decodeParms = xrefObj.GetDictionary().MustFindKey("DecodeParms").GetDictionary();
+    REQUIRE(decodeParms.MustFindKey("Predictor").GetNumber() == 12);
+    REQUIRE(decodeParms.MustFindKey("Columns").GetNumber() == 5);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    REQUIRE(loaded.GetPages().GetCount() == 1);
+    REQUIRE(loaded.GetObjects().MustGetObject(lastRef).GetDictionary().MustFindKey("Index").GetNumber() == 299);
+}
+
+TEST_CASE("testResetAndReload")
+{
+    charbuff withOutlines;
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        doc.GetOrCreateOutlines().CreateRoot(PdfString("root"));
+        BufferStreamDevice device(withOutlines);
+        doc.Save(device);
+    }
+
+    charbuff twoPages;
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        BufferStreamDevice device(twoPages);
+        doc.Save(device);
+    }
+
+    // Nothing of the previous document survives the next load
+    PdfMemDocument doc;
+    for (unsigned i = 0; i < 3; i++)
+    {
+        doc.LoadFromBuffer(withOutlines);
+        REQUIRE(doc.GetPages().GetCount() == 1);
+        REQUIRE(doc.GetOutlines() != nullptr);
+
+        doc.LoadFromBuffer(twoPages);
+        REQUIRE(doc.GetPages().GetCount() == 2);
+        REQUIRE(doc.GetOutlines() == nullptr);
+
+        doc.Reset();
+        REQUIRE(doc.GetPages().GetCount() == 0);
+        REQUIRE(doc.GetOutlines() == nullptr);
+        REQUIRE(doc.GetObjects().GetSize() == 3);
+    }
+
+    // A reset document is a valid new document
+    doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device);
+    doc.LoadFromBuffer(buffer);
+    REQUIRE(doc.GetPages().GetCount() == 1);
+}
+
+TEST_CASE("testLoadAsync")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    auto executors = { std::make_shared<PdfThreadPool>(1), std::make_shared<PdfThreadPool>(2) };
+    for (auto& executor : executors)
+    {
+        PdfMemDocument doc;
+        doc.SetExecutor(executor);
+        doc.LoadFromDeviceAsync(std::make_shared<SpanStreamDevice>(buffer)).get();
+        REQUIRE(doc.GetPages().GetCount() == 2);
+
+        vector<PdfReference> references;
+        for (auto obj : doc.GetObjects())
+            references.push_back(obj->GetIndirectReference());
+
+        references.push_back(PdfReference(1000, 0));
+        doc.LoadObjectsAsync(references).get();
+        for (auto obj : doc.GetObjects())
+            REQUIRE(obj->IsDelayedLoadDone());
+
+        // The errors are rethrown by the future
+        string_view invalid = "%PDF-1.7\nnot a document";
+        auto future = doc.LoadFromDeviceAsync(std::make_shared<SpanStreamDevice>(invalid));
+        REQUIRE_THROWS_AS(future.get(), PdfError);
+    }
+}
+
+TEST_CASE("testLoadUpdate")
+{
+    charbuff buffer;
+    vector<PdfReference> refs;
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        for (unsigned i = 0; i < 20; i++)
+        {
+            auto obj = doc.GetObjects().CreateDictionaryObject("Test");
+            obj->GetDictionary().AddKey("Index", (int64_t)i);
+            refs.push_back(obj->GetIndirectReference());
+        }
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+
+    // First step: modify an object and add a new one
+    doc.GetObjects().MustGetObject(refs[5]).GetDictionary().AddKey("Index", (int64_t)1000);
+    auto added = doc.GetObjects().CreateDictionaryObject("Added");
+    charbuff step1 = buffer;
+    {
+        BufferStreamDevice device(step1);
+        doc.SaveUpdate(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+
+    doc.LoadUpdateFromBuffer(step1);
+    REQUIRE(!doc.GetObjects().MustGetObject(refs[5]).IsDirty());
+    REQUIRE(!added->IsDirty());
+
+    // The rebased object is read again from the update
+    auto rebased = dynamic_cast<PdfParserObject*>(&doc.GetObjects().MustGetObject(refs[5]));
+    REQUIRE(rebased != nullptr);
+    REQUIRE(rebased->GetOffset() >= (ssize_t)buffer.size());
+    rebased->FreeObjectMemory();
+    REQUIRE(rebased->GetDictionary().MustFindKey("Index").GetNumber() == 1000);
+
+    // Second step: only the later change is written
+    doc.GetObjects().MustGetObject(refs[7]).GetDictionary().AddKey("Index", (int64_t)2000);
+    charbuff step2 = step1;
+    {
+        BufferStreamDevice device(step2);
+        doc.SaveUpdate(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+
+    string_view update = string_view(step2).substr(step1.size());
+    REQUIRE(update.find(" 0 obj") == update.rfind(" 0 obj"));
+    REQUIRE(update.find(utls::Format("{} 0 obj", refs[7].ObjectNumber())) == 0);
+    doc.LoadUpdateFromBuffer(step2);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(step2);
+    REQUIRE(loaded.GetObjects().MustGetObject(refs[5]).GetDictionary().MustFindKey("Index").GetNumber() == 1000);
+    REQUIRE(loaded.GetObjects().MustGetObject(refs[7]).GetDictionary().MustFindKey("Index").GetNumber() == 2000);
+    REQUIRE(loaded.GetObjects().GetObject(added->GetIndirectReference()) != nullptr);
+
+    // An unrelated file is rejected
+    PdfMemDocument other;
+    other.LoadFromBuffer(buffer);
+    REQUIRE_THROWS_AS(other.LoadUpdateFromBuffer(buffer), PdfError);
+}
+
+TEST_CASE("testLazyObjects")
+{
+    charbuff buffer;
+    vector<PdfReference> refs;
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        for (unsigned i = 0; i < 50; i++)
+        {
+            auto obj = doc.GetObjects().CreateDictionaryObject("Test");
+            obj->GetDictionary().AddKey("Index", (int64_t)i);
+            refs.push_back(obj->GetIndirectReference());
+        }
+
+        doc.GetCatalog().GetDictionary().AddKey("Test", refs.back());
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    auto& objects = doc.GetObjects();
+
+    // The listed objects are created on lookup
+    auto& obj = objects.MustGetObject(refs[10]);
+    REQUIRE(obj.GetDictionary().MustFindKey("Index").GetNumber() == 10);
+    REQUIRE(objects.GetObject(refs[10]) == &obj);
+    REQUIRE(objects.GetObject(PdfReference(refs[10].ObjectNumber(), 1)) == nullptr);
+    REQUIRE(doc.GetCatalog().GetDictionary().MustFindKey("Test").GetDictionary().MustFindKey("Index").GetNumber() == 49);
+
+    // New objects don't reuse the numbers of the objects not created yet
+    auto created = objects.CreateDictionaryObject();
+    REQUIRE(created->GetIndirectReference().ObjectNumber() > refs.back().ObjectNumber());
+
+    auto removed = objects.RemoveObject(refs[20]);
+    REQUIRE(removed != nullptr);
+    REQUIRE(removed->GetDictionary().MustFindKey("Index").GetNumber() == 20);
+    REQUIRE(objects.GetObject(refs[20]) == nullptr);
+
+    // Accessing the whole list creates all the objects
+    unsigned count = 0;
+    for (auto listed : objects)
+    {
+        if (!listed->IsDictionary())
+            continue;
+
+        auto type = listed->GetDictionary().FindKey("Type");
+        if (type != nullptr && type->GetName() == "Test")
+            count++;
+    }
+    REQUIRE(count == 49);
+}
@@ -0,0 +1,1436 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <PdfTest.h>
+#include "TestUtils.h"
+
+using namespace std;
+using namespace mm;
+
+TEST_CASE("testCollectGarbage")
+{
+    PdfMemDocument doc;
+    doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    auto& objects = doc.GetObjects();
+    auto orphan = objects.CreateDictionaryObject();
+    auto orphanRef = orphan->GetIndirectReference();
+
+    // A long chain of references, visited without recursion
+    auto referenced = objects.CreateArrayObject();
+    doc.GetCatalog().GetDictionary().AddKeyIndirect("Chain", referenced);
+    auto lastRef = referenced->GetIndirectReference();
+    for (unsigned i = 0; i < 100000; i++)
+    {
+        auto next = objects.CreateArrayObject();
+        objects.MustGetObject(lastRef).GetArray().AddIndirect(next);
+        lastRef = next->GetIndirectReference();
+    }
+
+    doc.CollectGarbage();
+    REQUIRE(objects.GetObject(orphanRef) == nullptr);
+    REQUIRE(objects.GetObject(lastRef) != nullptr);
+    REQUIRE(objects.GetObject(referenced->GetIndirectReference()) == referenced);
+    REQUIRE(doc.GetPages().GetCount() == 1);
+}
+
+TEST_CASE("testObjectWalker")
+{
+    PdfMemDocument doc;
+    auto& objects = doc.GetObjects();
+    auto first = objects.CreateDictionaryObject();
+    auto second = objects.CreateDictionaryObject();
+    auto leaf = objects.CreateArrayObject();
+    first->GetDictionary().AddKeyIndirect("Next", second);
+    first->GetDictionary().AddKeyIndirect("Leaf", leaf);
+    second->GetDictionary().AddKeyIndirect("Next", first);
+    leaf->GetArray().Add(PdfObject((int64_t)1));
+    leaf->GetArray().Add(PdfObject((int64_t)2));
+
+    // The cycle is walked once, and the values are visited in order
+    vector<const PdfObject*> visited;
+    PdfObjectWalker walker(&objects);
+    REQUIRE(walker.Walk(*first, [&](const PdfObject& obj, const PdfName*) {
+        if (obj.IsIndirect())
+            visited.push_back(&obj);
+        return PdfWalkAction::Continue;
+    }));
+    REQUIRE(visited == vector<const PdfObject*>{ first, leaf, second });
+    REQUIRE(walker.IsVisited(second->GetIndirectReference().ObjectNumber()));
+
+    // The children of the skipped values are not visited
+    unsigned count = 0;
+    PdfObjectWalker skipWalker(&objects);
+    REQUIRE(skipWalker.Walk(*first, [&](const PdfObject&, const PdfName* key) {
+        count++;
+        return key != nullptr && *key == "Leaf" ? PdfWalkAction::SkipChildren : PdfWalkAction::Continue;
+    }));
+    REQUIRE(count == 5);
+    REQUIRE(!skipWalker.IsVisited(leaf->GetIndirectReference().ObjectNumber()));
+
+    // A stopped walk returns false
+    PdfObjectWalker stopWalker(&objects);
+    REQUIRE(!stopWalker.Walk(*first, [&](const PdfObject& obj, const PdfName*) {
+        return obj.IsNumber() ? PdfWalkAction::Stop : PdfWalkAction::Continue;
+    }));
+
+    // Too deeply nested values are refused by the tokenizer
+    string nested = string(10000, '[') + string(10000, ']');
+    PdfVariant variant;
+    PdfTokenizer tokenizer;
+    SpanStreamDevice device(nested);
+    ASSERT_THROW_WITH_ERROR_CODE(tokenizer.ReadNextVariant(device, variant), PdfErrorCode::BrokenFile);
+}
+
+TEST_CASE("testFreeObjectReuse")
+{
+    PdfMemDocument doc;
+    auto& objects = doc.GetObjects();
+    auto ref1 = objects.CreateDictionaryObject()->GetIndirectReference();
+    auto ref2 = objects.CreateDictionaryObject()->GetIndirectReference();
+    objects.RemoveObject(ref2);
+    objects.RemoveObject(ref1);
+
+    // Free numbers are reused in the order they were freed, with
+    // the generation incremented, and never twice
+    REQUIRE(objects.CreateDictionaryObject()->GetIndirectReference() == PdfReference(ref2.ObjectNumber(), 1));
+    REQUIRE(objects.CreateDictionaryObject()->GetIndirectReference() == PdfReference(ref1.ObjectNumber(), 1));
+    auto ref3 = objects.CreateDictionaryObject()->GetIndirectReference();
+    REQUIRE(ref3.ObjectNumber() == objects.GetObjectCount() - 1);
+    REQUIRE(ref3.GenerationNumber() == 0);
+
+    objects.RemoveObject(ref3);
+    objects.SetCanReuseObjectNumbers(false);
+    REQUIRE(objects.GetFreeObjects().size() == 0);
+    REQUIRE(objects.CreateDictionaryObject()->GetIndirectReference().ObjectNumber() == ref3.ObjectNumber() + 1);
+}
+
+namespace
+{
+    class BatchObserver : public PdfIndirectObjectList::Observer
+    {
+    public:
+        void WriteObject(const PdfObject&) override { }
+        void WriteObjects(const cspan<PdfObject*>& objects) override { Batches.push_back(objects.size()); }
+        void BeginAppendStream(const PdfObjectStream&) override { }
+        void EndAppendStream(const PdfObjectStream&) override { }
+        void Finish() override { }
+
+        vector<size_t> Batches;
+    };
+}
+
+TEST_CASE("testBatchedObserver")
+{
+    PdfMemDocument doc;
+    auto& objects = doc.GetObjects();
+    BatchObserver observer;
+    objects.Attach(&observer);
+    objects.SetBatchSize(3);
+    for (unsigned i = 0; i < 7; i++)
+        objects.QueueObject(*objects.CreateDictionaryObject());
+
+    REQUIRE(observer.Batches == vector<size_t>{ 3, 3 });
+
+    // Queued objects are delivered before a stream append starts,
+    // and removed objects are not delivered
+    auto removed = objects.CreateDictionaryObject();
+    objects.QueueObject(*removed);
+    objects.RemoveObject(removed->GetIndirectReference());
+    objects.CreateDictionaryObject()->GetOrCreateStream().Set("test", 4, { });
+    REQUIRE(observer.Batches == vector<size_t>{ 3, 3, 1 });
+
+    objects.QueueObject(*objects.CreateDictionaryObject());
+    objects.Finish();
+    REQUIRE(observer.Batches == vector<size_t>{ 3, 3, 1, 1 });
+    objects.Detach(&observer);
+}
+
+TEST_CASE("testConcurrentWrite")
+{
+    PdfMemDocument doc;
+    auto& objects = doc.GetObjects();
+    for (unsigned i = 0; i < 3000; i++)
+    {
+        auto obj = objects.CreateDictionaryObject();
+        obj->GetDictionary().AddKey("Index", (int64_t)i);
+        obj->GetDictionary().AddKey("Name", PdfName("Object" + std::to_string(i)));
+        if (i % 3 == 0)
+            obj->GetOrCreateStream().Set("stream data " + std::to_string(i));
+    }
+
+    // The output is the same as the one written sequentially
+    charbuff expected;
+    BufferStreamDevice expectedDevice(expected);
+    doc.Save(expectedDevice, PdfSaveOptions::NoModifyDateUpdate);
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::NoModifyDateUpdate | PdfSaveOptions::ConcurrentWrite);
+    REQUIRE(buffer == expected);
+
+    // Objects read on demand are loaded before being serialized
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    REQUIRE(loaded.GetObjects().GetSize() == objects.GetSize());
+    charbuff reloaded;
+    BufferStreamDevice reloadedDevice(reloaded);
+    loaded.Save(reloadedDevice, PdfSaveOptions::NoModifyDateUpdate | PdfSaveOptions::ConcurrentWrite);
+    REQUIRE(reloaded == expected);
+}
+
+namespace
+{
+    class CountingExecutor final : public PdfExecutor
+    {
+    public:
+        CountingExecutor(unsigned concurrency)
+            : SubmitCount(0), m_pool(concurrency) { }
+
+        unsigned GetConcurrency() const override
+        {
+            return m_pool.GetConcurrency();
+        }
+
+        void Submit(Task task) override
+        {
+            SubmitCount++;
+            m_pool.Submit(std::move(task));
+        }
+
+    public:
+        std::atomic<unsigned> SubmitCount;
+
+    private:
+        PdfThreadPool m_pool;
+    };
+}
+
+TEST_CASE("testCustomExecutor")
+{
+    auto executor = std::make_shared<CountingExecutor>(4);
+
+    // Nested operations complete and the first error is rethrown
+    vector<size_t> sums(16);
+    executor->ParallelFor(sums.size(), 1, 0, [&]()
+    {
+        return [&](size_t i)
+        {
+            atomic<size_t> sum(0);
+            executor->ParallelFor(100, 10, 0, [&]()
+            {
+                return [&](size_t j) { sum += j; };
+            });
+            sums[i] = sum;
+        };
+    });
+    REQUIRE(sums == vector<size_t>(16, 4950));
+    REQUIRE_THROWS_AS(executor->ParallelFor(100, 1, 0, [&]()
+    {
+        return [](size_t i)
+        {
+            if (i == 50)
+                throw runtime_error("failed");
+        };
+    }), runtime_error);
+
+    // The document executor replaces the default one
+    PdfMemDocument doc;
+    auto& objects = doc.GetObjects();
+    for (unsigned i = 0; i < 300; i++)
+        objects.CreateDictionaryObject()->GetDictionary().AddKey("Index", (int64_t)i);
+
+    charbuff expected;
+    BufferStreamDevice expectedDevice(expected);
+    doc.Save(expectedDevice, PdfSaveOptions::NoModifyDateUpdate);
+
+    doc.SetExecutor(executor);
+    REQUIRE(doc.GetExecutor() == executor);
+    executor->SubmitCount = 0;
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::NoModifyDateUpdate | PdfSaveOptions::ConcurrentWrite);
+    REQUIRE(buffer == expected);
+    REQUIRE(executor->SubmitCount != 0);
+
+    doc.SetExecutor(nullptr);
+    REQUIRE(doc.GetExecutor() == PdfExecutor::GetDefault());
+}
+
+#ifdef PDFMM_HAVE_MEMORY_RESOURCE
+
+namespace
+{
+    class CountingMemoryResource final : public std::pmr::memory_resource
+    {
+    public:
+        size_t AllocationCount = 0;
+        size_t AllocatedBytes = 0;
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            AllocationCount++;
+            AllocatedBytes += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+        {
+            AllocatedBytes -= bytes;
+            std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+}
+
+TEST_CASE("testMemoryResourceDocument")
+{
+    charbuff buffer;
+    CountingMemoryResource resource;
+    {
+        PdfMemDocument doc(&resource);
+        REQUIRE(doc.GetMemoryResource() == &resource);
+        for (unsigned i = 0; i < 100; i++)
+        {
+            auto obj = doc.GetObjects().CreateDictionaryObject();
+            obj->GetDictionary().AddKey("Index", (int64_t)i);
+            obj->GetOrCreateStream().Set(std::string_view("stream data"));
+        }
+
+        REQUIRE(resource.AllocationCount > 200);
+        REQUIRE(PdfMemoryResource::GetCurrent() == nullptr);
+
+        // Objects allocated outside of the scope are released to the global heap
+        size_t allocationCount = resource.AllocationCount;
+        unique_ptr<PdfObject> obj(new PdfObject(PdfArray()));
+        REQUIRE(resource.AllocationCount == allocationCount);
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+    REQUIRE(resource.AllocatedBytes == 0);
+
+    // Loaded objects, also on demand, come from the resource too
+    resource.AllocationCount = 0;
+    {
+        PdfMemDocument doc(&resource);
+        doc.LoadFromBuffer(buffer);
+
+        // The objects are created on their first lookup
+        size_t allocationCount = resource.AllocationCount;
+        REQUIRE(allocationCount < 100);
+        for (auto obj : doc.GetObjects())
+            (void)obj->GetDataType();
+
+        REQUIRE(resource.AllocationCount > allocationCount + 100);
+    }
+    REQUIRE(resource.AllocatedBytes == 0);
+}
+
+#endif // PDFMM_HAVE_MEMORY_RESOURCE
+
+TEST_CASE("testMemoryGovernor")
+{
+    // Don't leave the budget set to the other tests
+    struct BudgetReset
+    {
+        ~BudgetReset() { PdfMemoryGovernor::SetBudget(0); }
+    } reset;
+
+    // Nothing is accounted without a budget
+    REQUIRE(PdfMemoryGovernor::Reserve(1000) == 0);
+
+    PdfMemoryGovernor::SetBudget(64 << 20);
+    size_t usage = PdfMemoryGovernor::GetUsage();
+    {
+        PdfMemDocument doc;
+        auto& objects = doc.GetObjects();
+        objects.SetDecodedStreamCacheSize(1 << 20);
+
+        charbuff data(string(100000, 'a'));
+        auto obj1 = objects.CreateDictionaryObject();
+        obj1->GetOrCreateStream().Set(data, { });
+        REQUIRE(PdfMemoryGovernor::GetUsage() >= usage + 100000);
+
+        charbuff extracted;
+        obj1->MustGetStream().ExtractTo(extracted);
+        REQUIRE(objects.GetDecodedStreamMemory() == 100000);
+        size_t used = PdfMemoryGovernor::GetUsage();
+        REQUIRE(used >= usage + 200000);
+
+        // The stream fits the budget once the cache is evicted
+        PdfMemoryGovernor::SetBudget(used + 50000);
+        auto obj2 = objects.CreateDictionaryObject();
+        obj2->GetOrCreateStream().Set(string(120000, 'b'), { });
+        REQUIRE(objects.GetDecodedStreamMemory() == 0);
+        REQUIRE(obj2->MustGetStream().GetLength() == 120000);
+
+        // Nothing is left to evict, so the operation fails
+        auto obj3 = objects.CreateDictionaryObject();
+        try
+        {
+            obj3->GetOrCreateStream().Set(data, { });
+            FAIL("Should throw");
+        }
+        catch (PdfError& error)
+        {
+            REQUIRE(error.GetError() == PdfErrorCode::MemoryBudgetExceeded);
+        }
+        REQUIRE(obj3->MustGetStream().GetLength() == 0);
+        REQUIRE(PdfMemoryGovernor::GetUsage() <= used + 50000);
+
+        // The data that doesn't fit the budget is just not cached
+        obj1->MustGetStream().ExtractTo(extracted);
+        REQUIRE(extracted == data);
+        REQUIRE(objects.GetDecodedStreamMemory() == 0);
+    }
+
+    // All the reserved memory is released with the document
+    REQUIRE(PdfMemoryGovernor::GetUsage() == usage);
+}
+
+TEST_CASE("testSnapshot")
+{
+    charbuff buffer;
+    PdfReference streamRef;
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto obj = doc.GetObjects().CreateDictionaryObject("Test");
+        obj->GetDictionary().AddKey("Real", 1.5);
+        PdfArray arr;
+        arr.Add(true);
+        arr.Add(PdfString("text"));
+        arr.Add(PdfVariant::NullValue);
+        obj->GetDictionary().AddKey("Array", arr);
+        obj->GetOrCreateStream().Set("stream data");
+        streamRef = obj->GetIndirectReference();
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    auto source = std::make_shared<SpanStreamDevice>(buffer);
+    PdfMemDocument doc;
+    doc.LoadFromDevice(source);
+
+    // Add an object that is not in the source, so its stream is stored inline
+    auto added = doc.GetObjects().CreateDictionaryObject();
+    added->GetOrCreateStream().Set("inline data");
+    auto addedRef = added->GetIndirectReference();
+
+    charbuff snapshot;
+    BufferStreamDevice device(snapshot);
+    doc.SaveSnapshot(device);
+
+    PdfMemDocument restored;
+    restored.LoadFromSnapshot(std::make_shared<SpanStreamDevice>(snapshot), source);
+    REQUIRE(restored.GetPages().GetCount() == 2);
+    REQUIRE(restored.GetObjects().GetSize() == doc.GetObjects().GetSize());
+
+    auto obj = restored.GetObjects().GetObject(streamRef);
+    REQUIRE(obj->GetDictionary().MustFindKey("Real").GetReal() == 1.5);
+    REQUIRE(obj->GetDictionary().MustFindKey("Array").GetArray()[1].GetString().GetString() == "text");
+    REQUIRE(obj->MustGetStream().GetFilteredCopy() == doc.GetObjects().GetObject(streamRef)->MustGetStream().GetFilteredCopy());
+    REQUIRE(restored.GetObjects().GetObject(addedRef)->MustGetStream().GetFilteredCopy() == added->MustGetStream().GetFilteredCopy());
+
+    // The restored document can be saved and loaded again
+    charbuff saved;
+    BufferStreamDevice savedDevice(saved);
+    restored.Save(savedDevice);
+    PdfMemDocument reloaded;
+    reloaded.LoadFromBuffer(saved);
+    REQUIRE(reloaded.GetPages().GetCount() == 2);
+
+    // A different source is detected
+    charbuff other = buffer;
+    other[other.size() - 10] = ' ';
+    PdfMemDocument mismatched;
+    REQUIRE_THROWS_AS(mismatched.LoadFromSnapshot(std::make_shared<SpanStreamDevice>(snapshot),
+        std::make_shared<SpanStreamDevice>(other)), PdfError);
+    REQUIRE_THROWS_AS(mismatched.LoadFromSnapshot(std::make_shared<SpanStreamDevice>(snapshot), nullptr), PdfError);
+}
+
+TEST_CASE("testDocumentHasher")
+{
+    // XXH64 reference values
+    REQUIRE(PdfDocumentHasher::ComputeDataHash(string_view()) == 0xEF46DB3751D8E999);
+    REQUIRE(PdfDocumentHasher::ComputeDataHash(string_view("abc")) == 0x44BC2CF5AD770999);
+    REQUIRE(PdfDocumentHasher::ComputeDataHash(string_view("Nobody inspects the spammish repetition")) == 0xFBCEA83C8A378BF1);
+
+    charbuff plain;
+    charbuff compressed;
+    {
+        PdfMemDocument doc;
+        for (unsigned i = 0; i < 3; i++)
+        {
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            auto obj = doc.GetObjects().CreateDictionaryObject();
+            obj->GetOrCreateStream().Set("stream data " + std::to_string(i));
+            page->GetObject().GetDictionary().AddKey("Test", obj->GetIndirectReference());
+        }
+
+        // The first page links to the last one
+        PdfArray dest;
+        dest.Add(doc.GetPages().GetPage(2).GetObject().GetIndirectReference());
+        dest.Add(PdfName("Fit"));
+        doc.GetPages().GetPage(0).GetObject().GetDictionary().AddKey("Dest", dest);
+
+        BufferStreamDevice plainDevice(plain);
+        doc.Save(plainDevice);
+        BufferStreamDevice compressedDevice(compressed);
+        doc.Save(compressedDevice, PdfSaveOptions::CompressObjects);
+    }
+
+    // The object numbering, the producer and the dates are not hashed
+    PdfMemDocument doc1;
+    doc1.LoadFromBuffer(plain);
+    PdfMemDocument doc2;
+    doc2.SetExecutor(std::make_shared<PdfThreadPool>(2));
+    doc2.LoadFromBuffer(compressed);
+    doc2.GetMetadata().SetProducer(PdfString("Other producer"), true);
+    REQUIRE(PdfDocumentHasher(doc1).ComputeDocumentHash() == PdfDocumentHasher(doc2).ComputeDocumentHash());
+
+    auto hashes = PdfDocumentHasher(doc2).ComputePageHashes();
+    REQUIRE(hashes.size() == 3);
+    REQUIRE(hashes[0] != hashes[1]);
+    REQUIRE(hashes[1] != hashes[2]);
+    for (unsigned i = 0; i < 3; i++)
+        REQUIRE(PdfDocumentHasher(doc1).ComputePageHash(i) == hashes[i]);
+
+    // Only the hash of the modified page changes
+    uint64_t documentHash = PdfDocumentHasher(doc2).ComputeDocumentHash();
+    doc2.GetPages().GetPage(1).GetObject().GetDictionary().AddKey("Other", (int64_t)1);
+    auto modifiedHashes = PdfDocumentHasher(doc2).ComputePageHashes();
+    REQUIRE(modifiedHashes[0] == hashes[0]);
+    REQUIRE(modifiedHashes[1] != hashes[1]);
+    REQUIRE(modifiedHashes[2] == hashes[2]);
+    REQUIRE(PdfDocumentHasher(doc2).ComputeDocumentHash() != documentHash);
+}
+
+TEST_CASE("testDocumentDiff")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        for (unsigned i = 0; i < 3; i++)
+        {
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            auto obj = doc.GetObjects().CreateDictionaryObject();
+            obj->GetOrCreateStream().Set("stream data " + std::to_string(i));
+            page->GetObject().GetDictionary().AddKey("Test", obj->GetIndirectReference());
+        }
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+
+    PdfMemDocument oldDoc;
+    oldDoc.LoadFromBuffer(buffer);
+
+    // Change the stream of the second page and add a page
+    // in an incremental update
+    PdfReference changedRef;
+    charbuff updated = buffer;
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(buffer);
+        changedRef = doc.GetPages().GetPage(1).GetObject().GetDictionary().MustFindKey("Test").GetIndirectReference();
+        doc.GetObjects().MustGetObject(changedRef).GetOrCreateStream().Set("changed data");
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        BufferStreamDevice device(updated);
+        doc.SaveUpdate(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+
+    PdfMemDocument newDoc;
+    newDoc.LoadFromBuffer(updated);
+
+    // The revisions are aligned by reference
+    PdfDocumentDiff diff(oldDoc, newDoc);
+    diff.Compute();
+    REQUIRE(diff.GetAlignment() == PdfDiffAlignment::Reference);
+    auto& pages = diff.GetPages();
+    REQUIRE(pages.size() == 2);
+    REQUIRE(pages[0].Change == PdfDiffChange::Changed);
+    REQUIRE(*pages[0].OldIndex == 1);
+    REQUIRE(*pages[0].NewIndex == 1);
+    REQUIRE(pages[1].Change == PdfDiffChange::Added);
+    REQUIRE(!pages[1].OldIndex.has_value());
+    REQUIRE(*pages[1].NewIndex == 3);
+
+    bool changedFound = false;
+    for (auto& obj : diff.GetObjects())
+    {
+        REQUIRE(obj.Change != PdfDiffChange::Removed);
+        if (obj.NewReference == changedRef)
+        {
+            REQUIRE(obj.Change == PdfDiffChange::Changed);
+            changedFound = true;
+        }
+    }
+    REQUIRE(changedFound);
+
+    PdfDocumentDiff sameDiff(oldDoc, oldDoc);
+    sameDiff.Compute();
+    REQUIRE(sameDiff.IsEmpty());
+
+    // Unrelated documents are aligned structurally
+    PdfMemDocument removedDoc;
+    removedDoc.LoadFromBuffer(buffer);
+    removedDoc.GetPages().DeletePage(0);
+    PdfDocumentDiff structureDiff(oldDoc, removedDoc);
+    structureDiff.Compute(PdfDiffAlignment::Structure);
+    REQUIRE(structureDiff.GetPages().size() == 1);
+    REQUIRE(structureDiff.GetPages()[0].Change == PdfDiffChange::Removed);
+    REQUIRE(*structureDiff.GetPages()[0].OldIndex == 0);
+    REQUIRE(structureDiff.GetObjects().size() == 1);
+    REQUIRE(structureDiff.GetObjects()[0].OldReference == oldDoc.GetPages().GetPage(0).GetObject().GetIndirectReference());
+}
+
+TEST_CASE("testCompressObjects")
+{
+    PdfMemDocument doc;
+    doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    auto& objects = doc.GetObjects();
+    vector<PdfReference> refs;
+    for (unsigned i = 0; i < 250; i++)
+    {
+        auto obj = objects.CreateDictionaryObject("Test");
+        obj->GetDictionary().AddKey("Index", (int64_t)i);
+        obj->GetDictionary().AddKey("Value", PdfString("value " + std::to_string(i)));
+        refs.push_back(obj->GetIndirectReference());
+    }
+
+    charbuff plain;
+    BufferStreamDevice plainDevice(plain);
+    doc.Save(plainDevice, PdfSaveOptions::NoModifyDateUpdate);
+
+    doc.SetObjectStreamSize(64);
+    charbuff compressed;
+    BufferStreamDevice device(compressed);
+    doc.Save(device, PdfSaveOptions::NoModifyDateUpdate | PdfSaveOptions::CompressObjects);
+    REQUIRE(compressed.size() < plain.size() / 2);
+    REQUIRE(compressed.find("/ObjStm") != string::npos);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(compressed);
+    REQUIRE(loaded.GetPages().GetCount() == 1);
+    for (unsigned i = 0; i < refs.size(); i++)
+    {
+        auto& dict = loaded.GetObjects().MustGetObject(refs[i]).GetDictionary();
+        REQUIRE(dict.MustFindKey("Index").GetNumber() == i);
+        REQUIRE(dict.MustFindKey("Value").GetString().GetString() == "value " + std::to_string(i));
+    }
+}
+
+TEST_CASE("testRawStreamPassthrough")
+{
+    string data;
+    for (unsigned i = 0; i < 100000; i++)
+        data.append(std::to_string(i));
+
+    charbuff buffer;
+    PdfReference streamRef;
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto obj = doc.GetObjects().CreateDictionaryObject();
+        obj->GetOrCreateStream().Set(data);
+        streamRef = obj->GetIndirectReference();
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+
+    auto check = [&](PdfMemDocument& doc)
+    {
+        // Unmodified streams are copied without being loaded
+        charbuff saved;
+        BufferStreamDevice device(saved);
+        doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+        auto& obj = doc.GetObjects().MustGetObject(streamRef);
+        REQUIRE(!obj.IsDelayedLoadStreamDone());
+
+        PdfMemDocument loaded;
+        loaded.LoadFromBuffer(saved);
+        charbuff extracted;
+        loaded.GetObjects().MustGetObject(streamRef).MustGetStream().ExtractTo(extracted);
+        REQUIRE(extracted == data);
+    };
+
+    // Copy from the device view
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    check(doc);
+
+    // Copy in chunks from a device with no view
+    std::istringstream stream(buffer);
+    PdfMemDocument doc2;
+    doc2.LoadFromDevice(std::make_shared<StandardStreamDevice>(stream));
+    check(doc2);
+}
+
+TEST_CASE("testSpillObjectStream")
+{
+    // Pseudo random data, not to be compressed below the threshold
+    string data;
+    unsigned seed = 1;
+    for (unsigned i = 0; i < 300000; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        data.push_back((char)(seed >> 16));
+    }
+
+    PdfSpillStreamFactory factory(16 * 1024);
+    charbuff buffer;
+    PdfReference largeRef;
+    PdfReference smallRef;
+    {
+        PdfMemDocument doc;
+        doc.GetObjects().SetStreamFactory(&factory);
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto large = doc.GetObjects().CreateDictionaryObject();
+        large->GetOrCreateStream().Set(data);
+        largeRef = large->GetIndirectReference();
+        auto small = doc.GetObjects().CreateDictionaryObject();
+        small->GetOrCreateStream().Set(string_view("small"));
+        smallRef = small->GetIndirectReference();
+
+        auto& largeStream = dynamic_cast<PdfSpillObjectStream&>(large->MustGetStream());
+        REQUIRE(largeStream.IsSpilled());
+        REQUIRE(largeStream.GetMemoryLength() == 0);
+        REQUIRE(factory.GetSpilledLength() == largeStream.GetLength());
+        REQUIRE(!dynamic_cast<PdfSpillObjectStream&>(small->MustGetStream()).IsSpilled());
+
+        charbuff extracted;
+        largeStream.ExtractTo(extracted);
+        REQUIRE(extracted == data);
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+        doc.GetObjects().SetStreamFactory(nullptr);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    charbuff extracted;
+    doc.GetObjects().MustGetObject(largeRef).MustGetStream().ExtractTo(extracted);
+    REQUIRE(extracted == data);
+    doc.GetObjects().MustGetObject(smallRef).MustGetStream().ExtractTo(extracted);
+    REQUIRE(extracted == "small");
+}
+
+TEST_CASE("testEmbeddedFileStream")
+{
+    string data;
+    for (unsigned i = 0; i < 100000; i++)
+        data.append(std::to_string(i));
+
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        SpanStreamDevice input(data);
+        PdfFileSpec compressed(doc, "compressed", input);
+        doc.AttachFile(compressed);
+        SpanStreamDevice input2(data);
+        PdfFileSpec stored(doc, "stored", input2, false);
+        doc.AttachFile(stored);
+
+        auto& params = compressed.GetObject().GetDictionary().MustFindKey("EF")
+            .GetDictionary().MustFindKey("F").GetDictionary().MustFindKey("Params").GetDictionary();
+        REQUIRE(params.MustFindKey("Size").GetNumber() == (int64_t)data.size());
+        REQUIRE(params.MustFindKey("CheckSum").GetString().GetRawData().size() == 16);
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    for (auto name : { "compressed", "stored" })
+    {
+        unique_ptr<PdfFileSpec> fileSpec(doc.GetAttachment(PdfString(name)));
+        REQUIRE(fileSpec != nullptr);
+        REQUIRE(fileSpec->HasEmbeddedFile());
+        charbuff extracted;
+        BufferStreamDevice output(extracted);
+        fileSpec->ExtractEmbeddedFile(output);
+        REQUIRE(extracted == data);
+    }
+
+    unique_ptr<PdfFileSpec> stored(doc.GetAttachment(PdfString("stored")));
+    auto& storedObj = stored->GetObject().GetDictionary().MustFindKey("EF").GetDictionary().MustFindKey("F");
+    REQUIRE(!storedObj.GetDictionary().HasKey(PdfName::KeyFilter));
+}
+
+TEST_CASE("testDeduplicateObjects")
+{
+    PdfMemDocument doc;
+    auto& objects = doc.GetObjects();
+    string data(10000, 'x');
+    vector<PdfReference> pageRefs;
+    vector<PdfReference> fontRefs;
+    for (unsigned i = 0; i < 3; i++)
+    {
+        auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        pageRefs.push_back(page->GetObject().GetIndirectReference());
+
+        // The same font in each page, identical once the
+        // streams they refer to are merged
+        auto fontFile = objects.CreateDictionaryObject();
+        fontFile->GetOrCreateStream().Set(data);
+        auto font = objects.CreateDictionaryObject("Font");
+        font->GetDictionary().AddKey("FontFile", fontFile->GetIndirectReference());
+        fontRefs.push_back(font->GetIndirectReference());
+        PdfDictionary fonts;
+        fonts.AddKey("F1", font->GetIndirectReference());
+        PdfDictionary resources;
+        resources.AddKey("Font", fonts);
+        page->GetObject().GetDictionary().AddKey("Resources", resources);
+    }
+
+    charbuff plain;
+    BufferStreamDevice plainDevice(plain);
+    doc.Save(plainDevice, PdfSaveOptions::NoModifyDateUpdate);
+
+    charbuff deduplicated;
+    BufferStreamDevice device(deduplicated);
+    doc.Save(device, PdfSaveOptions::NoModifyDateUpdate | PdfSaveOptions::DeduplicateObjects);
+    REQUIRE(deduplicated.size() < plain.size() - 2 * data.size());
+
+    // The merged objects are still available in the document
+    REQUIRE(objects.GetObject(fontRefs[2]) != nullptr);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(deduplicated);
+    REQUIRE(loaded.GetPages().GetCount() == 3);
+    for (unsigned i = 0; i < 3; i++)
+    {
+        // Identical pages are not merged
+        auto& page = loaded.GetPages().GetPage(i);
+        REQUIRE(page.GetObject().GetIndirectReference() == pageRefs[i]);
+        auto& fonts = page.GetObject().GetDictionary().MustFindKey("Resources").GetDictionary().MustFindKey("Font").GetDictionary();
+        REQUIRE(fonts.MustGetKey("F1").GetReference() == fontRefs[0]);
+    }
+
+    REQUIRE(loaded.GetObjects().GetObject(fontRefs[1]) == nullptr);
+    charbuff fontData;
+    loaded.GetObjects().MustGetObject(fontRefs[0]).GetDictionary().MustFindKey("FontFile").MustGetStream().ExtractTo(fontData);
+    REQUIRE(fontData == data);
+}
+
+TEST_CASE("testIncrementalUpdateDirtyObjects")
+{
+    charbuff buffer;
+    vector<PdfReference> refs;
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        for (unsigned i = 0; i < 200; i++)
+        {
+            auto obj = doc.GetObjects().CreateDictionaryObject("Test");
+            obj->GetDictionary().AddKey("Index", (int64_t)i);
+            refs.push_back(obj->GetIndirectReference());
+        }
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    doc.GetObjects().MustGetObject(refs[100]).GetDictionary().AddKey("Index", (int64_t)1000);
+
+    // A removed object modified afterwards is not written
+    auto removed = doc.GetObjects().RemoveObject(refs[150]);
+    removed->GetDictionary().AddKey("Index", (int64_t)2000);
+
+    // Only the modified object is written in the update
+    charbuff updated = buffer;
+    BufferStreamDevice device(updated);
+    doc.SaveUpdate(device, PdfSaveOptions::NoModifyDateUpdate);
+    string_view update = string_view(updated).substr(buffer.size());
+    REQUIRE(update.find(" 0 obj") == update.rfind(" 0 obj"));
+    REQUIRE(update.find(utls::Format("{} 0 obj", refs[100].ObjectNumber())) == 0);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(updated);
+    REQUIRE(loaded.GetObjects().MustGetObject(refs[100]).GetDictionary().MustFindKey("Index").GetNumber() == 1000);
+    REQUIRE(loaded.GetObjects().MustGetObject(refs[99]).GetDictionary().MustFindKey("Index").GetNumber() == 99);
+}
+
+TEST_CASE("testLinearize")
+{
+    PdfMemDocument doc;
+    auto& objects = doc.GetObjects();
+    auto shared = objects.CreateDictionaryObject("Test");
+    shared->GetDictionary().AddKey("Value", PdfString("shared"));
+    for (unsigned i = 0; i < 3; i++)
+    {
+        auto page = doc.GetPages().CreatePage(PdfRect(0, 0, 100 * (i + 1), 100));
+        auto obj = objects.CreateDictionaryObject("Test");
+        obj->GetDictionary().AddKey("Value", PdfString("page " + std::to_string(i)));
+        obj->GetOrCreateStream().Set("page data " + std::to_string(i));
+        page->GetObject().GetDictionary().AddKey("Private", obj->GetIndirectReference());
+        if (i != 0)
+            page->GetObject().GetDictionary().AddKey("Shared", shared->GetIndirectReference());
+    }
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::NoModifyDateUpdate | PdfSaveOptions::Linearize);
+
+    // The linearization dictionary is the first object in the file
+    SpanStreamDevice input(buffer);
+    PdfParserObject linearizationObj(input, buffer.rfind('\n', buffer.find(" obj")) + 1);
+    linearizationObj.Parse();
+    auto& linearization = linearizationObj.GetDictionary();
+    REQUIRE(linearization.HasKey("Linearized"));
+    REQUIRE(linearization.MustFindKey("N").GetNumber() == 3);
+    REQUIRE(linearization.MustFindKey("L").GetNumber() == (int64_t)buffer.size());
+
+    // The objects of the first page precede the end of the
+    // first-page section, the objects of the other pages follow it
+    size_t firstPageEnd = (size_t)linearization.MustFindKey("E").GetNumber();
+    REQUIRE(buffer.find("(page 0)") < firstPageEnd);
+    REQUIRE(buffer.find("(page 1)") > firstPageEnd);
+    REQUIRE(buffer.find("(page 2)") > firstPageEnd);
+
+    // The hint stream precedes the first page
+    auto& hint = linearization.MustFindKey("H").GetArray();
+    size_t hintOffset = (size_t)hint[0].GetNumber();
+    REQUIRE(hintOffset < firstPageEnd);
+    REQUIRE(hint[1].GetNumber() > 0);
+    PdfParserObject hintObj(input, hintOffset);
+    hintObj.Parse();
+    REQUIRE(hintObj.GetDictionary().HasKey("S"));
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    auto& pages = loaded.GetPages();
+    REQUIRE(pages.GetCount() == 3);
+    for (unsigned i = 0; i < 3; i++)
+    {
+        auto& page = pages.GetPage(i);
+        REQUIRE(page.GetMediaBox().GetWidth() == 100 * (i + 1));
+        auto& obj = page.GetObject().GetDictionary().MustFindKey("Private");
+        REQUIRE(obj.GetDictionary().MustFindKey("Value").GetString().GetString() == "page " + std::to_string(i));
+        charbuff data;
+        obj.MustGetStream().ExtractTo(data);
+        REQUIRE(data == "page data " + std::to_string(i));
+        if (i != 0)
+        {
+            REQUIRE(page.GetObject().GetDictionary().MustFindKey("Shared")
+                .GetDictionary().MustFindKey("Value").GetString().GetString() == "shared");
+        }
+    }
+
+    PdfMemDocument firstPageOnly;
+    firstPageOnly.LoadFromBuffer(buffer, { }, PdfLoadOptions::FirstPageOnly);
+    REQUIRE(firstPageOnly.GetPages().GetCount() == 3);
+    REQUIRE(firstPageOnly.GetPages().GetPage(2).GetMediaBox().GetWidth() == 300);
+}
+
+TEST_CASE("testSaveAsync")
+{
+    PdfMemDocument doc;
+    for (unsigned i = 0; i < 20; i++)
+    {
+        auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        string data;
+        for (unsigned j = 0; j < 10000; j++)
+            data.append(utls::Format("{} {} m\n", i, j));
+        page->GetObject().GetDictionary().AddKey("Test", doc.GetObjects().CreateDictionaryObject()->GetIndirectReference());
+        doc.GetObjects().GetObject(page->GetObject().GetDictionary().MustGetKey("Test").GetReference())
+            ->GetOrCreateStream().Set(data);
+    }
+
+    charbuff expected;
+    BufferStreamDevice expectedDevice(expected);
+    doc.Save(expectedDevice, PdfSaveOptions::NoModifyDateUpdate);
+
+    charbuff buffer;
+    auto device = std::make_shared<BufferStreamDevice>(buffer);
+    auto future = doc.SaveAsync(device, PdfSaveOptions::NoModifyDateUpdate);
+    future.get();
+    REQUIRE(buffer == expected);
+
+    auto testPath = TestUtils::GetTestOutputFilePath("SaveAsync.pdf");
+    doc.SaveAsync(testPath, PdfSaveOptions::NoModifyDateUpdate).get();
+    PdfMemDocument loaded;
+    loaded.Load(testPath);
+    REQUIRE(loaded.GetPages().GetCount() == 20);
+
+    // Errors are rethrown by the future
+    auto readOnly = std::make_shared<SpanStreamDevice>("read only");
+    auto failed = doc.SaveAsync(readOnly, PdfSaveOptions::NoModifyDateUpdate);
+    ASSERT_THROW_WITH_ERROR_CODE(failed.get(), PdfErrorCode::InternalLogic);
+}
+
+TEST_CASE("testSplitDocument")
+{
+    charbuff source;
+    {
+        PdfMemDocument doc;
+        auto shared = doc.GetObjects().CreateDictionaryObject("Shared");
+        for (unsigned i = 0; i < 5; i++)
+        {
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            auto& dict = page->GetObject().GetDictionary();
+            dict.AddKey("Shared", shared->GetIndirectReference());
+            auto contents = doc.GetObjects().CreateDictionaryObject();
+            contents->GetOrCreateStream().Set(utls::Format("(page {}) Tj", i));
+            dict.AddKey("Test", contents->GetIndirectReference());
+        }
+
+        doc.GetPages().GetObject().GetDictionary().AddKey("Rotate", (int64_t)90);
+        BufferStreamDevice device(source);
+        doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(source);
+    PdfDocumentSplitter splitter(doc);
+    REQUIRE(splitter.GetPageCount() == 5);
+    for (unsigned i = 0; i < 5; i++)
+    {
+        charbuff buffer;
+        BufferStreamDevice device(buffer);
+        splitter.WritePages(device, i);
+
+        PdfMemDocument split;
+        split.LoadFromBuffer(buffer);
+        REQUIRE(split.GetPages().GetCount() == 1);
+        auto& page = split.GetPages().GetPage(0);
+        REQUIRE(page.GetRotationRaw() == 90);
+        auto& dict = page.GetObject().GetDictionary();
+        REQUIRE(dict.MustFindKey("Shared").GetDictionary().MustFindKey("Type").GetName() == "Shared");
+        charbuff data;
+        dict.MustFindKey("Test").MustGetStream().ExtractTo(data);
+        REQUIRE(data == utls::Format("(page {}) Tj", i));
+    }
+
+    // The objects shared by the pages are written once
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    splitter.WritePages(device, 1, 3);
+    unsigned count = 0;
+    for (size_t pos = buffer.find("/Shared"); pos != string::npos; pos = buffer.find("/Shared", pos + 1))
+        count++;
+    REQUIRE(count == 4); // The 3 page keys and the object type
+    PdfMemDocument split;
+    split.LoadFromBuffer(buffer);
+    REQUIRE(split.GetPages().GetCount() == 3);
+
+    ASSERT_THROW_WITH_ERROR_CODE(splitter.WritePages(device, 4, 2), PdfErrorCode::ValueOutOfRange);
+}
+
+TEST_CASE("testMergeDocuments")
+{
+    charbuff source;
+    {
+        PdfMemDocument doc;
+        auto fontFile = doc.GetObjects().CreateDictionaryObject();
+        fontFile->GetOrCreateStream().Set(string(10000, 'x'));
+        auto font = doc.GetObjects().CreateDictionaryObject("Font");
+        font->GetDictionary().AddKey("FontFile", fontFile->GetIndirectReference());
+        for (unsigned i = 0; i < 3; i++)
+        {
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            auto contents = doc.GetObjects().CreateDictionaryObject();
+            contents->GetOrCreateStream().Set(utls::Format("(page {}) Tj", i));
+            page->GetObject().GetDictionary().AddKey("Test", contents->GetIndirectReference());
+            page->GetObject().GetDictionary().AddKey("Font", font->GetIndirectReference());
+        }
+
+        doc.GetPages().GetObject().GetDictionary().AddKey("Rotate", (int64_t)90);
+        BufferStreamDevice device(source);
+        doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+
+    PdfMemDocument doc;
+    PdfMergeContext context(doc);
+    vector<unique_ptr<PdfMemDocument>> sources;
+    for (unsigned i = 0; i < 3; i++)
+    {
+        sources.emplace_back(new PdfMemDocument());
+        sources.back()->LoadFromBuffer(source);
+        doc.InsertPages(*sources.back(), 0, 2, context);
+    }
+
+    // The same source document in more calls
+    doc.InsertPages(*sources[0], 2, 1, context);
+    REQUIRE(doc.GetPages().GetCount() == 7);
+
+    // The identical fonts of the source documents are copied once
+    auto fontRef = doc.GetPages().GetPage(0).GetObject().GetDictionary().MustGetKey("Font").GetReference();
+    unsigned fontCount = 0;
+    for (auto obj : doc.GetObjects())
+    {
+        if (obj->IsDictionary() && obj->GetDictionary().FindKeyAs<PdfName>(PdfName::KeyType) == "Font")
+            fontCount++;
+    }
+    REQUIRE(fontCount == 1);
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    REQUIRE(loaded.GetPages().GetCount() == 7);
+    const unsigned expected[] = { 0, 1, 0, 1, 0, 1, 2 };
+    for (unsigned i = 0; i < 7; i++)
+    {
+        auto& page = loaded.GetPages().GetPage(i);
+        REQUIRE(page.GetRotationRaw() == 90);
+        auto& dict = page.GetObject().GetDictionary();
+        REQUIRE(dict.MustGetKey("Font").GetReference() == fontRef);
+        charbuff data;
+        dict.MustFindKey("Test").MustGetStream().ExtractTo(data);
+        REQUIRE(data == utls::Format("(page {}) Tj", expected[i]));
+    }
+
+    charbuff fontData;
+    loaded.GetObjects().MustGetObject(fontRef).GetDictionary().MustFindKey("FontFile").MustGetStream().ExtractTo(fontData);
+    REQUIRE(fontData == string(10000, 'x'));
+
+    PdfMemDocument other;
+    ASSERT_THROW_WITH_ERROR_CODE(other.InsertPages(*sources[0], 0, 1, context), PdfErrorCode::InvalidHandle);
+    ASSERT_THROW_WITH_ERROR_CODE(doc.InsertPages(*sources[0], 2, 2, context), PdfErrorCode::ValueOutOfRange);
+}
+
+TEST_CASE("testNameTreeLookup")
+{
+    PdfMemDocument doc;
+    auto& names = doc.GetOrCreateNameTree();
+    for (unsigned i = 0; i < 500; i++)
+        names.AddValue("Dests", PdfString(utls::Format("dest{:04}", i * 2)), PdfObject((int64_t)i));
+
+    // The values are split in more nodes
+    auto& root = names.GetObject().GetDictionary().MustFindKey("Dests");
+    REQUIRE(root.GetDictionary().HasKey("Kids"));
+
+    auto check = [&]() {
+        for (unsigned i = 0; i < 1000; i++)
+        {
+            auto value = names.GetValue("Dests", PdfString(utls::Format("dest{:04}", i)));
+            if (i % 2 == 0)
+            {
+                REQUIRE(value != nullptr);
+                REQUIRE(value->GetNumber() == i / 2);
+            }
+            else
+            {
+                REQUIRE(value == nullptr);
+            }
+        }
+    };
+
+    check();
+    names.BuildIndex("Dests");
+    check();
+
+    // The index is dropped when the tree is modified
+    names.AddValue("Dests", PdfString("dest0001"), PdfObject((int64_t)1000));
+    REQUIRE(names.GetValue("Dests", PdfString("dest0001"))->GetNumber() == 1000);
+    REQUIRE(names.GetValue("Dests", PdfString("dest0998"))->GetNumber() == 499);
+}
+
+TEST_CASE("testNameTreeBulkInsert")
+{
+    PdfMemDocument doc;
+    auto& names = doc.GetOrCreateNameTree();
+    names.AddValue("Dests", PdfString("dest00001"), PdfObject((int64_t)-1));
+    names.AddValue("Dests", PdfString("other"), PdfObject((int64_t)-2));
+
+    // Insert unsorted values, with a duplicated key
+    vector<pair<PdfString, PdfObject>> values;
+    for (unsigned i = 0; i < 10000; i++)
+    {
+        unsigned key = (i * 7919) % 10000;
+        values.emplace_back(PdfString(utls::Format("dest{:05}", key)), PdfObject((int64_t)key));
+    }
+    values.emplace_back(PdfString("dest00002"), PdfObject((int64_t)-3));
+    names.AddValues("Dests", std::move(values));
+
+    REQUIRE(names.GetValue("Dests", PdfString("dest00001"))->GetNumber() == 1);
+    REQUIRE(names.GetValue("Dests", PdfString("dest00002"))->GetNumber() == -3);
+    REQUIRE(names.GetValue("Dests", PdfString("other"))->GetNumber() == -2);
+    for (unsigned i = 3; i < 10000; i++)
+        REQUIRE(names.GetValue("Dests", PdfString(utls::Format("dest{:05}", i)))->GetNumber() == i);
+
+    // The tree is balanced, and the limits of the nodes are sorted
+    vector<const PdfObject*> nodes = { &names.GetObject().GetDictionary().MustFindKey("Dests") };
+    REQUIRE(!nodes[0]->GetDictionary().HasKey("Limits"));
+    unsigned depth = 0;
+    unsigned leafCount = 0;
+    while (nodes.size() != 0)
+    {
+        vector<const PdfObject*> children;
+        for (auto node : nodes)
+        {
+            auto& dict = node->GetDictionary();
+            if (!dict.HasKey("Kids"))
+            {
+                leafCount++;
+                auto& arr = dict.MustFindKey("Names").GetArray();
+                REQUIRE(arr.size() <= 130);
+                REQUIRE(arr[0].GetString() == dict.MustFindKey("Limits").GetArray()[0].GetString());
+                continue;
+            }
+
+            string last;
+            for (auto& kid : dict.MustFindKey("Kids").GetArray())
+            {
+                auto& child = doc.GetObjects().MustGetObject(kid.GetReference());
+                auto& limits = child.GetDictionary().MustFindKey("Limits").GetArray();
+                REQUIRE(limits[0].GetString().GetString() > last);
+                last = limits[1].GetString().GetString();
+                children.push_back(&child);
+            }
+        }
+
+        if (children.size() != 0)
+            depth++;
+
+        nodes = std::move(children);
+    }
+
+    REQUIRE(depth == 2);
+    REQUIRE(leafCount == 154);
+
+    // The tree is rewritten, so the old nodes are removed
+    unsigned nodeCount = 0;
+    for (auto obj : doc.GetObjects())
+    {
+        if (obj->IsDictionary() && obj->GetDictionary().HasKey("Limits"))
+            nodeCount++;
+    }
+    REQUIRE(nodeCount == leafCount + 3);
+}
+
+TEST_CASE("testOutlineBulkCreate")
+{
+    vector<PdfOutlineNode> nodes(3);
+    for (unsigned i = 0; i < 3; i++)
+    {
+        nodes[i].Title = PdfString(utls::Format("chapter{}", i));
+        nodes[i].Children.resize(2);
+        for (unsigned j = 0; j < 2; j++)
+            nodes[i].Children[j].Title = PdfString(utls::Format("section{}.{}", i, j));
+    }
+    nodes[0].Open = true;
+    nodes[1].Children[1].Children.resize(4);
+    nodes[1].Children[1].Open = true;
+
+    // Long outlines are loaded and freed without recursion
+    nodes[2].Children[0].Children.resize(20000);
+
+    PdfMemDocument doc;
+    auto& outlines = doc.GetOrCreateOutlines();
+    outlines.CreateChildren(nodes);
+
+    auto& first = *outlines.First();
+    REQUIRE(first.GetTitle() == "chapter0");
+    REQUIRE(first.GetDictionary().MustFindKey("Count").GetNumber() == 2);
+    REQUIRE(first.Next()->GetDictionary().MustFindKey("Count").GetNumber() == -6);
+    REQUIRE(first.Next()->Last()->GetDictionary().MustFindKey("Count").GetNumber() == 4);
+    REQUIRE(outlines.Last()->GetDictionary().MustFindKey("Count").GetNumber() == -2);
+    REQUIRE(outlines.GetDictionary().MustFindKey("Count").GetNumber() == 5);
+
+    auto collectTitles = [](PdfOutlineItem& root) {
+        vector<string> titles;
+        for (auto item : root.GetDescendants())
+            titles.push_back(item->GetTitle().GetString());
+        return titles;
+    };
+
+    auto titles = collectTitles(outlines);
+    REQUIRE(titles.size() == 20013);
+    REQUIRE(titles[0] == "chapter0");
+    REQUIRE(titles[1] == "section0.0");
+    REQUIRE(titles[5] == "section1.1");
+    REQUIRE(titles[11] == "section2.0");
+    REQUIRE(titles[20012] == "section2.1");
+
+    // Appended children update the counts of the open ancestors
+    PdfOutlineNode added;
+    added.Title = PdfString("section0.2");
+    first.CreateChildren({ added });
+    REQUIRE(first.GetDictionary().MustFindKey("Count").GetNumber() == 3);
+    REQUIRE(outlines.GetDictionary().MustFindKey("Count").GetNumber() == 6);
+    REQUIRE(first.Last()->GetTitle() == "section0.2");
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    auto reloadedTitles = collectTitles(*loaded.GetOutlines());
+    REQUIRE(reloadedTitles.size() == 20014);
+    REQUIRE(reloadedTitles[3] == "section0.2");
+    REQUIRE(loaded.GetOutlines()->Last()->Last()->GetTitle() == "section2.1");
+}
+
+TEST_CASE("testMinimalSave")
+{
+    PdfMemDocument doc;
+    for (unsigned i = 0; i < 10; i++)
+    {
+        auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto contents = doc.GetObjects().CreateDictionaryObject();
+        contents->GetOrCreateStream().Set(utls::Format("(page {}) Tj", i));
+        page->GetObject().GetDictionary().AddKey("Test", contents->GetIndirectReference());
+    }
+
+    charbuff compact;
+    BufferStreamDevice compactDevice(compact);
+    doc.Save(compactDevice, PdfSaveOptions::NoModifyDateUpdate);
+
+    charbuff minimal;
+    BufferStreamDevice device(minimal);
+    doc.Save(device, PdfSaveOptions::NoModifyDateUpdate | PdfSaveOptions::Minimal);
+    REQUIRE(minimal.size() < compact.size());
+    REQUIRE(minimal.find(" obj<<") != string::npos);
+    REQUIRE(minimal.find(">>stream\n") != string::npos);
+    REQUIRE(minimal.find(">>endobj") != string::npos);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(minimal);
+    REQUIRE(loaded.GetPages().GetCount() == 10);
+    charbuff data;
+    loaded.GetPages().GetPage(9).GetObject().GetDictionary().MustFindKey("Test").MustGetStream().ExtractTo(data);
+    REQUIRE(data == "(page 9) Tj");
+}
+
+#ifdef PDFMM_HAVE_TRACING
+
+namespace
+{
+    class TestTraceSink final : public PdfTraceSink
+    {
+    public:
+        struct Event
+        {
+            PdfTraceEventType Type;
+            const PdfDocument* Document;
+            PdfReference Reference;
+            PdfFilterType Filter;
+            size_t OutputLength;
+            string Name;
+        };
+
+        void OnEvent(const PdfTraceEvent& ev) override
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Events.push_back({ ev.Type, ev.Document, ev.Reference, ev.Filter, ev.OutputLength, string(ev.Name) });
+        }
+
+        const Event* Find(PdfTraceEventType type, const string_view& name = { }) const
+        {
+            for (auto& ev : Events)
+            {
+                if (ev.Type == type && (name.empty() || ev.Name == name))
+                    return &ev;
+            }
+
+            return nullptr;
+        }
+
+    public:
+        vector<Event> Events;
+
+    private:
+        std::mutex m_mutex;
+    };
+}
+
+TEST_CASE("testTraceEvents")
+{
+    REQUIRE(PdfTrace::IsSupported());
+
+    TestTraceSink saveSink;
+    PdfMemDocument doc;
+    doc.SetTraceSink(&saveSink);
+    auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    auto contents = doc.GetObjects().CreateDictionaryObject();
+    contents->GetOrCreateStream().Set(string_view("(traced) Tj"));
+    page->GetObject().GetDictionary().AddKey("Test", contents->GetIndirectReference());
+    (void)doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+
+    auto font = saveSink.Find(PdfTraceEventType::FontLoad);
+    REQUIRE(font != nullptr);
+    REQUIRE(font->Name.find("Helvetica") != string::npos);
+    REQUIRE(saveSink.Find(PdfTraceEventType::WriterPhase, "header") != nullptr);
+    REQUIRE(saveSink.Find(PdfTraceEventType::WriterPhase, "xref") != nullptr);
+    auto objects = saveSink.Find(PdfTraceEventType::WriterPhase, "objects");
+    REQUIRE(objects != nullptr);
+    REQUIRE(objects->OutputLength > 0);
+    REQUIRE(objects->OutputLength < buffer.size());
+
+    TestTraceSink loadSink;
+    PdfMemDocument loaded;
+    loaded.SetTraceSink(&loadSink);
+    loaded.LoadFromBuffer(buffer);
+    REQUIRE(loadSink.Find(PdfTraceEventType::XRefSectionRead) != nullptr);
+
+    auto& loadedContents = loaded.GetObjects().MustGetObject(contents->GetIndirectReference());
+    charbuff data;
+    loadedContents.MustGetStream().ExtractTo(data);
+    REQUIRE(data == "(traced) Tj");
+
+    auto load = std::find_if(loadSink.Events.begin(), loadSink.Events.end(), [&](const TestTraceSink::Event& ev) {
+        return ev.Type == PdfTraceEventType::ObjectLoad && ev.Reference == contents->GetIndirectReference();
+    });
+    REQUIRE(load != loadSink.Events.end());
+    auto decode = loadSink.Find(PdfTraceEventType::StreamDecode);
+    REQUIRE(decode != nullptr);
+    REQUIRE(decode->Reference == contents->GetIndirectReference());
+    REQUIRE(decode->Filter == PdfFilterType::FlateDecode);
+    REQUIRE(decode->OutputLength == data.size());
+
+    // The global sink receives the events of the
+    // documents without a sink of their own
+    TestTraceSink globalSink;
+    PdfTrace::SetGlobalSink(&globalSink);
+    loadSink.Events.clear();
+    PdfMemDocument other;
+    other.LoadFromBuffer(buffer);
+    loaded.LoadFromBuffer(buffer);
+    PdfTrace::SetGlobalSink(nullptr);
+    REQUIRE(globalSink.Find(PdfTraceEventType::XRefSectionRead) != nullptr);
+    REQUIRE(loadSink.Find(PdfTraceEventType::XRefSectionRead) != nullptr);
+    for (auto& ev : globalSink.Events)
+        REQUIRE(ev.Document == &other);
+}
+
+TEST_CASE("testTraceContentsProfile")
+{
+    TestTraceSink sink;
+    PdfMemDocument doc;
+    doc.SetTraceSink(&sink);
+    auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    page->GetOrCreateContents().GetStreamForAppending(PdfStreamAppendFlags::None).Set("0 0 m 10 10 l S"sv);
+
+    PdfContentsProfiler profiler;
+    (void)profiler.Profile(*page);
+    auto profile = sink.Find(PdfTraceEventType::ContentsProfile, "page");
+    REQUIRE(profile != nullptr);
+    REQUIRE(profile->Reference == page->GetObject().GetIndirectReference());
+    REQUIRE(profile->OutputLength == 3);
+}
+
+#endif // PDFMM_HAVE_TRACING
@@ -0,0 +1,190 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <PdfTest.h>
+#include "TestUtils.h"
+
+using namespace std;
+using namespace mm;
+
+namespace
+{
+    class TestSigner : public PdfSigner
+    {
+    public:
+        void Reset() override
+        {
+            Data.clear();
+        }
+
+        void AppendData(const bufferview& data) override
+        {
+            Data.append(data.data(), data.size());
+        }
+
+        void ComputeSignature(charbuff& buffer, bool dryrun) override
+        {
+            if (dryrun)
+                DryRunCount++;
+
+            buffer.assign(16, 'S');
+        }
+
+        size_t GetSignatureSize() const override
+        {
+            return SignatureSize;
+        }
+
+        string GetSignatureSubFilter() const override
+        {
+            return "adbe.pkcs7.detached";
+        }
+
+        string GetSignatureType() const override
+        {
+            return "Sig";
+        }
+
+    public:
+        string Data;
+        size_t SignatureSize = 0;
+        unsigned DryRunCount = 0;
+    };
+
+    class TestDigester : public PdfSignatureDigester
+    {
+    public:
+        void AppendData(const bufferview& data) override
+        {
+            m_data.append(data.data(), data.size());
+        }
+
+        void ComputeDigest(charbuff& digest) override
+        {
+            digest = m_data;
+        }
+
+    private:
+        string m_data;
+    };
+}
+
+TEST_CASE("testSignDocument")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    PdfSignature signature(doc.GetPages().GetPage(0), PdfRect());
+    charbuff output = buffer;
+    BufferStreamDevice device(output);
+    TestSigner signer;
+    SignDocument(doc, device, signer, signature);
+
+    // The signed data must be the output without the signature contents
+    PdfMemDocument signedDoc;
+    signedDoc.LoadFromBuffer(output);
+    const PdfArray* byteRange = nullptr;
+    for (auto obj : signedDoc.GetObjects())
+    {
+        const PdfObject* value;
+        if (obj->IsDictionary() && (value = obj->GetDictionary().FindKey("ByteRange")) != nullptr)
+            byteRange = &value->GetArray();
+    }
+    REQUIRE(byteRange != nullptr);
+    REQUIRE(byteRange->GetSize() == 4);
+    string expected(output.data() + (*byteRange)[0].GetNumber(), (size_t)(*byteRange)[1].GetNumber());
+    expected.append(output.data() + (*byteRange)[2].GetNumber(), (size_t)(*byteRange)[3].GetNumber());
+    REQUIRE((*byteRange)[2].GetNumber() + (*byteRange)[3].GetNumber() == (int64_t)output.size());
+    REQUIRE(signer.Data == expected);
+}
+
+TEST_CASE("testComputeSignatureDigests")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    // Sign two incremental revisions
+    vector<string> signedData;
+    for (unsigned i = 0; i < 2; i++)
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(buffer);
+        PdfSignature signature(doc.GetPages().GetPage(0), PdfRect());
+        charbuff output = buffer;
+        BufferStreamDevice device(output);
+        TestSigner signer;
+        SignDocument(doc, device, signer, signature);
+        signedData.push_back(signer.Data);
+        buffer = output;
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    SpanStreamDevice device(buffer);
+    unsigned digesterCount = 0;
+    auto digests = ComputeSignatureDigests(doc, device, [&digesterCount](const PdfObject& signature) {
+        REQUIRE(signature.GetDictionary().MustFindKey("SubFilter").GetName() == "adbe.pkcs7.detached");
+        digesterCount++;
+        return std::make_unique<TestDigester>();
+    });
+
+    REQUIRE(digesterCount == 2);
+    REQUIRE(digests.size() == 2);
+    for (unsigned i = 0; i < 2; i++)
+    {
+        REQUIRE(digests[i].ByteRange.size() == 2);
+        REQUIRE(digests[i].Contents == string(16, 'S'));
+        REQUIRE(digests[i].Digest == signedData[i]);
+    }
+
+    // The last signature covers the whole file
+    REQUIRE(digests[1].ByteRange[1].first + digests[1].ByteRange[1].second == buffer.size());
+}
+
+TEST_CASE("testSignDocumentFixedSize")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    PdfSignature signature(doc.GetPages().GetPage(0), PdfRect());
+    BufferStreamDevice device(buffer);
+    TestSigner signer;
+    signer.SignatureSize = 64;
+    SignDocument(doc, device, signer, signature);
+
+    // The space of the signature is reserved with no dry run
+    REQUIRE(signer.DryRunCount == 0);
+    PdfMemDocument signedDoc;
+    signedDoc.LoadFromBuffer(buffer);
+    SpanStreamDevice input(buffer);
+    auto digests = ComputeSignatureDigests(signedDoc, input, [](const PdfObject&) {
+        return std::make_unique<TestDigester>();
+    });
+    REQUIRE(digests.size() == 1);
+    REQUIRE(digests[0].Contents.size() == 64);
+    REQUIRE(digests[0].Contents.substr(0, 16) == string(16, 'S'));
+    REQUIRE(digests[0].Digest == signer.Data);
+}
@@ -0,0 +1,163 @@
+/**
+ * Copyright (C) 2022 by Francesco Pretto <ceztko@gmail.com>
+ *
+ * Licensed under GNU Library General Public 2.0 or later.
+ * Some rights reserved. See COPYING, AUTHORS.
+ */
+
+#include <PdfTest.h>
+#include "TestUtils.h"
+
+using namespace std;
+using namespace mm;
+
+TEST_CASE("testStreamedCompressObjects")
+{
+    charbuff buffer;
+    vector<PdfReference> refs;
+    {
+        auto device = std::make_shared<BufferStreamDevice>(buffer);
+        PdfStreamedDocument doc(device, PdfVersionDefault, nullptr, PdfSaveOptions::CompressObjects);
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto& objects = doc.GetObjects();
+        objects.SetBatchSize(16);
+        for (unsigned i = 0; i < 250; i++)
+        {
+            auto obj = objects.CreateDictionaryObject("Test");
+            obj->GetDictionary().AddKey("Index", (int64_t)i);
+            obj->GetDictionary().AddKey("Value", PdfString("value " + std::to_string(i)));
+            refs.push_back(obj->GetIndirectReference());
+            objects.QueueObject(*obj);
+        }
+
+        // The finished objects are freed after being written
+        REQUIRE(objects.GetObject(refs.front()) == nullptr);
+        doc.Close();
+    }
+
+    REQUIRE(buffer.find("/ObjStm") != string::npos);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    REQUIRE(loaded.GetPages().GetCount() == 1);
+    for (unsigned i = 0; i < refs.size(); i++)
+    {
+        auto& dict = loaded.GetObjects().MustGetObject(refs[i]).GetDictionary();
+        REQUIRE(dict.MustFindKey("Index").GetNumber() == i);
+        REQUIRE(dict.MustFindKey("Value").GetString().GetString() == "value " + std::to_string(i));
+    }
+}
+
+TEST_CASE("testStreamedBackgroundCompression")
+{
+    charbuff buffer;
+    vector<PdfReference> refs;
+    {
+        auto device = std::make_shared<BufferStreamDevice>(buffer);
+        PdfStreamedDocument doc(device);
+        doc.SetMaxStreamsInFlight(2);
+        doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto& objects = doc.GetObjects();
+        for (unsigned i = 0; i < 20; i++)
+        {
+            auto obj = objects.CreateDictionaryObject("Test");
+            string data;
+            for (unsigned j = 0; j < 1000; j++)
+                data.append("stream data " + std::to_string(i) + "\n");
+            obj->GetOrCreateStream().Set(data);
+            refs.push_back(obj->GetIndirectReference());
+        }
+
+        // The compressed streams are written and freed
+        // when too many are waiting to be written
+        REQUIRE(objects.GetObject(refs.front()) == nullptr);
+        doc.Close();
+    }
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    REQUIRE(loaded.GetPages().GetCount() == 1);
+    for (unsigned i = 0; i < refs.size(); i++)
+    {
+        auto& obj = loaded.GetObjects().MustGetObject(refs[i]);
+        REQUIRE(obj.GetDictionary().MustFindKey("Filter").GetName() == "FlateDecode");
+        charbuff data;
+        obj.MustGetStream().ExtractTo(data);
+        string line = "stream data " + std::to_string(i) + "\n";
+        REQUIRE(data.size() == 1000 * line.size());
+        REQUIRE(data.substr(0, line.size()) == line);
+    }
+}
+
+TEST_CASE("testMergeDocumentsStreamed")
+{
+    vector<charbuff> sources;
+    for (unsigned i = 0; i < 3; i++)
+    {
+        PdfMemDocument doc;
+        auto fontFile = doc.GetObjects().CreateDictionaryObject();
+        fontFile->GetOrCreateStream().Set(string(10000, 'x'));
+        auto font = doc.GetObjects().CreateDictionaryObject("Font");
+        font->GetDictionary().AddKey("FontFile", fontFile->GetIndirectReference());
+        for (unsigned j = 0; j < 2; j++)
+        {
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            auto contents = doc.GetObjects().CreateDictionaryObject();
+            contents->GetOrCreateStream().Set(utls::Format("(document {} page {}) Tj", i, j));
+            page->GetObject().GetDictionary().AddKey("Test", contents->GetIndirectReference());
+            page->GetObject().GetDictionary().AddKey("Font", font->GetIndirectReference());
+        }
+
+        doc.GetPages().GetObject().GetDictionary().AddKey("Rotate", (int64_t)90);
+        sources.emplace_back();
+        BufferStreamDevice device(sources.back());
+        doc.Save(device, PdfSaveOptions::NoModifyDateUpdate);
+    }
+
+    charbuff buffer;
+    {
+        auto device = std::make_shared<BufferStreamDevice>(buffer);
+        PdfStreamedDocument doc(device);
+        PdfMergeContext context(doc);
+        for (auto& source : sources)
+        {
+            context.AppendDocument(std::make_shared<SpanStreamDevice>(source));
+
+            // The copied objects are written as soon as the source is done: only
+            // the catalog, the info, the page tree root and the stream lengths are left
+            unsigned dictCount = 0;
+            for (auto obj : doc.GetObjects())
+            {
+                if (obj->IsDictionary())
+                    dictCount++;
+            }
+            REQUIRE(dictCount == 3);
+        }
+
+        REQUIRE(doc.GetPages().GetCount() == 6);
+        doc.Close();
+    }
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    REQUIRE(loaded.GetPages().GetCount() == 6);
+    PdfReference fontRef;
+    for (unsigned i = 0; i < 6; i++)
+    {
+        auto& page = loaded.GetPages().GetPage(i);
+        REQUIRE(page.GetRotationRaw() == 90);
+        auto& dict = page.GetObject().GetDictionary();
+        if (i == 0)
+            fontRef = dict.MustGetKey("Font").GetReference();
+
+        // The identical fonts of the source documents are copied once
+        REQUIRE(dict.MustGetKey("Font").GetReference() == fontRef);
+        charbuff data;
+        dict.MustFindKey("Test").MustGetStream().ExtractTo(data);
+        REQUIRE(data == utls::Format("(document {} page {}) Tj", i / 2, i % 2));
+    }
+
+    charbuff fontData;
+    loaded.GetObjects().MustGetObject(fontRef).GetDictionary().MustFindKey("FontFile").MustGetStream().ExtractTo(fontData);
+    REQUIRE(fontData == string(10000, 'x'));
+}
@@ -8,6 +8,9 @@
 
 #include <PdfTest.h>
 
+#include <utfcpp/utf8.h>
+#include <pdfmm/private/PdfEncodingPrivate.h>
+
 using namespace std;
 using namespace mm;
 
@@ -117,6 +120,24 @@ TEST_CASE("testWriteEscapeSequences")
     TestWriteEscapeSequences("(9Hello\003World)", "(9Hello\003World)");
 }
 
+TEST_CASE("testWriteHexString")
+{
+    // Cover the lengths around the vectorized blocks
+    const char* digits = "0123456789ABCDEF";
+    string data;
+    string expected = "<>";
+    for (unsigned i = 0; i < 70; i++)
+    {
+        REQUIRE(PdfString::FromRaw(data).ToString() == expected);
+        char ch = (char)(i * 37 + 11);
+        data.push_back(ch);
+        expected.pop_back();
+        expected.push_back(digits[(unsigned char)ch >> 4]);
+        expected.push_back(digits[(unsigned char)ch & 0xF]);
+        expected.push_back('>');
+    }
+}
+
 TEST_CASE("testEmptyString")
 {
     const char* empty = "";
@@ -155,6 +176,88 @@ TEST_CASE("testInitFromUtf8")
     REQUIRE(str.GetString() == string(utf8));
 }
 
+TEST_CASE("testUnicodeConversions")
+{
+    // Place the non ASCII characters around the boundaries
+    // of the vectorized runs, and in the scalar tails
+    string_view fragments[] = { u8"é", u8"請", u8"😀", "\x7F", "\x1F" };
+    for (auto& fragment : fragments)
+    {
+        for (size_t length : { 0, 1, 15, 16, 17, 31, 32, 33, 47, 70 })
+        {
+            for (size_t position : { (size_t)0, length / 2, length })
+            {
+                string utf8(length, 'a');
+                for (size_t i = 0; i < length; i++)
+                    utf8[i] = (char)('!' + i % 90);
+                utf8.insert(position, fragment);
+
+                u16string utf16;
+                utf8::utf8to16(utf8.begin(), utf8.end(), std::back_inserter(utf16));
+                string expected;
+                for (char16_t unit : utf16)
+                {
+                    expected.push_back((char)(unit >> 8));
+                    expected.push_back((char)(unit & 0xFF));
+                }
+
+                string utf16be;
+                ConvertUTF8ToUTF16BE(utf8, utf16be);
+                REQUIRE(utf16be == expected);
+
+                string converted;
+                ConvertUTF16BEToUTF8(utf16be, converted);
+                REQUIRE(converted == utf8);
+
+                string pdfDocEncoded;
+                bool isAsciiEqual;
+                bool hasPdfDocEncoding = CheckValidUTF8ToPdfDocEcondingChars(utf8, isAsciiEqual);
+                REQUIRE(TryConvertUTF8ToPdfDocEncoding(utf8, pdfDocEncoded) == hasPdfDocEncoding);
+                if (!hasPdfDocEncoding)
+                    continue;
+
+                REQUIRE(!isAsciiEqual);
+                ConvertPdfDocEncodingToUTF8(pdfDocEncoded, converted, isAsciiEqual);
+                REQUIRE(converted == utf8);
+            }
+        }
+    }
+
+    // Odd utf-16 ranges and invalid utf-8 are rejected
+    string converted;
+    REQUIRE_THROWS(ConvertUTF16BEToUTF8(string_view("\0a\0", 3), converted));
+    REQUIRE_THROWS(ConvertUTF8ToUTF16BE(string(40, 'a') + "\xC3", converted));
+
+    // Unicode strings are written as utf-16 BE with BOM
+    PdfString str(u8"Текст with ASCII text longer than 16 characters");
+    REQUIRE(str.GetState() == PdfStringState::Unicode);
+    string written;
+    str.ToString(written);
+    PdfTokenizer tokenizer;
+    SpanStreamDevice device(written);
+    PdfVariant variant;
+    REQUIRE(tokenizer.TryReadNextVariant(device, variant));
+    REQUIRE(variant.GetString().GetString() == str.GetString());
+}
+
+TEST_CASE("testStringStream")
+{
+    PdfStringStream stream;
+    stream << 10 << " " << -3 << " " << 4294967296u << " " << 1.5 << " " << 0.1f << " re" << endl;
+    stream << 'm' << " " << PdfName("Name") << " " << string("str") << endl;
+    REQUIRE(stream.GetString() == "10 -3 4294967296 1.5 0.1 re\nm Name str\n");
+
+    // Writes to std::ostream keep the order with direct writes
+    stream.Clear();
+    stream.SetPrecision(2);
+    stream << 1.23456 << " ";
+    ((ostream&)stream) << "<" << 42 << ">";
+    stream << " " << 2.0 << std::flush;
+    REQUIRE(stream.GetString() == "1.23 <42> 2");
+    REQUIRE(stream.TakeString() == "1.23 <42> 2");
+    REQUIRE(stream.GetSize() == 0);
+}
+
 void TestWriteEscapeSequences(const string_view& str, const string_view& expected)
 {
     PdfVariant variant;
@@ -30,3 +30,513 @@ TEST_CASE("TextExtraction1")
     ASSERT_EQUAL(entries[11].X, 29.000000232);
     ASSERT_EQUAL(entries[11].Y, 664.872605318981);
 }
+
+TEST_CASE("TextExtractionConcurrent")
+{
+    constexpr unsigned PageCount = 12;
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+        for (unsigned i = 0; i < PageCount; i++)
+        {
+            PdfPainter painter;
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            painter.SetCanvas(page);
+            painter.GetTextState().SetFont(font, 12);
+            painter.DrawText(utls::Format("Page {} first line", i), 100, 700);
+            painter.DrawText(utls::Format("Page {} second line", i), 100, 600);
+            painter.FinishDrawing();
+        }
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    vector<unsigned> pages = { 7, 2, 11, 0, 5, 3 };
+    auto extracted = doc.ExtractText(pages, { }, 4);
+    REQUIRE(doc.IsFrozen());
+    REQUIRE(extracted.size() == pages.size());
+    for (unsigned i = 0; i < pages.size(); i++)
+    {
+        auto& entries = extracted[i];
+        REQUIRE(entries.size() == 2);
+        REQUIRE(entries[0].Text == utls::Format("Page {} first line", pages[i]));
+        REQUIRE(entries[0].Page == (int)pages[i]);
+        REQUIRE(entries[1].Text == utls::Format("Page {} second line", pages[i]));
+    }
+
+    // All the pages, compared with the serial extraction
+    extracted = doc.ExtractText();
+    REQUIRE(extracted.size() == PageCount);
+    for (unsigned i = 0; i < PageCount; i++)
+    {
+        vector<PdfTextEntry> entries;
+        doc.GetPages().GetPage(i).ExtractTextTo(entries);
+        REQUIRE(extracted[i].size() == entries.size());
+        for (unsigned j = 0; j < entries.size(); j++)
+        {
+            REQUIRE(extracted[i][j].Text == entries[j].Text);
+            REQUIRE(extracted[i][j].X == entries[j].X);
+            REQUIRE(extracted[i][j].Y == entries[j].Y);
+        }
+    }
+
+    vector<unsigned> invalid = { PageCount };
+    REQUIRE_THROWS(doc.ExtractText(invalid));
+}
+
+TEST_CASE("TextExtractionHandler")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+        auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        PdfPainter painter;
+        painter.SetCanvas(page);
+        painter.GetTextState().SetFont(font, 12);
+        painter.DrawText("Hello World", 100, 700);
+        painter.DrawText("Second line", 100, 600);
+        painter.FinishDrawing();
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    auto& page = doc.GetPages().GetPage(0);
+    vector<PdfTextEntry> entries;
+    page.ExtractTextTo(entries);
+    REQUIRE(entries.size() == 2);
+
+    unsigned count = 0;
+    page.ExtractTextTo([&](const PdfTextEntryView& entry)
+    {
+        REQUIRE(count < entries.size());
+        REQUIRE(entry.Text == entries[count].Text);
+        REQUIRE(entry.X == entries[count].X);
+        REQUIRE(entry.Y == entries[count].Y);
+        REQUIRE(entry.Font != nullptr);
+
+        PdfTextState state;
+        state.Font = entry.Font;
+        state.FontSize = 12;
+        ASSERT_EQUAL(entry.Length, entry.Font->GetStringWidth(entry.Text, state));
+        count++;
+    });
+    REQUIRE(count == 2);
+}
+
+TEST_CASE("TextExtractionFormCache")
+{
+    constexpr unsigned PageCount = 3;
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+        PdfXObjectForm header(doc, PdfRect(0, 0, 300, 50));
+        {
+            PdfPainter painter;
+            painter.SetCanvas(&header);
+            painter.GetTextState().SetFont(font, 10);
+            painter.DrawText("Shared header", 10, 20);
+            painter.FinishDrawing();
+        }
+
+        for (unsigned i = 0; i < PageCount; i++)
+        {
+            PdfPainter painter;
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            painter.SetCanvas(page);
+            painter.DrawXObject(header, 50, 780);
+            painter.GetTextState().SetFont(font, 12);
+            painter.DrawText(utls::Format("Body {}", i), 100, 400);
+            painter.FinishDrawing();
+        }
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    PdfTextExtractParams params;
+    params.ContentsCache = std::make_shared<PdfContentsCache>();
+    for (unsigned i = 0; i < PageCount; i++)
+    {
+        auto& page = doc.GetPages().GetPage(i);
+        vector<PdfTextEntry> cached;
+        page.ExtractTextTo(cached, params);
+        vector<PdfTextEntry> uncached;
+        page.ExtractTextTo(uncached);
+
+        REQUIRE(cached.size() == 2);
+        REQUIRE(cached[0].Text == "Shared header");
+        REQUIRE(cached[1].Text == utls::Format("Body {}", i));
+        REQUIRE(cached.size() == uncached.size());
+        for (unsigned j = 0; j < cached.size(); j++)
+        {
+            REQUIRE(cached[j].Text == uncached[j].Text);
+            REQUIRE(cached[j].X == uncached[j].X);
+            REQUIRE(cached[j].Y == uncached[j].Y);
+        }
+    }
+
+    // The form is tokenized once for all the pages
+    REQUIRE(params.ContentsCache->GetSize() == 1);
+}
+
+TEST_CASE("TextExtractionCompiledContents")
+{
+    constexpr unsigned PageCount = 2;
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+        PdfXObjectForm header(doc, PdfRect(0, 0, 300, 50));
+        {
+            PdfPainter painter;
+            painter.SetCanvas(&header);
+            painter.GetTextState().SetFont(font, 10);
+            painter.DrawText("Shared header", 10, 20);
+            painter.FinishDrawing();
+        }
+
+        for (unsigned i = 0; i < PageCount; i++)
+        {
+            PdfPainter painter;
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            painter.SetCanvas(page);
+            painter.DrawXObject(header, 50, 780);
+            painter.GetTextState().SetFont(font, 12);
+            painter.DrawText(utls::Format("Body {}", i), 100, 400);
+            painter.FinishDrawing();
+        }
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    PdfTextExtractParams params;
+    params.ContentsCache = std::make_shared<PdfContentsCache>();
+    for (unsigned i = 0; i < PageCount; i++)
+        params.ContentsCache->Compile(doc.GetPages().GetPage(i));
+
+    REQUIRE(params.ContentsCache->GetSize() == PageCount);
+
+    auto& page = doc.GetPages().GetPage(0);
+    auto readContents = [&](nullable<const PdfContentReaderArgs&> args) {
+        vector<PdfContentType> types;
+        PdfContentsReader reader(page, args);
+        PdfContent content;
+        while (reader.TryReadNext(content))
+            types.push_back(content.Type);
+        return types;
+    };
+
+    PdfContentReaderArgs args;
+    args.Cache = params.ContentsCache;
+    auto replayed = readContents(args);
+    REQUIRE(replayed == readContents({ }));
+    REQUIRE(std::count(replayed.begin(), replayed.end(), PdfContentType::DoXObject) == 1);
+    REQUIRE(std::count(replayed.begin(), replayed.end(), PdfContentType::EndXObjectForm) == 1);
+
+    // The form drawn by the pages is cached when replaying
+    REQUIRE(params.ContentsCache->GetSize() == PageCount + 1);
+
+    vector<PdfTextEntry> entries;
+    page.ExtractTextTo(entries, params);
+    REQUIRE(entries.size() == 2);
+    REQUIRE(entries[1].Text == "Body 0");
+
+    // The compiled contents are replayed until removed
+    page.GetContents()->Reset();
+    entries.clear();
+    page.ExtractTextTo(entries, params);
+    REQUIRE(entries.size() == 2);
+
+    params.ContentsCache->Remove(page);
+    entries.clear();
+    page.ExtractTextTo(entries, params);
+    REQUIRE(entries.size() == 0);
+}
+
+TEST_CASE("TextIndex")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+        for (unsigned i = 0; i < 3; i++)
+        {
+            PdfPainter painter;
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            painter.SetCanvas(page);
+            painter.GetTextState().SetFont(font, 12);
+            painter.DrawText(utls::Format("Hello world page{}", i), 100, 700);
+            if (i == 1)
+                painter.DrawText("HELLO again", 100, 600);
+            painter.FinishDrawing();
+        }
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    PdfTextIndex index;
+    index.Build(doc);
+    REQUIRE(index.GetPageCount() == 3);
+
+    auto matches = index.Find("Hello");
+    REQUIRE(matches.size() == 3);
+    for (unsigned i = 0; i < 3; i++)
+    {
+        REQUIRE(matches[i].Page == i);
+        ASSERT_EQUAL(matches[i].Rect.GetLeft(), 100);
+        ASSERT_EQUAL(matches[i].Rect.GetBottom(), 700);
+        REQUIRE(matches[i].Rect.GetWidth() > 0);
+        ASSERT_EQUAL(matches[i].Rect.GetHeight(), 12);
+    }
+
+    matches = index.Find("hello", true);
+    REQUIRE(matches.size() == 4);
+    REQUIRE(matches[2].Page == 1);
+    REQUIRE(matches[2].Word == "HELLO");
+    ASSERT_EQUAL(matches[2].Rect.GetBottom(), 600);
+    REQUIRE(index.Find("hello").size() == 0);
+
+    // Searches match the words as the extraction with TokenizeWords
+    matches = index.Search("page[12]");
+    REQUIRE(matches.size() == 2);
+    REQUIRE(matches[0].Word == "page1");
+    REQUIRE(matches[1].Word == "page2");
+    for (unsigned i = 0; i < 3; i++)
+    {
+        vector<PdfTextEntry> entries;
+        PdfTextExtractParams params;
+        params.Flags = PdfTextExtractFlags::TokenizeWords | PdfTextExtractFlags::IgnoreCase;
+        doc.GetPages().GetPage(i).ExtractTextTo(entries, "^hel", params);
+        auto found = index.Search("^hel", PdfTextExtractFlags::IgnoreCase);
+        auto count = std::count_if(found.begin(), found.end(),
+            [i](const PdfTextIndexMatch& match) { return match.Page == i; });
+        REQUIRE((size_t)count == entries.size());
+    }
+
+    // Save and load back the index
+    charbuff saved;
+    {
+        BufferStreamDevice device(saved);
+        index.Save(device);
+    }
+
+    PdfTextIndex loaded;
+    SpanStreamDevice device(saved);
+    loaded.Load(device);
+    REQUIRE(loaded.GetPageCount() == 3);
+    REQUIRE(loaded.GetWordCount() == index.GetWordCount());
+    auto loadedMatches = loaded.Find("hello", true);
+    matches = index.Find("hello", true);
+    REQUIRE(loadedMatches.size() == matches.size());
+    for (unsigned i = 0; i < matches.size(); i++)
+    {
+        REQUIRE(loadedMatches[i].Word == matches[i].Word);
+        REQUIRE(loadedMatches[i].Page == matches[i].Page);
+        REQUIRE(loadedMatches[i].Rect.GetLeft() == matches[i].Rect.GetLeft());
+        REQUIRE(loadedMatches[i].Rect.GetWidth() == matches[i].Rect.GetWidth());
+    }
+
+    saved[0] = 'X';
+    SpanStreamDevice invalid(saved);
+    REQUIRE_THROWS(loaded.Load(invalid));
+}
+
+TEST_CASE("TextSpatialIndex")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+        auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        PdfPainter painter;
+        painter.SetCanvas(page);
+        painter.GetTextState().SetFont(font, 10);
+        for (unsigned i = 0; i < 40; i++)
+            painter.DrawText(utls::Format("Cell {}", i), 50 + (i % 5) * 100, 100 + i * 18);
+        painter.FinishDrawing();
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    auto& page = doc.GetPages().GetPage(0);
+    PdfTextSpatialIndex index;
+    index.Build(page);
+    REQUIRE(index.GetEntryCount() == 40);
+
+    // The queries match the extraction with a clip rect
+    for (auto& rect : { PdfRect(0, 0, 600, 800), PdfRect(40, 90, 120, 100), PdfRect(240, 330, 300, 20), PdfRect(0, 0, 10, 10) })
+    {
+        PdfTextExtractParams params;
+        params.ClipRect = rect;
+        vector<PdfTextEntry> expected;
+        page.ExtractTextTo(expected, params);
+
+        auto entries = index.Find(rect);
+        REQUIRE(entries.size() == expected.size());
+        for (unsigned i = 0; i < entries.size(); i++)
+        {
+            REQUIRE(entries[i].Text == expected[i].Text);
+            REQUIRE(entries[i].X == expected[i].X);
+            REQUIRE(entries[i].Y == expected[i].Y);
+        }
+    }
+
+    auto entries = index.Find(PdfRect(40, 90, 120, 100));
+    REQUIRE(entries.size() == 3);
+    REQUIRE(entries[0].Text == "Cell 0");
+    REQUIRE(entries[1].Text == "Cell 1");
+    REQUIRE(entries[2].Text == "Cell 5");
+
+    // The glyph rect of "Cell 0" starts at 50, 100
+    entries = index.FindIntersecting(PdfRect(60, 102, 1, 1));
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].Text == "Cell 0");
+    REQUIRE(index.Find(PdfRect(60, 102, 1, 1)).size() == 0);
+}
+
+TEST_CASE("TextExtractionDecodeCache")
+{
+    constexpr unsigned PageCount = 3;
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+        for (unsigned i = 0; i < PageCount; i++)
+        {
+            PdfPainter painter;
+            auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+            painter.SetCanvas(page);
+            painter.GetTextState().SetFont(font, 12);
+            painter.DrawText("Quantity", 100, 700);
+            painter.DrawText("Price", 100, 650);
+            painter.DrawText(utls::Format("Row {}", i), 100, 600);
+
+            // The same strings with a different size and spacing
+            painter.GetTextState().SetFont(font, 20);
+            painter.GetTextState().SetCharSpacing(2);
+            painter.DrawText("Quantity", 100, 400);
+            painter.DrawText("Price", 200, 300);
+            painter.FinishDrawing();
+        }
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+
+    // Keep few strings, so they are evicted as well
+    PdfTextExtractParams params;
+    params.DecodeCache = std::make_shared<PdfTextDecodeCache>(2);
+    auto extract = [](const PdfPage& page, const PdfTextExtractParams& params)
+    {
+        vector<pair<string, double>> entries;
+        page.ExtractTextTo([&entries](const PdfTextEntryView& entry) {
+            entries.push_back({ (string)entry.Text, entry.Length });
+        }, params);
+        return entries;
+    };
+
+    for (unsigned i = 0; i < PageCount; i++)
+    {
+        auto& page = doc.GetPages().GetPage(i);
+        auto cached = extract(page, params);
+        auto uncached = extract(page, { });
+        REQUIRE(cached.size() == 5);
+        REQUIRE(cached[0].first == "Quantity");
+        REQUIRE(cached[2].first == utls::Format("Row {}", i));
+        REQUIRE(cached.size() == uncached.size());
+        for (unsigned j = 0; j < cached.size(); j++)
+        {
+            REQUIRE(cached[j].first == uncached[j].first);
+            ASSERT_EQUAL(cached[j].second, uncached[j].second);
+        }
+
+        // The sizes and spacings scale the cached widths
+        REQUIRE(cached[3].first == "Quantity");
+        REQUIRE(cached[3].second > cached[0].second * 20 / 12);
+    }
+}
+
+TEST_CASE("TextExtractionReadingOrder")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        auto font = doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica);
+        PdfPainter painter;
+        auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        painter.SetCanvas(page);
+        painter.GetTextState().SetFont(font, 12);
+        painter.DrawText("Two columns", 50, 750);
+
+        // The lines of the columns are drawn interleaved
+        for (unsigned i = 0; i < 3; i++)
+        {
+            painter.DrawText(utls::Format("Right {}", i), 300, 700 - 20 * i);
+            painter.DrawText(utls::Format("Left {}", i), 50, 700 - 20 * i);
+        }
+
+        // A line drawn in pieces, out of order
+        painter.DrawText("words", 90, 640);
+        painter.DrawText("Split", 50, 640);
+        painter.FinishDrawing();
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    auto& page = doc.GetPages().GetPage(0);
+    PdfTextExtractParams params;
+    params.Flags = PdfTextExtractFlags::ReadingOrder;
+    vector<PdfTextEntry> entries;
+    page.ExtractTextTo(entries, params);
+
+    vector<string> texts;
+    for (auto& entry : entries)
+        texts.push_back(entry.Text);
+
+    REQUIRE(texts == vector<string>{ "Two columns", "Left 0", "Left 1", "Left 2", "Split words",
+        "Right 0", "Right 1", "Right 2" });
+    ASSERT_EQUAL(entries[4].X, 50);
+    ASSERT_EQUAL(entries[4].Y, 640);
+
+    // The pattern is matched by the arranged entries
+    entries.clear();
+    page.ExtractTextTo(entries, "Split w", params);
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].Text == "Split words");
+
+    // The words are arranged as well
+    params.Flags |= PdfTextExtractFlags::TokenizeWords;
+    entries.clear();
+    page.ExtractTextTo(entries, params);
+    REQUIRE(entries.size() == 16);
+    REQUIRE(entries[2].Text == "Left");
+    REQUIRE(entries[3].Text == "0");
+    REQUIRE(entries[9].Text == "words");
+    REQUIRE(entries[10].Text == "Right");
+}
@@ -8,6 +8,8 @@
 
 #include <PdfTest.h>
 
+#include <sstream>
+
 using namespace std;
 using namespace mm;
 
@@ -171,6 +173,189 @@ TEST_CASE("testComments")
     TestStreamIsNextToken(pszBuffer, pszTokens);
 }
 
+TEST_CASE("testLongTokens")
+{
+    // Tokens and whitespace runs longer than the vectorized scanning blocks
+    const char pszBuffer[] = "\r\n\t                      /AVeryLongNameThatSpansMoreBlocks"
+        "/AnotherVeryLongName\x00\x00 0123456789012345678901234567890123456789"
+        "                                        [12345678901234567(string)"
+        "ShortName%                             comment\n>>";
+
+    const char* pszTokens[] = {
+        "/", "AVeryLongNameThatSpansMoreBlocks", "/", "AnotherVeryLongName",
+        "0123456789012345678901234567890123456789", "[", "12345678901234567", "(",
+        "string", ")", "ShortName", ">>", NULL
+    };
+
+    // NOTE: The buffer contains null characters
+    TestStream(string_view(pszBuffer, sizeof(pszBuffer) - 1), pszTokens);
+}
+
+namespace
+{
+    // Forward the reads to another device, counting the characters
+    // that are read or peeked one at a time
+    class CharCountingDevice final : public InputStreamDevice
+    {
+    public:
+        CharCountingDevice(InputStreamDevice& device)
+            : m_device(&device), CharCount(0) { }
+
+        size_t GetLength() const override { return m_device->GetLength(); }
+        size_t GetPosition() const override { return m_device->GetPosition(); }
+        bool Eof() const override { return m_device->Eof(); }
+
+    protected:
+        size_t readBuffer(char* buffer, size_t size, bool& eof) override
+        {
+            return m_device->Read(buffer, size, eof);
+        }
+
+        bool readChar(char& ch) override
+        {
+            CharCount++;
+            return m_device->Read(ch);
+        }
+
+        bool peek(char& ch) const override
+        {
+            const_cast<CharCountingDevice&>(*this).CharCount++;
+            return m_device->Peek(ch);
+        }
+
+        bool tryPeek(bufferview& view) const override
+        {
+            return m_device->TryPeek(view);
+        }
+
+    private:
+        InputStreamDevice* m_device;
+
+    public:
+        unsigned CharCount;
+    };
+}
+
+TEST_CASE("testContentStreamTokens")
+{
+    PdfMemDocument doc;
+    PdfPage* page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+
+    // Content streams are read through devices that are not contiguous
+    // in memory, but hold the decoded data in chunks
+    string whitespaces(100, ' ');
+    string name(100, 'N');
+    string number = string(99, '0') + "1";
+    auto& streams = page->GetOrCreateContents().GetObject().GetArray();
+    for (auto content : { whitespaces + "/" + name + whitespaces + number + " Tf%comment",
+        "\n\t" + whitespaces + "[(x)] TJ" + whitespaces })
+    {
+        auto& streamObj = *doc.GetObjects().CreateDictionaryObject();
+        streamObj.GetOrCreateStream().Set(content);
+        streams.Add(streamObj.GetIndirectReference());
+    }
+
+    PdfCanvasInputDevice input(*page);
+    CharCountingDevice device(input);
+    PdfPostScriptTokenizer tokenizer;
+    PdfPostScriptTokenType type;
+    string_view keyword;
+    PdfVariant variant;
+
+    REQUIRE(tokenizer.TryReadNext(device, type, keyword, variant));
+    REQUIRE(type == PdfPostScriptTokenType::Variant);
+    REQUIRE(variant.GetName() == name);
+    REQUIRE(tokenizer.TryReadNext(device, type, keyword, variant));
+    REQUIRE(variant.GetNumber() == 1);
+    REQUIRE(tokenizer.TryReadNext(device, type, keyword, variant));
+    REQUIRE(type == PdfPostScriptTokenType::Keyword);
+    REQUIRE(keyword == "Tf");
+    REQUIRE(tokenizer.TryReadNext(device, type, keyword, variant));
+    REQUIRE(variant.GetArray().GetSize() == 1);
+    REQUIRE(variant.GetArray()[0].GetString().GetString() == "x");
+    REQUIRE(tokenizer.TryReadNext(device, type, keyword, variant));
+    REQUIRE(keyword == "TJ");
+    REQUIRE(!tokenizer.TryReadNext(device, type, keyword, variant));
+
+    // Whitespace runs and regular tokens are scanned in the data held
+    // in memory, not read one character at a time
+    INFO(utls::Format("Characters read one at a time: {}", device.CharCount));
+    REQUIRE(device.CharCount < 100);
+}
+
+TEST_CASE("testNumbersAndReferences")
+{
+    string_view buffer = "[ 1 2 R 3 4 5 /Name 6 0 R 7 8 ] 9 10";
+
+    SpanStreamDevice device(buffer);
+    istringstream stream((string)buffer);
+    StandardStreamDevice stdDevice(stream);
+    PdfTokenizer tokenizer;
+    PdfTokenizer stdTokenizer;
+    PdfVariant variant;
+    PdfVariant stdVariant;
+    string variantStr;
+    string stdVariantStr;
+    for (unsigned i = 0; i < 3; i++)
+    {
+        REQUIRE(tokenizer.TryReadNextVariant(device, variant));
+        REQUIRE(stdTokenizer.TryReadNextVariant(stdDevice, stdVariant));
+        variant.ToString(variantStr);
+        stdVariant.ToString(stdVariantStr);
+        REQUIRE(variantStr == stdVariantStr);
+    }
+
+    REQUIRE(variantStr == "10");
+    REQUIRE(!tokenizer.TryReadNextVariant(device, variant));
+    REQUIRE(!stdTokenizer.TryReadNextVariant(stdDevice, stdVariant));
+}
+
+TEST_CASE("testNumberArraysLookahead")
+{
+    // Numbers pushed back by the reference lookahead are read again
+    // from the queue when the device is not contiguous in memory
+    for (string_view buffer : { "[1 2 3 4 0 R 5 6 7 R] 8 9 10 0 R",
+        "[0 0 612 792] 1 2", "[1 2 /N 3 4 (s) 5 6 [7 8 9] 10 11 R 12]" })
+    {
+        istringstream stream((string)buffer);
+        StandardStreamDevice stdDevice(stream);
+        SpanStreamDevice device(buffer);
+        PdfTokenizer tokenizer;
+        PdfTokenizer stdTokenizer;
+        PdfVariant variant;
+        PdfVariant stdVariant;
+        string variantStr;
+        string stdVariantStr;
+        while (tokenizer.TryReadNextVariant(device, variant))
+        {
+            REQUIRE(stdTokenizer.TryReadNextVariant(stdDevice, stdVariant));
+            variant.ToString(variantStr);
+            stdVariant.ToString(stdVariantStr);
+            REQUIRE(variantStr == stdVariantStr);
+        }
+
+        REQUIRE(!stdTokenizer.TryReadNextVariant(stdDevice, stdVariant));
+    }
+}
+
+TEST_CASE("testTryReadNumbers")
+{
+    SpanStreamDevice device(string_view("12 0 obj -3"));
+    PdfTokenizer tokenizer;
+    int64_t num;
+    REQUIRE(tokenizer.TryReadNextNumber(device, num));
+    REQUIRE(num == 12);
+    REQUIRE(tokenizer.TryReadNextNumber(device, num));
+    REQUIRE(num == 0);
+
+    // The token that is not a number is not consumed
+    REQUIRE(!tokenizer.TryReadNextNumber(device, num));
+    REQUIRE(tokenizer.IsNextToken(device, "obj"));
+    REQUIRE(tokenizer.TryReadNextNumber(device, num));
+    REQUIRE(num == -3);
+    REQUIRE(!tokenizer.TryReadNextNumber(device, num));
+}
+
 TEST_CASE("testLocale")
 {
     // Test with a locale thate uses "," instead of "." for doubles 
@@ -181,6 +366,262 @@ TEST_CASE("testLocale")
     setlocale(LC_ALL, old);
 }
 
+TEST_CASE("testPostScriptNumbers")
+{
+    string_view contents = "0 -12 +3 3.5 -.25 +.5 7. 0.1 -0.0000001 1.2.3 1e5 "
+        "9223372036854775807 12345678901234567890.5 1.0000000000000000000000001";
+    SpanStreamDevice device(contents);
+    PdfPostScriptTokenizer tokenizer;
+    PdfPostScriptTokenType type;
+    string_view keyword;
+    PdfVariant variant;
+
+    auto testNumber = [&](int64_t expected)
+    {
+        REQUIRE(tokenizer.TryReadNext(device, type, keyword, variant));
+        REQUIRE(type == PdfPostScriptTokenType::Variant);
+        REQUIRE(variant.GetDataType() == PdfDataType::Number);
+        REQUIRE(variant.GetNumber() == expected);
+    };
+
+    auto testReal = [&](double expected)
+    {
+        REQUIRE(tokenizer.TryReadNext(device, type, keyword, variant));
+        REQUIRE(type == PdfPostScriptTokenType::Variant);
+        REQUIRE(variant.GetDataType() == PdfDataType::Real);
+        REQUIRE(variant.GetReal() == expected);
+    };
+
+    testNumber(0);
+    testNumber(-12);
+    testNumber(3);
+    testReal(3.5);
+    testReal(-0.25);
+    testReal(0.5);
+    testReal(7);
+    testReal(0.1);
+    testReal(-0.0000001);
+    // Trailing malformed characters are ignored
+    testReal(1.2);
+
+    REQUIRE(tokenizer.TryReadNext(device, type, keyword, variant));
+    REQUIRE(type == PdfPostScriptTokenType::Keyword);
+    REQUIRE(keyword == "1e5");
+
+    testNumber(numeric_limits<int64_t>::max());
+    testReal(12345678901234567890.5);
+    testReal(1);
+
+    SpanStreamDevice invalidDevice("- 1");
+    REQUIRE_THROWS_AS(tokenizer.TryReadNext(invalidDevice, type, keyword, variant), PdfError);
+}
+
+TEST_CASE("testRawContents")
+{
+    string_view contents =
+        "BT /F1 12 Tf 1 0 0 1 72.5 -700 Tm [(Hallo \\(Welt\\)) -250 <48656C6C6F> (a#b)] TJ ET "
+        "/Span << /ActualText (x) >> BDC /Name#20A Do EMC "
+        "BI /W 1 /H 1 ID \x01 EI Q";
+
+    auto device = std::make_shared<SpanStreamDevice>(contents);
+    PdfContentsReader reader(device);
+    PdfRawContent content;
+
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(content.Operator == PdfOperator::BT);
+    REQUIRE(content.Operands.size() == 0);
+
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(content.Operator == PdfOperator::Tf);
+    REQUIRE(content.Operands.size() == 2);
+    REQUIRE(content.Operands[0].Type == PdfRawOperandType::Name);
+    REQUIRE(content.Operands[0].Data == "F1");
+    REQUIRE(content.Operands[1].Type == PdfRawOperandType::Number);
+    REQUIRE(content.Operands[1].Number == 12);
+
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(content.Operator == PdfOperator::Tm);
+    REQUIRE(content.Operands.size() == 6);
+    REQUIRE(content.Operands[4].Number == 72.5);
+    REQUIRE(content.Operands[5].Number == -700);
+
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(content.Operator == PdfOperator::TJ);
+    REQUIRE(content.Warnings == PdfContentWarnings::None);
+    REQUIRE(content.Operands.size() == 6);
+    REQUIRE(content.Operands[0].Type == PdfRawOperandType::ArrayBegin);
+    REQUIRE(content.Operands[1].Type == PdfRawOperandType::String);
+    REQUIRE(content.Operands[1].Data == "Hallo (Welt)");
+    REQUIRE(content.Operands[2].Number == -250);
+    REQUIRE(content.Operands[3].Type == PdfRawOperandType::HexString);
+    REQUIRE(content.Operands[3].Data == "Hello");
+    REQUIRE(content.Operands[4].Data == "a#b");
+    REQUIRE(content.Operands[5].Type == PdfRawOperandType::ArrayEnd);
+
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(content.Operator == PdfOperator::ET);
+
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(content.Operator == PdfOperator::BDC);
+    REQUIRE(content.Warnings == PdfContentWarnings::None);
+    REQUIRE(content.Operands.size() == 5);
+    REQUIRE(content.Operands[1].Type == PdfRawOperandType::DictionaryBegin);
+    REQUIRE(content.Operands[2].Data == "ActualText");
+    REQUIRE(content.Operands[3].Data == "x");
+
+    // XObjects are not followed
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(content.Operator == PdfOperator::Do);
+    REQUIRE(content.Operands.size() == 1);
+    REQUIRE(content.Operands[0].Data == "Name A");
+
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(content.Operator == PdfOperator::EMC);
+
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(content.Type == PdfContentType::ImageDictionary);
+    REQUIRE(content.Operands.size() == 4);
+    REQUIRE(content.Operands[0].Data == "W");
+    REQUIRE(content.Operands[3].Number == 1);
+
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(content.Type == PdfContentType::ImageData);
+    REQUIRE(content.InlineImageData.size() == 2);
+    REQUIRE(content.InlineImageData[0] == '\x01');
+
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(content.Operator == PdfOperator::Q);
+    REQUIRE(!reader.TryReadNextRaw(content));
+}
+
+TEST_CASE("testOperatorNames")
+{
+    PdfOperator op;
+    for (unsigned i = 1; i <= (unsigned)PdfOperator::EX; i++)
+    {
+        auto name = GetPdfOperatorName((PdfOperator)i);
+        REQUIRE(TryGetPdfOperator(name, op));
+        REQUIRE(op == (PdfOperator)i);
+        int count;
+        REQUIRE(TryGetOperandCount(op, count));
+    }
+
+    REQUIRE(GetPdfOperator("T*") == PdfOperator::T_Star);
+    REQUIRE(GetPdfOperator("\"") == PdfOperator::DoubleQuote);
+    REQUIRE(GetOperandCount(PdfOperator::scn) == -1);
+    REQUIRE(GetOperandCount(PdfOperator::re) == 4);
+    REQUIRE(!TryGetPdfOperator("", op));
+    REQUIRE(!TryGetPdfOperator("T", op));
+    REQUIRE(!TryGetPdfOperator("Tjx", op));
+    REQUIRE(!TryGetPdfOperator("SCNx", op));
+    REQUIRE(op == PdfOperator::Unknown);
+    string_view name;
+    REQUIRE(!TryGetPdfOperatorName(PdfOperator::Unknown, name));
+}
+
+TEST_CASE("testInlineImageData")
+{
+    // The data of unfiltered images may contain "EI", which
+    // is skipped when the length of the data is known
+    string_view contents =
+        "BI /W 2 /H 1 /BPC 8 /CS /RGB ID aEI bc EI "
+        "BI /F /AHx /L 3 ID EI\n EI "
+        "BI /W 3 /H 1 /BPC 8 /CS /G ID \x01 EI "
+        "BI /L 8 ID ab EI 1 w "
+        "BI /L 999999999999 ID cd EI 2 w "
+        "BI /W 16777216 /H 16777216 /BPC 8 /CS /RGB ID ef EI Q";
+
+    auto testContents = [](PdfContentsReader& reader)
+    {
+        PdfContent content;
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(content.Type == PdfContentType::ImageDictionary);
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(content.Type == PdfContentType::ImageData);
+        REQUIRE(content.InlineImageData == "aEI bc ");
+
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(content.InlineImageData == "EI\n ");
+
+        // The data is shorter than expected
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(content.InlineImageData == "\x01 ");
+
+        // The data is longer than expected, or its length is invalid:
+        // the operators following the end image operator are read
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(content.InlineImageData == "ab ");
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(content.Operator == PdfOperator::w);
+        REQUIRE(content.Stack[0].GetReal() == 1);
+
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(content.InlineImageData == "cd ");
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(content.Operator == PdfOperator::w);
+        REQUIRE(content.Stack[0].GetReal() == 2);
+
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(content.InlineImageData == "ef ");
+
+        REQUIRE(reader.TryReadNext(content));
+        REQUIRE(content.Operator == PdfOperator::Q);
+        REQUIRE(!reader.TryReadNext(content));
+    };
+
+    {
+        PdfContentsReader reader(std::make_shared<SpanStreamDevice>(contents));
+        testContents(reader);
+    }
+
+    {
+        // The contents of the page can't be viewed in memory
+        PdfMemDocument doc;
+        auto page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        page->GetOrCreateContents().GetStreamForAppending().Set(contents);
+        PdfContentsReader reader(*page);
+        testContents(reader);
+    }
+
+    PdfContentsReader reader(std::make_shared<SpanStreamDevice>(contents));
+    PdfRawContent content;
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(content.Type == PdfContentType::ImageDictionary);
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(string_view(content.InlineImageData.data(), content.InlineImageData.size()) == "aEI bc ");
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(reader.TryReadNextRaw(content));
+    REQUIRE(string_view(content.InlineImageData.data(), content.InlineImageData.size()) == "EI\n ");
+}
+
+TEST_CASE("testContentsOptimizer")
+{
+    string_view contents =
+        "q 1 0 0 1 0 0 cm 0.50 w 0.5 w 1.000 0 0 rg 1 0 0 rg /F1 12 Tf "
+        "BT /F1 12.0 Tf (a) Tj ET Q "
+        "q 0 g 2 w Q "
+        "100 200 m 300.0000001 400 l 0.25 w S "
+        "/GS1 gs 0.25 w [ 3.0  1 ] 0 d BI /W 1 /H 1 ID \x01 EI\n";
+
+    PdfContentsOptimizer optimizer;
+    charbuff buffer;
+    optimizer.Optimize(std::make_shared<SpanStreamDevice>(contents), buffer);
+    REQUIRE(buffer ==
+        "q\n.5 w\n1 0 0 rg\n/F1 12 Tf\nBT\n(a)Tj\nET\nQ\n"
+        "100 200 m\n300 400 l\n.25 w\nS\n"
+        "/GS1 gs\n.25 w\n[3 1]0 d\nBI/H 1/W 1 ID \x01 EI\n");
+
+    // Optimizing again doesn't change the contents
+    charbuff optimized;
+    optimizer.Optimize(std::make_shared<SpanStreamDevice>(buffer), optimized);
+    REQUIRE(optimized == buffer);
+}
+
 void Test(const string_view& buffer, PdfDataType dataType, string_view expected)
 {
     expected = expected.empty() ? buffer : expected;
@@ -205,20 +646,31 @@ void Test(const string_view& buffer, PdfDataType dataType, string_view expected)
 
 void TestStream(const string_view& buffer, const char* tokens[])
 {
-    SpanStreamDevice device(buffer);
-    PdfTokenizer tokenizer;
-    string_view token;
-    unsigned i = 0;
-    while (tokens[i] != nullptr)
+    auto test = [&](InputStreamDevice& device)
     {
-        REQUIRE(tokenizer.TryReadNextToken(device, token));
-        REQUIRE(token == tokens[i]);
+        PdfTokenizer tokenizer;
+        string_view token;
+        unsigned i = 0;
+        while (tokens[i] != nullptr)
+        {
+            REQUIRE(tokenizer.TryReadNextToken(device, token));
+            REQUIRE(token == tokens[i]);
+
+            i++;
+        }
+
+        // We are at the end, so GetNextToken has to return false!
+        REQUIRE(!tokenizer.TryReadNextToken(device, token));
+    };
 
-        i++;
-    }
+    // The span device data is contiguous in memory, the standard
+    // stream device one is not: test both tokenization paths
+    SpanStreamDevice device(buffer);
+    test(device);
 
-    // We are at the end, so GetNextToken has to return false!
-    REQUIRE(!tokenizer.TryReadNextToken(device, token));
+    istringstream stream((string)buffer);
+    StandardStreamDevice stdDevice(stream);
+    test(stdDevice);
 }
 
 void TestStreamIsNextToken(const string_view& buffer, const char* tokens[])
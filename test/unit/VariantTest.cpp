@@ -168,6 +168,123 @@ TEST_CASE("testIsDirtyFalse")
     TestObjectsDirty(objBool, objNum, objReal, objStr, objRef, objArray, objDict, objStream, objVariant, false);
 }
 
+TEST_CASE("testDictionaryKeys")
+{
+    PdfObject obj = PdfDictionary();
+    auto& dict = obj.GetDictionary();
+    dict.AddKey("Zeta", PdfObject(static_cast<int64_t>(3)));
+    dict.AddKey("Alpha", PdfObject(static_cast<int64_t>(1)));
+    dict.AddKey("Mu", PdfObject(static_cast<int64_t>(2)));
+    auto& zeta = dict.MustFindKey("Zeta");
+    auto& mu = dict.MustFindKey("Mu");
+    REQUIRE(dict.begin()->first == "Alpha");
+    REQUIRE(dict.MustFindKey("Alpha").GetNumber() == 1);
+    REQUIRE(dict.GetKey("Beta") == nullptr);
+
+    // Removed entries are reused by the next keys
+    REQUIRE(dict.RemoveKey("Mu"));
+    dict.AddKey("Beta", PdfObject(static_cast<int64_t>(5)));
+    REQUIRE(&dict.MustFindKey("Beta") == &mu);
+    REQUIRE(dict.RemoveKey("Beta"));
+    dict.AddKey("Mu", PdfObject(static_cast<int64_t>(2)));
+    REQUIRE(&dict.MustFindKey("Zeta") == &zeta);
+
+    for (unsigned i = 0; i < 20; i++)
+        dict.AddKey(PdfName(utls::Format("Key{}", 19 - i)), PdfObject(static_cast<int64_t>(i)));
+
+    // The values keep their address when other keys are added
+    REQUIRE(&dict.MustFindKey("Zeta") == &zeta);
+
+    // Replacing a key doesn't add a new entry
+    dict.AddKey("Mu", PdfObject(static_cast<int64_t>(4)));
+    REQUIRE(dict.GetSize() == 23);
+    REQUIRE(dict.MustFindKey("Mu").GetNumber() == 4);
+    REQUIRE(dict.MustFindKey("Key0").GetNumber() == 19);
+    REQUIRE(dict.GetKey("Beta") == nullptr);
+
+    // The keys are iterated sorted
+    const PdfName* prev = nullptr;
+    for (auto& pair : dict)
+    {
+        if (prev != nullptr)
+            REQUIRE(*prev < pair.first);
+
+        REQUIRE(pair.second.GetParent() == &dict);
+        prev = &pair.first;
+    }
+
+    REQUIRE(dict.RemoveKey("Alpha"));
+    REQUIRE(!dict.RemoveKey("Alpha"));
+    REQUIRE(dict.GetSize() == 22);
+    REQUIRE(dict.begin()->first == "Key0");
+    REQUIRE(&dict.MustFindKey("Zeta") == &zeta);
+    REQUIRE(zeta.GetParent() == &dict);
+
+    // Copies hold their own entries, moves keep the addresses
+    PdfDictionary copy(dict);
+    REQUIRE(copy == dict);
+    REQUIRE(&copy.MustFindKey("Zeta") != &zeta);
+    REQUIRE(copy.MustFindKey("Zeta").GetParent() == &copy);
+    copy.AddKey("Mu", PdfObject(static_cast<int64_t>(5)));
+    REQUIRE(copy != dict);
+    PdfDictionary moved(std::move(dict));
+    REQUIRE(moved.GetSize() == 22);
+    REQUIRE(&moved.MustFindKey("Zeta") == &zeta);
+    REQUIRE(zeta.GetParent() == &moved);
+
+    PdfDictionary small;
+    small.AddKey("B", PdfObject(static_cast<int64_t>(2)));
+    small.AddKey("A", PdfObject(static_cast<int64_t>(1)));
+    copy = small;
+    REQUIRE(copy == small);
+    REQUIRE(copy.GetSize() == 2);
+    REQUIRE(copy.begin()->first == "A");
+    moved.Clear();
+    REQUIRE(moved.GetSize() == 0);
+    REQUIRE(moved.begin() == moved.end());
+
+    // Small dictionaries take only the slots of the doubling chunks
+    // and the flat index, besides two chunk headers
+    PdfObject fiveKeys = PdfDictionary();
+    for (unsigned i = 0; i < 5; i++)
+        fiveKeys.GetDictionary().AddKey(PdfName(utls::Format("Key{}", i)), PdfObject(static_cast<int64_t>(i)));
+
+    PdfMemoryStats stats;
+    fiveKeys.CollectMemoryUsage(stats);
+    REQUIRE(stats.Dictionaries <= sizeof(PdfDictionary)
+        + 8 * sizeof(PdfDictionaryMap::value_type) + (12 + 8) * sizeof(void*));
+
+    // The storage of empty dictionaries is not allocated
+    REQUIRE(sizeof(PdfDictionaryMap) <= 4 * sizeof(void*));
+}
+
+TEST_CASE("testVariantMemory")
+{
+    REQUIRE(sizeof(PdfVariant) <= 16);
+
+    // Interned names held by variants point to the same instance
+    PdfVariant name1(PdfName("Type"));
+    PdfVariant name2(PdfName::FromEscaped("Type"));
+    REQUIRE(&name1.GetName() == &name2.GetName());
+    PdfVariant copy(name1);
+    REQUIRE(&copy.GetName() == &name1.GetName());
+    copy.SetName(PdfName("Custom"));
+    REQUIRE(copy.GetName() == "Custom");
+    REQUIRE(name1.GetName() == "Type");
+    copy.SetName(PdfName("Page"));
+    REQUIRE(&copy.GetName() == &PdfVariant(PdfName("Page")).GetName());
+
+    // Arrays of numbers like /Widths don't allocate per element
+    // besides the storage of the array itself
+    PdfArray widths;
+    for (unsigned i = 0; i < 256; i++)
+        widths.Add(PdfObject(static_cast<int64_t>(500 + i)));
+
+    size_t bytesPerElement = sizeof(PdfObject);
+    INFO(utls::Format("Bytes per number element: {}", bytesPerElement));
+    REQUIRE(bytesPerElement <= 64);
+}
+
 void TestObjectsDirty(
     const PdfObject& objBool,
     const PdfObject& objNum,
@@ -190,3 +307,61 @@ void TestObjectsDirty(
     INFO(utls::Format("STREAM    IsDirty() == {}", testValue)); REQUIRE(objStream.IsDirty() == testValue);
     INFO(utls::Format("VARIANT   IsDirty() == {}", testValue)); REQUIRE(objVariant.IsDirty() == testValue);
 }
+
+TEST_CASE("testMinimalWrite")
+{
+    PdfArray arr;
+    arr.Add((int64_t)1);
+    arr.Add(PdfString("s"));
+    arr.Add(PdfReference(2, 0));
+    PdfArray nested;
+    nested.Add(3.5);
+    arr.Add(nested);
+    arr.Add(PdfName("N"));
+    arr.Add(PdfVariant());
+    PdfDictionary dict;
+    dict.AddKey(PdfName::KeyType, PdfName("Test"));
+    dict.AddKey("Array", arr);
+
+    charbuff buffer;
+    string compact;
+    StringStreamDevice compactDevice(compact);
+    PdfVariant(dict).Write(compactDevice, PdfWriteFlags::None, { }, buffer);
+    REQUIRE(compact == "<</Type/Test/Array[ 1(s) 2 0 R[ 3.5]/N null]>>");
+
+    string minimal;
+    StringStreamDevice minimalDevice(minimal);
+    PdfVariant(dict).Write(minimalDevice, PdfWriteFlags::Minimal, { }, buffer);
+    REQUIRE(minimal == "<</Type/Test/Array[1(s)2 0 R[3.5]/N null]>>");
+
+}
+
+TEST_CASE("testArrayBulkAdd")
+{
+    PdfMemDocument doc;
+    auto obj = doc.GetObjects().CreateArrayObject();
+    auto& arr = obj->GetArray();
+
+    const int64_t numbers[] = { 1, -2, 3 };
+    arr.AddNumbers(numbers);
+    const double reals[] = { 0.5, 1.5 };
+    arr.AddReals(reals);
+    auto& nested = arr.emplace_back(PdfArray()).GetArray();
+    nested.emplace_back(PdfName("N"));
+    arr.emplace_back(PdfReference(2, 0));
+
+    REQUIRE(arr.size() == 7);
+    REQUIRE(arr[1].GetNumber() == -2);
+    REQUIRE(arr[4].GetReal() == 1.5);
+    for (auto& item : arr)
+    {
+        REQUIRE(item.GetParent() == &arr);
+        REQUIRE(item.GetDocument() == &doc);
+    }
+    REQUIRE(nested[0].GetParent() == &nested);
+    REQUIRE(nested[0].GetDocument() == &doc);
+
+    string str;
+    PdfVariant(arr).ToString(str);
+    REQUIRE(str == "[ 1 -2 3 0.5 1.5[/N] 2 0 R]");
+}
@@ -34,3 +34,121 @@ TEST_CASE("TestNormalizeXMP")
     TestNormalizeXMP("TestXMP5");
     TestNormalizeXMP("TestXMP7");
 }
+
+static void TestReadXMP(const string_view& xmp)
+{
+    unique_ptr<PdfXMPPacket> packet;
+    auto expected = mm::GetXMPMetadata(xmp, packet);
+
+    PdfXMPMetadata metadata;
+    REQUIRE(mm::TryReadXMPMetadata(xmp, metadata) == (packet != nullptr));
+    REQUIRE(metadata.Title == expected.Title);
+    REQUIRE(metadata.Author == expected.Author);
+    REQUIRE(metadata.Subject == expected.Subject);
+    REQUIRE(metadata.Keywords == expected.Keywords);
+    REQUIRE(metadata.Creator == expected.Creator);
+    REQUIRE(metadata.Producer == expected.Producer);
+    REQUIRE(metadata.CreationDate == expected.CreationDate);
+    REQUIRE(metadata.ModDate == expected.ModDate);
+    REQUIRE(metadata.PdfaLevel == expected.PdfaLevel);
+}
+
+TEST_CASE("TestReadXMP")
+{
+    string_view xmp = R"(<?xpacket begin="" id="W5M0MpCehiHzreSzNTczkc9d"?>
+<x:xmpmeta xmlns:x="adobe:ns:meta/">
+  <rdf:RDF xmlns:rdf="http://www.w3.org/1999/02/22-rdf-syntax-ns#">
+    <rdf:Description rdf:about="" xmlns:dc="http://purl.org/dc/elements/1.1/"
+        xmlns:pdf="http://ns.adobe.com/pdf/1.3/" pdf:Producer="Producer">
+      <dc:title><rdf:Alt><rdf:li xml:lang="x-default">Title</rdf:li><rdf:li xml:lang="it">Titolo</rdf:li></rdf:Alt></dc:title>
+      <dc:creator><rdf:Seq><rdf:li>Author</rdf:li></rdf:Seq></dc:creator>
+      <pdf:Keywords>Keyword1, Keyword2</pdf:Keywords>
+    </rdf:Description>
+    <rdf:Description rdf:about="" xmlns:xmp="http://ns.adobe.com/xap/1.0/"
+        xmlns:pdfaid="http://www.aiim.org/pdfa/ns/id/" pdfaid:part="2" pdfaid:conformance="B">
+      <xmp:CreateDate>2022-05-12T10:30:00+02:00</xmp:CreateDate>
+      <xmp:ModifyDate>2022-05-13T11:00:00Z</xmp:ModifyDate>
+      <pdf:Producer xmlns:pdf="http://ns.adobe.com/pdf/1.3/">Ignored</pdf:Producer>
+    </rdf:Description>
+  </rdf:RDF>
+</x:xmpmeta>
+<?xpacket end="w"?>)";
+
+    PdfXMPMetadata metadata;
+    REQUIRE(mm::TryReadXMPMetadata(xmp, metadata));
+    REQUIRE(metadata.Title == PdfString("Title"));
+    REQUIRE(metadata.Author == PdfString("Author"));
+    REQUIRE(metadata.Subject == nullptr);
+    REQUIRE(metadata.Keywords == PdfString("Keyword1, Keyword2"));
+    REQUIRE(metadata.Producer == PdfString("Producer"));
+    REQUIRE(metadata.CreationDate.has_value());
+    REQUIRE(metadata.PdfaLevel == PdfALevel::L2B);
+    TestReadXMP(xmp);
+
+    TestReadXMP(R"(<x:xmpmeta xmlns:x="adobe:ns:meta/"><rdf:RDF xmlns:rdf="http://www.w3.org/1999/02/22-rdf-syntax-ns#">
+<rdf:Description rdf:about="" xmlns:dc="http://purl.org/dc/elements/1.1/" dc:title="NotAList"/>
+<rdf:Description rdf:about="" xmlns:dc="http://purl.org/dc/elements/1.1/"><dc:title><rdf:Alt><rdf:li>Title</rdf:li></rdf:Alt></dc:title></rdf:Description>
+</rdf:RDF></x:xmpmeta>)");
+    TestReadXMP(R"(<x:xmpmeta xmlns:x="adobe:ns:meta/"/>)");
+    TestReadXMP(R"(<root/>)");
+    TestReadXMP(R"(<x:xmpmeta xmlns:x="adobe:ns:meta/">)");
+}
+
+TEST_CASE("TestPdfAValidator")
+{
+    PdfMemDocument doc;
+    doc.GetCatalog().SetMetadataStreamValue(R"(<x:xmpmeta xmlns:x="adobe:ns:meta/"><rdf:RDF xmlns:rdf="http://www.w3.org/1999/02/22-rdf-syntax-ns#">
+<rdf:Description rdf:about="" xmlns:dc="http://purl.org/dc/elements/1.1/" xmlns:pdfaid="http://www.aiim.org/pdfa/ns/id/"
+    pdfaid:part="1" pdfaid:conformance="B"><dc:title><rdf:Alt><rdf:li xml:lang="x-default">Title</rdf:li></rdf:Alt></dc:title></rdf:Description>
+</rdf:RDF></x:xmpmeta>)");
+    doc.GetTrailer().GetDictionary().MustFindKey("Info").GetDictionary().AddKey("Title", PdfString("Other"));
+
+    auto page = doc.GetPages().CreatePage(PdfRect(0, 0, 400, 400));
+    {
+        PdfPainter painter;
+        painter.SetCanvas(page);
+        painter.GetTextState().SetFont(doc.GetFontManager().GetStandard14Font(PdfStandard14FontType::Helvetica), 12);
+        painter.DrawText("Hello", 50, 50);
+        painter.FinishDrawing();
+    }
+
+    PdfDictionary extGState;
+    extGState.AddKey("ca", 0.5);
+    page->GetOrCreateResources().AddResource("ExtGState", "GS0", PdfObject(extGState));
+    page->GetOrCreateContents().GetStreamForAppending(PdfStreamAppendFlags::NoSaveRestorePrior).Set("/GS0 gs /Missing Do foo"sv, { });
+
+    auto countViolations = [](const PdfAValidationResult& result, PdfAViolationType type)
+    {
+        unsigned count = 0;
+        for (auto& violation : result.Violations)
+        {
+            if (violation.Type == type)
+                count++;
+        }
+        return count;
+    };
+
+    auto result = PdfAValidator().Validate(doc);
+    REQUIRE(result.Level == PdfALevel::L1B);
+    REQUIRE(!result.IsValid());
+    REQUIRE(countViolations(result, PdfAViolationType::Encrypted) == 0);
+    REQUIRE(countViolations(result, PdfAViolationType::MissingMetadata) == 0);
+    // The Producer and the CreationDate of the Info are not in the XMP metadata too
+    REQUIRE(countViolations(result, PdfAViolationType::InconsistentMetadata) == 3);
+    REQUIRE(countViolations(result, PdfAViolationType::MissingOutputIntent) == 1);
+    REQUIRE(countViolations(result, PdfAViolationType::FontNotEmbedded) == 1);
+    REQUIRE(countViolations(result, PdfAViolationType::Transparency) == 1);
+    REQUIRE(countViolations(result, PdfAViolationType::UndefinedOperator) == 1);
+    REQUIRE(countViolations(result, PdfAViolationType::MissingResource) == 1);
+    for (auto& violation : result.Violations)
+    {
+        if (violation.Type == PdfAViolationType::Transparency || violation.Type == PdfAViolationType::MissingResource)
+            REQUIRE(violation.Reference == page->GetObject().GetIndirectReference());
+    }
+
+    // Transparency is allowed from PDF/A-2
+    result = PdfAValidator(PdfALevel::L2B).Validate(doc, 1);
+    REQUIRE(result.Level == PdfALevel::L2B);
+    REQUIRE(countViolations(result, PdfAViolationType::Transparency) == 0);
+    REQUIRE(countViolations(result, PdfAViolationType::FontNotEmbedded) == 1);
+}